@@ -0,0 +1,836 @@
+// veloce_cpu_bench - CPU interpreter microbenchmarks on generated code
+//
+// Each CPU (NES 6502, Game Boy LR35902, GBA ARM7TDMI, SNES 65C816 and
+// SPC700) runs a synthetic loop built from one instruction mix: ALU work,
+// branches, or memory traffic, in whole passes of the mix so stack pushes
+// stay balanced. The CPU is wired to its own core's bus and nothing else:
+// no PPU, APU, DMA or timers are stepped (the NES and Game Boy buses run
+// in their CPU-only mode), so the time is the interpreter's dispatch,
+// decode and the bus's address decoding, not the rest of the system.
+// Code sits in a generated cartridge (work RAM for the SPC700) and data in
+// work RAM. --sweep times every instruction form on its own.
+
+#include "nes/src/bus.hpp"
+#include "nes/src/cartridge.hpp"
+#include "nes/src/cpu.hpp"
+#include "gb/src/bus.hpp"
+#include "gb/src/cartridge.hpp"
+#include "gb/src/lr35902.hpp"
+#include "gba/src/arm7tdmi.hpp"
+#include "gba/src/bus.hpp"
+#include "gba/src/cartridge.hpp"
+#include "snes/src/bus.hpp"
+#include "snes/src/cartridge.hpp"
+#include "snes/src/cpu.hpp"
+#include "snes/src/spc700.hpp"
+
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// About how much code one pass of the loop holds; mixes are repeated
+// whole until they fill it
+constexpr size_t BODY_BYTES = 1024;
+
+constexpr uint64_t DEFAULT_INSTRUCTIONS = 4000000;
+constexpr int DEFAULT_REPETITIONS = 5;
+
+// One instruction form, or a few that must run together (a push and its pop)
+struct Snippet {
+    const char* name;
+    std::vector<uint8_t> bytes;
+    int instructions = 1;
+};
+
+struct Mix {
+    const char* name;
+    std::vector<uint8_t> preamble;  // Runs once before the loop
+    std::vector<Snippet> snippets;
+    bool thumb = false;             // GBA: loop in Thumb state
+};
+
+// A CPU wired to a bus with nothing else on it
+class CpuHarness {
+public:
+    virtual ~CpuHarness() = default;
+
+    // Reset into a program that runs preamble once, then body forever
+    virtual bool load(const Mix& mix, const std::vector<uint8_t>& body) = 0;
+
+    // Run at least count instructions; returns how many ran
+    virtual uint64_t run(uint64_t count) = 0;
+
+    // False if the program counter has left the loop, so what was timed
+    // isn't the mix
+    bool in_loop() const {
+        uint32_t pc = get_pc();
+        return pc >= m_loop_start && pc <= m_loop_end;
+    }
+
+protected:
+    virtual uint32_t get_pc() const = 0;
+
+    uint32_t m_loop_start = 0;  // First byte of the body
+    uint32_t m_loop_end = 0;    // Last address the PC can read as
+};
+
+void put16(std::vector<uint8_t>& out, size_t offset, uint16_t value) {
+    out[offset] = static_cast<uint8_t>(value);
+    out[offset + 1] = static_cast<uint8_t>(value >> 8);
+}
+
+void put32(std::vector<uint8_t>& out, size_t offset, uint32_t value) {
+    put16(out, offset, static_cast<uint16_t>(value));
+    put16(out, offset + 2, static_cast<uint16_t>(value >> 16));
+}
+
+void place(std::vector<uint8_t>& out, size_t offset, const std::vector<uint8_t>& bytes) {
+    std::copy(bytes.begin(), bytes.end(), out.begin() + offset);
+}
+
+// Instruction words as their little-endian bytes
+std::vector<uint8_t> arm(std::initializer_list<uint32_t> words) {
+    std::vector<uint8_t> out(words.size() * 4);
+    size_t offset = 0;
+    for (uint32_t word : words) {
+        put32(out, offset, word);
+        offset += 4;
+    }
+    return out;
+}
+
+std::vector<uint8_t> thumb(std::initializer_list<uint16_t> halfwords) {
+    std::vector<uint8_t> out(halfwords.size() * 2);
+    size_t offset = 0;
+    for (uint16_t halfword : halfwords) {
+        put16(out, offset, halfword);
+        offset += 2;
+    }
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+// NES: mapper 0 cartridge, code from $8000, data in internal RAM
+
+class NesHarness : public CpuHarness {
+public:
+    bool load(const Mix& mix, const std::vector<uint8_t>& body) override {
+        m_image.assign(16 + 0x4000, 0);
+        const uint8_t header[] = {'N', 'E', 'S', 0x1A, 1, 0};
+        std::memcpy(m_image.data(), header, sizeof(header));
+
+        uint8_t* prg = m_image.data() + 16;
+        size_t loop = mix.preamble.size();
+        place(m_image, 16, mix.preamble);
+        place(m_image, 16 + loop, body);
+        size_t jump = 16 + loop + body.size();
+        m_image[jump] = 0x4C;  // JMP loop
+        put16(m_image, jump + 1, static_cast<uint16_t>(0x8000 + loop));
+        m_loop_start = static_cast<uint32_t>(0x8000 + loop);
+        m_loop_end = static_cast<uint32_t>(0x8000 + jump - 16 + 2);
+        for (int vector = 0x3FFA; vector < 0x4000; vector += 2) {
+            prg[vector] = 0x00;
+            prg[vector + 1] = 0x80;
+        }
+
+        if (!m_cartridge.load(m_image.data(), m_image.size())) return false;
+        m_bus.connect_cpu(&m_cpu);
+        m_bus.connect_cartridge(&m_cartridge);
+        m_bus.set_cpu_only(true);
+        m_cpu.reset();
+        return true;
+    }
+
+    uint64_t run(uint64_t count) override {
+        for (uint64_t i = 0; i < count; i++) {
+            m_cpu.step();
+        }
+        return count;
+    }
+
+private:
+    uint32_t get_pc() const override { return m_cpu.get_pc(); }
+
+    nes::Bus m_bus;
+    nes::Cartridge m_cartridge;
+    nes::CPU m_cpu{m_bus};
+    std::vector<uint8_t> m_image;
+};
+
+const std::vector<Mix> NES_MIXES = {
+    {"alu", {}, {
+        {"adc #", {0x69, 0x01}},
+        {"sbc #", {0xE9, 0x01}},
+        {"and #", {0x29, 0xFF}},
+        {"ora #", {0x09, 0x00}},
+        {"eor #", {0x49, 0x55}},
+        {"asl a", {0x0A}},
+        {"lsr a", {0x4A}},
+        {"rol a", {0x2A}},
+        {"inx", {0xE8}},
+        {"dey", {0x88}},
+        {"tax", {0xAA}},
+        {"tya", {0x98}},
+        {"clc", {0x18}},
+    }},
+    {"branch", {}, {
+        {"cmp #", {0xC9, 0x10}},
+        {"bne", {0xD0, 0x00}},
+        {"beq", {0xF0, 0x00}},
+        {"cpx #", {0xE0, 0x10}},
+        {"bcc", {0x90, 0x00}},
+        {"bcs", {0xB0, 0x00}},
+        {"bpl", {0x10, 0x00}},
+        {"bmi", {0x30, 0x00}},
+    }},
+    // (zp),Y points at $0400
+    {"memory", {0xA9, 0x00, 0x85, 0x20, 0xA9, 0x04, 0x85, 0x21, 0xA2, 0x00, 0xA0, 0x00}, {
+        {"lda zp", {0xA5, 0x10}},
+        {"sta zp", {0x85, 0x11}},
+        {"lda abs", {0xAD, 0x00, 0x02}},
+        {"sta abs", {0x8D, 0x01, 0x02}},
+        {"lda abs,x", {0xBD, 0x00, 0x03}},
+        {"sta (zp),y", {0x91, 0x20}},
+        {"inc zp", {0xE6, 0x12}},
+        {"ldx zp", {0xA6, 0x13}},
+        {"pha/pla", {0x48, 0x68}, 2},
+    }},
+};
+
+// ---------------------------------------------------------------------------
+// Game Boy: 32KB ROM-only cartridge, code from $0150, data in work RAM
+
+class GbHarness : public CpuHarness {
+public:
+    bool load(const Mix& mix, const std::vector<uint8_t>& body) override {
+        m_image.assign(0x8000, 0);
+        const std::vector<uint8_t> entry = {0x00, 0xC3, 0x50, 0x01};  // NOP; JP $0150
+        place(m_image, 0x100, entry);
+
+        size_t loop = 0x150 + mix.preamble.size();
+        place(m_image, 0x150, mix.preamble);
+        place(m_image, loop, body);
+        size_t jump = loop + body.size();
+        m_image[jump] = 0xC3;  // JP loop
+        put16(m_image, jump + 1, static_cast<uint16_t>(loop));
+        m_loop_start = static_cast<uint32_t>(loop);
+        m_loop_end = static_cast<uint32_t>(jump + 2);
+
+        if (!m_cartridge.load(m_image.data(), m_image.size())) return false;
+        m_bus.connect_cpu(&m_cpu);
+        m_bus.connect_cartridge(&m_cartridge);
+        m_bus.set_cpu_only(true);
+        m_cpu.reset();
+        return true;
+    }
+
+    uint64_t run(uint64_t count) override {
+        for (uint64_t i = 0; i < count; i++) {
+            m_cpu.step();
+        }
+        return count;
+    }
+
+private:
+    uint32_t get_pc() const override { return m_cpu.get_pc(); }
+
+    gb::Bus m_bus;
+    gb::Cartridge m_cartridge;
+    gb::LR35902 m_cpu{m_bus};
+    std::vector<uint8_t> m_image;
+};
+
+const std::vector<Mix> GB_MIXES = {
+    {"alu", {0xF3}, {
+        {"add a,b", {0x80}},
+        {"sub c", {0x91}},
+        {"and d", {0xA2}},
+        {"or e", {0xB3}},
+        {"xor h", {0xAC}},
+        {"inc b", {0x04}},
+        {"dec c", {0x0D}},
+        {"add hl,de", {0x19}},
+        {"inc de", {0x13}},
+        {"rlca", {0x07}},
+        {"swap a", {0xCB, 0x37}},
+        {"bit 7,h", {0xCB, 0x7C}},
+    }},
+    {"branch", {0xF3}, {
+        {"cp n", {0xFE, 0x10}},
+        {"jr nz", {0x20, 0x00}},
+        {"jr z", {0x28, 0x00}},
+        {"dec b", {0x05}},
+        {"jr nc", {0x30, 0x00}},
+        {"jr c", {0x38, 0x00}},
+        {"jr", {0x18, 0x00}},
+        {"bit 0,a", {0xCB, 0x47}},
+    }},
+    // DI; LD SP,$DFFE; LD HL,$C100; LD DE,$C300
+    {"memory", {0xF3, 0x31, 0xFE, 0xDF, 0x21, 0x00, 0xC1, 0x11, 0x00, 0xC3}, {
+        {"ld a,(hl)", {0x7E}},
+        {"ld (hl),a", {0x77}},
+        {"ld a,(nn)", {0xFA, 0x00, 0xC2}},
+        {"ld (nn),a", {0xEA, 0x02, 0xC2}},
+        {"ldh a,(n)", {0xF0, 0x80}},
+        {"ldh (n),a", {0xE0, 0x81}},
+        {"ld b,(hl)", {0x46}},
+        {"ld a,(de)", {0x1A}},
+        {"inc (hl)", {0x34}},
+        {"push/pop bc", {0xC5, 0xC1}, 2},
+    }},
+};
+
+// ---------------------------------------------------------------------------
+// GBA: code in cartridge ROM from $080000C0, data in IWRAM (r7/r8 point
+// at it). Runs through ARM7TDMI::run(), the path the core's frame loop uses.
+
+class GbaHarness : public CpuHarness {
+public:
+    static constexpr size_t CODE = 0xC0;
+    static constexpr uint32_t ROM_BASE = 0x08000000;
+
+    bool load(const Mix& mix, const std::vector<uint8_t>& body) override {
+        m_image.assign(0x10000, 0);
+        put32(m_image, 0, 0xEA00002E);  // B $080000C0, past the header
+
+        // MOV r7/r8, #$03000000, then into Thumb at the next word if asked
+        std::vector<uint8_t> setup = arm({0xE3A07403, 0xE3A08403});
+        if (mix.thumb) {
+            std::vector<uint8_t> to_thumb = arm({0xE28F9001, 0xE12FFF19});  // ADD r9, pc, #1; BX r9
+            setup.insert(setup.end(), to_thumb.begin(), to_thumb.end());
+        }
+        place(m_image, CODE, setup);
+        size_t start = CODE + setup.size();
+        place(m_image, start, mix.preamble);
+
+        size_t loop = start + mix.preamble.size();
+        place(m_image, loop, body);
+        size_t jump = loop + body.size();
+        if (mix.thumb) {
+            int32_t offset = (static_cast<int32_t>(loop) - static_cast<int32_t>(jump + 4)) / 2;
+            put16(m_image, jump, static_cast<uint16_t>(0xE000 | (offset & 0x7FF)));  // B loop
+        } else {
+            int32_t offset = (static_cast<int32_t>(loop) - static_cast<int32_t>(jump + 8)) / 4;
+            put32(m_image, jump, 0xEA000000 | (static_cast<uint32_t>(offset) & 0xFFFFFF));
+        }
+        m_loop_start = ROM_BASE + static_cast<uint32_t>(loop);
+        m_loop_end = ROM_BASE + static_cast<uint32_t>(jump) + 8;
+
+        if (!m_cartridge.load(m_image.data(), m_image.size(), gba::SystemType::GameBoyAdvance)) return false;
+        m_bus.connect_cpu(&m_cpu);
+        m_bus.connect_cartridge(&m_cartridge);
+        m_cpu.reset();
+        return true;
+    }
+
+    uint64_t run(uint64_t count) override {
+        uint64_t ran = 0;
+        while (ran < count) {
+            int instructions = 0;
+            m_cpu.run(RUN_CYCLES, instructions);
+            ran += static_cast<uint64_t>(instructions);
+        }
+        return ran;
+    }
+
+private:
+    uint32_t get_pc() const override { return m_cpu.get_pc(); }
+
+    static constexpr int RUN_CYCLES = 1232;  // One scanline, as the frame loop asks for
+
+    gba::Bus m_bus;
+    gba::Cartridge m_cartridge;
+    gba::ARM7TDMI m_cpu{m_bus};
+    std::vector<uint8_t> m_image;
+};
+
+const std::vector<Mix> GBA_MIXES = {
+    {"arm-alu", {}, {
+        {"add", arm({0xE0800001})},
+        {"sub #", arm({0xE2422001})},
+        {"eor", arm({0xE0233000})},
+        {"orr lsl #", arm({0xE1844101})},
+        {"and", arm({0xE0005001})},
+        {"mov ror #", arm({0xE1A061E0})},
+        {"mul", arm({0xE0070190})},
+        {"adds", arm({0xE0900001})},
+        {"cmp", arm({0xE1500001})},
+    }},
+    {"arm-branch", {}, {
+        {"cmp #", arm({0xE3500000})},
+        {"bne", arm({0x1AFFFFFF})},
+        {"beq", arm({0x0AFFFFFF})},
+        {"tst #", arm({0xE3110001})},
+        {"bcs", arm({0x2AFFFFFF})},
+        {"b", arm({0xEAFFFFFF})},
+    }},
+    {"arm-memory", {}, {
+        {"ldr", arm({0xE5980000})},
+        {"str #", arm({0xE5881004})},
+        {"ldrb #", arm({0xE5D82008})},
+        {"strh #", arm({0xE1C830BC})},
+        {"ldmia", arm({0xE898000F})},
+        {"stmia", arm({0xE88800F0})},
+    }},
+    {"thumb-alu", {}, {
+        {"adds", thumb({0x1840})},
+        {"subs #", thumb({0x3A01})},
+        {"lsls #", thumb({0x0083})},
+        {"eors", thumb({0x4044})},
+        {"muls", thumb({0x434D})},
+        {"movs #", thumb({0x2607})},
+        {"cmp", thumb({0x4288})},
+    }, true},
+    {"thumb-branch", {}, {
+        {"cmp #", thumb({0x2800})},
+        {"bne", thumb({0xD1FF})},
+        {"beq", thumb({0xD0FF})},
+        {"bcs", thumb({0xD2FF})},
+        {"b", thumb({0xE7FF})},
+    }, true},
+    {"thumb-memory", {}, {
+        {"ldr #", thumb({0x6838})},
+        {"str #", thumb({0x6079})},
+        {"ldrb #", thumb({0x7A3A})},
+        {"strh #", thumb({0x81BB})},
+        {"push/pop", thumb({0xB403, 0xBC03}), 2},
+    }, true},
+};
+
+// ---------------------------------------------------------------------------
+// SNES: 256KB LoROM cartridge, code from $00:8000, data in work RAM.
+// Every mix switches to native mode with 16-bit registers first.
+
+class SnesHarness : public CpuHarness {
+public:
+    bool load(const Mix& mix, const std::vector<uint8_t>& body) override {
+        m_image.assign(0x40000, 0);
+        const char title[] = "VELOCE CPU BENCH     ";
+        std::memcpy(&m_image[0x7FC0], title, 21);
+        m_image[0x7FD5] = 0x20;  // LoROM
+        m_image[0x7FD7] = 0x08;  // 256KB
+        m_image[0x7FD9] = 0x01;  // North America
+        for (int vector = 0x7FE4; vector < 0x8000; vector += 2) {
+            put16(m_image, vector, 0x8000);
+        }
+
+        // SEI; CLC; XCE; REP #$30
+        const std::vector<uint8_t> native = {0x78, 0x18, 0xFB, 0xC2, 0x30};
+        place(m_image, 0, native);
+        place(m_image, native.size(), mix.preamble);
+        size_t loop = native.size() + mix.preamble.size();
+        place(m_image, loop, body);
+        size_t jump = loop + body.size();
+        m_image[jump] = 0x4C;  // JMP loop
+        put16(m_image, jump + 1, static_cast<uint16_t>(0x8000 + loop));
+        m_loop_start = static_cast<uint32_t>(0x8000 + loop);
+        m_loop_end = static_cast<uint32_t>(0x8000 + jump + 2);
+
+        uint16_t sum = 0;
+        put16(m_image, 0x7FDC, 0xFFFF);
+        put16(m_image, 0x7FDE, 0x0000);
+        for (uint8_t byte : m_image) sum = static_cast<uint16_t>(sum + byte);
+        put16(m_image, 0x7FDC, static_cast<uint16_t>(~sum));
+        put16(m_image, 0x7FDE, sum);
+
+        if (!m_cartridge.load(m_image.data(), m_image.size())) return false;
+        m_bus.connect_cpu(&m_cpu);
+        m_bus.connect_cartridge(&m_cartridge);
+        m_cpu.reset();
+        return true;
+    }
+
+    uint64_t run(uint64_t count) override {
+        for (uint64_t i = 0; i < count; i++) {
+            m_cpu.step();
+        }
+        return count;
+    }
+
+private:
+    uint32_t get_pc() const override { return m_cpu.get_full_pc(); }
+
+    snes::Bus m_bus;
+    snes::Cartridge m_cartridge;
+    snes::CPU m_cpu{m_bus};
+    std::vector<uint8_t> m_image;
+};
+
+const std::vector<Mix> SNES_MIXES = {
+    {"alu", {}, {
+        {"adc #", {0x69, 0x01, 0x00}},
+        {"sbc #", {0xE9, 0x01, 0x00}},
+        {"and #", {0x29, 0xFF, 0x7F}},
+        {"eor #", {0x49, 0x55, 0x55}},
+        {"asl a", {0x0A}},
+        {"ror a", {0x6A}},
+        {"inx", {0xE8}},
+        {"dey", {0x88}},
+        {"tax", {0xAA}},
+        {"xba", {0xEB}},
+        {"clc", {0x18}},
+    }},
+    {"branch", {}, {
+        {"cmp #", {0xC9, 0x10, 0x00}},
+        {"bne", {0xD0, 0x00}},
+        {"beq", {0xF0, 0x00}},
+        {"cpx #", {0xE0, 0x10, 0x00}},
+        {"bcc", {0x90, 0x00}},
+        {"bcs", {0xB0, 0x00}},
+        {"bra", {0x80, 0x00}},
+    }},
+    // X = Y = 0, (dp),Y points at $0500
+    {"memory", {0xA2, 0x00, 0x00, 0xA0, 0x00, 0x00, 0xA9, 0x00, 0x05, 0x85, 0x20}, {
+        {"lda dp", {0xA5, 0x10}},
+        {"sta dp", {0x85, 0x12}},
+        {"lda abs", {0xAD, 0x00, 0x02}},
+        {"sta abs", {0x8D, 0x02, 0x02}},
+        {"lda abs,x", {0xBD, 0x00, 0x03}},
+        {"lda long", {0xAF, 0x00, 0x04, 0x7E}},
+        {"sta long", {0x8F, 0x02, 0x04, 0x7E}},
+        {"lda (dp),y", {0xB1, 0x20}},
+        {"inc dp", {0xE6, 0x14}},
+        {"pha/pla", {0x48, 0x68}, 2},
+    }},
+};
+
+// ---------------------------------------------------------------------------
+// SPC700: the whole 64KB is RAM. Code from $1000 with the IPL ROM mapped
+// out, so reset's jump lands on a JMP at $FFC0; data in the direct page
+// (below the $F0 registers) and at $0400.
+
+class Spc700Harness : public CpuHarness {
+public:
+    static constexpr uint16_t CODE = 0x1000;
+
+    bool load(const Mix& mix, const std::vector<uint8_t>& body) override {
+        m_spc.reset();
+        m_spc.set_ipl_rom_enabled(false);
+
+        uint8_t* ram = m_spc.get_ram();
+        std::memset(ram, 0, 0x10000);
+        ram[0xFFC0] = 0x5F;  // JMP CODE
+        ram[0xFFC1] = static_cast<uint8_t>(CODE);
+        ram[0xFFC2] = static_cast<uint8_t>(CODE >> 8);
+        ram[0x20] = 0x00;    // [dp]+Y points at $0500
+        ram[0x21] = 0x05;
+
+        std::memcpy(ram + CODE, mix.preamble.data(), mix.preamble.size());
+        size_t loop = CODE + mix.preamble.size();
+        std::memcpy(ram + loop, body.data(), body.size());
+        size_t jump = loop + body.size();
+        ram[jump] = 0x5F;  // JMP loop
+        ram[jump + 1] = static_cast<uint8_t>(loop);
+        ram[jump + 2] = static_cast<uint8_t>(loop >> 8);
+        m_loop_start = static_cast<uint32_t>(loop);
+        m_loop_end = static_cast<uint32_t>(jump + 2);
+        return true;
+    }
+
+    uint64_t run(uint64_t count) override {
+        for (uint64_t i = 0; i < count; i++) {
+            m_spc.step();
+        }
+        return count;
+    }
+
+private:
+    uint32_t get_pc() const override { return m_spc.get_pc(); }
+
+    snes::SPC700 m_spc;
+};
+
+const std::vector<Mix> SPC700_MIXES = {
+    {"alu", {}, {
+        {"adc a,#", {0x88, 0x01}},
+        {"sbc a,#", {0xA8, 0x01}},
+        {"and a,#", {0x28, 0xFF}},
+        {"or a,#", {0x08, 0x00}},
+        {"eor a,#", {0x48, 0x55}},
+        {"asl a", {0x1C}},
+        {"ror a", {0x7C}},
+        {"inc x", {0x3D}},
+        {"dec y", {0xDC}},
+        {"mov x,a", {0x5D}},
+        {"mul ya", {0xCF}},
+        {"xcn a", {0x9F}},
+    }},
+    {"branch", {}, {
+        {"cmp a,#", {0x68, 0x10}},
+        {"bne", {0xD0, 0x00}},
+        {"beq", {0xF0, 0x00}},
+        {"cmp x,#", {0xC8, 0x10}},
+        {"bcc", {0x90, 0x00}},
+        {"bcs", {0xB0, 0x00}},
+        {"bra", {0x2F, 0x00}},
+        {"cbne dp", {0x2E, 0x10, 0x00}},
+        {"dbnz y", {0xFE, 0x00}},
+    }},
+    // MOV X,#$40 for (X)
+    {"memory", {0xCD, 0x40}, {
+        {"mov a,dp", {0xE4, 0x10}},
+        {"mov dp,a", {0xC4, 0x12}},
+        {"mov a,!abs", {0xE5, 0x00, 0x04}},
+        {"mov !abs,a", {0xC5, 0x02, 0x04}},
+        {"mov a,[dp]+y", {0xF7, 0x20}},
+        {"mov a,(x)", {0xE6}},
+        {"inc dp", {0xAB, 0x14}},
+        {"movw ya,dp", {0xBA, 0x16}},
+        {"movw dp,ya", {0xDA, 0x18}},
+        {"push/pop a", {0x2D, 0xAE}, 2},
+    }},
+};
+
+// ---------------------------------------------------------------------------
+
+struct CpuEntry {
+    const char* name;
+    std::unique_ptr<CpuHarness> (*create)();
+    const std::vector<Mix>* mixes;
+};
+
+template <typename T>
+std::unique_ptr<CpuHarness> make_harness() {
+    return std::make_unique<T>();
+}
+
+const CpuEntry CPUS[] = {
+    {"nes", make_harness<NesHarness>, &NES_MIXES},
+    {"gb", make_harness<GbHarness>, &GB_MIXES},
+    {"gba", make_harness<GbaHarness>, &GBA_MIXES},
+    {"snes", make_harness<SnesHarness>, &SNES_MIXES},
+    {"spc700", make_harness<Spc700Harness>, &SPC700_MIXES},
+};
+
+struct Options {
+    std::string cpu;         // Only this CPU if set
+    std::string mix;         // Only mixes whose name contains this
+    std::string report_path;
+    uint64_t instructions = DEFAULT_INSTRUCTIONS;
+    int repetitions = DEFAULT_REPETITIONS;
+    bool sweep = false;
+};
+
+void print_usage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [OPTIONS]\n\n";
+    std::cout << "Times each CPU interpreter on generated instruction mixes, with\n";
+    std::cout << "nothing but the CPU's bus attached, and reports ns per instruction.\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  -h, --help          Show this help message and exit\n";
+    std::cout << "  --cpu NAME          Only run nes, gb, gba, snes or spc700\n";
+    std::cout << "  --mix TEXT          Only run mixes whose name contains TEXT\n";
+    std::cout << "  --sweep             Also time every instruction form on its own\n";
+    std::cout << "  --instructions N    Instructions per timed run (default 4000000)\n";
+    std::cout << "  --repetitions N     Timed runs per mix (default 5)\n";
+    std::cout << "  --report PATH       Also write a JSON report to PATH\n";
+}
+
+bool parse_command_line(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+
+        if (std::strcmp(arg, "-h") == 0 || std::strcmp(arg, "--help") == 0) {
+            print_usage(argv[0]);
+            std::exit(0);
+        }
+        else if (std::strcmp(arg, "--sweep") == 0) {
+            options.sweep = true;
+        }
+        else if (std::strcmp(arg, "--cpu") == 0 || std::strcmp(arg, "--mix") == 0 ||
+                 std::strcmp(arg, "--instructions") == 0 || std::strcmp(arg, "--repetitions") == 0 ||
+                 std::strcmp(arg, "--report") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << "\n";
+                return false;
+            }
+            const char* value = argv[++i];
+            if (std::strcmp(arg, "--cpu") == 0) {
+                options.cpu = value;
+            } else if (std::strcmp(arg, "--mix") == 0) {
+                options.mix = value;
+            } else if (std::strcmp(arg, "--instructions") == 0) {
+                long long count = std::atoll(value);
+                if (count <= 0) {
+                    std::cerr << "Invalid instruction count: " << value << "\n";
+                    return false;
+                }
+                options.instructions = static_cast<uint64_t>(count);
+            } else if (std::strcmp(arg, "--repetitions") == 0) {
+                options.repetitions = std::atoi(value);
+                if (options.repetitions <= 0) {
+                    std::cerr << "Invalid repetition count: " << value << "\n";
+                    return false;
+                }
+            } else {
+                options.report_path = value;
+            }
+        }
+        else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            std::cerr << "Use --help for usage information.\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+double median(std::vector<double> values) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t mid = values.size() / 2;
+    return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2.0;
+}
+
+// Whole passes of the snippets, as many as fit in BODY_BYTES (at least one)
+std::vector<uint8_t> build_body(const std::vector<Snippet>& snippets, int& instructions_per_pass) {
+    std::vector<uint8_t> pass;
+    int instructions = 0;
+    for (const Snippet& snippet : snippets) {
+        pass.insert(pass.end(), snippet.bytes.begin(), snippet.bytes.end());
+        instructions += snippet.instructions;
+    }
+
+    size_t passes = std::max<size_t>(1, BODY_BYTES / pass.size());
+    std::vector<uint8_t> body;
+    body.reserve(pass.size() * passes);
+    for (size_t i = 0; i < passes; i++) {
+        body.insert(body.end(), pass.begin(), pass.end());
+    }
+    instructions_per_pass = instructions * static_cast<int>(passes) + 1;  // And the jump back
+    return body;
+}
+
+// Times one loop: an untimed run to settle caches and predictors, then
+// the timed repetitions. Returns the report entry, or null on failure.
+nlohmann::json measure(const CpuEntry& cpu, const Mix& mix, const std::vector<Snippet>& snippets,
+                       const char* name, const Options& options) {
+    int per_pass = 0;
+    std::vector<uint8_t> body = build_body(snippets, per_pass);
+
+    // The cartridges report what they loaded on stdout
+    std::unique_ptr<CpuHarness> harness = cpu.create();
+    std::ostringstream load_log;
+    std::streambuf* stdout_buffer = std::cout.rdbuf(load_log.rdbuf());
+    bool loaded = harness->load(mix, body);
+    std::cout.rdbuf(stdout_buffer);
+    if (!loaded) {
+        std::cerr << cpu.name << " " << name << ": couldn't load the generated program" << std::endl;
+        return nullptr;
+    }
+
+    harness->run(options.instructions / 4);
+    std::vector<double> ns_per_instruction;
+    for (int run = 0; run < options.repetitions; run++) {
+        uint64_t start = now_ns();
+        uint64_t ran = harness->run(options.instructions);
+        uint64_t elapsed = now_ns() - start;
+        ns_per_instruction.push_back(static_cast<double>(elapsed) / static_cast<double>(std::max<uint64_t>(ran, 1)));
+    }
+
+    if (!harness->in_loop()) {
+        std::cerr << cpu.name << " " << name << ": the CPU left the generated loop" << std::endl;
+        return nullptr;
+    }
+
+    double ns = median(ns_per_instruction);
+    char line[160];
+    std::snprintf(line, sizeof(line), "  %-7s %-26s %8.2f ns/instr  %8.1f MIPS\n",
+                  cpu.name, name, ns, ns > 0.0 ? 1000.0 / ns : 0.0);
+    std::cout << line << std::flush;
+
+    nlohmann::json entry;
+    entry["cpu"] = cpu.name;
+    entry["name"] = name;
+    entry["instructions_per_pass"] = per_pass;
+    entry["ns_per_instruction"] = {
+        {"median", ns},
+        {"min", *std::min_element(ns_per_instruction.begin(), ns_per_instruction.end())},
+        {"max", *std::max_element(ns_per_instruction.begin(), ns_per_instruction.end())},
+        {"runs", ns_per_instruction},
+    };
+    return entry;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_command_line(argc, argv, options)) {
+        return 1;
+    }
+
+    std::cout << "veloce_cpu_bench: " << options.instructions << " instructions x "
+              << options.repetitions << " timed runs per loop\n";
+
+    bool failed = false;
+    bool ran = false;
+    nlohmann::json mixes = nlohmann::json::array();
+    nlohmann::json sweep = nlohmann::json::array();
+    for (const CpuEntry& cpu : CPUS) {
+        if (!options.cpu.empty() && options.cpu != cpu.name) continue;
+
+        for (const Mix& mix : *cpu.mixes) {
+            if (!options.mix.empty() && std::string(mix.name).find(options.mix) == std::string::npos) continue;
+            ran = true;
+
+            nlohmann::json entry = measure(cpu, mix, mix.snippets, mix.name, options);
+            if (entry.is_null()) {
+                failed = true;
+                continue;
+            }
+            mixes.push_back(std::move(entry));
+
+            if (!options.sweep) continue;
+            for (const Snippet& snippet : mix.snippets) {
+                std::string name = std::string(mix.name) + ": " + snippet.name;
+                entry = measure(cpu, mix, {snippet}, name.c_str(), options);
+                if (entry.is_null()) {
+                    failed = true;
+                    continue;
+                }
+                entry["mix"] = mix.name;
+                entry["instruction"] = snippet.name;
+                sweep.push_back(std::move(entry));
+            }
+        }
+    }
+
+    if (!ran) {
+        std::cerr << "No CPU or mix matched" << std::endl;
+        return 1;
+    }
+
+    if (!options.report_path.empty()) {
+        std::ofstream out(options.report_path);
+        nlohmann::json report;
+        report["instructions"] = options.instructions;
+        report["repetitions"] = options.repetitions;
+        report["mixes"] = mixes;
+        report["sweep"] = sweep;
+        out << report.dump(2) << '\n';
+        if (!out) {
+            std::cerr << "Failed to write report " << options.report_path << std::endl;
+            return 1;
+        }
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,384 @@
+// veloce_bench - fixed per-core workloads for tracking emulation speed
+//
+// Every core is linked in statically and driven straight through
+// IEmulatorPlugin, so the numbers cover the cores alone: no plugin loading,
+// frontend, audio device or frame pacing. Each workload restarts from the
+// same power-on state for every run, is run a few times untimed to warm the
+// caches and branch predictors, then timed for several repetitions. The
+// report gives the median and the median absolute deviation (MAD), which a
+// single slow run from a noisy machine can't drag around the way it does a
+// mean and standard deviation.
+
+#include "core/benchmark.hpp"
+#include "emu/emulator_plugin.hpp"
+
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Factories exported by the cores' static builds (VELOCE_STATIC_CORE)
+namespace nes { emu::IEmulatorPlugin* create_static_plugin(); }
+namespace snes { emu::IEmulatorPlugin* create_static_plugin(); }
+namespace gb { emu::IEmulatorPlugin* create_static_plugin(); }
+namespace gba { emu::IEmulatorPlugin* create_static_plugin(); }
+
+namespace {
+
+struct CoreEntry {
+    const char* name;
+    emu::IEmulatorPlugin* (*create)();
+};
+
+const CoreEntry CORES[] = {
+    {"nes", nes::create_static_plugin},
+    {"snes", snes::create_static_plugin},
+    {"gb", gb::create_static_plugin},
+    {"gba", gba::create_static_plugin},
+};
+
+// Results whose MAD is above this share of the median are flagged unstable
+constexpr double DEFAULT_MAX_MAD_PERCENT = 2.0;
+
+struct Workload {
+    std::string name;
+    std::string core;
+    std::string rom;          // Relative to the ROM directory
+    std::string movie;        // FM2 input log, relative to the ROM directory
+    std::string description;
+    std::string crc32;        // Expected ROM CRC32 (hex); unchecked if empty
+    int frames = 600;
+    bool video = true;
+    bool audio = true;
+};
+
+struct Options {
+    std::string workloads_path = VELOCE_BENCH_WORKLOADS;
+    std::string rom_dir;
+    std::string filter;
+    std::string report_path;
+    int warmup = -1;       // -1: use the workload file's value
+    int repetitions = -1;
+    double max_mad_percent = DEFAULT_MAX_MAD_PERCENT;
+    bool list = false;
+};
+
+void print_usage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [OPTIONS]\n\n";
+    std::cout << "Runs the benchmark workloads for every core and reports median\n";
+    std::cout << "throughput. Workloads whose ROM isn't present are skipped.\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  -h, --help          Show this help message and exit\n";
+    std::cout << "  --list              List the workloads and the ROMs they need\n";
+    std::cout << "  --workloads PATH    Workload file (default bench/workloads.json)\n";
+    std::cout << "  --roms DIR          ROM directory (default $VELOCE_BENCH_ROMS, then\n";
+    std::cout << "                      roms/ next to the workload file)\n";
+    std::cout << "  --filter TEXT       Only run workloads whose name contains TEXT\n";
+    std::cout << "  --warmup N          Untimed runs before measuring\n";
+    std::cout << "  --repetitions N     Timed runs per workload\n";
+    std::cout << "  --max-mad PERCENT   Flag results noisier than this (default 2)\n";
+    std::cout << "  --report PATH       Also write a JSON report to PATH\n";
+}
+
+bool parse_command_line(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+
+        if (std::strcmp(arg, "-h") == 0 || std::strcmp(arg, "--help") == 0) {
+            print_usage(argv[0]);
+            std::exit(0);
+        }
+        else if (std::strcmp(arg, "--list") == 0) {
+            options.list = true;
+        }
+        else if (std::strcmp(arg, "--workloads") == 0 || std::strcmp(arg, "--roms") == 0 ||
+                 std::strcmp(arg, "--filter") == 0 || std::strcmp(arg, "--warmup") == 0 ||
+                 std::strcmp(arg, "--repetitions") == 0 || std::strcmp(arg, "--max-mad") == 0 ||
+                 std::strcmp(arg, "--report") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << "\n";
+                return false;
+            }
+            const char* value = argv[++i];
+            if (std::strcmp(arg, "--workloads") == 0) {
+                options.workloads_path = value;
+            } else if (std::strcmp(arg, "--roms") == 0) {
+                options.rom_dir = value;
+            } else if (std::strcmp(arg, "--filter") == 0) {
+                options.filter = value;
+            } else if (std::strcmp(arg, "--warmup") == 0) {
+                options.warmup = std::atoi(value);
+                if (options.warmup < 0) {
+                    std::cerr << "Invalid warmup count: " << value << "\n";
+                    return false;
+                }
+            } else if (std::strcmp(arg, "--repetitions") == 0) {
+                options.repetitions = std::atoi(value);
+                if (options.repetitions <= 0) {
+                    std::cerr << "Invalid repetition count: " << value << "\n";
+                    return false;
+                }
+            } else if (std::strcmp(arg, "--max-mad") == 0) {
+                options.max_mad_percent = std::atof(value);
+            } else {
+                options.report_path = value;
+            }
+        }
+        else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            std::cerr << "Use --help for usage information.\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool read_file(const std::filesystem::path& path, std::vector<uint8_t>& data) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+bool load_workloads(const std::string& path, int& warmup, int& repetitions, std::vector<Workload>& workloads) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open workload file " << path << std::endl;
+        return false;
+    }
+
+    try {
+        nlohmann::json root = nlohmann::json::parse(file);
+        warmup = root.value("warmup", 1);
+        repetitions = root.value("repetitions", 5);
+        for (const auto& entry : root.at("workloads")) {
+            Workload w;
+            w.name = entry.at("name").get<std::string>();
+            w.core = entry.at("core").get<std::string>();
+            w.rom = entry.at("rom").get<std::string>();
+            w.movie = entry.value("movie", "");
+            w.description = entry.value("description", "");
+            w.crc32 = entry.value("crc32", "");
+            w.frames = entry.value("frames", 600);
+            w.video = entry.value("video", true);
+            w.audio = entry.value("audio", true);
+            workloads.push_back(std::move(w));
+        }
+    } catch (const nlohmann::json::exception& e) {
+        std::cerr << "Invalid workload file " << path << ": " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+const CoreEntry* find_core(const std::string& name) {
+    for (const auto& core : CORES) {
+        if (name == core.name) return &core;
+    }
+    return nullptr;
+}
+
+double median(std::vector<double> values) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t mid = values.size() / 2;
+    return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2.0;
+}
+
+double median_absolute_deviation(const std::vector<double>& values, double center) {
+    std::vector<double> deviations;
+    deviations.reserve(values.size());
+    for (double v : values) deviations.push_back(std::fabs(v - center));
+    return median(deviations);
+}
+
+// Runs one workload; returns its report entry, or null if it was skipped
+nlohmann::json run_workload(const Workload& w, const std::filesystem::path& rom_dir,
+                            int warmup, int repetitions, double max_mad_percent, bool& failed) {
+    const CoreEntry* core = find_core(w.core);
+    if (!core) {
+        std::cerr << w.name << ": unknown core '" << w.core << "'" << std::endl;
+        failed = true;
+        return nullptr;
+    }
+
+    std::vector<uint8_t> rom;
+    if (!read_file(rom_dir / w.rom, rom)) {
+        std::cout << "  " << w.name << ": skipped, " << (rom_dir / w.rom).string() << " not found\n";
+        return nullptr;
+    }
+
+    std::vector<uint32_t> inputs;
+    if (!w.movie.empty() && !emu::Benchmark::load_fm2_inputs((rom_dir / w.movie).string(), inputs)) {
+        std::cout << "  " << w.name << ": skipped, " << (rom_dir / w.movie).string() << " not found\n";
+        return nullptr;
+    }
+
+    std::unique_ptr<emu::IEmulatorPlugin> plugin(core->create());
+    if (!plugin->load_rom(rom.data(), rom.size())) {
+        std::cerr << w.name << ": " << w.core << " core rejected " << w.rom << std::endl;
+        failed = true;
+        return nullptr;
+    }
+
+    char crc[16];
+    std::snprintf(crc, sizeof(crc), "%08x", plugin->get_rom_crc32());
+    if (!w.crc32.empty() && w.crc32 != crc) {
+        std::cerr << "  " << w.name << ": warning, ROM CRC32 is " << crc << ", expected " << w.crc32
+                  << "; results aren't comparable with other runs" << std::endl;
+    }
+
+    // Every run starts from the same power-on state
+    std::vector<uint8_t> power_on;
+    bool has_power_on = plugin->save_state(power_on);
+
+    std::vector<double> fps;
+    std::vector<double> p99_ns;
+    uint64_t samples[static_cast<size_t>(emu::ProfileSection::Count)] = {};
+    for (int run = 0; run < warmup + repetitions; run++) {
+        if (has_power_on) {
+            plugin->load_state(power_on);
+        } else {
+            plugin->reset();
+        }
+
+        emu::BenchmarkResult result = emu::Benchmark::measure(*plugin, w.frames, inputs, w.video, w.audio);
+        if (run < warmup) continue;
+
+        fps.push_back(static_cast<double>(w.frames) * 1e9 / static_cast<double>(std::max<uint64_t>(result.total_ns, 1)));
+        std::sort(result.frame_ns.begin(), result.frame_ns.end());
+        p99_ns.push_back(result.frame_ns.empty() ? 0.0 :
+            static_cast<double>(result.frame_ns[(result.frame_ns.size() - 1) * 99 / 100]));
+        for (size_t i = 0; i < static_cast<size_t>(emu::ProfileSection::Count); i++) {
+            samples[i] += result.samples[i];
+        }
+    }
+
+    emu::EmulatorInfo info = plugin->get_info();
+    double fps_median = median(fps);
+    double fps_mad = median_absolute_deviation(fps, fps_median);
+    double mad_percent = fps_median > 0.0 ? fps_mad / fps_median * 100.0 : 0.0;
+    bool stable = mad_percent <= max_mad_percent;
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "  %-14s %-5s %6d frames  %9.1f fps  %6.1fx  MAD %5.2f%%%s\n",
+                  w.name.c_str(), w.core.c_str(), w.frames, fps_median,
+                  info.native_fps > 0.0 ? fps_median / info.native_fps : 0.0,
+                  mad_percent, stable ? "" : "  (unstable)");
+    std::cout << line << std::flush;
+
+    nlohmann::json entry;
+    entry["name"] = w.name;
+    entry["core"] = w.core;
+    entry["core_version"] = info.version ? info.version : "";
+    entry["rom"] = w.rom;
+    entry["rom_crc32"] = crc;
+    entry["movie"] = w.movie.empty() ? nlohmann::json(nullptr) : nlohmann::json(w.movie);
+    entry["frames"] = w.frames;
+    entry["video"] = w.video;
+    entry["audio"] = w.audio;
+    entry["warmup"] = warmup;
+    entry["repetitions"] = repetitions;
+    entry["fps"] = {
+        {"median", fps_median},
+        {"mad", fps_mad},
+        {"mad_percent", mad_percent},
+        {"min", *std::min_element(fps.begin(), fps.end())},
+        {"max", *std::max_element(fps.begin(), fps.end())},
+        {"runs", fps},
+    };
+    entry["speed"] = info.native_fps > 0.0 ? fps_median / info.native_fps : 0.0;
+    entry["frame_ns_p99"] = median(p99_ns);
+    entry["stable"] = stable;
+
+    uint64_t sample_count = 0;
+    for (uint64_t n : samples) sample_count += n;
+    if (sample_count > 0) {
+        nlohmann::json subsystems;
+        for (size_t i = 0; i < static_cast<size_t>(emu::ProfileSection::Count); i++) {
+            subsystems[emu::profile_section_name(static_cast<emu::ProfileSection>(i))] =
+                static_cast<double>(samples[i]) / static_cast<double>(sample_count);
+        }
+        entry["subsystems"] = subsystems;
+    } else {
+        entry["subsystems"] = nullptr;
+    }
+    return entry;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_command_line(argc, argv, options)) {
+        return 1;
+    }
+
+    int warmup = 0;
+    int repetitions = 0;
+    std::vector<Workload> workloads;
+    if (!load_workloads(options.workloads_path, warmup, repetitions, workloads)) {
+        return 1;
+    }
+    if (options.warmup >= 0) warmup = options.warmup;
+    if (options.repetitions > 0) repetitions = options.repetitions;
+    repetitions = std::max(repetitions, 1);
+
+    std::filesystem::path rom_dir;
+    if (!options.rom_dir.empty()) {
+        rom_dir = options.rom_dir;
+    } else if (const char* env = std::getenv("VELOCE_BENCH_ROMS")) {
+        rom_dir = env;
+    } else {
+        rom_dir = std::filesystem::path(options.workloads_path).parent_path() / "roms";
+    }
+
+    if (options.list) {
+        for (const auto& w : workloads) {
+            std::cout << w.name << " (" << w.core << ", " << w.frames << " frames)\n";
+            if (!w.description.empty()) std::cout << "    " << w.description << "\n";
+            std::cout << "    rom:   " << (rom_dir / w.rom).string() << "\n";
+            if (!w.movie.empty()) std::cout << "    movie: " << (rom_dir / w.movie).string() << "\n";
+        }
+        return 0;
+    }
+
+    std::cout << "veloce_bench: " << warmup << " warmup + " << repetitions
+              << " timed runs per workload, ROMs from " << rom_dir.string() << "\n";
+
+    bool failed = false;
+    nlohmann::json results = nlohmann::json::array();
+    for (const auto& w : workloads) {
+        if (!options.filter.empty() && w.name.find(options.filter) == std::string::npos) continue;
+        nlohmann::json entry = run_workload(w, rom_dir, warmup, repetitions, options.max_mad_percent, failed);
+        if (!entry.is_null()) results.push_back(std::move(entry));
+    }
+
+    if (results.empty() && !failed) {
+        std::cerr << "No workloads ran; see --list for the ROMs they need" << std::endl;
+        return 1;
+    }
+
+    if (!options.report_path.empty()) {
+        std::ofstream out(options.report_path);
+        nlohmann::json report;
+        report["warmup"] = warmup;
+        report["repetitions"] = repetitions;
+        report["workloads"] = results;
+        out << report.dump(2) << '\n';
+        if (!out) {
+            std::cerr << "Failed to write report " << options.report_path << std::endl;
+            return 1;
+        }
+    }
+
+    return failed ? 1 : 0;
+}
@@ -1,15 +1,12 @@
 #include "apu.hpp"
 #include "debug.hpp"
+#include "emu/state_writer.hpp"
 #include <cstring>
 #include <algorithm>
 #include <cstdio>
 
 namespace gb {
 
-// Debug statistics for audio tracking
-static uint64_t s_debug_total_samples = 0;
-static uint64_t s_debug_frame_count = 0;
-
 // Duty patterns for pulse channels
 // These patterns determine when the waveform is HIGH (1) vs LOW (0)
 // The actual output will be converted to bipolar (-1 to +1) based on volume
@@ -21,6 +18,8 @@ const uint8_t APU::s_duty_table[4][8] = {
 };
 
 APU::APU() {
+    m_blip_left.set_rates(CLOCK_RATE, SAMPLE_RATE);
+    m_blip_right.set_rates(CLOCK_RATE, SAMPLE_RATE);
     m_wave.wave_ram.fill(0);
     reset();
 }
@@ -28,6 +27,7 @@ APU::APU() {
 APU::~APU() = default;
 
 void APU::reset() {
+    m_pending_cycles = 0;
     // Initialize to post-boot ROM state
     // NR52 = 0xF1 means sound is enabled (bit 7 = 1) and channel 1 is on (bit 0 = 1)
     m_nr50 = 0x77;
@@ -44,7 +44,6 @@ void APU::reset() {
     m_frame_counter = 0;
     m_frame_counter_step = 0;
     m_cycles = 0;
-    m_sample_counter = 0;
     m_audio_write_pos = 0;
 
     // Reset audio filters
@@ -54,118 +53,279 @@ void APU::reset() {
     m_hp_prev_in_right = 0.0f;
     m_lp_filter_left = 0.0f;
     m_lp_filter_right = 0.0f;
+
+    // Reset band-limited synthesis
+    m_blip_left.clear();
+    m_blip_right.clear();
+    m_level_left = 0.0f;
+    m_level_right = 0.0f;
+    m_blip_time = 0;
+    m_mix_dirty = true;
 }
 
-void APU::step(int cycles) {
-    if (!m_enabled) return;
+// Advance a channel timer that reloads with 'period' when it expires by
+// 'cycles' in one go, the same as that many single-cycle steps; returns
+// the number of expiries
+static int run_timer(uint16_t& timer, int period, int cycles) {
+    int first = std::max<int>(timer, 1);
+    if (cycles < first) {
+        timer -= cycles;
+        return 0;
+    }
+    int after = cycles - first;
+    timer = static_cast<uint16_t>(period - after % period);
+    return 1 + after / period;
+}
 
-    for (int i = 0; i < cycles; i++) {
-        m_frame_counter++;
+static int noise_period(uint8_t divisor_code, uint8_t clock_shift) {
+    // Divisor table: r=0 -> 8, else r*16. Large shifts wrap the 16-bit
+    // timer; a reload of 0 expires again on the next cycle.
+    uint16_t divisor = divisor_code == 0 ? 8 : (divisor_code * 16);
+    return std::max(static_cast<uint16_t>(divisor << clock_shift), uint16_t(1));
+}
 
-        // Frame sequencer clocks at 512 Hz (every 8192 T-cycles on GB @ 4.194304 MHz)
-        // CGB double-speed mode still uses the same frame period (APU runs at normal speed)
-        constexpr int FRAME_PERIOD = 8192;
-        if (m_frame_counter >= FRAME_PERIOD) {
-            m_frame_counter -= FRAME_PERIOD;
-            clock_frame_sequencer();
-        }
+void APU::sync() {
+    if (m_pending_cycles == 0) return;
+    int cycles = m_pending_cycles;
+    m_pending_cycles = 0;
+    run(cycles);
+}
 
-        // Step pulse 1 timer - always runs even when channel is disabled (for proper reload)
-        // Timer clocks at CPU/4 rate, but we're already in T-cycles so check every cycle
-        if (m_pulse1.timer > 0) {
-            m_pulse1.timer--;
-        }
-        if (m_pulse1.timer == 0) {
-            m_pulse1.timer = (2048 - m_pulse1.frequency) * 4;
-            m_pulse1.sequence_pos = (m_pulse1.sequence_pos + 1) & 7;
+void APU::run(int cycles) {
+    while (cycles > 0) {
+        // Register writes since the last step land at the current time
+        if (m_audio_enabled && m_mix_dirty) {
+            update_mix();
         }
 
-        // Step pulse 2 timer
-        if (m_pulse2.timer > 0) {
-            m_pulse2.timer--;
+        // Run straight to the next cycle where the output can change; only
+        // that last cycle goes through the per-cycle path
+        int run = cycles;
+        if (m_audio_enabled) {
+            run = std::min(run, static_cast<int>(BLIP_FRAME_CYCLES - m_blip_time));
         }
-        if (m_pulse2.timer == 0) {
-            m_pulse2.timer = (2048 - m_pulse2.frequency) * 4;
-            m_pulse2.sequence_pos = (m_pulse2.sequence_pos + 1) & 7;
+        if (m_enabled) {
+            run = std::min(run, cycles_until_event());
+            advance_channels(run - 1);
+            clock_cycle();
         }
+        cycles -= run;
 
-        // Step wave timer - wave channel clocks at CPU/2 rate
-        if (m_wave.timer > 0) {
-            m_wave.timer--;
-        }
-        if (m_wave.timer == 0) {
-            m_wave.timer = (2048 - m_wave.frequency) * 2;
-            m_wave.position = (m_wave.position + 1) & 31;
-            uint8_t byte = m_wave.wave_ram[m_wave.position / 2];
-            m_wave.sample_buffer = (m_wave.position & 1) ? (byte & 0x0F) : (byte >> 4);
+        if (m_audio_enabled) {
+            m_blip_time += run;
+            if (m_mix_dirty) {
+                update_mix();
+            }
+            if (m_blip_time >= BLIP_FRAME_CYCLES) {
+                flush_samples();
+            }
         }
+    }
+}
+
+bool APU::pulse_audible(bool enabled, uint8_t envelope_initial, bool envelope_dir,
+                        uint8_t volume, uint8_t nr51_bits) const {
+    bool dac = (envelope_initial > 0) || envelope_dir;
+    return m_audio_enabled && enabled && dac && volume > 0 && (m_nr51 & nr51_bits);
+}
+
+bool APU::wave_audible() const {
+    return m_audio_enabled && m_wave.enabled && m_wave.dac_enabled &&
+           m_wave.volume_code > 0 && (m_nr51 & 0x44);
+}
 
-        // Step noise timer
-        if (m_noise.timer > 0) {
-            m_noise.timer--;
+bool APU::noise_audible() const {
+    return pulse_audible(m_noise.enabled, m_noise.envelope_initial, m_noise.envelope_dir,
+                         m_noise.volume, 0x88);
+}
+
+int APU::cycles_until_event() const {
+    int cycles = FRAME_PERIOD - m_frame_counter;
+    if (pulse_audible(m_pulse1.enabled, m_pulse1.envelope_initial, m_pulse1.envelope_dir,
+                      m_pulse1.volume, 0x11)) {
+        cycles = std::min<int>(cycles, std::max<int>(m_pulse1.timer, 1));
+    }
+    if (pulse_audible(m_pulse2.enabled, m_pulse2.envelope_initial, m_pulse2.envelope_dir,
+                      m_pulse2.volume, 0x22)) {
+        cycles = std::min<int>(cycles, std::max<int>(m_pulse2.timer, 1));
+    }
+    if (wave_audible()) {
+        cycles = std::min<int>(cycles, std::max<int>(m_wave.timer, 1));
+    }
+    if (noise_audible()) {
+        cycles = std::min<int>(cycles, std::max<int>(m_noise.timer, 1));
+    }
+    return cycles;
+}
+
+void APU::advance_channels(int cycles) {
+    // Stays short of cycles_until_event(), so neither the frame sequencer
+    // nor an audible channel expires here
+    if (cycles <= 0) return;
+    m_frame_counter += cycles;
+
+    int fires = run_timer(m_pulse1.timer, (2048 - m_pulse1.frequency) * 4, cycles);
+    m_pulse1.sequence_pos = (m_pulse1.sequence_pos + fires) & 7;
+
+    fires = run_timer(m_pulse2.timer, (2048 - m_pulse2.frequency) * 4, cycles);
+    m_pulse2.sequence_pos = (m_pulse2.sequence_pos + fires) & 7;
+
+    fires = run_timer(m_wave.timer, (2048 - m_wave.frequency) * 2, cycles);
+    if (fires > 0) {
+        m_wave.position = (m_wave.position + fires) & 31;
+        uint8_t byte = m_wave.wave_ram[m_wave.position / 2];
+        m_wave.sample_buffer = (m_wave.position & 1) ? (byte & 0x0F) : (byte >> 4);
+    }
+
+    fires = run_timer(m_noise.timer, noise_period(m_noise.divisor_code, m_noise.clock_shift), cycles);
+    for (int i = 0; i < fires; i++) {
+        uint16_t xor_result = (m_noise.lfsr & 1) ^ ((m_noise.lfsr >> 1) & 1);
+        m_noise.lfsr = (m_noise.lfsr >> 1) | (xor_result << 14);
+        if (m_noise.width_mode) {
+            m_noise.lfsr &= ~(1 << 6);
+            m_noise.lfsr |= xor_result << 6;
         }
-        if (m_noise.timer == 0) {
-            // Divisor table: r=0 -> 8, else r*16
-            uint16_t divisor = m_noise.divisor_code == 0 ? 8 : (m_noise.divisor_code * 16);
-            m_noise.timer = divisor << m_noise.clock_shift;
-
-            // Clock LFSR - XOR bits 0 and 1
-            uint16_t xor_result = (m_noise.lfsr & 1) ^ ((m_noise.lfsr >> 1) & 1);
-            m_noise.lfsr = (m_noise.lfsr >> 1) | (xor_result << 14);
-            if (m_noise.width_mode) {
-                // 7-bit mode: also set bit 6
-                m_noise.lfsr &= ~(1 << 6);
-                m_noise.lfsr |= xor_result << 6;
-            }
+    }
+}
+
+void APU::clock_cycle() {
+    m_frame_counter++;
+
+    // Frame sequencer clocks at 512 Hz (every 8192 T-cycles on GB @ 4.194304 MHz)
+    // CGB double-speed mode still uses the same frame period (APU runs at normal speed)
+    if (m_frame_counter >= FRAME_PERIOD) {
+        m_frame_counter -= FRAME_PERIOD;
+        clock_frame_sequencer();
+        m_mix_dirty = true;
+    }
+
+    // Step pulse 1 timer - always runs even when channel is disabled (for proper reload)
+    // Timer clocks at CPU/4 rate, but we're already in T-cycles so check every cycle
+    if (m_pulse1.timer > 0) {
+        m_pulse1.timer--;
+    }
+    if (m_pulse1.timer == 0) {
+        m_pulse1.timer = (2048 - m_pulse1.frequency) * 4;
+        m_pulse1.sequence_pos = (m_pulse1.sequence_pos + 1) & 7;
+        m_mix_dirty = true;
+    }
+
+    // Step pulse 2 timer
+    if (m_pulse2.timer > 0) {
+        m_pulse2.timer--;
+    }
+    if (m_pulse2.timer == 0) {
+        m_pulse2.timer = (2048 - m_pulse2.frequency) * 4;
+        m_pulse2.sequence_pos = (m_pulse2.sequence_pos + 1) & 7;
+        m_mix_dirty = true;
+    }
+
+    // Step wave timer - wave channel clocks at CPU/2 rate
+    if (m_wave.timer > 0) {
+        m_wave.timer--;
+    }
+    if (m_wave.timer == 0) {
+        m_wave.timer = (2048 - m_wave.frequency) * 2;
+        m_wave.position = (m_wave.position + 1) & 31;
+        uint8_t byte = m_wave.wave_ram[m_wave.position / 2];
+        m_wave.sample_buffer = (m_wave.position & 1) ? (byte & 0x0F) : (byte >> 4);
+        m_mix_dirty = true;
+    }
+
+    // Step noise timer
+    if (m_noise.timer > 0) {
+        m_noise.timer--;
+    }
+    if (m_noise.timer == 0) {
+        uint16_t divisor = m_noise.divisor_code == 0 ? 8 : (m_noise.divisor_code * 16);
+        m_noise.timer = divisor << m_noise.clock_shift;
+
+        // Clock LFSR - XOR bits 0 and 1
+        uint16_t xor_result = (m_noise.lfsr & 1) ^ ((m_noise.lfsr >> 1) & 1);
+        m_noise.lfsr = (m_noise.lfsr >> 1) | (xor_result << 14);
+        if (m_noise.width_mode) {
+            // 7-bit mode: also set bit 6
+            m_noise.lfsr &= ~(1 << 6);
+            m_noise.lfsr |= xor_result << 6;
         }
+        m_mix_dirty = true;
+    }
+}
 
-        // Generate sample at target rate (~44100 Hz)
-        // GB CPU: 4194304 Hz (T-cycles), target: 44100 Hz -> 4194304/44100 = ~95.1 cycles per sample
-        // Use fractional accumulator for accurate timing
-        m_sample_counter += 44100;
-        constexpr int GB_CPU_FREQ = 4194304;  // T-cycle frequency
-        if (m_sample_counter >= GB_CPU_FREQ) {
-            m_sample_counter -= GB_CPU_FREQ;
-
-            if (m_audio_write_pos < AUDIO_BUFFER_SIZE) {
-                float left, right;
-                mix_output(left, right);
-
-                // Apply high-pass filter to remove DC offset (~37Hz cutoff like real GB)
-                // y[n] = alpha * (y[n-1] + x[n] - x[n-1])
-                // Alpha = 1 / (1 + 2*pi*fc/fs) = 1 / (1 + 2*pi*37/44100) = 0.9947
-                constexpr float HP_ALPHA = 0.9947f;
-                float hp_left = HP_ALPHA * (m_hp_filter_left + left - m_hp_prev_in_left);
-                float hp_right = HP_ALPHA * (m_hp_filter_right + right - m_hp_prev_in_right);
-                m_hp_prev_in_left = left;
-                m_hp_prev_in_right = right;
-                m_hp_filter_left = hp_left;
-                m_hp_filter_right = hp_right;
-
-                // Apply gentle low-pass filter for smoothing (~14kHz)
-                // Alpha = 2 * pi * fc / fs = 2 * pi * 14000 / 44100 = 0.5
-                constexpr float LP_ALPHA = 0.5f;
-                m_lp_filter_left = m_lp_filter_left + LP_ALPHA * (hp_left - m_lp_filter_left);
-                m_lp_filter_right = m_lp_filter_right + LP_ALPHA * (hp_right - m_lp_filter_right);
-
-                // If streaming callback is set, use low-latency path
-                if (m_audio_callback) {
-                    m_stream_buffer[m_stream_pos * 2] = m_lp_filter_left;
-                    m_stream_buffer[m_stream_pos * 2 + 1] = m_lp_filter_right;
-                    m_stream_pos++;
-
-                    // Flush when buffer is full (every 64 samples = ~1.5ms)
-                    if (m_stream_pos >= STREAM_BUFFER_SIZE) {
-                        m_audio_callback(m_stream_buffer, m_stream_pos, 44100);
-                        m_stream_pos = 0;
-                    }
-                } else {
-                    // Legacy path: buffer until get_samples() is called
-                    m_audio_buffer[m_audio_write_pos * 2] = m_lp_filter_left;
-                    m_audio_buffer[m_audio_write_pos * 2 + 1] = m_lp_filter_right;
-                    m_audio_write_pos++;
-                }
-            }
+void APU::set_audio_enabled(bool enabled) {
+    if (enabled == m_audio_enabled) return;
+    sync();
+    m_audio_enabled = enabled;
+    if (enabled) {
+        restart_synthesis();
+    }
+}
+
+void APU::restart_synthesis() {
+    // Restart at the current mix level; lining the high-pass inputs up with
+    // it keeps the output from stepping
+    mix_output(m_level_left, m_level_right);
+    m_blip_left.clear(m_level_left);
+    m_blip_right.clear(m_level_right);
+    m_blip_time = 0;
+    m_mix_dirty = false;
+    m_hp_prev_in_left = m_level_left;
+    m_hp_prev_in_right = m_level_right;
+}
+
+void APU::update_mix() {
+    m_mix_dirty = false;
+    float left, right;
+    mix_output(left, right);
+    if (left != m_level_left) {
+        m_blip_left.add_delta(m_blip_time, left - m_level_left);
+        m_level_left = left;
+    }
+    if (right != m_level_right) {
+        m_blip_right.add_delta(m_blip_time, right - m_level_right);
+        m_level_right = right;
+    }
+}
+
+void APU::flush_samples() {
+    m_blip_left.end_frame(m_blip_time);
+    m_blip_right.end_frame(m_blip_time);
+    m_blip_time = 0;
+
+    float left_samples[256];
+    float right_samples[256];
+    size_t count = m_blip_left.read_samples(left_samples, 256);
+    m_blip_right.read_samples(right_samples, count);
+
+    for (size_t i = 0; i < count; i++) {
+        float left = left_samples[i];
+        float right = right_samples[i];
+
+        // Apply high-pass filter to remove DC offset (~37Hz cutoff like real GB)
+        // y[n] = alpha * (y[n-1] + x[n] - x[n-1])
+        // Alpha = 1 / (1 + 2*pi*fc/fs) = 1 / (1 + 2*pi*37/44100) = 0.9947
+        constexpr float HP_ALPHA = 0.9947f;
+        float hp_left = HP_ALPHA * (m_hp_filter_left + left - m_hp_prev_in_left);
+        float hp_right = HP_ALPHA * (m_hp_filter_right + right - m_hp_prev_in_right);
+        m_hp_prev_in_left = left;
+        m_hp_prev_in_right = right;
+        m_hp_filter_left = hp_left;
+        m_hp_filter_right = hp_right;
+
+        // Apply gentle low-pass filter for smoothing (~14kHz)
+        // Alpha = 2 * pi * fc / fs = 2 * pi * 14000 / 44100 = 0.5
+        constexpr float LP_ALPHA = 0.5f;
+        m_lp_filter_left = m_lp_filter_left + LP_ALPHA * (hp_left - m_lp_filter_left);
+        m_lp_filter_right = m_lp_filter_right + LP_ALPHA * (hp_right - m_lp_filter_right);
+
+        // If a stream sink is set, use low-latency path
+        if (m_stream.active()) {
+            m_stream.push(m_lp_filter_left, m_lp_filter_right);
+        } else if (m_audio_write_pos < AUDIO_BUFFER_SIZE) {
+            // Legacy path: buffer until get_samples() is called
+            m_audio_buffer[m_audio_write_pos * 2] = m_lp_filter_left;
+            m_audio_buffer[m_audio_write_pos * 2 + 1] = m_lp_filter_right;
+            m_audio_write_pos++;
         }
     }
 }
@@ -391,6 +551,7 @@ void APU::mix_output(float& left, float& right) {
 }
 
 uint8_t APU::read_register(uint16_t address) {
+    sync();
     switch (address & 0xFF) {
         // Pulse 1
         case 0x10: return 0x80 | (m_pulse1.sweep_period << 4) | (m_pulse1.sweep_negate ? 0x08 : 0) | m_pulse1.sweep_shift;
@@ -438,7 +599,9 @@ uint8_t APU::read_register(uint16_t address) {
 }
 
 void APU::write_register(uint16_t address, uint8_t value) {
+    sync();
     uint8_t reg = address & 0xFF;
+    m_mix_dirty = true;
 
     // If APU is disabled, only NR52 and length registers (on DMG) can be written
     // On DMG, NRx1 length registers (NR11=0x11, NR21=0x16, NR31=0x1B, NR41=0x20)
@@ -718,16 +881,22 @@ void APU::write_register(uint16_t address, uint8_t value) {
 }
 
 size_t APU::get_samples(float* buffer, size_t max_samples) {
+    sync();
+    // Draw the partial blip frame so each call returns everything emulated so far
+    if (m_audio_enabled && m_blip_time > 0) {
+        flush_samples();
+    }
+
     size_t samples = std::min(m_audio_write_pos, max_samples);
     std::memcpy(buffer, m_audio_buffer.data(), samples * 2 * sizeof(float));
 
     // Debug logging once per second (every 60 frames)
     if (is_debug_mode()) {
-        s_debug_total_samples += samples;
-        s_debug_frame_count++;
+        m_debug_total_samples += samples;
+        m_debug_frame_count++;
 
-        if (s_debug_frame_count % 60 == 0) {
-            float avg_samples = static_cast<float>(s_debug_total_samples) / 60.0f;
+        if (m_debug_frame_count % 60 == 0) {
+            float avg_samples = static_cast<float>(m_debug_total_samples) / 60.0f;
             fprintf(stderr, "[APU] Avg samples/frame: %.1f (expected ~735 for GB)\n", avg_samples);
             fprintf(stderr, "[APU] CH1: enabled=%d vol=%d freq=%d duty=%d timer=%d\n",
                    m_pulse1.enabled, m_pulse1.volume, m_pulse1.frequency,
@@ -740,7 +909,7 @@ size_t APU::get_samples(float* buffer, size_t max_samples) {
                    m_noise.enabled, m_noise.volume, m_noise.lfsr);
             fprintf(stderr, "[APU] NR50=0x%02X NR51=0x%02X NR52=0x%02X enabled=%d\n",
                    m_nr50, m_nr51, m_nr52, m_enabled);
-            s_debug_total_samples = 0;
+            m_debug_total_samples = 0;
         }
     }
 
@@ -748,7 +917,8 @@ size_t APU::get_samples(float* buffer, size_t max_samples) {
     return samples;
 }
 
-void APU::save_state(std::vector<uint8_t>& data) {
+void APU::save_state(StateWriter& data) {
+    sync();
     // Save control registers
     data.push_back(m_nr50);
     data.push_back(m_nr51);
@@ -756,12 +926,13 @@ void APU::save_state(std::vector<uint8_t>& data) {
     data.push_back(m_enabled ? 1 : 0);
 
     // Save wave RAM
-    data.insert(data.end(), m_wave.wave_ram.begin(), m_wave.wave_ram.end());
+    data.write(m_wave.wave_ram.data(), m_wave.wave_ram.size());
 
     // Simplified - full state would save all channel data
 }
 
 void APU::load_state(const uint8_t*& data, size_t& remaining) {
+    m_pending_cycles = 0;
     m_nr50 = *data++; remaining--;
     m_nr51 = *data++; remaining--;
     m_nr52 = *data++; remaining--;
@@ -770,6 +941,10 @@ void APU::load_state(const uint8_t*& data, size_t& remaining) {
     std::memcpy(m_wave.wave_ram.data(), data, 16);
     data += 16;
     remaining -= 16;
+
+    if (m_audio_enabled) {
+        restart_synthesis();
+    }
 }
 
 } // namespace gb
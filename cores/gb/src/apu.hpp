@@ -5,10 +5,15 @@
 #include <cstddef>
 #include <array>
 #include <vector>
-#include <functional>
+
+#include "emu/audio_stream.hpp"
+#include "emu/blip_buffer.hpp"
+#include "emu/state_writer.hpp"
 
 namespace gb {
 
+using emu::StateWriter;
+
 // Audio Processing Unit for Game Boy / Game Boy Color
 class APU {
 public:
@@ -16,7 +21,11 @@ public:
     ~APU();
 
     void reset();
-    void step(int cycles);  // Step in T-cycles
+    // Bank T-cycles. The channels only show through the audio registers,
+    // so they run in one batch at sync(), which register access, the
+    // audio calls below and the end of each frame do.
+    void step(int cycles) { m_pending_cycles += cycles; }
+    void sync();
 
     void set_cgb_mode(bool cgb) { m_cgb_mode = cgb; }
 
@@ -24,18 +33,44 @@ public:
     uint8_t read_register(uint16_t address);
     void write_register(uint16_t address, uint8_t value);
 
-    // Get audio samples
+    // Get audio samples at get_sample_rate()
     size_t get_samples(float* buffer, size_t max_samples);
 
-    // Streaming audio callback - called frequently with small batches for low latency
-    using AudioStreamCallback = std::function<void(const float*, size_t, int)>;
-    void set_audio_callback(AudioStreamCallback callback) { m_audio_callback = callback; }
+    // Rate the blip buffers synthesize at; the host converts from it
+    int get_sample_rate() const { return SAMPLE_RATE; }
+
+    // Stream samples through sink as they're produced (low-latency path);
+    // an empty sink buffers them for get_samples() instead
+    void set_audio_sink(const emu::AudioStreamSink& sink) {
+        sync();
+        m_stream.set_sink(sink, SAMPLE_RATE);
+    }
+
+    // Skip sample mixing (fast-forward, seeking); channel and length
+    // counter state keep running exactly
+    void set_audio_enabled(bool enabled);
 
     // Save state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
 
 private:
+    void run(int cycles);
+    int m_pending_cycles = 0;
+
+    // Cycles until the frame sequencer or an audible channel timer expires
+    int cycles_until_event() const;
+    void advance_channels(int cycles);
+    void clock_cycle();
+    bool pulse_audible(bool enabled, uint8_t envelope_initial, bool envelope_dir,
+                       uint8_t volume, uint8_t nr51_bits) const;
+    bool wave_audible() const;
+    bool noise_audible() const;
+
+    void update_mix();
+    void flush_samples();
+    void restart_synthesis();
+
     void clock_frame_sequencer();
     void clock_length_counters();
     void clock_envelopes();
@@ -137,7 +172,21 @@ private:
 
     // Timing
     int m_cycles = 0;
-    int m_sample_counter = 0;
+
+    // Band-limited synthesis, one buffer per side: the mix is only
+    // recomputed at cycles where an audible channel or the frame sequencer
+    // changes state, and level changes go into the blip buffers as steps.
+    // Silent channels are fast-forwarded without stopping the loop.
+    static constexpr int FRAME_PERIOD = 8192;          // Frame sequencer (512 Hz)
+    static constexpr int CLOCK_RATE = 4194304;         // T-cycles per second
+    static constexpr int SAMPLE_RATE = 44100;
+    static constexpr uint32_t BLIP_FRAME_CYCLES = 4096;  // ~43 samples
+    emu::BlipBuffer m_blip_left{256};
+    emu::BlipBuffer m_blip_right{256};
+    float m_level_left = 0.0f;   // Mix levels last handed to the blip buffers
+    float m_level_right = 0.0f;
+    uint32_t m_blip_time = 0;    // T-cycles into the current blip frame
+    bool m_mix_dirty = true;
 
     // Audio filtering state (matches NES APU quality)
     // High-pass filter removes DC offset (~37Hz cutoff)
@@ -149,14 +198,17 @@ private:
     float m_lp_filter_left = 0.0f;
     float m_lp_filter_right = 0.0f;
 
-    // Streaming audio callback and buffer
-    AudioStreamCallback m_audio_callback;
-    static constexpr size_t STREAM_BUFFER_SIZE = 64;  // Small buffer for low latency
-    float m_stream_buffer[STREAM_BUFFER_SIZE * 2];    // Stereo
-    size_t m_stream_pos = 0;
+    // Streaming audio
+    emu::AudioStreamWriter m_stream;
+
+    bool m_audio_enabled = true;
 
     // Duty patterns
     static const uint8_t s_duty_table[4][8];
+
+    // Sample rate statistics (DEBUG=1)
+    uint64_t m_debug_total_samples = 0;
+    uint64_t m_debug_frame_count = 0;
 };
 
 } // namespace gb
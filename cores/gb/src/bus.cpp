@@ -3,7 +3,11 @@
 #include "ppu.hpp"
 #include "apu.hpp"
 #include "cartridge.hpp"
+#include "emu/state_writer.hpp"
+#include "link_cable.hpp"
 #include <cstring>
+#include <algorithm>
+#include <thread>
 
 namespace gb {
 
@@ -16,6 +20,15 @@ Bus::Bus() {
 Bus::~Bus() = default;
 
 uint8_t Bus::read(uint16_t address) {
+    if (m_breakpoints) {
+        uint8_t value = read_unchecked(address);
+        m_breakpoints->check(address, emu::BREAK_READ, value);
+        return value;
+    }
+    return read_unchecked(address);
+}
+
+uint8_t Bus::read_unchecked(uint16_t address) {
     // ROM Bank 0 (0x0000-0x3FFF)
     if (address < 0x4000) {
         if (m_cartridge) {
@@ -100,6 +113,9 @@ uint8_t Bus::read(uint16_t address) {
 }
 
 void Bus::write(uint16_t address, uint8_t value) {
+    if (m_write_watch) m_write_watch->check(address, value);
+    if (m_breakpoints) m_breakpoints->check(address, emu::BREAK_WRITE, value);
+
     // ROM (0x0000-0x7FFF) - writes go to MBC
     if (address < 0x8000) {
         if (m_cartridge) {
@@ -179,15 +195,23 @@ void Bus::write(uint16_t address, uint8_t value) {
 
     // Interrupt Enable (0xFFFF)
     m_ie = value;
+    m_pending_interrupts = m_ie & m_if;
+}
+
+uint8_t Bus::peek(uint16_t address) {
+    if (address >= 0xFE00 && address < 0xFF80) return 0xFF;
+    return read_unchecked(address);
 }
 
 uint8_t Bus::read_io(uint16_t address) {
     switch (address & 0xFF) {
         case 0x00:  // JOYP
             if (!(m_joyp & 0x20)) {
+                m_joypad_read = true;
                 return (m_joyp & 0xF0) | (m_joypad_buttons & 0x0F);
             }
             if (!(m_joyp & 0x10)) {
+                m_joypad_read = true;
                 return (m_joyp & 0xF0) | (m_joypad_directions & 0x0F);
             }
             return m_joyp | 0x0F;
@@ -265,8 +289,17 @@ void Bus::write_io(uint16_t address, uint8_t value) {
             m_joyp = (m_joyp & 0x0F) | (value & 0x30);
             break;
 
-        case 0x01: m_sb = value; break;
+        case 0x01:
+            // Transfers due before the write still send the old byte
+            if (m_link) service_link(false);
+            m_sb = value;
+            break;
         case 0x02:
+            if (m_link) {
+                // Becoming a listening slave, every transfer stamped up to
+                // now has to be answered as a non-listening port first
+                service_link((value & 0x81) == 0x80);
+            }
             m_sc = value;
             if (value == 0x81) {
                 // Blargg test ROMs use internal clock (bit 0 = 1) with transfer start (bit 7 = 1)
@@ -282,6 +315,11 @@ void Bus::write_io(uint16_t address, uint8_t value) {
                 m_serial_counter = 0;
                 m_serial_bits = 0;
             }
+            if (m_link) {
+                m_link_reply_cycle = 0;
+                if ((value & 0x81) == 0x81) start_link_transfer();
+                m_link_service_cycle = m_link_clock;
+            }
             break;
 
         case 0x04: {
@@ -320,7 +358,10 @@ void Bus::write_io(uint16_t address, uint8_t value) {
             break;
         }
 
-        case 0x0F: m_if = value & 0x1F; break;
+        case 0x0F:
+            m_if = value & 0x1F;
+            m_pending_interrupts = m_ie & m_if;
+            break;
 
         // Sound registers
         case 0x10 ... 0x26:
@@ -356,7 +397,7 @@ void Bus::write_io(uint16_t address, uint8_t value) {
         // CGB registers
         case 0x4D:
             if (m_cgb_mode) {
-                m_key1 = (m_key1 & 0x80) | (value & 1);
+                m_key1 = value & 1;
             }
             break;
 
@@ -375,9 +416,22 @@ void Bus::write_io(uint16_t address, uint8_t value) {
         case 0x54: m_hdma4 = value & 0xF0; break;
         case 0x55:
             // HDMA control
-            if (m_cgb_mode) {
-                m_hdma5 = value;
-                // TODO: Implement HDMA
+            if (!m_cgb_mode) break;
+            if (m_hdma_active && !(value & 0x80)) {
+                // Stops an HBlank DMA, leaving the blocks it had left
+                m_hdma_active = false;
+                m_hdma5 |= 0x80;
+                break;
+            }
+            m_hdma5 = value & 0x7F;
+            if (value & 0x80) {
+                m_hdma_active = true;
+            } else {
+                // General-purpose DMA: the whole transfer happens now
+                for (int blocks = m_hdma5 + 1; blocks > 0; blocks--) {
+                    transfer_vram_dma_block();
+                }
+                m_hdma5 = 0xFF;
             }
             break;
 
@@ -423,6 +477,11 @@ void Bus::set_input_state(uint32_t buttons) {
     if (buttons & (1 << 8)) m_joypad_directions &= ~0x04;   // Up
     if (buttons & (1 << 9)) m_joypad_directions &= ~0x08;   // Down
 
+    // With a group selected the interrupt depends on the input, read or not
+    if (!(m_joyp & 0x20) || !(m_joyp & 0x10)) {
+        m_joypad_read = true;
+    }
+
     // Check for joypad interrupt (any button pressed)
     if ((m_joypad_buttons & 0x0F) != 0x0F || (m_joypad_directions & 0x0F) != 0x0F) {
         // Only trigger if the appropriate selection is made
@@ -432,37 +491,89 @@ void Bus::set_input_state(uint32_t buttons) {
     }
 }
 
-uint8_t Bus::get_pending_interrupts() {
-    return m_ie & m_if;
-}
-
 void Bus::request_interrupt(uint8_t irq) {
     m_if |= irq;
+    m_pending_interrupts = m_ie & m_if;
 }
 
 void Bus::clear_interrupt(uint8_t irq) {
     m_if &= ~irq;
+    m_pending_interrupts = m_ie & m_if;
 }
 
 void Bus::start_oam_dma(uint8_t page) {
+    // Active before the source is read, so a source in OAM reads as 0xFF
     m_oam_dma_active = true;
-    m_oam_dma_src = static_cast<uint16_t>(page) << 8;
-    m_oam_dma_offset = 0;
+    m_oam_dma_cycles = 160;
+
+    if (m_ppu) {
+        uint16_t src = static_cast<uint16_t>(page) << 8;
+        uint8_t data[160];
+        for (int i = 0; i < 160; i++) {
+            data[i] = read_unchecked(static_cast<uint16_t>(src + i));
+        }
+        m_ppu->write_oam_block(data);
+    }
 }
 
-void Bus::step_oam_dma() {
+void Bus::step_oam_dma(int m_cycles) {
     if (!m_oam_dma_active) return;
 
-    // Transfer one byte per cycle
+    if (m_cycles >= m_oam_dma_cycles) {
+        m_oam_dma_cycles = 0;
+        m_oam_dma_active = false;
+    } else {
+        m_oam_dma_cycles -= m_cycles;
+    }
+}
+
+void Bus::transfer_vram_dma_block() {
+    uint16_t src = static_cast<uint16_t>((m_hdma1 << 8) | m_hdma2);
+    uint16_t dst = static_cast<uint16_t>((m_hdma3 << 8) | m_hdma4);
+
+    uint8_t block[16];
+    for (int i = 0; i < 16; i++) {
+        block[i] = read_unchecked(static_cast<uint16_t>(src + i));
+    }
     if (m_ppu) {
-        uint8_t value = read(m_oam_dma_src + m_oam_dma_offset);
-        m_ppu->write_oam(m_oam_dma_offset, value);
+        m_ppu->write_vram_block(dst, block, sizeof(block));
     }
 
-    m_oam_dma_offset++;
-    if (m_oam_dma_offset >= 160) {
-        m_oam_dma_active = false;
+    src += 16;
+    dst = (dst + 16) & 0x1FF0;
+    m_hdma1 = src >> 8;
+    m_hdma2 = src & 0xF0;
+    m_hdma3 = dst >> 8;
+    m_hdma4 = dst & 0xF0;
+
+    // 32 T-cycles of the PPU's clock per block, twice as many CPU
+    // M-cycles at double speed
+    m_dma_stall += 32 / t_cycles_per_m_cycle();
+}
+
+void Bus::hblank_dma() {
+    if (!m_hdma_active) return;
+
+    transfer_vram_dma_block();
+    if (m_hdma5 == 0) {
+        m_hdma_active = false;
+        m_hdma5 = 0xFF;
+    } else {
+        m_hdma5--;
+    }
+}
+
+int Bus::run_dma_stall() {
+    int m_cycles = m_dma_stall;
+    if (m_cycles == 0) return 0;
+
+    m_dma_stall = 0;
+    if (!m_cpu_only) {
+        step_timer(m_cycles);
+        step_serial(m_cycles);
     }
+    step_oam_dma(m_cycles);
+    return m_cycles;
 }
 
 void Bus::trigger_oam_bug(uint16_t address, bool is_read) {
@@ -520,13 +631,41 @@ void Bus::step_timer(int m_cycles) {
 void Bus::tick_m_cycle() {
     // Single M-cycle tick for cycle-accurate timing
     // This is called during memory accesses to tick components
+    if (m_cpu_only) {
+        step_oam_dma(1);
+        return;
+    }
     step_timer(1);
-    step_oam_dma();
+    step_oam_dma(1);
     step_serial(1);
     // PPU and APU are stepped by the plugin with T-cycles for their own timing
 }
 
+bool Bus::switch_speed() {
+    if (!m_cgb_mode || !(m_key1 & 1)) return false;
+
+    m_double_speed = !m_double_speed;
+    m_key1 = 0;
+
+    // STOP resets DIV like a write to FF04
+    bool old_bit = get_timer_bit();
+    m_div_counter = 0;
+    if (old_bit) {
+        check_timer_falling_edge(false);
+    }
+    m_prev_timer_bit = false;
+    return true;
+}
+
 void Bus::step_serial(int m_cycles) {
+    if (m_link) {
+        // The link clock counts real time, which the serial clock outruns
+        // at double speed
+        m_link_clock += m_cycles * t_cycles_per_m_cycle();
+        if (m_link_clock >= m_link_service_cycle) service_link(false);
+        return;
+    }
+
     if (!(m_sc & 0x80)) return;  // Transfer not active
 
     // Only handle internal clock
@@ -555,16 +694,141 @@ void Bus::step_serial(int m_cycles) {
     }
 }
 
-void Bus::save_state(std::vector<uint8_t>& data) {
+void Bus::connect_link(std::shared_ptr<LinkCable> cable, int side) {
+    if (!cable || !cable->is_connected()) return;
+
+    m_link = std::move(cable);
+    m_link_side = side;
+    // Carry on from this side's last published clock, so a bus created by
+    // a ROM load never stamps messages behind ones it already sent
+    m_link_clock = m_link->port(side).clock.load(std::memory_order_acquire);
+    m_link_service_cycle = m_link_clock;
+    m_link_reply_cycle = 0;
+    if ((m_sc & 0x81) == 0x81) start_link_transfer();
+}
+
+void Bus::disconnect_link() {
+    if (!m_link) return;
+    m_link.reset();
+
+    // A transfer in flight finishes as if the cable had been pulled out
+    m_link_reply_cycle = 0;
+    m_serial_counter = 0;
+    m_serial_bits = 0;
+}
+
+void Bus::service_link(bool settle) {
+    LinkCable& cable = *m_link;
+    cable.port(m_link_side).clock.store(m_link_clock, std::memory_order_release);
+
+    // Only waits while our own transfer's reply is due or while every
+    // transfer up to now must be visible (listening, or settle)
+    while (process_link_messages(settle)) {
+        if (!cable.is_connected()) {
+            disconnect_link();
+            return;
+        }
+        std::this_thread::yield();
+    }
+    if (!cable.is_connected()) {
+        disconnect_link();
+        return;
+    }
+
+    // Next link cycle anything can happen: a queued transfer falls due,
+    // our reply falls due, a listening port reaches the partner's horizon,
+    // or the clock is due to be published again
+    uint64_t next = m_link_clock + LinkCable::LATENCY / 4;
+    if (const LinkCable::Message* transfer = cable.port(m_link_side).transfers.front()) {
+        next = std::min(next, transfer->cycle);
+    }
+    if (m_link_reply_cycle) {
+        next = std::min(next, m_link_reply_cycle);
+    }
+    if (is_link_listening()) {
+        uint64_t horizon = cable.partner(m_link_side).clock.load(std::memory_order_acquire) +
+                           LinkCable::LATENCY;
+        next = std::min(next, horizon);
+    }
+    m_link_service_cycle = next;
+}
+
+bool Bus::process_link_messages(bool settle) {
+    LinkCable& cable = *m_link;
+    LinkCable::Port& inbox = cable.port(m_link_side);
+    LinkCable::Port& outbox = cable.partner(m_link_side);
+
+    // Read before the queues: everything the partner sent up to this clock
+    // is visible, and it never stamps a message below it plus LATENCY
+    uint64_t partner_clock = outbox.clock.load(std::memory_order_acquire);
+
+    // Transfers from a master act at their stamp; a port that isn't
+    // listening shifts out 0xFF and keeps its own byte
+    while (const LinkCable::Message* transfer = inbox.transfers.front()) {
+        if (transfer->cycle > m_link_clock) break;
+
+        uint8_t reply = 0xFF;
+        if (is_link_listening()) {
+            reply = m_sb;
+            m_sb = transfer->data;
+            m_sc &= ~0x80;
+            request_interrupt(0x08);  // Serial interrupt
+        }
+        LinkCable::Message message{transfer->cycle + LinkCable::LATENCY, reply};
+        inbox.transfers.pop();
+        while (!outbox.replies.push(message)) {
+            if (!cable.is_connected()) return false;
+            std::this_thread::yield();
+        }
+    }
+
+    // Replies to our own transfers, dropping those to cancelled ones
+    while (const LinkCable::Message* reply = inbox.replies.front()) {
+        if (m_link_reply_cycle == 0 || reply->cycle < m_link_reply_cycle) {
+            inbox.replies.pop();
+            continue;
+        }
+        if (reply->cycle > m_link_clock) break;
+
+        m_sb = reply->data;
+        m_sc &= ~0x80;
+        m_link_reply_cycle = 0;
+        inbox.replies.pop();
+        request_interrupt(0x08);  // Serial interrupt
+    }
+    if (m_link_reply_cycle && m_link_clock >= m_link_reply_cycle) return true;
+
+    return (settle || is_link_listening()) && m_link_clock >= partner_clock + LinkCable::LATENCY;
+}
+
+void Bus::start_link_transfer() {
+    LinkCable& cable = *m_link;
+    m_link_reply_cycle = m_link_clock + 2 * LinkCable::LATENCY;
+
+    LinkCable::Message message{m_link_clock + LinkCable::LATENCY, m_sb};
+    while (!cable.partner(m_link_side).transfers.push(message)) {
+        if (!cable.is_connected()) return;
+        std::this_thread::yield();
+    }
+}
+
+void Bus::save_state(StateWriter& data) {
+    save_work_ram(data);
+    save_registers(data);
+}
+
+void Bus::save_work_ram(StateWriter& data) {
     // Save WRAM
-    data.insert(data.end(), m_wram.begin(), m_wram.end());
+    data.write(m_wram.data(), m_wram.size());
     if (m_cgb_mode) {
-        data.insert(data.end(), m_wram_cgb.begin(), m_wram_cgb.end());
+        data.write(m_wram_cgb.data(), m_wram_cgb.size());
     }
 
     // Save HRAM
-    data.insert(data.end(), m_hram.begin(), m_hram.end());
+    data.write(m_hram.data(), m_hram.size());
+}
 
+void Bus::save_registers(StateWriter& data) {
     // Save I/O registers
     data.push_back(m_joyp);
     data.push_back(m_sb);
@@ -577,12 +841,67 @@ void Bus::save_state(std::vector<uint8_t>& data) {
     data.push_back(m_ie);
 
     // CGB registers
-    data.push_back(m_key1);
+    data.push_back((m_key1 & 1) | (m_double_speed ? 0x80 : 0));
     data.push_back(m_vbk);
     data.push_back(m_svbk);
 }
 
+void Bus::save_dma_state(StateWriter& data) {
+    data.push_back(m_hdma1);
+    data.push_back(m_hdma2);
+    data.push_back(m_hdma3);
+    data.push_back(m_hdma4);
+    data.push_back(m_hdma5);
+    data.push_back((m_hdma_active ? 0x01 : 0) | (m_oam_dma_active ? 0x02 : 0));
+    data.push_back(m_oam_dma_cycles);
+    data.push_back(m_dma_stall & 0xFF);
+    data.push_back((m_dma_stall >> 8) & 0xFF);
+}
+
+void Bus::load_dma_state(const uint8_t*& data, size_t& remaining) {
+    m_hdma_active = false;
+    m_oam_dma_active = false;
+    m_oam_dma_cycles = 0;
+    m_dma_stall = 0;
+    if (remaining < 9) return;
+
+    m_hdma1 = data[0];
+    m_hdma2 = data[1];
+    m_hdma3 = data[2];
+    m_hdma4 = data[3];
+    m_hdma5 = data[4];
+    m_hdma_active = m_cgb_mode && (data[5] & 0x01);
+    m_oam_dma_active = (data[5] & 0x02) != 0;
+    m_oam_dma_cycles = data[6];
+    m_dma_stall = data[7] | (data[8] << 8);
+    data += 9;
+    remaining -= 9;
+}
+
+void Bus::save_timer_state(StateWriter& data) {
+    data.push_back(static_cast<uint8_t>(m_div_counter & 0xFF));
+    data.push_back(m_tima_overflow_cycle);
+}
+
+void Bus::load_timer_state(const uint8_t*& data, size_t& remaining) {
+    if (remaining < 2) return;
+
+    m_div_counter = static_cast<uint16_t>((m_div_counter & 0xFF00) | data[0]);
+    m_tima_overflow_cycle = data[1];
+    m_prev_timer_bit = get_timer_bit();
+    data += 2;
+    remaining -= 2;
+}
+
 void Bus::load_state(const uint8_t*& data, size_t& remaining) {
+    load_work_ram(data, remaining);
+    load_registers(data, remaining);
+}
+
+void Bus::load_work_ram(const uint8_t*& data, size_t& remaining) {
+    size_t size = m_wram.size() + (m_cgb_mode ? m_wram_cgb.size() : 0) + m_hram.size();
+    if (remaining < size) return;
+
     // Load WRAM
     std::memcpy(m_wram.data(), data, m_wram.size());
     data += m_wram.size();
@@ -598,7 +917,9 @@ void Bus::load_state(const uint8_t*& data, size_t& remaining) {
     std::memcpy(m_hram.data(), data, m_hram.size());
     data += m_hram.size();
     remaining -= m_hram.size();
+}
 
+void Bus::load_registers(const uint8_t*& data, size_t& remaining) {
     // Load I/O registers
     m_joyp = *data++; remaining--;
     m_sb = *data++; remaining--;
@@ -609,15 +930,25 @@ void Bus::load_state(const uint8_t*& data, size_t& remaining) {
     m_tac = *data++; remaining--;
     m_if = *data++; remaining--;
     m_ie = *data++; remaining--;
+    m_pending_interrupts = m_ie & m_if;
 
     // CGB registers
     m_key1 = *data++; remaining--;
+    m_double_speed = m_cgb_mode && (m_key1 & 0x80);
+    m_key1 &= 1;
     m_vbk = *data++; remaining--;
     m_svbk = *data++; remaining--;
 
     // Initialize timer falling edge state from current div_counter
     m_prev_timer_bit = get_timer_bit();
     m_tima_overflow_cycle = 0;
+
+    // Restart a linked transfer that was in flight
+    if (m_link) {
+        m_link_reply_cycle = 0;
+        if ((m_sc & 0x81) == 0x81) start_link_transfer();
+        m_link_service_cycle = m_link_clock;
+    }
 }
 
 } // namespace gb
@@ -1,10 +1,14 @@
 #pragma once
 
 #include "types.hpp"
+#include "emu/breakpoints.hpp"
+#include "emu/state_writer.hpp"
+#include "emu/write_watch.hpp"
 #include <cstdint>
 #include <array>
 #include <vector>
 #include <string>
+#include <memory>
 
 namespace gb {
 
@@ -12,6 +16,8 @@ class LR35902;
 class PPU;
 class APU;
 class Cartridge;
+using emu::StateWriter;
+class LinkCable;
 
 // Game Boy Memory Bus
 class Bus {
@@ -33,19 +39,49 @@ public:
     uint8_t read(uint16_t address);
     void write(uint16_t address, uint8_t value);
 
+    // read() for code addresses (ROM, RAM, HRAM), which has no side
+    // effects there; 0xFF for OAM and I/O. For tracing.
+    uint8_t peek(uint16_t address);
+
+    // Watchpoints checked on every CPU write, or nullptr for none
+    void set_write_watch(emu::WriteWatchpoints* watch) { m_write_watch = watch; }
+
+    // Read and write breakpoints checked on every CPU access, or nullptr
+    // for none
+    void set_breakpoints(emu::Breakpoints* breakpoints) { m_breakpoints = breakpoints; }
+
     // Input handling
     void set_input_state(uint32_t buttons);
 
-    // Interrupt handling
-    uint8_t get_pending_interrupts();
+    // Set when the game reads JOYP with a button group selected, or when a
+    // selected group could raise the joypad interrupt. The frame loop clears
+    // it before setting each frame's input, so it ends the frame false on a
+    // lag frame.
+    bool was_joypad_read() const { return m_joypad_read; }
+    void clear_joypad_read() { m_joypad_read = false; }
+
+    // Interrupt handling. IE & IF is kept up to date as either changes,
+    // since the CPU checks it after every instruction.
+    uint8_t get_pending_interrupts() const { return m_pending_interrupts; }
     void request_interrupt(uint8_t irq);
     void clear_interrupt(uint8_t irq);
 
-    // OAM DMA
+    // OAM DMA. The 160 bytes are copied when the transfer starts; OAM then
+    // stays locked to the CPU for the 160 M-cycles the transfer takes
     void start_oam_dma(uint8_t page);
-    void step_oam_dma();
+    void step_oam_dma(int m_cycles);
     bool is_oam_dma_active() const { return m_oam_dma_active; }
 
+    // CGB VRAM DMA. General-purpose DMA copies everything when FF55 is
+    // written; HBlank DMA copies a 16-byte block each time the PPU enters
+    // HBlank. The CPU is stopped while either copies, which is owed as
+    // DMA stall cycles until the frame loop runs them.
+    void hblank_dma();
+
+    // Run the M-cycles the CPU owes to VRAM DMA (timer and serial keep
+    // going through them); returns how many there were
+    int run_dma_stall();
+
     // OAM bug trigger (DMG only)
     // Called by CPU when 16-bit register pair operations occur with OAM-range addresses
     void trigger_oam_bug(uint16_t address, bool is_read);
@@ -57,17 +93,62 @@ public:
     // This ticks timer, serial, PPU, and APU
     void tick_m_cycle();
 
+    // While set, tick_m_cycle() leaves the timer and serial port alone so
+    // only the CPU (and OAM DMA it started) runs, for overclocked lines
+    void set_cpu_only(bool enabled) { m_cpu_only = enabled; }
+
+    // CGB speed switch. Timer, serial and OAM DMA are ticked per CPU
+    // M-cycle above, so they follow the CPU clock on their own; the PPU
+    // and APU keep theirs and see 2 T-cycles per M-cycle at double speed.
+    int t_cycles_per_m_cycle() const { return m_double_speed ? 2 : 4; }
+    bool is_double_speed() const { return m_double_speed; }
+
+    // Perform an armed KEY1 switch on STOP; returns false if none was armed
+    bool switch_speed();
+    void reset_speed() { m_key1 = 0; m_double_speed = false; }
+
     // Serial
     void step_serial(int cycles);
 
+    // Link cable. Without one, internal-clock transfers shift in 0xFF and
+    // external-clock transfers never complete.
+    void connect_link(std::shared_ptr<LinkCable> cable, int side);
+    void disconnect_link();
+    bool is_link_connected() const { return m_link != nullptr; }
+
     // Serial output capture (for test ROMs)
     const std::string& get_serial_output() const { return m_serial_output; }
     void clear_serial_output() { m_serial_output.clear(); }
 
     // Save state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
 
+    // Memories, for memory domains. WRAM banks 0-1 and 2-7 (CGB) are
+    // separate arrays
+    const uint8_t* get_wram_data() const { return m_wram.data(); }
+    const uint8_t* get_wram_cgb_data() const { return m_wram_cgb.data(); }
+    const uint8_t* get_hram_data() const { return m_hram.data(); }
+
+    // The two halves of save_state(), which are separate state chunks:
+    // WRAM and HRAM, and the I/O registers
+    void save_work_ram(StateWriter& data);
+    void load_work_ram(const uint8_t*& data, size_t& remaining);
+    void save_registers(StateWriter& data);
+    void load_registers(const uint8_t*& data, size_t& remaining);
+
+    // DMA state, written after the registers in the bus chunk. Chunks from
+    // before it existed end early, which leaves both DMAs idle.
+    void save_dma_state(StateWriter& data);
+    void load_dma_state(const uint8_t*& data, size_t& remaining);
+
+    // The rest of the timer, after the DMA state (bus chunk version 2): the
+    // low byte of the DIV counter and a pending TIMA reload. The registers
+    // only hold DIV's high byte, and the timer's falling edges come from
+    // the whole counter.
+    void save_timer_state(StateWriter& data);
+    void load_timer_state(const uint8_t*& data, size_t& remaining);
+
 private:
     // Components
     LR35902* m_cpu = nullptr;
@@ -80,6 +161,9 @@ private:
     std::array<uint8_t, 0x6000> m_wram_cgb;  // Extra 24KB for CGB banks 2-7
     std::array<uint8_t, 0x7F> m_hram;        // High RAM
 
+    emu::WriteWatchpoints* m_write_watch = nullptr;
+    emu::Breakpoints* m_breakpoints = nullptr;
+
     // I/O Registers
     uint8_t m_joyp = 0xCF;       // FF00 - Joypad
     uint8_t m_sb = 0;            // FF01 - Serial transfer data
@@ -90,6 +174,7 @@ private:
     uint8_t m_tac = 0;           // FF07 - Timer control
     uint8_t m_if = 0;            // FF0F - Interrupt flags
     uint8_t m_ie = 0;            // FFFF - Interrupt enable
+    uint8_t m_pending_interrupts = 0;  // m_ie & m_if
 
     // CGB-specific registers
     uint8_t m_key1 = 0;          // FF4D - CPU speed switch
@@ -98,18 +183,23 @@ private:
     uint8_t m_hdma2 = 0;         // FF52 - HDMA source low
     uint8_t m_hdma3 = 0;         // FF53 - HDMA dest high
     uint8_t m_hdma4 = 0;         // FF54 - HDMA dest low
-    uint8_t m_hdma5 = 0;         // FF55 - HDMA control
+    uint8_t m_hdma5 = 0xFF;      // FF55 - HDMA blocks left - 1, bit 7 set when idle
     uint8_t m_rp = 0;            // FF56 - Infrared
     uint8_t m_svbk = 0;          // FF70 - WRAM bank
 
     // Joypad state
     uint8_t m_joypad_buttons = 0xFF;   // Button states
     uint8_t m_joypad_directions = 0xFF; // Direction states
+    bool m_joypad_read = false;
+    bool m_cpu_only = false;
 
     // OAM DMA
     bool m_oam_dma_active = false;
-    uint16_t m_oam_dma_src = 0;
-    uint8_t m_oam_dma_offset = 0;
+    uint8_t m_oam_dma_cycles = 0;  // M-cycles until OAM is released
+
+    // VRAM DMA
+    bool m_hdma_active = false;   // HBlank DMA running
+    int m_dma_stall = 0;          // CPU M-cycles owed to VRAM DMA
 
     // Timer internals - using falling edge detection like real hardware
     uint16_t m_div_counter = 0;  // Full 16-bit DIV counter (system counter)
@@ -121,6 +211,14 @@ private:
     int m_serial_bits = 0;
     std::string m_serial_output;  // Captured serial output for test ROMs
 
+    // Link cable state. Not part of save states: the link clock only ever
+    // moves forward, and a transfer in flight is restarted on load.
+    std::shared_ptr<LinkCable> m_link;
+    int m_link_side = 0;
+    uint64_t m_link_clock = 0;          // Link cycles (see link_cable.hpp)
+    uint64_t m_link_service_cycle = 0;  // Next link cycle service_link() runs
+    uint64_t m_link_reply_cycle = 0;    // Reply due for our transfer, 0 = none
+
     // CGB mode flag
     bool m_cgb_mode = false;
     bool m_double_speed = false;
@@ -135,8 +233,21 @@ private:
     // Check for falling edge and increment TIMA if needed
     void check_timer_falling_edge(bool new_bit);
 
+    // Copy 16 bytes from the HDMA source to the HDMA destination, advance
+    // both and charge the CPU for it
+    void transfer_vram_dma_block();
+
+    // Link cable helpers
+    void service_link(bool settle);
+    bool process_link_messages(bool settle);
+    void start_link_transfer();
+    bool is_link_listening() const { return (m_sc & 0x81) == 0x80; }
+
     // I/O helpers
     uint8_t read_io(uint16_t address);
+
+    // read() without the breakpoint check, for DMA and peek()
+    uint8_t read_unchecked(uint16_t address);
     void write_io(uint16_t address, uint8_t value);
 };
 
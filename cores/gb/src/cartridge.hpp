@@ -1,6 +1,8 @@
 #pragma once
 
 #include "types.hpp"
+#include "emu/rom_image.hpp"
+#include "emu/state_writer.hpp"
 #include <cstdint>
 #include <cstddef>
 #include <vector>
@@ -10,6 +12,7 @@
 namespace gb {
 
 class MBC;
+using emu::StateWriter;
 
 // Cartridge loader for GB and GBC ROMs
 class Cartridge {
@@ -17,17 +20,30 @@ public:
     Cartridge();
     ~Cartridge();
 
-    // Load ROM
+    // Load ROM (the shared form keeps a reference to the image, which is
+    // never written, instead of copying it)
     bool load(const uint8_t* data, size_t size);
+    bool load(std::shared_ptr<const emu::RomImage> rom);
     void unload();
 
     // Reset
     void reset();
 
-    // ROM access (via MBC)
-    uint8_t read_rom(uint16_t address);
-    uint8_t read_ram(uint16_t address);
-    void write_ram(uint16_t address, uint8_t value);
+    // ROM access (via MBC). Banks the MBC has mapped are read directly;
+    // everything else falls back to the MBC.
+    uint8_t read_rom(uint16_t address) {
+        if (const uint8_t* bank = m_map.rom[address >> 14]) return bank[address & 0x3FFF];
+        return read_rom_slow(address);
+    }
+    uint8_t read_ram(uint16_t address) {
+        if (m_map.ram) return m_map.ram[address & 0x1FFF];
+        return read_ram_slow(address);
+    }
+    void write_ram(uint16_t address, uint8_t value) {
+        if (m_map.ram) m_map.ram[address & 0x1FFF] = value;
+        else write_ram_slow(address, value);
+        m_save_generation++;
+    }
     void write_mbc(uint16_t address, uint8_t value);
 
     // Get CRC32
@@ -40,23 +56,37 @@ public:
     bool is_cgb() const { return m_system_type == SystemType::GameBoyColor; }
     const char* get_mapper_name() const;
 
+    // Whole ROM and cartridge RAM, for memory domains
+    const uint8_t* get_rom_data() const { return m_rom ? m_rom->data() : nullptr; }
+    size_t get_rom_size() const { return m_rom ? m_rom->size() : 0; }
+    const uint8_t* get_ram_data() const { return m_ram.data(); }
+    size_t get_ram_size() const { return m_ram.size(); }
+
     // Battery save support
     bool has_battery() const;
     std::vector<uint8_t> get_save_data() const;
     bool set_save_data(const std::vector<uint8_t>& data);
+    // Bumped on every cartridge RAM write and state load
+    uint64_t get_save_generation() const { return m_save_generation; }
 
     // Save state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
 
 private:
+    uint8_t read_rom_slow(uint16_t address);
+    uint8_t read_ram_slow(uint16_t address);
+    void write_ram_slow(uint16_t address, uint8_t value);
+    void update_map();
+
     void detect_mbc(uint8_t cart_type);
-    uint32_t calculate_crc32(const uint8_t* data, size_t size);
 
-    std::vector<uint8_t> m_rom;
+    std::shared_ptr<const emu::RomImage> m_rom;
     std::vector<uint8_t> m_ram;  // Cartridge RAM
 
     std::unique_ptr<MBC> m_mbc;
+    CartridgeMap m_map;  // Published by the MBC, see update_map()
+    uint64_t m_save_generation = 0;
 
     bool m_loaded = false;
     uint32_t m_crc32 = 0;
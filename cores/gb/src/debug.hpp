@@ -5,17 +5,18 @@
 namespace gb {
 
 // Check if debug mode is enabled via environment variable
+// (read once; thread-safe, as instances may run on several threads).
+// Always off when the build leaves out core debug logging.
+#ifdef VELOCE_NO_CORE_DEBUG
+constexpr bool is_debug_mode() { return false; }
+#else
 inline bool is_debug_mode() {
-    static bool checked = false;
-    static bool enabled = false;
-
-    if (!checked) {
+    static const bool enabled = [] {
         const char* env = std::getenv("DEBUG");
-        enabled = env && (env[0] == '1' || env[0] == 'y' || env[0] == 'Y');
-        checked = true;
-    }
-
+        return env && (env[0] == '1' || env[0] == 'y' || env[0] == 'Y');
+    }();
     return enabled;
 }
+#endif
 
 } // namespace gb
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <cstdint>
+
+namespace gb {
+
+// Link cable shared by the buses of two GB instances in one process
+//
+// Each side keeps a link clock: T-cycles at normal speed since the cable
+// was first connected, so both sides count the same real time. Every
+// message is stamped with the link cycle at which the receiver acts on
+// it, at least LATENCY after the sender's clock when it was sent. A side
+// that needs to see every message before its stamp (a listening slave)
+// therefore only has to stay less than LATENCY ahead of the clock its
+// partner last published, rather than running in lockstep with it.
+//
+// A master's byte reaches the slave LATENCY after the transfer starts and
+// the slave's byte comes back LATENCY later, so a transfer takes 2 *
+// LATENCY: exactly the 4096 cycles of a normal-speed byte, but longer than
+// a CGB fast-clock one.
+class LinkCable {
+public:
+    static constexpr uint64_t LATENCY = 2048;
+
+    struct Message {
+        uint64_t cycle;  // Link cycle the receiver acts on it
+        uint8_t data;
+    };
+
+    // Single-producer/single-consumer ring of messages. Stamps within one
+    // queue never decrease.
+    class Queue {
+    public:
+        bool push(const Message& message) {
+            uint32_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_head.load(std::memory_order_acquire) == CAPACITY) return false;
+            m_messages[tail % CAPACITY] = message;
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        const Message* front() const {
+            uint32_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_tail.load(std::memory_order_acquire)) return nullptr;
+            return &m_messages[head % CAPACITY];
+        }
+
+        void pop() {
+            m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+    private:
+        static constexpr uint32_t CAPACITY = 16;
+        std::array<Message, CAPACITY> m_messages{};
+        std::atomic<uint32_t> m_head{0};
+        std::atomic<uint32_t> m_tail{0};
+    };
+
+    // Per-side inboxes: transfers from a master and replies to our own
+    // transfers are queued apart so that each queue stays in stamp order
+    struct Port {
+        Queue transfers;
+        Queue replies;
+        std::atomic<uint64_t> clock{0};  // Last published link clock
+    };
+
+    Port& port(int side) { return m_ports[side]; }
+    Port& partner(int side) { return m_ports[side ^ 1]; }
+
+    bool is_connected() const { return m_connected.load(std::memory_order_acquire); }
+    void disconnect() { m_connected.store(false, std::memory_order_release); }
+
+private:
+    std::array<Port, 2> m_ports;
+    std::atomic<bool> m_connected{true};
+};
+
+} // namespace gb
@@ -1,5 +1,6 @@
 #include "lr35902.hpp"
 #include "bus.hpp"
+#include "emu/state_writer.hpp"
 #include <cstring>
 
 namespace gb {
@@ -165,6 +166,35 @@ void LR35902::handle_interrupts(uint8_t pending) {
     }
 }
 
+int LR35902::run_halted(int max_m_cycles) {
+    if (m_ime_pending) {
+        m_ime_pending = false;
+        m_ime = true;
+    }
+
+    int cycles = 0;
+    do {
+        m_bus.tick_m_cycle();
+        cycles++;
+    } while (cycles < max_m_cycles && !m_bus.get_pending_interrupts());
+    return cycles;
+}
+
+void LR35902::trace_instruction() {
+    emu::CpuTraceRecord& record = m_trace->append();
+    record.pc = m_pc;
+    for (int i = 0; i < 4; i++) {
+        record.opcode[i] = m_bus.peek(static_cast<uint16_t>(m_pc + i));
+    }
+    record.arch = static_cast<uint8_t>(emu::CpuTraceArch::SM83);
+    record.flags = 0;
+    record.regs[0] = get_af();
+    record.regs[1] = get_bc();
+    record.regs[2] = get_de();
+    record.regs[3] = get_hl();
+    record.regs[4] = m_sp;
+}
+
 int LR35902::step() {
     // Handle pending EI
     if (m_ime_pending) {
@@ -172,11 +202,16 @@ int LR35902::step() {
         m_ime = true;
     }
 
-    // If halted, just consume 1 cycle
+    // If halted, just consume 1 cycle (timer and serial keep running)
     if (m_halted) {
+        m_bus.tick_m_cycle();
         return 1;
     }
 
+    if (m_trace) trace_instruction();
+    if (m_breakpoints && (m_breakpoints->page_flags(m_pc) & emu::BREAK_EXECUTE)) {
+        m_breakpoints->check(m_pc, emu::BREAK_EXECUTE, m_bus.peek(m_pc));
+    }
     uint8_t opcode = fetch();
     int cycles = s_cycle_table[opcode];
 
@@ -252,7 +287,9 @@ int LR35902::step() {
         // STOP
         case 0x10:
             fetch();  // Skip next byte
-            // TODO: Handle double-speed mode switch for CGB
+            // On CGB with KEY1 armed this toggles double speed; the bus
+            // then changes how M-cycles map to PPU/APU T-cycles
+            m_bus.switch_speed();
             break;
 
         // LD DE, nn
@@ -988,75 +1025,64 @@ int LR35902::step() {
     return cycles;
 }
 
-int LR35902::execute_cb() {
-    uint8_t opcode = fetch();
-    int cycles = s_cb_cycle_table[opcode];
-
-    // Get register based on lower 3 bits
-    auto get_reg = [this](int r) -> uint8_t {
-        switch (r) {
-            case 0: return m_b;
-            case 1: return m_c;
-            case 2: return m_d;
-            case 3: return m_e;
-            case 4: return m_h;
-            case 5: return m_l;
-            case 6: return read(get_hl());
-            case 7: return m_a;
-        }
-        return 0;
-    };
-
-    auto set_reg = [this](int r, uint8_t value) {
-        switch (r) {
-            case 0: m_b = value; break;
-            case 1: m_c = value; break;
-            case 2: m_d = value; break;
-            case 3: m_e = value; break;
-            case 4: m_h = value; break;
-            case 5: m_l = value; break;
-            case 6: write(get_hl(), value); break;
-            case 7: m_a = value; break;
-        }
-    };
-
-    int reg = opcode & 0x07;
-    int bit_num = (opcode >> 3) & 0x07;
-    int op = opcode >> 6;
-
-    uint8_t value = get_reg(reg);
-    uint8_t result;
-
-    switch (op) {
-        case 0:  // Rotate/shift operations
-            switch (bit_num) {
-                case 0: result = rlc(value); break;
-                case 1: result = rrc(value); break;
-                case 2: result = rl(value); break;
-                case 3: result = rr(value); break;
-                case 4: result = sla(value); break;
-                case 5: result = sra(value); break;
-                case 6: result = swap(value); break;
-                case 7: result = srl(value); break;
-                default: result = value;
-            }
-            set_reg(reg, result);
-            break;
-
-        case 1:  // BIT
-            bit(bit_num, value);
-            break;
+template <int R>
+uint8_t LR35902::read_r8() {
+    if constexpr (R == 0) return m_b;
+    else if constexpr (R == 1) return m_c;
+    else if constexpr (R == 2) return m_d;
+    else if constexpr (R == 3) return m_e;
+    else if constexpr (R == 4) return m_h;
+    else if constexpr (R == 5) return m_l;
+    else if constexpr (R == 6) return read(get_hl());
+    else return m_a;
+}
 
-        case 2:  // RES
-            set_reg(reg, res(bit_num, value));
-            break;
+template <int R>
+void LR35902::write_r8(uint8_t value) {
+    if constexpr (R == 0) m_b = value;
+    else if constexpr (R == 1) m_c = value;
+    else if constexpr (R == 2) m_d = value;
+    else if constexpr (R == 3) m_e = value;
+    else if constexpr (R == 4) m_h = value;
+    else if constexpr (R == 5) m_l = value;
+    else if constexpr (R == 6) write(get_hl(), value);
+    else m_a = value;
+}
 
-        case 3:  // SET
-            set_reg(reg, set(bit_num, value));
-            break;
+template <int OPCODE>
+void LR35902::execute_cb_op() {
+    constexpr int reg = OPCODE & 0x07;
+    constexpr int bit_num = (OPCODE >> 3) & 0x07;
+    constexpr int op = OPCODE >> 6;
+
+    uint8_t value = read_r8<reg>();
+
+    if constexpr (op == 0) {  // Rotate/shift operations
+        if constexpr (bit_num == 0) value = rlc(value);
+        else if constexpr (bit_num == 1) value = rrc(value);
+        else if constexpr (bit_num == 2) value = rl(value);
+        else if constexpr (bit_num == 3) value = rr(value);
+        else if constexpr (bit_num == 4) value = sla(value);
+        else if constexpr (bit_num == 5) value = sra(value);
+        else if constexpr (bit_num == 6) value = swap(value);
+        else value = srl(value);
+        write_r8<reg>(value);
+    } else if constexpr (op == 1) {  // BIT
+        bit(bit_num, value);
+    } else if constexpr (op == 2) {  // RES
+        write_r8<reg>(res(bit_num, value));
+    } else {  // SET
+        write_r8<reg>(set(bit_num, value));
     }
+}
 
-    return cycles;
+const std::array<LR35902::CbHandler, 256> LR35902::s_cb_handlers =
+    LR35902::make_cb_handlers(std::make_index_sequence<256>{});
+
+int LR35902::execute_cb() {
+    uint8_t opcode = fetch();
+    (this->*s_cb_handlers[opcode])();
+    return s_cb_cycle_table[opcode];
 }
 
 // ALU operations
@@ -1228,7 +1254,7 @@ uint8_t LR35902::set(int n, uint8_t value) {
     return value | (1 << n);
 }
 
-void LR35902::save_state(std::vector<uint8_t>& data) {
+void LR35902::save_state(StateWriter& data) {
     data.push_back(m_a);
     data.push_back(m_f);
     data.push_back(m_b);
@@ -1,13 +1,18 @@
 #pragma once
 
 #include "types.hpp"
+#include "emu/breakpoints.hpp"
+#include "emu/cpu_trace.hpp"
+#include "emu/state_writer.hpp"
 #include <cstdint>
 #include <array>
+#include <utility>
 #include <vector>
 
 namespace gb {
 
 class Bus;
+using emu::StateWriter;
 
 // Sharp LR35902 CPU emulator (Game Boy CPU)
 // Hybrid of Z80 and 8080 with custom extensions
@@ -22,6 +27,10 @@ public:
     // Execute one instruction, return M-cycles consumed
     int step();
 
+    // Idle in HALT for up to 'max_m_cycles', stopping early once an
+    // interrupt is pending; returns M-cycles consumed (at least 1)
+    int run_halted(int max_m_cycles);
+
     // Handle pending interrupts
     void handle_interrupts(uint8_t pending);
 
@@ -38,8 +47,14 @@ public:
     uint8_t get_l() const { return m_l; }
     bool is_halted() const { return m_halted; }
 
+    // Record every instruction into trace while set (see emu/cpu_trace.hpp)
+    void set_trace(emu::CpuTrace* trace) { m_trace = trace; }
+
+    // Execute breakpoints checked at each instruction, or nullptr for none
+    void set_breakpoints(emu::Breakpoints* breakpoints) { m_breakpoints = breakpoints; }
+
     // Save/load state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
 
 private:
@@ -109,6 +124,20 @@ private:
     // Execute CB-prefixed instruction
     int execute_cb();
 
+    // Operand r of the r/(HL) forms: B, C, D, E, H, L, (HL), A
+    template <int R> uint8_t read_r8();
+    template <int R> void write_r8(uint8_t value);
+
+    // One CB opcode with its operation, bit and register fixed at compile
+    // time; s_cb_handlers holds all 256 instantiations
+    template <int OPCODE> void execute_cb_op();
+
+    using CbHandler = void (LR35902::*)();
+    template <size_t... OPCODES>
+    static constexpr std::array<CbHandler, 256> make_cb_handlers(std::index_sequence<OPCODES...>) {
+        return {{&LR35902::execute_cb_op<OPCODES>...}};
+    }
+
     // Bus reference
     Bus& m_bus;
 
@@ -132,6 +161,10 @@ private:
     bool m_halted = false;
     bool m_halt_bug = false;  // HALT bug: PC not incremented after HALT when IME=0
 
+    emu::CpuTrace* m_trace = nullptr;
+    void trace_instruction();
+    emu::Breakpoints* m_breakpoints = nullptr;
+
     // Flag bit positions
     static constexpr uint8_t FLAG_Z = 0x80;  // Zero
     static constexpr uint8_t FLAG_N = 0x40;  // Subtract
@@ -143,6 +176,9 @@ private:
 
     // Cycle table for CB-prefixed opcodes
     static const uint8_t s_cb_cycle_table[256];
+
+    // Handler table for CB-prefixed opcodes
+    static const std::array<CbHandler, 256> s_cb_handlers;
 };
 
 } // namespace gb
@@ -6,12 +6,12 @@
 
 namespace gb {
 
-MBC::MBC(std::vector<uint8_t>& rom, std::vector<uint8_t>& ram, int rom_banks, int ram_banks)
+MBC::MBC(const emu::RomImage& rom, std::vector<uint8_t>& ram, int rom_banks, int ram_banks)
     : m_rom(rom), m_ram(ram), m_rom_banks(rom_banks), m_ram_banks(ram_banks) {
     reset();
 }
 
-std::unique_ptr<MBC> MBC::create(int type, std::vector<uint8_t>& rom, std::vector<uint8_t>& ram, int rom_banks, int ram_banks) {
+std::unique_ptr<MBC> MBC::create(int type, const emu::RomImage& rom, std::vector<uint8_t>& ram, int rom_banks, int ram_banks) {
     switch (type) {
         case 0:  return std::make_unique<MBC0>(rom, ram, rom_banks, ram_banks);
         case 1:  return std::make_unique<MBC1>(rom, ram, rom_banks, ram_banks);
@@ -32,17 +32,34 @@ uint8_t MBC::read_rom(uint16_t address) {
     if (address < 0x4000) {
         // Bank 0
         if (address < m_rom.size()) {
-            return m_rom[address];
+            return m_rom.data()[address];
         }
     } else {
         // Switchable bank
         uint32_t offset = (m_rom_bank * 0x4000) + (address - 0x4000);
         offset %= m_rom.size();
-        return m_rom[offset];
+        return m_rom.data()[offset];
     }
     return 0xFF;
 }
 
+void MBC::update_map(CartridgeMap& map) const {
+    map.rom[0] = rom_bank_pointer(0);
+    map.rom[1] = rom_bank_pointer(m_rom_bank);
+    map.ram = m_ram_enabled ? ram_bank_pointer(m_ram_bank) : nullptr;
+}
+
+const uint8_t* MBC::rom_bank_pointer(uint32_t bank) const {
+    // Images that aren't a whole number of banks keep the slow path
+    if (m_rom.size() == 0 || (m_rom.size() % 0x4000) != 0) return nullptr;
+    return m_rom.data() + (bank * 0x4000) % m_rom.size();
+}
+
+uint8_t* MBC::ram_bank_pointer(uint32_t bank) const {
+    if ((bank + 1) * 0x2000 > m_ram.size()) return nullptr;
+    return m_ram.data() + bank * 0x2000;
+}
+
 uint8_t MBC::read_ram(uint16_t address) {
     if (!m_ram_enabled || m_ram.empty()) {
         return 0xFF;
@@ -66,7 +83,7 @@ void MBC::write_ram(uint16_t address, uint8_t value) {
     }
 }
 
-void MBC::save_state(std::vector<uint8_t>& data) {
+void MBC::save_state(StateWriter& data) {
     data.push_back(m_rom_bank & 0xFF);
     data.push_back((m_rom_bank >> 8) & 0xFF);
     data.push_back(m_ram_bank);
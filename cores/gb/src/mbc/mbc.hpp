@@ -4,16 +4,22 @@
 #include <vector>
 #include <memory>
 
+#include "emu/state_writer.hpp"
+#include "../types.hpp"
+#include "emu/rom_image.hpp"
+
 namespace gb {
 
+using emu::StateWriter;
+
 // Memory Bank Controller base class
 class MBC {
 public:
-    MBC(std::vector<uint8_t>& rom, std::vector<uint8_t>& ram, int rom_banks, int ram_banks);
+    MBC(const emu::RomImage& rom, std::vector<uint8_t>& ram, int rom_banks, int ram_banks);
     virtual ~MBC() = default;
 
     // Factory method
-    static std::unique_ptr<MBC> create(int type, std::vector<uint8_t>& rom, std::vector<uint8_t>& ram, int rom_banks, int ram_banks);
+    static std::unique_ptr<MBC> create(int type, const emu::RomImage& rom, std::vector<uint8_t>& ram, int rom_banks, int ram_banks);
 
     // Reset MBC state
     virtual void reset();
@@ -28,12 +34,20 @@ public:
     // MBC register writes
     virtual void write(uint16_t address, uint8_t value) = 0;
 
+    // Fill in the banks currently mapped; called after every register
+    // write, reset and state load
+    virtual void update_map(CartridgeMap& map) const;
+
     // Save state
-    virtual void save_state(std::vector<uint8_t>& data);
+    virtual void save_state(StateWriter& data);
     virtual void load_state(const uint8_t*& data, size_t& remaining);
 
 protected:
-    std::vector<uint8_t>& m_rom;
+    // Pointer to a 16KB ROM bank (wrapped like read_rom) or 8KB RAM bank
+    const uint8_t* rom_bank_pointer(uint32_t bank) const;
+    uint8_t* ram_bank_pointer(uint32_t bank) const;
+
+    const emu::RomImage& m_rom;  // The cartridge's, which outlives the MBC
     std::vector<uint8_t>& m_ram;
     int m_rom_banks;
     int m_ram_banks;
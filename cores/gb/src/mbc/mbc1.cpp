@@ -18,7 +18,7 @@ uint8_t MBC1::read_rom(uint16_t address) {
         }
         uint32_t offset = (bank * 0x4000) + address;
         offset %= m_rom.size();
-        return m_rom[offset];
+        return m_rom.data()[offset];
     } else {
         // Switchable bank
         uint32_t bank = m_rom_bank_lo;
@@ -29,10 +29,23 @@ uint8_t MBC1::read_rom(uint16_t address) {
 
         uint32_t offset = (bank * 0x4000) + (address - 0x4000);
         offset %= m_rom.size();
-        return m_rom[offset];
+        return m_rom.data()[offset];
     }
 }
 
+void MBC1::update_map(CartridgeMap& map) const {
+    MBC::update_map(map);
+
+    uint32_t bank0 = 0;
+    uint32_t bank = m_rom_bank_lo;
+    if (m_rom_banks > 32) {
+        if (m_mode) bank0 = m_bank_hi << 5;
+        bank |= (m_bank_hi << 5);
+    }
+    map.rom[0] = rom_bank_pointer(bank0);
+    map.rom[1] = rom_bank_pointer(bank % m_rom_banks);
+}
+
 void MBC1::write(uint16_t address, uint8_t value) {
     if (address < 0x2000) {
         // RAM Enable
@@ -70,7 +83,7 @@ void MBC1::write(uint16_t address, uint8_t value) {
     }
 }
 
-void MBC1::save_state(std::vector<uint8_t>& data) {
+void MBC1::save_state(StateWriter& data) {
     MBC::save_state(data);
     data.push_back(m_rom_bank_lo);
     data.push_back(m_bank_hi);
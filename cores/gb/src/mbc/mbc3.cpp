@@ -80,6 +80,13 @@ void MBC3::write(uint16_t address, uint8_t value) {
     }
 }
 
+void MBC3::update_map(CartridgeMap& map) const {
+    MBC::update_map(map);
+
+    // RTC registers stay on the read_ram()/write_ram() path
+    if (m_rtc_selected) map.ram = nullptr;
+}
+
 void MBC3::latch_rtc() {
     m_rtc_s_latch = m_rtc_s;
     m_rtc_m_latch = m_rtc_m;
@@ -88,7 +95,7 @@ void MBC3::latch_rtc() {
     m_rtc_dh_latch = m_rtc_dh;
 }
 
-void MBC3::save_state(std::vector<uint8_t>& data) {
+void MBC3::save_state(StateWriter& data) {
     MBC::save_state(data);
 
     data.push_back(m_rtc_s);
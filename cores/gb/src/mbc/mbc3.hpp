@@ -14,8 +14,9 @@ public:
     uint8_t read_ram(uint16_t address) override;
     void write_ram(uint16_t address, uint8_t value) override;
     void write(uint16_t address, uint8_t value) override;
+    void update_map(CartridgeMap& map) const override;
 
-    void save_state(std::vector<uint8_t>& data) override;
+    void save_state(StateWriter& data) override;
     void load_state(const uint8_t*& data, size_t& remaining) override;
 
 private:
@@ -32,7 +32,7 @@ void MBC5::write(uint16_t address, uint8_t value) {
     }
 }
 
-void MBC5::save_state(std::vector<uint8_t>& data) {
+void MBC5::save_state(StateWriter& data) {
     MBC::save_state(data);
     data.push_back(m_rom_bank_lo);
     data.push_back(m_rom_bank_hi);
@@ -14,7 +14,7 @@ public:
     void reset() override;
     void write(uint16_t address, uint8_t value) override;
 
-    void save_state(std::vector<uint8_t>& data) override;
+    void save_state(StateWriter& data) override;
     void load_state(const uint8_t*& data, size_t& remaining) override;
 
 private:
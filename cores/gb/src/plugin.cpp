@@ -1,4 +1,8 @@
 #include "emu/emulator_plugin.hpp"
+#include "emu/netplay_plugin.hpp"
+#include "emu/state_chunks.hpp"
+#include "emu/trace.hpp"
+#include "emu/link_cable.hpp"
 #include "types.hpp"
 #include "lr35902.hpp"
 #include "bus.hpp"
@@ -6,7 +10,11 @@
 #include "apu.hpp"
 #include "cartridge.hpp"
 #include "debug.hpp"
+#include "emu/state_writer.hpp"
+#include "link_cable.hpp"
 
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <cstdio>
 #include <iostream>
@@ -125,7 +133,8 @@ static const emu::ControllerLayoutInfo GB_CONTROLLER_LAYOUT = {
 };
 
 
-class GBPlugin : public emu::IEmulatorPlugin {
+class GBPlugin : public emu::IEmulatorPlugin, public emu::INetplayCapable,
+                 public emu::ILinkCableCapable {
 public:
     GBPlugin();
     ~GBPlugin() override;
@@ -136,6 +145,7 @@ public:
 
     // ROM management
     bool load_rom(const uint8_t* data, size_t size) override;
+    bool load_rom_shared(std::shared_ptr<const emu::RomImage> rom) override;
     void unload_rom() override;
     bool is_rom_loaded() const override;
     uint32_t get_rom_crc32() const override;
@@ -143,8 +153,10 @@ public:
     // Emulation
     void reset() override;
     void run_frame(const emu::InputState& input) override;
+    void run_frames(const emu::InputState* inputs, size_t count, emu::RunFlags flags) override;
     uint64_t get_cycle_count() const override;
     uint64_t get_frame_count() const override;
+    bool is_lag_frame() const override { return m_rom_loaded && !m_bus->was_joypad_read(); }
 
     // Video
     emu::FrameBuffer get_framebuffer() override;
@@ -154,20 +166,63 @@ public:
     void clear_audio_buffer() override;
 
     // Streaming audio (low-latency)
-    void set_audio_callback(AudioStreamCallback callback) override;
+    void set_audio_sink(const emu::AudioStreamSink& sink) override;
+    void set_audio_enabled(bool enabled) override;
+    void set_video_enabled(bool enabled) override;
+    bool set_output_framebuffer(uint32_t* pixels, int pitch) override;
+    const emu::ProfileMarker* get_profile_marker() const override { return &m_profile; }
+    void set_tracer(emu::Tracer* tracer) override { m_tracer = tracer; }
+    bool set_cpu_trace(emu::CpuTrace* trace) override;
 
     // Memory access
     uint8_t read_memory(uint16_t address) override;
     void write_memory(uint16_t address, uint8_t value) override;
+    std::vector<emu::MemoryDomain> get_memory_domains() override;
+    bool read_memory_block(size_t domain, uint32_t address, size_t length, uint8_t* out) override;
+    bool set_write_watchpoints(const uint32_t* addresses, size_t count) override;
+    size_t take_write_watch_hits(emu::WriteWatchHit* out, size_t max) override;
+    bool set_breakpoints(const emu::Breakpoint* breakpoints, size_t count) override;
+    size_t take_breakpoint_hits(emu::BreakpointHit* out, size_t max) override;
 
     // Save states
     bool save_state(std::vector<uint8_t>& data) override;
     bool load_state(const std::vector<uint8_t>& data) override;
+    bool load_state_chunks(const uint8_t* data, size_t size, const uint32_t* tags, size_t tag_count) override;
+    bool clone_into(emu::IEmulatorPlugin* other) override;
 
     // Battery-backed save support
     bool has_battery_save() const override;
     std::vector<uint8_t> get_battery_save_data() const override;
     bool set_battery_save_data(const std::vector<uint8_t>& data) override;
+    uint64_t get_battery_save_generation() const override;
+
+    // Netplay/Rollback support (INetplayCapable)
+    // The GB core is integer-only and the MBC3 RTC registers only change
+    // through emulated writes (never the host clock), so replays are deterministic
+    bool is_deterministic() const override { return true; }
+
+    // The Game Boy has a single controller, so only player 1 input is used
+    void run_frame_netplay(uint32_t player1_buttons, uint32_t player2_buttons) override;
+    int get_max_players() const override { return 1; }
+
+    // Buttons are read from the VirtualButton bits A through Right
+    int get_input_bits() const override { return 12; }
+
+    // Fast save state for rollback - writes directly to buffer, no allocations
+    size_t get_max_state_size() const override;
+    size_t save_state_fast(uint8_t* buffer, size_t buffer_size) override;
+    bool load_state_fast(const uint8_t* buffer, size_t size) override;
+
+    // State hash for desync detection
+    uint64_t get_state_hash() const override;
+
+    // Discard audio during rollback re-simulation
+    void discard_audio() override { m_audio_samples = 0; }
+
+    // Link cable between two GB instances (ILinkCableCapable)
+    bool connect_link(emu::ILinkCableCapable* partner) override;
+    void disconnect_link() override;
+    bool is_link_connected() const override;
 
     // Configuration GUI
     bool has_config_gui() const override { return true; }
@@ -178,6 +233,7 @@ public:
 
     // Fast mode support
     bool is_fast_mode_enabled() const override { return m_fast_mode; }
+    void set_enhancements_allowed(bool allowed) override { m_enhancements_allowed = allowed; }
 
     // Configuration persistence
     bool save_config(const char* path) override;
@@ -186,6 +242,23 @@ public:
 private:
     void run_gb_frame(const emu::InputState& input);
 
+    // Run the CPU alone for m_overclock_lines scanlines' worth of T-cycles
+    void run_overclock();
+
+    // Shared serialization helpers - used by both the vector-based and the
+    // in-place (rollback) save state paths
+    void serialize_state(StateWriter& out) const;
+    bool deserialize_state(const uint8_t* buffer, size_t size);
+
+    // Chunks with the given tags (all of them for a null list), or a state
+    // from before chunking
+    bool deserialize_chunks(const uint8_t* buffer, size_t size, const uint32_t* tags, size_t tag_count);
+    bool load_state_chunk(const emu::StateChunk& chunk);
+    bool deserialize_unchunked_state(const uint8_t* buffer, size_t size);
+
+    // Domain index of get_memory_domains(); false past the last
+    bool get_memory_domain(size_t index, emu::MemoryDomain& domain) const;
+
     // Components
     std::unique_ptr<LR35902> m_cpu;
     std::unique_ptr<Bus> m_bus;
@@ -193,8 +266,18 @@ private:
     std::unique_ptr<APU> m_apu;
     std::unique_ptr<Cartridge> m_cartridge;
 
+    // Handed to each new bus while any address is watched
+    emu::WriteWatchpoints m_write_watch;
+    emu::Breakpoints m_breakpoints{16, 8};
+    void apply_breakpoints();
+
+    // Link cable, kept across ROM loads; side 0 or 1 of the cable
+    std::shared_ptr<LinkCable> m_link_cable;
+    int m_link_side = 0;
+
     SystemType m_system_type = SystemType::GameBoy;
     bool m_rom_loaded = false;
+    bool m_video_enabled = true;  // False = frames run without drawing
     uint32_t m_rom_crc32 = 0;
     uint64_t m_total_cycles = 0;
     uint64_t m_frame_count = 0;
@@ -203,12 +286,32 @@ private:
     static constexpr int SCREEN_WIDTH = 160;
     static constexpr int SCREEN_HEIGHT = 144;
     uint32_t m_framebuffer[SCREEN_WIDTH * SCREEN_HEIGHT];
+    uint32_t* m_output_framebuffer = nullptr;       // Host buffer frames are drawn into, if set
+    uint32_t* m_shown_framebuffer = m_framebuffer;  // Holds the last frame drawn
 
     // Audio buffer
     static constexpr size_t AUDIO_BUFFER_SIZE = 2048;
     float m_audio_buffer[AUDIO_BUFFER_SIZE * 2];  // Stereo
     size_t m_audio_samples = 0;
 
+    // Rollback state size, measured once per cartridge in load_rom()
+    size_t m_max_state_size = 0;
+
+    // Subsystem being run, for the benchmark's breakdown
+    emu::ProfileMarker m_profile;
+
+    // Frame phase tracing, if the host is recording
+    emu::Tracer* m_tracer = nullptr;
+
+    // Instruction trace, if the host is recording one
+    emu::CpuTrace* m_cpu_trace = nullptr;
+
+    // Scratch buffer for get_state_hash(), sized alongside m_max_state_size
+    mutable std::vector<uint8_t> m_hash_buffer;
+
+    // clone_into() stages the state here, on the receiving instance
+    std::vector<uint8_t> m_clone_state;
+
     // Test ROM result tracking (for DEBUG mode)
     bool m_test_result_reported = false;
 
@@ -217,6 +320,9 @@ private:
     bool m_use_custom_palette = false;  // True if using custom colors
     uint32_t m_custom_palette[4];    // Custom palette colors (ABGR format)
     bool m_fast_mode = false;        // Run at uncapped speed when true
+    static constexpr int MAX_OVERCLOCK_LINES = 1000;
+    int m_overclock_lines = 0;       // Extra CPU-only scanlines at VBlank
+    bool m_enhancements_allowed = true;  // Host switch for m_overclock_lines
 
     // File extensions
     static const char* s_extensions[];
@@ -233,9 +339,13 @@ GBPlugin::GBPlugin() {
 
     m_cartridge = std::make_unique<Cartridge>();
     m_apu = std::make_unique<APU>();
+    m_write_watch.set_clock(&m_total_cycles);
+    m_breakpoints.set_clock(&m_total_cycles);
 }
 
-GBPlugin::~GBPlugin() = default;
+GBPlugin::~GBPlugin() {
+    disconnect_link();
+}
 
 emu::EmulatorInfo GBPlugin::get_info() {
     emu::EmulatorInfo info;
@@ -274,12 +384,16 @@ const emu::ControllerLayoutInfo* GBPlugin::get_controller_layout() {
 }
 
 bool GBPlugin::load_rom(const uint8_t* data, size_t size) {
+    return load_rom_shared(emu::make_rom_image(data, size));
+}
+
+bool GBPlugin::load_rom_shared(std::shared_ptr<const emu::RomImage> rom) {
     if (m_rom_loaded) {
         unload_rom();
     }
 
     // Load cartridge
-    if (!m_cartridge->load(data, size)) {
+    if (!m_cartridge->load(std::move(rom))) {
         return false;
     }
 
@@ -290,13 +404,20 @@ bool GBPlugin::load_rom(const uint8_t* data, size_t size) {
     // Setup GB/GBC system
     m_bus = std::make_unique<Bus>();
     m_cpu = std::make_unique<LR35902>(*m_bus);
+    m_cpu->set_trace(m_cpu_trace);
     m_ppu = std::make_unique<PPU>(*m_bus);
+    m_ppu->set_video_enabled(m_video_enabled);
 
     // Connect components
     m_bus->connect_cpu(m_cpu.get());
     m_bus->connect_ppu(m_ppu.get());
     m_bus->connect_apu(m_apu.get());
     m_bus->connect_cartridge(m_cartridge.get());
+    m_bus->set_write_watch(m_write_watch.empty() ? nullptr : &m_write_watch);
+    apply_breakpoints();
+    if (m_link_cable) {
+        m_bus->connect_link(m_link_cable, m_link_side);
+    }
 
     // Set CGB mode
     bool is_cgb = (m_system_type == SystemType::GameBoyColor);
@@ -304,7 +425,9 @@ bool GBPlugin::load_rom(const uint8_t* data, size_t size) {
     m_ppu->set_cgb_mode(is_cgb);
     m_apu->set_cgb_mode(is_cgb);
 
-    // Reset everything
+    // Reset everything. No boot ROM runs: the CPU, APU and IO resets are
+    // the HLE boot path and leave every register at its post-boot value,
+    // with PC at the cartridge entry point 0x0100
     m_cpu->reset();
     m_ppu->reset();
     m_apu->reset();
@@ -324,6 +447,14 @@ bool GBPlugin::load_rom(const uint8_t* data, size_t size) {
     m_frame_count = 0;
     m_test_result_reported = false;
 
+    // State size is fixed once the cartridge RAM size and CGB mode are known,
+    // so one sizing pass gives the rollback buffer size. Round up to 4KB to
+    // leave headroom.
+    StateWriter sizer(nullptr, 0);
+    serialize_state(sizer);
+    m_max_state_size = (sizer.size() + 0xFFF) & ~static_cast<size_t>(0xFFF);
+    m_hash_buffer.assign(m_max_state_size, 0);
+
     if (is_debug_mode()) {
         printf("[GB] ROM loaded: %s (%s)\n",
                m_cartridge->get_title().c_str(),
@@ -342,6 +473,8 @@ void GBPlugin::unload_rom() {
     m_rom_crc32 = 0;
     m_total_cycles = 0;
     m_frame_count = 0;
+    m_max_state_size = 0;
+    m_hash_buffer.clear();
 }
 
 bool GBPlugin::is_rom_loaded() const {
@@ -359,6 +492,7 @@ void GBPlugin::reset() {
     m_ppu->reset();
     m_apu->reset();
     m_cartridge->reset();
+    m_bus->reset_speed();
 
     m_total_cycles = 0;
     m_frame_count = 0;
@@ -371,12 +505,68 @@ void GBPlugin::run_frame(const emu::InputState& input) {
     m_frame_count++;
 }
 
+void GBPlugin::run_frames(const emu::InputState* inputs, size_t count, emu::RunFlags flags) {
+    if (!m_rom_loaded || count == 0) return;
+
+    // Output is switched once around the batch instead of per frame, and the
+    // frames run straight through without going back through the interface
+    bool skip_video = (flags & emu::RUN_FLAGS_SKIP_VIDEO) && count > 1;
+    bool skip_audio = (flags & emu::RUN_FLAGS_SKIP_AUDIO) && count > 1;
+    if (skip_video) set_video_enabled(false);
+    if (skip_audio) set_audio_enabled(false);
+
+    for (size_t i = 0; i + 1 < count; i++) {
+        run_gb_frame(inputs[i]);
+        m_frame_count++;
+    }
+
+    if (skip_video) set_video_enabled(true);
+    if (skip_audio) set_audio_enabled(true);
+    run_gb_frame(inputs[count - 1]);
+    m_frame_count++;
+}
+
+void GBPlugin::run_frame_netplay(uint32_t player1_buttons, uint32_t player2_buttons) {
+    (void)player2_buttons;  // No second controller port
+
+    emu::InputState input;
+    input.buttons = player1_buttons;
+    run_frame(input);
+}
+
+void GBPlugin::run_overclock() {
+    EMU_TRACE_SCOPE(m_tracer, "gb", "overclock");
+    int t_budget = m_overclock_lines * 456;
+
+    // Once the CPU halts nothing can wake it until the PPU moves again
+    m_bus->set_cpu_only(true);
+    while (t_budget > 0 && !m_cpu->is_halted()) {
+        int m_cycles = m_cpu->step() + m_bus->run_dma_stall();
+        m_total_cycles += m_cycles;
+        t_budget -= m_cycles * m_bus->t_cycles_per_m_cycle();
+
+        uint8_t interrupts = m_bus->get_pending_interrupts();
+        if (interrupts) {
+            m_cpu->handle_interrupts(interrupts);
+        }
+    }
+    m_bus->set_cpu_only(false);
+}
+
 void GBPlugin::run_gb_frame(const emu::InputState& input) {
+    // Marked around each subsystem call below; timer and OAM DMA ticked
+    // from CPU memory accesses count as CPU
+    emu::ProfileScope profile(m_profile, emu::ProfileSection::CPU);
+    EMU_TRACE_SCOPE(m_tracer, "gb", "frame");
+    if (!m_write_watch.empty()) m_write_watch.begin_frame(m_total_cycles);
+    if (!m_breakpoints.empty()) m_breakpoints.begin_frame(m_total_cycles);
+
     // Set input state
+    m_bus->clear_joypad_read();
     m_bus->set_input_state(input.buttons);
 
     // GB: 70224 T-cycles per frame (154 scanlines * 456 T-cycles)
-    // CPU operates in M-cycles where 1 M-cycle = 4 T-cycles
+    // CPU operates in M-cycles where 1 M-cycle = 4 T-cycles (2 at CGB double speed)
     constexpr int T_CYCLES_PER_FRAME = 70224;
     int t_cycles_run = 0;
 
@@ -384,8 +574,21 @@ void GBPlugin::run_gb_frame(const emu::InputState& input) {
         // CPU step returns M-cycles
         // Note: The CPU's read/write methods now tick the bus (timer, serial, OAM DMA)
         // during each memory access for cycle-accurate timing.
-        int m_cycles = m_cpu->step();
-        int t_cycles = m_cycles * 4;  // Convert to T-cycles
+        int m_cycles;
+        if (m_cpu->is_halted()) {
+            // Nothing but the bus runs until an interrupt; the PPU can only
+            // raise one at its next mode change, so idle up to that point
+            int t_per_m = m_bus->t_cycles_per_m_cycle();
+            int t_budget = std::min(m_ppu->cycles_until_event(), T_CYCLES_PER_FRAME - t_cycles_run);
+            m_cycles = m_cpu->run_halted((t_budget + t_per_m - 1) / t_per_m);
+        } else {
+            m_cycles = m_cpu->step();
+        }
+        // A VRAM DMA started by the instruction or the last HBlank stops
+        // the CPU for its length
+        m_cycles += m_bus->run_dma_stall();
+        // Convert to T-cycles (2 per M-cycle in CGB double speed)
+        int t_cycles = m_cycles * m_bus->t_cycles_per_m_cycle();
 
         m_total_cycles += m_cycles;
         t_cycles_run += t_cycles;
@@ -394,27 +597,47 @@ void GBPlugin::run_gb_frame(const emu::InputState& input) {
         // via bus.tick_m_cycle() called from CPU read/write.
         // We don't step them again here to avoid double-counting.
 
-        // Step PPU (operates on T-cycles, 1 T-cycle per step)
-        for (int i = 0; i < t_cycles; i++) {
-            m_ppu->step();
-        }
+        // Step PPU (operates on T-cycles; only runs at mode changes)
+        m_profile.set(emu::ProfileSection::PPU);
+        m_ppu->advance(t_cycles);
 
         // Step APU (operates on T-cycles for proper timing)
+        m_profile.set(emu::ProfileSection::APU);
         m_apu->step(t_cycles);
+        m_profile.set(emu::ProfileSection::CPU);
 
         // Handle interrupts
         uint8_t interrupts = m_bus->get_pending_interrupts();
         if (interrupts) {
             m_cpu->handle_interrupts(interrupts);
         }
-    }
 
-    // Copy framebuffer
-    const uint32_t* ppu_fb = m_ppu->get_framebuffer();
-    std::memcpy(m_framebuffer, ppu_fb, SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(uint32_t));
+        // Frames aren't aligned to VBlank here, so overclocked lines go in
+        // wherever the PPU enters it, after its interrupt is dispatched
+        if (m_ppu->take_vblank_start() && m_overclock_lines > 0 && m_enhancements_allowed) {
+            run_overclock();
+        }
+    }
+    // The caller counts the frame once this returns
+    if (!m_write_watch.empty()) m_write_watch.end_frame(m_total_cycles, m_frame_count + 1);
+    if (!m_breakpoints.empty()) m_breakpoints.end_frame(m_total_cycles, m_frame_count + 1);
+
+    // Copy framebuffer (kept at the last shown frame while video is off)
+    if (m_video_enabled) {
+        EMU_TRACE_SCOPE(m_tracer, "gb", "video");
+        m_profile.set(emu::ProfileSection::PPU);
+        const uint32_t* ppu_fb = m_ppu->get_framebuffer();
+        uint32_t* out = m_output_framebuffer ? m_output_framebuffer : m_framebuffer;
+        std::memcpy(out, ppu_fb, SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(uint32_t));
+        m_shown_framebuffer = out;
+    }
 
-    // Get audio samples
-    m_audio_samples = m_apu->get_samples(m_audio_buffer, AUDIO_BUFFER_SIZE);
+    // Catch the APU up to the end of the frame and take its samples
+    {
+        EMU_TRACE_SCOPE(m_tracer, "gb", "audio");
+        m_profile.set(emu::ProfileSection::APU);
+        m_audio_samples = m_apu->get_samples(m_audio_buffer, AUDIO_BUFFER_SIZE);
+    }
 
     // Check for test ROM results in debug mode
     if (is_debug_mode() && !m_test_result_reported) {
@@ -438,6 +661,37 @@ void GBPlugin::run_gb_frame(const emu::InputState& input) {
     }
 }
 
+bool GBPlugin::connect_link(emu::ILinkCableCapable* partner) {
+    // Only another GB instance speaks this cable's protocol
+    auto* other = dynamic_cast<GBPlugin*>(partner);
+    if (!other || other == this) return false;
+
+    disconnect_link();
+    other->disconnect_link();
+
+    auto cable = std::make_shared<LinkCable>();
+    m_link_cable = cable;
+    m_link_side = 0;
+    other->m_link_cable = cable;
+    other->m_link_side = 1;
+    if (m_bus) m_bus->connect_link(cable, 0);
+    if (other->m_bus) other->m_bus->connect_link(cable, 1);
+    return true;
+}
+
+void GBPlugin::disconnect_link() {
+    if (!m_link_cable) return;
+
+    // The partner's bus notices on its next link service
+    m_link_cable->disconnect();
+    m_link_cable.reset();
+    if (m_bus) m_bus->disconnect_link();
+}
+
+bool GBPlugin::is_link_connected() const {
+    return m_link_cable && m_link_cable->is_connected();
+}
+
 uint64_t GBPlugin::get_cycle_count() const {
     return m_total_cycles;
 }
@@ -448,7 +702,7 @@ uint64_t GBPlugin::get_frame_count() const {
 
 emu::FrameBuffer GBPlugin::get_framebuffer() {
     return {
-        m_framebuffer,
+        m_shown_framebuffer,
         SCREEN_WIDTH,
         SCREEN_HEIGHT
     };
@@ -458,7 +712,7 @@ emu::AudioBuffer GBPlugin::get_audio() {
     return {
         m_audio_buffer,
         static_cast<int>(m_audio_samples),
-        44100  // Sample rate
+        m_apu->get_sample_rate()
     };
 }
 
@@ -466,25 +720,44 @@ void GBPlugin::clear_audio_buffer() {
     m_audio_samples = 0;
 }
 
-void GBPlugin::set_audio_callback(AudioStreamCallback callback) {
+void GBPlugin::set_audio_sink(const emu::AudioStreamSink& sink) {
     // Store in base class
-    m_audio_callback = callback;
+    m_audio_sink = sink;
 
     // Forward to APU for direct streaming
     if (m_apu) {
-        if (callback) {
-            m_apu->set_audio_callback([callback](const float* samples, size_t count, int rate) {
-                callback(samples, count, rate);
-            });
-        } else {
-            m_apu->set_audio_callback(nullptr);
-        }
+        m_apu->set_audio_sink(sink);
+    }
+}
+
+void GBPlugin::set_audio_enabled(bool enabled) {
+    if (m_apu) {
+        m_apu->set_audio_enabled(enabled);
+    }
+}
+
+void GBPlugin::set_video_enabled(bool enabled) {
+    m_video_enabled = enabled;
+    if (m_ppu) {
+        m_ppu->set_video_enabled(enabled);
     }
 }
 
+bool GBPlugin::set_output_framebuffer(uint32_t* pixels, int pitch) {
+    if (pixels && pitch != SCREEN_WIDTH) return false;
+
+    // Keep the last frame when going back to our own buffer
+    if (!pixels && m_shown_framebuffer != m_framebuffer) {
+        std::memcpy(m_framebuffer, m_shown_framebuffer, sizeof(m_framebuffer));
+        m_shown_framebuffer = m_framebuffer;
+    }
+    m_output_framebuffer = pixels;
+    return true;
+}
+
 uint8_t GBPlugin::read_memory(uint16_t address) {
     if (m_bus) {
-        return m_bus->read(address);
+        return m_bus->peek(address);
     }
     return 0xFF;
 }
@@ -495,32 +768,217 @@ void GBPlugin::write_memory(uint16_t address, uint8_t value) {
     }
 }
 
-bool GBPlugin::save_state(std::vector<uint8_t>& data) {
-    if (!m_rom_loaded) return false;
+// Domain indices used by read_memory_block()
+enum : size_t { GB_DOMAIN_BUS = 0, GB_DOMAIN_WRAM = 1 };
+
+bool GBPlugin::get_memory_domain(size_t index, emu::MemoryDomain& domain) const {
+    bool cgb = m_bus->is_cgb_mode();
+    switch (index) {
+        case GB_DOMAIN_BUS: domain = {"CPU Bus", 0x10000, nullptr}; return true;
+        // Banks 0-7 in order; not one array, so read through read_memory_block()
+        case GB_DOMAIN_WRAM: domain = {"WRAM", cgb ? 0x8000u : 0x2000u, nullptr}; return true;
+        case 2: domain = {"HRAM", 0x7F, m_bus->get_hram_data()}; return true;
+        case 3: domain = {"VRAM", cgb ? 0x4000u : 0x2000u, m_ppu->get_vram_data()}; return true;
+        case 4: domain = {"OAM", 160, m_ppu->get_oam_data()}; return true;
+        case 5:
+            domain = {"SRAM", static_cast<uint32_t>(m_cartridge->get_ram_size()), m_cartridge->get_ram_data()};
+            return true;
+        case 6:
+            domain = {"ROM", static_cast<uint32_t>(m_cartridge->get_rom_size()), m_cartridge->get_rom_data()};
+            return true;
+        // CGB palette memory (FF69/FF6B), eight 4-colour BGR555 palettes each
+        case 7: domain = {"BG Palette", 64, m_ppu->get_bg_palette_data()}; return true;
+        case 8: domain = {"OBJ Palette", 64, m_ppu->get_obj_palette_data()}; return true;
+        default: return false;
+    }
+}
 
-    // Save total cycles and frame count
-    for (int i = 0; i < 8; i++) {
-        data.push_back((m_total_cycles >> (i * 8)) & 0xFF);
+bool GBPlugin::set_write_watchpoints(const uint32_t* addresses, size_t count) {
+    m_write_watch.set(addresses, count);
+    if (m_bus) m_bus->set_write_watch(m_write_watch.empty() ? nullptr : &m_write_watch);
+    return true;
+}
+
+bool GBPlugin::set_cpu_trace(emu::CpuTrace* trace) {
+    if (trace) trace->set_clock(&m_total_cycles);
+    m_cpu_trace = trace;
+    if (m_cpu) m_cpu->set_trace(trace);
+    return true;
+}
+
+size_t GBPlugin::take_write_watch_hits(emu::WriteWatchHit* out, size_t max) {
+    return m_write_watch.take(out, max);
+}
+
+bool GBPlugin::set_breakpoints(const emu::Breakpoint* breakpoints, size_t count) {
+    m_breakpoints.set(breakpoints, count);
+    apply_breakpoints();
+    return true;
+}
+
+// The CPU and bus are rebuilt on each load, so they're handed the
+// breakpoints again from here
+void GBPlugin::apply_breakpoints() {
+    uint8_t kinds = m_breakpoints.kinds();
+    if (m_cpu) m_cpu->set_breakpoints(kinds & emu::BREAK_EXECUTE ? &m_breakpoints : nullptr);
+    if (m_bus) m_bus->set_breakpoints(kinds & (emu::BREAK_READ | emu::BREAK_WRITE) ? &m_breakpoints : nullptr);
+}
+
+size_t GBPlugin::take_breakpoint_hits(emu::BreakpointHit* out, size_t max) {
+    return m_breakpoints.take(out, max);
+}
+
+std::vector<emu::MemoryDomain> GBPlugin::get_memory_domains() {
+    std::vector<emu::MemoryDomain> domains;
+    emu::MemoryDomain domain;
+    for (size_t i = 0; get_memory_domain(i, domain); i++) {
+        domains.push_back(domain);
     }
-    for (int i = 0; i < 8; i++) {
-        data.push_back((m_frame_count >> (i * 8)) & 0xFF);
+    return domains;
+}
+
+bool GBPlugin::read_memory_block(size_t domain, uint32_t address, size_t length, uint8_t* out) {
+    emu::MemoryDomain info;
+    if (!get_memory_domain(domain, info)) return false;
+    if (address > info.size || length > info.size - address) return false;
+
+    switch (domain) {
+        case GB_DOMAIN_BUS:
+            // read() would check breakpoints and mark the joypad as read
+            for (size_t i = 0; i < length; i++) {
+                out[i] = m_bus->peek(static_cast<uint16_t>(address + i));
+            }
+            return true;
+        case GB_DOMAIN_WRAM: {
+            size_t low = address < 0x2000 ? std::min<size_t>(length, 0x2000 - address) : 0;
+            if (low > 0) {
+                std::memcpy(out, m_bus->get_wram_data() + address, low);
+            }
+            if (length > low) {
+                std::memcpy(out + low, m_bus->get_wram_cgb_data() + (address + low - 0x2000), length - low);
+            }
+            return true;
+        }
+        default:
+            return emu::copy_memory_domain(info, address, length, out);
     }
+}
 
-    // Save component states
-    m_cpu->save_state(data);
-    m_bus->save_state(data);
-    m_ppu->save_state(data);
-    m_apu->save_state(data);
-    m_cartridge->save_state(data);
+bool GBPlugin::save_state(std::vector<uint8_t>& data) {
+    if (!m_rom_loaded) return false;
 
+    StateWriter writer(data);
+    serialize_state(writer);
     return true;
 }
 
 bool GBPlugin::load_state(const std::vector<uint8_t>& data) {
-    if (!m_rom_loaded || data.size() < 16) return false;
+    if (!m_rom_loaded) return false;
+    return deserialize_state(data.data(), data.size());
+}
+
+// Layout version of every chunk this core writes; bump a chunk's own when
+// its subsystem's save_state() changes, and keep loading the old one
+static constexpr uint16_t GB_CHUNK_VERSION = 1;
+static constexpr uint16_t GB_BUS_CHUNK_VERSION = 2;    // 2: the whole DIV counter
+
+static uint16_t gb_chunk_version(uint32_t tag) {
+    return tag == emu::STATE_CHUNK_BUS ? GB_BUS_CHUNK_VERSION : GB_CHUNK_VERSION;
+}
 
-    const uint8_t* ptr = data.data();
-    size_t remaining = data.size();
+void GBPlugin::serialize_state(StateWriter& out) const {
+    emu::write_state_chunks_magic(out);
+
+    emu::write_state_chunk(out, emu::STATE_CHUNK_TIMING, GB_CHUNK_VERSION, [&] {
+        for (int i = 0; i < 8; i++) {
+            out.push_back((m_total_cycles >> (i * 8)) & 0xFF);
+        }
+        for (int i = 0; i < 8; i++) {
+            out.push_back((m_frame_count >> (i * 8)) & 0xFF);
+        }
+    });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_CPU, GB_CHUNK_VERSION, [&] { m_cpu->save_state(out); });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_WORK_RAM, GB_CHUNK_VERSION, [&] { m_bus->save_work_ram(out); });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_BUS, GB_BUS_CHUNK_VERSION, [&] {
+        m_bus->save_registers(out);
+        m_bus->save_dma_state(out);
+        m_bus->save_timer_state(out);
+    });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_PPU, GB_CHUNK_VERSION, [&] { m_ppu->save_state(out); });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_APU, GB_CHUNK_VERSION, [&] { m_apu->save_state(out); });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_CARTRIDGE, GB_CHUNK_VERSION, [&] { m_cartridge->save_state(out); });
+}
+
+bool GBPlugin::deserialize_state(const uint8_t* buffer, size_t size) {
+    return deserialize_chunks(buffer, size, nullptr, 0);
+}
+
+bool GBPlugin::load_state_chunks(const uint8_t* data, size_t size, const uint32_t* tags, size_t tag_count) {
+    if (!m_rom_loaded || !data || !tags || tag_count == 0) return false;
+    return deserialize_chunks(data, size, tags, tag_count);
+}
+
+bool GBPlugin::deserialize_chunks(const uint8_t* buffer, size_t size, const uint32_t* tags, size_t tag_count) {
+    emu::StateChunkReader reader(buffer, size);
+    if (!reader.is_chunked()) {
+        // Old states can only be loaded whole
+        return !tags && deserialize_unchunked_state(buffer, size);
+    }
+
+    bool loaded = false;
+    emu::StateChunk chunk;
+    while (reader.next(chunk)) {
+        if (!emu::state_chunk_selected(chunk.tag, tags, tag_count)) continue;
+        if (chunk.version > gb_chunk_version(chunk.tag)) {
+            std::cerr << "[GB] Save state is from a newer version" << std::endl;
+            return false;
+        }
+        if (!load_state_chunk(chunk)) {
+            return false;
+        }
+        loaded = true;
+    }
+    return loaded && !reader.malformed();
+}
+
+bool GBPlugin::load_state_chunk(const emu::StateChunk& chunk) {
+    const uint8_t* ptr = chunk.data;
+    size_t remaining = chunk.size;
+
+    switch (chunk.tag) {
+        case emu::STATE_CHUNK_TIMING:
+            if (remaining < 16) return false;
+            m_total_cycles = 0;
+            m_frame_count = 0;
+            for (int i = 0; i < 8; i++) {
+                m_total_cycles |= static_cast<uint64_t>(ptr[i]) << (i * 8);
+                m_frame_count |= static_cast<uint64_t>(ptr[8 + i]) << (i * 8);
+            }
+            return true;
+        case emu::STATE_CHUNK_CPU: m_cpu->load_state(ptr, remaining); break;
+        case emu::STATE_CHUNK_WORK_RAM: m_bus->load_work_ram(ptr, remaining); break;
+        case emu::STATE_CHUNK_BUS:
+            m_bus->load_registers(ptr, remaining);
+            m_bus->load_dma_state(ptr, remaining);
+            if (chunk.version >= 2) m_bus->load_timer_state(ptr, remaining);
+            break;
+        case emu::STATE_CHUNK_PPU: m_ppu->load_state(ptr, remaining); break;
+        case emu::STATE_CHUNK_APU: m_apu->load_state(ptr, remaining); break;
+        case emu::STATE_CHUNK_CARTRIDGE: m_cartridge->load_state(ptr, remaining); break;
+        default:
+            return true;  // Written by a newer build; skipped
+    }
+
+    // The component loaders don't check sizes; one that read past its
+    // chunk has wrapped the count
+    return remaining <= chunk.size;
+}
+
+bool GBPlugin::deserialize_unchunked_state(const uint8_t* buffer, size_t size) {
+    if (size < 16) return false;
+
+    const uint8_t* ptr = buffer;
+    size_t remaining = size;
 
     // Load total cycles and frame count
     m_total_cycles = 0;
@@ -544,6 +1002,76 @@ bool GBPlugin::load_state(const std::vector<uint8_t>& data) {
     return true;
 }
 
+// Fast save state for rollback
+size_t GBPlugin::get_max_state_size() const {
+    return m_max_state_size;
+}
+
+size_t GBPlugin::save_state_fast(uint8_t* buffer, size_t buffer_size) {
+    if (!m_rom_loaded) return 0;
+
+    // If buffer is null, just return required size
+    if (buffer == nullptr) {
+        return get_max_state_size();
+    }
+
+    if (buffer_size < get_max_state_size()) {
+        return 0;  // Buffer too small
+    }
+
+    StateWriter writer(buffer, buffer_size);
+    serialize_state(writer);
+
+    if (writer.overflowed()) {
+        return 0;  // Shouldn't happen, the size was measured at load time
+    }
+
+    return writer.size();
+}
+
+bool GBPlugin::load_state_fast(const uint8_t* buffer, size_t size) {
+    if (!m_rom_loaded || buffer == nullptr) return false;
+    return deserialize_state(buffer, size);
+}
+
+bool GBPlugin::clone_into(emu::IEmulatorPlugin* other) {
+    auto* target = dynamic_cast<GBPlugin*>(other);
+    if (!target || target == this || !m_rom_loaded || !target->m_rom_loaded ||
+        target->m_rom_crc32 != m_rom_crc32) {
+        return false;
+    }
+
+    // Through the fast state path; after the first clone nothing allocates
+    target->m_clone_state.resize(get_max_state_size());
+    size_t size = save_state_fast(target->m_clone_state.data(), target->m_clone_state.size());
+    return size > 0 && target->load_state_fast(target->m_clone_state.data(), size);
+}
+
+// FNV-1a hash for desync detection (fast, non-cryptographic)
+static uint64_t fnv1a_hash(const uint8_t* data, size_t size) {
+    const uint64_t FNV_PRIME = 0x100000001b3ULL;
+    const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+uint64_t GBPlugin::get_state_hash() const {
+    if (!m_rom_loaded || m_hash_buffer.empty()) return 0;
+
+    // Hash the complete serialized state into a scratch buffer sized at
+    // load time, so this never allocates
+    StateWriter writer(m_hash_buffer.data(), m_hash_buffer.size());
+    serialize_state(writer);
+    if (writer.overflowed()) return 0;
+
+    return fnv1a_hash(m_hash_buffer.data(), writer.size());
+}
+
 bool GBPlugin::has_battery_save() const {
     return m_cartridge && m_cartridge->has_battery();
 }
@@ -562,6 +1090,10 @@ bool GBPlugin::set_battery_save_data(const std::vector<uint8_t>& data) {
     return false;
 }
 
+uint64_t GBPlugin::get_battery_save_generation() const {
+    return m_cartridge ? m_cartridge->get_save_generation() : 0;
+}
+
 // Helper to convert ABGR (internal format) to ImVec4 (RGBA float)
 static ImVec4 abgr_to_imvec4(uint32_t abgr) {
     float r = ((abgr >> 0) & 0xFF) / 255.0f;
@@ -728,6 +1260,35 @@ void GBPlugin::render_config_gui_content() {
         } else {
             ImGui::TextColored(ImVec4(0.4f, 1.0f, 0.4f, 1.0f), "Running at CYCLE-ACCURATE speed (default)");
         }
+
+        // Overclock
+        ImGui::Spacing();
+        if (ImGui::SliderInt("Overclock Lines", &m_overclock_lines, 0, MAX_OVERCLOCK_LINES)) {
+            m_overclock_lines = std::clamp(m_overclock_lines, 0, MAX_OVERCLOCK_LINES);
+        }
+        ImGui::SameLine();
+        ImGui::TextDisabled("(?)");
+        if (ImGui::IsItemHovered()) {
+            ImGui::BeginTooltip();
+            ImGui::PushTextWrapPos(ImGui::GetFontSize() * 25.0f);
+            ImGui::TextUnformatted(
+                "Adds scanlines at the start of VBlank in which only the CPU "
+                "runs; the LCD, sound and timer wait. Games that slow down "
+                "in busy scenes get more time per frame.\n\n"
+                "This is NOT accurate to real hardware and some games may "
+                "misbehave. It is turned off during netplay and while a TAS "
+                "movie is open."
+            );
+            ImGui::PopTextWrapPos();
+            ImGui::EndTooltip();
+        }
+        if (m_overclock_lines > 0) {
+            if (m_enhancements_allowed) {
+                ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.0f, 1.0f), "Overclocked (not accurate)");
+            } else {
+                ImGui::TextDisabled("Overclock off for netplay or TAS");
+            }
+        }
     }
 
     if (ImGui::CollapsingHeader("System Information")) {
@@ -761,7 +1322,8 @@ bool GBPlugin::save_config(const char* path) {
         file << "\n";
     }
     file << "  ],\n";
-    file << "  \"fast_mode\": " << (m_fast_mode ? "true" : "false") << "\n";
+    file << "  \"fast_mode\": " << (m_fast_mode ? "true" : "false") << ",\n";
+    file << "  \"overclock_lines\": " << m_overclock_lines << "\n";
     file << "}\n";
 
     return true;
@@ -818,6 +1380,13 @@ bool GBPlugin::load_config(const char* path) {
         m_fast_mode = (content.find("true", pos) < content.find("false", pos) + 5);
     }
 
+    // Parse overclock_lines
+    pos = content.find("\"overclock_lines\":");
+    if (pos != std::string::npos) {
+        pos = content.find(':', pos);
+        m_overclock_lines = std::clamp(std::atoi(content.c_str() + pos + 1), 0, MAX_OVERCLOCK_LINES);
+    }
+
     // Apply loaded palette if using custom
     if (!m_use_custom_palette) {
         std::memcpy(m_custom_palette, s_palette_presets[m_selected_palette].colors, sizeof(m_custom_palette));
@@ -833,6 +1402,17 @@ bool GBPlugin::load_config(const char* path) {
 
 } // namespace gb
 
+#ifdef VELOCE_STATIC_CORE
+// Static build for veloce_bench, which links every core into one binary
+// and so can't use the shared C entry points below
+namespace gb {
+
+emu::IEmulatorPlugin* create_static_plugin() {
+    return new GBPlugin();
+}
+
+} // namespace gb
+#else
 // Plugin factory function - exported from shared library
 extern "C" {
     EMU_PLUGIN_EXPORT emu::IEmulatorPlugin* create_emulator_plugin() {
@@ -847,3 +1427,4 @@ extern "C" {
         return EMU_PLUGIN_API_VERSION;
     }
 }
+#endif
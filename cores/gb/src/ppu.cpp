@@ -1,5 +1,7 @@
 #include "ppu.hpp"
 #include "bus.hpp"
+#include "emu/state_writer.hpp"
+#include <algorithm>
 #include <cstring>
 
 namespace gb {
@@ -23,6 +25,7 @@ PPU::~PPU() = default;
 void PPU::reset() {
     m_vram.fill(0);
     m_oam.fill(0);
+    m_sprite_lines_height = 0;
 
     // Initialize DMG palette from default if not already set
     // (preserve user-configured palette across resets)
@@ -50,11 +53,25 @@ void PPU::reset() {
     m_ocps = 0;
     m_bg_palette.fill(0xFF);
     m_obj_palette.fill(0xFF);
+    update_cgb_colors();
 
     m_cycle = 0;
+    m_pending_cycles = 0;
     m_mode = Mode::OAMScan;
     m_window_line = 0;
     m_vram_bank = 0;
+    update_event_cycles();
+}
+
+void PPU::update_event_cycles() {
+    if (!(m_lcdc & 0x80)) {
+        m_event_cycles = SCANLINE_CYCLES;
+        return;
+    }
+    int target = SCANLINE_CYCLES;
+    if (m_mode == Mode::OAMScan) target = OAM_SCAN_CYCLES;
+    else if (m_mode == Mode::Drawing) target = OAM_SCAN_CYCLES + DRAWING_MIN_CYCLES;
+    m_event_cycles = target > m_cycle ? target - m_cycle : 1;
 }
 
 void PPU::set_mode(Mode mode) {
@@ -66,10 +83,12 @@ void PPU::set_mode(Mode mode) {
     switch (mode) {
         case Mode::HBlank:
             if (m_stat & 0x08) interrupt = true;
+            m_bus.hblank_dma();
             break;
         case Mode::VBlank:
             if (m_stat & 0x10) interrupt = true;
             m_bus.request_interrupt(0x01);  // VBlank interrupt
+            m_vblank_started = true;
             break;
         case Mode::OAMScan:
             if (m_stat & 0x20) interrupt = true;
@@ -83,83 +102,99 @@ void PPU::set_mode(Mode mode) {
     }
 }
 
-void PPU::step() {
-    // LCD off
-    if (!(m_lcdc & 0x80)) {
-        m_cycle = 0;
-        m_ly = 0;
-        m_mode = Mode::HBlank;
-        m_stat = (m_stat & 0xFC);
-        return;
-    }
-
-    m_cycle++;
-
-    switch (m_mode) {
-        case Mode::OAMScan:
-            if (m_cycle >= OAM_SCAN_CYCLES) {
-                set_mode(Mode::Drawing);
-            }
+void PPU::step(int cycles) {
+    while (cycles > 0) {
+        // LCD off
+        if (!(m_lcdc & 0x80)) {
+            m_cycle = 0;
+            m_ly = 0;
+            m_mode = Mode::HBlank;
+            m_stat = (m_stat & 0xFC);
             break;
+        }
 
-        case Mode::Drawing:
-            if (m_cycle >= OAM_SCAN_CYCLES + DRAWING_MIN_CYCLES) {
-                set_mode(Mode::HBlank);
-                render_scanline();
-            }
-            break;
+        // Nothing changes between transitions, so skip to the next one
+        update_event_cycles();
+        int advance = std::min(cycles, m_event_cycles);
+        m_cycle += advance;
+        cycles -= advance;
 
-        case Mode::HBlank:
-            if (m_cycle >= SCANLINE_CYCLES) {
-                m_cycle = 0;
-                m_ly++;
+        switch (m_mode) {
+            case Mode::OAMScan:
+                if (m_cycle >= OAM_SCAN_CYCLES) {
+                    set_mode(Mode::Drawing);
+                }
+                break;
 
-                if (m_ly >= 144) {
-                    set_mode(Mode::VBlank);
-                    m_window_line = 0;
-                } else {
-                    set_mode(Mode::OAMScan);
+            case Mode::Drawing:
+                if (m_cycle >= OAM_SCAN_CYCLES + DRAWING_MIN_CYCLES) {
+                    set_mode(Mode::HBlank);
+                    render_scanline();
                 }
+                break;
+
+            case Mode::HBlank:
+                if (m_cycle >= SCANLINE_CYCLES) {
+                    m_cycle = 0;
+                    m_ly++;
+
+                    if (m_ly >= 144) {
+                        set_mode(Mode::VBlank);
+                        m_window_line = 0;
+                    } else {
+                        set_mode(Mode::OAMScan);
+                    }
 
-                // LYC compare
-                if (m_ly == m_lyc) {
-                    m_stat |= 0x04;
-                    if (m_stat & 0x40) {
-                        m_bus.request_interrupt(0x02);
+                    // LYC compare
+                    if (m_ly == m_lyc) {
+                        m_stat |= 0x04;
+                        if (m_stat & 0x40) {
+                            m_bus.request_interrupt(0x02);
+                        }
+                    } else {
+                        m_stat &= ~0x04;
                     }
-                } else {
-                    m_stat &= ~0x04;
                 }
-            }
-            break;
+                break;
 
-        case Mode::VBlank:
-            if (m_cycle >= SCANLINE_CYCLES) {
-                m_cycle = 0;
-                m_ly++;
+            case Mode::VBlank:
+                if (m_cycle >= SCANLINE_CYCLES) {
+                    m_cycle = 0;
+                    m_ly++;
 
-                if (m_ly >= TOTAL_LINES) {
-                    m_ly = 0;
-                    set_mode(Mode::OAMScan);
-                }
+                    if (m_ly >= TOTAL_LINES) {
+                        m_ly = 0;
+                        set_mode(Mode::OAMScan);
+                    }
 
-                // LYC compare in VBlank too
-                if (m_ly == m_lyc) {
-                    m_stat |= 0x04;
-                    if (m_stat & 0x40) {
-                        m_bus.request_interrupt(0x02);
+                    // LYC compare in VBlank too
+                    if (m_ly == m_lyc) {
+                        m_stat |= 0x04;
+                        if (m_stat & 0x40) {
+                            m_bus.request_interrupt(0x02);
+                        }
+                    } else {
+                        m_stat &= ~0x04;
                     }
-                } else {
-                    m_stat &= ~0x04;
                 }
-            }
-            break;
+                break;
+        }
     }
+
+    update_event_cycles();
 }
 
 void PPU::render_scanline() {
     if (m_ly >= 144) return;
 
+    if (!m_video_enabled) {
+        // The window line counter is the only state drawing advances
+        if ((m_lcdc & 0x20) && m_wy <= m_ly && m_wx <= 166) {
+            m_window_line++;
+        }
+        return;
+    }
+
     m_bg_priority.fill(0);
 
     // Render layers
@@ -181,148 +216,100 @@ void PPU::render_scanline() {
     }
 }
 
-void PPU::render_background() {
-    bool use_tile_map_1 = m_lcdc & 0x08;
-    bool use_tile_data_1 = m_lcdc & 0x10;
-
-    uint16_t tile_map_base = use_tile_map_1 ? 0x1C00 : 0x1800;
-
-    for (int screen_x = 0; screen_x < 160; screen_x++) {
-        int map_x = (screen_x + m_scx) & 0xFF;
-        int map_y = (m_ly + m_scy) & 0xFF;
+// Tile row bitplane byte with bit i moved to bit 2*i, so that
+// lut[lo] | lut[hi] << 1 holds all 8 pixels as 2-bit color numbers with
+// the leftmost pixel on top. The second table is for horizontally
+// flipped tiles.
+const std::array<std::array<uint16_t, 256>, 2> PPU::s_tile_row_lut = [] {
+    std::array<std::array<uint16_t, 256>, 2> lut{};
+    for (int value = 0; value < 256; value++) {
+        for (int bit = 0; bit < 8; bit++) {
+            if (value & (1 << bit)) {
+                lut[0][value] |= 1 << (bit * 2);
+                lut[1][value] |= 1 << ((7 - bit) * 2);
+            }
+        }
+    }
+    return lut;
+}();
 
-        int tile_x = map_x / 8;
-        int tile_y = map_y / 8;
-        int pixel_x = map_x & 7;
-        int pixel_y = map_y & 7;
+void PPU::fetch_tile_rows(uint8_t* out, uint16_t tile_map_base, int map_y, int tile_x, int count) {
+    bool use_tile_data_1 = m_lcdc & 0x10;
+    uint16_t map_row = tile_map_base + (map_y / 8) * 32;
 
-        uint16_t tile_addr = tile_map_base + tile_y * 32 + tile_x;
+    for (int i = 0; i < count; i++, out += 8) {
+        uint16_t tile_addr = map_row + ((tile_x + i) & 31);
         uint8_t tile_num = m_vram[tile_addr];
 
         // CGB attributes (from VRAM bank 1)
-        uint8_t attr = 0;
-        int palette_num = 0;
-        bool h_flip = false;
-        bool v_flip = false;
-        bool priority = false;
-        int tile_bank = 0;
-
-        if (m_cgb_mode) {
-            attr = m_vram[0x2000 + tile_addr];
-            palette_num = attr & 0x07;
-            tile_bank = (attr >> 3) & 1;
-            h_flip = attr & 0x20;
-            v_flip = attr & 0x40;
-            priority = attr & 0x80;
-        }
+        uint8_t attr = m_cgb_mode ? m_vram[0x2000 + tile_addr] : 0;
 
-        if (h_flip) pixel_x = 7 - pixel_x;
-        if (v_flip) pixel_y = 7 - pixel_y;
+        int pixel_y = map_y & 7;
+        if (attr & 0x40) pixel_y = 7 - pixel_y;
 
-        // Get tile data address
         uint16_t tile_data_addr;
         if (use_tile_data_1) {
             tile_data_addr = tile_num * 16;
         } else {
             tile_data_addr = 0x1000 + static_cast<int8_t>(tile_num) * 16;
         }
-
-        if (m_cgb_mode && tile_bank) {
+        if (attr & 0x08) {
             tile_data_addr += 0x2000;
         }
 
-        uint8_t lo = m_vram[tile_data_addr + pixel_y * 2];
-        uint8_t hi = m_vram[tile_data_addr + pixel_y * 2 + 1];
+        const auto& lut = s_tile_row_lut[(attr >> 5) & 1];
+        uint16_t row = lut[m_vram[tile_data_addr + pixel_y * 2]] |
+                       (lut[m_vram[tile_data_addr + pixel_y * 2 + 1]] << 1);
 
-        int color_bit = 7 - pixel_x;
-        uint8_t color_num = ((hi >> color_bit) & 1) << 1 | ((lo >> color_bit) & 1);
+        // Palette in bits 2-4 and BG-to-OAM priority in bit 7, as in attr
+        uint8_t tag = ((attr & 0x07) << 2) | (attr & 0x80);
+        for (int pixel = 0; pixel < 8; pixel++) {
+            out[pixel] = ((row >> (14 - pixel * 2)) & 3) | tag;
+        }
+    }
+}
 
-        uint32_t color;
-        if (m_cgb_mode) {
-            uint16_t cgb_color = m_bg_palette[palette_num * 8 + color_num * 2] |
-                                 (m_bg_palette[palette_num * 8 + color_num * 2 + 1] << 8);
-            color = get_cgb_color(cgb_color);
-        } else {
-            uint8_t shade = (m_bgp >> (color_num * 2)) & 3;
-            color = get_dmg_color(shade);
+void PPU::draw_tile_pixels(const uint8_t* pixels, int screen_x, int count, bool use_priority) {
+    // Colors for every palette/color number combination on this line
+    uint32_t dmg_colors[4];
+    const uint32_t* colors = m_bg_colors.data();
+    if (!m_cgb_mode) {
+        for (int i = 0; i < 4; i++) {
+            dmg_colors[i] = get_dmg_color((m_bgp >> (i * 2)) & 3);
         }
+        colors = dmg_colors;
+    }
 
-        m_framebuffer[m_ly * 160 + screen_x] = color;
-        m_bg_priority[screen_x] = color_num != 0 ? (priority ? 2 : 1) : 0;
+    uint32_t* line = &m_framebuffer[m_ly * 160];
+    for (int x = screen_x; x < screen_x + count; x++) {
+        uint8_t pixel = *pixels++;
+        line[x] = colors[pixel & 0x1F];
+        m_bg_priority[x] = (pixel & 3) != 0 ? ((use_priority && (pixel & 0x80)) ? 2 : 1) : 0;
     }
 }
 
+void PPU::render_background() {
+    uint16_t tile_map_base = (m_lcdc & 0x08) ? 0x1C00 : 0x1800;
+    int map_y = (m_ly + m_scy) & 0xFF;
+
+    // 21 tiles cover the line at any fine scroll
+    uint8_t pixels[21 * 8];
+    fetch_tile_rows(pixels, tile_map_base, map_y, m_scx / 8, 21);
+    draw_tile_pixels(pixels + (m_scx & 7), 0, 160, true);
+}
+
 void PPU::render_window() {
     if (m_wx > 166) return;
 
     int window_x = m_wx - 7;
     if (window_x < 0) window_x = 0;
 
-    bool use_tile_map_1 = m_lcdc & 0x40;
-    bool use_tile_data_1 = m_lcdc & 0x10;
-
-    uint16_t tile_map_base = use_tile_map_1 ? 0x1C00 : 0x1800;
-
-    for (int screen_x = window_x; screen_x < 160; screen_x++) {
-        int win_x = screen_x - window_x;
-        int win_y = m_window_line;
-
-        int tile_x = win_x / 8;
-        int tile_y = win_y / 8;
-        int pixel_x = win_x & 7;
-        int pixel_y = win_y & 7;
-
-        uint16_t tile_addr = tile_map_base + tile_y * 32 + tile_x;
-        uint8_t tile_num = m_vram[tile_addr];
-
-        // CGB attributes
-        uint8_t attr = 0;
-        int palette_num = 0;
-        bool h_flip = false;
-        bool v_flip = false;
-        int tile_bank = 0;
-
-        if (m_cgb_mode) {
-            attr = m_vram[0x2000 + tile_addr];
-            palette_num = attr & 0x07;
-            tile_bank = (attr >> 3) & 1;
-            h_flip = attr & 0x20;
-            v_flip = attr & 0x40;
-        }
-
-        if (h_flip) pixel_x = 7 - pixel_x;
-        if (v_flip) pixel_y = 7 - pixel_y;
-
-        uint16_t tile_data_addr;
-        if (use_tile_data_1) {
-            tile_data_addr = tile_num * 16;
-        } else {
-            tile_data_addr = 0x1000 + static_cast<int8_t>(tile_num) * 16;
-        }
-
-        if (m_cgb_mode && tile_bank) {
-            tile_data_addr += 0x2000;
-        }
-
-        uint8_t lo = m_vram[tile_data_addr + pixel_y * 2];
-        uint8_t hi = m_vram[tile_data_addr + pixel_y * 2 + 1];
+    uint16_t tile_map_base = (m_lcdc & 0x40) ? 0x1C00 : 0x1800;
+    int width = 160 - window_x;
 
-        int color_bit = 7 - pixel_x;
-        uint8_t color_num = ((hi >> color_bit) & 1) << 1 | ((lo >> color_bit) & 1);
-
-        uint32_t color;
-        if (m_cgb_mode) {
-            uint16_t cgb_color = m_bg_palette[palette_num * 8 + color_num * 2] |
-                                 (m_bg_palette[palette_num * 8 + color_num * 2 + 1] << 8);
-            color = get_cgb_color(cgb_color);
-        } else {
-            uint8_t shade = (m_bgp >> (color_num * 2)) & 3;
-            color = get_dmg_color(shade);
-        }
-
-        m_framebuffer[m_ly * 160 + screen_x] = color;
-        m_bg_priority[screen_x] = color_num != 0 ? 1 : 0;
-    }
+    uint8_t pixels[20 * 8];
+    fetch_tile_rows(pixels, tile_map_base, m_window_line, 0, (width + 7) / 8);
+    draw_tile_pixels(pixels, window_x, width, false);
 
     m_window_line++;
 }
@@ -342,24 +329,23 @@ void PPU::render_sprites() {
     SpriteEntry sprites[10];
     int sprite_count = 0;
 
-    for (int i = 0; i < 40 && sprite_count < 10; i++) {
+    // The first ten in OAM order, from the line index
+    if (m_sprite_lines_height != sprite_height) {
+        build_sprite_lines(sprite_height);
+    }
+    uint64_t on_line = m_ly < 144 ? m_sprite_lines[m_ly] : 0;
+    while (on_line && sprite_count < 10) {
+        int i = __builtin_ctzll(on_line);
+        on_line &= on_line - 1;
+
         // OAM Y is stored as Y + 16, X as X + 8
         // Use signed arithmetic to properly handle sprites at screen edges
-        int y = static_cast<int>(m_oam[i * 4 + 0]) - 16;
-        int x = static_cast<int>(m_oam[i * 4 + 1]) - 8;
-        uint8_t tile = m_oam[i * 4 + 2];
-        uint8_t attr = m_oam[i * 4 + 3];
-
-        // Check if sprite is on this scanline
-        // m_ly must be >= y and < y + sprite_height
-        if (m_ly >= y && m_ly < y + sprite_height) {
-            sprites[sprite_count].x = x;
-            sprites[sprite_count].y = y;
-            sprites[sprite_count].tile = tile;
-            sprites[sprite_count].attr = attr;
-            sprites[sprite_count].oam_index = i;
-            sprite_count++;
-        }
+        sprites[sprite_count].x = static_cast<int>(m_oam[i * 4 + 1]) - 8;
+        sprites[sprite_count].y = static_cast<int>(m_oam[i * 4 + 0]) - 16;
+        sprites[sprite_count].tile = m_oam[i * 4 + 2];
+        sprites[sprite_count].attr = m_oam[i * 4 + 3];
+        sprites[sprite_count].oam_index = i;
+        sprite_count++;
     }
 
     // Sort by X coordinate (lower X = higher priority)
@@ -421,9 +407,7 @@ void PPU::render_sprites() {
 
             uint32_t color;
             if (m_cgb_mode) {
-                uint16_t cgb_color = m_obj_palette[palette_num * 8 + color_num * 2] |
-                                     (m_obj_palette[palette_num * 8 + color_num * 2 + 1] << 8);
-                color = get_cgb_color(cgb_color);
+                color = m_obj_colors[palette_num * 4 + color_num];
             } else {
                 uint8_t palette = palette_num ? m_obp1 : m_obp0;
                 uint8_t shade = (palette >> (color_num * 2)) & 3;
@@ -447,8 +431,9 @@ void PPU::get_dmg_palette(uint32_t colors[4]) const {
     std::memcpy(colors, m_dmg_palette, sizeof(m_dmg_palette));
 }
 
-uint32_t PPU::get_cgb_color(uint16_t color) {
-    // CGB: xBBBBBGGGGGRRRRR
+uint32_t PPU::get_cgb_color(const std::array<uint8_t, 64>& palette, int entry) {
+    // CGB: xBBBBBGGGGGRRRRR, little-endian
+    uint16_t color = palette[entry * 2] | (palette[entry * 2 + 1] << 8);
     uint8_t r = (color & 0x1F) << 3;
     uint8_t g = ((color >> 5) & 0x1F) << 3;
     uint8_t b = ((color >> 10) & 0x1F) << 3;
@@ -460,6 +445,13 @@ uint32_t PPU::get_cgb_color(uint16_t color) {
     return 0xFF000000 | (b << 16) | (g << 8) | r;
 }
 
+void PPU::update_cgb_colors() {
+    for (int i = 0; i < 32; i++) {
+        m_bg_colors[i] = get_cgb_color(m_bg_palette, i);
+        m_obj_colors[i] = get_cgb_color(m_obj_palette, i);
+    }
+}
+
 uint8_t PPU::read_vram(uint16_t offset) {
     if (m_cgb_mode && m_vram_bank) {
         return m_vram[0x2000 + (offset & 0x1FFF)];
@@ -475,6 +467,25 @@ void PPU::write_vram(uint16_t offset, uint8_t value) {
     }
 }
 
+void PPU::write_vram_block(uint16_t offset, const uint8_t* data, size_t size) {
+    size_t base = (m_cgb_mode && m_vram_bank) ? 0x2000 : 0;
+    std::memcpy(&m_vram[base + (offset & 0x1FFF)], data, size);
+}
+
+// Index which lines each OAM entry covers: line y holds the sprites with
+// y <= line < y + sprite_height
+void PPU::build_sprite_lines(int sprite_height) {
+    m_sprite_lines.fill(0);
+    for (int i = 0; i < 40; i++) {
+        int y = static_cast<int>(m_oam[i * 4]) - 16;
+        int end = std::min(y + sprite_height, 144);
+        for (int line = std::max(y, 0); line < end; line++) {
+            m_sprite_lines[line] |= uint64_t(1) << i;
+        }
+    }
+    m_sprite_lines_height = sprite_height;
+}
+
 uint8_t PPU::read_oam(uint16_t offset) {
     if (offset < 160) {
         return m_oam[offset];
@@ -485,9 +496,15 @@ uint8_t PPU::read_oam(uint16_t offset) {
 void PPU::write_oam(uint16_t offset, uint8_t value) {
     if (offset < 160) {
         m_oam[offset] = value;
+        m_sprite_lines_height = 0;
     }
 }
 
+void PPU::write_oam_block(const uint8_t* data) {
+    std::memcpy(m_oam.data(), data, 160);
+    m_sprite_lines_height = 0;
+}
+
 void PPU::trigger_oam_bug(uint16_t address, bool is_read) {
     // DMG OAM Corruption Bug
     // This bug occurs when a 16-bit register pair (BC, DE, HL) contains a value
@@ -511,6 +528,7 @@ void PPU::trigger_oam_bug(uint16_t address, bool is_read) {
 
     // Rows 0 and 1 are unaffected
     if (row < 2) return;
+    m_sprite_lines_height = 0;
 
     // OAM corruption works on 16-bit words within each 8-byte row
     // Each row has 4 words at offsets 0, 2, 4, 6
@@ -583,6 +601,9 @@ uint8_t PPU::read_register(uint16_t address) {
 }
 
 void PPU::write_register(uint16_t address, uint8_t value) {
+    // LCDC can stop the dot clock, so bring it up to date first
+    sync();
+
     switch (address & 0xFF) {
         case 0x40:
             m_lcdc = value;
@@ -607,19 +628,25 @@ void PPU::write_register(uint16_t address, uint8_t value) {
         case 0x68: m_bcps = value; break;
         case 0x69:
             m_bg_palette[m_bcps & 0x3F] = value;
+            m_bg_colors[(m_bcps & 0x3F) >> 1] = get_cgb_color(m_bg_palette, (m_bcps & 0x3F) >> 1);
             if (m_bcps & 0x80) m_bcps = (m_bcps & 0x80) | ((m_bcps + 1) & 0x3F);
             break;
         case 0x6A: m_ocps = value; break;
         case 0x6B:
             m_obj_palette[m_ocps & 0x3F] = value;
+            m_obj_colors[(m_ocps & 0x3F) >> 1] = get_cgb_color(m_obj_palette, (m_ocps & 0x3F) >> 1);
             if (m_ocps & 0x80) m_ocps = (m_ocps & 0x80) | ((m_ocps + 1) & 0x3F);
             break;
     }
+
+    update_event_cycles();
 }
 
-void PPU::save_state(std::vector<uint8_t>& data) {
-    data.insert(data.end(), m_vram.begin(), m_vram.end());
-    data.insert(data.end(), m_oam.begin(), m_oam.end());
+void PPU::save_state(StateWriter& data) {
+    sync();
+
+    data.write(m_vram.data(), m_vram.size());
+    data.write(m_oam.data(), m_oam.size());
 
     data.push_back(m_lcdc);
     data.push_back(m_stat);
@@ -639,8 +666,8 @@ void PPU::save_state(std::vector<uint8_t>& data) {
     data.push_back(m_window_line);
 
     if (m_cgb_mode) {
-        data.insert(data.end(), m_bg_palette.begin(), m_bg_palette.end());
-        data.insert(data.end(), m_obj_palette.begin(), m_obj_palette.end());
+        data.write(m_bg_palette.data(), m_bg_palette.size());
+        data.write(m_obj_palette.data(), m_obj_palette.size());
         data.push_back(m_bcps);
         data.push_back(m_ocps);
     }
@@ -654,6 +681,7 @@ void PPU::load_state(const uint8_t*& data, size_t& remaining) {
     std::memcpy(m_oam.data(), data, m_oam.size());
     data += m_oam.size();
     remaining -= m_oam.size();
+    m_sprite_lines_height = 0;
 
     m_lcdc = *data++; remaining--;
     m_stat = *data++; remaining--;
@@ -671,6 +699,8 @@ void PPU::load_state(const uint8_t*& data, size_t& remaining) {
     data += 2; remaining -= 2;
     m_mode = static_cast<Mode>(*data++); remaining--;
     m_window_line = *data++; remaining--;
+    m_pending_cycles = 0;
+    update_event_cycles();
 
     if (m_cgb_mode) {
         std::memcpy(m_bg_palette.data(), data, m_bg_palette.size());
@@ -683,6 +713,7 @@ void PPU::load_state(const uint8_t*& data, size_t& remaining) {
 
         m_bcps = *data++; remaining--;
         m_ocps = *data++; remaining--;
+        update_cgb_colors();
     }
 }
 
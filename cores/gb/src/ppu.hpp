@@ -1,6 +1,7 @@
 #pragma once
 
 #include "types.hpp"
+#include "emu/state_writer.hpp"
 #include <cstdint>
 #include <array>
 #include <vector>
@@ -8,6 +9,7 @@
 namespace gb {
 
 class Bus;
+using emu::StateWriter;
 
 // Game Boy PPU - 160x144 display
 class PPU {
@@ -16,18 +18,53 @@ public:
     ~PPU();
 
     void reset();
-    void step();
+
+    // Advance by T-cycles, jumping straight between mode transitions
+    void step(int cycles);
+
+    // Bank T-cycles and only run step() once the next mode change is due.
+    // Mode, LY and STAT (and the interrupts they raise) are therefore
+    // current at every instruction boundary; only the dot counter lags
+    // until sync().
+    void advance(int cycles) {
+        m_pending_cycles += cycles;
+        if (m_pending_cycles >= m_event_cycles) sync();
+    }
+    void sync() {
+        int cycles = m_pending_cycles;
+        m_pending_cycles = 0;
+        step(cycles);
+    }
+
+    // T-cycles until the next mode change or line end
+    int cycles_until_event() const { return m_event_cycles - m_pending_cycles; }
+
+    // True once after each entry into VBlank (for overclocked lines)
+    bool take_vblank_start() {
+        bool started = m_vblank_started;
+        m_vblank_started = false;
+        return started;
+    }
 
     // Set CGB mode
     void set_cgb_mode(bool cgb) { m_cgb_mode = cgb; }
     void set_vram_bank(int bank) { m_vram_bank = bank & 1; }
 
+    // Skip scanline rendering for frames that won't be shown; STAT, LY and
+    // the window line counter stay exact
+    void set_video_enabled(bool enabled) { m_video_enabled = enabled; }
+
     // Memory access
     uint8_t read_vram(uint16_t offset);
     void write_vram(uint16_t offset, uint8_t value);
     uint8_t read_oam(uint16_t offset);
     void write_oam(uint16_t offset, uint8_t value);
 
+    // DMA destinations: a block within the selected VRAM bank (offset + size
+    // must not pass 0x2000), and all of OAM
+    void write_vram_block(uint16_t offset, const uint8_t* data, size_t size);
+    void write_oam_block(const uint8_t* data);
+
     // OAM bug emulation (DMG only)
     // Called when a 16-bit register pair pointing to OAM is accessed during mode 2
     // This triggers OAM corruption on real DMG hardware
@@ -41,13 +78,19 @@ public:
     // Get framebuffer
     const uint32_t* get_framebuffer() const { return m_framebuffer.data(); }
 
+    // VRAM (both CGB banks), OAM and CGB palette memory, for memory domains
+    const uint8_t* get_vram_data() const { return m_vram.data(); }
+    const uint8_t* get_oam_data() const { return m_oam.data(); }
+    const uint8_t* get_bg_palette_data() const { return m_bg_palette.data(); }
+    const uint8_t* get_obj_palette_data() const { return m_obj_palette.data(); }
+
     // DMG palette configuration (for non-CGB games)
     // Each color is in ABGR format (0xAABBGGRR)
     void set_dmg_palette(const uint32_t colors[4]);
     void get_dmg_palette(uint32_t colors[4]) const;
 
     // Save state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
 
 private:
@@ -59,13 +102,22 @@ private:
     };
 
     void set_mode(Mode mode);
+    void update_event_cycles();
     void render_scanline();
     void render_background();
     void render_window();
+
+    // Decode 'count' tile rows from the map starting at tile_x into one
+    // byte per pixel (color number, CGB palette and priority), then
+    // resolve those to the framebuffer and BG priority line
+    void fetch_tile_rows(uint8_t* out, uint16_t tile_map_base, int map_y, int tile_x, int count);
+    void draw_tile_pixels(const uint8_t* pixels, int screen_x, int count, bool use_priority);
     void render_sprites();
+    void build_sprite_lines(int sprite_height);
 
     uint32_t get_dmg_color(uint8_t shade);
-    uint32_t get_cgb_color(uint16_t color);
+    uint32_t get_cgb_color(const std::array<uint8_t, 64>& palette, int entry);
+    void update_cgb_colors();
 
     Bus& m_bus;
 
@@ -73,6 +125,11 @@ private:
     std::array<uint8_t, 0x4000> m_vram;  // 8KB for DMG, 16KB for CGB
     std::array<uint8_t, 160> m_oam;      // 160 bytes OAM
 
+    // The sprites on each visible line, bit i for OAM entry i, rebuilt by
+    // the next render_sprites() after OAM or the sprite size changes
+    std::array<uint64_t, 144> m_sprite_lines{};
+    int m_sprite_lines_height = 0;       // 0 = needs a rebuild
+
     // Framebuffer (160x144 RGBA)
     std::array<uint32_t, 160 * 144> m_framebuffer;
 
@@ -97,20 +154,30 @@ private:
     uint8_t m_ocps = 0;     // FF6A - OBJ Palette Index
     std::array<uint8_t, 64> m_bg_palette;   // CGB BG palettes
     std::array<uint8_t, 64> m_obj_palette;  // CGB OBJ palettes
+    // The palettes above as RGBA, converted as each entry is written
+    std::array<uint32_t, 32> m_bg_colors{};
+    std::array<uint32_t, 32> m_obj_colors{};
 
     // Timing
     int m_cycle = 0;
+    int m_pending_cycles = 0;  // Banked by advance(), not yet run
+    int m_event_cycles = 0;    // Dots from m_cycle to the next transition
     Mode m_mode = Mode::OAMScan;
     int m_window_line = 0;  // Internal window line counter
 
     // State
     bool m_cgb_mode = false;
     int m_vram_bank = 0;
+    bool m_video_enabled = true;  // Host output switch, not saved
+    bool m_vblank_started = false;  // See take_vblank_start(), not saved
 
     // DMG color palette - configurable, defaults to classic greenish LCD
     uint32_t m_dmg_palette[4] = {0, 0, 0, 0};  // Zero-init so reset() can detect and set defaults
     static const uint32_t s_default_dmg_palette[4];
 
+    // Bitplane byte to interleaved 2-bit pixels, plain and h-flipped
+    static const std::array<std::array<uint16_t, 256>, 2> s_tile_row_lut;
+
     // Timing constants
     static constexpr int OAM_SCAN_CYCLES = 80;
     static constexpr int DRAWING_MIN_CYCLES = 172;
@@ -19,6 +19,14 @@ enum class GBInterrupt : uint8_t {
     Joypad   = 0x10
 };
 
+// Direct pointers to the cartridge banks currently mapped at $0000-$3FFF,
+// $4000-$7FFF and $A000-$BFFF. A null entry means the access has to go
+// through the MBC (RAM disabled, RTC registers, odd-sized images).
+struct CartridgeMap {
+    const uint8_t* rom[2] = {nullptr, nullptr};
+    uint8_t* ram = nullptr;
+};
+
 // Inline utility functions
 constexpr inline uint16_t make_u16(uint8_t lo, uint8_t hi) {
     return static_cast<uint16_t>(lo) | (static_cast<uint16_t>(hi) << 8);
@@ -1,15 +1,12 @@
 #include "apu.hpp"
 #include "debug.hpp"
+#include "emu/state_writer.hpp"
 #include <cstring>
 #include <algorithm>
 #include <cstdio>
 
 namespace gba {
 
-// Debug statistics for audio tracking
-static uint64_t s_debug_total_samples = 0;
-static uint64_t s_debug_frame_count = 0;
-
 // Duty patterns for pulse channels
 // These patterns determine when the waveform is HIGH (1) vs LOW (0)
 // The actual output will be converted to bipolar (-1 to +1) based on volume
@@ -21,6 +18,7 @@ const uint8_t APU::s_duty_table[4][8] = {
 };
 
 APU::APU() {
+    set_system_type(SystemType::GameBoy);
     m_wave.wave_ram.fill(0);
     reset();
 }
@@ -58,103 +56,262 @@ void APU::reset() {
     m_frame_counter = 0;
     m_frame_counter_step = 0;
     m_cycles = 0;
-    m_sample_counter = 0;
     m_audio_write_pos = 0;
+
+    // Reset band-limited synthesis
+    m_blip_left.clear();
+    m_blip_right.clear();
+    m_level_left = 0.0f;
+    m_level_right = 0.0f;
+    m_blip_time = 0;
+    m_mix_dirty = true;
 }
 
-void APU::step(int cycles) {
-    if (!m_enabled) return;
+void APU::set_system_type(SystemType type) {
+    m_system_type = type;
+    m_blip_left.set_rates(clock_rate(), SAMPLE_RATE);
+    m_blip_right.set_rates(clock_rate(), SAMPLE_RATE);
+    m_blip_left.clear(m_level_left);
+    m_blip_right.clear(m_level_right);
+    m_blip_time = 0;
+}
 
-    for (int i = 0; i < cycles; i++) {
-        m_frame_counter++;
+// Advance a channel timer that reloads with 'period' when it expires by
+// 'cycles' in one go, the same as that many single-cycle steps; returns
+// the number of expiries
+static int run_timer(uint16_t& timer, int period, int cycles) {
+    int first = std::max<int>(timer, 1);
+    if (cycles < first) {
+        timer -= cycles;
+        return 0;
+    }
+    int after = cycles - first;
+    timer = static_cast<uint16_t>(period - after % period);
+    return 1 + after / period;
+}
 
-        // Frame sequencer clocks at 512 Hz (every 8192 T-cycles on GB @ 4.194304 MHz)
-        // For GBA (16.78 MHz), it's every 32768 cycles
-        int frame_period = (m_system_type == SystemType::GameBoyAdvance) ? 32768 : 8192;
-        if (m_frame_counter >= frame_period) {
-            m_frame_counter -= frame_period;
-            clock_frame_sequencer();
-        }
+static int noise_period(uint8_t divisor_code, uint8_t clock_shift) {
+    // Divisor table: r=0 -> 8, else r*16. Large shifts wrap the 16-bit
+    // timer; a reload of 0 expires again on the next cycle.
+    uint16_t divisor = divisor_code == 0 ? 8 : (divisor_code * 16);
+    return std::max(static_cast<uint16_t>(divisor << clock_shift), uint16_t(1));
+}
 
-        // Step pulse 1 timer - always runs even when channel is disabled (for proper reload)
-        // Timer clocks at CPU/4 rate, but we're already in T-cycles so check every cycle
-        if (m_pulse1.timer > 0) {
-            m_pulse1.timer--;
-        }
-        if (m_pulse1.timer == 0) {
-            m_pulse1.timer = (2048 - m_pulse1.frequency) * 4;
-            m_pulse1.sequence_pos = (m_pulse1.sequence_pos + 1) & 7;
+void APU::step(int cycles) {
+    while (cycles > 0) {
+        // Register writes and FIFO samples since the last step land at the
+        // current time
+        if (m_audio_enabled && m_mix_dirty) {
+            update_mix();
         }
 
-        // Step pulse 2 timer
-        if (m_pulse2.timer > 0) {
-            m_pulse2.timer--;
+        // Run straight to the next cycle where the output can change; only
+        // that last cycle goes through the per-cycle path
+        int run = cycles;
+        if (m_audio_enabled) {
+            run = std::min(run, static_cast<int>(BLIP_FRAME_CYCLES - m_blip_time));
         }
-        if (m_pulse2.timer == 0) {
-            m_pulse2.timer = (2048 - m_pulse2.frequency) * 4;
-            m_pulse2.sequence_pos = (m_pulse2.sequence_pos + 1) & 7;
+        if (m_enabled) {
+            run = std::min(run, cycles_until_event());
+            advance_channels(run - 1);
+            clock_cycle();
         }
+        cycles -= run;
 
-        // Step wave timer - wave channel clocks at CPU/2 rate
-        if (m_wave.timer > 0) {
-            m_wave.timer--;
-        }
-        if (m_wave.timer == 0) {
-            m_wave.timer = (2048 - m_wave.frequency) * 2;
-            m_wave.position = (m_wave.position + 1) & 31;
-            uint8_t byte = m_wave.wave_ram[m_wave.position / 2];
-            m_wave.sample_buffer = (m_wave.position & 1) ? (byte & 0x0F) : (byte >> 4);
+        if (m_audio_enabled) {
+            m_blip_time += run;
+            if (m_mix_dirty) {
+                update_mix();
+            }
+            if (m_blip_time >= BLIP_FRAME_CYCLES) {
+                flush_samples();
+            }
         }
+    }
+}
+
+bool APU::pulse_audible(bool enabled, uint8_t envelope_initial, bool envelope_dir,
+                        uint8_t volume, uint8_t nr51_bits) const {
+    bool dac = (envelope_initial > 0) || envelope_dir;
+    return m_audio_enabled && enabled && dac && volume > 0 && (m_nr51 & nr51_bits);
+}
+
+bool APU::wave_audible() const {
+    return m_audio_enabled && m_wave.enabled && m_wave.dac_enabled &&
+           m_wave.volume_code > 0 && (m_nr51 & 0x44);
+}
 
-        // Step noise timer
-        if (m_noise.timer > 0) {
-            m_noise.timer--;
+bool APU::noise_audible() const {
+    return pulse_audible(m_noise.enabled, m_noise.envelope_initial, m_noise.envelope_dir,
+                         m_noise.volume, 0x88);
+}
+
+int APU::cycles_until_event() const {
+    int cycles = frame_period() - m_frame_counter;
+    if (pulse_audible(m_pulse1.enabled, m_pulse1.envelope_initial, m_pulse1.envelope_dir,
+                      m_pulse1.volume, 0x11)) {
+        cycles = std::min<int>(cycles, std::max<int>(m_pulse1.timer, 1));
+    }
+    if (pulse_audible(m_pulse2.enabled, m_pulse2.envelope_initial, m_pulse2.envelope_dir,
+                      m_pulse2.volume, 0x22)) {
+        cycles = std::min<int>(cycles, std::max<int>(m_pulse2.timer, 1));
+    }
+    if (wave_audible()) {
+        cycles = std::min<int>(cycles, std::max<int>(m_wave.timer, 1));
+    }
+    if (noise_audible()) {
+        cycles = std::min<int>(cycles, std::max<int>(m_noise.timer, 1));
+    }
+    return cycles;
+}
+
+void APU::advance_channels(int cycles) {
+    // Stays short of cycles_until_event(), so neither the frame sequencer
+    // nor an audible channel expires here
+    if (cycles <= 0) return;
+    m_frame_counter += cycles;
+
+    int fires = run_timer(m_pulse1.timer, (2048 - m_pulse1.frequency) * 4, cycles);
+    m_pulse1.sequence_pos = (m_pulse1.sequence_pos + fires) & 7;
+
+    fires = run_timer(m_pulse2.timer, (2048 - m_pulse2.frequency) * 4, cycles);
+    m_pulse2.sequence_pos = (m_pulse2.sequence_pos + fires) & 7;
+
+    fires = run_timer(m_wave.timer, (2048 - m_wave.frequency) * 2, cycles);
+    if (fires > 0) {
+        m_wave.position = (m_wave.position + fires) & 31;
+        uint8_t byte = m_wave.wave_ram[m_wave.position / 2];
+        m_wave.sample_buffer = (m_wave.position & 1) ? (byte & 0x0F) : (byte >> 4);
+    }
+
+    fires = run_timer(m_noise.timer, noise_period(m_noise.divisor_code, m_noise.clock_shift), cycles);
+    for (int i = 0; i < fires; i++) {
+        uint16_t xor_result = (m_noise.lfsr & 1) ^ ((m_noise.lfsr >> 1) & 1);
+        m_noise.lfsr = (m_noise.lfsr >> 1) | (xor_result << 14);
+        if (m_noise.width_mode) {
+            m_noise.lfsr &= ~(1 << 6);
+            m_noise.lfsr |= xor_result << 6;
         }
-        if (m_noise.timer == 0) {
-            // Divisor table: r=0 -> 8, else r*16
-            uint16_t divisor = m_noise.divisor_code == 0 ? 8 : (m_noise.divisor_code * 16);
-            m_noise.timer = divisor << m_noise.clock_shift;
-
-            // Clock LFSR - XOR bits 0 and 1
-            uint16_t xor_result = (m_noise.lfsr & 1) ^ ((m_noise.lfsr >> 1) & 1);
-            m_noise.lfsr = (m_noise.lfsr >> 1) | (xor_result << 14);
-            if (m_noise.width_mode) {
-                // 7-bit mode: also set bit 6
-                m_noise.lfsr &= ~(1 << 6);
-                m_noise.lfsr |= xor_result << 6;
-            }
+    }
+}
+
+void APU::clock_cycle() {
+    m_frame_counter++;
+
+    // Frame sequencer clocks at 512 Hz (every 8192 T-cycles on GB @ 4.194304 MHz)
+    // For GBA (16.78 MHz), it's every 32768 cycles
+    if (m_frame_counter >= frame_period()) {
+        m_frame_counter -= frame_period();
+        clock_frame_sequencer();
+        m_mix_dirty = true;
+    }
+
+    // Step pulse 1 timer - always runs even when channel is disabled (for proper reload)
+    // Timer clocks at CPU/4 rate, but we're already in T-cycles so check every cycle
+    if (m_pulse1.timer > 0) {
+        m_pulse1.timer--;
+    }
+    if (m_pulse1.timer == 0) {
+        m_pulse1.timer = (2048 - m_pulse1.frequency) * 4;
+        m_pulse1.sequence_pos = (m_pulse1.sequence_pos + 1) & 7;
+        m_mix_dirty = true;
+    }
+
+    // Step pulse 2 timer
+    if (m_pulse2.timer > 0) {
+        m_pulse2.timer--;
+    }
+    if (m_pulse2.timer == 0) {
+        m_pulse2.timer = (2048 - m_pulse2.frequency) * 4;
+        m_pulse2.sequence_pos = (m_pulse2.sequence_pos + 1) & 7;
+        m_mix_dirty = true;
+    }
+
+    // Step wave timer - wave channel clocks at CPU/2 rate
+    if (m_wave.timer > 0) {
+        m_wave.timer--;
+    }
+    if (m_wave.timer == 0) {
+        m_wave.timer = (2048 - m_wave.frequency) * 2;
+        m_wave.position = (m_wave.position + 1) & 31;
+        uint8_t byte = m_wave.wave_ram[m_wave.position / 2];
+        m_wave.sample_buffer = (m_wave.position & 1) ? (byte & 0x0F) : (byte >> 4);
+        m_mix_dirty = true;
+    }
+
+    // Step noise timer
+    if (m_noise.timer > 0) {
+        m_noise.timer--;
+    }
+    if (m_noise.timer == 0) {
+        uint16_t divisor = m_noise.divisor_code == 0 ? 8 : (m_noise.divisor_code * 16);
+        m_noise.timer = divisor << m_noise.clock_shift;
+
+        // Clock LFSR - XOR bits 0 and 1
+        uint16_t xor_result = (m_noise.lfsr & 1) ^ ((m_noise.lfsr >> 1) & 1);
+        m_noise.lfsr = (m_noise.lfsr >> 1) | (xor_result << 14);
+        if (m_noise.width_mode) {
+            // 7-bit mode: also set bit 6
+            m_noise.lfsr &= ~(1 << 6);
+            m_noise.lfsr |= xor_result << 6;
         }
+        m_mix_dirty = true;
+    }
+}
 
-        // Generate sample at target rate (~44100 Hz)
-        // GB CPU: 4194304 Hz, target: 44100 Hz -> 4194304/44100 = ~95.1 cycles per sample
-        // Use fractional accumulator for accurate timing
-        m_sample_counter += 44100;
-        int cpu_freq = (m_system_type == SystemType::GameBoyAdvance) ? 16777216 : 4194304;
-        if (m_sample_counter >= cpu_freq) {
-            m_sample_counter -= cpu_freq;
-
-            float left, right;
-            mix_output(left, right);
-
-            // If streaming callback is set, use low-latency path
-            if (m_audio_callback) {
-                m_stream_buffer[m_stream_pos * 2] = left;
-                m_stream_buffer[m_stream_pos * 2 + 1] = right;
-                m_stream_pos++;
-
-                // Flush when buffer is full (every 64 samples = ~1.5ms)
-                if (m_stream_pos >= STREAM_BUFFER_SIZE) {
-                    m_audio_callback(m_stream_buffer, m_stream_pos, 44100);
-                    m_stream_pos = 0;
-                }
-            } else {
-                // Legacy path: buffer until get_samples() is called
-                if (m_audio_write_pos < AUDIO_BUFFER_SIZE) {
-                    m_audio_buffer[m_audio_write_pos * 2] = left;
-                    m_audio_buffer[m_audio_write_pos * 2 + 1] = right;
-                    m_audio_write_pos++;
-                }
-            }
+void APU::set_audio_enabled(bool enabled) {
+    if (enabled == m_audio_enabled) return;
+    m_audio_enabled = enabled;
+    if (enabled) {
+        restart_synthesis();
+    }
+}
+
+void APU::restart_synthesis() {
+    // Restart at the current mix level
+    mix_output(m_level_left, m_level_right);
+    m_blip_left.clear(m_level_left);
+    m_blip_right.clear(m_level_right);
+    m_blip_time = 0;
+    m_mix_dirty = false;
+}
+
+void APU::update_mix() {
+    m_mix_dirty = false;
+    float left, right;
+    mix_output(left, right);
+    if (left != m_level_left) {
+        m_blip_left.add_delta(m_blip_time, left - m_level_left);
+        m_level_left = left;
+    }
+    if (right != m_level_right) {
+        m_blip_right.add_delta(m_blip_time, right - m_level_right);
+        m_level_right = right;
+    }
+}
+
+void APU::flush_samples() {
+    m_blip_left.end_frame(m_blip_time);
+    m_blip_right.end_frame(m_blip_time);
+    m_blip_time = 0;
+
+    float left_samples[512];
+    float right_samples[512];
+    size_t count = m_blip_left.read_samples(left_samples, 512);
+    m_blip_right.read_samples(right_samples, count);
+
+    for (size_t i = 0; i < count; i++) {
+        float left = std::clamp(left_samples[i], -1.0f, 1.0f);
+        float right = std::clamp(right_samples[i], -1.0f, 1.0f);
+
+        // If a stream sink is set, use low-latency path
+        if (m_stream.active()) {
+            m_stream.push(left, right);
+        } else if (m_audio_write_pos < AUDIO_BUFFER_SIZE) {
+            // Legacy path: buffer until get_samples() is called
+            m_audio_buffer[m_audio_write_pos * 2] = left;
+            m_audio_buffer[m_audio_write_pos * 2 + 1] = right;
+            m_audio_write_pos++;
         }
     }
 }
@@ -387,27 +544,11 @@ void APU::mix_output(float& left, float& right) {
         right *= dmg_scale;
 
         // Add Direct Sound channels (GBA only)
-        // Use linear interpolation between samples to reduce aliasing artifacts
-        // Direct Sound samples are signed 8-bit, normalize to -1.0 to +1.0
-
-        // Interpolation step: output_rate / typical_input_rate
-        // Most GBA games use timer rates around 16384-32768 Hz
-        // We use a fixed step that provides smooth interpolation
-        constexpr float INTERP_STEP = 0.4f;  // ~44100/16384 samples per step
-
-        // Channel A interpolation
-        DSPipe& pipe_a = m_dsound_pipe[0];
-        float t_a = std::min(pipe_a.interp_pos, 1.0f);
-        float raw_a = pipe_a.prev_sample + (pipe_a.sample - pipe_a.prev_sample) * t_a;
-        float ds_a = raw_a / 128.0f;
-        pipe_a.interp_pos += INTERP_STEP;
-
-        // Channel B interpolation
-        DSPipe& pipe_b = m_dsound_pipe[1];
-        float t_b = std::min(pipe_b.interp_pos, 1.0f);
-        float raw_b = pipe_b.prev_sample + (pipe_b.sample - pipe_b.prev_sample) * t_b;
-        float ds_b = raw_b / 128.0f;
-        pipe_b.interp_pos += INTERP_STEP;
+        // Direct Sound samples are signed 8-bit, normalize to -1.0 to +1.0.
+        // Each sample is held until the next timer overflow; the blip
+        // buffers band-limit the steps between them.
+        float ds_a = m_dsound_pipe[0].sample / 128.0f;
+        float ds_b = m_dsound_pipe[1].sample / 128.0f;
 
         // Apply volume (50% or 100%)
         if (!m_dsound_a_vol) ds_a *= 0.5f;
@@ -473,6 +614,8 @@ uint8_t APU::read_register(uint16_t address) {
 }
 
 void APU::write_register(uint16_t address, uint8_t value) {
+    m_mix_dirty = true;
+
     // If APU is disabled, only NR52 can be written
     if (!m_enabled && (address & 0xFF) != 0x26) {
         return;
@@ -638,16 +781,21 @@ void APU::write_register(uint16_t address, uint8_t value) {
 }
 
 size_t APU::get_samples(float* buffer, size_t max_samples) {
+    // Draw the partial blip frame so each call returns everything emulated so far
+    if (m_audio_enabled && m_blip_time > 0) {
+        flush_samples();
+    }
+
     size_t samples = std::min(m_audio_write_pos, max_samples);
     std::memcpy(buffer, m_audio_buffer.data(), samples * 2 * sizeof(float));
 
     // Debug logging once per second (every 60 frames)
     if (is_debug_mode()) {
-        s_debug_total_samples += samples;
-        s_debug_frame_count++;
+        m_debug_total_samples += samples;
+        m_debug_frame_count++;
 
-        if (s_debug_frame_count % 60 == 0) {
-            float avg_samples = static_cast<float>(s_debug_total_samples) / 60.0f;
+        if (m_debug_frame_count % 60 == 0) {
+            float avg_samples = static_cast<float>(m_debug_total_samples) / 60.0f;
             fprintf(stderr, "[APU] Avg samples/frame: %.1f (expected ~735 for GB)\n", avg_samples);
             fprintf(stderr, "[APU] CH1: enabled=%d vol=%d freq=%d duty=%d timer=%d\n",
                    m_pulse1.enabled, m_pulse1.volume, m_pulse1.frequency,
@@ -660,7 +808,7 @@ size_t APU::get_samples(float* buffer, size_t max_samples) {
                    m_noise.enabled, m_noise.volume, m_noise.lfsr);
             fprintf(stderr, "[APU] NR50=0x%02X NR51=0x%02X NR52=0x%02X enabled=%d\n",
                    m_nr50, m_nr51, m_nr52, m_enabled);
-            s_debug_total_samples = 0;
+            m_debug_total_samples = 0;
         }
     }
 
@@ -668,7 +816,7 @@ size_t APU::get_samples(float* buffer, size_t max_samples) {
     return samples;
 }
 
-void APU::save_state(std::vector<uint8_t>& data) {
+void APU::save_state(StateWriter& data) {
     // Save control registers
     data.push_back(m_nr50);
     data.push_back(m_nr51);
@@ -676,7 +824,7 @@ void APU::save_state(std::vector<uint8_t>& data) {
     data.push_back(m_enabled ? 1 : 0);
 
     // Save wave RAM
-    data.insert(data.end(), m_wave.wave_ram.begin(), m_wave.wave_ram.end());
+    data.write(m_wave.wave_ram.data(), m_wave.wave_ram.size());
 
     // Simplified - full state would save all channel data
 }
@@ -690,6 +838,10 @@ void APU::load_state(const uint8_t*& data, size_t& remaining) {
     std::memcpy(m_wave.wave_ram.data(), data, 16);
     data += 16;
     remaining -= 16;
+
+    if (m_audio_enabled) {
+        restart_synthesis();
+    }
 }
 
 // ============================================================================
@@ -706,6 +858,7 @@ void APU::write_fifo_b(uint32_t value) {
 
 void APU::write_soundcnt_h(uint16_t value) {
     m_soundcnt_h = value;
+    m_mix_dirty = true;
 
     // Bits 0-1: DMG volume ratio (0=25%, 1=50%, 2=100%, 3=prohibited)
     m_dmg_volume = value & 3;
@@ -778,23 +931,18 @@ void APU::consume_fifo_sample(int idx) {
             pipe.bytes_left = 4;
         } else {
             // FIFO underrun - output silence (or last sample)
-            pipe.prev_sample = pipe.sample;
             pipe.sample = 0;
-            pipe.interp_pos = 0.0f;
+            m_mix_dirty = true;
             return;
         }
     }
 
-    // Save previous sample for interpolation
-    pipe.prev_sample = pipe.sample;
-
     // Consume one byte from the pipe (samples are signed 8-bit)
     pipe.sample = static_cast<int8_t>(pipe.word & 0xFF);
     pipe.word >>= 8;
     pipe.bytes_left--;
 
-    // Reset interpolation position - we just got a new sample
-    pipe.interp_pos = 0.0f;
+    m_mix_dirty = true;
 
     // Request DMA refill when FIFO is half-empty (4 or fewer words)
     if (fifo.size() <= 4 && m_request_fifo_dma) {
@@ -802,6 +950,20 @@ void APU::consume_fifo_sample(int idx) {
     }
 }
 
+int APU::overflows_until_fifo_request(int timer_id) const {
+    int until = 0;
+    for (int idx = 0; idx < 2; idx++) {
+        if ((idx == 0 ? m_dsound_a_timer : m_dsound_b_timer) != timer_id) continue;
+
+        // consume_fifo_sample() asks once the FIFO is down to four words,
+        // which takes the pipe's bytes plus four per word above that
+        int words = m_dsound_fifo[idx].size();
+        int overflows = words <= 4 ? 1 : m_dsound_pipe[idx].bytes_left + (words - 5) * 4 + 1;
+        until = until == 0 ? overflows : std::min(until, overflows);
+    }
+    return until;
+}
+
 void APU::on_timer_overflow(int timer_id) {
     // Check if Direct Sound A uses this timer
     if (m_dsound_a_timer == timer_id) {
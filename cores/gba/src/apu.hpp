@@ -7,8 +7,14 @@
 #include <vector>
 #include <functional>
 
+#include "emu/audio_stream.hpp"
+#include "emu/blip_buffer.hpp"
+#include "emu/state_writer.hpp"
+
 namespace gba {
 
+using emu::StateWriter;
+
 // Audio Processing Unit - supports both GB and GBA
 class APU {
 public:
@@ -18,25 +24,47 @@ public:
     void reset();
     void step(int cycles);
 
-    void set_system_type(SystemType type) { m_system_type = type; }
+    void set_system_type(SystemType type);
 
     // GB audio register access
     uint8_t read_register(uint16_t address);
     void write_register(uint16_t address, uint8_t value);
 
-    // Get audio samples (legacy buffered mode)
+    // Get audio samples at get_sample_rate() (legacy buffered mode)
     size_t get_samples(float* buffer, size_t max_samples);
 
-    // Streaming audio callback - called frequently with small batches for low latency
-    // Parameters: samples (interleaved stereo), sample_count (stereo pairs), sample_rate
-    using AudioStreamCallback = std::function<void(const float*, size_t, int)>;
-    void set_audio_callback(AudioStreamCallback callback) { m_audio_callback = callback; }
+    // Rate the blip buffers synthesize at; the host converts from it
+    int get_sample_rate() const { return SAMPLE_RATE; }
+
+    // Stream samples through sink as they're produced (low-latency path);
+    // an empty sink buffers them for get_samples() instead
+    void set_audio_sink(const emu::AudioStreamSink& sink) { m_stream.set_sink(sink, SAMPLE_RATE); }
+
+    // Skip sample mixing (fast-forward, seeking); channel, length counter
+    // and FIFO state keep running exactly
+    void set_audio_enabled(bool enabled);
 
     // Save state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
 
 private:
+    // Cycles until the frame sequencer or an audible channel timer expires
+    int cycles_until_event() const;
+    void advance_channels(int cycles);
+    void clock_cycle();
+    bool pulse_audible(bool enabled, uint8_t envelope_initial, bool envelope_dir,
+                       uint8_t volume, uint8_t nr51_bits) const;
+    bool wave_audible() const;
+    bool noise_audible() const;
+
+    int frame_period() const { return m_system_type == SystemType::GameBoyAdvance ? 32768 : 8192; }
+    int clock_rate() const { return m_system_type == SystemType::GameBoyAdvance ? 16777216 : 4194304; }
+
+    void update_mix();
+    void flush_samples();
+    void restart_synthesis();
+
     void clock_frame_sequencer();
     void clock_length_counters();
     void clock_envelopes();
@@ -160,14 +188,12 @@ private:
         int size() const { return count; }
     };
 
-    // Pipeline for byte-by-byte FIFO consumption with interpolation
+    // Pipeline for byte-by-byte FIFO consumption. Each new sample enters
+    // the blip buffers as a step at the timer overflow that played it.
     struct DSPipe {
         uint32_t word = 0;
         int bytes_left = 0;
         int8_t sample = 0;        // Current sample
-        int8_t prev_sample = 0;   // Previous sample for interpolation
-        float interp_pos = 0.0f;  // Interpolation position (0.0 to 1.0)
-        float interp_step = 0.0f; // Step per output sample (based on timer rate)
     };
 
     std::array<DSFIFO, 2> m_dsound_fifo;
@@ -199,6 +225,9 @@ public:
     void write_soundcnt_h(uint16_t value);
     uint16_t read_soundcnt_h() const;
     int get_fifo_count(int idx) const { return m_dsound_fifo[idx].size(); }
+    // Overflows of timer_id until the sample one plays asks for a FIFO
+    // refill, or 0 if it feeds neither FIFO
+    int overflows_until_fifo_request(int timer_id) const;
     void set_fifo_dma_callback(std::function<void(int)> cb) { m_request_fifo_dma = cb; }
 
 private:
@@ -214,18 +243,33 @@ private:
     std::array<float, AUDIO_BUFFER_SIZE * 2> m_audio_buffer;
     size_t m_audio_write_pos = 0;
 
-    // Streaming audio callback and buffer
-    AudioStreamCallback m_audio_callback;
-    static constexpr size_t STREAM_BUFFER_SIZE = 64;  // Small buffer for low latency
-    float m_stream_buffer[STREAM_BUFFER_SIZE * 2];    // Stereo
-    size_t m_stream_pos = 0;
+    // Streaming audio
+    emu::AudioStreamWriter m_stream;
+
+    bool m_audio_enabled = true;
 
     // Timing
     int m_cycles = 0;
-    int m_sample_counter = 0;
+
+    // Band-limited synthesis, one buffer per side: the mix is only
+    // recomputed at cycles where an audible PSG channel, the frame
+    // sequencer or a Direct Sound sample changes, and level changes go into
+    // the blip buffers as steps. Silent channels are fast-forwarded.
+    static constexpr int SAMPLE_RATE = 44100;
+    static constexpr uint32_t BLIP_FRAME_CYCLES = 16384;  // ~43 samples on GBA
+    emu::BlipBuffer m_blip_left{512};
+    emu::BlipBuffer m_blip_right{512};
+    float m_level_left = 0.0f;   // Mix levels last handed to the blip buffers
+    float m_level_right = 0.0f;
+    uint32_t m_blip_time = 0;    // Cycles into the current blip frame
+    bool m_mix_dirty = true;
 
     // Duty patterns
     static const uint8_t s_duty_table[4][8];
+
+    // Sample rate statistics (DEBUG=1)
+    uint64_t m_debug_total_samples = 0;
+    uint64_t m_debug_frame_count = 0;
 };
 
 } // namespace gba
@@ -1,6 +1,8 @@
 #include "arm7tdmi.hpp"
 #include "bus.hpp"
 #include "debug.hpp"
+#include "emu/state_writer.hpp"
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <cmath>
@@ -97,6 +99,10 @@ void ARM7TDMI::reset() {
     m_last_data_addr = 0xFFFFFFFF;
     m_next_fetch_nonseq = true;  // First fetch after reset is non-sequential
 
+    flush_block_cache();
+    m_idle_head = 0;
+    m_idle_clean = false;
+
     GBA_DEBUG_PRINT("CPU Reset: PC=0x%08X, CPSR=0x%08X (mode=%s, IRQ=%s)\n",
                     m_regs[15], m_cpsr,
                     (m_mode == ProcessorMode::System) ? "System" : "Other",
@@ -109,6 +115,10 @@ int ARM7TDMI::step() {
     // If halted (either from Halt SWI or IntrWait), just pass time
     // The CPU will be woken by signal_irq() when an interrupt arrives
     if (m_halted) {
+        // Time spent halted isn't part of any loop pass
+        m_idle_head = 0;
+        m_idle_clean = false;
+
         // Decrement IRQ delay during halt (cycles still pass)
         if (m_irq_delay > 0) {
             m_irq_delay--;
@@ -172,8 +182,18 @@ int ARM7TDMI::step() {
         // Use prefetch buffer for ROM fetches, otherwise normal wait states
         int fetch_wait = prefetch_read(fetch_addr, 16);
 
-        uint16_t instruction = fetch_thumb();
-        int exec_cycles = execute_thumb(instruction);
+        int exec_cycles;
+        if (const CachedOp* op = lookup_cached_op(fetch_addr, true)) {
+            if (m_trace) trace_instruction(fetch_addr, op->instruction, true);
+            if (m_breakpoints) m_breakpoints->check(fetch_addr, emu::BREAK_EXECUTE, op->instruction & 0xFF);
+            m_regs[15] += 2;
+            exec_cycles = (this->*op->thumb)(static_cast<uint16_t>(op->instruction));
+        } else {
+            uint16_t instruction = fetch_thumb();
+            if (m_trace) trace_instruction(fetch_addr, instruction, true);
+            if (m_breakpoints) m_breakpoints->check(fetch_addr, emu::BREAK_EXECUTE, instruction & 0xFF);
+            exec_cycles = execute_thumb(instruction);
+        }
         cycles = exec_cycles + fetch_wait;
 
         // Advance prefetch buffer during execution cycles
@@ -188,8 +208,19 @@ int ARM7TDMI::step() {
         // Use prefetch buffer for ROM fetches, otherwise normal wait states
         int fetch_wait = prefetch_read(fetch_addr, 32);
 
-        uint32_t instruction = fetch_arm();
-        int exec_cycles = execute_arm(instruction);
+        int exec_cycles;
+        if (const CachedOp* op = lookup_cached_op(fetch_addr, false)) {
+            if (m_trace) trace_instruction(fetch_addr, op->instruction, false);
+            if (m_breakpoints) m_breakpoints->check(fetch_addr, emu::BREAK_EXECUTE, op->instruction & 0xFF);
+            m_regs[15] += 4;
+            exec_cycles = check_condition(op->instruction)
+                ? (this->*op->arm)(op->instruction) : 1;
+        } else {
+            uint32_t instruction = fetch_arm();
+            if (m_trace) trace_instruction(fetch_addr, instruction, false);
+            if (m_breakpoints) m_breakpoints->check(fetch_addr, emu::BREAK_EXECUTE, instruction & 0xFF);
+            exec_cycles = execute_arm(instruction);
+        }
         cycles = exec_cycles + fetch_wait;
 
         // Advance prefetch buffer during execution cycles
@@ -204,9 +235,147 @@ int ARM7TDMI::step() {
         m_irq_delay -= cycles;
     }
 
+    if (m_idle_head) {
+        if (m_last_fetch_addr - m_idle_head > m_idle_tail - m_idle_head) {
+            // Left the loop (fell through, took an IRQ or called out)
+            m_idle_head = 0;
+            m_idle_clean = false;
+            m_idle_period = 0;
+        } else {
+            m_idle_cycles += cycles;
+            if (m_regs[15] == m_idle_head) complete_idle_pass();
+        }
+    } else if (m_regs[15] < m_last_fetch_addr &&
+               m_last_fetch_addr - m_regs[15] <= IDLE_LOOP_MAX_BYTES) {
+        // Short backward branch: start watching the loop from its head
+        m_idle_head = m_regs[15];
+        m_idle_tail = m_last_fetch_addr;
+        m_idle_cycles = 0;
+        m_idle_clean = true;
+        m_idle_primed = false;
+        m_idle_period = 0;
+    }
+
     return cycles;
 }
 
+void ARM7TDMI::trace_instruction(uint32_t address, uint32_t instruction, bool thumb) {
+    emu::CpuTraceRecord& record = m_trace->append();
+    record.pc = address;
+    for (int i = 0; i < 4; i++) {
+        record.opcode[i] = static_cast<uint8_t>(instruction >> (i * 8));
+    }
+    record.arch = static_cast<uint8_t>(emu::CpuTraceArch::ARM7TDMI);
+    record.flags = thumb ? emu::CPU_TRACE_THUMB : 0;
+    for (int i = 0; i < 8; i++) {
+        record.regs[i] = m_regs[i];
+    }
+    record.regs[8] = m_regs[13];
+    record.regs[9] = m_regs[14];
+    record.regs[10] = m_cpsr;
+}
+
+int ARM7TDMI::run(int max_cycles, int& instructions) {
+    // Between syncs only the CPU changes anything: DMA and interrupts are
+    // raised by events or IO accesses, and both end the run first
+    int cycles = 0;
+    do {
+        cycles += step();
+        instructions++;
+    } while (cycles < max_cycles && !m_halted && !m_bus.is_sync_requested() &&
+             !idle_loop_period());
+    return cycles;
+}
+
+bool ARM7TDMI::IdleState::operator==(const IdleState& other) const {
+    return regs == other.regs && banked == other.banked && spsrs == other.spsrs &&
+           pipeline == other.pipeline && cpsr == other.cpsr &&
+           last_fetch_addr == other.last_fetch_addr && last_data_addr == other.last_data_addr &&
+           prefetch_head == other.prefetch_head && prefetch_next == other.prefetch_next &&
+           irq_delay == other.irq_delay && pipeline_valid == other.pipeline_valid &&
+           prefetch_count == other.prefetch_count && prefetch_countdown == other.prefetch_countdown &&
+           irq_pending == other.irq_pending && in_thumb_bl == other.in_thumb_bl &&
+           next_fetch_nonseq == other.next_fetch_nonseq && prefetch_active == other.prefetch_active &&
+           mode == other.mode && bus_events == other.bus_events;
+}
+
+ARM7TDMI::IdleState ARM7TDMI::capture_idle_state() const {
+    IdleState state;
+    state.regs = m_regs;
+    auto banked = state.banked.begin();
+    banked = std::copy(m_fiq_regs.begin(), m_fiq_regs.end(), banked);
+    banked = std::copy(m_usr_regs.begin(), m_usr_regs.end(), banked);
+    for (const auto* pair : {&m_svc_regs, &m_abt_regs, &m_irq_regs, &m_und_regs, &m_usr_sp_lr}) {
+        banked = std::copy(pair->begin(), pair->end(), banked);
+    }
+    state.spsrs = {m_spsr_fiq, m_spsr_svc, m_spsr_abt, m_spsr_irq, m_spsr_und};
+    state.pipeline = {m_pipeline[0], m_pipeline[1]};
+    state.cpsr = m_cpsr;
+    state.last_fetch_addr = m_last_fetch_addr;
+    state.last_data_addr = m_last_data_addr;
+    state.prefetch_head = m_prefetch.head_address;
+    state.prefetch_next = m_prefetch.next_address;
+    state.irq_delay = m_irq_delay;
+    state.pipeline_valid = m_pipeline_valid;
+    state.prefetch_count = m_prefetch.count;
+    state.prefetch_countdown = m_prefetch.countdown;
+    state.irq_pending = m_irq_pending;
+    state.in_thumb_bl = m_in_thumb_bl;
+    state.next_fetch_nonseq = m_next_fetch_nonseq;
+    state.prefetch_active = m_prefetch.active;
+    state.mode = m_mode;
+    state.bus_events = m_bus.get_event_count();
+    return state;
+}
+
+void ARM7TDMI::complete_idle_pass() {
+    m_idle_period = 0;
+    if (m_idle_clean) {
+        prefetch_sync();
+        IdleState state = capture_idle_state();
+        if (m_idle_primed && state == m_idle_state) {
+            m_idle_period = m_idle_cycles;
+        }
+        m_idle_state = state;
+        m_idle_primed = true;
+    } else {
+        m_idle_primed = false;
+    }
+    m_idle_clean = true;
+    m_idle_cycles = 0;
+}
+
+void ARM7TDMI::note_idle_read(uint32_t address) {
+    switch (address >> 24) {
+        case 0x02:  // EWRAM
+        case 0x03:  // IWRAM
+        case 0x05:  // Palette
+        case 0x06:  // VRAM
+        case 0x07:  // OAM
+            return;
+        case 0x04:
+            // Registers that only change on bus events or CPU writes
+            switch (address & 0x00FFFFFE) {
+                case 0x000: case 0x004: case 0x006:           // DISPCNT, DISPSTAT, VCOUNT
+                case 0x130: case 0x132:                       // KEYINPUT, KEYCNT
+                case 0x200: case 0x202: case 0x204: case 0x208:  // IE, IF, WAITCNT, IME
+                    return;
+            }
+            break;
+        case 0x08: case 0x09: case 0x0A: case 0x0B:
+            // ROM, except the GPIO port
+            if ((address & 0x1FFFFFF) - 0xC4 >= 6) return;
+            break;
+    }
+    m_idle_clean = false;
+}
+
+int ARM7TDMI::idle_loop_period() const {
+    if (!m_idle_period || m_regs[15] != m_idle_head) return 0;
+    if (m_bus.get_event_count() != m_idle_state.bus_events) return 0;
+    return m_idle_period;
+}
+
 void ARM7TDMI::signal_irq() {
     // Only start the delay if we don't already have an IRQ pending
     // This prevents resetting the delay counter on every call
@@ -225,28 +394,34 @@ void ARM7TDMI::signal_irq() {
 }
 
 uint8_t ARM7TDMI::read8(uint32_t address) {
+    if (m_idle_clean) note_idle_read(address);
     return m_bus.read8(address);
 }
 
 uint16_t ARM7TDMI::read16(uint32_t address) {
     address &= ~1u;  // Force alignment
+    if (m_idle_clean) note_idle_read(address);
     return m_bus.read16(address);
 }
 
 uint32_t ARM7TDMI::read32(uint32_t address) {
     address &= ~3u;  // Force alignment
+    if (m_idle_clean) note_idle_read(address);
     return m_bus.read32(address);
 }
 
 void ARM7TDMI::write8(uint32_t address, uint8_t value) {
+    m_idle_clean = false;
     m_bus.write8(address, value);
 }
 
 void ARM7TDMI::write16(uint32_t address, uint16_t value) {
+    m_idle_clean = false;
     m_bus.write16_unaligned(address, value);
 }
 
 void ARM7TDMI::write32(uint32_t address, uint32_t value) {
+    m_idle_clean = false;
     m_bus.write32_unaligned(address, value);
 }
 
@@ -305,13 +480,23 @@ void ARM7TDMI::prefetch_invalidate() {
 }
 
 void ARM7TDMI::prefetch_step(int cycles) {
-    // Don't fill if prefetch is disabled
-    if (!m_bus.is_prefetch_enabled()) {
-        return;
+    m_prefetch.pending += cycles;
+    if (m_prefetch.pending >= PREFETCH_PENDING_LIMIT) {
+        prefetch_sync();
     }
+}
+
+// Applies the pending cycles as one fill: the first halfword arrives when
+// the countdown runs out, each further one duty cycles later, until the
+// buffer holds 8 or the fetch reaches a 128KB boundary, where the GBA
+// forces non-sequential timing and the prefetcher stops. The result is the
+// same however the cycles were split up.
+void ARM7TDMI::prefetch_sync() {
+    int cycles = m_prefetch.pending;
+    m_prefetch.pending = 0;
 
-    // Need a valid next_address to prefetch from
-    if (!m_prefetch.active) {
+    // Don't fill if prefetch is disabled, or with no valid next_address
+    if (!m_bus.is_prefetch_enabled() || !m_prefetch.active) {
         return;
     }
 
@@ -326,42 +511,34 @@ void ARM7TDMI::prefetch_step(int cycles) {
         return;
     }
 
-    // Get the duty cycle (S wait states) for the current ROM region
-    int duty = m_bus.get_prefetch_duty(m_prefetch.next_address);
-
-    // Use the cycles to fill the buffer
     m_prefetch.countdown -= cycles;
+    if (m_prefetch.countdown > 0) {
+        return;
+    }
 
-    while (m_prefetch.countdown <= 0 && m_prefetch.count < 8) {
-        // Check for 128KB boundary crossing
-        // The GBA forces non-sequential timing at each 128KB ROM boundary
-        // The prefetcher stops at these boundaries (acts as full)
-        uint32_t current_block = m_prefetch.next_address & 0x1FFFF;  // Within 128KB block
-        if (current_block == 0 && m_prefetch.count > 0) {
-            // We've reached a 128KB boundary, stop prefetching
-            m_prefetch.countdown = 0;
-            break;
-        }
-
-        // One halfword filled
-        m_prefetch.count++;
-        m_prefetch.next_address += 2;
+    // Halfwords that fit before the buffer is full or the boundary is hit
+    uint32_t block_offset = m_prefetch.next_address & 0x1FFFF;  // Within 128KB block
+    if (block_offset == 0 && m_prefetch.count > 0) {
+        m_prefetch.countdown = 0;
+        return;
+    }
+    int limit = 8 - m_prefetch.count;
+    if (block_offset != 0) {
+        limit = std::min<int>(limit, (0x20000 - block_offset) / 2);
+    }
 
-        // Check if next address crosses 128KB boundary
-        uint32_t next_block = m_prefetch.next_address & 0x1FFFF;
+    // Get the duty cycle (S wait states) for the current ROM region
+    int duty = m_bus.get_prefetch_duty(m_prefetch.next_address);
+    int filled = duty > 0 ? 1 + (-m_prefetch.countdown) / duty : limit;
 
-        // Reset countdown for next halfword if buffer not full and valid
-        if (m_prefetch.count < 8 && is_rom_address(m_prefetch.next_address) && next_block != 0) {
-            m_prefetch.countdown += duty;
-        } else if (m_prefetch.count < 8 && is_rom_address(m_prefetch.next_address) && next_block == 0) {
-            // Stop at boundary - don't continue prefetching
-            m_prefetch.countdown = 0;
-            break;
-        } else {
-            m_prefetch.countdown = 0;
-            break;
-        }
+    if (filled >= limit) {
+        filled = limit;
+        m_prefetch.countdown = 0;
+    } else {
+        m_prefetch.countdown += filled * duty;
     }
+    m_prefetch.count += filled;
+    m_prefetch.next_address += filled * 2;
 }
 
 int ARM7TDMI::prefetch_read(uint32_t address, int size) {
@@ -372,6 +549,8 @@ int ARM7TDMI::prefetch_read(uint32_t address, int size) {
         return m_bus.get_wait_states(address, is_sequential, size);
     }
 
+    prefetch_sync();
+
     // Calculate how many halfwords we need (1 for Thumb/16-bit, 2 for ARM/32-bit)
     int halfwords_needed = (size == 32) ? 2 : 1;
 
@@ -454,6 +633,132 @@ int ARM7TDMI::data_access_cycles(uint32_t address, int access_size, bool is_writ
     return wait;
 }
 
+// ============================================================================
+// Block Cache
+// ============================================================================
+
+bool ARM7TDMI::is_cacheable(uint32_t address) const {
+    uint32_t region = address >> 24;
+    // EWRAM and IWRAM: invalidated through invalidate_code() on writes.
+    // Pages that keep getting rewritten under cached code are left to the
+    // interpreter, which is cheaper than decoding them again every time.
+    if (region == 0x02 || region == 0x03) {
+        return m_code_page_flushes[code_page(address)] < CODE_PAGE_MAX_FLUSHES;
+    }
+    // ROM WS0/WS1, except the GPIO ports at 0xC4-0xC9 which are read live.
+    // BIOS fetches update the BIOS open-bus latch and WS2 may be EEPROM, so
+    // both keep going through the bus.
+    if (region >= 0x08 && region <= 0x0B) return (address & 0x1FFFFFF) - 0xC4 >= 6;
+    return false;
+}
+
+const ARM7TDMI::CachedOp* ARM7TDMI::lookup_cached_op(uint32_t address, bool thumb) {
+    uint32_t size = thumb ? 2 : 4;
+
+    // Straight-line execution continues in the current block
+    if (m_block && address == m_block_pc && m_block->thumb == thumb &&
+        m_block_index < m_block->ops.size()) {
+        m_block_pc += size;
+        return &m_block->ops[m_block_index++];
+    }
+
+    m_block = nullptr;
+    if (!is_cacheable(address)) {
+        return nullptr;
+    }
+
+    auto it = m_blocks.find(address | (thumb ? 1u : 0u));
+    CachedBlock* block = (it != m_blocks.end() && is_block_valid(it->second))
+        ? &it->second : &build_block(address, thumb);
+
+    m_block = block;
+    m_block_index = 1;
+    m_block_pc = address + size;
+    return &block->ops[0];
+}
+
+ARM7TDMI::CachedBlock& ARM7TDMI::build_block(uint32_t address, bool thumb) {
+    if (m_blocks.size() >= BLOCK_CACHE_LIMIT) {
+        flush_block_cache();
+    }
+
+    CachedBlock& block = m_blocks[address | (thumb ? 1u : 0u)];
+    block.ops.clear();
+    block.thumb = thumb;
+
+    // Decode until the first instruction that can leave the run
+    uint32_t size = thumb ? 2 : 4;
+    uint32_t pc = address;
+    uint32_t last = address;
+    while (block.ops.size() < BLOCK_MAX_OPS && is_cacheable(pc)) {
+        CachedOp op;
+        bool ends;
+        if (thumb) {
+            uint16_t instruction = read16(pc);
+            op.thumb = decode_thumb(instruction);
+            op.instruction = instruction;
+            ends = thumb_ends_block(instruction, op.thumb);
+        } else {
+            uint32_t instruction = read32(pc);
+            op.arm = decode_arm(instruction);
+            op.instruction = instruction;
+            ends = arm_ends_block(instruction, op.arm);
+        }
+        block.ops.push_back(op);
+        last = pc;
+        pc += size;
+        if (ends) break;
+    }
+
+    // A block is at most 128 bytes, so it touches at most two code pages
+    uint32_t region = address >> 24;
+    block.in_ram = region == 0x02 || region == 0x03;
+    if (block.in_ram) {
+        uint32_t pages[2] = {code_page(address), code_page(last)};
+        for (int i = 0; i < 2; i++) {
+            block.pages[i] = static_cast<uint16_t>(pages[i]);
+            block.gens[i] = m_code_page_gen[pages[i]];
+            m_code_pages[pages[i]] = 1;
+        }
+    }
+
+    return block;
+}
+
+bool ARM7TDMI::is_block_valid(const CachedBlock& block) const {
+    return !block.in_ram ||
+           (block.gens[0] == m_code_page_gen[block.pages[0]] &&
+            block.gens[1] == m_code_page_gen[block.pages[1]]);
+}
+
+void ARM7TDMI::flush_code_page(uint32_t page) {
+    // Blocks from this page go stale; they are rebuilt on their next lookup
+    m_code_pages[page] = 0;
+    m_code_page_gen[page]++;
+    if (m_code_page_flushes[page] < CODE_PAGE_MAX_FLUSHES) {
+        m_code_page_flushes[page]++;
+    }
+    m_block = nullptr;
+}
+
+void ARM7TDMI::invalidate_ram_code() {
+    // Not counted as self-modifying code: the pages were replaced wholesale
+    for (uint32_t page = 0; page < CODE_PAGES; page++) {
+        if (m_code_pages[page]) {
+            m_code_pages[page] = 0;
+            m_code_page_gen[page]++;
+        }
+    }
+    m_block = nullptr;
+}
+
+void ARM7TDMI::flush_block_cache() {
+    m_blocks.clear();
+    m_block = nullptr;
+    m_code_pages.fill(0);
+    m_code_page_flushes.fill(0);
+}
+
 bool ARM7TDMI::check_condition(uint32_t instruction) {
     Condition cond = static_cast<Condition>((instruction >> 28) & 0xF);
 
@@ -489,71 +794,79 @@ int ARM7TDMI::execute_arm(uint32_t instruction) {
         return 1;  // 1 cycle for skipped instruction
     }
 
-    // Decode instruction class
-    uint32_t op = (instruction >> 25) & 0x7;
-    uint32_t op2 = (instruction >> 4) & 0xF;
-
-    // Decode based on bits [27:25] and [7:4]
-    switch (op) {
-        case 0b000:
-            if ((instruction & 0x0FFFFFF0) == 0x012FFF10) {
-                return arm_branch_exchange(instruction);
-            }
-            if ((op2 & 0x9) == 0x9) {
-                if ((instruction & 0x0FC000F0) == 0x00000090) {
-                    return arm_multiply(instruction);
-                }
-                if ((instruction & 0x0F8000F0) == 0x00800090) {
-                    return arm_multiply_long(instruction);
-                }
-                if ((instruction & 0x0FB00FF0) == 0x01000090) {
-                    return arm_swap(instruction);
-                }
-                return arm_halfword_data_transfer(instruction);
-            }
-            if ((instruction & 0x0FBF0FFF) == 0x010F0000) {
-                return arm_mrs(instruction);
-            }
-            if ((instruction & 0x0DB0F000) == 0x0120F000) {
-                return arm_msr(instruction);
-            }
-            return arm_data_processing(instruction);
-
-        case 0b001:
-            if ((instruction & 0x0FBF0FFF) == 0x010F0000) {
-                return arm_mrs(instruction);
-            }
-            if ((instruction & 0x0DB0F000) == 0x0120F000) {
-                return arm_msr(instruction);
-            }
-            return arm_data_processing(instruction);
-
-        case 0b010:
-        case 0b011:
-            if (op == 0b011 && (instruction & 0x10)) {
-                return arm_undefined(instruction);
-            }
-            return arm_single_data_transfer(instruction);
+    return (this->*decode_arm(instruction))(instruction);
+}
 
-        case 0b100:
-            return arm_block_data_transfer(instruction);
+ARM7TDMI::ArmHandler ARM7TDMI::decode_arm(uint32_t instruction) const {
+    // The table index can't tell these apart from their neighbours; their
+    // remaining bits decide, checked in the same order as the class decode
+    if ((instruction & 0x0FFFFFF0) == 0x012FFF10) {
+        return &ARM7TDMI::arm_branch_exchange;
+    }
+    if ((instruction & 0x0FB00FF0) == 0x01000090) {
+        return &ARM7TDMI::arm_swap;
+    }
+    if ((instruction & 0x0FBF0FFF) == 0x010F0000) {
+        return &ARM7TDMI::arm_mrs;
+    }
+    if ((instruction & 0x0DB0F000) == 0x0120F000 && (instruction & 0x02000090) != 0x00000090) {
+        return &ARM7TDMI::arm_msr;
+    }
 
-        case 0b101:
-            return arm_branch(instruction);
+    return s_arm_table[((instruction >> 16) & 0xFF0) | ((instruction >> 4) & 0xF)];
+}
 
-        case 0b110:
-            // Coprocessor data transfer - not used on GBA
-            return 1;
+template <size_t Index>
+constexpr ARM7TDMI::ArmHandler ARM7TDMI::arm_table_entry() {
+    // Representative instruction carrying the indexed bits 27-20 and 7-4
+    constexpr uint32_t instruction = ((Index >> 4) << 20) | ((Index & 0xF) << 4);
+    constexpr uint32_t op = (instruction >> 25) & 0x7;
+    constexpr uint32_t op2 = (instruction >> 4) & 0xF;
 
-        case 0b111:
-            if (instruction & (1 << 24)) {
-                return arm_software_interrupt(instruction);
-            }
-            // Coprocessor operations - not used on GBA
-            return 1;
+    // Decode based on bits [27:25] and [7:4]
+    if constexpr (op == 0b000 && (op2 & 0x9) == 0x9) {
+        if constexpr ((instruction & 0x0FC000F0) == 0x00000090) {
+            return &ARM7TDMI::arm_multiply;
+        } else if constexpr ((instruction & 0x0F8000F0) == 0x00800090) {
+            return &ARM7TDMI::arm_multiply_long;
+        } else {
+            return &ARM7TDMI::arm_halfword_data_transfer;
+        }
+    } else if constexpr (op == 0b000 || op == 0b001) {
+        return &ARM7TDMI::arm_data_processing<(instruction >> 21) & 0xF,
+                                              ((instruction >> 20) & 1) != 0,
+                                              op == 0b001,
+                                              op == 0b000 && (instruction & 0x10) != 0>;
+    } else if constexpr (op == 0b011 && (instruction & 0x10)) {
+        return &ARM7TDMI::arm_undefined;
+    } else if constexpr (op == 0b010 || op == 0b011) {
+        return &ARM7TDMI::arm_single_data_transfer;
+    } else if constexpr (op == 0b100) {
+        return &ARM7TDMI::arm_block_data_transfer;
+    } else if constexpr (op == 0b101) {
+        return &ARM7TDMI::arm_branch;
+    } else if constexpr (op == 0b111 && (instruction & (1 << 24))) {
+        return &ARM7TDMI::arm_software_interrupt;
+    } else {
+        // Coprocessor transfers and operations - not used on GBA
+        return &ARM7TDMI::arm_coprocessor;
     }
+}
 
-    return arm_undefined(instruction);
+bool ARM7TDMI::arm_ends_block(uint32_t instruction, ArmHandler handler) {
+    // Close the block after anything that can move PC or change state
+    if (handler == &ARM7TDMI::arm_branch ||
+        handler == &ARM7TDMI::arm_branch_exchange ||
+        handler == &ARM7TDMI::arm_software_interrupt ||
+        handler == &ARM7TDMI::arm_msr ||
+        handler == &ARM7TDMI::arm_undefined) {
+        return true;
+    }
+    if (handler == &ARM7TDMI::arm_block_data_transfer) {
+        return (instruction & (1u << 15)) != 0;  // PC in the register list
+    }
+    // Rd == PC for data processing and loads
+    return ((instruction >> 12) & 0xF) == 15;
 }
 
 uint32_t ARM7TDMI::arm_shift(uint32_t value, int shift_type, int amount, bool& carry_out, bool reg_shift) {
@@ -677,9 +990,10 @@ int ARM7TDMI::arm_branch_exchange(uint32_t instruction) {
     return 3;
 }
 
+template <uint32_t Opcode, bool SetFlags, bool Immediate, bool RegShift>
 int ARM7TDMI::arm_data_processing(uint32_t instruction) {
-    uint32_t opcode = (instruction >> 21) & 0xF;
-    bool set_flags = (instruction >> 20) & 1;
+    constexpr uint32_t opcode = Opcode;
+    constexpr bool set_flags = SetFlags;
     uint32_t rn = (instruction >> 16) & 0xF;
     uint32_t rd = (instruction >> 12) & 0xF;
 
@@ -687,9 +1001,9 @@ int ARM7TDMI::arm_data_processing(uint32_t instruction) {
     // We need to process this first to know if it's a register shift (affects PC reading)
     uint32_t op2;
     bool carry_out = (m_cpsr & FLAG_C) != 0;
-    bool reg_shift = false;
+    constexpr bool reg_shift = RegShift;
 
-    if (instruction & (1 << 25)) {
+    if constexpr (Immediate) {
         // Immediate operand
         uint32_t imm = instruction & 0xFF;
         int rotate = ((instruction >> 8) & 0xF) * 2;
@@ -703,9 +1017,8 @@ int ARM7TDMI::arm_data_processing(uint32_t instruction) {
         int shift_type = (instruction >> 5) & 3;
         int shift_amount;
 
-        if (instruction & (1 << 4)) {
+        if constexpr (RegShift) {
             // Shift by register
-            reg_shift = true;
             uint32_t rs = (instruction >> 8) & 0xF;
             shift_amount = m_regs[rs] & 0xFF;
         } else {
@@ -1126,9 +1439,8 @@ int ARM7TDMI::arm_block_data_transfer(uint32_t instruction) {
                     m_regs[i] = value;
                     // Debug: if loading garbage into SP, dump the context
                     if (i == 13 && (value < 0x03000000 || value >= 0x03008000)) {
-                        static bool sp_ldm_logged = false;
-                        if (!sp_ldm_logged) {
-                            sp_ldm_logged = true;
+                        if (!m_debug_sp_ldm_logged) {
+                            m_debug_sp_ldm_logged = true;
                             GBA_DEBUG_PRINT("=== LDM loading invalid SP ===\n");
                             GBA_DEBUG_PRINT("  Instruction: 0x%08X (P=%d, U=%d, S=%d, W=%d, L=%d)\n",
                                            instruction, pre, up, psr, writeback, load);
@@ -1252,8 +1564,7 @@ int ARM7TDMI::arm_swap(uint32_t instruction) {
 int ARM7TDMI::arm_software_interrupt(uint32_t instruction) {
     // GBA uses the comment field bits [23:16] for the function number in ARM mode
     uint8_t function = (instruction >> 16) & 0xFF;
-    hle_bios_call(function);
-    return 3;
+    return 3 + hle_bios_call(function);
 }
 
 int ARM7TDMI::arm_mrs(uint32_t instruction) {
@@ -1308,76 +1619,106 @@ int ARM7TDMI::arm_undefined(uint32_t instruction) {
     return 3;
 }
 
+int ARM7TDMI::arm_coprocessor(uint32_t instruction) {
+    (void)instruction;
+    return 1;  // No coprocessors on the GBA
+}
+
 // Thumb instruction execution
 int ARM7TDMI::execute_thumb(uint16_t instruction) {
-    // Decode based on upper bits
-    uint16_t op = instruction >> 13;
-
-    switch (op) {
-        case 0b000:
-            if ((instruction & 0x1800) == 0x1800) {
-                return thumb_add_subtract(instruction);
-            }
-            return thumb_move_shifted(instruction);
-
-        case 0b001:
-            return thumb_immediate(instruction);
-
-        case 0b010:
-            // Check for PC-relative load first (0x4800-0x4FFF, bit 11 set)
-            if ((instruction & 0x1800) == 0x0800) {
-                return thumb_pc_relative_load(instruction);
-            }
-            // Then check for ALU / hi-reg operations (0x4000-0x47FF)
-            if ((instruction & 0x1000) == 0) {
-                if ((instruction & 0x0C00) == 0x0000) {
-                    return thumb_alu(instruction);
-                }
-                return thumb_hi_reg_bx(instruction);
-            }
-            // Load/store with register offset (0x5000-0x5FFF)
-            if ((instruction & 0x0200) == 0) {
-                return thumb_load_store_reg(instruction);
-            }
-            return thumb_load_store_sign(instruction);
-
-        case 0b011:
-            return thumb_load_store_imm(instruction);
-
-        case 0b100:
-            if ((instruction & 0x1000) == 0) {
-                return thumb_load_store_half(instruction);
-            }
-            return thumb_sp_relative_load_store(instruction);
+    return (this->*decode_thumb(instruction))(instruction);
+}
 
-        case 0b101:
-            if ((instruction & 0x1000) == 0) {
-                return thumb_load_address(instruction);
-            }
-            if ((instruction & 0x0F00) == 0x0000) {
-                return thumb_add_sp(instruction);
-            }
-            return thumb_push_pop(instruction);
+ARM7TDMI::ThumbHandler ARM7TDMI::decode_thumb(uint16_t instruction) const {
+    return s_thumb_table[instruction >> 6];
+}
 
-        case 0b110:
-            if ((instruction & 0x1000) == 0) {
-                return thumb_multiple_load_store(instruction);
-            }
-            if ((instruction & 0x0F00) == 0x0F00) {
-                return thumb_software_interrupt(instruction);
-            }
-            return thumb_conditional_branch(instruction);
+template <size_t Index>
+constexpr ARM7TDMI::ThumbHandler ARM7TDMI::thumb_table_entry() {
+    // Representative instruction carrying the indexed bits 15-6
+    constexpr uint16_t instruction = static_cast<uint16_t>(Index << 6);
+    constexpr uint16_t op = instruction >> 13;
 
-        case 0b111:
-            if ((instruction & 0x1800) == 0x0000) {
-                return thumb_unconditional_branch(instruction);
-            }
-            return thumb_long_branch(instruction);
+    if constexpr (op == 0b000) {
+        if constexpr ((instruction & 0x1800) == 0x1800) {
+            return &ARM7TDMI::thumb_add_subtract;
+        } else {
+            return &ARM7TDMI::thumb_move_shifted;
+        }
+    } else if constexpr (op == 0b001) {
+        return &ARM7TDMI::thumb_immediate;
+    } else if constexpr (op == 0b010) {
+        // PC-relative load (0x4800-0x4FFF), then ALU / hi-reg (0x4000-0x47FF),
+        // then load/store with register offset (0x5000-0x5FFF)
+        if constexpr ((instruction & 0x1800) == 0x0800) {
+            return &ARM7TDMI::thumb_pc_relative_load;
+        } else if constexpr ((instruction & 0x1000) == 0 && (instruction & 0x0C00) == 0x0000) {
+            return &ARM7TDMI::thumb_alu<(instruction >> 6) & 0xF>;
+        } else if constexpr ((instruction & 0x1000) == 0) {
+            return &ARM7TDMI::thumb_hi_reg_bx;
+        } else if constexpr ((instruction & 0x0200) == 0) {
+            return &ARM7TDMI::thumb_load_store_reg;
+        } else {
+            return &ARM7TDMI::thumb_load_store_sign;
+        }
+    } else if constexpr (op == 0b011) {
+        return &ARM7TDMI::thumb_load_store_imm;
+    } else if constexpr (op == 0b100) {
+        if constexpr ((instruction & 0x1000) == 0) {
+            return &ARM7TDMI::thumb_load_store_half;
+        } else {
+            return &ARM7TDMI::thumb_sp_relative_load_store;
+        }
+    } else if constexpr (op == 0b101) {
+        if constexpr ((instruction & 0x1000) == 0) {
+            return &ARM7TDMI::thumb_load_address;
+        } else if constexpr ((instruction & 0x0F00) == 0x0000) {
+            return &ARM7TDMI::thumb_add_sp;
+        } else {
+            return &ARM7TDMI::thumb_push_pop;
+        }
+    } else if constexpr (op == 0b110) {
+        if constexpr ((instruction & 0x1000) == 0) {
+            return &ARM7TDMI::thumb_multiple_load_store;
+        } else if constexpr ((instruction & 0x0F00) == 0x0F00) {
+            return &ARM7TDMI::thumb_software_interrupt;
+        } else {
+            return &ARM7TDMI::thumb_conditional_branch;
+        }
+    } else {
+        if constexpr ((instruction & 0x1800) == 0x0000) {
+            return &ARM7TDMI::thumb_unconditional_branch;
+        } else {
+            return &ARM7TDMI::thumb_long_branch;
+        }
     }
+}
 
-    return 1;
+bool ARM7TDMI::thumb_ends_block(uint16_t instruction, ThumbHandler handler) {
+    // Close the block after anything that can move PC or change state
+    if (handler == &ARM7TDMI::thumb_conditional_branch ||
+        handler == &ARM7TDMI::thumb_unconditional_branch ||
+        handler == &ARM7TDMI::thumb_long_branch ||
+        handler == &ARM7TDMI::thumb_software_interrupt) {
+        return true;
+    }
+    if (handler == &ARM7TDMI::thumb_hi_reg_bx) {
+        uint16_t op = (instruction >> 8) & 3;
+        uint16_t rd = (instruction & 7) | ((instruction >> 4) & 8);
+        return op == 3 || rd == 15;  // BX, or a hi-register op writing PC
+    }
+    if (handler == &ARM7TDMI::thumb_push_pop) {
+        return (instruction & 0x0900) == 0x0900;  // POP {..., PC}
+    }
+    return false;
 }
 
+const std::array<ARM7TDMI::ArmHandler, ARM7TDMI::ARM_TABLE_SIZE> ARM7TDMI::s_arm_table =
+    ARM7TDMI::make_arm_table(std::make_index_sequence<ARM7TDMI::ARM_TABLE_SIZE>{});
+
+const std::array<ARM7TDMI::ThumbHandler, ARM7TDMI::THUMB_TABLE_SIZE> ARM7TDMI::s_thumb_table =
+    ARM7TDMI::make_thumb_table(std::make_index_sequence<ARM7TDMI::THUMB_TABLE_SIZE>{});
+
 int ARM7TDMI::thumb_move_shifted(uint16_t instruction) {
     uint16_t op = (instruction >> 11) & 3;
     uint16_t offset = (instruction >> 6) & 0x1F;
@@ -1477,8 +1818,9 @@ int ARM7TDMI::thumb_immediate(uint16_t instruction) {
     return 1;
 }
 
+template <uint32_t Op>
 int ARM7TDMI::thumb_alu(uint16_t instruction) {
-    uint16_t op = (instruction >> 6) & 0xF;
+    constexpr uint16_t op = Op;
     uint16_t rs = (instruction >> 3) & 7;
     uint16_t rd = instruction & 7;
 
@@ -1962,8 +2304,7 @@ int ARM7TDMI::thumb_conditional_branch(uint16_t instruction) {
 int ARM7TDMI::thumb_software_interrupt(uint16_t instruction) {
     // GBA uses the comment field bits [7:0] for the function number in Thumb mode
     uint8_t function = instruction & 0xFF;
-    hle_bios_call(function);
-    return 3;
+    return 3 + hle_bios_call(function);
 }
 
 int ARM7TDMI::thumb_unconditional_branch(uint16_t instruction) {
@@ -2257,42 +2598,42 @@ uint32_t ARM7TDMI::get_register(int reg) const {
     return 0;
 }
 
-void ARM7TDMI::save_state(std::vector<uint8_t>& data) {
+void ARM7TDMI::save_state(StateWriter& data) {
     // Save registers
     for (int i = 0; i < 16; i++) {
         const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&m_regs[i]);
-        data.insert(data.end(), ptr, ptr + 4);
+        data.write(ptr, 4);
     }
 
     // Save banked registers
     for (const auto& reg : m_fiq_regs) {
         const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&reg);
-        data.insert(data.end(), ptr, ptr + 4);
+        data.write(ptr, 4);
     }
     for (const auto& reg : m_svc_regs) {
         const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&reg);
-        data.insert(data.end(), ptr, ptr + 4);
+        data.write(ptr, 4);
     }
     for (const auto& reg : m_abt_regs) {
         const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&reg);
-        data.insert(data.end(), ptr, ptr + 4);
+        data.write(ptr, 4);
     }
     for (const auto& reg : m_irq_regs) {
         const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&reg);
-        data.insert(data.end(), ptr, ptr + 4);
+        data.write(ptr, 4);
     }
     for (const auto& reg : m_und_regs) {
         const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&reg);
-        data.insert(data.end(), ptr, ptr + 4);
+        data.write(ptr, 4);
     }
 
     // Save CPSR and SPSRs
     const uint8_t* cpsr_ptr = reinterpret_cast<const uint8_t*>(&m_cpsr);
-    data.insert(data.end(), cpsr_ptr, cpsr_ptr + 4);
+    data.write(cpsr_ptr, 4);
 
     for (uint32_t spsr : {m_spsr_fiq, m_spsr_svc, m_spsr_abt, m_spsr_irq, m_spsr_und}) {
         const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&spsr);
-        data.insert(data.end(), ptr, ptr + 4);
+        data.write(ptr, 4);
     }
 
     // Save state flags
@@ -2306,27 +2647,34 @@ void ARM7TDMI::save_state(std::vector<uint8_t>& data) {
     // Save IntrWait state
     data.push_back(m_in_intr_wait ? 1 : 0);
     const uint8_t* flags_ptr = reinterpret_cast<const uint8_t*>(&m_intr_wait_flags);
-    data.insert(data.end(), flags_ptr, flags_ptr + 2);
+    data.write(flags_ptr, 2);
     const uint8_t* pc_ptr = reinterpret_cast<const uint8_t*>(&m_intr_wait_return_pc);
-    data.insert(data.end(), pc_ptr, pc_ptr + 4);
+    data.write(pc_ptr, 4);
     const uint8_t* cpsr_ptr2 = reinterpret_cast<const uint8_t*>(&m_intr_wait_return_cpsr);
-    data.insert(data.end(), cpsr_ptr2, cpsr_ptr2 + 4);
+    data.write(cpsr_ptr2, 4);
 
     // Save prefetch buffer state
+    prefetch_sync();
     const uint8_t* prefetch_head = reinterpret_cast<const uint8_t*>(&m_prefetch.head_address);
-    data.insert(data.end(), prefetch_head, prefetch_head + 4);
+    data.write(prefetch_head, 4);
     const uint8_t* prefetch_next = reinterpret_cast<const uint8_t*>(&m_prefetch.next_address);
-    data.insert(data.end(), prefetch_next, prefetch_next + 4);
+    data.write(prefetch_next, 4);
     data.push_back(static_cast<uint8_t>(m_prefetch.count));
     data.push_back(static_cast<uint8_t>(m_prefetch.countdown));
     data.push_back(m_prefetch.active ? 1 : 0);
 
     // Save last fetch address
     const uint8_t* last_fetch = reinterpret_cast<const uint8_t*>(&m_last_fetch_addr);
-    data.insert(data.end(), last_fetch, last_fetch + 4);
+    data.write(last_fetch, 4);
 }
 
 void ARM7TDMI::load_state(const uint8_t*& data, size_t& remaining) {
+    // Cached blocks stay: ROM can't change, and the bus drops the work
+    // RAM ones when it restores work RAM
+    m_block = nullptr;
+    m_idle_head = 0;
+    m_idle_clean = false;
+
     // Load registers
     for (int i = 0; i < 16; i++) {
         std::memcpy(&m_regs[i], data, 4);
@@ -2406,6 +2754,7 @@ void ARM7TDMI::load_state(const uint8_t*& data, size_t& remaining) {
         m_prefetch.count = *data++; remaining--;
         m_prefetch.countdown = static_cast<int8_t>(*data++); remaining--;
         m_prefetch.active = *data++ != 0; remaining--;
+        m_prefetch.pending = 0;
         std::memcpy(&m_last_fetch_addr, data, 4); data += 4; remaining -= 4;
     } else if (remaining >= 10) {
         // Old format without next_address and active
@@ -2414,6 +2763,7 @@ void ARM7TDMI::load_state(const uint8_t*& data, size_t& remaining) {
         m_prefetch.count = *data++; remaining--;
         m_prefetch.countdown = static_cast<int8_t>(*data++); remaining--;
         m_prefetch.active = m_prefetch.count > 0;
+        m_prefetch.pending = 0;
         std::memcpy(&m_last_fetch_addr, data, 4); data += 4; remaining -= 4;
     } else {
         // Old save state without prefetch data
@@ -2426,8 +2776,61 @@ void ARM7TDMI::load_state(const uint8_t*& data, size_t& remaining) {
 // HLE BIOS Functions
 // ============================================================================
 
-void ARM7TDMI::hle_bios_call(uint8_t function) {
+// Approximate BIOS timings. The BIOS runs from 32-bit zero-wait ROM, so its
+// instructions cost about a cycle each; memory accesses are charged
+// separately through bios_access() at the wait states of the region hit.
+namespace {
+constexpr int BIOS_SWI_OVERHEAD = 25;  // Dispatch through the SWI table and return
+
+int bit_length(uint32_t value) {
+    int bits = 0;
+    for (; value; value >>= 1) bits++;
+    return bits;
+}
+}
+
+// One data access by the BIOS: a cycle plus the region's wait states
+void ARM7TDMI::bios_access(uint32_t address, int access_size) {
+    bool sequential = address == m_bios_last_access + access_size / 8;
+    m_bios_last_access = address;
+    m_bios_cycles += 1 + m_bus.get_wait_states(address, sequential, access_size);
+}
+
+uint8_t ARM7TDMI::bios_read8(uint32_t address) {
+    bios_access(address, 8);
+    return read8(address);
+}
+
+uint16_t ARM7TDMI::bios_read16(uint32_t address) {
+    bios_access(address, 16);
+    return read16(address);
+}
+
+uint32_t ARM7TDMI::bios_read32(uint32_t address) {
+    bios_access(address, 32);
+    return read32(address);
+}
+
+void ARM7TDMI::bios_write8(uint32_t address, uint8_t value) {
+    bios_access(address, 8);
+    write8(address, value);
+}
+
+void ARM7TDMI::bios_write16(uint32_t address, uint16_t value) {
+    bios_access(address, 16);
+    write16(address, value);
+}
+
+void ARM7TDMI::bios_write32(uint32_t address, uint32_t value) {
+    bios_access(address, 32);
+    write32(address, value);
+}
+
+int ARM7TDMI::hle_bios_call(uint8_t function) {
     GBA_DEBUG_PRINT("BIOS call: 0x%02X at PC=0x%08X\n", function, m_regs[15]);
+    m_idle_clean = false;  // BIOS functions touch the bus directly
+    m_bios_cycles = BIOS_SWI_OVERHEAD;
+    m_bios_last_access = 0;
     switch (function) {
         case 0x00:  // SoftReset
             bios_soft_reset();
@@ -2442,31 +2845,31 @@ void ARM7TDMI::hle_bios_call(uint8_t function) {
             // bit 0 - Clear 256K EWRAM (0x02000000-0x0203FFFF)
             if (flags & 0x01) {
                 for (uint32_t addr = 0x02000000; addr < 0x02040000; addr += 4) {
-                    m_bus.write32(addr, 0);
+                    bios_write32(addr, 0);
                 }
             }
             // bit 1 - Clear 32K IWRAM (0x03000000-0x03007FFF), except last 512 bytes (stack area)
             if (flags & 0x02) {
                 for (uint32_t addr = 0x03000000; addr < 0x03007E00; addr += 4) {
-                    m_bus.write32(addr, 0);
+                    bios_write32(addr, 0);
                 }
             }
             // bit 2 - Clear Palette (0x05000000-0x050003FF)
             if (flags & 0x04) {
                 for (uint32_t addr = 0x05000000; addr < 0x05000400; addr += 4) {
-                    m_bus.write32(addr, 0);
+                    bios_write32(addr, 0);
                 }
             }
             // bit 3 - Clear VRAM (0x06000000-0x06017FFF)
             if (flags & 0x08) {
                 for (uint32_t addr = 0x06000000; addr < 0x06018000; addr += 4) {
-                    m_bus.write32(addr, 0);
+                    bios_write32(addr, 0);
                 }
             }
             // bit 4 - Clear OAM (0x07000000-0x070003FF)
             if (flags & 0x10) {
                 for (uint32_t addr = 0x07000000; addr < 0x07000400; addr += 4) {
-                    m_bus.write32(addr, 0);
+                    bios_write32(addr, 0);
                 }
             }
             // bits 5-7: SIO, Sound, other registers - not implemented for now
@@ -2499,16 +2902,16 @@ void ARM7TDMI::hle_bios_call(uint8_t function) {
 
                 // If R0 != 0, discard old flags (clear them from BIOS mirror)
                 if (m_regs[0] != 0) {
-                    uint16_t flags = read16(0x03007FF8);
+                    uint16_t flags = bios_read16(0x03007FF8);
                     flags &= ~m_intr_wait_flags;
-                    write16(0x03007FF8, flags);
+                    bios_write16(0x03007FF8, flags);
                     GBA_DEBUG_PRINT("IntrWait: Cleared old flags, BIOS_IF now=0x%04X\n", flags);
                 } else {
                     // R0 == 0: Check if flag is already set
-                    uint16_t flags = read16(0x03007FF8);
+                    uint16_t flags = bios_read16(0x03007FF8);
                     if (flags & m_intr_wait_flags) {
                         // Flag already set, clear it and return immediately
-                        write16(0x03007FF8, flags & ~m_intr_wait_flags);
+                        bios_write16(0x03007FF8, flags & ~m_intr_wait_flags);
                         GBA_DEBUG_PRINT("IntrWait: Flag already set! Returning immediately\n");
                         break;
                     }
@@ -2530,9 +2933,9 @@ void ARM7TDMI::hle_bios_call(uint8_t function) {
                 GBA_DEBUG_PRINT("VBlankIntrWait: Called\n");
 
                 // Clear VBlank flag from BIOS IRQ mirror
-                uint16_t flags = read16(0x03007FF8);
+                uint16_t flags = bios_read16(0x03007FF8);
                 flags &= ~0x0001;  // Clear VBlank flag
-                write16(0x03007FF8, flags);
+                bios_write16(0x03007FF8, flags);
 
                 // Enter IntrWait state waiting for VBlank
                 m_in_intr_wait = true;
@@ -2650,6 +3053,7 @@ void ARM7TDMI::hle_bios_call(uint8_t function) {
     // the value at address 0x188+8=0x190: 0xE3A02004 (mov r2, #4)
     // This is what real BIOS would have in its prefetch after returning from SWI
     m_bus.set_last_bios_read(0xE3A02004);
+    return m_bios_cycles;
 }
 
 void ARM7TDMI::bios_div() {
@@ -2658,6 +3062,15 @@ void ARM7TDMI::bios_div() {
     int32_t num = static_cast<int32_t>(m_regs[0]);
     int32_t den = static_cast<int32_t>(m_regs[1]);
 
+    // Shift-and-subtract: 13 cycles per quotient bit, plus sign handling
+    uint32_t abs_num = num < 0 ? 0u - static_cast<uint32_t>(num) : static_cast<uint32_t>(num);
+    uint32_t abs_den = den < 0 ? 0u - static_cast<uint32_t>(den) : static_cast<uint32_t>(den);
+    int quotient_bits = 1;
+    if (abs_num > abs_den && abs_den != 0) {
+        quotient_bits += bit_length(abs_num) - bit_length(abs_den);
+    }
+    m_bios_cycles += 11 + 13 * quotient_bits;
+
     if (den == 0) {
         // Division by zero - undefined behavior, return something reasonable
         m_regs[0] = (num < 0) ? 1 : -1;
@@ -2679,6 +3092,9 @@ void ARM7TDMI::bios_sqrt() {
     // Returns: R0 = sqrt(R0)
     uint32_t val = m_regs[0];
 
+    // One 12-cycle iteration per result bit
+    m_bios_cycles += 16 + 12 * ((bit_length(val) + 1) / 2);
+
     if (val == 0) {
         m_regs[0] = 0;
         return;
@@ -2699,6 +3115,7 @@ void ARM7TDMI::bios_arctan() {
     // R0 = tan value (signed 16-bit fixed point, 1.14)
     // Returns: R0 = arctan result (-0x4000 to 0x4000)
     int16_t tan = static_cast<int16_t>(m_regs[0]);
+    m_bios_cycles += 40;  // Fixed-length polynomial
 
     // Polynomial approximation
     // arctan(x) ≈ x - x³/3 + x⁵/5 - ...
@@ -2723,6 +3140,9 @@ void ARM7TDMI::bios_arctan2() {
     int16_t x = static_cast<int16_t>(m_regs[0]);
     int16_t y = static_cast<int16_t>(m_regs[1]);
 
+    // Octant reduction, a Div of the smaller side by the larger and ArcTan
+    m_bios_cycles += 30 + 11 + 13 * 15 + 40;
+
     if (x == 0 && y == 0) {
         m_regs[0] = 0;
         return;
@@ -2748,18 +3168,27 @@ void ARM7TDMI::bios_cpu_set() {
     bool is_32bit = (cnt & (1 << 26)) != 0;
     uint32_t count = cnt & 0x1FFFFF;
 
+    // Loop overhead per unit; a fill loads its value once up front
+    m_bios_cycles += 20 + count * (fixed_src ? 3 : 5);
+
     if (is_32bit) {
+        uint32_t val = fixed_src ? bios_read32(src) : 0;
         for (uint32_t i = 0; i < count; i++) {
-            uint32_t val = read32(src);
-            write32(dst, val);
-            if (!fixed_src) src += 4;
+            if (!fixed_src) {
+                val = bios_read32(src);
+                src += 4;
+            }
+            bios_write32(dst, val);
             dst += 4;
         }
     } else {
+        uint16_t val = fixed_src ? bios_read16(src) : 0;
         for (uint32_t i = 0; i < count; i++) {
-            uint16_t val = read16(src);
-            write16(dst, val);
-            if (!fixed_src) src += 2;
+            if (!fixed_src) {
+                val = bios_read16(src);
+                src += 2;
+            }
+            bios_write16(dst, val);
             dst += 2;
         }
     }
@@ -2778,11 +3207,23 @@ void ARM7TDMI::bios_cpu_fast_set() {
     // Round up to multiple of 8
     count = (count + 7) & ~7u;
 
-    for (uint32_t i = 0; i < count; i++) {
-        uint32_t val = read32(src);
-        write32(dst, val);
-        if (!fixed_src) src += 4;
-        dst += 4;
+    m_bios_cycles += 20 + count / 8 * 6;
+
+    // Blocks of 8 words go through LDMIA/STMIA, so all but the first word
+    // of each burst is sequential. A fill loads its value once up front.
+    uint32_t block[8];
+    if (fixed_src) std::fill(block, block + 8, bios_read32(src));
+    for (uint32_t i = 0; i < count; i += 8) {
+        if (!fixed_src) {
+            for (uint32_t& word : block) {
+                word = bios_read32(src);
+                src += 4;
+            }
+        }
+        for (uint32_t word : block) {
+            bios_write32(dst, word);
+            dst += 4;
+        }
     }
 }
 
@@ -2866,14 +3307,15 @@ void ARM7TDMI::bios_bg_affine_set() {
 
     for (uint32_t i = 0; i < count; i++) {
         // Read source data
-        int32_t orig_center_x = static_cast<int32_t>(read32(src));
-        int32_t orig_center_y = static_cast<int32_t>(read32(src + 4));
-        int16_t display_center_x = static_cast<int16_t>(read16(src + 8));
-        int16_t display_center_y = static_cast<int16_t>(read16(src + 10));
-        int16_t scale_x = static_cast<int16_t>(read16(src + 12));
-        int16_t scale_y = static_cast<int16_t>(read16(src + 14));
-        uint16_t angle = read16(src + 16);
+        int32_t orig_center_x = static_cast<int32_t>(bios_read32(src));
+        int32_t orig_center_y = static_cast<int32_t>(bios_read32(src + 4));
+        int16_t display_center_x = static_cast<int16_t>(bios_read16(src + 8));
+        int16_t display_center_y = static_cast<int16_t>(bios_read16(src + 10));
+        int16_t scale_x = static_cast<int16_t>(bios_read16(src + 12));
+        int16_t scale_y = static_cast<int16_t>(bios_read16(src + 14));
+        uint16_t angle = bios_read16(src + 16);
         src += 20;
+        m_bios_cycles += 50;  // Sine table lookups and eight multiplies
 
         // Calculate sin/cos from angle (angle is 0-0xFFFF for full circle)
         // GBA BIOS only uses the upper 8 bits for the angle
@@ -2907,12 +3349,12 @@ void ARM7TDMI::bios_bg_affine_set() {
         int32_t start_y = orig_center_y - (display_center_x * pc + display_center_y * pd);
 
         // Write destination data
-        write16(dst, static_cast<uint16_t>(pa));
-        write16(dst + 2, static_cast<uint16_t>(pb));
-        write16(dst + 4, static_cast<uint16_t>(pc));
-        write16(dst + 6, static_cast<uint16_t>(pd));
-        write32(dst + 8, static_cast<uint32_t>(start_x));
-        write32(dst + 12, static_cast<uint32_t>(start_y));
+        bios_write16(dst, static_cast<uint16_t>(pa));
+        bios_write16(dst + 2, static_cast<uint16_t>(pb));
+        bios_write16(dst + 4, static_cast<uint16_t>(pc));
+        bios_write16(dst + 6, static_cast<uint16_t>(pd));
+        bios_write32(dst + 8, static_cast<uint32_t>(start_x));
+        bios_write32(dst + 12, static_cast<uint32_t>(start_y));
         dst += 16;
     }
 }
@@ -2929,10 +3371,11 @@ void ARM7TDMI::bios_obj_affine_set() {
 
     for (uint32_t i = 0; i < count; i++) {
         // Read source data: sx, sy, angle (each 16-bit)
-        int16_t sx = static_cast<int16_t>(read16(src));
-        int16_t sy = static_cast<int16_t>(read16(src + 2));
-        uint16_t angle = read16(src + 4);
+        int16_t sx = static_cast<int16_t>(bios_read16(src));
+        int16_t sy = static_cast<int16_t>(bios_read16(src + 2));
+        uint16_t angle = bios_read16(src + 4);
         src += 8;
+        m_bios_cycles += 35;  // Sine table lookups and four multiplies
 
         // Calculate sin/cos from angle (angle is 0-0xFFFF for full circle)
         double rad = (angle / 65536.0) * 2.0 * 3.14159265358979;
@@ -2949,10 +3392,10 @@ void ARM7TDMI::bios_obj_affine_set() {
         // Write affine parameters using R3 as the offset between each parameter
         // For standard OAM: offset=8 (writes to OAM+6, OAM+14, OAM+22, OAM+30)
         // For custom buffer: offset=2 (writes consecutive 16-bit values)
-        write16(dst, static_cast<uint16_t>(pa));
-        write16(dst + offset, static_cast<uint16_t>(pb));
-        write16(dst + offset * 2, static_cast<uint16_t>(pc));
-        write16(dst + offset * 3, static_cast<uint16_t>(pd));
+        bios_write16(dst, static_cast<uint16_t>(pa));
+        bios_write16(dst + offset, static_cast<uint16_t>(pb));
+        bios_write16(dst + offset * 2, static_cast<uint16_t>(pc));
+        bios_write16(dst + offset * 3, static_cast<uint16_t>(pd));
 
         dst += offset * 4;  // Move to next group of 4 parameters
     }
@@ -2964,10 +3407,10 @@ void ARM7TDMI::bios_bit_unpack() {
     uint32_t dst = m_regs[1];
     uint32_t info = m_regs[2];
 
-    uint16_t src_len = read16(info);
-    uint8_t src_width = read8(info + 2);
-    uint8_t dst_width = read8(info + 3);
-    uint32_t data_offset = read32(info + 4);
+    uint16_t src_len = bios_read16(info);
+    uint8_t src_width = bios_read8(info + 2);
+    uint8_t dst_width = bios_read8(info + 3);
+    uint32_t data_offset = bios_read32(info + 4);
 
     bool zero_flag = (data_offset >> 31) != 0;
     data_offset &= 0x7FFFFFFF;
@@ -2979,10 +3422,12 @@ void ARM7TDMI::bios_bit_unpack() {
 
     for (uint16_t i = 0; i < src_len; i++) {
         // Read source byte
-        src_buffer = read8(src++);
+        src_buffer = bios_read8(src++);
         src_bits_left = 8;
 
         while (src_bits_left >= src_width) {
+            m_bios_cycles += 8;
+
             // Extract bits
             uint32_t val = src_buffer & ((1 << src_width) - 1);
             src_buffer >>= src_width;
@@ -2999,7 +3444,7 @@ void ARM7TDMI::bios_bit_unpack() {
 
             // Flush when we have 32 bits
             if (dst_bits_filled >= 32) {
-                write32(dst, dst_buffer);
+                bios_write32(dst, dst_buffer);
                 dst += 4;
                 dst_buffer = 0;
                 dst_bits_filled = 0;
@@ -3009,7 +3454,7 @@ void ARM7TDMI::bios_bit_unpack() {
 
     // Flush remaining bits
     if (dst_bits_filled > 0) {
-        write32(dst, dst_buffer);
+        bios_write32(dst, dst_buffer);
     }
 }
 
@@ -3019,31 +3464,35 @@ void ARM7TDMI::bios_lz77_uncomp_wram() {
     uint32_t dst = m_regs[1];
 
     // Read header
-    uint32_t header = read32(src);
+    uint32_t header = bios_read32(src);
     src += 4;
 
     uint32_t decomp_size = header >> 8;
     uint32_t decomp_end = dst + decomp_size;
 
     while (dst < decomp_end) {
-        uint8_t flags = read8(src++);
+        uint8_t flags = bios_read8(src++);
+        m_bios_cycles += 6;
 
         for (int i = 0; i < 8 && dst < decomp_end; i++) {
+            m_bios_cycles += 4;
             if (flags & 0x80) {
                 // Compressed - read offset/length
-                uint8_t b1 = read8(src++);
-                uint8_t b2 = read8(src++);
+                uint8_t b1 = bios_read8(src++);
+                uint8_t b2 = bios_read8(src++);
 
                 uint32_t len = ((b1 >> 4) & 0xF) + 3;
                 uint32_t offset = ((b1 & 0xF) << 8) | b2;
 
                 uint32_t src_ptr = dst - offset - 1;
+                m_bios_cycles += 8;
                 for (uint32_t j = 0; j < len && dst < decomp_end; j++) {
-                    write8(dst++, read8(src_ptr++));
+                    m_bios_cycles += 3;
+                    bios_write8(dst++, bios_read8(src_ptr++));
                 }
             } else {
                 // Uncompressed
-                write8(dst++, read8(src++));
+                bios_write8(dst++, bios_read8(src++));
             }
             flags <<= 1;
         }
@@ -3056,7 +3505,7 @@ void ARM7TDMI::bios_lz77_uncomp_vram() {
     uint32_t src = m_regs[0];
     uint32_t dst_start = m_regs[1];
 
-    uint32_t header = read32(src);
+    uint32_t header = bios_read32(src);
     src += 4;
 
     uint32_t decomp_size = header >> 8;
@@ -3071,24 +3520,31 @@ void ARM7TDMI::bios_lz77_uncomp_vram() {
     uint32_t dst_pos = 0;
 
     while (dst_pos < decomp_size) {
-        uint8_t flags = read8(src++);
+        uint8_t flags = bios_read8(src++);
+        m_bios_cycles += 6;
 
         for (int i = 0; i < 8 && dst_pos < decomp_size; i++) {
+            m_bios_cycles += 4;
             if (flags & 0x80) {
                 // Compressed - read offset/length
-                uint8_t b1 = read8(src++);
-                uint8_t b2 = read8(src++);
+                uint8_t b1 = bios_read8(src++);
+                uint8_t b2 = bios_read8(src++);
 
                 uint32_t len = ((b1 >> 4) & 0xF) + 3;
                 uint32_t offset = ((b1 & 0xF) << 8) | b2;
 
+                // The BIOS reads each byte back from VRAM a halfword at a
+                // time and merges it into its write buffer
                 uint32_t src_ptr = dst_pos - offset - 1;
+                m_bios_cycles += 8;
                 for (uint32_t j = 0; j < len && dst_pos < decomp_size; j++) {
+                    bios_access(dst_start + (src_ptr & ~1u), 16);
+                    m_bios_cycles += 6;
                     temp_buffer[dst_pos++] = temp_buffer[src_ptr++];
                 }
             } else {
                 // Uncompressed
-                temp_buffer[dst_pos++] = read8(src++);
+                temp_buffer[dst_pos++] = bios_read8(src++);
             }
             flags <<= 1;
         }
@@ -3097,13 +3553,13 @@ void ARM7TDMI::bios_lz77_uncomp_vram() {
     // Now write to VRAM in 16-bit units
     uint32_t dst = dst_start;
     for (uint32_t i = 0; i + 1 < decomp_size; i += 2) {
-        write16(dst, temp_buffer[i] | (temp_buffer[i + 1] << 8));
+        bios_write16(dst, temp_buffer[i] | (temp_buffer[i + 1] << 8));
         dst += 2;
     }
     // Handle odd byte if present
     if (decomp_size & 1) {
         // Last odd byte - write as 16-bit with 0 padding (hardware behavior)
-        write16(dst, temp_buffer[decomp_size - 1]);
+        bios_write16(dst, temp_buffer[decomp_size - 1]);
     }
 }
 
@@ -3112,14 +3568,14 @@ void ARM7TDMI::bios_huff_uncomp() {
     uint32_t src = m_regs[0];
     uint32_t dst = m_regs[1];
 
-    uint32_t header = read32(src);
+    uint32_t header = bios_read32(src);
     src += 4;
 
     uint8_t data_size = header & 0xF;  // Bits per symbol (4 or 8)
     uint32_t decomp_size = header >> 8;
 
     // Read tree size and tree data
-    uint8_t tree_size = read8(src++);
+    uint8_t tree_size = bios_read8(src++);
     uint32_t tree_start = src;
     src = tree_start + (tree_size + 1) * 2;
 
@@ -3132,14 +3588,15 @@ void ARM7TDMI::bios_huff_uncomp() {
     for (uint32_t written = 0; written < decomp_size;) {
         // Refill bit buffer
         while (bits_left < 16 && src < m_regs[0] + 0x10000) {
-            bits |= read8(src++) << bits_left;
+            bits |= bios_read8(src++) << bits_left;
             bits_left += 8;
         }
 
         // Traverse tree
         uint32_t node_offset = tree_start;
         while (true) {
-            uint8_t node = read8(node_offset);
+            uint8_t node = bios_read8(node_offset);
+            m_bios_cycles += 8;
             bool is_data = (node & ((bits & 1) ? 0x80 : 0x40)) != 0;
             uint8_t offset = node & 0x3F;
 
@@ -3148,12 +3605,12 @@ void ARM7TDMI::bios_huff_uncomp() {
 
             if (is_data) {
                 // Read data
-                uint8_t data = read8(tree_start + (offset + 1) * 2 + ((bits & 1) ? 1 : 0));
+                uint8_t data = bios_read8(tree_start + (offset + 1) * 2 + ((bits & 1) ? 1 : 0));
                 out_buffer |= data << out_bits;
                 out_bits += data_size;
 
                 if (out_bits >= 32) {
-                    write32(dst, out_buffer);
+                    bios_write32(dst, out_buffer);
                     dst += 4;
                     written += 4;
                     out_buffer = 0;
@@ -3172,27 +3629,30 @@ void ARM7TDMI::bios_rl_uncomp_wram() {
     uint32_t src = m_regs[0];
     uint32_t dst = m_regs[1];
 
-    uint32_t header = read32(src);
+    uint32_t header = bios_read32(src);
     src += 4;
 
     uint32_t decomp_size = header >> 8;
     uint32_t decomp_end = dst + decomp_size;
 
     while (dst < decomp_end) {
-        uint8_t flag = read8(src++);
+        uint8_t flag = bios_read8(src++);
+        m_bios_cycles += 8;
 
         if (flag & 0x80) {
             // Compressed run
             uint8_t len = (flag & 0x7F) + 3;
-            uint8_t data = read8(src++);
+            uint8_t data = bios_read8(src++);
             for (int i = 0; i < len && dst < decomp_end; i++) {
-                write8(dst++, data);
+                m_bios_cycles += 3;
+                bios_write8(dst++, data);
             }
         } else {
             // Uncompressed run
             uint8_t len = (flag & 0x7F) + 1;
             for (int i = 0; i < len && dst < decomp_end; i++) {
-                write8(dst++, read8(src++));
+                m_bios_cycles += 3;
+                bios_write8(dst++, bios_read8(src++));
             }
         }
     }
@@ -3203,7 +3663,7 @@ void ARM7TDMI::bios_rl_uncomp_vram() {
     uint32_t src = m_regs[0];
     uint32_t dst = m_regs[1];
 
-    uint32_t header = read32(src);
+    uint32_t header = bios_read32(src);
     src += 4;
 
     uint32_t decomp_size = header >> 8;
@@ -3213,15 +3673,17 @@ void ARM7TDMI::bios_rl_uncomp_vram() {
     int buf_pos = 0;
 
     while (dst < decomp_end) {
-        uint8_t flag = read8(src++);
+        uint8_t flag = bios_read8(src++);
+        m_bios_cycles += 8;
 
         if (flag & 0x80) {
             uint8_t len = (flag & 0x7F) + 3;
-            uint8_t data = read8(src++);
+            uint8_t data = bios_read8(src++);
             for (int i = 0; i < len && dst < decomp_end; i++) {
+                m_bios_cycles += 4;
                 buffer[buf_pos++] = data;
                 if (buf_pos == 2) {
-                    write16(dst, buffer[0] | (buffer[1] << 8));
+                    bios_write16(dst, buffer[0] | (buffer[1] << 8));
                     dst += 2;
                     buf_pos = 0;
                 }
@@ -3229,9 +3691,10 @@ void ARM7TDMI::bios_rl_uncomp_vram() {
         } else {
             uint8_t len = (flag & 0x7F) + 1;
             for (int i = 0; i < len && dst < decomp_end; i++) {
-                buffer[buf_pos++] = read8(src++);
+                m_bios_cycles += 4;
+                buffer[buf_pos++] = bios_read8(src++);
                 if (buf_pos == 2) {
-                    write16(dst, buffer[0] | (buffer[1] << 8));
+                    bios_write16(dst, buffer[0] | (buffer[1] << 8));
                     dst += 2;
                     buf_pos = 0;
                 }
@@ -3252,7 +3715,7 @@ void ARM7TDMI::bios_diff8bit_unfilter_wram() {
     uint32_t src = m_regs[0];
     uint32_t dst = m_regs[1];
 
-    uint32_t header = read32(src);
+    uint32_t header = bios_read32(src);
     src += 4;
 
     uint32_t decomp_size = header >> 8;
@@ -3261,14 +3724,15 @@ void ARM7TDMI::bios_diff8bit_unfilter_wram() {
     if (decomp_size == 0) return;
 
     // First byte is the base value
-    uint8_t running_sum = read8(src++);
-    write8(dst++, running_sum);
+    uint8_t running_sum = bios_read8(src++);
+    bios_write8(dst++, running_sum);
 
     // Each subsequent byte is a difference to add to the running sum
     while (dst < decomp_end) {
-        uint8_t diff = read8(src++);
+        uint8_t diff = bios_read8(src++);
+        m_bios_cycles += 4;
         running_sum += diff;
-        write8(dst++, running_sum);
+        bios_write8(dst++, running_sum);
     }
 }
 
@@ -3280,7 +3744,7 @@ void ARM7TDMI::bios_diff8bit_unfilter_vram() {
     uint32_t src = m_regs[0];
     uint32_t dst = m_regs[1];
 
-    uint32_t header = read32(src);
+    uint32_t header = bios_read32(src);
     src += 4;
 
     uint32_t decomp_size = header >> 8;
@@ -3288,7 +3752,7 @@ void ARM7TDMI::bios_diff8bit_unfilter_vram() {
     if (decomp_size == 0) return;
 
     // First byte is the base value
-    uint8_t running_sum = read8(src++);
+    uint8_t running_sum = bios_read8(src++);
     uint32_t bytes_processed = 1;
 
     // Process in pairs - always write 16 bits at a time
@@ -3298,18 +3762,19 @@ void ARM7TDMI::bios_diff8bit_unfilter_vram() {
         // Get next byte if available
         uint8_t hi = 0;
         if (bytes_processed < decomp_size) {
-            uint8_t diff = read8(src++);
+            uint8_t diff = bios_read8(src++);
             running_sum += diff;
             hi = running_sum;
             bytes_processed++;
         }
 
-        write16(dst, lo | (hi << 8));
+        m_bios_cycles += 8;
+        bios_write16(dst, lo | (hi << 8));
         dst += 2;
 
         // Prepare next low byte
         if (bytes_processed < decomp_size) {
-            uint8_t diff = read8(src++);
+            uint8_t diff = bios_read8(src++);
             running_sum += diff;
             bytes_processed++;
         } else {
@@ -3330,7 +3795,7 @@ void ARM7TDMI::bios_diff16bit_unfilter() {
     uint32_t src = m_regs[0];
     uint32_t dst = m_regs[1];
 
-    uint32_t header = read32(src);
+    uint32_t header = bios_read32(src);
     src += 4;
 
     uint32_t decomp_size = header >> 8;
@@ -3339,17 +3804,18 @@ void ARM7TDMI::bios_diff16bit_unfilter() {
     if (decomp_size == 0) return;
 
     // First halfword is the base value
-    uint16_t running_sum = read16(src);
+    uint16_t running_sum = bios_read16(src);
     src += 2;
-    write16(dst, running_sum);
+    bios_write16(dst, running_sum);
     dst += 2;
 
     // Each subsequent halfword is a difference to add to the running sum
     while (dst < decomp_end) {
-        uint16_t diff = read16(src);
+        uint16_t diff = bios_read16(src);
         src += 2;
+        m_bios_cycles += 4;
         running_sum += diff;
-        write16(dst, running_sum);
+        bios_write16(dst, running_sum);
         dst += 2;
     }
 }
@@ -1,13 +1,20 @@
 #pragma once
 
 #include "types.hpp"
+#include "emu/breakpoints.hpp"
+#include "emu/cpu_trace.hpp"
+#include "emu/state_writer.hpp"
 #include <cstdint>
+#include <algorithm>
 #include <array>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace gba {
 
 class Bus;
+using emu::StateWriter;
 
 // ARM7TDMI CPU emulator
 // Supports both ARM (32-bit) and Thumb (16-bit) instruction sets
@@ -22,11 +29,16 @@ public:
     // Execute one instruction, return cycles consumed
     int step();
 
+    // Execute instructions until max_cycles have passed, the bus wants a
+    // sync, the CPU halts or an idle loop is proven; returns cycles consumed
+    // and adds the instructions run to instructions
+    int run(int max_cycles, int& instructions);
+
     // Signal an IRQ (level-triggered)
     void signal_irq();
 
     // Save/load state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
 
     // Debug access
@@ -36,6 +48,53 @@ public:
     bool is_thumb_mode() const { return m_cpsr & FLAG_T; }
     bool is_halted() const { return m_halted; }
 
+    // Record every instruction into trace while set (see emu/cpu_trace.hpp)
+    void set_trace(emu::CpuTrace* trace) { m_trace = trace; }
+
+    // Execute breakpoints checked at each instruction, or nullptr for none
+    void set_breakpoints(emu::Breakpoints* breakpoints) { m_breakpoints = breakpoints; }
+
+    // Halt control (HALTCNT, and wake-up on IE & IF with IME off)
+    void halt() { m_halted = true; }
+    void wake() { m_halted = false; }
+
+    // Let cycles pass while halted, as that many halted step() calls would
+    void idle(int cycles) {
+        if (m_irq_delay > 0) {
+            m_irq_delay = std::max(0, m_irq_delay - cycles);
+        }
+    }
+
+    // Cycles per pass when the CPU sits at the head of a loop that will
+    // repeat unchanged until the next bus event, otherwise 0
+    int idle_loop_period() const;
+
+    // Called by the bus for every EWRAM/IWRAM write; drops cached blocks
+    // decoded from the written page
+    void invalidate_code(uint32_t address) {
+        uint32_t page = code_page(address);
+        if (m_code_pages[page]) {
+            flush_code_page(page);
+        }
+    }
+
+    // Same for a bulk write of [address, address + size) within one region
+    void invalidate_code_range(uint32_t address, uint32_t size) {
+        for (uint32_t page = code_page(address); page <= code_page(address + size - 1); page++) {
+            if (m_code_pages[page]) {
+                flush_code_page(page);
+            }
+        }
+    }
+
+    // Drop the blocks decoded from EWRAM/IWRAM after both were replaced
+    // (state loads); ROM blocks stay cached
+    void invalidate_ram_code();
+
+    // Bring the prefetch buffer up to date; the bus calls this before
+    // WAITCNT changes its enable or timing
+    void prefetch_sync();
+
 private:
     // Memory access with proper bus timing
     uint8_t read8(uint32_t address);
@@ -51,7 +110,7 @@ private:
     void flush_pipeline();
 
     // Prefetch buffer operations
-    void prefetch_step(int cycles);           // Advance prefetch during idle cycles
+    void prefetch_step(int cycles);           // Add cycles the buffer can fill during
     int prefetch_read(uint32_t address, int size);  // Read from prefetch, returns cycles
     void prefetch_invalidate();               // Invalidate buffer on non-sequential access
     bool is_rom_address(uint32_t address) const;    // Check if address is in ROM region
@@ -59,13 +118,74 @@ private:
     // Data access timing - calculates wait states and advances prefetch during stalls
     int data_access_cycles(uint32_t address, int access_size, bool is_write);
 
+    // Handler types shared by the decoders and the block cache
+    using ArmHandler = int (ARM7TDMI::*)(uint32_t);
+    using ThumbHandler = int (ARM7TDMI::*)(uint16_t);
+
+    // Block cache
+    // Straight-line runs from ROM and work RAM are decoded once into
+    // handler + instruction pairs, so the hot path skips the bus fetch and
+    // the bit-pattern dispatch. Prefetch and wait-state timing is still
+    // charged per instruction exactly as for an uncached fetch.
+    struct CachedOp {
+        union {
+            ArmHandler arm;
+            ThumbHandler thumb;
+        };
+        uint32_t instruction;
+    };
+
+    struct CachedBlock {
+        std::vector<CachedOp> ops;
+        bool thumb = false;
+        bool in_ram = false;        // RAM blocks are checked against page generations
+        uint16_t pages[2] = {0, 0}; // Code pages of the first and last instruction
+        uint32_t gens[2] = {0, 0};  // Page generations at decode time
+    };
+
+    bool is_cacheable(uint32_t address) const;
+    static uint32_t code_page(uint32_t address) {
+        // EWRAM pages first, then IWRAM
+        if ((address >> 24) == 0x02) {
+            return (address & 0x3FFFF) >> CODE_PAGE_BITS;
+        }
+        return (0x40000 >> CODE_PAGE_BITS) + ((address & 0x7FFF) >> CODE_PAGE_BITS);
+    }
+    const CachedOp* lookup_cached_op(uint32_t address, bool thumb);
+    CachedBlock& build_block(uint32_t address, bool thumb);
+    bool is_block_valid(const CachedBlock& block) const;
+    void flush_code_page(uint32_t page);
+    void flush_block_cache();
+
+    // Decode tables, generated at compile time
+    // ARM is indexed by bits 27-20 and 7-4, Thumb by bits 15-6. Entries
+    // point at handlers specialized on those bits where it pays off.
+    static constexpr size_t ARM_TABLE_SIZE = 4096;
+    static constexpr size_t THUMB_TABLE_SIZE = 1024;
+    static const std::array<ArmHandler, ARM_TABLE_SIZE> s_arm_table;
+    static const std::array<ThumbHandler, THUMB_TABLE_SIZE> s_thumb_table;
+
+    template <size_t Index> static constexpr ArmHandler arm_table_entry();
+    template <size_t Index> static constexpr ThumbHandler thumb_table_entry();
+    template <size_t... Index>
+    static constexpr std::array<ArmHandler, ARM_TABLE_SIZE> make_arm_table(std::index_sequence<Index...>) {
+        return {{arm_table_entry<Index>()...}};
+    }
+    template <size_t... Index>
+    static constexpr std::array<ThumbHandler, THUMB_TABLE_SIZE> make_thumb_table(std::index_sequence<Index...>) {
+        return {{thumb_table_entry<Index>()...}};
+    }
+
     // ARM instruction execution
     int execute_arm(uint32_t instruction);
+    ArmHandler decode_arm(uint32_t instruction) const;
+    static bool arm_ends_block(uint32_t instruction, ArmHandler handler);
     bool check_condition(uint32_t instruction);
 
     // ARM instruction handlers
     int arm_branch(uint32_t instruction);
     int arm_branch_exchange(uint32_t instruction);
+    template <uint32_t Opcode, bool SetFlags, bool Immediate, bool RegShift>
     int arm_data_processing(uint32_t instruction);
     int arm_multiply(uint32_t instruction);
     int arm_multiply_long(uint32_t instruction);
@@ -77,6 +197,7 @@ private:
     int arm_mrs(uint32_t instruction);
     int arm_msr(uint32_t instruction);
     int arm_undefined(uint32_t instruction);
+    int arm_coprocessor(uint32_t instruction);
 
     // ARM data processing operand calculation
     uint32_t arm_shift(uint32_t value, int shift_type, int amount, bool& carry_out, bool reg_shift);
@@ -86,11 +207,14 @@ private:
 
     // Thumb instruction execution
     int execute_thumb(uint16_t instruction);
+    ThumbHandler decode_thumb(uint16_t instruction) const;
+    static bool thumb_ends_block(uint16_t instruction, ThumbHandler handler);
 
     // Thumb instruction handlers
     int thumb_move_shifted(uint16_t instruction);
     int thumb_add_subtract(uint16_t instruction);
     int thumb_immediate(uint16_t instruction);
+    template <uint32_t Op>
     int thumb_alu(uint16_t instruction);
     int thumb_hi_reg_bx(uint16_t instruction);
     int thumb_pc_relative_load(uint16_t instruction);
@@ -112,8 +236,16 @@ private:
     void switch_mode(ProcessorMode new_mode);
     void enter_exception(ProcessorMode mode, uint32_t vector);
 
-    // HLE BIOS functions
-    void hle_bios_call(uint8_t function);
+    // HLE BIOS functions. hle_bios_call returns the cycles the real BIOS
+    // routine would have taken, beyond the SWI instruction itself.
+    int hle_bios_call(uint8_t function);
+    void bios_access(uint32_t address, int access_size);
+    uint8_t bios_read8(uint32_t address);
+    uint16_t bios_read16(uint32_t address);
+    uint32_t bios_read32(uint32_t address);
+    void bios_write8(uint32_t address, uint8_t value);
+    void bios_write16(uint32_t address, uint16_t value);
+    void bios_write32(uint32_t address, uint32_t value);
     void bios_div();
     void bios_sqrt();
     void bios_arctan();
@@ -174,6 +306,10 @@ private:
     uint32_t m_spsr_und = 0;
 
     // Pipeline state
+    emu::CpuTrace* m_trace = nullptr;
+    void trace_instruction(uint32_t address, uint32_t instruction, bool thumb);
+    emu::Breakpoints* m_breakpoints = nullptr;
+
     uint32_t m_pipeline[2] = {0, 0};  // 2-stage prefetch
     int m_pipeline_valid = 0;
 
@@ -217,11 +353,15 @@ private:
     // - Provides 0-wait sequential ROM reads if data is prefetched
     // - Buffer becomes invalid on non-sequential access (branches)
     // - WAITCNT bit 14 enables/disables the prefetch buffer
+    // The fields hold the buffer as of the last prefetch_sync(); cycles since
+    // then only add up in pending, and the sync works out how many halfwords
+    // arrived in them in one go, when the CPU next fetches from ROM.
     struct Prefetch {
         uint32_t head_address = 0;     // Start of current prefetch region (first valid address)
         uint32_t next_address = 0;     // Next address to prefetch
         int count = 0;                 // Current halfwords in buffer (0-8)
         int countdown = 0;             // Cycles until next prefetch completes
+        int pending = 0;               // Fill cycles not yet applied (not saved)
         bool active = false;           // Is the prefetcher currently running?
 
         void reset() {
@@ -229,17 +369,71 @@ private:
             next_address = 0;
             count = 0;
             countdown = 0;
+            pending = 0;
             active = false;
         }
 
         void invalidate() {
             count = 0;
             countdown = 0;
+            pending = 0;
             active = false;
         }
     };
+    static constexpr int PREFETCH_PENDING_LIMIT = 0x10000;  // Synced early past this
     Prefetch m_prefetch;
 
+    // Block cache state (not saved; rebuilt on demand after a load)
+    // Blocks are keyed by start address with bit 0 set for Thumb
+    static constexpr int CODE_PAGE_BITS = 8;
+    static constexpr size_t CODE_PAGES = (0x40000 + 0x8000) >> CODE_PAGE_BITS;
+    static constexpr size_t BLOCK_MAX_OPS = 32;
+    static constexpr size_t BLOCK_CACHE_LIMIT = 1 << 16;
+    static constexpr uint8_t CODE_PAGE_MAX_FLUSHES = 16;  // Then the page is interpreted
+    std::unordered_map<uint32_t, CachedBlock> m_blocks;
+    CachedBlock* m_block = nullptr;  // Block being executed
+    size_t m_block_index = 0;        // Next op in m_block
+    uint32_t m_block_pc = 0;         // Address of that op
+    std::array<uint8_t, CODE_PAGES> m_code_pages{};       // Pages holding cached code
+    std::array<uint32_t, CODE_PAGES> m_code_page_gen{};   // Bumped on writes to those pages
+    std::array<uint8_t, CODE_PAGES> m_code_page_flushes{};  // Self-modifying code detection
+
+    // Idle loop detection
+    // A taken backward branch of at most IDLE_LOOP_MAX_BYTES makes its body
+    // a candidate. A pass is clean when it stayed inside the body, stored
+    // nothing and only read memory that changes on bus events alone. Two
+    // clean passes that leave the CPU in the same state with no bus event in
+    // between prove every further pass identical until the next event.
+    struct IdleState {
+        std::array<uint32_t, 16> regs;
+        std::array<uint32_t, 22> banked;  // FIQ, shared R8-R12, SP/LR pairs
+        std::array<uint32_t, 5> spsrs;
+        std::array<uint32_t, 2> pipeline;
+        uint32_t cpsr, last_fetch_addr, last_data_addr, prefetch_head, prefetch_next;
+        int irq_delay, pipeline_valid, prefetch_count, prefetch_countdown;
+        bool irq_pending, in_thumb_bl, next_fetch_nonseq, prefetch_active;
+        ProcessorMode mode;
+        uint32_t bus_events;
+
+        bool operator==(const IdleState& other) const;
+    };
+    IdleState capture_idle_state() const;
+    void complete_idle_pass();
+    void note_idle_read(uint32_t address);
+
+    static constexpr uint32_t IDLE_LOOP_MAX_BYTES = 64;
+    uint32_t m_idle_head = 0;     // Loop start, 0 = no candidate
+    uint32_t m_idle_tail = 0;     // Address of the backward branch
+    int m_idle_cycles = 0;        // Cycles spent in the current pass
+    int m_idle_period = 0;        // Cycles of the last pass if it proved idle
+    bool m_idle_clean = false;    // Current pass qualifies so far (false without a candidate)
+    bool m_idle_primed = false;   // m_idle_state holds the state after a clean pass
+    IdleState m_idle_state{};
+
+    // Cost of the HLE BIOS call in progress
+    int m_bios_cycles = 0;
+    uint32_t m_bios_last_access = 0;  // For telling sequential accesses apart
+
     // Current processor mode
     ProcessorMode m_mode = ProcessorMode::Supervisor;
 
@@ -260,6 +454,9 @@ private:
     static constexpr uint32_t VECTOR_DATA      = 0x00000010;
     static constexpr uint32_t VECTOR_IRQ       = 0x00000018;
     static constexpr uint32_t VECTOR_FIQ       = 0x0000001C;
+
+    // Debug output limits (DEBUG=1)
+    bool m_debug_sp_ldm_logged = false;
 };
 
 } // namespace gba
@@ -4,7 +4,10 @@
 #include "apu.hpp"
 #include "cartridge.hpp"
 #include "debug.hpp"
+#include "emu/state_writer.hpp"
 #include <cstring>
+#include <algorithm>
+#include <limits>
 
 namespace gba {
 
@@ -81,13 +84,13 @@ Bus::Bus() {
 
     // Initialize wait state tables with default values
     // These get updated when WAITCNT is written
-    m_ws_n.fill(4);
-    m_ws_s.fill(2);
+    map_pages();
+    update_wait_states();
 }
 
 Bus::~Bus() = default;
 
-MemoryRegion Bus::get_region(uint32_t address) {
+MemoryRegion Bus::get_region(uint32_t address) const {
     switch (address >> 24) {
         case 0x00: return MemoryRegion::BIOS;
         case 0x02: return MemoryRegion::EWRAM;
@@ -108,7 +111,72 @@ MemoryRegion Bus::get_region(uint32_t address) {
     }
 }
 
-int Bus::get_wait_states(uint32_t address, bool is_sequential, int access_size) {
+void Bus::map_pages() {
+    for (Page& page : m_pages) {
+        page.data = nullptr;
+        page.write = nullptr;
+        page.mask = 0;
+        page.limit = 0;
+    }
+
+    auto map = [this](int index, const uint8_t* data, uint32_t mask, uint32_t limit) {
+        m_pages[index].data = data;
+        m_pages[index].mask = mask;
+        m_pages[index].limit = limit;
+    };
+
+    map(0x02, m_ewram.data(), 0x3FFFF, 0x40000);
+    map(0x03, m_iwram.data(), 0x7FFF, 0x8000);
+    if (!is_debug_mode()) {  // DEBUG=1 traces some IWRAM writes in write8()
+        m_pages[0x02].write = m_ewram.data();
+        m_pages[0x03].write = m_iwram.data();
+    }
+
+    if (m_ppu) {
+        map(0x05, m_ppu->get_palette_data(), 0x3FF, 0x400);
+        map(0x06, m_ppu->get_vram_data(), 0x1FFFF, 0x18000);  // Upper 32KB mirror stays slow
+        map(0x07, m_ppu->get_oam_data(), 0x3FF, 0x400);
+    }
+
+    if (m_cartridge && m_cartridge->get_rom_size() > 0) {
+        // Word-aligned limit so 16/32-bit reads never straddle the ROM end
+        uint32_t rom_limit = static_cast<uint32_t>(
+            std::min<size_t>(m_cartridge->get_rom_size(), 0x2000000)) & ~3u;
+        SaveType save_type = m_cartridge->get_save_type();
+        bool eeprom = save_type == SaveType::EEPROM_512 || save_type == SaveType::EEPROM_8K;
+        for (int index = 0x08; index <= 0x0D; index++) {
+            // GPIO registers sit at offset 0xC4 of each mirror's first page
+            if (m_cartridge->has_rtc() && !(index & 1)) continue;
+            uint32_t limit = rom_limit;
+            if (index >= 0x0C && eeprom) limit = std::min(limit, 0x1FFFF00u);
+            map(index, m_cartridge->get_rom_data(), 0x1FFFFFF, limit);
+        }
+    }
+
+    if (m_breakpoints) {
+        for (uint32_t index = 0; index < m_pages.size(); index++) {
+            if (m_breakpoints->range_flags(index << 24, (index << 24) | 0xFFFFFF)) {
+                m_pages[index].data = nullptr;
+                m_pages[index].write = nullptr;
+                m_pages[index].limit = 0;
+            }
+        }
+    }
+}
+
+void Bus::update_wait_states() {
+    for (uint32_t index = 0; index < m_pages.size(); index++) {
+        uint32_t address = index << 24;
+        Page& page = m_pages[index];
+        page.waits[0] = static_cast<uint8_t>(calc_wait_states(address, false, 16));
+        page.waits[1] = static_cast<uint8_t>(calc_wait_states(address, false, 32));
+        page.waits[2] = static_cast<uint8_t>(calc_wait_states(address, true, 16));
+        page.waits[3] = static_cast<uint8_t>(calc_wait_states(address, true, 32));
+        page.prefetch_duty = static_cast<uint8_t>(calc_prefetch_duty(address));
+    }
+}
+
+int Bus::calc_wait_states(uint32_t address, bool is_sequential, int access_size) const {
     // Default WAITCNT = 0x0000 gives:
     // - SRAM: 4 cycles
     // - WS0 N: 4, S: 2
@@ -202,7 +270,7 @@ int Bus::get_rom_s_cycles() const {
     return s_bit ? 1 : 2;
 }
 
-int Bus::get_prefetch_duty(uint32_t address) const {
+int Bus::calc_prefetch_duty(uint32_t address) const {
     // Get the S-cycle wait states for the ROM region at this address
     // This determines how long each prefetch takes
     // Different ROM waitstate regions have different S-cycle timing
@@ -240,6 +308,18 @@ int Bus::get_prefetch_duty(uint32_t address) const {
 }
 
 uint8_t Bus::read8(uint32_t address) {
+    const Page& page = m_pages[address >> 24];
+    uint32_t fast_offset = address & page.mask;
+    if (fast_offset < page.limit) {
+        return page.data[fast_offset];
+    }
+
+    uint8_t value = read8_slow(address);
+    if (m_breakpoints) m_breakpoints->check(address, emu::BREAK_READ, value);
+    return value;
+}
+
+uint8_t Bus::read8_slow(uint32_t address) {
     MemoryRegion region = get_region(address);
 
     switch (region) {
@@ -335,6 +415,21 @@ uint8_t Bus::read8(uint32_t address) {
 
 uint16_t Bus::read16(uint32_t address) {
     address &= ~1u;  // Force alignment
+    const Page& page = m_pages[address >> 24];
+    uint32_t fast_offset = address & page.mask;
+    if (fast_offset < page.limit) {
+        return page.data[fast_offset] | (page.data[fast_offset + 1] << 8);
+    }
+
+    uint16_t value = read16_slow(address);
+    if (m_breakpoints) {
+        m_breakpoints->check(address, emu::BREAK_READ, value & 0xFF);
+        m_breakpoints->check(address + 1, emu::BREAK_READ, value >> 8);
+    }
+    return value;
+}
+
+uint16_t Bus::read16_slow(uint32_t address) {
     MemoryRegion region = get_region(address);
 
     switch (region) {
@@ -430,7 +525,21 @@ uint16_t Bus::read16(uint32_t address) {
 
 uint32_t Bus::read32(uint32_t address) {
     address &= ~3u;  // Force alignment
+    const Page& page = m_pages[address >> 24];
+    uint32_t fast_offset = address & page.mask;
+    if (fast_offset < page.limit) {
+        const uint8_t* p = page.data + fast_offset;
+        return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
 
+    uint32_t value = read32_slow(address);
+    if (m_breakpoints) {
+        for (int i = 0; i < 4; i++) m_breakpoints->check(address + i, emu::BREAK_READ, (value >> (i * 8)) & 0xFF);
+    }
+    return value;
+}
+
+uint32_t Bus::read32_slow(uint32_t address) {
     // Special handling for BIOS to return correct last read value
     if (address < 0x4000) {
         uint32_t pc = m_cpu ? m_cpu->get_pc() : 0xFFFFFFFF;
@@ -469,15 +578,37 @@ uint32_t Bus::read32(uint32_t address) {
         return 0xFFFFFFFF;
     }
 
-    return read16(address) | (read16(address + 2) << 16);
+    return read16_slow(address) | (read16_slow(address + 2) << 16);
+}
+
+inline void Bus::ram_written(uint32_t address) {
+    m_ram_stamps[ram_stamp_page(address)] = m_write_stamp;
+    if (m_cpu) m_cpu->invalidate_code(address);
+}
+
+void Bus::ram_written_range(uint32_t address, uint32_t size) {
+    for (uint32_t page = ram_stamp_page(address); page <= ram_stamp_page(address + size - 1); page++) {
+        m_ram_stamps[page] = m_write_stamp;
+    }
+    if (m_cpu) m_cpu->invalidate_code_range(address, size);
 }
 
 void Bus::write8(uint32_t address, uint8_t value) {
+    if (m_write_watch) m_write_watch->check(address, value);
+    if (m_breakpoints) m_breakpoints->check(address, emu::BREAK_WRITE, value);
+    const Page& page = m_pages[address >> 24];
+    if (page.write) {
+        page.write[address & page.mask] = value;
+        ram_written(address);
+        return;
+    }
+
     MemoryRegion region = get_region(address);
 
     switch (region) {
         case MemoryRegion::EWRAM:
             m_ewram[address & 0x3FFFF] = value;
+            ram_written(address);
             break;
 
         case MemoryRegion::IWRAM: {
@@ -489,10 +620,18 @@ void Bus::write8(uint32_t address, uint8_t value) {
                         address, value, pc);
             }
             m_iwram[offset] = value;
+            ram_written(address);
             break;
         }
 
         case MemoryRegion::IO: {
+            // HALTCNT shares its halfword with POSTFLG but must only see
+            // its own byte, or every POSTFLG write would halt the CPU
+            if ((address & 0xFFF) == 0x301) {
+                write_io(address, value);
+                break;
+            }
+
             // Byte writes to I/O need special handling
             uint32_t io_addr = address & ~1;
             uint16_t old_val = read_io(io_addr);
@@ -569,6 +708,23 @@ void Bus::write8(uint32_t address, uint8_t value) {
 
 void Bus::write16(uint32_t address, uint16_t value) {
     address &= ~1u;  // Force alignment
+    if (m_write_watch) {
+        m_write_watch->check(address, value & 0xFF);
+        m_write_watch->check(address + 1, value >> 8);
+    }
+    if (m_breakpoints) {
+        m_breakpoints->check(address, emu::BREAK_WRITE, value & 0xFF);
+        m_breakpoints->check(address + 1, emu::BREAK_WRITE, value >> 8);
+    }
+    const Page& page = m_pages[address >> 24];
+    if (page.write) {
+        uint8_t* p = page.write + (address & page.mask);
+        p[0] = value & 0xFF;
+        p[1] = value >> 8;
+        ram_written(address);
+        return;
+    }
+
     MemoryRegion region = get_region(address);
 
     switch (region) {
@@ -576,6 +732,7 @@ void Bus::write16(uint32_t address, uint16_t value) {
             uint32_t offset = address & 0x3FFFF;
             m_ewram[offset] = value & 0xFF;
             m_ewram[offset + 1] = value >> 8;
+            ram_written(address);
             break;
         }
 
@@ -583,6 +740,7 @@ void Bus::write16(uint32_t address, uint16_t value) {
             uint32_t offset = address & 0x7FFF;
             m_iwram[offset] = value & 0xFF;
             m_iwram[offset + 1] = value >> 8;
+            ram_written(address);
             break;
         }
 
@@ -666,6 +824,20 @@ void Bus::write16(uint32_t address, uint16_t value) {
 
 void Bus::write32(uint32_t address, uint32_t value) {
     address &= ~3u;  // Force alignment
+    const Page& page = m_pages[address >> 24];
+    if (page.write) {
+        if (m_write_watch) {
+            for (int i = 0; i < 4; i++) m_write_watch->check(address + i, (value >> (i * 8)) & 0xFF);
+        }
+        uint8_t* p = page.write + (address & page.mask);
+        p[0] = value & 0xFF;
+        p[1] = (value >> 8) & 0xFF;
+        p[2] = (value >> 16) & 0xFF;
+        p[3] = value >> 24;
+        ram_written(address);  // One code page holds all four bytes
+        return;
+    }
+
     write16(address, value & 0xFFFF);
     write16(address + 2, value >> 16);
 }
@@ -702,6 +874,10 @@ void Bus::write32_unaligned(uint32_t address, uint32_t value) {
 }
 
 uint16_t Bus::read_io(uint32_t address) {
+    // Registers must reflect every cycle up to this instruction
+    catch_up();
+    m_sync_requested = true;
+
     // mGBA debug registers (0x04FFF600-0x04FFF7FF)
     // REG_DEBUG_ENABLE = 0x4FFF780 (write 0xC0DE to enable, reads 0x1DEA if supported)
     // REG_DEBUG_FLAGS  = 0x4FFF700 (write level|0x100 to flush)
@@ -793,7 +969,7 @@ uint16_t Bus::read_io(uint32_t address) {
         case 0x10E: return m_timers[3].control;
 
         // Key input
-        case 0x130: return m_keyinput;
+        case 0x130: m_keyinput_read = true; return m_keyinput;
         case 0x132: return m_keycnt;
 
         // Interrupts
@@ -810,6 +986,11 @@ uint16_t Bus::read_io(uint32_t address) {
 }
 
 void Bus::write_io(uint32_t address, uint16_t value) {
+    // The write may move or add events, so reschedule after this instruction
+    catch_up();
+    m_sync_requested = true;
+    m_event_count++;
+
     // mGBA debug registers (0x04FFF600-0x04FFF7FF)
     uint32_t debug_offset = address & 0xFFFF;
     if (debug_offset >= 0xF600) {
@@ -1049,6 +1230,7 @@ void Bus::write_io(uint32_t address, uint16_t value) {
             GBA_DEBUG_PRINT("IE write: 0x%04X (VBlank=%s, HBlank=%s, Timer0=%s)\n",
                            value, (value & 1) ? "Y" : "N", (value & 2) ? "Y" : "N", (value & 8) ? "Y" : "N");
             m_ie = value;
+            update_irq_line();
             break;
         case 0x202:
             GBA_DEBUG_PRINT("IF write (ack): 0x%04X (clearing IF from 0x%04X to 0x%04X)\n",
@@ -1056,19 +1238,24 @@ void Bus::write_io(uint32_t address, uint16_t value) {
             m_if &= ~value;
             // Also clear serviced tracking for these interrupts so they can re-trigger
             m_if_serviced &= ~value;
+            update_irq_line();
             break;  // Write 1 to clear
         case 0x204:
+            if (m_cpu) m_cpu->prefetch_sync();
             m_waitcnt = value;
+            update_wait_states();
             break;
         case 0x208:
             GBA_DEBUG_PRINT("IME write: 0x%04X (Master IRQ %s)\n", value, (value & 1) ? "ENABLED" : "disabled");
             m_ime = value & 1;
+            update_irq_line();
             break;
 
         case 0x300: m_postflg = value & 1; break;
         case 0x301:
             m_haltcnt = value;
-            // TODO: Enter halt or stop mode
+            // Bit 7 selects Stop mode, which isn't emulated; Halt waits for an IRQ
+            if (!(value & 0x80) && m_cpu) m_cpu->halt();
             break;
 
         default:
@@ -1077,6 +1264,11 @@ void Bus::write_io(uint32_t address, uint16_t value) {
 }
 
 void Bus::set_input_state(uint32_t buttons) {
+    // Resync at the start of each frame so resets and state loads between
+    // frames are picked up by the scheduler
+    m_sync_requested = true;
+    m_event_count++;
+
     // Convert from Veloce button layout to GBA KEYINPUT
     // GBA: bit 0=A, 1=B, 2=Select, 3=Start, 4=Right, 5=Left, 6=Up, 7=Down, 8=R, 9=L
     // Veloce: bit 0=A, 1=B, 2=X, 3=Y, 4=L, 5=R, 6=Start, 7=Select, 8=Up, 9=Down, 10=Left, 11=Right
@@ -1098,6 +1290,7 @@ void Bus::set_input_state(uint32_t buttons) {
 
     // Check for keypad IRQ
     if (m_keycnt & 0x4000) {
+        m_keyinput_read = true;     // Whether it fires depends on the input
         uint16_t keys_pressed = ~m_keyinput & 0x3FF;
         uint16_t keys_watched = m_keycnt & 0x3FF;
 
@@ -1116,18 +1309,10 @@ void Bus::set_input_state(uint32_t buttons) {
     }
 }
 
-bool Bus::check_interrupts() {
-    // Edge-triggered: only signal IRQ for pending interrupts that haven't been serviced yet
-    // This prevents the same interrupt from re-triggering while the handler is still running
-    uint16_t pending = m_ie & m_if;
-    uint16_t unserviced = pending & ~m_if_serviced;
-
-    if (m_ime && unserviced) {
-        // Mark these interrupts as serviced so they won't re-trigger
-        m_if_serviced |= unserviced;
-        return true;
-    }
-    return false;
+// Recomputed whenever IE, IF, IME or the serviced bits change, so the
+// frame loop's check is a single flag test
+void Bus::update_irq_line() {
+    m_irq_line = m_ime && (m_ie & m_if & ~m_if_serviced);
 }
 
 void Bus::request_interrupt(GBAInterrupt irq) {
@@ -1138,6 +1323,9 @@ void Bus::request_interrupt(GBAInterrupt irq) {
                         irq_bit, m_ie, m_if, m_if | irq_bit, m_ime);
     }
     m_if |= irq_bit;
+    update_irq_line();
+    m_sync_requested = true;
+    m_event_count++;
     // Note: m_if_serviced is NOT modified here - the interrupt is eligible to fire
     // until check_interrupts() marks it as serviced
 }
@@ -1161,6 +1349,7 @@ int Bus::run_dma() {
     if (channel < 0) {
         return 0;  // No DMA pending
     }
+    m_event_count++;
 
     // Run the cycle-accurate DMA state machine
     // Give it enough cycles to complete typical transfers
@@ -1359,6 +1548,277 @@ int Bus::get_dma_access_cycles(uint32_t address, bool is_sequential, bool is_32b
     return get_wait_states(address, is_sequential, access_size) + 1;
 }
 
+// Backing storage of [address, address + bytes) if it is plain memory
+// inside a single mapping, nullptr otherwise
+void Bus::read_block(uint32_t address, size_t length, uint8_t* out) {
+    while (length > 0) {
+        const Page& page = m_pages[address >> 24];
+        uint32_t offset = address & page.mask;
+        if (offset < page.limit) {
+            // Runs end at the limit, which is never past a mirror boundary
+            size_t run = std::min<size_t>(length, page.limit - offset);
+            std::memcpy(out, page.data + offset, run);
+            out += run;
+            address += static_cast<uint32_t>(run);
+            length -= run;
+        } else {
+            *out++ = peek8(address++);
+            length--;
+        }
+    }
+}
+
+uint8_t Bus::peek8(uint32_t address) const {
+    uint8_t open_bus = static_cast<uint8_t>(m_last_read_value >> ((address & 3) * 8));
+    switch (get_region(address)) {
+        case MemoryRegion::BIOS:
+            if (address >= 0x4000) return open_bus;
+            if (m_cpu && m_cpu->get_pc() < 0x4000) return m_bios[address];
+            return static_cast<uint8_t>(m_last_bios_read >> ((address & 3) * 8));
+
+        case MemoryRegion::EWRAM:
+            return m_ewram[address & 0x3FFFF];
+
+        case MemoryRegion::IWRAM:
+            return m_iwram[address & 0x7FFF];
+
+        case MemoryRegion::Palette:
+        case MemoryRegion::VRAM:
+        case MemoryRegion::OAM:
+        case MemoryRegion::ROM_WS0:
+        case MemoryRegion::ROM_WS1:
+            // Plain reads, here only while a breakpoint keeps them out of
+            // the page table
+            return const_cast<Bus*>(this)->read8_slow(address);
+
+        case MemoryRegion::ROM_WS2:
+        case MemoryRegion::SRAM: {
+            if (!m_cartridge) return open_bus;
+            SaveType save_type = m_cartridge->get_save_type();
+            if (save_type == SaveType::EEPROM_512 || save_type == SaveType::EEPROM_8K) {
+                uint32_t rom_offset = address & 0x1FFFFFF;
+                bool eeprom = get_region(address) == MemoryRegion::SRAM || rom_offset >= 0x1FFFF00 ||
+                              rom_offset >= m_cartridge->get_rom_size();
+                if (eeprom) return open_bus;
+            }
+            return const_cast<Bus*>(this)->read8_slow(address);
+        }
+
+        default:
+            return open_bus;
+    }
+}
+
+const uint8_t* Bus::plain_span(uint32_t address, uint32_t bytes) const {
+    const Page& page = m_pages[address >> 24];
+    uint32_t offset = address & page.mask;
+    return offset + bytes <= page.limit ? page.data + offset : nullptr;
+}
+
+// Writable storage for a span plain_span() accepted, with the side
+// effects of writing it (code cache and render worker invalidation).
+// nullptr for ROM.
+uint8_t* Bus::writable_span(uint32_t address, uint32_t bytes) {
+    uint32_t offset = address & m_pages[address >> 24].mask;
+    switch (address >> 24) {
+        case 0x02:
+            ram_written_range(address, bytes);
+            return m_ewram.data() + offset;
+        case 0x03:
+            ram_written_range(address, bytes);
+            return m_iwram.data() + offset;
+        case 0x05: return m_ppu->palette_for_write(offset, bytes);
+        case 0x06: return m_ppu->vram_for_write(offset, bytes);
+        case 0x07: return m_ppu->oam_for_write(offset, bytes);
+        default: return nullptr;
+    }
+}
+
+// Move as many whole units of a transfer between plain memory as fit in
+// available_cycles in one block, charging the same cycles as the unit by
+// unit path: the first access of a run is non-sequential, the rest are
+// sequential, and a span inside one mapping has a single set of waits.
+// Returns 0 without doing anything when the transfer needs that path
+// (IO, SRAM, decrementing or fixed destination, overlap).
+int Bus::dma_bulk_transfer(DMAChannel& dma, uint32_t transfer_count, bool is_32bit,
+                           int available_cycles) {
+    int src_adj = (dma.control >> 7) & 3;
+    int dst_adj = (dma.control >> 5) & 3;
+    if (src_adj == 1 || dst_adj == 1 || dst_adj == 2) return 0;
+    bool fixed_src = src_adj == 2;
+
+    uint32_t unit = is_32bit ? 4 : 2;
+    if ((dma.internal_src | dma.internal_dst) & (unit - 1)) return 0;
+
+    int first_cycles = get_dma_access_cycles(dma.internal_src, !dma.first_access, is_32bit) +
+                       get_dma_access_cycles(dma.internal_dst, !dma.first_access, is_32bit);
+    int unit_cycles = get_dma_access_cycles(dma.internal_src, true, is_32bit) +
+                      get_dma_access_cycles(dma.internal_dst, true, is_32bit);
+    if (available_cycles < first_cycles) return 0;
+    uint32_t units = std::min<uint32_t>(transfer_count - dma.current_unit,
+                                        1 + (available_cycles - first_cycles) / unit_cycles);
+    if (units < 2) return 0;
+
+    uint32_t bytes = units * unit;
+    uint32_t src_bytes = fixed_src ? unit : bytes;
+    const uint8_t* src = plain_span(dma.internal_src, src_bytes);
+    if (!src || !plain_span(dma.internal_dst, bytes)) return 0;
+
+    // Overlapping runs only happen within one region and repeat data when
+    // copied a unit at a time
+    if ((dma.internal_src >> 24) == (dma.internal_dst >> 24)) {
+        uint32_t mask = m_pages[dma.internal_dst >> 24].mask;
+        uint32_t src_offset = dma.internal_src & mask;
+        uint32_t dst_offset = dma.internal_dst & mask;
+        if (src_offset < dst_offset + bytes && dst_offset < src_offset + src_bytes) return 0;
+    }
+
+    uint8_t* dst = writable_span(dma.internal_dst, bytes);
+    if (!dst) return 0;
+
+    if (fixed_src) {
+        for (uint32_t i = 0; i < bytes; i += unit) {
+            std::memcpy(dst + i, src, unit);
+        }
+    } else {
+        std::memcpy(dst, src, bytes);
+    }
+
+    const uint8_t* last = dst + bytes - unit;
+    dma.latch = last[0] | (last[1] << 8);
+    if (is_32bit) dma.latch |= (last[2] << 16) | (static_cast<uint32_t>(last[3]) << 24);
+
+    if (!fixed_src) dma.internal_src += bytes;
+    dma.internal_dst += bytes;
+    dma.current_unit += units;
+    dma.first_access = false;
+    dma.phase = dma.current_unit >= transfer_count ? DMAChannel::Phase::Complete
+                                                   : DMAChannel::Phase::Read;
+
+    return first_cycles + static_cast<int>(units - 1) * unit_cycles;
+}
+
+// Sound FIFO refill from plain memory: the words go straight into the FIFO
+// and the events are rescheduled once instead of after every IO write
+int Bus::dma_fifo_transfer(DMAChannel& dma, int available_cycles) {
+    if (!m_apu) return 0;
+    int fifo;
+    switch (dma.internal_dst & ~3u) {
+        case 0x040000A0: fifo = 0; break;
+        case 0x040000A4: fifo = 1; break;
+        default: return 0;
+    }
+    int src_adj = (dma.control >> 7) & 3;
+    if (src_adj == 1 || (dma.internal_src & 3)) return 0;
+    bool fixed_src = src_adj == 2;
+
+    uint32_t units = 4 - dma.current_unit;
+    int first_cycles = get_dma_access_cycles(dma.internal_src, !dma.first_access, true) +
+                       get_dma_access_cycles(dma.internal_dst, !dma.first_access, true);
+    int unit_cycles = get_dma_access_cycles(dma.internal_src, true, true) +
+                      get_dma_access_cycles(dma.internal_dst, true, true);
+    int cycles = first_cycles + static_cast<int>(units - 1) * unit_cycles;
+    if (available_cycles < cycles) return 0;
+    const uint8_t* src = plain_span(dma.internal_src, fixed_src ? 4 : units * 4);
+    if (!src) return 0;
+
+    // As the IO write of the first word would
+    catch_up();
+    m_sync_requested = true;
+    m_event_count++;
+
+    for (uint32_t i = 0; i < units; i++) {
+        const uint8_t* word = fixed_src ? src : src + i * 4;
+        dma.latch = word[0] | (word[1] << 8) | (word[2] << 16) | (static_cast<uint32_t>(word[3]) << 24);
+        if (fifo == 0) {
+            m_apu->write_fifo_a(dma.latch);
+        } else {
+            m_apu->write_fifo_b(dma.latch);
+        }
+    }
+    uint16_t& latch = fifo == 0 ? m_fifo_a_latch : m_fifo_b_latch;
+    latch = static_cast<uint16_t>(dma.latch);
+
+    if (!fixed_src) dma.internal_src += units * 4;
+    dma.current_unit += units;
+    dma.first_access = false;
+    dma.phase = DMAChannel::Phase::Complete;
+    return cycles;
+}
+
+// True when address reaches the EEPROM rather than ROM
+bool Bus::is_eeprom_address(uint32_t address) const {
+    if ((address >> 24) != 0x0D || !m_cartridge) return false;
+    SaveType save_type = m_cartridge->get_save_type();
+    if (save_type != SaveType::EEPROM_512 && save_type != SaveType::EEPROM_8K) return false;
+    uint32_t offset = address & 0x1FFFFFF;
+    return offset >= 0x1FFFF00 || offset >= m_cartridge->get_rom_size();
+}
+
+// A DMA3 transfer to or from the EEPROM carries a whole serial command or
+// reply, a halfword per bit. The whole buffer goes to the cartridge in one
+// call and the cycles are charged together (first access non-sequential,
+// the rest sequential). Returns 0 when the rest of the transfer doesn't fit
+// in available_cycles or the other side isn't plain incrementing memory.
+int Bus::dma_eeprom_transfer(DMAChannel& dma, uint32_t transfer_count, int available_cycles) {
+    if (m_breakpoints) return 0;
+    bool to_eeprom = is_eeprom_address(dma.internal_dst);
+    if (!to_eeprom && !is_eeprom_address(dma.internal_src)) return 0;
+
+    uint32_t memory = to_eeprom ? dma.internal_src : dma.internal_dst;
+    uint32_t eeprom = to_eeprom ? dma.internal_dst : dma.internal_src;
+    int memory_adj = to_eeprom ? (dma.control >> 7) & 3 : (dma.control >> 5) & 3;
+    int eeprom_adj = to_eeprom ? (dma.control >> 5) & 3 : (dma.control >> 7) & 3;
+    if ((memory_adj != 0 && memory_adj != 3) || (memory & 1)) return 0;
+
+    uint32_t units = transfer_count - dma.current_unit;
+    uint32_t bytes = units * 2;
+    uint32_t eeprom_end = eeprom;
+    switch (eeprom_adj) {
+        case 1: eeprom_end -= bytes - 2; break;
+        case 2: break;
+        default: eeprom_end += bytes - 2; break;
+    }
+    if (!is_eeprom_address(eeprom_end)) return 0;
+
+    int first_cycles = get_dma_access_cycles(dma.internal_src, !dma.first_access, false) +
+                       get_dma_access_cycles(dma.internal_dst, !dma.first_access, false);
+    int unit_cycles = get_dma_access_cycles(dma.internal_src, true, false) +
+                      get_dma_access_cycles(dma.internal_dst, true, false);
+    int cycles = first_cycles + static_cast<int>(units - 1) * unit_cycles;
+    if (available_cycles < cycles || !plain_span(memory, bytes)) return 0;
+
+    const uint8_t* last;
+    if (to_eeprom) {
+        const uint8_t* src = plain_span(memory, bytes);
+        m_cartridge->write_eeprom_stream(src, units);
+        last = src + bytes - 2;
+    } else {
+        uint8_t* dst = writable_span(memory, bytes);
+        if (!dst) return 0;
+        m_cartridge->read_eeprom_stream(dst, units);
+        last = dst + bytes - 2;
+    }
+    dma.latch = last[0] | (last[1] << 8);
+
+    int src_adj = (dma.control >> 7) & 3;
+    int dst_adj = (dma.control >> 5) & 3;
+    if (src_adj == 1) {
+        dma.internal_src -= bytes;
+    } else if (src_adj != 2) {
+        dma.internal_src += bytes;
+    }
+    if (dst_adj == 1) {
+        dma.internal_dst -= bytes;
+    } else if (dst_adj != 2) {
+        dma.internal_dst += bytes;
+    }
+    dma.current_unit += units;
+    dma.first_access = false;
+    dma.phase = DMAChannel::Phase::Complete;
+    return cycles;
+}
+
 // Complete a DMA transfer
 void Bus::complete_dma(int channel) {
     DMAChannel& dma = m_dma[channel];
@@ -1451,6 +1911,25 @@ int Bus::step_dma(int available_cycles) {
             }
 
             case DMAChannel::Phase::Read: {
+                // Runs between plain memory, and EEPROM commands, move as
+                // one block
+                int bulk_cycles = 0;
+                if (timing == 3 && (channel == 1 || channel == 2)) {
+                    bulk_cycles = dma_fifo_transfer(dma, available_cycles);
+                } else {
+                    if (channel == 3 && !is_32bit) {
+                        bulk_cycles = dma_eeprom_transfer(dma, transfer_count, available_cycles);
+                    }
+                    if (bulk_cycles == 0) {
+                        bulk_cycles = dma_bulk_transfer(dma, transfer_count, is_32bit, available_cycles);
+                    }
+                }
+                if (bulk_cycles > 0) {
+                    cycles_used += bulk_cycles;
+                    available_cycles -= bulk_cycles;
+                    break;
+                }
+
                 // Calculate read cycles
                 bool src_seq = !dma.first_access;
                 int read_cycles = get_dma_access_cycles(dma.internal_src, src_seq, is_32bit);
@@ -1620,93 +2099,160 @@ void Bus::write_timer_control(int timer_idx, uint16_t value) {
     // When timer is enabled (bit 7 goes from 0 to 1), reload counter
     bool was_enabled = old_control & 0x80;
     bool now_enabled = value & 0x80;
+    bool was_counting = is_timer_counting(timer_idx);
+    bool timing_changed = ((old_control ^ value) & 0x87) != 0;  // Enable, cascade or prescaler
 
     if (!was_enabled && now_enabled) {
-        // Timer is being enabled - reload counter and reset prescaler
+        // Timer is being enabled - reload counter
         // Timer starts counting on the cycle AFTER the enable write completes
         timer.counter = timer.reload;
-        timer.initial_reload = timer.reload;  // Snapshot reload value for this counting cycle
-        timer.prescaler_counter = 0;
-        // Record the current cycle - the timer will start counting from the next cycle
-        timer.last_enabled_cycle = m_global_cycles;
         GBA_DEBUG_PRINT("Timer%d: Enabled, reload=0x%04X, starting at cycle %llu\n",
-                       timer_idx, timer.reload, (unsigned long long)timer.last_enabled_cycle);
-    } else if (was_enabled && !now_enabled) {
-        // Timer is being disabled - freeze the counter value by computing it now
-        // This ensures we have the correct value when read while disabled
+                       timer_idx, timer.reload, (unsigned long long)m_global_cycles);
+    } else if (was_counting && timing_changed) {
+        // Stopping, switching to cascade or changing prescaler - freeze the
+        // counter value by computing it now. This ensures we have the
+        // correct value when read while disabled, and a new period counts on from it
         timer.counter = get_timer_counter(timer_idx);
-        GBA_DEBUG_PRINT("Timer%d: Disabled, frozen at counter=0x%04X\n", timer_idx, timer.counter);
+        GBA_DEBUG_PRINT("Timer%d: Stopped at counter=0x%04X\n", timer_idx, timer.counter);
     }
 
     timer.control = value;
+
+    if (is_timer_counting(timer_idx) && timing_changed) {
+        start_timer_period(timer_idx, timer.counter, m_global_cycles);
+    }
 }
 
-void Bus::step_timers(int cycles) {
-    // Update global cycle counter for accurate timer reads
-    m_global_cycles += cycles;
+void Bus::start_timer_period(int idx, uint16_t from, uint64_t cycle) {
+    static const int prescaler_shifts[] = {0, 6, 8, 10};
+    Timer& timer = m_timers[idx];
+    timer.counter = from;
+    timer.initial_reload = from;
+    timer.last_enabled_cycle = cycle;
+    timer.overflow_cycle = cycle + (static_cast<uint64_t>(0x10000 - from) << prescaler_shifts[timer.control & 3]);
+}
 
-    static const int prescaler_values[] = {1, 64, 256, 1024};
+void Bus::overflow_timer(int idx, uint64_t cycle) {
+    Timer& timer = m_timers[idx];
 
-    for (int i = 0; i < 4; i++) {
-        Timer& timer = m_timers[i];
+    // Overflow - reload counter with the current reload value
+    // (not initial_reload - the reload register can be updated mid-cycle
+    // and the new value is used on the NEXT overflow)
+    if (is_timer_counting(idx)) {
+        // The next period starts exactly at this overflow
+        start_timer_period(idx, timer.reload, timer.overflow_cycle);
+    } else {
+        timer.counter = timer.reload;
+        timer.initial_reload = timer.reload;
+    }
 
-        // Skip if not enabled
-        if (!(timer.control & 0x80)) continue;
+    // Request interrupt if enabled
+    // Timer interrupts are at bits 3-6 (0x0008, 0x0010, 0x0020, 0x0040)
+    if (timer.control & 0x40) {
+        request_interrupt(static_cast<GBAInterrupt>(0x0008 << idx));
+    }
 
-        // Skip if cascade mode (handled by previous timer)
-        if ((timer.control & 0x04) && i > 0) continue;
+    // Notify APU of timer overflow for Direct Sound, once it has played up
+    // to the overflow
+    if (m_apu && (idx == 0 || idx == 1)) {
+        run_apu_to(cycle);
+        m_apu->on_timer_overflow(idx);
+    }
 
-        int prescaler = prescaler_values[timer.control & 3];
-        timer.prescaler_counter += cycles;
+    // Handle cascade to next timer
+    if (idx < 3 && (m_timers[idx + 1].control & 0x84) == 0x84) {
+        Timer& next = m_timers[idx + 1];
+        next.counter++;
+        if (next.counter == 0) {
+            overflow_timer(idx + 1, cycle);
+        }
+    }
+}
 
-        while (timer.prescaler_counter >= prescaler) {
-            timer.prescaler_counter -= prescaler;
-            timer.counter++;
+void Bus::sync_components() {
+    if (m_pending_cycles >= m_next_event) m_event_count++;
+    catch_up();
+    m_sync_requested = false;
 
-            if (timer.counter == 0) {
-                // Overflow - reload counter with the current reload value
-                // (not initial_reload - the reload register can be updated mid-cycle
-                // and the new value is used on the NEXT overflow)
-                timer.counter = timer.reload;
+    m_next_event = cycles_until_timer_event();
+    if (m_ppu) m_next_event = std::min(m_next_event, m_ppu->cycles_until_event());
+}
 
-                // Update initial_reload for the next counting cycle
-                // This is used by get_timer_counter() to track elapsed ticks
-                timer.initial_reload = timer.reload;
+void Bus::catch_up() {
+    if (m_pending_cycles == 0) return;
 
-                // Reset the reference point for accurate reads
-                // The timer is now counting from reload to 0xFFFF again
-                timer.last_enabled_cycle = m_global_cycles;
-                timer.prescaler_counter = 0;
+    int cycles = m_pending_cycles;
+    m_pending_cycles = 0;
 
-                // Request interrupt if enabled
-                if (timer.control & 0x40) {
-                    request_interrupt(static_cast<GBAInterrupt>(0x0008 << i));
-                }
+    emu::ProfileSection previous = m_profile ? m_profile->get() : emu::ProfileSection::Other;
+    if (m_profile) m_profile->set(emu::ProfileSection::PPU);
+    if (m_ppu) m_ppu->step(cycles);
+    if (m_profile) m_profile->set(previous);
 
-                // Notify APU of timer overflow for Direct Sound
-                if (m_apu && (i == 0 || i == 1)) {
-                    m_apu->on_timer_overflow(i);
-                }
+    // The APU runs in pieces between timer overflows, so each Direct Sound
+    // sample starts on the cycle that played it however long the batch
+    m_apu_cycle = m_global_cycles;
+    step_timers(cycles);
+    run_apu_to(m_global_cycles);
+}
 
-                // Handle cascade to next timer
-                if (i < 3 && (m_timers[i + 1].control & 0x84) == 0x84) {
-                    m_timers[i + 1].counter++;
-                    if (m_timers[i + 1].counter == 0) {
-                        m_timers[i + 1].counter = m_timers[i + 1].reload;
-                        m_timers[i + 1].initial_reload = m_timers[i + 1].reload;
-                        if (m_timers[i + 1].control & 0x40) {
-                            // Timer interrupts are at bits 3-6 (0x0008, 0x0010, 0x0020, 0x0040)
-                            // For timer i+1, the interrupt is 0x0008 << (i+1)
-                            request_interrupt(static_cast<GBAInterrupt>(0x0008 << (i + 1)));
-                        }
-                        // Also notify APU for cascaded timer 1
-                        if (m_apu && (i + 1 == 0 || i + 1 == 1)) {
-                            m_apu->on_timer_overflow(i + 1);
-                        }
-                    }
-                }
+void Bus::run_apu_to(uint64_t cycle) {
+    if (!m_apu || cycle <= m_apu_cycle) return;
+
+    emu::ProfileSection previous = m_profile ? m_profile->get() : emu::ProfileSection::Other;
+    if (m_profile) m_profile->set(emu::ProfileSection::APU);
+    m_apu->step(static_cast<int>(cycle - m_apu_cycle));
+    if (m_profile) m_profile->set(previous);
+    m_apu_cycle = cycle;
+}
+
+uint64_t Bus::overflows_until_visible(int idx) const {
+    const Timer& timer = m_timers[idx];
+    if (timer.control & 0x40) return 1;
+    if (idx < 3 && (m_timers[idx + 1].control & 0x84) == 0x84) return 1;
+    if (m_apu && idx < 2) return static_cast<uint64_t>(m_apu->overflows_until_fifo_request(idx));
+    return 0;
+}
+
+int Bus::cycles_until_timer_event() const {
+    // The APU frame sequencer and FIFO DMA need no events of their own:
+    // FIFO DMA is driven by timer overflows, and the APU is only visible
+    // through IO registers, which catch up before they are accessed.
+    // Overflows nothing else sees, such as those playing samples out of a
+    // well-filled FIFO, run inside a batch; the event is the first one that
+    // raises an IRQ, counts a cascading timer or asks for a refill.
+    static const int prescaler_shifts[] = {0, 6, 8, 10};
+    uint64_t next = std::numeric_limits<int>::max();
+    for (int i = 0; i < 4; i++) {
+        if (!is_timer_counting(i)) continue;
+        uint64_t overflows = overflows_until_visible(i);
+        if (overflows == 0) continue;
+        const Timer& timer = m_timers[i];
+        uint64_t period = static_cast<uint64_t>(0x10000 - timer.reload) << prescaler_shifts[timer.control & 3];
+        uint64_t cycle = timer.overflow_cycle + (overflows - 1) * period;
+        uint64_t until = cycle > m_global_cycles ? cycle - m_global_cycles : 1;
+        next = std::min(next, until);
+    }
+    return static_cast<int>(next);
+}
+
+void Bus::step_timers(int cycles) {
+    // Update global cycle counter for accurate timer reads
+    m_global_cycles += cycles;
+
+    // Overflows in the order they happen, lower timers first on the same
+    // cycle; a cascade from one lands in the next at once, as when they were
+    // stepped a cycle at a time
+    for (;;) {
+        int due = -1;
+        for (int i = 0; i < 4; i++) {
+            if (is_timer_counting(i) && m_timers[i].overflow_cycle <= m_global_cycles &&
+                (due < 0 || m_timers[i].overflow_cycle < m_timers[due].overflow_cycle)) {
+                due = i;
             }
         }
+        if (due < 0) break;
+        overflow_timer(due, m_timers[due].overflow_cycle);
     }
 }
 
@@ -1715,13 +2261,20 @@ uint32_t Bus::get_open_bus_value(uint32_t address) {
     return m_last_read_value;
 }
 
-void Bus::save_state(std::vector<uint8_t>& data) {
+void Bus::save_state(StateWriter& data) {
+    save_work_ram(data);
+    save_registers(data);
+}
+
+void Bus::save_work_ram(StateWriter& data) {
     // Save EWRAM
-    data.insert(data.end(), m_ewram.begin(), m_ewram.end());
+    data.write(m_ewram.data(), m_ewram.size());
 
     // Save IWRAM
-    data.insert(data.end(), m_iwram.begin(), m_iwram.end());
+    data.write(m_iwram.data(), m_iwram.size());
+}
 
+void Bus::save_registers(StateWriter& data) {
     // Save key I/O registers
     auto save16 = [&data](uint16_t val) {
         data.push_back(val & 0xFF);
@@ -1741,6 +2294,13 @@ void Bus::save_state(std::vector<uint8_t>& data) {
 }
 
 void Bus::load_state(const uint8_t*& data, size_t& remaining) {
+    load_work_ram(data, remaining);
+    load_registers(data, remaining);
+}
+
+void Bus::load_work_ram(const uint8_t*& data, size_t& remaining) {
+    if (remaining < m_ewram.size() + m_iwram.size()) return;
+
     // Load EWRAM
     std::memcpy(m_ewram.data(), data, m_ewram.size());
     data += m_ewram.size();
@@ -1751,6 +2311,10 @@ void Bus::load_state(const uint8_t*& data, size_t& remaining) {
     data += m_iwram.size();
     remaining -= m_iwram.size();
 
+    if (m_cpu) m_cpu->invalidate_ram_code();
+}
+
+void Bus::load_registers(const uint8_t*& data, size_t& remaining) {
     // Load key I/O registers
     auto load16 = [&data, &remaining]() {
         uint16_t val = data[0] | (data[1] << 8);
@@ -1767,6 +2331,11 @@ void Bus::load_state(const uint8_t*& data, size_t& remaining) {
     m_ime = load16();
     m_keyinput = load16();
     m_if_serviced = load16();
+    update_irq_line();
+
+    m_pending_cycles = 0;
+    m_sync_requested = true;
+    m_event_count++;
 }
 
 void Bus::flush_debug_string() {
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "types.hpp"
+#include "emu/profile.hpp"
+#include "emu/breakpoints.hpp"
+#include "emu/state_writer.hpp"
+#include "emu/write_watch.hpp"
 #include <cstdint>
 #include <array>
 #include <vector>
@@ -11,6 +15,7 @@ class ARM7TDMI;
 class PPU;
 class APU;
 class Cartridge;
+using emu::StateWriter;
 
 // GBA Memory Bus with proper timing
 class Bus {
@@ -20,9 +25,12 @@ public:
 
     // Connect components
     void connect_cpu(ARM7TDMI* cpu) { m_cpu = cpu; }
-    void connect_ppu(PPU* ppu) { m_ppu = ppu; }
+    void connect_ppu(PPU* ppu) { m_ppu = ppu; map_pages(); }
     void connect_apu(APU* apu) { m_apu = apu; }
-    void connect_cartridge(Cartridge* cart) { m_cartridge = cart; }
+
+    // Marker catch_up() points at the PPU and APU while it runs them
+    void set_profile_marker(emu::ProfileMarker* marker) { m_profile = marker; }
+    void connect_cartridge(Cartridge* cart) { m_cartridge = cart; map_pages(); }
 
     // Memory access
     uint8_t read8(uint32_t address);
@@ -32,6 +40,21 @@ public:
     void write16(uint32_t address, uint16_t value);
     void write32(uint32_t address, uint32_t value);
 
+    // Copy length bytes from address for debuggers and memory domains:
+    // plain memory a page-table run at a time, the rest through peek8()
+    void read_block(uint32_t address, size_t length, uint8_t* out);
+
+    // Work RAM, for memory domains
+    const uint8_t* get_ewram_data() const { return m_ewram.data(); }
+    const uint8_t* get_iwram_data() const { return m_iwram.data(); }
+
+    // Watchpoints checked on every CPU write, or nullptr for none
+    void set_write_watch(emu::WriteWatchpoints* watch) { m_write_watch = watch; }
+
+    // Read and write breakpoints, or nullptr for none. Regions holding one
+    // leave the page table so their accesses reach the checks.
+    void set_breakpoints(emu::Breakpoints* breakpoints) { m_breakpoints = breakpoints; map_pages(); }
+
     // Unaligned write support (needed for correct SRAM byte selection)
     void write16_unaligned(uint32_t address, uint16_t value);
     void write32_unaligned(uint32_t address, uint32_t value);
@@ -43,12 +66,25 @@ public:
     // Input handling
     void set_input_state(uint32_t buttons);
 
+    // Set when the game reads KEYINPUT, or has the keypad IRQ enabled. The
+    // frame loop clears it before setting each frame's input, so it ends
+    // the frame false on a lag frame.
+    bool was_keyinput_read() const { return m_keyinput_read; }
+    void clear_keyinput_read() { m_keyinput_read = false; }
+
     // BIOS protection simulation - update the "last BIOS read" value
     // Used by HLE BIOS functions to simulate proper BIOS behavior
     void set_last_bios_read(uint32_t value) { m_last_bios_read = value; }
 
-    // Interrupt handling
-    bool check_interrupts();
+    // Interrupt handling. Edge-triggered: only signals an IRQ for pending
+    // interrupts that haven't been serviced yet, so the same one can't
+    // re-trigger while its handler runs.
+    bool check_interrupts() {
+        if (!m_irq_line) return false;
+        m_if_serviced |= m_ie & m_if;
+        m_irq_line = false;
+        return true;
+    }
     void request_interrupt(GBAInterrupt irq);
 
     // DMA access
@@ -62,10 +98,49 @@ public:
     void step_timers(int cycles);
     void write_timer_control(int timer, uint16_t value);
 
+    // Event scheduling
+    // Component cycles are banked here instead of being stepped after every
+    // instruction. Returns true once the nearest posted event (HBlank, end of
+    // line, timer overflow) is due or IO was touched, at which point the
+    // caller runs sync_components() and checks interrupts.
+    bool add_cycles(int cycles) {
+        m_pending_cycles += cycles;
+        return m_pending_cycles >= m_next_event || m_sync_requested;
+    }
+    void sync_components();
+
+    bool is_sync_requested() const { return m_sync_requested; }
+
+    // Cycles until the nearest event fires (1 while a resync is pending)
+    int cycles_until_event() const {
+        return m_sync_requested ? 1 : m_next_event - m_pending_cycles;
+    }
+
+    // Bumped whenever memory or registers can change without a CPU store:
+    // component events, IRQ requests, IO writes, DMA, input and state loads
+    uint32_t get_event_count() const { return m_event_count; }
+
+    bool is_dma_pending() { return find_highest_priority_dma() >= 0; }
+
     // Save state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
 
+    // The two halves of save_state(), which are separate state chunks:
+    // EWRAM and IWRAM, and the I/O registers
+    void save_work_ram(StateWriter& data);
+    void load_work_ram(const uint8_t*& data, size_t& remaining);
+    void save_registers(StateWriter& data);
+    void load_registers(const uint8_t*& data, size_t& remaining);
+
+    // Write stamps for incremental captures (see GBAPlugin::mark_state_capture)
+    // One per 256 bytes of EWRAM then IWRAM, in work RAM chunk order; each
+    // holds the stamp current when the bytes were last stored to
+    static constexpr int RAM_STAMP_SHIFT = 8;
+    static constexpr size_t RAM_STAMP_PAGES = (0x40000 + 0x8000) >> RAM_STAMP_SHIFT;
+    const std::array<uint32_t, RAM_STAMP_PAGES>& get_ram_stamps() const { return m_ram_stamps; }
+    void set_write_stamp(uint32_t stamp) { m_write_stamp = stamp; }
+
     // PPU register access
     uint16_t get_bgcnt(int layer) const { return m_bgcnt[layer]; }
     uint16_t get_bghofs(int layer) const { return m_bghofs[layer]; }
@@ -101,17 +176,54 @@ public:
     uint16_t get_if() const { return m_if; }
     uint16_t get_ime() const { return m_ime; }
 
-    // Wait state calculation (for CPU fetch timing)
-    int get_wait_states(uint32_t address, bool is_sequential, int access_size);
+    // Wait state calculation (for CPU fetch timing), cached per page
+    int get_wait_states(uint32_t address, bool is_sequential, int access_size) const {
+        return m_pages[address >> 24].waits[(is_sequential ? 2 : 0) + (access_size == 32 ? 1 : 0)];
+    }
 
     // Prefetch buffer support
     bool is_prefetch_enabled() const { return (m_waitcnt & (1 << 14)) != 0; }
     int get_rom_s_cycles() const;  // Get sequential wait cycles for ROM WS0 (for prefetch duty)
-    int get_prefetch_duty(uint32_t address) const;  // Get S-cycles for specific ROM region
+    int get_prefetch_duty(uint32_t address) const {  // Get S-cycles for specific ROM region
+        return m_pages[address >> 24].prefetch_duty;
+    }
 
 private:
     // Get memory region
-    MemoryRegion get_region(uint32_t address);
+    MemoryRegion get_region(uint32_t address) const;
+
+    // Reads past the page table, without the breakpoint check
+    uint8_t read8_slow(uint32_t address);
+
+    // read8_slow() without side effects, for read_block(): I/O registers
+    // (KEYINPUT marks the frame as polled) and EEPROM (reads clock its
+    // serial state) read as open bus, and BIOS reads don't move the
+    // protection latch
+    uint8_t peek8(uint32_t address) const;
+    uint16_t read16_slow(uint32_t address);
+    uint32_t read32_slow(uint32_t address);
+
+    // Memory page table, one entry per address bits 24-31
+    // Reads of plain memory go straight through 'data' when the masked
+    // offset is below 'limit'; everything else (BIOS protection, IO, VRAM
+    // mirrors, GPIO, EEPROM, SRAM) keeps limit 0 and takes the region switch.
+    // Work RAM also gets a 'write' pointer: its stores have no side effects
+    // beyond code invalidation, so they skip the switch too.
+    // Waits are indexed [sequential * 2 + is_32bit].
+    struct Page {
+        const uint8_t* data = nullptr;
+        uint8_t* write = nullptr;
+        uint32_t mask = 0;
+        uint32_t limit = 0;
+        std::array<uint8_t, 4> waits{};
+        uint8_t prefetch_duty = 2;
+    };
+    std::array<Page, 256> m_pages;
+
+    void map_pages();           // Rebuild data pointers after connecting components
+    void update_wait_states();  // Rebuild cached timing after a WAITCNT write
+    int calc_wait_states(uint32_t address, bool is_sequential, int access_size) const;
+    int calc_prefetch_duty(uint32_t address) const;
 
     // Open bus behavior
     uint32_t get_open_bus_value(uint32_t address);
@@ -127,6 +239,17 @@ private:
     std::array<uint8_t, 0x40000> m_ewram;    // 256KB External WRAM
     std::array<uint8_t, 0x8000> m_iwram;     // 32KB Internal WRAM
 
+    // Every EWRAM/IWRAM store ends here: stamps the pages and drops the
+    // code cached from them
+    static uint32_t ram_stamp_page(uint32_t address) {
+        if ((address >> 24) == 0x02) return (address & 0x3FFFF) >> RAM_STAMP_SHIFT;
+        return (0x40000 + (address & 0x7FFF)) >> RAM_STAMP_SHIFT;
+    }
+    void ram_written(uint32_t address);
+    void ram_written_range(uint32_t address, uint32_t size);
+    std::array<uint32_t, RAM_STAMP_PAGES> m_ram_stamps{};
+    uint32_t m_write_stamp = 0;
+
     // I/O Registers (directly mapped for fast access)
     // Display
     uint16_t m_dispcnt = 0;      // 0x4000000 - LCD Control
@@ -208,18 +331,30 @@ private:
     void run_dma_channel(int channel);  // Legacy atomic DMA (to be replaced)
     int step_dma(int available_cycles); // Cycle-accurate DMA stepping
     int get_dma_access_cycles(uint32_t address, bool is_sequential, bool is_32bit);
+    int dma_bulk_transfer(DMAChannel& dma, uint32_t transfer_count, bool is_32bit,
+                          int available_cycles);
+    int dma_fifo_transfer(DMAChannel& dma, int available_cycles);
+    int dma_eeprom_transfer(DMAChannel& dma, uint32_t transfer_count, int available_cycles);
+    bool is_eeprom_address(uint32_t address) const;
+    const uint8_t* plain_span(uint32_t address, uint32_t bytes) const;
+    uint8_t* writable_span(uint32_t address, uint32_t bytes);
     void schedule_dma(int channel);     // Schedule a DMA to start
     void complete_dma(int channel);     // Handle DMA completion
     int find_highest_priority_dma();    // Find highest priority pending DMA
+    void update_irq_line();             // After IE, IF, IME or serviced bits change
 
     // Timer registers
+    // A timer counting on its own (enabled, not cascading) isn't stepped:
+    // its counter is worked out from the cycles since the period started,
+    // and step_timers() only acts once the global cycle count reaches its
+    // overflow. Cascading timers count in overflow_timer() of the one before.
     struct Timer {
-        uint16_t counter = 0;
+        uint16_t counter = 0;         // Frozen value while disabled or cascading
         uint16_t reload = 0;          // Current reload value (can be modified while running)
-        uint16_t initial_reload = 0;  // Reload value when timer was started (used for counting)
+        uint16_t initial_reload = 0;  // Value the current period started counting from
         uint16_t control = 0;
-        int prescaler_counter = 0;
-        uint64_t last_enabled_cycle = 0;  // Cycle count when timer started counting (after 2-cycle delay)
+        uint64_t last_enabled_cycle = 0;  // Global cycle the current period started at
+        uint64_t overflow_cycle = 0;      // Global cycle the current period overflows at
     };
     std::array<Timer, 4> m_timers;
 
@@ -228,15 +363,41 @@ private:
 
     // Compute timer counter value on-the-fly (for accurate reads during polling)
     uint16_t get_timer_counter(int idx);
+    bool is_timer_counting(int idx) const {
+        uint16_t control = m_timers[idx].control;
+        return (control & 0x80) && !(idx > 0 && (control & 0x04));
+    }
+    void start_timer_period(int idx, uint16_t from, uint64_t cycle);
+    void overflow_timer(int idx, uint64_t cycle);
+    // Overflows of a counting timer until one the CPU can see (0 for none)
+    uint64_t overflows_until_visible(int idx) const;
+
+    // Event scheduling state
+    // Catch the PPU, timers and APU up on the banked cycles. No event can be
+    // crossed here, so IO accesses call it mid-instruction to see the
+    // component state as of the end of the previous instruction.
+    void catch_up();
+    int cycles_until_timer_event() const;
+    void run_apu_to(uint64_t cycle);
+    uint64_t m_apu_cycle = 0;      // Global cycle the APU has run to within catch_up()
+    int m_pending_cycles = 0;      // Cycles not yet seen by the PPU, timers and APU
+    int m_next_event = 0;          // Pending cycles at which the nearest event fires
+    bool m_sync_requested = true;  // IO access or IRQ request since the last sync
+    uint32_t m_event_count = 0;
+    emu::ProfileMarker* m_profile = nullptr;
+    emu::WriteWatchpoints* m_write_watch = nullptr;
+    emu::Breakpoints* m_breakpoints = nullptr;
 
     // Interrupt registers
     uint16_t m_ie = 0;       // Interrupt Enable
     uint16_t m_if = 0;       // Interrupt Request Flags
     uint16_t m_ime = 0;      // Interrupt Master Enable
     uint16_t m_if_serviced = 0;  // Tracks which IF bits have already triggered an IRQ
+    bool m_irq_line = false;     // IME set and an enabled, unserviced IF bit
 
     // Key input
     uint16_t m_keyinput = 0x3FF;  // All buttons released
+    bool m_keyinput_read = false;
     uint16_t m_keycnt = 0;
 
     // Wait state control
@@ -260,10 +421,6 @@ private:
     uint16_t m_fifo_a_latch = 0;
     uint16_t m_fifo_b_latch = 0;
 
-    // Wait state lookup tables (populated based on WAITCNT)
-    std::array<int, 16> m_ws_n;  // Non-sequential
-    std::array<int, 16> m_ws_s;  // Sequential
-
     // mGBA debug registers (for test ROM output)
     // 0x04FFF600-0x04FFF6FF: 256-byte debug string buffer
     // 0x04FFF700: Debug flags (write level|0x100 to flush)
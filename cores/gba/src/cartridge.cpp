@@ -1,9 +1,12 @@
 #include "cartridge.hpp"
+#include "emu/rom_crc32.hpp"
 #include "debug.hpp"
+#include "emu/state_writer.hpp"
 #include <cstring>
 #include <iostream>
 #include <algorithm>
 #include <ctime>
+#include <string_view>
 
 namespace gba {
 
@@ -11,9 +14,9 @@ Cartridge::Cartridge() = default;
 Cartridge::~Cartridge() = default;
 
 bool Cartridge::detect_rtc(const uint8_t* data, size_t size) {
-    // Check for RTC identifier string in ROM
-    std::string rom_str(reinterpret_cast<const char*>(data), size);
-    if (rom_str.find("RTC_V") != std::string::npos) {
+    // Check for RTC identifier string in ROM (viewed in place, not copied)
+    std::string_view rom_str(reinterpret_cast<const char*>(data), size);
+    if (rom_str.find("RTC_V") != std::string_view::npos) {
         return true;
     }
 
@@ -43,12 +46,13 @@ bool Cartridge::detect_rtc(const uint8_t* data, size_t size) {
 
 SaveType Cartridge::detect_save_type(const uint8_t* data, size_t size) {
     // Search for save type strings in ROM
-    // These strings are placed by the SDK to indicate save type
-    std::string rom_str(reinterpret_cast<const char*>(data), size);
+    // These strings are placed by the SDK to indicate save type. The ROM is
+    // viewed in place: copying a 32MB image per check dominated load time.
+    std::string_view rom_str(reinterpret_cast<const char*>(data), size);
 
     // Check for Flash 1M (128KB) first - most specific
-    if (rom_str.find("FLASH1M_V") != std::string::npos ||
-        rom_str.find("FLASH1M_") != std::string::npos) {
+    if (rom_str.find("FLASH1M_V") != std::string_view::npos ||
+        rom_str.find("FLASH1M_") != std::string_view::npos) {
         if (is_debug_mode()) {
             std::cout << "[GBA] Detected save type: Flash 128KB" << std::endl;
         }
@@ -56,8 +60,8 @@ SaveType Cartridge::detect_save_type(const uint8_t* data, size_t size) {
     }
 
     // Check for Flash 512K (64KB)
-    if (rom_str.find("FLASH_V") != std::string::npos ||
-        rom_str.find("FLASH512_V") != std::string::npos) {
+    if (rom_str.find("FLASH_V") != std::string_view::npos ||
+        rom_str.find("FLASH512_V") != std::string_view::npos) {
         if (is_debug_mode()) {
             std::cout << "[GBA] Detected save type: Flash 64KB" << std::endl;
         }
@@ -65,7 +69,7 @@ SaveType Cartridge::detect_save_type(const uint8_t* data, size_t size) {
     }
 
     // Check for EEPROM
-    if (rom_str.find("EEPROM_V") != std::string::npos) {
+    if (rom_str.find("EEPROM_V") != std::string_view::npos) {
         // Determine EEPROM size based on ROM size
         // Large ROMs (>16MB) typically use 8KB EEPROM
         if (is_debug_mode()) {
@@ -75,8 +79,8 @@ SaveType Cartridge::detect_save_type(const uint8_t* data, size_t size) {
     }
 
     // Check for SRAM
-    if (rom_str.find("SRAM_V") != std::string::npos ||
-        rom_str.find("SRAM_F_V") != std::string::npos) {
+    if (rom_str.find("SRAM_V") != std::string_view::npos ||
+        rom_str.find("SRAM_F_V") != std::string_view::npos) {
         if (is_debug_mode()) {
             std::cout << "[GBA] Detected save type: SRAM 32KB" << std::endl;
         }
@@ -91,15 +95,22 @@ SaveType Cartridge::detect_save_type(const uint8_t* data, size_t size) {
 }
 
 bool Cartridge::load(const uint8_t* data, size_t size, SystemType system_type) {
+    return load(emu::make_rom_image(data, size), system_type);
+}
+
+bool Cartridge::load(std::shared_ptr<const emu::RomImage> rom, SystemType system_type) {
     (void)system_type;  // Always GBA for this plugin
 
-    if (size < 0xC0) {
+    if (!rom || rom->size() < 0xC0) {
         std::cerr << "GBA ROM too small" << std::endl;
         return false;
     }
 
-    // Copy ROM
-    m_rom.assign(data, data + size);
+    m_rom = std::move(rom);
+    m_rom_data = m_rom->data();
+    m_rom_size = m_rom->size();
+    const uint8_t* data = m_rom_data;
+    size_t size = m_rom_size;
 
     // Extract title (at 0xA0, 12 bytes)
     m_title.clear();
@@ -153,7 +164,7 @@ bool Cartridge::load(const uint8_t* data, size_t size, SystemType system_type) {
     m_rtc_byte_count = 0;
     m_rtc_last_sck = false;
 
-    m_crc32 = calculate_crc32(data, size);
+    m_crc32 = emu::rom_crc32(data, size);
     m_loaded = true;
 
     std::cout << "GBA ROM loaded: " << m_title << std::endl;
@@ -161,7 +172,9 @@ bool Cartridge::load(const uint8_t* data, size_t size, SystemType system_type) {
 }
 
 void Cartridge::unload() {
-    m_rom.clear();
+    m_rom.reset();
+    m_rom_data = nullptr;
+    m_rom_size = 0;
     m_save_data.clear();
     m_loaded = false;
     m_crc32 = 0;
@@ -193,8 +206,7 @@ uint8_t Cartridge::read_rom(uint32_t address) {
                     if (!(m_gpio_direction & GPIO_SIO)) {
                         value = (value & ~GPIO_SIO) | rtc_get_output();
                     }
-                    static int read_count = 0;
-                    if (is_debug_mode() && ++read_count <= 20) {
+                    if (is_debug_mode() && ++m_debug_gpio_reads <= 20) {
                         fprintf(stderr, "[GBA] GPIO read 0xC4: dir=%02X ctrl=%02X returning %02X\n",
                                m_gpio_direction, m_gpio_control, value);
                     }
@@ -214,8 +226,8 @@ uint8_t Cartridge::read_rom(uint32_t address) {
         }
     }
 
-    if (address < m_rom.size()) {
-        return m_rom[address];
+    if (address < m_rom_size) {
+        return m_rom_data[address];
     }
     // Return open bus value for reads past ROM end
     // (address / 2) & 0xFF for each byte
@@ -225,8 +237,7 @@ uint8_t Cartridge::read_rom(uint32_t address) {
 void Cartridge::write_rom(uint32_t address, uint8_t value) {
     // Handle GPIO writes for RTC games
     if (m_has_rtc && address >= 0xC4 && address <= 0xC9) {
-        static int write_count = 0;
-        if (is_debug_mode() && ++write_count <= 50) {
+        if (is_debug_mode() && ++m_debug_gpio_writes <= 50) {
             fprintf(stderr, "[GBA] GPIO write [%02X] = %02X\n", address & 0xFF, value);
         }
 
@@ -361,6 +372,7 @@ void Cartridge::write_flash(uint32_t address, uint8_t value) {
             if (addr == 0x5555 && value == 0x10) {
                 // Erase entire chip
                 std::fill(m_save_data.begin(), m_save_data.end(), 0xFF);
+                m_save_generation++;
                 m_flash_state = FlashState::Ready;
             } else if (value == 0x30) {
                 // Sector erase (4KB sectors)
@@ -371,6 +383,7 @@ void Cartridge::write_flash(uint32_t address, uint8_t value) {
                 for (uint32_t i = 0; i < 0x1000 && (sector_base + i) < m_save_data.size(); i++) {
                     m_save_data[sector_base + i] = 0xFF;
                 }
+                m_save_generation++;
                 m_flash_state = FlashState::Ready;
             } else {
                 m_flash_state = FlashState::Ready;
@@ -386,6 +399,7 @@ void Cartridge::write_flash(uint32_t address, uint8_t value) {
                 }
                 if (actual_address < m_save_data.size()) {
                     m_save_data[actual_address] &= value;
+                    m_save_generation++;
                 }
                 m_flash_state = FlashState::Ready;
             }
@@ -500,13 +514,7 @@ void Cartridge::write_eeprom(uint8_t value) {
                     // Stop bit after address for read command
                     if (m_eeprom_command == 0x03) {
                         // Load data from EEPROM for reading
-                        uint32_t byte_addr = m_eeprom_address * 8;  // 8 bytes per block
-                        m_eeprom_buffer = 0;
-                        for (int i = 0; i < 8 && (byte_addr + i) < m_save_data.size(); i++) {
-                            m_eeprom_buffer = (m_eeprom_buffer << 8) | m_save_data[byte_addr + i];
-                        }
-                        m_eeprom_state = EEPROMState::SendDummy;
-                        m_eeprom_bits_to_send = 4;
+                        load_eeprom_block();
                     }
                 }
             }
@@ -514,22 +522,12 @@ void Cartridge::write_eeprom(uint8_t value) {
 
         case EEPROMState::ReceiveData:
             // Receiving 64 data bits for write (MSB first)
-            m_eeprom_buffer = (m_eeprom_buffer << 1) | bit;
-            m_eeprom_bits_received++;
-
-            if (m_eeprom_bits_received == 64) {
-                // Data complete, wait for stop bit
-                // The next write should be the stop bit (0)
-                m_eeprom_bits_received = 65;  // Mark that we're waiting for stop
-            } else if (m_eeprom_bits_received == 65) {
+            if (m_eeprom_bits_received < 64) {
+                m_eeprom_buffer = (m_eeprom_buffer << 1) | bit;
+                m_eeprom_bits_received++;
+            } else {
                 // This is the stop bit - perform the write
-                uint32_t byte_addr = m_eeprom_address * 8;
-                for (int i = 0; i < 8 && (byte_addr + i) < m_save_data.size(); i++) {
-                    int shift = (7 - i) * 8;
-                    m_save_data[byte_addr + i] = (m_eeprom_buffer >> shift) & 0xFF;
-                }
-                m_eeprom_ready = false;
-                m_eeprom_state = EEPROMState::WriteComplete;
+                store_eeprom_block();
             }
             break;
 
@@ -543,6 +541,79 @@ void Cartridge::write_eeprom(uint8_t value) {
     }
 }
 
+// Read the addressed block into the buffer and start sending it
+void Cartridge::load_eeprom_block() {
+    uint32_t byte_addr = m_eeprom_address * 8;  // 8 bytes per block
+    m_eeprom_buffer = 0;
+    for (int i = 0; i < 8 && (byte_addr + i) < m_save_data.size(); i++) {
+        m_eeprom_buffer = (m_eeprom_buffer << 8) | m_save_data[byte_addr + i];
+    }
+    m_eeprom_state = EEPROMState::SendDummy;
+    m_eeprom_bits_to_send = 4;
+}
+
+// Write the buffer to the addressed block and start the busy period
+void Cartridge::store_eeprom_block() {
+    uint32_t byte_addr = m_eeprom_address * 8;
+    for (int i = 0; i < 8 && (byte_addr + i) < m_save_data.size(); i++) {
+        int shift = (7 - i) * 8;
+        m_save_data[byte_addr + i] = (m_eeprom_buffer >> shift) & 0xFF;
+    }
+    m_save_generation++;
+    m_eeprom_ready = false;
+    m_eeprom_state = EEPROMState::WriteComplete;
+}
+
+void Cartridge::write_eeprom_stream(const uint8_t* halfwords, size_t count) {
+    int addr_bits = (m_save_type == SaveType::EEPROM_8K) ? 14 : 6;
+    size_t request_bits = 2 + static_cast<size_t>(addr_bits) + 1;
+    size_t write_bits = request_bits + 64;
+    auto bit = [halfwords](size_t i) { return halfwords[i * 2] & 1; };
+
+    // A whole read request or write command sent from idle, as games do
+    bool whole = m_eeprom_state == EEPROMState::Idle && bit(0) == 1 &&
+                 ((count == request_bits && bit(1) == 1) || (count == write_bits && bit(1) == 0));
+    if (!whole) {
+        for (size_t i = 0; i < count; i++) write_eeprom(bit(i));
+        return;
+    }
+
+    m_eeprom_command = static_cast<uint8_t>(2 | bit(1));
+    m_eeprom_address = 0;
+    for (int i = 0; i < addr_bits; i++) {
+        m_eeprom_address = static_cast<uint16_t>((m_eeprom_address << 1) | bit(2 + i));
+    }
+    m_eeprom_bits_received = 0;
+    if (m_eeprom_command == 0x03) {
+        load_eeprom_block();
+        return;
+    }
+
+    m_eeprom_buffer = 0;
+    for (int i = 0; i < 64; i++) {
+        m_eeprom_buffer = (m_eeprom_buffer << 1) | bit(2 + addr_bits + i);
+    }
+    store_eeprom_block();
+}
+
+void Cartridge::read_eeprom_stream(uint8_t* halfwords, size_t count) {
+    // The whole reply to a read request: 4 dummy bits, then the block
+    if (m_eeprom_state == EEPROMState::SendDummy && m_eeprom_bits_to_send == 4 && count == 68) {
+        for (size_t i = 0; i < 68; i++) {
+            halfwords[i * 2] = i < 4 ? 0 : static_cast<uint8_t>((m_eeprom_buffer >> (67 - i)) & 1);
+            halfwords[i * 2 + 1] = 0;
+        }
+        m_eeprom_bits_to_send = 0;
+        m_eeprom_state = EEPROMState::Idle;
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        halfwords[i * 2] = read_eeprom();
+        halfwords[i * 2 + 1] = 0;
+    }
+}
+
 uint8_t Cartridge::read_sram(uint32_t address) {
     switch (m_save_type) {
         case SaveType::Flash_64K:
@@ -578,6 +649,7 @@ void Cartridge::write_sram(uint32_t address, uint8_t value) {
             // SRAM is mirrored in the 64KB region
             if (!m_save_data.empty()) {
                 m_save_data[address % m_save_data.size()] = value;
+                m_save_generation++;
             }
             break;
 
@@ -608,63 +680,9 @@ bool Cartridge::set_save_data(const std::vector<uint8_t>& data) {
     return true;
 }
 
-uint32_t Cartridge::calculate_crc32(const uint8_t* data, size_t size) {
-    static const uint32_t crc_table[256] = {
-        0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F,
-        0xE963A535, 0x9E6495A3, 0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988,
-        0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91, 0x1DB71064, 0x6AB020F2,
-        0xF3B97148, 0x84BE41DE, 0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7,
-        0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC, 0x14015C4F, 0x63066CD9,
-        0xFA0F3D63, 0x8D080DF5, 0x3B6E20C8, 0x4C69105E, 0xD56041E4, 0xA2677172,
-        0x3C03E4D1, 0x4B04D447, 0xD20D85FD, 0xA50AB56B, 0x35B5A8FA, 0x42B2986C,
-        0xDBBBC9D6, 0xACBCF940, 0x32D86CE3, 0x45DF5C75, 0xDCD60DCF, 0xABD13D59,
-        0x26D930AC, 0x51DE003A, 0xC8D75180, 0xBFD06116, 0x21B4F4B5, 0x56B3C423,
-        0xCFBA9599, 0xB8BDA50F, 0x2802B89E, 0x5F058808, 0xC60CD9B2, 0xB10BE924,
-        0x2F6F7C87, 0x58684C11, 0xC1611DAB, 0xB6662D3D, 0x76DC4190, 0x01DB7106,
-        0x98D220BC, 0xEFD5102A, 0x71B18589, 0x06B6B51F, 0x9FBFE4A5, 0xE8B8D433,
-        0x7807C9A2, 0x0F00F934, 0x9609A88E, 0xE10E9818, 0x7F6A0DBB, 0x086D3D2D,
-        0x91646C97, 0xE6635C01, 0x6B6B51F4, 0x1C6C6162, 0x856530D8, 0xF262004E,
-        0x6C0695ED, 0x1B01A57B, 0x8208F4C1, 0xF50FC457, 0x65B0D9C6, 0x12B7E950,
-        0x8BBEB8EA, 0xFCB9887C, 0x62DD1DDF, 0x15DA2D49, 0x8CD37CF3, 0xFBD44C65,
-        0x4DB26158, 0x3AB551CE, 0xA3BC0074, 0xD4BB30E2, 0x4ADFA541, 0x3DD895D7,
-        0xA4D1C46D, 0xD3D6F4FB, 0x4369E96A, 0x346ED9FC, 0xAD678846, 0xDA60B8D0,
-        0x44042D73, 0x33031DE5, 0xAA0A4C5F, 0xDD0D7CC9, 0x5005713C, 0x270241AA,
-        0xBE0B1010, 0xC90C2086, 0x5768B525, 0x206F85B3, 0xB966D409, 0xCE61E49F,
-        0x5EDEF90E, 0x29D9C998, 0xB0D09822, 0xC7D7A8B4, 0x59B33D17, 0x2EB40D81,
-        0xB7BD5C3B, 0xC0BA6CAD, 0xEDB88320, 0x9ABFB3B6, 0x03B6E20C, 0x74B1D29A,
-        0xEAD54739, 0x9DD277AF, 0x04DB2615, 0x73DC1683, 0xE3630B12, 0x94643B84,
-        0x0D6D6A3E, 0x7A6A5AA8, 0xE40ECF0B, 0x9309FF9D, 0x0A00AE27, 0x7D079EB1,
-        0xF00F9344, 0x8708A3D2, 0x1E01F268, 0x6906C2FE, 0xF762575D, 0x806567CB,
-        0x196C3671, 0x6E6B06E7, 0xFED41B76, 0x89D32BE0, 0x10DA7A5A, 0x67DD4ACC,
-        0xF9B9DF6F, 0x8EBEEFF9, 0x17B7BE43, 0x60B08ED5, 0xD6D6A3E8, 0xA1D1937E,
-        0x38D8C2C4, 0x4FDFF252, 0xD1BB67F1, 0xA6BC5767, 0x3FB506DD, 0x48B2364B,
-        0xD80D2BDA, 0xAF0A1B4C, 0x36034AF6, 0x41047A60, 0xDF60EFC3, 0xA867DF55,
-        0x316E8EEF, 0x4669BE79, 0xCB61B38C, 0xBC66831A, 0x256FD2A0, 0x5268E236,
-        0xCC0C7795, 0xBB0B4703, 0x220216B9, 0x5505262F, 0xC5BA3BBE, 0xB2BD0B28,
-        0x2BB45A92, 0x5CB36A04, 0xC2D7FFA7, 0xB5D0CF31, 0x2CD99E8B, 0x5BDEAE1D,
-        0x9B64C2B0, 0xEC63F226, 0x756AA39C, 0x026D930A, 0x9C0906A9, 0xEB0E363F,
-        0x72076785, 0x05005713, 0x95BF4A82, 0xE2B87A14, 0x7BB12BAE, 0x0CB61B38,
-        0x92D28E9B, 0xE5D5BE0D, 0x7CDCEFB7, 0x0BDBDF21, 0x86D3D2D4, 0xF1D4E242,
-        0x68DDB3F8, 0x1FDA836E, 0x81BE16CD, 0xF6B9265B, 0x6FB077E1, 0x18B74777,
-        0x88085AE6, 0xFF0F6A70, 0x66063BCA, 0x11010B5C, 0x8F659EFF, 0xF862AE69,
-        0x616BFFD3, 0x166CCF45, 0xA00AE278, 0xD70DD2EE, 0x4E048354, 0x3903B3C2,
-        0xA7672661, 0xD06016F7, 0x4969474D, 0x3E6E77DB, 0xAED16A4A, 0xD9D65ADC,
-        0x40DF0B66, 0x37D83BF0, 0xA9BCAE53, 0xDEBB9EC5, 0x47B2CF7F, 0x30B5FFE9,
-        0xBDBDF21C, 0xCABAC28A, 0x53B39330, 0x24B4A3A6, 0xBAD03605, 0xCDD706B3,
-        0x54DE5729, 0x23D967BF, 0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94,
-        0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
-    };
-
-    uint32_t crc = 0xFFFFFFFF;
-    for (size_t i = 0; i < size; i++) {
-        crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
-    }
-    return crc ^ 0xFFFFFFFF;
-}
-
-void Cartridge::save_state(std::vector<uint8_t>& data) {
+void Cartridge::save_state(StateWriter& data) {
     // Save save_data
-    data.insert(data.end(), m_save_data.begin(), m_save_data.end());
+    data.write(m_save_data.data(), m_save_data.size());
 
     // Save Flash state
     data.push_back(static_cast<uint8_t>(m_flash_state));
@@ -689,6 +707,7 @@ void Cartridge::load_state(const uint8_t*& data, size_t& remaining) {
     std::memcpy(m_save_data.data(), data, m_save_data.size());
     data += m_save_data.size();
     remaining -= m_save_data.size();
+    m_save_generation++;
 
     // Load Flash state
     m_flash_state = static_cast<FlashState>(data[0]);
@@ -1,13 +1,18 @@
 #pragma once
 
 #include "types.hpp"
+#include "emu/rom_image.hpp"
+#include "emu/state_writer.hpp"
 #include <cstdint>
 #include <cstddef>
+#include <memory>
 #include <vector>
 #include <string>
 
 namespace gba {
 
+using emu::StateWriter;
+
 // Save types for GBA cartridges
 enum class SaveType {
     None,
@@ -55,8 +60,10 @@ public:
     Cartridge();
     ~Cartridge();
 
-    // Load ROM
+    // Load ROM (the shared form keeps a reference to the image, which is
+    // never written, instead of copying it)
     bool load(const uint8_t* data, size_t size, SystemType system_type);
+    bool load(std::shared_ptr<const emu::RomImage> rom, SystemType system_type);
     void unload();
 
     // Reset
@@ -69,6 +76,13 @@ public:
     uint8_t read_sram(uint32_t address);
     void write_sram(uint32_t address, uint8_t value);
 
+    // EEPROM transfers as DMA moves them: one little-endian halfword per
+    // serial bit, bit 0 significant. A whole read request or write command,
+    // or the whole reply to a read, is handled in one pass; anything else
+    // goes through the bit protocol.
+    void write_eeprom_stream(const uint8_t* halfwords, size_t count);
+    void read_eeprom_stream(uint8_t* halfwords, size_t count);
+
     // Get CRC32
     uint32_t get_crc32() const { return m_crc32; }
 
@@ -76,19 +90,25 @@ public:
     bool is_loaded() const { return m_loaded; }
     const std::string& get_title() const { return m_title; }
     SaveType get_save_type() const { return m_save_type; }
-    size_t get_rom_size() const { return m_rom.size(); }
+    size_t get_rom_size() const { return m_rom_size; }
+    const uint8_t* get_rom_data() const { return m_rom_data; }
+    size_t get_save_data_size() const { return m_save_data.size(); }
+    const uint8_t* get_save_data_ptr() const { return m_save_data.data(); }  // For memory domains
+    bool has_rtc() const { return m_has_rtc; }
 
     // Battery save support
     bool has_battery() const;
     std::vector<uint8_t> get_save_data() const;
     bool set_save_data(const std::vector<uint8_t>& data);
+    // Bumped on every SRAM write, Flash erase or program, EEPROM block
+    // write and state load
+    uint64_t get_save_generation() const { return m_save_generation; }
 
     // Save state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
 
 private:
-    uint32_t calculate_crc32(const uint8_t* data, size_t size);
     SaveType detect_save_type(const uint8_t* data, size_t size);
 
     // Flash memory handling
@@ -100,9 +120,14 @@ private:
     uint8_t read_eeprom();
     void write_eeprom(uint8_t value);
     void reset_eeprom_state();
+    void load_eeprom_block();
+    void store_eeprom_block();
 
-    std::vector<uint8_t> m_rom;
+    std::shared_ptr<const emu::RomImage> m_rom;
+    const uint8_t* m_rom_data = nullptr;  // m_rom's bytes, cached for read_rom()
+    size_t m_rom_size = 0;
     std::vector<uint8_t> m_save_data;  // SRAM or Flash data
+    uint64_t m_save_generation = 0;
 
     bool m_loaded = false;
     uint32_t m_crc32 = 0;
@@ -157,6 +182,10 @@ private:
     uint8_t rtc_get_output();
     void rtc_process_command();
     bool detect_rtc(const uint8_t* data, size_t size);
+
+    // Debug output limits (DEBUG=1)
+    int m_debug_gpio_reads = 0;
+    int m_debug_gpio_writes = 0;
 };
 
 } // namespace gba
@@ -1,4 +1,7 @@
 #include "emu/emulator_plugin.hpp"
+#include "emu/netplay_plugin.hpp"
+#include "emu/state_chunks.hpp"
+#include "emu/trace.hpp"
 #include "types.hpp"
 #include "arm7tdmi.hpp"
 #include "bus.hpp"
@@ -6,11 +9,16 @@
 #include "apu.hpp"
 #include "cartridge.hpp"
 #include "debug.hpp"
+#include "emu/state_writer.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <string>
 
 namespace gba {
 
@@ -43,7 +51,7 @@ static const emu::ControllerLayoutInfo GBA_CONTROLLER_LAYOUT = {
 };
 
 
-class GBAPlugin : public emu::IEmulatorPlugin {
+class GBAPlugin : public emu::IEmulatorPlugin, public emu::INetplayCapable {
 public:
     GBAPlugin();
     ~GBAPlugin() override;
@@ -54,6 +62,7 @@ public:
 
     // ROM management
     bool load_rom(const uint8_t* data, size_t size) override;
+    bool load_rom_shared(std::shared_ptr<const emu::RomImage> rom) override;
     void unload_rom() override;
     bool is_rom_loaded() const override;
     uint32_t get_rom_crc32() const override;
@@ -61,8 +70,10 @@ public:
     // Emulation
     void reset() override;
     void run_frame(const emu::InputState& input) override;
+    void run_frames(const emu::InputState* inputs, size_t count, emu::RunFlags flags) override;
     uint64_t get_cycle_count() const override;
     uint64_t get_frame_count() const override;
+    bool is_lag_frame() const override { return m_rom_loaded && !m_bus->was_keyinput_read(); }
 
     // Video
     emu::FrameBuffer get_framebuffer() override;
@@ -72,24 +83,85 @@ public:
     void clear_audio_buffer() override;
 
     // Streaming audio (low-latency)
-    void set_audio_callback(AudioStreamCallback callback) override;
+    void set_audio_sink(const emu::AudioStreamSink& sink) override;
+    void set_audio_enabled(bool enabled) override;
+    void set_video_enabled(bool enabled) override;
+    bool set_output_framebuffer(uint32_t* pixels, int pitch) override;
+    const emu::ProfileMarker* get_profile_marker() const override { return &m_profile; }
+    void set_tracer(emu::Tracer* tracer) override { m_tracer = tracer; }
+    bool set_cpu_trace(emu::CpuTrace* trace) override;
 
     // Memory access
     uint8_t read_memory(uint16_t address) override;
     void write_memory(uint16_t address, uint8_t value) override;
+    std::vector<emu::MemoryDomain> get_memory_domains() override;
+    bool read_memory_block(size_t domain, uint32_t address, size_t length, uint8_t* out) override;
+    bool set_write_watchpoints(const uint32_t* addresses, size_t count) override;
+    size_t take_write_watch_hits(emu::WriteWatchHit* out, size_t max) override;
+    bool set_breakpoints(const emu::Breakpoint* breakpoints, size_t count) override;
+    size_t take_breakpoint_hits(emu::BreakpointHit* out, size_t max) override;
 
     // Save states
     bool save_state(std::vector<uint8_t>& data) override;
     bool load_state(const std::vector<uint8_t>& data) override;
+    bool load_state_chunks(const uint8_t* data, size_t size, const uint32_t* tags, size_t tag_count) override;
+    bool clone_into(emu::IEmulatorPlugin* other) override;
 
     // Battery-backed save support
     bool has_battery_save() const override;
     std::vector<uint8_t> get_battery_save_data() const override;
     bool set_battery_save_data(const std::vector<uint8_t>& data) override;
+    uint64_t get_battery_save_generation() const override;
+
+    // Netplay/Rollback support (INetplayCapable)
+    // The core itself is integer-only, but the cartridge RTC reads the host
+    // clock, so RTC cartridges can diverge between peers
+    bool is_deterministic() const override { return !(m_cartridge && m_cartridge->has_rtc()); }
+
+    // The GBA has a single controller, so only player 1 input is used
+    void run_frame_netplay(uint32_t player1_buttons, uint32_t player2_buttons) override;
+    int get_max_players() const override { return 1; }
+
+    // Buttons are read from the VirtualButton bits A through Right
+    int get_input_bits() const override { return 12; }
+
+    // Fast save state for rollback - writes directly to buffer, no allocations
+    size_t get_max_state_size() const override;
+    size_t save_state_fast(uint8_t* buffer, size_t buffer_size) override;
+    bool load_state_fast(const uint8_t* buffer, size_t size) override;
+
+    // Work RAM, VRAM, palette and OAM stores are stamped, so only the
+    // 256-byte pages written since a mark count as changed
+    uint64_t mark_state_capture() override;
+    bool get_changed_state_spans(uint64_t mark, std::vector<emu::StateSpan>& spans) const override;
+
+    // State hash for desync detection
+    uint64_t get_state_hash() const override;
+
+    // Discard audio during rollback re-simulation
+    void discard_audio() override { m_audio_samples = 0; }
+
+    // Configuration
+    bool save_config(const char* path) override;
+    bool load_config(const char* path) override;
 
 private:
     void run_gba_frame(const emu::InputState& input);
 
+    // Shared serialization helpers - used by both the vector-based and the
+    // in-place (rollback) save state paths
+    void serialize_state(StateWriter& out) const;
+    bool deserialize_state(const uint8_t* buffer, size_t size);
+
+    // Chunks with the given tags (all of them for a null list), or a state
+    // from before chunking
+    bool deserialize_chunks(const uint8_t* buffer, size_t size, const uint32_t* tags, size_t tag_count);
+    bool load_state_chunk(const emu::StateChunk& chunk);
+    bool deserialize_unchunked_state(const uint8_t* buffer, size_t size);
+
+    // Domain index of get_memory_domains(); false past the last
+    bool get_memory_domain(size_t index, emu::MemoryDomain& domain) const;
+
     // GBA components
     std::unique_ptr<ARM7TDMI> m_cpu;
     std::unique_ptr<Bus> m_bus;
@@ -97,7 +169,14 @@ private:
     std::unique_ptr<APU> m_apu;
     std::unique_ptr<Cartridge> m_cartridge;
 
+    // Handed to each new bus while any address is watched
+    emu::WriteWatchpoints m_write_watch;
+    emu::Breakpoints m_breakpoints{28, 16};
+    void apply_breakpoints();
+
     bool m_rom_loaded = false;
+    bool m_video_enabled = true;  // False = frames run without drawing
+    bool m_threaded_rendering = false;  // Draw scanlines on a worker thread
     uint32_t m_rom_crc32 = 0;
     uint64_t m_total_cycles = 0;
     uint64_t m_frame_count = 0;
@@ -106,14 +185,48 @@ private:
     static constexpr int SCREEN_WIDTH = 240;
     static constexpr int SCREEN_HEIGHT = 160;
     uint32_t m_framebuffer[SCREEN_WIDTH * SCREEN_HEIGHT];
+    uint32_t* m_output_framebuffer = nullptr;       // Host buffer frames are drawn into, if set
+    uint32_t* m_shown_framebuffer = m_framebuffer;  // Holds the last frame drawn
 
     // Audio buffer
     static constexpr size_t AUDIO_BUFFER_SIZE = 2048;
     float m_audio_buffer[AUDIO_BUFFER_SIZE * 2];  // Stereo
     size_t m_audio_samples = 0;
 
+    // Rollback state size, measured once per cartridge in load_rom()
+    size_t m_max_state_size = 0;
+
+    // Subsystem being run, for the benchmark's breakdown
+    emu::ProfileMarker m_profile;
+
+    // Frame phase tracing, if the host is recording
+    emu::Tracer* m_tracer = nullptr;
+
+    // Instruction trace, if the host is recording one
+    emu::CpuTrace* m_cpu_trace = nullptr;
+
+    // Scratch buffer for get_state_hash(), sized alongside m_max_state_size
+    mutable std::vector<uint8_t> m_hash_buffer;
+
+    // clone_into() stages the state here, on the receiving instance
+    std::vector<uint8_t> m_clone_state;
+
+    // Incremental captures: the bus and PPU stamp stores with m_write_stamp,
+    // and marks are stamps handed out before it. A load or reset counts as a
+    // store to everything at m_load_stamp. The offsets are where VRAM and
+    // EWRAM sit in save_state_fast() states (0 until measured).
+    void set_write_stamp(uint32_t stamp);
+    uint32_t m_write_stamp = 1;
+    uint32_t m_load_stamp = 1;
+    size_t m_state_size = 0;
+    size_t m_video_state_offset = 0;
+    size_t m_work_ram_state_offset = 0;
+
     // Test ROM result tracking (for DEBUG mode)
     bool m_test_result_reported = false;
+    uint32_t m_test_last_pc = 0;
+    int m_test_same_pc_frames = 0;
+    uint64_t m_debug_last_cycles = 0;
 
     // File extensions
     static const char* s_extensions[];
@@ -127,6 +240,8 @@ GBAPlugin::GBAPlugin() {
 
     m_cartridge = std::make_unique<Cartridge>();
     m_apu = std::make_unique<APU>();
+    m_write_watch.set_clock(&m_total_cycles);
+    m_breakpoints.set_clock(&m_total_cycles);
 }
 
 GBAPlugin::~GBAPlugin() = default;
@@ -153,6 +268,14 @@ const emu::ControllerLayoutInfo* GBAPlugin::get_controller_layout() {
 }
 
 bool GBAPlugin::load_rom(const uint8_t* data, size_t size) {
+    return load_rom_shared(emu::make_rom_image(data, size));
+}
+
+bool GBAPlugin::load_rom_shared(std::shared_ptr<const emu::RomImage> rom) {
+    if (!rom) return false;
+    const uint8_t* data = rom->data();
+    size_t size = rom->size();
+
     if (is_debug_mode()) {
         printf("[GBA] Loading ROM: %zu bytes\n", size);
     }
@@ -173,7 +296,7 @@ bool GBAPlugin::load_rom(const uint8_t* data, size_t size) {
     }
 
     // Load the cartridge
-    if (!m_cartridge->load(data, size, SystemType::GameBoyAdvance)) {
+    if (!m_cartridge->load(std::move(rom), SystemType::GameBoyAdvance)) {
         std::cerr << "Failed to load GBA ROM" << std::endl;
         return false;
     }
@@ -181,12 +304,19 @@ bool GBAPlugin::load_rom(const uint8_t* data, size_t size) {
     // Set up GBA system
     m_bus = std::make_unique<Bus>();
     m_cpu = std::make_unique<ARM7TDMI>(*m_bus);
+    m_cpu->set_trace(m_cpu_trace);
     m_ppu = std::make_unique<PPU>(*m_bus);
+    m_ppu->set_video_enabled(m_video_enabled);
+    m_ppu->set_threaded_rendering(m_threaded_rendering);
 
     m_bus->connect_cpu(m_cpu.get());
     m_bus->connect_ppu(m_ppu.get());
     m_bus->connect_apu(m_apu.get());
     m_bus->connect_cartridge(m_cartridge.get());
+    m_bus->set_profile_marker(&m_profile);
+    m_bus->set_write_watch(m_write_watch.empty() ? nullptr : &m_write_watch);
+    apply_breakpoints();
+    set_write_stamp(m_write_stamp);
 
     m_apu->set_system_type(SystemType::GameBoyAdvance);
 
@@ -198,8 +328,38 @@ bool GBAPlugin::load_rom(const uint8_t* data, size_t size) {
 
     m_rom_loaded = true;
     m_rom_crc32 = m_cartridge->get_crc32();
+
+    // No BIOS runs: reset() is the HLE boot path, putting the CPU (banked
+    // stacks, System mode, PC at 0x08000000) and IO (POSTFLG=1) straight
+    // into their post-BIOS state, so the first frame is game code
     reset();
 
+    // State size is fixed once the save type (SRAM/Flash/EEPROM size) is
+    // known, so one sizing pass gives the rollback buffer size. Round up to
+    // 4KB to leave headroom.
+    StateWriter sizer(nullptr, 0);
+    serialize_state(sizer);
+    m_max_state_size = (sizer.size() + 0xFFF) & ~static_cast<size_t>(0xFFF);
+    m_hash_buffer.assign(m_max_state_size, 0);
+
+    // The layout is as fixed as the size, so the tracked memory's offsets
+    // are measured once too
+    m_state_size = sizer.size();
+    m_video_state_offset = 0;
+    m_work_ram_state_offset = 0;
+    StateWriter layout(m_hash_buffer.data(), m_hash_buffer.size());
+    serialize_state(layout);
+    emu::StateChunkReader reader(m_hash_buffer.data(), layout.size());
+    emu::StateChunk chunk;
+    while (reader.next(chunk)) {
+        size_t offset = static_cast<size_t>(chunk.data - m_hash_buffer.data());
+        if (chunk.tag == emu::STATE_CHUNK_PPU && chunk.size >= PPU::STAMP_BLOCKS * 256) {
+            m_video_state_offset = offset;
+        } else if (chunk.tag == emu::STATE_CHUNK_WORK_RAM && chunk.size == Bus::RAM_STAMP_PAGES << Bus::RAM_STAMP_SHIFT) {
+            m_work_ram_state_offset = offset;
+        }
+    }
+
     if (is_debug_mode()) {
         printf("[GBA] ROM loaded successfully, CRC32: 0x%08X\n", m_rom_crc32);
     }
@@ -214,6 +374,8 @@ void GBAPlugin::unload_rom() {
     m_total_cycles = 0;
     m_frame_count = 0;
     m_test_result_reported = false;
+    m_max_state_size = 0;
+    m_hash_buffer.clear();
 
     m_cpu.reset();
     m_bus.reset();
@@ -229,6 +391,7 @@ uint32_t GBAPlugin::get_rom_crc32() const {
 }
 
 void GBAPlugin::reset() {
+    m_load_stamp = m_write_stamp;
     m_total_cycles = 0;
     m_frame_count = 0;
     m_audio_samples = 0;
@@ -245,73 +408,151 @@ void GBAPlugin::run_frame(const emu::InputState& input) {
     m_frame_count++;
 }
 
+void GBAPlugin::run_frames(const emu::InputState* inputs, size_t count, emu::RunFlags flags) {
+    if (!m_rom_loaded || count == 0) return;
+
+    // Output is switched once around the batch instead of per frame, and the
+    // frames run straight through without going back through the interface
+    bool skip_video = (flags & emu::RUN_FLAGS_SKIP_VIDEO) && count > 1;
+    bool skip_audio = (flags & emu::RUN_FLAGS_SKIP_AUDIO) && count > 1;
+    if (skip_video) set_video_enabled(false);
+    if (skip_audio) set_audio_enabled(false);
+
+    for (size_t i = 0; i + 1 < count; i++) {
+        run_gba_frame(inputs[i]);
+        m_frame_count++;
+    }
+
+    if (skip_video) set_video_enabled(true);
+    if (skip_audio) set_audio_enabled(true);
+    run_gba_frame(inputs[count - 1]);
+    m_frame_count++;
+}
+
+void GBAPlugin::run_frame_netplay(uint32_t player1_buttons, uint32_t player2_buttons) {
+    (void)player2_buttons;  // No second controller port
+
+    emu::InputState input;
+    input.buttons = player1_buttons;
+    run_frame(input);
+}
+
 void GBAPlugin::run_gba_frame(const emu::InputState& input) {
+    // Marked around DMA here; Bus::catch_up() marks the PPU and APU
+    emu::ProfileScope profile(m_profile, emu::ProfileSection::CPU);
+    EMU_TRACE_SCOPE(m_tracer, "gba", "frame");
+    if (!m_write_watch.empty()) m_write_watch.begin_frame(m_total_cycles);
+    if (!m_breakpoints.empty()) m_breakpoints.begin_frame(m_total_cycles);
+
     // Set input state
+    m_bus->clear_keyinput_read();
     m_bus->set_input_state(input.buttons);
 
     // GBA: 280896 cycles per frame (228 scanlines * 1232 cycles)
     // 160 visible lines + 68 VBlank lines
     constexpr int CYCLES_PER_FRAME = 280896;
     int cycles_run = 0;
-
-    static bool debug = is_debug_mode();
     int instr_count = 0;
     while (cycles_run < CYCLES_PER_FRAME) {
-        int cpu_cycles = m_cpu->step();
-        instr_count++;
+        int cpu_cycles;
+        if (m_cpu->is_halted() && !m_bus->is_dma_pending()) {
+            // Only an event can end the halt, so skip straight to the next one
+            cpu_cycles = std::min(m_bus->cycles_until_event(), CYCLES_PER_FRAME - cycles_run);
+            m_cpu->idle(cpu_cycles);
+            instr_count++;
+        } else if (m_write_watch.empty() && m_breakpoints.empty() && !m_cpu_trace &&
+                   !m_bus->is_dma_pending()) {
+            // Nothing below has work until the event, so the CPU runs up to
+            // it in one call (watched writes, breakpoints and traced
+            // instructions want per-instruction clocks)
+            cpu_cycles = m_cpu->run(std::min(m_bus->cycles_until_event(), CYCLES_PER_FRAME - cycles_run),
+                                    instr_count);
+        } else {
+            cpu_cycles = m_cpu->step();
+            instr_count++;
+        }
 
         // Run DMA after CPU step - DMA halts CPU while active
+        m_profile.set(emu::ProfileSection::DMA);
         int dma_cycles = m_bus->run_dma();
+        m_profile.set(emu::ProfileSection::CPU);
 
         // Total cycles for this iteration
         int total_cycles = cpu_cycles + dma_cycles;
         m_total_cycles += total_cycles;
         cycles_run += total_cycles;
 
-        // Step PPU
-        m_ppu->step(total_cycles);
-
-        // Step timers
-        m_bus->step_timers(total_cycles);
-
-        // Step APU
-        m_apu->step(total_cycles);
+        // PPU, timers and APU only need stepping once the nearest scheduled
+        // event is due or IO was touched; until then the CPU runs on
+        if (m_bus->add_cycles(total_cycles)) {
+            m_bus->sync_components();
+
+            // Handle interrupts
+            if (m_bus->check_interrupts()) {
+                m_cpu->signal_irq();
+            } else if (m_cpu->is_halted() && !m_bus->get_ime() &&
+                       (m_bus->get_ie() & m_bus->get_if())) {
+                // Halt ends on any enabled interrupt, even with IME clear
+                m_cpu->wake();
+            }
+        }
 
-        // Handle interrupts
-        if (m_bus->check_interrupts()) {
-            m_cpu->signal_irq();
+        // Idle loop: passes that end before the next event (or the end of
+        // the frame) would all be identical, so only their time needs to pass
+        if (int period = m_cpu_trace ? 0 : m_cpu->idle_loop_period()) {  // A trace wants every pass
+            int budget = std::min(m_bus->cycles_until_event(), CYCLES_PER_FRAME - cycles_run) - 1;
+            int skipped = budget / period * period;
+            if (skipped > 0) {
+                m_total_cycles += skipped;
+                cycles_run += skipped;
+                m_bus->add_cycles(skipped);
+            }
         }
     }
 
-    // Log instruction count per frame
-    if (debug && (m_frame_count + 1) % 60 == 0) {
-        fprintf(stderr, "[FRAME] %llu: %d instructions, %d cycles\n",
-               m_frame_count + 1, instr_count, cycles_run);
+    // Bring the components level with the CPU for the end of the frame
+    {
+        EMU_TRACE_SCOPE(m_tracer, "gba", "sync");
+        m_bus->sync_components();
+    }
+    // The caller counts the frame once this returns
+    if (!m_write_watch.empty()) m_write_watch.end_frame(m_total_cycles, m_frame_count + 1);
+    if (!m_breakpoints.empty()) m_breakpoints.end_frame(m_total_cycles, m_frame_count + 1);
+    EMU_TRACE_COUNTER(m_tracer, "gba", "instructions", instr_count);
+
+    // Copy framebuffer (kept at the last shown frame while video is off);
+    // with threaded rendering this includes waiting for the worker
+    if (m_video_enabled) {
+        EMU_TRACE_SCOPE(m_tracer, "gba", "video");
+        m_profile.set(emu::ProfileSection::PPU);
+        m_ppu->sync_rendering();
+        const uint32_t* ppu_fb = m_ppu->get_framebuffer();
+        uint32_t* out = m_output_framebuffer ? m_output_framebuffer : m_framebuffer;
+        std::memcpy(out, ppu_fb, SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(uint32_t));
+        m_shown_framebuffer = out;
     }
-
-    // Copy framebuffer
-    const uint32_t* ppu_fb = m_ppu->get_framebuffer();
-    std::memcpy(m_framebuffer, ppu_fb, SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(uint32_t));
 
     // Get audio samples
-    m_audio_samples = m_apu->get_samples(m_audio_buffer, AUDIO_BUFFER_SIZE);
+    {
+        EMU_TRACE_SCOPE(m_tracer, "gba", "audio");
+        m_profile.set(emu::ProfileSection::APU);
+        m_audio_samples = m_apu->get_samples(m_audio_buffer, AUDIO_BUFFER_SIZE);
+    }
 
     // Test ROM result detection (frame-based)
     if (is_debug_mode() && !m_test_result_reported) {
-        static uint32_t last_frame_pc = 0;
-        static int same_pc_frames = 0;
 
         uint32_t current_pc = m_cpu->get_pc();
 
-        if (current_pc == last_frame_pc) {
-            same_pc_frames++;
+        if (current_pc == m_test_last_pc) {
+            m_test_same_pc_frames++;
             // If PC has been the same for 10 frames (~170ms), consider test complete
-            if (same_pc_frames >= 10) {
+            if (m_test_same_pc_frames >= 10) {
                 uint32_t r12 = m_cpu->get_register(12);
                 m_test_result_reported = true;
 
                 fprintf(stderr, "\n=== GBA TEST ROM RESULT ===\n");
-                fprintf(stderr, "Detected stable PC at 0x%08X for %d frames\n", current_pc, same_pc_frames);
+                fprintf(stderr, "Detected stable PC at 0x%08X for %d frames\n", current_pc, m_test_same_pc_frames);
                 fprintf(stderr, "R12 (test result): %u\n", r12);
                 fprintf(stderr, "Cycles: %llu, Frame: %llu\n",
                        static_cast<unsigned long long>(m_total_cycles),
@@ -326,8 +567,8 @@ void GBAPlugin::run_gba_frame(const emu::InputState& input) {
                 fflush(stderr);  // Ensure output is flushed immediately for test detection
             }
         } else {
-            same_pc_frames = 0;
-            last_frame_pc = current_pc;
+            m_test_same_pc_frames = 0;
+            m_test_last_pc = current_pc;
         }
     }
 
@@ -335,7 +576,6 @@ void GBAPlugin::run_gba_frame(const emu::InputState& input) {
     if (is_debug_mode()) {
         uint32_t pc = m_cpu->get_pc();
         uint32_t cpsr = m_cpu->get_cpsr();
-        static uint64_t last_cycles = 0;
 
         // Print PC every 10 frames
         if ((m_frame_count + 1) % 10 == 0 || m_frame_count < 20) {
@@ -343,13 +583,13 @@ void GBAPlugin::run_gba_frame(const emu::InputState& input) {
                     static_cast<unsigned long long>(m_frame_count + 1), pc, cpsr);
         }
         if ((m_frame_count + 1) % 60 == 0) {
-            uint64_t cycles_this_frame = m_total_cycles - last_cycles;
+            uint64_t cycles_this_frame = m_total_cycles - m_debug_last_cycles;
             fprintf(stderr, "[GBA] Frame %llu, cycles: %llu (delta=%llu), PC: 0x%08X\n",
                    static_cast<unsigned long long>(m_frame_count + 1),
                    static_cast<unsigned long long>(m_total_cycles),
                    static_cast<unsigned long long>(cycles_this_frame),
                    pc);
-            last_cycles = m_total_cycles;
+            m_debug_last_cycles = m_total_cycles;
         }
     }
 }
@@ -364,7 +604,7 @@ uint64_t GBAPlugin::get_frame_count() const {
 
 emu::FrameBuffer GBAPlugin::get_framebuffer() {
     return {
-        m_framebuffer,
+        m_shown_framebuffer,
         SCREEN_WIDTH,
         SCREEN_HEIGHT
     };
@@ -374,7 +614,7 @@ emu::AudioBuffer GBAPlugin::get_audio() {
     return {
         m_audio_buffer,
         static_cast<int>(m_audio_samples),
-        44100
+        m_apu->get_sample_rate()
     };
 }
 
@@ -382,20 +622,39 @@ void GBAPlugin::clear_audio_buffer() {
     m_audio_samples = 0;
 }
 
-void GBAPlugin::set_audio_callback(AudioStreamCallback callback) {
+void GBAPlugin::set_audio_sink(const emu::AudioStreamSink& sink) {
     // Store in base class
-    m_audio_callback = callback;
+    m_audio_sink = sink;
 
     // Forward to APU for direct streaming
     if (m_apu) {
-        if (callback) {
-            m_apu->set_audio_callback([callback](const float* samples, size_t count, int rate) {
-                callback(samples, count, rate);
-            });
-        } else {
-            m_apu->set_audio_callback(nullptr);
-        }
+        m_apu->set_audio_sink(sink);
+    }
+}
+
+void GBAPlugin::set_audio_enabled(bool enabled) {
+    if (m_apu) {
+        m_apu->set_audio_enabled(enabled);
+    }
+}
+
+void GBAPlugin::set_video_enabled(bool enabled) {
+    m_video_enabled = enabled;
+    if (m_ppu) {
+        m_ppu->set_video_enabled(enabled);
+    }
+}
+
+bool GBAPlugin::set_output_framebuffer(uint32_t* pixels, int pitch) {
+    if (pixels && pitch != SCREEN_WIDTH) return false;
+
+    // Keep the last frame when going back to our own buffer
+    if (!pixels && m_shown_framebuffer != m_framebuffer) {
+        std::memcpy(m_framebuffer, m_shown_framebuffer, sizeof(m_framebuffer));
+        m_shown_framebuffer = m_framebuffer;
     }
+    m_output_framebuffer = pixels;
+    return true;
 }
 
 uint8_t GBAPlugin::read_memory(uint16_t address) {
@@ -407,6 +666,79 @@ void GBAPlugin::write_memory(uint16_t address, uint8_t value) {
     if (m_bus) m_bus->write8(0x03000000 | address, value);
 }
 
+bool GBAPlugin::get_memory_domain(size_t index, emu::MemoryDomain& domain) const {
+    switch (index) {
+        // 0x00000000-0x0FFFFFFF, everything the CPU can reach
+        case 0: domain = {"CPU Bus", 0x10000000, nullptr}; return true;
+        case 1: domain = {"EWRAM", 0x40000, m_bus->get_ewram_data()}; return true;
+        case 2: domain = {"IWRAM", 0x8000, m_bus->get_iwram_data()}; return true;
+        case 3: domain = {"VRAM", 0x18000, m_ppu->get_vram_data()}; return true;
+        case 4: domain = {"Palette", 0x400, m_ppu->get_palette_data()}; return true;
+        case 5: domain = {"OAM", 0x400, m_ppu->get_oam_data()}; return true;
+        case 6:
+            domain = {"SRAM", static_cast<uint32_t>(m_cartridge->get_save_data_size()),
+                      m_cartridge->get_save_data_ptr()};
+            return true;
+        case 7:
+            domain = {"ROM", static_cast<uint32_t>(m_cartridge->get_rom_size()), m_cartridge->get_rom_data()};
+            return true;
+        default: return false;
+    }
+}
+
+bool GBAPlugin::set_cpu_trace(emu::CpuTrace* trace) {
+    if (trace) trace->set_clock(&m_total_cycles);
+    m_cpu_trace = trace;
+    if (m_cpu) m_cpu->set_trace(trace);
+    return true;
+}
+
+bool GBAPlugin::set_write_watchpoints(const uint32_t* addresses, size_t count) {
+    m_write_watch.set(addresses, count);
+    if (m_bus) m_bus->set_write_watch(m_write_watch.empty() ? nullptr : &m_write_watch);
+    return true;
+}
+
+size_t GBAPlugin::take_write_watch_hits(emu::WriteWatchHit* out, size_t max) {
+    return m_write_watch.take(out, max);
+}
+
+bool GBAPlugin::set_breakpoints(const emu::Breakpoint* breakpoints, size_t count) {
+    m_breakpoints.set(breakpoints, count);
+    apply_breakpoints();
+    return true;
+}
+
+// Also called for each new CPU and bus at load
+void GBAPlugin::apply_breakpoints() {
+    uint8_t kinds = m_breakpoints.kinds();
+    if (m_cpu) m_cpu->set_breakpoints(kinds & emu::BREAK_EXECUTE ? &m_breakpoints : nullptr);
+    if (m_bus) m_bus->set_breakpoints(kinds & (emu::BREAK_READ | emu::BREAK_WRITE) ? &m_breakpoints : nullptr);
+}
+
+size_t GBAPlugin::take_breakpoint_hits(emu::BreakpointHit* out, size_t max) {
+    return m_breakpoints.take(out, max);
+}
+
+std::vector<emu::MemoryDomain> GBAPlugin::get_memory_domains() {
+    std::vector<emu::MemoryDomain> domains;
+    emu::MemoryDomain domain;
+    for (size_t i = 0; get_memory_domain(i, domain); i++) {
+        domains.push_back(domain);
+    }
+    return domains;
+}
+
+bool GBAPlugin::read_memory_block(size_t domain, uint32_t address, size_t length, uint8_t* out) {
+    if (domain == 0) {
+        if (address > 0x10000000 || length > 0x10000000 - address) return false;
+        m_bus->read_block(address, length, out);
+        return true;
+    }
+    emu::MemoryDomain info;
+    return get_memory_domain(domain, info) && emu::copy_memory_domain(info, address, length, out);
+}
+
 bool GBAPlugin::save_state(std::vector<uint8_t>& data) {
     if (!m_rom_loaded) return false;
 
@@ -414,19 +746,8 @@ bool GBAPlugin::save_state(std::vector<uint8_t>& data) {
         data.clear();
         data.reserve(64 * 1024);  // Reserve 64KB
 
-        // Save frame count and cycles
-        const uint8_t* fc_ptr = reinterpret_cast<const uint8_t*>(&m_frame_count);
-        data.insert(data.end(), fc_ptr, fc_ptr + sizeof(m_frame_count));
-
-        const uint8_t* tc_ptr = reinterpret_cast<const uint8_t*>(&m_total_cycles);
-        data.insert(data.end(), tc_ptr, tc_ptr + sizeof(m_total_cycles));
-
-        m_cpu->save_state(data);
-        m_ppu->save_state(data);
-        m_bus->save_state(data);
-        m_apu->save_state(data);
-        m_cartridge->save_state(data);
-
+        StateWriter writer(data);
+        serialize_state(writer);
         return true;
     } catch (...) {
         return false;
@@ -437,32 +758,231 @@ bool GBAPlugin::load_state(const std::vector<uint8_t>& data) {
     if (!m_rom_loaded || data.empty()) return false;
 
     try {
-        const uint8_t* ptr = data.data();
-        size_t remaining = data.size();
+        return deserialize_state(data.data(), data.size());
+    } catch (...) {
+        return false;
+    }
+}
 
-        // Load frame count and cycles
-        if (remaining < sizeof(m_frame_count) + sizeof(m_total_cycles)) {
+// Layout version of every chunk this core writes; bump a chunk's own when
+// its subsystem's save_state() changes, and keep loading the old one
+static constexpr uint16_t GBA_CHUNK_VERSION = 1;
+
+void GBAPlugin::serialize_state(StateWriter& out) const {
+    emu::write_state_chunks_magic(out);
+
+    emu::write_state_chunk(out, emu::STATE_CHUNK_TIMING, GBA_CHUNK_VERSION, [&] {
+        out.write(&m_frame_count, sizeof(m_frame_count));
+        out.write(&m_total_cycles, sizeof(m_total_cycles));
+    });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_CPU, GBA_CHUNK_VERSION, [&] { m_cpu->save_state(out); });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_PPU, GBA_CHUNK_VERSION, [&] { m_ppu->save_state(out); });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_WORK_RAM, GBA_CHUNK_VERSION, [&] { m_bus->save_work_ram(out); });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_BUS, GBA_CHUNK_VERSION, [&] { m_bus->save_registers(out); });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_APU, GBA_CHUNK_VERSION, [&] { m_apu->save_state(out); });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_CARTRIDGE, GBA_CHUNK_VERSION, [&] { m_cartridge->save_state(out); });
+}
+
+bool GBAPlugin::deserialize_state(const uint8_t* buffer, size_t size) {
+    return deserialize_chunks(buffer, size, nullptr, 0);
+}
+
+bool GBAPlugin::load_state_chunks(const uint8_t* data, size_t size, const uint32_t* tags, size_t tag_count) {
+    if (!m_rom_loaded || !data || !tags || tag_count == 0) return false;
+    return deserialize_chunks(data, size, tags, tag_count);
+}
+
+bool GBAPlugin::deserialize_chunks(const uint8_t* buffer, size_t size, const uint32_t* tags, size_t tag_count) {
+    m_load_stamp = m_write_stamp;
+    emu::StateChunkReader reader(buffer, size);
+    if (!reader.is_chunked()) {
+        // Old states can only be loaded whole
+        return !tags && deserialize_unchunked_state(buffer, size);
+    }
+
+    bool loaded = false;
+    emu::StateChunk chunk;
+    while (reader.next(chunk)) {
+        if (!emu::state_chunk_selected(chunk.tag, tags, tag_count)) continue;
+        if (chunk.version > GBA_CHUNK_VERSION) {
+            std::cerr << "[GBA] Save state is from a newer version" << std::endl;
+            return false;
+        }
+        if (!load_state_chunk(chunk)) {
             return false;
         }
+        loaded = true;
+    }
+    return loaded && !reader.malformed();
+}
 
-        std::memcpy(&m_frame_count, ptr, sizeof(m_frame_count));
-        ptr += sizeof(m_frame_count);
-        remaining -= sizeof(m_frame_count);
+bool GBAPlugin::load_state_chunk(const emu::StateChunk& chunk) {
+    const uint8_t* ptr = chunk.data;
+    size_t remaining = chunk.size;
+
+    switch (chunk.tag) {
+        case emu::STATE_CHUNK_TIMING:
+            if (remaining < sizeof(m_frame_count) + sizeof(m_total_cycles)) return false;
+            std::memcpy(&m_frame_count, ptr, sizeof(m_frame_count));
+            std::memcpy(&m_total_cycles, ptr + sizeof(m_frame_count), sizeof(m_total_cycles));
+            return true;
+        case emu::STATE_CHUNK_CPU: m_cpu->load_state(ptr, remaining); break;
+        case emu::STATE_CHUNK_PPU: m_ppu->load_state(ptr, remaining); break;
+        case emu::STATE_CHUNK_WORK_RAM: m_bus->load_work_ram(ptr, remaining); break;
+        case emu::STATE_CHUNK_BUS: m_bus->load_registers(ptr, remaining); break;
+        case emu::STATE_CHUNK_APU: m_apu->load_state(ptr, remaining); break;
+        case emu::STATE_CHUNK_CARTRIDGE: m_cartridge->load_state(ptr, remaining); break;
+        default:
+            return true;  // Written by a newer build; skipped
+    }
 
-        std::memcpy(&m_total_cycles, ptr, sizeof(m_total_cycles));
-        ptr += sizeof(m_total_cycles);
-        remaining -= sizeof(m_total_cycles);
+    // The component loaders don't check sizes; one that read past its
+    // chunk has wrapped the count
+    return remaining <= chunk.size;
+}
 
-        m_cpu->load_state(ptr, remaining);
-        m_ppu->load_state(ptr, remaining);
-        m_bus->load_state(ptr, remaining);
-        m_apu->load_state(ptr, remaining);
-        m_cartridge->load_state(ptr, remaining);
+bool GBAPlugin::deserialize_unchunked_state(const uint8_t* buffer, size_t size) {
+    const uint8_t* ptr = buffer;
+    size_t remaining = size;
 
-        return true;
-    } catch (...) {
+    // Load frame count and cycles
+    if (remaining < sizeof(m_frame_count) + sizeof(m_total_cycles)) {
+        return false;
+    }
+
+    std::memcpy(&m_frame_count, ptr, sizeof(m_frame_count));
+    ptr += sizeof(m_frame_count);
+    remaining -= sizeof(m_frame_count);
+
+    std::memcpy(&m_total_cycles, ptr, sizeof(m_total_cycles));
+    ptr += sizeof(m_total_cycles);
+    remaining -= sizeof(m_total_cycles);
+
+    m_cpu->load_state(ptr, remaining);
+    m_ppu->load_state(ptr, remaining);
+    m_bus->load_state(ptr, remaining);
+    m_apu->load_state(ptr, remaining);
+    m_cartridge->load_state(ptr, remaining);
+
+    return true;
+}
+
+// Fast save state for rollback
+size_t GBAPlugin::get_max_state_size() const {
+    return m_max_state_size;
+}
+
+size_t GBAPlugin::save_state_fast(uint8_t* buffer, size_t buffer_size) {
+    if (!m_rom_loaded) return 0;
+
+    // If buffer is null, just return required size
+    if (buffer == nullptr) {
+        return get_max_state_size();
+    }
+
+    if (buffer_size < get_max_state_size()) {
+        return 0;  // Buffer too small
+    }
+
+    StateWriter writer(buffer, buffer_size);
+    serialize_state(writer);
+
+    if (writer.overflowed()) {
+        return 0;  // Shouldn't happen, the size was measured at load time
+    }
+
+    return writer.size();
+}
+
+bool GBAPlugin::load_state_fast(const uint8_t* buffer, size_t size) {
+    if (!m_rom_loaded || buffer == nullptr || size == 0) {
+        return false;
+    }
+    return deserialize_state(buffer, size);
+}
+
+bool GBAPlugin::clone_into(emu::IEmulatorPlugin* other) {
+    auto* target = dynamic_cast<GBAPlugin*>(other);
+    if (!target || target == this || !m_rom_loaded || !target->m_rom_loaded ||
+        target->m_rom_crc32 != m_rom_crc32) {
+        return false;
+    }
+
+    // Through the fast state path; after the first clone nothing allocates
+    target->m_clone_state.resize(get_max_state_size());
+    size_t size = save_state_fast(target->m_clone_state.data(), target->m_clone_state.size());
+    return size > 0 && target->load_state_fast(target->m_clone_state.data(), size);
+}
+
+void GBAPlugin::set_write_stamp(uint32_t stamp) {
+    m_write_stamp = stamp;
+    m_bus->set_write_stamp(stamp);
+    m_ppu->set_write_stamp(stamp);
+}
+
+uint64_t GBAPlugin::mark_state_capture() {
+    if (!m_rom_loaded || !m_work_ram_state_offset || !m_video_state_offset) return 0;
+    uint32_t mark = m_write_stamp;
+    set_write_stamp(mark + 1);
+    return mark;
+}
+
+bool GBAPlugin::get_changed_state_spans(uint64_t mark, std::vector<emu::StateSpan>& spans) const {
+    spans.clear();
+    if (!m_rom_loaded || mark == 0 || mark >= m_write_stamp || m_load_stamp > mark ||
+        !m_work_ram_state_offset || !m_video_state_offset) {
         return false;
     }
+
+    auto add = [&spans](size_t offset, size_t size) {
+        if (!spans.empty() && spans.back().offset + spans.back().size == offset) {
+            spans.back().size += size;
+        } else {
+            spans.push_back({offset, size});
+        }
+    };
+    auto add_pages = [&](size_t offset, const uint32_t* stamps, size_t count, size_t page_size) {
+        for (size_t i = 0; i < count; i++) {
+            if (stamps[i] > mark) add(offset + i * page_size, page_size);
+        }
+    };
+
+    // Everything but the tracked memory (registers, chunk headers, APU,
+    // cartridge) is taken as changed
+    const size_t video_end = m_video_state_offset + PPU::STAMP_BLOCKS * 256;
+    const size_t work_ram_end = m_work_ram_state_offset + (Bus::RAM_STAMP_PAGES << Bus::RAM_STAMP_SHIFT);
+    add(0, m_video_state_offset);
+    add_pages(m_video_state_offset, m_ppu->get_write_stamps(), PPU::STAMP_BLOCKS, 256);
+    add(video_end, m_work_ram_state_offset - video_end);
+    add_pages(m_work_ram_state_offset, m_bus->get_ram_stamps().data(), Bus::RAM_STAMP_PAGES,
+              size_t{1} << Bus::RAM_STAMP_SHIFT);
+    add(work_ram_end, m_state_size - work_ram_end);
+    return true;
+}
+
+// FNV-1a hash for desync detection (fast, non-cryptographic)
+static uint64_t fnv1a_hash(const uint8_t* data, size_t size) {
+    const uint64_t FNV_PRIME = 0x100000001b3ULL;
+    const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+uint64_t GBAPlugin::get_state_hash() const {
+    if (!m_rom_loaded || m_hash_buffer.empty()) return 0;
+
+    // Hash the complete serialized state into a scratch buffer sized at
+    // load time, so this never allocates
+    StateWriter writer(m_hash_buffer.data(), m_hash_buffer.size());
+    serialize_state(writer);
+    if (writer.overflowed()) return 0;
+
+    return fnv1a_hash(m_hash_buffer.data(), writer.size());
 }
 
 bool GBAPlugin::has_battery_save() const {
@@ -483,8 +1003,61 @@ bool GBAPlugin::set_battery_save_data(const std::vector<uint8_t>& data) {
     return m_cartridge->set_save_data(data);
 }
 
+uint64_t GBAPlugin::get_battery_save_generation() const {
+    return m_cartridge ? m_cartridge->get_save_generation() : 0;
+}
+
+bool GBAPlugin::save_config(const char* path) {
+    std::ofstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    // Simple JSON format
+    file << "{\n";
+    file << "  \"threaded_rendering\": " << (m_threaded_rendering ? "true" : "false") << "\n";
+    file << "}\n";
+
+    return true;
+}
+
+bool GBAPlugin::load_config(const char* path) {
+    std::ifstream file(path);
+    if (!file) {
+        // File doesn't exist - use defaults (not an error)
+        return true;
+    }
+
+    // Simple JSON parsing (basic, not a full parser)
+    std::string content((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+
+    // Parse threaded_rendering
+    size_t pos = content.find("\"threaded_rendering\":");
+    if (pos != std::string::npos) {
+        m_threaded_rendering = (content.find("true", pos) < content.find("false", pos));
+    }
+
+    if (m_ppu) {
+        m_ppu->set_threaded_rendering(m_threaded_rendering);
+    }
+
+    return true;
+}
+
 } // namespace gba
 
+#ifdef VELOCE_STATIC_CORE
+// Static build for veloce_bench, which links every core into one binary
+// and so can't use the shared C entry points below
+namespace gba {
+
+emu::IEmulatorPlugin* create_static_plugin() {
+    return new GBAPlugin();
+}
+
+} // namespace gba
+#else
 // C interface for plugin loading
 extern "C" {
 
@@ -501,3 +1074,4 @@ EMU_PLUGIN_EXPORT uint32_t get_plugin_api_version() {
 }
 
 }
+#endif
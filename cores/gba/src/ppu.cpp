@@ -1,23 +1,106 @@
 #include "ppu.hpp"
 #include "bus.hpp"
 #include "debug.hpp"
+#include "emu/state_writer.hpp"
 #include <cstring>
 #include <algorithm>
 #include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define GBA_PPU_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define GBA_PPU_NEON 1
+#endif
 
 namespace gba {
 
+// Registers a visible line is drawn with, as latched at its HBlank
+struct PPU::LineState {
+    uint16_t vcount;
+    uint16_t dispcnt;
+    DisplayMode mode;
+    std::array<uint16_t, 4> bgcnt, bghofs, bgvofs;
+    std::array<int16_t, 2> bgpa, bgpb, bgpc, bgpd;
+    std::array<int32_t, 2> bgx, bgy, bgx_internal, bgy_internal;
+    uint16_t win0h, win1h, win0v, win1v, winin, winout;
+    uint16_t bldcnt, bldalpha, bldy, mosaic;
+};
+
+// One queued line: its registers plus every memory block written since
+// the previous line, in block order
+struct PPU::LineJob {
+    LineState state;
+    std::vector<uint16_t> blocks;
+    std::vector<uint8_t> data;
+};
+
+// The worker draws into a shadow PPU that mirrors VRAM, palette and OAM
+// from the block copies. Jobs live in a fixed ring so steady-state
+// queueing doesn't allocate.
+struct PPU::RenderWorker {
+    explicit RenderWorker(Bus& bus) : shadow(bus), jobs(QUEUE_SIZE) {}
+
+    static constexpr size_t QUEUE_SIZE = 256;
+    static constexpr size_t WAKE_BATCH = 16;  // Lines queued before the worker is woken
+
+    PPU shadow;
+    std::vector<LineJob> jobs;
+    size_t head = 0;  // Next job to queue (emulation thread)
+    size_t tail = 0;  // Next job to draw (worker thread)
+    bool stop = false;
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable work_done;
+    std::thread thread;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            work_ready.wait(lock, [this] { return stop || tail != head; });
+            if (tail == head) return;  // Stopped with nothing left
+            LineJob& job = jobs[tail % QUEUE_SIZE];
+            lock.unlock();
+
+            const uint8_t* src = job.data.data();
+            for (uint16_t block : job.blocks) {
+                std::memcpy(shadow.block_data(block), src, DIRTY_BLOCK_SIZE);
+                src += DIRTY_BLOCK_SIZE;
+                if (block >= VRAM_BLOCKS + PALETTE_BLOCKS) shadow.m_sprite_lines_valid = false;
+            }
+            shadow.apply_line_state(job.state);
+            shadow.draw_scanline();
+
+            lock.lock();
+            tail++;
+            work_done.notify_all();
+        }
+    }
+};
+
 PPU::PPU(Bus& bus) : m_bus(bus) {
     reset();
 }
 
-PPU::~PPU() = default;
+PPU::~PPU() {
+    set_threaded_rendering(false);
+}
 
 void PPU::reset() {
     m_vram.fill(0);
     m_palette.fill(0);
     m_oam.fill(0);
+    m_sprite_lines_valid = false;
     m_framebuffer.fill(0);
+    if (m_worker) {
+        sync_rendering();
+        m_worker->shadow.m_framebuffer.fill(0);
+        mark_all_dirty();
+    }
 
     m_vcount = 0;
     m_hcount = 0;
@@ -49,8 +132,12 @@ void PPU::reset() {
 }
 
 void PPU::step(int cycles) {
-    for (int i = 0; i < cycles; i++) {
-        m_hcount++;
+    while (cycles > 0) {
+        // Nothing happens between the HBlank and end-of-line boundaries,
+        // so advance straight to the next one
+        int run = std::min(cycles, cycles_until_event());
+        m_hcount += run;
+        cycles -= run;
 
         // Handle HBlank transition
         if (m_hcount == HDRAW_CYCLES) {
@@ -131,17 +218,6 @@ void PPU::step(int cycles) {
 }
 
 void PPU::render_scanline() {
-    // Clear scanline buffers
-    for (int i = 0; i < 4; i++) {
-        m_bg_buffer[i].fill(0x8000);  // Transparent marker
-        m_bg_priority[i].fill(4);     // Lowest priority
-        m_bg_is_target1[i].fill(false);
-    }
-    m_sprite_buffer.fill(0x8000);
-    m_sprite_priority.fill(4);
-    m_sprite_semi_transparent.fill(false);
-    m_sprite_is_window.fill(false);
-
     // Update registers from bus before rendering
     m_dispcnt = m_bus.get_dispcnt();
     for (int i = 0; i < 4; i++) {
@@ -178,6 +254,32 @@ void PPU::render_scanline() {
     // Get display mode
     m_mode = static_cast<DisplayMode>(m_dispcnt & 7);
 
+    if (!m_video_enabled || m_worker) {
+        // The register latches above are all the state a scanline advances,
+        // apart from the frame select the bitmap renderers pick up
+        if (!(m_dispcnt & 0x0080) &&
+            (m_mode == DisplayMode::Mode4 || m_mode == DisplayMode::Mode5)) {
+            m_frame_select = (m_dispcnt & 0x0010) != 0;
+        }
+        if (m_video_enabled) queue_scanline();
+        return;
+    }
+
+    draw_scanline();
+}
+
+void PPU::draw_scanline() {
+    // Clear scanline buffers
+    for (int i = 0; i < 4; i++) {
+        m_bg_buffer[i].fill(0x8000);  // Transparent marker
+        m_bg_priority[i].fill(4);     // Lowest priority
+        m_bg_is_target1[i].fill(false);
+    }
+    m_sprite_buffer.fill(0x8000);
+    m_sprite_priority.fill(4);
+    m_sprite_semi_transparent.fill(false);
+    m_sprite_is_window.fill(false);
+
     // Check for forced blank
     if (m_dispcnt & 0x0080) {
         // Forced blank - display white
@@ -229,14 +331,12 @@ void PPU::render_mode2() {
 
 void PPU::render_mode3() {
     // Mode 3: 240x160 bitmap, 15-bit color (uses BG2)
+    // The line is already in the layer buffer's format (little-endian BGR555)
     uint32_t base = m_vcount * 240 * 2;
     uint8_t priority = m_bgcnt[2] & 3;
 
-    for (int x = 0; x < 240; x++) {
-        uint16_t color = m_vram[base + x * 2] | (m_vram[base + x * 2 + 1] << 8);
-        m_bg_buffer[2][x] = color;
-        m_bg_priority[2][x] = priority;
-    }
+    std::memcpy(m_bg_buffer[2].data(), &m_vram[base], 240 * sizeof(uint16_t));
+    m_bg_priority[2].fill(priority);
 }
 
 void PPU::render_mode4() {
@@ -246,12 +346,13 @@ void PPU::render_mode4() {
     uint32_t base = (m_frame_select ? 0xA000 : 0) + m_vcount * 240;
     uint8_t priority = m_bgcnt[2] & 3;
 
+    uint16_t palette[256];
+    std::memcpy(palette, m_palette.data(), sizeof(palette));
+    const uint8_t* indices = &m_vram[base];
     for (int x = 0; x < 240; x++) {
-        uint8_t index = m_vram[base + x];
-        uint16_t color = m_palette[index * 2] | (m_palette[index * 2 + 1] << 8);
-        m_bg_buffer[2][x] = color;
-        m_bg_priority[2][x] = priority;
+        m_bg_buffer[2][x] = palette[indices[x]];
     }
+    m_bg_priority[2].fill(priority);
 }
 
 void PPU::render_mode5() {
@@ -262,11 +363,8 @@ void PPU::render_mode5() {
     if (m_vcount >= 128) return;
 
     uint32_t base = (m_frame_select ? 0xA000 : 0) + m_vcount * 160 * 2;
-    for (int x = 0; x < 160; x++) {
-        uint16_t color = m_vram[base + x * 2] | (m_vram[base + x * 2 + 1] << 8);
-        m_bg_buffer[2][x] = color;
-        m_bg_priority[2][x] = priority;
-    }
+    std::memcpy(m_bg_buffer[2].data(), &m_vram[base], 160 * sizeof(uint16_t));
+    std::fill(m_bg_priority[2].begin(), m_bg_priority[2].begin() + 160, priority);
 }
 
 void PPU::render_background(int layer) {
@@ -300,82 +398,105 @@ void PPU::render_background(int layer) {
     }
     int y = (src_y + scroll_y) % screen_height;
 
-    for (int screen_x = 0; screen_x < 240; screen_x++) {
-        // Apply horizontal mosaic to the source x coordinate if enabled
-        int src_x = screen_x;
-        if (mosaic_enabled && mosaic_h > 1) {
-            src_x = (src_x / mosaic_h) * mosaic_h;
-        }
-        int x = (src_x + scroll_x) % screen_width;
-
-        // Determine which screen block we're in
-        // Screen blocks are arranged as:
-        // Size 0: [0]
-        // Size 1: [0][1] (horizontal)
-        // Size 2: [0]
-        //         [1] (vertical)
-        // Size 3: [0][1]
-        //         [2][3]
+    // Screen blocks are arranged as:
+    // Size 0: [0]
+    // Size 1: [0][1] (horizontal)
+    // Size 2: [0]
+    //         [1] (vertical)
+    // Size 3: [0][1]
+    //         [2][3]
+    int screen_block_y = y / 256;
+    int tile_y = (y % 256) / 8;
+    int pixel_y = y & 7;
+
+    auto map_address = [&](int x) -> uint32_t {
         int screen_block_x = x / 256;
-        int screen_block_y = y / 256;
         int screen_block = 0;
-
         switch (screen_size) {
             case 0: screen_block = 0; break;
             case 1: screen_block = screen_block_x; break;
             case 2: screen_block = screen_block_y; break;
             case 3: screen_block = screen_block_x + screen_block_y * 2; break;
         }
+        int tile_x = (x % 256) / 8;
+        return screen_base + screen_block * 0x800 + (tile_y * 32 + tile_x) * 2;
+    };
 
-        int local_x = x % 256;
-        int local_y = y % 256;
+    // All 8 pixels of a tile row share one map entry, so each row is decoded
+    // once into palette indices (0 = transparent), already flipped
+    std::array<uint8_t, 8> row{};
+    uint32_t row_map_offset = 0xFFFFFFFF;
+    bool row_valid = false;
 
-        // Get tile from map
-        int tile_x = local_x / 8;
-        int tile_y = local_y / 8;
-        uint32_t map_offset = screen_base + screen_block * 0x800 + (tile_y * 32 + tile_x) * 2;
+    auto load_row = [&](uint32_t map_offset) -> bool {
+        if (map_offset == row_map_offset) return row_valid;
+        row_map_offset = map_offset;
+        row_valid = false;
 
         // Ensure we don't read out of bounds
-        if (map_offset + 1 >= m_vram.size()) continue;
+        if (map_offset + 1 >= m_vram.size()) return false;
 
         uint16_t tile_entry = m_vram[map_offset] | (m_vram[map_offset + 1] << 8);
         int tile_id = tile_entry & 0x3FF;
         bool h_flip = tile_entry & 0x0400;
         bool v_flip = tile_entry & 0x0800;
         int palette_num = (tile_entry >> 12) & 0xF;
+        int tile_row = v_flip ? 7 - pixel_y : pixel_y;
 
-        // Get pixel within tile
-        int pixel_x = local_x & 7;
-        int pixel_y = local_y & 7;
-
-        if (h_flip) pixel_x = 7 - pixel_x;
-        if (v_flip) pixel_y = 7 - pixel_y;
-
-        uint8_t color_index;
         if (palette_256) {
             // 256-color mode: 64 bytes per tile
-            uint32_t tile_offset = char_base + tile_id * 64 + pixel_y * 8 + pixel_x;
-            if (tile_offset >= m_vram.size()) continue;
-            color_index = m_vram[tile_offset];
+            uint32_t tile_offset = char_base + tile_id * 64 + tile_row * 8;
+            if (tile_offset >= m_vram.size()) return false;
+            for (int px = 0; px < 8; px++) {
+                row[h_flip ? 7 - px : px] = m_vram[tile_offset + px];
+            }
         } else {
             // 16-color mode: 32 bytes per tile
-            uint32_t tile_offset = char_base + tile_id * 32 + pixel_y * 4 + pixel_x / 2;
-            if (tile_offset >= m_vram.size()) continue;
-            uint8_t byte = m_vram[tile_offset];
-            color_index = (pixel_x & 1) ? (byte >> 4) : (byte & 0x0F);
-
-            if (color_index != 0) {
-                color_index += palette_num * 16;
+            uint32_t tile_offset = char_base + tile_id * 32 + tile_row * 4;
+            if (tile_offset >= m_vram.size()) return false;
+            uint8_t bank = static_cast<uint8_t>(palette_num * 16);
+            for (int px = 0; px < 8; px++) {
+                uint8_t byte = m_vram[tile_offset + px / 2];
+                uint8_t color_index = (px & 1) ? (byte >> 4) : (byte & 0x0F);
+                row[h_flip ? 7 - px : px] = color_index ? color_index + bank : 0;
             }
         }
 
+        row_valid = true;
+        return true;
+    };
+
+    auto put_pixel = [&](int screen_x, uint8_t color_index) {
         if (color_index != 0) {
             uint32_t pal_offset = color_index * 2;
-            if (pal_offset + 1 < m_palette.size()) {
-                uint16_t color = m_palette[pal_offset] | (m_palette[pal_offset + 1] << 8);
-                m_bg_buffer[layer][screen_x] = color;
-                m_bg_priority[layer][screen_x] = priority;
+            m_bg_buffer[layer][screen_x] = m_palette[pal_offset] | (m_palette[pal_offset + 1] << 8);
+            m_bg_priority[layer][screen_x] = priority;
+        }
+    };
+
+    if (!mosaic_enabled || mosaic_h <= 1) {
+        // Walk the line a tile at a time
+        int screen_x = 0;
+        while (screen_x < 240) {
+            int x = (screen_x + scroll_x) % screen_width;
+            int first = x & 7;
+            int count = std::min(8 - first, 240 - screen_x);
+            if (load_row(map_address(x))) {
+                for (int i = 0; i < count; i++) {
+                    put_pixel(screen_x + i, row[first + i]);
+                }
             }
+            screen_x += count;
+        }
+        return;
+    }
+
+    for (int screen_x = 0; screen_x < 240; screen_x++) {
+        // Apply horizontal mosaic to the source x coordinate
+        int src_x = (screen_x / mosaic_h) * mosaic_h;
+        int x = (src_x + scroll_x) % screen_width;
+        if (load_row(map_address(x))) {
+            put_pixel(screen_x, row[x & 7]);
         }
     }
 }
@@ -417,230 +538,238 @@ void PPU::render_affine_background(int layer) {
         ref_y -= pd * lines_from_start;
     }
 
+    // Texel position of each pixel: the reference point (8 fractional
+    // bits) stepped by PA/PC. Plain loops over the line so the compiler can
+    // vectorize the stepping and, where the target has gathers, the fetches.
+    int32_t tex_x[240];
+    int32_t tex_y[240];
     for (int screen_x = 0; screen_x < 240; screen_x++) {
-        // Apply horizontal mosaic if enabled
-        int src_x = screen_x;
-        if (mosaic_enabled && mosaic_h > 1) {
-            src_x = (src_x / mosaic_h) * mosaic_h;
-        }
-
-        // Calculate texture coordinates
-        // The reference point moves by PA/PC for each pixel
-        int32_t tex_x = ref_x + pa * src_x;
-        int32_t tex_y = ref_y + pc * src_x;
-
-        // Convert from 28.4 fixed point to integer
-        int x = tex_x >> 8;
-        int y = tex_y >> 8;
+        tex_x[screen_x] = ref_x + pa * screen_x;
+        tex_y[screen_x] = ref_y + pc * screen_x;
+    }
 
-        // Handle wraparound or clipping
-        if (wraparound) {
-            x = x & (size - 1);
-            y = y & (size - 1);
-        } else {
-            if (x < 0 || x >= size || y < 0 || y >= size) {
-                continue;
-            }
+    // Horizontal mosaic repeats the first pixel of each block
+    if (mosaic_enabled && mosaic_h > 1) {
+        for (int screen_x = 0; screen_x < 240; screen_x++) {
+            int src_x = (screen_x / mosaic_h) * mosaic_h;
+            tex_x[screen_x] = tex_x[src_x];
+            tex_y[screen_x] = tex_y[src_x];
         }
+    }
 
-        // Get tile from map (affine maps are 8-bit entries, one byte per tile)
-        int tile_x = x / 8;
-        int tile_y = y / 8;
-        int tiles_per_row = size / 8;
-        uint32_t map_offset = screen_base + tile_y * tiles_per_row + tile_x;
-
-        if (map_offset >= m_vram.size()) continue;
-
-        uint8_t tile_id = m_vram[map_offset];
-
-        // Get pixel within tile (affine BGs are always 256-color)
-        int pixel_x = x & 7;
-        int pixel_y = y & 7;
-
-        uint32_t tile_offset = char_base + tile_id * 64 + pixel_y * 8 + pixel_x;
-        if (tile_offset >= m_vram.size()) continue;
-
-        uint8_t color_index = m_vram[tile_offset];
+    // Affine BGs are always 256-color, their tiles 64 linear bytes, and
+    // their maps one byte per tile. Masking the coordinates to the map keeps
+    // every fetch inside VRAM (the highest map or tile byte is below
+    // 0x14000), so pixels off a non-wrapping map are read and then dropped.
+    const uint8_t* vram = m_vram.data();
+    uint32_t mask = static_cast<uint32_t>(size - 1);
+    int row_shift = 4 + size_bits;  // log2(tiles per row)
+    uint8_t colors[240];
+    for (int screen_x = 0; screen_x < 240; screen_x++) {
+        uint32_t x = static_cast<uint32_t>(tex_x[screen_x] >> 8);
+        uint32_t y = static_cast<uint32_t>(tex_y[screen_x] >> 8);
+        bool inside = wraparound || ((x | y) & ~mask) == 0;
+        x &= mask;
+        y &= mask;
+
+        uint8_t tile_id = vram[screen_base + ((y >> 3) << row_shift) + (x >> 3)];
+        uint8_t color_index = vram[char_base + tile_id * 64 + (y & 7) * 8 + (x & 7)];
+        colors[screen_x] = inside ? color_index : 0;
+    }
 
+    for (int screen_x = 0; screen_x < 240; screen_x++) {
+        uint8_t color_index = colors[screen_x];
         if (color_index != 0) {
             uint32_t pal_offset = color_index * 2;
-            if (pal_offset + 1 < m_palette.size()) {
-                uint16_t color = m_palette[pal_offset] | (m_palette[pal_offset + 1] << 8);
-                m_bg_buffer[layer][screen_x] = color;
-                m_bg_priority[layer][screen_x] = priority;
-            }
+            m_bg_buffer[layer][screen_x] = m_palette[pal_offset] | (m_palette[pal_offset + 1] << 8);
+            m_bg_priority[layer][screen_x] = priority;
         }
     }
 }
 
-void PPU::render_sprites() {
-    // OAM contains 128 sprites, each 8 bytes
-    // Render in reverse order so lower index sprites have higher priority
-    for (int sprite = 127; sprite >= 0; sprite--) {
-        uint16_t attr0 = m_oam[sprite * 8 + 0] | (m_oam[sprite * 8 + 1] << 8);
-        uint16_t attr1 = m_oam[sprite * 8 + 2] | (m_oam[sprite * 8 + 3] << 8);
-        uint16_t attr2 = m_oam[sprite * 8 + 4] | (m_oam[sprite * 8 + 5] << 8);
+namespace {
 
-        // Check object mode
-        int obj_mode = (attr0 >> 8) & 3;
-        if (obj_mode == 2) continue;  // Disabled/hidden
+// OBJ width and height by shape (attr0 bits 14-15, 3 is invalid) and size
+// (attr1 bits 14-15)
+constexpr int OBJ_SIZES[3][4][2] = {
+    {{8, 8}, {16, 16}, {32, 32}, {64, 64}},   // Square
+    {{16, 8}, {32, 8}, {32, 16}, {64, 32}},   // Horizontal
+    {{8, 16}, {8, 32}, {16, 32}, {32, 64}}    // Vertical
+};
 
-        bool is_affine = attr0 & 0x0100;
-        bool double_size = is_affine && (attr0 & 0x0200);
+} // namespace
 
-        // Get sprite dimensions
-        int shape = (attr0 >> 14) & 3;
-        int size_bits = (attr1 >> 14) & 3;
-
-        static const int sprite_sizes[3][4][2] = {
-            {{8, 8}, {16, 16}, {32, 32}, {64, 64}},   // Square
-            {{16, 8}, {32, 8}, {32, 16}, {64, 32}},   // Horizontal
-            {{8, 16}, {8, 32}, {16, 32}, {32, 64}}    // Vertical
-        };
+// Which sprites cover each visible line, from their OAM Y, shape and size
+// Rebuilt on the first line drawn after OAM changes, which for most games
+// is once a frame after the VBlank OAM DMA.
+void PPU::build_sprite_lines() {
+    m_sprite_lines.fill({});
 
-        if (shape == 3) continue;  // Invalid shape
+    for (int sprite = 0; sprite < 128; sprite++) {
+        uint16_t attr0 = m_oam[sprite * 8 + 0] | (m_oam[sprite * 8 + 1] << 8);
+        uint16_t attr1 = m_oam[sprite * 8 + 2] | (m_oam[sprite * 8 + 3] << 8);
 
-        int width = sprite_sizes[shape][size_bits][0];
-        int height = sprite_sizes[shape][size_bits][1];
+        int obj_mode = (attr0 >> 8) & 3;
+        int shape = (attr0 >> 14) & 3;
+        if (obj_mode == 2 || shape == 3) continue;  // Disabled, or invalid shape
 
         // For affine double-size, the bounding box is doubled
-        int bounds_height = double_size ? height * 2 : height;
-        (void)double_size;  // bounds_width not needed for non-affine sprites
+        int height = OBJ_SIZES[shape][(attr1 >> 14) & 3][1];
+        if (obj_mode == 3) height *= 2;
 
-        // Get sprite position
         int y = attr0 & 0xFF;
         if (y >= 160) y -= 256;
 
-        int x = attr1 & 0x1FF;
-        if (x >= 240) x -= 512;
-
-        // Check if sprite is on current scanline
-        if (m_vcount < y || m_vcount >= y + bounds_height) continue;
-
-        // Handle affine sprites separately
-        if (is_affine) {
-            render_affine_sprite(sprite, attr0, attr1, attr2);
-            continue;
+        int first = std::max(y, 0);
+        int last = std::min(y + height, VDRAW_LINES);
+        for (int line = first; line < last; line++) {
+            m_sprite_lines[line][sprite >> 6] |= uint64_t(1) << (sprite & 63);
         }
+    }
+    m_sprite_lines_valid = true;
+}
 
-        int sprite_y = m_vcount - y;
+void PPU::render_sprites() {
+    if (m_vcount >= VDRAW_LINES) return;
+    if (!m_sprite_lines_valid) build_sprite_lines();
 
-        // Get sprite attributes
-        bool h_flip = attr1 & 0x1000;
-        bool v_flip = attr1 & 0x2000;
-        int tile_id = attr2 & 0x3FF;
+    // OAM contains 128 sprites, each 8 bytes
+    // Render in reverse order so lower index sprites have higher priority
+    const std::array<uint64_t, 2>& line = m_sprite_lines[m_vcount];
+    for (int word = 1; word >= 0; word--) {
+        uint64_t bits = line[word];
+        while (bits) {
+            int bit = 63 - __builtin_clzll(bits);
+            bits &= ~(uint64_t(1) << bit);
+            int sprite = word * 64 + bit;
+
+            uint16_t attr0 = m_oam[sprite * 8 + 0] | (m_oam[sprite * 8 + 1] << 8);
+            uint16_t attr1 = m_oam[sprite * 8 + 2] | (m_oam[sprite * 8 + 3] << 8);
+            uint16_t attr2 = m_oam[sprite * 8 + 4] | (m_oam[sprite * 8 + 5] << 8);
+
+            if (attr0 & 0x0100) {
+                render_affine_sprite(sprite, attr0, attr1, attr2);
+            } else {
+                render_regular_sprite(attr0, attr1, attr2);
+            }
+        }
+    }
+}
 
-        // In bitmap modes (3-5), sprite tiles with index < 512 are unavailable
-        // because the lower VRAM bank (0x06010000-0x06013FFF) is used by the bitmap framebuffer.
-        // Only tiles >= 512 (starting at 0x06014000) can be used for sprites.
-        if (static_cast<int>(m_mode) >= 3 && tile_id < 512) continue;
+void PPU::render_regular_sprite(uint16_t attr0, uint16_t attr1, uint16_t attr2) {
+    int shape = (attr0 >> 14) & 3;
+    int size_bits = (attr1 >> 14) & 3;
+    int width = OBJ_SIZES[shape][size_bits][0];
+    int height = OBJ_SIZES[shape][size_bits][1];
 
-        uint8_t priority = (attr2 >> 10) & 3;
-        int palette = (attr2 >> 12) & 0xF;
-        bool is_256_color = attr0 & 0x2000;
-        bool semi_transparent = (obj_mode == 1);  // Semi-transparent mode
-        bool is_obj_window = (obj_mode == 2);     // Actually obj_mode == 2 is disabled, obj_mode == 3 is window
-        bool obj_mosaic = (attr0 & 0x1000) != 0;
+    // Get sprite position
+    int y = attr0 & 0xFF;
+    if (y >= 160) y -= 256;
 
-        if (obj_mode == 3) {
-            is_obj_window = true;
-        }
+    int x = attr1 & 0x1FF;
+    if (x >= 240) x -= 512;
 
-        // OBJ mosaic sizes (bits 8-15 of MOSAIC register)
-        int obj_mosaic_h = ((m_mosaic >> 8) & 0xF) + 1;
-        int obj_mosaic_v = ((m_mosaic >> 12) & 0xF) + 1;
+    int sprite_y = m_vcount - y;
 
-        // Apply vertical mosaic
-        if (obj_mosaic && obj_mosaic_v > 1) {
-            sprite_y = (sprite_y / obj_mosaic_v) * obj_mosaic_v;
-        }
+    // Get sprite attributes
+    bool h_flip = attr1 & 0x1000;
+    bool v_flip = attr1 & 0x2000;
+    int tile_id = attr2 & 0x3FF;
 
-        if (v_flip) sprite_y = height - 1 - sprite_y;
+    // In bitmap modes (3-5), sprite tiles with index < 512 are unavailable
+    // because the lower VRAM bank (0x06010000-0x06013FFF) is used by the bitmap framebuffer.
+    // Only tiles >= 512 (starting at 0x06014000) can be used for sprites.
+    if (static_cast<int>(m_mode) >= 3 && tile_id < 512) return;
 
-        // Render sprite pixels
-        for (int sprite_x = 0; sprite_x < width; sprite_x++) {
-            int screen_x = x + sprite_x;
-            if (screen_x < 0 || screen_x >= 240) continue;
+    int obj_mode = (attr0 >> 8) & 3;
+    uint8_t priority = (attr2 >> 10) & 3;
+    int palette = (attr2 >> 12) & 0xF;
+    bool is_256_color = attr0 & 0x2000;
+    bool semi_transparent = (obj_mode == 1);  // Semi-transparent mode
+    bool is_obj_window = (obj_mode == 3);     // obj_mode == 2 is disabled, obj_mode == 3 is window
+    bool obj_mosaic = (attr0 & 0x1000) != 0;
 
-            // Apply horizontal mosaic
-            int mosaic_sprite_x = sprite_x;
-            if (obj_mosaic && obj_mosaic_h > 1) {
-                mosaic_sprite_x = (sprite_x / obj_mosaic_h) * obj_mosaic_h;
-            }
+    // OBJ mosaic sizes (bits 8-15 of MOSAIC register)
+    int obj_mosaic_h = ((m_mosaic >> 8) & 0xF) + 1;
+    int obj_mosaic_v = ((m_mosaic >> 12) & 0xF) + 1;
 
-            int pixel_x = h_flip ? (width - 1 - mosaic_sprite_x) : mosaic_sprite_x;
+    // Apply vertical mosaic
+    if (obj_mosaic && obj_mosaic_v > 1) {
+        sprite_y = (sprite_y / obj_mosaic_v) * obj_mosaic_v;
+    }
 
-            // Calculate tile offset
-            int tile_row = sprite_y / 8;
-            int tile_col = pixel_x / 8;
-            int in_tile_x = pixel_x & 7;
-            int in_tile_y = sprite_y & 7;
+    if (v_flip) sprite_y = height - 1 - sprite_y;
 
-            int current_tile;
-            if (m_dispcnt & 0x0040) {
-                // 1D mapping: tiles are laid out linearly
-                if (is_256_color) {
-                    // 256-color: each tile is 64 bytes, so tiles take up 2 tile slots
-                    current_tile = tile_id + tile_row * (width / 8) * 2 + tile_col * 2;
-                } else {
-                    // 16-color: each tile is 32 bytes
-                    current_tile = tile_id + tile_row * (width / 8) + tile_col;
-                }
+    // Decode the sprite's row once, a tile at a time; color index 0 is
+    // transparent, as are tiles past the end of VRAM
+    uint8_t row[64];
+    int tile_row = sprite_y / 8;
+    int in_tile_y = sprite_y & 7;
+    uint32_t char_base = 0x10000;  // Sprite tiles start at 0x10000 in VRAM
+    for (int tile_col = 0; tile_col < width / 8; tile_col++) {
+        int current_tile;
+        if (m_dispcnt & 0x0040) {
+            // 1D mapping: tiles are laid out linearly
+            if (is_256_color) {
+                // 256-color: each tile is 64 bytes, so tiles take up 2 tile slots
+                current_tile = tile_id + tile_row * (width / 8) * 2 + tile_col * 2;
             } else {
-                // 2D mapping: 32 tiles per row in VRAM
-                if (is_256_color) {
-                    current_tile = (tile_id & ~1) + tile_row * 32 + tile_col * 2;
-                } else {
-                    current_tile = tile_id + tile_row * 32 + tile_col;
-                }
+                // 16-color: each tile is 32 bytes
+                current_tile = tile_id + tile_row * (width / 8) + tile_col;
             }
-
-            uint8_t color_index;
-            uint32_t char_base = 0x10000;  // Sprite tiles start at 0x10000 in VRAM
-
+        } else {
+            // 2D mapping: 32 tiles per row in VRAM
             if (is_256_color) {
-                // 256-color: 64 bytes per tile (8x8 pixels, 1 byte per pixel)
-                uint32_t offset = char_base + current_tile * 32 + in_tile_y * 8 + in_tile_x;
-                // Note: current_tile already doubled for 256-color in tile calculation
-                if (offset >= m_vram.size()) continue;
-                color_index = m_vram[offset];
+                current_tile = (tile_id & ~1) + tile_row * 32 + tile_col * 2;
             } else {
-                // 16-color: 32 bytes per tile
-                uint32_t offset = char_base + current_tile * 32 + in_tile_y * 4 + in_tile_x / 2;
-                if (offset >= m_vram.size()) continue;
-                uint8_t byte = m_vram[offset];
-                color_index = (in_tile_x & 1) ? (byte >> 4) : (byte & 0x0F);
+                current_tile = tile_id + tile_row * 32 + tile_col;
             }
+        }
 
-            // Color index 0 is always transparent
-            if (color_index == 0) continue;
-
-            // For 16-color, add palette offset
-            if (!is_256_color) {
-                color_index += palette * 16;
+        uint8_t* pixels = &row[tile_col * 8];
+        if (is_256_color) {
+            // 256-color: 8 bytes per tile row, 1 byte per pixel
+            uint32_t offset = char_base + current_tile * 32 + in_tile_y * 8;
+            if (offset + 8 > m_vram.size()) {
+                std::memset(pixels, 0, 8);
+            } else {
+                std::memcpy(pixels, &m_vram[offset], 8);
             }
-
-            // Handle OBJ window mode
-            if (is_obj_window) {
-                m_sprite_is_window[screen_x] = true;
+        } else {
+            // 16-color: 4 bytes per tile row, low nibble first
+            uint32_t offset = char_base + current_tile * 32 + in_tile_y * 4;
+            if (offset + 4 > m_vram.size()) {
+                std::memset(pixels, 0, 8);
                 continue;
             }
-
-            // Sprite palette is at offset 0x200 in palette RAM
-            uint32_t pal_offset = 0x200 + color_index * 2;
-            if (pal_offset + 1 >= m_palette.size()) continue;
-            uint16_t color = m_palette[pal_offset] | (m_palette[pal_offset + 1] << 8);
-
-            // Only draw if higher or equal priority (lower number = higher priority)
-            // Since we iterate OAM 127->0, lower indices are processed last and should win
-            // at equal priority. Using <= allows this overwrite behavior.
-            if (priority <= m_sprite_priority[screen_x]) {
-                m_sprite_buffer[screen_x] = color;
-                m_sprite_priority[screen_x] = priority;
-                m_sprite_semi_transparent[screen_x] = semi_transparent;
+            for (int i = 0; i < 4; i++) {
+                uint8_t byte = m_vram[offset + i];
+                pixels[i * 2] = byte & 0x0F;
+                pixels[i * 2 + 1] = byte >> 4;
             }
         }
     }
+
+    // Only the part of the sprite on screen
+    int start = std::max(0, -x);
+    int end = std::min(width, 240 - x);
+    for (int sprite_x = start; sprite_x < end; sprite_x++) {
+        // Apply horizontal mosaic
+        int mosaic_sprite_x = sprite_x;
+        if (obj_mosaic && obj_mosaic_h > 1) {
+            mosaic_sprite_x = (sprite_x / obj_mosaic_h) * obj_mosaic_h;
+        }
+
+        int pixel_x = h_flip ? (width - 1 - mosaic_sprite_x) : mosaic_sprite_x;
+        uint8_t color_index = row[pixel_x];
+        if (color_index == 0) continue;
+
+        // For 16-color, add palette offset
+        if (!is_256_color) {
+            color_index += palette * 16;
+        }
+        draw_sprite_pixel(x + sprite_x, color_index, priority, semi_transparent, is_obj_window);
+    }
 }
 
 void PPU::render_affine_sprite([[maybe_unused]] int sprite_idx, uint16_t attr0, uint16_t attr1, uint16_t attr2) {
@@ -650,15 +779,8 @@ void PPU::render_affine_sprite([[maybe_unused]] int sprite_idx, uint16_t attr0,
     // Get sprite dimensions
     int shape = (attr0 >> 14) & 3;
     int size_bits = (attr1 >> 14) & 3;
-
-    static const int sprite_sizes[3][4][2] = {
-        {{8, 8}, {16, 16}, {32, 32}, {64, 64}},
-        {{16, 8}, {32, 8}, {32, 16}, {64, 32}},
-        {{8, 16}, {8, 32}, {16, 32}, {32, 64}}
-    };
-
-    int width = sprite_sizes[shape][size_bits][0];
-    int height = sprite_sizes[shape][size_bits][1];
+    int width = OBJ_SIZES[shape][size_bits][0];
+    int height = OBJ_SIZES[shape][size_bits][1];
 
     int bounds_width = double_size ? width * 2 : width;
     int bounds_height = double_size ? height * 2 : height;
@@ -692,6 +814,7 @@ void PPU::render_affine_sprite([[maybe_unused]] int sprite_idx, uint16_t attr0,
     // OBJ mosaic sizes (bits 8-15 of MOSAIC register)
     int obj_mosaic_h = ((m_mosaic >> 8) & 0xF) + 1;
     int obj_mosaic_v = ((m_mosaic >> 12) & 0xF) + 1;
+    bool mosaic_h = obj_mosaic && obj_mosaic_h > 1;
 
     // Calculate center of sprite
     int center_x = bounds_width / 2;
@@ -702,27 +825,29 @@ void PPU::render_affine_sprite([[maybe_unused]] int sprite_idx, uint16_t attr0,
     if (obj_mosaic && obj_mosaic_v > 1) {
         base_sprite_y = (base_sprite_y / obj_mosaic_v) * obj_mosaic_v;
     }
-    int sprite_y = base_sprite_y - center_y;
-
-    // Render each pixel in the bounding box
-    for (int sprite_x = 0; sprite_x < bounds_width; sprite_x++) {
-        int screen_x = x + sprite_x;
-        if (screen_x < 0 || screen_x >= 240) continue;
-
-        // Apply horizontal mosaic
-        int mosaic_sprite_x = sprite_x;
-        if (obj_mosaic && obj_mosaic_h > 1) {
-            mosaic_sprite_x = (sprite_x / obj_mosaic_h) * obj_mosaic_h;
+    int dy = base_sprite_y - center_y;
+
+    // Only the part of the bounding box on screen
+    int start = std::max(0, -x);
+    int end = std::min(bounds_width, 240 - x);
+
+    // Inverse-transformed position (PA, PB, PC, PD are 8.8 fixed point)
+    // relative to the sprite's center, stepped by PA and PC each pixel
+    int32_t step_x = pa * (start - center_x) + pb * dy;
+    int32_t step_y = pc * (start - center_x) + pd * dy;
+
+    for (int sprite_x = start; sprite_x < end; sprite_x++, step_x += pa, step_y += pc) {
+        int32_t fx = step_x;
+        int32_t fy = step_y;
+        if (mosaic_h) {
+            // Horizontal mosaic holds the transform at the block's first pixel
+            int dx = (sprite_x / obj_mosaic_h) * obj_mosaic_h - center_x;
+            fx = pa * dx + pb * dy;
+            fy = pc * dx + pd * dy;
         }
 
-        // Offset from center
-        int dx = mosaic_sprite_x - center_x;
-        int dy = sprite_y;
-
-        // Apply inverse transformation to get texture coordinates
-        // (PA, PB, PC, PD are 8.8 fixed point)
-        int tex_x = ((pa * dx + pb * dy) >> 8) + width / 2;
-        int tex_y = ((pc * dx + pd * dy) >> 8) + height / 2;
+        int tex_x = (fx >> 8) + width / 2;
+        int tex_y = (fy >> 8) + height / 2;
 
         // Check if within sprite bounds
         if (tex_x < 0 || tex_x >= width || tex_y < 0 || tex_y >= height) continue;
@@ -769,26 +894,35 @@ void PPU::render_affine_sprite([[maybe_unused]] int sprite_idx, uint16_t attr0,
         if (!is_256_color) {
             color_index += palette * 16;
         }
+        draw_sprite_pixel(x + sprite_x, color_index, priority, semi_transparent, is_obj_window);
+    }
+}
 
-        if (is_obj_window) {
-            m_sprite_is_window[screen_x] = true;
-            continue;
-        }
-
-        uint32_t pal_offset = 0x200 + color_index * 2;
-        if (pal_offset + 1 >= m_palette.size()) continue;
-        uint16_t color = m_palette[pal_offset] | (m_palette[pal_offset + 1] << 8);
+// color_index is into the OBJ half of palette RAM, already offset by the
+// 16-color palette number
+void PPU::draw_sprite_pixel(int screen_x, uint8_t color_index, uint8_t priority,
+                            bool semi_transparent, bool is_obj_window) {
+    // Handle OBJ window mode
+    if (is_obj_window) {
+        m_sprite_is_window[screen_x] = true;
+        return;
+    }
 
-        // Same priority logic as non-affine sprites: <= allows lower OAM to win
-        if (priority <= m_sprite_priority[screen_x]) {
-            m_sprite_buffer[screen_x] = color;
-            m_sprite_priority[screen_x] = priority;
-            m_sprite_semi_transparent[screen_x] = semi_transparent;
-        }
+    // Sprite palette is at offset 0x200 in palette RAM
+    uint32_t pal_offset = 0x200 + color_index * 2;
+    uint16_t color = m_palette[pal_offset] | (m_palette[pal_offset + 1] << 8);
+
+    // Only draw if higher or equal priority (lower number = higher priority)
+    // Since we iterate OAM 127->0, lower indices are processed last and should win
+    // at equal priority. Using <= allows this overwrite behavior.
+    if (priority <= m_sprite_priority[screen_x]) {
+        m_sprite_buffer[screen_x] = color;
+        m_sprite_priority[screen_x] = priority;
+        m_sprite_semi_transparent[screen_x] = semi_transparent;
     }
 }
 
-bool PPU::is_inside_window(int x, int window_id) {
+void PPU::paint_window(int window_id, uint8_t flags) {
     uint16_t h_reg, v_reg;
     if (window_id == 0) {
         h_reg = m_win0h;
@@ -803,14 +937,6 @@ bool PPU::is_inside_window(int x, int window_id) {
     int y1 = (v_reg >> 8) & 0xFF;
     int y2 = v_reg & 0xFF;
 
-    // Handle wraparound: if x1 > x2, window wraps horizontally
-    bool in_h;
-    if (x1 <= x2) {
-        in_h = (x >= x1 && x < x2);
-    } else {
-        in_h = (x >= x1 || x < x2);
-    }
-
     // Handle wraparound: if y1 > y2, window wraps vertically
     bool in_v;
     if (y1 <= y2) {
@@ -818,11 +944,23 @@ bool PPU::is_inside_window(int x, int window_id) {
     } else {
         in_v = (m_vcount >= y1 || m_vcount < y2);
     }
+    if (!in_v) return;
 
-    return in_h && in_v;
+    // Handle wraparound: if x1 > x2, window wraps horizontally
+    auto fill = [this, flags](int start, int end) {
+        for (int x = start; x < std::min(end, 240); x++) {
+            m_window_flags[x] = flags;
+        }
+    };
+    if (x1 <= x2) {
+        fill(x1, x2);
+    } else {
+        fill(0, x2);
+        fill(x1, 240);
+    }
 }
 
-uint8_t PPU::get_window_flags(int x) {
+void PPU::build_window_flags() {
     // Check if any windows are enabled
     bool win0_enabled = m_dispcnt & 0x2000;
     bool win1_enabled = m_dispcnt & 0x4000;
@@ -830,31 +968,25 @@ uint8_t PPU::get_window_flags(int x) {
 
     if (!win0_enabled && !win1_enabled && !obj_win_enabled) {
         // No windows - all features enabled
-        return 0x3F;
+        m_window_flags.fill(0x3F);
+        return;
     }
 
-    // Check windows in priority order: WIN0 > WIN1 > OBJWIN > WINOUT
-    if (win0_enabled && is_inside_window(x, 0)) {
-        return m_winin & 0x3F;
-    }
-    if (win1_enabled && is_inside_window(x, 1)) {
-        return (m_winin >> 8) & 0x3F;
-    }
-    if (obj_win_enabled && m_sprite_is_window[x]) {
-        return (m_winout >> 8) & 0x3F;
+    // Paint from lowest to highest priority: WINOUT < OBJWIN < WIN1 < WIN0
+    m_window_flags.fill(m_winout & 0x3F);
+    if (obj_win_enabled) {
+        uint8_t obj_flags = (m_winout >> 8) & 0x3F;
+        for (int x = 0; x < 240; x++) {
+            if (m_sprite_is_window[x]) m_window_flags[x] = obj_flags;
+        }
     }
-
-    // Outside all windows
-    return m_winout & 0x3F;
+    if (win1_enabled) paint_window(1, (m_winin >> 8) & 0x3F);
+    if (win0_enabled) paint_window(0, m_winin & 0x3F);
 }
 
-void PPU::apply_blending(int x, uint16_t& top_color, uint16_t bottom_color, int blend_mode) {
+void PPU::apply_blending(uint16_t& top_color, uint16_t bottom_color, int blend_mode) {
     if (blend_mode == 0) return;  // No blending
 
-    // Check window blend enable
-    uint8_t win_flags = get_window_flags(x);
-    if (!(win_flags & 0x20)) return;  // Blending disabled in this window
-
     // Extract RGB components (5 bits each)
     int r1 = top_color & 0x1F;
     int g1 = (top_color >> 5) & 0x1F;
@@ -899,86 +1031,76 @@ void PPU::compose_scanline() {
     // Get backdrop color
     uint16_t backdrop = m_palette[0] | (m_palette[1] << 8);
 
-    for (int x = 0; x < 240; x++) {
-        // Get window flags for this pixel
-        uint8_t win_flags = get_window_flags(x);
+    build_window_flags();
 
-        uint16_t final_color = backdrop;
-        uint16_t second_color = 0x8000;  // For blending
-        int top_priority = 5;
-        int top_layer = -1;  // -1 = backdrop, 0-3 = BG, 4 = sprite
-        int second_layer = -1;  // Track which layer is second for blend target check
-        bool found_top = false;
-        bool found_second = false;
+    // BG priority is fixed for the whole line, so sort the layers once:
+    // ascending priority, lower layer number first on ties
+    int order[4] = {0, 1, 2, 3};
+    int layer_priority[4];
+    for (int layer = 0; layer < 4; layer++) {
+        layer_priority[layer] = m_bgcnt[layer] & 3;
+    }
+    for (int i = 1; i < 4; i++) {
+        for (int j = i; j > 0 && layer_priority[order[j]] < layer_priority[order[j - 1]]; j--) {
+            std::swap(order[j], order[j - 1]);
+        }
+    }
+
+    // Composed as BGR555 and converted to RGBA as a whole line at the end
+    uint16_t colors[240];
+
+    for (int x = 0; x < 240; x++) {
+        uint8_t win_flags = m_window_flags[x];
+
+        // Opaque BG pixels enabled in this window, front to back
+        int visible[4];
+        int visible_count = 0;
+        for (int i = 0; i < 4; i++) {
+            int layer = order[i];
+            if (m_bg_buffer[layer][x] != 0x8000 && (win_flags & (1 << layer))) {
+                visible[visible_count++] = layer;
+            }
+        }
+        bool obj_visible = m_sprite_buffer[x] != 0x8000 && (win_flags & 0x10);
+        int obj_priority = m_sprite_priority[x];
 
         // Find top two visible layers for potential blending
-        for (int priority = 0; priority < 4; priority++) {
-            // Check sprites at this priority
-            if (!found_top && m_sprite_buffer[x] != 0x8000 && m_sprite_priority[x] == priority) {
-                if (win_flags & 0x10) {  // OBJ enabled in window
-                    final_color = m_sprite_buffer[x];
-                    top_priority = priority;
-                    top_layer = 4;
-                    found_top = true;
-
-                    // Check if semi-transparent sprite needs blending
-                    if (m_sprite_semi_transparent[x]) {
-                        // Continue to find second layer for blending
-                    } else {
-                        continue;
+        // -1 = backdrop, 0-3 = BG, 4 = sprite; sprites win priority ties
+        int top_layer = -1;
+        int second_layer = -1;
+        if (obj_visible && (visible_count == 0 || obj_priority <= layer_priority[visible[0]])) {
+            top_layer = 4;
+            if (visible_count > 0) {
+                second_layer = visible[0];
+                // An opaque sprite pairs with the first BG behind its own
+                // priority, falling back to one at the same priority
+                if (!m_sprite_semi_transparent[x]) {
+                    for (int i = 0; i < visible_count; i++) {
+                        if (layer_priority[visible[i]] > obj_priority) {
+                            second_layer = visible[i];
+                            break;
+                        }
                     }
                 }
             }
-
-            // Check backgrounds at this priority
-            for (int layer = 0; layer < 4; layer++) {
-                if (m_bg_buffer[layer][x] == 0x8000) continue;
-                if (m_bg_priority[layer][x] != priority) continue;
-                if (!(win_flags & (1 << layer))) continue;  // Layer not enabled in window
-
-                if (!found_top) {
-                    final_color = m_bg_buffer[layer][x];
-                    top_priority = priority;
-                    top_layer = layer;
-                    found_top = true;
-                } else if (!found_second) {
-                    second_color = m_bg_buffer[layer][x];
-                    second_layer = layer;
-                    found_second = true;
-                    break;
-                }
+        } else if (visible_count > 0) {
+            top_layer = visible[0];
+            if (visible_count > 1) {
+                second_layer = visible[1];
+            } else if (obj_visible) {
+                second_layer = 4;
             }
-
-            if (found_top && found_second) break;
         }
 
-        // Check if we need to find a second layer from remaining priorities
-        if (found_top && !found_second) {
-            for (int priority = top_priority; priority < 4; priority++) {
-                // Check sprites
-                if (top_layer != 4 && m_sprite_buffer[x] != 0x8000 &&
-                    m_sprite_priority[x] == priority && (win_flags & 0x10)) {
-                    second_color = m_sprite_buffer[x];
-                    second_layer = 4;  // OBJ
-                    found_second = true;
-                    break;
-                }
-
-                // Check backgrounds
-                for (int layer = 0; layer < 4; layer++) {
-                    if (layer == top_layer) continue;
-                    if (m_bg_buffer[layer][x] == 0x8000) continue;
-                    if (m_bg_priority[layer][x] != priority) continue;
-                    if (!(win_flags & (1 << layer))) continue;
-
-                    second_color = m_bg_buffer[layer][x];
-                    second_layer = layer;
-                    found_second = true;
-                    break;
-                }
-
-                if (found_second) break;
-            }
+        bool found_top = top_layer >= 0;
+        bool found_second = second_layer >= 0;
+        uint16_t final_color = backdrop;
+        uint16_t second_color = 0x8000;  // For blending
+        if (found_top) {
+            final_color = (top_layer == 4) ? m_sprite_buffer[x] : m_bg_buffer[top_layer][x];
+        }
+        if (found_second) {
+            second_color = (second_layer == 4) ? m_sprite_buffer[x] : m_bg_buffer[second_layer][x];
         }
 
         // Apply blending if enabled and applicable
@@ -1029,12 +1151,15 @@ void PPU::compose_scanline() {
             }
         }
 
-        if (apply_blend) {
-            apply_blending(x, final_color, second_color, blend_mode);
+        // Blending can also be masked off by the window
+        if (apply_blend && (win_flags & 0x20)) {
+            apply_blending(final_color, second_color, blend_mode);
         }
 
-        m_framebuffer[m_vcount * 240 + x] = palette_to_rgba(final_color);
+        colors[x] = final_color;
     }
+
+    convert_line(colors, &m_framebuffer[m_vcount * 240], 240);
 }
 
 uint32_t PPU::palette_to_rgba(uint16_t color) {
@@ -1054,6 +1179,63 @@ uint32_t PPU::palette_to_rgba(uint16_t color) {
     return 0xFF000000 | (b << 16) | (g << 8) | r;
 }
 
+// palette_to_rgba() over a line, eight pixels at a time with SSE2 or NEON;
+// elsewhere through a table of all 32K colors
+void PPU::convert_line(const uint16_t* colors, uint32_t* out, int count) {
+    int x = 0;
+#if defined(GBA_PPU_SSE2)
+    const __m128i five_bits = _mm_set1_epi16(0x1F);
+    const __m128i alpha = _mm_set1_epi16(static_cast<short>(0xFF00));
+    for (; x + 8 <= count; x += 8) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(colors + x));
+        __m128i r = _mm_and_si128(c, five_bits);
+        __m128i g = _mm_and_si128(_mm_srli_epi16(c, 5), five_bits);
+        __m128i b = _mm_and_si128(_mm_srli_epi16(c, 10), five_bits);
+        r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+        g = _mm_or_si128(_mm_slli_epi16(g, 3), _mm_srli_epi16(g, 2));
+        b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+
+        // 16-bit halves R|G<<8 and B|A<<8, interleaved into 32-bit pixels
+        __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+        __m128i ba = _mm_or_si128(b, alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_unpacklo_epi16(rg, ba));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x + 4), _mm_unpackhi_epi16(rg, ba));
+    }
+#elif defined(GBA_PPU_NEON)
+    const uint16x8_t five_bits = vdupq_n_u16(0x1F);
+    const uint16x8_t alpha = vdupq_n_u16(0xFF00);
+    for (; x + 8 <= count; x += 8) {
+        uint16x8_t c = vld1q_u16(colors + x);
+        uint16x8_t r = vandq_u16(c, five_bits);
+        uint16x8_t g = vandq_u16(vshrq_n_u16(c, 5), five_bits);
+        uint16x8_t b = vandq_u16(vshrq_n_u16(c, 10), five_bits);
+        r = vorrq_u16(vshlq_n_u16(r, 3), vshrq_n_u16(r, 2));
+        g = vorrq_u16(vshlq_n_u16(g, 3), vshrq_n_u16(g, 2));
+        b = vorrq_u16(vshlq_n_u16(b, 3), vshrq_n_u16(b, 2));
+
+        // Storing the two halves interleaved writes whole 32-bit pixels
+        uint16x8x2_t pixels;
+        pixels.val[0] = vorrq_u16(r, vshlq_n_u16(g, 8));
+        pixels.val[1] = vorrq_u16(b, alpha);
+        vst2q_u16(reinterpret_cast<uint16_t*>(out + x), pixels);
+    }
+#else
+    static const std::vector<uint32_t> table = [] {
+        std::vector<uint32_t> rgba(0x8000);
+        for (uint32_t color = 0; color < 0x8000; color++) {
+            rgba[color] = palette_to_rgba(static_cast<uint16_t>(color));
+        }
+        return rgba;
+    }();
+    for (; x < count; x++) {
+        out[x] = table[colors[x] & 0x7FFF];
+    }
+#endif
+    for (; x < count; x++) {
+        out[x] = palette_to_rgba(colors[x]);
+    }
+}
+
 uint8_t PPU::read_vram(uint32_t offset) {
     if (offset < m_vram.size()) {
         return m_vram[offset];
@@ -1064,6 +1246,8 @@ uint8_t PPU::read_vram(uint32_t offset) {
 void PPU::write_vram(uint32_t offset, uint8_t value) {
     if (offset < m_vram.size()) {
         m_vram[offset] = value;
+        m_block_stamps[offset / DIRTY_BLOCK_SIZE] = m_write_stamp;
+        if (m_worker) mark_dirty(offset / DIRTY_BLOCK_SIZE);
     }
 }
 
@@ -1077,6 +1261,8 @@ uint8_t PPU::read_palette(uint32_t offset) {
 void PPU::write_palette(uint32_t offset, uint8_t value) {
     if (offset < m_palette.size()) {
         m_palette[offset] = value;
+        m_block_stamps[VRAM_BLOCKS + offset / DIRTY_BLOCK_SIZE] = m_write_stamp;
+        if (m_worker) mark_dirty(VRAM_BLOCKS + offset / DIRTY_BLOCK_SIZE);
     }
 }
 
@@ -1090,13 +1276,185 @@ uint8_t PPU::read_oam(uint32_t offset) {
 void PPU::write_oam(uint32_t offset, uint8_t value) {
     if (offset < m_oam.size()) {
         m_oam[offset] = value;
+        m_sprite_lines_valid = false;
+        m_block_stamps[VRAM_BLOCKS + PALETTE_BLOCKS + offset / DIRTY_BLOCK_SIZE] = m_write_stamp;
+        if (m_worker) mark_dirty(VRAM_BLOCKS + PALETTE_BLOCKS + offset / DIRTY_BLOCK_SIZE);
+    }
+}
+
+uint8_t* PPU::vram_for_write(uint32_t offset, uint32_t size) {
+    mark_dirty_range(0, offset, size);
+    return m_vram.data() + offset;
+}
+
+uint8_t* PPU::palette_for_write(uint32_t offset, uint32_t size) {
+    mark_dirty_range(VRAM_BLOCKS, offset, size);
+    return m_palette.data() + offset;
+}
+
+uint8_t* PPU::oam_for_write(uint32_t offset, uint32_t size) {
+    mark_dirty_range(VRAM_BLOCKS + PALETTE_BLOCKS, offset, size);
+    m_sprite_lines_valid = false;
+    return m_oam.data() + offset;
+}
+
+// ============================================================================
+// Threaded rendering
+// ============================================================================
+
+void PPU::set_threaded_rendering(bool enabled) {
+    if (enabled == (m_worker != nullptr)) return;
+
+    if (!enabled) {
+        sync_rendering();
+        {
+            std::lock_guard<std::mutex> lock(m_worker->mutex);
+            m_worker->stop = true;
+        }
+        m_worker->work_ready.notify_all();
+        m_worker->thread.join();
+        m_worker.reset();
+        m_dirty_blocks.clear();
+        m_block_dirty.fill(false);
+        return;
     }
+
+    m_worker = std::make_unique<RenderWorker>(m_bus);
+    m_worker->shadow.m_framebuffer = m_framebuffer;
+    m_dirty_blocks.clear();
+    m_block_dirty.fill(false);
+    mark_all_dirty();
+    m_worker->thread = std::thread([worker = m_worker.get()] { worker->run(); });
 }
 
-void PPU::save_state(std::vector<uint8_t>& data) {
-    data.insert(data.end(), m_vram.begin(), m_vram.end());
-    data.insert(data.end(), m_palette.begin(), m_palette.end());
-    data.insert(data.end(), m_oam.begin(), m_oam.end());
+void PPU::sync_rendering() {
+    if (!m_worker) return;
+    std::unique_lock<std::mutex> lock(m_worker->mutex);
+    m_worker->work_ready.notify_one();
+    m_worker->work_done.wait(lock, [this] { return m_worker->tail == m_worker->head; });
+    m_framebuffer = m_worker->shadow.m_framebuffer;
+}
+
+uint8_t* PPU::block_data(int block) {
+    if (block < VRAM_BLOCKS) return m_vram.data() + block * DIRTY_BLOCK_SIZE;
+    block -= VRAM_BLOCKS;
+    if (block < PALETTE_BLOCKS) return m_palette.data() + block * DIRTY_BLOCK_SIZE;
+    return m_oam.data() + (block - PALETTE_BLOCKS) * DIRTY_BLOCK_SIZE;
+}
+
+void PPU::mark_dirty(int block) {
+    if (!m_block_dirty[block]) {
+        m_block_dirty[block] = true;
+        m_dirty_blocks.push_back(static_cast<uint16_t>(block));
+    }
+}
+
+void PPU::mark_dirty_range(int first_block, uint32_t offset, uint32_t size) {
+    if (size == 0) return;
+    int last = first_block + static_cast<int>((offset + size - 1) / DIRTY_BLOCK_SIZE);
+    for (int block = first_block + static_cast<int>(offset / DIRTY_BLOCK_SIZE); block <= last; block++) {
+        m_block_stamps[block] = m_write_stamp;
+        if (m_worker) mark_dirty(block);
+    }
+}
+
+void PPU::mark_all_dirty() {
+    for (int block = 0; block < TOTAL_BLOCKS; block++) {
+        mark_dirty(block);
+    }
+}
+
+void PPU::capture_line_state(LineState& state) const {
+    state.vcount = m_vcount;
+    state.dispcnt = m_dispcnt;
+    state.mode = m_mode;
+    state.bgcnt = m_bgcnt;
+    state.bghofs = m_bghofs;
+    state.bgvofs = m_bgvofs;
+    state.bgpa = m_bgpa;
+    state.bgpb = m_bgpb;
+    state.bgpc = m_bgpc;
+    state.bgpd = m_bgpd;
+    state.bgx = m_bgx;
+    state.bgy = m_bgy;
+    state.bgx_internal = m_bgx_internal;
+    state.bgy_internal = m_bgy_internal;
+    state.win0h = m_win0h;
+    state.win1h = m_win1h;
+    state.win0v = m_win0v;
+    state.win1v = m_win1v;
+    state.winin = m_winin;
+    state.winout = m_winout;
+    state.bldcnt = m_bldcnt;
+    state.bldalpha = m_bldalpha;
+    state.bldy = m_bldy;
+    state.mosaic = m_mosaic;
+}
+
+void PPU::apply_line_state(const LineState& state) {
+    m_vcount = state.vcount;
+    m_dispcnt = state.dispcnt;
+    m_mode = state.mode;
+    m_bgcnt = state.bgcnt;
+    m_bghofs = state.bghofs;
+    m_bgvofs = state.bgvofs;
+    m_bgpa = state.bgpa;
+    m_bgpb = state.bgpb;
+    m_bgpc = state.bgpc;
+    m_bgpd = state.bgpd;
+    m_bgx = state.bgx;
+    m_bgy = state.bgy;
+    m_bgx_internal = state.bgx_internal;
+    m_bgy_internal = state.bgy_internal;
+    m_win0h = state.win0h;
+    m_win1h = state.win1h;
+    m_win0v = state.win0v;
+    m_win1v = state.win1v;
+    m_winin = state.winin;
+    m_winout = state.winout;
+    m_bldcnt = state.bldcnt;
+    m_bldalpha = state.bldalpha;
+    m_bldy = state.bldy;
+    m_mosaic = state.mosaic;
+}
+
+void PPU::queue_scanline() {
+    RenderWorker& worker = *m_worker;
+    std::unique_lock<std::mutex> lock(worker.mutex);
+    if (worker.head - worker.tail >= RenderWorker::QUEUE_SIZE) {
+        worker.work_ready.notify_one();
+        worker.work_done.wait(lock, [&worker] {
+            return worker.head - worker.tail < RenderWorker::QUEUE_SIZE;
+        });
+    }
+    LineJob& job = worker.jobs[worker.head % RenderWorker::QUEUE_SIZE];
+    lock.unlock();
+
+    // The worker never touches a job between tail and head, so it can be
+    // filled without holding the lock
+    capture_line_state(job.state);
+    std::sort(m_dirty_blocks.begin(), m_dirty_blocks.end());
+    job.blocks.assign(m_dirty_blocks.begin(), m_dirty_blocks.end());
+    job.data.resize(job.blocks.size() * DIRTY_BLOCK_SIZE);
+    uint8_t* dst = job.data.data();
+    for (uint16_t block : m_dirty_blocks) {
+        std::memcpy(dst, block_data(block), DIRTY_BLOCK_SIZE);
+        dst += DIRTY_BLOCK_SIZE;
+        m_block_dirty[block] = false;
+    }
+    m_dirty_blocks.clear();
+
+    lock.lock();
+    worker.head++;
+    if (worker.head - worker.tail >= RenderWorker::WAKE_BATCH) {
+        worker.work_ready.notify_one();
+    }
+}
+
+void PPU::save_state(StateWriter& data) {
+    data.write(m_vram.data(), m_vram.size());
+    data.write(m_palette.data(), m_palette.size());
+    data.write(m_oam.data(), m_oam.size());
 
     // Save timing state
     data.push_back(m_vcount & 0xFF);
@@ -1130,6 +1488,9 @@ void PPU::load_state(const uint8_t*& data, size_t& remaining) {
     std::memcpy(m_oam.data(), data, m_oam.size());
     data += m_oam.size();
     remaining -= m_oam.size();
+    m_sprite_lines_valid = false;
+
+    if (m_worker) mark_all_dirty();
 
     m_vcount = data[0] | (data[1] << 8);
     data += 2; remaining -= 2;
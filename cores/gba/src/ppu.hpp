@@ -1,14 +1,17 @@
 #pragma once
 
 #include "types.hpp"
+#include "emu/state_writer.hpp"
 #include <cstdint>
 #include <cstdio>
 #include <array>
+#include <memory>
 #include <vector>
 
 namespace gba {
 
 class Bus;
+using emu::StateWriter;
 
 // GBA PPU - 240x160 display with multiple modes
 class PPU {
@@ -19,6 +22,11 @@ public:
     void reset();
     void step(int cycles);
 
+    // Cycles until the next HBlank start or end of scanline
+    int cycles_until_event() const {
+        return (m_hcount < HDRAW_CYCLES ? HDRAW_CYCLES : SCANLINE_CYCLES) - m_hcount;
+    }
+
     // Memory access
     uint8_t read_vram(uint32_t offset);
     void write_vram(uint32_t offset, uint8_t value);
@@ -27,18 +35,49 @@ public:
     uint8_t read_oam(uint32_t offset);
     void write_oam(uint32_t offset, uint8_t value);
 
+    // Backing storage for the bus page table
+    const uint8_t* get_vram_data() const { return m_vram.data(); }
+    const uint8_t* get_palette_data() const { return m_palette.data(); }
+    const uint8_t* get_oam_data() const { return m_oam.data(); }
+
+    // Storage for a bulk write of [offset, offset + size), marked dirty
+    // for the render worker and stamped
+    uint8_t* vram_for_write(uint32_t offset, uint32_t size);
+    uint8_t* palette_for_write(uint32_t offset, uint32_t size);
+    uint8_t* oam_for_write(uint32_t offset, uint32_t size);
+
+    // Write stamps for incremental captures, as Bus::get_ram_stamps() for
+    // VRAM, palette and OAM: one per 256 bytes, in state order
+    static constexpr size_t STAMP_BLOCKS = (0x18000 + 0x400 + 0x400) / 256;
+    const uint32_t* get_write_stamps() const { return m_block_stamps.data(); }
+    void set_write_stamp(uint32_t stamp) { m_write_stamp = stamp; }
+
     // Get framebuffer
     const uint32_t* get_framebuffer() const { return m_framebuffer.data(); }
 
+    // Skip scanline composition for frames that won't be shown; register
+    // latches, affine reference points and all timing stay exact
+    void set_video_enabled(bool enabled) { m_video_enabled = enabled; }
+
+    // Draw visible lines on a worker thread. At each HBlank the emulation
+    // thread only latches registers and queues the memory blocks written
+    // since the previous line; output is identical to serial rendering.
+    void set_threaded_rendering(bool enabled);
+    bool is_threaded_rendering() const { return m_worker != nullptr; }
+
+    // Wait for queued lines and publish them to get_framebuffer()
+    void sync_rendering();
+
     // Get current scanline (for VCOUNT)
     uint16_t get_vcount() const { return m_vcount; }
 
     // Save state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
 
 private:
     void render_scanline();
+    void draw_scanline();
     void render_mode0();
     void render_mode1();
     void render_mode2();
@@ -46,16 +85,21 @@ private:
     void render_mode4();
     void render_mode5();
     void render_sprites();
+    void build_sprite_lines();
+    void render_regular_sprite(uint16_t attr0, uint16_t attr1, uint16_t attr2);
     void render_background(int layer);
     void render_affine_background(int layer);
     void render_affine_sprite(int sprite_idx, uint16_t attr0, uint16_t attr1, uint16_t attr2);
+    void draw_sprite_pixel(int screen_x, uint8_t color_index, uint8_t priority,
+                           bool semi_transparent, bool is_obj_window);
 
     void compose_scanline();
-    bool is_inside_window(int x, int window_id);
-    uint8_t get_window_flags(int x);
-    void apply_blending(int x, uint16_t& top_color, uint16_t bottom_color, int blend_mode);
+    void build_window_flags();
+    void paint_window(int window_id, uint8_t flags);
+    void apply_blending(uint16_t& top_color, uint16_t bottom_color, int blend_mode);
 
-    uint32_t palette_to_rgba(uint16_t color);
+    static uint32_t palette_to_rgba(uint16_t color);
+    static void convert_line(const uint16_t* colors, uint32_t* out, int count);
 
     Bus& m_bus;
 
@@ -64,6 +108,11 @@ private:
     std::array<uint8_t, 0x400> m_palette;    // 1KB Palette RAM
     std::array<uint8_t, 0x400> m_oam;        // 1KB OAM
 
+    // Sprites covering each visible line, bit n for OAM entry n; any OAM
+    // write invalidates it (see build_sprite_lines())
+    std::array<std::array<uint64_t, 2>, 160> m_sprite_lines;
+    bool m_sprite_lines_valid = false;
+
     // Framebuffer (240x160 RGBA)
     std::array<uint32_t, 240 * 160> m_framebuffer;
 
@@ -75,6 +124,7 @@ private:
     std::array<uint8_t, 240> m_sprite_priority;   // Sprite priorities
     std::array<bool, 240> m_sprite_semi_transparent; // Semi-transparent sprite flags
     std::array<bool, 240> m_sprite_is_window;     // OBJ window flags
+    std::array<uint8_t, 240> m_window_flags;      // Layer/blend enables after windowing
 
     // Timing
     uint16_t m_vcount = 0;  // Current scanline (0-227)
@@ -83,6 +133,7 @@ private:
     // Display mode
     DisplayMode m_mode = DisplayMode::Mode0;
     bool m_frame_select = false;  // For double-buffered modes
+    bool m_video_enabled = true;  // Host output switch, not saved
 
     // Register cache (synced from bus)
     uint16_t m_dispcnt = 0;
@@ -144,6 +195,33 @@ private:
     // Mosaic register
     uint16_t m_mosaic = 0;
 
+    // Threaded rendering (see ppu.cpp)
+    struct LineState;
+    struct LineJob;
+    struct RenderWorker;
+
+    static constexpr int DIRTY_BLOCK_SIZE = 256;
+    static constexpr int VRAM_BLOCKS = 0x18000 / DIRTY_BLOCK_SIZE;
+    static constexpr int PALETTE_BLOCKS = 0x400 / DIRTY_BLOCK_SIZE;
+    static constexpr int TOTAL_BLOCKS = VRAM_BLOCKS + PALETTE_BLOCKS + 0x400 / DIRTY_BLOCK_SIZE;
+
+    void queue_scanline();
+    void capture_line_state(LineState& state) const;
+    void apply_line_state(const LineState& state);
+    uint8_t* block_data(int block);
+    void mark_dirty(int block);
+    void mark_dirty_range(int first_block, uint32_t offset, uint32_t size);
+    void mark_all_dirty();
+
+    std::unique_ptr<RenderWorker> m_worker;
+    std::array<bool, TOTAL_BLOCKS> m_block_dirty{};
+    std::vector<uint16_t> m_dirty_blocks;
+
+    // The blocks double as the write stamp granularity
+    static_assert(TOTAL_BLOCKS == STAMP_BLOCKS, "one write stamp per dirty block");
+    std::array<uint32_t, TOTAL_BLOCKS> m_block_stamps{};
+    uint32_t m_write_stamp = 0;
+
     // Constants
     static constexpr int HDRAW_CYCLES = 960;    // HBlank starts at cycle 960
     static constexpr int HBLANK_CYCLES = 272;   // HBlank lasts 272 cycles
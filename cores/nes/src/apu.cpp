@@ -1,5 +1,7 @@
 #include "apu.hpp"
 #include "bus.hpp"
+#include "expansion_audio.hpp"
+#include "emu/state_writer.hpp"
 
 #include <algorithm>
 #include <cmath>
@@ -47,6 +49,7 @@ const uint16_t APU::s_dmc_rate_pal[16] = {
 };
 
 APU::APU(Bus& bus) : m_bus(bus) {
+    m_blip.set_rates(m_cpu_freq, SAMPLE_RATE);
     reset();
 }
 
@@ -110,6 +113,11 @@ void APU::set_region(Region region) {
 
     // Update DMC timer period with new rate table
     m_dmc.timer_period = m_dmc_rate_table_ptr[m_dmc.rate_index];
+
+    // Resample at the new CPU clock; pending samples belong to the old one
+    m_blip.set_rates(m_cpu_freq, SAMPLE_RATE);
+    m_blip.clear(m_blip_level);
+    m_blip_time = 0;
 }
 
 void APU::reset() {
@@ -150,22 +158,19 @@ void APU::reset() {
     // Reset all filter states
     m_hp_filter_state = 0.0f;
     m_lp_filter_state = 0.0f;
-    m_aa_filter_state = 0.0f;
-    m_aa_filter_state2 = 0.0f;
-    m_sample_accumulator = 0.0f;
-    m_sample_count = 0;
-    m_prev_output_sample = 0.0f;
 
     // Reset DC blocker
     m_dc_blocker_prev_in = 0.0f;
     m_dc_blocker_prev_out = 0.0f;
 
-    // Reset DMC smoothing
-    m_dmc_smoothed_output = 0.0f;
-
     // Reset expansion audio
     m_expansion_audio = 0.0f;
-    m_expansion_audio_smoothed = 0.0f;
+
+    // Reset band-limited synthesis
+    m_blip.clear();
+    m_blip_level = 0.0f;
+    m_blip_time = 0;
+    m_mix_dirty = true;
 }
 
 void APU::step(int cpu_cycles) {
@@ -187,6 +192,7 @@ void APU::step(int cpu_cycles) {
                     clock_envelopes();
                     clock_length_counters();
                     clock_sweeps();
+                    m_mix_dirty = true;
                 }
             }
         }
@@ -196,6 +202,7 @@ void APU::step(int cpu_cycles) {
             m_triangle.timer = m_triangle.timer_period;
             if (m_triangle.length_counter > 0 && m_triangle.linear_counter > 0) {
                 m_triangle.sequence_pos = (m_triangle.sequence_pos + 1) & 31;
+                m_mix_dirty = true;
             }
         } else {
             m_triangle.timer--;
@@ -210,6 +217,7 @@ void APU::step(int cpu_cycles) {
                 if (m_pulse[p].timer == 0) {
                     m_pulse[p].timer = m_pulse[p].timer_period;
                     m_pulse[p].sequence_pos = (m_pulse[p].sequence_pos + 1) & 7;
+                    m_mix_dirty = true;
                 } else {
                     m_pulse[p].timer--;
                 }
@@ -221,6 +229,7 @@ void APU::step(int cpu_cycles) {
                     ((m_noise.shift_register >> 6) ^ m_noise.shift_register) & 1 :
                     ((m_noise.shift_register >> 1) ^ m_noise.shift_register) & 1;
                 m_noise.shift_register = (m_noise.shift_register >> 1) | (bit << 14);
+                m_mix_dirty = true;
             } else {
                 m_noise.timer--;
             }
@@ -262,81 +271,104 @@ void APU::step(int cpu_cycles) {
 
         if (should_clock) {
             clock_frame_counter();
+            m_mix_dirty = true;
         }
 
-        // Get raw mixed output
-        float raw_sample = mix_output();
-
-        // Apply anti-aliasing low-pass filter BEFORE downsampling
-        // This is critical to prevent aliasing artifacts
-        // Use a 2-pole filter for better roll-off (~12dB/octave)
-        // Cutoff frequency ~15kHz at 1.79MHz sampling rate
-        // Alpha = 2 * pi * fc / fs = 2 * pi * 15000 / 1789773 = 0.053
-        static constexpr float AA_ALPHA = 0.053f;
-        m_aa_filter_state = m_aa_filter_state + AA_ALPHA * (raw_sample - m_aa_filter_state);
-        m_aa_filter_state2 = m_aa_filter_state2 + AA_ALPHA * (m_aa_filter_state - m_aa_filter_state2);
-        float filtered_sample = m_aa_filter_state2;
-
-        // Accumulate filtered samples for averaging (box filter for downsampling)
-        m_sample_accumulator += filtered_sample;
-        m_sample_count++;
-
-        // Output sample at target rate (uses region-specific CPU frequency)
-        m_sample_counter += SAMPLE_RATE;
-        if (m_sample_counter >= m_cpu_freq) {
-            m_sample_counter -= m_cpu_freq;
-
-            // Average accumulated samples (box filter - simple but effective)
-            float sample = (m_sample_count > 0) ? (m_sample_accumulator / m_sample_count) : 0.0f;
-            m_sample_accumulator = 0.0f;
-            m_sample_count = 0;
-
-            // Apply high-pass filter to remove DC offset (~37Hz cutoff like real NES)
-            // y[n] = alpha * (y[n-1] + x[n] - x[n-1])
-            // Alpha = 1 / (1 + 2*pi*fc/fs) = 1 / (1 + 2*pi*37/44100) = 0.9947
-            static constexpr float HP_ALPHA = 0.9947f;
-            float hp_output = HP_ALPHA * (m_hp_filter_state + sample - m_dc_blocker_prev_in);
-            m_dc_blocker_prev_in = sample;
-            m_hp_filter_state = hp_output;
-            sample = hp_output;
-
-            // Apply gentle low-pass filter for final output smoothing (~14kHz)
-            // Alpha = 2 * pi * fc / fs = 2 * pi * 14000 / 44100 = 0.667
-            static constexpr float LP_ALPHA = 0.5f;  // Slightly gentler for smoothness
-            m_lp_filter_state = m_lp_filter_state + LP_ALPHA * (sample - m_lp_filter_state);
-            sample = m_lp_filter_state;
-
-            // Soft clipping to prevent harsh distortion if signal exceeds range
-            // Use tanh-style soft clipping
-            if (sample > 0.9f) {
-                sample = 0.9f + 0.1f * std::tanh((sample - 0.9f) * 10.0f);
-            } else if (sample < -0.9f) {
-                sample = -0.9f + 0.1f * std::tanh((sample + 0.9f) * 10.0f);
+        // Hand level changes to the blip buffer at this cycle
+        if (m_audio_enabled) {
+            if (m_mix_dirty) {
+                update_mix();
+            }
+            if (++m_blip_time >= BLIP_FRAME_CYCLES) {
+                flush_samples();
             }
+        }
+    }
+}
 
-            // Linear interpolation with previous sample to reduce aliasing in final output
-            // This provides additional smoothing for sample rate conversion
-            float interp_sample = 0.5f * (sample + m_prev_output_sample);
-            m_prev_output_sample = sample;
-            sample = interp_sample;
-
-            // If streaming callback is set, use low-latency path
-            if (m_audio_callback) {
-                m_stream_buffer[m_stream_pos * 2] = sample;
-                m_stream_buffer[m_stream_pos * 2 + 1] = sample;  // Stereo
-                m_stream_pos++;
-
-                // Flush when buffer is full (every 64 samples = ~1.5ms)
-                if (m_stream_pos >= STREAM_BUFFER_SIZE) {
-                    m_audio_callback(m_stream_buffer, m_stream_pos, SAMPLE_RATE);
-                    m_stream_pos = 0;
-                }
-            } else {
-                // Legacy path: buffer until get_samples() is called
-                if (m_audio_write_pos < AUDIO_BUFFER_SIZE * 2 - 1) {
-                    m_audio_buffer[m_audio_write_pos++] = sample;
-                    m_audio_buffer[m_audio_write_pos++] = sample;  // Stereo
-                }
+void APU::set_audio_enabled(bool enabled) {
+    if (enabled == m_audio_enabled) return;
+    m_audio_enabled = enabled;
+    if (enabled) {
+        restart_synthesis();
+    }
+}
+
+void APU::restart_synthesis() {
+    // Restart at the current mix level; lining the high-pass input up with
+    // it keeps the output from stepping
+    m_blip_level = mix_output();
+    m_blip.clear(m_blip_level);
+    m_blip_time = 0;
+    m_mix_dirty = false;
+    m_dc_blocker_prev_in = m_blip_level;
+}
+
+void APU::update_mix() {
+    m_mix_dirty = false;
+    float level = mix_output();
+    if (level != m_blip_level) {
+        m_blip.add_delta(m_blip_time, level - m_blip_level);
+        m_blip_level = level;
+    }
+}
+
+void APU::add_expansion_audio(ExpansionAudio& audio, uint32_t cycles) {
+    // Steps go in at their own cycle rather than the current one; a step
+    // from before the current blip frame lands at its start
+    for (const ExpansionAudio::Step& step : audio.get_steps()) {
+        if (m_audio_enabled) {
+            uint32_t ago = cycles - step.cycle;
+            uint32_t time = m_blip_time > ago ? m_blip_time - ago : 0;
+            float delta = (step.level - m_expansion_audio) * EXPANSION_GAIN;
+            m_blip.add_delta(time, delta);
+            m_blip_level += delta;
+        }
+        m_expansion_audio = step.level;
+    }
+    audio.clear_steps();
+}
+
+void APU::flush_samples() {
+    m_blip.end_frame(m_blip_time);
+    m_blip_time = 0;
+
+    float samples[256];
+    size_t count = m_blip.read_samples(samples, 256);
+    for (size_t i = 0; i < count; i++) {
+        float sample = samples[i];
+
+        // Apply high-pass filter to remove DC offset (~37Hz cutoff like real NES)
+        // y[n] = alpha * (y[n-1] + x[n] - x[n-1])
+        // Alpha = 1 / (1 + 2*pi*fc/fs) = 1 / (1 + 2*pi*37/44100) = 0.9947
+        static constexpr float HP_ALPHA = 0.9947f;
+        float hp_output = HP_ALPHA * (m_hp_filter_state + sample - m_dc_blocker_prev_in);
+        m_dc_blocker_prev_in = sample;
+        m_hp_filter_state = hp_output;
+        sample = hp_output;
+
+        // Apply gentle low-pass filter for final output smoothing (~14kHz)
+        // Alpha = 2 * pi * fc / fs = 2 * pi * 14000 / 44100 = 0.667
+        static constexpr float LP_ALPHA = 0.5f;  // Slightly gentler for smoothness
+        m_lp_filter_state = m_lp_filter_state + LP_ALPHA * (sample - m_lp_filter_state);
+        sample = m_lp_filter_state;
+
+        // Soft clipping to prevent harsh distortion if signal exceeds range
+        // Use tanh-style soft clipping
+        if (sample > 0.9f) {
+            sample = 0.9f + 0.1f * std::tanh((sample - 0.9f) * 10.0f);
+        } else if (sample < -0.9f) {
+            sample = -0.9f + 0.1f * std::tanh((sample + 0.9f) * 10.0f);
+        }
+
+        // If a stream sink is set, use low-latency path
+        if (m_stream.active()) {
+            m_stream.push(sample, sample);  // Stereo
+        } else {
+            // Legacy path: buffer until get_samples() is called
+            if (m_audio_write_pos < AUDIO_BUFFER_SIZE * 2 - 1) {
+                m_audio_buffer[m_audio_write_pos++] = sample;
+                m_audio_buffer[m_audio_write_pos++] = sample;  // Stereo
             }
         }
     }
@@ -485,6 +517,7 @@ void APU::clock_dmc() {
 
     // Step 1: Output a bit (if not in silence mode)
     if (!m_dmc.silence_flag) {
+        m_mix_dirty = true;
         // Bit 0 of shift register determines +2 or -2
         if (m_dmc.shift_register & 1) {
             // Increment output level (clamped to 127)
@@ -596,21 +629,14 @@ float APU::mix_output() {
         noise = m_noise.constant_volume ? m_noise.volume : m_noise.envelope_counter;
     }
 
-    // DMC - apply smoothing to reduce clicks from direct loads ($4011 writes)
-    // The smoothing factor controls how quickly we approach the target level
-    // A value of 0.95 means we reach 95% of the change in about 20 samples
-    // at CPU rate, which is very fast but eliminates instant jumps
-    float dmc_target = static_cast<float>(m_dmc.output_level);
-    m_dmc_smoothed_output = m_dmc_smoothed_output + (1.0f - DMC_SMOOTH_FACTOR) * (dmc_target - m_dmc_smoothed_output);
-    float dmc = m_dmc_smoothed_output;
+    // DMC - direct loads ($4011 writes) arrive as band-limited steps, so no
+    // extra smoothing is needed against clicks
+    float dmc = static_cast<float>(m_dmc.output_level);
 
     tnd_out = 0.00851f * triangle + 0.00494f * noise + 0.00335f * dmc;
 
     // Mix in expansion audio (from mapper chips like VRC6, Sunsoft 5B, N163, MMC5)
-    // Apply smoothing to expansion audio to prevent clicks when it changes suddenly
-    m_expansion_audio_smoothed = m_expansion_audio_smoothed +
-        0.1f * (m_expansion_audio - m_expansion_audio_smoothed);
-    float expansion = m_expansion_audio_smoothed * 0.35f;  // Slightly lower to prevent clipping
+    float expansion = m_expansion_audio * EXPANSION_GAIN;
 
     // Calculate total output with headroom for peaks
     // Scale down slightly to prevent clipping when all channels are at max
@@ -639,6 +665,7 @@ uint8_t APU::cpu_read(uint16_t address) {
 }
 
 void APU::cpu_write(uint16_t address, uint8_t value) {
+    m_mix_dirty = true;
     switch (address) {
         // Pulse 1
         case 0x4000:
@@ -823,6 +850,11 @@ void APU::cpu_write(uint16_t address, uint8_t value) {
 }
 
 size_t APU::get_samples(float* buffer, size_t max_samples) {
+    // Draw the partial blip frame so each call returns everything emulated so far
+    if (m_blip_time > 0) {
+        flush_samples();
+    }
+
     size_t samples = m_audio_write_pos / 2;
     if (samples > max_samples) samples = max_samples;
 
@@ -848,9 +880,8 @@ size_t APU::get_samples(float* buffer, size_t max_samples) {
 // Serialization helpers
 namespace {
     template<typename T>
-    void write_value(std::vector<uint8_t>& data, T value) {
-        const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&value);
-        data.insert(data.end(), ptr, ptr + sizeof(T));
+    void write_value(StateWriter& data, T value) {
+        data.write(&value, sizeof(T));
     }
 
     template<typename T>
@@ -863,7 +894,7 @@ namespace {
     }
 }
 
-void APU::save_state(std::vector<uint8_t>& data) {
+void APU::save_state(StateWriter& data) {
     // Frame counter
     write_value(data, m_frame_counter_mode);
     write_value(data, m_frame_counter_step);
@@ -945,16 +976,14 @@ void APU::save_state(std::vector<uint8_t>& data) {
     write_value(data, m_cycles);
     write_value(data, m_sample_counter);
 
-    // Filter states
-    write_value(data, m_hp_filter_state);
-    write_value(data, m_lp_filter_state);
-    write_value(data, m_aa_filter_state);
-    write_value(data, m_aa_filter_state2);
-    write_value(data, m_prev_output_sample);
-    write_value(data, m_dc_blocker_prev_in);
-    write_value(data, m_dc_blocker_prev_out);
-    write_value(data, m_dmc_smoothed_output);
-    write_value(data, m_expansion_audio_smoothed);
+    // Filter states - the output filters now run on samples drawn from the
+    // blip buffer, whose pending kernel tail isn't serialized, so their state
+    // would make identical emulation states (and netplay hashes) differ. The
+    // nine slots stay in the layout as zeros for compatibility.
+    const float retired = 0.0f;
+    for (int i = 0; i < 9; i++) {
+        write_value(data, retired);
+    }
 }
 
 void APU::load_state(const uint8_t*& data, size_t& remaining) {
@@ -1064,28 +1093,13 @@ void APU::load_state(const uint8_t*& data, size_t& remaining) {
     read_value(data, remaining, m_cycles);
     read_value(data, remaining, m_sample_counter);
 
-    // Filter states - try to read them, but they may not exist in old save states
+    // Filter states from older save states are skipped; the live output
+    // filters keep running across the load (see save_state)
     if (remaining >= sizeof(float) * 9) {
-        read_value(data, remaining, m_hp_filter_state);
-        read_value(data, remaining, m_lp_filter_state);
-        read_value(data, remaining, m_aa_filter_state);
-        read_value(data, remaining, m_aa_filter_state2);
-        read_value(data, remaining, m_prev_output_sample);
-        read_value(data, remaining, m_dc_blocker_prev_in);
-        read_value(data, remaining, m_dc_blocker_prev_out);
-        read_value(data, remaining, m_dmc_smoothed_output);
-        read_value(data, remaining, m_expansion_audio_smoothed);
-    } else {
-        // Old save state format - initialize filter states to reasonable values
-        m_hp_filter_state = 0.0f;
-        m_lp_filter_state = 0.0f;
-        m_aa_filter_state = 0.0f;
-        m_aa_filter_state2 = 0.0f;
-        m_prev_output_sample = 0.0f;
-        m_dc_blocker_prev_in = 0.0f;
-        m_dc_blocker_prev_out = 0.0f;
-        m_dmc_smoothed_output = static_cast<float>(m_dmc.output_level);
-        m_expansion_audio_smoothed = m_expansion_audio;
+        float retired;
+        for (int i = 0; i < 9; i++) {
+            read_value(data, remaining, retired);
+        }
     }
 
     // Fade out current audio buffer smoothly to prevent pop on state load
@@ -1107,11 +1121,11 @@ void APU::load_state(const uint8_t*& data, size_t& remaining) {
         m_audio_write_pos = 0;
     }
 
-    m_sample_accumulator = 0.0f;
-    m_sample_count = 0;
     m_expansion_audio = 0.0f;
     m_dmc_dma_cycles = 0;
     m_dmc_dma_pending = false;
+
+    restart_synthesis();
 }
 
 } // namespace nes
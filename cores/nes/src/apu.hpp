@@ -4,11 +4,16 @@
 #include <cstddef>
 #include <array>
 #include <vector>
-#include <functional>
+
+#include "emu/audio_stream.hpp"
+#include "emu/blip_buffer.hpp"
+#include "emu/state_writer.hpp"
 
 namespace nes {
 
 class Bus;
+class ExpansionAudio;
+using emu::StateWriter;
 
 // NES APU (Audio Processing Unit) - 2A03
 class APU {
@@ -31,13 +36,19 @@ public:
     uint8_t cpu_read(uint16_t address);
     void cpu_write(uint16_t address, uint8_t value);
 
-    // Get audio samples (stereo, interleaved)
+    // Get audio samples (stereo, interleaved) at get_sample_rate()
     size_t get_samples(float* buffer, size_t max_samples);
 
-    // Streaming audio callback - called frequently with small batches for low latency
-    // Parameters: samples (interleaved stereo), sample_count (stereo pairs), sample_rate
-    using AudioStreamCallback = std::function<void(const float*, size_t, int)>;
-    void set_audio_callback(AudioStreamCallback callback) { m_audio_callback = callback; }
+    // Rate the blip buffer synthesizes at; the host converts from it
+    int get_sample_rate() const { return SAMPLE_RATE; }
+
+    // Stream samples through sink as they're produced (low-latency path);
+    // an empty sink buffers them for get_samples() instead
+    void set_audio_sink(const emu::AudioStreamSink& sink) { m_stream.set_sink(sink, SAMPLE_RATE); }
+
+    // Skip mixing and resampling (fast-forward, seeking); channel, length
+    // counter and IRQ state keep running exactly
+    void set_audio_enabled(bool enabled);
 
     // DMC DMA support - returns cycles the CPU should stall
     int get_dmc_dma_cycles();
@@ -45,11 +56,16 @@ public:
     // Check if DMC or frame counter IRQ is pending
     bool irq_pending() const { return m_frame_irq || m_dmc.irq_pending; }
 
-    // Set expansion audio output (for mapper audio chips)
-    void set_expansion_audio(float output) { m_expansion_audio = output; }
+    // Mix in a cartridge audio chip's output over the last `cycles` CPU
+    // cycles, which end at the current one, and clear its steps
+    void add_expansion_audio(ExpansionAudio& audio, uint32_t cycles);
+
+    // CPU cycles left before the blip buffer draws samples, which expansion
+    // audio has to be added by
+    uint32_t get_cycles_until_flush() const { return BLIP_FRAME_CYCLES - m_blip_time; }
 
     // Save state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
 
 private:
@@ -61,6 +77,9 @@ private:
     void dmc_fetch_sample();
 
     float mix_output();
+    void update_mix();
+    void flush_samples();
+    void restart_synthesis();
 
     Bus& m_bus;
 
@@ -186,7 +205,7 @@ private:
 
     // Timing (varies by region)
     int m_cycles = 0;
-    int m_sample_counter = 0;
+    int m_sample_counter = 0;  // Unused since band-limited synthesis; kept for state layout
     static constexpr int SAMPLE_RATE = 44100;
     int m_cpu_freq = 1789773;  // NTSC: 1789773, PAL: 1662607, Dendy: 1773448
 
@@ -208,37 +227,26 @@ private:
     float m_hp_filter_state = 0.0f;    // High-pass filter (removes DC offset)
     float m_lp_filter_state = 0.0f;    // Low-pass filter (anti-aliasing)
 
-    // Pre-downsampling anti-aliasing filter (applied at CPU rate)
-    // This is a more aggressive filter to prevent aliasing artifacts
-    float m_aa_filter_state = 0.0f;
-
-    // Higher-order filter for better anti-aliasing (2-pole Butterworth approximation)
-    float m_aa_filter_state2 = 0.0f;
-
-    // Sample accumulator for averaging (downsampling)
-    float m_sample_accumulator = 0.0f;
-    int m_sample_count = 0;
-
-    // Previous output sample for interpolation during downsampling
-    float m_prev_output_sample = 0.0f;
-
     // DC blocking filter state
     float m_dc_blocker_prev_in = 0.0f;
     float m_dc_blocker_prev_out = 0.0f;
 
-    // DMC smoothing to reduce clicks from direct loads
-    float m_dmc_smoothed_output = 0.0f;
-    static constexpr float DMC_SMOOTH_FACTOR = 0.95f;  // Smooth rapid DMC changes
-
     // Expansion audio input (from mapper audio chips)
     float m_expansion_audio = 0.0f;
-    float m_expansion_audio_smoothed = 0.0f;  // Smoothed expansion audio
-
-    // Streaming audio callback and buffer
-    AudioStreamCallback m_audio_callback;
-    static constexpr size_t STREAM_BUFFER_SIZE = 64;  // Small buffer for low latency
-    float m_stream_buffer[STREAM_BUFFER_SIZE * 2];    // Stereo
-    size_t m_stream_pos = 0;
+    static constexpr float EXPANSION_GAIN = 0.35f;  // Slightly lower to prevent clipping
+
+    // Band-limited synthesis: the mix is only recomputed when a channel
+    // output may have changed, and level changes go into the blip buffer as
+    // steps at their CPU cycle. Samples are drawn every BLIP_FRAME_CYCLES.
+    static constexpr uint32_t BLIP_FRAME_CYCLES = 2048;  // ~50 samples at 44.1kHz
+    emu::BlipBuffer m_blip{256};
+    float m_blip_level = 0.0f;   // Mix level last handed to the blip buffer
+    uint32_t m_blip_time = 0;    // CPU cycles into the current blip frame
+    bool m_mix_dirty = true;
+    bool m_audio_enabled = true;
+
+    // Streaming audio
+    emu::AudioStreamWriter m_stream;
 
     // Lookup tables (use current region's tables via pointers)
     static const uint8_t s_length_table[32];
@@ -3,9 +3,11 @@
 #include "ppu.hpp"
 #include "apu.hpp"
 #include "cartridge.hpp"
+#include "emu/state_writer.hpp"
 #include "mappers/mapper.hpp"
 #include "debug.hpp"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 
@@ -27,20 +29,42 @@ Bus::~Bus() = default;
 //   NMI at the correct point within an instruction
 // - Mapper IRQ counters are clocked via PPU A12 notifications
 //
+// With cycle-accurate mode off, the PPU dots are only counted here and run
+// in batches by sync_ppu(); see set_cycle_accurate().
+//
 // Returns true if an NMI edge was detected during this cycle.
 bool Bus::tick() {
-    if (!m_cycle_accurate) return false;
+    // Overclocked cycles belong to the CPU alone. The count stays put too,
+    // since DMA alignment and the APU's $4017 delay go by its parity.
+    if (m_cpu_only) {
+        if (m_cpu) m_cpu->set_irq_line(poll_irq_status());
+        return false;
+    }
 
     m_cpu_cycles++;
     bool nmi_detected = false;
 
+    // The cycle belongs to the CPU or to OAM DMA, apart from the PPU and
+    // APU work run from here
+    emu::ProfileSection owner = m_dma_active ? emu::ProfileSection::DMA : emu::ProfileSection::CPU;
+
     // Tick PPU 3 times per CPU cycle
     // NMI detection is done by PPU::step() internally which sets m_nmi_triggered
     // We check for NMI after each PPU step to detect the edge accurately
     if (m_ppu) {
-        m_ppu->step();
-        m_ppu->step();
-        m_ppu->step();
+        if (m_profile) m_profile->set(emu::ProfileSection::PPU);
+        if (m_cycle_accurate || (m_cartridge && m_cartridge->needs_exact_ppu_timing())) {
+            m_ppu->step();
+            m_ppu->step();
+            m_ppu->step();
+        } else {
+            // Catch-up mode: the PPU can run behind until the next point where
+            // it could signal VBlank/NMI, or until something accesses it
+            m_ppu_pending_cycles += 3;
+            if (m_ppu_pending_cycles >= m_ppu_sync_budget) {
+                sync_ppu();
+            }
+        }
 
         // Check if NMI was triggered during these PPU cycles
         // This allows the CPU to detect NMI edges mid-instruction
@@ -65,34 +89,55 @@ bool Bus::tick() {
     // Tick APU once per CPU cycle
     // APU frame counter and channel timers advance here
     if (m_apu) {
+        if (m_profile) m_profile->set(emu::ProfileSection::APU);
         m_apu->step(1);
     }
+    if (m_profile) m_profile->set(owner);
 
-    // Clock mapper for IRQ counters and expansion audio
+    // Clock mapper for IRQ counters and expansion audio, in batches that
+    // end no later than the cycle a counter IRQ could assert
     // Note: MMC3 A12 clocking happens via notify_ppu_address_bus during PPU step
-    if (m_cartridge) {
-        m_cartridge->cpu_cycle();
+    if (m_cartridge && m_cartridge->has_cpu_cycle_hook()) {
+        if (++m_mapper_pending_cycles >= m_mapper_cycle_budget) {
+            sync_mapper();
+        }
     }
 
     // Update IRQ line state for the CPU
-    // This is level-triggered, so we update it every cycle
+    // This is level-triggered, so we update it every cycle; the mapper is
+    // only asked again after something has called into it
     if (m_cpu) {
-        bool mapper_irq = m_cartridge && m_ppu ? m_cartridge->irq_pending(m_ppu->get_frame_cycle()) : false;
-        bool apu_irq = m_apu ? m_apu->irq_pending() : false;
-        m_cpu->set_irq_line(mapper_irq || apu_irq);
+        m_cpu->set_irq_line(poll_irq_status());
     }
 
     return nmi_detected;
 }
 
 void Bus::tick_ppu_only(int ppu_cycles) {
-    if (!m_cycle_accurate) return;
+    m_ppu_pending_cycles += ppu_cycles;
+    sync_ppu();
+}
 
-    if (m_ppu) {
-        for (int i = 0; i < ppu_cycles; i++) {
-            m_ppu->step();
-        }
+void Bus::sync_ppu() {
+    if (!m_ppu) return;
+
+    emu::ProfileSection previous = m_profile ? m_profile->get() : emu::ProfileSection::Other;
+    if (m_profile) m_profile->set(emu::ProfileSection::PPU);
+    while (m_ppu_pending_cycles > 0) {
+        m_ppu->step();
+        m_ppu_pending_cycles--;
     }
+    m_ppu_sync_budget = m_ppu->get_cycles_until_event();
+    if (m_cartridge && m_cartridge->has_ppu_events_hook() && m_cartridge->ppu_scanline_irq_armed()) {
+        m_ppu_sync_budget = std::min(m_ppu_sync_budget, m_ppu->get_cycles_until_line_event());
+    }
+    if (m_profile) m_profile->set(previous);
+}
+
+void Bus::set_cycle_accurate(bool enabled) {
+    // Settle any owed PPU dots before switching scheduling modes
+    sync_ppu();
+    m_cycle_accurate = enabled;
 }
 
 void Bus::check_interrupts() {
@@ -107,23 +152,77 @@ void Bus::check_interrupts() {
     }
 
     // Check for IRQ from mapper and APU
-    bool mapper_irq = m_cartridge ? m_cartridge->irq_pending(m_ppu->get_frame_cycle()) : false;
-    bool apu_irq = m_apu ? m_apu->irq_pending() : false;
-    m_cpu->set_irq_line(mapper_irq || apu_irq);
+    m_cpu->set_irq_line(poll_irq_status());
 }
 
 bool Bus::poll_irq_status() {
     // Poll IRQ status from all sources
-    bool mapper_irq = m_cartridge && m_ppu ? m_cartridge->irq_pending(m_ppu->get_frame_cycle()) : false;
+    bool mapper_irq = false;
+    if (m_cartridge && m_ppu && m_cartridge->has_irq_hook()) {
+        mapper_irq = m_cartridge->irq_line_stale() ? m_cartridge->irq_pending(m_ppu->get_frame_cycle())
+                                                   : m_cartridge->irq_line();
+    }
     bool apu_irq = m_apu ? m_apu->irq_pending() : false;
     return mapper_irq || apu_irq;
 }
 
+// The skipped passes only lose their CPU side: tick() still runs every
+// cycle, so the APU, DMC fetches and mapper counters see the same clock,
+// and with catch-up scheduling the PPU runs them as one batch instead of
+// syncing for each read.
+int Bus::run_status_poll(uint8_t bits, int loop_cycles) {
+    if (!m_ppu || m_cpu_only || m_dma_active || loop_cycles <= 0) return 0;
+
+    sync_ppu();
+    int cycles = m_ppu->get_cycles_until_status_change(bits) / (3 * loop_cycles) * loop_cycles;
+    for (int i = 0; i < cycles; i++) {
+        tick();
+    }
+    return cycles;
+}
+
 uint8_t Bus::cpu_read(uint16_t address) {
     // Tick PPU/APU for this memory access cycle
     tick();
 
-    return cpu_peek(address);
+    // PRG ROM fetches from directly mapped pages skip the mapper
+    if (address >= 0x8000 && m_cartridge) {
+        if (const uint8_t* page = m_cartridge->prg_page(address)) {
+            uint8_t value = page[address & 0x3FF];
+            if (m_breakpoints) m_breakpoints->check(address, emu::BREAK_READ, value);
+            return value;
+        }
+    }
+
+    // PPU registers and mapper registers ($4020-$5FFF, e.g. MMC5 scanline
+    // status) observe the PPU, so catch it up first
+    if ((address >= 0x2000 && address < 0x4000) || (address >= 0x4020 && address < 0x6000)) {
+        sync_ppu();
+    }
+    if (address >= 0x4020) {
+        sync_mapper();
+    }
+
+    uint8_t value = cpu_peek(address);
+    if (m_breakpoints) m_breakpoints->check(address, emu::BREAK_READ, value);
+    return value;
+}
+
+bool Bus::peek_prg(uint16_t address, uint8_t& value) const {
+    if (address < 0x8000 || !m_cartridge) return false;
+    const uint8_t* page = m_cartridge->prg_page(address);
+    if (!page) return false;
+    value = page[address & 0x3FF];
+    return true;
+}
+
+uint8_t Bus::debug_peek(uint16_t address) const {
+    if (address < 0x2000) return m_ram[address & 0x07FF];
+    if (address < 0x6000 || !m_cartridge) return static_cast<uint8_t>(address >> 8);
+
+    uint8_t value;
+    if (peek_prg(address, value)) return value;
+    return const_cast<Cartridge*>(m_cartridge)->cpu_read(address);
 }
 
 uint8_t Bus::cpu_peek(uint16_t address) const {
@@ -158,13 +257,18 @@ void Bus::cpu_write(uint16_t address, uint8_t value) {
     // Tick PPU/APU for this memory access cycle
     tick();
 
+    if (m_write_watch) m_write_watch->check(address, value);
+    if (m_breakpoints) m_breakpoints->check(address, emu::BREAK_WRITE, value);
+
     if (address < 0x2000) {
         // Internal RAM (mirrored)
         m_ram[address & 0x07FF] = value;
+        m_ram_pages.mark_dirty(address & 0x07FF);
     }
     else if (address < 0x4000) {
         // PPU registers (mirrored every 8 bytes)
         if (m_ppu) {
+            sync_ppu();
             m_ppu->cpu_write(address & 0x0007, value);
         }
     }
@@ -178,8 +282,16 @@ void Bus::cpu_write(uint16_t address, uint8_t value) {
             // Controller strobe
             m_controller_strobe = (value & 1) != 0;
             if (m_controller_strobe) {
+                if (m_input_poll && m_ppu) {
+                    // Frames end at VBlank (scanline 241), so count from there
+                    int dots = m_ppu->get_scanlines_per_frame() * 341;
+                    int since_vblank = (static_cast<int>(m_ppu->get_frame_cycle()) - 241 * 341 + dots) % dots;
+                    set_controller_state(0, m_input_poll.poll(m_input_poll.context,
+                                                              static_cast<float>(since_vblank) / dots));
+                }
                 m_controller_shift[0] = static_cast<uint8_t>(m_controller_state[0]);
                 m_controller_shift[1] = static_cast<uint8_t>(m_controller_state[1]);
+                m_controller_read = true;   // Latched now, even if read next frame
             }
         }
         else if (m_apu) {
@@ -192,8 +304,17 @@ void Bus::cpu_write(uint16_t address, uint8_t value) {
     }
     else {
         // Cartridge space
+        // Mapper writes can switch CHR banks or mirroring under the PPU,
+        // and start or stop a cycle-counted IRQ, so the mapper syncs on
+        // both sides of the write
         if (m_cartridge) {
+            sync_ppu();
+            sync_mapper();
             m_cartridge->cpu_write(address, value);
+            sync_mapper();
+            if (m_cartridge->has_ppu_events_hook()) {
+                sync_ppu();     // Recomputes the budget for a newly armed scanline IRQ
+            }
         }
     }
 }
@@ -250,6 +371,7 @@ void Bus::set_controller_state(int controller, uint32_t buttons) {
 
 uint8_t Bus::read_controller(int controller) {
     if (controller < 0 || controller >= 2) return 0;
+    m_controller_read = true;
 
     uint8_t data = m_controller_shift[controller] & 1;
     m_controller_shift[controller] >>= 1;
@@ -301,6 +423,7 @@ void Bus::run_dma_cycle() {
     } else {
         // Write cycle
         if (m_ppu) {
+            sync_ppu();
             m_ppu->oam_write(byte_index, m_dma_data);
         }
     }
@@ -320,7 +443,7 @@ void Bus::mapper_scanline() {
 }
 
 bool Bus::mapper_irq_pending(uint32_t frame_cycle) {
-    if (m_cartridge) {
+    if (m_cartridge && m_cartridge->has_irq_hook()) {
         return m_cartridge->irq_pending(frame_cycle);
     }
     return false;
@@ -344,27 +467,37 @@ void Bus::mapper_cpu_cycle() {
     }
 }
 
-float Bus::get_mapper_audio() const {
-    if (m_cartridge) {
-        return m_cartridge->get_audio_output();
+void Bus::sync_mapper() {
+    if (!m_cartridge || !m_cartridge->has_cpu_cycle_hook()) return;
+
+    bool audio = m_apu && m_cartridge->has_audio_hook();
+    if (m_mapper_pending_cycles > 0) {
+        uint32_t cycles = m_mapper_pending_cycles;
+        m_mapper_pending_cycles = 0;
+        m_cartridge->cpu_cycles(static_cast<int>(cycles));
+        if (audio) {
+            m_apu->add_expansion_audio(*m_cartridge->get_expansion_audio(), cycles);
+        }
     }
-    return 0.0f;
-}
 
-void Bus::notify_ppu_addr_change(uint16_t old_addr, uint16_t new_addr, uint32_t frame_cycle) {
-    if (m_cartridge) {
-        m_cartridge->notify_ppu_addr_change(old_addr, new_addr, frame_cycle);
+    m_mapper_cycle_budget = m_cartridge->cpu_cycles_until_irq();
+    if (audio) {
+        // The APU draws samples inside the tick that fills its blip frame,
+        // before tick() counts that cycle for the mapper, so the batch has
+        // to end a tick earlier
+        uint32_t until_flush = m_apu->get_cycles_until_flush();
+        m_mapper_cycle_budget = std::min(m_mapper_cycle_budget, until_flush > 1 ? until_flush - 1 : 1);
     }
 }
 
-void Bus::notify_ppu_address_bus(uint16_t address, uint32_t frame_cycle) {
+void Bus::notify_ppu_addr_change(uint16_t old_addr, uint16_t new_addr, uint32_t frame_cycle) {
     if (m_cartridge) {
-        m_cartridge->notify_ppu_address_bus(address, frame_cycle);
+        m_cartridge->notify_ppu_addr_change(old_addr, new_addr, frame_cycle);
     }
 }
 
 void Bus::notify_frame_start() {
-    if (m_cartridge) {
+    if (m_cartridge && m_cartridge->has_frame_start_hook()) {
         m_cartridge->notify_frame_start();
     }
 }
@@ -388,21 +521,17 @@ void Bus::check_test_output() {
     uint8_t sig3 = cpu_peek(0x6003);
 
     // Debug: show what's at $6000 (every time, until signature found)
-    static int check_count = 0;
-    if (check_count < 10 && !(sig1 == 0xDE && sig2 == 0xB0 && sig3 == 0x61)) {
+    if (m_test_check_count < 10 && !(sig1 == 0xDE && sig2 == 0xB0 && sig3 == 0x61)) {
         fprintf(stderr, "Test check #%d: $6000=%02X sig=%02X %02X %02X\n",
-                check_count++, cpu_peek(0x6000), sig1, sig2, sig3);
+                m_test_check_count++, cpu_peek(0x6000), sig1, sig2, sig3);
     }
 
     if (sig1 == 0xDE && sig2 == 0xB0 && sig3 == 0x61) {
         uint8_t status = cpu_peek(0x6000);
 
         // Status: 0x80 = running, 0x81 = needs reset, 0x00-0x7F = finished with result
-        static bool result_printed = false;
-        static uint8_t last_status = 0x80;
-        if (status < 0x80 && !result_printed) {
-            result_printed = true;
-            last_status = status;
+        if (status < 0x80 && !m_test_result_printed) {
+            m_test_result_printed = true;
             fprintf(stderr, "\n=== TEST ROM RESULT ===\n");
             fprintf(stderr, "Status code: %d (%s)\n", status,
                     status == 0 ? "PASSED" : "FAILED");
@@ -426,9 +555,8 @@ void Bus::check_test_output() {
 // Save state serialization
 namespace {
     template<typename T>
-    void write_value(std::vector<uint8_t>& data, T value) {
-        const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&value);
-        data.insert(data.end(), ptr, ptr + sizeof(T));
+    void write_value(StateWriter& data, T value) {
+        data.write(&value, sizeof(T));
     }
 
     template<typename T>
@@ -440,8 +568,8 @@ namespace {
         return true;
     }
 
-    void write_array(std::vector<uint8_t>& data, const uint8_t* arr, size_t size) {
-        data.insert(data.end(), arr, arr + size);
+    void write_array(StateWriter& data, const uint8_t* arr, size_t size) {
+        data.write(arr, size);
     }
 
     bool read_array(const uint8_t*& data, size_t& remaining, uint8_t* arr, size_t size) {
@@ -453,10 +581,16 @@ namespace {
     }
 }
 
-void Bus::save_state(std::vector<uint8_t>& data) {
-    // Save RAM
+void Bus::save_state(StateWriter& data) {
+    save_work_ram(data);
+    save_registers(data);
+}
+
+void Bus::save_work_ram(StateWriter& data) {
     write_array(data, m_ram.data(), m_ram.size());
+}
 
+void Bus::save_registers(StateWriter& data) {
     // Save controller state
     write_value(data, m_controller_state[0]);
     write_value(data, m_controller_state[1]);
@@ -476,9 +610,16 @@ void Bus::save_state(std::vector<uint8_t>& data) {
 }
 
 void Bus::load_state(const uint8_t*& data, size_t& remaining) {
-    // Load RAM
+    load_work_ram(data, remaining);
+    load_registers(data, remaining);
+}
+
+void Bus::load_work_ram(const uint8_t*& data, size_t& remaining) {
     read_array(data, remaining, m_ram.data(), m_ram.size());
+    m_ram_pages.mark_all_dirty();
+}
 
+void Bus::load_registers(const uint8_t*& data, size_t& remaining) {
     // Load controller state
     read_value(data, remaining, m_controller_state[0]);
     read_value(data, remaining, m_controller_state[1]);
@@ -507,6 +648,16 @@ void Bus::load_state(const uint8_t*& data, size_t& remaining) {
     if (remaining >= sizeof(uint64_t)) {
         read_value(data, remaining, m_cpu_cycles);
     }
+
+    // Save states are taken with the PPU caught up; drop any owed dots
+    m_ppu_pending_cycles = 0;
+    reset_ppu_sync();
+}
+
+uint64_t Bus::get_state_hash() {
+    uint64_t hash = m_ram_pages.hash(m_ram.data(), m_ram.size());
+    return state_hash::combine(hash, state_hash::hash_serialized(m_hash_scratch,
+        [this](StateWriter& out) { save_registers(out); }));
 }
 
 } // namespace nes
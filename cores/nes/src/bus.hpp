@@ -4,12 +4,20 @@
 #include <array>
 #include <vector>
 
+#include "cartridge.hpp"
+#include "state_hash.hpp"
+#include "emu/input_poll.hpp"
+#include "emu/profile.hpp"
+#include "emu/breakpoints.hpp"
+#include "emu/state_writer.hpp"
+#include "emu/write_watch.hpp"
+
 namespace nes {
 
 class CPU;
 class PPU;
 class APU;
-class Cartridge;
+using emu::StateWriter;
 
 // NES Memory Bus - connects all components
 // Implements cycle-accurate CPU/PPU/APU synchronization
@@ -24,6 +32,16 @@ public:
     void connect_apu(APU* apu) { m_apu = apu; }
     void connect_cartridge(Cartridge* cart) { m_cartridge = cart; }
 
+    // Marker tick() points at the PPU and APU while it runs them
+    void set_profile_marker(emu::ProfileMarker* marker) { m_profile = marker; }
+
+    // Watchpoints checked on every CPU write, or nullptr for none
+    void set_write_watch(emu::WriteWatchpoints* watch) { m_write_watch = watch; }
+
+    // Read and write breakpoints checked on every CPU access, or nullptr
+    // for none
+    void set_breakpoints(emu::Breakpoints* breakpoints) { m_breakpoints = breakpoints; }
+
     // CPU memory access - these tick PPU/APU for cycle accuracy
     // Each memory access takes 1 CPU cycle = 3 PPU cycles
     uint8_t cpu_read(uint16_t address);
@@ -32,6 +50,16 @@ public:
     // Non-ticking memory access (for save states, debugging, etc.)
     uint8_t cpu_peek(uint16_t address) const;
 
+    // A PRG ROM byte from a directly mapped page, which reads without side
+    // effects; false for any other address
+    bool peek_prg(uint16_t address, uint8_t& value) const;
+
+    // What a memory viewer may read: RAM, PRG RAM and PRG ROM. PPU, APU,
+    // controller and mapper registers ($2000-$5FFF) change when read, so
+    // they read as open bus (the address's high byte, as after an absolute
+    // read) instead.
+    uint8_t debug_peek(uint16_t address) const;
+
     // PPU memory access (for CHR ROM/RAM)
     uint8_t ppu_read(uint16_t address, uint32_t frame_cycle = 0);
     void ppu_write(uint16_t address, uint8_t value);
@@ -40,6 +68,15 @@ public:
     void set_controller_state(int controller, uint32_t buttons);
     uint8_t read_controller(int controller);
 
+    // Set by read_controller() and by strobing the pads; the frame loop
+    // clears it at the start of each frame, so it ends the frame false on a
+    // lag frame
+    bool was_controller_read() const { return m_controller_read; }
+    void clear_controller_read() { m_controller_read = false; }
+
+    // Controller 1 is read through poll at each strobe, if set
+    void set_input_poll(const emu::InputPoll& poll) { m_input_poll = poll; }
+
     // DMA - OAM DMA is handled cycle-by-cycle now
     void start_oam_dma(uint8_t page);
     bool is_dma_active() const { return m_dma_active; }
@@ -53,7 +90,21 @@ public:
     void notify_ppu_addr_change(uint16_t old_addr, uint16_t new_addr, uint32_t frame_cycle);
 
     // Notify mapper of PPU address bus activity during rendering (for A12 tracking)
-    void notify_ppu_address_bus(uint16_t address, uint32_t frame_cycle);
+    // Called for every PPU fetch, so mappers that don't watch the bus are
+    // skipped right here
+    void notify_ppu_address_bus(uint16_t address, uint32_t frame_cycle) {
+        if (m_cartridge && m_cartridge->has_ppu_address_bus_hook()) {
+            m_cartridge->notify_ppu_address_bus(address, frame_cycle);
+        }
+    }
+
+    // Rendering events for mappers that take them (Mapper::HOOK_PPU_EVENTS)
+    bool has_ppu_events() const { return m_cartridge && m_cartridge->has_ppu_events_hook(); }
+    void ppu_scanline_start(int scanline) { m_cartridge->ppu_scanline_start(scanline); }
+    void ppu_frame_end() { m_cartridge->ppu_frame_end(); }
+    bool ppu_tile_fetch(int scanline, int column, uint8_t& tile, uint8_t& palette) {
+        return m_cartridge->ppu_tile_fetch(scanline, column, tile, palette);
+    }
 
     // Notify mapper of frame start (for resetting timing state)
     void notify_frame_start();
@@ -66,8 +117,14 @@ public:
     void mapper_cpu_cycles(int count);
     void mapper_cpu_cycle();
 
-    // Get expansion audio output from mapper (-1.0 to 1.0)
-    float get_mapper_audio() const;
+    // Catch the mapper up on the CPU cycles tick() has batched for it.
+    // tick() runs a mapper that counts CPU cycles only every so many
+    // cycles, never later than its cycle-counted IRQ can assert (see
+    // Mapper::cpu_cycles_until_irq()) or, for audio chips, than the APU
+    // next draws samples; the batch's expansion audio goes to the APU.
+    // Cartridge accesses sync first, and so should the frame loop at
+    // either end.
+    void sync_mapper();
 
     // Get current mirror mode (0=H, 1=V, 2=SingleScreen0, 3=SingleScreen1, 4=FourScreen)
     int get_mirror_mode() const;
@@ -80,16 +137,39 @@ public:
     // Tick only PPU (for internal use)
     void tick_ppu_only(int ppu_cycles);
 
+    // While set, tick() runs nothing but the CPU: the PPU, APU and mapper
+    // counters hold still, for overclocked lines inserted at VBlank
+    void set_cpu_only(bool enabled) { m_cpu_only = enabled; }
+
     // Enable/disable cycle-accurate mode
-    // When disabled, PPU/APU are not ticked during memory accesses (legacy mode)
-    void set_cycle_accurate(bool enabled) { m_cycle_accurate = enabled; }
+    // When enabled (default), the PPU is stepped 3 dots on every CPU cycle.
+    // When disabled, the PPU is scheduled lazily: tick() only records the
+    // dots it owes, and sync_ppu() catches it up when a PPU register or the
+    // cartridge is accessed, OAM DMA writes, or the PPU reaches VBlank/NMI.
+    // Mappers that need exact A12 timing keep the per-cycle path regardless.
+    // The APU is ticked every cycle in both modes, and mappers that count CPU
+    // cycles are batched in both (see sync_mapper()).
+    void set_cycle_accurate(bool enabled);
     bool is_cycle_accurate() const { return m_cycle_accurate; }
 
+    // Catch-up scheduling: run the PPU forward to the current CPU cycle
+    void sync_ppu();
+
+    // Tick through whole passes of a CPU loop polling the PPUSTATUS bits in
+    // 'bits', loop_cycles CPU cycles each, for as long as every read the
+    // passes make would give the value it gives now. Returns the cycles run.
+    int run_status_poll(uint8_t bits, int loop_cycles);
+
+    // Force a resync on the next tick (after the PPU was reset or reloaded)
+    void reset_ppu_sync() { m_ppu_sync_budget = 0; }
+
     // Check and handle NMI/IRQ after ticking
     void check_interrupts();
 
     // Poll IRQ status (for cycle-accurate interrupt detection)
-    // Returns true if any IRQ source is active
+    // Returns true if any IRQ source is active. The APU's flags are read
+    // directly; the mapper's line is cached by the cartridge and only
+    // asked for again once something has called into the mapper.
     bool poll_irq_status();
 
     // Get the current CPU cycle count (for APU jitter timing)
@@ -99,9 +179,22 @@ public:
     uint64_t get_cpu_cycles() const { return m_cpu_cycles; }
 
     // Save state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
 
+    // The two halves of save_state(), which are separate state chunks:
+    // the 2KB of work RAM, and everything else
+    void save_work_ram(StateWriter& data);
+    void load_work_ram(const uint8_t*& data, size_t& remaining);
+    void save_registers(StateWriter& data);
+    void load_registers(const uint8_t*& data, size_t& remaining);
+
+    // Internal RAM, for memory domains
+    const uint8_t* get_ram_data() const { return m_ram.data(); }
+
+    // Incremental hash of everything save_state() writes (RAM by dirty page)
+    uint64_t get_state_hash();
+
     // Test ROM support - check and print test output from $6000+
     void check_test_output();
 
@@ -114,11 +207,15 @@ private:
 
     // Internal RAM (2KB, mirrored 4 times in $0000-$1FFF)
     std::array<uint8_t, 2048> m_ram;
+    PageHashCache m_ram_pages;
+    std::vector<uint8_t> m_hash_scratch;
 
     // Controller state
     uint32_t m_controller_state[2] = {0, 0};
     uint8_t m_controller_shift[2] = {0, 0};
     bool m_controller_strobe = false;
+    bool m_controller_read = false;
+    emu::InputPoll m_input_poll;
 
     // OAM DMA state - cycle-accurate handling
     bool m_dma_active = false;
@@ -132,9 +229,26 @@ private:
 
     // Cycle-accurate mode flag
     bool m_cycle_accurate = true;
+    bool m_cpu_only = false;
+
+    // Catch-up PPU scheduling (cycle-accurate mode off)
+    int m_ppu_pending_cycles = 0;  // PPU dots owed since the last sync
+    int m_ppu_sync_budget = 0;     // Dots that may be owed before the next sync
+
+    // Mapper cycle batching (see sync_mapper())
+    uint32_t m_mapper_pending_cycles = 0;  // CPU cycles owed since the last sync
+    uint32_t m_mapper_cycle_budget = 0;    // Cycles that may be owed before the next
 
     // CPU cycle counter
     uint64_t m_cpu_cycles = 0;
+
+    emu::ProfileMarker* m_profile = nullptr;
+    emu::WriteWatchpoints* m_write_watch = nullptr;
+    emu::Breakpoints* m_breakpoints = nullptr;
+
+    // Test ROM result reporting (DEBUG=1)
+    int m_test_check_count = 0;
+    bool m_test_result_printed = false;
 };
 
 } // namespace nes
@@ -1,56 +1,12 @@
 #include "cartridge.hpp"
+#include "emu/rom_crc32.hpp"
 #include "mappers/mapper.hpp"
 #include <iostream>
 #include <cstring>
 
 namespace nes {
 
-// CRC32 lookup table
-static const uint32_t s_crc32_table[256] = {
-    0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F,
-    0xE963A535, 0x9E6495A3, 0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988,
-    0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91, 0x1DB71064, 0x6AB020F2,
-    0xF3B97148, 0x84BE41DE, 0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7,
-    0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC, 0x14015C4F, 0x63066CD9,
-    0xFA0F3D63, 0x8D080DF5, 0x3B6E20C8, 0x4C69105E, 0xD56041E4, 0xA2677172,
-    0x3C03E4D1, 0x4B04D447, 0xD20D85FD, 0xA50AB56B, 0x35B5A8FA, 0x42B2986C,
-    0xDBBBC9D6, 0xACBCF940, 0x32D86CE3, 0x45DF5C75, 0xDCD60DCF, 0xABD13D59,
-    0x26D930AC, 0x51DE003A, 0xC8D75180, 0xBFD06116, 0x21B4F4B5, 0x56B3C423,
-    0xCFBA9599, 0xB8BDA50F, 0x2802B89E, 0x5F058808, 0xC60CD9B2, 0xB10BE924,
-    0x2F6F7C87, 0x58684C11, 0xC1611DAB, 0xB6662D3D, 0x76DC4190, 0x01DB7106,
-    0x98D220BC, 0xEFD5102A, 0x71B18589, 0x06B6B51F, 0x9FBFE4A5, 0xE8B8D433,
-    0x7807C9A2, 0x0F00F934, 0x9609A88E, 0xE10E9818, 0x7F6A0DBB, 0x086D3D2D,
-    0x91646C97, 0xE6635C01, 0x6B6B51F4, 0x1C6C6162, 0x856530D8, 0xF262004E,
-    0x6C0695ED, 0x1B01A57B, 0x8208F4C1, 0xF50FC457, 0x65B0D9C6, 0x12B7E950,
-    0x8BBEB8EA, 0xFCB9887C, 0x62DD1DDF, 0x15DA2D49, 0x8CD37CF3, 0xFBD44C65,
-    0x4DB26158, 0x3AB551CE, 0xA3BC0074, 0xD4BB30E2, 0x4ADFA541, 0x3DD895D7,
-    0xA4D1C46D, 0xD3D6F4FB, 0x4369E96A, 0x346ED9FC, 0xAD678846, 0xDA60B8D0,
-    0x44042D73, 0x33031DE5, 0xAA0A4C5F, 0xDD0D7CC9, 0x5005713C, 0x270241AA,
-    0xBE0B1010, 0xC90C2086, 0x5768B525, 0x206F85B3, 0xB966D409, 0xCE61E49F,
-    0x5EDEF90E, 0x29D9C998, 0xB0D09822, 0xC7D7A8B4, 0x59B33D17, 0x2EB40D81,
-    0xB7BD5C3B, 0xC0BA6CAD, 0xEDB88320, 0x9ABFB3B6, 0x03B6E20C, 0x74B1D29A,
-    0xEAD54739, 0x9DD277AF, 0x04DB2615, 0x73DC1683, 0xE3630B12, 0x94643B84,
-    0x0D6D6A3E, 0x7A6A5AA8, 0xE40ECF0B, 0x9309FF9D, 0x0A00AE27, 0x7D079EB1,
-    0xF00F9344, 0x8708A3D2, 0x1E01F268, 0x6906C2FE, 0xF762575D, 0x806567CB,
-    0x196C3671, 0x6E6B06E7, 0xFED41B76, 0x89D32BE0, 0x10DA7A5A, 0x67DD4ACC,
-    0xF9B9DF6F, 0x8EBEEFF9, 0x17B7BE43, 0x60B08ED5, 0xD6D6A3E8, 0xA1D1937E,
-    0x38D8C2C4, 0x4FDFF252, 0xD1BB67F1, 0xA6BC5767, 0x3FB506DD, 0x48B2364B,
-    0xD80D2BDA, 0xAF0A1B4C, 0x36034AF6, 0x41047A60, 0xDF60EFC3, 0xA867DF55,
-    0x316E8EEF, 0x4669BE79, 0xCB61B38C, 0xBC66831A, 0x256FD2A0, 0x5268E236,
-    0xCC0C7795, 0xBB0B4703, 0x220216B9, 0x5505262F, 0xC5BA3BBE, 0xB2BD0B28,
-    0x2BB45A92, 0x5CB36A04, 0xC2D7FFA7, 0xB5D0CF31, 0x2CD99E8B, 0x5BDEAE1D,
-    0x9B64C2B0, 0xEC63F226, 0x756AA39C, 0x026D930A, 0x9C0906A9, 0xEB0E363F,
-    0x72076785, 0x05005713, 0x95BF4A82, 0xE2B87A14, 0x7BB12BAE, 0x0CB61B38,
-    0x92D28E9B, 0xE5D5BE0D, 0x7CDCEFB7, 0x0BDBDF21, 0x86D3D2D4, 0xF1D4E242,
-    0x68DDB3F8, 0x1FDA836E, 0x81BE16CD, 0xF6B9265B, 0x6FB077E1, 0x18B74777,
-    0x88085AE6, 0xFF0F6A70, 0x66063BCA, 0x11010B5C, 0x8F659EFF, 0xF862AE69,
-    0x616BFFD3, 0x166CCF45, 0xA00AE278, 0xD70DD2EE, 0x4E048354, 0x3903B3C2,
-    0xA7672661, 0xD06016F7, 0x4969474D, 0x3E6E77DB, 0xAED16A4A, 0xD9D65ADC,
-    0x40DF0B66, 0x37D83BF0, 0xA9BCAE53, 0xDEBB9EC5, 0x47B2CF7F, 0x30B5FFE9,
-    0xBDBDF21C, 0xCABAC28A, 0x53B39330, 0x24B4A3A6, 0xBAD03605, 0xCDD706B3,
-    0x54DE5729, 0x23D967BF, 0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94,
-    0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
-};
+const uint8_t* const Cartridge::s_no_prg_pages[32] = {};
 
 Cartridge::Cartridge() = default;
 
@@ -114,7 +70,7 @@ bool Cartridge::load(const uint8_t* data, size_t size) {
     m_prg_ram.resize(8192, 0);
 
     // Calculate CRC32 of PRG+CHR ROM (excluding header)
-    m_crc32 = calculate_crc32(data + sizeof(iNESHeader) + (m_has_trainer ? 512 : 0),
+    m_crc32 = emu::rom_crc32(data + sizeof(iNESHeader) + (m_has_trainer ? 512 : 0),
                               prg_size + chr_size);
 
     // Determine mirror mode from header
@@ -128,12 +84,26 @@ bool Cartridge::load(const uint8_t* data, size_t size) {
     }
 
     // Create mapper
+    m_prg_pages = s_no_prg_pages;
     m_mapper.reset(create_mapper(m_mapper_number, m_prg_rom, m_chr_rom, m_prg_ram,
                                  mirror, m_has_chr_ram));
     if (!m_mapper) {
         std::cerr << "Failed to create mapper " << m_mapper_number << std::endl;
         return false;
     }
+    m_mapper->set_page_tracking(&m_prg_ram_pages, &m_chr_ram_pages);
+    m_exact_ppu_timing = m_mapper->needs_exact_ppu_timing();
+    uint32_t hooks = m_mapper->get_hooks();
+    m_cpu_cycle_hook = (hooks & Mapper::HOOK_CPU_CYCLES) != 0;
+    m_irq_hook = (hooks & Mapper::HOOK_IRQ) != 0;
+    m_ppu_address_bus_hook = (hooks & Mapper::HOOK_PPU_ADDRESS_BUS) != 0;
+    m_frame_start_hook = (hooks & Mapper::HOOK_FRAME_START) != 0;
+    m_audio_hook = (hooks & Mapper::HOOK_AUDIO) != 0;
+    m_ppu_events_hook = (hooks & Mapper::HOOK_PPU_EVENTS) != 0;
+    m_prg_pages = m_mapper->prg_pages();
+    m_irq_stale = true;
+    m_prg_ram_pages.mark_all_dirty();
+    m_chr_ram_pages.mark_all_dirty();
 
     m_loaded = true;
 
@@ -148,11 +118,21 @@ bool Cartridge::load(const uint8_t* data, size_t size) {
 }
 
 void Cartridge::unload() {
+    m_prg_pages = s_no_prg_pages;
     m_mapper.reset();
     m_prg_rom.clear();
     m_chr_rom.clear();
     m_prg_ram.clear();
     m_loaded = false;
+    m_exact_ppu_timing = false;
+    m_cpu_cycle_hook = false;
+    m_irq_hook = false;
+    m_ppu_address_bus_hook = false;
+    m_frame_start_hook = false;
+    m_audio_hook = false;
+    m_ppu_events_hook = false;
+    m_irq_line = false;
+    m_irq_stale = true;
     m_mapper_number = 0;
     m_crc32 = 0;
     m_title.clear();
@@ -175,22 +155,18 @@ bool Cartridge::parse_header(const iNESHeader& header) {
     return true;
 }
 
-uint32_t Cartridge::calculate_crc32(const uint8_t* data, size_t size) {
-    uint32_t crc = 0xFFFFFFFF;
-    for (size_t i = 0; i < size; i++) {
-        crc = s_crc32_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
-    }
-    return crc ^ 0xFFFFFFFF;
-}
-
 void Cartridge::reset() {
     if (m_mapper) {
+        m_irq_stale = true;
         m_mapper->reset();
     }
+    m_prg_ram_pages.mark_all_dirty();
+    m_chr_ram_pages.mark_all_dirty();
 }
 
 uint8_t Cartridge::cpu_read(uint16_t address) {
     if (m_mapper) {
+        m_irq_stale = true;
         return m_mapper->cpu_read(address);
     }
     return 0;
@@ -198,12 +174,20 @@ uint8_t Cartridge::cpu_read(uint16_t address) {
 
 void Cartridge::cpu_write(uint16_t address, uint8_t value) {
     if (m_mapper) {
+        m_irq_stale = true;
         m_mapper->cpu_write(address, value);
     }
 }
 
 uint8_t Cartridge::ppu_read(uint16_t address, uint32_t frame_cycle) {
     if (m_mapper) {
+        // Pattern fetches from directly mapped CHR skip the virtual call
+        if (address < 0x2000) {
+            if (const uint8_t* page = m_mapper->chr_page(address)) {
+                return page[address & 0x3FF];
+            }
+        }
+        m_irq_stale = true;
         return m_mapper->ppu_read(address, frame_cycle);
     }
     return 0;
@@ -211,6 +195,7 @@ uint8_t Cartridge::ppu_read(uint16_t address, uint32_t frame_cycle) {
 
 void Cartridge::ppu_write(uint16_t address, uint8_t value) {
     if (m_mapper) {
+        m_irq_stale = true;
         m_mapper->ppu_write(address, value);
     }
 }
@@ -223,59 +208,98 @@ MirrorMode Cartridge::get_mirror_mode() const {
 }
 
 bool Cartridge::irq_pending(uint32_t frame_cycle) {
-    if (m_mapper) {
-        return m_mapper->irq_pending(frame_cycle);
-    }
-    return false;
+    m_irq_line = m_mapper && m_mapper->irq_pending(frame_cycle);
+    m_irq_stale = m_mapper && m_mapper->irq_polled();
+    return m_irq_line;
 }
 
 void Cartridge::irq_clear() {
     if (m_mapper) {
+        m_irq_stale = true;
         m_mapper->irq_clear();
     }
 }
 
 void Cartridge::scanline() {
     if (m_mapper) {
+        m_irq_stale = true;
         m_mapper->scanline();
     }
 }
 
 void Cartridge::notify_ppu_addr_change(uint16_t old_addr, uint16_t new_addr, uint32_t frame_cycle) {
     if (m_mapper) {
+        m_irq_stale = true;
         m_mapper->notify_ppu_addr_change(old_addr, new_addr, frame_cycle);
     }
 }
 
 void Cartridge::notify_ppu_address_bus(uint16_t address, uint32_t frame_cycle) {
     if (m_mapper) {
+        m_irq_stale = true;
         m_mapper->notify_ppu_address_bus(address, frame_cycle);
     }
 }
 
 void Cartridge::notify_frame_start() {
     if (m_mapper) {
+        m_irq_stale = true;
         m_mapper->notify_frame_start();
     }
 }
 
+void Cartridge::ppu_scanline_start(int scanline) {
+    if (m_mapper) {
+        m_irq_stale = true;
+        m_mapper->ppu_scanline_start(scanline);
+    }
+}
+
+void Cartridge::ppu_frame_end() {
+    if (m_mapper) {
+        m_irq_stale = true;
+        m_mapper->ppu_frame_end();
+    }
+}
+
+bool Cartridge::ppu_tile_fetch(int scanline, int column, uint8_t& tile, uint8_t& palette) {
+    if (m_mapper) {
+        m_irq_stale = true;
+        return m_mapper->ppu_tile_fetch(scanline, column, tile, palette);
+    }
+    return false;
+}
+
+bool Cartridge::ppu_scanline_irq_armed() const {
+    return m_mapper && m_mapper->ppu_scanline_irq_armed();
+}
+
 void Cartridge::cpu_cycles(int count) {
     if (m_mapper) {
+        m_irq_stale = true;
         m_mapper->cpu_cycles(count);
     }
 }
 
 void Cartridge::cpu_cycle() {
     if (m_mapper) {
+        m_irq_stale = true;
         m_mapper->cpu_cycle();
     }
 }
 
-float Cartridge::get_audio_output() const {
+uint32_t Cartridge::cpu_cycles_until_irq() const {
+    if (m_mapper) {
+        return m_mapper->cpu_cycles_until_irq();
+    }
+    return UINT32_MAX;
+}
+
+ExpansionAudio* Cartridge::get_expansion_audio() {
     if (m_mapper) {
-        return m_mapper->get_audio_output();
+        return &m_mapper->get_expansion_audio();
     }
-    return 0.0f;
+    return nullptr;
 }
 
 // Battery-backed save data support
@@ -374,6 +398,7 @@ bool Cartridge::set_save_data(const std::vector<uint8_t>& data) {
         if (prg_ram_size > 0 && offset + prg_ram_size <= data.size()) {
             size_t copy_size = std::min(static_cast<size_t>(prg_ram_size), m_prg_ram.size());
             std::memcpy(m_prg_ram.data(), data.data() + offset, copy_size);
+            m_prg_ram_pages.mark_all_dirty();
             offset += prg_ram_size;
         }
 
@@ -398,6 +423,7 @@ bool Cartridge::set_save_data(const std::vector<uint8_t>& data) {
     // Raw format - just PRG RAM (compatible with other emulators)
     size_t copy_size = std::min(data.size(), m_prg_ram.size());
     std::memcpy(m_prg_ram.data(), data.data(), copy_size);
+    m_prg_ram_pages.mark_all_dirty();
 
     // If there's mapper-specific save data and the file is larger than PRG RAM,
     // try to load that too (some other emulators append it)
@@ -413,9 +439,8 @@ bool Cartridge::set_save_data(const std::vector<uint8_t>& data) {
 // Serialization helpers
 namespace {
     template<typename T>
-    void write_value(std::vector<uint8_t>& data, T value) {
-        const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&value);
-        data.insert(data.end(), ptr, ptr + sizeof(T));
+    void write_value(StateWriter& data, T value) {
+        data.write(&value, sizeof(T));
     }
 
     template<typename T>
@@ -427,8 +452,8 @@ namespace {
         return true;
     }
 
-    void write_array(std::vector<uint8_t>& data, const uint8_t* arr, size_t size) {
-        data.insert(data.end(), arr, arr + size);
+    void write_array(StateWriter& data, const uint8_t* arr, size_t size) {
+        data.write(arr, size);
     }
 
     bool read_array(const uint8_t*& data, size_t& remaining, uint8_t* arr, size_t size) {
@@ -440,7 +465,11 @@ namespace {
     }
 }
 
-void Cartridge::save_state(std::vector<uint8_t>& data) {
+uint64_t Cartridge::get_save_generation() const {
+    return m_mapper ? m_mapper->get_save_generation() : 0;
+}
+
+void Cartridge::save_state(StateWriter& data) {
     // Save PRG RAM (may include battery-backed SRAM)
     write_value(data, static_cast<uint32_t>(m_prg_ram.size()));
     if (!m_prg_ram.empty()) {
@@ -490,7 +519,26 @@ void Cartridge::load_state(const uint8_t*& data, size_t& remaining) {
     // Load mapper state
     if (m_mapper) {
         m_mapper->load_state(data, remaining);
+        m_mapper->touch_save_data();
+    }
+    m_irq_stale = true;
+
+    m_prg_ram_pages.mark_all_dirty();
+    m_chr_ram_pages.mark_all_dirty();
+}
+
+uint64_t Cartridge::get_state_hash() {
+    uint64_t hash = m_prg_ram_pages.hash(m_prg_ram.data(), m_prg_ram.size());
+    if (m_has_chr_ram) {
+        hash = state_hash::combine(hash, m_chr_ram_pages.hash(m_chr_rom.data(), m_chr_rom.size()));
+    }
+
+    // Mapper registers (and any mapper-internal RAM) are hashed in full
+    if (m_mapper) {
+        hash = state_hash::combine(hash, state_hash::hash_serialized(m_hash_scratch,
+            [this](StateWriter& out) { m_mapper->save_state(out); }));
     }
+    return hash;
 }
 
 } // namespace nes
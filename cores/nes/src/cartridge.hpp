@@ -6,9 +6,14 @@
 #include <memory>
 #include <string>
 
+#include "state_hash.hpp"
+#include "emu/state_writer.hpp"
+
 namespace nes {
 
 class Mapper;
+class ExpansionAudio;
+using emu::StateWriter;
 enum class MirrorMode;
 
 // iNES header format
@@ -51,13 +56,21 @@ public:
     // Get mirror mode from mapper
     MirrorMode get_mirror_mode() const;
 
-    // IRQ support
+    // IRQ support. irq_pending() asks the mapper; between calls the answer
+    // is kept, and only goes stale once something calls into the mapper
+    // (or, for a mapper that's Mapper::irq_polled(), at once).
     bool irq_pending(uint32_t frame_cycle = 0);
+    bool irq_line_stale() const { return m_irq_stale; }
+    bool irq_line() const { return m_irq_line; }
     void irq_clear();
     void scanline();
     void notify_ppu_addr_change(uint16_t old_addr, uint16_t new_addr, uint32_t frame_cycle);
     void notify_ppu_address_bus(uint16_t address, uint32_t frame_cycle);
     void notify_frame_start();
+    void ppu_scanline_start(int scanline);
+    void ppu_frame_end();
+    bool ppu_tile_fetch(int scanline, int column, uint8_t& tile, uint8_t& palette);
+    bool ppu_scanline_irq_armed() const;
 
     // CPU cycle notification (for mappers with IRQ counters or expansion audio)
     // PERFORMANCE: Batched version - receives cycle count to process at once
@@ -66,8 +79,27 @@ public:
     // Legacy single-cycle version (deprecated)
     void cpu_cycle();
 
-    // Get expansion audio output (-1.0 to 1.0)
-    float get_audio_output() const;
+    // The mapper's expansion audio, or nullptr with no mapper
+    ExpansionAudio* get_expansion_audio();
+
+    // True if the mapper needs the PPU stepped every CPU cycle (see Mapper)
+    bool needs_exact_ppu_timing() const { return m_exact_ppu_timing; }
+
+    // Which of the per-cycle hooks above the mapper implements (see
+    // Mapper::Hook); the bus tests these before calling them
+    bool has_cpu_cycle_hook() const { return m_cpu_cycle_hook; }
+    bool has_irq_hook() const { return m_irq_hook; }
+    bool has_ppu_address_bus_hook() const { return m_ppu_address_bus_hook; }
+    bool has_frame_start_hook() const { return m_frame_start_hook; }
+    bool has_audio_hook() const { return m_audio_hook; }
+    bool has_ppu_events_hook() const { return m_ppu_events_hook; }
+
+    // CPU cycles the bus may batch before calling cpu_cycles() (see Mapper)
+    uint32_t cpu_cycles_until_irq() const;
+
+    // Directly mapped PRG ROM for a $8000-$FFFF read, or nullptr for the
+    // slow path through cpu_read() (see Mapper::prg_pages)
+    const uint8_t* prg_page(uint16_t address) const { return m_prg_pages[(address >> 10) & 0x1F]; }
 
     // ROM info
     uint32_t get_crc32() const { return m_crc32; }
@@ -89,20 +121,41 @@ public:
     // Set battery-backed save data (restores PRG RAM + mapper-specific data)
     bool set_save_data(const std::vector<uint8_t>& data);
 
+    // Changes whenever save data may have (see Mapper::get_save_generation)
+    uint64_t get_save_generation() const;
+
     // Save state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
 
+    // Incremental hash of everything save_state() writes (PRG/CHR RAM by dirty page)
+    uint64_t get_state_hash();
+
 private:
     bool parse_header(const iNESHeader& header);
-    uint32_t calculate_crc32(const uint8_t* data, size_t size);
 
     std::unique_ptr<Mapper> m_mapper;
     std::vector<uint8_t> m_prg_rom;
     std::vector<uint8_t> m_chr_rom;
     std::vector<uint8_t> m_prg_ram;
 
+    // Dirty-page hash caches, fed by the mapper's RAM write helpers
+    PageHashCache m_prg_ram_pages;
+    PageHashCache m_chr_ram_pages;
+    std::vector<uint8_t> m_hash_scratch;
+
     bool m_loaded = false;
+    bool m_exact_ppu_timing = false;
+    bool m_cpu_cycle_hook = false;
+    bool m_irq_hook = false;
+    bool m_ppu_address_bus_hook = false;
+    bool m_frame_start_hook = false;
+    bool m_audio_hook = false;
+    bool m_ppu_events_hook = false;
+    bool m_irq_line = false;       // Mapper's IRQ as of the last irq_pending()
+    bool m_irq_stale = true;       // Mapper called since then
+    static const uint8_t* const s_no_prg_pages[32];
+    const uint8_t* const* m_prg_pages = s_no_prg_pages;  // Mapper's table while loaded
     int m_mapper_number = 0;
     uint32_t m_crc32 = 0;
     std::string m_title;
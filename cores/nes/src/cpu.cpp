@@ -1,5 +1,6 @@
 #include "cpu.hpp"
 #include "bus.hpp"
+#include "emu/state_writer.hpp"
 
 #include <cstring>
 
@@ -72,483 +73,11 @@ int CPU::step() {
 
     // Fetch opcode (cycle 1 of every instruction)
     uint8_t opcode = read(m_pc++);
-    int cycles = 0;
-    bool page_crossed = false;
+    if (m_trace) trace_instruction(opcode);
+    if (m_breakpoints) m_breakpoints->check(static_cast<uint16_t>(m_pc - 1), emu::BREAK_EXECUTE, opcode);
 
     // Decode and execute
-    switch (opcode) {
-        // ADC - Add with Carry
-        case 0x69: op_adc(read(addr_immediate())); cycles = 2; break;
-        case 0x65: op_adc(read(addr_zero_page())); cycles = 3; break;
-        case 0x75: op_adc(read(addr_zero_page_x())); cycles = 4; break;
-        case 0x6D: op_adc(read(addr_absolute())); cycles = 4; break;
-        case 0x7D: op_adc(read(addr_absolute_x(page_crossed))); cycles = 4 + page_crossed; break;
-        case 0x79: op_adc(read(addr_absolute_y(page_crossed))); cycles = 4 + page_crossed; break;
-        case 0x61: op_adc(read(addr_indirect_x())); cycles = 6; break;
-        case 0x71: op_adc(read(addr_indirect_y(page_crossed))); cycles = 5 + page_crossed; break;
-
-        // AND - Logical AND
-        case 0x29: op_and(read(addr_immediate())); cycles = 2; break;
-        case 0x25: op_and(read(addr_zero_page())); cycles = 3; break;
-        case 0x35: op_and(read(addr_zero_page_x())); cycles = 4; break;
-        case 0x2D: op_and(read(addr_absolute())); cycles = 4; break;
-        case 0x3D: op_and(read(addr_absolute_x(page_crossed))); cycles = 4 + page_crossed; break;
-        case 0x39: op_and(read(addr_absolute_y(page_crossed))); cycles = 4 + page_crossed; break;
-        case 0x21: op_and(read(addr_indirect_x())); cycles = 6; break;
-        case 0x31: op_and(read(addr_indirect_y(page_crossed))); cycles = 5 + page_crossed; break;
-
-        // ASL - Arithmetic Shift Left
-        case 0x0A: tick_internal(); op_asl_a(); cycles = 2; break;
-        case 0x06: op_asl(addr_zero_page()); cycles = 5; break;
-        case 0x16: op_asl(addr_zero_page_x()); cycles = 6; break;
-        case 0x0E: op_asl(addr_absolute()); cycles = 6; break;
-        case 0x1E: op_asl(addr_absolute_x(page_crossed, true)); cycles = 7; break;
-
-        // BCC - Branch if Carry Clear
-        case 0x90: op_branch(!get_flag(FLAG_C)); cycles = 2; break;
-
-        // BCS - Branch if Carry Set
-        case 0xB0: op_branch(get_flag(FLAG_C)); cycles = 2; break;
-
-        // BEQ - Branch if Equal
-        case 0xF0: op_branch(get_flag(FLAG_Z)); cycles = 2; break;
-
-        // BIT - Bit Test
-        case 0x24: op_bit(read(addr_zero_page())); cycles = 3; break;
-        case 0x2C: op_bit(read(addr_absolute())); cycles = 4; break;
-
-        // BMI - Branch if Minus
-        case 0x30: op_branch(get_flag(FLAG_N)); cycles = 2; break;
-
-        // BNE - Branch if Not Equal
-        case 0xD0: op_branch(!get_flag(FLAG_Z)); cycles = 2; break;
-
-        // BPL - Branch if Positive
-        case 0x10: op_branch(!get_flag(FLAG_N)); cycles = 2; break;
-
-        // BRK - Break
-        case 0x00: op_brk(); cycles = 7; break;
-
-        // BVC - Branch if Overflow Clear
-        case 0x50: op_branch(!get_flag(FLAG_V)); cycles = 2; break;
-
-        // BVS - Branch if Overflow Set
-        case 0x70: op_branch(get_flag(FLAG_V)); cycles = 2; break;
-
-        // CLC - Clear Carry Flag
-        case 0x18: tick_internal(); set_flag(FLAG_C, false); cycles = 2; break;
-
-        // CLD - Clear Decimal Mode
-        case 0xD8: tick_internal(); set_flag(FLAG_D, false); cycles = 2; break;
-
-        // CLI - Clear Interrupt Disable
-        case 0x58: tick_internal(); set_flag(FLAG_I, false); cycles = 2; break;
-
-        // CLV - Clear Overflow Flag
-        case 0xB8: tick_internal(); set_flag(FLAG_V, false); cycles = 2; break;
-
-        // CMP - Compare Accumulator
-        case 0xC9: op_cmp(m_a, read(addr_immediate())); cycles = 2; break;
-        case 0xC5: op_cmp(m_a, read(addr_zero_page())); cycles = 3; break;
-        case 0xD5: op_cmp(m_a, read(addr_zero_page_x())); cycles = 4; break;
-        case 0xCD: op_cmp(m_a, read(addr_absolute())); cycles = 4; break;
-        case 0xDD: op_cmp(m_a, read(addr_absolute_x(page_crossed))); cycles = 4 + page_crossed; break;
-        case 0xD9: op_cmp(m_a, read(addr_absolute_y(page_crossed))); cycles = 4 + page_crossed; break;
-        case 0xC1: op_cmp(m_a, read(addr_indirect_x())); cycles = 6; break;
-        case 0xD1: op_cmp(m_a, read(addr_indirect_y(page_crossed))); cycles = 5 + page_crossed; break;
-
-        // CPX - Compare X Register
-        case 0xE0: op_cmp(m_x, read(addr_immediate())); cycles = 2; break;
-        case 0xE4: op_cmp(m_x, read(addr_zero_page())); cycles = 3; break;
-        case 0xEC: op_cmp(m_x, read(addr_absolute())); cycles = 4; break;
-
-        // CPY - Compare Y Register
-        case 0xC0: op_cmp(m_y, read(addr_immediate())); cycles = 2; break;
-        case 0xC4: op_cmp(m_y, read(addr_zero_page())); cycles = 3; break;
-        case 0xCC: op_cmp(m_y, read(addr_absolute())); cycles = 4; break;
-
-        // DEC - Decrement Memory
-        case 0xC6: op_dec(addr_zero_page()); cycles = 5; break;
-        case 0xD6: op_dec(addr_zero_page_x()); cycles = 6; break;
-        case 0xCE: op_dec(addr_absolute()); cycles = 6; break;
-        case 0xDE: op_dec(addr_absolute_x(page_crossed, true)); cycles = 7; break;
-
-        // DEX - Decrement X
-        case 0xCA: tick_internal(); m_x--; update_zero_negative(m_x); cycles = 2; break;
-
-        // DEY - Decrement Y
-        case 0x88: tick_internal(); m_y--; update_zero_negative(m_y); cycles = 2; break;
-
-        // EOR - Exclusive OR
-        case 0x49: op_eor(read(addr_immediate())); cycles = 2; break;
-        case 0x45: op_eor(read(addr_zero_page())); cycles = 3; break;
-        case 0x55: op_eor(read(addr_zero_page_x())); cycles = 4; break;
-        case 0x4D: op_eor(read(addr_absolute())); cycles = 4; break;
-        case 0x5D: op_eor(read(addr_absolute_x(page_crossed))); cycles = 4 + page_crossed; break;
-        case 0x59: op_eor(read(addr_absolute_y(page_crossed))); cycles = 4 + page_crossed; break;
-        case 0x41: op_eor(read(addr_indirect_x())); cycles = 6; break;
-        case 0x51: op_eor(read(addr_indirect_y(page_crossed))); cycles = 5 + page_crossed; break;
-
-        // INC - Increment Memory
-        case 0xE6: op_inc(addr_zero_page()); cycles = 5; break;
-        case 0xF6: op_inc(addr_zero_page_x()); cycles = 6; break;
-        case 0xEE: op_inc(addr_absolute()); cycles = 6; break;
-        case 0xFE: op_inc(addr_absolute_x(page_crossed, true)); cycles = 7; break;
-
-        // INX - Increment X
-        case 0xE8: tick_internal(); m_x++; update_zero_negative(m_x); cycles = 2; break;
-
-        // INY - Increment Y
-        case 0xC8: tick_internal(); m_y++; update_zero_negative(m_y); cycles = 2; break;
-
-        // JMP - Jump
-        case 0x4C: op_jmp(addr_absolute()); cycles = 3; break;
-        case 0x6C: op_jmp(addr_indirect()); cycles = 5; break;
-
-        // JSR - Jump to Subroutine
-        case 0x20: op_jsr(addr_absolute()); cycles = 6; break;
-
-        // LDA - Load Accumulator
-        case 0xA9: op_lda(read(addr_immediate())); cycles = 2; break;
-        case 0xA5: op_lda(read(addr_zero_page())); cycles = 3; break;
-        case 0xB5: op_lda(read(addr_zero_page_x())); cycles = 4; break;
-        case 0xAD: op_lda(read(addr_absolute())); cycles = 4; break;
-        case 0xBD: op_lda(read(addr_absolute_x(page_crossed))); cycles = 4 + page_crossed; break;
-        case 0xB9: op_lda(read(addr_absolute_y(page_crossed))); cycles = 4 + page_crossed; break;
-        case 0xA1: op_lda(read(addr_indirect_x())); cycles = 6; break;
-        case 0xB1: op_lda(read(addr_indirect_y(page_crossed))); cycles = 5 + page_crossed; break;
-
-        // LDX - Load X Register
-        case 0xA2: op_ldx(read(addr_immediate())); cycles = 2; break;
-        case 0xA6: op_ldx(read(addr_zero_page())); cycles = 3; break;
-        case 0xB6: op_ldx(read(addr_zero_page_y())); cycles = 4; break;
-        case 0xAE: op_ldx(read(addr_absolute())); cycles = 4; break;
-        case 0xBE: op_ldx(read(addr_absolute_y(page_crossed))); cycles = 4 + page_crossed; break;
-
-        // LDY - Load Y Register
-        case 0xA0: op_ldy(read(addr_immediate())); cycles = 2; break;
-        case 0xA4: op_ldy(read(addr_zero_page())); cycles = 3; break;
-        case 0xB4: op_ldy(read(addr_zero_page_x())); cycles = 4; break;
-        case 0xAC: op_ldy(read(addr_absolute())); cycles = 4; break;
-        case 0xBC: op_ldy(read(addr_absolute_x(page_crossed))); cycles = 4 + page_crossed; break;
-
-        // LSR - Logical Shift Right
-        case 0x4A: tick_internal(); op_lsr_a(); cycles = 2; break;
-        case 0x46: op_lsr(addr_zero_page()); cycles = 5; break;
-        case 0x56: op_lsr(addr_zero_page_x()); cycles = 6; break;
-        case 0x4E: op_lsr(addr_absolute()); cycles = 6; break;
-        case 0x5E: op_lsr(addr_absolute_x(page_crossed, true)); cycles = 7; break;
-
-        // NOP - No Operation
-        case 0xEA: tick_internal(); cycles = 2; break;
-
-        // ORA - Logical OR
-        case 0x09: op_ora(read(addr_immediate())); cycles = 2; break;
-        case 0x05: op_ora(read(addr_zero_page())); cycles = 3; break;
-        case 0x15: op_ora(read(addr_zero_page_x())); cycles = 4; break;
-        case 0x0D: op_ora(read(addr_absolute())); cycles = 4; break;
-        case 0x1D: op_ora(read(addr_absolute_x(page_crossed))); cycles = 4 + page_crossed; break;
-        case 0x19: op_ora(read(addr_absolute_y(page_crossed))); cycles = 4 + page_crossed; break;
-        case 0x01: op_ora(read(addr_indirect_x())); cycles = 6; break;
-        case 0x11: op_ora(read(addr_indirect_y(page_crossed))); cycles = 5 + page_crossed; break;
-
-        // PHA - Push Accumulator (3 cycles: fetch, internal, push)
-        case 0x48: tick_internal(); push(m_a); cycles = 3; break;
-
-        // PHP - Push Processor Status (3 cycles: fetch, internal, push)
-        case 0x08: tick_internal(); push(m_status | FLAG_B | FLAG_U); cycles = 3; break;
-
-        // PLA - Pull Accumulator (4 cycles: fetch, internal, dummy read, pop)
-        case 0x68: tick_internal(); tick_internal(); m_a = pop(); update_zero_negative(m_a); cycles = 4; break;
-
-        // PLP - Pull Processor Status (4 cycles: fetch, internal, dummy read, pop)
-        case 0x28: tick_internal(); tick_internal(); m_status = (pop() & ~FLAG_B) | FLAG_U; cycles = 4; break;
-
-        // ROL - Rotate Left
-        case 0x2A: tick_internal(); op_rol_a(); cycles = 2; break;
-        case 0x26: op_rol(addr_zero_page()); cycles = 5; break;
-        case 0x36: op_rol(addr_zero_page_x()); cycles = 6; break;
-        case 0x2E: op_rol(addr_absolute()); cycles = 6; break;
-        case 0x3E: op_rol(addr_absolute_x(page_crossed, true)); cycles = 7; break;
-
-        // ROR - Rotate Right
-        case 0x6A: tick_internal(); op_ror_a(); cycles = 2; break;
-        case 0x66: op_ror(addr_zero_page()); cycles = 5; break;
-        case 0x76: op_ror(addr_zero_page_x()); cycles = 6; break;
-        case 0x6E: op_ror(addr_absolute()); cycles = 6; break;
-        case 0x7E: op_ror(addr_absolute_x(page_crossed, true)); cycles = 7; break;
-
-        // RTI - Return from Interrupt
-        case 0x40: op_rti(); cycles = 6; break;
-
-        // RTS - Return from Subroutine
-        case 0x60: op_rts(); cycles = 6; break;
-
-        // SBC - Subtract with Carry
-        case 0xE9: op_sbc(read(addr_immediate())); cycles = 2; break;
-        case 0xE5: op_sbc(read(addr_zero_page())); cycles = 3; break;
-        case 0xF5: op_sbc(read(addr_zero_page_x())); cycles = 4; break;
-        case 0xED: op_sbc(read(addr_absolute())); cycles = 4; break;
-        case 0xFD: op_sbc(read(addr_absolute_x(page_crossed))); cycles = 4 + page_crossed; break;
-        case 0xF9: op_sbc(read(addr_absolute_y(page_crossed))); cycles = 4 + page_crossed; break;
-        case 0xE1: op_sbc(read(addr_indirect_x())); cycles = 6; break;
-        case 0xF1: op_sbc(read(addr_indirect_y(page_crossed))); cycles = 5 + page_crossed; break;
-
-        // SEC - Set Carry Flag
-        case 0x38: tick_internal(); set_flag(FLAG_C, true); cycles = 2; break;
-
-        // SED - Set Decimal Flag
-        case 0xF8: tick_internal(); set_flag(FLAG_D, true); cycles = 2; break;
-
-        // SEI - Set Interrupt Disable
-        case 0x78: tick_internal(); set_flag(FLAG_I, true); cycles = 2; break;
-
-        // STA - Store Accumulator
-        // Indexed addressing modes always do a dummy read for stores
-        case 0x85: op_sta(addr_zero_page()); cycles = 3; break;
-        case 0x95: op_sta(addr_zero_page_x()); cycles = 4; break;
-        case 0x8D: op_sta(addr_absolute()); cycles = 4; break;
-        case 0x9D: op_sta(addr_absolute_x(page_crossed, true)); cycles = 5; break;
-        case 0x99: op_sta(addr_absolute_y(page_crossed, true)); cycles = 5; break;
-        case 0x81: op_sta(addr_indirect_x()); cycles = 6; break;
-        case 0x91: op_sta(addr_indirect_y(page_crossed, true)); cycles = 6; break;
-
-        // STX - Store X Register
-        case 0x86: op_stx(addr_zero_page()); cycles = 3; break;
-        case 0x96: op_stx(addr_zero_page_y()); cycles = 4; break;
-        case 0x8E: op_stx(addr_absolute()); cycles = 4; break;
-
-        // STY - Store Y Register
-        case 0x84: op_sty(addr_zero_page()); cycles = 3; break;
-        case 0x94: op_sty(addr_zero_page_x()); cycles = 4; break;
-        case 0x8C: op_sty(addr_absolute()); cycles = 4; break;
-
-        // TAX - Transfer Accumulator to X
-        case 0xAA: tick_internal(); m_x = m_a; update_zero_negative(m_x); cycles = 2; break;
-
-        // TAY - Transfer Accumulator to Y
-        case 0xA8: tick_internal(); m_y = m_a; update_zero_negative(m_y); cycles = 2; break;
-
-        // TSX - Transfer Stack Pointer to X
-        case 0xBA: tick_internal(); m_x = m_sp; update_zero_negative(m_x); cycles = 2; break;
-
-        // TXA - Transfer X to Accumulator
-        case 0x8A: tick_internal(); m_a = m_x; update_zero_negative(m_a); cycles = 2; break;
-
-        // TXS - Transfer X to Stack Pointer
-        case 0x9A: tick_internal(); m_sp = m_x; cycles = 2; break;
-
-        // TYA - Transfer Y to Accumulator
-        case 0x98: tick_internal(); m_a = m_y; update_zero_negative(m_a); cycles = 2; break;
-
-        // ============== Unofficial/Illegal Opcodes ==============
-
-        // LAX - Load A and X with same value
-        case 0xA7: { uint8_t v = read(addr_zero_page()); m_a = m_x = v; update_zero_negative(v); cycles = 3; break; }
-        case 0xB7: { uint8_t v = read(addr_zero_page_y()); m_a = m_x = v; update_zero_negative(v); cycles = 4; break; }
-        case 0xAF: { uint8_t v = read(addr_absolute()); m_a = m_x = v; update_zero_negative(v); cycles = 4; break; }
-        case 0xBF: { uint8_t v = read(addr_absolute_y(page_crossed)); m_a = m_x = v; update_zero_negative(v); cycles = 4 + (page_crossed ? 1 : 0); break; }
-        case 0xA3: { uint8_t v = read(addr_indirect_x()); m_a = m_x = v; update_zero_negative(v); cycles = 6; break; }
-        case 0xB3: { uint8_t v = read(addr_indirect_y(page_crossed)); m_a = m_x = v; update_zero_negative(v); cycles = 5 + (page_crossed ? 1 : 0); break; }
-
-        // SAX - Store A AND X
-        case 0x87: write(addr_zero_page(), m_a & m_x); cycles = 3; break;
-        case 0x97: write(addr_zero_page_y(), m_a & m_x); cycles = 4; break;
-        case 0x8F: write(addr_absolute(), m_a & m_x); cycles = 4; break;
-        case 0x83: write(addr_indirect_x(), m_a & m_x); cycles = 6; break;
-
-        // DCP - Decrement memory then Compare with A (RMW - includes dummy write)
-        case 0xC7: { uint16_t a = addr_zero_page(); uint8_t v = read(a); write(a, v); v--; write(a, v); op_cmp(m_a, v); cycles = 5; break; }
-        case 0xD7: { uint16_t a = addr_zero_page_x(); uint8_t v = read(a); write(a, v); v--; write(a, v); op_cmp(m_a, v); cycles = 6; break; }
-        case 0xCF: { uint16_t a = addr_absolute(); uint8_t v = read(a); write(a, v); v--; write(a, v); op_cmp(m_a, v); cycles = 6; break; }
-        case 0xDF: { uint16_t a = addr_absolute_x(page_crossed, true); uint8_t v = read(a); write(a, v); v--; write(a, v); op_cmp(m_a, v); cycles = 7; break; }
-        case 0xDB: { uint16_t a = addr_absolute_y(page_crossed, true); uint8_t v = read(a); write(a, v); v--; write(a, v); op_cmp(m_a, v); cycles = 7; break; }
-        case 0xC3: { uint16_t a = addr_indirect_x(); uint8_t v = read(a); write(a, v); v--; write(a, v); op_cmp(m_a, v); cycles = 8; break; }
-        case 0xD3: { uint16_t a = addr_indirect_y(page_crossed, true); uint8_t v = read(a); write(a, v); v--; write(a, v); op_cmp(m_a, v); cycles = 8; break; }
-
-        // ISB/ISC - Increment memory then Subtract from A (RMW - includes dummy write)
-        case 0xE7: { uint16_t a = addr_zero_page(); uint8_t v = read(a); write(a, v); v++; write(a, v); op_sbc(v); cycles = 5; break; }
-        case 0xF7: { uint16_t a = addr_zero_page_x(); uint8_t v = read(a); write(a, v); v++; write(a, v); op_sbc(v); cycles = 6; break; }
-        case 0xEF: { uint16_t a = addr_absolute(); uint8_t v = read(a); write(a, v); v++; write(a, v); op_sbc(v); cycles = 6; break; }
-        case 0xFF: { uint16_t a = addr_absolute_x(page_crossed, true); uint8_t v = read(a); write(a, v); v++; write(a, v); op_sbc(v); cycles = 7; break; }
-        case 0xFB: { uint16_t a = addr_absolute_y(page_crossed, true); uint8_t v = read(a); write(a, v); v++; write(a, v); op_sbc(v); cycles = 7; break; }
-        case 0xE3: { uint16_t a = addr_indirect_x(); uint8_t v = read(a); write(a, v); v++; write(a, v); op_sbc(v); cycles = 8; break; }
-        case 0xF3: { uint16_t a = addr_indirect_y(page_crossed, true); uint8_t v = read(a); write(a, v); v++; write(a, v); op_sbc(v); cycles = 8; break; }
-
-        // SLO - Shift Left then OR with A (RMW - includes dummy write of original value)
-        case 0x07: { uint16_t a = addr_zero_page(); uint8_t v = read(a); write(a, v); set_flag(FLAG_C, v & 0x80); v <<= 1; write(a, v); m_a |= v; update_zero_negative(m_a); cycles = 5; break; }
-        case 0x17: { uint16_t a = addr_zero_page_x(); uint8_t v = read(a); write(a, v); set_flag(FLAG_C, v & 0x80); v <<= 1; write(a, v); m_a |= v; update_zero_negative(m_a); cycles = 6; break; }
-        case 0x0F: { uint16_t a = addr_absolute(); uint8_t v = read(a); write(a, v); set_flag(FLAG_C, v & 0x80); v <<= 1; write(a, v); m_a |= v; update_zero_negative(m_a); cycles = 6; break; }
-        case 0x1F: { uint16_t a = addr_absolute_x(page_crossed, true); uint8_t v = read(a); write(a, v); set_flag(FLAG_C, v & 0x80); v <<= 1; write(a, v); m_a |= v; update_zero_negative(m_a); cycles = 7; break; }
-        case 0x1B: { uint16_t a = addr_absolute_y(page_crossed, true); uint8_t v = read(a); write(a, v); set_flag(FLAG_C, v & 0x80); v <<= 1; write(a, v); m_a |= v; update_zero_negative(m_a); cycles = 7; break; }
-        case 0x03: { uint16_t a = addr_indirect_x(); uint8_t v = read(a); write(a, v); set_flag(FLAG_C, v & 0x80); v <<= 1; write(a, v); m_a |= v; update_zero_negative(m_a); cycles = 8; break; }
-        case 0x13: { uint16_t a = addr_indirect_y(page_crossed, true); uint8_t v = read(a); write(a, v); set_flag(FLAG_C, v & 0x80); v <<= 1; write(a, v); m_a |= v; update_zero_negative(m_a); cycles = 8; break; }
-
-        // RLA - Rotate Left then AND with A (RMW - includes dummy write)
-        case 0x27: { uint16_t a = addr_zero_page(); uint8_t v = read(a); write(a, v); uint8_t c = get_flag(FLAG_C) ? 1 : 0; set_flag(FLAG_C, v & 0x80); v = (v << 1) | c; write(a, v); m_a &= v; update_zero_negative(m_a); cycles = 5; break; }
-        case 0x37: { uint16_t a = addr_zero_page_x(); uint8_t v = read(a); write(a, v); uint8_t c = get_flag(FLAG_C) ? 1 : 0; set_flag(FLAG_C, v & 0x80); v = (v << 1) | c; write(a, v); m_a &= v; update_zero_negative(m_a); cycles = 6; break; }
-        case 0x2F: { uint16_t a = addr_absolute(); uint8_t v = read(a); write(a, v); uint8_t c = get_flag(FLAG_C) ? 1 : 0; set_flag(FLAG_C, v & 0x80); v = (v << 1) | c; write(a, v); m_a &= v; update_zero_negative(m_a); cycles = 6; break; }
-        case 0x3F: { uint16_t a = addr_absolute_x(page_crossed, true); uint8_t v = read(a); write(a, v); uint8_t c = get_flag(FLAG_C) ? 1 : 0; set_flag(FLAG_C, v & 0x80); v = (v << 1) | c; write(a, v); m_a &= v; update_zero_negative(m_a); cycles = 7; break; }
-        case 0x3B: { uint16_t a = addr_absolute_y(page_crossed, true); uint8_t v = read(a); write(a, v); uint8_t c = get_flag(FLAG_C) ? 1 : 0; set_flag(FLAG_C, v & 0x80); v = (v << 1) | c; write(a, v); m_a &= v; update_zero_negative(m_a); cycles = 7; break; }
-        case 0x23: { uint16_t a = addr_indirect_x(); uint8_t v = read(a); write(a, v); uint8_t c = get_flag(FLAG_C) ? 1 : 0; set_flag(FLAG_C, v & 0x80); v = (v << 1) | c; write(a, v); m_a &= v; update_zero_negative(m_a); cycles = 8; break; }
-        case 0x33: { uint16_t a = addr_indirect_y(page_crossed, true); uint8_t v = read(a); write(a, v); uint8_t c = get_flag(FLAG_C) ? 1 : 0; set_flag(FLAG_C, v & 0x80); v = (v << 1) | c; write(a, v); m_a &= v; update_zero_negative(m_a); cycles = 8; break; }
-
-        // SRE - Shift Right then XOR with A (RMW - includes dummy write)
-        case 0x47: { uint16_t a = addr_zero_page(); uint8_t v = read(a); write(a, v); set_flag(FLAG_C, v & 0x01); v >>= 1; write(a, v); m_a ^= v; update_zero_negative(m_a); cycles = 5; break; }
-        case 0x57: { uint16_t a = addr_zero_page_x(); uint8_t v = read(a); write(a, v); set_flag(FLAG_C, v & 0x01); v >>= 1; write(a, v); m_a ^= v; update_zero_negative(m_a); cycles = 6; break; }
-        case 0x4F: { uint16_t a = addr_absolute(); uint8_t v = read(a); write(a, v); set_flag(FLAG_C, v & 0x01); v >>= 1; write(a, v); m_a ^= v; update_zero_negative(m_a); cycles = 6; break; }
-        case 0x5F: { uint16_t a = addr_absolute_x(page_crossed, true); uint8_t v = read(a); write(a, v); set_flag(FLAG_C, v & 0x01); v >>= 1; write(a, v); m_a ^= v; update_zero_negative(m_a); cycles = 7; break; }
-        case 0x5B: { uint16_t a = addr_absolute_y(page_crossed, true); uint8_t v = read(a); write(a, v); set_flag(FLAG_C, v & 0x01); v >>= 1; write(a, v); m_a ^= v; update_zero_negative(m_a); cycles = 7; break; }
-        case 0x43: { uint16_t a = addr_indirect_x(); uint8_t v = read(a); write(a, v); set_flag(FLAG_C, v & 0x01); v >>= 1; write(a, v); m_a ^= v; update_zero_negative(m_a); cycles = 8; break; }
-        case 0x53: { uint16_t a = addr_indirect_y(page_crossed, true); uint8_t v = read(a); write(a, v); set_flag(FLAG_C, v & 0x01); v >>= 1; write(a, v); m_a ^= v; update_zero_negative(m_a); cycles = 8; break; }
-
-        // RRA - Rotate Right then Add with carry (RMW - includes dummy write)
-        case 0x67: { uint16_t a = addr_zero_page(); uint8_t v = read(a); write(a, v); uint8_t c = get_flag(FLAG_C) ? 0x80 : 0; set_flag(FLAG_C, v & 0x01); v = (v >> 1) | c; write(a, v); op_adc(v); cycles = 5; break; }
-        case 0x77: { uint16_t a = addr_zero_page_x(); uint8_t v = read(a); write(a, v); uint8_t c = get_flag(FLAG_C) ? 0x80 : 0; set_flag(FLAG_C, v & 0x01); v = (v >> 1) | c; write(a, v); op_adc(v); cycles = 6; break; }
-        case 0x6F: { uint16_t a = addr_absolute(); uint8_t v = read(a); write(a, v); uint8_t c = get_flag(FLAG_C) ? 0x80 : 0; set_flag(FLAG_C, v & 0x01); v = (v >> 1) | c; write(a, v); op_adc(v); cycles = 6; break; }
-        case 0x7F: { uint16_t a = addr_absolute_x(page_crossed, true); uint8_t v = read(a); write(a, v); uint8_t c = get_flag(FLAG_C) ? 0x80 : 0; set_flag(FLAG_C, v & 0x01); v = (v >> 1) | c; write(a, v); op_adc(v); cycles = 7; break; }
-        case 0x7B: { uint16_t a = addr_absolute_y(page_crossed, true); uint8_t v = read(a); write(a, v); uint8_t c = get_flag(FLAG_C) ? 0x80 : 0; set_flag(FLAG_C, v & 0x01); v = (v >> 1) | c; write(a, v); op_adc(v); cycles = 7; break; }
-        case 0x63: { uint16_t a = addr_indirect_x(); uint8_t v = read(a); write(a, v); uint8_t c = get_flag(FLAG_C) ? 0x80 : 0; set_flag(FLAG_C, v & 0x01); v = (v >> 1) | c; write(a, v); op_adc(v); cycles = 8; break; }
-        case 0x73: { uint16_t a = addr_indirect_y(page_crossed, true); uint8_t v = read(a); write(a, v); uint8_t c = get_flag(FLAG_C) ? 0x80 : 0; set_flag(FLAG_C, v & 0x01); v = (v >> 1) | c; write(a, v); op_adc(v); cycles = 8; break; }
-
-        // ANC - AND with A, copy N to C
-        case 0x0B: case 0x2B: { m_a &= read(addr_immediate()); update_zero_negative(m_a); set_flag(FLAG_C, m_a & 0x80); cycles = 2; break; }
-
-        // ALR/ASR - AND with A, then LSR
-        case 0x4B: { m_a &= read(addr_immediate()); set_flag(FLAG_C, m_a & 0x01); m_a >>= 1; update_zero_negative(m_a); cycles = 2; break; }
-
-        // ARR - AND with A, then ROR
-        case 0x6B: { m_a &= read(addr_immediate()); m_a = (m_a >> 1) | (get_flag(FLAG_C) ? 0x80 : 0); update_zero_negative(m_a); set_flag(FLAG_C, m_a & 0x40); set_flag(FLAG_V, ((m_a >> 6) ^ (m_a >> 5)) & 1); cycles = 2; break; }
-
-        // SBX/AXS - (A AND X) - imm -> X
-        case 0xCB: { uint8_t v = read(addr_immediate()); uint8_t t = (m_a & m_x) - v; set_flag(FLAG_C, (m_a & m_x) >= v); m_x = t; update_zero_negative(m_x); cycles = 2; break; }
-
-        // Unofficial SBC immediate (duplicate of 0xE9)
-        case 0xEB: op_sbc(read(addr_immediate())); cycles = 2; break;
-
-        // LAX immediate (unstable - uses (A | 0xEE) & X & imm, but many emulators use simpler behavior)
-        case 0xAB: { uint8_t v = read(addr_immediate()); m_a = m_x = (m_a | 0xEE) & v; update_zero_negative(m_a); cycles = 2; break; }
-
-        // Unofficial NOPs (various addressing modes)
-        // These actually perform the addressing mode reads but discard the result
-        case 0x1A: case 0x3A: case 0x5A: case 0x7A: case 0xDA: case 0xFA: tick_internal(); cycles = 2; break;  // NOP implied
-        case 0x80: case 0x82: case 0x89: case 0xC2: case 0xE2: read(m_pc++); cycles = 2; break;  // NOP immediate (2 cycles)
-        case 0x04: case 0x44: case 0x64: read(addr_zero_page()); cycles = 3; break;  // NOP zero page (3 cycles)
-        case 0x14: case 0x34: case 0x54: case 0x74: case 0xD4: case 0xF4: read(addr_zero_page_x()); cycles = 4; break;  // NOP zero page,X (4 cycles)
-        case 0x0C: read(addr_absolute()); cycles = 4; break;  // NOP absolute (4 cycles)
-        case 0x1C: case 0x3C: case 0x5C: case 0x7C: case 0xDC: case 0xFC: read(addr_absolute_x(page_crossed)); cycles = 4 + (page_crossed ? 1 : 0); break;  // NOP absolute,X (4+ cycles)
-
-        // SHY - Store Y AND (high byte + 1) absolute,X (unstable)
-        case 0x9C: {
-            uint8_t lo = read(m_pc++);
-            uint8_t hi = read(m_pc++);
-            uint8_t val = m_y & (hi + 1);
-            uint16_t addr = ((static_cast<uint16_t>(hi) << 8) | lo) + m_x;
-            // Dummy read at uncorrected address (store instructions always do this)
-            read(((static_cast<uint16_t>(hi) << 8) | ((lo + m_x) & 0xFF)));
-            if ((lo + m_x) > 0xFF) {
-                addr = (static_cast<uint16_t>(val) << 8) | ((lo + m_x) & 0xFF);
-            }
-            write(addr, val);
-            cycles = 5;
-            break;
-        }
-
-        // SHX - Store X AND (high byte + 1) absolute,Y (unstable)
-        case 0x9E: {
-            uint8_t lo = read(m_pc++);
-            uint8_t hi = read(m_pc++);
-            uint8_t val = m_x & (hi + 1);
-            uint16_t addr = ((static_cast<uint16_t>(hi) << 8) | lo) + m_y;
-            // Dummy read at uncorrected address (store instructions always do this)
-            read(((static_cast<uint16_t>(hi) << 8) | ((lo + m_y) & 0xFF)));
-            if ((lo + m_y) > 0xFF) {
-                addr = (static_cast<uint16_t>(val) << 8) | ((lo + m_y) & 0xFF);
-            }
-            write(addr, val);
-            cycles = 5;
-            break;
-        }
-
-        // SHA/AHX - Store A AND X AND (high byte + 1) absolute,Y (unstable)
-        case 0x9F: {
-            uint8_t lo = read(m_pc++);
-            uint8_t hi = read(m_pc++);
-            uint8_t val = m_a & m_x & (hi + 1);
-            uint16_t addr = ((static_cast<uint16_t>(hi) << 8) | lo) + m_y;
-            // Dummy read at uncorrected address (store instructions always do this)
-            read(((static_cast<uint16_t>(hi) << 8) | ((lo + m_y) & 0xFF)));
-            if ((lo + m_y) > 0xFF) {
-                addr = (static_cast<uint16_t>(val) << 8) | ((lo + m_y) & 0xFF);
-            }
-            write(addr, val);
-            cycles = 5;
-            break;
-        }
-
-        // SHA/AHX - Store A AND X AND (high byte + 1) (indirect),Y (unstable)
-        case 0x93: {
-            uint8_t ptr = read(m_pc++);
-            uint8_t lo = read(ptr);
-            uint8_t hi = read((ptr + 1) & 0xFF);
-            uint8_t val = m_a & m_x & (hi + 1);
-            uint16_t addr = ((static_cast<uint16_t>(hi) << 8) | lo) + m_y;
-            // Dummy read at uncorrected address (store instructions always do this)
-            read(((static_cast<uint16_t>(hi) << 8) | ((lo + m_y) & 0xFF)));
-            if ((lo + m_y) > 0xFF) {
-                addr = (static_cast<uint16_t>(val) << 8) | ((lo + m_y) & 0xFF);
-            }
-            write(addr, val);
-            cycles = 6;
-            break;
-        }
-
-        // TAS/SHS - Transfer A AND X to SP, then store A AND X AND (high byte + 1) (unstable)
-        case 0x9B: {
-            uint8_t lo = read(m_pc++);
-            uint8_t hi = read(m_pc++);
-            m_sp = m_a & m_x;
-            uint8_t val = m_a & m_x & (hi + 1);
-            uint16_t addr = ((static_cast<uint16_t>(hi) << 8) | lo) + m_y;
-            // Dummy read at uncorrected address (store instructions always do this)
-            read(((static_cast<uint16_t>(hi) << 8) | ((lo + m_y) & 0xFF)));
-            if ((lo + m_y) > 0xFF) {
-                addr = (static_cast<uint16_t>(val) << 8) | ((lo + m_y) & 0xFF);
-            }
-            write(addr, val);
-            cycles = 5;
-            break;
-        }
-
-        // LAS - Load A, X, and SP with (SP AND memory)
-        case 0xBB: {
-            uint16_t addr = addr_absolute_y(page_crossed);
-            uint8_t val = read(addr) & m_sp;
-            m_a = m_x = m_sp = val;
-            update_zero_negative(val);
-            cycles = 4 + (page_crossed ? 1 : 0);
-            break;
-        }
-
-        // XAA/ANE - A = (A | magic) & X & imm (highly unstable, magic varies)
-        case 0x8B: {
-            uint8_t v = read(addr_immediate());
-            m_a = (m_a | 0xEE) & m_x & v;
-            update_zero_negative(m_a);
-            cycles = 2;
-            break;
-        }
-
-        // KIL/JAM opcodes - these halt the CPU on real hardware
-        // We treat them as 2-cycle NOPs to avoid infinite loops
-        case 0x02: case 0x12: case 0x22: case 0x32: case 0x42: case 0x52:
-        case 0x62: case 0x72: case 0x92: case 0xB2: case 0xD2: case 0xF2:
-            cycles = 2;
-            break;
-
-        // Unknown/remaining opcodes - treat as NOP
-        default: cycles = 2; break;
-    }
+    int cycles = (this->*s_op_table[opcode])();
 
     // At the end of each instruction, convert delayed NMI to pending
     // This makes the NMI fire BEFORE the next instruction starts
@@ -561,6 +90,27 @@ int CPU::step() {
     return cycles;
 }
 
+void CPU::trace_instruction(uint8_t opcode) {
+    emu::CpuTraceRecord& record = m_trace->append();
+    uint16_t pc = m_pc - 1;
+    record.pc = pc;
+    record.opcode[0] = opcode;
+    for (int i = 1; i < 4; i++) {
+        // Reading PPU and APU registers has side effects; code doesn't run
+        // from them
+        uint16_t address = static_cast<uint16_t>(pc + i);
+        bool io = address >= 0x2000 && address < 0x4020;
+        record.opcode[i] = io ? 0 : m_bus.cpu_peek(address);
+    }
+    record.arch = static_cast<uint8_t>(emu::CpuTraceArch::MOS6502);
+    record.flags = 0;
+    record.regs[0] = m_a;
+    record.regs[1] = m_x;
+    record.regs[2] = m_y;
+    record.regs[3] = m_sp;
+    record.regs[4] = m_status;
+}
+
 void CPU::trigger_nmi() {
     m_nmi_pending = true;
 }
@@ -575,12 +125,6 @@ void CPU::trigger_irq() {
     m_irq_pending = true;
 }
 
-void CPU::set_irq_line(bool active) {
-    // Level-triggered: IRQ is pending if the line is currently active
-    // This reflects the mapper's current IRQ state, not a latched value
-    m_irq_pending = active;
-}
-
 void CPU::set_nmi_line(bool active) {
     // Update NMI line state for edge detection
     // Edge detection happens in detect_nmi_edge()
@@ -754,6 +298,19 @@ uint16_t CPU::addr_indirect_y(bool& page_crossed, bool is_write) {
     return result;
 }
 
+template<CPU::AddrMode Mode, bool IsWrite>
+uint16_t CPU::resolve_address(bool& page_crossed) {
+    if constexpr (Mode == AddrMode::Immediate) return addr_immediate();
+    else if constexpr (Mode == AddrMode::ZeroPage) return addr_zero_page();
+    else if constexpr (Mode == AddrMode::ZeroPageX) return addr_zero_page_x();
+    else if constexpr (Mode == AddrMode::ZeroPageY) return addr_zero_page_y();
+    else if constexpr (Mode == AddrMode::Absolute) return addr_absolute();
+    else if constexpr (Mode == AddrMode::AbsoluteX) return addr_absolute_x(page_crossed, IsWrite);
+    else if constexpr (Mode == AddrMode::AbsoluteY) return addr_absolute_y(page_crossed, IsWrite);
+    else if constexpr (Mode == AddrMode::IndirectX) return addr_indirect_x();
+    else return addr_indirect_y(page_crossed, IsWrite);
+}
+
 void CPU::set_flag(uint8_t flag, bool value) {
     if (value) {
         m_status |= flag;
@@ -785,19 +342,9 @@ void CPU::op_and(uint8_t value) {
     update_zero_negative(m_a);
 }
 
-void CPU::op_asl(uint16_t address) {
-    uint8_t value = read(address);
-    write(address, value);  // Dummy write of original value (RMW behavior)
+uint8_t CPU::op_asl(uint8_t value) {
     set_flag(FLAG_C, (value & 0x80) != 0);
-    value <<= 1;
-    write(address, value);
-    update_zero_negative(value);
-}
-
-void CPU::op_asl_a() {
-    set_flag(FLAG_C, (m_a & 0x80) != 0);
-    m_a <<= 1;
-    update_zero_negative(m_a);
+    return value << 1;
 }
 
 void CPU::op_bit(uint8_t value) {
@@ -806,11 +353,12 @@ void CPU::op_bit(uint8_t value) {
     set_flag(FLAG_V, (value & 0x40) != 0);
 }
 
-void CPU::op_branch(bool condition) {
+int CPU::op_branch(bool condition) {
     int8_t offset = static_cast<int8_t>(read(m_pc++));
     if (condition) {
         // Branch taken: 1 cycle penalty for calculating new PC
         tick_internal();
+        int cycles = 1;
 
         uint16_t old_pc = m_pc;
         m_pc += offset;
@@ -818,9 +366,61 @@ void CPU::op_branch(bool condition) {
         // Page crossing adds another cycle
         if ((old_pc & 0xFF00) != (m_pc & 0xFF00)) {
             tick_internal();
+            cycles++;
         }
+
+        // The two shapes of $2002 polling loop
+        if (offset == -5 || offset == -7) {
+            cycles += skip_status_poll(-offset);
+        }
+        return cycles;
     }
     // Branch not taken: no extra cycles (just the 2 cycles for fetch + operand)
+    return 0;
+}
+
+// Games wait for VBlank or sprite 0 hit with
+//     BIT $2002 / LDA $2002      4 cycles
+//     (AND #mask)                2 cycles
+//     Bxx back to the read       3 cycles, 4 crossing a page
+// so a loop is recognised from its bytes. The branch must exit on $2002's
+// upper three bits only, as the lower five are open bus that decays.
+int CPU::skip_status_poll(int length) {
+    // Nothing may need to happen between passes: no interrupt could be
+    // taken, and no debugger sees the instructions or reads
+    if (!get_flag(FLAG_I) || !m_prev_irq_inhibit || m_nmi_pending || m_nmi_delayed) return 0;
+    if (m_trace || m_breakpoints) return 0;
+
+    uint8_t code[7];
+    for (int i = 0; i < length; i++) {
+        if (!m_bus.peek_prg(static_cast<uint16_t>(m_pc + i), code[i])) return 0;
+    }
+    uint16_t address = static_cast<uint16_t>(code[1] | (code[2] << 8));
+    if ((code[0] != 0x2C && code[0] != 0xAD) || (address & 0xE007) != 0x2002) return 0;
+
+    // Branches on N and V test bits 7 and 6; on Z, whichever bits the
+    // value is masked with
+    uint8_t branch = code[length - 2];
+    bool on_zero = branch == 0xD0 || branch == 0xF0;
+    uint8_t bits = 0;
+    if (length == 5 && code[0] == 0x2C) {
+        if (branch == 0x50 || branch == 0x70) bits = 0x40;
+        else if (branch == 0x10 || branch == 0x30) bits = 0x80;
+        else if (on_zero) bits = m_a;
+    } else if (length == 5) {
+        if (branch == 0x10 || branch == 0x30) bits = 0x80;
+    } else if (code[0] == 0xAD && code[3] == 0x29) {
+        if (on_zero) bits = code[4];
+        else if (branch == 0x10 || branch == 0x30) bits = code[4] & 0x80;
+    }
+    if (bits == 0 || (bits & 0x1F) != 0) return 0;
+
+    int loop_cycles = (length == 5 ? 7 : 9);
+    if (((m_pc + length) & 0xFF00) != (m_pc & 0xFF00)) loop_cycles++;
+
+    int cycles = m_bus.run_status_poll(bits, loop_cycles);
+    m_cycles += cycles;
+    return cycles;
 }
 
 void CPU::op_brk() {
@@ -852,17 +452,25 @@ void CPU::op_brk() {
     m_pc = (static_cast<uint16_t>(hi) << 8) | lo;
 }
 
-void CPU::op_cmp(uint8_t reg, uint8_t value) {
+void CPU::op_cmp(uint8_t value) {
+    compare(m_a, value);
+}
+
+void CPU::op_cpx(uint8_t value) {
+    compare(m_x, value);
+}
+
+void CPU::op_cpy(uint8_t value) {
+    compare(m_y, value);
+}
+
+void CPU::compare(uint8_t reg, uint8_t value) {
     set_flag(FLAG_C, reg >= value);
     update_zero_negative(reg - value);
 }
 
-void CPU::op_dec(uint16_t address) {
-    uint8_t value = read(address);
-    write(address, value);  // Dummy write of original value (RMW behavior)
-    value--;
-    write(address, value);
-    update_zero_negative(value);
+uint8_t CPU::op_dec(uint8_t value) {
+    return value - 1;
 }
 
 void CPU::op_eor(uint8_t value) {
@@ -870,12 +478,8 @@ void CPU::op_eor(uint8_t value) {
     update_zero_negative(m_a);
 }
 
-void CPU::op_inc(uint16_t address) {
-    uint8_t value = read(address);
-    write(address, value);  // Dummy write of original value (RMW behavior)
-    value++;
-    write(address, value);
-    update_zero_negative(value);
+uint8_t CPU::op_inc(uint8_t value) {
+    return value + 1;
 }
 
 void CPU::op_jmp(uint16_t address) {
@@ -908,19 +512,13 @@ void CPU::op_ldy(uint8_t value) {
     update_zero_negative(m_y);
 }
 
-void CPU::op_lsr(uint16_t address) {
-    uint8_t value = read(address);
-    write(address, value);  // Dummy write of original value (RMW behavior)
+uint8_t CPU::op_lsr(uint8_t value) {
     set_flag(FLAG_C, (value & 0x01) != 0);
-    value >>= 1;
-    write(address, value);
-    update_zero_negative(value);
+    return value >> 1;
 }
 
-void CPU::op_lsr_a() {
-    set_flag(FLAG_C, (m_a & 0x01) != 0);
-    m_a >>= 1;
-    update_zero_negative(m_a);
+void CPU::op_nop(uint8_t /*value*/) {
+    // Unofficial NOPs perform the addressing mode reads but discard the result
 }
 
 void CPU::op_ora(uint8_t value) {
@@ -928,38 +526,16 @@ void CPU::op_ora(uint8_t value) {
     update_zero_negative(m_a);
 }
 
-void CPU::op_rol(uint16_t address) {
-    uint8_t value = read(address);
-    write(address, value);  // Dummy write of original value (RMW behavior)
+uint8_t CPU::op_rol(uint8_t value) {
     bool carry = get_flag(FLAG_C);
     set_flag(FLAG_C, (value & 0x80) != 0);
-    value = (value << 1) | (carry ? 1 : 0);
-    write(address, value);
-    update_zero_negative(value);
-}
-
-void CPU::op_rol_a() {
-    bool carry = get_flag(FLAG_C);
-    set_flag(FLAG_C, (m_a & 0x80) != 0);
-    m_a = (m_a << 1) | (carry ? 1 : 0);
-    update_zero_negative(m_a);
+    return (value << 1) | (carry ? 1 : 0);
 }
 
-void CPU::op_ror(uint16_t address) {
-    uint8_t value = read(address);
-    write(address, value);  // Dummy write of original value (RMW behavior)
+uint8_t CPU::op_ror(uint8_t value) {
     bool carry = get_flag(FLAG_C);
     set_flag(FLAG_C, (value & 0x01) != 0);
-    value = (value >> 1) | (carry ? 0x80 : 0);
-    write(address, value);
-    update_zero_negative(value);
-}
-
-void CPU::op_ror_a() {
-    bool carry = get_flag(FLAG_C);
-    set_flag(FLAG_C, (m_a & 0x01) != 0);
-    m_a = (m_a >> 1) | (carry ? 0x80 : 0);
-    update_zero_negative(m_a);
+    return (value >> 1) | (carry ? 0x80 : 0);
 }
 
 void CPU::op_rti() {
@@ -1006,12 +582,622 @@ void CPU::op_sty(uint16_t address) {
     write(address, m_y);
 }
 
+// Unofficial instructions
+void CPU::op_alr(uint8_t value) {
+    // AND with A, then LSR
+    m_a &= value;
+    set_flag(FLAG_C, m_a & 0x01);
+    m_a >>= 1;
+    update_zero_negative(m_a);
+}
+
+void CPU::op_anc(uint8_t value) {
+    // AND with A, copy N to C
+    m_a &= value;
+    update_zero_negative(m_a);
+    set_flag(FLAG_C, m_a & 0x80);
+}
+
+void CPU::op_arr(uint8_t value) {
+    // AND with A, then ROR
+    m_a &= value;
+    m_a = (m_a >> 1) | (get_flag(FLAG_C) ? 0x80 : 0);
+    update_zero_negative(m_a);
+    set_flag(FLAG_C, m_a & 0x40);
+    set_flag(FLAG_V, ((m_a >> 6) ^ (m_a >> 5)) & 1);
+}
+
+void CPU::op_las(uint8_t value) {
+    // Load A, X, and SP with (SP AND memory)
+    uint8_t result = value & m_sp;
+    m_a = m_x = m_sp = result;
+    update_zero_negative(result);
+}
+
+void CPU::op_lax(uint8_t value) {
+    // Load A and X with same value
+    m_a = m_x = value;
+    update_zero_negative(value);
+}
+
+void CPU::op_lxa(uint8_t value) {
+    // LAX immediate (unstable - uses (A | 0xEE) & X & imm, but many emulators use simpler behavior)
+    m_a = m_x = (m_a | 0xEE) & value;
+    update_zero_negative(m_a);
+}
+
+void CPU::op_sax(uint16_t address) {
+    write(address, m_a & m_x);
+}
+
+void CPU::op_sbx(uint8_t value) {
+    // (A AND X) - imm -> X
+    uint8_t result = (m_a & m_x) - value;
+    set_flag(FLAG_C, (m_a & m_x) >= value);
+    m_x = result;
+    update_zero_negative(m_x);
+}
+
+void CPU::op_xaa(uint8_t value) {
+    // A = (A | magic) & X & imm (highly unstable, magic varies)
+    m_a = (m_a | 0xEE) & m_x & value;
+    update_zero_negative(m_a);
+}
+
+void CPU::store_unstable(uint8_t lo, uint8_t hi, uint8_t index, uint8_t value) {
+    // SHY/SHX/SHA/TAS: the stored value is ANDed with (high byte + 1) and,
+    // on a page cross, also replaces the high byte of the target address
+    uint16_t addr = ((static_cast<uint16_t>(hi) << 8) | lo) + index;
+    // Dummy read at uncorrected address (store instructions always do this)
+    read(((static_cast<uint16_t>(hi) << 8) | ((lo + index) & 0xFF)));
+    if ((lo + index) > 0xFF) {
+        addr = (static_cast<uint16_t>(value) << 8) | ((lo + index) & 0xFF);
+    }
+    write(addr, value);
+}
+
+// Opcode handlers
+// Cycle counts include the opcode fetch done in step()
+template<CPU::AddrMode Mode, void (CPU::*Op)(uint8_t)>
+int CPU::exec_read() {
+    bool page_crossed = false;
+    (this->*Op)(read(resolve_address<Mode, false>(page_crossed)));
+
+    if constexpr (Mode == AddrMode::Immediate) return 2;
+    else if constexpr (Mode == AddrMode::ZeroPage) return 3;
+    else if constexpr (Mode == AddrMode::IndirectX) return 6;
+    else if constexpr (Mode == AddrMode::IndirectY) return 5 + page_crossed;
+    else if constexpr (Mode == AddrMode::AbsoluteX || Mode == AddrMode::AbsoluteY) return 4 + page_crossed;
+    else return 4;  // Zero page indexed, absolute
+}
+
+template<CPU::AddrMode Mode, void (CPU::*Op)(uint16_t)>
+int CPU::exec_store() {
+    // Indexed addressing modes always do a dummy read for stores
+    bool page_crossed = false;
+    (this->*Op)(resolve_address<Mode, true>(page_crossed));
+
+    if constexpr (Mode == AddrMode::ZeroPage) return 3;
+    else if constexpr (Mode == AddrMode::AbsoluteX || Mode == AddrMode::AbsoluteY) return 5;
+    else if constexpr (Mode == AddrMode::IndirectX || Mode == AddrMode::IndirectY) return 6;
+    else return 4;  // Zero page indexed, absolute
+}
+
+template<CPU::AddrMode Mode, uint8_t (CPU::*Modify)(uint8_t), void (CPU::*Result)(uint8_t)>
+int CPU::exec_rmw() {
+    // Read-modify-write: read, dummy write of the original value, write the
+    // modified value, then apply the result (flags, or the second half of
+    // the combined unofficial opcodes)
+    bool page_crossed = false;
+    uint16_t address = resolve_address<Mode, true>(page_crossed);
+    uint8_t value = read(address);
+    write(address, value);
+    value = (this->*Modify)(value);
+    write(address, value);
+    (this->*Result)(value);
+
+    if constexpr (Mode == AddrMode::ZeroPage) return 5;
+    else if constexpr (Mode == AddrMode::AbsoluteX || Mode == AddrMode::AbsoluteY) return 7;
+    else if constexpr (Mode == AddrMode::IndirectX || Mode == AddrMode::IndirectY) return 8;
+    else return 6;  // Zero page indexed, absolute
+}
+
+template<uint8_t (CPU::*Modify)(uint8_t)>
+int CPU::exec_accumulator() {
+    tick_internal();
+    m_a = (this->*Modify)(m_a);
+    update_zero_negative(m_a);
+    return 2;
+}
+
+template<uint8_t Flag, bool Value>
+int CPU::exec_branch() {
+    return 2 + op_branch(get_flag(Flag) == Value);
+}
+
+template<uint8_t Flag, bool Value>
+int CPU::exec_set_flag() {
+    tick_internal();
+    set_flag(Flag, Value);
+    return 2;
+}
+
+template<uint8_t CPU::*Src, uint8_t CPU::*Dst, bool SetFlags>
+int CPU::exec_transfer() {
+    tick_internal();
+    this->*Dst = this->*Src;
+    if constexpr (SetFlags) {
+        update_zero_negative(this->*Dst);
+    }
+    return 2;
+}
+
+template<uint8_t CPU::*Reg, int Delta>
+int CPU::exec_increment() {
+    tick_internal();
+    this->*Reg = static_cast<uint8_t>(this->*Reg + Delta);
+    update_zero_negative(this->*Reg);
+    return 2;
+}
+
+int CPU::exec_brk() {
+    op_brk();
+    return 7;
+}
+
+int CPU::exec_jmp_absolute() {
+    op_jmp(addr_absolute());
+    return 3;
+}
+
+int CPU::exec_jmp_indirect() {
+    op_jmp(addr_indirect());
+    return 5;
+}
+
+int CPU::exec_jsr() {
+    op_jsr(addr_absolute());
+    return 6;
+}
+
+int CPU::exec_rti() {
+    op_rti();
+    return 6;
+}
+
+int CPU::exec_rts() {
+    op_rts();
+    return 6;
+}
+
+int CPU::exec_pha() {
+    // 3 cycles: fetch, internal, push
+    tick_internal();
+    push(m_a);
+    return 3;
+}
+
+int CPU::exec_php() {
+    // 3 cycles: fetch, internal, push
+    tick_internal();
+    push(m_status | FLAG_B | FLAG_U);
+    return 3;
+}
+
+int CPU::exec_pla() {
+    // 4 cycles: fetch, internal, dummy read, pop
+    tick_internal();
+    tick_internal();
+    m_a = pop();
+    update_zero_negative(m_a);
+    return 4;
+}
+
+int CPU::exec_plp() {
+    // 4 cycles: fetch, internal, dummy read, pop
+    tick_internal();
+    tick_internal();
+    m_status = (pop() & ~FLAG_B) | FLAG_U;
+    return 4;
+}
+
+int CPU::exec_nop() {
+    tick_internal();
+    return 2;
+}
+
+int CPU::exec_jam() {
+    // KIL/JAM opcodes halt the CPU on real hardware
+    // We treat them (and any unknown opcode) as 2-cycle NOPs to avoid infinite loops
+    return 2;
+}
+
+int CPU::exec_shy() {
+    // SHY - Store Y AND (high byte + 1) absolute,X (unstable)
+    uint8_t lo = read(m_pc++);
+    uint8_t hi = read(m_pc++);
+    store_unstable(lo, hi, m_x, m_y & (hi + 1));
+    return 5;
+}
+
+int CPU::exec_shx() {
+    // SHX - Store X AND (high byte + 1) absolute,Y (unstable)
+    uint8_t lo = read(m_pc++);
+    uint8_t hi = read(m_pc++);
+    store_unstable(lo, hi, m_y, m_x & (hi + 1));
+    return 5;
+}
+
+int CPU::exec_sha_absolute_y() {
+    // SHA/AHX - Store A AND X AND (high byte + 1) absolute,Y (unstable)
+    uint8_t lo = read(m_pc++);
+    uint8_t hi = read(m_pc++);
+    store_unstable(lo, hi, m_y, m_a & m_x & (hi + 1));
+    return 5;
+}
+
+int CPU::exec_sha_indirect_y() {
+    // SHA/AHX - Store A AND X AND (high byte + 1) (indirect),Y (unstable)
+    uint8_t ptr = read(m_pc++);
+    uint8_t lo = read(ptr);
+    uint8_t hi = read((ptr + 1) & 0xFF);
+    store_unstable(lo, hi, m_y, m_a & m_x & (hi + 1));
+    return 6;
+}
+
+int CPU::exec_tas() {
+    // TAS/SHS - Transfer A AND X to SP, then store A AND X AND (high byte + 1) (unstable)
+    uint8_t lo = read(m_pc++);
+    uint8_t hi = read(m_pc++);
+    m_sp = m_a & m_x;
+    store_unstable(lo, hi, m_y, m_a & m_x & (hi + 1));
+    return 5;
+}
+
+// Opcode dispatch table, built at compile time
+constexpr CPU::OpTable CPU::build_op_table() {
+    using M = AddrMode;
+    OpTable t{};
+
+    // Unknown/remaining opcodes - treat as NOP
+    for (auto& handler : t) {
+        handler = &CPU::exec_jam;
+    }
+
+    // ADC - Add with Carry
+    t[0x69] = &CPU::exec_read<M::Immediate, &CPU::op_adc>;
+    t[0x65] = &CPU::exec_read<M::ZeroPage, &CPU::op_adc>;
+    t[0x75] = &CPU::exec_read<M::ZeroPageX, &CPU::op_adc>;
+    t[0x6D] = &CPU::exec_read<M::Absolute, &CPU::op_adc>;
+    t[0x7D] = &CPU::exec_read<M::AbsoluteX, &CPU::op_adc>;
+    t[0x79] = &CPU::exec_read<M::AbsoluteY, &CPU::op_adc>;
+    t[0x61] = &CPU::exec_read<M::IndirectX, &CPU::op_adc>;
+    t[0x71] = &CPU::exec_read<M::IndirectY, &CPU::op_adc>;
+
+    // AND - Logical AND
+    t[0x29] = &CPU::exec_read<M::Immediate, &CPU::op_and>;
+    t[0x25] = &CPU::exec_read<M::ZeroPage, &CPU::op_and>;
+    t[0x35] = &CPU::exec_read<M::ZeroPageX, &CPU::op_and>;
+    t[0x2D] = &CPU::exec_read<M::Absolute, &CPU::op_and>;
+    t[0x3D] = &CPU::exec_read<M::AbsoluteX, &CPU::op_and>;
+    t[0x39] = &CPU::exec_read<M::AbsoluteY, &CPU::op_and>;
+    t[0x21] = &CPU::exec_read<M::IndirectX, &CPU::op_and>;
+    t[0x31] = &CPU::exec_read<M::IndirectY, &CPU::op_and>;
+
+    // ASL - Arithmetic Shift Left
+    t[0x0A] = &CPU::exec_accumulator<&CPU::op_asl>;
+    t[0x06] = &CPU::exec_rmw<M::ZeroPage, &CPU::op_asl, &CPU::update_zero_negative>;
+    t[0x16] = &CPU::exec_rmw<M::ZeroPageX, &CPU::op_asl, &CPU::update_zero_negative>;
+    t[0x0E] = &CPU::exec_rmw<M::Absolute, &CPU::op_asl, &CPU::update_zero_negative>;
+    t[0x1E] = &CPU::exec_rmw<M::AbsoluteX, &CPU::op_asl, &CPU::update_zero_negative>;
+
+    // Branches
+    t[0x90] = &CPU::exec_branch<FLAG_C, false>;  // BCC
+    t[0xB0] = &CPU::exec_branch<FLAG_C, true>;   // BCS
+    t[0xF0] = &CPU::exec_branch<FLAG_Z, true>;   // BEQ
+    t[0x30] = &CPU::exec_branch<FLAG_N, true>;   // BMI
+    t[0xD0] = &CPU::exec_branch<FLAG_Z, false>;  // BNE
+    t[0x10] = &CPU::exec_branch<FLAG_N, false>;  // BPL
+    t[0x50] = &CPU::exec_branch<FLAG_V, false>;  // BVC
+    t[0x70] = &CPU::exec_branch<FLAG_V, true>;   // BVS
+
+    // BIT - Bit Test
+    t[0x24] = &CPU::exec_read<M::ZeroPage, &CPU::op_bit>;
+    t[0x2C] = &CPU::exec_read<M::Absolute, &CPU::op_bit>;
+
+    // BRK - Break
+    t[0x00] = &CPU::exec_brk;
+
+    // Flag instructions
+    t[0x18] = &CPU::exec_set_flag<FLAG_C, false>;  // CLC
+    t[0xD8] = &CPU::exec_set_flag<FLAG_D, false>;  // CLD
+    t[0x58] = &CPU::exec_set_flag<FLAG_I, false>;  // CLI
+    t[0xB8] = &CPU::exec_set_flag<FLAG_V, false>;  // CLV
+    t[0x38] = &CPU::exec_set_flag<FLAG_C, true>;   // SEC
+    t[0xF8] = &CPU::exec_set_flag<FLAG_D, true>;   // SED
+    t[0x78] = &CPU::exec_set_flag<FLAG_I, true>;   // SEI
+
+    // CMP - Compare Accumulator
+    t[0xC9] = &CPU::exec_read<M::Immediate, &CPU::op_cmp>;
+    t[0xC5] = &CPU::exec_read<M::ZeroPage, &CPU::op_cmp>;
+    t[0xD5] = &CPU::exec_read<M::ZeroPageX, &CPU::op_cmp>;
+    t[0xCD] = &CPU::exec_read<M::Absolute, &CPU::op_cmp>;
+    t[0xDD] = &CPU::exec_read<M::AbsoluteX, &CPU::op_cmp>;
+    t[0xD9] = &CPU::exec_read<M::AbsoluteY, &CPU::op_cmp>;
+    t[0xC1] = &CPU::exec_read<M::IndirectX, &CPU::op_cmp>;
+    t[0xD1] = &CPU::exec_read<M::IndirectY, &CPU::op_cmp>;
+
+    // CPX - Compare X Register
+    t[0xE0] = &CPU::exec_read<M::Immediate, &CPU::op_cpx>;
+    t[0xE4] = &CPU::exec_read<M::ZeroPage, &CPU::op_cpx>;
+    t[0xEC] = &CPU::exec_read<M::Absolute, &CPU::op_cpx>;
+
+    // CPY - Compare Y Register
+    t[0xC0] = &CPU::exec_read<M::Immediate, &CPU::op_cpy>;
+    t[0xC4] = &CPU::exec_read<M::ZeroPage, &CPU::op_cpy>;
+    t[0xCC] = &CPU::exec_read<M::Absolute, &CPU::op_cpy>;
+
+    // DEC - Decrement Memory
+    t[0xC6] = &CPU::exec_rmw<M::ZeroPage, &CPU::op_dec, &CPU::update_zero_negative>;
+    t[0xD6] = &CPU::exec_rmw<M::ZeroPageX, &CPU::op_dec, &CPU::update_zero_negative>;
+    t[0xCE] = &CPU::exec_rmw<M::Absolute, &CPU::op_dec, &CPU::update_zero_negative>;
+    t[0xDE] = &CPU::exec_rmw<M::AbsoluteX, &CPU::op_dec, &CPU::update_zero_negative>;
+
+    // DEX, DEY, INX, INY - Decrement/Increment index registers
+    t[0xCA] = &CPU::exec_increment<&CPU::m_x, -1>;
+    t[0x88] = &CPU::exec_increment<&CPU::m_y, -1>;
+    t[0xE8] = &CPU::exec_increment<&CPU::m_x, 1>;
+    t[0xC8] = &CPU::exec_increment<&CPU::m_y, 1>;
+
+    // EOR - Exclusive OR
+    t[0x49] = &CPU::exec_read<M::Immediate, &CPU::op_eor>;
+    t[0x45] = &CPU::exec_read<M::ZeroPage, &CPU::op_eor>;
+    t[0x55] = &CPU::exec_read<M::ZeroPageX, &CPU::op_eor>;
+    t[0x4D] = &CPU::exec_read<M::Absolute, &CPU::op_eor>;
+    t[0x5D] = &CPU::exec_read<M::AbsoluteX, &CPU::op_eor>;
+    t[0x59] = &CPU::exec_read<M::AbsoluteY, &CPU::op_eor>;
+    t[0x41] = &CPU::exec_read<M::IndirectX, &CPU::op_eor>;
+    t[0x51] = &CPU::exec_read<M::IndirectY, &CPU::op_eor>;
+
+    // INC - Increment Memory
+    t[0xE6] = &CPU::exec_rmw<M::ZeroPage, &CPU::op_inc, &CPU::update_zero_negative>;
+    t[0xF6] = &CPU::exec_rmw<M::ZeroPageX, &CPU::op_inc, &CPU::update_zero_negative>;
+    t[0xEE] = &CPU::exec_rmw<M::Absolute, &CPU::op_inc, &CPU::update_zero_negative>;
+    t[0xFE] = &CPU::exec_rmw<M::AbsoluteX, &CPU::op_inc, &CPU::update_zero_negative>;
+
+    // JMP - Jump
+    t[0x4C] = &CPU::exec_jmp_absolute;
+    t[0x6C] = &CPU::exec_jmp_indirect;
+
+    // JSR - Jump to Subroutine
+    t[0x20] = &CPU::exec_jsr;
+
+    // LDA - Load Accumulator
+    t[0xA9] = &CPU::exec_read<M::Immediate, &CPU::op_lda>;
+    t[0xA5] = &CPU::exec_read<M::ZeroPage, &CPU::op_lda>;
+    t[0xB5] = &CPU::exec_read<M::ZeroPageX, &CPU::op_lda>;
+    t[0xAD] = &CPU::exec_read<M::Absolute, &CPU::op_lda>;
+    t[0xBD] = &CPU::exec_read<M::AbsoluteX, &CPU::op_lda>;
+    t[0xB9] = &CPU::exec_read<M::AbsoluteY, &CPU::op_lda>;
+    t[0xA1] = &CPU::exec_read<M::IndirectX, &CPU::op_lda>;
+    t[0xB1] = &CPU::exec_read<M::IndirectY, &CPU::op_lda>;
+
+    // LDX - Load X Register
+    t[0xA2] = &CPU::exec_read<M::Immediate, &CPU::op_ldx>;
+    t[0xA6] = &CPU::exec_read<M::ZeroPage, &CPU::op_ldx>;
+    t[0xB6] = &CPU::exec_read<M::ZeroPageY, &CPU::op_ldx>;
+    t[0xAE] = &CPU::exec_read<M::Absolute, &CPU::op_ldx>;
+    t[0xBE] = &CPU::exec_read<M::AbsoluteY, &CPU::op_ldx>;
+
+    // LDY - Load Y Register
+    t[0xA0] = &CPU::exec_read<M::Immediate, &CPU::op_ldy>;
+    t[0xA4] = &CPU::exec_read<M::ZeroPage, &CPU::op_ldy>;
+    t[0xB4] = &CPU::exec_read<M::ZeroPageX, &CPU::op_ldy>;
+    t[0xAC] = &CPU::exec_read<M::Absolute, &CPU::op_ldy>;
+    t[0xBC] = &CPU::exec_read<M::AbsoluteX, &CPU::op_ldy>;
+
+    // LSR - Logical Shift Right
+    t[0x4A] = &CPU::exec_accumulator<&CPU::op_lsr>;
+    t[0x46] = &CPU::exec_rmw<M::ZeroPage, &CPU::op_lsr, &CPU::update_zero_negative>;
+    t[0x56] = &CPU::exec_rmw<M::ZeroPageX, &CPU::op_lsr, &CPU::update_zero_negative>;
+    t[0x4E] = &CPU::exec_rmw<M::Absolute, &CPU::op_lsr, &CPU::update_zero_negative>;
+    t[0x5E] = &CPU::exec_rmw<M::AbsoluteX, &CPU::op_lsr, &CPU::update_zero_negative>;
+
+    // NOP - No Operation
+    t[0xEA] = &CPU::exec_nop;
+
+    // ORA - Logical OR
+    t[0x09] = &CPU::exec_read<M::Immediate, &CPU::op_ora>;
+    t[0x05] = &CPU::exec_read<M::ZeroPage, &CPU::op_ora>;
+    t[0x15] = &CPU::exec_read<M::ZeroPageX, &CPU::op_ora>;
+    t[0x0D] = &CPU::exec_read<M::Absolute, &CPU::op_ora>;
+    t[0x1D] = &CPU::exec_read<M::AbsoluteX, &CPU::op_ora>;
+    t[0x19] = &CPU::exec_read<M::AbsoluteY, &CPU::op_ora>;
+    t[0x01] = &CPU::exec_read<M::IndirectX, &CPU::op_ora>;
+    t[0x11] = &CPU::exec_read<M::IndirectY, &CPU::op_ora>;
+
+    // Stack instructions
+    t[0x48] = &CPU::exec_pha;
+    t[0x08] = &CPU::exec_php;
+    t[0x68] = &CPU::exec_pla;
+    t[0x28] = &CPU::exec_plp;
+
+    // ROL - Rotate Left
+    t[0x2A] = &CPU::exec_accumulator<&CPU::op_rol>;
+    t[0x26] = &CPU::exec_rmw<M::ZeroPage, &CPU::op_rol, &CPU::update_zero_negative>;
+    t[0x36] = &CPU::exec_rmw<M::ZeroPageX, &CPU::op_rol, &CPU::update_zero_negative>;
+    t[0x2E] = &CPU::exec_rmw<M::Absolute, &CPU::op_rol, &CPU::update_zero_negative>;
+    t[0x3E] = &CPU::exec_rmw<M::AbsoluteX, &CPU::op_rol, &CPU::update_zero_negative>;
+
+    // ROR - Rotate Right
+    t[0x6A] = &CPU::exec_accumulator<&CPU::op_ror>;
+    t[0x66] = &CPU::exec_rmw<M::ZeroPage, &CPU::op_ror, &CPU::update_zero_negative>;
+    t[0x76] = &CPU::exec_rmw<M::ZeroPageX, &CPU::op_ror, &CPU::update_zero_negative>;
+    t[0x6E] = &CPU::exec_rmw<M::Absolute, &CPU::op_ror, &CPU::update_zero_negative>;
+    t[0x7E] = &CPU::exec_rmw<M::AbsoluteX, &CPU::op_ror, &CPU::update_zero_negative>;
+
+    // RTI, RTS - Return from Interrupt/Subroutine
+    t[0x40] = &CPU::exec_rti;
+    t[0x60] = &CPU::exec_rts;
+
+    // SBC - Subtract with Carry
+    t[0xE9] = &CPU::exec_read<M::Immediate, &CPU::op_sbc>;
+    t[0xE5] = &CPU::exec_read<M::ZeroPage, &CPU::op_sbc>;
+    t[0xF5] = &CPU::exec_read<M::ZeroPageX, &CPU::op_sbc>;
+    t[0xED] = &CPU::exec_read<M::Absolute, &CPU::op_sbc>;
+    t[0xFD] = &CPU::exec_read<M::AbsoluteX, &CPU::op_sbc>;
+    t[0xF9] = &CPU::exec_read<M::AbsoluteY, &CPU::op_sbc>;
+    t[0xE1] = &CPU::exec_read<M::IndirectX, &CPU::op_sbc>;
+    t[0xF1] = &CPU::exec_read<M::IndirectY, &CPU::op_sbc>;
+
+    // STA - Store Accumulator
+    t[0x85] = &CPU::exec_store<M::ZeroPage, &CPU::op_sta>;
+    t[0x95] = &CPU::exec_store<M::ZeroPageX, &CPU::op_sta>;
+    t[0x8D] = &CPU::exec_store<M::Absolute, &CPU::op_sta>;
+    t[0x9D] = &CPU::exec_store<M::AbsoluteX, &CPU::op_sta>;
+    t[0x99] = &CPU::exec_store<M::AbsoluteY, &CPU::op_sta>;
+    t[0x81] = &CPU::exec_store<M::IndirectX, &CPU::op_sta>;
+    t[0x91] = &CPU::exec_store<M::IndirectY, &CPU::op_sta>;
+
+    // STX - Store X Register
+    t[0x86] = &CPU::exec_store<M::ZeroPage, &CPU::op_stx>;
+    t[0x96] = &CPU::exec_store<M::ZeroPageY, &CPU::op_stx>;
+    t[0x8E] = &CPU::exec_store<M::Absolute, &CPU::op_stx>;
+
+    // STY - Store Y Register
+    t[0x84] = &CPU::exec_store<M::ZeroPage, &CPU::op_sty>;
+    t[0x94] = &CPU::exec_store<M::ZeroPageX, &CPU::op_sty>;
+    t[0x8C] = &CPU::exec_store<M::Absolute, &CPU::op_sty>;
+
+    // Register transfers
+    t[0xAA] = &CPU::exec_transfer<&CPU::m_a, &CPU::m_x>;          // TAX
+    t[0xA8] = &CPU::exec_transfer<&CPU::m_a, &CPU::m_y>;          // TAY
+    t[0xBA] = &CPU::exec_transfer<&CPU::m_sp, &CPU::m_x>;         // TSX
+    t[0x8A] = &CPU::exec_transfer<&CPU::m_x, &CPU::m_a>;          // TXA
+    t[0x9A] = &CPU::exec_transfer<&CPU::m_x, &CPU::m_sp, false>;  // TXS (no flags)
+    t[0x98] = &CPU::exec_transfer<&CPU::m_y, &CPU::m_a>;          // TYA
+
+    // ============== Unofficial/Illegal Opcodes ==============
+
+    // LAX - Load A and X with same value
+    t[0xA7] = &CPU::exec_read<M::ZeroPage, &CPU::op_lax>;
+    t[0xB7] = &CPU::exec_read<M::ZeroPageY, &CPU::op_lax>;
+    t[0xAF] = &CPU::exec_read<M::Absolute, &CPU::op_lax>;
+    t[0xBF] = &CPU::exec_read<M::AbsoluteY, &CPU::op_lax>;
+    t[0xA3] = &CPU::exec_read<M::IndirectX, &CPU::op_lax>;
+    t[0xB3] = &CPU::exec_read<M::IndirectY, &CPU::op_lax>;
+
+    // SAX - Store A AND X
+    t[0x87] = &CPU::exec_store<M::ZeroPage, &CPU::op_sax>;
+    t[0x97] = &CPU::exec_store<M::ZeroPageY, &CPU::op_sax>;
+    t[0x8F] = &CPU::exec_store<M::Absolute, &CPU::op_sax>;
+    t[0x83] = &CPU::exec_store<M::IndirectX, &CPU::op_sax>;
+
+    // DCP - Decrement memory then Compare with A
+    t[0xC7] = &CPU::exec_rmw<M::ZeroPage, &CPU::op_dec, &CPU::op_cmp>;
+    t[0xD7] = &CPU::exec_rmw<M::ZeroPageX, &CPU::op_dec, &CPU::op_cmp>;
+    t[0xCF] = &CPU::exec_rmw<M::Absolute, &CPU::op_dec, &CPU::op_cmp>;
+    t[0xDF] = &CPU::exec_rmw<M::AbsoluteX, &CPU::op_dec, &CPU::op_cmp>;
+    t[0xDB] = &CPU::exec_rmw<M::AbsoluteY, &CPU::op_dec, &CPU::op_cmp>;
+    t[0xC3] = &CPU::exec_rmw<M::IndirectX, &CPU::op_dec, &CPU::op_cmp>;
+    t[0xD3] = &CPU::exec_rmw<M::IndirectY, &CPU::op_dec, &CPU::op_cmp>;
+
+    // ISB/ISC - Increment memory then Subtract from A
+    t[0xE7] = &CPU::exec_rmw<M::ZeroPage, &CPU::op_inc, &CPU::op_sbc>;
+    t[0xF7] = &CPU::exec_rmw<M::ZeroPageX, &CPU::op_inc, &CPU::op_sbc>;
+    t[0xEF] = &CPU::exec_rmw<M::Absolute, &CPU::op_inc, &CPU::op_sbc>;
+    t[0xFF] = &CPU::exec_rmw<M::AbsoluteX, &CPU::op_inc, &CPU::op_sbc>;
+    t[0xFB] = &CPU::exec_rmw<M::AbsoluteY, &CPU::op_inc, &CPU::op_sbc>;
+    t[0xE3] = &CPU::exec_rmw<M::IndirectX, &CPU::op_inc, &CPU::op_sbc>;
+    t[0xF3] = &CPU::exec_rmw<M::IndirectY, &CPU::op_inc, &CPU::op_sbc>;
+
+    // SLO - Shift Left then OR with A
+    t[0x07] = &CPU::exec_rmw<M::ZeroPage, &CPU::op_asl, &CPU::op_ora>;
+    t[0x17] = &CPU::exec_rmw<M::ZeroPageX, &CPU::op_asl, &CPU::op_ora>;
+    t[0x0F] = &CPU::exec_rmw<M::Absolute, &CPU::op_asl, &CPU::op_ora>;
+    t[0x1F] = &CPU::exec_rmw<M::AbsoluteX, &CPU::op_asl, &CPU::op_ora>;
+    t[0x1B] = &CPU::exec_rmw<M::AbsoluteY, &CPU::op_asl, &CPU::op_ora>;
+    t[0x03] = &CPU::exec_rmw<M::IndirectX, &CPU::op_asl, &CPU::op_ora>;
+    t[0x13] = &CPU::exec_rmw<M::IndirectY, &CPU::op_asl, &CPU::op_ora>;
+
+    // RLA - Rotate Left then AND with A
+    t[0x27] = &CPU::exec_rmw<M::ZeroPage, &CPU::op_rol, &CPU::op_and>;
+    t[0x37] = &CPU::exec_rmw<M::ZeroPageX, &CPU::op_rol, &CPU::op_and>;
+    t[0x2F] = &CPU::exec_rmw<M::Absolute, &CPU::op_rol, &CPU::op_and>;
+    t[0x3F] = &CPU::exec_rmw<M::AbsoluteX, &CPU::op_rol, &CPU::op_and>;
+    t[0x3B] = &CPU::exec_rmw<M::AbsoluteY, &CPU::op_rol, &CPU::op_and>;
+    t[0x23] = &CPU::exec_rmw<M::IndirectX, &CPU::op_rol, &CPU::op_and>;
+    t[0x33] = &CPU::exec_rmw<M::IndirectY, &CPU::op_rol, &CPU::op_and>;
+
+    // SRE - Shift Right then XOR with A
+    t[0x47] = &CPU::exec_rmw<M::ZeroPage, &CPU::op_lsr, &CPU::op_eor>;
+    t[0x57] = &CPU::exec_rmw<M::ZeroPageX, &CPU::op_lsr, &CPU::op_eor>;
+    t[0x4F] = &CPU::exec_rmw<M::Absolute, &CPU::op_lsr, &CPU::op_eor>;
+    t[0x5F] = &CPU::exec_rmw<M::AbsoluteX, &CPU::op_lsr, &CPU::op_eor>;
+    t[0x5B] = &CPU::exec_rmw<M::AbsoluteY, &CPU::op_lsr, &CPU::op_eor>;
+    t[0x43] = &CPU::exec_rmw<M::IndirectX, &CPU::op_lsr, &CPU::op_eor>;
+    t[0x53] = &CPU::exec_rmw<M::IndirectY, &CPU::op_lsr, &CPU::op_eor>;
+
+    // RRA - Rotate Right then Add with carry
+    t[0x67] = &CPU::exec_rmw<M::ZeroPage, &CPU::op_ror, &CPU::op_adc>;
+    t[0x77] = &CPU::exec_rmw<M::ZeroPageX, &CPU::op_ror, &CPU::op_adc>;
+    t[0x6F] = &CPU::exec_rmw<M::Absolute, &CPU::op_ror, &CPU::op_adc>;
+    t[0x7F] = &CPU::exec_rmw<M::AbsoluteX, &CPU::op_ror, &CPU::op_adc>;
+    t[0x7B] = &CPU::exec_rmw<M::AbsoluteY, &CPU::op_ror, &CPU::op_adc>;
+    t[0x63] = &CPU::exec_rmw<M::IndirectX, &CPU::op_ror, &CPU::op_adc>;
+    t[0x73] = &CPU::exec_rmw<M::IndirectY, &CPU::op_ror, &CPU::op_adc>;
+
+    // Immediate-only unofficial opcodes
+    t[0x0B] = &CPU::exec_read<M::Immediate, &CPU::op_anc>;  // ANC
+    t[0x2B] = &CPU::exec_read<M::Immediate, &CPU::op_anc>;  // ANC
+    t[0x4B] = &CPU::exec_read<M::Immediate, &CPU::op_alr>;  // ALR/ASR
+    t[0x6B] = &CPU::exec_read<M::Immediate, &CPU::op_arr>;  // ARR
+    t[0xCB] = &CPU::exec_read<M::Immediate, &CPU::op_sbx>;  // SBX/AXS
+    t[0xEB] = &CPU::exec_read<M::Immediate, &CPU::op_sbc>;  // SBC (duplicate of 0xE9)
+    t[0xAB] = &CPU::exec_read<M::Immediate, &CPU::op_lxa>;  // LAX immediate
+    t[0x8B] = &CPU::exec_read<M::Immediate, &CPU::op_xaa>;  // XAA/ANE
+
+    // Unofficial NOPs (various addressing modes)
+    // These actually perform the addressing mode reads but discard the result
+    for (uint8_t op : {0x1A, 0x3A, 0x5A, 0x7A, 0xDA, 0xFA}) {
+        t[op] = &CPU::exec_nop;
+    }
+    for (uint8_t op : {0x80, 0x82, 0x89, 0xC2, 0xE2}) {
+        t[op] = &CPU::exec_read<M::Immediate, &CPU::op_nop>;
+    }
+    for (uint8_t op : {0x04, 0x44, 0x64}) {
+        t[op] = &CPU::exec_read<M::ZeroPage, &CPU::op_nop>;
+    }
+    for (uint8_t op : {0x14, 0x34, 0x54, 0x74, 0xD4, 0xF4}) {
+        t[op] = &CPU::exec_read<M::ZeroPageX, &CPU::op_nop>;
+    }
+    t[0x0C] = &CPU::exec_read<M::Absolute, &CPU::op_nop>;
+    for (uint8_t op : {0x1C, 0x3C, 0x5C, 0x7C, 0xDC, 0xFC}) {
+        t[op] = &CPU::exec_read<M::AbsoluteX, &CPU::op_nop>;
+    }
+
+    // Unstable high-byte stores
+    t[0x9C] = &CPU::exec_shy;
+    t[0x9E] = &CPU::exec_shx;
+    t[0x9F] = &CPU::exec_sha_absolute_y;
+    t[0x93] = &CPU::exec_sha_indirect_y;
+    t[0x9B] = &CPU::exec_tas;
+
+    // LAS - Load A, X, and SP with (SP AND memory)
+    t[0xBB] = &CPU::exec_read<M::AbsoluteY, &CPU::op_las>;
+
+    // KIL/JAM opcodes (0x02, 0x12, ... 0xF2) keep the default exec_jam handler
+
+    return t;
+}
+
+const CPU::OpTable CPU::s_op_table = CPU::build_op_table();
+
 // Save state serialization helpers
 namespace {
     template<typename T>
-    void write_value(std::vector<uint8_t>& data, T value) {
-        const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&value);
-        data.insert(data.end(), ptr, ptr + sizeof(T));
+    void write_value(StateWriter& data, T value) {
+        data.write(&value, sizeof(T));
     }
 
     template<typename T>
@@ -1024,7 +1210,7 @@ namespace {
     }
 }
 
-void CPU::save_state(std::vector<uint8_t>& data) {
+void CPU::save_state(StateWriter& data) {
     write_value(data, m_pc);
     write_value(data, m_a);
     write_value(data, m_x);
@@ -1,11 +1,17 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <vector>
 
+#include "emu/breakpoints.hpp"
+#include "emu/cpu_trace.hpp"
+#include "emu/state_writer.hpp"
+
 namespace nes {
 
 class Bus;
+using emu::StateWriter;
 
 // 6502 CPU emulator (cycle-accurate)
 // Memory accesses tick PPU/APU through the Bus
@@ -26,7 +32,7 @@ public:
     void trigger_nmi();
     void trigger_nmi_delayed();  // NMI will fire after NEXT instruction
     void trigger_irq();  // Edge-triggered (BRK, etc.)
-    void set_irq_line(bool active);  // Level-triggered (mapper IRQ)
+    void set_irq_line(bool active) { m_irq_pending = active; }  // Level-triggered (mapper IRQ)
     void set_nmi_line(bool active);  // NMI line state for edge detection
 
     // Check if NMI is pending (for cycle-accurate detection)
@@ -41,7 +47,7 @@ public:
     bool detect_nmi_edge();
 
     // Save state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
 
     // Register access (for debugging)
@@ -52,6 +58,12 @@ public:
     uint8_t get_sp() const { return m_sp; }
     uint8_t get_status() const { return m_status; }
 
+    // Record every instruction into trace while set (see emu/cpu_trace.hpp)
+    void set_trace(emu::CpuTrace* trace) { m_trace = trace; }
+
+    // Execute breakpoints checked at each instruction, or nullptr for none
+    void set_breakpoints(emu::Breakpoints* breakpoints) { m_breakpoints = breakpoints; }
+
 private:
     // Memory access (these tick PPU/APU via the bus)
     uint8_t read(uint16_t address);
@@ -80,35 +92,56 @@ private:
     uint16_t addr_indirect_x();
     uint16_t addr_indirect_y(bool& page_crossed, bool is_write = false);
 
+    // Addressing mode selector for the templated opcode handlers
+    enum class AddrMode : uint8_t {
+        Immediate,
+        ZeroPage,
+        ZeroPageX,
+        ZeroPageY,
+        Absolute,
+        AbsoluteX,
+        AbsoluteY,
+        IndirectX,
+        IndirectY
+    };
+
+    // Resolve the effective address for an addressing mode at compile time
+    template<AddrMode Mode, bool IsWrite>
+    uint16_t resolve_address(bool& page_crossed);
+
     // Flag operations
     void set_flag(uint8_t flag, bool value);
     bool get_flag(uint8_t flag) const;
     void update_zero_negative(uint8_t value);
 
     // Instructions
+    // Read operations take the fetched operand, RMW operations take the
+    // original value and return the modified one (setting carry as needed)
     void op_adc(uint8_t value);
     void op_and(uint8_t value);
-    void op_asl(uint16_t address);
-    void op_asl_a();
+    uint8_t op_asl(uint8_t value);
     void op_bit(uint8_t value);
-    void op_branch(bool condition);  // Handles its own internal cycles
+    // Handles its own internal cycles; returns the taken-branch cycles plus
+    // any run by skip_status_poll()
+    int op_branch(bool condition);
     void op_brk();
-    void op_cmp(uint8_t reg, uint8_t value);
-    void op_dec(uint16_t address);
+    void op_cmp(uint8_t value);
+    void op_cpx(uint8_t value);
+    void op_cpy(uint8_t value);
+    void compare(uint8_t reg, uint8_t value);
+    uint8_t op_dec(uint8_t value);
     void op_eor(uint8_t value);
-    void op_inc(uint16_t address);
+    uint8_t op_inc(uint8_t value);
     void op_jmp(uint16_t address);
     void op_jsr(uint16_t address);
     void op_lda(uint8_t value);
     void op_ldx(uint8_t value);
     void op_ldy(uint8_t value);
-    void op_lsr(uint16_t address);
-    void op_lsr_a();
+    uint8_t op_lsr(uint8_t value);
+    void op_nop(uint8_t value);
     void op_ora(uint8_t value);
-    void op_rol(uint16_t address);
-    void op_rol_a();
-    void op_ror(uint16_t address);
-    void op_ror_a();
+    uint8_t op_rol(uint8_t value);
+    uint8_t op_ror(uint8_t value);
     void op_rti();
     void op_rts();
     void op_sbc(uint8_t value);
@@ -116,6 +149,63 @@ private:
     void op_stx(uint16_t address);
     void op_sty(uint16_t address);
 
+    // Unofficial instructions
+    void op_alr(uint8_t value);
+    void op_anc(uint8_t value);
+    void op_arr(uint8_t value);
+    void op_las(uint8_t value);
+    void op_lax(uint8_t value);
+    void op_lxa(uint8_t value);
+    void op_sax(uint16_t address);
+    void op_sbx(uint8_t value);
+    void op_xaa(uint8_t value);
+    void store_unstable(uint8_t lo, uint8_t hi, uint8_t index, uint8_t value);
+
+    // Opcode handlers - each executes one full instruction after the opcode
+    // fetch and returns its cycle count. The templates are instantiated per
+    // addressing mode / operation so every opcode gets its own straight-line
+    // function and step() dispatches through s_op_table instead of a switch.
+    using OpHandler = int (CPU::*)();
+    using OpTable = std::array<OpHandler, 256>;
+
+    template<AddrMode Mode, void (CPU::*Op)(uint8_t)>
+    int exec_read();
+    template<AddrMode Mode, void (CPU::*Op)(uint16_t)>
+    int exec_store();
+    template<AddrMode Mode, uint8_t (CPU::*Modify)(uint8_t), void (CPU::*Result)(uint8_t)>
+    int exec_rmw();
+    template<uint8_t (CPU::*Modify)(uint8_t)>
+    int exec_accumulator();
+    template<uint8_t Flag, bool Value>
+    int exec_branch();
+    template<uint8_t Flag, bool Value>
+    int exec_set_flag();
+    template<uint8_t CPU::*Src, uint8_t CPU::*Dst, bool SetFlags = true>
+    int exec_transfer();
+    template<uint8_t CPU::*Reg, int Delta>
+    int exec_increment();
+
+    int exec_brk();
+    int exec_jmp_absolute();
+    int exec_jmp_indirect();
+    int exec_jsr();
+    int exec_rti();
+    int exec_rts();
+    int exec_pha();
+    int exec_php();
+    int exec_pla();
+    int exec_plp();
+    int exec_nop();
+    int exec_jam();
+    int exec_shy();
+    int exec_shx();
+    int exec_sha_absolute_y();
+    int exec_sha_indirect_y();
+    int exec_tas();
+
+    static constexpr OpTable build_op_table();
+    static const OpTable s_op_table;
+
     // Bus reference
     Bus& m_bus;
 
@@ -146,9 +236,20 @@ private:
     // Track if we're currently in an interrupt sequence
     bool m_in_interrupt_sequence = false;
 
+    // Called after a branch back to m_pc over 'length' bytes. A loop that
+    // only reads PPUSTATUS and branches on it is ticked through, pass by
+    // pass, for as long as the bits it tests can't change (see
+    // Bus::run_status_poll()); registers keep their values from the last
+    // real pass. Returns the cycles skipped, 0 if the loop isn't one.
+    int skip_status_poll(int length);
+
     // Cycle counter (for statistics)
     int m_cycles = 0;
 
+    emu::CpuTrace* m_trace = nullptr;
+    void trace_instruction(uint8_t opcode);
+    emu::Breakpoints* m_breakpoints = nullptr;
+
     // Status register flags
     static constexpr uint8_t FLAG_C = 0x01;  // Carry
     static constexpr uint8_t FLAG_Z = 0x02;  // Zero
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace nes {
+
+// Output of a cartridge audio chip over one Mapper::cpu_cycles() batch
+//
+// The chip reports its level whenever it may have changed, stamped with
+// the CPU cycles into the batch it happened at; only actual changes are
+// kept. After the batch the bus hands the steps to the APU, which puts them
+// into its band-limited mix at their cycle, so the chip renders a batch at
+// a time instead of being polled after every instruction.
+class ExpansionAudio {
+public:
+    struct Step {
+        uint32_t cycle;     // CPU cycles into the batch, 0 to its length
+        float level;        // -1.0 to 1.0
+    };
+
+    ExpansionAudio() { m_steps.reserve(256); }
+
+    void set(uint32_t cycle, float level) {
+        if (level == m_level) return;
+        m_level = level;
+        m_steps.push_back({cycle, level});
+    }
+
+    float get_level() const { return m_level; }
+
+    const std::vector<Step>& get_steps() const { return m_steps; }
+    void clear_steps() { m_steps.clear(); }
+
+private:
+    float m_level = 0.0f;
+    std::vector<Step> m_steps;
+};
+
+} // namespace nes
@@ -1,10 +1,17 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <vector>
 
+#include "expansion_audio.hpp"
+#include "emu/state_writer.hpp"
+#include "state_hash.hpp"
+
 namespace nes {
 
+using emu::StateWriter;
+
 // Mirror modes for nametables
 enum class MirrorMode {
     Horizontal,
@@ -19,6 +26,19 @@ class Mapper {
 public:
     virtual ~Mapper() = default;
 
+    // Hooks the bus would otherwise call on every CPU cycle or PPU fetch.
+    // Each mapper declares the ones it overrides in its constructor, and
+    // Cartridge skips the rest without a virtual call.
+    enum Hook : uint32_t {
+        HOOK_CPU_CYCLES = 1 << 0,       // cpu_cycles()
+        HOOK_IRQ = 1 << 1,              // irq_pending()
+        HOOK_PPU_ADDRESS_BUS = 1 << 2,  // notify_ppu_address_bus()
+        HOOK_FRAME_START = 1 << 3,      // notify_frame_start()
+        HOOK_AUDIO = 1 << 4,            // cpu_cycles() sets get_expansion_audio()
+        HOOK_PPU_EVENTS = 1 << 5        // ppu_scanline_start(), ppu_frame_end(), ppu_tile_fetch()
+    };
+    uint32_t get_hooks() const { return m_hooks; }
+
     // CPU memory access ($4020-$FFFF)
     virtual uint8_t cpu_read(uint16_t address) = 0;
     virtual void cpu_write(uint16_t address, uint8_t value) = 0;
@@ -36,6 +56,12 @@ public:
     virtual bool irq_pending(uint32_t frame_cycle = 0) { return false; }
     virtual void irq_clear() {}
 
+    // The bus keeps irq_pending()'s answer until the next call into the
+    // mapper. True while the answer can change with nothing but time
+    // passing (a delay or counter measured from frame_cycle), so the bus
+    // asks again every cycle.
+    virtual bool irq_polled() const { return false; }
+
     // Scanline counter (for MMC3 and similar)
     virtual void scanline() {}
 
@@ -51,6 +77,34 @@ public:
     // Used by mappers like MMC3 to reset frame-relative timing state
     virtual void notify_frame_start() {}
 
+    // Rendering events (HOOK_PPU_EVENTS), for mappers that follow the
+    // picture by scanline and tile instead of watching the address bus.
+    // ppu_scanline_start() comes at dot 1 of each visible line while
+    // rendering is on; ppu_frame_end() when rendering leaves the visible
+    // lines, at the post-render line or on a visible line with rendering
+    // off (possibly more than once).
+    virtual void ppu_scanline_start(int scanline) { (void)scanline; }
+    virtual void ppu_frame_end() {}
+
+    // Background tile column (0-33) of a visible scanline about to be
+    // fetched; columns 0 and 1 are prefetched at the end of the line
+    // before. Returning true supplies the tile number and its 2-bit
+    // palette in place of the PPU's nametable and attribute bytes.
+    virtual bool ppu_tile_fetch(int scanline, int column, uint8_t& tile, uint8_t& palette) {
+        (void)scanline; (void)column; (void)tile; (void)palette;
+        return false;
+    }
+
+    // Whether a ppu_scanline_start() could raise the IRQ. While it does,
+    // catch-up PPU scheduling syncs the PPU at every line start, so the CPU
+    // sees the IRQ on the cycle it would with the PPU stepped every cycle.
+    virtual bool ppu_scanline_irq_armed() const { return false; }
+
+    // True if the mapper's IRQ depends on exact PPU timing (A12 edges,
+    // scanline detection, frame_cycle). When catch-up PPU scheduling is
+    // enabled, the bus keeps stepping the PPU every CPU cycle for these.
+    virtual bool needs_exact_ppu_timing() const { return false; }
+
     // CPU cycle notification (for mappers with IRQ counters or expansion audio)
     // PERFORMANCE: Receives cycle COUNT to allow batched processing instead of
     // being called once per cycle. Mappers should process all cycles at once.
@@ -59,14 +113,22 @@ public:
     // Legacy single-cycle interface (deprecated, kept for compatibility)
     virtual void cpu_cycle() {}
 
-    // Get expansion audio output (-1.0 to 1.0) for mappers with audio chips
-    virtual float get_audio_output() const { return 0.0f; }
+    // How many CPU cycles the bus may hold back before calling cpu_cycles():
+    // no more than it takes for a cycle-clocked IRQ to assert, given the
+    // current registers. The bus catches the mapper up anyway before any
+    // cartridge register access, expansion audio read and at frame end.
+    // UINT32_MAX when cpu_cycles() can't raise an IRQ at all.
+    virtual uint32_t cpu_cycles_until_irq() const { return 1; }
+
+    // Expansion audio for mappers with audio chips, which cpu_cycles()
+    // writes the chip's output into (see ExpansionAudio)
+    ExpansionAudio& get_expansion_audio() { return m_audio; }
 
     // Reset mapper state
     virtual void reset() {}
 
     // Save state
-    virtual void save_state(std::vector<uint8_t>& data) {}
+    virtual void save_state(StateWriter& data) {}
     virtual void load_state(const uint8_t*& data, size_t& remaining) {}
 
     // Battery-backed save data (for mappers with EEPROM or other save mechanisms)
@@ -80,12 +142,90 @@ public:
     // Set mapper-specific save data
     virtual bool set_mapper_save_data(const std::vector<uint8_t>& data) { (void)data; return false; }
 
+    // Bumped on every PRG RAM write and mapper save data write (see
+    // IEmulatorPlugin::get_battery_save_generation)
+    uint64_t get_save_generation() const { return m_save_generation; }
+    void touch_save_data() { m_save_generation++; }
+
+    // Direct CHR access for pattern fetches (1 KB pages)
+    // Returns the CHR memory backing `address`, or nullptr when the fetch
+    // has to go through ppu_read() (unmapped page, latches, ExRAM, CIRAM).
+    // Entries are offsets rather than pointers so CHR RAM reloads stay valid.
+    const uint8_t* chr_page(uint16_t address) const {
+        int32_t offset = m_chr_page_offset[(address >> 10) & 7];
+        return offset < 0 ? nullptr : m_chr_rom->data() + offset;
+    }
+
+    // Direct PRG ROM access for CPU reads ($8000-$FFFF, 1 KB pages)
+    // Bus::cpu_read() serves reads from non-null pages without calling
+    // cpu_read(); null pages (IO, RAM-backed or unmapped) take the slow path.
+    const uint8_t* const* prg_pages() const { return m_prg_pages.data(); }
+
+    // Dirty-page tracking for the incremental state hash (owned by Cartridge)
+    void set_page_tracking(PageHashCache* prg_ram_pages, PageHashCache* chr_ram_pages) {
+        m_prg_ram_pages = prg_ram_pages;
+        m_chr_ram_pages = chr_ram_pages;
+    }
+
 protected:
+    // PRG RAM / CHR RAM stores - mappers must write through these (rather
+    // than indexing the vectors directly) so the written page gets rehashed
+    void write_prg_ram(size_t offset, uint8_t value) {
+        (*m_prg_ram)[offset] = value;
+        if (m_prg_ram_pages) m_prg_ram_pages->mark_dirty(offset);
+        m_save_generation++;
+    }
+    void write_chr_ram(size_t offset, uint8_t value) {
+        (*m_chr_rom)[offset] = value;
+        if (m_chr_ram_pages) m_chr_ram_pages->mark_dirty(offset);
+    }
+
+    // Publish a CHR page for chr_page(). Mappers whose ppu_read() is a plain
+    // banked lookup call this wherever their CHR bank offsets change; a page
+    // that doesn't fit entirely inside CHR memory stays on the slow path.
+    void map_chr_page(int page, uint32_t offset) {
+        size_t size = m_chr_rom ? m_chr_rom->size() : 0;
+        m_chr_page_offset[page] = (static_cast<size_t>(offset) + 0x400 <= size)
+            ? static_cast<int32_t>(offset) : -1;
+    }
+
+    // Map `count` consecutive 1 KB pages starting at CHR offset `offset`
+    void map_chr_pages(int first, int count, uint32_t offset) {
+        for (int i = 0; i < count; i++) {
+            map_chr_page(first + i, offset + i * 0x400);
+        }
+    }
+
+    // Publish a PRG ROM page for prg_pages(). `page` is (address - $8000) / 1 KB.
+    // Mappers whose $8000-$FFFF reads are plain banked ROM call this wherever
+    // their PRG bank offsets change; pages past the end of PRG ROM stay null.
+    void map_prg_page(int page, uint32_t offset) {
+        size_t size = m_prg_rom ? m_prg_rom->size() : 0;
+        m_prg_pages[page] = (static_cast<size_t>(offset) + 0x400 <= size)
+            ? m_prg_rom->data() + offset : nullptr;
+    }
+
+    // Map `count` consecutive 1 KB pages starting at PRG offset `offset`
+    void map_prg_pages(int first, int count, uint32_t offset) {
+        for (int i = 0; i < count; i++) {
+            map_prg_page(first + i, offset + i * 0x400);
+        }
+    }
+
     std::vector<uint8_t>* m_prg_rom = nullptr;
     std::vector<uint8_t>* m_chr_rom = nullptr;
     std::vector<uint8_t>* m_prg_ram = nullptr;
     MirrorMode m_mirror_mode = MirrorMode::Horizontal;
     bool m_has_chr_ram = false;
+    uint32_t m_hooks = 0;   // Hook bits, set by the constructor
+    ExpansionAudio m_audio;
+    PageHashCache* m_prg_ram_pages = nullptr;
+    PageHashCache* m_chr_ram_pages = nullptr;
+
+private:
+    uint64_t m_save_generation = 0;
+    std::array<int32_t, 8> m_chr_page_offset{{-1, -1, -1, -1, -1, -1, -1, -1}};
+    std::array<const uint8_t*, 32> m_prg_pages{};
 };
 
 // Factory function to create mapper by number
@@ -18,6 +18,15 @@ Mapper000::Mapper000(std::vector<uint8_t>& prg_rom,
 
     // Check if we have 16KB or 32KB PRG ROM
     m_prg_16k = (prg_rom.size() <= 16384);
+    if (m_prg_16k) {
+        map_prg_pages(0, 16, 0);
+        map_prg_pages(16, 16, 0);
+    } else {
+        map_prg_pages(0, 32, 0);
+    }
+
+    // Unbanked 8KB CHR
+    map_chr_pages(0, 8, 0);
 }
 
 uint8_t Mapper000::cpu_read(uint16_t address) {
@@ -47,13 +56,12 @@ void Mapper000::cpu_write(uint16_t address, uint8_t value) {
     // PRG RAM: $6000-$7FFF
     if (address >= 0x6000 && address < 0x8000) {
         if (!m_prg_ram->empty()) {
-            (*m_prg_ram)[address & 0x1FFF] = value;
+            write_prg_ram(address & 0x1FFF, value);
             // Debug first few writes (only in debug mode)
             if (is_debug_mode()) {
-                static int write_count = 0;
-                if (write_count < 5) {
+                if (m_debug_prg_ram_writes < 5) {
                     fprintf(stderr, "PRG RAM write: $%04X = %02X\n", address, value);
-                    write_count++;
+                    m_debug_prg_ram_writes++;
                 }
             }
         }
@@ -75,7 +83,7 @@ void Mapper000::ppu_write(uint16_t address, uint8_t value) {
     // CHR RAM: $0000-$1FFF (only if using CHR RAM)
     if (address < 0x2000 && m_has_chr_ram) {
         if (!m_chr_rom->empty()) {
-            (*m_chr_rom)[address] = value;
+            write_chr_ram(address, value);
         }
     }
 }
@@ -26,6 +26,9 @@ public:
 
 private:
     bool m_prg_16k;  // True if only 16KB PRG ROM (needs mirroring)
+
+    // Debug output limits (DEBUG=1)
+    int m_debug_prg_ram_writes = 0;
 };
 
 } // namespace nes
@@ -63,7 +63,7 @@ void Mapper001::cpu_write(uint16_t address, uint8_t value) {
     // PRG RAM: $6000-$7FFF
     if (address >= 0x6000 && address < 0x8000) {
         if (!m_prg_ram->empty()) {
-            (*m_prg_ram)[address & 0x1FFF] = value;
+            write_prg_ram(address & 0x1FFF, value);
         }
         return;
     }
@@ -168,6 +168,8 @@ void Mapper001::update_banks() {
     // Ensure offsets are within bounds
     m_prg_bank_0_offset %= prg_size;
     m_prg_bank_1_offset %= prg_size;
+    map_prg_pages(0, 16, m_prg_bank_0_offset);
+    map_prg_pages(16, 16, m_prg_bank_1_offset);
 
     // CHR bank mode (bit 4 of control)
     if (chr_size > 0) {
@@ -183,6 +185,8 @@ void Mapper001::update_banks() {
                 m_chr_bank_1_offset = 0;
             }
         }
+        map_chr_pages(0, 4, m_chr_bank_0_offset);
+        map_chr_pages(4, 4, m_chr_bank_1_offset);
     }
 }
 
@@ -209,17 +213,17 @@ void Mapper001::ppu_write(uint16_t address, uint8_t value) {
     if (address < 0x1000) {
         uint32_t offset = m_chr_bank_0_offset + address;
         if (offset < m_chr_rom->size()) {
-            (*m_chr_rom)[offset] = value;
+            write_chr_ram(offset, value);
         }
     } else if (address < 0x2000) {
         uint32_t offset = m_chr_bank_1_offset + (address & 0x0FFF);
         if (offset < m_chr_rom->size()) {
-            (*m_chr_rom)[offset] = value;
+            write_chr_ram(offset, value);
         }
     }
 }
 
-void Mapper001::save_state(std::vector<uint8_t>& data) {
+void Mapper001::save_state(StateWriter& data) {
     data.push_back(m_shift_register);
     data.push_back(static_cast<uint8_t>(m_shift_count));
     data.push_back(m_control);
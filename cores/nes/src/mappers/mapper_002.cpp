@@ -17,13 +17,18 @@ Mapper002::Mapper002(std::vector<uint8_t>& prg_rom,
     m_has_chr_ram = has_chr_ram;
 
     reset();
+
+    // Unbanked 8KB CHR
+    map_chr_pages(0, 8, 0);
 }
 
 void Mapper002::reset() {
     m_prg_bank = 0;
     m_prg_bank_offset = 0;
+    map_prg_pages(0, 16, m_prg_bank_offset);
     // Last 16KB bank is fixed at $C000
     m_last_bank_offset = m_prg_rom->size() - 0x4000;
+    map_prg_pages(16, 16, m_last_bank_offset);
 }
 
 uint8_t Mapper002::cpu_read(uint16_t address) {
@@ -60,7 +65,7 @@ void Mapper002::cpu_write(uint16_t address, uint8_t value) {
     // PRG RAM: $6000-$7FFF
     if (address >= 0x6000 && address < 0x8000) {
         if (!m_prg_ram->empty()) {
-            (*m_prg_ram)[address & 0x1FFF] = value;
+            write_prg_ram(address & 0x1FFF, value);
         }
         return;
     }
@@ -69,6 +74,7 @@ void Mapper002::cpu_write(uint16_t address, uint8_t value) {
     if (address >= 0x8000) {
         m_prg_bank = value & 0x0F;  // Usually only 4 bits used
         m_prg_bank_offset = (m_prg_bank * 0x4000) % m_prg_rom->size();
+        map_prg_pages(0, 16, m_prg_bank_offset);
         if (is_debug_mode()) {
             fprintf(stderr, "UxROM: PRG bank = %02X (addr=%04X val=%02X)\n", m_prg_bank, address, value);
         }
@@ -89,12 +95,12 @@ void Mapper002::ppu_write(uint16_t address, uint8_t value) {
     // CHR RAM: $0000-$1FFF (UxROM uses CHR RAM)
     if (address < 0x2000 && m_has_chr_ram) {
         if (!m_chr_rom->empty()) {
-            (*m_chr_rom)[address] = value;
+            write_chr_ram(address, value);
         }
     }
 }
 
-void Mapper002::save_state(std::vector<uint8_t>& data) {
+void Mapper002::save_state(StateWriter& data) {
     data.push_back(m_prg_bank);
 }
 
@@ -102,6 +108,7 @@ void Mapper002::load_state(const uint8_t*& data, size_t& remaining) {
     if (remaining < 1) return;
     m_prg_bank = *data++; remaining--;
     m_prg_bank_offset = (m_prg_bank * 0x4000) % m_prg_rom->size();
+    map_prg_pages(0, 16, m_prg_bank_offset);
 }
 
 } // namespace nes
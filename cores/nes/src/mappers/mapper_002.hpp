@@ -27,7 +27,7 @@ public:
 
     MirrorMode get_mirror_mode() const override { return m_mirror_mode; }
 
-    void save_state(std::vector<uint8_t>& data) override;
+    void save_state(StateWriter& data) override;
     void load_state(const uint8_t*& data, size_t& remaining) override;
 
 private:
@@ -22,6 +22,7 @@ Mapper003::Mapper003(std::vector<uint8_t>& prg_rom,
 void Mapper003::reset() {
     m_chr_bank = 0;
     m_chr_bank_offset = 0;
+    map_chr_pages(0, 8, m_chr_bank_offset);
 }
 
 uint8_t Mapper003::cpu_read(uint16_t address) {
@@ -50,7 +51,7 @@ void Mapper003::cpu_write(uint16_t address, uint8_t value) {
     // PRG RAM: $6000-$7FFF
     if (address >= 0x6000 && address < 0x8000) {
         if (!m_prg_ram->empty()) {
-            (*m_prg_ram)[address & 0x1FFF] = value;
+            write_prg_ram(address & 0x1FFF, value);
         }
         return;
     }
@@ -60,6 +61,7 @@ void Mapper003::cpu_write(uint16_t address, uint8_t value) {
         // Select CHR bank (usually only 2 bits used, but can be more)
         m_chr_bank = value & 0x03;  // Typically 4 banks max
         m_chr_bank_offset = (m_chr_bank * 0x2000) % m_chr_rom->size();
+        map_chr_pages(0, 8, m_chr_bank_offset);
         if (is_debug_mode()) {
             fprintf(stderr, "CNROM: CHR bank = %02X (addr=%04X val=%02X)\n", m_chr_bank, address, value);
         }
@@ -85,13 +87,13 @@ void Mapper003::ppu_write(uint16_t address, uint8_t value) {
         if (!m_chr_rom->empty()) {
             uint32_t offset = m_chr_bank_offset + address;
             if (offset < m_chr_rom->size()) {
-                (*m_chr_rom)[offset] = value;
+                write_chr_ram(offset, value);
             }
         }
     }
 }
 
-void Mapper003::save_state(std::vector<uint8_t>& data) {
+void Mapper003::save_state(StateWriter& data) {
     data.push_back(m_chr_bank);
 }
 
@@ -99,6 +101,7 @@ void Mapper003::load_state(const uint8_t*& data, size_t& remaining) {
     if (remaining < 1) return;
     m_chr_bank = *data++; remaining--;
     m_chr_bank_offset = (m_chr_bank * 0x2000) % m_chr_rom->size();
+    map_chr_pages(0, 8, m_chr_bank_offset);
 }
 
 } // namespace nes
@@ -13,6 +13,7 @@ Mapper004::Mapper004(std::vector<uint8_t>& prg_rom,
     m_prg_ram = &prg_ram;
     m_mirror_mode = mirror;
     m_has_chr_ram = has_chr_ram;
+    m_hooks = HOOK_IRQ | HOOK_PPU_ADDRESS_BUS | HOOK_FRAME_START;
 
     reset();
 }
@@ -75,6 +76,10 @@ void Mapper004::update_banks() {
         m_prg_bank[3] = last * 0x2000;
     }
 
+    for (int i = 0; i < 4; i++) {
+        map_prg_pages(i * 8, 8, m_prg_bank[i]);
+    }
+
     // CHR banking (1KB banks)
     if (chr_size > 0) {
         uint32_t chr_bank_count = chr_size / 0x400;  // Number of 1KB banks
@@ -104,6 +109,10 @@ void Mapper004::update_banks() {
             m_chr_bank[6] = (m_registers[4] % chr_bank_count) * 0x400;
             m_chr_bank[7] = (m_registers[5] % chr_bank_count) * 0x400;
         }
+
+        for (int i = 0; i < 8; i++) {
+            map_chr_page(i, m_chr_bank[i]);
+        }
     }
 }
 
@@ -169,7 +178,7 @@ void Mapper004::cpu_write(uint16_t address, uint8_t value) {
     // PRG RAM: $6000-$7FFF
     if (address >= 0x6000 && address < 0x8000) {
         if (!m_prg_ram->empty()) {
-            (*m_prg_ram)[address & 0x1FFF] = value;
+            write_prg_ram(address & 0x1FFF, value);
         }
         return;
     }
@@ -236,7 +245,7 @@ void Mapper004::ppu_write(uint16_t address, uint8_t value) {
         int bank = address / 0x400;
         uint32_t offset = m_chr_bank[bank] + (address & 0x3FF);
         if (offset < m_chr_rom->size()) {
-            (*m_chr_rom)[offset] = value;
+            write_chr_ram(offset, value);
         }
     }
 }
@@ -308,7 +317,7 @@ void Mapper004::notify_frame_start() {
     m_irq_pending_at_cycle = 0;  // Clear any stale pending IRQ timing
 }
 
-void Mapper004::save_state(std::vector<uint8_t>& data) {
+void Mapper004::save_state(StateWriter& data) {
     data.push_back(m_bank_select);
     data.push_back(m_prg_mode ? 1 : 0);
     data.push_back(m_chr_mode ? 1 : 0);
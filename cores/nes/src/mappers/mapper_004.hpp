@@ -28,13 +28,15 @@ public:
 
     bool irq_pending(uint32_t frame_cycle = 0) override;
     void irq_clear() override { m_irq_pending = false; m_irq_pending_at_cycle = 0; }
+    bool irq_polled() const override { return m_irq_pending_at_cycle > 0 && m_irq_enabled; }
     void scanline() override;
     void notify_ppu_addr_change(uint16_t old_addr, uint16_t new_addr, uint32_t frame_cycle) override;
     void notify_ppu_address_bus(uint16_t address, uint32_t frame_cycle) override;
     void notify_frame_start() override;
+    bool needs_exact_ppu_timing() const override { return true; }
 
     void reset() override;
-    void save_state(std::vector<uint8_t>& data) override;
+    void save_state(StateWriter& data) override;
     void load_state(const uint8_t*& data, size_t& remaining) override;
 
 private:
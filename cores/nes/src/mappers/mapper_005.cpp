@@ -14,6 +14,7 @@ Mapper005::Mapper005(std::vector<uint8_t>& prg_rom,
     m_prg_ram = &prg_ram;
     m_mirror_mode = mirror;
     m_has_chr_ram = has_chr_ram;
+    m_hooks = HOOK_CPU_CYCLES | HOOK_IRQ | HOOK_FRAME_START | HOOK_AUDIO | HOOK_PPU_EVENTS;
 
     // MMC5 typically has 64KB of PRG RAM
     if (m_prg_ram->size() < 0x10000) {
@@ -65,16 +66,12 @@ void Mapper005::reset() {
     m_exram.fill(0);
 
     m_scanline_counter = 0;
-    m_last_ppu_addr = 0;
-    m_consecutive_nametable_reads = 0;
-    m_last_frame_cycle = 0;
 
     m_fetching_sprites = false;
-    m_current_tile_addr = 0;
     m_exram_attr_latch = 0;
 
     m_in_split_region = false;
-    m_split_tile_count = 0;
+    m_split_y = 0;
 
     // Reset audio state
     m_mmc5_pulse[0] = MMC5Pulse{};
@@ -242,7 +239,7 @@ void Mapper005::write_prg(uint16_t address, uint8_t value) {
             if (address >= 0x8000) {
                 offset = address & 0x7FFF;
                 uint32_t ram_offset = ((bank_reg & 0x7C) * 0x2000 + offset) % m_prg_ram->size();
-                (*m_prg_ram)[ram_offset] = value;
+                write_prg_ram(ram_offset, value);
             }
             break;
 
@@ -259,7 +256,7 @@ void Mapper005::write_prg(uint16_t address, uint8_t value) {
             offset = address & 0x3FFF;
             {
                 uint32_t ram_offset = ((bank_reg & 0x7E) * 0x2000 + offset) % m_prg_ram->size();
-                (*m_prg_ram)[ram_offset] = value;
+                write_prg_ram(ram_offset, value);
             }
             break;
 
@@ -286,7 +283,7 @@ void Mapper005::write_prg(uint16_t address, uint8_t value) {
                     ram_offset = get_prg_bank_offset(bank_reg & 0x7F, true) + offset;
                     ram_offset %= m_prg_ram->size();
                 }
-                (*m_prg_ram)[ram_offset] = value;
+                write_prg_ram(ram_offset, value);
             }
             break;
 
@@ -308,7 +305,7 @@ void Mapper005::write_prg(uint16_t address, uint8_t value) {
             offset = address & 0x1FFF;
             {
                 uint32_t ram_offset = get_prg_bank_offset(bank_reg & 0x7F, true) + offset;
-                (*m_prg_ram)[ram_offset % m_prg_ram->size()] = value;
+                write_prg_ram(ram_offset % m_prg_ram->size(), value);
             }
             break;
     }
@@ -454,7 +451,7 @@ void Mapper005::cpu_write(uint16_t address, uint8_t value) {
         if (m_prg_ram_protect1 == 0x02 && m_prg_ram_protect2 == 0x01) {
             uint32_t offset = (m_prg_ram_bank & 0x07) * 0x2000 + (address & 0x1FFF);
             if (offset < m_prg_ram->size()) {
-                (*m_prg_ram)[offset] = value;
+                write_prg_ram(offset, value);
             }
         }
         return;
@@ -664,12 +661,18 @@ uint8_t Mapper005::ppu_read(uint16_t address, uint32_t frame_cycle) {
 
     // Pattern tables ($0000-$1FFF)
     if (address < 0x2000) {
-        // Detect scanline based on PPU address patterns
-        detect_scanline(address, frame_cycle);
+        uint32_t cycle_in_line = frame_cycle % 341;
+        m_fetching_sprites = (cycle_in_line >= 257 && cycle_in_line <= 320);
 
         uint32_t chr_size = m_chr_rom->size();
         if (chr_size == 0) return 0;
 
+        // Split tiles come from the 4 KB split bank at the split's own fine Y
+        if (m_in_split_region && !m_fetching_sprites) {
+            uint32_t offset = static_cast<uint32_t>(m_split_bank) * 0x1000 + (address & 0x0FF8) + (m_split_y & 7);
+            return (*m_chr_rom)[offset % chr_size];
+        }
+
         // Determine if this is a sprite or background fetch
         // Background fetches happen at cycles 1-256 and 321-340
         // Sprite fetches happen at cycles 257-320
@@ -709,7 +712,7 @@ void Mapper005::ppu_write(uint16_t address, uint8_t value) {
         offset += (address & 0x3FF);
 
         if (offset < chr_size) {
-            (*m_chr_rom)[offset] = value;
+            write_chr_ram(offset, value);
         }
         return;
     }
@@ -842,59 +845,6 @@ MirrorMode Mapper005::get_mirror_mode() const {
 
 // ========== Scanline Detection and IRQ ==========
 
-void Mapper005::detect_scanline(uint16_t address, uint32_t frame_cycle) {
-    // MMC5 detects scanlines by watching for consecutive nametable reads
-    // During visible rendering, the PPU reads from nametables in a predictable pattern
-
-    // Track if we're in the sprite fetch region (cycles 257-320)
-    // During these cycles, the PPU fetches sprite patterns
-    // We can detect this by looking at the frame cycle within a scanline
-
-    uint32_t cycle_in_frame = frame_cycle % 341;
-
-    // Sprite fetches occur during cycles 257-320
-    m_fetching_sprites = (cycle_in_frame >= 257 && cycle_in_frame <= 320);
-
-    // The MMC5 detects scanlines by counting nametable reads
-    // After 3 consecutive reads at $2000-$2FFF, it considers a new scanline
-
-    // For now, we use a simpler approach: detect based on frame cycle wrapping
-    // A more accurate implementation would track the actual PPU address patterns
-
-    uint32_t scanline = frame_cycle / 341;
-
-    // Detect frame start (leaving VBlank)
-    if (frame_cycle < m_last_frame_cycle && m_last_frame_cycle > 240 * 341) {
-        // Frame wrapped
-        m_in_frame = false;
-        m_scanline_counter = 0;
-    }
-
-    // Visible scanlines: 0-239
-    if (scanline < 240) {
-        if (!m_in_frame && scanline == 0) {
-            m_in_frame = true;
-            m_scanline_counter = 0;
-        }
-
-        // Check for new scanline
-        uint8_t expected_scanline = static_cast<uint8_t>(scanline);
-        if (expected_scanline != m_scanline_counter && m_in_frame) {
-            m_scanline_counter = expected_scanline;
-
-            // Check for IRQ
-            if (m_irq_enabled && m_scanline_counter == m_irq_scanline) {
-                m_irq_pending = true;
-            }
-        }
-    } else if (scanline >= 241) {
-        // VBlank
-        m_in_frame = false;
-    }
-
-    m_last_frame_cycle = frame_cycle;
-}
-
 void Mapper005::scanline() {
     // This is called by the PPU at the end of each visible scanline
     // We use this as a backup scanline detection method
@@ -924,23 +874,55 @@ void Mapper005::notify_ppu_addr_change(uint16_t old_addr, uint16_t new_addr, uin
     // MMC5 doesn't use A12 clocking like MMC3
 }
 
-void Mapper005::notify_ppu_address_bus(uint16_t address, uint32_t frame_cycle) {
-    // Track PPU address for scanline detection
-    detect_scanline(address, frame_cycle);
-}
-
 void Mapper005::notify_frame_start() {
     // Reset frame-related state
     m_in_frame = false;
     m_scanline_counter = 0;
     m_irq_pending = false;  // Clear any stale IRQ
-    m_split_tile_count = 0;
     m_in_split_region = false;
 }
 
+void Mapper005::ppu_scanline_start(int scanline) {
+    (void)scanline;
+
+    // The first rendered line starts the frame; each one after it counts
+    if (!m_in_frame) {
+        m_in_frame = true;
+        m_scanline_counter = 0;
+        return;
+    }
+    m_scanline_counter = static_cast<uint8_t>(m_scanline_counter + 1);
+    if (m_irq_enabled && m_scanline_counter == m_irq_scanline) {
+        m_irq_pending = true;
+    }
+}
+
+void Mapper005::ppu_frame_end() {
+    m_in_frame = false;
+    m_in_split_region = false;
+}
+
+bool Mapper005::ppu_tile_fetch(int scanline, int column, uint8_t& tile, uint8_t& palette) {
+    // $5200: the split covers tiles left of the threshold, or from it on
+    // when bit 6 is set; ExRAM holds its nametable in modes 0 and 1
+    int threshold = m_split_mode & 0x1F;
+    m_in_split_region = (m_split_mode & 0x80) && m_exram_mode < 2 &&
+                        ((m_split_mode & 0x40) ? column >= threshold : column < threshold);
+    if (!m_in_split_region) return false;
+
+    // The split scrolls by $5201 on its own, wrapping at the 30th tile row
+    m_split_y = static_cast<uint8_t>((m_split_scroll + scanline) % 240);
+    int x = column & 0x1F;
+    int row = m_split_y / 8;
+    tile = m_exram[row * 32 + x];
+    uint8_t attribute = m_exram[0x3C0 + (row / 4) * 8 + x / 4];
+    palette = (attribute >> (((row & 2) << 1) | (x & 2))) & 0x03;
+    return true;
+}
+
 // ========== Save State ==========
 
-void Mapper005::save_state(std::vector<uint8_t>& data) {
+void Mapper005::save_state(StateWriter& data) {
     // Mode registers
     data.push_back(m_prg_mode);
     data.push_back(m_chr_mode);
@@ -988,7 +970,7 @@ void Mapper005::save_state(std::vector<uint8_t>& data) {
     data.push_back(m_scanline_counter);
 
     // ExRAM
-    data.insert(data.end(), m_exram.begin(), m_exram.end());
+    data.write(m_exram.data(), m_exram.size());
 }
 
 void Mapper005::load_state(const uint8_t*& data, size_t& remaining) {
@@ -1061,16 +1043,18 @@ void Mapper005::cpu_cycles(int count) {
     // PERFORMANCE: Process all cycles at once instead of one at a time
 
     // Add cycles to divider and process audio in batches
-    m_audio_divider += count;
+    uint32_t divider = m_audio_divider + static_cast<uint32_t>(count);
 
     // Process each complete divider period
-    while (m_audio_divider >= AUDIO_DIVIDER_PERIOD) {
-        m_audio_divider -= AUDIO_DIVIDER_PERIOD;
+    while (divider >= AUDIO_DIVIDER_PERIOD) {
+        divider -= AUDIO_DIVIDER_PERIOD;
         m_audio_cycles += AUDIO_DIVIDER_PERIOD;
 
         // (Audio processing code follows unchanged - called once per AUDIO_DIVIDER_PERIOD cycles)
         process_audio_batch();
+        m_audio.set(count - divider, m_audio_output);
     }
+    m_audio_divider = static_cast<uint8_t>(divider);
 }
 
 void Mapper005::cpu_cycle() {
@@ -36,20 +36,24 @@ public:
     void irq_clear() override;
     void scanline() override;
     void notify_ppu_addr_change(uint16_t old_addr, uint16_t new_addr, uint32_t frame_cycle) override;
-    void notify_ppu_address_bus(uint16_t address, uint32_t frame_cycle) override;
     void notify_frame_start() override;
 
+    // Scanline counting, in-frame status and the vertical split all follow
+    // the PPU's rendering events, so the PPU can run behind the CPU
+    void ppu_scanline_start(int scanline) override;
+    void ppu_frame_end() override;
+    bool ppu_tile_fetch(int scanline, int column, uint8_t& tile, uint8_t& palette) override;
+    bool ppu_scanline_irq_armed() const override { return m_irq_enabled; }
+
     void reset() override;
-    void save_state(std::vector<uint8_t>& data) override;
+    void save_state(StateWriter& data) override;
     void load_state(const uint8_t*& data, size_t& remaining) override;
 
     // CPU cycle notification for audio
     // PERFORMANCE: Batched version - receives cycle count for efficient processing
     void cpu_cycles(int count) override;
     void cpu_cycle() override;
-
-    // Get expansion audio output (-1.0 to 1.0)
-    float get_audio_output() const override { return m_audio_output; }
+    uint32_t cpu_cycles_until_irq() const override { return UINT32_MAX; }  // Scanline IRQ only
 
 private:
     // Audio processing helper
@@ -68,9 +72,6 @@ private:
     void write_nametable(uint16_t address, uint8_t value);
     uint8_t get_exram_attribute(uint16_t address);
 
-    // Scanline detection
-    void detect_scanline(uint16_t address, uint32_t frame_cycle);
-
     // ========== Registers ==========
 
     // $5100: PRG mode (0-3)
@@ -168,23 +169,18 @@ private:
     // Current scanline counter (0-255, wraps)
     uint8_t m_scanline_counter = 0;
 
-    // For in-frame detection
-    uint16_t m_last_ppu_addr = 0;
-    int m_consecutive_nametable_reads = 0;
-    uint32_t m_last_frame_cycle = 0;
-
     // Track rendering state for sprite/BG CHR bank selection
     // The PPU fetches BG tiles first (cycles 1-256, 321-336), then sprites (257-320)
-    // We detect this by watching the PPU address bus
+    // We tell them apart by the dot of each pattern fetch
     bool m_fetching_sprites = false;
-    uint16_t m_current_tile_addr = 0;
 
     // For extended attribute mode - track current tile fetch
     uint8_t m_exram_attr_latch = 0;
 
-    // Split screen state
+    // Split screen state: whether the tile being fetched is in the split,
+    // and the split's row for the line (tile row and fine Y)
     bool m_in_split_region = false;
-    uint8_t m_split_tile_count = 0;
+    uint8_t m_split_y = 0;
 
     // ========== MMC5 Audio ==========
     // MMC5 has two pulse channels similar to the NES APU pulse channels
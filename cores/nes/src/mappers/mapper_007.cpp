@@ -15,6 +15,9 @@ Mapper007::Mapper007(std::vector<uint8_t>& prg_rom,
     m_has_chr_ram = has_chr_ram;
 
     reset();
+
+    // Unbanked 8KB CHR
+    map_chr_pages(0, 8, 0);
 }
 
 void Mapper007::reset() {
@@ -23,6 +26,7 @@ void Mapper007::reset() {
     size_t num_banks = m_prg_rom->size() / 0x8000;
     m_prg_bank = (num_banks > 0) ? static_cast<uint8_t>(num_banks - 1) : 0;
     m_prg_bank_offset = m_prg_bank * 0x8000;
+    map_prg_pages(0, 32, m_prg_bank_offset);
     m_mirror_mode = MirrorMode::SingleScreen0;
 }
 
@@ -55,6 +59,7 @@ void Mapper007::cpu_write(uint16_t address, uint8_t value) {
         // Use lower 4 bits for bank, then modulo by actual bank count
         m_prg_bank = value & 0x0F;
         m_prg_bank_offset = (m_prg_bank * 0x8000) % m_prg_rom->size();
+        map_prg_pages(0, 32, m_prg_bank_offset);
 
         // Single-screen mirroring: bit 4 selects which nametable
         if (value & 0x10) {
@@ -79,12 +84,12 @@ void Mapper007::ppu_write(uint16_t address, uint8_t value) {
     // CHR RAM: $0000-$1FFF (AxROM always uses CHR RAM)
     if (address < 0x2000) {
         if (!m_chr_rom->empty()) {
-            (*m_chr_rom)[address] = value;
+            write_chr_ram(address, value);
         }
     }
 }
 
-void Mapper007::save_state(std::vector<uint8_t>& data) {
+void Mapper007::save_state(StateWriter& data) {
     data.push_back(m_prg_bank);
     data.push_back(static_cast<uint8_t>(m_mirror_mode));
 }
@@ -94,6 +99,7 @@ void Mapper007::load_state(const uint8_t*& data, size_t& remaining) {
     m_prg_bank = *data++; remaining--;
     m_mirror_mode = static_cast<MirrorMode>(*data++); remaining--;
     m_prg_bank_offset = (m_prg_bank * 0x8000) % m_prg_rom->size();
+    map_prg_pages(0, 32, m_prg_bank_offset);
 }
 
 } // namespace nes
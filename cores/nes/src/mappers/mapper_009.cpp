@@ -22,8 +22,10 @@ Mapper009::Mapper009(std::vector<uint8_t>& prg_rom,
 void Mapper009::reset() {
     m_prg_bank = 0;
     m_prg_bank_offset = 0;
+    map_prg_pages(0, 8, m_prg_bank_offset);
     // Last 3 8KB banks are fixed at $A000-$FFFF
     m_prg_fixed_offset = m_prg_rom->size() - (3 * 0x2000);
+    map_prg_pages(8, 24, m_prg_fixed_offset);
 
     m_chr_bank_0_fd = 0;
     m_chr_bank_0_fe = 0;
@@ -78,7 +80,7 @@ void Mapper009::cpu_write(uint16_t address, uint8_t value) {
     // PRG RAM: $6000-$7FFF
     if (address >= 0x6000 && address < 0x8000) {
         if (!m_prg_ram->empty()) {
-            (*m_prg_ram)[address & 0x1FFF] = value;
+            write_prg_ram(address & 0x1FFF, value);
         }
         return;
     }
@@ -89,6 +91,7 @@ void Mapper009::cpu_write(uint16_t address, uint8_t value) {
             case 0xA000:  // PRG ROM bank select
                 m_prg_bank = value & 0x0F;
                 m_prg_bank_offset = (m_prg_bank * 0x2000) % m_prg_rom->size();
+                map_prg_pages(0, 8, m_prg_bank_offset);
                 if (is_debug_mode()) {
                     fprintf(stderr, "MMC2: PRG bank = %02X\n", m_prg_bank);
                 }
@@ -192,15 +195,15 @@ void Mapper009::ppu_write(uint16_t address, uint8_t value) {
     if (address < 0x2000 && m_has_chr_ram) {
         if (address < 0x1000) {
             uint32_t offset = m_chr_bank_0_offset + (address & 0x0FFF);
-            (*m_chr_rom)[offset % m_chr_rom->size()] = value;
+            write_chr_ram(offset % m_chr_rom->size(), value);
         } else {
             uint32_t offset = m_chr_bank_1_offset + (address & 0x0FFF);
-            (*m_chr_rom)[offset % m_chr_rom->size()] = value;
+            write_chr_ram(offset % m_chr_rom->size(), value);
         }
     }
 }
 
-void Mapper009::save_state(std::vector<uint8_t>& data) {
+void Mapper009::save_state(StateWriter& data) {
     data.push_back(m_prg_bank);
     data.push_back(m_chr_bank_0_fd);
     data.push_back(m_chr_bank_0_fe);
@@ -224,6 +227,7 @@ void Mapper009::load_state(const uint8_t*& data, size_t& remaining) {
     m_mirror_mode = static_cast<MirrorMode>(*data++); remaining--;
 
     m_prg_bank_offset = (m_prg_bank * 0x2000) % m_prg_rom->size();
+    map_prg_pages(0, 8, m_prg_bank_offset);
     update_chr_banks();
 }
 
@@ -22,8 +22,10 @@ Mapper010::Mapper010(std::vector<uint8_t>& prg_rom,
 void Mapper010::reset() {
     m_prg_bank = 0;
     m_prg_bank_offset = 0;
+    map_prg_pages(0, 16, m_prg_bank_offset);
     // Last 16KB bank is fixed at $C000-$FFFF
     m_prg_fixed_offset = m_prg_rom->size() - 0x4000;
+    map_prg_pages(16, 16, m_prg_fixed_offset);
 
     m_chr_bank_0_fd = 0;
     m_chr_bank_0_fe = 0;
@@ -78,7 +80,7 @@ void Mapper010::cpu_write(uint16_t address, uint8_t value) {
     // PRG RAM: $6000-$7FFF
     if (address >= 0x6000 && address < 0x8000) {
         if (!m_prg_ram->empty()) {
-            (*m_prg_ram)[address & 0x1FFF] = value;
+            write_prg_ram(address & 0x1FFF, value);
         }
         return;
     }
@@ -89,6 +91,7 @@ void Mapper010::cpu_write(uint16_t address, uint8_t value) {
             case 0xA000:  // PRG ROM bank select (16KB)
                 m_prg_bank = value & 0x0F;
                 m_prg_bank_offset = (m_prg_bank * 0x4000) % m_prg_rom->size();
+                map_prg_pages(0, 16, m_prg_bank_offset);
                 break;
 
             case 0xB000:  // CHR ROM bank 0 select ($FD)
@@ -169,15 +172,15 @@ void Mapper010::ppu_write(uint16_t address, uint8_t value) {
     if (address < 0x2000 && m_has_chr_ram) {
         if (address < 0x1000) {
             uint32_t offset = m_chr_bank_0_offset + (address & 0x0FFF);
-            (*m_chr_rom)[offset % m_chr_rom->size()] = value;
+            write_chr_ram(offset % m_chr_rom->size(), value);
         } else {
             uint32_t offset = m_chr_bank_1_offset + (address & 0x0FFF);
-            (*m_chr_rom)[offset % m_chr_rom->size()] = value;
+            write_chr_ram(offset % m_chr_rom->size(), value);
         }
     }
 }
 
-void Mapper010::save_state(std::vector<uint8_t>& data) {
+void Mapper010::save_state(StateWriter& data) {
     data.push_back(m_prg_bank);
     data.push_back(m_chr_bank_0_fd);
     data.push_back(m_chr_bank_0_fe);
@@ -201,6 +204,7 @@ void Mapper010::load_state(const uint8_t*& data, size_t& remaining) {
     m_mirror_mode = static_cast<MirrorMode>(*data++); remaining--;
 
     m_prg_bank_offset = (m_prg_bank * 0x4000) % m_prg_rom->size();
+    map_prg_pages(0, 16, m_prg_bank_offset);
     update_chr_banks();
 }
 
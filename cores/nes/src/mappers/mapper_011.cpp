@@ -21,7 +21,9 @@ void Mapper011::reset() {
     m_prg_bank = 0;
     m_chr_bank = 0;
     m_prg_bank_offset = 0;
+    map_prg_pages(0, 32, m_prg_bank_offset);
     m_chr_bank_offset = 0;
+    map_chr_pages(0, 8, m_chr_bank_offset);
 }
 
 uint8_t Mapper011::cpu_read(uint16_t address) {
@@ -48,8 +50,10 @@ void Mapper011::cpu_write(uint16_t address, uint8_t value) {
         m_chr_bank = (value >> 4) & 0x0F;
 
         m_prg_bank_offset = (m_prg_bank * 0x8000) % m_prg_rom->size();
+        map_prg_pages(0, 32, m_prg_bank_offset);
         if (!m_chr_rom->empty()) {
             m_chr_bank_offset = (m_chr_bank * 0x2000) % m_chr_rom->size();
+            map_chr_pages(0, 8, m_chr_bank_offset);
         }
     }
 }
@@ -70,12 +74,12 @@ void Mapper011::ppu_write(uint16_t address, uint8_t value) {
     if (address < 0x2000 && m_has_chr_ram) {
         if (!m_chr_rom->empty()) {
             uint32_t offset = m_chr_bank_offset + address;
-            (*m_chr_rom)[offset % m_chr_rom->size()] = value;
+            write_chr_ram(offset % m_chr_rom->size(), value);
         }
     }
 }
 
-void Mapper011::save_state(std::vector<uint8_t>& data) {
+void Mapper011::save_state(StateWriter& data) {
     data.push_back(m_prg_bank);
     data.push_back(m_chr_bank);
 }
@@ -87,8 +91,10 @@ void Mapper011::load_state(const uint8_t*& data, size_t& remaining) {
     m_chr_bank = *data++; remaining--;
 
     m_prg_bank_offset = (m_prg_bank * 0x8000) % m_prg_rom->size();
+    map_prg_pages(0, 32, m_prg_bank_offset);
     if (!m_chr_rom->empty()) {
         m_chr_bank_offset = (m_chr_bank * 0x2000) % m_chr_rom->size();
+        map_chr_pages(0, 8, m_chr_bank_offset);
     }
 }
 
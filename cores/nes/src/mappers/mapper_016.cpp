@@ -16,6 +16,7 @@ Mapper016::Mapper016(std::vector<uint8_t>& prg_rom,
     m_prg_ram = &prg_ram;
     m_mirror_mode = mirror;
     m_has_chr_ram = has_chr_ram;
+    m_hooks = HOOK_IRQ | HOOK_FRAME_START;
     m_eeprom_type = eeprom_type;
 
     // Initialize EEPROM data based on type
@@ -97,6 +98,10 @@ void Mapper016::update_prg_bank() {
 
     // PRG bank register selects 16KB bank at $8000-$BFFF
     m_prg_bank_offset = (m_prg_bank_reg % bank_count) * 0x4000;
+
+    // $C000-$FFFF is fixed to the last 16KB bank
+    map_prg_pages(0, 16, m_prg_bank_offset);
+    map_prg_pages(16, 16, prg_size - 0x4000);
 }
 
 void Mapper016::update_chr_banks() {
@@ -108,6 +113,7 @@ void Mapper016::update_chr_banks() {
 
     for (int i = 0; i < 8; i++) {
         m_chr_bank_offsets[i] = (m_chr_bank_regs[i] % bank_count) * 0x400;
+        map_chr_page(i, m_chr_bank_offsets[i]);
     }
 }
 
@@ -233,7 +239,7 @@ void Mapper016::ppu_write(uint16_t address, uint8_t value) {
         int bank = address / 0x400;
         uint32_t offset = m_chr_bank_offsets[bank] + (address & 0x3FF);
         if (offset < m_chr_rom->size()) {
-            (*m_chr_rom)[offset] = value;
+            write_chr_ram(offset, value);
         }
     }
 }
@@ -488,6 +494,7 @@ void Mapper016::eeprom_process_byte() {
                 size_t eeprom_size = get_eeprom_size();
                 if (eeprom_size > 0 && m_i2c_word_addr < eeprom_size) {
                     m_eeprom_data[m_i2c_word_addr] = byte;
+                    touch_save_data();
                 }
 
                 // Increment address (with wraparound)
@@ -517,7 +524,7 @@ void Mapper016::eeprom_process_byte() {
 // Save State
 // ============================================================================
 
-void Mapper016::save_state(std::vector<uint8_t>& data) {
+void Mapper016::save_state(StateWriter& data) {
     // PRG banking
     data.push_back(m_prg_bank_reg);
 
@@ -44,10 +44,13 @@ public:
 
     bool irq_pending(uint32_t frame_cycle = 0) override;
     void irq_clear() override;
+    // The counter is run down from the frame cycle of each poll
+    bool irq_polled() const override { return true; }
     void notify_frame_start() override;
+    bool needs_exact_ppu_timing() const override { return true; }
 
     void reset() override;
-    void save_state(std::vector<uint8_t>& data) override;
+    void save_state(StateWriter& data) override;
     void load_state(const uint8_t*& data, size_t& remaining) override;
 
     // EEPROM data access for save file support
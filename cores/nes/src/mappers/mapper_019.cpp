@@ -34,6 +34,7 @@ Mapper019::Mapper019(std::vector<uint8_t>& prg_rom,
     m_prg_ram = &prg_ram;
     m_mirror_mode = mirror;
     m_has_chr_ram = has_chr_ram;
+    m_hooks = HOOK_CPU_CYCLES | HOOK_IRQ | HOOK_AUDIO;
 
     reset();
 }
@@ -100,6 +101,10 @@ void Mapper019::update_prg_banks() {
 
     // Bank 3 is fixed to the last bank ($E000-$FFFF)
     m_prg_bank_offset[3] = (num_8k_banks - 1) * 0x2000;
+
+    for (int i = 0; i < 4; i++) {
+        map_prg_pages(i * 8, 8, m_prg_bank_offset[i]);
+    }
 }
 
 void Mapper019::update_chr_banks() {
@@ -239,7 +244,7 @@ void Mapper019::cpu_write(uint16_t address, uint8_t value) {
     // PRG RAM: $6000-$7FFF
     if (address >= 0x6000 && address < 0x8000) {
         if (!m_prg_ram->empty() && !m_prg_ram_write_protect) {
-            (*m_prg_ram)[address & 0x1FFF] = value;
+            write_prg_ram(address & 0x1FFF, value);
         }
         return;
     }
@@ -427,7 +432,7 @@ void Mapper019::ppu_write(uint16_t address, uint8_t value) {
         // Regular CHR RAM write
         uint32_t offset = m_chr_bank_offset[bank] + (address & 0x3FF);
         if (offset < m_chr_rom->size()) {
-            (*m_chr_rom)[offset] = value;
+            write_chr_ram(offset, value);
         }
         return;
     }
@@ -456,11 +461,13 @@ void Mapper019::cpu_cycles(int count) {
 
     // Audio synthesis with divider for performance
     // Namco 163 audio updates one channel every 15 CPU cycles
-    m_audio_divider += count;
-    while (m_audio_divider >= AUDIO_DIVIDER_PERIOD) {
-        m_audio_divider -= AUDIO_DIVIDER_PERIOD;
+    uint32_t divider = m_audio_divider + static_cast<uint32_t>(count);
+    while (divider >= AUDIO_DIVIDER_PERIOD) {
+        divider -= AUDIO_DIVIDER_PERIOD;
         clock_audio();
+        m_audio.set(count - divider, m_audio_output);
     }
+    m_audio_divider = static_cast<uint8_t>(divider);
 }
 
 void Mapper019::cpu_cycle() {
@@ -468,6 +475,11 @@ void Mapper019::cpu_cycle() {
     cpu_cycles(1);
 }
 
+uint32_t Mapper019::cpu_cycles_until_irq() const {
+    if (!m_irq_enabled || m_irq_counter >= 0x8000) return UINT32_MAX;
+    return 0x8000u - m_irq_counter;
+}
+
 void Mapper019::clock_audio() {
     // This function is now called every 15 CPU cycles (once per channel clock)
 
@@ -526,7 +538,7 @@ void Mapper019::clock_audio() {
     }
 }
 
-void Mapper019::save_state(std::vector<uint8_t>& data) {
+void Mapper019::save_state(StateWriter& data) {
     // PRG banks
     for (int i = 0; i < 3; i++) {
         data.push_back(m_prg_bank[i]);
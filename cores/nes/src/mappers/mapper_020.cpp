@@ -15,6 +15,7 @@ Mapper020::Mapper020(std::vector<uint8_t>& prg_rom,
     m_prg_ram = &prg_ram;
     m_mirror_mode = initial_mirror;
     m_has_chr_ram = true;  // FDS always uses CHR RAM
+    m_hooks = HOOK_CPU_CYCLES | HOOK_IRQ | HOOK_AUDIO;
 
     m_prg_ram_main.fill(0);
     m_prg_ram_bios.fill(0);
@@ -278,8 +279,15 @@ void Mapper020::cpu_cycles(int count) {
     // FDS audio requires per-cycle updates for accurate emulation
     // For now, just call cpu_cycle for each cycle
     // TODO: Optimize this with batched audio processing if FDS becomes a bottleneck
+    // The output only moves with the wave position, apart from register
+    // writes, which land between batches
+    m_audio.set(0, audio_output());
     for (int i = 0; i < count; i++) {
+        uint8_t wave_pos = m_wave_pos;
         cpu_cycle();
+        if (m_wave_pos != wave_pos) {
+            m_audio.set(i + 1, audio_output());
+        }
     }
 }
 
@@ -331,10 +339,9 @@ void Mapper020::cpu_cycle() {
     if (m_motor_on && m_disk_inserted && !m_transfer_reset) {
         // Simplified: just signal byte ready periodically
         // Real FDS timing is much more complex
-        static int disk_timer = 0;
-        disk_timer++;
-        if (disk_timer >= 150) {  // ~150 CPU cycles per byte
-            disk_timer = 0;
+        m_disk_timer++;
+        if (m_disk_timer >= 150) {  // ~150 CPU cycles per byte
+            m_disk_timer = 0;
             if (m_read_mode && m_disk_position < m_disk_data.size()) {
                 m_data_read = m_disk_data[m_disk_position];
                 m_disk_position++;
@@ -344,7 +351,12 @@ void Mapper020::cpu_cycle() {
     }
 }
 
-float Mapper020::get_audio_output() const {
+uint32_t Mapper020::cpu_cycles_until_irq() const {
+    if (!m_irq_enabled || m_irq_counter == 0) return UINT32_MAX;
+    return m_irq_counter;
+}
+
+float Mapper020::audio_output() const {
     if (!m_wave_enabled || m_wave_freq == 0) {
         return 0.0f;
     }
@@ -382,9 +394,8 @@ void Mapper020::eject_disk() {
 // Serialization helpers
 namespace {
     template<typename T>
-    void write_value(std::vector<uint8_t>& data, T value) {
-        const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&value);
-        data.insert(data.end(), ptr, ptr + sizeof(T));
+    void write_value(StateWriter& data, T value) {
+        data.write(&value, sizeof(T));
     }
 
     template<typename T>
@@ -396,8 +407,8 @@ namespace {
         return true;
     }
 
-    void write_array(std::vector<uint8_t>& data, const uint8_t* arr, size_t size) {
-        data.insert(data.end(), arr, arr + size);
+    void write_array(StateWriter& data, const uint8_t* arr, size_t size) {
+        data.write(arr, size);
     }
 
     bool read_array(const uint8_t*& data, size_t& remaining, uint8_t* arr, size_t size) {
@@ -409,7 +420,7 @@ namespace {
     }
 }
 
-void Mapper020::save_state(std::vector<uint8_t>& data) {
+void Mapper020::save_state(StateWriter& data) {
     // Save PRG RAM
     write_array(data, m_prg_ram_main.data(), m_prg_ram_main.size());
     write_array(data, m_prg_ram_bios.data(), m_prg_ram_bios.size());
@@ -38,10 +38,10 @@ public:
     // PERFORMANCE: Batched version - receives cycle count for efficient processing
     void cpu_cycles(int count) override;
     void cpu_cycle() override;
-    float get_audio_output() const override;
+    uint32_t cpu_cycles_until_irq() const override;
 
     void reset() override;
-    void save_state(std::vector<uint8_t>& data) override;
+    void save_state(StateWriter& data) override;
     void load_state(const uint8_t*& data, size_t& remaining) override;
 
     // Disk operations
@@ -51,6 +51,9 @@ public:
     bool is_disk_inserted() const { return m_disk_inserted; }
 
 private:
+    // Wave channel output (-1.0 to 1.0) for the current registers and position
+    float audio_output() const;
+
     // PRG RAM (32KB main + 8KB BIOS area)
     std::array<uint8_t, 32768> m_prg_ram_main;
     std::array<uint8_t, 8192> m_prg_ram_bios;  // $E000-$FFFF
@@ -105,6 +108,9 @@ private:
     uint8_t m_master_volume = 0;
     uint8_t m_env_speed = 0;
     bool m_env_enabled = false;
+
+    // CPU cycles toward the next disk byte
+    int m_disk_timer = 0;
 };
 
 } // namespace nes
@@ -14,6 +14,7 @@ Mapper024::Mapper024(std::vector<uint8_t>& prg_rom,
     m_prg_ram = &prg_ram;
     m_mirror_mode = mirror;
     m_has_chr_ram = has_chr_ram;
+    m_hooks = HOOK_CPU_CYCLES | HOOK_IRQ | HOOK_AUDIO;
     m_is_vrc6b = is_vrc6b;
 
     reset();
@@ -76,6 +77,10 @@ void Mapper024::update_prg_banks() {
     m_prg_bank_16k_offset = (m_prg_bank_16k % num_16k_banks) * 0x4000;
     m_prg_bank_8k_offset = (m_prg_bank_8k % num_8k_banks) * 0x2000;
     m_prg_fixed_offset = (num_8k_banks - 1) * 0x2000;  // Last 8KB bank
+
+    map_prg_pages(0, 16, m_prg_bank_16k_offset);
+    map_prg_pages(16, 8, m_prg_bank_8k_offset);
+    map_prg_pages(24, 8, m_prg_fixed_offset);
 }
 
 void Mapper024::update_chr_banks() {
@@ -87,6 +92,7 @@ void Mapper024::update_chr_banks() {
 
     for (int i = 0; i < 8; i++) {
         m_chr_bank_offset[i] = (m_chr_bank[i] % num_1k_banks) * 0x400;
+        map_chr_page(i, m_chr_bank_offset[i]);
     }
 }
 
@@ -133,7 +139,7 @@ void Mapper024::cpu_write(uint16_t address, uint8_t value) {
     // PRG RAM: $6000-$7FFF
     if (address >= 0x6000 && address < 0x8000) {
         if (!m_prg_ram->empty()) {
-            (*m_prg_ram)[address & 0x1FFF] = value;
+            write_prg_ram(address & 0x1FFF, value);
         }
         return;
     }
@@ -298,7 +304,7 @@ void Mapper024::ppu_write(uint16_t address, uint8_t value) {
         int bank = address / 0x400;
         uint32_t offset = m_chr_bank_offset[bank] + (address & 0x3FF);
         if (offset < m_chr_rom->size()) {
-            (*m_chr_rom)[offset] = value;
+            write_chr_ram(offset, value);
         }
     }
 }
@@ -345,11 +351,13 @@ void Mapper024::cpu_cycles(int count) {
 
     // Audio divider - batch update
     // Add cycles to divider and call clock_audio for each period elapsed
-    m_audio_divider += count;
-    while (m_audio_divider >= AUDIO_DIVIDER_PERIOD) {
-        m_audio_divider -= AUDIO_DIVIDER_PERIOD;
+    uint32_t divider = m_audio_divider + static_cast<uint32_t>(count);
+    while (divider >= AUDIO_DIVIDER_PERIOD) {
+        divider -= AUDIO_DIVIDER_PERIOD;
         clock_audio();
+        m_audio.set(count - divider, m_audio_output);
     }
+    m_audio_divider = static_cast<uint8_t>(divider);
 }
 
 void Mapper024::cpu_cycle() {
@@ -357,6 +365,13 @@ void Mapper024::cpu_cycle() {
     cpu_cycles(1);
 }
 
+uint32_t Mapper024::cpu_cycles_until_irq() const {
+    if (!m_irq_mode_cycle || !m_irq_enabled) return UINT32_MAX;
+
+    // The prescaler underflow that clocks the counter past $FF
+    return m_irq_prescaler + 1u + (0xFFu - m_irq_counter) * IRQ_PRESCALER_RELOAD;
+}
+
 void Mapper024::clock_audio() {
     // Check if audio is halted
     if (m_audio_halt & 0x01) {
@@ -438,7 +453,7 @@ void Mapper024::clock_audio() {
     m_audio_output = (mix / 61.0f - 0.5f) * 2.0f;
 }
 
-void Mapper024::save_state(std::vector<uint8_t>& data) {
+void Mapper024::save_state(StateWriter& data) {
     data.push_back(m_prg_bank_16k);
     data.push_back(m_prg_bank_8k);
 
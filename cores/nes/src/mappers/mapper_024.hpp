@@ -37,16 +37,14 @@ public:
 
     void reset() override;
 
-    void save_state(std::vector<uint8_t>& data) override;
+    void save_state(StateWriter& data) override;
     void load_state(const uint8_t*& data, size_t& remaining) override;
 
     // CPU cycle notification for IRQ counter (cycle mode) and audio clocking
     // PERFORMANCE: Batched version - receives cycle count for efficient processing
     void cpu_cycles(int count) override;
     void cpu_cycle() override;
-
-    // Get expansion audio output (-1.0 to 1.0)
-    float get_audio_output() const override { return m_audio_output; }
+    uint32_t cpu_cycles_until_irq() const override;
 
 private:
     // Audio synthesis
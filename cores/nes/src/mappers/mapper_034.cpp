@@ -27,8 +27,11 @@ void Mapper034::reset() {
     m_chr_bank_0 = 0;
     m_chr_bank_1 = 0;
     m_prg_bank_offset = 0;
+    map_prg_pages(0, 32, m_prg_bank_offset);
     m_chr_bank_0_offset = 0;
+    map_chr_pages(0, 4, m_chr_bank_0_offset);
     m_chr_bank_1_offset = 0x1000;  // Second 4KB bank
+    map_chr_pages(4, 4, m_chr_bank_1_offset);
 }
 
 uint8_t Mapper034::cpu_read(uint16_t address) {
@@ -56,7 +59,7 @@ void Mapper034::cpu_write(uint16_t address, uint8_t value) {
     // PRG RAM: $6000-$7FFF
     if (address >= 0x6000 && address < 0x8000) {
         if (!m_prg_ram->empty()) {
-            (*m_prg_ram)[address & 0x1FFF] = value;
+            write_prg_ram(address & 0x1FFF, value);
         }
 
         // NINA-001 register writes (in PRG RAM space)
@@ -65,16 +68,19 @@ void Mapper034::cpu_write(uint16_t address, uint8_t value) {
                 case 0x7FFD:  // PRG bank select
                     m_prg_bank = value & 0x01;
                     m_prg_bank_offset = (m_prg_bank * 0x8000) % m_prg_rom->size();
+                    map_prg_pages(0, 32, m_prg_bank_offset);
                     break;
 
                 case 0x7FFE:  // CHR bank 0 select ($0000-$0FFF)
                     m_chr_bank_0 = value & 0x0F;
                     m_chr_bank_0_offset = (m_chr_bank_0 * 0x1000) % m_chr_rom->size();
+                    map_chr_pages(0, 4, m_chr_bank_0_offset);
                     break;
 
                 case 0x7FFF:  // CHR bank 1 select ($1000-$1FFF)
                     m_chr_bank_1 = value & 0x0F;
                     m_chr_bank_1_offset = (m_chr_bank_1 * 0x1000) % m_chr_rom->size();
+                    map_chr_pages(4, 4, m_chr_bank_1_offset);
                     break;
             }
         }
@@ -85,6 +91,7 @@ void Mapper034::cpu_write(uint16_t address, uint8_t value) {
     if (address >= 0x8000 && !m_is_nina001) {
         m_prg_bank = value & 0x03;  // 2 bits = 4 banks max (128KB)
         m_prg_bank_offset = (m_prg_bank * 0x8000) % m_prg_rom->size();
+        map_prg_pages(0, 32, m_prg_bank_offset);
     }
 }
 
@@ -113,12 +120,12 @@ void Mapper034::ppu_write(uint16_t address, uint8_t value) {
     // CHR RAM write (BNROM only, NINA-001 uses CHR ROM)
     if (address < 0x2000 && m_has_chr_ram) {
         if (!m_chr_rom->empty()) {
-            (*m_chr_rom)[address] = value;
+            write_chr_ram(address, value);
         }
     }
 }
 
-void Mapper034::save_state(std::vector<uint8_t>& data) {
+void Mapper034::save_state(StateWriter& data) {
     data.push_back(m_prg_bank);
     data.push_back(m_chr_bank_0);
     data.push_back(m_chr_bank_1);
@@ -132,9 +139,12 @@ void Mapper034::load_state(const uint8_t*& data, size_t& remaining) {
     m_chr_bank_1 = *data++; remaining--;
 
     m_prg_bank_offset = (m_prg_bank * 0x8000) % m_prg_rom->size();
+    map_prg_pages(0, 32, m_prg_bank_offset);
     if (m_is_nina001 && !m_chr_rom->empty()) {
         m_chr_bank_0_offset = (m_chr_bank_0 * 0x1000) % m_chr_rom->size();
+        map_chr_pages(0, 4, m_chr_bank_0_offset);
         m_chr_bank_1_offset = (m_chr_bank_1 * 0x1000) % m_chr_rom->size();
+        map_chr_pages(4, 4, m_chr_bank_1_offset);
     }
 }
 
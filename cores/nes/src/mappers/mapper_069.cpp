@@ -13,6 +13,7 @@ Mapper069::Mapper069(std::vector<uint8_t>& prg_rom,
     m_prg_ram = &prg_ram;
     m_mirror_mode = mirror;
     m_has_chr_ram = has_chr_ram;
+    m_hooks = HOOK_CPU_CYCLES | HOOK_IRQ | HOOK_AUDIO;
 
     reset();
 }
@@ -82,6 +83,10 @@ void Mapper069::update_prg_banks() {
 
     // Bank 3 is fixed to last bank ($E000-$FFFF)
     m_prg_bank_offset[3] = (num_8k_banks - 1) * 0x2000;
+
+    for (int i = 0; i < 4; i++) {
+        map_prg_pages(i * 8, 8, m_prg_bank_offset[i]);
+    }
 }
 
 void Mapper069::update_chr_banks() {
@@ -93,6 +98,7 @@ void Mapper069::update_chr_banks() {
 
     for (int i = 0; i < 8; i++) {
         m_chr_bank_offset[i] = (m_chr_bank[i] % num_1k_banks) * 0x400;
+        map_chr_page(i, m_chr_bank_offset[i]);
     }
 }
 
@@ -208,7 +214,7 @@ void Mapper069::cpu_write(uint16_t address, uint8_t value) {
             if (!m_prg_ram->empty()) {
                 size_t offset = (m_prg_ram_bank & 0x03) * 0x2000 + (address & 0x1FFF);
                 if (offset < m_prg_ram->size()) {
-                    (*m_prg_ram)[offset] = value;
+                    write_prg_ram(offset, value);
                 }
             }
         }
@@ -315,7 +321,7 @@ void Mapper069::ppu_write(uint16_t address, uint8_t value) {
         int bank = address / 0x400;
         uint32_t offset = m_chr_bank_offset[bank] + (address & 0x3FF);
         if (offset < m_chr_rom->size()) {
-            (*m_chr_rom)[offset] = value;
+            write_chr_ram(offset, value);
         }
     }
 }
@@ -340,11 +346,13 @@ void Mapper069::cpu_cycles(int count) {
     }
 
     // Clock audio every 16 CPU cycles (5B runs at CPU/16)
-    m_audio_divider += count;
-    while (m_audio_divider >= 16) {
-        m_audio_divider -= 16;
+    uint32_t divider = m_audio_divider + static_cast<uint32_t>(count);
+    while (divider >= 16) {
+        divider -= 16;
         clock_audio();
+        m_audio.set(count - divider, m_audio_output);
     }
+    m_audio_divider = static_cast<uint8_t>(divider);
 }
 
 void Mapper069::cpu_cycle() {
@@ -352,6 +360,11 @@ void Mapper069::cpu_cycle() {
     cpu_cycles(1);
 }
 
+uint32_t Mapper069::cpu_cycles_until_irq() const {
+    if (!m_irq_counter_enabled || !m_irq_enabled) return UINT32_MAX;
+    return m_irq_counter + 1u;     // The decrement that wraps past 0
+}
+
 void Mapper069::clock_audio() {
     int mix = 0;
 
@@ -435,7 +448,7 @@ void Mapper069::clock_audio() {
     m_audio_output = (mix / 45.0f - 0.5f) * 2.0f;
 }
 
-void Mapper069::save_state(std::vector<uint8_t>& data) {
+void Mapper069::save_state(StateWriter& data) {
     data.push_back(m_command);
 
     for (int i = 0; i < 4; i++) {
@@ -20,13 +20,18 @@ Mapper071::Mapper071(std::vector<uint8_t>& prg_rom,
     m_has_mirroring_control = true;
 
     reset();
+
+    // Unbanked 8KB CHR
+    map_chr_pages(0, 8, 0);
 }
 
 void Mapper071::reset() {
     m_prg_bank = 0;
     m_prg_bank_offset = 0;
+    map_prg_pages(0, 16, m_prg_bank_offset);
     // Last 16KB bank is fixed at $C000-$FFFF
     m_prg_fixed_offset = m_prg_rom->size() - 0x4000;
+    map_prg_pages(16, 16, m_prg_fixed_offset);
 }
 
 uint8_t Mapper071::cpu_read(uint16_t address) {
@@ -71,6 +76,7 @@ void Mapper071::cpu_write(uint16_t address, uint8_t value) {
     if (address >= 0xC000) {
         m_prg_bank = value & 0x0F;
         m_prg_bank_offset = (m_prg_bank * 0x4000) % m_prg_rom->size();
+        map_prg_pages(0, 16, m_prg_bank_offset);
     }
 }
 
@@ -88,12 +94,12 @@ void Mapper071::ppu_write(uint16_t address, uint8_t value) {
     // CHR RAM: $0000-$1FFF
     if (address < 0x2000) {
         if (!m_chr_rom->empty()) {
-            (*m_chr_rom)[address] = value;
+            write_chr_ram(address, value);
         }
     }
 }
 
-void Mapper071::save_state(std::vector<uint8_t>& data) {
+void Mapper071::save_state(StateWriter& data) {
     data.push_back(m_prg_bank);
     data.push_back(static_cast<uint8_t>(m_mirror_mode));
 }
@@ -105,6 +111,7 @@ void Mapper071::load_state(const uint8_t*& data, size_t& remaining) {
     m_mirror_mode = static_cast<MirrorMode>(*data++); remaining--;
 
     m_prg_bank_offset = (m_prg_bank * 0x4000) % m_prg_rom->size();
+    map_prg_pages(0, 16, m_prg_bank_offset);
 }
 
 } // namespace nes
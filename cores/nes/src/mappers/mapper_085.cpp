@@ -183,6 +183,7 @@ Mapper085::Mapper085(std::vector<uint8_t>& prg_rom,
     m_prg_ram = &prg_ram;
     m_mirror_mode = mirror;
     m_has_chr_ram = has_chr_ram;
+    m_hooks = HOOK_CPU_CYCLES | HOOK_IRQ;
 
     reset();
 }
@@ -256,6 +257,10 @@ void Mapper085::update_prg_banks() {
 
     // Fixed last bank at $E000
     m_prg_bank_offset[3] = (num_8k_banks - 1) * 0x2000;
+
+    for (int i = 0; i < 4; i++) {
+        map_prg_pages(i * 8, 8, m_prg_bank_offset[i]);
+    }
 }
 
 void Mapper085::update_chr_banks() {
@@ -267,6 +272,7 @@ void Mapper085::update_chr_banks() {
 
     for (int i = 0; i < 8; i++) {
         m_chr_bank_offset[i] = (m_chr_bank[i] % num_1k_banks) * 0x400;
+        map_chr_page(i, m_chr_bank_offset[i]);
     }
 }
 
@@ -304,7 +310,7 @@ void Mapper085::cpu_write(uint16_t address, uint8_t value) {
     // PRG RAM: $6000-$7FFF
     if (address >= 0x6000 && address < 0x8000) {
         if (!m_prg_ram->empty()) {
-            (*m_prg_ram)[address & 0x1FFF] = value;
+            write_prg_ram(address & 0x1FFF, value);
         }
         return;
     }
@@ -766,7 +772,7 @@ void Mapper085::ppu_write(uint16_t address, uint8_t value) {
         int bank = address / 0x400;
         uint32_t offset = m_chr_bank_offset[bank] + (address & 0x3FF);
         if (offset < m_chr_rom->size()) {
-            (*m_chr_rom)[offset] = value;
+            write_chr_ram(offset, value);
         }
     }
 }
@@ -816,7 +822,15 @@ void Mapper085::cpu_cycle() {
     cpu_cycles(1);
 }
 
-void Mapper085::save_state(std::vector<uint8_t>& data) {
+uint32_t Mapper085::cpu_cycles_until_irq() const {
+    if (!m_irq_mode_cycle || !m_irq_enabled) return UINT32_MAX;
+
+    // The prescaler overflow that clocks the counter past $FF
+    int first_tick = std::max(IRQ_PRESCALER_RELOAD - static_cast<int>(m_irq_prescaler), 1);
+    return static_cast<uint32_t>(first_tick) + (0xFFu - m_irq_counter) * IRQ_PRESCALER_RELOAD;
+}
+
+void Mapper085::save_state(StateWriter& data) {
     // PRG banks
     for (int i = 0; i < 3; i++) {
         data.push_back(m_prg_bank[i]);
@@ -43,13 +43,14 @@ public:
 
     void reset() override;
 
-    void save_state(std::vector<uint8_t>& data) override;
+    void save_state(StateWriter& data) override;
     void load_state(const uint8_t*& data, size_t& remaining) override;
 
     // CPU cycle notification for IRQ counter (cycle mode)
     // PERFORMANCE: Batched version - receives cycle count for efficient processing
     void cpu_cycles(int count) override;
     void cpu_cycle() override;
+    uint32_t cpu_cycles_until_irq() const override;
 
     // Get FM audio samples - returns mixed FM output for blending with APU
     // This should be called by the emulator's audio system
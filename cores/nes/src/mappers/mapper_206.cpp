@@ -42,6 +42,10 @@ void Mapper206::update_prg_banks() {
 
     // $E000-$FFFF: Fixed to last bank
     m_prg_bank_offsets[3] = (prg_size - 0x2000);
+
+    for (int i = 0; i < 4; i++) {
+        map_prg_pages(i * 8, 8, m_prg_bank_offsets[i]);
+    }
 }
 
 void Mapper206::update_chr_banks() {
@@ -60,6 +64,10 @@ void Mapper206::update_chr_banks() {
     m_chr_bank_offsets[5] = (m_registers[3] * 0x400) % chr_size;
     m_chr_bank_offsets[6] = (m_registers[4] * 0x400) % chr_size;
     m_chr_bank_offsets[7] = (m_registers[5] * 0x400) % chr_size;
+
+    for (int i = 0; i < 8; i++) {
+        map_chr_page(i, m_chr_bank_offsets[i]);
+    }
 }
 
 uint8_t Mapper206::cpu_read(uint16_t address) {
@@ -133,12 +141,12 @@ void Mapper206::ppu_write(uint16_t address, uint8_t value) {
         if (!m_chr_rom->empty()) {
             int bank = address / 0x400;
             uint32_t offset = m_chr_bank_offsets[bank] + (address & 0x3FF);
-            (*m_chr_rom)[offset % m_chr_rom->size()] = value;
+            write_chr_ram(offset % m_chr_rom->size(), value);
         }
     }
 }
 
-void Mapper206::save_state(std::vector<uint8_t>& data) {
+void Mapper206::save_state(StateWriter& data) {
     data.push_back(m_bank_select);
     for (int i = 0; i < 8; i++) {
         data.push_back(m_registers[i]);
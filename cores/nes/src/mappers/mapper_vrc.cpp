@@ -20,6 +20,9 @@ MapperVRC::MapperVRC(std::vector<uint8_t>& prg_rom,
     m_is_vrc4 = (variant == Variant::VRC4a || variant == Variant::VRC4b ||
                  variant == Variant::VRC4c || variant == Variant::VRC4d ||
                  variant == Variant::VRC4e || variant == Variant::VRC4f);
+    if (m_is_vrc4) {
+        m_hooks = HOOK_CPU_CYCLES | HOOK_IRQ;
+    }
 
     reset();
 }
@@ -109,6 +112,10 @@ void MapperVRC::update_prg_banks() {
         m_prg_bank_offset[2] = second_last * 0x2000;  // $C000
         m_prg_bank_offset[3] = last * 0x2000;         // $E000
     }
+
+    for (int i = 0; i < 4; i++) {
+        map_prg_pages(i * 8, 8, m_prg_bank_offset[i]);
+    }
 }
 
 void MapperVRC::update_chr_banks() {
@@ -133,6 +140,7 @@ void MapperVRC::update_chr_banks() {
             }
         }
         m_chr_bank_offset[i] = (bank % num_1k_banks) * 0x400;
+        map_chr_page(i, m_chr_bank_offset[i]);
     }
 }
 
@@ -172,7 +180,7 @@ void MapperVRC::cpu_write(uint16_t address, uint8_t value) {
     // PRG RAM: $6000-$7FFF
     if (address >= 0x6000 && address < 0x8000) {
         if (!m_prg_ram->empty()) {
-            (*m_prg_ram)[address & 0x1FFF] = value;
+            write_prg_ram(address & 0x1FFF, value);
         }
         return;
     }
@@ -292,7 +300,7 @@ void MapperVRC::ppu_write(uint16_t address, uint8_t value) {
         int bank = address / 0x400;
         uint32_t offset = m_chr_bank_offset[bank] + (address & 0x3FF);
         if (offset < m_chr_rom->size()) {
-            (*m_chr_rom)[offset] = value;
+            write_chr_ram(offset, value);
         }
     }
 }
@@ -341,7 +349,14 @@ void MapperVRC::cpu_cycle() {
     cpu_cycles(1);
 }
 
-void MapperVRC::save_state(std::vector<uint8_t>& data) {
+uint32_t MapperVRC::cpu_cycles_until_irq() const {
+    if (!m_is_vrc4 || !m_irq_mode_cycle || !m_irq_enabled) return UINT32_MAX;
+
+    // The prescaler underflow that clocks the counter past $FF
+    return m_irq_prescaler + 1u + (0xFFu - m_irq_counter) * IRQ_PRESCALER_RELOAD;
+}
+
+void MapperVRC::save_state(StateWriter& data) {
     data.push_back(m_prg_bank_0);
     data.push_back(m_prg_bank_1);
     data.push_back(m_prg_swap_mode ? 1 : 0);
@@ -1,12 +1,18 @@
 #include "emu/emulator_plugin.hpp"
 #include "emu/netplay_plugin.hpp"
+#include "emu/state_chunks.hpp"
+#include "emu/trace.hpp"
 #include "bus.hpp"
 #include "cpu.hpp"
 #include "ppu.hpp"
 #include "apu.hpp"
 #include "cartridge.hpp"
+#include "emu/state_writer.hpp"
+#include "state_hash.hpp"
 
 #include <imgui.h>
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <fstream>
@@ -56,8 +62,11 @@ public:
     // Emulation
     void reset() override;
     void run_frame(const emu::InputState& input) override;
+    void run_frames(const emu::InputState* inputs, size_t count, emu::RunFlags flags) override;
+    void set_input_poll(const emu::InputPoll& poll) override { m_bus->set_input_poll(poll); }
     uint64_t get_cycle_count() const override;
     uint64_t get_frame_count() const override;
+    bool is_lag_frame() const override { return m_rom_loaded && !m_bus->was_controller_read(); }
 
     // Video
     emu::FrameBuffer get_framebuffer() override;
@@ -67,20 +76,35 @@ public:
     void clear_audio_buffer() override;
 
     // Streaming audio (low-latency)
-    void set_audio_callback(AudioStreamCallback callback) override;
+    void set_audio_sink(const emu::AudioStreamSink& sink) override;
+    void set_audio_enabled(bool enabled) override;
+    void set_video_enabled(bool enabled) override;
+    bool set_output_framebuffer(uint32_t* pixels, int pitch) override;
+    const emu::ProfileMarker* get_profile_marker() const override { return &m_profile; }
+    void set_tracer(emu::Tracer* tracer) override { m_tracer = tracer; }
+    bool set_cpu_trace(emu::CpuTrace* trace) override;
 
     // Memory access
     uint8_t read_memory(uint16_t address) override;
     void write_memory(uint16_t address, uint8_t value) override;
+    std::vector<emu::MemoryDomain> get_memory_domains() override;
+    bool read_memory_block(size_t domain, uint32_t address, size_t length, uint8_t* out) override;
+    bool set_write_watchpoints(const uint32_t* addresses, size_t count) override;
+    size_t take_write_watch_hits(emu::WriteWatchHit* out, size_t max) override;
+    bool set_breakpoints(const emu::Breakpoint* breakpoints, size_t count) override;
+    size_t take_breakpoint_hits(emu::BreakpointHit* out, size_t max) override;
 
     // Save states
     bool save_state(std::vector<uint8_t>& data) override;
     bool load_state(const std::vector<uint8_t>& data) override;
+    bool load_state_chunks(const uint8_t* data, size_t size, const uint32_t* tags, size_t tag_count) override;
+    bool clone_into(emu::IEmulatorPlugin* other) override;
 
     // Battery-backed save support
     bool has_battery_save() const override;
     std::vector<uint8_t> get_battery_save_data() const override;
     bool set_battery_save_data(const std::vector<uint8_t>& data) override;
+    uint64_t get_battery_save_generation() const override;
 
     // =========================================================================
     // INetplayCapable implementation - Netplay/Rollback support
@@ -96,12 +120,13 @@ public:
     void run_frame_netplay(uint32_t player1_buttons, uint32_t player2_buttons) override;
 
     // N-player netplay variant - delegates to 2-player version for NES
-    void run_frame_netplay_n(const std::vector<uint32_t>& player_inputs) override {
-        uint32_t p1 = player_inputs.size() > 0 ? player_inputs[0] : 0;
-        uint32_t p2 = player_inputs.size() > 1 ? player_inputs[1] : 0;
-        run_frame_netplay(p1, p2);
+    void run_frame_netplay_n(const emu::NetplayFrameInputs& inputs) override {
+        run_frame_netplay(inputs.buttons[0], inputs.buttons[1]);
     }
 
+    // Buttons are read from the VirtualButton bits A through Right
+    int get_input_bits() const override { return 12; }
+
     // Maximum players supported (NES supports 2 standard controllers)
     int get_max_players() const override { return 2; }
 
@@ -112,6 +137,7 @@ public:
 
     // State hash for desync detection
     uint64_t get_state_hash() const override;
+    int get_state_hash_components(emu::StateHashComponent* out, int max) const override;
 
     // Discard audio during rollback re-simulation
     void discard_audio() override { m_audio_samples = 0; }
@@ -122,6 +148,7 @@ public:
 
     // Check if core requests fast/uncapped mode
     bool is_fast_mode_enabled() const override { return m_fast_mode; }
+    void set_enhancements_allowed(bool allowed) override { m_enhancements_allowed = allowed; }
 
     // Configuration GUI support
     bool has_config_gui() const override { return true; }
@@ -138,10 +165,23 @@ private:
     // Internal run_frame that takes both player inputs
     void run_frame_internal(uint32_t player1_buttons, uint32_t player2_buttons);
 
-    // Fast serialization helpers (write directly to buffer)
-    size_t serialize_state(uint8_t* buffer) const;
+    // Run the CPU alone for m_overclock_lines scanlines' worth of cycles
+    void run_overclock();
+
+    // Shared serialization helpers - used by both the vector-based and the
+    // in-place (rollback) save state paths
+    void serialize_state(StateWriter& out);
     bool deserialize_state(const uint8_t* buffer, size_t size);
 
+    // Chunks with the given tags (all of them for a null list), or a state
+    // from before chunking
+    bool deserialize_chunks(const uint8_t* buffer, size_t size, const uint32_t* tags, size_t tag_count);
+    bool load_state_chunk(const emu::StateChunk& chunk);
+    bool deserialize_unchunked_state(const uint8_t* buffer, size_t size);
+
+    // Domain index of get_memory_domains(); false past the last
+    bool get_memory_domain(size_t index, emu::MemoryDomain& domain) const;
+
 private:
     std::unique_ptr<Bus> m_bus;
     std::unique_ptr<CPU> m_cpu;
@@ -149,24 +189,52 @@ private:
     std::unique_ptr<APU> m_apu;
     std::unique_ptr<Cartridge> m_cartridge;
 
+    // Set on the bus only while it watches something
+    emu::WriteWatchpoints m_write_watch;
+
+    // Set on the CPU and bus only while they have a breakpoint to check;
+    // 256-byte pages of the 16-bit bus
+    emu::Breakpoints m_breakpoints{16, 8};
+
     bool m_rom_loaded = false;
+    bool m_video_enabled = true;  // False = frames run without drawing
     uint32_t m_rom_crc32 = 0;
     uint64_t m_total_cycles = 0;
     uint64_t m_frame_count = 0;
 
     // Framebuffer
     uint32_t m_framebuffer[256 * 240];
+    uint32_t* m_output_framebuffer = nullptr;       // Host buffer frames are drawn into, if set
+    uint32_t* m_shown_framebuffer = m_framebuffer;  // Holds the last frame drawn
 
     // Audio buffer
     static constexpr size_t AUDIO_BUFFER_SIZE = 2048;
     float m_audio_buffer[AUDIO_BUFFER_SIZE * 2];  // Stereo
     size_t m_audio_samples = 0;
 
+    // Scratch buffer for the CPU/APU part of get_state_hash()
+    mutable std::vector<uint8_t> m_hash_scratch;
+
+    // clone_into() stages the state here, on the receiving instance
+    std::vector<uint8_t> m_clone_state;
+
     // Configuration options
     bool m_fast_mode = false;           // Run at uncapped speed when true
+    static constexpr int MAX_OVERCLOCK_LINES = 1000;
+    int m_overclock_lines = 0;          // Extra CPU-only scanlines at VBlank
+    bool m_enhancements_allowed = true; // Host switch for m_overclock_lines
     bool m_disable_sprite_limit = false; // Allow >8 sprites per scanline when true
     bool m_crop_overscan = false;        // Hide top/bottom 8 rows (typically hidden on CRT TVs)
 
+    // Subsystem being run, for the benchmark's breakdown
+    emu::ProfileMarker m_profile;
+
+    // Frame phase tracing, if the host is recording
+    emu::Tracer* m_tracer = nullptr;
+
+    // Frames until the next test ROM output check
+    int m_test_check_interval = 0;
+
     // File extensions
     static const char* s_extensions[];
 };
@@ -188,6 +256,9 @@ NESPlugin::NESPlugin() {
     m_bus->connect_ppu(m_ppu.get());
     m_bus->connect_apu(m_apu.get());
     m_bus->connect_cartridge(m_cartridge.get());
+    m_bus->set_profile_marker(&m_profile);
+    m_write_watch.set_clock(&m_total_cycles);
+    m_breakpoints.set_clock(&m_total_cycles);
 }
 
 NESPlugin::~NESPlugin() = default;
@@ -244,7 +315,9 @@ uint32_t NESPlugin::get_rom_crc32() const {
 
 void NESPlugin::reset() {
     m_cpu->reset();
+    m_bus->sync_ppu();  // Settle PPU dots owed from the reset vector fetch
     m_ppu->reset();
+    m_bus->reset_ppu_sync();
     m_apu->reset();
     m_total_cycles = 0;
     m_frame_count = 0;
@@ -257,6 +330,25 @@ void NESPlugin::run_frame(const emu::InputState& input) {
     run_frame_internal(input.buttons, 0);
 }
 
+void NESPlugin::run_frames(const emu::InputState* inputs, size_t count, emu::RunFlags flags) {
+    if (!m_rom_loaded || count == 0) return;
+
+    // Output is switched once around the batch instead of per frame, and the
+    // frames run straight through without going back through the interface
+    bool skip_video = (flags & emu::RUN_FLAGS_SKIP_VIDEO) && count > 1;
+    bool skip_audio = (flags & emu::RUN_FLAGS_SKIP_AUDIO) && count > 1;
+    if (skip_video) set_video_enabled(false);
+    if (skip_audio) set_audio_enabled(false);
+
+    for (size_t i = 0; i + 1 < count; i++) {
+        run_frame_internal(inputs[i].buttons, 0);
+    }
+
+    if (skip_video) set_video_enabled(true);
+    if (skip_audio) set_audio_enabled(true);
+    run_frame_internal(inputs[count - 1].buttons, 0);
+}
+
 void NESPlugin::run_frame_netplay(uint32_t player1_buttons, uint32_t player2_buttons) {
     // Netplay version - accepts input for both players
     // Input is already in NES format (A, B, Select, Start, Up, Down, Left, Right)
@@ -266,10 +358,21 @@ void NESPlugin::run_frame_netplay(uint32_t player1_buttons, uint32_t player2_but
 void NESPlugin::run_frame_internal(uint32_t player1_buttons, uint32_t player2_buttons) {
     if (!m_rom_loaded) return;
 
+    // The CPU drives the frame; Bus::tick() marks the PPU and APU
+    emu::ProfileScope profile(m_profile, emu::ProfileSection::CPU);
+    EMU_TRACE_SCOPE(m_tracer, "nes", "frame");
+    if (!m_write_watch.empty()) m_write_watch.begin_frame(m_total_cycles);
+    if (!m_breakpoints.empty()) m_breakpoints.begin_frame(m_total_cycles);
+
     // Set controller state BEFORE running the frame
     // This ensures NMI handlers can read the current input
     m_bus->set_controller_state(0, player1_buttons);
     m_bus->set_controller_state(1, player2_buttons);
+    m_bus->clear_controller_read();
+
+    // A state load or reset since the last frame may have moved the
+    // mapper's IRQ counters, so let it re-pick its batch size
+    m_bus->sync_mapper();
 
     // Run until PPU signals frame completion (at VBlank start)
     // With cycle-accurate mode, PPU and APU are ticked during each CPU memory access
@@ -287,9 +390,7 @@ void NESPlugin::run_frame_internal(uint32_t player1_buttons, uint32_t player2_bu
             // Check for NMI during DMA - it will be pending when DMA completes
             // The bus tick() already triggers NMI detection via check_nmi()
             // but we also need to poll for IRQ changes
-            bool mapper_irq = m_bus->mapper_irq_pending(m_ppu->get_frame_cycle());
-            bool apu_irq = m_apu->irq_pending();
-            m_cpu->set_irq_line(mapper_irq || apu_irq);
+            m_cpu->set_irq_line(m_bus->poll_irq_status());
 
             // Check for frame completion during DMA
             if (m_ppu->check_frame_complete()) {
@@ -312,34 +413,73 @@ void NESPlugin::run_frame_internal(uint32_t player1_buttons, uint32_t player2_bu
         }
 
         // Check for mapper IRQ and APU IRQ at instruction boundary
-        bool mapper_irq = m_bus->mapper_irq_pending(m_ppu->get_frame_cycle());
-        bool apu_irq = m_apu->irq_pending();
-        m_cpu->set_irq_line(mapper_irq || apu_irq);
+        m_cpu->set_irq_line(m_bus->poll_irq_status());
 
         // Check for frame completion
         if (m_ppu->check_frame_complete()) {
             frame_complete = true;
             // Check for test ROM output once per frame
-            static int check_interval = 0;
-            if (++check_interval >= 30) {
-                check_interval = 0;
+            if (++m_test_check_interval >= 30) {
+                m_test_check_interval = 0;
                 m_bus->check_test_output();
             }
         }
+    }
 
-        // Get expansion audio from mapper and pass to APU for mixing
-        float expansion_audio = m_bus->get_mapper_audio();
-        m_apu->set_expansion_audio(expansion_audio);
+    // The frame ends as VBlank starts, so overclocked lines go here, with
+    // the NMI already on its way to the CPU
+    if (m_overclock_lines > 0 && m_enhancements_allowed) {
+        run_overclock();
     }
 
-    // Copy PPU framebuffer - now guaranteed to be at the correct frame boundary
-    const uint32_t* ppu_fb = m_ppu->get_framebuffer();
-    std::memcpy(m_framebuffer, ppu_fb, sizeof(m_framebuffer));
+    // Catch the PPU and mapper up to the CPU so save states and hashes
+    // taken between frames are identical in both scheduling modes
+    {
+        EMU_TRACE_SCOPE(m_tracer, "nes", "ppu sync");
+        m_bus->sync_ppu();
+        m_bus->sync_mapper();
+    }
+
+    // Convert the PPU's color indices - now guaranteed to be at the correct
+    // frame boundary (kept at the last shown frame while video is off)
+    if (m_video_enabled) {
+        EMU_TRACE_SCOPE(m_tracer, "nes", "video");
+        m_profile.set(emu::ProfileSection::PPU);
+        uint32_t* out = m_output_framebuffer ? m_output_framebuffer : m_framebuffer;
+        m_ppu->convert_framebuffer(out);
+        m_shown_framebuffer = out;
+    }
 
     // Get audio samples
-    m_audio_samples = m_apu->get_samples(m_audio_buffer, AUDIO_BUFFER_SIZE);
+    {
+        EMU_TRACE_SCOPE(m_tracer, "nes", "audio");
+        m_profile.set(emu::ProfileSection::APU);
+        m_audio_samples = m_apu->get_samples(m_audio_buffer, AUDIO_BUFFER_SIZE);
+    }
 
     m_frame_count++;
+    if (!m_write_watch.empty()) m_write_watch.end_frame(m_total_cycles, m_frame_count);
+    if (!m_breakpoints.empty()) m_breakpoints.end_frame(m_total_cycles, m_frame_count);
+}
+
+void NESPlugin::run_overclock() {
+    EMU_TRACE_SCOPE(m_tracer, "nes", "overclock");
+    int budget = m_overclock_lines * 341 / 3;
+
+    m_bus->set_cpu_only(true);
+    for (int cycles = 0; cycles < budget;) {
+        // OAM DMA started from the NMI handler still takes its cycles
+        if (m_bus->is_dma_active()) {
+            m_bus->run_dma_cycle();
+            cycles++;
+            m_total_cycles++;
+        } else {
+            int cpu_cycles = m_cpu->step();
+            cycles += cpu_cycles;
+            m_total_cycles += cpu_cycles;
+        }
+    }
+    m_bus->set_cpu_only(false);
 }
 
 uint64_t NESPlugin::get_cycle_count() const {
@@ -352,7 +492,7 @@ uint64_t NESPlugin::get_frame_count() const {
 
 emu::FrameBuffer NESPlugin::get_framebuffer() {
     emu::FrameBuffer fb;
-    fb.pixels = m_framebuffer;
+    fb.pixels = m_shown_framebuffer;
     fb.width = 256;
     fb.height = 240;
     return fb;
@@ -362,7 +502,7 @@ emu::AudioBuffer NESPlugin::get_audio() {
     emu::AudioBuffer ab;
     ab.samples = m_audio_buffer;
     ab.sample_count = static_cast<int>(m_audio_samples);
-    ab.sample_rate = 44100;
+    ab.sample_rate = m_apu->get_sample_rate();
     return ab;
 }
 
@@ -370,25 +510,44 @@ void NESPlugin::clear_audio_buffer() {
     m_audio_samples = 0;
 }
 
-void NESPlugin::set_audio_callback(AudioStreamCallback callback) {
+void NESPlugin::set_audio_sink(const emu::AudioStreamSink& sink) {
     // Store in base class
-    m_audio_callback = callback;
+    m_audio_sink = sink;
 
     // Forward to APU for direct streaming
     if (m_apu) {
-        if (callback) {
-            m_apu->set_audio_callback([callback](const float* samples, size_t count, int rate) {
-                callback(samples, count, rate);
-            });
-        } else {
-            m_apu->set_audio_callback(nullptr);
-        }
+        m_apu->set_audio_sink(sink);
     }
 }
 
+void NESPlugin::set_audio_enabled(bool enabled) {
+    if (m_apu) {
+        m_apu->set_audio_enabled(enabled);
+    }
+}
+
+void NESPlugin::set_video_enabled(bool enabled) {
+    m_video_enabled = enabled;
+    if (m_ppu) {
+        m_ppu->set_video_enabled(enabled);
+    }
+}
+
+bool NESPlugin::set_output_framebuffer(uint32_t* pixels, int pitch) {
+    if (pixels && pitch != 256) return false;
+
+    // Keep the last frame when going back to our own buffer
+    if (!pixels && m_shown_framebuffer != m_framebuffer) {
+        std::memcpy(m_framebuffer, m_shown_framebuffer, sizeof(m_framebuffer));
+        m_shown_framebuffer = m_framebuffer;
+    }
+    m_output_framebuffer = pixels;
+    return true;
+}
+
 uint8_t NESPlugin::read_memory(uint16_t address) {
-    // Use peek to avoid side effects (ticking PPU/APU) for debugging
-    return m_bus->cpu_peek(address);
+    // No side effects: the registers read as open bus (see debug_peek)
+    return m_bus->debug_peek(address);
 }
 
 void NESPlugin::write_memory(uint16_t address, uint8_t value) {
@@ -397,6 +556,72 @@ void NESPlugin::write_memory(uint16_t address, uint8_t value) {
     m_bus->cpu_write(address, value);
 }
 
+bool NESPlugin::get_memory_domain(size_t index, emu::MemoryDomain& domain) const {
+    auto vector_domain = [](const char* name, const std::vector<uint8_t>& data) {
+        return emu::MemoryDomain{name, static_cast<uint32_t>(data.size()), data.data()};
+    };
+    switch (index) {
+        case 0: domain = {"CPU Bus", 0x10000, nullptr}; return true;
+        case 1: domain = {"WRAM", 0x800, m_bus->get_ram_data()}; return true;
+        case 2: domain = {"Nametables", 0x800, m_ppu->get_nametable_data()}; return true;
+        case 3: domain = {"Palette", 0x20, m_ppu->get_palette_data()}; return true;
+        case 4: domain = {"OAM", 0x100, m_ppu->get_oam_data()}; return true;
+        case 5: domain = vector_domain("SRAM", m_cartridge->get_prg_ram()); return true;
+        case 6: domain = vector_domain("PRG ROM", m_cartridge->get_prg_rom()); return true;
+        case 7: domain = vector_domain("CHR", m_cartridge->get_chr_rom()); return true;
+        default: return false;
+    }
+}
+
+bool NESPlugin::set_write_watchpoints(const uint32_t* addresses, size_t count) {
+    m_write_watch.set(addresses, count);
+    m_bus->set_write_watch(m_write_watch.empty() ? nullptr : &m_write_watch);
+    return true;
+}
+
+bool NESPlugin::set_cpu_trace(emu::CpuTrace* trace) {
+    if (trace) trace->set_clock(&m_total_cycles);
+    m_cpu->set_trace(trace);
+    return true;
+}
+
+size_t NESPlugin::take_write_watch_hits(emu::WriteWatchHit* out, size_t max) {
+    return m_write_watch.take(out, max);
+}
+
+bool NESPlugin::set_breakpoints(const emu::Breakpoint* breakpoints, size_t count) {
+    m_breakpoints.set(breakpoints, count);
+    uint8_t kinds = m_breakpoints.kinds();
+    m_cpu->set_breakpoints(kinds & emu::BREAK_EXECUTE ? &m_breakpoints : nullptr);
+    m_bus->set_breakpoints(kinds & (emu::BREAK_READ | emu::BREAK_WRITE) ? &m_breakpoints : nullptr);
+    return true;
+}
+
+size_t NESPlugin::take_breakpoint_hits(emu::BreakpointHit* out, size_t max) {
+    return m_breakpoints.take(out, max);
+}
+
+std::vector<emu::MemoryDomain> NESPlugin::get_memory_domains() {
+    std::vector<emu::MemoryDomain> domains;
+    emu::MemoryDomain domain;
+    for (size_t i = 0; get_memory_domain(i, domain); i++) {
+        domains.push_back(domain);
+    }
+    return domains;
+}
+
+bool NESPlugin::read_memory_block(size_t domain, uint32_t address, size_t length, uint8_t* out) {
+    if (domain == 0) {
+        if (address > 0x10000 || length > 0x10000 - address) return false;
+        for (size_t i = 0; i < length; i++) {
+            out[i] = m_bus->debug_peek(static_cast<uint16_t>(address + i));
+        }
+        return true;
+    }
+    emu::MemoryDomain info;
+    return get_memory_domain(domain, info) && emu::copy_memory_domain(info, address, length, out);
+}
+
 bool NESPlugin::save_state(std::vector<uint8_t>& data) {
     if (!m_rom_loaded) return false;
 
@@ -406,20 +631,8 @@ bool NESPlugin::save_state(std::vector<uint8_t>& data) {
         // Reserve some space for efficiency
         data.reserve(32 * 1024);  // 32KB should be plenty
 
-        // Save frame count
-        const uint8_t* fc_ptr = reinterpret_cast<const uint8_t*>(&m_frame_count);
-        data.insert(data.end(), fc_ptr, fc_ptr + sizeof(m_frame_count));
-
-        const uint8_t* tc_ptr = reinterpret_cast<const uint8_t*>(&m_total_cycles);
-        data.insert(data.end(), tc_ptr, tc_ptr + sizeof(m_total_cycles));
-
-        // Save each component
-        m_cpu->save_state(data);
-        m_ppu->save_state(data);
-        m_apu->save_state(data);
-        m_bus->save_state(data);
-        m_cartridge->save_state(data);
-
+        StateWriter writer(data);
+        serialize_state(writer);
         return true;
     } catch (...) {
         return false;
@@ -430,32 +643,112 @@ bool NESPlugin::load_state(const std::vector<uint8_t>& data) {
     if (!m_rom_loaded || data.empty()) return false;
 
     try {
-        const uint8_t* ptr = data.data();
-        size_t remaining = data.size();
+        return deserialize_state(data.data(), data.size());
+    } catch (...) {
+        return false;
+    }
+}
 
-        // Load frame count
-        if (remaining < sizeof(m_frame_count) + sizeof(m_total_cycles)) {
+bool NESPlugin::load_state_chunks(const uint8_t* data, size_t size, const uint32_t* tags, size_t tag_count) {
+    if (!m_rom_loaded || !data || !tags || tag_count == 0) return false;
+    return deserialize_chunks(data, size, tags, tag_count);
+}
+
+// Layout version of every chunk this core writes; bump a chunk's own when
+// its subsystem's save_state() changes, and keep loading the old one
+static constexpr uint16_t NES_CHUNK_VERSION = 1;
+
+void NESPlugin::serialize_state(StateWriter& out) {
+    emu::write_state_chunks_magic(out);
+
+    emu::write_state_chunk(out, emu::STATE_CHUNK_TIMING, NES_CHUNK_VERSION, [&] {
+        out.write(&m_frame_count, sizeof(m_frame_count));
+        out.write(&m_total_cycles, sizeof(m_total_cycles));
+    });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_CPU, NES_CHUNK_VERSION, [&] { m_cpu->save_state(out); });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_PPU, NES_CHUNK_VERSION, [&] { m_ppu->save_state(out); });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_APU, NES_CHUNK_VERSION, [&] { m_apu->save_state(out); });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_WORK_RAM, NES_CHUNK_VERSION, [&] { m_bus->save_work_ram(out); });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_BUS, NES_CHUNK_VERSION, [&] { m_bus->save_registers(out); });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_CARTRIDGE, NES_CHUNK_VERSION, [&] { m_cartridge->save_state(out); });
+}
+
+bool NESPlugin::deserialize_state(const uint8_t* buffer, size_t size) {
+    return deserialize_chunks(buffer, size, nullptr, 0);
+}
+
+bool NESPlugin::deserialize_chunks(const uint8_t* buffer, size_t size, const uint32_t* tags, size_t tag_count) {
+    emu::StateChunkReader reader(buffer, size);
+    if (!reader.is_chunked()) {
+        // Old states can only be loaded whole
+        return !tags && deserialize_unchunked_state(buffer, size);
+    }
+
+    bool loaded = false;
+    emu::StateChunk chunk;
+    while (reader.next(chunk)) {
+        if (!emu::state_chunk_selected(chunk.tag, tags, tag_count)) continue;
+        if (chunk.version > NES_CHUNK_VERSION) {
+            std::cerr << "[NES] Save state is from a newer version" << std::endl;
             return false;
         }
-        std::memcpy(&m_frame_count, ptr, sizeof(m_frame_count));
-        ptr += sizeof(m_frame_count);
-        remaining -= sizeof(m_frame_count);
+        if (!load_state_chunk(chunk)) {
+            return false;
+        }
+        loaded = true;
+    }
+    return loaded && !reader.malformed();
+}
 
-        std::memcpy(&m_total_cycles, ptr, sizeof(m_total_cycles));
-        ptr += sizeof(m_total_cycles);
-        remaining -= sizeof(m_total_cycles);
+bool NESPlugin::load_state_chunk(const emu::StateChunk& chunk) {
+    const uint8_t* ptr = chunk.data;
+    size_t remaining = chunk.size;
+
+    switch (chunk.tag) {
+        case emu::STATE_CHUNK_TIMING:
+            if (remaining < sizeof(m_frame_count) + sizeof(m_total_cycles)) return false;
+            std::memcpy(&m_frame_count, ptr, sizeof(m_frame_count));
+            std::memcpy(&m_total_cycles, ptr + sizeof(m_frame_count), sizeof(m_total_cycles));
+            return true;
+        case emu::STATE_CHUNK_CPU: m_cpu->load_state(ptr, remaining); break;
+        case emu::STATE_CHUNK_PPU: m_ppu->load_state(ptr, remaining); break;
+        case emu::STATE_CHUNK_APU: m_apu->load_state(ptr, remaining); break;
+        case emu::STATE_CHUNK_WORK_RAM: m_bus->load_work_ram(ptr, remaining); break;
+        case emu::STATE_CHUNK_BUS: m_bus->load_registers(ptr, remaining); break;
+        case emu::STATE_CHUNK_CARTRIDGE: m_cartridge->load_state(ptr, remaining); break;
+        default:
+            return true;  // Written by a newer build; skipped
+    }
 
-        // Load each component
-        m_cpu->load_state(ptr, remaining);
-        m_ppu->load_state(ptr, remaining);
-        m_apu->load_state(ptr, remaining);
-        m_bus->load_state(ptr, remaining);
-        m_cartridge->load_state(ptr, remaining);
+    // Not every component loader checks sizes; one that read past its
+    // chunk has wrapped the count
+    return remaining <= chunk.size;
+}
 
-        return true;
-    } catch (...) {
+bool NESPlugin::deserialize_unchunked_state(const uint8_t* buffer, size_t size) {
+    const uint8_t* ptr = buffer;
+    size_t remaining = size;
+
+    // Load frame count
+    if (remaining < sizeof(m_frame_count) + sizeof(m_total_cycles)) {
         return false;
     }
+    std::memcpy(&m_frame_count, ptr, sizeof(m_frame_count));
+    ptr += sizeof(m_frame_count);
+    remaining -= sizeof(m_frame_count);
+
+    std::memcpy(&m_total_cycles, ptr, sizeof(m_total_cycles));
+    ptr += sizeof(m_total_cycles);
+    remaining -= sizeof(m_total_cycles);
+
+    // Load each component
+    m_cpu->load_state(ptr, remaining);
+    m_ppu->load_state(ptr, remaining);
+    m_apu->load_state(ptr, remaining);
+    m_bus->load_state(ptr, remaining);
+    m_cartridge->load_state(ptr, remaining);
+
+    return true;
 }
 
 bool NESPlugin::has_battery_save() const {
@@ -476,6 +769,10 @@ bool NESPlugin::set_battery_save_data(const std::vector<uint8_t>& data) {
     return m_cartridge->set_save_data(data);
 }
 
+uint64_t NESPlugin::get_battery_save_generation() const {
+    return m_cartridge ? m_cartridge->get_save_generation() : 0;
+}
+
 // =============================================================================
 // INetplayCapable Implementation - Fast Save State for Rollback
 // =============================================================================
@@ -506,19 +803,16 @@ size_t NESPlugin::save_state_fast(uint8_t* buffer, size_t buffer_size) {
         return 0;  // Buffer too small
     }
 
-    // Use vector-based save_state and copy to buffer
-    // This is simple and correct; optimization can come later if profiling shows need
-    std::vector<uint8_t> state_data;
-    if (!save_state(state_data)) {
-        return 0;
-    }
+    // Serialize in place - every component writes straight into the
+    // caller's buffer through the cursor, so rollback never allocates
+    StateWriter writer(buffer, buffer_size);
+    serialize_state(writer);
 
-    if (state_data.size() > buffer_size) {
+    if (writer.overflowed()) {
         return 0;  // Shouldn't happen with proper max size estimation
     }
 
-    std::memcpy(buffer, state_data.data(), state_data.size());
-    return state_data.size();
+    return writer.size();
 }
 
 bool NESPlugin::load_state_fast(const uint8_t* buffer, size_t size) {
@@ -526,82 +820,67 @@ bool NESPlugin::load_state_fast(const uint8_t* buffer, size_t size) {
         return false;
     }
 
-    // Use vector-based load_state
-    // This is simple and correct; optimization can come later if profiling shows need
-    std::vector<uint8_t> state_data(buffer, buffer + size);
-    return load_state(state_data);
+    // Components read directly from the caller's buffer
+    return deserialize_state(buffer, size);
+}
+
+bool NESPlugin::clone_into(emu::IEmulatorPlugin* other) {
+    auto* target = dynamic_cast<NESPlugin*>(other);
+    if (!target || target == this || !m_rom_loaded || !target->m_rom_loaded ||
+        target->m_rom_crc32 != m_rom_crc32) {
+        return false;
+    }
+
+    // Through the fast state path; after the first clone nothing allocates
+    target->m_clone_state.resize(get_max_state_size());
+    size_t size = save_state_fast(target->m_clone_state.data(), target->m_clone_state.size());
+    return size > 0 && target->load_state_fast(target->m_clone_state.data(), size);
 }
 
 // =============================================================================
 // INetplayCapable Implementation - State Hash for Desync Detection
 // =============================================================================
 
-// FNV-1a hash implementation for state hashing
-// This is a fast, non-cryptographic hash suitable for desync detection
-static uint64_t fnv1a_hash(const uint8_t* data, size_t size) {
-    const uint64_t FNV_PRIME = 0x100000001b3ULL;
-    const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
-
-    uint64_t hash = FNV_OFFSET_BASIS;
-    for (size_t i = 0; i < size; i++) {
-        hash ^= data[i];
-        hash *= FNV_PRIME;
-    }
-    return hash;
-}
-
 uint64_t NESPlugin::get_state_hash() const {
     if (!m_rom_loaded) return 0;
 
-    // Hash the critical emulation state for desync detection
-    // We want to hash:
-    // - CPU registers
-    // - PPU state (excluding framebuffer which is output-only)
-    // - APU state (excluding audio buffer)
-    // - RAM
-    // - Controller state
-
-    // For efficiency, we hash a quick snapshot of the most critical state
-    // A full state hash would be more thorough but slower
-
-    uint64_t hash = 0;
-
-    // Hash frame count and cycle count
-    hash ^= fnv1a_hash(reinterpret_cast<const uint8_t*>(&m_frame_count), sizeof(m_frame_count));
-    hash ^= fnv1a_hash(reinterpret_cast<const uint8_t*>(&m_total_cycles), sizeof(m_total_cycles));
-
-    // Hash CPU registers
-    uint8_t cpu_state[8];
-    cpu_state[0] = static_cast<uint8_t>(m_cpu->get_pc() & 0xFF);
-    cpu_state[1] = static_cast<uint8_t>(m_cpu->get_pc() >> 8);
-    cpu_state[2] = m_cpu->get_a();
-    cpu_state[3] = m_cpu->get_x();
-    cpu_state[4] = m_cpu->get_y();
-    cpu_state[5] = m_cpu->get_sp();
-    cpu_state[6] = m_cpu->get_status();
-    cpu_state[7] = 0;  // Padding
-    hash ^= fnv1a_hash(cpu_state, sizeof(cpu_state));
-
-    // Hash RAM through bus peeks (first 256 bytes as quick check)
-    // For full sync verification, consider hashing all 2KB
-    // Use cpu_peek to avoid side effects (ticking PPU/APU)
-    uint8_t ram_sample[256];
-    for (int i = 0; i < 256; i++) {
-        ram_sample[i] = m_bus->cpu_peek(static_cast<uint16_t>(i));
-    }
-    hash ^= fnv1a_hash(ram_sample, sizeof(ram_sample));
-
-    // Hash some critical PPU state by reading a few key memory locations
-    uint8_t ppu_sample[32];
-    for (int i = 0; i < 32; i++) {
-        // Read from PPU palette memory (most likely to differ on desync)
-        ppu_sample[i] = m_bus->ppu_read(0x3F00 + i, 0);
-    }
-    hash ^= fnv1a_hash(ppu_sample, sizeof(ppu_sample));
+    // Hash everything the save state captures. CPU and APU state is small
+    // and hashed in full; RAM, nametables and PRG/CHR RAM go through the
+    // components' dirty-page caches, so the cost follows the bytes written
+    // since the last call rather than the total state size. This is cheap
+    // enough to check every frame.
+    uint64_t hash = state_hash::hash_serialized(m_hash_scratch, [this](StateWriter& out) {
+        out.write(&m_frame_count, sizeof(m_frame_count));
+        out.write(&m_total_cycles, sizeof(m_total_cycles));
+        m_cpu->save_state(out);
+        m_apu->save_state(out);
+    });
+    hash = state_hash::combine(hash, m_ppu->get_state_hash());
+    hash = state_hash::combine(hash, m_bus->get_state_hash());
+    hash = state_hash::combine(hash, m_cartridge->get_state_hash());
 
     return hash;
 }
 
+int NESPlugin::get_state_hash_components(emu::StateHashComponent* out, int max) const {
+    if (!m_rom_loaded || max < 5) return 0;
+
+    // The same parts get_state_hash() combines, with the frame and cycle
+    // counters counted as CPU state
+    out[0] = {"CPU", state_hash::hash_serialized(m_hash_scratch, [this](StateWriter& writer) {
+        writer.write(&m_frame_count, sizeof(m_frame_count));
+        writer.write(&m_total_cycles, sizeof(m_total_cycles));
+        m_cpu->save_state(writer);
+    })};
+    out[1] = {"PPU", m_ppu->get_state_hash()};
+    out[2] = {"APU", state_hash::hash_serialized(m_hash_scratch, [this](StateWriter& writer) {
+        m_apu->save_state(writer);
+    })};
+    out[3] = {"RAM", m_bus->get_state_hash()};
+    out[4] = {"Mapper", m_cartridge->get_state_hash()};
+    return 5;
+}
+
 // =============================================================================
 // Configuration GUI Implementation
 // =============================================================================
@@ -632,6 +911,8 @@ void NESPlugin::render_config_gui_content() {
         // Fast mode checkbox
         if (ImGui::Checkbox("Fast Mode (Uncapped Speed)", &m_fast_mode)) {
             // Setting is applied immediately via is_fast_mode_enabled()
+            // Fast mode also switches the PPU to catch-up scheduling
+            m_bus->set_cycle_accurate(!m_fast_mode);
         }
 
         // Help text
@@ -657,6 +938,36 @@ void NESPlugin::render_config_gui_content() {
         } else {
             ImGui::TextColored(ImVec4(0.4f, 1.0f, 0.4f, 1.0f), "Running at CYCLE-ACCURATE speed (default)");
         }
+
+        // Overclock
+        ImGui::Spacing();
+        if (ImGui::SliderInt("Overclock Lines", &m_overclock_lines, 0, MAX_OVERCLOCK_LINES)) {
+            m_overclock_lines = std::clamp(m_overclock_lines, 0, MAX_OVERCLOCK_LINES);
+        }
+        ImGui::SameLine();
+        ImGui::TextDisabled("(?)");
+        if (ImGui::IsItemHovered()) {
+            ImGui::BeginTooltip();
+            ImGui::PushTextWrapPos(ImGui::GetFontSize() * 25.0f);
+            ImGui::TextUnformatted(
+                "Adds scanlines at the start of VBlank in which only the CPU "
+                "runs, so games that slow down with many sprites on screen "
+                "get more time per frame. Picture, sound and NMI timing stay "
+                "the same.\n\n"
+                "This is NOT accurate to real hardware and some games may "
+                "misbehave. It is turned off during netplay and while a TAS "
+                "movie is open."
+            );
+            ImGui::PopTextWrapPos();
+            ImGui::EndTooltip();
+        }
+        if (m_overclock_lines > 0) {
+            if (m_enhancements_allowed) {
+                ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.0f, 1.0f), "Overclocked (not accurate)");
+            } else {
+                ImGui::TextDisabled("Overclock off for netplay or TAS");
+            }
+        }
     }
 
     // Video / Graphics Section
@@ -728,6 +1039,7 @@ bool NESPlugin::save_config(const char* path) {
     // Simple JSON format
     file << "{\n";
     file << "  \"fast_mode\": " << (m_fast_mode ? "true" : "false") << ",\n";
+    file << "  \"overclock_lines\": " << m_overclock_lines << ",\n";
     file << "  \"disable_sprite_limit\": " << (m_disable_sprite_limit ? "true" : "false") << ",\n";
     file << "  \"crop_overscan\": " << (m_crop_overscan ? "true" : "false") << "\n";
     file << "}\n";
@@ -754,6 +1066,13 @@ bool NESPlugin::load_config(const char* path) {
         m_fast_mode = (true_pos != std::string::npos && (false_pos == std::string::npos || true_pos < false_pos));
     }
 
+    // Parse overclock_lines
+    pos = content.find("\"overclock_lines\":");
+    if (pos != std::string::npos) {
+        pos = content.find(':', pos);
+        m_overclock_lines = std::clamp(std::atoi(content.c_str() + pos + 1), 0, MAX_OVERCLOCK_LINES);
+    }
+
     // Parse disable_sprite_limit
     pos = content.find("\"disable_sprite_limit\":");
     if (pos != std::string::npos) {
@@ -770,6 +1089,8 @@ bool NESPlugin::load_config(const char* path) {
         m_crop_overscan = (true_pos != std::string::npos && (false_pos == std::string::npos || true_pos < false_pos));
     }
 
+    m_bus->set_cycle_accurate(!m_fast_mode);
+
     // Apply loaded settings to PPU if it exists
     if (m_ppu) {
         m_ppu->set_sprite_limit_enabled(!m_disable_sprite_limit);
@@ -781,6 +1102,17 @@ bool NESPlugin::load_config(const char* path) {
 
 } // namespace nes
 
+#ifdef VELOCE_STATIC_CORE
+// Static build for veloce_bench, which links every core into one binary
+// and so can't use the shared C entry points below
+namespace nes {
+
+emu::IEmulatorPlugin* create_static_plugin() {
+    return new NESPlugin();
+}
+
+} // namespace nes
+#else
 // C interface for plugin loading
 extern "C" {
 
@@ -797,3 +1129,4 @@ EMU_PLUGIN_EXPORT uint32_t get_plugin_api_version() {
 }
 
 }
+#endif
@@ -1,6 +1,8 @@
 #include "ppu.hpp"
 #include "bus.hpp"
+#include "emu/state_writer.hpp"
 
+#include <algorithm>
 #include <cstring>
 
 namespace nes {
@@ -78,6 +80,7 @@ const uint32_t PPU::s_palette_rp2c04_0004[64] = {
 };
 
 PPU::PPU(Bus& bus) : m_bus(bus) {
+    build_rgba_palette();
     reset();
 }
 
@@ -136,6 +139,57 @@ void PPU::set_ppu_variant(PPUVariant variant) {
             m_current_palette = s_palette_rp2c04_0004;
             break;
     }
+    build_rgba_palette();
+}
+
+// Emphasis on the composite PPUs darkens the two colors not emphasized (by
+// about 18%); the 2C07 and Dendy swap the red and green bits. The RGB Vs.
+// PPUs instead drive the emphasized color at full.
+void PPU::build_rgba_palette() {
+    bool rgb = m_current_palette != s_palette;
+    bool swap_red_green = m_variant == PPUVariant::RP2C07 || m_variant == PPUVariant::Dendy;
+
+    for (int emphasis = 0; emphasis < 8; emphasis++) {
+        int bits = emphasis;
+        if (swap_red_green) {
+            bits = (bits & 0x04) | ((bits & 0x01) << 1) | ((bits & 0x02) >> 1);
+        }
+
+        for (int color = 0; color < 64; color++) {
+            uint32_t rgba = m_current_palette[color];
+            if (bits != 0) {
+                uint32_t out = rgba & 0xFF000000;
+                for (int channel = 0; channel < 3; channel++) {
+                    uint32_t value = (rgba >> (channel * 8)) & 0xFF;
+                    bool emphasized = bits & (1 << channel);
+                    if (rgb) {
+                        if (emphasized) value = 0xFF;
+                    } else if (!emphasized) {
+                        value = value * 209 / 256;
+                    }
+                    out |= value << (channel * 8);
+                }
+                rgba = out;
+            }
+            m_rgba_palette[(emphasis << 6) | color] = rgba;
+        }
+    }
+}
+
+void PPU::convert_framebuffer(uint32_t* out) const {
+    int first = 0;
+    int last = 240;
+    if (m_crop_overscan) {
+        std::fill(out, out + 8 * 256, 0xFF000000);
+        std::fill(out + 232 * 256, out + 240 * 256, 0xFF000000);
+        first = 8;
+        last = 232;
+    }
+
+    const uint32_t* rgba = m_rgba_palette.data();
+    for (int i = first * 256; i < last * 256; i++) {
+        out[i] = rgba[m_framebuffer[i] & 0x1FF];
+    }
 }
 
 void PPU::reset() {
@@ -164,11 +218,14 @@ void PPU::reset() {
     m_vbl_suppress = false;
     m_suppress_nmi = false;
     m_frame_complete = false;
+    m_bg_batch = false;
 
     m_oam.fill(0);
+    m_sprite_lines_height = 0;
     m_nametable.fill(0);
     m_palette.fill(0);
     m_framebuffer.fill(0);
+    m_nametable_pages.mark_all_dirty();
 }
 
 void PPU::step() {
@@ -177,8 +234,26 @@ void PPU::step() {
 
     // Visible scanlines (0-239)
     if (m_scanline >= 0 && m_scanline < 240) {
+        if (m_cycle == 1 && m_bus.has_ppu_events()) {
+            if ((m_mask & 0x18) != 0) {
+                m_bus.ppu_scanline_start(m_scanline);
+            } else {
+                m_bus.ppu_frame_end();
+            }
+        }
+
         if (m_cycle >= 1 && m_cycle <= 256) {
-            render_pixel();
+            // Lines without sprites are drawn 8 pixels at a time from the
+            // shifters right after each tile load; fetches still run per dot
+            if (m_cycle == 1) {
+                m_bg_batch = begin_batched_scanline();
+            }
+            if (!m_bg_batch || m_cycle == 1) {
+                render_pixel();
+            } else if (!(m_crop_overscan && (m_scanline < 8 || m_scanline >= 232))) {
+                // Cropped rows skip sprite logic in render_pixel() too
+                update_sprite_shifters();
+            }
 
             // Background fetches
             update_shifters();
@@ -186,19 +261,15 @@ void PPU::step() {
             switch ((m_cycle - 1) % 8) {
                 case 0: {
                     load_background_shifters();
-                    uint16_t nt_addr = 0x2000 | (m_v & 0x0FFF);
-                    m_bus.notify_ppu_address_bus(nt_addr, frame_cycle);  // A12 tracking for MMC3
-                    m_bg_next_tile_id = m_bus.ppu_read(nt_addr, frame_cycle);
+                    if (m_bg_batch) {
+                        render_background_chunk();
+                    }
+                    fetch_tile_name(m_scanline, (m_cycle - 1) / 8 + 2, frame_cycle);
                     break;
                 }
-                case 2: {
-                    uint16_t at_addr = 0x23C0 | (m_v & 0x0C00) | ((m_v >> 4) & 0x38) | ((m_v >> 2) & 0x07);
-                    m_bus.notify_ppu_address_bus(at_addr, frame_cycle);  // A12 tracking for MMC3
-                    m_bg_next_tile_attrib = m_bus.ppu_read(at_addr, frame_cycle);
-                    if (m_v & 0x40) m_bg_next_tile_attrib >>= 4;
-                    if (m_v & 0x02) m_bg_next_tile_attrib >>= 2;
+                case 2:
+                    fetch_tile_attribute(frame_cycle);
                     break;
-                }
                 case 4: {
                     uint16_t addr = ((m_ctrl & 0x10) << 8) + (m_bg_next_tile_id << 4) + ((m_v >> 12) & 7);
                     m_bus.notify_ppu_address_bus(addr, frame_cycle);
@@ -307,19 +378,12 @@ void PPU::step() {
             switch ((m_cycle - 1) % 8) {
                 case 0: {
                     load_background_shifters();
-                    uint16_t nt_addr = 0x2000 | (m_v & 0x0FFF);
-                    m_bus.notify_ppu_address_bus(nt_addr, frame_cycle);
-                    m_bg_next_tile_id = m_bus.ppu_read(nt_addr, frame_cycle);
+                    fetch_tile_name(m_scanline + 1, (m_cycle - 321) / 8, frame_cycle);
                     break;
                 }
-                case 2: {
-                    uint16_t at_addr = 0x23C0 | (m_v & 0x0C00) | ((m_v >> 4) & 0x38) | ((m_v >> 2) & 0x07);
-                    m_bus.notify_ppu_address_bus(at_addr, frame_cycle);
-                    m_bg_next_tile_attrib = m_bus.ppu_read(at_addr, frame_cycle);
-                    if (m_v & 0x40) m_bg_next_tile_attrib >>= 4;
-                    if (m_v & 0x02) m_bg_next_tile_attrib >>= 2;
+                case 2:
+                    fetch_tile_attribute(frame_cycle);
                     break;
-                }
                 case 4: {
                     uint16_t addr = ((m_ctrl & 0x10) << 8) + (m_bg_next_tile_id << 4) + ((m_v >> 12) & 7);
                     m_bus.notify_ppu_address_bus(addr, frame_cycle);
@@ -506,19 +570,12 @@ void PPU::step() {
             switch ((m_cycle - 1) % 8) {
                 case 0: {
                     load_background_shifters();
-                    uint16_t nt_addr = 0x2000 | (m_v & 0x0FFF);
-                    m_bus.notify_ppu_address_bus(nt_addr, frame_cycle);
-                    m_bg_next_tile_id = m_bus.ppu_read(nt_addr, frame_cycle);
+                    fetch_tile_name(0, (m_cycle - 321) / 8, frame_cycle);
                     break;
                 }
-                case 2: {
-                    uint16_t at_addr = 0x23C0 | (m_v & 0x0C00) | ((m_v >> 4) & 0x38) | ((m_v >> 2) & 0x07);
-                    m_bus.notify_ppu_address_bus(at_addr, frame_cycle);
-                    m_bg_next_tile_attrib = m_bus.ppu_read(at_addr, frame_cycle);
-                    if (m_v & 0x40) m_bg_next_tile_attrib >>= 4;
-                    if (m_v & 0x02) m_bg_next_tile_attrib >>= 2;
+                case 2:
+                    fetch_tile_attribute(frame_cycle);
                     break;
-                }
                 case 4: {
                     uint16_t addr = ((m_ctrl & 0x10) << 8) + (m_bg_next_tile_id << 4) + ((m_v >> 12) & 7);
                     m_bus.notify_ppu_address_bus(addr, frame_cycle);
@@ -560,7 +617,10 @@ void PPU::step() {
 
     }
 
-    // Post-render scanline 240 is idle, nothing happens
+    // Post-render scanline 240 is idle; rendering has left the frame
+    if (m_scanline == m_postrender_scanline && m_cycle == 1 && m_bus.has_ppu_events()) {
+        m_bus.ppu_frame_end();
+    }
 
     // Advance timing first
     m_cycle++;
@@ -831,6 +891,9 @@ uint8_t PPU::cpu_read(uint16_t address) {
 }
 
 void PPU::cpu_write(uint16_t address, uint8_t value) {
+    // Any register write may change scroll, mask or palette mid-line
+    m_bg_batch = false;
+
     // Any write to any PPU register fills the IO latch (open bus)
     // and refreshes decay timers for bits that are 1
     m_io_latch = value;
@@ -883,6 +946,7 @@ void PPU::cpu_write(uint16_t address, uint8_t value) {
 
         case 4: // OAMDATA
             m_oam[m_oam_addr++] = value;
+            m_sprite_lines_height = 0;
             break;
 
         case 5: // PPUSCROLL
@@ -1006,6 +1070,7 @@ void PPU::ppu_write(uint16_t address, uint8_t value) {
                 break;
         }
         m_nametable[address] = value;
+        m_nametable_pages.mark_dirty(address);
     }
     else {
         // Palette
@@ -1019,6 +1084,7 @@ void PPU::ppu_write(uint16_t address, uint8_t value) {
 
 void PPU::oam_write(int address, uint8_t value) {
     m_oam[address & 0xFF] = value;
+    m_sprite_lines_height = 0;
 }
 
 int PPU::check_nmi() {
@@ -1041,15 +1107,120 @@ bool PPU::check_frame_complete() {
     return false;
 }
 
+int PPU::get_cycles_until_event() const {
+    // VBlank (and frame completion) is signalled by the step() that advances
+    // to dot 1 of the VBlank start scanline
+    int position = m_scanline * 341 + m_cycle;
+    int vblank = m_vblank_start_scanline * 341 + 1;
+    int cycles;
+    if (position < vblank) {
+        cycles = vblank - position;
+    } else {
+        // Next frame - the odd frame skip may shorten it by one dot
+        cycles = m_scanlines_per_frame * 341 - position + vblank - 1;
+    }
+
+    // An in-flight NMI fires on the step() that counts the delay down to 0
+    if (m_nmi_delay > 0 && m_nmi_delay < cycles) {
+        cycles = m_nmi_delay;
+    }
+    return cycles;
+}
+
+int PPU::get_cycles_until_line_event() const {
+    // The events come from the step() at dot 1 of lines 0-240
+    int position = m_scanline * 341 + m_cycle;
+    int line = m_cycle <= 1 ? m_scanline : m_scanline + 1;
+    if (line <= m_postrender_scanline) {
+        return line * 341 + 1 - position + 1;
+    }
+    // Line 0 of the next frame, which the odd frame skip may bring a dot closer
+    return m_scanlines_per_frame * 341 + 1 - position;
+}
+
+int PPU::get_cycles_until_status_change(uint8_t bits) const {
+    // A status bit that's set may be cleared by this very read (VBlank) or
+    // by an overflow evaluation nothing here predicts
+    if ((bits & 0x80) && (m_status & 0x80)) return 0;
+    if ((bits & 0x20) && !(m_status & 0x20)) return 0;
+
+    // Steps until the PPU reaches a frame position, the odd frame skip
+    // taken into account when it's in the next frame
+    int position = m_scanline * 341 + m_cycle;
+    int frame = m_scanlines_per_frame * 341;
+    auto until = [&](int target) {
+        return target >= position ? target - position : frame - position + target - 1;
+    };
+
+    // Reads from dot 0 of the VBlank line on suppress the flag or the NMI
+    int cycles = std::min(get_cycles_until_event(), until(m_vblank_start_scanline * 341));
+
+    // The pre-render line clears all three flags, which also stops reads
+    // from refreshing their open bus decay timers
+    if (m_status & 0xE0) {
+        cycles = std::min(cycles, until(m_prerender_scanline * 341));
+    }
+
+    // Sprite 0 hit needs both layers on and sprite 0 on screen. It's taken
+    // as covering one line more than its height in case evaluation is a
+    // line early, and as able to hit from its left edge (or 8 with either
+    // layer clipped) on every line it covers.
+    uint8_t y = m_oam[0];
+    if ((bits & 0x40) && !(m_status & 0x40) && (m_mask & 0x18) == 0x18 && y < 240) {
+        int height = (m_ctrl & 0x20) ? 16 : 8;
+        int x = m_oam[3];
+        int first_x = ((m_mask & 0x06) != 0x06) ? std::max(x, 8) : x;
+
+        int line = y;
+        if (m_scanline < 240 && m_scanline >= y) {
+            // Past the sprite's last pixel the hit can only come a line later
+            line = (m_cycle <= x + 9) ? m_scanline : m_scanline + 1;
+        }
+        if (m_scanline < 240 && line <= y + height && line < 240) {
+            int target = line * 341 + first_x;
+            cycles = std::min(cycles, target > position ? target - position : 0);
+        } else {
+            // Not before VBlank; next frame's
+            cycles = std::min(cycles, until(y * 341 + first_x));
+        }
+    }
+
+    // One step's margin, as the flags change on the step reaching their dot
+    return std::max(cycles - 1, 0);
+}
+
+// Nametable fetch for background tile column (0-33) of line; a mapper with
+// PPU events may supply the tile instead, as the MMC5's split does
+void PPU::fetch_tile_name(int line, int column, uint32_t frame_cycle) {
+    uint16_t nt_addr = 0x2000 | (m_v & 0x0FFF);
+    m_bus.notify_ppu_address_bus(nt_addr, frame_cycle);  // A12 tracking for MMC3
+    m_bg_split = line < 240 && m_bus.has_ppu_events() &&
+                 m_bus.ppu_tile_fetch(line, column, m_bg_next_tile_id, m_bg_split_palette);
+    if (!m_bg_split) {
+        m_bg_next_tile_id = m_bus.ppu_read(nt_addr, frame_cycle);
+    }
+}
+
+void PPU::fetch_tile_attribute(uint32_t frame_cycle) {
+    uint16_t at_addr = 0x23C0 | (m_v & 0x0C00) | ((m_v >> 4) & 0x38) | ((m_v >> 2) & 0x07);
+    m_bus.notify_ppu_address_bus(at_addr, frame_cycle);  // A12 tracking for MMC3
+    if (m_bg_split) {
+        m_bg_next_tile_attrib = m_bg_split_palette;
+        return;
+    }
+    m_bg_next_tile_attrib = m_bus.ppu_read(at_addr, frame_cycle);
+    if (m_v & 0x40) m_bg_next_tile_attrib >>= 4;
+    if (m_v & 0x02) m_bg_next_tile_attrib >>= 2;
+}
+
 void PPU::render_pixel() {
     int x = m_cycle - 1;
     int y = m_scanline;
 
     if (x < 0 || x >= 256 || y < 0 || y >= 240) return;
 
-    // Overscan cropping: render black for top/bottom 8 rows
+    // Overscan cropping: convert_framebuffer() draws these rows black
     if (m_crop_overscan && (y < 8 || y >= 232)) {
-        m_framebuffer[y * 256 + x] = 0xFF000000;  // Black with full alpha
         return;
     }
 
@@ -1132,9 +1303,13 @@ void PPU::render_pixel() {
 
     // Get color from palette (use current palette for region/Vs. System support)
     uint8_t color_index = ppu_read(0x3F00 + (palette << 2) + pixel) & 0x3F;
-    m_framebuffer[y * 256 + x] = m_current_palette[color_index];
+    m_framebuffer[y * 256 + x] = color_index | ((m_mask & 0xE0) << 1);
 
-    // Update sprite shifters
+    update_sprite_shifters();
+}
+
+// Sprite X counters and shifters advance every dot, even with sprites hidden
+void PPU::update_sprite_shifters() {
     for (int i = 0; i < m_sprite_count; i++) {
         if (m_scanline_sprites[i].x > 0) {
             m_scanline_sprites[i].x--;
@@ -1145,6 +1320,84 @@ void PPU::render_pixel() {
     }
 }
 
+// A scanline can be batched when render_pixel() would only ever produce
+// background or backdrop pixels: no sprites in range, or sprites disabled
+// (their counters still tick through update_sprite_shifters()).
+// The palette can only change through $2007, which ends the batch, so the
+// 16 background color indices are resolved once for the whole line.
+// With video disabled nothing is drawn, and sprites only need the per-dot
+// path on lines where sprite 0 could hit.
+bool PPU::begin_batched_scanline() {
+    if ((m_mask & 0x10) && m_sprite_count > 0) {
+        if (m_video_enabled || m_sprite_zero_hit_possible) {
+            return false;
+        }
+    }
+    if (!m_video_enabled) {
+        return true;
+    }
+
+    for (int i = 0; i < 16; i++) {
+        uint8_t color_index = ppu_read(0x3F00 + ((i & 0x03) ? i : 0)) & 0x3F;
+        m_bg_batch_colors[i] = color_index;
+    }
+    return true;
+}
+
+// Draw the pixels for the next 8 dots, called right after a tile load
+// Until the next load the shifters only shift left, so the pixel drawn at
+// dot m_cycle + 1 + i is bit (15 - m_x - i) of their current value.
+void PPU::render_background_chunk() {
+    int x0 = m_cycle;
+    int y = m_scanline;
+    int count = (256 - x0 < 8) ? 256 - x0 : 8;
+    if (count <= 0) return;
+
+    uint16_t* out = &m_framebuffer[y * 256 + x0];
+
+    if (m_crop_overscan && (y < 8 || y >= 232)) {
+        return;
+    }
+
+    // Matches the per-dot path clearing the sprite 0 flag on an empty line
+    if ((m_mask & 0x10) && ((m_mask & 0x04) || x0 + count > 8)) {
+        m_sprite_zero_rendering = false;
+    }
+
+    if (!m_video_enabled) {
+        return;
+    }
+
+    uint8_t pattern_lo = 0;
+    uint8_t pattern_hi = 0;
+    uint8_t attrib_lo = 0;
+    uint8_t attrib_hi = 0;
+    if (m_mask & 0x08) {
+        int shift = 8 - m_x;
+        pattern_lo = static_cast<uint8_t>(m_bg_shifter_pattern_lo >> shift);
+        pattern_hi = static_cast<uint8_t>(m_bg_shifter_pattern_hi >> shift);
+        attrib_lo = static_cast<uint8_t>(m_bg_shifter_attrib_lo >> shift);
+        attrib_hi = static_cast<uint8_t>(m_bg_shifter_attrib_hi >> shift);
+
+        // Left 8 pixels hidden by PPUMASK bit 1
+        if (!(m_mask & 0x02) && x0 < 8) {
+            uint8_t keep = static_cast<uint8_t>(0xFF >> (8 - x0));
+            pattern_lo &= keep;
+            pattern_hi &= keep;
+        }
+    }
+
+    // PPUMASK can't change mid-batch without ending it, so one emphasis
+    // for the chunk
+    uint16_t emphasis = static_cast<uint16_t>((m_mask & 0xE0) << 1);
+    for (int i = 0; i < count; i++) {
+        int bit = 7 - i;
+        int pixel = ((pattern_lo >> bit) & 1) | (((pattern_hi >> bit) & 1) << 1);
+        int palette = ((attrib_lo >> bit) & 1) | (((attrib_hi >> bit) & 1) << 1);
+        out[i] = m_bg_batch_colors[pixel ? (palette << 2) | pixel : 0] | emphasis;
+    }
+}
+
 void PPU::evaluate_sprites() {
     uint32_t fc = m_scanline * 341 + m_cycle;
     evaluate_sprites_for_scanline(m_scanline, fc);
@@ -1193,24 +1446,28 @@ void PPU::evaluate_sprites_for_next_scanline(int scanline) {
     uint8_t sprite_height = (m_ctrl & 0x20) ? 16 : 8;
 
     // Phase 1: Normal sprite evaluation (find sprites on scanline up to limit)
-    int m = 0;  // OAM sprite index (0-63)
-    while (m < 64 && m_sprite_count < sprite_limit) {
-        int y = m_oam[m * 4];
-        int diff = scanline - y;
-
-        if (diff >= 0 && diff < sprite_height) {
-            if (m == 0) {
-                m_sprite_zero_hit_possible = true;
-                m_sprite_zero_index = m_sprite_count;
-            }
+    // The in-range sprites come from the line index, in OAM order; m ends
+    // up one past the last sprite taken, or 64 when the line ran out
+    if (m_sprite_lines_height != sprite_height) {
+        build_sprite_lines(sprite_height);
+    }
+    uint64_t in_range = (scanline >= 0 && scanline < 256) ? m_sprite_lines[scanline] : 0;
+    int m = 64;  // OAM sprite index (0-63)
+    while (in_range && m_sprite_count < sprite_limit) {
+        m = __builtin_ctzll(in_range);
+        in_range &= in_range - 1;
+
+        if (m == 0) {
+            m_sprite_zero_hit_possible = true;
+            m_sprite_zero_index = m_sprite_count;
+        }
 
-            m_scanline_sprites[m_sprite_count].y = m_oam[m * 4];
-            m_scanline_sprites[m_sprite_count].tile = m_oam[m * 4 + 1];
-            m_scanline_sprites[m_sprite_count].attr = m_oam[m * 4 + 2];
-            m_scanline_sprites[m_sprite_count].x = m_oam[m * 4 + 3];
+        m_scanline_sprites[m_sprite_count].y = m_oam[m * 4];
+        m_scanline_sprites[m_sprite_count].tile = m_oam[m * 4 + 1];
+        m_scanline_sprites[m_sprite_count].attr = m_oam[m * 4 + 2];
+        m_scanline_sprites[m_sprite_count].x = m_oam[m * 4 + 3];
 
-            m_sprite_count++;
-        }
+        m_sprite_count++;
         m++;
     }
 
@@ -1249,6 +1506,19 @@ void PPU::evaluate_sprites_for_next_scanline(int scanline) {
     }
 }
 
+// Index which sprites each scanline's evaluation finds in range
+void PPU::build_sprite_lines(uint8_t sprite_height) {
+    m_sprite_lines.fill(0);
+    for (int m = 0; m < 64; m++) {
+        int y = m_oam[m * 4];
+        int end = std::min(y + sprite_height, 256);
+        for (int line = y; line < end; line++) {
+            m_sprite_lines[line] |= uint64_t(1) << m;
+        }
+    }
+    m_sprite_lines_height = sprite_height;
+}
+
 // Get the pattern table address for a sprite slot's pattern fetch
 uint16_t PPU::get_sprite_pattern_addr(int sprite_slot, bool hi_byte) {
     uint8_t sprite_height = (m_ctrl & 0x20) ? 16 : 8;
@@ -1292,14 +1562,29 @@ uint16_t PPU::get_sprite_pattern_addr(int sprite_slot, bool hi_byte) {
 }
 
 // Apply horizontal flip to a sprite byte if needed
+namespace {
+    // Horizontally flipped sprite pattern rows, indexed by the unflipped byte
+    constexpr std::array<uint8_t, 256> build_bit_reverse_table() {
+        std::array<uint8_t, 256> table{};
+        for (int i = 0; i < 256; i++) {
+            uint8_t reversed = 0;
+            for (int bit = 0; bit < 8; bit++) {
+                if (i & (1 << bit)) reversed |= static_cast<uint8_t>(0x80 >> bit);
+            }
+            table[i] = reversed;
+        }
+        return table;
+    }
+
+    constexpr std::array<uint8_t, 256> s_bit_reverse = build_bit_reverse_table();
+}
+
 uint8_t PPU::maybe_flip_sprite_byte(int sprite_slot, uint8_t byte) {
     if (sprite_slot < m_sprite_count) {
         const Sprite& sprite = m_scanline_sprites[sprite_slot];
         if (sprite.attr & 0x40) {
             // Horizontal flip - bit reverse
-            byte = (byte & 0xF0) >> 4 | (byte & 0x0F) << 4;
-            byte = (byte & 0xCC) >> 2 | (byte & 0x33) << 2;
-            byte = (byte & 0xAA) >> 1 | (byte & 0x55) << 1;
+            byte = s_bit_reverse[byte];
         }
     }
     return byte;
@@ -1349,9 +1634,8 @@ void PPU::update_shifters() {
 // Serialization helpers
 namespace {
     template<typename T>
-    void write_value(std::vector<uint8_t>& data, T value) {
-        const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&value);
-        data.insert(data.end(), ptr, ptr + sizeof(T));
+    void write_value(StateWriter& data, T value) {
+        data.write(&value, sizeof(T));
     }
 
     template<typename T>
@@ -1363,8 +1647,8 @@ namespace {
         return true;
     }
 
-    void write_array(std::vector<uint8_t>& data, const uint8_t* arr, size_t size) {
-        data.insert(data.end(), arr, arr + size);
+    void write_array(StateWriter& data, const uint8_t* arr, size_t size) {
+        data.write(arr, size);
     }
 
     bool read_array(const uint8_t*& data, size_t& remaining, uint8_t* arr, size_t size) {
@@ -1376,7 +1660,23 @@ namespace {
     }
 }
 
-void PPU::save_state(std::vector<uint8_t>& data) {
+void PPU::save_state(StateWriter& data) {
+    save_registers(data);
+
+    // OAM
+    write_array(data, m_oam.data(), m_oam.size());
+
+    // Nametable RAM
+    write_array(data, m_nametable.data(), m_nametable.size());
+
+    // Palette RAM
+    write_array(data, m_palette.data(), m_palette.size());
+
+    // Mirroring
+    write_value(data, m_mirroring);
+}
+
+void PPU::save_registers(StateWriter& data) {
     // PPU registers
     write_value(data, m_ctrl);
     write_value(data, m_mask);
@@ -1436,18 +1736,6 @@ void PPU::save_state(std::vector<uint8_t>& data) {
         write_value(data, m_sprite_shifter_lo[i]);
         write_value(data, m_sprite_shifter_hi[i]);
     }
-
-    // OAM
-    write_array(data, m_oam.data(), m_oam.size());
-
-    // Nametable RAM
-    write_array(data, m_nametable.data(), m_nametable.size());
-
-    // Palette RAM
-    write_array(data, m_palette.data(), m_palette.size());
-
-    // Mirroring
-    write_value(data, m_mirroring);
 }
 
 void PPU::load_state(const uint8_t*& data, size_t& remaining) {
@@ -1518,6 +1806,7 @@ void PPU::load_state(const uint8_t*& data, size_t& remaining) {
     read_value(data, remaining, sprite_zero_rendering);
     m_sprite_zero_hit_possible = sprite_zero_hit_possible != 0;
     m_sprite_zero_rendering = sprite_zero_rendering != 0;
+    m_bg_batch = false;
 
     // Scanline sprite data
     for (int i = 0; i < 8; i++) {
@@ -1531,9 +1820,11 @@ void PPU::load_state(const uint8_t*& data, size_t& remaining) {
 
     // OAM
     read_array(data, remaining, m_oam.data(), m_oam.size());
+    m_sprite_lines_height = 0;
 
     // Nametable RAM
     read_array(data, remaining, m_nametable.data(), m_nametable.size());
+    m_nametable_pages.mark_all_dirty();
 
     // Palette RAM
     read_array(data, remaining, m_palette.data(), m_palette.size());
@@ -1542,4 +1833,15 @@ void PPU::load_state(const uint8_t*& data, size_t& remaining) {
     read_value(data, remaining, m_mirroring);
 }
 
+uint64_t PPU::get_state_hash() {
+    // OAM and palette are small enough to hash in full every time
+    uint64_t hash = state_hash::hash_serialized(m_hash_scratch, [this](StateWriter& out) {
+        save_registers(out);
+        write_value(out, m_mirroring);
+    });
+    hash = state_hash::combine(hash, state_hash::hash_bytes(m_oam.data(), m_oam.size()));
+    hash = state_hash::combine(hash, state_hash::hash_bytes(m_palette.data(), m_palette.size()));
+    return state_hash::combine(hash, m_nametable_pages.hash(m_nametable.data(), m_nametable.size()));
+}
+
 } // namespace nes
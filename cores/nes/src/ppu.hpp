@@ -4,9 +4,13 @@
 #include <array>
 #include <vector>
 
+#include "state_hash.hpp"
+#include "emu/state_writer.hpp"
+
 namespace nes {
 
 class Bus;
+using emu::StateWriter;
 
 // NES PPU (Picture Processing Unit) - 2C02
 class PPU {
@@ -38,8 +42,36 @@ public:
     // Frame complete check (returns true once per frame, at start of VBlank)
     bool check_frame_complete();
 
-    // Get framebuffer
-    const uint32_t* get_framebuffer() const { return m_framebuffer.data(); }
+    // Number of step() calls that can run before the CPU could observe a
+    // change without touching a PPU register (VBlank start / NMI firing).
+    // Used by the bus for catch-up scheduling; may underestimate, never over.
+    int get_cycles_until_event() const;
+
+    // Number of step() calls up to and including the next mapper line
+    // event (Mapper::ppu_scanline_start() / ppu_frame_end()), for syncing
+    // the PPU in time for a scanline IRQ; may underestimate, never over
+    int get_cycles_until_line_event() const;
+
+    // Number of step() calls after which a $2002 read still gives the same
+    // value in 'bits' and no side effect a read at that point wouldn't have
+    // had now, for skipping CPU loops that poll PPUSTATUS. Sprite 0 hit is
+    // placed from OAM entry 0 and PPUMASK alone (its first possible line
+    // and column), so it may come early, never late. 0 if a change could
+    // already be due.
+    int get_cycles_until_status_change(uint8_t bits) const;
+
+    // The frame as drawn: one entry per pixel, the 6-bit palette color in
+    // bits 0-5 and PPUMASK's emphasis bits in 6-8
+    const uint16_t* get_index_framebuffer() const { return m_framebuffer.data(); }
+
+    // Convert the frame to RGBA through the variant's palette, applying
+    // emphasis and overscan cropping
+    void convert_framebuffer(uint32_t* out) const;
+
+    // Internal memories, for memory domains
+    const uint8_t* get_nametable_data() const { return m_nametable.data(); }
+    const uint8_t* get_palette_data() const { return m_palette.data(); }
+    const uint8_t* get_oam_data() const { return m_oam.data(); }
 
     // Get current frame cycle for mapper IRQ timing
     uint32_t get_frame_cycle() const { return static_cast<uint32_t>(m_scanline * 341 + m_cycle); }
@@ -77,22 +109,40 @@ public:
     bool is_sprite_limit_enabled() const { return m_sprite_limit_enabled; }
     void set_crop_overscan(bool enabled) { m_crop_overscan = enabled; }
     bool is_crop_overscan_enabled() const { return m_crop_overscan; }
+    // Skip pixel composition for frames that won't be shown; sprite 0 hit,
+    // sprite overflow and all timing stay exact
+    void set_video_enabled(bool enabled) { m_video_enabled = enabled; }
 
     // Save state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
 
+    // Incremental hash of everything save_state() writes (nametables by dirty page)
+    uint64_t get_state_hash();
+
 private:
+    // Everything save_state() writes before OAM
+    void save_registers(StateWriter& data);
+
+    // Background tile fetches shared by the visible and pre-render lines
+    void fetch_tile_name(int line, int column, uint32_t frame_cycle);
+    void fetch_tile_attribute(uint32_t frame_cycle);
+
     void render_pixel();
+    // Scanline-batched background path (see step())
+    bool begin_batched_scanline();
+    void render_background_chunk();
     uint8_t get_background_pixel();
     uint8_t get_sprite_pixel(uint8_t& sprite_priority);
     void evaluate_sprites();
     void evaluate_sprites_for_scanline(int scanline, uint32_t frame_cycle);
+    void build_sprite_lines(uint8_t sprite_height);
     void evaluate_sprites_for_next_scanline(int scanline);
     uint16_t get_sprite_pattern_addr(int sprite_slot, bool hi_byte);
     uint8_t maybe_flip_sprite_byte(int sprite_slot, uint8_t byte);
     void load_background_shifters();
     void update_shifters();
+    void update_sprite_shifters();
 
     // Bus reference
     Bus& m_bus;
@@ -151,6 +201,14 @@ private:
     uint8_t m_bg_next_tile_attrib = 0;
     uint8_t m_bg_next_tile_lo = 0;
     uint8_t m_bg_next_tile_hi = 0;
+    bool m_bg_split = false;            // The mapper supplied the tile being fetched
+    uint8_t m_bg_split_palette = 0;
+
+    // Batched background rendering for the current scanline
+    // Set at dot 1 when no sprite can land on the line; any register write
+    // clears it and the rest of the line falls back to render_pixel().
+    bool m_bg_batch = false;
+    std::array<uint8_t, 16> m_bg_batch_colors{};   // Backdrop + BG palettes as color indices
 
     // Sprite rendering
     struct Sprite {
@@ -168,16 +226,25 @@ private:
     std::array<uint8_t, MAX_SPRITES_PER_SCANLINE> m_sprite_shifter_lo;
     std::array<uint8_t, MAX_SPRITES_PER_SCANLINE> m_sprite_shifter_hi;
     int m_sprite_count = 0;
+
+    // The sprites in range of each scanline, bit m for OAM sprite m, so
+    // evaluation doesn't test all 64 on every line. Rebuilt on the next
+    // evaluation after OAM or the sprite height changes, which for most
+    // games is once a frame, after OAM DMA.
+    std::array<uint64_t, 256> m_sprite_lines{};
+    uint8_t m_sprite_lines_height = 0;  // 0 = needs a rebuild
     int m_sprite_zero_index = -1;  // Index of OAM sprite 0 in m_scanline_sprites (-1 if not present)
     bool m_sprite_zero_hit_possible = false;
     bool m_sprite_zero_rendering = false;
 
     // Memory
     std::array<uint8_t, 2048> m_nametable;  // 2KB nametable RAM
+    PageHashCache m_nametable_pages;
+    std::vector<uint8_t> m_hash_scratch;
     std::array<uint8_t, 32> m_palette;      // Palette RAM
 
-    // Framebuffer (256x240 RGBA)
-    std::array<uint32_t, 256 * 240> m_framebuffer;
+    // Framebuffer (256x240 color + emphasis indices, see get_index_framebuffer())
+    std::array<uint16_t, 256 * 240> m_framebuffer;
 
     // Mirroring mode
     int m_mirroring = 0;  // 0 = horizontal, 1 = vertical
@@ -206,9 +273,15 @@ private:
     // Current palette pointer (points to one of the above)
     const uint32_t* m_current_palette = s_palette;
 
+    // RGBA for each framebuffer index: the current palette under each of
+    // the 8 emphasis settings
+    std::array<uint32_t, 512> m_rgba_palette{};
+    void build_rgba_palette();
+
     // Emulation options
     bool m_sprite_limit_enabled = true;  // True = accurate 8 sprite limit
     bool m_crop_overscan = false;        // True = hide top/bottom 8 rows
+    bool m_video_enabled = true;         // False = framebuffer not updated
 };
 
 } // namespace nes
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "emu/state_writer.hpp"
+
+namespace nes {
+
+using emu::StateWriter;
+
+// Save state hashing for netplay desync detection
+// hash_bytes() is a single-lane xxHash64-style hash (8 bytes per round).
+// PageHashCache keeps one hash per 256-byte page of a memory region and only
+// rehashes pages that were written since the last call, so hashing the full
+// state costs roughly the bytes the game touched this frame.
+namespace state_hash {
+
+constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotl(uint64_t value, int shift) {
+    return (value << shift) | (value >> (64 - shift));
+}
+
+inline uint64_t mix_round(uint64_t acc, uint64_t input) {
+    acc += input * PRIME2;
+    acc = rotl(acc, 31);
+    return acc * PRIME1;
+}
+
+inline uint64_t avalanche(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+inline uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t hash = seed + PRIME5 + size;
+
+    while (size >= 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        hash ^= mix_round(0, word);
+        hash = rotl(hash, 27) * PRIME1 + PRIME4;
+        bytes += 8;
+        size -= 8;
+    }
+    if (size >= 4) {
+        uint32_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        hash ^= static_cast<uint64_t>(word) * PRIME1;
+        hash = rotl(hash, 23) * PRIME2 + PRIME3;
+        bytes += 4;
+        size -= 4;
+    }
+    while (size > 0) {
+        hash ^= (*bytes) * PRIME5;
+        hash = rotl(hash, 11) * PRIME1;
+        bytes++;
+        size--;
+    }
+
+    return avalanche(hash);
+}
+
+// Order-dependent combination of two hashes
+inline uint64_t combine(uint64_t hash, uint64_t value) {
+    return rotl(hash, 27) * PRIME1 + mix_round(PRIME4, value);
+}
+
+// Hash whatever `serialize` writes, using `scratch` as the output buffer
+// The scratch buffer only grows (once) if a component's state outgrows it,
+// so steady-state hashing never allocates.
+template<typename Fn>
+uint64_t hash_serialized(std::vector<uint8_t>& scratch, Fn&& serialize) {
+    StateWriter writer(scratch.data(), scratch.size());
+    serialize(writer);
+    if (writer.overflowed()) {
+        scratch.resize(writer.size());
+        StateWriter retry(scratch.data(), scratch.size());
+        serialize(retry);
+        return hash_bytes(scratch.data(), retry.size());
+    }
+    return hash_bytes(scratch.data(), writer.size());
+}
+
+} // namespace state_hash
+
+// Incremental hash of a memory region, tracked in 256-byte pages
+// Owners call mark_dirty() from their write paths and mark_all_dirty()
+// whenever the region is replaced wholesale (load_state, reset, battery load).
+class PageHashCache {
+public:
+    static constexpr size_t PAGE_SHIFT = 8;
+    static constexpr size_t PAGE_SIZE = 1 << PAGE_SHIFT;
+
+    void mark_dirty(size_t offset) {
+        size_t page = offset >> PAGE_SHIFT;
+        if (page < m_dirty.size()) {
+            m_dirty[page] = 1;
+        }
+    }
+
+    void mark_all_dirty() { m_all_dirty = true; }
+
+    // Rehash dirty pages and fold all page hashes into one value
+    uint64_t hash(const uint8_t* data, size_t size) {
+        size_t pages = (size + PAGE_SIZE - 1) >> PAGE_SHIFT;
+        if (size != m_size) {
+            // Region was resized (e.g. mapper grew PRG RAM) - start over
+            m_size = size;
+            m_page_hashes.assign(pages, 0);
+            m_dirty.assign(pages, 1);
+        }
+
+        uint64_t combined = state_hash::PRIME5 + size;
+        for (size_t page = 0; page < pages; page++) {
+            if (m_all_dirty || m_dirty[page]) {
+                size_t offset = page << PAGE_SHIFT;
+                size_t length = (size - offset < PAGE_SIZE) ? size - offset : PAGE_SIZE;
+                m_page_hashes[page] = state_hash::hash_bytes(data + offset, length, page);
+                m_dirty[page] = 0;
+            }
+            combined = state_hash::combine(combined, m_page_hashes[page]);
+        }
+        m_all_dirty = false;
+
+        return state_hash::avalanche(combined);
+    }
+
+private:
+    std::vector<uint64_t> m_page_hashes;
+    std::vector<uint8_t> m_dirty;
+    size_t m_size = 0;
+    bool m_all_dirty = true;
+};
+
+} // namespace nes
@@ -2,7 +2,12 @@
 #include "spc700.hpp"
 #include "dsp.hpp"
 #include "debug.hpp"
+#include "emu/state_writer.hpp"
+#include <algorithm>
+#include <condition_variable>
 #include <cstring>
+#include <mutex>
+#include <thread>
 
 namespace snes {
 
@@ -16,22 +21,60 @@ APU::APU() {
     reset();
 }
 
-APU::~APU() = default;
+APU::~APU() {
+    set_threaded(false);
+}
 
 void APU::reset() {
+    if (m_worker) {
+        wait_for_worker();
+    }
+
     m_spc->reset();
     m_dsp->reset();
 
     m_cycle_counter = 0;
+    m_pending_cycles = 0;
     m_audio_buffer.fill(0);
     m_audio_write_pos = 0;
     m_sample_counter = 0;
-    m_last_left = 0;
-    m_last_right = 0;
-    m_stream_pos = 0;
+    m_stream.discard();
 }
 
-void APU::step(int master_cycles) {
+// ============================================================================
+// CATCH-UP SYNCHRONIZATION
+// ============================================================================
+// The SPC700 and DSP only talk to the main CPU through the four $2140-$2143
+// port bytes, so nothing outside the APU can observe it between port
+// accesses. step() just banks master cycles, and the audio side runs them
+// in one batch when a port is read or written or the frame ends.
+//
+// The plugin steps the APU after each CPU instruction, so a port access in
+// the middle of an instruction used to see the APU at the end of the
+// previous one. Syncing on access runs exactly those banked cycles, so port
+// timing (and the output) matches per-instruction stepping.
+// ============================================================================
+void APU::sync() {
+    if (m_worker) {
+        wait_for_worker();
+
+        // The worker buffers samples instead of streaming from its own
+        // thread; hand them to the stream here
+        if (m_stream.active()) {
+            m_stream.write(m_audio_buffer.data(), m_audio_write_pos);
+            m_audio_write_pos = 0;
+        }
+        return;
+    }
+
+    if (m_pending_cycles == 0) {
+        return;
+    }
+    run_cycles(m_pending_cycles);
+    m_pending_cycles = 0;
+}
+
+void APU::run_cycles(int master_cycles) {
     m_cycle_counter += master_cycles;
 
     // SPC700 runs at ~1.024 MHz, master clock is 21.477 MHz
@@ -61,6 +104,7 @@ void APU::step(int master_cycles) {
             m_sample_counter -= 32;
 
             m_dsp->step();
+            if (!m_audio_enabled) continue;
 
             // Get DSP output
             int16_t left = m_dsp->get_output_left();
@@ -70,17 +114,9 @@ void APU::step(int master_cycles) {
             float left_f = left / 32768.0f;
             float right_f = right / 32768.0f;
 
-            // If streaming callback is set, use low-latency path
-            if (m_audio_callback) {
-                m_stream_buffer[m_stream_pos * 2] = left_f;
-                m_stream_buffer[m_stream_pos * 2 + 1] = right_f;
-                m_stream_pos++;
-
-                // Flush when buffer is full (every 64 samples = ~2ms at 32kHz)
-                if (m_stream_pos >= STREAM_BUFFER_SIZE) {
-                    m_audio_callback(m_stream_buffer, m_stream_pos, DSP_RATE);
-                    m_stream_pos = 0;
-                }
+            // If a stream sink is set, use low-latency path
+            if (m_stream.active() && !m_worker) {
+                m_stream.push(left_f, right_f);
             } else {
                 // Legacy path: buffer until get_samples() is called
                 if (m_audio_write_pos < AUDIO_BUFFER_SIZE) {
@@ -89,22 +125,40 @@ void APU::step(int master_cycles) {
                     m_audio_write_pos++;
                 }
             }
-
-            m_last_left = left;
-            m_last_right = right;
         }
     }
 }
 
+void APU::set_audio_sink(const emu::AudioStreamSink& sink) {
+    sync();
+    m_stream.set_sink(sink, DSP_RATE);
+}
+
+void APU::set_audio_enabled(bool enabled) {
+    sync();
+    m_audio_enabled = enabled;
+    m_dsp->set_audio_enabled(enabled);
+}
+
 uint8_t APU::read_port(int port) {
+    sync();
     return m_spc->cpu_read_port(port & 3);
 }
 
 void APU::write_port(int port, uint8_t value) {
+    if (m_worker) {
+        publish(port & 3, value);
+        return;
+    }
+    sync();
     m_spc->cpu_write_port(port & 3, value);
 }
 
 size_t APU::get_samples(float* buffer, size_t max_samples) {
+    if (m_worker) {
+        wait_for_worker();
+    }
+
     size_t samples_to_copy = std::min(m_audio_write_pos, max_samples);
 
     if (samples_to_copy > 0) {
@@ -117,7 +171,10 @@ size_t APU::get_samples(float* buffer, size_t max_samples) {
     return samples_to_copy;
 }
 
-void APU::save_state(std::vector<uint8_t>& data) {
+void APU::save_state(StateWriter& data) {
+    // Only the sub-instruction remainder of the cycle counter is saved
+    sync();
+
     m_spc->save_state(data);
     m_dsp->save_state(data);
 
@@ -129,6 +186,10 @@ void APU::save_state(std::vector<uint8_t>& data) {
 }
 
 void APU::load_state(const uint8_t*& data, size_t& remaining) {
+    if (m_worker) {
+        wait_for_worker();
+    }
+
     m_spc->load_state(data, remaining);
     m_dsp->load_state(data, remaining);
 
@@ -137,6 +198,118 @@ void APU::load_state(const uint8_t*& data, size_t& remaining) {
     data += 2; remaining -= 2;
     m_sample_counter = data[0] | (data[1] << 8);
     data += 2; remaining -= 2;
+    m_pending_cycles = 0;
+}
+
+void APU::save_internal_state(StateWriter& data) {
+    sync();
+    m_spc->save_timer_dividers(data);
+    m_dsp->save_voice_state(data);
+}
+
+void APU::load_internal_state(const uint8_t*& data, size_t& remaining) {
+    if (m_worker) {
+        wait_for_worker();
+    }
+    m_spc->load_timer_dividers(data, remaining);
+    m_dsp->load_voice_state(data, remaining);
+}
+
+// ============================================================================
+// THREADED MODE
+// ============================================================================
+// The worker runs the same run_cycles() loop the emulation thread would.
+// Every published event carries the master cycles banked since the previous
+// one and an optional port write, so the worker applies each write at the
+// same point in SPC700 time that sync() would have. Splitting a span of
+// banked cycles across several run_cycles() calls executes the same
+// instructions, because the leftover in m_cycle_counter carries over.
+//
+// The emulation thread never touches SPC700/DSP state or the sample buffer
+// unless the worker is idle with an empty queue (wait_for_worker()).
+// ============================================================================
+struct APU::Worker {
+    struct PortEvent {
+        int cycles;     // Master cycles to run before the write
+        int port;       // -1 = time only
+        uint8_t value;
+    };
+
+    std::vector<PortEvent> queue;    // Filled by the emulation thread
+    std::vector<PortEvent> running;  // Owned by the worker while busy
+    bool busy = false;
+    bool stop = false;
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable work_done;
+    std::thread thread;
+};
+
+void APU::set_threaded(bool enabled) {
+    if (enabled == (m_worker != nullptr)) return;
+
+    if (!enabled) {
+        wait_for_worker();
+        {
+            std::lock_guard<std::mutex> lock(m_worker->mutex);
+            m_worker->stop = true;
+        }
+        m_worker->work_ready.notify_all();
+        m_worker->thread.join();
+        m_worker.reset();
+        return;
+    }
+
+    // Start from a fully caught-up APU with no buffered stream samples
+    sync();
+    m_stream.flush();
+    m_worker = std::make_unique<Worker>();
+    m_worker->thread = std::thread([this] { worker_loop(); });
+}
+
+void APU::publish(int port, uint8_t value) {
+    Worker& worker = *m_worker;
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.queue.push_back({m_pending_cycles, port, value});
+    m_pending_cycles = 0;
+    if (!worker.busy) {
+        worker.work_ready.notify_one();
+    }
+}
+
+void APU::wait_for_worker() {
+    if (m_pending_cycles > 0) {
+        publish(-1, 0);
+    }
+    Worker& worker = *m_worker;
+    std::unique_lock<std::mutex> lock(worker.mutex);
+    worker.work_done.wait(lock, [&worker] { return worker.queue.empty() && !worker.busy; });
+}
+
+void APU::worker_loop() {
+    Worker& worker = *m_worker;
+    std::unique_lock<std::mutex> lock(worker.mutex);
+    for (;;) {
+        worker.work_ready.wait(lock, [&worker] { return worker.stop || !worker.queue.empty(); });
+        if (worker.queue.empty()) return;  // Stopped with nothing left
+        std::swap(worker.queue, worker.running);
+        worker.busy = true;
+        lock.unlock();
+
+        for (const auto& event : worker.running) {
+            run_cycles(event.cycles);
+            if (event.port >= 0) {
+                m_spc->cpu_write_port(event.port, event.value);
+            }
+        }
+        worker.running.clear();
+
+        lock.lock();
+        worker.busy = false;
+        if (worker.queue.empty()) {
+            worker.work_done.notify_all();
+        }
+    }
 }
 
 } // namespace snes
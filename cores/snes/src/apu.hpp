@@ -4,12 +4,15 @@
 #include <array>
 #include <vector>
 #include <memory>
-#include <functional>
+
+#include "emu/audio_stream.hpp"
+#include "emu/state_writer.hpp"
 
 namespace snes {
 
 class SPC700;
 class DSP;
+using emu::StateWriter;
 
 // SNES APU - Wrapper for SPC700 + DSP audio subsystem
 // Handles synchronization between main CPU and audio processor
@@ -20,31 +23,66 @@ public:
 
     void reset();
 
-    // Step APU for given number of master clock cycles
-    void step(int master_cycles);
-
-    // Communication ports (main CPU side)
+    // Advance the APU clock by the given number of master clock cycles
+    // The SPC700 and DSP don't run here; they catch up in sync(), which
+    // happens whenever the main CPU touches a port and at end of frame
+    void step(int master_cycles) {
+        m_pending_cycles += master_cycles;
+        if (m_worker && m_pending_cycles >= PUBLISH_CYCLES) publish(-1, 0);
+    }
+
+    // Run the SPC700 and DSP up to the current master clock
+    void sync();
+
+    // Run the SPC700 and DSP on a worker thread. Port writes are queued
+    // with their master clock time and don't wait; the main CPU only blocks
+    // when it reads a port or at end of frame, until the APU has caught up
+    // to that point. Output is identical to running on the emulation thread.
+    void set_threaded(bool enabled);
+    bool is_threaded() const { return m_worker != nullptr; }
+
+    // Communication ports (main CPU side, sync before access)
     uint8_t read_port(int port);
     void write_port(int port, uint8_t value);
 
-    // Get audio samples (stereo, interleaved)
+    // Get audio samples (stereo, interleaved) at the DSP's own rate
     size_t get_samples(float* buffer, size_t max_samples);
 
-    // Streaming audio callback - called frequently with small batches for low latency
-    // Parameters: samples (interleaved stereo), sample_count (stereo pairs), sample_rate
-    using AudioStreamCallback = std::function<void(const float*, size_t, int)>;
-    void set_audio_callback(AudioStreamCallback callback) { m_audio_callback = callback; }
+    // DSP output rate; samples are handed over unresampled
+    int get_sample_rate() const { return DSP_RATE; }
+
+    // Stream samples through sink as they're produced (low-latency path);
+    // an empty sink buffers them for get_samples() instead
+    void set_audio_sink(const emu::AudioStreamSink& sink);
+
+    // Skip sample generation (fast-forward, seeking); SPC700 and DSP
+    // register state keep running exactly
+    void set_audio_enabled(bool enabled);
 
     // Save state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
+    // The DSP voice state and SPC700 timer dividers, after save_state()
+    void save_internal_state(StateWriter& data);
+    void load_internal_state(const uint8_t*& data, size_t& remaining);
 
 private:
+    void run_cycles(int master_cycles);
+
+    // Threaded mode (see apu.cpp)
+    struct Worker;
+    static constexpr int PUBLISH_CYCLES = 1364 * 4;  // Banked time handed over every ~4 scanlines
+    void publish(int port, uint8_t value);
+    void wait_for_worker();
+    void worker_loop();
+    std::unique_ptr<Worker> m_worker;
+
     std::unique_ptr<SPC700> m_spc;
     std::unique_ptr<DSP> m_dsp;
 
     // Timing
     int m_cycle_counter = 0;
+    int m_pending_cycles = 0;  // Master cycles not yet run by sync()
     static constexpr int MASTER_CYCLES_PER_SPC = 21;  // ~1.024 MHz from 21.477 MHz
 
     // Audio output buffer
@@ -52,20 +90,14 @@ private:
     std::array<float, AUDIO_BUFFER_SIZE * 2> m_audio_buffer;
     size_t m_audio_write_pos = 0;
 
-    // Sample rate conversion
+    // SPC700 cycles toward the next DSP sample
     int m_sample_counter = 0;
-    static constexpr int SAMPLE_RATE = 44100;
     static constexpr int DSP_RATE = 32000;
 
-    // Resampling state
-    int16_t m_last_left = 0;
-    int16_t m_last_right = 0;
+    // Streaming audio
+    emu::AudioStreamWriter m_stream;
 
-    // Streaming audio callback and buffer
-    AudioStreamCallback m_audio_callback;
-    static constexpr size_t STREAM_BUFFER_SIZE = 64;  // Small buffer for low latency
-    float m_stream_buffer[STREAM_BUFFER_SIZE * 2];    // Stereo
-    size_t m_stream_pos = 0;
+    bool m_audio_enabled = true;
 };
 
 } // namespace snes
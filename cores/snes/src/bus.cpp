@@ -4,7 +4,10 @@
 #include "apu.hpp"
 #include "dma.hpp"
 #include "cartridge.hpp"
+#include "coprocessor.hpp"
 #include "debug.hpp"
+#include "emu/state_writer.hpp"
+#include <climits>
 #include <cstring>
 
 namespace snes {
@@ -16,6 +19,7 @@ Bus::Bus() {
     m_wram_addr = 0;
     m_irq_lock = false;
     m_irq_lock_cycles = 0;
+    build_page_map();
 }
 
 Bus::~Bus() = default;
@@ -42,7 +46,7 @@ bool Bus::is_fast_rom_enabled() const {
     return (m_memsel & 0x01) && m_cartridge->is_fast_rom();
 }
 
-int Bus::get_access_cycles(uint32_t address) const {
+int Bus::decode_access_cycles(uint32_t address) const {
     uint8_t bank = (address >> 16) & 0xFF;
     uint16_t offset = address & 0xFFFF;
 
@@ -114,7 +118,86 @@ int Bus::get_access_cycles(uint32_t address) const {
     return 8;
 }
 
+void Bus::build_page_map() {
+    for (int i = 0; i < PAGE_COUNT; i++) {
+        uint32_t base = static_cast<uint32_t>(i) << PAGE_SHIFT;
+        uint8_t bank = (base >> 16) & 0xFF;
+        uint16_t offset = base & 0xFFFF;
+        bool system_bank = bank <= 0x3F || (bank >= 0x80 && bank <= 0xBF);
+
+        Page& page = m_page_map[i];
+        page.read = nullptr;
+        page.write = nullptr;
+
+        // Coprocessor windows must reach the chip (and sync it) on every access
+        if (m_coprocessor && m_coprocessor->maps(base)) {
+            continue;
+        }
+        uint8_t breaks = m_breakpoints ? m_breakpoints->page_flags(base) : 0;
+
+        uint8_t* wram = nullptr;
+        if (bank == 0x7E || bank == 0x7F) {
+            wram = &m_wram[(bank - 0x7E) * 0x10000 + offset];
+        } else if (system_bank && offset < 0x2000) {
+            wram = &m_wram[offset];
+        }
+
+        if (wram) {
+            page.read = wram;
+            page.write = wram;
+        } else if (m_cartridge && !is_debug_mode() && (!system_bank || offset >= 0x8000)) {
+            // ROM pages only; SRAM and the debug-traced reads go through read()
+            int run = 0;
+            const uint8_t* rom = m_cartridge->get_rom_pointer(base, run);
+            if (rom && run >= PAGE_SIZE) {
+                page.read = rom;
+            }
+        }
+
+        // Accesses breakpoints watch take read()/write()'s checked path
+        if (breaks & emu::BREAK_READ) page.read = nullptr;
+        if (breaks & emu::BREAK_WRITE) page.write = nullptr;
+    }
+
+    update_page_speeds();
+}
+
+void Bus::update_page_speeds() {
+    for (int i = 0; i < PAGE_COUNT; i++) {
+        uint32_t base = static_cast<uint32_t>(i) << PAGE_SHIFT;
+        uint8_t bank = (base >> 16) & 0xFF;
+        bool system_bank = bank <= 0x3F || (bank >= 0x80 && bank <= 0xBF);
+        if (system_bank && (base & 0xFFFF) == 0x4000) {
+            m_page_map[i].speed = 0;
+        } else {
+            m_page_map[i].speed = static_cast<uint8_t>(decode_access_cycles(base));
+        }
+    }
+}
+
 uint8_t Bus::read(uint32_t address) {
+    const Page& page = m_page_map[(address >> PAGE_SHIFT) & (PAGE_COUNT - 1)];
+    if (page.read) {
+        m_open_bus = page.read[address & (PAGE_SIZE - 1)];
+        return m_open_bus;
+    }
+
+    // Pages with a read breakpoint are left out of the page map
+    if (m_breakpoints) {
+        uint8_t value = read_unmapped(address);
+        m_breakpoints->check(address, emu::BREAK_READ, value);
+        return value;
+    }
+    return read_unmapped(address);
+}
+
+uint8_t Bus::read_unmapped(uint32_t address) {
+    if (m_coprocessor && m_coprocessor->maps(address)) {
+        m_coprocessor->sync();
+        m_open_bus = m_coprocessor->read(address);
+        return m_open_bus;
+    }
+
     uint8_t bank = (address >> 16) & 0xFF;
     uint16_t offset = address & 0xFFFF;
 
@@ -129,11 +212,10 @@ uint8_t Bus::read(uint32_t address) {
             // APU ports (must be checked BEFORE PPU range)
             if (m_apu) {
                 m_open_bus = m_apu->read_port(offset - 0x2140);
-                static int apu_read_count = 0;
-                apu_read_count++;
-                if (is_debug_mode() && apu_read_count <= 10) {
+                m_debug_apu_reads++;
+                if (is_debug_mode() && m_debug_apu_reads <= 10) {
                     SNES_DEBUG_PRINT("APU port %d read: $%02X (count=%d)\n",
-                        (int)(offset - 0x2140), m_open_bus, apu_read_count);
+                        (int)(offset - 0x2140), m_open_bus, m_debug_apu_reads);
                 }
                 return m_open_bus;
             }
@@ -210,11 +292,55 @@ uint8_t Bus::read(uint32_t address) {
     return m_open_bus;
 }
 
-void Bus::write(uint32_t address, uint8_t value) {
+const uint8_t* Bus::get_dma_source(uint32_t address, int& run) const {
+    if (m_coprocessor && m_coprocessor->maps(address)) return nullptr;
+
     uint8_t bank = (address >> 16) & 0xFF;
     uint16_t offset = address & 0xFFFF;
 
+    if (bank <= 0x3F || (bank >= 0x80 && bank <= 0xBF)) {
+        if (offset < 0x2000) {
+            run = 0x2000 - offset;
+            return &m_wram[offset];
+        }
+        if (offset >= 0x8000 && m_cartridge) {
+            return m_cartridge->get_rom_pointer(address, run);
+        }
+        return nullptr;
+    }
+    if (bank == 0x7E || bank == 0x7F) {
+        run = 0x10000 - offset;
+        return &m_wram[(bank == 0x7F ? 0x10000 : 0) + offset];
+    }
+    if (m_cartridge) {
+        return m_cartridge->get_rom_pointer(address, run);
+    }
+    return nullptr;
+}
+
+void Bus::write(uint32_t address, uint8_t value) {
     m_open_bus = value;
+    if (m_write_watch) m_write_watch->check(address, value);
+
+    const Page& page = m_page_map[(address >> PAGE_SHIFT) & (PAGE_COUNT - 1)];
+    if (page.write) {
+        page.write[address & (PAGE_SIZE - 1)] = value;
+        return;
+    }
+
+    if (m_breakpoints) m_breakpoints->check(address, emu::BREAK_WRITE, value);
+    write_unmapped(address, value);
+}
+
+void Bus::write_unmapped(uint32_t address, uint8_t value) {
+    if (m_coprocessor && m_coprocessor->maps(address)) {
+        m_coprocessor->sync();
+        m_coprocessor->write(address, value);
+        return;
+    }
+
+    uint8_t bank = (address >> 16) & 0xFF;
+    uint16_t offset = address & 0xFFFF;
 
     // Banks $00-$3F and $80-$BF
     if (bank <= 0x3F || (bank >= 0x80 && bank <= 0xBF)) {
@@ -320,6 +446,7 @@ uint8_t Bus::read_cpu_io(uint16_t address) {
     switch (address) {
         case 0x4016:  // JOYSER0 - Joypad 1 data
             {
+                m_controller_read = true;
                 uint8_t result = m_controller_latch[0] & 1;
                 m_controller_latch[0] >>= 1;
                 m_controller_latch[0] |= 0x8000;  // Return 1s after all bits read
@@ -328,6 +455,7 @@ uint8_t Bus::read_cpu_io(uint16_t address) {
 
         case 0x4017:  // JOYSER1 - Joypad 2 data
             {
+                m_controller_read = true;
                 uint8_t result = m_controller_latch[1] & 1;
                 m_controller_latch[1] >>= 1;
                 m_controller_latch[1] |= 0x8000;
@@ -397,15 +525,19 @@ uint8_t Bus::read_cpu_io(uint16_t address) {
             return (m_rdmpy >> 8) & 0xFF;
 
         case 0x4218:  // JOY1L - Joypad 1 (low)
+            m_controller_read = true;
             return m_controller_state[0] & 0xFF;
 
         case 0x4219:  // JOY1H - Joypad 1 (high)
+            m_controller_read = true;
             return (m_controller_state[0] >> 8) & 0xFF;
 
         case 0x421A:  // JOY2L - Joypad 2 (low)
+            m_controller_read = true;
             return m_controller_state[1] & 0xFF;
 
         case 0x421B:  // JOY2H - Joypad 2 (high)
+            m_controller_read = true;
             return (m_controller_state[1] >> 8) & 0xFF;
 
         default:
@@ -417,6 +549,7 @@ void Bus::write_cpu_io(uint16_t address, uint8_t value) {
     switch (address) {
         case 0x4016:  // JOYSER0 - Joypad strobe
             if (value & 1) {
+                poll_live_input();
                 m_controller_latch[0] = m_controller_state[0] & 0xFFFF;
                 m_controller_latch[1] = m_controller_state[1] & 0xFFFF;
             }
@@ -424,12 +557,11 @@ void Bus::write_cpu_io(uint16_t address, uint8_t value) {
 
         case 0x4200:  // NMITIMEN - NMI/IRQ enable
             {
-                static int nmitimen_count = 0;
-                nmitimen_count++;
+                m_debug_nmitimen_writes++;
                 // Log all NMITIMEN writes that enable NMI
-                if (is_debug_mode() && ((value & 0x80) != 0 || nmitimen_count <= 5)) {
+                if (is_debug_mode() && ((value & 0x80) != 0 || m_debug_nmitimen_writes <= 5)) {
                     SNES_DEBUG_PRINT("NMITIMEN write #%d: $%02X (NMI=%s, nmi_line=%d)\n",
-                        nmitimen_count, value, (value & 0x80) ? "enabled" : "disabled",
+                        m_debug_nmitimen_writes, value, (value & 0x80) ? "enabled" : "disabled",
                         m_nmi_line ? 1 : 0);
                 }
 
@@ -539,10 +671,9 @@ void Bus::write_cpu_io(uint16_t address, uint8_t value) {
 
         case 0x420C:  // HDMAEN - HDMA enable
             if (is_debug_mode() && value != 0) {
-                static int hdmaen_count = 0;
-                hdmaen_count++;
-                if (hdmaen_count <= 5) {
-                    SNES_DEBUG_PRINT("HDMAEN write #%d: $%02X\n", hdmaen_count, value);
+                m_debug_hdmaen_writes++;
+                if (m_debug_hdmaen_writes <= 5) {
+                    SNES_DEBUG_PRINT("HDMAEN write #%d: $%02X\n", m_debug_hdmaen_writes, value);
                 }
             }
             m_hdmaen = value;
@@ -553,6 +684,7 @@ void Bus::write_cpu_io(uint16_t address, uint8_t value) {
 
         case 0x420D:  // MEMSEL - FastROM select
             m_memsel = value;
+            update_page_speeds();
             break;
     }
 }
@@ -644,11 +776,10 @@ void Bus::start_scanline() {
             m_irq_triggered_this_line = true;
 
             if (is_debug_mode()) {
-                static int virq_count = 0;
-                virq_count++;
-                if (virq_count <= 10 || virq_count % 100 == 0) {
+                m_debug_virq_count++;
+                if (m_debug_virq_count <= 10 || m_debug_virq_count % 100 == 0) {
                     SNES_DEBUG_PRINT("V-IRQ triggered #%d at V=%d (VTIME=%d)\n",
-                        virq_count, m_ppu->get_scanline(), m_vtime & 0x1FF);
+                        m_debug_virq_count, m_ppu->get_scanline(), m_vtime & 0x1FF);
                 }
             }
         }
@@ -700,11 +831,10 @@ void Bus::start_vblank() {
         m_nmi_transition = true;
         m_nmi_pending = true;
 
-        static int nmi_count = 0;
-        nmi_count++;
-        if (is_debug_mode() && (nmi_count <= 5 || nmi_count % 50 == 0)) {
+        m_debug_nmi_count++;
+        if (is_debug_mode() && (m_debug_nmi_count <= 5 || m_debug_nmi_count % 50 == 0)) {
             SNES_DEBUG_PRINT("NMI triggered #%d (NMITIMEN=$%02X, hold=%d)\n",
-                nmi_count, m_nmitimen, m_nmi_hold_cycles);
+                m_debug_nmi_count, m_nmitimen, m_nmi_hold_cycles);
         }
     }
 
@@ -712,6 +842,7 @@ void Bus::start_vblank() {
     if (m_auto_joypad_read) {
         m_joypad_counter = 4224;  // Takes ~4224 master cycles
         // Latch controllers
+        poll_live_input();
         m_controller_latch[0] = m_controller_state[0];
         m_controller_latch[1] = m_controller_state[1];
     }
@@ -720,6 +851,13 @@ void Bus::start_vblank() {
     // This ensures V-IRQ fires at any scanline VTIME, not just at vblank
 }
 
+void Bus::poll_live_input() {
+    if (!m_input_poll) return;
+    // Frames run from scanline 0, so the auto-joypad read lands ~86% in
+    float position = m_ppu ? static_cast<float>(m_ppu->get_scanline()) / 262.0f : 0.0f;
+    set_controller_state(0, m_input_poll.poll(m_input_poll.context, position));
+}
+
 void Bus::add_cycles(int master_cycles) {
     // Decrement auto-joypad counter
     if (m_joypad_counter > 0) {
@@ -775,10 +913,9 @@ void Bus::poll_nmi() {
         m_nmi_pending = true;
 
         if (is_debug_mode()) {
-            static int edge_count = 0;
-            edge_count++;
-            if (edge_count <= 10) {
-                SNES_DEBUG_PRINT("NMI edge detected #%d (poll_nmi)\n", edge_count);
+            m_debug_nmi_edges++;
+            if (m_debug_nmi_edges <= 10) {
+                SNES_DEBUG_PRINT("NMI edge detected #%d (poll_nmi)\n", m_debug_nmi_edges);
             }
         }
     }
@@ -874,11 +1011,10 @@ bool Bus::check_irq_trigger() {
         m_irq_triggered_this_line = true;
 
         if (is_debug_mode()) {
-            static int irq_count = 0;
-            irq_count++;
-            if (irq_count <= 10 || irq_count % 100 == 0) {
+            m_debug_irq_count++;
+            if (m_debug_irq_count <= 10 || m_debug_irq_count % 100 == 0) {
                 SNES_DEBUG_PRINT("IRQ triggered #%d: V=%d H=%d (VTIME=%d HTIME=%d NMITIMEN=$%02X)\n",
-                    irq_count, vcounter, hcounter, vtime, htime, m_nmitimen);
+                    m_debug_irq_count, vcounter, hcounter, vtime, htime, m_nmitimen);
             }
         }
         return true;
@@ -887,6 +1023,23 @@ bool Bus::check_irq_trigger() {
     return false;
 }
 
+int Bus::get_cycles_until_interrupt() const {
+    if (m_irq_lock) return 0;
+
+    // Only H and HV IRQs fire mid-line (see check_irq_trigger()); the H
+    // counter stops at 340, so a later HTIME never comes
+    int htime = m_htime & 0x1FF;
+    if (!(m_nmitimen & 0x10) || m_irq_triggered_this_line || m_hcounter >= htime || htime > 340) {
+        return INT_MAX;
+    }
+    if ((m_nmitimen & 0x20) && m_ppu && m_ppu->get_scanline() != (m_vtime & 0x1FF)) {
+        // Not this line; the PPU may reach VTIME before the frame loop's
+        // next line starts
+        return m_ppu->get_cycles_until_dot(0);
+    }
+    return (htime - m_hcounter) * 4;
+}
+
 bool Bus::irq_pending() const {
     // IRQ can only be serviced if the IRQ lock is not active
     return (m_irq_flag || m_irq_line) && !m_irq_lock;
@@ -904,10 +1057,16 @@ void Bus::set_irq_line(bool active) {
     m_irq_line = active;
 }
 
-void Bus::save_state(std::vector<uint8_t>& data) {
-    // Save WRAM
-    data.insert(data.end(), m_wram.begin(), m_wram.end());
+void Bus::save_state(StateWriter& data) {
+    save_work_ram(data);
+    save_registers(data);
+}
+
+void Bus::save_work_ram(StateWriter& data) {
+    data.write(m_wram.data(), m_wram.size());
+}
 
+void Bus::save_registers(StateWriter& data) {
     // Save I/O state
     data.push_back(m_nmitimen);
     data.push_back(m_wrio);
@@ -954,10 +1113,17 @@ void Bus::save_state(std::vector<uint8_t>& data) {
 }
 
 void Bus::load_state(const uint8_t*& data, size_t& remaining) {
-    // Load WRAM
+    load_work_ram(data, remaining);
+    load_registers(data, remaining);
+}
+
+void Bus::load_work_ram(const uint8_t*& data, size_t& remaining) {
+    if (remaining < m_wram.size()) return;
     std::memcpy(m_wram.data(), data, m_wram.size());
     data += m_wram.size(); remaining -= m_wram.size();
+}
 
+void Bus::load_registers(const uint8_t*& data, size_t& remaining) {
     // Load I/O state
     m_nmitimen = *data++; remaining--;
     m_wrio = *data++; remaining--;
@@ -968,6 +1134,7 @@ void Bus::load_state(const uint8_t*& data, size_t& remaining) {
     m_mdmaen = *data++; remaining--;
     m_hdmaen = *data++; remaining--;
     m_memsel = *data++; remaining--;
+    update_page_speeds();
 
     // Load math state
     m_rddiv = data[0] | (data[1] << 8);
@@ -4,6 +4,10 @@
 #include <array>
 #include <vector>
 #include "debug.hpp"
+#include "emu/input_poll.hpp"
+#include "emu/breakpoints.hpp"
+#include "emu/state_writer.hpp"
+#include "emu/write_watch.hpp"
 
 namespace snes {
 
@@ -12,6 +16,8 @@ class PPU;
 class APU;
 class DMA;
 class Cartridge;
+class Coprocessor;
+using emu::StateWriter;
 
 // SNES Memory Bus - connects all components
 // Handles the complex SNES memory mapping
@@ -26,6 +32,7 @@ public:
     void connect_apu(APU* apu) { m_apu = apu; }
     void connect_dma(DMA* dma) { m_dma = dma; }
     void connect_cartridge(Cartridge* cart) { m_cartridge = cart; }
+    void connect_coprocessor(Coprocessor* coprocessor) { m_coprocessor = coprocessor; }
 
     // Component access (for debug)
     PPU& ppu() { return *m_ppu; }
@@ -37,6 +44,16 @@ public:
     // Controller input
     void set_controller_state(int controller, uint32_t buttons);
 
+    // Set when the game reads the pads ($4016/$4017 serial data or the
+    // $4218-$421B auto-joypad registers); the frame loop clears it at the
+    // start of each frame, so it ends the frame false on a lag frame
+    bool was_controller_read() const { return m_controller_read; }
+    void clear_controller_read() { m_controller_read = false; }
+
+    // Controller 1 is read through poll whenever the pads are latched
+    // (auto-joypad read or $4016 strobe), if set
+    void set_input_poll(const emu::InputPoll& poll) { m_input_poll = poll; }
+
     // Frame timing
     void start_frame();
     void start_scanline();  // Check V-IRQ at start of each scanline
@@ -61,16 +78,59 @@ public:
     void update_hcounter(int master_cycles);
     bool check_irq_trigger();
 
+    // Master cycles that can pass before the clock alone could change what
+    // the CPU sees of NMI and IRQ within this line: an H or HV IRQ coming
+    // due, or the IRQ lock running out (0 while it's on). Line starts and
+    // VBlank are left to the frame loop, which runs them.
+    int get_cycles_until_interrupt() const;
+
     // CPU I/O register access ($4200-$421F)
     uint8_t read_cpu_io(uint16_t address);
     void write_cpu_io(uint16_t address, uint8_t value);
 
+    // Watchpoints checked on every CPU write, or nullptr for none
+    void set_write_watch(emu::WriteWatchpoints* watch) { m_write_watch = watch; }
+
+    // Read and write breakpoints, or nullptr for none. Their pages leave
+    // the page map, so only accesses to those pages are checked.
+    void set_breakpoints(emu::Breakpoints* breakpoints) {
+        m_breakpoints = breakpoints;
+        build_page_map();
+    }
+
     // Get/set open bus value
     uint8_t get_open_bus() const { return m_open_bus; }
+    void set_open_bus(uint8_t value) { m_open_bus = value; }
+
+    // Direct pointer to side-effect-free A-bus memory (WRAM or cartridge ROM)
+    // for DMA bursts; `run` receives the contiguous byte count. Returns
+    // nullptr for I/O and anything else that must go through read().
+    const uint8_t* get_dma_source(uint32_t address, int& run) const;
+
+    // Plain memory (WRAM, cartridge ROM and RAM) read without side effects
+    // or open bus update, for tracing; the open bus value for anything else
+    uint8_t peek(uint32_t address) const {
+        const Page& page = m_page_map[(address >> PAGE_SHIFT) & (PAGE_COUNT - 1)];
+        if (page.read) return page.read[address & (PAGE_SIZE - 1)];
+        int run = 0;
+        const uint8_t* memory = get_dma_source(address, run);  // Pages left out for breakpoints
+        return memory ? *memory : m_open_bus;
+    }
+
+    // Work RAM, for memory domains
+    const uint8_t* get_wram_data() const { return m_wram.data(); }
 
     // Memory access timing (returns master cycles for a given address)
     // Reference: bsnes/sfc/cpu/timing.cpp, anomie's SNES docs
-    int get_access_cycles(uint32_t address) const;
+    int get_access_cycles(uint32_t address) const {
+        int speed = m_page_map[(address >> PAGE_SHIFT) & (PAGE_COUNT - 1)].speed;
+        if (speed != 0) return speed;
+        // $4000-$41FF (joypad) is XSlow, the rest of that page is fast
+        return (address & 0xFFFF) < 0x4200 ? 12 : 6;
+    }
+
+    // Rebuild the page map after the cartridge or coprocessor changes
+    void build_page_map();
 
     // Check if FastROM is enabled (MEMSEL bit 0 and cartridge supports it)
     bool is_fast_rom_enabled() const;
@@ -82,9 +142,16 @@ public:
     bool blargg_test_completed() const { return m_blargg_state.should_exit(); }
 
     // Save state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
 
+    // The two halves of save_state(), which are separate state chunks:
+    // the 128KB of WRAM, and the I/O registers
+    void save_work_ram(StateWriter& data);
+    void load_work_ram(const uint8_t*& data, size_t& remaining);
+    void save_registers(StateWriter& data);
+    void load_registers(const uint8_t*& data, size_t& remaining);
+
 private:
     // Components
     CPU* m_cpu = nullptr;
@@ -92,18 +159,47 @@ private:
     APU* m_apu = nullptr;
     DMA* m_dma = nullptr;
     Cartridge* m_cartridge = nullptr;
+    Coprocessor* m_coprocessor = nullptr;
 
     // Work RAM (128KB)
     std::array<uint8_t, 0x20000> m_wram;
 
+    emu::WriteWatchpoints* m_write_watch = nullptr;
+    emu::Breakpoints* m_breakpoints = nullptr;
+
+    // read() and write() for addresses the page map doesn't cover
+    uint8_t read_unmapped(uint32_t address);
+    void write_unmapped(uint32_t address, uint8_t value);
+
+    // Page map: one entry per 8KB page of the 24-bit address space. Pages
+    // backed by plain memory (WRAM, cartridge ROM) carry host pointers so
+    // read()/write() skip the bank/offset decode; speed is the access time
+    // in master cycles (0 = varies within the page). Speeds are patched on
+    // MEMSEL writes.
+    static constexpr int PAGE_SHIFT = 13;
+    static constexpr int PAGE_SIZE = 1 << PAGE_SHIFT;
+    static constexpr int PAGE_COUNT = 0x1000000 >> PAGE_SHIFT;
+    struct Page {
+        const uint8_t* read = nullptr;
+        uint8_t* write = nullptr;
+        uint8_t speed = 8;
+    };
+    std::array<Page, PAGE_COUNT> m_page_map;
+
+    int decode_access_cycles(uint32_t address) const;
+    void update_page_speeds();
+
     // Open bus value
     uint8_t m_open_bus = 0;
 
     // Controller state
     std::array<uint32_t, 2> m_controller_state;
     std::array<uint16_t, 2> m_controller_latch;
+    bool m_controller_read = false;
     bool m_auto_joypad_read = false;
     int m_joypad_counter = 0;
+    emu::InputPoll m_input_poll;
+    void poll_live_input();
 
     // CPU I/O registers ($4200-$421F)
     uint8_t m_nmitimen = 0;    // $4200 - NMI/IRQ enable
@@ -153,6 +249,15 @@ private:
 
     // Blargg test state (for automated testing)
     BlarggTestState m_blargg_state;
+
+    // Debug output limits (DEBUG=1)
+    int m_debug_apu_reads = 0;
+    int m_debug_nmitimen_writes = 0;
+    int m_debug_hdmaen_writes = 0;
+    int m_debug_virq_count = 0;
+    int m_debug_nmi_count = 0;
+    int m_debug_nmi_edges = 0;
+    int m_debug_irq_count = 0;
 };
 
 } // namespace snes
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "emu/state_writer.hpp"
+
 #include <cstdint>
 #include <cstddef>
 #include <vector>
@@ -8,6 +10,8 @@
 
 namespace snes {
 
+using emu::StateWriter;
+
 // SNES ROM mapping types
 enum class MapperType {
     LoROM,      // Mode $20 - PRG mapped to banks $00-$7D, $80-$FF at $8000-$FFFF
@@ -75,6 +79,11 @@ public:
     uint8_t read(uint32_t address);
     void write(uint32_t address, uint8_t value);
 
+    // Direct ROM pointer for DMA bursts. `run` receives how many bytes follow
+    // contiguously in both the bank and the ROM image; returns nullptr for
+    // anything read() would not serve from ROM.
+    const uint8_t* get_rom_pointer(uint32_t address, int& run) const;
+
     // ROM info
     uint32_t get_crc32() const { return m_crc32; }
     const std::string& get_title() const { return m_title; }
@@ -85,6 +94,8 @@ public:
     // ROM size info
     size_t get_rom_size() const { return m_rom.size(); }
     size_t get_ram_size() const { return m_sram.size(); }
+    const uint8_t* get_rom_data() const { return m_rom.data(); }
+    const uint8_t* get_ram_data() const { return m_sram.data(); }
 
     // Battery-backed save support
     bool has_battery() const { return m_has_battery; }
@@ -95,8 +106,11 @@ public:
     // Set battery-backed save data
     bool set_save_data(const std::vector<uint8_t>& data);
 
+    // Bumped on every SRAM write and state load
+    uint64_t get_save_generation() const { return m_save_generation; }
+
     // Save state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
 
     // Speed info (for FastROM detection)
@@ -107,7 +121,6 @@ private:
     bool detect_header(const uint8_t* data, size_t size);
     bool parse_header(const uint8_t* header_data);
     int score_header(const uint8_t* header_data, size_t rom_size);
-    uint32_t calculate_crc32(const uint8_t* data, size_t size);
 
     // Memory mapping helpers
     uint8_t read_lorom(uint32_t address);
@@ -120,6 +133,7 @@ private:
 
     // SRAM (battery-backed or volatile)
     std::vector<uint8_t> m_sram;
+    uint64_t m_save_generation = 0;
 
     // ROM info
     bool m_loaded = false;
@@ -136,6 +150,10 @@ private:
 
     // Header offset (for proper vector reading)
     size_t m_header_offset = 0;
+
+    // Debug output limits (DEBUG=1)
+    int m_debug_lorom_reads = 0;
+    int m_debug_dma_source_reads = 0;
 };
 
 } // namespace snes
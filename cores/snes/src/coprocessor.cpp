@@ -0,0 +1,24 @@
+#include "coprocessor.hpp"
+#include "cartridge.hpp"
+#include "debug.hpp"
+
+namespace snes {
+
+std::unique_ptr<Coprocessor> create_coprocessor(EnhancementChip chip, Cartridge& cartridge) {
+    (void)cartridge;
+
+    switch (chip) {
+        case EnhancementChip::None:
+            return nullptr;
+
+        // SA-1: second 65C816 at 10.74 MHz, I/O at $2200-$23FF, I-RAM at
+        // $3000-$37FF, BW-RAM at $40-$4F and $6000-$7FFF.
+        // SuperFX: GSU at up to 21.4 MHz, I/O and cache at $3000-$34FF.
+        // DSP-1: command-driven math unit on the ROM data/status ports.
+        default:
+            SNES_DEBUG_PRINT("Enhancement chip %d is not emulated\n", static_cast<int>(chip));
+            return nullptr;
+    }
+}
+
+} // namespace snes
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "emu/state_writer.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+namespace snes {
+
+class Cartridge;
+using emu::StateWriter;
+enum class EnhancementChip;
+
+// Base class for cartridge enhancement chips (SA-1, SuperFX, DSP-n, ...)
+//
+// Coprocessors are scheduled like the APU: the frame loop only banks
+// master cycles with step(), and the chip runs in one batch in sync(),
+// which happens whenever the main CPU touches an address the chip owns
+// and at end of frame. A chip never runs instruction-interleaved with
+// the 65C816, so a SuperFX program costs one tight loop per batch.
+//
+// A chip whose state the main CPU can observe without going through
+// maps() (shared RAM polled by the CPU, IRQ lines) must keep its batches
+// short enough by overriding max_batch_cycles().
+class Coprocessor {
+public:
+    virtual ~Coprocessor() = default;
+
+    virtual void reset() = 0;
+
+    // Advance the chip clock by the given number of master clock cycles
+    void step(int master_cycles) {
+        m_pending_cycles += master_cycles;
+        if (m_pending_cycles >= max_batch_cycles()) sync();
+    }
+
+    // Run the chip up to the current master clock. run() may overshoot;
+    // the excess is carried as debt into the next batch.
+    void sync() {
+        if (m_pending_cycles > 0) m_pending_cycles -= run(m_pending_cycles);
+    }
+
+    // Master cycles step() can still bank before it syncs on its own
+    int get_cycles_until_sync() const { return max_batch_cycles() - m_pending_cycles; }
+
+    // Main CPU access to the chip's registers and private memory. The bus
+    // calls sync() before read()/write() for any address maps() claims.
+    // Claims over WRAM or ROM must cover whole 8KB bus pages.
+    virtual bool maps(uint32_t address) const = 0;
+    virtual uint8_t read(uint32_t address) = 0;
+    virtual void write(uint32_t address, uint8_t value) = 0;
+
+    // Save state
+    virtual void save_state(StateWriter& data) = 0;
+    virtual void load_state(const uint8_t*& data, size_t& remaining) = 0;
+
+protected:
+    // Run for at least master_cycles; returns the master cycles consumed
+    virtual int run(int master_cycles) = 0;
+
+    // Longest batch before the chip is synced without a CPU access
+    virtual int max_batch_cycles() const { return 1364 * 262; }
+
+    int m_pending_cycles = 0;  // Master cycles not yet run by sync()
+};
+
+// Create the coprocessor for a cartridge's enhancement chip. Returns
+// nullptr for cartridges without one and for chips not emulated yet.
+std::unique_ptr<Coprocessor> create_coprocessor(EnhancementChip chip, Cartridge& cartridge);
+
+} // namespace snes
@@ -1,10 +1,22 @@
 #include "cpu.hpp"
 #include "bus.hpp"
 #include "debug.hpp"
+#include "emu/state_writer.hpp"
 #include <cstring>
 
 namespace snes {
 
+namespace {
+
+// Registers whose reads or writes depend on where the PPU and H counter are
+bool is_timed_register(uint32_t address) {
+    if (address & 0x400000) return false;  // Banks $40-$7F and $C0-$FF
+    uint32_t offset = address & 0xFFFF;
+    return offset - 0x2100u < 0x40u || offset - 0x4200u < 0x20u;
+}
+
+} // namespace
+
 CPU::CPU(Bus& bus) : m_bus(bus) {
     reset();
 }
@@ -26,6 +38,8 @@ void CPU::reset() {
     m_wai_waiting = false;
     m_stp_stopped = false;
     m_cycles = 0;
+    m_poll_loop = {};
+    update_execute();
 
     // Read reset vector
     uint8_t lo = m_bus.read(VEC_RESET);
@@ -73,15 +87,26 @@ int CPU::step() {
     return m_cycles;
 }
 
+bool CPU::is_idle() const {
+    if (m_stp_stopped) return true;
+    return m_wai_waiting && !m_nmi_pending && !(m_irq_line && !get_flag(FLAG_I));
+}
+
+bool CPU::take_poll_loop(PollLoop& loop) {
+    if (m_poll_loop.cycles == 0) return false;
+    loop = m_poll_loop;
+    m_poll_loop = {};
+    return m_poll_loop_head == get_full_pc() && !m_nmi_pending && !(m_irq_line && !get_flag(FLAG_I));
+}
+
 void CPU::trigger_nmi() {
     m_nmi_pending = true;
     if (m_wai_waiting) {
         m_wai_waiting = false;
     }
-    static int s_nmi_count = 0;
-    if (is_debug_mode() && s_nmi_count < 10) {
+    if (is_debug_mode() && m_debug_nmi_count < 10) {
         SNES_CPU_DEBUG("NMI triggered! PC=$%02X:%04X\n", m_pbr, m_pc);
-        s_nmi_count++;
+        m_debug_nmi_count++;
     }
 }
 
@@ -100,11 +125,13 @@ void CPU::set_irq_line(bool active) {
 // Reference: bsnes/sfc/cpu/timing.cpp, anomie's SNES docs
 uint8_t CPU::read(uint32_t address) {
     m_cycles += m_bus.get_access_cycles(address);
+    if (m_access_sync && is_timed_register(address)) m_access_sync(m_access_sync_context, m_cycles);
     return m_bus.read(address);
 }
 
 void CPU::write(uint32_t address, uint8_t value) {
     m_cycles += m_bus.get_access_cycles(address);
+    if (m_access_sync && is_timed_register(address)) m_access_sync(m_access_sync_context, m_cycles);
     m_bus.write(address, value);
 }
 
@@ -193,15 +220,17 @@ uint32_t CPU::addr_immediate16() {
     return addr;
 }
 
+template <bool M8>
 uint32_t CPU::addr_immediate_m() {
-    if (get_flag(FLAG_M)) {
+    if (M8) {
         return addr_immediate8();
     }
     return addr_immediate16();
 }
 
+template <bool X8>
 uint32_t CPU::addr_immediate_x() {
-    if (get_flag(FLAG_X)) {
+    if (X8) {
         return addr_immediate8();
     }
     return addr_immediate16();
@@ -359,8 +388,9 @@ void CPU::update_nz16(uint16_t value) {
     set_flag(FLAG_N, (value & 0x8000) != 0);
 }
 
+template <bool M8>
 void CPU::update_nz_m(uint16_t value) {
-    if (get_flag(FLAG_M)) {
+    if (M8) {
         update_nz8(value & 0xFF);
     } else {
         update_nz16(value);
@@ -646,9 +676,65 @@ void CPU::branch(bool condition) {
         if (m_emulation && ((old_pc & 0xFF00) != (m_pc & 0xFF00))) {
             m_cycles += 6;
         }
+
+        if (offset >= -8 && offset <= -5) detect_poll_loop(-offset);
     }
 }
 
+// Waits on VBlank, HBlank or the NMI flag are written as
+//     LDA $4212 / LDA $004212 / BIT $4212
+//     (AND #mask)
+//     Bxx back to the read
+// with an 8-bit accumulator. The branch may only depend on bits that move
+// with the PPU's position, not HVBJOY's auto-joypad busy flag.
+void CPU::detect_poll_loop(int length) {
+    if (!(m_emulation || get_flag(FLAG_M)) || m_trace || m_breakpoints) return;
+
+    uint32_t head = get_full_pc();
+    int run = 0;
+    const uint8_t* code = m_bus.get_dma_source(head, run);
+    if (!code || run < length) return;
+
+    int read_length = code[0] == 0xAF ? 4 : 3;
+    bool masked = length == read_length + 4;
+    if (length != read_length + 2 && !masked) return;
+    if (code[0] != 0xAD && code[0] != 0xAF && !(code[0] == 0x2C && !masked)) return;
+    if (masked && code[read_length] != 0x29) return;
+
+    uint32_t address = code[1] | (code[2] << 8) |
+                       (read_length == 4 ? code[3] << 16 : static_cast<uint32_t>(m_dbr) << 16);
+    uint16_t offset = address & 0xFFFF;
+    if ((address & 0x400000) || (offset != 0x4210 && offset != 0x4212)) return;
+
+    uint8_t branch_op = code[length - 2];
+    bool on_sign = branch_op == 0x10 || branch_op == 0x30;
+    bool on_zero = branch_op == 0xD0 || branch_op == 0xF0;
+    uint8_t bits = 0;
+    if (masked) {
+        if (on_zero) bits = code[read_length + 1];
+        else if (on_sign) bits = code[read_length + 1] & 0x80;
+    } else if (code[0] == 0x2C) {
+        if (on_sign) bits = 0x80;
+        else if (branch_op == 0x50 || branch_op == 0x70) bits = 0x40;
+        else if (on_zero) bits = m_a & 0xFF;
+    } else if (on_sign) {
+        bits = 0x80;
+    }
+    if (bits == 0 || (offset == 0x4212 && (bits & 0x01))) return;
+
+    // Every byte fetched, the register read and the taken branch
+    int cycles = m_bus.get_access_cycles(address) + 6;
+    for (int i = 0; i < length; i++) {
+        cycles += m_bus.get_access_cycles((head & 0xFF0000) | static_cast<uint16_t>(head + i));
+    }
+    if (m_emulation && ((head + length) & 0xFF00) != (head & 0xFF00)) cycles += 6;
+
+    m_poll_loop.address = address;
+    m_poll_loop.bits = bits;
+    m_poll_loop.cycles = cycles;
+    m_poll_loop_head = head;
+}
+
 // Interrupt handling
 void CPU::do_interrupt(uint16_t vector, bool is_brk) {
     m_cycles += 6;  // Internal operation
@@ -677,27 +763,56 @@ void CPU::do_interrupt(uint16_t vector, bool is_brk) {
 
 // Main execution
 void CPU::execute() {
-    static int s_trace_count = 0;
-    static uint16_t s_last_pc = 0xFFFF;
 
     uint16_t current_pc = m_pc;
     uint8_t opcode = read_pc();
+    if (m_trace) trace_instruction(current_pc, opcode);
+    if (m_breakpoints) {
+        m_breakpoints->check((static_cast<uint32_t>(m_pbr) << 16) | current_pc, emu::BREAK_EXECUTE, opcode);
+    }
 
     // Trace first 100 unique instructions or if stuck in a loop
-    if (is_debug_mode() && (s_trace_count < 100 || current_pc == s_last_pc)) {
-        if (current_pc != s_last_pc || s_trace_count < 10) {
+    if (is_debug_mode() && (m_debug_trace_count < 100 || current_pc == m_debug_last_pc)) {
+        if (current_pc != m_debug_last_pc || m_debug_trace_count < 10) {
             fprintf(stderr, "[SNES/CPU] %02X:%04X op=%02X A=%04X X=%04X Y=%04X SP=%04X P=%02X DBR=%02X%s\n",
                 m_pbr, current_pc, opcode, m_a, m_x, m_y, m_sp, m_status, m_dbr,
                 m_emulation ? " (E)" : "");
-            s_trace_count++;
+            m_debug_trace_count++;
         }
     }
-    s_last_pc = current_pc;
+    m_debug_last_pc = current_pc;
+
+    (this->*m_execute)(opcode);
+}
 
+void CPU::trace_instruction(uint16_t pc, uint8_t opcode) {
+    emu::CpuTraceRecord& record = m_trace->append();
+    uint32_t bank = static_cast<uint32_t>(m_pbr) << 16;
+    record.pc = bank | pc;
+    record.opcode[0] = opcode;
+    for (int i = 1; i < 4; i++) {
+        // Operands wrap within the program bank, as the fetches do
+        record.opcode[i] = m_bus.peek(bank | static_cast<uint16_t>(pc + i));
+    }
+    record.arch = static_cast<uint8_t>(emu::CpuTraceArch::WDC65816);
+    record.flags = m_emulation ? emu::CPU_TRACE_EMULATION : 0;
+    record.regs[0] = m_a;
+    record.regs[1] = m_x;
+    record.regs[2] = m_y;
+    record.regs[3] = m_sp;
+    record.regs[4] = m_status;
+    record.regs[5] = m_dp;
+    record.regs[6] = m_dbr;
+}
+
+// Opcode handlers, specialized on the E, M and X flags so the width checks
+// fold away. E=1 always has M=X=1, leaving five live combinations.
+template <bool E, bool M8, bool X8>
+void CPU::execute_op(uint8_t opcode) {
     switch (opcode) {
         // ADC - Add with Carry
         case 0x69:  // ADC #imm
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 op_adc8(read(addr_immediate8()));
             } else {
                 uint32_t addr = addr_immediate16();
@@ -706,7 +821,7 @@ void CPU::execute() {
             break;
         case 0x65: { // ADC dp
             uint32_t addr = addr_direct();
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 op_adc8(read(addr));
             } else {
                 op_adc16(read(addr) | (read(addr + 1) << 8));
@@ -715,7 +830,7 @@ void CPU::execute() {
         }
         case 0x75: { // ADC dp,X
             uint32_t addr = addr_direct_x();
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 op_adc8(read(addr));
             } else {
                 op_adc16(read(addr) | (read(addr + 1) << 8));
@@ -724,7 +839,7 @@ void CPU::execute() {
         }
         case 0x6D: { // ADC abs
             uint32_t addr = addr_absolute();
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 op_adc8(read(addr));
             } else {
                 op_adc16(read(addr) | (read(addr + 1) << 8));
@@ -733,7 +848,7 @@ void CPU::execute() {
         }
         case 0x7D: { // ADC abs,X
             uint32_t addr = addr_absolute_x();
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 op_adc8(read(addr));
             } else {
                 op_adc16(read(addr) | (read(addr + 1) << 8));
@@ -742,7 +857,7 @@ void CPU::execute() {
         }
         case 0x79: { // ADC abs,Y
             uint32_t addr = addr_absolute_y();
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 op_adc8(read(addr));
             } else {
                 op_adc16(read(addr) | (read(addr + 1) << 8));
@@ -751,7 +866,7 @@ void CPU::execute() {
         }
         case 0x6F: { // ADC long
             uint32_t addr = addr_absolute_long();
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 op_adc8(read(addr));
             } else {
                 op_adc16(read(addr) | (read(addr + 1) << 8));
@@ -760,7 +875,7 @@ void CPU::execute() {
         }
         case 0x7F: { // ADC long,X
             uint32_t addr = addr_absolute_long_x();
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 op_adc8(read(addr));
             } else {
                 op_adc16(read(addr) | (read(addr + 1) << 8));
@@ -769,7 +884,7 @@ void CPU::execute() {
         }
         case 0x72: { // ADC (dp)
             uint32_t addr = addr_direct_indirect();
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 op_adc8(read(addr));
             } else {
                 op_adc16(read(addr) | (read(addr + 1) << 8));
@@ -778,7 +893,7 @@ void CPU::execute() {
         }
         case 0x67: { // ADC [dp]
             uint32_t addr = addr_direct_indirect_long();
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 op_adc8(read(addr));
             } else {
                 op_adc16(read(addr) | (read(addr + 1) << 8));
@@ -787,7 +902,7 @@ void CPU::execute() {
         }
         case 0x61: { // ADC (dp,X)
             uint32_t addr = addr_direct_x_indirect();
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 op_adc8(read(addr));
             } else {
                 op_adc16(read(addr) | (read(addr + 1) << 8));
@@ -796,7 +911,7 @@ void CPU::execute() {
         }
         case 0x71: { // ADC (dp),Y
             uint32_t addr = addr_direct_indirect_y();
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 op_adc8(read(addr));
             } else {
                 op_adc16(read(addr) | (read(addr + 1) << 8));
@@ -805,7 +920,7 @@ void CPU::execute() {
         }
         case 0x77: { // ADC [dp],Y
             uint32_t addr = addr_direct_indirect_long_y();
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 op_adc8(read(addr));
             } else {
                 op_adc16(read(addr) | (read(addr + 1) << 8));
@@ -814,7 +929,7 @@ void CPU::execute() {
         }
         case 0x63: { // ADC sr,S
             uint32_t addr = addr_stack_relative();
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 op_adc8(read(addr));
             } else {
                 op_adc16(read(addr) | (read(addr + 1) << 8));
@@ -823,7 +938,7 @@ void CPU::execute() {
         }
         case 0x73: { // ADC (sr,S),Y
             uint32_t addr = addr_stack_relative_indirect_y();
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 op_adc8(read(addr));
             } else {
                 op_adc16(read(addr) | (read(addr + 1) << 8));
@@ -833,41 +948,41 @@ void CPU::execute() {
 
         // AND - Logical AND
         case 0x29:  // AND #imm
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 op_and8(read(addr_immediate8()));
             } else {
                 uint32_t addr = addr_immediate16();
                 op_and16(read(addr) | (read(addr + 1) << 8));
             }
             break;
-        case 0x25: { uint32_t a = addr_direct(); if (get_flag(FLAG_M)) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
-        case 0x35: { uint32_t a = addr_direct_x(); if (get_flag(FLAG_M)) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
-        case 0x2D: { uint32_t a = addr_absolute(); if (get_flag(FLAG_M)) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
-        case 0x3D: { uint32_t a = addr_absolute_x(); if (get_flag(FLAG_M)) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
-        case 0x39: { uint32_t a = addr_absolute_y(); if (get_flag(FLAG_M)) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
-        case 0x2F: { uint32_t a = addr_absolute_long(); if (get_flag(FLAG_M)) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
-        case 0x3F: { uint32_t a = addr_absolute_long_x(); if (get_flag(FLAG_M)) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
-        case 0x32: { uint32_t a = addr_direct_indirect(); if (get_flag(FLAG_M)) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
-        case 0x27: { uint32_t a = addr_direct_indirect_long(); if (get_flag(FLAG_M)) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
-        case 0x21: { uint32_t a = addr_direct_x_indirect(); if (get_flag(FLAG_M)) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
-        case 0x31: { uint32_t a = addr_direct_indirect_y(); if (get_flag(FLAG_M)) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
-        case 0x37: { uint32_t a = addr_direct_indirect_long_y(); if (get_flag(FLAG_M)) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
-        case 0x23: { uint32_t a = addr_stack_relative(); if (get_flag(FLAG_M)) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
-        case 0x33: { uint32_t a = addr_stack_relative_indirect_y(); if (get_flag(FLAG_M)) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
+        case 0x25: { uint32_t a = addr_direct(); if (M8) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
+        case 0x35: { uint32_t a = addr_direct_x(); if (M8) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
+        case 0x2D: { uint32_t a = addr_absolute(); if (M8) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
+        case 0x3D: { uint32_t a = addr_absolute_x(); if (M8) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
+        case 0x39: { uint32_t a = addr_absolute_y(); if (M8) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
+        case 0x2F: { uint32_t a = addr_absolute_long(); if (M8) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
+        case 0x3F: { uint32_t a = addr_absolute_long_x(); if (M8) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
+        case 0x32: { uint32_t a = addr_direct_indirect(); if (M8) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
+        case 0x27: { uint32_t a = addr_direct_indirect_long(); if (M8) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
+        case 0x21: { uint32_t a = addr_direct_x_indirect(); if (M8) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
+        case 0x31: { uint32_t a = addr_direct_indirect_y(); if (M8) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
+        case 0x37: { uint32_t a = addr_direct_indirect_long_y(); if (M8) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
+        case 0x23: { uint32_t a = addr_stack_relative(); if (M8) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
+        case 0x33: { uint32_t a = addr_stack_relative_indirect_y(); if (M8) op_and8(read(a)); else op_and16(read(a)|(read(a+1)<<8)); break; }
 
         // ASL - Arithmetic Shift Left
         case 0x0A:  // ASL A
             m_cycles += 6;
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 m_a = (m_a & 0xFF00) | op_asl8(m_a & 0xFF);
             } else {
                 m_a = op_asl16(m_a);
             }
             break;
-        case 0x06: { uint32_t a = addr_direct(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_asl8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_asl16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
-        case 0x16: { uint32_t a = addr_direct_x(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_asl8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_asl16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
-        case 0x0E: { uint32_t a = addr_absolute(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_asl8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_asl16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
-        case 0x1E: { uint32_t a = addr_absolute_x(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_asl8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_asl16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0x06: { uint32_t a = addr_direct(); m_cycles += 6; if (M8) write(a, op_asl8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_asl16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0x16: { uint32_t a = addr_direct_x(); m_cycles += 6; if (M8) write(a, op_asl8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_asl16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0x0E: { uint32_t a = addr_absolute(); m_cycles += 6; if (M8) write(a, op_asl8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_asl16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0x1E: { uint32_t a = addr_absolute_x(); m_cycles += 6; if (M8) write(a, op_asl8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_asl16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
 
         // BCC/BCS/BEQ/BMI/BNE/BPL/BVC/BVS - Branches
         case 0x90: branch(!get_flag(FLAG_C)); break;  // BCC
@@ -890,22 +1005,22 @@ void CPU::execute() {
 
         // BIT - Bit Test
         case 0x89:  // BIT #imm
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 op_bit_imm8(read(addr_immediate8()));
             } else {
                 uint32_t addr = addr_immediate16();
                 op_bit_imm16(read(addr) | (read(addr + 1) << 8));
             }
             break;
-        case 0x24: { uint32_t a = addr_direct(); if (get_flag(FLAG_M)) op_bit8(read(a)); else op_bit16(read(a)|(read(a+1)<<8)); break; }
-        case 0x34: { uint32_t a = addr_direct_x(); if (get_flag(FLAG_M)) op_bit8(read(a)); else op_bit16(read(a)|(read(a+1)<<8)); break; }
-        case 0x2C: { uint32_t a = addr_absolute(); if (get_flag(FLAG_M)) op_bit8(read(a)); else op_bit16(read(a)|(read(a+1)<<8)); break; }
-        case 0x3C: { uint32_t a = addr_absolute_x(); if (get_flag(FLAG_M)) op_bit8(read(a)); else op_bit16(read(a)|(read(a+1)<<8)); break; }
+        case 0x24: { uint32_t a = addr_direct(); if (M8) op_bit8(read(a)); else op_bit16(read(a)|(read(a+1)<<8)); break; }
+        case 0x34: { uint32_t a = addr_direct_x(); if (M8) op_bit8(read(a)); else op_bit16(read(a)|(read(a+1)<<8)); break; }
+        case 0x2C: { uint32_t a = addr_absolute(); if (M8) op_bit8(read(a)); else op_bit16(read(a)|(read(a+1)<<8)); break; }
+        case 0x3C: { uint32_t a = addr_absolute_x(); if (M8) op_bit8(read(a)); else op_bit16(read(a)|(read(a+1)<<8)); break; }
 
         // BRK - Break
         case 0x00:
             read_pc();  // Padding byte
-            do_interrupt(m_emulation ? VEC_IRQ_BRK_EMU : VEC_BRK_NATIVE, true);
+            do_interrupt(E ? VEC_IRQ_BRK_EMU : VEC_BRK_NATIVE, true);
             break;
 
         // CLC/CLD/CLI/CLV - Clear flags
@@ -916,76 +1031,76 @@ void CPU::execute() {
 
         // CMP - Compare Accumulator
         case 0xC9:
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 op_cmp8(m_a & 0xFF, read(addr_immediate8()));
             } else {
                 uint32_t addr = addr_immediate16();
                 op_cmp16(m_a, read(addr) | (read(addr + 1) << 8));
             }
             break;
-        case 0xC5: { uint32_t a = addr_direct(); if (get_flag(FLAG_M)) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
-        case 0xD5: { uint32_t a = addr_direct_x(); if (get_flag(FLAG_M)) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
-        case 0xCD: { uint32_t a = addr_absolute(); if (get_flag(FLAG_M)) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
-        case 0xDD: { uint32_t a = addr_absolute_x(); if (get_flag(FLAG_M)) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
-        case 0xD9: { uint32_t a = addr_absolute_y(); if (get_flag(FLAG_M)) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
-        case 0xCF: { uint32_t a = addr_absolute_long(); if (get_flag(FLAG_M)) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
-        case 0xDF: { uint32_t a = addr_absolute_long_x(); if (get_flag(FLAG_M)) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
-        case 0xD2: { uint32_t a = addr_direct_indirect(); if (get_flag(FLAG_M)) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
-        case 0xC7: { uint32_t a = addr_direct_indirect_long(); if (get_flag(FLAG_M)) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
-        case 0xC1: { uint32_t a = addr_direct_x_indirect(); if (get_flag(FLAG_M)) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
-        case 0xD1: { uint32_t a = addr_direct_indirect_y(); if (get_flag(FLAG_M)) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
-        case 0xD7: { uint32_t a = addr_direct_indirect_long_y(); if (get_flag(FLAG_M)) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
-        case 0xC3: { uint32_t a = addr_stack_relative(); if (get_flag(FLAG_M)) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
-        case 0xD3: { uint32_t a = addr_stack_relative_indirect_y(); if (get_flag(FLAG_M)) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
+        case 0xC5: { uint32_t a = addr_direct(); if (M8) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
+        case 0xD5: { uint32_t a = addr_direct_x(); if (M8) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
+        case 0xCD: { uint32_t a = addr_absolute(); if (M8) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
+        case 0xDD: { uint32_t a = addr_absolute_x(); if (M8) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
+        case 0xD9: { uint32_t a = addr_absolute_y(); if (M8) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
+        case 0xCF: { uint32_t a = addr_absolute_long(); if (M8) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
+        case 0xDF: { uint32_t a = addr_absolute_long_x(); if (M8) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
+        case 0xD2: { uint32_t a = addr_direct_indirect(); if (M8) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
+        case 0xC7: { uint32_t a = addr_direct_indirect_long(); if (M8) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
+        case 0xC1: { uint32_t a = addr_direct_x_indirect(); if (M8) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
+        case 0xD1: { uint32_t a = addr_direct_indirect_y(); if (M8) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
+        case 0xD7: { uint32_t a = addr_direct_indirect_long_y(); if (M8) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
+        case 0xC3: { uint32_t a = addr_stack_relative(); if (M8) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
+        case 0xD3: { uint32_t a = addr_stack_relative_indirect_y(); if (M8) op_cmp8(m_a&0xFF, read(a)); else op_cmp16(m_a, read(a)|(read(a+1)<<8)); break; }
 
         // COP - Coprocessor
         case 0x02:
             read_pc();  // Signature byte
-            do_interrupt(m_emulation ? VEC_COP_EMU : VEC_COP_NATIVE);
+            do_interrupt(E ? VEC_COP_EMU : VEC_COP_NATIVE);
             break;
 
         // CPX - Compare X
         case 0xE0:
-            if (get_flag(FLAG_X)) {
+            if (X8) {
                 op_cmp8(m_x & 0xFF, read(addr_immediate8()));
             } else {
                 uint32_t addr = addr_immediate16();
                 op_cmp16(m_x, read(addr) | (read(addr + 1) << 8));
             }
             break;
-        case 0xE4: { uint32_t a = addr_direct(); if (get_flag(FLAG_X)) op_cmp8(m_x&0xFF, read(a)); else op_cmp16(m_x, read(a)|(read(a+1)<<8)); break; }
-        case 0xEC: { uint32_t a = addr_absolute(); if (get_flag(FLAG_X)) op_cmp8(m_x&0xFF, read(a)); else op_cmp16(m_x, read(a)|(read(a+1)<<8)); break; }
+        case 0xE4: { uint32_t a = addr_direct(); if (X8) op_cmp8(m_x&0xFF, read(a)); else op_cmp16(m_x, read(a)|(read(a+1)<<8)); break; }
+        case 0xEC: { uint32_t a = addr_absolute(); if (X8) op_cmp8(m_x&0xFF, read(a)); else op_cmp16(m_x, read(a)|(read(a+1)<<8)); break; }
 
         // CPY - Compare Y
         case 0xC0:
-            if (get_flag(FLAG_X)) {
+            if (X8) {
                 op_cmp8(m_y & 0xFF, read(addr_immediate8()));
             } else {
                 uint32_t addr = addr_immediate16();
                 op_cmp16(m_y, read(addr) | (read(addr + 1) << 8));
             }
             break;
-        case 0xC4: { uint32_t a = addr_direct(); if (get_flag(FLAG_X)) op_cmp8(m_y&0xFF, read(a)); else op_cmp16(m_y, read(a)|(read(a+1)<<8)); break; }
-        case 0xCC: { uint32_t a = addr_absolute(); if (get_flag(FLAG_X)) op_cmp8(m_y&0xFF, read(a)); else op_cmp16(m_y, read(a)|(read(a+1)<<8)); break; }
+        case 0xC4: { uint32_t a = addr_direct(); if (X8) op_cmp8(m_y&0xFF, read(a)); else op_cmp16(m_y, read(a)|(read(a+1)<<8)); break; }
+        case 0xCC: { uint32_t a = addr_absolute(); if (X8) op_cmp8(m_y&0xFF, read(a)); else op_cmp16(m_y, read(a)|(read(a+1)<<8)); break; }
 
         // DEC - Decrement
         case 0x3A:  // DEC A
             m_cycles += 6;
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 m_a = (m_a & 0xFF00) | op_dec8(m_a & 0xFF);
             } else {
                 m_a = op_dec16(m_a);
             }
             break;
-        case 0xC6: { uint32_t a = addr_direct(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_dec8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_dec16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
-        case 0xD6: { uint32_t a = addr_direct_x(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_dec8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_dec16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
-        case 0xCE: { uint32_t a = addr_absolute(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_dec8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_dec16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
-        case 0xDE: { uint32_t a = addr_absolute_x(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_dec8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_dec16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0xC6: { uint32_t a = addr_direct(); m_cycles += 6; if (M8) write(a, op_dec8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_dec16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0xD6: { uint32_t a = addr_direct_x(); m_cycles += 6; if (M8) write(a, op_dec8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_dec16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0xCE: { uint32_t a = addr_absolute(); m_cycles += 6; if (M8) write(a, op_dec8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_dec16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0xDE: { uint32_t a = addr_absolute_x(); m_cycles += 6; if (M8) write(a, op_dec8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_dec16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
 
         // DEX/DEY - Decrement X/Y
         case 0xCA:
             m_cycles += 6;
-            if (get_flag(FLAG_X)) {
+            if (X8) {
                 m_x = (m_x & 0xFF00) | op_dec8(m_x & 0xFF);
             } else {
                 m_x = op_dec16(m_x);
@@ -993,7 +1108,7 @@ void CPU::execute() {
             break;
         case 0x88:
             m_cycles += 6;
-            if (get_flag(FLAG_X)) {
+            if (X8) {
                 m_y = (m_y & 0xFF00) | op_dec8(m_y & 0xFF);
             } else {
                 m_y = op_dec16(m_y);
@@ -1002,46 +1117,46 @@ void CPU::execute() {
 
         // EOR - Exclusive OR
         case 0x49:
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 op_eor8(read(addr_immediate8()));
             } else {
                 uint32_t addr = addr_immediate16();
                 op_eor16(read(addr) | (read(addr + 1) << 8));
             }
             break;
-        case 0x45: { uint32_t a = addr_direct(); if (get_flag(FLAG_M)) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
-        case 0x55: { uint32_t a = addr_direct_x(); if (get_flag(FLAG_M)) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
-        case 0x4D: { uint32_t a = addr_absolute(); if (get_flag(FLAG_M)) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
-        case 0x5D: { uint32_t a = addr_absolute_x(); if (get_flag(FLAG_M)) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
-        case 0x59: { uint32_t a = addr_absolute_y(); if (get_flag(FLAG_M)) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
-        case 0x4F: { uint32_t a = addr_absolute_long(); if (get_flag(FLAG_M)) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
-        case 0x5F: { uint32_t a = addr_absolute_long_x(); if (get_flag(FLAG_M)) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
-        case 0x52: { uint32_t a = addr_direct_indirect(); if (get_flag(FLAG_M)) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
-        case 0x47: { uint32_t a = addr_direct_indirect_long(); if (get_flag(FLAG_M)) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
-        case 0x41: { uint32_t a = addr_direct_x_indirect(); if (get_flag(FLAG_M)) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
-        case 0x51: { uint32_t a = addr_direct_indirect_y(); if (get_flag(FLAG_M)) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
-        case 0x57: { uint32_t a = addr_direct_indirect_long_y(); if (get_flag(FLAG_M)) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
-        case 0x43: { uint32_t a = addr_stack_relative(); if (get_flag(FLAG_M)) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
-        case 0x53: { uint32_t a = addr_stack_relative_indirect_y(); if (get_flag(FLAG_M)) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
+        case 0x45: { uint32_t a = addr_direct(); if (M8) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
+        case 0x55: { uint32_t a = addr_direct_x(); if (M8) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
+        case 0x4D: { uint32_t a = addr_absolute(); if (M8) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
+        case 0x5D: { uint32_t a = addr_absolute_x(); if (M8) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
+        case 0x59: { uint32_t a = addr_absolute_y(); if (M8) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
+        case 0x4F: { uint32_t a = addr_absolute_long(); if (M8) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
+        case 0x5F: { uint32_t a = addr_absolute_long_x(); if (M8) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
+        case 0x52: { uint32_t a = addr_direct_indirect(); if (M8) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
+        case 0x47: { uint32_t a = addr_direct_indirect_long(); if (M8) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
+        case 0x41: { uint32_t a = addr_direct_x_indirect(); if (M8) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
+        case 0x51: { uint32_t a = addr_direct_indirect_y(); if (M8) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
+        case 0x57: { uint32_t a = addr_direct_indirect_long_y(); if (M8) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
+        case 0x43: { uint32_t a = addr_stack_relative(); if (M8) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
+        case 0x53: { uint32_t a = addr_stack_relative_indirect_y(); if (M8) op_eor8(read(a)); else op_eor16(read(a)|(read(a+1)<<8)); break; }
 
         // INC - Increment
         case 0x1A:  // INC A
             m_cycles += 6;
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 m_a = (m_a & 0xFF00) | op_inc8(m_a & 0xFF);
             } else {
                 m_a = op_inc16(m_a);
             }
             break;
-        case 0xE6: { uint32_t a = addr_direct(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_inc8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_inc16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
-        case 0xF6: { uint32_t a = addr_direct_x(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_inc8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_inc16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
-        case 0xEE: { uint32_t a = addr_absolute(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_inc8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_inc16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
-        case 0xFE: { uint32_t a = addr_absolute_x(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_inc8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_inc16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0xE6: { uint32_t a = addr_direct(); m_cycles += 6; if (M8) write(a, op_inc8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_inc16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0xF6: { uint32_t a = addr_direct_x(); m_cycles += 6; if (M8) write(a, op_inc8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_inc16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0xEE: { uint32_t a = addr_absolute(); m_cycles += 6; if (M8) write(a, op_inc8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_inc16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0xFE: { uint32_t a = addr_absolute_x(); m_cycles += 6; if (M8) write(a, op_inc8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_inc16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
 
         // INX/INY - Increment X/Y
         case 0xE8:
             m_cycles += 6;
-            if (get_flag(FLAG_X)) {
+            if (X8) {
                 m_x = (m_x & 0xFF00) | op_inc8(m_x & 0xFF);
             } else {
                 m_x = op_inc16(m_x);
@@ -1049,7 +1164,7 @@ void CPU::execute() {
             break;
         case 0xC8:
             m_cycles += 6;
-            if (get_flag(FLAG_X)) {
+            if (X8) {
                 m_y = (m_y & 0xFF00) | op_inc8(m_y & 0xFF);
             } else {
                 m_y = op_inc16(m_y);
@@ -1107,7 +1222,7 @@ void CPU::execute() {
 
         // LDA - Load Accumulator
         case 0xA9:
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 m_a = (m_a & 0xFF00) | read(addr_immediate8());
                 update_nz8(m_a & 0xFF);
             } else {
@@ -1116,24 +1231,24 @@ void CPU::execute() {
                 update_nz16(m_a);
             }
             break;
-        case 0xA5: { uint32_t a = addr_direct(); if (get_flag(FLAG_M)) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
-        case 0xB5: { uint32_t a = addr_direct_x(); if (get_flag(FLAG_M)) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
-        case 0xAD: { uint32_t a = addr_absolute(); if (get_flag(FLAG_M)) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
-        case 0xBD: { uint32_t a = addr_absolute_x(); if (get_flag(FLAG_M)) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
-        case 0xB9: { uint32_t a = addr_absolute_y(); if (get_flag(FLAG_M)) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
-        case 0xAF: { uint32_t a = addr_absolute_long(); if (get_flag(FLAG_M)) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
-        case 0xBF: { uint32_t a = addr_absolute_long_x(); if (get_flag(FLAG_M)) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
-        case 0xB2: { uint32_t a = addr_direct_indirect(); if (get_flag(FLAG_M)) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
-        case 0xA7: { uint32_t a = addr_direct_indirect_long(); if (get_flag(FLAG_M)) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
-        case 0xA1: { uint32_t a = addr_direct_x_indirect(); if (get_flag(FLAG_M)) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
-        case 0xB1: { uint32_t a = addr_direct_indirect_y(); if (get_flag(FLAG_M)) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
-        case 0xB7: { uint32_t a = addr_direct_indirect_long_y(); if (get_flag(FLAG_M)) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
-        case 0xA3: { uint32_t a = addr_stack_relative(); if (get_flag(FLAG_M)) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
-        case 0xB3: { uint32_t a = addr_stack_relative_indirect_y(); if (get_flag(FLAG_M)) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
+        case 0xA5: { uint32_t a = addr_direct(); if (M8) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
+        case 0xB5: { uint32_t a = addr_direct_x(); if (M8) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
+        case 0xAD: { uint32_t a = addr_absolute(); if (M8) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
+        case 0xBD: { uint32_t a = addr_absolute_x(); if (M8) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
+        case 0xB9: { uint32_t a = addr_absolute_y(); if (M8) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
+        case 0xAF: { uint32_t a = addr_absolute_long(); if (M8) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
+        case 0xBF: { uint32_t a = addr_absolute_long_x(); if (M8) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
+        case 0xB2: { uint32_t a = addr_direct_indirect(); if (M8) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
+        case 0xA7: { uint32_t a = addr_direct_indirect_long(); if (M8) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
+        case 0xA1: { uint32_t a = addr_direct_x_indirect(); if (M8) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
+        case 0xB1: { uint32_t a = addr_direct_indirect_y(); if (M8) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
+        case 0xB7: { uint32_t a = addr_direct_indirect_long_y(); if (M8) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
+        case 0xA3: { uint32_t a = addr_stack_relative(); if (M8) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
+        case 0xB3: { uint32_t a = addr_stack_relative_indirect_y(); if (M8) { m_a = (m_a&0xFF00)|read(a); update_nz8(m_a&0xFF); } else { m_a = read(a)|(read(a+1)<<8); update_nz16(m_a); } break; }
 
         // LDX - Load X
         case 0xA2:
-            if (get_flag(FLAG_X)) {
+            if (X8) {
                 m_x = read(addr_immediate8());
                 update_nz8(m_x & 0xFF);
             } else {
@@ -1142,14 +1257,14 @@ void CPU::execute() {
                 update_nz16(m_x);
             }
             break;
-        case 0xA6: { uint32_t a = addr_direct(); if (get_flag(FLAG_X)) { m_x = read(a); update_nz8(m_x&0xFF); } else { m_x = read(a)|(read(a+1)<<8); update_nz16(m_x); } break; }
-        case 0xB6: { uint32_t a = addr_direct_y(); if (get_flag(FLAG_X)) { m_x = read(a); update_nz8(m_x&0xFF); } else { m_x = read(a)|(read(a+1)<<8); update_nz16(m_x); } break; }
-        case 0xAE: { uint32_t a = addr_absolute(); if (get_flag(FLAG_X)) { m_x = read(a); update_nz8(m_x&0xFF); } else { m_x = read(a)|(read(a+1)<<8); update_nz16(m_x); } break; }
-        case 0xBE: { uint32_t a = addr_absolute_y(); if (get_flag(FLAG_X)) { m_x = read(a); update_nz8(m_x&0xFF); } else { m_x = read(a)|(read(a+1)<<8); update_nz16(m_x); } break; }
+        case 0xA6: { uint32_t a = addr_direct(); if (X8) { m_x = read(a); update_nz8(m_x&0xFF); } else { m_x = read(a)|(read(a+1)<<8); update_nz16(m_x); } break; }
+        case 0xB6: { uint32_t a = addr_direct_y(); if (X8) { m_x = read(a); update_nz8(m_x&0xFF); } else { m_x = read(a)|(read(a+1)<<8); update_nz16(m_x); } break; }
+        case 0xAE: { uint32_t a = addr_absolute(); if (X8) { m_x = read(a); update_nz8(m_x&0xFF); } else { m_x = read(a)|(read(a+1)<<8); update_nz16(m_x); } break; }
+        case 0xBE: { uint32_t a = addr_absolute_y(); if (X8) { m_x = read(a); update_nz8(m_x&0xFF); } else { m_x = read(a)|(read(a+1)<<8); update_nz16(m_x); } break; }
 
         // LDY - Load Y
         case 0xA0:
-            if (get_flag(FLAG_X)) {
+            if (X8) {
                 m_y = read(addr_immediate8());
                 update_nz8(m_y & 0xFF);
             } else {
@@ -1158,24 +1273,24 @@ void CPU::execute() {
                 update_nz16(m_y);
             }
             break;
-        case 0xA4: { uint32_t a = addr_direct(); if (get_flag(FLAG_X)) { m_y = read(a); update_nz8(m_y&0xFF); } else { m_y = read(a)|(read(a+1)<<8); update_nz16(m_y); } break; }
-        case 0xB4: { uint32_t a = addr_direct_x(); if (get_flag(FLAG_X)) { m_y = read(a); update_nz8(m_y&0xFF); } else { m_y = read(a)|(read(a+1)<<8); update_nz16(m_y); } break; }
-        case 0xAC: { uint32_t a = addr_absolute(); if (get_flag(FLAG_X)) { m_y = read(a); update_nz8(m_y&0xFF); } else { m_y = read(a)|(read(a+1)<<8); update_nz16(m_y); } break; }
-        case 0xBC: { uint32_t a = addr_absolute_x(); if (get_flag(FLAG_X)) { m_y = read(a); update_nz8(m_y&0xFF); } else { m_y = read(a)|(read(a+1)<<8); update_nz16(m_y); } break; }
+        case 0xA4: { uint32_t a = addr_direct(); if (X8) { m_y = read(a); update_nz8(m_y&0xFF); } else { m_y = read(a)|(read(a+1)<<8); update_nz16(m_y); } break; }
+        case 0xB4: { uint32_t a = addr_direct_x(); if (X8) { m_y = read(a); update_nz8(m_y&0xFF); } else { m_y = read(a)|(read(a+1)<<8); update_nz16(m_y); } break; }
+        case 0xAC: { uint32_t a = addr_absolute(); if (X8) { m_y = read(a); update_nz8(m_y&0xFF); } else { m_y = read(a)|(read(a+1)<<8); update_nz16(m_y); } break; }
+        case 0xBC: { uint32_t a = addr_absolute_x(); if (X8) { m_y = read(a); update_nz8(m_y&0xFF); } else { m_y = read(a)|(read(a+1)<<8); update_nz16(m_y); } break; }
 
         // LSR - Logical Shift Right
         case 0x4A:  // LSR A
             m_cycles += 6;
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 m_a = (m_a & 0xFF00) | op_lsr8(m_a & 0xFF);
             } else {
                 m_a = op_lsr16(m_a);
             }
             break;
-        case 0x46: { uint32_t a = addr_direct(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_lsr8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_lsr16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
-        case 0x56: { uint32_t a = addr_direct_x(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_lsr8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_lsr16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
-        case 0x4E: { uint32_t a = addr_absolute(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_lsr8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_lsr16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
-        case 0x5E: { uint32_t a = addr_absolute_x(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_lsr8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_lsr16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0x46: { uint32_t a = addr_direct(); m_cycles += 6; if (M8) write(a, op_lsr8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_lsr16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0x56: { uint32_t a = addr_direct_x(); m_cycles += 6; if (M8) write(a, op_lsr8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_lsr16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0x4E: { uint32_t a = addr_absolute(); m_cycles += 6; if (M8) write(a, op_lsr8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_lsr16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0x5E: { uint32_t a = addr_absolute_x(); m_cycles += 6; if (M8) write(a, op_lsr8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_lsr16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
 
         // MVN/MVP - Block Move
         case 0x54: {  // MVN (Move Negative/Increment)
@@ -1187,7 +1302,7 @@ void CPU::execute() {
             write(dst, read(src));
             m_x++;
             m_y++;
-            if (get_flag(FLAG_X)) { m_x &= 0xFF; m_y &= 0xFF; }
+            if (X8) { m_x &= 0xFF; m_y &= 0xFF; }
             m_a--;
             if (m_a != 0xFFFF) m_pc -= 3;  // Repeat
             m_cycles += 6;
@@ -1202,7 +1317,7 @@ void CPU::execute() {
             write(dst, read(src));
             m_x--;
             m_y--;
-            if (get_flag(FLAG_X)) { m_x &= 0xFF; m_y &= 0xFF; }
+            if (X8) { m_x &= 0xFF; m_y &= 0xFF; }
             m_a--;
             if (m_a != 0xFFFF) m_pc -= 3;
             m_cycles += 6;
@@ -1216,27 +1331,27 @@ void CPU::execute() {
 
         // ORA - Logical OR
         case 0x09:
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 op_ora8(read(addr_immediate8()));
             } else {
                 uint32_t addr = addr_immediate16();
                 op_ora16(read(addr) | (read(addr + 1) << 8));
             }
             break;
-        case 0x05: { uint32_t a = addr_direct(); if (get_flag(FLAG_M)) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
-        case 0x15: { uint32_t a = addr_direct_x(); if (get_flag(FLAG_M)) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
-        case 0x0D: { uint32_t a = addr_absolute(); if (get_flag(FLAG_M)) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
-        case 0x1D: { uint32_t a = addr_absolute_x(); if (get_flag(FLAG_M)) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
-        case 0x19: { uint32_t a = addr_absolute_y(); if (get_flag(FLAG_M)) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
-        case 0x0F: { uint32_t a = addr_absolute_long(); if (get_flag(FLAG_M)) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
-        case 0x1F: { uint32_t a = addr_absolute_long_x(); if (get_flag(FLAG_M)) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
-        case 0x12: { uint32_t a = addr_direct_indirect(); if (get_flag(FLAG_M)) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
-        case 0x07: { uint32_t a = addr_direct_indirect_long(); if (get_flag(FLAG_M)) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
-        case 0x01: { uint32_t a = addr_direct_x_indirect(); if (get_flag(FLAG_M)) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
-        case 0x11: { uint32_t a = addr_direct_indirect_y(); if (get_flag(FLAG_M)) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
-        case 0x17: { uint32_t a = addr_direct_indirect_long_y(); if (get_flag(FLAG_M)) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
-        case 0x03: { uint32_t a = addr_stack_relative(); if (get_flag(FLAG_M)) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
-        case 0x13: { uint32_t a = addr_stack_relative_indirect_y(); if (get_flag(FLAG_M)) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
+        case 0x05: { uint32_t a = addr_direct(); if (M8) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
+        case 0x15: { uint32_t a = addr_direct_x(); if (M8) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
+        case 0x0D: { uint32_t a = addr_absolute(); if (M8) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
+        case 0x1D: { uint32_t a = addr_absolute_x(); if (M8) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
+        case 0x19: { uint32_t a = addr_absolute_y(); if (M8) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
+        case 0x0F: { uint32_t a = addr_absolute_long(); if (M8) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
+        case 0x1F: { uint32_t a = addr_absolute_long_x(); if (M8) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
+        case 0x12: { uint32_t a = addr_direct_indirect(); if (M8) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
+        case 0x07: { uint32_t a = addr_direct_indirect_long(); if (M8) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
+        case 0x01: { uint32_t a = addr_direct_x_indirect(); if (M8) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
+        case 0x11: { uint32_t a = addr_direct_indirect_y(); if (M8) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
+        case 0x17: { uint32_t a = addr_direct_indirect_long_y(); if (M8) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
+        case 0x03: { uint32_t a = addr_stack_relative(); if (M8) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
+        case 0x13: { uint32_t a = addr_stack_relative_indirect_y(); if (M8) op_ora8(read(a)); else op_ora16(read(a)|(read(a+1)<<8)); break; }
 
         // PEA/PEI/PER - Push Effective Address
         case 0xF4: {  // PEA abs
@@ -1258,7 +1373,7 @@ void CPU::execute() {
         // PHA/PHB/PHD/PHK/PHP/PHX/PHY - Push
         case 0x48:  // PHA
             m_cycles += 6;
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 push8(m_a & 0xFF);
             } else {
                 push16(m_a);
@@ -1270,7 +1385,7 @@ void CPU::execute() {
         case 0x08: m_cycles += 6; push8(m_status); break;  // PHP
         case 0xDA:  // PHX
             m_cycles += 6;
-            if (get_flag(FLAG_X)) {
+            if (X8) {
                 push8(m_x & 0xFF);
             } else {
                 push16(m_x);
@@ -1278,7 +1393,7 @@ void CPU::execute() {
             break;
         case 0x5A:  // PHY
             m_cycles += 6;
-            if (get_flag(FLAG_X)) {
+            if (X8) {
                 push8(m_y & 0xFF);
             } else {
                 push16(m_y);
@@ -1288,7 +1403,7 @@ void CPU::execute() {
         // PLA/PLB/PLD/PLP/PLX/PLY - Pull
         case 0x68:  // PLA
             m_cycles += 12;
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 m_a = (m_a & 0xFF00) | pop8();
                 update_nz8(m_a & 0xFF);
             } else {
@@ -1309,17 +1424,18 @@ void CPU::execute() {
         case 0x28:  // PLP
             m_cycles += 12;
             m_status = pop8();
-            if (m_emulation) {
+            if (E) {
                 m_status |= FLAG_M | FLAG_X;
             }
             if (get_flag(FLAG_X)) {
                 m_x &= 0xFF;
                 m_y &= 0xFF;
             }
+            update_execute();
             break;
         case 0xFA:  // PLX
             m_cycles += 12;
-            if (get_flag(FLAG_X)) {
+            if (X8) {
                 m_x = pop8();
                 update_nz8(m_x & 0xFF);
             } else {
@@ -1329,7 +1445,7 @@ void CPU::execute() {
             break;
         case 0x7A:  // PLY
             m_cycles += 12;
-            if (get_flag(FLAG_X)) {
+            if (X8) {
                 m_y = pop8();
                 update_nz8(m_y & 0xFF);
             } else {
@@ -1343,59 +1459,61 @@ void CPU::execute() {
             uint8_t mask = read_pc();
             m_cycles += 6;
             m_status &= ~mask;
-            if (m_emulation) {
+            if (E) {
                 m_status |= FLAG_M | FLAG_X;
             }
             if (get_flag(FLAG_X)) {
                 m_x &= 0xFF;
                 m_y &= 0xFF;
             }
+            update_execute();
             break;
         }
 
         // ROL - Rotate Left
         case 0x2A:  // ROL A
             m_cycles += 6;
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 m_a = (m_a & 0xFF00) | op_rol8(m_a & 0xFF);
             } else {
                 m_a = op_rol16(m_a);
             }
             break;
-        case 0x26: { uint32_t a = addr_direct(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_rol8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_rol16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
-        case 0x36: { uint32_t a = addr_direct_x(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_rol8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_rol16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
-        case 0x2E: { uint32_t a = addr_absolute(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_rol8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_rol16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
-        case 0x3E: { uint32_t a = addr_absolute_x(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_rol8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_rol16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0x26: { uint32_t a = addr_direct(); m_cycles += 6; if (M8) write(a, op_rol8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_rol16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0x36: { uint32_t a = addr_direct_x(); m_cycles += 6; if (M8) write(a, op_rol8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_rol16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0x2E: { uint32_t a = addr_absolute(); m_cycles += 6; if (M8) write(a, op_rol8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_rol16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0x3E: { uint32_t a = addr_absolute_x(); m_cycles += 6; if (M8) write(a, op_rol8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_rol16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
 
         // ROR - Rotate Right
         case 0x6A:  // ROR A
             m_cycles += 6;
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 m_a = (m_a & 0xFF00) | op_ror8(m_a & 0xFF);
             } else {
                 m_a = op_ror16(m_a);
             }
             break;
-        case 0x66: { uint32_t a = addr_direct(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_ror8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_ror16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
-        case 0x76: { uint32_t a = addr_direct_x(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_ror8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_ror16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
-        case 0x6E: { uint32_t a = addr_absolute(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_ror8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_ror16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
-        case 0x7E: { uint32_t a = addr_absolute_x(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_ror8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_ror16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0x66: { uint32_t a = addr_direct(); m_cycles += 6; if (M8) write(a, op_ror8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_ror16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0x76: { uint32_t a = addr_direct_x(); m_cycles += 6; if (M8) write(a, op_ror8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_ror16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0x6E: { uint32_t a = addr_absolute(); m_cycles += 6; if (M8) write(a, op_ror8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_ror16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0x7E: { uint32_t a = addr_absolute_x(); m_cycles += 6; if (M8) write(a, op_ror8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_ror16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
 
         // RTI - Return from Interrupt
         case 0x40:
             m_cycles += 12;
             m_status = pop8();
-            if (m_emulation) {
+            if (E) {
                 m_status |= FLAG_M | FLAG_X;
             }
             m_pc = pop16();
-            if (!m_emulation) {
+            if (!E) {
                 m_pbr = pop8();
             }
             if (get_flag(FLAG_X)) {
                 m_x &= 0xFF;
                 m_y &= 0xFF;
             }
+            update_execute();
             break;
 
         // RTL - Return from Subroutine Long
@@ -1413,27 +1531,27 @@ void CPU::execute() {
 
         // SBC - Subtract with Carry
         case 0xE9:
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 op_sbc8(read(addr_immediate8()));
             } else {
                 uint32_t addr = addr_immediate16();
                 op_sbc16(read(addr) | (read(addr + 1) << 8));
             }
             break;
-        case 0xE5: { uint32_t a = addr_direct(); if (get_flag(FLAG_M)) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
-        case 0xF5: { uint32_t a = addr_direct_x(); if (get_flag(FLAG_M)) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
-        case 0xED: { uint32_t a = addr_absolute(); if (get_flag(FLAG_M)) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
-        case 0xFD: { uint32_t a = addr_absolute_x(); if (get_flag(FLAG_M)) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
-        case 0xF9: { uint32_t a = addr_absolute_y(); if (get_flag(FLAG_M)) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
-        case 0xEF: { uint32_t a = addr_absolute_long(); if (get_flag(FLAG_M)) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
-        case 0xFF: { uint32_t a = addr_absolute_long_x(); if (get_flag(FLAG_M)) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
-        case 0xF2: { uint32_t a = addr_direct_indirect(); if (get_flag(FLAG_M)) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
-        case 0xE7: { uint32_t a = addr_direct_indirect_long(); if (get_flag(FLAG_M)) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
-        case 0xE1: { uint32_t a = addr_direct_x_indirect(); if (get_flag(FLAG_M)) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
-        case 0xF1: { uint32_t a = addr_direct_indirect_y(); if (get_flag(FLAG_M)) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
-        case 0xF7: { uint32_t a = addr_direct_indirect_long_y(); if (get_flag(FLAG_M)) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
-        case 0xE3: { uint32_t a = addr_stack_relative(); if (get_flag(FLAG_M)) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
-        case 0xF3: { uint32_t a = addr_stack_relative_indirect_y(); if (get_flag(FLAG_M)) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
+        case 0xE5: { uint32_t a = addr_direct(); if (M8) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
+        case 0xF5: { uint32_t a = addr_direct_x(); if (M8) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
+        case 0xED: { uint32_t a = addr_absolute(); if (M8) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
+        case 0xFD: { uint32_t a = addr_absolute_x(); if (M8) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
+        case 0xF9: { uint32_t a = addr_absolute_y(); if (M8) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
+        case 0xEF: { uint32_t a = addr_absolute_long(); if (M8) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
+        case 0xFF: { uint32_t a = addr_absolute_long_x(); if (M8) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
+        case 0xF2: { uint32_t a = addr_direct_indirect(); if (M8) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
+        case 0xE7: { uint32_t a = addr_direct_indirect_long(); if (M8) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
+        case 0xE1: { uint32_t a = addr_direct_x_indirect(); if (M8) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
+        case 0xF1: { uint32_t a = addr_direct_indirect_y(); if (M8) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
+        case 0xF7: { uint32_t a = addr_direct_indirect_long_y(); if (M8) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
+        case 0xE3: { uint32_t a = addr_stack_relative(); if (M8) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
+        case 0xF3: { uint32_t a = addr_stack_relative_indirect_y(); if (M8) op_sbc8(read(a)); else op_sbc16(read(a)|(read(a+1)<<8)); break; }
 
         // SEC/SED/SEI - Set flags
         case 0x38: m_cycles += 6; set_flag(FLAG_C, true); break;
@@ -1449,24 +1567,25 @@ void CPU::execute() {
                 m_x &= 0xFF;
                 m_y &= 0xFF;
             }
+            update_execute();
             break;
         }
 
         // STA - Store Accumulator
-        case 0x85: { uint32_t a = addr_direct(); if (get_flag(FLAG_M)) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
-        case 0x95: { uint32_t a = addr_direct_x(); if (get_flag(FLAG_M)) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
-        case 0x8D: { uint32_t a = addr_absolute(); if (get_flag(FLAG_M)) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
-        case 0x9D: { uint32_t a = addr_absolute_x(); if (get_flag(FLAG_M)) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
-        case 0x99: { uint32_t a = addr_absolute_y(); if (get_flag(FLAG_M)) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
-        case 0x8F: { uint32_t a = addr_absolute_long(); if (get_flag(FLAG_M)) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
-        case 0x9F: { uint32_t a = addr_absolute_long_x(); if (get_flag(FLAG_M)) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
-        case 0x92: { uint32_t a = addr_direct_indirect(); if (get_flag(FLAG_M)) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
-        case 0x87: { uint32_t a = addr_direct_indirect_long(); if (get_flag(FLAG_M)) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
-        case 0x81: { uint32_t a = addr_direct_x_indirect(); if (get_flag(FLAG_M)) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
-        case 0x91: { uint32_t a = addr_direct_indirect_y(); if (get_flag(FLAG_M)) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
-        case 0x97: { uint32_t a = addr_direct_indirect_long_y(); if (get_flag(FLAG_M)) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
-        case 0x83: { uint32_t a = addr_stack_relative(); if (get_flag(FLAG_M)) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
-        case 0x93: { uint32_t a = addr_stack_relative_indirect_y(); if (get_flag(FLAG_M)) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
+        case 0x85: { uint32_t a = addr_direct(); if (M8) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
+        case 0x95: { uint32_t a = addr_direct_x(); if (M8) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
+        case 0x8D: { uint32_t a = addr_absolute(); if (M8) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
+        case 0x9D: { uint32_t a = addr_absolute_x(); if (M8) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
+        case 0x99: { uint32_t a = addr_absolute_y(); if (M8) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
+        case 0x8F: { uint32_t a = addr_absolute_long(); if (M8) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
+        case 0x9F: { uint32_t a = addr_absolute_long_x(); if (M8) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
+        case 0x92: { uint32_t a = addr_direct_indirect(); if (M8) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
+        case 0x87: { uint32_t a = addr_direct_indirect_long(); if (M8) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
+        case 0x81: { uint32_t a = addr_direct_x_indirect(); if (M8) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
+        case 0x91: { uint32_t a = addr_direct_indirect_y(); if (M8) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
+        case 0x97: { uint32_t a = addr_direct_indirect_long_y(); if (M8) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
+        case 0x83: { uint32_t a = addr_stack_relative(); if (M8) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
+        case 0x93: { uint32_t a = addr_stack_relative_indirect_y(); if (M8) write(a, m_a&0xFF); else { write(a, m_a&0xFF); write(a+1, m_a>>8); } break; }
 
         // STP - Stop Processor
         case 0xDB:
@@ -1475,25 +1594,25 @@ void CPU::execute() {
             break;
 
         // STX - Store X
-        case 0x86: { uint32_t a = addr_direct(); if (get_flag(FLAG_X)) write(a, m_x&0xFF); else { write(a, m_x&0xFF); write(a+1, m_x>>8); } break; }
-        case 0x96: { uint32_t a = addr_direct_y(); if (get_flag(FLAG_X)) write(a, m_x&0xFF); else { write(a, m_x&0xFF); write(a+1, m_x>>8); } break; }
-        case 0x8E: { uint32_t a = addr_absolute(); if (get_flag(FLAG_X)) write(a, m_x&0xFF); else { write(a, m_x&0xFF); write(a+1, m_x>>8); } break; }
+        case 0x86: { uint32_t a = addr_direct(); if (X8) write(a, m_x&0xFF); else { write(a, m_x&0xFF); write(a+1, m_x>>8); } break; }
+        case 0x96: { uint32_t a = addr_direct_y(); if (X8) write(a, m_x&0xFF); else { write(a, m_x&0xFF); write(a+1, m_x>>8); } break; }
+        case 0x8E: { uint32_t a = addr_absolute(); if (X8) write(a, m_x&0xFF); else { write(a, m_x&0xFF); write(a+1, m_x>>8); } break; }
 
         // STY - Store Y
-        case 0x84: { uint32_t a = addr_direct(); if (get_flag(FLAG_X)) write(a, m_y&0xFF); else { write(a, m_y&0xFF); write(a+1, m_y>>8); } break; }
-        case 0x94: { uint32_t a = addr_direct_x(); if (get_flag(FLAG_X)) write(a, m_y&0xFF); else { write(a, m_y&0xFF); write(a+1, m_y>>8); } break; }
-        case 0x8C: { uint32_t a = addr_absolute(); if (get_flag(FLAG_X)) write(a, m_y&0xFF); else { write(a, m_y&0xFF); write(a+1, m_y>>8); } break; }
+        case 0x84: { uint32_t a = addr_direct(); if (X8) write(a, m_y&0xFF); else { write(a, m_y&0xFF); write(a+1, m_y>>8); } break; }
+        case 0x94: { uint32_t a = addr_direct_x(); if (X8) write(a, m_y&0xFF); else { write(a, m_y&0xFF); write(a+1, m_y>>8); } break; }
+        case 0x8C: { uint32_t a = addr_absolute(); if (X8) write(a, m_y&0xFF); else { write(a, m_y&0xFF); write(a+1, m_y>>8); } break; }
 
         // STZ - Store Zero
-        case 0x64: { uint32_t a = addr_direct(); if (get_flag(FLAG_M)) write(a, 0); else { write(a, 0); write(a+1, 0); } break; }
-        case 0x74: { uint32_t a = addr_direct_x(); if (get_flag(FLAG_M)) write(a, 0); else { write(a, 0); write(a+1, 0); } break; }
-        case 0x9C: { uint32_t a = addr_absolute(); if (get_flag(FLAG_M)) write(a, 0); else { write(a, 0); write(a+1, 0); } break; }
-        case 0x9E: { uint32_t a = addr_absolute_x(); if (get_flag(FLAG_M)) write(a, 0); else { write(a, 0); write(a+1, 0); } break; }
+        case 0x64: { uint32_t a = addr_direct(); if (M8) write(a, 0); else { write(a, 0); write(a+1, 0); } break; }
+        case 0x74: { uint32_t a = addr_direct_x(); if (M8) write(a, 0); else { write(a, 0); write(a+1, 0); } break; }
+        case 0x9C: { uint32_t a = addr_absolute(); if (M8) write(a, 0); else { write(a, 0); write(a+1, 0); } break; }
+        case 0x9E: { uint32_t a = addr_absolute_x(); if (M8) write(a, 0); else { write(a, 0); write(a+1, 0); } break; }
 
         // TAX/TAY/TCD/TCS/TDC/TSC/TSX/TXA/TXS/TXY/TYA/TYX - Transfers
         case 0xAA:  // TAX
             m_cycles += 6;
-            if (get_flag(FLAG_X)) {
+            if (X8) {
                 m_x = m_a & 0xFF;
                 update_nz8(m_x & 0xFF);
             } else {
@@ -1503,7 +1622,7 @@ void CPU::execute() {
             break;
         case 0xA8:  // TAY
             m_cycles += 6;
-            if (get_flag(FLAG_X)) {
+            if (X8) {
                 m_y = m_a & 0xFF;
                 update_nz8(m_y & 0xFF);
             } else {
@@ -1519,7 +1638,7 @@ void CPU::execute() {
         case 0x1B:  // TCS
             m_cycles += 6;
             m_sp = m_a;
-            if (m_emulation) m_sp = 0x0100 | (m_sp & 0xFF);
+            if (E) m_sp = 0x0100 | (m_sp & 0xFF);
             break;
         case 0x7B:  // TDC
             m_cycles += 6;
@@ -1533,7 +1652,7 @@ void CPU::execute() {
             break;
         case 0xBA:  // TSX
             m_cycles += 6;
-            if (get_flag(FLAG_X)) {
+            if (X8) {
                 m_x = m_sp & 0xFF;
                 update_nz8(m_x & 0xFF);
             } else {
@@ -1543,7 +1662,7 @@ void CPU::execute() {
             break;
         case 0x8A:  // TXA
             m_cycles += 6;
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 m_a = (m_a & 0xFF00) | (m_x & 0xFF);
                 update_nz8(m_a & 0xFF);
             } else {
@@ -1554,12 +1673,12 @@ void CPU::execute() {
         case 0x9A:  // TXS
             m_cycles += 6;
             m_sp = m_x;
-            if (m_emulation) m_sp = 0x0100 | (m_sp & 0xFF);
+            if (E) m_sp = 0x0100 | (m_sp & 0xFF);
             break;
         case 0x9B:  // TXY
             m_cycles += 6;
             m_y = m_x;
-            if (get_flag(FLAG_X)) {
+            if (X8) {
                 update_nz8(m_y & 0xFF);
             } else {
                 update_nz16(m_y);
@@ -1567,7 +1686,7 @@ void CPU::execute() {
             break;
         case 0x98:  // TYA
             m_cycles += 6;
-            if (get_flag(FLAG_M)) {
+            if (M8) {
                 m_a = (m_a & 0xFF00) | (m_y & 0xFF);
                 update_nz8(m_a & 0xFF);
             } else {
@@ -1578,7 +1697,7 @@ void CPU::execute() {
         case 0xBB:  // TYX
             m_cycles += 6;
             m_x = m_y;
-            if (get_flag(FLAG_X)) {
+            if (X8) {
                 update_nz8(m_x & 0xFF);
             } else {
                 update_nz16(m_x);
@@ -1586,12 +1705,12 @@ void CPU::execute() {
             break;
 
         // TRB - Test and Reset Bits
-        case 0x14: { uint32_t a = addr_direct(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_trb8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_trb16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
-        case 0x1C: { uint32_t a = addr_absolute(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_trb8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_trb16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0x14: { uint32_t a = addr_direct(); m_cycles += 6; if (M8) write(a, op_trb8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_trb16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0x1C: { uint32_t a = addr_absolute(); m_cycles += 6; if (M8) write(a, op_trb8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_trb16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
 
         // TSB - Test and Set Bits
-        case 0x04: { uint32_t a = addr_direct(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_tsb8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_tsb16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
-        case 0x0C: { uint32_t a = addr_absolute(); m_cycles += 6; if (get_flag(FLAG_M)) write(a, op_tsb8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_tsb16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0x04: { uint32_t a = addr_direct(); m_cycles += 6; if (M8) write(a, op_tsb8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_tsb16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
+        case 0x0C: { uint32_t a = addr_absolute(); m_cycles += 6; if (M8) write(a, op_tsb8(read(a))); else { uint16_t v = read(a)|(read(a+1)<<8); v = op_tsb16(v); write(a, v&0xFF); write(a+1, v>>8); } break; }
 
         // WAI - Wait for Interrupt
         case 0xCB:
@@ -1624,6 +1743,7 @@ void CPU::execute() {
                 m_y &= 0xFF;
                 m_sp = 0x0100 | (m_sp & 0xFF);
             }
+            update_execute();
             break;
         }
 
@@ -1634,7 +1754,23 @@ void CPU::execute() {
     }
 }
 
-void CPU::save_state(std::vector<uint8_t>& data) {
+void CPU::update_execute() {
+    static constexpr ExecuteFn HANDLERS[5] = {
+        &CPU::execute_op<false, false, false>,
+        &CPU::execute_op<false, false, true>,
+        &CPU::execute_op<false, true, false>,
+        &CPU::execute_op<false, true, true>,
+        &CPU::execute_op<true, true, true>,
+    };
+
+    int index = 4;
+    if (!m_emulation) {
+        index = (get_flag(FLAG_M) ? 2 : 0) | (get_flag(FLAG_X) ? 1 : 0);
+    }
+    m_execute = HANDLERS[index];
+}
+
+void CPU::save_state(StateWriter& data) {
     auto write16 = [&](uint16_t v) { data.push_back(v & 0xFF); data.push_back(v >> 8); };
     auto write8 = [&](uint8_t v) { data.push_back(v); };
 
@@ -1680,6 +1816,8 @@ void CPU::load_state(const uint8_t*& data, size_t& remaining) {
     m_irq_line = read8() != 0;
     m_wai_waiting = read8() != 0;
     m_stp_stopped = read8() != 0;
+    m_poll_loop = {};
+    update_execute();
 }
 
 } // namespace snes
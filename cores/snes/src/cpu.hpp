@@ -3,9 +3,14 @@
 #include <cstdint>
 #include <vector>
 
+#include "emu/breakpoints.hpp"
+#include "emu/cpu_trace.hpp"
+#include "emu/state_writer.hpp"
+
 namespace snes {
 
 class Bus;
+using emu::StateWriter;
 
 // Ricoh 5A22 CPU (65816 core) - 16-bit processor with 8-bit compatibility
 // Reference: 65816 Programming Manual, anomie's SNES docs
@@ -21,13 +26,30 @@ public:
     // Master clock is 21.477 MHz, CPU runs at 3.58 MHz (6 master cycles per CPU cycle)
     int step();
 
+    // True while WAI or STP holds the CPU with nothing pending to release
+    // it, when step() does no more than take 6 cycles
+    bool is_idle() const;
+
+    // A loop that only polls RDNMI ($4210) or HVBJOY ($4212) and branches
+    // back on the bits in 'bits'
+    struct PollLoop {
+        uint32_t address = 0;   // Register, as the loop reads it
+        uint8_t bits = 0;
+        int cycles = 0;         // Per pass
+    };
+
+    // The poll loop the last step() closed a pass of, if the CPU is at its
+    // head with no interrupt about to be taken; false otherwise. Passes
+    // that read what the last one did can be run as bare cycles.
+    bool take_poll_loop(PollLoop& loop);
+
     // Interrupts
     void trigger_nmi();
     void trigger_irq();
     void set_irq_line(bool active);
 
     // Save state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
 
     // Register access (for debugging)
@@ -46,6 +68,22 @@ public:
     // Get full 24-bit address
     uint32_t get_full_pc() const { return (static_cast<uint32_t>(m_pbr) << 16) | m_pc; }
 
+    // Record every instruction into trace while set (see emu/cpu_trace.hpp)
+    void set_trace(emu::CpuTrace* trace) { m_trace = trace; }
+
+    // Execute breakpoints checked at each instruction, or nullptr for none
+    void set_breakpoints(emu::Breakpoints* breakpoints) { m_breakpoints = breakpoints; }
+
+    // Called before each access to a PPU port ($2100-$213F) or CPU I/O
+    // register ($4200-$421F) with the cycles the instruction has taken up to
+    // and including it, so the host can bring the PPU, H counter and IRQ
+    // state up to the access. Without one they only move between instructions.
+    using AccessSync = void (*)(void* context, int cycles);
+    void set_access_sync(AccessSync sync, void* context) {
+        m_access_sync = sync;
+        m_access_sync_context = context;
+    }
+
 private:
     // Memory access (adds appropriate cycles)
     uint8_t read(uint32_t address);
@@ -71,8 +109,8 @@ private:
     // Addressing modes - return effective address
     uint32_t addr_immediate8();
     uint32_t addr_immediate16();
-    uint32_t addr_immediate_m();  // 8 or 16 bit depending on M flag
-    uint32_t addr_immediate_x();  // 8 or 16 bit depending on X flag
+    template <bool M8> uint32_t addr_immediate_m();  // 8 or 16 bit depending on M flag
+    template <bool X8> uint32_t addr_immediate_x();  // 8 or 16 bit depending on X flag
     uint32_t addr_direct();
     uint32_t addr_direct_x();
     uint32_t addr_direct_y();
@@ -97,7 +135,7 @@ private:
     bool get_flag(uint8_t flag) const;
     void update_nz8(uint8_t value);
     void update_nz16(uint16_t value);
-    void update_nz_m(uint16_t value);  // Uses M flag to determine width
+    template <bool M8> void update_nz_m(uint16_t value);  // Uses M flag to determine width
 
     // ALU operations
     void op_adc8(uint8_t value);
@@ -142,12 +180,26 @@ private:
     // Branch helper
     void branch(bool condition);
 
+    // Called by a branch taken back over 'length' bytes; notes the loop in
+    // m_poll_loop if it's one take_poll_loop() reports
+    void detect_poll_loop(int length);
+
     // Interrupt handling
     void do_interrupt(uint16_t vector, bool is_brk = false);
 
     // Execute single instruction
     void execute();
 
+    // Instruction handlers specialized per E/M/X combination. m_execute
+    // points at the set matching the current flags and is refreshed by
+    // update_execute() whenever REP, SEP, PLP, RTI, XCE, reset or a state
+    // load changes them.
+    template <bool E, bool M8, bool X8> void execute_op(uint8_t opcode);
+    void update_execute();
+
+    using ExecuteFn = void (CPU::*)(uint8_t);
+    ExecuteFn m_execute = nullptr;
+
     // Bus reference
     Bus& m_bus;
 
@@ -172,6 +224,10 @@ private:
     // Cycle counter for current instruction
     int m_cycles = 0;
 
+    // Set by detect_poll_loop() with the loop's head
+    PollLoop m_poll_loop;
+    uint32_t m_poll_loop_head = 0;
+
     // Status register flags
     static constexpr uint8_t FLAG_C = 0x01;  // Carry
     static constexpr uint8_t FLAG_Z = 0x02;  // Zero
@@ -196,6 +252,17 @@ private:
     static constexpr uint16_t VEC_NMI_EMU       = 0xFFFA;
     static constexpr uint16_t VEC_RESET         = 0xFFFC;
     static constexpr uint16_t VEC_IRQ_BRK_EMU   = 0xFFFE;
+
+    emu::CpuTrace* m_trace = nullptr;
+    void trace_instruction(uint16_t pc, uint8_t opcode);
+    emu::Breakpoints* m_breakpoints = nullptr;
+    AccessSync m_access_sync = nullptr;
+    void* m_access_sync_context = nullptr;
+
+    // Debug output limits (DEBUG=1)
+    int m_debug_nmi_count = 0;
+    int m_debug_trace_count = 0;
+    uint16_t m_debug_last_pc = 0xFFFF;
 };
 
 } // namespace snes
@@ -7,17 +7,20 @@
 
 namespace snes {
 
-// Single debug mode check - caches result of DEBUG environment variable
+// Single debug mode check - caches result of DEBUG environment variable.
+// Release builds without VELOCE_CORE_DEBUG_LOG make it a constant, which
+// drops the debug logging from the hot paths altogether.
+#ifdef VELOCE_NO_CORE_DEBUG
+constexpr bool is_debug_mode() { return false; }
+#else
 inline bool is_debug_mode() {
-    static bool checked = false;
-    static bool debug = false;
-    if (!checked) {
+    static const bool debug = [] {
         const char* env = std::getenv("DEBUG");
-        debug = (env != nullptr && env[0] != '0');
-        checked = true;
-    }
+        return env != nullptr && env[0] != '0';
+    }();
     return debug;
 }
+#endif
 
 // Blargg test result detection
 // Blargg's tests write results to specific memory addresses:
@@ -2,6 +2,8 @@
 #include "bus.hpp"
 #include "ppu.hpp"
 #include "debug.hpp"
+#include "emu/state_writer.hpp"
+#include <algorithm>
 #include <cstring>
 
 namespace snes {
@@ -61,14 +63,13 @@ void DMA::write(uint16_t address, uint8_t value) {
     auto& ch = m_channels[channel];
 
     // Debug: trace DMA register writes for channel 0 when setting up VRAM transfers
-    static int dma_write_trace = 0;
-    bool trace_this = is_debug_mode() && channel == 0 && dma_write_trace < 100;
+    bool trace_this = is_debug_mode() && channel == 0 && m_debug_write_trace < 100;
     if (trace_this) {
         static const char* reg_names[] = {"DMAP", "BBAD", "A1TL", "A1TH", "A1B", "DASL", "DASH", "DASB", "A2AL", "A2AH", "NLTR"};
         if (reg <= 0x0A) {
             SNES_DEBUG_PRINT("DMA ch0 write $%04X (%s) = $%02X\n", 0x4300 + address, reg_names[reg], value);
         }
-        dma_write_trace++;
+        m_debug_write_trace++;
     }
 
     switch (reg) {
@@ -217,33 +218,57 @@ void DMA::do_dma_transfer(int channel) {
     int size = transfer_size[transfer_mode];
     int transferred = 0;
 
-    while (transferred < count) {
-        for (int i = 0; i < size && transferred < count; i++) {
-            uint8_t b = b_addr + b_offset[transfer_mode][i];
-            uint16_t b_full = 0x2100 + b;
-
-            if (direction) {
-                // B -> A
-                uint8_t value = m_bus.read(b_full);
-                m_bus.write(a_addr, value);
-            } else {
-                // A -> B
-                uint8_t value = m_bus.read(a_addr);
-                m_bus.write(b_full, value);
-            }
+    // Burst path: A->B transfers from WRAM/ROM into the VRAM, CGRAM and OAM
+    // data ports resolve both ends once and hand whole runs to the PPU.
+    // The debug traces hook the per-byte path, so it is kept in debug mode.
+    uint8_t ports[4];
+    bool burst = !direction && !(decrement && !fixed) && !is_debug_mode();
+    for (int i = 0; i < size; i++) {
+        ports[i] = b_addr + b_offset[transfer_mode][i];
+        burst = burst && PPU::is_burst_port(ports[i]);
+    }
 
-            // Update A-bus address
-            if (!fixed) {
-                if (decrement) {
-                    a_addr = ((a_addr & 0xFF0000) | ((a_addr - 1) & 0xFFFF));
-                } else {
-                    a_addr = ((a_addr & 0xFF0000) | ((a_addr + 1) & 0xFFFF));
+    while (transferred < count) {
+        if (burst) {
+            int run = 0;
+            const uint8_t* src = m_bus.get_dma_source(a_addr, run);
+            if (src) {
+                int n = fixed ? count - transferred : std::min(run, count - transferred);
+                m_bus.ppu().write_dma_burst(ports, size, transferred % size, src, fixed ? 0 : 1, n);
+                m_bus.set_open_bus(src[fixed ? 0 : n - 1]);
+                if (!fixed) {
+                    a_addr = ((a_addr & 0xFF0000) | ((a_addr + n) & 0xFFFF));
                 }
+                transferred += n;
+                m_dma_cycles += 8 * n;  // Each byte takes 8 master cycles
+                continue;
             }
+        }
+
+        uint8_t b = b_addr + b_offset[transfer_mode][transferred % size];
+        uint16_t b_full = 0x2100 + b;
 
-            transferred++;
-            m_dma_cycles += 8;  // Each byte takes 8 master cycles
+        if (direction) {
+            // B -> A
+            uint8_t value = m_bus.read(b_full);
+            m_bus.write(a_addr, value);
+        } else {
+            // A -> B
+            uint8_t value = m_bus.read(a_addr);
+            m_bus.write(b_full, value);
         }
+
+        // Update A-bus address
+        if (!fixed) {
+            if (decrement) {
+                a_addr = ((a_addr & 0xFF0000) | ((a_addr - 1) & 0xFFFF));
+            } else {
+                a_addr = ((a_addr & 0xFF0000) | ((a_addr + 1) & 0xFFFF));
+            }
+        }
+
+        transferred++;
+        m_dma_cycles += 8;  // Each byte takes 8 master cycles
     }
 
     // Update channel registers
@@ -388,7 +413,7 @@ uint8_t DMA::hdma_read_table(int channel) {
     return value;
 }
 
-void DMA::save_state(std::vector<uint8_t>& data) {
+void DMA::save_state(StateWriter& data) {
     data.push_back(m_hdmaen);
 
     for (const auto& ch : m_channels) {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "emu/state_writer.hpp"
+
 #include <cstdint>
 #include <array>
 #include <vector>
@@ -7,6 +9,7 @@
 namespace snes {
 
 class Bus;
+using emu::StateWriter;
 
 // SNES DMA and HDMA Controller
 // 8 DMA channels, each can do general purpose DMA or HDMA
@@ -35,7 +38,7 @@ public:
     void clear_dma_cycles() { m_dma_cycles = 0; }
 
     // Save state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
 
 private:
@@ -69,6 +72,9 @@ private:
 
     // HDMA state
     uint8_t m_hdmaen = 0;  // HDMA enable bits
+
+    // Debug output limits (DEBUG=1)
+    int m_debug_write_trace = 0;
 };
 
 } // namespace snes
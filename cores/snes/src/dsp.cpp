@@ -1,6 +1,7 @@
 #include "dsp.hpp"
 #include "spc700.hpp"
 #include "debug.hpp"
+#include "emu/state_writer.hpp"
 #include <cstring>
 #include <algorithm>
 
@@ -58,6 +59,17 @@ const int16_t DSP::GAUSS_TABLE[512] = {
     1299, 1300, 1300, 1301, 1302, 1302, 1303, 1303, 1303, 1304, 1304, 1304, 1304, 1304, 1305, 1305
 };
 
+// GAUSS_TABLE rearranged per fractional position so the four weights for
+// taps s0..s3 sit next to each other
+const std::array<std::array<int16_t, 4>, 256> DSP::GAUSS_TAPS = [] {
+    std::array<std::array<int16_t, 4>, 256> taps{};
+    for (int frac = 0; frac < 256; frac++) {
+        taps[frac] = {GAUSS_TABLE[255 - frac], GAUSS_TABLE[511 - frac],
+                      GAUSS_TABLE[256 + frac], GAUSS_TABLE[frac]};
+    }
+    return taps;
+}();
+
 DSP::DSP() {
     reset();
 }
@@ -93,6 +105,10 @@ void DSP::reset() {
         voice.brr_buffer.fill(0);
     }
 
+    for (auto& entry : m_brr_cache) {
+        entry.valid = false;
+    }
+
     m_output_left = 0;
     m_output_right = 0;
 
@@ -245,6 +261,10 @@ void DSP::step() {
 
     int16_t prev_outx = 0;
 
+    // With audio disabled the voice outputs are only needed where emulation
+    // can see them: pitch modulation and echo writes into ARAM
+    bool render = m_audio_enabled || pmon != 0 || !(m_regs[REG_FLG] & 0x20);
+
     for (int v = 0; v < 8; v++) {
         auto& voice = m_voices[v];
 
@@ -322,9 +342,18 @@ void DSP::step() {
                 decode_brr_block(v);
             }
 
-            // Store sample in ring buffer
-            voice.samples[voice.sample_index] = voice.brr_buffer[voice.brr_offset];
-            voice.sample_index = (voice.sample_index + 1) % 12;
+            // Store sample in ring buffer (and its mirror)
+            int16_t decoded = voice.brr_buffer[voice.brr_offset];
+            voice.samples[voice.sample_index] = decoded;
+            voice.samples[voice.sample_index + 12] = decoded;
+            if (++voice.sample_index == 12) voice.sample_index = 0;
+        }
+
+        if (!render) {
+            // Skip interpolation and mixing; the envelope (ENVX) stays exact
+            // and OUTX holds its last value
+            process_envelope(v);
+            continue;
         }
 
         // Interpolate sample
@@ -362,6 +391,13 @@ void DSP::step() {
         }
     }
 
+    if (!render) {
+        m_output_left = 0;
+        m_output_right = 0;
+        m_sample_counter++;
+        return;
+    }
+
     // Process echo
     if (!(m_regs[REG_FLG] & 0x20)) {  // Echo not disabled
         process_echo();
@@ -432,22 +468,39 @@ void DSP::decode_brr_block(int v) {
     const uint8_t* ram = m_spc->get_ram();
     auto& voice = m_voices[v];
 
+    // BRR block layout: 1 header byte + 8 data bytes = 9 bytes total
+    uint8_t raw[9];
+    for (int i = 0; i < 9; i++) {
+        raw[i] = ram[(voice.brr_addr + i) & 0xFFFF];
+    }
+
     // Read BRR header
-    uint8_t header = ram[voice.brr_addr];
+    uint8_t header = raw[0];
     int shift = header >> 4;
     int filter = (header >> 2) & 0x03;
     voice.brr_loop = (header & 0x02) != 0;
     voice.brr_end = (header & 0x01) != 0;
 
     // Get previous samples for filter
-    int prev1 = voice.samples[(voice.sample_index + 11) % 12];
-    int prev2 = voice.samples[(voice.sample_index + 10) % 12];
+    int prev1 = voice.samples[voice.sample_index + 11];
+    int prev2 = voice.samples[voice.sample_index + 10];
+
+    // Looping samples decode the same blocks over and over
+    auto& entry = m_brr_cache[voice.brr_addr & (BRR_CACHE_SIZE - 1)];
+    if (entry.valid && std::memcmp(entry.raw, raw, sizeof(raw)) == 0 &&
+        (filter == 0 || (entry.prev1 == prev1 && entry.prev2 == prev2))) {
+        voice.brr_buffer = entry.samples;
+        return;
+    }
+    entry.valid = true;
+    std::memcpy(entry.raw, raw, sizeof(raw));
+    entry.prev1 = prev1;
+    entry.prev2 = prev2;
 
     // Decode 16 samples from 8 data bytes (2 nibbles per byte)
-    // BRR block layout: 1 header byte + 8 data bytes = 9 bytes total
     int sample_idx = 0;
     for (int i = 0; i < 8; i++) {
-        uint8_t byte = ram[(voice.brr_addr + 1 + i) & 0xFFFF];
+        uint8_t byte = raw[1 + i];
 
         // Each byte has 2 nibbles (high nibble first)
         for (int j = 0; j < 2; j++) {
@@ -492,6 +545,8 @@ void DSP::decode_brr_block(int v) {
             prev1 = sample;
         }
     }
+
+    entry.samples = voice.brr_buffer;
 }
 
 int16_t DSP::interpolate(int v) {
@@ -500,18 +555,15 @@ int16_t DSP::interpolate(int v) {
     // Get fractional position
     int frac = (voice.pitch_counter >> 4) & 0xFF;
 
-    // Get 4 samples for interpolation
-    int idx = voice.sample_index;
-    int16_t s0 = voice.samples[(idx + 8) % 12];
-    int16_t s1 = voice.samples[(idx + 9) % 12];
-    int16_t s2 = voice.samples[(idx + 10) % 12];
-    int16_t s3 = voice.samples[(idx + 11) % 12];
+    // Get 4 samples for interpolation (oldest first)
+    const int16_t* s = &voice.samples[voice.sample_index + 8];
+    const auto& g = GAUSS_TAPS[frac];
 
     // Gaussian interpolation
-    int32_t out = (GAUSS_TABLE[255 - frac] * s0) >> 11;
-    out += (GAUSS_TABLE[511 - frac] * s1) >> 11;
-    out += (GAUSS_TABLE[256 + frac] * s2) >> 11;
-    out += (GAUSS_TABLE[frac] * s3) >> 11;
+    int32_t out = (g[0] * s[0]) >> 11;
+    out += (g[1] * s[1]) >> 11;
+    out += (g[2] * s[2]) >> 11;
+    out += (g[3] * s[3]) >> 11;
 
     return static_cast<int16_t>(std::clamp(out, -32768, 32767));
 }
@@ -654,11 +706,11 @@ void DSP::process_echo() {
     }
 }
 
-void DSP::save_state(std::vector<uint8_t>& data) {
+void DSP::save_state(StateWriter& data) {
     data.push_back(m_address);
-    data.insert(data.end(), m_regs.begin(), m_regs.end());
+    data.write(m_regs.data(), m_regs.size());
 
-    // Save voice state (simplified)
+    // Save voice state (the rest goes in save_voice_state())
     for (const auto& voice : m_voices) {
         data.push_back(voice.brr_addr & 0xFF);
         data.push_back(voice.brr_addr >> 8);
@@ -701,4 +753,50 @@ void DSP::load_state(const uint8_t*& data, size_t& remaining) {
     }
 }
 
+// The BRR cache isn't listed: its entries check their source bytes on use
+template <typename Visit>
+void DSP::visit_voice_state(Visit&& visit) {
+    for (auto& voice : m_voices) {
+        visit(voice.src_addr);
+        visit(voice.brr_offset);
+        visit(voice.brr_end);
+        visit(voice.brr_loop);
+        visit(voice.samples);
+        visit(voice.sample_index);
+        visit(voice.pitch);
+        visit(voice.pitch_counter);
+        visit(voice.envelope_rate);
+        visit(voice.adsr1);
+        visit(voice.adsr2);
+        visit(voice.gain);
+        visit(voice.output);
+        visit(voice.outx);
+        visit(voice.key_on);
+        visit(voice.key_on_delay);
+        visit(voice.key_on_counter);
+        visit(voice.brr_buffer);
+    }
+
+    visit(m_output_left);
+    visit(m_output_right);
+    visit(m_echo_history_left);
+    visit(m_echo_history_right);
+    visit(m_echo_history_index);
+    visit(m_echo_addr);
+    visit(m_echo_length);
+    visit(m_noise_value);
+    visit(m_noise_counter);
+    visit(m_sample_counter);
+}
+
+void DSP::save_voice_state(StateWriter& data) {
+    visit_voice_state(emu::StateFieldWriter(data));
+}
+
+void DSP::load_voice_state(const uint8_t*& data, size_t& remaining) {
+    emu::StateFieldReader reader(data, remaining);
+    visit_voice_state(reader);
+    reader.finish();
+}
+
 } // namespace snes
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "emu/state_writer.hpp"
+
 #include <cstdint>
 #include <array>
 #include <vector>
@@ -7,6 +9,7 @@
 namespace snes {
 
 class SPC700;
+using emu::StateWriter;
 
 // Sony S-DSP (Digital Signal Processor)
 // 8 voice channels, BRR decoding, ADSR, echo
@@ -30,13 +33,20 @@ public:
     uint8_t read_data();
     void write_data(uint8_t value);
 
+    // Skip voice interpolation and mixing when nothing will be heard
+    void set_audio_enabled(bool enabled) { m_audio_enabled = enabled; }
+
     // Get audio output (stereo, -32768 to 32767)
     int16_t get_output_left() const { return m_output_left; }
     int16_t get_output_right() const { return m_output_right; }
 
     // Save state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
+    // The rest of each voice (BRR decoder, pitch, envelope, key-on delay)
+    // and of the echo, noise and output state, after save_state()
+    void save_voice_state(StateWriter& data);
+    void load_voice_state(const uint8_t*& data, size_t& remaining);
 
 private:
     void process_voice(int v);
@@ -45,6 +55,10 @@ private:
     void process_envelope(int v);
     void process_echo();
 
+    // Calls visit on each field save_voice_state() covers
+    template <typename Visit>
+    void visit_voice_state(Visit&& visit);
+
     SPC700* m_spc = nullptr;
 
     // Register address
@@ -62,8 +76,9 @@ private:
         bool brr_end;            // End flag from BRR header
         bool brr_loop;           // Loop flag from BRR header
 
-        // Decoded samples (ring buffer of 12 samples for interpolation)
-        std::array<int16_t, 12> samples;
+        // Decoded samples (ring buffer of 12 samples for interpolation),
+        // stored twice so the last four are contiguous at sample_index + 8
+        std::array<int16_t, 24> samples;
         int sample_index;        // Current position in ring buffer
 
         // Pitch
@@ -95,6 +110,20 @@ private:
     };
     std::array<Voice, 8> m_voices;
 
+    // Decoded BRR blocks, indexed by ARAM address. An entry is reused only
+    // while its 9 source bytes (and, for filtered blocks, the two previous
+    // samples) still match, so ARAM writes from the SPC700, echo or a state
+    // load can never leave it stale.
+    struct BrrCacheEntry {
+        bool valid;
+        uint8_t raw[9];
+        int prev1;
+        int prev2;
+        std::array<int16_t, 16> samples;
+    };
+    static constexpr int BRR_CACHE_SIZE = 512;
+    std::array<BrrCacheEntry, BRR_CACHE_SIZE> m_brr_cache;
+
     // Global state
     int16_t m_output_left = 0;
     int16_t m_output_right = 0;
@@ -123,10 +152,14 @@ private:
 
     // Gaussian interpolation table
     static const int16_t GAUSS_TABLE[512];
+    static const std::array<std::array<int16_t, 4>, 256> GAUSS_TAPS;
 
     // Sample counter for timing
     int m_sample_counter = 0;
 
+    // Host-side audio output switch (not part of the save state)
+    bool m_audio_enabled = true;
+
     // Register indices
     static constexpr int REG_VOL_L    = 0x00;  // VxVOLL
     static constexpr int REG_VOL_R    = 0x01;  // VxVOLR
@@ -1,17 +1,131 @@
 #include "ppu.hpp"
 #include "bus.hpp"
 #include "debug.hpp"
+#include "emu/state_writer.hpp"
 #include <cstring>
 #include <algorithm>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
 
 namespace snes {
 
+// Backgrounds present in each BG mode
+static constexpr int BG_LAYER_COUNT[8] = {4, 3, 2, 2, 2, 2, 2, 1};
+
+// Everything composition reads besides VRAM and CGRAM, as it stood while a
+// span of dots was drawn
+struct PPU::SpanState {
+    uint64_t frame;
+    bool force_blank;
+    uint8_t brightness;
+    int bg_mode;
+    bool bg3_priority;
+    std::array<bool, 4> bg_tile_size;
+    int mosaic_size;
+    std::array<bool, 4> mosaic_enabled;
+    std::array<uint16_t, 4> bg_tilemap_addr;
+    std::array<int, 4> bg_tilemap_width, bg_tilemap_height;
+    std::array<uint16_t, 4> bg_chr_addr;
+    std::array<uint16_t, 4> bg_hofs, bg_vofs;
+    std::array<bool, 4> bg_window1_enable, bg_window1_invert;
+    std::array<bool, 4> bg_window2_enable, bg_window2_invert;
+    bool obj_window1_enable, obj_window1_invert, obj_window2_enable, obj_window2_invert;
+    bool color_window1_enable, color_window1_invert, color_window2_enable, color_window2_invert;
+    uint8_t window1_left, window1_right, window2_left, window2_right;
+    std::array<int, 4> bg_window_logic;
+    int obj_window_logic, color_window_logic;
+    uint8_t tm, ts, tmw, tsw;
+    int color_math_clip, color_math_prevent;
+    bool direct_color, sub_screen_bg_obj;
+    bool color_math_add, color_math_half;
+    std::array<bool, 4> bg_color_math;
+    bool obj_color_math, backdrop_color_math;
+    uint8_t fixed_color_r, fixed_color_g, fixed_color_b;
+    bool pseudo_hires, extbg;
+    bool m7_hflip, m7_vflip;
+    int m7_wrap;
+    int16_t m7a, m7b, m7c, m7d, m7x, m7y, m7hofs, m7vofs;
+    std::array<SpriteTile, 34> sprite_tiles;
+    int sprite_tile_count;
+};
+
+// One queued span: dots [start_x, end_x) of a screen line, drawn with the
+// captured state after copying in every block written since the previous
+// span, in block order
+struct PPU::SpanJob {
+    int screen_y;
+    int start_x;
+    int end_x;
+    SpanState state;
+    bool line_buffer_dirty;  // A write the layer buffers depend on came first
+    bool window_dirty;
+    std::vector<uint16_t> blocks;
+    std::vector<uint8_t> data;
+};
+
+// The worker draws into a shadow PPU, which keeps its own layer buffers,
+// window masks and decoded tile cache. Jobs live in a fixed ring so
+// steady-state queueing doesn't allocate.
+struct PPU::RenderWorker {
+    explicit RenderWorker(Bus& bus) : shadow(bus), jobs(QUEUE_SIZE) {}
+
+    // A line is usually one span, or a few with mid-line raster effects
+    static constexpr size_t QUEUE_SIZE = 512;
+    static constexpr size_t WAKE_BATCH = 16;  // Spans queued before the worker is woken
+
+    PPU shadow;
+    std::vector<SpanJob> jobs;
+    size_t head = 0;  // Next job to queue (emulation thread)
+    size_t tail = 0;  // Next job to draw (worker thread)
+    bool stop = false;
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable work_done;
+    std::thread thread;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            work_ready.wait(lock, [this] { return stop || tail != head; });
+            if (tail == head) return;  // Stopped with nothing left
+            SpanJob& job = jobs[tail % QUEUE_SIZE];
+            lock.unlock();
+
+            const uint8_t* src = job.data.data();
+            for (uint16_t block : job.blocks) {
+                std::memcpy(shadow.block_data(block), src, DIRTY_BLOCK_SIZE);
+                src += DIRTY_BLOCK_SIZE;
+                if (block < VRAM_BLOCKS) {
+                    shadow.invalidate_vram_block(block);
+                }
+            }
+            shadow.apply_span_state(job.state);
+            if (job.line_buffer_dirty) shadow.m_line_buffer_dirty = true;
+            if (job.window_dirty) shadow.m_window_dirty = true;
+            shadow.draw_span(job.screen_y, job.start_x, job.end_x);
+
+            lock.lock();
+            tail++;
+            work_done.notify_all();
+        }
+    }
+};
+
 PPU::PPU(Bus& bus) : m_bus(bus) {
+    // 2bpp tiles are 16 bytes, 4bpp 32 and 8bpp 64
+    for (int depth = 0; depth < 3; depth++) {
+        int tile_count = 0x10000 >> (4 + depth);
+        m_tile_cache[depth].pixels.resize(tile_count * 64);
+        m_tile_cache[depth].dirty.resize(tile_count);
+    }
     reset();
 }
 
-PPU::~PPU() = default;
+PPU::~PPU() {
+    set_threaded_rendering(false);
+}
 
 void PPU::reset() {
     m_scanline = 0;
@@ -23,23 +137,36 @@ void PPU::reset() {
     m_rendered_scanline = 0;
     m_rendered_dot = 0;
     m_sprites_for_scanline = -1;  // No sprites evaluated yet
+    m_line_buffer_y = -1;
+    m_window_dirty = true;
     m_force_blank_latched_eval = true;   // Latched at dot 270 for sprite evaluation
     m_force_blank_latched_fetch = true;  // Latched at dot 272 for sprite tile fetch
     m_force_blank_on_cycle = 0;
     m_total_ppu_cycles = 0;
     m_dot_accumulator = 0;
 
+    if (m_worker) {
+        m_span_y = -1;
+        sync_rendering();
+        m_worker->shadow.m_framebuffer.fill(0);
+        m_worker->shadow.m_line_hires.fill(0);
+        mark_all_dirty();
+    }
     m_framebuffer.fill(0);
+    m_line_hires.fill(0);
     m_vram.fill(0);
+    invalidate_tile_cache();
     // OAM should initialize to $FF, not $00. On SNES hardware, this places all
     // sprites offscreen (Y=$FF). Initializing to $00 causes sprites at Y=0 to
     // appear on every scanline 0-7, blocking actual sprites.
     m_oam.fill(0xFF);
+    m_sprite_lines_size = -1;
     m_cgram.fill(0);
 
     m_inidisp = 0x80;
     m_force_blank = true;
     m_brightness = 0;
+    update_brightness_levels();
     m_obsel = 0;
     m_obj_base_addr = 0;
     m_obj_name_select = 0;
@@ -198,6 +325,7 @@ void PPU::set_timing(int scanline, int dot) {
         m_force_blank_latched_eval = m_force_blank;
         m_force_blank_latched_fetch = m_force_blank;
         m_sprites_for_scanline = -1;  // No sprites evaluated yet for this frame
+        m_line_buffer_y = -1;
         m_rendered_scanline = 0;
         m_rendered_dot = 0;
     }
@@ -373,11 +501,10 @@ void PPU::sync_to_current() {
     int visible_lines = m_overscan ? 239 : 224;
 
     // Debug: track sync calls
-    static int sync_debug_count = 0;
-    bool debug_sync = is_debug_mode() && sync_debug_count < 10 &&
+    bool debug_sync = is_debug_mode() && m_debug_sync_count < 10 &&
                       m_frame >= 25 && m_scanline < visible_lines;
     if (debug_sync) {
-        sync_debug_count++;
+        m_debug_sync_count++;
         SNES_PPU_DEBUG("sync_to_current: frame=%lu scanline=%d dot=%d rendered_sl=%d rendered_dot=%d fb=%d TM=$%02X\n",
             m_frame, m_scanline, m_dot, m_rendered_scanline, m_rendered_dot, m_force_blank ? 1 : 0, m_tm);
     }
@@ -441,6 +568,9 @@ void PPU::sync_to_current() {
             // ================================================================
 
             if (m_sprites_for_scanline != current_line) {
+                // Queued dots keep the sprite tiles they were drawn with
+                if (m_worker) flush_span();
+
                 // Check if sprite evaluation (range scan) should happen
                 // based on force_blank state latched at dot 270
                 if (!m_force_blank_latched_eval) {
@@ -476,22 +606,11 @@ void PPU::sync_to_current() {
             int render_start = std::max(start_dot, 22);
             int render_end = std::min(end_dot, 278);
 
-            for (int dot = render_start; dot < render_end; dot++) {
-                int screen_x = dot - 22;
-
-                if (!m_force_blank) {
-                    // Save current scanline, set for rendering
-                    // render_pixel does: int y = m_scanline - 1
-                    // With current_line being 0-based, we need m_scanline = current_line + 1
-                    // so that y = (current_line + 1) - 1 = current_line = screen_y
-                    int saved = m_scanline;
-                    m_scanline = current_line + 1;
-                    render_pixel(screen_x);
-                    m_scanline = saved;
+            if (render_start < render_end) {
+                if (m_worker) {
+                    if (m_video_enabled) queue_span(screen_y, render_start - 22, render_end - 22);
                 } else {
-                    // Force blank - output black (512-pixel stride with duplicated pixels)
-                    m_framebuffer[screen_y * 512 + screen_x * 2] = 0xFF000000;
-                    m_framebuffer[screen_y * 512 + screen_x * 2 + 1] = 0xFF000000;
+                    draw_span(screen_y, render_start - 22, render_end - 22);
                 }
             }
         }
@@ -515,6 +634,46 @@ void PPU::sync_to_current() {
     }
 }
 
+void PPU::draw_span(int screen_y, int start_x, int end_x) {
+    for (int screen_x = start_x; screen_x < end_x; screen_x++) {
+        if (!m_force_blank) {
+            // render_pixel does: int y = m_scanline - 1
+            // With screen_y being 0-based, we need m_scanline = screen_y + 1
+            int saved = m_scanline;
+            m_scanline = screen_y + 1;
+            render_pixel(screen_x);
+            m_scanline = saved;
+        } else {
+            output_pixel(screen_y, screen_x, 0xFF000000);
+        }
+    }
+}
+
+void PPU::output_pixel(int y, int x, uint32_t argb) {
+    uint32_t* pixel = &m_framebuffer[y * 512 + x * 2];
+    pixel[0] = argb;
+    if (m_line_hires[y]) {
+        // Lines are drawn left to right, so a line that starts lo-res is
+        // a new frame's line and hasn't gone hi-res yet
+        if (x == 0) {
+            m_line_hires[y] = 0;
+        } else {
+            pixel[1] = argb;
+        }
+    }
+}
+
+void PPU::output_hires_pixel(int y, int x, uint32_t sub_argb, uint32_t main_argb) {
+    uint32_t* row = &m_framebuffer[y * 512];
+    if (!m_line_hires[y]) {
+        // Double the lo-res pixels already on this line
+        m_line_hires[y] = 1;
+        for (int i = 0; i < x; i++) row[i * 2 + 1] = row[i * 2];
+    }
+    row[x * 2] = sub_argb;       // Even: sub screen
+    row[x * 2 + 1] = main_argb;  // Odd: main screen
+}
+
 void PPU::step() {
     // Render visible scanlines (1-224 or 1-239 in overscan)
     int visible_lines = m_overscan ? 239 : 224;
@@ -525,10 +684,7 @@ void PPU::step() {
         if (!m_force_blank) {
             render_pixel(x);
         } else {
-            // Force blank - output black (512-pixel stride with duplicated pixels)
-            int y = m_scanline - 1;
-            m_framebuffer[y * 512 + x * 2] = 0xFF000000;
-            m_framebuffer[y * 512 + x * 2 + 1] = 0xFF000000;
+            output_pixel(m_scanline - 1, x, 0xFF000000);
         }
     }
 
@@ -616,9 +772,7 @@ void PPU::render_scanline(int scanline) {
         if (!m_force_blank) {
             render_pixel(x);
         } else {
-            // Force blank - output black (512-pixel stride with duplicated pixels)
-            m_framebuffer[scanline * 512 + x * 2] = 0xFF000000;
-            m_framebuffer[scanline * 512 + x * 2 + 1] = 0xFF000000;
+            output_pixel(scanline, x, 0xFF000000);
         }
     }
 }
@@ -744,12 +898,14 @@ void PPU::end_frame() {
 }
 
 void PPU::render_pixel(int x) {
+    // Composition has no side effects beyond the framebuffer
+    if (!m_video_enabled) return;
+
     int y = m_scanline - 1;
 
     // Debug: track render_pixel calls (x=50 is near the left text area)
-    static int render_pixel_debug_count = 0;
-    if (is_debug_mode() && render_pixel_debug_count < 5 && m_frame >= 25 && y >= 70 && y <= 90 && x == 50) {
-        render_pixel_debug_count++;
+    if (is_debug_mode() && m_debug_render_pixel_count < 5 && m_frame >= 25 && y >= 70 && y <= 90 && x == 50) {
+        m_debug_render_pixel_count++;
         SNES_PPU_DEBUG("render_pixel: x=%d y=%d (m_scanline=%d) TM=$%02X mode=%d frame=%lu tilemap0=$%04X chr0=$%04X\n",
             x, y, m_scanline, m_tm, m_bg_mode, m_frame, m_bg_tilemap_addr[0], m_bg_chr_addr[0]);
     }
@@ -801,51 +957,54 @@ void PPU::render_pixel(int x) {
     uint8_t bg_priority_sub[4] = {0, 0, 0, 0};
 
     // Determine which BGs exist in current mode
-    int num_bgs = 0;
-    switch (m_bg_mode) {
-        case 0: num_bgs = 4; break;  // 4 BGs, 2bpp each
-        case 1: num_bgs = 3; break;  // 3 BGs (BG1/BG2 4bpp, BG3 2bpp)
-        case 2:
-        case 3:
-        case 4:
-        case 5:
-        case 6: num_bgs = 2; break;  // 2 BGs
-        case 7: num_bgs = 1; break;  // 1 BG (Mode 7)
-    }
+    int num_bgs = BG_LAYER_COUNT[m_bg_mode];
 
     // Check if we're in hi-res mode (Mode 5/6)
     bool is_hires_bg_mode = (m_bg_mode == 5 || m_bg_mode == 6);
 
-    // Render all backgrounds (we'll check TM/TS later for main/sub screen enable)
-    // For Modes 3/4, we also capture the palette for Direct Color mode
-    // For Mode 5/6, we render with odd pixel selection for main screen
-    for (int bg = 0; bg < num_bgs; bg++) {
-        if (m_bg_mode == 7 && bg == 0) {
-            render_mode7_pixel(x, bg_pixel[0], bg_priority[0]);
-        } else if ((m_bg_mode == 3 || m_bg_mode == 4) && bg == 0) {
-            // 8bpp BG1 in Mode 3/4 - capture palette for Direct Color
-            render_background_pixel(bg, x, bg_pixel[bg], bg_priority[bg], bg_palette[bg]);
-        } else if (is_hires_bg_mode) {
-            // Mode 5/6: render with hires_odd_pixel=true for main screen
-            render_background_pixel(bg, x, bg_pixel[bg], bg_priority[bg], true, true);
+    // BG and OBJ pixels come from the scanline buffers. The first dot of a
+    // line decodes the rest of it. The first mid-line write (usually one
+    // line's HDMA batch, which lands wherever the PPU has got to) decodes
+    // the rest again from here; a line written to after that is re-fetched
+    // a dot at a time so each dot sees the register values at that point.
+    if (m_line_buffer_y != y) {
+        build_line_buffers(x, SCREEN_WIDTH);
+        m_line_buffer_y = y;
+        m_line_buffer_dirty = false;
+        m_line_buffer_rebuilt = false;
+    } else if (m_line_buffer_dirty) {
+        if (!m_line_buffer_rebuilt) {
+            build_line_buffers(x, SCREEN_WIDTH);
+            m_line_buffer_dirty = false;
+            m_line_buffer_rebuilt = true;
         } else {
-            // Regular modes: use standard rendering
-            render_background_pixel(bg, x, bg_pixel[bg], bg_priority[bg]);
+            build_line_buffers(x, x + 1);
         }
     }
 
-    // For Mode 5/6, also render sub-screen pixels (even tile pixels)
-    if (is_hires_bg_mode) {
-        for (int bg = 0; bg < num_bgs; bg++) {
-            render_background_pixel(bg, x, bg_pixel_sub[bg], bg_priority_sub[bg], true, false);
+    // Windows only change with their registers, not from line to line
+    if (m_window_dirty) {
+        build_window_masks();
+    }
+    const uint8_t window = m_window_line[x];
+    const bool in_color_window = (window & WINDOW_COLOR) != 0;
+
+    // For Mode 5/6 the main screen takes the odd hi-res pixels and the sub
+    // screen the even ones
+    for (int bg = 0; bg < num_bgs; bg++) {
+        const BgLine& line = m_bg_line[bg];
+        bg_pixel[bg] = line.pixel[x];
+        bg_priority[bg] = line.priority[x];
+        bg_palette[bg] = line.palette[x];
+        if (is_hires_bg_mode) {
+            bg_pixel_sub[bg] = line.pixel_sub[x];
+            bg_priority_sub[bg] = line.priority_sub[x];
         }
     }
 
-    // Render sprites
-    uint8_t sprite_pixel = 0;
-    uint8_t sprite_priority = 0;
-    bool sprite_palette_4_7 = false;
-    render_sprite_pixel(x, sprite_pixel, sprite_priority, sprite_palette_4_7);
+    uint8_t sprite_pixel = m_obj_line.pixel[x];
+    uint8_t sprite_priority = m_obj_line.priority[x];
+    bool sprite_palette_4_7 = m_obj_line.palette_4_7[x];
 
     // Debug pixel rendering
     // Debug at a position where BG tiles should be visible (top-left corner)
@@ -903,14 +1062,14 @@ void PPU::render_pixel(int x) {
         auto bg_visible = [&](int bg) -> bool {
             uint8_t bit = 1 << bg;
             if (!(layer_mask & bit)) return false;  // Not enabled
-            if ((window_mask & bit) && get_bg_window(bg, x)) return false;  // Masked by window
+            if (window_mask & window & bit) return false;  // Masked by window
             return true;
         };
 
         // Helper to check if OBJ is visible (enabled and not masked by window)
         auto obj_visible = [&]() -> bool {
             if (!(layer_mask & 0x10)) return false;  // Not enabled
-            if ((window_mask & 0x10) && get_obj_window(x)) return false;  // Masked by window
+            if (window_mask & window & WINDOW_OBJ) return false;  // Masked by window
             return true;
         };
 
@@ -1044,9 +1203,8 @@ void PPU::render_pixel(int x) {
                 // BG1.pri1, OBJ.pri3
 
                 // Debug: one-time check for Mode 3 BG2 compositing
-                static bool mode3_composite_debugged = false;
-                if (is_debug_mode() && m_bg_mode == 3 && m_frame == 285 && y == 112 && x == 128 && !mode3_composite_debugged) {
-                    mode3_composite_debugged = true;
+                if (is_debug_mode() && m_bg_mode == 3 && m_frame == 285 && y == 112 && x == 128 && !m_debug_mode3_composite) {
+                    m_debug_mode3_composite = true;
                     fprintf(stderr, "[SNES/PPU] Mode 3 composite debug:\n");
                     fprintf(stderr, "  layer_mask=$%02X (TM) window_mask=$%02X (TMW)\n", layer_mask, window_mask);
                     fprintf(stderr, "  bg_visible(1)=%d (should be true if TM bit 1 set)\n", bg_visible(1) ? 1 : 0);
@@ -1235,8 +1393,8 @@ void PPU::render_pixel(int x) {
     bool apply_color_math = false;
     switch (m_color_math_prevent) {
         case 0: apply_color_math = true; break;   // Always
-        case 1: apply_color_math = !get_color_window(x); break;  // Inside window
-        case 2: apply_color_math = get_color_window(x); break;   // Outside window
+        case 1: apply_color_math = !in_color_window; break;  // Inside window
+        case 2: apply_color_math = in_color_window; break;   // Outside window
         case 3: apply_color_math = false; break;  // Never
     }
 
@@ -1306,8 +1464,8 @@ void PPU::render_pixel(int x) {
     bool clip_to_black = false;
     switch (m_color_math_clip) {
         case 0: clip_to_black = false; break;  // Never
-        case 1: clip_to_black = !get_color_window(x); break;  // Inside window
-        case 2: clip_to_black = get_color_window(x); break;   // Outside window
+        case 1: clip_to_black = !in_color_window; break;  // Inside window
+        case 2: clip_to_black = in_color_window; break;   // Outside window
         case 3: clip_to_black = true; break;   // Always
     }
 
@@ -1337,32 +1495,12 @@ void PPU::render_pixel(int x) {
     // ============================================================================
     bool use_hires_output = m_pseudo_hires || (m_bg_mode == 5) || (m_bg_mode == 6);
 
-    // Helper to convert 15-bit SNES color to 32-bit ARGB with brightness
-    // Reference: bsnes/sfc/ppu/ppu.cpp lightTable generation
-    // Formula: luma = brightness / 15.0; output = round(input * luma)
-    // This matches hardware behavior where brightness 15 = full, 0 = black
+    // Helper to convert 15-bit SNES color to 32-bit ARGB with brightness,
+    // one table load per channel (see update_brightness_levels())
     auto apply_brightness_and_convert = [this](uint16_t color) -> uint32_t {
-        // Extract 5-bit RGB components from 15-bit SNES BGR555 color
-        int r_in = color & 0x1F;
-        int g_in = (color >> 5) & 0x1F;
-        int b_in = (color >> 10) & 0x1F;
-
-        // Apply brightness with rounding (matching bsnes: (input * brightness + 7) / 15)
-        // Adding 7 (half of 15) provides proper rounding for values 0-15
-        int r = (r_in * m_brightness + 7) / 15;
-        int g = (g_in * m_brightness + 7) / 15;
-        int b = (b_in * m_brightness + 7) / 15;
-
-        // Clamp to 0-31 (shouldn't be necessary but safe)
-        r = std::min(r, 31);
-        g = std::min(g, 31);
-        b = std::min(b, 31);
-
-        // Convert 5-bit color to 8-bit (expand using upper bits for accuracy)
-        // This replicates the high bits into the low bits for proper 8-bit range
-        r = (r << 3) | (r >> 2);
-        g = (g << 3) | (g >> 2);
-        b = (b << 3) | (b >> 2);
+        uint32_t r = m_brightness_levels[color & 0x1F];
+        uint32_t g = m_brightness_levels[(color >> 5) & 0x1F];
+        uint32_t b = m_brightness_levels[(color >> 10) & 0x1F];
 
         // Return as 32-bit ABGR (0xAABBGGRR format matching other cores)
         // On little-endian systems, this byte order is RGBA when accessed as bytes
@@ -1391,21 +1529,17 @@ void PPU::render_pixel(int x) {
         uint32_t main_argb = apply_brightness_and_convert(final_color);
         uint32_t sub_argb = apply_brightness_and_convert(sub_color);
 
-        // Write both pixels (512-wide framebuffer)
-        m_framebuffer[y * 512 + x * 2] = sub_argb;      // Even: sub screen
-        m_framebuffer[y * 512 + x * 2 + 1] = main_argb; // Odd: main screen
+        output_hires_pixel(y, x, sub_argb, main_argb);
     } else {
-        // Standard 256-pixel mode - output duplicated pixels to 512-wide framebuffer
-        // This ensures consistent framebuffer stride when modes are mixed mid-frame
-        // (e.g., SplitScreen test switches between Mode 5 and Mode 3)
+        // Standard 256-pixel mode - one pixel, doubled only on lines that
+        // also have hi-res pixels (e.g., SplitScreen test switches between
+        // Mode 5 and Mode 3)
         uint32_t argb = apply_brightness_and_convert(final_color);
-        m_framebuffer[y * 512 + x * 2] = argb;
-        m_framebuffer[y * 512 + x * 2 + 1] = argb;  // Duplicate for 256-pixel mode
+        output_pixel(y, x, argb);
 
         // Debug: track pixel output
-        static int pixel_output_debug = 0;
-        if (is_debug_mode() && pixel_output_debug < 5 && m_frame >= 25 && y >= 70 && y <= 90 && x == 50) {
-            pixel_output_debug++;
+        if (is_debug_mode() && m_debug_pixel_output_count < 5 && m_frame >= 25 && y >= 70 && y <= 90 && x == 50) {
+            m_debug_pixel_output_count++;
             SNES_PPU_DEBUG("  PIXEL OUTPUT: x=%d y=%d final=$%04X bright=%d argb=$%08X fb_idx=%d\n",
                 x, y, final_color, m_brightness, argb, y * 512 + x * 2);
         }
@@ -1416,10 +1550,9 @@ void PPU::render_pixel(int x) {
         }
 
         // One-time diagnostic: count non-black pixels in Mode 3
-        static bool mode3_pixel_diagnosed = false;
-        if (is_debug_mode() && m_bg_mode == 3 && m_frame == 285 && y == 112 && !mode3_pixel_diagnosed) {
+        if (is_debug_mode() && m_bg_mode == 3 && m_frame == 285 && y == 112 && !m_debug_mode3_pixel) {
             if (x == 128) {  // Check at center pixel
-                mode3_pixel_diagnosed = true;
+                m_debug_mode3_pixel = true;
                 fprintf(stderr, "[SNES/PPU] Mode 3 center pixel: final_color=$%04X argb=$%08X\n",
                     final_color, argb);
                 fprintf(stderr, "  main_pixel: color=$%04X source=%d (0=backdrop,2=BG2)\n",
@@ -1431,856 +1564,348 @@ void PPU::render_pixel(int x) {
 }
 
 // ============================================================================
-// COLOR WINDOW EVALUATION
+// WINDOW MASKS
 // ============================================================================
 // Reference: fullsnes Window documentation, bsnes/sfc/ppu/window.cpp
 //
-// The color window is used to mask regions of the screen for color math
-// and clip-to-black operations. It uses the same window registers as
-// background/sprite masking but with its own enable and logic settings.
+// Each layer (BG1-4, OBJ and the color window used by color math and
+// clip-to-black) has its own enable, invert and logic settings for the two
+// shared windows. None of that depends on the screen line, so the result is
+// built for all 256 pixels at once and kept until a window register changes:
+// m_window_line[x] has WINDOW_BG1..WINDOW_COLOR set for the layers whose
+// window covers x.
 // ============================================================================
-bool PPU::get_color_window(int x) const {
-    // Evaluate window 1
-    bool w1 = false;
-    if (m_color_window1_enable) {
-        w1 = (x >= m_window1_left && x <= m_window1_right);
-        if (m_color_window1_invert) w1 = !w1;
-    }
-
-    // Evaluate window 2
-    bool w2 = false;
-    if (m_color_window2_enable) {
-        w2 = (x >= m_window2_left && x <= m_window2_right);
-        if (m_color_window2_invert) w2 = !w2;
-    }
-
-    // Combine windows based on logic mode
-    // 0 = OR, 1 = AND, 2 = XOR, 3 = XNOR
-    bool result = false;
-    if (!m_color_window1_enable && !m_color_window2_enable) {
-        // No windows enabled - always outside
-        result = false;
-    } else if (m_color_window1_enable && !m_color_window2_enable) {
-        result = w1;
-    } else if (!m_color_window1_enable && m_color_window2_enable) {
-        result = w2;
-    } else {
-        // Both windows enabled - apply logic
-        switch (m_color_window_logic) {
-            case 0: result = w1 || w2; break;  // OR
-            case 1: result = w1 && w2; break;  // AND
-            case 2: result = w1 != w2; break;  // XOR
-            case 3: result = w1 == w2; break;  // XNOR
+void PPU::build_window_masks() {
+    // The layers inside their window for each combination of "x is within
+    // window 1" (bit 0) and "x is within window 2" (bit 1)
+    std::array<uint8_t, 4> inside = {0, 0, 0, 0};
+    auto add_layer = [&](uint8_t bit, bool enable1, bool invert1, bool enable2, bool invert2, int logic) {
+        for (int in = 0; in < 4; in++) {
+            bool w1 = ((in & 1) != 0) != invert1;
+            bool w2 = ((in & 2) != 0) != invert2;
+            bool result = false;
+            if (enable1 && enable2) {
+                switch (logic) {
+                    case 0: result = w1 || w2; break;  // OR
+                    case 1: result = w1 && w2; break;  // AND
+                    case 2: result = w1 != w2; break;  // XOR
+                    case 3: result = w1 == w2; break;  // XNOR
+                }
+            } else if (enable1) {
+                result = w1;
+            } else if (enable2) {
+                result = w2;
+            }
+            if (result) inside[in] |= bit;
         }
+    };
+
+    for (int bg = 0; bg < 4; bg++) {
+        add_layer(static_cast<uint8_t>(1 << bg), m_bg_window1_enable[bg], m_bg_window1_invert[bg],
+                  m_bg_window2_enable[bg], m_bg_window2_invert[bg], m_bg_window_logic[bg]);
     }
+    add_layer(WINDOW_OBJ, m_obj_window1_enable, m_obj_window1_invert,
+              m_obj_window2_enable, m_obj_window2_invert, m_obj_window_logic);
+    add_layer(WINDOW_COLOR, m_color_window1_enable, m_color_window1_invert,
+              m_color_window2_enable, m_color_window2_invert, m_color_window_logic);
 
-    return result;
+    for (int x = 0; x < SCREEN_WIDTH; x++) {
+        int in = (x >= m_window1_left && x <= m_window1_right ? 1 : 0) |
+                 (x >= m_window2_left && x <= m_window2_right ? 2 : 0);
+        m_window_line[x] = inside[in];
+    }
+    m_window_dirty = false;
 }
 
-bool PPU::get_bg_window(int bg, int x) const {
-    // Evaluate window 1 for this BG
-    bool w1 = false;
-    if (m_bg_window1_enable[bg]) {
-        w1 = (x >= m_window1_left && x <= m_window1_right);
-        if (m_bg_window1_invert[bg]) w1 = !w1;
-    }
-
-    // Evaluate window 2 for this BG
-    bool w2 = false;
-    if (m_bg_window2_enable[bg]) {
-        w2 = (x >= m_window2_left && x <= m_window2_right);
-        if (m_bg_window2_invert[bg]) w2 = !w2;
-    }
-
-    // Combine windows based on logic mode
-    bool result = false;
-    if (!m_bg_window1_enable[bg] && !m_bg_window2_enable[bg]) {
-        result = false;
-    } else if (m_bg_window1_enable[bg] && !m_bg_window2_enable[bg]) {
-        result = w1;
-    } else if (!m_bg_window1_enable[bg] && m_bg_window2_enable[bg]) {
-        result = w2;
-    } else {
-        switch (m_bg_window_logic[bg]) {
-            case 0: result = w1 || w2; break;  // OR
-            case 1: result = w1 && w2; break;  // AND
-            case 2: result = w1 != w2; break;  // XOR
-            case 3: result = w1 == w2; break;  // XNOR
-        }
+// ============================================================================
+// SCANLINE LAYER BUFFERS
+// ============================================================================
+// Reference: bsnes/sfc/ppu-fast/background.cpp
+//
+// Each BG is walked across the line once, reading color indices from the
+// decoded tile cache, so a pixel costs one byte load instead of a bitplane
+// gather. The per-dot position math (scroll, offset-per-tile, mosaic, 16-pixel tiles, hi-res
+// doubling) is unchanged, so building a one-dot range gives exactly what the
+// old per-pixel fetch did.
+// ============================================================================
+void PPU::build_line_buffers(int start_x, int end_x) {
+    int num_bgs = BG_LAYER_COUNT[m_bg_mode];
+    for (int bg = 0; bg < num_bgs; bg++) {
+        build_background_line(bg, start_x, end_x);
     }
-
-    return result;
+    build_sprite_line(start_x, end_x);
 }
 
-bool PPU::get_obj_window(int x) const {
-    // Evaluate window 1 for OBJ
-    bool w1 = false;
-    if (m_obj_window1_enable) {
-        w1 = (x >= m_window1_left && x <= m_window1_right);
-        if (m_obj_window1_invert) w1 = !w1;
-    }
-
-    // Evaluate window 2 for OBJ
-    bool w2 = false;
-    if (m_obj_window2_enable) {
-        w2 = (x >= m_window2_left && x <= m_window2_right);
-        if (m_obj_window2_invert) w2 = !w2;
-    }
-
-    // Combine windows based on logic mode
-    bool result = false;
-    if (!m_obj_window1_enable && !m_obj_window2_enable) {
-        result = false;
-    } else if (m_obj_window1_enable && !m_obj_window2_enable) {
-        result = w1;
-    } else if (!m_obj_window1_enable && m_obj_window2_enable) {
-        result = w2;
-    } else {
-        switch (m_obj_window_logic) {
-            case 0: result = w1 || w2; break;  // OR
-            case 1: result = w1 && w2; break;  // AND
-            case 2: result = w1 != w2; break;  // XOR
-            case 3: result = w1 == w2; break;  // XNOR
-        }
+void PPU::build_background_line(int bg, int start_x, int end_x) {
+    BgLine& line = m_bg_line[bg];
+
+    if (m_bg_mode == 7) {
+        build_mode7_line(start_x, end_x);
+        return;
     }
 
-    return result;
-}
+    int y = m_scanline - 1;
+    bool is_hires_mode = (m_bg_mode == 5 || m_bg_mode == 6);
 
-void PPU::render_background_pixel(int bg, int x, uint8_t& pixel, uint8_t& priority) {
-    pixel = 0;
-    priority = 0;
-
-    // Debug BG rendering - once per frame at a specific pixel for Mode 3 BG2
-    bool debug_bg = is_debug_mode() && m_frame == 300 && m_scanline == 10 && x == 16 && bg == 1;
-    // Also do a one-time summary when Mode 3 BG2 is first rendered
-    static bool mode3_bg2_diagnosed = false;
-    bool do_mode3_diagnosis = is_debug_mode() && m_bg_mode == 3 && bg == 1 && m_frame >= 280 && !mode3_bg2_diagnosed;
-    if (do_mode3_diagnosis) {
-        mode3_bg2_diagnosed = true;
-        uint16_t tilemap_base = m_bg_tilemap_addr[1];
-        uint16_t chr_base = m_bg_chr_addr[1];
-        fprintf(stderr, "[SNES/PPU] Mode 3 BG2 diagnosis at frame %lu:\n", m_frame);
-        fprintf(stderr, "  BG2 tilemap=$%04X chr=$%04X TM=$%02X\n", tilemap_base, chr_base, m_tm);
-
-        // Check if BG2 is enabled on main screen
-        if (!(m_tm & 0x02)) {
-            fprintf(stderr, "  WARNING: BG2 NOT enabled on main screen (TM bit 1 = 0)!\n");
-        }
+    // In Modes 5/6 tiles are always 16 pixels wide; the tile size bit only
+    // affects the height there
+    int tile_width = is_hires_mode ? 16 : (m_bg_tile_size[bg] ? 16 : 8);
+    int tile_height = m_bg_tile_size[bg] ? 16 : 8;
 
-        // Scan tilemap for non-zero entries
-        int nonzero_entries = 0;
-        int first_nonzero_tile = -1;
-        for (int i = 0; i < 2048; i += 2) {
-            uint8_t lo = m_vram[(tilemap_base + i) & 0xFFFF];
-            uint8_t hi = m_vram[(tilemap_base + i + 1) & 0xFFFF];
-            if (lo != 0 || hi != 0) {
-                nonzero_entries++;
-                if (first_nonzero_tile < 0) {
-                    first_nonzero_tile = i / 2;
-                    int tile = lo | ((hi & 0x03) << 8);
-                    int pal = (hi >> 2) & 0x07;
-                    fprintf(stderr, "  First non-zero tilemap entry at %d: tile=%d pal=%d\n",
-                        first_nonzero_tile, tile, pal);
-                }
-            }
-        }
-        fprintf(stderr, "  Tilemap: %d/1024 non-zero entries\n", nonzero_entries);
+    // Bits per pixel by mode
+    // Mode 0: All BGs 2bpp       Mode 3: BG1 8bpp, BG2 4bpp
+    // Mode 1: BG1/BG2 4bpp, BG3 2bpp  Mode 4: BG1 8bpp, BG2 2bpp
+    // Mode 2: BG1/BG2 4bpp       Mode 5/6: BG1 4bpp, BG2 2bpp
+    int bpp;
+    switch (m_bg_mode) {
+        case 0: bpp = 2; break;
+        case 1: bpp = (bg < 2) ? 4 : 2; break;
+        case 2: bpp = 4; break;
+        case 3: bpp = (bg == 0) ? 8 : 4; break;
+        case 4: bpp = (bg == 0) ? 8 : 2; break;
+        default: bpp = (bg == 0) ? 4 : 2; break;
+    }
 
-        // Check chr data at chr_base
-        int chr_nonzero = 0;
-        for (int i = 0; i < 0x2000; i++) {
-            if (m_vram[(chr_base + i) & 0xFFFF] != 0) chr_nonzero++;
-        }
-        fprintf(stderr, "  Chr data at $%04X: %d/8192 non-zero bytes\n", chr_base, chr_nonzero);
+    // Mode 0: Each BG has its own 32-color region (BG1: 0-31, BG2: 32-63, ...)
+    int bg_offset = (m_bg_mode == 0) ? (bg * 32) : 0;
 
-        // Check first tile's data
-        fprintf(stderr, "  Tile 0 chr data: ");
-        for (int i = 0; i < 8; i++) {
-            fprintf(stderr, "%02X ", m_vram[(chr_base + i) & 0xFFFF]);
+    uint16_t tilemap_base = m_bg_tilemap_addr[bg];
+    int tilemap_width = m_bg_tilemap_width[bg] ? 64 : 32;
+    int tilemap_height = m_bg_tilemap_height[bg] ? 64 : 32;
+    uint16_t chr_base = m_bg_chr_addr[bg];
+
+    bool mosaic = m_mosaic_enabled[bg] && m_mosaic_size > 1;
+    int mosaic_y = mosaic ? (y / m_mosaic_size) * m_mosaic_size : y;
+
+    // Fetch the BG pixel at BG-space position (px, py)
+    auto fetch = [&](int px, int py, uint8_t& pixel, uint8_t& priority, uint8_t& palette_out) {
+        // Calculate tile coordinates
+        int tile_x = px / tile_width;
+        int tile_y = py / tile_height;
+        int fine_x = px % tile_width;
+        int fine_y = py % tile_height;
+
+        // Handle tilemap wrapping
+        int tilemap_x = tile_x % tilemap_width;
+        int tilemap_y = tile_y % tilemap_height;
+
+        // Each 32x32 screen is 2KB
+        // Layout: SC0 | SC1 (if width=64)
+        //         SC2 | SC3 (if both width and height=64)
+        int screen_offset = 0;
+        if (tilemap_width == 64 && tilemap_x >= 32) {
+            screen_offset += 0x800;
+            tilemap_x -= 32;
+        }
+        if (tilemap_height == 64 && tilemap_y >= 32) {
+            screen_offset += tilemap_width == 64 ? 0x1000 : 0x800;
+            tilemap_y -= 32;
         }
-        fprintf(stderr, "\n");
 
-        // Check CGRAM palette 0 (first BG palette)
-        fprintf(stderr, "  CGRAM palette 0: ");
-        for (int c = 0; c < 16; c++) {
-            uint16_t color = m_cgram[c * 2] | (m_cgram[c * 2 + 1] << 8);
-            if (color != 0) fprintf(stderr, "[%d]=$%04X ", c, color);
+        // Tilemap entry: vhopppcc cccccccc
+        uint16_t tilemap_addr = tilemap_base + screen_offset + (tilemap_y * 32 + tilemap_x) * 2;
+        uint8_t tile_lo = m_vram[tilemap_addr & 0xFFFF];
+        uint8_t tile_hi = m_vram[(tilemap_addr + 1) & 0xFFFF];
+
+        int tile_num = tile_lo | ((tile_hi & 0x03) << 8);
+        int palette = (tile_hi >> 2) & 0x07;
+        priority = (tile_hi >> 5) & 0x01;
+        palette_out = palette;
+        bool hflip = (tile_hi & 0x40) != 0;
+        bool vflip = (tile_hi & 0x80) != 0;
+
+        // Large tiles are composed of 8x8 tiles: [N  ][N+1]
+        //                                        [N+16][N+17]
+        int x_offset = 0;
+        int y_offset = 0;
+
+        if (tile_width == 16) {
+            x_offset = (fine_x >= 8) ? 1 : 0;
+            if (hflip) x_offset = 1 - x_offset;
+            fine_x &= 7;
         }
-        fprintf(stderr, "\n");
-    }
-
-    if (debug_bg) {
-        SNES_PPU_DEBUG(">>> render_background_pixel ENTRY: bg=%d x=%d scanline=%d frame=%llu\n",
-            bg, x, m_scanline, (unsigned long long)m_frame);
-        // Scan entire BG2 tilemap for unique tiles and check their chr data
-        uint16_t tilemap_base = m_bg_tilemap_addr[1];
-        SNES_PPU_DEBUG("  BG2 Tilemap at $%04X scan - unique tiles:\n", tilemap_base);
-        int tile_counts[256] = {0};
-        for (int i = 0; i < 2048; i += 2) {  // 2KB tilemap = 1024 entries
-            uint8_t lo = m_vram[(tilemap_base + i) & 0xFFFF];
-            uint8_t hi = m_vram[(tilemap_base + i + 1) & 0xFFFF];
-            int tile = lo | ((hi & 0x03) << 8);
-            if (tile < 256) tile_counts[tile]++;
+
+        if (tile_height == 16) {
+            y_offset = (fine_y >= 8) ? 16 : 0;
+            if (vflip) y_offset = (y_offset == 16) ? 0 : 16;
+            fine_y &= 7;
         }
-        for (int t = 0; t < 256; t++) {
-            if (tile_counts[t] > 0) {
-                uint16_t tile_addr = m_bg_chr_addr[1] + t * 32;
-                int nonzero = 0;
-                for (int j = 0; j < 32; j++) {
-                    if (m_vram[(tile_addr + j) & 0xFFFF] != 0) nonzero++;
-                }
-                SNES_PPU_DEBUG("    Tile %d: %d uses, chr $%04X: %d/32 bytes\n",
-                    t, tile_counts[t], tile_addr, nonzero);
+
+        tile_num += x_offset + y_offset;
+
+        // Apply flip to fine coordinates (within 8x8 sub-tile)
+        if (hflip) fine_x = 7 - fine_x;
+        if (vflip) fine_y = 7 - fine_y;
+
+        // Color index from the decoded tile cache
+        uint16_t chr_addr = chr_base + tile_num * (bpp * 8);
+        const uint8_t* row = get_decoded_tile_row(bpp, chr_addr + fine_y * 2);
+
+        // Final CGRAM index; 8bpp is a direct index (no palette selection)
+        uint8_t color_index = row[fine_x];
+        pixel = 0;
+        if (color_index != 0) {
+            if (bpp == 8) {
+                pixel = color_index;
+            } else if (bpp == 2) {
+                pixel = bg_offset + (palette << 2) + color_index;
+            } else {
+                pixel = (palette << 4) + color_index;
             }
         }
+    };
+
+    if (is_hires_mode) {
+        // ====================================================================
+        // HI-RES (MODE 5/6)
+        // ====================================================================
+        // Reference: bsnes/ares background.cpp fetchNameTable()
+        //
+        // Screen X and the horizontal scroll are both doubled into 512-pixel
+        // hi-res space. Odd pixels go to the main screen, even pixels to the
+        // sub screen.
+        // ====================================================================
+        int scroll_x = (m_bg_hofs[bg] & 0x3FF) << 1;
+        int py = (mosaic_y + (m_bg_vofs[bg] & 0x3FF)) & 0x3FF;
+        uint8_t unused_palette;
+
+        for (int x = start_x; x < end_x; x++) {
+            int mosaic_x = mosaic ? (x / m_mosaic_size) * m_mosaic_size : x;
+            fetch((mosaic_x * 2 + 1 + scroll_x) & 0x3FF, py,
+                  line.pixel[x], line.priority[x], line.palette[x]);
+            fetch((mosaic_x * 2 + scroll_x) & 0x3FF, py,
+                  line.pixel_sub[x], line.priority_sub[x], unused_palette);
+        }
+        return;
     }
 
-    // Get scroll values
-    // Note: Scroll registers are 10-bit signed values
-    int scroll_x = m_bg_hofs[bg] & 0x3FF;
-    int scroll_y = m_bg_vofs[bg] & 0x3FF;
+    // Scroll registers are 10-bit values
+    int hofs = m_bg_hofs[bg] & 0x3FF;
+    int vofs = m_bg_vofs[bg] & 0x3FF;
+    int scroll_x = hofs;
+    int scroll_y = vofs;
 
     // ========================================================================
-    // OFFSET-PER-TILE (OPT) FOR MODES 2, 4, 6
+    // OFFSET-PER-TILE (OPT) FOR MODES 2 AND 4
     // ========================================================================
     // Reference: SNESdev wiki Offset-per-tile, sneslab.net Offset_Change_Mode
     //
-    // In Modes 2/4/6, BG3's tilemap is repurposed as an offset table.
-    // Each 8-pixel column of BG1/BG2 can have a different scroll offset.
-    // The leftmost visible column uses normal scroll values.
-    // Columns 1-32 use offsets from BG3 tilemap entries.
+    // BG3's tilemap is repurposed as an offset table. Each 8-pixel column of
+    // BG1/BG2 can have a different scroll offset; the leftmost visible column
+    // uses the normal scroll values, columns 1-32 use BG3 tilemap entries.
     //
     // BG3 offset table format (16-bit entries):
     //   Bits 0-9:  Offset value (same format as scroll register)
-    //   Bits 10-12: Unused
     //   Bit 13:    Apply to BG1
     //   Bit 14:    Apply to BG2
     //   Bit 15:    Mode 4 only: 0=horizontal, 1=vertical
     //
-    // For Mode 2/6: Two rows - row 0 = H offset, row 1 = V offset
-    // For Mode 4:   One row, bit 15 selects H or V
+    // For Mode 2: Two rows - row 0 = H offset, row 1 = V offset
+    // For Mode 4: One row, bit 15 selects H or V
     //
     // Horizontal offset: Replaces upper bits of HOFS, keeps low 3 bits (fine scroll)
     // Vertical offset: Replaces entire VOFS value
     // ========================================================================
-    bool opt_mode = (m_bg_mode == 2 || m_bg_mode == 4 || m_bg_mode == 6);
-    if (opt_mode && (bg == 0 || bg == 1)) {
-        // Calculate screen column (0-32 visible tiles)
-        // Column 0 uses normal scroll, columns 1-32 use OPT
-        int screen_column = (x + (scroll_x & 7)) >> 3;
-
-        if (screen_column > 0 && screen_column <= 32) {
-            // Read from BG3 offset table at position (screen_column - 1)
-            // BG3 tilemap base address
-            uint16_t bg3_base = m_bg_tilemap_addr[2];
-            int bg3_hofs = m_bg_hofs[2] & 0x3FF;
-            int bg3_vofs = m_bg_vofs[2] & 0x3FF;
-
-            // BG3 tile size affects column granularity
-            int bg3_tile_size = m_bg_tile_size[2] ? 16 : 8;
-
-            // Calculate offset table entry address
-            // The offset table is indexed by (screen_column - 1)
-            // Each entry is 2 bytes (16-bit)
-            int opt_column = screen_column - 1;
-
-            // Calculate BG3 tilemap position based on BG3 scroll and tile size
-            // The upper bits of BG3 scroll determine which row of the tilemap we read
-            int opt_row = (bg3_vofs / bg3_tile_size) & 0x1F;
-            int opt_col = ((bg3_hofs / bg3_tile_size) + opt_column) & 0x1F;
-
-            // Handle 64-wide tilemap
-            int screen_offset = 0;
-            if (m_bg_tilemap_width[2] && opt_col >= 32) {
-                screen_offset = 0x800;
-                opt_col -= 32;
-            }
-
-            // Read horizontal offset entry (row 0 in Mode 2/6)
-            uint16_t h_entry_addr = bg3_base + screen_offset + (opt_row * 32 + opt_col) * 2;
-            uint8_t h_lo = m_vram[h_entry_addr & 0xFFFF];
-            uint8_t h_hi = m_vram[(h_entry_addr + 1) & 0xFFFF];
-            uint16_t h_entry = h_lo | (h_hi << 8);
-
-            // Check if this entry applies to this BG
-            bool apply_h = (bg == 0 && (h_entry & 0x2000)) || (bg == 1 && (h_entry & 0x4000));
-
-            if (m_bg_mode == 4) {
-                // Mode 4: Single entry, bit 15 determines H or V
-                if (!(h_entry & 0x8000) && apply_h) {
-                    // Horizontal offset - keep low 3 bits of original HOFS
-                    scroll_x = (h_entry & 0x3F8) | (scroll_x & 7);
-                } else if ((h_entry & 0x8000) && apply_h) {
-                    // Vertical offset - replace entire VOFS
-                    scroll_y = h_entry & 0x3FF;
-                }
-            } else {
-                // Mode 2/6: Read H from row 0, V from row 1
-                if (apply_h) {
-                    // Horizontal offset - keep low 3 bits of original HOFS
-                    scroll_x = (h_entry & 0x3F8) | (scroll_x & 7);
-                }
-
-                // Read vertical offset entry (row 1 = 32 entries = 64 bytes later)
-                uint16_t v_entry_addr = h_entry_addr + 64;
-                uint8_t v_lo = m_vram[v_entry_addr & 0xFFFF];
-                uint8_t v_hi = m_vram[(v_entry_addr + 1) & 0xFFFF];
-                uint16_t v_entry = v_lo | (v_hi << 8);
-
-                bool apply_v = (bg == 0 && (v_entry & 0x2000)) || (bg == 1 && (v_entry & 0x4000));
-                if (apply_v) {
-                    // Vertical offset - replace entire VOFS
-                    scroll_y = v_entry & 0x3FF;
-                }
-            }
+    bool opt_mode = (m_bg_mode == 2 || m_bg_mode == 4) && bg < 2;
+    int opt_column = -1;
+
+    auto apply_offset_per_tile = [&](int screen_column) {
+        scroll_x = hofs;
+        scroll_y = vofs;
+        if (screen_column <= 0 || screen_column > 32) {
+            return;
         }
-    }
-
-    // Apply mosaic
-    int mosaic_x = x;
-    int mosaic_y = m_scanline - 1;
-    if (m_mosaic_enabled[bg] && m_mosaic_size > 1) {
-        mosaic_x = (mosaic_x / m_mosaic_size) * m_mosaic_size;
-        mosaic_y = (mosaic_y / m_mosaic_size) * m_mosaic_size;
-    }
-
-    // Calculate pixel position in BG (10-bit wrap for 1024 pixel BG space)
-    int px = (mosaic_x + scroll_x) & 0x3FF;
-    int py = (mosaic_y + scroll_y) & 0x3FF;
-
-    // Get tile size
-    // Reference: SNESdev wiki Backgrounds, sneslab.net Mode_5
-    //
-    // In Modes 5 and 6 (hi-res modes), tiles are ALWAYS 16 pixels wide.
-    // The tile size bit ($2105 bits 4-7) only affects the height:
-    //   - Bit clear: 16x8 tiles (16 wide, 8 tall)
-    //   - Bit set:   16x16 tiles (16 wide, 16 tall)
-    //
-    // In non-hires modes (0-4, 7), the tile size bit affects both dimensions:
-    //   - Bit clear: 8x8 tiles
-    //   - Bit set:   16x16 tiles
-    bool is_hires_mode = (m_bg_mode == 5 || m_bg_mode == 6);
-    int tile_width = is_hires_mode ? 16 : (m_bg_tile_size[bg] ? 16 : 8);
-    int tile_height = m_bg_tile_size[bg] ? 16 : 8;
-
-    // Calculate tile coordinates
-    int tile_x = px / tile_width;
-    int tile_y = py / tile_height;
-    int fine_x = px % tile_width;
-    int fine_y = py % tile_height;
 
-    // Get tilemap address (pre-calculated from BGnSC register as byte address)
-    uint16_t tilemap_base = m_bg_tilemap_addr[bg];
-    int tilemap_width = m_bg_tilemap_width[bg] ? 64 : 32;
-    int tilemap_height = m_bg_tilemap_height[bg] ? 64 : 32;
-
-    // Handle tilemap wrapping
-    int tilemap_x = tile_x % tilemap_width;
-    int tilemap_y = tile_y % tilemap_height;
-
-    // Calculate screen offset for 64-wide/tall tilemaps
-    // Each 32x32 screen is 2KB (32*32*2 bytes)
-    // Layout: SC0 | SC1 (if width=64)
-    //         SC2 | SC3 (if both width and height=64)
-    int screen_offset = 0;
-    if (tilemap_width == 64 && tilemap_x >= 32) {
-        screen_offset += 0x800;  // 2KB for second horizontal screen
-        tilemap_x -= 32;
-    }
-    if (tilemap_height == 64 && tilemap_y >= 32) {
-        screen_offset += tilemap_width == 64 ? 0x1000 : 0x800;
-        tilemap_y -= 32;
-    }
-
-    // Get tilemap entry (2 bytes per tile)
-    // Each tilemap entry: vhopppcc cccccccc
-    uint16_t tilemap_addr = tilemap_base + screen_offset + (tilemap_y * 32 + tilemap_x) * 2;
-    uint8_t tile_lo = m_vram[tilemap_addr & 0xFFFF];
-    uint8_t tile_hi = m_vram[(tilemap_addr + 1) & 0xFFFF];
-
-    int tile_num = tile_lo | ((tile_hi & 0x03) << 8);  // 10-bit tile number
+        uint16_t bg3_base = m_bg_tilemap_addr[2];
+        int bg3_hofs = m_bg_hofs[2] & 0x3FF;
+        int bg3_vofs = m_bg_vofs[2] & 0x3FF;
+        int bg3_tile_size = m_bg_tile_size[2] ? 16 : 8;
 
-    int palette = (tile_hi >> 2) & 0x07;               // 3-bit palette
-    priority = (tile_hi >> 5) & 0x01;                  // 1-bit priority
-    bool hflip = (tile_hi & 0x40) != 0;
-    bool vflip = (tile_hi & 0x80) != 0;
+        // The upper bits of BG3 scroll select which tilemap entries are read
+        int opt_row = (bg3_vofs / bg3_tile_size) & 0x1F;
+        int opt_col = ((bg3_hofs / bg3_tile_size) + screen_column - 1) & 0x1F;
 
-    if (debug_bg) {
-        SNES_PPU_DEBUG("BG2 render: px=%d py=%d tile_x=%d tile_y=%d fine_x=%d fine_y=%d\n",
-            px, py, tile_x, tile_y, fine_x, fine_y);
-        SNES_PPU_DEBUG("  tilemap_addr=$%04X tile_lo=%02X tile_hi=%02X -> tile=%d pal=%d pri=%d hflip=%d vflip=%d\n",
-            tilemap_addr, tile_lo, tile_hi, tile_num, palette, priority, hflip, vflip);
-    }
-
-    // Handle large tiles (composed of multiple 8x8 tiles)
-    // Reference: SNESdev wiki Backgrounds
-    //
-    // For 16-pixel wide tiles (Mode 5/6 always, or 16x16 mode in other modes):
-    //   Tiles are arranged horizontally: [N][N+1]
-    // For 16-pixel tall tiles (16x16 mode in any mode):
-    //   Tiles are arranged vertically in rows of 16
-    //
-    // Combined for 16x16: [N  ][N+1]
-    //                     [N+16][N+17]
-    int x_offset = 0;
-    int y_offset = 0;
-
-    if (tile_width == 16) {
-        x_offset = (fine_x >= 8) ? 1 : 0;
-        if (hflip) x_offset = 1 - x_offset;
-        fine_x &= 7;
-    }
-
-    if (tile_height == 16) {
-        y_offset = (fine_y >= 8) ? 16 : 0;
-        if (vflip) y_offset = (y_offset == 16) ? 0 : 16;
-        fine_y &= 7;
-    }
-
-    tile_num += x_offset + y_offset;
-
-    // Apply flip to fine coordinates (within 8x8 sub-tile)
-    if (hflip) fine_x = 7 - fine_x;
-    if (vflip) fine_y = 7 - fine_y;
-
-    // Get bits per pixel based on mode
-    // Mode 0: All BGs 2bpp (4 colors each, 8 palettes)
-    // Mode 1: BG1/BG2 4bpp (16 colors), BG3 2bpp
-    // Mode 2: BG1/BG2 4bpp, offset-per-tile
-    // Mode 3: BG1 8bpp (256 colors), BG2 4bpp
-    // Mode 4: BG1 8bpp, BG2 2bpp, offset-per-tile
-    // Mode 5: BG1/BG2 4bpp, 16x8 or 16x16, hi-res
-    // Mode 6: BG1 4bpp, 16x8 or 16x16, offset-per-tile, hi-res
-    // Mode 7: BG1 8bpp, affine transformation
-    int bpp;
-    switch (m_bg_mode) {
-        case 0: bpp = 2; break;
-        case 1: bpp = (bg < 2) ? 4 : 2; break;
-        case 2: bpp = 4; break;
-        case 3: bpp = (bg == 0) ? 8 : 4; break;
-        case 4: bpp = (bg == 0) ? 8 : 2; break;
-        case 5: bpp = 4; break;
-        case 6: bpp = 4; break;
-        default: bpp = 8; break;
-    }
-
-    // Get character data address (pre-calculated from BGnNBA register as byte address)
-    // Tile size in bytes: 8 rows * bpp bytes per row (bitplanes interleaved)
-    uint16_t chr_base = m_bg_chr_addr[bg];
-    uint16_t chr_addr = chr_base + tile_num * (bpp * 8);
-
-    // Read tile data using SNES bitplane format
-    // 2bpp: planes 0,1 interleaved (bytes 0,1 for row 0, etc.)
-    // 4bpp: planes 0,1 first 16 bytes, planes 2,3 next 16 bytes
-    // 8bpp: planes 0,1 first 16 bytes, 2,3 next 16, 4,5 next 16, 6,7 next 16
-    uint8_t color_index = 0;
-
-    for (int bit = 0; bit < bpp; bit++) {
-        // Offset calculation for SNES planar format:
-        // Planes are grouped in pairs, with 16 bytes per pair (8 rows * 2 bytes)
-        int plane_offset = (bit / 2) * 16 + (bit & 1);
-        uint16_t addr = chr_addr + fine_y * 2 + plane_offset;
-        uint8_t plane = m_vram[addr & 0xFFFF];
-        if (plane & (0x80 >> fine_x)) {
-            color_index |= (1 << bit);
+        int screen_offset = 0;
+        if (m_bg_tilemap_width[2] && opt_col >= 32) {
+            screen_offset = 0x800;
+            opt_col -= 32;
         }
-    }
 
-    if (debug_bg) {
-        SNES_PPU_DEBUG("  chr_base=$%04X chr_addr=$%04X tile_num=%d bpp=%d\n",
-            chr_base, chr_addr, tile_num, bpp);
-        SNES_PPU_DEBUG("  VRAM data at chr_addr: %02X %02X %02X %02X %02X %02X %02X %02X\n",
-            m_vram[(chr_addr) & 0xFFFF], m_vram[(chr_addr+1) & 0xFFFF],
-            m_vram[(chr_addr+2) & 0xFFFF], m_vram[(chr_addr+3) & 0xFFFF],
-            m_vram[(chr_addr+4) & 0xFFFF], m_vram[(chr_addr+5) & 0xFFFF],
-            m_vram[(chr_addr+6) & 0xFFFF], m_vram[(chr_addr+7) & 0xFFFF]);
-        SNES_PPU_DEBUG("  color_index=%d (0x%02X)\n", color_index, color_index);
-        // Check for non-zero data in BG2 chr area
-        int nonzero = 0;
-        for (int i = 0; i < 0x2000; i++) {
-            if (m_vram[(chr_base + i) & 0xFFFF] != 0) nonzero++;
-        }
-        SNES_PPU_DEBUG("  Non-zero bytes in BG2 chr area ($%04X-$%04X): %d\n",
-            chr_base, chr_base + 0x1FFF, nonzero);
-
-        // Check key VRAM locations
-        SNES_PPU_DEBUG("  VRAM at $08000 (where graphics DMA went): %02X %02X %02X %02X %02X %02X %02X %02X\n",
-            m_vram[0x8000], m_vram[0x8001], m_vram[0x8002], m_vram[0x8003],
-            m_vram[0x8004], m_vram[0x8005], m_vram[0x8006], m_vram[0x8007]);
-        SNES_PPU_DEBUG("  VRAM at $0A000 (BG2 chr area): %02X %02X %02X %02X %02X %02X %02X %02X\n",
-            m_vram[0xA000], m_vram[0xA001], m_vram[0xA002], m_vram[0xA003],
-            m_vram[0xA004], m_vram[0xA005], m_vram[0xA006], m_vram[0xA007]);
-        // Count non-zero at each location
-        int nz_8000 = 0, nz_A000 = 0;
-        for (int i = 0; i < 0x2000; i++) {
-            if (m_vram[(0x8000 + i) & 0xFFFF] != 0) nz_8000++;
-            if (m_vram[(0xA000 + i) & 0xFFFF] != 0) nz_A000++;
-        }
-        SNES_PPU_DEBUG("  Non-zero: $08000-09FFF: %d bytes, $0A000-0BFFF: %d bytes\n", nz_8000, nz_A000);
-    }
-
-    // Calculate final pixel value (palette index into CGRAM)
-    // Mode 0: Each BG has its own 32-color region (8 palettes * 4 colors)
-    //   BG1: colors 0-31, BG2: colors 32-63, BG3: colors 64-95, BG4: colors 96-127
-    // Other modes: All BGs share the 128-color BG palette space (8 palettes * 16 colors for 4bpp)
-    if (color_index != 0) {
-        if (bpp == 8) {
-            // 8bpp: direct index into first 256 colors, no palette selection
-            pixel = color_index;
-        } else if (bpp == 2) {
-            // 2bpp: 4 colors per palette
-            // In Mode 0, each BG is offset by 32 colors (bg * 32 + palette * 4 + color)
-            int bg_offset = (m_bg_mode == 0) ? (bg * 32) : 0;
-            pixel = bg_offset + (palette << 2) + color_index;
-        } else {
-            // 4bpp: 16 colors per palette
-            pixel = (palette << 4) + color_index;
-        }
-    }
-}
+        uint16_t h_entry_addr = bg3_base + screen_offset + (opt_row * 32 + opt_col) * 2;
+        uint16_t h_entry = m_vram[h_entry_addr & 0xFFFF] | (m_vram[(h_entry_addr + 1) & 0xFFFF] << 8);
+        bool apply_h = (bg == 0 && (h_entry & 0x2000)) || (bg == 1 && (h_entry & 0x4000));
 
-void PPU::render_background_pixel(int bg, int x, uint8_t& pixel, uint8_t& priority, uint8_t& out_palette) {
-    // Wrapper that also returns the palette from tilemap
-    // This is needed for Direct Color mode which uses the palette bits differently
-    pixel = 0;
-    priority = 0;
-    out_palette = 0;
-
-    // Get scroll values
-    int scroll_x = m_bg_hofs[bg] & 0x3FF;
-    int scroll_y = m_bg_vofs[bg] & 0x3FF;
-
-    // Apply offset-per-tile for Modes 2, 4, 6 (same logic as primary function)
-    bool opt_mode = (m_bg_mode == 2 || m_bg_mode == 4 || m_bg_mode == 6);
-    if (opt_mode && (bg == 0 || bg == 1)) {
-        int screen_column = (x + (scroll_x & 7)) >> 3;
-        if (screen_column > 0 && screen_column <= 32) {
-            uint16_t bg3_base = m_bg_tilemap_addr[2];
-            int bg3_hofs = m_bg_hofs[2] & 0x3FF;
-            int bg3_vofs = m_bg_vofs[2] & 0x3FF;
-            int bg3_tile_size = m_bg_tile_size[2] ? 16 : 8;
-            int opt_column = screen_column - 1;
-            int opt_row = (bg3_vofs / bg3_tile_size) & 0x1F;
-            int opt_col = ((bg3_hofs / bg3_tile_size) + opt_column) & 0x1F;
-            int screen_offset = 0;
-            if (m_bg_tilemap_width[2] && opt_col >= 32) {
-                screen_offset = 0x800;
-                opt_col -= 32;
+        if (m_bg_mode == 4) {
+            if (!(h_entry & 0x8000) && apply_h) {
+                scroll_x = (h_entry & 0x3F8) | (hofs & 7);
+            } else if ((h_entry & 0x8000) && apply_h) {
+                scroll_y = h_entry & 0x3FF;
             }
-            uint16_t h_entry_addr = bg3_base + screen_offset + (opt_row * 32 + opt_col) * 2;
-            uint8_t h_lo = m_vram[h_entry_addr & 0xFFFF];
-            uint8_t h_hi = m_vram[(h_entry_addr + 1) & 0xFFFF];
-            uint16_t h_entry = h_lo | (h_hi << 8);
-            bool apply_h = (bg == 0 && (h_entry & 0x2000)) || (bg == 1 && (h_entry & 0x4000));
-            if (m_bg_mode == 4) {
-                if (!(h_entry & 0x8000) && apply_h) {
-                    scroll_x = (h_entry & 0x3F8) | (scroll_x & 7);
-                } else if ((h_entry & 0x8000) && apply_h) {
-                    scroll_y = h_entry & 0x3FF;
-                }
-            } else {
-                if (apply_h) {
-                    scroll_x = (h_entry & 0x3F8) | (scroll_x & 7);
-                }
-                uint16_t v_entry_addr = h_entry_addr + 64;
-                uint8_t v_lo = m_vram[v_entry_addr & 0xFFFF];
-                uint8_t v_hi = m_vram[(v_entry_addr + 1) & 0xFFFF];
-                uint16_t v_entry = v_lo | (v_hi << 8);
-                bool apply_v = (bg == 0 && (v_entry & 0x2000)) || (bg == 1 && (v_entry & 0x4000));
-                if (apply_v) {
-                    scroll_y = v_entry & 0x3FF;
-                }
+        } else {
+            if (apply_h) {
+                scroll_x = (h_entry & 0x3F8) | (hofs & 7);
             }
-        }
-    }
-
-    // Apply mosaic
-    int mosaic_x = x;
-    int mosaic_y = m_scanline - 1;
-    if (m_mosaic_enabled[bg] && m_mosaic_size > 1) {
-        mosaic_x = (mosaic_x / m_mosaic_size) * m_mosaic_size;
-        mosaic_y = (mosaic_y / m_mosaic_size) * m_mosaic_size;
-    }
-
-    // Calculate pixel position in BG
-    int px = (mosaic_x + scroll_x) & 0x3FF;
-    int py = (mosaic_y + scroll_y) & 0x3FF;
 
-    // Get tile size (see main render_background_pixel for detailed comments)
-    bool is_hires_mode = (m_bg_mode == 5 || m_bg_mode == 6);
-    int tile_width = is_hires_mode ? 16 : (m_bg_tile_size[bg] ? 16 : 8);
-    int tile_height = m_bg_tile_size[bg] ? 16 : 8;
-
-    // Calculate tile coordinates
-    int tile_x = px / tile_width;
-    int tile_y = py / tile_height;
-    int fine_x = px % tile_width;
-    int fine_y = py % tile_height;
-
-    // Get tilemap address
-    uint16_t tilemap_base = m_bg_tilemap_addr[bg];
-    int tilemap_width = m_bg_tilemap_width[bg] ? 64 : 32;
-    int tilemap_height = m_bg_tilemap_height[bg] ? 64 : 32;
-
-    // Handle tilemap wrapping
-    int tilemap_x = tile_x % tilemap_width;
-    int tilemap_y = tile_y % tilemap_height;
-
-    // Calculate screen offset for 64-wide/tall tilemaps
-    int screen_offset = 0;
-    if (tilemap_width == 64 && tilemap_x >= 32) {
-        screen_offset += 0x800;
-        tilemap_x -= 32;
-    }
-    if (tilemap_height == 64 && tilemap_y >= 32) {
-        screen_offset += tilemap_width == 64 ? 0x1000 : 0x800;
-        tilemap_y -= 32;
-    }
-
-    // Get tilemap entry
-    uint16_t tilemap_addr = tilemap_base + screen_offset + (tilemap_y * 32 + tilemap_x) * 2;
-    uint8_t tile_lo = m_vram[tilemap_addr & 0xFFFF];
-    uint8_t tile_hi = m_vram[(tilemap_addr + 1) & 0xFFFF];
-
-    int tile_num = tile_lo | ((tile_hi & 0x03) << 8);
-    int palette = (tile_hi >> 2) & 0x07;
-    priority = (tile_hi >> 5) & 0x01;
-    bool hflip = (tile_hi & 0x40) != 0;
-    bool vflip = (tile_hi & 0x80) != 0;
-
-    // Output the palette for Direct Color mode
-    out_palette = palette;
-
-    // Handle large tiles (see main render_background_pixel for detailed comments)
-    int x_offset = 0;
-    int y_offset = 0;
-
-    if (tile_width == 16) {
-        x_offset = (fine_x >= 8) ? 1 : 0;
-        if (hflip) x_offset = 1 - x_offset;
-        fine_x &= 7;
-    }
-
-    if (tile_height == 16) {
-        y_offset = (fine_y >= 8) ? 16 : 0;
-        if (vflip) y_offset = (y_offset == 16) ? 0 : 16;
-        fine_y &= 7;
-    }
-
-    tile_num += x_offset + y_offset;
-
-    // Apply flip to fine coordinates (within 8x8 sub-tile)
-    if (hflip) fine_x = 7 - fine_x;
-    if (vflip) fine_y = 7 - fine_y;
-
-    // Get bits per pixel
-    int bpp;
-    switch (m_bg_mode) {
-        case 0: bpp = 2; break;
-        case 1: bpp = (bg < 2) ? 4 : 2; break;
-        case 2: bpp = 4; break;
-        case 3: bpp = (bg == 0) ? 8 : 4; break;
-        case 4: bpp = (bg == 0) ? 8 : 2; break;
-        case 5: bpp = 4; break;
-        case 6: bpp = 4; break;
-        default: bpp = 8; break;
-    }
-
-    // Get character data address
-    uint16_t chr_base = m_bg_chr_addr[bg];
-    uint16_t chr_addr = chr_base + tile_num * (bpp * 8);
-
-    // Read tile data
-    uint8_t color_index = 0;
-    for (int bit = 0; bit < bpp; bit++) {
-        int plane_offset = (bit / 2) * 16 + (bit & 1);
-        uint16_t addr = chr_addr + fine_y * 2 + plane_offset;
-        uint8_t plane = m_vram[addr & 0xFFFF];
-        if (plane & (0x80 >> fine_x)) {
-            color_index |= (1 << bit);
+            // Vertical offset entry is one row (32 entries = 64 bytes) later
+            uint16_t v_entry_addr = h_entry_addr + 64;
+            uint16_t v_entry = m_vram[v_entry_addr & 0xFFFF] | (m_vram[(v_entry_addr + 1) & 0xFFFF] << 8);
+            bool apply_v = (bg == 0 && (v_entry & 0x2000)) || (bg == 1 && (v_entry & 0x4000));
+            if (apply_v) {
+                scroll_y = v_entry & 0x3FF;
+            }
         }
-    }
+    };
 
-    // For 8bpp, return raw color index (for Direct Color mode)
-    // For other BPP, compute full CGRAM index
-    if (color_index != 0) {
-        if (bpp == 8) {
-            pixel = color_index;
-        } else if (bpp == 2) {
-            int bg_offset = (m_bg_mode == 0) ? (bg * 32) : 0;
-            pixel = bg_offset + (palette << 2) + color_index;
-        } else {
-            pixel = (palette << 4) + color_index;
+    for (int x = start_x; x < end_x; x++) {
+        if (opt_mode) {
+            int screen_column = (x + (hofs & 7)) >> 3;
+            if (screen_column != opt_column) {
+                opt_column = screen_column;
+                apply_offset_per_tile(screen_column);
+            }
         }
-    }
-}
-
-// Hi-res mode background pixel rendering (Mode 5/6)
-// ============================================================================
-// Reference: bsnes/ares background.cpp fetchNameTable()
-//
-// In Mode 5/6, tiles are always 16 pixels wide in hi-res coordinate space.
-// The 16 pixels are split between main and sub screens:
-//   - Even pixels (0,2,4,6,8,10,12,14) go to sub screen
-//   - Odd pixels (1,3,5,7,9,11,13,15) go to main screen
-//
-// The output to the TV interleaves: column 0=sub, column 1=main, column 2=sub, etc.
-//
-// Scroll handling in hi-res modes (from bsnes):
-//   hpixel = x << hires()      // screen x is doubled
-//   hscroll = io.hoffset
-//   if(hires()) hscroll <<= 1  // scroll is also doubled
-//   hoffset = hpixel + hscroll
-//
-// This means BOTH the pixel position AND the scroll value are doubled.
-// ============================================================================
-void PPU::render_background_pixel(int bg, int x, uint8_t& pixel, uint8_t& priority,
-                                   bool hires_mode, bool hires_odd_pixel) {
-    pixel = 0;
-    priority = 0;
-
-    // Get scroll values
-    // Reference: bsnes - in hi-res mode, scroll is doubled (hscroll <<= 1)
-    int scroll_x = m_bg_hofs[bg] & 0x3FF;
-    int scroll_y = m_bg_vofs[bg] & 0x3FF;
-
-    // In hi-res mode, scroll is doubled to match the doubled coordinate space
-    if (hires_mode) {
-        scroll_x <<= 1;
-    }
-
-    // Apply mosaic
-    int mosaic_x = x;
-    int mosaic_y = m_scanline - 1;
-    if (m_mosaic_enabled[bg] && m_mosaic_size > 1) {
-        mosaic_x = (mosaic_x / m_mosaic_size) * m_mosaic_size;
-        mosaic_y = (mosaic_y / m_mosaic_size) * m_mosaic_size;
-    }
-
-    // In hi-res mode (Mode 5/6), each screen X (0-255) maps to 2 hi-res pixels (0-511)
-    // Main screen gets odd pixels (1,3,5...), sub screen gets even pixels (0,2,4...)
-    // So screen X=0 -> hires 0/1, screen X=1 -> hires 2/3, etc.
-    // Reference: bsnes - hpixel = x << hires() (i.e., x * 2 when in hi-res)
-    int hires_x = mosaic_x;
-    if (hires_mode) {
-        // Convert to 512-pixel hi-res space
-        // Add 1 for odd pixel (main screen), 0 for even pixel (sub screen)
-        hires_x = mosaic_x * 2 + (hires_odd_pixel ? 1 : 0);
-    }
-
-    // Calculate pixel position in BG (now in correct coordinate space)
-    // Both hires_x and scroll_x are in the doubled coordinate space for Mode 5/6
-    int px = (hires_x + scroll_x) & 0x3FF;
-    int py = (mosaic_y + scroll_y) & 0x3FF;
-
-    // In hi-res mode (Mode 5/6), tiles are always 16 pixels wide
-    int tile_width = 16;  // Always 16 in hi-res modes
-    int tile_height = m_bg_tile_size[bg] ? 16 : 8;
-
-    // Calculate tile coordinates
-    int tile_x = px / tile_width;
-    int tile_y = py / tile_height;
-    int fine_x = px % tile_width;
-    int fine_y = py % tile_height;
-
-    // Get tilemap address
-    uint16_t tilemap_base = m_bg_tilemap_addr[bg];
-    int tilemap_width = m_bg_tilemap_width[bg] ? 64 : 32;
-    int tilemap_height = m_bg_tilemap_height[bg] ? 64 : 32;
-
-    // Handle tilemap wrapping
-    int tilemap_x = tile_x % tilemap_width;
-    int tilemap_y = tile_y % tilemap_height;
-
-    // Calculate screen offset for 64-wide/tall tilemaps
-    int screen_offset = 0;
-    if (tilemap_width == 64 && tilemap_x >= 32) {
-        screen_offset += 0x800;
-        tilemap_x -= 32;
-    }
-    if (tilemap_height == 64 && tilemap_y >= 32) {
-        screen_offset += tilemap_width == 64 ? 0x1000 : 0x800;
-        tilemap_y -= 32;
-    }
 
-    // Get tilemap entry
-    uint16_t tilemap_addr = tilemap_base + screen_offset + (tilemap_y * 32 + tilemap_x) * 2;
-    uint8_t tile_lo = m_vram[tilemap_addr & 0xFFFF];
-    uint8_t tile_hi = m_vram[(tilemap_addr + 1) & 0xFFFF];
-
-    int tile_num = tile_lo | ((tile_hi & 0x03) << 8);
-    int palette = (tile_hi >> 2) & 0x07;
-    priority = (tile_hi >> 5) & 0x01;
-    bool hflip = (tile_hi & 0x40) != 0;
-    bool vflip = (tile_hi & 0x80) != 0;
-
-    // Handle large tiles (16-pixel wide tiles are composed of two 8x8 tiles)
-    int x_offset = 0;
-    int y_offset = 0;
-
-    if (tile_width == 16) {
-        x_offset = (fine_x >= 8) ? 1 : 0;
-        if (hflip) x_offset = 1 - x_offset;
-        fine_x &= 7;
+        int mosaic_x = mosaic ? (x / m_mosaic_size) * m_mosaic_size : x;
+        int py = (mosaic_y + scroll_y) & 0x3FF;
+        fetch((mosaic_x + scroll_x) & 0x3FF, py, line.pixel[x], line.priority[x], line.palette[x]);
     }
+}
 
-    if (tile_height == 16) {
-        y_offset = (fine_y >= 8) ? 16 : 0;
-        if (vflip) y_offset = (y_offset == 16) ? 0 : 16;
-        fine_y &= 7;
+void PPU::build_sprite_line(int start_x, int end_x) {
+    for (int x = start_x; x < end_x; x++) {
+        m_obj_line.pixel[x] = 0;
+        m_obj_line.priority[x] = 0;
+        m_obj_line.palette_4_7[x] = false;
     }
 
-    tile_num += x_offset + y_offset;
-
-    // Apply flip to fine coordinates (within 8x8 sub-tile)
-    if (hflip) fine_x = 7 - fine_x;
-    if (vflip) fine_y = 7 - fine_y;
-
-    // Mode 5/6: BG1 is 4bpp, BG2 is 2bpp
-    int bpp = (bg == 0) ? 4 : 2;
+    // Tiles were added in reverse OAM order (high index first). On SNES a
+    // lower OAM index has higher priority, so walking the list forward and
+    // letting later opaque pixels overwrite leaves the lowest index on top.
+    for (int i = 0; i < m_sprite_tile_count; i++) {
+        const auto& tile = m_sprite_tiles[i];
+        int left = std::max(start_x, tile.x);
+        int right = std::min(end_x, tile.x + 8);
 
-    // Get character data address
-    uint16_t chr_base = m_bg_chr_addr[bg];
-    uint16_t chr_addr = chr_base + tile_num * (bpp * 8);
-
-    // Read tile data using SNES bitplane format
-    uint8_t color_index = 0;
-    for (int bit = 0; bit < bpp; bit++) {
-        int plane_offset = (bit / 2) * 16 + (bit & 1);
-        uint16_t addr = chr_addr + fine_y * 2 + plane_offset;
-        uint8_t plane = m_vram[addr & 0xFFFF];
-        if (plane & (0x80 >> fine_x)) {
-            color_index |= (1 << bit);
-        }
-    }
+        for (int x = left; x < right; x++) {
+            int fine_x = x - tile.x;
+            if (tile.hflip) fine_x = 7 - fine_x;
+            uint8_t color_index = tile.pixels[fine_x];
 
-    // Compute CGRAM index
-    // BG1 (4bpp): 16 colors per palette
-    // BG2 (2bpp): 4 colors per palette
-    if (color_index != 0) {
-        if (bg == 0) {
-            // 4bpp: palette * 16 + color_index
-            pixel = (palette << 4) + color_index;
-        } else {
-            // 2bpp: palette * 4 + color_index
-            pixel = (palette << 2) + color_index;
+            // Color index 0 is transparent; sprite colors use CGRAM 128-255
+            if (color_index != 0) {
+                m_obj_line.pixel[x] = 128 + tile.palette * 16 + color_index;
+                m_obj_line.priority[x] = tile.priority;
+                m_obj_line.palette_4_7[x] = tile.palette >= 4;
+            }
         }
     }
 }
 
-void PPU::render_mode7_pixel(int x, uint8_t& pixel, uint8_t& priority) {
-    pixel = 0;
-    priority = 0;
+void PPU::build_mode7_line(int start_x, int end_x) {
+    BgLine& line = m_bg_line[0];
 
-    int screen_x = x;
     int screen_y = m_scanline - 1;
 
-    // Apply horizontal flip
-    if (m_m7_hflip) {
-        screen_x = 255 - screen_x;
-    }
-
     // Apply vertical flip
     if (m_m7_vflip) {
         screen_y = 255 - screen_y;
@@ -2300,6 +1925,12 @@ void PPU::render_mode7_pixel(int x, uint8_t& pixel, uint8_t& priority) {
     // CenterX/CenterY (M7X/M7Y) are 13-bit signed values
     //
     // The result is 10-bit coordinates (0-1023 range for 128x8 = 1024 pixel space)
+    //
+    // Everything but ScreenX is fixed for the line, so the 8.8 sums are set
+    // up once at screen X 0 and advance by A and C per pixel (negated under
+    // horizontal flip). The shift happens after the sum, exactly as in the
+    // full formula. Matrix writes mid-line mark the line buffers dirty, and
+    // the remaining dots are then built one at a time with the new values.
     // ========================================================================
 
     // Sign-extend 13-bit values to 32-bit
@@ -2309,132 +1940,94 @@ void PPU::render_mode7_pixel(int x, uint8_t& pixel, uint8_t& priority) {
     int32_t cx = (static_cast<int16_t>(m_m7x << 3)) >> 3;
     int32_t cy = (static_cast<int16_t>(m_m7y << 3)) >> 3;
 
-    // Calculate input coordinates (screen position + scroll - center)
-    int32_t px = screen_x + hofs - cx;
+    // Input coordinates at screen X 0 (screen position + scroll - center)
+    int32_t px0 = (m_m7_hflip ? 255 : 0) + hofs - cx;
     int32_t py = screen_y + vofs - cy;
 
-    // Apply matrix transformation
-    // A/B/C/D are 16-bit signed with 8 fractional bits (1.7.8 format)
-    // Multiply, then add center (in 8.8 format), then shift down
-    int32_t tx = ((static_cast<int16_t>(m_m7a) * px) +
-                  (static_cast<int16_t>(m_m7b) * py) + (cx << 8)) >> 8;
-    int32_t ty = ((static_cast<int16_t>(m_m7c) * px) +
-                  (static_cast<int16_t>(m_m7d) * py) + (cy << 8)) >> 8;
-
-    // Handle wrapping/clamping
-    bool out_of_bounds = (tx < 0 || tx >= 1024 || ty < 0 || ty >= 1024);
-
-    if (out_of_bounds) {
-        switch (m_m7_wrap) {
-            case 0:  // Wrap
-                tx &= 0x3FF;
-                ty &= 0x3FF;
-                break;
-            case 1:  // Transparent
-                return;
-            case 2:  // Tile 0
-            case 3:
-                tx = 0;
-                ty = 0;
-                break;
+    int32_t a = m_m7a;
+    int32_t c = m_m7c;
+    int32_t origin_x = a * px0 + m_m7b * py + (cx << 8);
+    int32_t origin_y = c * px0 + m_m7d * py + (cy << 8);
+    int32_t step_x = m_m7_hflip ? -a : a;
+    int32_t step_y = m_m7_hflip ? -c : c;
+
+    // Transform the span first; this loop has no branches or memory
+    // dependencies and vectorizes
+    int32_t tx_line[SCREEN_WIDTH];
+    int32_t ty_line[SCREEN_WIDTH];
+    for (int x = start_x; x < end_x; x++) {
+        tx_line[x] = (origin_x + step_x * x) >> 8;
+        ty_line[x] = (origin_y + step_y * x) >> 8;
+    }
+
+    for (int x = start_x; x < end_x; x++) {
+        int32_t tx = tx_line[x];
+        int32_t ty = ty_line[x];
+        line.pixel[x] = 0;
+        line.priority[x] = 0;  // Mode 7 BG has no priority bit
+        line.palette[x] = 0;
+
+        // Handle wrapping/clamping
+        bool out_of_bounds = (tx < 0 || tx >= 1024 || ty < 0 || ty >= 1024);
+
+        if (out_of_bounds) {
+            switch (m_m7_wrap) {
+                case 0:  // Wrap
+                    tx &= 0x3FF;
+                    ty &= 0x3FF;
+                    break;
+                case 1:  // Transparent
+                    continue;
+                case 2:  // Tile 0
+                case 3:
+                    tx = 0;
+                    ty = 0;
+                    break;
+            }
         }
-    }
 
-    // Mode 7 VRAM layout (128x128 tilemap, 8bpp character data):
-    // - VRAM is word-addressed in hardware, we use byte addressing
-    // - Even bytes contain tile numbers (tilemap)
-    // - Odd bytes contain pixel colors (character data)
-    // Reference: bsnes/sfc/ppu-fast/mode7.cpp
-    int tile_x = (tx >> 3) & 127;
-    int tile_y = (ty >> 3) & 127;
-    int fine_x = tx & 7;
-    int fine_y = ty & 7;
-
-    // Tile address: tileY * 128 + tileX (word address), *2 for byte address
-    uint16_t tile_addr = (tile_y * 128 + tile_x) * 2;
-    uint8_t tile_num = m_vram[tile_addr & 0xFFFF];
-
-    // Palette address: tile * 64 + fine_y * 8 + fine_x (word address)
-    // Each tile is 64 words (8x8 pixels), fine_y * 8 + fine_x gives offset within tile
-    uint16_t palette_addr = ((tile_num << 6) | (fine_y << 3) | fine_x) * 2 + 1;
-    uint8_t color_index = m_vram[palette_addr & 0xFFFF];
-
-    if (color_index != 0) {
-        pixel = color_index;
-        priority = 0;  // Mode 7 BG has no priority bit
+        // Mode 7 VRAM layout (128x128 tilemap, 8bpp character data):
+        // - VRAM is word-addressed in hardware, we use byte addressing
+        // - Even bytes contain tile numbers (tilemap)
+        // - Odd bytes contain pixel colors (character data)
+        // Reference: bsnes/sfc/ppu-fast/mode7.cpp
+        int tile_x = (tx >> 3) & 127;
+        int tile_y = (ty >> 3) & 127;
+        int fine_x = tx & 7;
+        int fine_y = ty & 7;
+
+        // Tile address: tileY * 128 + tileX (word address), *2 for byte address
+        uint16_t tile_addr = (tile_y * 128 + tile_x) * 2;
+        uint8_t tile_num = m_vram[tile_addr & 0xFFFF];
+
+        // Palette address: tile * 64 + fine_y * 8 + fine_x (word address)
+        // Each tile is 64 words (8x8 pixels), fine_y * 8 + fine_x gives offset within tile
+        uint16_t palette_addr = ((tile_num << 6) | (fine_y << 3) | fine_x) * 2 + 1;
+        line.pixel[x] = m_vram[palette_addr & 0xFFFF];
     }
 }
 
-void PPU::render_sprite_pixel(int x, uint8_t& pixel, uint8_t& priority, bool& is_palette_4_7) {
-    pixel = 0;
-    priority = 0;
-    is_palette_4_7 = false;
-
-    bool debug_render = is_debug_mode() && m_frame == 200 && m_scanline == 86 && (x == 96 || x == 128);
-
-    if (debug_render) {
-        SNES_PPU_DEBUG("render_sprite_pixel x=%d: tile_count=%d\n", x, m_sprite_tile_count);
-        for (int j = 0; j < m_sprite_tile_count; j++) {
-            SNES_PPU_DEBUG("  m_sprite_tiles[%d].x = %d\n", j, m_sprite_tiles[j].x);
-        }
-    }
-
-    // Search through sprite tiles for this X position
-    // Tiles were added in reverse OAM order (high index first), so we search
-    // from the END to find the lowest OAM index (highest sprite priority) first.
-    // On SNES, lower OAM index = higher priority (sprite 0 appears on top).
-    for (int i = m_sprite_tile_count - 1; i >= 0; i--) {
-        const auto& tile = m_sprite_tiles[i];
-
-        if (debug_render && i == 6) {
-            SNES_PPU_DEBUG("  checking i=6: tile.x=%d, condition=%d\n",
-                tile.x, (x >= tile.x && x < tile.x + 8) ? 1 : 0);
-        }
-
-        // Check if this tile covers the current X position
-        if (x >= tile.x && x < tile.x + 8) {
-            int fine_x = x - tile.x;
-            if (tile.hflip) fine_x = 7 - fine_x;
-
-            // Decode 4bpp pixel from the cached pattern data
-            // Each plane is a byte with 8 pixels (MSB = leftmost)
-            uint8_t mask = 0x80 >> fine_x;
-            uint8_t color_index = 0;
-
-            // Combine the 4 bitplanes into a 4-bit color index
-            if (tile.planes[0] & mask) color_index |= 0x01;
-            if (tile.planes[1] & mask) color_index |= 0x02;
-            if (tile.planes[2] & mask) color_index |= 0x04;
-            if (tile.planes[3] & mask) color_index |= 0x08;
-
-            if (debug_render) {
-                SNES_PPU_DEBUG("  tile[%d] x=%d fine=%d mask=%02X planes=[%02X,%02X,%02X,%02X] -> color=%d\n",
-                    i, tile.x, fine_x, mask, tile.planes[0], tile.planes[1], tile.planes[2], tile.planes[3], color_index);
-            }
-
-            // Color index 0 is transparent for sprites
-            if (color_index != 0) {
-                // Sprite colors use CGRAM 128-255 (second half of palette)
-                // 8 palettes of 16 colors each
-                pixel = 128 + tile.palette * 16 + color_index;
-                priority = tile.priority;
-                is_palette_4_7 = tile.palette >= 4;
-
-                if (debug_render) {
-                    uint16_t cgram_color = m_cgram[pixel * 2] | (m_cgram[pixel * 2 + 1] << 8);
-                    SNES_PPU_DEBUG("  -> pixel=%d (pal=%d idx=%d) cgram=$%04X\n",
-                        pixel, tile.palette, color_index, cgram_color);
-                }
-
-                return;
-            }
+// Index the lines each sprite covers, with the heights of OBSEL size set
+// size_index: line l holds the sprites with (l - y) & 0xFF < height
+void PPU::build_sprite_lines(int size_index) {
+    for (auto& line : m_sprite_lines) {
+        line.fill(0);
+    }
+    for (int i = 0; i < 128; i++) {
+        int y = m_oam[i * 4 + 1];
+        bool large = ((m_oam[512 + i / 4] >> ((i % 4) * 2)) & 0x02) != 0;
+        int height = SPRITE_SIZES[size_index][large ? 1 : 0][1];
+        for (int row = 0; row < height; row++) {
+            m_sprite_lines[(y + row) & 0xFF][i / 64] |= uint64_t(1) << (i % 64);
         }
     }
+    m_sprite_lines_size = size_index;
 }
 
 void PPU::evaluate_sprites() {
     m_sprite_count = 0;
     m_sprite_tile_count = 0;
+    m_line_buffer_dirty = true;
     m_time_over = false;
     m_range_over = false;
 
@@ -2457,8 +2050,22 @@ void PPU::evaluate_sprites() {
     int large_width = SPRITE_SIZES[size_index][1][0];
     int large_height = SPRITE_SIZES[size_index][1][1];
 
-    // Scan all 128 sprites
-    for (int i = 0; i < 128 && m_sprite_count < 32; i++) {
+    // Scan the sprites the line index has in range, in OAM order
+    if (m_sprite_lines_size != size_index) {
+        build_sprite_lines(size_index);
+    }
+    uint64_t in_range_lo = m_sprite_lines[screen_y & 0xFF][0];
+    uint64_t in_range_hi = m_sprite_lines[screen_y & 0xFF][1];
+    while ((in_range_lo | in_range_hi) && m_sprite_count < 32) {
+        int i;
+        if (in_range_lo) {
+            i = __builtin_ctzll(in_range_lo);
+            in_range_lo &= in_range_lo - 1;
+        } else {
+            i = 64 + __builtin_ctzll(in_range_hi);
+            in_range_hi &= in_range_hi - 1;
+        }
+
         // Read OAM entry
         int oam_addr = i * 4;
         int x = m_oam[oam_addr];
@@ -2496,10 +2103,8 @@ void PPU::evaluate_sprites() {
         // Reference: SNESdev Wiki - "sprites appear 1 line lower than their Y value,
         // however because the first line of rendering is always hidden on SNES, a
         // sprite with Y=0 will appear to begin on the first visible line."
+        // build_sprite_lines() applies the same 8-bit wrapped range test
         int sprite_y = y;
-        int offset_y = (screen_y - sprite_y) & 0xFF;  // 8-bit wrap
-
-        if (offset_y >= height) continue;
 
         // Sprite is on this scanline
         SpriteEntry entry;
@@ -2585,23 +2190,18 @@ void PPU::evaluate_sprites() {
 
             SpriteTile tile_entry;
             tile_entry.x = screen_x;
-            // Read 4bpp tile data (2 words = 4 bytes for planes 0-3 at this row)
+            // Latch the 4bpp row now, as the hardware does during the tile fetch
             // bsnes: tile.data = vram[address + 0] << 0 | vram[address + 8] << 16
-            // vram entries are 16-bit words containing planes 0+1 and planes 2+3
-            // Low word at address+0: plane0 (low byte) + plane1 (high byte)
-            // High word at address+8: plane2 (low byte) + plane3 (high byte)
-            tile_entry.planes[0] = m_vram[byte_addr];               // Plane 0
-            tile_entry.planes[1] = m_vram[(byte_addr + 1) & 0xFFFF]; // Plane 1
-            tile_entry.planes[2] = m_vram[(byte_addr + 16) & 0xFFFF]; // Plane 2 (word offset 8 = byte offset 16)
-            tile_entry.planes[3] = m_vram[(byte_addr + 17) & 0xFFFF]; // Plane 3
+            // The address is 16-word aligned plus the row, so it indexes the
+            // decoded tile cache directly
+            std::memcpy(tile_entry.pixels, get_decoded_tile_row(4, byte_addr), 8);
             tile_entry.palette = sprite.palette;
             tile_entry.priority = sprite.priority;
             tile_entry.hflip = sprite.hflip;
 
             if (debug_sprites && m_sprite_tile_count < 8) {
-                SNES_PPU_DEBUG("  Tile[%d]: spr=%d x=%d tile=$%03X addr=$%04X byte=$%04X planes=[%02X,%02X,%02X,%02X]\n",
-                    m_sprite_tile_count, i, screen_x, sprite.tile, address, byte_addr,
-                    tile_entry.planes[0], tile_entry.planes[1], tile_entry.planes[2], tile_entry.planes[3]);
+                SNES_PPU_DEBUG("  Tile[%d]: spr=%d x=%d tile=$%03X addr=$%04X byte=$%04X\n",
+                    m_sprite_tile_count, i, screen_x, sprite.tile, address, byte_addr);
             }
 
             m_sprite_tiles[m_sprite_tile_count++] = tile_entry;
@@ -2621,6 +2221,22 @@ void PPU::evaluate_sprites() {
     }
 }
 
+// 8-bit output of each 5-bit channel value at the current INIDISP
+// brightness, rebuilt whenever it changes
+// Reference: bsnes/sfc/ppu/ppu.cpp lightTable generation
+// Formula: luma = brightness / 15.0; output = round(input * luma)
+// This matches hardware behavior where brightness 15 = full, 0 = black
+void PPU::update_brightness_levels() {
+    for (int value = 0; value < 32; value++) {
+        // Apply brightness with rounding (matching bsnes: (input * brightness + 7) / 15)
+        int level = std::min((value * m_brightness + 7) / 15, 31);
+
+        // Convert 5-bit color to 8-bit, replicating the high bits into the
+        // low bits for the full 8-bit range
+        m_brightness_levels[value] = static_cast<uint8_t>((level << 3) | (level >> 2));
+    }
+}
+
 uint16_t PPU::get_color(uint8_t palette, uint8_t index, bool sprite) {
     // ============================================================================
     // CGRAM COLOR LOOKUP
@@ -2738,6 +2354,109 @@ uint16_t PPU::remap_vram_address(uint16_t addr) const {
     }
 }
 
+// ============================================================================
+// DECODED TILE CACHE
+// ============================================================================
+// SNES tiles store pixels as interleaved bitplanes: planes are grouped in
+// pairs, each pair 16 bytes (8 rows * 2 bytes), so a 2bpp tile is 16 bytes,
+// 4bpp 32 and 8bpp 64. All VRAM writes (CPU and DMA, after VMAIN address
+// remapping) go through write_vram_byte(), which flags every tile covering
+// the byte at each depth. Readers get a whole decoded 8-pixel row.
+// ============================================================================
+void PPU::write_vram_byte(uint16_t byte_addr, uint8_t value) {
+    m_vram[byte_addr] = value;
+    m_line_buffer_dirty = true;
+    m_tile_cache[0].dirty[byte_addr >> 4] = 1;
+    m_tile_cache[1].dirty[byte_addr >> 5] = 1;
+    m_tile_cache[2].dirty[byte_addr >> 6] = 1;
+    if (m_worker) mark_dirty(byte_addr / DIRTY_BLOCK_SIZE);
+}
+
+void PPU::write_vmdata(bool high_byte, uint8_t value) {
+    // Apply VRAM address remapping based on VMAIN bits 2-3
+    // This remapping is used for efficient tile data DMA
+    // Reference: fullsnes, bsnes/snes9x VMAIN documentation
+    uint16_t addr = remap_vram_address(m_vram_addr);
+    write_vram_byte((addr * 2 + (high_byte ? 1 : 0)) & 0xFFFF, value);
+    if (high_byte == m_vram_increment_high) {
+        m_vram_addr += m_vram_increment;
+    }
+}
+
+void PPU::write_oamdata(uint8_t value) {
+    // OAM is 544 bytes: 512 bytes for 128 sprites (4 bytes each) + 32 high bytes
+    // Reference: bsnes/ares io.cpp OAMDATA handler
+    // Address increments after EVERY write, latch bit is address bit 0
+    bool latch_bit = (m_oam_addr & 1) != 0;
+    uint16_t address = m_oam_addr;
+    m_oam_addr = (m_oam_addr + 1) & 0x3FF;  // Increment BEFORE the write logic
+
+    if ((address & 0x200) != 0) {
+        // High OAM (addresses 512-543): direct byte writes, bypass latch
+        m_oam[0x200 + (address & 0x1F)] = value;
+        m_sprite_lines_size = -1;
+    } else {
+        // Low OAM (addresses 0-511): word-based writes
+        if (!latch_bit) {
+            // Even address: just latch the byte
+            m_oam_latch = value;
+        } else {
+            // Odd address: write both bytes to the word-aligned address
+            uint16_t word_addr = address & 0x1FE;
+            m_oam[word_addr] = m_oam_latch;      // Low byte (latched)
+            m_oam[word_addr + 1] = value;        // High byte (current)
+            m_sprite_lines_size = -1;
+        }
+    }
+}
+
+void PPU::invalidate_tile_cache() {
+    for (auto& cache : m_tile_cache) {
+        std::fill(cache.dirty.begin(), cache.dirty.end(), 1);
+    }
+}
+
+void PPU::invalidate_vram_block(int block) {
+    for (int depth = 0; depth < 3; depth++) {
+        int tiles = DIRTY_BLOCK_SIZE >> (4 + depth);
+        auto first = m_tile_cache[depth].dirty.begin() + block * tiles;
+        std::fill(first, first + tiles, 1);
+    }
+    m_line_buffer_dirty = true;
+}
+
+const uint8_t* PPU::get_decoded_tile_row(int bpp, uint16_t row_addr) {
+    // Tiles are aligned to their own size, so the byte address splits into
+    // tile index and row (2 bytes per row within each plane pair)
+    int depth = (bpp == 2) ? 0 : (bpp == 4) ? 1 : 2;
+    int tile_shift = 4 + depth;
+    int tile = row_addr >> tile_shift;
+    int fine_y = (row_addr >> 1) & 7;
+
+    TileCache& cache = m_tile_cache[depth];
+    uint8_t* pixels = &cache.pixels[tile * 64];
+    if (cache.dirty[tile]) {
+        cache.dirty[tile] = 0;
+        uint16_t tile_addr = tile << tile_shift;
+        for (int y = 0; y < 8; y++) {
+            uint8_t planes[8];
+            for (int bit = 0; bit < bpp; bit++) {
+                planes[bit] = m_vram[tile_addr + y * 2 + (bit / 2) * 16 + (bit & 1)];
+            }
+            for (int x = 0; x < 8; x++) {
+                uint8_t color_index = 0;
+                for (int bit = 0; bit < bpp; bit++) {
+                    if (planes[bit] & (0x80 >> x)) {
+                        color_index |= (1 << bit);
+                    }
+                }
+                pixels[y * 8 + x] = color_index;
+            }
+        }
+    }
+    return pixels + fine_y * 8;
+}
+
 bool PPU::check_frame_complete() {
     bool complete = m_frame_complete;
     m_frame_complete = false;
@@ -2873,6 +2592,16 @@ void PPU::write(uint16_t address, uint8_t value) {
     // Reference: Mesen-S, bsnes - both sync PPU state before register writes
     // ========================================================================
     sync_to_current();
+    if (m_worker) flush_span();
+
+    // BGMODE through the Mode 7 registers feed the scanline layer buffers
+    if (address >= 0x2105 && address <= 0x2120) {
+        m_line_buffer_dirty = true;
+    }
+    // W12SEL through WOBJLOG feed the window masks
+    if (address >= 0x2123 && address <= 0x212B) {
+        m_window_dirty = true;
+    }
 
     // Debug key PPU registers
     if (address == 0x2100 || address == 0x2105 || address == 0x212C || address == 0x212D) {
@@ -2886,6 +2615,7 @@ void PPU::write(uint16_t address, uint8_t value) {
             bool old_force_blank = m_force_blank;
             m_force_blank = (value & 0x80) != 0;
             m_brightness = value & 0x0F;
+            update_brightness_levels();
 
             // ================================================================
             // HBlank Force Blank Detection for Sprite Tile Fetch
@@ -2944,31 +2674,9 @@ void PPU::write(uint16_t address, uint8_t value) {
             m_oam_high_byte = false;
             break;
 
-        case 0x2104: {  // OAMDATA
-            // OAM is 544 bytes: 512 bytes for 128 sprites (4 bytes each) + 32 high bytes
-            // Reference: bsnes/ares io.cpp OAMDATA handler
-            // Address increments after EVERY write, latch bit is address bit 0
-            bool latch_bit = (m_oam_addr & 1) != 0;
-            uint16_t address = m_oam_addr;
-            m_oam_addr = (m_oam_addr + 1) & 0x3FF;  // Increment BEFORE the write logic
-
-            if ((address & 0x200) != 0) {
-                // High OAM (addresses 512-543): direct byte writes, bypass latch
-                m_oam[0x200 + (address & 0x1F)] = value;
-            } else {
-                // Low OAM (addresses 0-511): word-based writes
-                if (!latch_bit) {
-                    // Even address: just latch the byte
-                    m_oam_latch = value;
-                } else {
-                    // Odd address: write both bytes to the word-aligned address
-                    uint16_t word_addr = address & 0x1FE;
-                    m_oam[word_addr] = m_oam_latch;      // Low byte (latched)
-                    m_oam[word_addr + 1] = value;        // High byte (current)
-                }
-            }
+        case 0x2104:  // OAMDATA
+            write_oamdata(value);
             break;
-        }
 
         case 0x2105:  // BGMODE
             m_bgmode = value;
@@ -3017,14 +2725,12 @@ void PPU::write(uint16_t address, uint8_t value) {
             m_bg_chr_addr[0] = (value & 0x07) << 13;  // Byte address (0x0000-0xE000)
             m_bg_chr_addr[1] = ((value >> 4) & 0x07) << 13;  // Byte address (0x0000-0xE000)
             {
-                static int bg12nba_write_count = 0;
-                static uint8_t last_bg12nba = 0xFF;
-                bg12nba_write_count++;
+                m_debug_bg12nba_writes++;
                 // Log first few writes and any changes
-                if (is_debug_mode() && (bg12nba_write_count <= 10 || value != last_bg12nba)) {
+                if (is_debug_mode() && (m_debug_bg12nba_writes <= 10 || value != m_debug_last_bg12nba)) {
                     SNES_DEBUG_PRINT("BG12NBA write #%d: $%02X -> BG1=$%04X BG2=$%04X (frame %lu)\n",
-                        bg12nba_write_count, value, m_bg_chr_addr[0], m_bg_chr_addr[1], m_frame);
-                    last_bg12nba = value;
+                        m_debug_bg12nba_writes, value, m_bg_chr_addr[0], m_bg_chr_addr[1], m_frame);
+                    m_debug_last_bg12nba = value;
                 }
             }
             SNES_PPU_DEBUG("BG12NBA=$%02X -> BG1 chr=$%04X, BG2 chr=$%04X\n",
@@ -3125,46 +2831,27 @@ void PPU::write(uint16_t address, uint8_t value) {
             break;
 
         case 0x2118:  // VMDATAL
-            {
-                // Apply VRAM address remapping based on VMAIN bits 2-3
-                // This remapping is used for efficient tile data DMA
-                // Reference: fullsnes, bsnes/snes9x VMAIN documentation
-                uint16_t addr = remap_vram_address(m_vram_addr);
-                uint32_t byte_addr = (addr * 2) & 0xFFFF;
-                // Debug: track CPU writes to $A000-$BFFF region
-                if (is_debug_mode() && byte_addr >= 0xA000 && byte_addr < 0xC000 && value != 0) {
-                    static int cpu_vram_a000_writes = 0;
-                    cpu_vram_a000_writes++;
-                    if (cpu_vram_a000_writes <= 20) {
-                        SNES_DEBUG_PRINT("CPU VRAM write (low): byte $%04X = $%02X (word_addr=$%04X, frame %lu)\n",
-                            byte_addr, value, m_vram_addr, m_frame);
-                    }
-                }
-                m_vram[byte_addr] = value;
-                if (!m_vram_increment_high) {
-                    m_vram_addr += m_vram_increment;
+            // Debug: track CPU writes to $A000-$BFFF region
+            if (is_debug_mode() && value != 0) {
+                uint32_t byte_addr = (remap_vram_address(m_vram_addr) * 2) & 0xFFFF;
+                if (byte_addr >= 0xA000 && byte_addr < 0xC000 && ++m_debug_vram_a000_writes <= 20) {
+                    SNES_DEBUG_PRINT("CPU VRAM write (low): byte $%04X = $%02X (word_addr=$%04X, frame %lu)\n",
+                        byte_addr, value, m_vram_addr, m_frame);
                 }
             }
+            write_vmdata(false, value);
             break;
 
         case 0x2119:  // VMDATAH
-            {
-                uint16_t addr = remap_vram_address(m_vram_addr);
-                uint32_t byte_addr = (addr * 2 + 1) & 0xFFFF;
-                // Debug: track CPU writes to $A000-$BFFF region
-                if (is_debug_mode() && byte_addr >= 0xA000 && byte_addr < 0xC000 && value != 0) {
-                    static int cpu_vram_a000_writes_h = 0;
-                    cpu_vram_a000_writes_h++;
-                    if (cpu_vram_a000_writes_h <= 20) {
-                        SNES_DEBUG_PRINT("CPU VRAM write (high): byte $%04X = $%02X (word_addr=$%04X, frame %lu)\n",
-                            byte_addr, value, m_vram_addr, m_frame);
-                    }
-                }
-                m_vram[byte_addr] = value;
-                if (m_vram_increment_high) {
-                    m_vram_addr += m_vram_increment;
+            // Debug: track CPU writes to $A000-$BFFF region
+            if (is_debug_mode() && value != 0) {
+                uint32_t byte_addr = (remap_vram_address(m_vram_addr) * 2 + 1) & 0xFFFF;
+                if (byte_addr >= 0xA000 && byte_addr < 0xC000 && ++m_debug_vram_a000_writes_h <= 20) {
+                    SNES_DEBUG_PRINT("CPU VRAM write (high): byte $%04X = $%02X (word_addr=$%04X, frame %lu)\n",
+                        byte_addr, value, m_vram_addr, m_frame);
                 }
             }
+            write_vmdata(true, value);
             break;
 
         case 0x211A:  // M7SEL
@@ -3209,29 +2896,15 @@ void PPU::write(uint16_t address, uint8_t value) {
             m_cgram_high_byte = false;
             break;
 
-        case 0x2122: {  // CGDATA - Palette data write
-            // CGRAM writes use a double-byte buffer
-            // First write: store low byte in latch
-            // Second write: combine with latch and write 15-bit color to CGRAM
-            if (!m_cgram_high_byte) {
-                m_cgram_latch = value;
-            } else {
-                // CGRAM stores 15-bit BGR colors (5:5:5 format)
-                m_cgram[m_cgram_addr * 2] = m_cgram_latch;
-                m_cgram[m_cgram_addr * 2 + 1] = value & 0x7F;  // Bit 7 ignored
-
-                // Debug: Log CGRAM writes during transition frames
-                if (is_debug_mode() && m_frame >= 255 && m_frame <= 275 && m_cgram_addr < 16) {
-                    uint16_t color = m_cgram_latch | ((value & 0x7F) << 8);
-                    fprintf(stderr, "[SNES/PPU] F%lu CGRAM[%d]=$%04X\n",
-                        m_frame, m_cgram_addr, color);
-                }
-
-                m_cgram_addr = (m_cgram_addr + 1) & 0xFF;
+        case 0x2122:  // CGDATA - Palette data write
+            // Debug: Log CGRAM writes during transition frames
+            if (is_debug_mode() && m_cgram_high_byte && m_frame >= 255 && m_frame <= 275 && m_cgram_addr < 16) {
+                uint16_t color = m_cgram_latch | ((value & 0x7F) << 8);
+                fprintf(stderr, "[SNES/PPU] F%lu CGRAM[%d]=$%04X\n",
+                    m_frame, m_cgram_addr, color);
             }
-            m_cgram_high_byte = !m_cgram_high_byte;
+            cgram_write(value);
             break;
-        }
 
         case 0x2123:  // W12SEL
             m_bg_window1_invert[0] = (value & 0x01) != 0;
@@ -3357,6 +3030,7 @@ void PPU::write(uint16_t address, uint8_t value) {
 
 void PPU::oam_write(uint16_t address, uint8_t value) {
     m_oam[address & 0x21F] = value;
+    m_sprite_lines_size = -1;
 }
 
 uint8_t PPU::oam_read(uint16_t address) {
@@ -3364,14 +3038,16 @@ uint8_t PPU::oam_read(uint16_t address) {
 }
 
 void PPU::cgram_write(uint8_t value) {
-    // CGRAM write handler - uses same double-byte latch as register $2122
-    // This function exists for potential direct DMA access but currently
-    // DMA goes through the bus which routes to ppu->write($2122, value).
+    // CGRAM write handler for register $2122 and MDMA bursts
+    // First write: store low byte in latch
+    // Second write: combine with latch and write 15-bit color to CGRAM
     if (!m_cgram_high_byte) {
         m_cgram_latch = value;
     } else {
+        // CGRAM stores 15-bit BGR colors (5:5:5 format)
         m_cgram[m_cgram_addr * 2] = m_cgram_latch;
-        m_cgram[m_cgram_addr * 2 + 1] = value & 0x7F;
+        m_cgram[m_cgram_addr * 2 + 1] = value & 0x7F;  // Bit 7 ignored
+        if (m_worker) mark_dirty(VRAM_BLOCKS + m_cgram_addr * 2 / DIRTY_BLOCK_SIZE);
         m_cgram_addr = (m_cgram_addr + 1) & 0xFF;
     }
     m_cgram_high_byte = !m_cgram_high_byte;
@@ -3391,7 +3067,7 @@ uint8_t PPU::cgram_read() {
 
 void PPU::vram_write(uint16_t address, uint8_t value, bool high_byte) {
     uint16_t addr = (address * 2 + (high_byte ? 1 : 0)) & 0xFFFF;
-    m_vram[addr] = value;
+    write_vram_byte(addr, value);
 }
 
 uint8_t PPU::vram_read(uint16_t address, bool high_byte) {
@@ -3399,21 +3075,36 @@ uint8_t PPU::vram_read(uint16_t address, bool high_byte) {
     return m_vram[addr];
 }
 
-void PPU::save_state(std::vector<uint8_t>& data) {
+void PPU::write_dma_burst(const uint8_t* ports, int unit, int phase,
+                          const uint8_t* data, int stride, int count) {
+    sync_to_current();
+    if (m_worker) flush_span();
+
+    for (int i = 0; i < count; i++) {
+        uint8_t value = *data;
+        data += stride;
+        switch (ports[phase]) {
+            case 0x04: write_oamdata(value); break;
+            case 0x18: write_vmdata(false, value); break;
+            case 0x19: write_vmdata(true, value); break;
+            case 0x22: cgram_write(value); break;
+        }
+        if (++phase == unit) phase = 0;
+    }
+}
+
+void PPU::save_state(StateWriter& data) {
     // Save timing
-    data.insert(data.end(), reinterpret_cast<uint8_t*>(&m_scanline),
-                reinterpret_cast<uint8_t*>(&m_scanline) + sizeof(m_scanline));
-    data.insert(data.end(), reinterpret_cast<uint8_t*>(&m_dot),
-                reinterpret_cast<uint8_t*>(&m_dot) + sizeof(m_dot));
-    data.insert(data.end(), reinterpret_cast<uint8_t*>(&m_frame),
-                reinterpret_cast<uint8_t*>(&m_frame) + sizeof(m_frame));
+    data.write(&m_scanline, sizeof(m_scanline));
+    data.write(&m_dot, sizeof(m_dot));
+    data.write(&m_frame, sizeof(m_frame));
 
     // Save VRAM, OAM, CGRAM
-    data.insert(data.end(), m_vram.begin(), m_vram.end());
-    data.insert(data.end(), m_oam.begin(), m_oam.end());
-    data.insert(data.end(), m_cgram.begin(), m_cgram.end());
+    data.write(m_vram.data(), m_vram.size());
+    data.write(m_oam.data(), m_oam.size());
+    data.write(m_cgram.data(), m_cgram.size());
 
-    // Save key registers (simplified)
+    // Save key registers (the rest go in save_registers())
     data.push_back(m_inidisp);
     data.push_back(m_obsel);
     data.push_back(m_bgmode);
@@ -3436,6 +3127,7 @@ void PPU::load_state(const uint8_t*& data, size_t& remaining) {
     std::memcpy(m_vram.data(), data, m_vram.size());
     data += m_vram.size(); remaining -= m_vram.size();
     std::memcpy(m_oam.data(), data, m_oam.size());
+    m_sprite_lines_size = -1;
     data += m_oam.size(); remaining -= m_oam.size();
     std::memcpy(m_cgram.data(), data, m_cgram.size());
     data += m_cgram.size(); remaining -= m_cgram.size();
@@ -3452,7 +3144,422 @@ void PPU::load_state(const uint8_t*& data, size_t& remaining) {
     // Recalculate derived values
     m_force_blank = (m_inidisp & 0x80) != 0;
     m_brightness = m_inidisp & 0x0F;
+    update_brightness_levels();
     m_bg_mode = m_bgmode & 0x07;
+    m_line_buffer_y = -1;
+    m_window_dirty = true;
+    invalidate_tile_cache();
+    if (m_worker) mark_all_dirty();
+}
+
+// Sprite and layer line buffers aren't listed: sprites are evaluated again
+// from the start of each frame, and load_state() drops the line buffers
+template <typename Visit>
+void PPU::visit_registers(Visit&& visit) {
+    // Timing
+    visit(m_frame_complete);
+    visit(m_rendered_scanline);
+    visit(m_rendered_dot);
+    visit(m_force_blank_latched_eval);
+    visit(m_force_blank_latched_fetch);
+    visit(m_force_blank_on_cycle);
+    visit(m_total_ppu_cycles);
+    visit(m_dot_accumulator);
+
+    // Objects and OAM access
+    visit(m_obj_base_addr);
+    visit(m_obj_name_select);
+    visit(m_obj_size_small);
+    visit(m_obj_size_large);
+    visit(m_oam_addr);
+    visit(m_oam_addr_reload);
+    visit(m_oam_latch);
+    visit(m_oam_high_byte);
+
+    // Backgrounds and scroll
+    visit(m_bg3_priority);
+    visit(m_bg_tile_size);
+    visit(m_mosaic);
+    visit(m_mosaic_size);
+    visit(m_mosaic_enabled);
+    visit(m_bg_tilemap_addr);
+    visit(m_bg_tilemap_width);
+    visit(m_bg_tilemap_height);
+    visit(m_bg_chr_addr);
+    visit(m_bg_hofs);
+    visit(m_bg_vofs);
+    visit(m_bgofs_latch_ppu1);
+    visit(m_bgofs_latch_ppu2);
+
+    // VRAM and CGRAM access
+    visit(m_vmain);
+    visit(m_vram_increment);
+    visit(m_vram_increment_high);
+    visit(m_vram_remap_mode);
+    visit(m_vram_addr);
+    visit(m_vram_latch);
+    visit(m_vram_read_buffer);
+    visit(m_cgram_addr);
+    visit(m_cgram_latch);
+    visit(m_cgram_high_byte);
+
+    // Windows
+    visit(m_bg_window1_enable);
+    visit(m_bg_window1_invert);
+    visit(m_bg_window2_enable);
+    visit(m_bg_window2_invert);
+    visit(m_obj_window1_enable);
+    visit(m_obj_window1_invert);
+    visit(m_obj_window2_enable);
+    visit(m_obj_window2_invert);
+    visit(m_color_window1_enable);
+    visit(m_color_window1_invert);
+    visit(m_color_window2_enable);
+    visit(m_color_window2_invert);
+    visit(m_window1_left);
+    visit(m_window1_right);
+    visit(m_window2_left);
+    visit(m_window2_right);
+    visit(m_bg_window_logic);
+    visit(m_obj_window_logic);
+    visit(m_color_window_logic);
+    visit(m_tmw);
+    visit(m_tsw);
+
+    // Color math
+    visit(m_cgwsel);
+    visit(m_color_math_clip);
+    visit(m_color_math_prevent);
+    visit(m_direct_color);
+    visit(m_sub_screen_bg_obj);
+    visit(m_cgadsub);
+    visit(m_color_math_add);
+    visit(m_color_math_half);
+    visit(m_bg_color_math);
+    visit(m_obj_color_math);
+    visit(m_backdrop_color_math);
+    visit(m_fixed_color_r);
+    visit(m_fixed_color_g);
+    visit(m_fixed_color_b);
+
+    // Screen mode
+    visit(m_setini);
+    visit(m_interlace);
+    visit(m_obj_interlace);
+    visit(m_overscan);
+    visit(m_pseudo_hires);
+    visit(m_extbg);
+    visit(m_external_sync);
+
+    // Mode 7
+    visit(m_m7sel);
+    visit(m_m7_hflip);
+    visit(m_m7_vflip);
+    visit(m_m7_wrap);
+    visit(m_m7a);
+    visit(m_m7b);
+    visit(m_m7c);
+    visit(m_m7d);
+    visit(m_m7x);
+    visit(m_m7y);
+    visit(m_m7hofs);
+    visit(m_m7vofs);
+    visit(m_m7_latch);
+
+    // Status, counters and multiplier
+    visit(m_time_over);
+    visit(m_range_over);
+    visit(m_ppu1_open_bus);
+    visit(m_ppu2_open_bus);
+    visit(m_nmi_pending);
+    visit(m_hcount);
+    visit(m_vcount);
+    visit(m_hv_latch);
+    visit(m_hcount_second);
+    visit(m_vcount_second);
+    visit(m_mpy_result);
+}
+
+void PPU::save_registers(StateWriter& data) {
+    visit_registers(emu::StateFieldWriter(data));
+}
+
+void PPU::load_registers(const uint8_t*& data, size_t& remaining) {
+    emu::StateFieldReader reader(data, remaining);
+    visit_registers(reader);
+    reader.finish();
+
+    m_sprites_for_scanline = -1;
+    m_line_buffer_y = -1;
+    m_window_dirty = true;
+    invalidate_tile_cache();
+    if (m_worker) mark_all_dirty();
+}
+
+// ============================================================================
+// THREADED RENDERING
+// ============================================================================
+// The emulation thread keeps the catch-up timing, sprite evaluation and all
+// register state. Where serial rendering would draw dots, it extends the
+// pending span instead; a PPU write or the end of the visible line queues
+// the span with a copy of the state it was drawn with. Mid-line raster
+// effects just split a line into several spans, so nothing waits on the
+// worker until the frame is read out.
+// ============================================================================
+
+void PPU::set_threaded_rendering(bool enabled) {
+    if (enabled == (m_worker != nullptr)) return;
+
+    if (!enabled) {
+        sync_rendering();
+        {
+            std::lock_guard<std::mutex> lock(m_worker->mutex);
+            m_worker->stop = true;
+        }
+        m_worker->work_ready.notify_all();
+        m_worker->thread.join();
+        m_worker.reset();
+        m_dirty_blocks.clear();
+        m_block_dirty.fill(false);
+
+        // The layer buffers and window masks here went stale while the
+        // worker drew
+        m_line_buffer_y = -1;
+        m_window_dirty = true;
+        return;
+    }
+
+    m_worker = std::make_unique<RenderWorker>(m_bus);
+    m_worker->shadow.m_framebuffer = m_framebuffer;
+    m_worker->shadow.m_line_hires = m_line_hires;
+    m_dirty_blocks.clear();
+    m_block_dirty.fill(false);
+    mark_all_dirty();
+    m_window_dirty = true;
+    m_span_y = -1;
+    m_worker->thread = std::thread([worker = m_worker.get()] { worker->run(); });
+}
+
+void PPU::sync_rendering() {
+    if (!m_worker) return;
+    flush_span();
+    std::unique_lock<std::mutex> lock(m_worker->mutex);
+    m_worker->work_ready.notify_one();
+    m_worker->work_done.wait(lock, [this] { return m_worker->tail == m_worker->head; });
+    m_framebuffer = m_worker->shadow.m_framebuffer;
+    m_line_hires = m_worker->shadow.m_line_hires;
+}
+
+uint8_t* PPU::block_data(int block) {
+    if (block < VRAM_BLOCKS) return m_vram.data() + block * DIRTY_BLOCK_SIZE;
+    return m_cgram.data() + (block - VRAM_BLOCKS) * DIRTY_BLOCK_SIZE;
+}
+
+void PPU::mark_dirty(int block) {
+    if (!m_block_dirty[block]) {
+        m_block_dirty[block] = true;
+        m_dirty_blocks.push_back(static_cast<uint16_t>(block));
+    }
+}
+
+void PPU::mark_all_dirty() {
+    for (int block = 0; block < TOTAL_BLOCKS; block++) {
+        mark_dirty(block);
+    }
+}
+
+void PPU::capture_span_state(SpanState& state) const {
+    state.frame = m_frame;
+    state.force_blank = m_force_blank;
+    state.brightness = m_brightness;
+    state.bg_mode = m_bg_mode;
+    state.bg3_priority = m_bg3_priority;
+    state.bg_tile_size = m_bg_tile_size;
+    state.mosaic_size = m_mosaic_size;
+    state.mosaic_enabled = m_mosaic_enabled;
+    state.bg_tilemap_addr = m_bg_tilemap_addr;
+    state.bg_tilemap_width = m_bg_tilemap_width;
+    state.bg_tilemap_height = m_bg_tilemap_height;
+    state.bg_chr_addr = m_bg_chr_addr;
+    state.bg_hofs = m_bg_hofs;
+    state.bg_vofs = m_bg_vofs;
+    state.bg_window1_enable = m_bg_window1_enable;
+    state.bg_window1_invert = m_bg_window1_invert;
+    state.bg_window2_enable = m_bg_window2_enable;
+    state.bg_window2_invert = m_bg_window2_invert;
+    state.obj_window1_enable = m_obj_window1_enable;
+    state.obj_window1_invert = m_obj_window1_invert;
+    state.obj_window2_enable = m_obj_window2_enable;
+    state.obj_window2_invert = m_obj_window2_invert;
+    state.color_window1_enable = m_color_window1_enable;
+    state.color_window1_invert = m_color_window1_invert;
+    state.color_window2_enable = m_color_window2_enable;
+    state.color_window2_invert = m_color_window2_invert;
+    state.window1_left = m_window1_left;
+    state.window1_right = m_window1_right;
+    state.window2_left = m_window2_left;
+    state.window2_right = m_window2_right;
+    state.bg_window_logic = m_bg_window_logic;
+    state.obj_window_logic = m_obj_window_logic;
+    state.color_window_logic = m_color_window_logic;
+    state.tm = m_tm;
+    state.ts = m_ts;
+    state.tmw = m_tmw;
+    state.tsw = m_tsw;
+    state.color_math_clip = m_color_math_clip;
+    state.color_math_prevent = m_color_math_prevent;
+    state.direct_color = m_direct_color;
+    state.sub_screen_bg_obj = m_sub_screen_bg_obj;
+    state.color_math_add = m_color_math_add;
+    state.color_math_half = m_color_math_half;
+    state.bg_color_math = m_bg_color_math;
+    state.obj_color_math = m_obj_color_math;
+    state.backdrop_color_math = m_backdrop_color_math;
+    state.fixed_color_r = m_fixed_color_r;
+    state.fixed_color_g = m_fixed_color_g;
+    state.fixed_color_b = m_fixed_color_b;
+    state.pseudo_hires = m_pseudo_hires;
+    state.extbg = m_extbg;
+    state.m7_hflip = m_m7_hflip;
+    state.m7_vflip = m_m7_vflip;
+    state.m7_wrap = m_m7_wrap;
+    state.m7a = m_m7a;
+    state.m7b = m_m7b;
+    state.m7c = m_m7c;
+    state.m7d = m_m7d;
+    state.m7x = m_m7x;
+    state.m7y = m_m7y;
+    state.m7hofs = m_m7hofs;
+    state.m7vofs = m_m7vofs;
+    std::copy_n(m_sprite_tiles.begin(), m_sprite_tile_count, state.sprite_tiles.begin());
+    state.sprite_tile_count = m_sprite_tile_count;
+}
+
+void PPU::apply_span_state(const SpanState& state) {
+    m_frame = state.frame;
+    m_force_blank = state.force_blank;
+    m_brightness = state.brightness;
+    update_brightness_levels();
+    m_bg_mode = state.bg_mode;
+    m_bg3_priority = state.bg3_priority;
+    m_bg_tile_size = state.bg_tile_size;
+    m_mosaic_size = state.mosaic_size;
+    m_mosaic_enabled = state.mosaic_enabled;
+    m_bg_tilemap_addr = state.bg_tilemap_addr;
+    m_bg_tilemap_width = state.bg_tilemap_width;
+    m_bg_tilemap_height = state.bg_tilemap_height;
+    m_bg_chr_addr = state.bg_chr_addr;
+    m_bg_hofs = state.bg_hofs;
+    m_bg_vofs = state.bg_vofs;
+    m_bg_window1_enable = state.bg_window1_enable;
+    m_bg_window1_invert = state.bg_window1_invert;
+    m_bg_window2_enable = state.bg_window2_enable;
+    m_bg_window2_invert = state.bg_window2_invert;
+    m_obj_window1_enable = state.obj_window1_enable;
+    m_obj_window1_invert = state.obj_window1_invert;
+    m_obj_window2_enable = state.obj_window2_enable;
+    m_obj_window2_invert = state.obj_window2_invert;
+    m_color_window1_enable = state.color_window1_enable;
+    m_color_window1_invert = state.color_window1_invert;
+    m_color_window2_enable = state.color_window2_enable;
+    m_color_window2_invert = state.color_window2_invert;
+    m_window1_left = state.window1_left;
+    m_window1_right = state.window1_right;
+    m_window2_left = state.window2_left;
+    m_window2_right = state.window2_right;
+    m_bg_window_logic = state.bg_window_logic;
+    m_obj_window_logic = state.obj_window_logic;
+    m_color_window_logic = state.color_window_logic;
+    m_tm = state.tm;
+    m_ts = state.ts;
+    m_tmw = state.tmw;
+    m_tsw = state.tsw;
+    m_color_math_clip = state.color_math_clip;
+    m_color_math_prevent = state.color_math_prevent;
+    m_direct_color = state.direct_color;
+    m_sub_screen_bg_obj = state.sub_screen_bg_obj;
+    m_color_math_add = state.color_math_add;
+    m_color_math_half = state.color_math_half;
+    m_bg_color_math = state.bg_color_math;
+    m_obj_color_math = state.obj_color_math;
+    m_backdrop_color_math = state.backdrop_color_math;
+    m_fixed_color_r = state.fixed_color_r;
+    m_fixed_color_g = state.fixed_color_g;
+    m_fixed_color_b = state.fixed_color_b;
+    m_pseudo_hires = state.pseudo_hires;
+    m_extbg = state.extbg;
+    m_m7_hflip = state.m7_hflip;
+    m_m7_vflip = state.m7_vflip;
+    m_m7_wrap = state.m7_wrap;
+    m_m7a = state.m7a;
+    m_m7b = state.m7b;
+    m_m7c = state.m7c;
+    m_m7d = state.m7d;
+    m_m7x = state.m7x;
+    m_m7y = state.m7y;
+    m_m7hofs = state.m7hofs;
+    m_m7vofs = state.m7vofs;
+    std::copy_n(state.sprite_tiles.begin(), state.sprite_tile_count, m_sprite_tiles.begin());
+    m_sprite_tile_count = state.sprite_tile_count;
+}
+
+void PPU::queue_span(int screen_y, int start_x, int end_x) {
+    if (m_span_y == screen_y && m_span_end == start_x) {
+        m_span_end = end_x;
+    } else {
+        flush_span();
+        m_span_y = screen_y;
+        m_span_start = start_x;
+        m_span_end = end_x;
+    }
+
+    // A finished line can go to the worker straight away
+    if (m_span_end >= SCREEN_WIDTH) {
+        flush_span();
+    }
+}
+
+void PPU::flush_span() {
+    if (m_span_y < 0) return;
+
+    RenderWorker& worker = *m_worker;
+    std::unique_lock<std::mutex> lock(worker.mutex);
+    if (worker.head - worker.tail >= RenderWorker::QUEUE_SIZE) {
+        worker.work_ready.notify_one();
+        worker.work_done.wait(lock, [&worker] {
+            return worker.head - worker.tail < RenderWorker::QUEUE_SIZE;
+        });
+    }
+    SpanJob& job = worker.jobs[worker.head % RenderWorker::QUEUE_SIZE];
+    lock.unlock();
+
+    // The worker never touches a job between tail and head, so it can be
+    // filled without holding the lock
+    job.screen_y = m_span_y;
+    job.start_x = m_span_start;
+    job.end_x = m_span_end;
+    capture_span_state(job.state);
+    job.line_buffer_dirty = m_line_buffer_dirty;
+    job.window_dirty = m_window_dirty;
+    m_line_buffer_dirty = false;
+    m_window_dirty = false;
+    std::sort(m_dirty_blocks.begin(), m_dirty_blocks.end());
+    job.blocks.assign(m_dirty_blocks.begin(), m_dirty_blocks.end());
+    job.data.resize(job.blocks.size() * DIRTY_BLOCK_SIZE);
+    uint8_t* dst = job.data.data();
+    for (uint16_t block : m_dirty_blocks) {
+        std::memcpy(dst, block_data(block), DIRTY_BLOCK_SIZE);
+        dst += DIRTY_BLOCK_SIZE;
+        m_block_dirty[block] = false;
+    }
+    m_dirty_blocks.clear();
+    m_span_y = -1;
+
+    lock.lock();
+    worker.head++;
+    if (worker.head - worker.tail >= RenderWorker::WAKE_BATCH) {
+        worker.work_ready.notify_one();
+    }
 }
 
 } // namespace snes
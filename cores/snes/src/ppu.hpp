@@ -1,12 +1,16 @@
 #pragma once
 
+#include "emu/state_writer.hpp"
+
 #include <cstdint>
 #include <array>
+#include <memory>
 #include <vector>
 
 namespace snes {
 
 class Bus;
+using emu::StateWriter;
 
 // SNES PPU (Picture Processing Unit)
 // Consists of PPU1 (5C77) and PPU2 (5C78)
@@ -37,6 +41,25 @@ public:
     // Get framebuffer (256x224 or 512x448 in hi-res)
     const uint32_t* get_framebuffer() const { return m_framebuffer.data(); }
 
+    // Internal memories, for memory domains
+    const uint8_t* get_vram_data() const { return m_vram.data(); }
+    const uint8_t* get_oam_data() const { return m_oam.data(); }
+    const uint8_t* get_cgram_data() const { return m_cgram.data(); }
+
+    // Skip pixel composition for frames that won't be shown; sprite range
+    // and time over flags, H/V counters and HDMA timing stay exact
+    void set_video_enabled(bool enabled) { m_video_enabled = enabled; }
+
+    // Draw visible dots on a worker thread. The emulation thread still runs
+    // the catch-up timing and sprite evaluation; it queues each run of dots
+    // along with the register state and the VRAM/CGRAM blocks written since
+    // the previous run, so output is identical to serial rendering.
+    void set_threaded_rendering(bool enabled);
+    bool is_threaded_rendering() const { return m_worker != nullptr; }
+
+    // Wait for queued dots and publish them to get_framebuffer()
+    void sync_rendering();
+
     // Current scanline/dot for timing
     int get_scanline() const { return m_scanline; }
     int get_dot() const { return m_dot; }
@@ -44,6 +67,13 @@ public:
     void set_dot(int dot) { m_dot = dot; }
     uint32_t get_frame_cycle() const { return m_scanline * 340 + m_dot; }
 
+    // Master cycles advance() takes to reach the given dot: on this line if
+    // it's still ahead, else on the next
+    int get_cycles_until_dot(int dot) const {
+        int dots = dot > m_dot ? dot - m_dot : DOTS_PER_SCANLINE - m_dot + dot;
+        return dots * 4 - m_dot_accumulator;
+    }
+
     // ========================================================================
     // CATCH-UP RENDERING SYSTEM
     // ========================================================================
@@ -90,10 +120,12 @@ public:
     bool is_overscan() const { return m_overscan; }
     // Mode 5/6 always output 512 pixels wide (true hi-res), same as pseudo-hires
     bool is_hires_output() const { return m_pseudo_hires || m_bg_mode == 5 || m_bg_mode == 6; }
-    // Always return 512 - framebuffer is always 512 pixels wide to handle mixed modes
-    // Non-hi-res scanlines duplicate pixels; hi-res scanlines use full resolution
+    // The framebuffer stride is always 512 to handle mixed modes. Lo-res
+    // lines only fill the even pixels; lines with any hi-res pixels fill
+    // both, doubling their lo-res ones (see is_line_hires()).
     int get_screen_width() const { return 512; }
     int get_screen_height() const { return m_overscan ? 239 : 224; }
+    bool is_line_hires(int y) const { return m_line_hires[y] != 0; }
 
     // OAM access for DMA
     void oam_write(uint16_t address, uint8_t value);
@@ -107,9 +139,21 @@ public:
     void vram_write(uint16_t address, uint8_t value, bool high_byte);
     uint8_t vram_read(uint16_t address, bool high_byte);
 
+    // MDMA fast path into the OAMDATA ($2104), VMDATAL/H ($2118/$2119) and
+    // CGDATA ($2122) ports. Byte i goes to ports[(phase + i) % unit] and is
+    // read from data[i * stride], with the same side effects as write().
+    static bool is_burst_port(uint8_t b_addr) {
+        return b_addr == 0x04 || b_addr == 0x18 || b_addr == 0x19 || b_addr == 0x22;
+    }
+    void write_dma_burst(const uint8_t* ports, int unit, int phase,
+                         const uint8_t* data, int stride, int count);
+
     // Save state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
+    // The rest of the register, latch and timing state, after save_state()
+    void save_registers(StateWriter& data);
+    void load_registers(const uint8_t*& data, size_t& remaining);
 
     // Render a specific scanline (public for plugin)
     void render_scanline(int scanline);
@@ -120,20 +164,31 @@ public:
 private:
     void render_scanline();
     void render_pixel(int x);
-    void render_background_pixel(int bg, int x, uint8_t& pixel, uint8_t& priority);
-    void render_background_pixel(int bg, int x, uint8_t& pixel, uint8_t& priority, uint8_t& palette);
-    void render_background_pixel(int bg, int x, uint8_t& pixel, uint8_t& priority,
-                                  bool hires_mode, bool hires_odd_pixel);  // Hi-res Mode 5/6
-    void render_mode7_pixel(int x, uint8_t& pixel, uint8_t& priority);
-    void render_sprite_pixel(int x, uint8_t& pixel, uint8_t& priority, bool& is_palette_4_7);
+    void output_pixel(int y, int x, uint32_t argb);
+    void output_hires_pixel(int y, int x, uint32_t sub_argb, uint32_t main_argb);
+    void draw_span(int screen_y, int start_x, int end_x);
+    void build_line_buffers(int start_x, int end_x);
+    void build_background_line(int bg, int start_x, int end_x);
+    void build_sprite_line(int start_x, int end_x);
+    void build_mode7_line(int start_x, int end_x);
     void evaluate_sprites();
+    void build_sprite_lines(int size_index);
     uint16_t get_bg_tile_address(int bg, int tile_x, int tile_y);
     uint16_t get_color(uint8_t palette, uint8_t index, bool sprite = false);
     uint16_t get_direct_color(uint8_t palette, uint8_t color_index);
+    void update_brightness_levels();
     uint16_t remap_vram_address(uint16_t addr) const;
-    bool get_color_window(int x) const;  // Returns true if pixel is inside color window
-    bool get_bg_window(int bg, int x) const;  // Returns true if BG pixel is masked by window
-    bool get_obj_window(int x) const;  // Returns true if OBJ pixel is masked by window
+    void write_vram_byte(uint16_t byte_addr, uint8_t value);
+    void write_vmdata(bool high_byte, uint8_t value);
+    void write_oamdata(uint8_t value);
+    void invalidate_tile_cache();
+    void invalidate_vram_block(int block);
+    const uint8_t* get_decoded_tile_row(int bpp, uint16_t row_addr);
+    void build_window_masks();
+
+    // Calls visit on each field save_registers() covers
+    template <typename Visit>
+    void visit_registers(Visit&& visit);
 
     Bus& m_bus;
 
@@ -211,13 +266,34 @@ private:
 
     // Framebuffer (supports hi-res 512x448)
     std::array<uint32_t, 512 * 448> m_framebuffer;
+    std::array<uint8_t, 240> m_line_hires;  // Per line: both pixels of each pair filled
+    bool m_video_enabled = true;  // Host output switch, not saved
 
     // VRAM (64KB)
     std::array<uint8_t, 0x10000> m_vram;
 
+    // Decoded tile cache
+    // ========================================================================
+    // Every VRAM tile at each depth (index 0/1/2 = 2/4/8bpp) decoded from
+    // interleaved bitplanes to one color index byte per pixel. A VRAM write
+    // only marks the 2bpp, 4bpp and 8bpp tiles covering that byte dirty; a
+    // dirty tile is decoded again the next time the BG or OBJ path reads it.
+    // ========================================================================
+    struct TileCache {
+        std::vector<uint8_t> pixels;  // 64 bytes per tile, row-major
+        std::vector<uint8_t> dirty;   // One flag per tile
+    };
+    std::array<TileCache, 3> m_tile_cache;
+
     // OAM (544 bytes: 512 + 32 high bytes)
     std::array<uint8_t, 544> m_oam;
 
+    // The sprites in range of each line (screen Y & 0xFF), bit i of the
+    // pair for OAM entry i, for the OBSEL size set they were built with.
+    // OAM writes clear the size so the next evaluation rebuilds.
+    std::array<std::array<uint64_t, 2>, 256> m_sprite_lines{};
+    int m_sprite_lines_size = -1;
+
     // CGRAM (512 bytes = 256 colors)
     std::array<uint8_t, 512> m_cgram;
 
@@ -227,6 +303,7 @@ private:
     uint8_t m_inidisp = 0x80;  // Force blank on reset
     bool m_force_blank = true;
     uint8_t m_brightness = 0;
+    std::array<uint8_t, 32> m_brightness_levels{};  // Channel value -> 8-bit output at m_brightness
 
     // $2101 - OBSEL - Object size and base
     uint8_t m_obsel = 0;
@@ -408,7 +485,7 @@ private:
     // Sprites are always 4bpp (16 colors per palette)
     struct SpriteTile {
         int x;                      // X position on screen
-        uint8_t planes[4];          // 4 bitplanes for one 8-pixel row
+        uint8_t pixels[8];          // Decoded 4bpp color indices for one row
         int palette;                // Palette 0-7
         int priority;               // Priority 0-3
         bool hflip;                 // Horizontal flip
@@ -416,6 +493,62 @@ private:
     std::array<SpriteTile, 34> m_sprite_tiles;
     int m_sprite_tile_count = 0;
 
+    // Scanline layer buffers
+    // ========================================================================
+    // BG and OBJ pixels for a line are decoded a tile at a time into these
+    // buffers when the line's first dot is rendered; render_pixel() then only
+    // does the priority merge. A register or VRAM write that reaches the PPU
+    // mid-line marks the buffers dirty, and the rest of that line is fetched
+    // one dot at a time so raster effects still take hold at the exact dot.
+    // ========================================================================
+    struct BgLine {
+        std::array<uint8_t, SCREEN_WIDTH> pixel;         // CGRAM index (0 = transparent)
+        std::array<uint8_t, SCREEN_WIDTH> priority;      // Tilemap priority bit
+        std::array<uint8_t, SCREEN_WIDTH> palette;       // Tilemap palette (Direct Color)
+        std::array<uint8_t, SCREEN_WIDTH> pixel_sub;     // Mode 5/6 even (sub screen) pixel
+        std::array<uint8_t, SCREEN_WIDTH> priority_sub;
+    };
+    struct ObjLine {
+        std::array<uint8_t, SCREEN_WIDTH> pixel;
+        std::array<uint8_t, SCREEN_WIDTH> priority;
+        std::array<bool, SCREEN_WIDTH> palette_4_7;      // Palettes 4-7 take part in color math
+    };
+    std::array<BgLine, 4> m_bg_line;
+    ObjLine m_obj_line;
+    int m_line_buffer_y = -1;          // Screen line the buffers hold (-1 = none)
+    bool m_line_buffer_dirty = false;  // Written since the buffers were built
+    bool m_line_buffer_rebuilt = false; // Rest of the line already re-decoded once after a write
+
+    // Per-pixel window masks, one bit per layer (BG1-4 match the TMW/TSW bits)
+    static constexpr uint8_t WINDOW_OBJ = 0x10;
+    static constexpr uint8_t WINDOW_COLOR = 0x20;
+    std::array<uint8_t, SCREEN_WIDTH> m_window_line{};
+    bool m_window_dirty = true;        // A window register changed since the masks were built
+
+    // Threaded rendering (see ppu.cpp)
+    struct SpanState;
+    struct SpanJob;
+    struct RenderWorker;
+
+    static constexpr int DIRTY_BLOCK_SIZE = 256;
+    static constexpr int VRAM_BLOCKS = 0x10000 / DIRTY_BLOCK_SIZE;
+    static constexpr int TOTAL_BLOCKS = VRAM_BLOCKS + 512 / DIRTY_BLOCK_SIZE;
+
+    void queue_span(int screen_y, int start_x, int end_x);
+    void flush_span();
+    void capture_span_state(SpanState& state) const;
+    void apply_span_state(const SpanState& state);
+    uint8_t* block_data(int block);
+    void mark_dirty(int block);
+    void mark_all_dirty();
+
+    std::unique_ptr<RenderWorker> m_worker;
+    std::array<bool, TOTAL_BLOCKS> m_block_dirty{};
+    std::vector<uint16_t> m_dirty_blocks;
+    int m_span_y = -1;      // Screen line of the dots not yet queued (-1 = none)
+    int m_span_start = 0;
+    int m_span_end = 0;
+
     // Sprite sizes lookup (small, large)
     static constexpr int SPRITE_SIZES[8][2][2] = {
         {{8, 8}, {16, 16}},    // 0: 8x8, 16x16
@@ -427,6 +560,17 @@ private:
         {{16, 32}, {32, 64}},  // 6: 16x32, 32x64
         {{16, 32}, {32, 32}}   // 7: 16x32, 32x32
     };
+
+    // Debug output limits (DEBUG=1)
+    int m_debug_sync_count = 0;
+    int m_debug_render_pixel_count = 0;
+    int m_debug_pixel_output_count = 0;
+    bool m_debug_mode3_composite = false;
+    bool m_debug_mode3_pixel = false;
+    int m_debug_bg12nba_writes = 0;
+    uint8_t m_debug_last_bg12nba = 0xFF;
+    int m_debug_vram_a000_writes = 0;
+    int m_debug_vram_a000_writes_h = 0;
 };
 
 } // namespace snes
@@ -1,14 +1,24 @@
 #include "emu/emulator_plugin.hpp"
+#include "emu/netplay_plugin.hpp"
+#include "emu/state_chunks.hpp"
+#include "emu/trace.hpp"
 #include "bus.hpp"
 #include "cpu.hpp"
 #include "ppu.hpp"
 #include "apu.hpp"
 #include "dma.hpp"
 #include "cartridge.hpp"
+#include "coprocessor.hpp"
 #include "debug.hpp"
+#include "emu/state_writer.hpp"
 
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <string>
 
 namespace snes {
 
@@ -43,7 +53,7 @@ static const emu::ControllerLayoutInfo SNES_CONTROLLER_LAYOUT = {
     2      // 2 controllers supported
 };
 
-class SNESPlugin : public emu::IEmulatorPlugin {
+class SNESPlugin : public emu::IEmulatorPlugin, public emu::INetplayCapable {
 public:
     SNESPlugin();
     ~SNESPlugin() override;
@@ -61,8 +71,11 @@ public:
     // Emulation
     void reset() override;
     void run_frame(const emu::InputState& input) override;
+    void run_frames(const emu::InputState* inputs, size_t count, emu::RunFlags flags) override;
+    void set_input_poll(const emu::InputPoll& poll) override { m_bus->set_input_poll(poll); }
     uint64_t get_cycle_count() const override;
     uint64_t get_frame_count() const override;
+    bool is_lag_frame() const override { return m_rom_loaded && !m_bus->was_controller_read(); }
 
     // Video
     emu::FrameBuffer get_framebuffer() override;
@@ -72,22 +85,110 @@ public:
     void clear_audio_buffer() override;
 
     // Streaming audio (low-latency)
-    void set_audio_callback(AudioStreamCallback callback) override;
+    void set_audio_sink(const emu::AudioStreamSink& sink) override;
+    void set_audio_enabled(bool enabled) override;
+    void set_video_enabled(bool enabled) override;
+    void set_enhancements_allowed(bool allowed) override { m_enhancements_allowed = allowed; }
+    bool set_output_framebuffer(uint32_t* pixels, int pitch) override;
+    const emu::ProfileMarker* get_profile_marker() const override { return &m_profile; }
+    void set_tracer(emu::Tracer* tracer) override { m_tracer = tracer; }
+    bool set_cpu_trace(emu::CpuTrace* trace) override;
 
     // Memory access
     uint8_t read_memory(uint16_t address) override;
     void write_memory(uint16_t address, uint8_t value) override;
+    std::vector<emu::MemoryDomain> get_memory_domains() override;
+    bool read_memory_block(size_t domain, uint32_t address, size_t length, uint8_t* out) override;
+    bool set_write_watchpoints(const uint32_t* addresses, size_t count) override;
+    size_t take_write_watch_hits(emu::WriteWatchHit* out, size_t max) override;
+    bool set_breakpoints(const emu::Breakpoint* breakpoints, size_t count) override;
+    size_t take_breakpoint_hits(emu::BreakpointHit* out, size_t max) override;
 
     // Save states
     bool save_state(std::vector<uint8_t>& data) override;
     bool load_state(const std::vector<uint8_t>& data) override;
+    bool load_state_chunks(const uint8_t* data, size_t size, const uint32_t* tags, size_t tag_count) override;
+    bool clone_into(emu::IEmulatorPlugin* other) override;
 
     // Battery-backed save support
     bool has_battery_save() const override;
     std::vector<uint8_t> get_battery_save_data() const override;
     bool set_battery_save_data(const std::vector<uint8_t>& data) override;
+    uint64_t get_battery_save_generation() const override;
+
+    // =========================================================================
+    // INetplayCapable implementation - Netplay/Rollback support
+    // =========================================================================
+
+    // The SNES core only uses integer state in CPU/PPU/SPC700/DSP emulation
+    // and never consults the host clock
+    bool is_deterministic() const override { return true; }
+
+    // Run frame with explicit input for both controller ports (for netplay)
+    void run_frame_netplay(uint32_t player1_buttons, uint32_t player2_buttons) override;
+
+    // N-player netplay variant - delegates to 2-player version for SNES
+    void run_frame_netplay_n(const emu::NetplayFrameInputs& inputs) override {
+        run_frame_netplay(inputs.buttons[0], inputs.buttons[1]);
+    }
+
+    // Buttons are read from the VirtualButton bits A through Right
+    int get_input_bits() const override { return 12; }
+
+    // Maximum players supported (2 standard controller ports, no multitap)
+    int get_max_players() const override { return 2; }
+
+    // Fast save state for rollback - writes directly to buffer, no allocations
+    size_t get_max_state_size() const override;
+    size_t save_state_fast(uint8_t* buffer, size_t buffer_size) override;
+    bool load_state_fast(const uint8_t* buffer, size_t size) override;
+
+    // State hash for desync detection
+    uint64_t get_state_hash() const override;
+
+    // Discard audio during rollback re-simulation
+    void discard_audio() override { m_audio_samples = 0; }
+
+    // Configuration
+    bool save_config(const char* path) override;
+    bool load_config(const char* path) override;
 
 private:
+    // Internal run_frame that takes both controller port inputs
+    void run_frame_internal(uint32_t player1_buttons, uint32_t player2_buttons);
+
+    // Run the CPU alone for m_overclock_lines scanlines' worth of master
+    // cycles; the PPU, APU, H/V counters and coprocessor wait
+    void run_overclock();
+
+    // Move the PPU, H counter, IRQ/NMI state, APU and coprocessor on by
+    // master_cycles of CPU time
+    void advance_components(int master_cycles, bool advance_ppu);
+
+    // CPU access sync: catches the above up partway through an instruction
+    static void sync_cpu_access(void* context, int cycles);
+    int m_instruction_synced = 0;  // Cycles of the current instruction already advanced
+
+    // CPU cycles to pass in one go instead of a step() when the CPU is
+    // held by WAI/STP or at the head of a poll loop (CPU::take_poll_loop()):
+    // whole steps or passes that end before anything the frame loop must
+    // see, given the master cycles left in the line. 0 to step.
+    int get_idle_cycles(int line_cycles_left);
+
+    // Shared serialization helpers - used by both the vector-based and the
+    // in-place (rollback) save state paths
+    void serialize_state(StateWriter& out) const;
+    bool deserialize_state(const uint8_t* buffer, size_t size);
+
+    // Chunks with the given tags (all of them for a null list), or a state
+    // from before chunking
+    bool deserialize_chunks(const uint8_t* buffer, size_t size, const uint32_t* tags, size_t tag_count);
+    bool load_state_chunk(const emu::StateChunk& chunk);
+    bool deserialize_unchunked_state(const uint8_t* buffer, size_t size);
+
+    // Domain index of get_memory_domains(); false past the last
+    bool get_memory_domain(size_t index, emu::MemoryDomain& domain) const;
+
     // Convert input state to SNES controller format
     uint32_t convert_input(uint32_t buttons);
 
@@ -97,20 +198,56 @@ private:
     std::unique_ptr<APU> m_apu;
     std::unique_ptr<DMA> m_dma;
     std::unique_ptr<Cartridge> m_cartridge;
+    std::unique_ptr<Coprocessor> m_coprocessor;  // Enhancement chip, if emulated
+
+    // On the bus while any address is watched
+    emu::WriteWatchpoints m_write_watch;
+
+    // On the CPU and bus while they have a breakpoint to check; flagged in
+    // the bus's own 8KB pages
+    emu::Breakpoints m_breakpoints{24, 13};
 
     bool m_rom_loaded = false;
+    bool m_video_enabled = true;  // False = frames run without drawing
+    bool m_threaded_apu = false;  // Run the SPC700/DSP on a worker thread
+    bool m_threaded_rendering = false;  // Draw PPU dots on a worker thread
+    static constexpr int MAX_OVERCLOCK_LINES = 1000;
+    int m_overclock_lines = 0;    // Extra CPU-only scanlines at VBlank
+    bool m_enhancements_allowed = true;  // Host switch for m_overclock_lines
     uint32_t m_rom_crc32 = 0;
     uint64_t m_total_cycles = 0;
     uint64_t m_frame_count = 0;
 
-    // Framebuffer (256x224 native, stored as 256x240 for overscan handling)
-    uint32_t m_framebuffer[256 * 240];
+    // Framebuffer, sized for the largest frame (512x239: hi-res with overscan)
+    uint32_t m_framebuffer[512 * 239];
+    int m_frame_width = 256;
+    int m_frame_height = 224;
+    uint32_t* m_output_framebuffer = nullptr;       // Host buffer frames are drawn into, if set
+    uint32_t* m_shown_framebuffer = m_framebuffer;  // Holds the last frame drawn
 
     // Audio buffer
     static constexpr size_t AUDIO_BUFFER_SIZE = 2048;
     float m_audio_buffer[AUDIO_BUFFER_SIZE * 2];  // Stereo
     size_t m_audio_samples = 0;
 
+    // Rollback state size, measured once per cartridge in load_rom()
+    size_t m_max_state_size = 0;
+
+    // Scratch buffer for get_state_hash(), sized alongside m_max_state_size
+    mutable std::vector<uint8_t> m_hash_buffer;
+
+    // clone_into() stages the state here, on the receiving instance
+    std::vector<uint8_t> m_clone_state;
+
+    // Subsystem being run, for the benchmark's breakdown
+    emu::ProfileMarker m_profile;
+
+    // Frame phase tracing, if the host is recording
+    emu::Tracer* m_tracer = nullptr;
+
+    // Debug output limits (DEBUG=1)
+    int m_debug_cpu_trace_count = 0;
+
     // File extensions
     static const char* s_extensions[];
 };
@@ -134,6 +271,9 @@ SNESPlugin::SNESPlugin() {
     m_bus->connect_apu(m_apu.get());
     m_bus->connect_dma(m_dma.get());
     m_bus->connect_cartridge(m_cartridge.get());
+    m_write_watch.set_clock(&m_total_cycles);
+    m_breakpoints.set_clock(&m_total_cycles);
+    m_cpu->set_access_sync(&SNESPlugin::sync_cpu_access, this);
 }
 
 SNESPlugin::~SNESPlugin() = default;
@@ -165,20 +305,36 @@ bool SNESPlugin::load_rom(const uint8_t* data, size_t size) {
         return false;
     }
 
+    m_coprocessor = create_coprocessor(m_cartridge->get_enhancement_chip(), *m_cartridge);
+    m_bus->connect_coprocessor(m_coprocessor.get());
+    m_bus->build_page_map();
     m_rom_loaded = true;
     m_rom_crc32 = m_cartridge->get_crc32();
     reset();
 
+    // Every component serializes a fixed amount of data for a given cartridge
+    // (SRAM size is the only variable part), so one sizing pass gives the
+    // rollback buffer size. Round up to 4KB to leave headroom.
+    StateWriter sizer(nullptr, 0);
+    serialize_state(sizer);
+    m_max_state_size = (sizer.size() + 0xFFF) & ~static_cast<size_t>(0xFFF);
+    m_hash_buffer.assign(m_max_state_size, 0);
+
     std::cout << "SNES ROM loaded, CRC32: " << std::hex << m_rom_crc32 << std::dec << std::endl;
     return true;
 }
 
 void SNESPlugin::unload_rom() {
     m_cartridge->unload();
+    m_bus->connect_coprocessor(nullptr);
+    m_coprocessor.reset();
+    m_bus->build_page_map();
     m_rom_loaded = false;
     m_rom_crc32 = 0;
     m_total_cycles = 0;
     m_frame_count = 0;
+    m_max_state_size = 0;
+    m_hash_buffer.clear();
 }
 
 bool SNESPlugin::is_rom_loaded() const {
@@ -195,6 +351,7 @@ void SNESPlugin::reset() {
     m_apu->reset();
     m_dma->reset();
     m_cartridge->reset();
+    if (m_coprocessor) m_coprocessor->reset();
     m_total_cycles = 0;
     m_frame_count = 0;
     m_audio_samples = 0;
@@ -208,6 +365,7 @@ void SNESPlugin::reset() {
     // Reference: The IPL ROM clears ~240 bytes of memory (240 iterations * ~8 cycles)
     // plus some initialization, totaling roughly 2000-2500 SPC cycles.
     m_apu->step(50000);  // Run APU for ~50000 master cycles (~2380 SPC cycles)
+    m_apu->sync();
 }
 
 uint32_t SNESPlugin::convert_input(uint32_t buttons) {
@@ -246,8 +404,144 @@ uint32_t SNESPlugin::convert_input(uint32_t buttons) {
 }
 
 void SNESPlugin::run_frame(const emu::InputState& input) {
+    // Single-player run_frame - mirror the input to both ports
+    // SMAS reads from port 2 for game select scroll
+    run_frame_internal(input.buttons, input.buttons);
+}
+
+void SNESPlugin::run_frames(const emu::InputState* inputs, size_t count, emu::RunFlags flags) {
+    if (!m_rom_loaded || count == 0) return;
+
+    // Output is switched once around the batch instead of per frame, and the
+    // frames run straight through without going back through the interface
+    bool skip_video = (flags & emu::RUN_FLAGS_SKIP_VIDEO) && count > 1;
+    bool skip_audio = (flags & emu::RUN_FLAGS_SKIP_AUDIO) && count > 1;
+    if (skip_video) set_video_enabled(false);
+    if (skip_audio) set_audio_enabled(false);
+
+    for (size_t i = 0; i + 1 < count; i++) {
+        run_frame_internal(inputs[i].buttons, inputs[i].buttons);
+    }
+
+    if (skip_video) set_video_enabled(true);
+    if (skip_audio) set_audio_enabled(true);
+    run_frame_internal(inputs[count - 1].buttons, inputs[count - 1].buttons);
+}
+
+void SNESPlugin::run_frame_netplay(uint32_t player1_buttons, uint32_t player2_buttons) {
+    // Netplay version - each player drives their own controller port
+    // Input is a raw VirtualButton bitmask, same as run_frame()
+    run_frame_internal(player1_buttons, player2_buttons);
+}
+
+void SNESPlugin::advance_components(int master_cycles, bool advance_ppu) {
+    if (master_cycles == 0) return;
+
+    // Advance PPU timing - this may trigger catch-up rendering
+    // and handles sprite evaluation at dot 285
+    if (advance_ppu) {
+        m_profile.set(emu::ProfileSection::PPU);
+        m_ppu->advance(master_cycles);
+        m_profile.set(emu::ProfileSection::CPU);
+    }
+
+    // Update H-counter and check for H-IRQ trigger
+    m_bus->update_hcounter(master_cycles);
+    m_bus->add_cycles(master_cycles);
+
+    // Poll NMI state (edge detection)
+    m_bus->poll_nmi();
+
+    // Check for H-IRQ at proper dot position
+    m_bus->check_irq_trigger();
+
+    // Step APU (runs at its own clock)
+    m_profile.set(emu::ProfileSection::APU);
+    m_apu->step(master_cycles);
+    if (m_coprocessor) m_coprocessor->step(master_cycles);
+    m_profile.set(emu::ProfileSection::CPU);
+}
+
+void SNESPlugin::sync_cpu_access(void* context, int cycles) {
+    auto* plugin = static_cast<SNESPlugin*>(context);
+    plugin->advance_components((cycles - plugin->m_instruction_synced) * 6, true);
+    plugin->m_instruction_synced = cycles;
+}
+
+int SNESPlugin::get_idle_cycles(int line_cycles_left) {
+    int limit = std::min(line_cycles_left, m_bus->get_cycles_until_interrupt());
+    if (m_coprocessor) limit = std::min(limit, m_coprocessor->get_cycles_until_sync());
+
+    // Master cycles per step or pass
+    int unit;
+    CPU::PollLoop loop;
+    if (m_cpu->is_idle()) {
+        unit = 6 * 6;
+    } else if (m_cpu->take_poll_loop(loop)) {
+        unit = loop.cycles * 6;
+        // HVBJOY's V-blank flag can only change as the PPU starts a line,
+        // and its H-blank flag at dot 274
+        if ((loop.address & 0xFFFF) == 0x4212) {
+            limit = std::min(limit, m_ppu->get_cycles_until_dot(0));
+            if ((loop.bits & 0x40) && m_ppu->get_dot() < 274) {
+                limit = std::min(limit, m_ppu->get_cycles_until_dot(274));
+            }
+        }
+    } else {
+        return 0;
+    }
+
+    // Ending short of the limit leaves whatever happens there to the
+    // ordinary path
+    int units = (limit - 1) / unit;
+    return units >= 2 ? units * unit / 6 : 0;
+}
+
+void SNESPlugin::run_overclock() {
+    EMU_TRACE_SCOPE(m_tracer, "snes", "overclock");
+    int budget = m_overclock_lines * 340 * 4;
+
+    // The PPU and counters are held, so there is nothing to sync accesses to
+    m_cpu->set_access_sync(nullptr, nullptr);
+
+    for (int cycles = 0; cycles < budget;) {
+        // General DMA from the NMI handler still takes its time
+        int dma_cycles = m_dma->get_dma_cycles();
+        if (dma_cycles > 0) {
+            cycles += dma_cycles;
+            m_total_cycles += dma_cycles;
+            m_bus->add_cycles(dma_cycles);
+            m_dma->clear_dma_cycles();
+            continue;
+        }
+
+        int master_cycles = m_cpu->step() * 6;
+        cycles += master_cycles;
+        m_total_cycles += master_cycles;
+
+        // NMI hold, IRQ lock and the auto-joypad busy flag are CPU-side and
+        // keep counting; H/V IRQs can't fire with the counters held
+        m_bus->add_cycles(master_cycles);
+        m_bus->poll_nmi();
+        if (m_bus->nmi_pending()) {
+            m_cpu->trigger_nmi();
+            m_bus->clear_nmi();
+        }
+        m_cpu->set_irq_line(m_bus->irq_pending());
+    }
+    m_cpu->set_access_sync(&SNESPlugin::sync_cpu_access, this);
+}
+
+void SNESPlugin::run_frame_internal(uint32_t player1_buttons, uint32_t player2_buttons) {
     if (!m_rom_loaded) return;
 
+    // Marked around each subsystem call below; PPU catch-up triggered by
+    // register writes and DMA started mid-instruction count as CPU
+    emu::ProfileScope profile(m_profile, emu::ProfileSection::CPU);
+    EMU_TRACE_SCOPE(m_tracer, "snes", "frame");
+    if (!m_write_watch.empty()) m_write_watch.begin_frame(m_total_cycles);
+    if (!m_breakpoints.empty()) m_breakpoints.begin_frame(m_total_cycles);
+
     // Debug: Output diagnostic info for the first few frames and periodically
     if (m_frame_count < 5 || (is_debug_mode() && m_frame_count % 100 == 0)) {
         SNES_DEBUG_PRINT("Frame %llu: PC=$%02X:%04X force_blank=%d brightness=%d TM=$%02X\n",
@@ -260,9 +554,9 @@ void SNESPlugin::run_frame(const emu::InputState& input) {
 
     // Set controller state at the start of the frame
     // Pass raw VirtualButton bitmask - set_controller_state does the conversion
-    // Set both controller ports - SMAS reads from port 2 for game select scroll
-    m_bus->set_controller_state(0, input.buttons);
-    m_bus->set_controller_state(1, input.buttons);
+    m_bus->set_controller_state(0, player1_buttons);
+    m_bus->set_controller_state(1, player2_buttons);
+    m_bus->clear_controller_read();
 
     // SNES timing:
     // Master clock: 21.477272 MHz (NTSC)
@@ -300,7 +594,7 @@ void SNESPlugin::run_frame(const emu::InputState& input) {
     // ========================================================================
 
     // TEMPORARY: Use old render_scanline for debugging
-    static bool use_old_rendering = false;  // Using new catch-up rendering
+    constexpr bool use_old_rendering = false;  // Using new catch-up rendering
 
     // Initialize PPU timing for frame start
     // This resets the rendered state for the new frame
@@ -339,13 +633,16 @@ void SNESPlugin::run_frame(const emu::InputState& input) {
             int dma_cycles = m_dma->get_dma_cycles();
             if (dma_cycles > 0) {
                 // DMA halts CPU - just accumulate cycles
+                m_profile.set(emu::ProfileSection::DMA);
                 cycles_this_scanline += dma_cycles;
                 m_total_cycles += dma_cycles;
 
                 // Advance PPU timing during DMA
                 // PPU continues running even while CPU is halted
                 if (!use_old_rendering) {
+                    m_profile.set(emu::ProfileSection::PPU);
                     m_ppu->advance(dma_cycles);
+                    m_profile.set(emu::ProfileSection::DMA);
                 }
 
                 // Update H-counter during DMA (IRQ can still fire)
@@ -353,22 +650,27 @@ void SNESPlugin::run_frame(const emu::InputState& input) {
                 m_bus->add_cycles(dma_cycles);
 
                 // APU continues during DMA
+                m_profile.set(emu::ProfileSection::APU);
                 m_apu->step(dma_cycles);
+                if (m_coprocessor) m_coprocessor->step(dma_cycles);
 
                 m_dma->clear_dma_cycles();
                 continue;
             }
 
-            // Step CPU
-            int cpu_cycles = m_cpu->step();
+            // Step CPU, or pass a stretch it would spend waiting in one go;
+            // the components below then catch up in bulk
+            m_profile.set(emu::ProfileSection::CPU);
+            m_instruction_synced = 0;
+            int cpu_cycles = get_idle_cycles(target_cycles - cycles_this_scanline);
+            if (cpu_cycles == 0) cpu_cycles = m_cpu->step();
 
             // Debug: Trace CPU PC during transition frames
-            static int trace_count = 0;
-            if (is_debug_mode() && m_frame_count >= 265 && m_frame_count <= 280 && trace_count < 50) {
+            if (is_debug_mode() && m_frame_count >= 265 && m_frame_count <= 280 && m_debug_cpu_trace_count < 50) {
                 if (scanline == 0 && cycles_this_scanline < 100) {
                     fprintf(stderr, "[SNES/CPU] F%d PC=$%02X:%04X\n",
                         m_frame_count, m_cpu->get_pbr(), m_cpu->get_pc());
-                    trace_count++;
+                    m_debug_cpu_trace_count++;
                 }
             }
 
@@ -378,24 +680,9 @@ void SNESPlugin::run_frame(const emu::InputState& input) {
             cycles_this_scanline += master_cycles;
             m_total_cycles += master_cycles;
 
-            // Advance PPU timing - this may trigger catch-up rendering
-            // and handles sprite evaluation at dot 285
-            if (!use_old_rendering) {
-                m_ppu->advance(master_cycles);
-            }
-
-            // Update H-counter and check for H-IRQ trigger
-            m_bus->update_hcounter(master_cycles);
-            m_bus->add_cycles(master_cycles);
-
-            // Poll NMI state (edge detection)
-            m_bus->poll_nmi();
-
-            // Check for H-IRQ at proper dot position
-            m_bus->check_irq_trigger();
-
-            // Step APU (runs at its own clock)
-            m_apu->step(master_cycles);
+            // Everything else moves once per instruction, by what timed
+            // register accesses didn't already move it
+            advance_components((cpu_cycles - m_instruction_synced) * 6, !use_old_rendering);
 
             // Check for NMI (edge-triggered)
             if (m_bus->nmi_pending()) {
@@ -417,7 +704,9 @@ void SNESPlugin::run_frame(const emu::InputState& input) {
         // Note: We don't use set_timing here because advance() has already updated
         // the PPU clock - we just need to render any pending pixels.
         if (!use_old_rendering) {
+            m_profile.set(emu::ProfileSection::PPU);
             m_ppu->sync_to_current();
+            m_profile.set(emu::ProfileSection::CPU);
         }
 
         // H-blank processing
@@ -427,51 +716,74 @@ void SNESPlugin::run_frame(const emu::InputState& input) {
         // With catch-up rendering, pixels are already rendered, so HDMA
         // changes will affect the NEXT scanline's rendering.
         if (scanline < 225) {
+            EMU_TRACE_SCOPE(m_tracer, "snes", "hdma");
+            m_profile.set(emu::ProfileSection::DMA);
             m_dma->hdma_transfer();
+            m_profile.set(emu::ProfileSection::CPU);
         }
 
         // V-blank starts at scanline 225
         if (scanline == 225) {
             m_bus->start_vblank();
+            if (m_overclock_lines > 0 && m_enhancements_allowed) {
+                run_overclock();
+            }
         }
     }
 
     // Final catch-up: ensure all remaining pixels are rendered
+    m_profile.set(emu::ProfileSection::PPU);
     if (!use_old_rendering) {
         m_ppu->sync_to_current();
     }
 
     // Copy PPU framebuffer
-    // The PPU may render at 256 or 512 width depending on pseudo-hires/Mode 5-6
-    // We need to handle this properly - for now, always sample from the PPU's
-    // native resolution to our 256x224 output buffer
-    const uint32_t* ppu_fb = m_ppu->get_framebuffer();
-    int ppu_width = m_ppu->get_screen_width();  // 256 or 512
-    (void)m_ppu->get_screen_height(); // 224 or 239 (unused for now, we always output 224)
-
-    if (ppu_width == 256) {
-        // Standard mode - direct copy
-        std::memcpy(m_framebuffer, ppu_fb, 256 * 224 * sizeof(uint32_t));
-    } else {
-        // Pseudo-hires or Mode 5/6: PPU renders at 512 width
-        // For now, we downsample by taking every other pixel (or averaging)
-        // This gives a usable 256-width output from the 512-width source
-        for (int y = 0; y < 224; y++) {
-            for (int x = 0; x < 256; x++) {
-                // Simple nearest-neighbor: take the "main screen" pixel (odd index)
-                // In pseudo-hires, even pixels are sub screen, odd are main screen
-                m_framebuffer[y * 256 + x] = ppu_fb[y * 512 + x * 2 + 1];
+    // The frame comes out at its own size: 256 wide unless some line used
+    // pseudo-hires or Mode 5/6, then 512 with the lo-res lines doubled
+    if (m_video_enabled) {
+        EMU_TRACE_SCOPE(m_tracer, "snes", "video");
+        m_ppu->sync_rendering();
+        const uint32_t* ppu_fb = m_ppu->get_framebuffer();
+        const int height = m_ppu->get_screen_height();  // 224 or 239
+        bool hires = false;
+        for (int y = 0; y < height && !hires; y++) hires = m_ppu->is_line_hires(y);
+        const int width = hires ? 512 : 256;
+
+        // The host's buffer is sized for the common 256x224 frame
+        uint32_t* out = (m_output_framebuffer && width == 256 && height == 224) ? m_output_framebuffer
+                                                                              : m_framebuffer;
+        for (int y = 0; y < height; y++) {
+            const uint32_t* src = ppu_fb + y * 512;
+            uint32_t* dst = out + y * width;
+            if (!hires) {
+                for (int x = 0; x < 256; x++) dst[x] = src[x * 2];
+            } else if (m_ppu->is_line_hires(y)) {
+                std::memcpy(dst, src, 512 * sizeof(uint32_t));
+            } else {
+                for (int x = 0; x < 256; x++) dst[x * 2] = dst[x * 2 + 1] = src[x * 2];
             }
         }
+        m_frame_width = width;
+        m_frame_height = height;
+        m_shown_framebuffer = out;
     }
 
     // Notify PPU frame complete (updates internal frame counter)
     m_ppu->end_frame();
 
-    // Get audio samples
-    m_audio_samples = m_apu->get_samples(m_audio_buffer, AUDIO_BUFFER_SIZE);
+    // Run the APU and coprocessor up to the end of the frame, then get
+    // audio samples
+    {
+        EMU_TRACE_SCOPE(m_tracer, "snes", "audio");
+        m_profile.set(emu::ProfileSection::APU);
+        if (m_coprocessor) m_coprocessor->sync();
+        m_apu->sync();
+        m_audio_samples = m_apu->get_samples(m_audio_buffer, AUDIO_BUFFER_SIZE);
+    }
 
     m_frame_count++;
+    if (!m_write_watch.empty()) m_write_watch.end_frame(m_total_cycles, m_frame_count);
+    if (!m_breakpoints.empty()) m_breakpoints.end_frame(m_total_cycles, m_frame_count);
 
     // Check for Blargg test completion and report results
     if (m_bus->blargg_test_completed()) {
@@ -489,9 +801,9 @@ uint64_t SNESPlugin::get_frame_count() const {
 
 emu::FrameBuffer SNESPlugin::get_framebuffer() {
     emu::FrameBuffer fb;
-    fb.pixels = m_framebuffer;
-    fb.width = 256;
-    fb.height = 224;
+    fb.pixels = m_shown_framebuffer;
+    fb.width = m_frame_width;
+    fb.height = m_frame_height;
     return fb;
 }
 
@@ -499,7 +811,7 @@ emu::AudioBuffer SNESPlugin::get_audio() {
     emu::AudioBuffer ab;
     ab.samples = m_audio_buffer;
     ab.sample_count = static_cast<int>(m_audio_samples);
-    ab.sample_rate = 32000;  // DSP outputs at 32 kHz
+    ab.sample_rate = m_apu->get_sample_rate();
     return ab;
 }
 
@@ -507,22 +819,41 @@ void SNESPlugin::clear_audio_buffer() {
     m_audio_samples = 0;
 }
 
-void SNESPlugin::set_audio_callback(AudioStreamCallback callback) {
+void SNESPlugin::set_audio_sink(const emu::AudioStreamSink& sink) {
     // Store in base class
-    m_audio_callback = callback;
+    m_audio_sink = sink;
 
     // Forward to APU for direct streaming
     if (m_apu) {
-        if (callback) {
-            m_apu->set_audio_callback([callback](const float* samples, size_t count, int rate) {
-                callback(samples, count, rate);
-            });
-        } else {
-            m_apu->set_audio_callback(nullptr);
-        }
+        m_apu->set_audio_sink(sink);
+    }
+}
+
+void SNESPlugin::set_audio_enabled(bool enabled) {
+    if (m_apu) {
+        m_apu->set_audio_enabled(enabled);
     }
 }
 
+void SNESPlugin::set_video_enabled(bool enabled) {
+    m_video_enabled = enabled;
+    if (m_ppu) {
+        m_ppu->set_video_enabled(enabled);
+    }
+}
+
+bool SNESPlugin::set_output_framebuffer(uint32_t* pixels, int pitch) {
+    if (pixels && pitch != 256) return false;
+
+    // Keep the last frame when going back to our own buffer
+    if (!pixels && m_shown_framebuffer != m_framebuffer) {
+        std::memcpy(m_framebuffer, m_shown_framebuffer, m_frame_width * m_frame_height * sizeof(uint32_t));
+        m_shown_framebuffer = m_framebuffer;
+    }
+    m_output_framebuffer = pixels;
+    return true;
+}
+
 uint8_t SNESPlugin::read_memory(uint16_t address) {
     // Read from bank 0 by default (for debug purposes)
     return m_bus->read(address);
@@ -533,6 +864,84 @@ void SNESPlugin::write_memory(uint16_t address, uint8_t value) {
     m_bus->write(address, value);
 }
 
+bool SNESPlugin::get_memory_domain(size_t index, emu::MemoryDomain& domain) const {
+    switch (index) {
+        case 0: domain = {"CPU Bus", 0x1000000, nullptr}; return true;
+        case 1: domain = {"WRAM", 0x20000, m_bus->get_wram_data()}; return true;
+        case 2: domain = {"VRAM", 0x10000, m_ppu->get_vram_data()}; return true;
+        case 3: domain = {"OAM", 544, m_ppu->get_oam_data()}; return true;
+        case 4: domain = {"CGRAM", 512, m_ppu->get_cgram_data()}; return true;
+        case 5:
+            domain = {"SRAM", static_cast<uint32_t>(m_cartridge->get_ram_size()), m_cartridge->get_ram_data()};
+            return true;
+        case 6:
+            domain = {"ROM", static_cast<uint32_t>(m_cartridge->get_rom_size()), m_cartridge->get_rom_data()};
+            return true;
+        default: return false;
+    }
+}
+
+bool SNESPlugin::set_write_watchpoints(const uint32_t* addresses, size_t count) {
+    m_write_watch.set(addresses, count);
+    m_bus->set_write_watch(m_write_watch.empty() ? nullptr : &m_write_watch);
+    return true;
+}
+
+bool SNESPlugin::set_cpu_trace(emu::CpuTrace* trace) {
+    if (trace) trace->set_clock(&m_total_cycles);
+    m_cpu->set_trace(trace);
+    return true;
+}
+
+size_t SNESPlugin::take_write_watch_hits(emu::WriteWatchHit* out, size_t max) {
+    return m_write_watch.take(out, max);
+}
+
+bool SNESPlugin::set_breakpoints(const emu::Breakpoint* breakpoints, size_t count) {
+    m_breakpoints.set(breakpoints, count);
+    uint8_t kinds = m_breakpoints.kinds();
+    m_cpu->set_breakpoints(kinds & emu::BREAK_EXECUTE ? &m_breakpoints : nullptr);
+    m_bus->set_breakpoints(kinds & (emu::BREAK_READ | emu::BREAK_WRITE) ? &m_breakpoints : nullptr);
+    return true;
+}
+
+size_t SNESPlugin::take_breakpoint_hits(emu::BreakpointHit* out, size_t max) {
+    return m_breakpoints.take(out, max);
+}
+
+std::vector<emu::MemoryDomain> SNESPlugin::get_memory_domains() {
+    std::vector<emu::MemoryDomain> domains;
+    emu::MemoryDomain domain;
+    for (size_t i = 0; get_memory_domain(i, domain); i++) {
+        domains.push_back(domain);
+    }
+    return domains;
+}
+
+bool SNESPlugin::read_memory_block(size_t domain, uint32_t address, size_t length, uint8_t* out) {
+    if (domain == 0) {
+        // WRAM and ROM are copied a run at a time. Everything else reads as
+        // open bus, since reading I/O registers would change them
+        if (address > 0x1000000 || length > 0x1000000 - address) return false;
+        while (length > 0) {
+            int run = 0;
+            const uint8_t* source = m_bus->get_dma_source(address, run);
+            size_t count = source ? std::min(length, static_cast<size_t>(run)) : 1;
+            if (source) {
+                std::memcpy(out, source, count);
+            } else {
+                *out = m_bus->get_open_bus();
+            }
+            out += count;
+            address += static_cast<uint32_t>(count);
+            length -= count;
+        }
+        return true;
+    }
+    emu::MemoryDomain info;
+    return get_memory_domain(domain, info) && emu::copy_memory_domain(info, address, length, out);
+}
+
 bool SNESPlugin::save_state(std::vector<uint8_t>& data) {
     if (!m_rom_loaded) return false;
 
@@ -540,21 +949,8 @@ bool SNESPlugin::save_state(std::vector<uint8_t>& data) {
         data.clear();
         data.reserve(256 * 1024);  // Reserve 256KB
 
-        // Save frame count and cycle count
-        const uint8_t* fc_ptr = reinterpret_cast<const uint8_t*>(&m_frame_count);
-        data.insert(data.end(), fc_ptr, fc_ptr + sizeof(m_frame_count));
-
-        const uint8_t* tc_ptr = reinterpret_cast<const uint8_t*>(&m_total_cycles);
-        data.insert(data.end(), tc_ptr, tc_ptr + sizeof(m_total_cycles));
-
-        // Save each component
-        m_cpu->save_state(data);
-        m_ppu->save_state(data);
-        m_apu->save_state(data);
-        m_dma->save_state(data);
-        m_bus->save_state(data);
-        m_cartridge->save_state(data);
-
+        StateWriter writer(data);
+        serialize_state(writer);
         return true;
     } catch (...) {
         return false;
@@ -565,33 +961,145 @@ bool SNESPlugin::load_state(const std::vector<uint8_t>& data) {
     if (!m_rom_loaded || data.empty()) return false;
 
     try {
-        const uint8_t* ptr = data.data();
-        size_t remaining = data.size();
+        return deserialize_state(data.data(), data.size());
+    } catch (...) {
+        return false;
+    }
+}
+
+// Layout version of every chunk this core writes; bump a chunk's own when
+// its subsystem's save_state() changes, and keep loading the old one
+static constexpr uint16_t SNES_CHUNK_VERSION = 1;
+static constexpr uint16_t SNES_PPU_CHUNK_VERSION = 2;   // 2: every register and latch
+static constexpr uint16_t SNES_APU_CHUNK_VERSION = 2;   // 2: DSP voices and SPC700 timer dividers
+
+static uint16_t snes_chunk_version(uint32_t tag) {
+    switch (tag) {
+        case emu::STATE_CHUNK_PPU: return SNES_PPU_CHUNK_VERSION;
+        case emu::STATE_CHUNK_APU: return SNES_APU_CHUNK_VERSION;
+        default: return SNES_CHUNK_VERSION;
+    }
+}
+
+void SNESPlugin::serialize_state(StateWriter& out) const {
+    emu::write_state_chunks_magic(out);
+
+    emu::write_state_chunk(out, emu::STATE_CHUNK_TIMING, SNES_CHUNK_VERSION, [&] {
+        out.write(&m_frame_count, sizeof(m_frame_count));
+        out.write(&m_total_cycles, sizeof(m_total_cycles));
+    });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_CPU, SNES_CHUNK_VERSION, [&] { m_cpu->save_state(out); });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_PPU, SNES_PPU_CHUNK_VERSION, [&] {
+        m_ppu->save_state(out);
+        m_ppu->save_registers(out);
+    });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_APU, SNES_APU_CHUNK_VERSION, [&] {
+        m_apu->save_state(out);
+        m_apu->save_internal_state(out);
+    });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_DMA, SNES_CHUNK_VERSION, [&] { m_dma->save_state(out); });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_WORK_RAM, SNES_CHUNK_VERSION, [&] { m_bus->save_work_ram(out); });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_BUS, SNES_CHUNK_VERSION, [&] { m_bus->save_registers(out); });
+    emu::write_state_chunk(out, emu::STATE_CHUNK_CARTRIDGE, SNES_CHUNK_VERSION, [&] { m_cartridge->save_state(out); });
+    if (m_coprocessor) {
+        emu::write_state_chunk(out, emu::STATE_CHUNK_COPROCESSOR, SNES_CHUNK_VERSION, [&] { m_coprocessor->save_state(out); });
+    }
+}
+
+bool SNESPlugin::deserialize_state(const uint8_t* buffer, size_t size) {
+    return deserialize_chunks(buffer, size, nullptr, 0);
+}
+
+bool SNESPlugin::load_state_chunks(const uint8_t* data, size_t size, const uint32_t* tags, size_t tag_count) {
+    if (!m_rom_loaded || !data || !tags || tag_count == 0) return false;
+    return deserialize_chunks(data, size, tags, tag_count);
+}
 
-        // Load frame count and cycle count
-        if (remaining < sizeof(m_frame_count) + sizeof(m_total_cycles)) {
+bool SNESPlugin::deserialize_chunks(const uint8_t* buffer, size_t size, const uint32_t* tags, size_t tag_count) {
+    emu::StateChunkReader reader(buffer, size);
+    if (!reader.is_chunked()) {
+        // Old states can only be loaded whole
+        return !tags && deserialize_unchunked_state(buffer, size);
+    }
+
+    bool loaded = false;
+    emu::StateChunk chunk;
+    while (reader.next(chunk)) {
+        if (!emu::state_chunk_selected(chunk.tag, tags, tag_count)) continue;
+        if (chunk.version > snes_chunk_version(chunk.tag)) {
+            std::cerr << "[SNES] Save state is from a newer version" << std::endl;
+            return false;
+        }
+        if (!load_state_chunk(chunk)) {
             return false;
         }
-        std::memcpy(&m_frame_count, ptr, sizeof(m_frame_count));
-        ptr += sizeof(m_frame_count);
-        remaining -= sizeof(m_frame_count);
-
-        std::memcpy(&m_total_cycles, ptr, sizeof(m_total_cycles));
-        ptr += sizeof(m_total_cycles);
-        remaining -= sizeof(m_total_cycles);
-
-        // Load each component
-        m_cpu->load_state(ptr, remaining);
-        m_ppu->load_state(ptr, remaining);
-        m_apu->load_state(ptr, remaining);
-        m_dma->load_state(ptr, remaining);
-        m_bus->load_state(ptr, remaining);
-        m_cartridge->load_state(ptr, remaining);
+        loaded = true;
+    }
+    return loaded && !reader.malformed();
+}
 
-        return true;
-    } catch (...) {
+bool SNESPlugin::load_state_chunk(const emu::StateChunk& chunk) {
+    const uint8_t* ptr = chunk.data;
+    size_t remaining = chunk.size;
+
+    switch (chunk.tag) {
+        case emu::STATE_CHUNK_TIMING:
+            if (remaining < sizeof(m_frame_count) + sizeof(m_total_cycles)) return false;
+            std::memcpy(&m_frame_count, ptr, sizeof(m_frame_count));
+            std::memcpy(&m_total_cycles, ptr + sizeof(m_frame_count), sizeof(m_total_cycles));
+            return true;
+        case emu::STATE_CHUNK_CPU: m_cpu->load_state(ptr, remaining); break;
+        case emu::STATE_CHUNK_PPU:
+            m_ppu->load_state(ptr, remaining);
+            if (chunk.version >= 2) m_ppu->load_registers(ptr, remaining);
+            break;
+        case emu::STATE_CHUNK_APU:
+            m_apu->load_state(ptr, remaining);
+            if (chunk.version >= 2) m_apu->load_internal_state(ptr, remaining);
+            break;
+        case emu::STATE_CHUNK_DMA: m_dma->load_state(ptr, remaining); break;
+        case emu::STATE_CHUNK_WORK_RAM: m_bus->load_work_ram(ptr, remaining); break;
+        case emu::STATE_CHUNK_BUS: m_bus->load_registers(ptr, remaining); break;
+        case emu::STATE_CHUNK_CARTRIDGE: m_cartridge->load_state(ptr, remaining); break;
+        case emu::STATE_CHUNK_COPROCESSOR:
+            if (!m_coprocessor) return false;
+            m_coprocessor->load_state(ptr, remaining);
+            break;
+        default:
+            return true;  // Written by a newer build; skipped
+    }
+
+    // The component loaders don't check sizes; one that read past its
+    // chunk has wrapped the count
+    return remaining <= chunk.size;
+}
+
+bool SNESPlugin::deserialize_unchunked_state(const uint8_t* buffer, size_t size) {
+    const uint8_t* ptr = buffer;
+    size_t remaining = size;
+
+    // Load frame count and cycle count
+    if (remaining < sizeof(m_frame_count) + sizeof(m_total_cycles)) {
         return false;
     }
+    std::memcpy(&m_frame_count, ptr, sizeof(m_frame_count));
+    ptr += sizeof(m_frame_count);
+    remaining -= sizeof(m_frame_count);
+
+    std::memcpy(&m_total_cycles, ptr, sizeof(m_total_cycles));
+    ptr += sizeof(m_total_cycles);
+    remaining -= sizeof(m_total_cycles);
+
+    // Load each component
+    m_cpu->load_state(ptr, remaining);
+    m_ppu->load_state(ptr, remaining);
+    m_apu->load_state(ptr, remaining);
+    m_dma->load_state(ptr, remaining);
+    m_bus->load_state(ptr, remaining);
+    m_cartridge->load_state(ptr, remaining);
+    if (m_coprocessor) m_coprocessor->load_state(ptr, remaining);
+
+    return true;
 }
 
 bool SNESPlugin::has_battery_save() const {
@@ -612,8 +1120,160 @@ bool SNESPlugin::set_battery_save_data(const std::vector<uint8_t>& data) {
     return m_cartridge->set_save_data(data);
 }
 
+uint64_t SNESPlugin::get_battery_save_generation() const {
+    return m_cartridge ? m_cartridge->get_save_generation() : 0;
+}
+
+bool SNESPlugin::save_config(const char* path) {
+    std::ofstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    // Simple JSON format
+    file << "{\n";
+    file << "  \"threaded_apu\": " << (m_threaded_apu ? "true" : "false") << ",\n";
+    file << "  \"threaded_rendering\": " << (m_threaded_rendering ? "true" : "false") << ",\n";
+    file << "  \"overclock_lines\": " << m_overclock_lines << "\n";
+    file << "}\n";
+
+    return true;
+}
+
+bool SNESPlugin::load_config(const char* path) {
+    std::ifstream file(path);
+    if (!file) {
+        // File doesn't exist - use defaults (not an error)
+        return true;
+    }
+
+    // Simple JSON parsing (basic, not a full parser)
+    std::string content((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+
+    // Parse threaded_apu
+    size_t pos = content.find("\"threaded_apu\":");
+    if (pos != std::string::npos) {
+        m_threaded_apu = (content.find("true", pos) < content.find("false", pos));
+    }
+
+    // Parse threaded_rendering
+    pos = content.find("\"threaded_rendering\":");
+    if (pos != std::string::npos) {
+        m_threaded_rendering = (content.find("true", pos) < content.find("false", pos));
+    }
+
+    // Parse overclock_lines
+    pos = content.find("\"overclock_lines\":");
+    if (pos != std::string::npos) {
+        pos = content.find(':', pos);
+        m_overclock_lines = std::clamp(std::atoi(content.c_str() + pos + 1), 0, MAX_OVERCLOCK_LINES);
+    }
+
+    m_apu->set_threaded(m_threaded_apu);
+    m_ppu->set_threaded_rendering(m_threaded_rendering);
+
+    return true;
+}
+
+// =============================================================================
+// INetplayCapable Implementation - Fast Save State for Rollback
+// =============================================================================
+
+size_t SNESPlugin::get_max_state_size() const {
+    return m_max_state_size;
+}
+
+size_t SNESPlugin::save_state_fast(uint8_t* buffer, size_t buffer_size) {
+    if (!m_rom_loaded) return 0;
+
+    // If buffer is null, just return required size
+    if (buffer == nullptr) {
+        return get_max_state_size();
+    }
+
+    if (buffer_size < get_max_state_size()) {
+        return 0;  // Buffer too small
+    }
+
+    // Serialize in place - every component writes straight into the
+    // caller's buffer through the cursor, so rollback never allocates
+    StateWriter writer(buffer, buffer_size);
+    serialize_state(writer);
+
+    if (writer.overflowed()) {
+        return 0;  // Shouldn't happen, the size was measured at load time
+    }
+
+    return writer.size();
+}
+
+bool SNESPlugin::load_state_fast(const uint8_t* buffer, size_t size) {
+    if (!m_rom_loaded || buffer == nullptr || size == 0) {
+        return false;
+    }
+
+    // Components read directly from the caller's buffer
+    return deserialize_state(buffer, size);
+}
+
+bool SNESPlugin::clone_into(emu::IEmulatorPlugin* other) {
+    auto* target = dynamic_cast<SNESPlugin*>(other);
+    if (!target || target == this || !m_rom_loaded || !target->m_rom_loaded ||
+        target->m_rom_crc32 != m_rom_crc32) {
+        return false;
+    }
+
+    // Through the fast state path; after the first clone nothing allocates
+    target->m_clone_state.resize(get_max_state_size());
+    size_t size = save_state_fast(target->m_clone_state.data(), target->m_clone_state.size());
+    return size > 0 && target->load_state_fast(target->m_clone_state.data(), size);
+}
+
+// =============================================================================
+// INetplayCapable Implementation - State Hash for Desync Detection
+// =============================================================================
+
+// FNV-1a hash implementation for state hashing
+// This is a fast, non-cryptographic hash suitable for desync detection
+static uint64_t fnv1a_hash(const uint8_t* data, size_t size) {
+    const uint64_t FNV_PRIME = 0x100000001b3ULL;
+    const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+uint64_t SNESPlugin::get_state_hash() const {
+    if (!m_rom_loaded || m_hash_buffer.empty()) return 0;
+
+    // Hash the complete serialized state (CPU, PPU, APU, DMA, WRAM, SRAM)
+    // so any divergence the save state would capture is also detected.
+    // The scratch buffer is sized at load time, so this never allocates.
+    StateWriter writer(m_hash_buffer.data(), m_hash_buffer.size());
+    serialize_state(writer);
+    if (writer.overflowed()) return 0;
+
+    return fnv1a_hash(m_hash_buffer.data(), writer.size());
+}
+
 } // namespace snes
 
+#ifdef VELOCE_STATIC_CORE
+// Static build for veloce_bench, which links every core into one binary
+// and so can't use the shared C entry points below
+namespace snes {
+
+emu::IEmulatorPlugin* create_static_plugin() {
+    return new SNESPlugin();
+}
+
+} // namespace snes
+#else
 // C interface for plugin loading
 extern "C" {
 
@@ -630,3 +1290,4 @@ EMU_PLUGIN_EXPORT uint32_t get_plugin_api_version() {
 }
 
 }
+#endif
@@ -1,6 +1,7 @@
 #include "spc700.hpp"
 #include "dsp.hpp"
 #include "debug.hpp"
+#include "emu/state_writer.hpp"
 #include <cstring>
 
 namespace snes {
@@ -91,8 +92,13 @@ int SPC700::step() {
 uint8_t SPC700::read(uint16_t address) {
     m_cycles += 1;
 
+    // $0100-$FFBF is always plain ARAM
+    if (static_cast<uint16_t>(address - 0x0100) < 0xFEC0) {
+        return m_ram[address];
+    }
+
     // I/O registers ($00F0-$00FF when direct page is 0)
-    if (address >= 0x00F0 && address <= 0x00FF) {
+    if ((address & 0xFFF0) == 0x00F0) {
         switch (address) {
             case 0x00F2:  // DSP address
                 return m_dsp ? m_dsp->read_address() : 0;
@@ -125,79 +131,79 @@ uint8_t SPC700::read(uint16_t address) {
 void SPC700::write(uint16_t address, uint8_t value) {
     m_cycles += 1;
 
+    // Only $00F0-$00FF are registers; writes under the IPL ROM land in ARAM
+    if ((address & 0xFFF0) != 0x00F0) {
+        m_ram[address] = value;
+        return;
+    }
+
     // I/O registers
-    if (address >= 0x00F0 && address <= 0x00FF) {
-        switch (address) {
-            case 0x00F0:  // Test register (undocumented)
-                break;
-            case 0x00F1:  // Control
-                {
-                    // When a timer transitions from disabled to enabled, reset Stage 2 and 3
-                    // Reference: anomie's SPC700 docs - Stage 1 (divider) runs constantly
-                    // and should NOT be reset when timer is enabled
-                    bool new_enable[3] = {
-                        (value & 0x01) != 0,
-                        (value & 0x02) != 0,
-                        (value & 0x04) != 0
-                    };
-                    for (int i = 0; i < 3; i++) {
-                        if (new_enable[i] && !m_timer_enabled[i]) {
-                            // Timer being enabled - reset Stage 2 (counter) and Stage 3 (output)
-                            // Do NOT reset Stage 1 (divider) - it runs constantly
-                            m_timer_counter[i] = 0;
-                            m_timer_output[i] = 0;
-                        }
-                        m_timer_enabled[i] = new_enable[i];
-                    }
-                    m_control = value;
-                    if (value & 0x10) {
-                        m_port_in[0] = 0;
-                        m_port_in[1] = 0;
-                    }
-                    if (value & 0x20) {
-                        m_port_in[2] = 0;
-                        m_port_in[3] = 0;
+    switch (address) {
+        case 0x00F0:  // Test register (undocumented)
+            break;
+        case 0x00F1:  // Control
+            {
+                // When a timer transitions from disabled to enabled, reset Stage 2 and 3
+                // Reference: anomie's SPC700 docs - Stage 1 (divider) runs constantly
+                // and should NOT be reset when timer is enabled
+                bool new_enable[3] = {
+                    (value & 0x01) != 0,
+                    (value & 0x02) != 0,
+                    (value & 0x04) != 0
+                };
+                for (int i = 0; i < 3; i++) {
+                    if (new_enable[i] && !m_timer_enabled[i]) {
+                        // Timer being enabled - reset Stage 2 (counter) and Stage 3 (output)
+                        // Do NOT reset Stage 1 (divider) - it runs constantly
+                        m_timer_counter[i] = 0;
+                        m_timer_output[i] = 0;
                     }
-                    m_ipl_rom_enabled = (value & 0x80) != 0;
+                    m_timer_enabled[i] = new_enable[i];
                 }
-                break;
-            case 0x00F2:  // DSP address
-                if (m_dsp) m_dsp->write_address(value);
-                break;
-            case 0x00F3:  // DSP data
-                if (m_dsp) m_dsp->write_data(value);
-                break;
-            case 0x00F4:
-            case 0x00F5:
-            case 0x00F6:
-            case 0x00F7:
-                {
-                    static int port_write_count = 0;
-                    port_write_count++;
-                    if (port_write_count <= 5) {
-                        fprintf(stderr, "[SPC700] Port %d write: $%02X (count=%d, PC=$%04X)\n",
-                            (int)(address - 0x00F4), value, port_write_count, m_pc - 1);
-                    }
+                m_control = value;
+                if (value & 0x10) {
+                    m_port_in[0] = 0;
+                    m_port_in[1] = 0;
                 }
-                m_port_out[address - 0x00F4] = value;
-                break;
-            case 0x00FA:
-                m_timer_target[0] = value;
-                break;
-            case 0x00FB:
-                m_timer_target[1] = value;
-                break;
-            case 0x00FC:
-                m_timer_target[2] = value;
-                break;
-            default:
-                m_ram[address] = value;
-                break;
-        }
-        return;
+                if (value & 0x20) {
+                    m_port_in[2] = 0;
+                    m_port_in[3] = 0;
+                }
+                m_ipl_rom_enabled = (value & 0x80) != 0;
+            }
+            break;
+        case 0x00F2:  // DSP address
+            if (m_dsp) m_dsp->write_address(value);
+            break;
+        case 0x00F3:  // DSP data
+            if (m_dsp) m_dsp->write_data(value);
+            break;
+        case 0x00F4:
+        case 0x00F5:
+        case 0x00F6:
+        case 0x00F7:
+            {
+                m_debug_port_writes++;
+                if (m_debug_port_writes <= 5) {
+                    fprintf(stderr, "[SPC700] Port %d write: $%02X (count=%d, PC=$%04X)\n",
+                        (int)(address - 0x00F4), value, m_debug_port_writes, m_pc - 1);
+                }
+            }
+            m_port_out[address - 0x00F4] = value;
+            break;
+        case 0x00FA:
+            m_timer_target[0] = value;
+            break;
+        case 0x00FB:
+            m_timer_target[1] = value;
+            break;
+        case 0x00FC:
+            m_timer_target[2] = value;
+            break;
+        default:
+            m_ram[address] = value;
+            break;
     }
-
-    m_ram[address] = value;
 }
 
 uint8_t SPC700::read_dp(uint8_t address) {
@@ -412,6 +418,14 @@ void SPC700::cpu_write_port(int port, uint8_t value) {
 
 void SPC700::execute() {
     uint8_t opcode = read(m_pc++);
+    (this->*s_op_handlers[opcode])();
+}
+
+// Each instantiation keeps only its own case of the switch, so execute()
+// makes one indirect call instead of going through the whole switch
+template <int OPCODE>
+void SPC700::execute_op() {
+    constexpr uint8_t opcode = OPCODE;
 
     switch (opcode) {
         // MOV A, #imm
@@ -1239,7 +1253,10 @@ void SPC700::execute() {
     }
 }
 
-void SPC700::save_state(std::vector<uint8_t>& data) {
+const std::array<SPC700::OpHandler, 256> SPC700::s_op_handlers =
+    SPC700::make_op_handlers(std::make_index_sequence<256>{});
+
+void SPC700::save_state(StateWriter& data) {
     data.push_back(m_a);
     data.push_back(m_x);
     data.push_back(m_y);
@@ -1250,12 +1267,12 @@ void SPC700::save_state(std::vector<uint8_t>& data) {
     data.push_back(m_control);
     data.push_back(m_ipl_rom_enabled ? 1 : 0);
 
-    data.insert(data.end(), m_ram.begin(), m_ram.end());
-    data.insert(data.end(), m_port_in.begin(), m_port_in.end());
-    data.insert(data.end(), m_port_out.begin(), m_port_out.end());
-    data.insert(data.end(), m_timer_target.begin(), m_timer_target.end());
-    data.insert(data.end(), m_timer_counter.begin(), m_timer_counter.end());
-    data.insert(data.end(), m_timer_output.begin(), m_timer_output.end());
+    data.write(m_ram.data(), m_ram.size());
+    data.write(m_port_in.data(), m_port_in.size());
+    data.write(m_port_out.data(), m_port_out.size());
+    data.write(m_timer_target.data(), m_timer_target.size());
+    data.write(m_timer_counter.data(), m_timer_counter.size());
+    data.write(m_timer_output.data(), m_timer_output.size());
 
     for (int i = 0; i < 3; i++) {
         data.push_back(m_timer_enabled[i] ? 1 : 0);
@@ -1291,4 +1308,15 @@ void SPC700::load_state(const uint8_t*& data, size_t& remaining) {
     }
 }
 
+void SPC700::save_timer_dividers(StateWriter& data) {
+    emu::StateFieldWriter writer(data);
+    writer(m_timer_divider);
+}
+
+void SPC700::load_timer_dividers(const uint8_t*& data, size_t& remaining) {
+    emu::StateFieldReader reader(data, remaining);
+    reader(m_timer_divider);
+    reader.finish();
+}
+
 } // namespace snes
@@ -1,12 +1,16 @@
 #pragma once
 
+#include "emu/state_writer.hpp"
+
 #include <cstdint>
 #include <array>
+#include <utility>
 #include <vector>
 
 namespace snes {
 
 class DSP;
+using emu::StateWriter;
 
 // Sony SPC700 Sound Processor
 // 8-bit CPU running at ~1.024 MHz
@@ -40,8 +44,11 @@ public:
     const uint8_t* get_ram() const { return m_ram.data(); }
 
     // Save state
-    void save_state(std::vector<uint8_t>& data);
+    void save_state(StateWriter& data);
     void load_state(const uint8_t*& data, size_t& remaining);
+    // Cycles banked toward each timer's next tick, after save_state()
+    void save_timer_dividers(StateWriter& data);
+    void load_timer_dividers(const uint8_t*& data, size_t& remaining);
 
     // Debug
     uint16_t get_pc() const { return m_pc; }
@@ -91,6 +98,17 @@ private:
     // Execute single instruction
     void execute();
 
+    // One opcode with its value fixed at compile time; s_op_handlers holds
+    // all 256 instantiations
+    template <int OPCODE> void execute_op();
+
+    using OpHandler = void (SPC700::*)();
+    template <size_t... OPCODES>
+    static constexpr std::array<OpHandler, 256> make_op_handlers(std::index_sequence<OPCODES...>) {
+        return {{&SPC700::execute_op<OPCODES>...}};
+    }
+    static const std::array<OpHandler, 256> s_op_handlers;
+
     // DSP reference
     DSP* m_dsp = nullptr;
 
@@ -135,6 +153,9 @@ private:
     static constexpr uint8_t FLAG_P = 0x20;  // Direct page (0=00xx, 1=01xx)
     static constexpr uint8_t FLAG_V = 0x40;  // Overflow
     static constexpr uint8_t FLAG_N = 0x80;  // Negative
+
+    // Debug output limits (DEBUG=1)
+    int m_debug_port_writes = 0;
 };
 
 } // namespace snes
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace emu {
+
+struct VectorEnvConfig {
+    std::string core;               // "nes", "snes", "gb" or "gba"
+    std::string rom_path;
+    std::string state_path;         // Savestate every reset starts from; power-on if empty
+    int num_envs = 1;
+    int frame_skip = 4;             // Frames per step(), all with the same action
+    int threads = 0;                // Worker count; 0 picks one per hardware thread
+
+    // Observations: frames are the last frame of the step, downscaled by
+    // an integer box filter and stored as RGB or grayscale bytes
+    bool frames = true;
+    int downscale = 1;
+    bool grayscale = false;
+
+    // RAM observations: ram_size bytes (0 for the rest of the domain) from
+    // ram_address in the named memory domain; none if ram_domain is empty
+    std::string ram_domain;
+    uint32_t ram_address = 0;
+    uint32_t ram_size = 0;
+};
+
+// Batched environment for training agents: N independent instances of one
+// core running the same ROM
+//
+// The ROM is read once and shared by every instance, as in the
+// multi-instance job runner. step() runs frame_skip frames on every
+// environment with video off for all but the last, then writes each
+// environment's observations into caller-owned arrays, environment after
+// environment, so they can be wrapped as [N, H, W, C] and [N, ram_size]
+// tensors without a copy. The environments are split into fixed slices,
+// one per worker thread, so an instance always runs on the same thread.
+//
+// Rewards and episode ends are the caller's to work out from the RAM
+// observations.
+class VectorEnv {
+public:
+    // nullptr and error set if the core, ROM, state or RAM range can't be
+    // used
+    static std::unique_ptr<VectorEnv> create(const VectorEnvConfig& config, std::string& error);
+
+    ~VectorEnv();
+
+    VectorEnv(const VectorEnv&) = delete;
+    VectorEnv& operator=(const VectorEnv&) = delete;
+
+    int get_num_envs() const;
+
+    // Observation layout; the sizes are per environment
+    int get_frame_width() const;
+    int get_frame_height() const;
+    int get_frame_channels() const;     // 3 (RGB) or 1 (grayscale)
+    size_t get_frame_size() const;      // 0 if frames are off
+    size_t get_ram_size() const;        // 0 without a RAM domain
+
+    // Put the environments whose flag in mask is set (all of them if mask
+    // is nullptr) back at the start state. frames and ram receive every
+    // environment's observations and may be nullptr when unused.
+    void reset(const uint8_t* mask, uint8_t* frames, uint8_t* ram);
+
+    // Run one step with actions[i] (a button mask, see input_types.hpp)
+    // held on controller 1 of environment i
+    void step(const uint32_t* actions, uint8_t* frames, uint8_t* ram);
+
+private:
+    struct Impl;
+
+    explicit VectorEnv(std::unique_ptr<Impl> impl);
+
+    std::unique_ptr<Impl> m_impl;
+};
+
+} // namespace emu
@@ -0,0 +1,353 @@
+#include "veloce/vector_env.hpp"
+#include "emu/emulator_plugin.hpp"
+#include "emu/netplay_plugin.hpp"
+#include "emu/rom_image.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Factories exported by the cores' static builds (VELOCE_STATIC_CORE)
+namespace nes { emu::IEmulatorPlugin* create_static_plugin(); }
+namespace snes { emu::IEmulatorPlugin* create_static_plugin(); }
+namespace gb { emu::IEmulatorPlugin* create_static_plugin(); }
+namespace gba { emu::IEmulatorPlugin* create_static_plugin(); }
+
+namespace emu {
+
+namespace {
+
+struct CoreEntry {
+    const char* name;
+    IEmulatorPlugin* (*create)();
+};
+
+const CoreEntry CORES[] = {
+    {"nes", nes::create_static_plugin},
+    {"snes", snes::create_static_plugin},
+    {"gb", gb::create_static_plugin},
+    {"gba", gba::create_static_plugin},
+};
+
+bool read_file(const std::string& path, std::vector<uint8_t>& data) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    data.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0, std::ios::beg);
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(data.data()), data.size()));
+}
+
+} // namespace
+
+struct VectorEnv::Impl {
+    VectorEnvConfig config;
+    std::vector<std::unique_ptr<IEmulatorPlugin>> envs;
+    std::shared_ptr<const RomImage> rom;
+
+    // Every reset loads this; a save_state_fast() state when the core has
+    // one, a save_state() state otherwise
+    std::vector<uint8_t> start_state;
+    bool fast_state = false;
+
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    size_t frame_size = 0;
+    size_t ram_domain = 0;
+    size_t ram_size = 0;
+
+    std::vector<InputState> inputs;    // Per worker, frame_skip each
+
+    // The request the workers are running
+    const uint32_t* actions = nullptr;
+    const uint8_t* mask = nullptr;
+    uint8_t* frames = nullptr;
+    uint8_t* ram = nullptr;
+    bool resetting = false;
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable start;
+    std::condition_variable done;
+    uint64_t generation = 0;
+    int pending = 0;
+    bool quit = false;
+
+    ~Impl() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        start.notify_all();
+        for (auto& thread : workers) {
+            thread.join();
+        }
+    }
+
+    bool load_start(IEmulatorPlugin& env) {
+        if (start_state.empty()) {
+            env.reset();
+            return true;
+        }
+        if (fast_state) {
+            auto* netplay = dynamic_cast<INetplayCapable*>(&env);
+            return netplay && netplay->load_state_fast(start_state.data(), start_state.size());
+        }
+        return env.load_state(start_state);
+    }
+
+    // Box filter the last frame drawn down to width x height. The source
+    // rectangles follow the frame's actual size, so cores that switch
+    // resolution mid-game (SNES hi-res) still fill the same layout.
+    void observe_frame(IEmulatorPlugin& env, uint8_t* out) {
+        FrameBuffer fb = env.get_framebuffer();
+        if (!fb.pixels || fb.width <= 0 || fb.height <= 0) {
+            std::memset(out, 0, frame_size);
+            return;
+        }
+
+        for (int y = 0; y < height; y++) {
+            int y0 = y * fb.height / height;
+            int y1 = std::max(y0 + 1, (y + 1) * fb.height / height);
+            for (int x = 0; x < width; x++) {
+                int x0 = x * fb.width / width;
+                int x1 = std::max(x0 + 1, (x + 1) * fb.width / width);
+
+                uint32_t r = 0, g = 0, b = 0;
+                for (int sy = y0; sy < y1; sy++) {
+                    const uint32_t* row = fb.pixels + static_cast<size_t>(sy) * fb.width;
+                    for (int sx = x0; sx < x1; sx++) {
+                        uint32_t pixel = row[sx];
+                        r += (pixel >> 16) & 0xFF;
+                        g += (pixel >> 8) & 0xFF;
+                        b += pixel & 0xFF;
+                    }
+                }
+                uint32_t count = static_cast<uint32_t>((y1 - y0) * (x1 - x0));
+                r /= count;
+                g /= count;
+                b /= count;
+
+                if (channels == 1) {
+                    // BT.601 luma in 8-bit fixed point
+                    *out++ = static_cast<uint8_t>((r * 77 + g * 150 + b * 29) >> 8);
+                } else {
+                    *out++ = static_cast<uint8_t>(r);
+                    *out++ = static_cast<uint8_t>(g);
+                    *out++ = static_cast<uint8_t>(b);
+                }
+            }
+        }
+    }
+
+    void observe(size_t index) {
+        IEmulatorPlugin& env = *envs[index];
+        if (frames && frame_size > 0) {
+            observe_frame(env, frames + index * frame_size);
+        }
+        if (ram && ram_size > 0) {
+            uint8_t* out = ram + index * ram_size;
+            if (!env.read_memory_block(ram_domain, config.ram_address, ram_size, out)) {
+                std::memset(out, 0, ram_size);
+            }
+        }
+    }
+
+    void run_slice(int worker) {
+        size_t count = envs.size();
+        size_t threads = workers.size();
+        size_t begin = count * static_cast<size_t>(worker) / threads;
+        size_t end = count * static_cast<size_t>(worker + 1) / threads;
+        size_t skip = static_cast<size_t>(config.frame_skip);
+        InputState* batch = inputs.data() + static_cast<size_t>(worker) * skip;
+        RunFlags flags = frame_size > 0 ? RUN_FLAGS_SKIP_VIDEO : RUN_FLAGS_NONE;
+
+        for (size_t i = begin; i < end; i++) {
+            IEmulatorPlugin& env = *envs[i];
+            if (resetting) {
+                if (!mask || mask[i]) load_start(env);
+            } else {
+                for (size_t f = 0; f < skip; f++) {
+                    batch[f].buttons = actions[i];
+                }
+                env.run_frames(batch, skip, flags);
+                env.clear_audio_buffer();
+            }
+            observe(i);
+        }
+    }
+
+    void worker_main(int worker) {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                start.wait(lock, [&] { return quit || generation != seen; });
+                if (quit) return;
+                seen = generation;
+            }
+
+            run_slice(worker);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) {
+                done.notify_one();
+            }
+        }
+    }
+
+    // Run the request on every worker and wait for all of them
+    void dispatch() {
+        std::unique_lock<std::mutex> lock(mutex);
+        pending = static_cast<int>(workers.size());
+        generation++;
+        start.notify_all();
+        done.wait(lock, [&] { return pending == 0; });
+    }
+};
+
+VectorEnv::VectorEnv(std::unique_ptr<Impl> impl) : m_impl(std::move(impl)) {}
+
+VectorEnv::~VectorEnv() = default;
+
+std::unique_ptr<VectorEnv> VectorEnv::create(const VectorEnvConfig& config, std::string& error) {
+    const CoreEntry* core = nullptr;
+    for (const auto& entry : CORES) {
+        if (config.core == entry.name) core = &entry;
+    }
+    if (!core) {
+        error = "unknown core \"" + config.core + "\"";
+        return nullptr;
+    }
+    if (config.num_envs <= 0 || config.frame_skip <= 0 || config.downscale <= 0) {
+        error = "num_envs, frame_skip and downscale must be positive";
+        return nullptr;
+    }
+
+    auto impl = std::make_unique<Impl>();
+    impl->config = config;
+
+    std::vector<uint8_t> rom;
+    if (!read_file(config.rom_path, rom) || rom.empty()) {
+        error = "failed to read ROM " + config.rom_path;
+        return nullptr;
+    }
+    impl->rom = std::make_shared<const RomBuffer>(std::move(rom));
+
+    // The first instance checks the ROM, state and RAM range and captures
+    // the start state the others are put in
+    for (int i = 0; i < config.num_envs; i++) {
+        std::unique_ptr<IEmulatorPlugin> env(core->create());
+        if (!env || !env->load_rom_shared(impl->rom)) {
+            error = config.core + " core rejected ROM " + config.rom_path;
+            return nullptr;
+        }
+        env->set_audio_enabled(false);
+        env->set_video_enabled(config.frames);
+        impl->envs.push_back(std::move(env));
+    }
+
+    IEmulatorPlugin& first = *impl->envs[0];
+    if (!config.state_path.empty()) {
+        std::vector<uint8_t> state;
+        if (!read_file(config.state_path, state)) {
+            error = "failed to read state " + config.state_path;
+            return nullptr;
+        }
+        if (!first.load_state(state)) {
+            error = "core rejected state " + config.state_path;
+            return nullptr;
+        }
+    }
+    if (auto* netplay = dynamic_cast<INetplayCapable*>(&first)) {
+        impl->start_state.resize(netplay->get_max_state_size());
+        size_t size = netplay->save_state_fast(impl->start_state.data(), impl->start_state.size());
+        impl->start_state.resize(size);
+        impl->fast_state = size > 0;
+    }
+    if (!impl->fast_state && !first.save_state(impl->start_state)) {
+        // Resets fall back to the core's own reset
+        impl->start_state.clear();
+    }
+    for (auto& env : impl->envs) {
+        if (!impl->load_start(*env)) {
+            error = "core rejected its own start state";
+            return nullptr;
+        }
+    }
+
+    if (config.frames) {
+        EmulatorInfo info = first.get_info();
+        impl->width = info.screen_width / config.downscale;
+        impl->height = info.screen_height / config.downscale;
+        impl->channels = config.grayscale ? 1 : 3;
+        if (impl->width <= 0 || impl->height <= 0) {
+            error = "downscale leaves no pixels";
+            return nullptr;
+        }
+        impl->frame_size = static_cast<size_t>(impl->width) * impl->height * impl->channels;
+    }
+
+    if (!config.ram_domain.empty()) {
+        std::vector<MemoryDomain> domains = first.get_memory_domains();
+        size_t index = domains.size();
+        for (size_t i = 0; i < domains.size(); i++) {
+            if (config.ram_domain == domains[i].name) index = i;
+        }
+        if (index == domains.size()) {
+            error = config.core + " core has no memory domain \"" + config.ram_domain + "\"";
+            return nullptr;
+        }
+        uint32_t domain_size = domains[index].size;
+        if (config.ram_address >= domain_size ||
+            (config.ram_size > 0 && config.ram_size > domain_size - config.ram_address)) {
+            error = "RAM range runs past the end of " + config.ram_domain;
+            return nullptr;
+        }
+        impl->ram_domain = index;
+        impl->ram_size = config.ram_size > 0 ? config.ram_size : domain_size - config.ram_address;
+    }
+
+    int threads = config.threads;
+    if (threads <= 0) {
+        threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    threads = std::min(threads, config.num_envs);
+    impl->inputs.resize(static_cast<size_t>(threads) * static_cast<size_t>(config.frame_skip));
+    impl->workers.reserve(static_cast<size_t>(threads));
+    Impl* shared = impl.get();
+    for (int i = 0; i < threads; i++) {
+        impl->workers.emplace_back([shared, i] { shared->worker_main(i); });
+    }
+
+    return std::unique_ptr<VectorEnv>(new VectorEnv(std::move(impl)));
+}
+
+int VectorEnv::get_num_envs() const { return static_cast<int>(m_impl->envs.size()); }
+int VectorEnv::get_frame_width() const { return m_impl->width; }
+int VectorEnv::get_frame_height() const { return m_impl->height; }
+int VectorEnv::get_frame_channels() const { return m_impl->channels; }
+size_t VectorEnv::get_frame_size() const { return m_impl->frame_size; }
+size_t VectorEnv::get_ram_size() const { return m_impl->ram_size; }
+
+void VectorEnv::reset(const uint8_t* mask, uint8_t* frames, uint8_t* ram) {
+    m_impl->resetting = true;
+    m_impl->mask = mask;
+    m_impl->frames = frames;
+    m_impl->ram = ram;
+    m_impl->dispatch();
+}
+
+void VectorEnv::step(const uint32_t* actions, uint8_t* frames, uint8_t* ram) {
+    m_impl->resetting = false;
+    m_impl->actions = actions;
+    m_impl->frames = frames;
+    m_impl->ram = ram;
+    m_impl->dispatch();
+}
+
+} // namespace emu
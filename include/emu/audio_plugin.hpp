@@ -25,6 +25,14 @@ struct AudioPluginInfo {
     bool supports_effects;      // Has DSP effects
 };
 
+// Describes one parameter of a DSP effect, for building settings UI
+struct AudioEffectParameterInfo {
+    const char* name;       // "Cutoff (Hz)", "Threshold (dB)", etc.
+    float min_value;
+    float max_value;
+    float default_value;
+};
+
 // Audio format specification
 struct AudioFormat {
     int sample_rate;        // 44100, 48000, etc.
@@ -65,6 +73,12 @@ public:
     // Plugin should call host->output_samples() with processed audio
     virtual void process(const float* input, size_t sample_count) = 0;
 
+    // Process interleaved stereo samples in place at the host's output rate,
+    // on the thread that produces audio. The host calls this on its output
+    // path with spans of any length; return false if only process() is
+    // supported. Must not block.
+    virtual bool process_in_place(float* samples, size_t sample_count) { return false; }
+
     // Volume control (0.0 - 1.0)
     virtual void set_volume(float volume) = 0;
     virtual float get_volume() const = 0;
@@ -85,6 +99,8 @@ public:
     virtual void set_effect_enabled(int index, bool enabled) {}
     virtual float get_effect_parameter(int index, int param) const { return 0.0f; }
     virtual void set_effect_parameter(int index, int param, float value) {}
+    virtual int get_effect_parameter_count(int index) const { return 0; }
+    virtual bool get_effect_parameter_info(int index, int param, AudioEffectParameterInfo& info) const { return false; }
 };
 
 } // namespace emu
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace emu {
+
+// Low-latency audio stream from a core to the host
+//
+// Instead of filling its own buffer and handing it over to be copied, a
+// core asks the host for a block and writes interleaved stereo frames into
+// it in place:
+//
+//   size_t room = 0;
+//   float* block = sink.reserve(sink.context, 64, &room);  // 1 <= room <= 64
+//   ... write up to room frames ...
+//   sink.commit(sink.context, frames_written, sample_rate);
+//
+// A block stays valid until it is committed (committing 0 frames gives it
+// back), and only one can be outstanding. Both calls come from the thread
+// that runs the core. Plain function pointers keep the per-block cost to
+// one indirect call.
+struct AudioStreamSink {
+    void* context = nullptr;
+    float* (*reserve)(void* context, size_t frames, size_t* granted) = nullptr;
+    void (*commit)(void* context, size_t frames, int sample_rate) = nullptr;
+
+    explicit operator bool() const { return reserve != nullptr && commit != nullptr; }
+};
+
+// Core-side helper that streams samples through an AudioStreamSink in
+// blocks of BLOCK_FRAMES, holding a reserved block between calls
+class AudioStreamWriter {
+public:
+    static constexpr size_t BLOCK_FRAMES = 64;  // ~1.5 ms at 44.1 kHz
+
+    // Give back any pending block and stream to sink from now on (or stop,
+    // for an empty sink)
+    void set_sink(const AudioStreamSink& sink, int sample_rate) {
+        discard();
+        m_sink = sink;
+        m_sample_rate = sample_rate;
+    }
+
+    bool active() const { return static_cast<bool>(m_sink); }
+
+    void push(float left, float right) {
+        if (!m_block) reserve();
+        m_block[m_used * 2] = left;
+        m_block[m_used * 2 + 1] = right;
+        if (++m_used == m_room) flush();
+    }
+
+    // Stream frames already gathered elsewhere (interleaved stereo)
+    void write(const float* samples, size_t frames) {
+        while (frames > 0) {
+            if (!m_block) reserve();
+            size_t count = std::min(frames, m_room - m_used);
+            std::memcpy(&m_block[m_used * 2], samples, count * 2 * sizeof(float));
+            m_used += count;
+            samples += count * 2;
+            frames -= count;
+            if (m_used == m_room) flush();
+        }
+    }
+
+    // Hand over the frames written so far
+    void flush() {
+        if (!m_block) return;
+        m_sink.commit(m_sink.context, m_used, m_sample_rate);
+        m_block = nullptr;
+        m_used = 0;
+        m_room = 0;
+    }
+
+    // Drop the frames written so far (reset, state load)
+    void discard() {
+        m_used = 0;
+        flush();
+    }
+
+private:
+    void reserve() {
+        m_block = m_sink.reserve(m_sink.context, BLOCK_FRAMES, &m_room);
+        m_used = 0;
+    }
+
+    AudioStreamSink m_sink;
+    int m_sample_rate = 0;
+    float* m_block = nullptr;
+    size_t m_room = 0;
+    size_t m_used = 0;
+};
+
+} // namespace emu
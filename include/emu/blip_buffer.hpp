@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+namespace emu {
+
+// Band-limited step synthesis, shared by the NES, GB and GBA APUs
+// The APU reports each change of its mixed output as (clock time, delta).
+// Every delta is added to the sample buffer as a windowed-sinc step, so a
+// channel holding its level costs nothing and square-wave edges don't alias.
+// end_frame() publishes the samples up to a clock time; read_samples()
+// integrates the deltas into output samples.
+//
+// The sample rate is only an intermediate one: cores hand the result to the
+// host at that rate and the host's resampler converts it to the device rate
+// in the same pass as rate control, so cores never resample themselves.
+class BlipBuffer {
+public:
+    static constexpr int KERNEL_TAPS = 16;
+    static constexpr int PHASE_BITS = 5;
+    static constexpr int PHASES = 1 << PHASE_BITS;
+
+    explicit BlipBuffer(size_t max_samples)
+        : m_buffer(max_samples + KERNEL_TAPS, 0.0f) {
+        build_kernel();
+    }
+
+    // Clock rate in input clocks per second, sample rate in output samples
+    void set_rates(double clock_rate, double sample_rate) {
+        m_factor = static_cast<uint64_t>(sample_rate / clock_rate * TIME_UNIT + 0.5);
+    }
+
+    // Drop all pending samples; the integrator restarts at 'level'
+    void clear(float level = 0.0f) {
+        std::fill(m_buffer.begin(), m_buffer.end(), 0.0f);
+        m_offset = 0;
+        m_avail = 0;
+        m_integrator = level;
+    }
+
+    // Add an amplitude step at 'clock_time' clocks after the current frame start
+    void add_delta(uint32_t clock_time, float delta) {
+        uint64_t fixed = m_offset + clock_time * m_factor;
+        size_t index = m_avail + static_cast<size_t>(fixed >> TIME_BITS);
+        if (index + KERNEL_TAPS > m_buffer.size()) {
+            return;  // Frame ran past capacity; caller flushes well before this
+        }
+        int phase = static_cast<int>(fixed >> (TIME_BITS - PHASE_BITS)) & (PHASES - 1);
+        const float* kernel = &m_kernel[phase * KERNEL_TAPS];
+        float* out = &m_buffer[index];
+        for (int i = 0; i < KERNEL_TAPS; i++) {
+            out[i] += kernel[i] * delta;
+        }
+    }
+
+    // Finish the current frame after 'clocks' input clocks
+    void end_frame(uint32_t clocks) {
+        uint64_t fixed = m_offset + clocks * m_factor;
+        m_avail += static_cast<size_t>(fixed >> TIME_BITS);
+        m_offset = fixed & (TIME_UNIT - 1);
+    }
+
+    size_t samples_avail() const { return m_avail; }
+
+    // Integrate up to 'max_samples' finished samples into 'out'
+    size_t read_samples(float* out, size_t max_samples) {
+        size_t count = std::min(max_samples, m_avail);
+        float sum = m_integrator;
+        for (size_t i = 0; i < count; i++) {
+            sum += m_buffer[i];
+            out[i] = sum;
+        }
+        m_integrator = sum;
+
+        // Shift the unread samples and kernel tails to the front
+        size_t tail = m_avail + KERNEL_TAPS - count;
+        std::copy(m_buffer.begin() + count, m_buffer.begin() + count + tail, m_buffer.begin());
+        std::fill(m_buffer.begin() + tail, m_buffer.begin() + tail + count, 0.0f);
+        m_avail -= count;
+        return count;
+    }
+
+private:
+    static constexpr int TIME_BITS = 32;
+    static constexpr uint64_t TIME_UNIT = 1ULL << TIME_BITS;
+
+    // Blackman-windowed sinc, one row per sub-sample phase, each row summing
+    // to 1 so a delta lands with exactly its height once integrated
+    void build_kernel() {
+        constexpr double PI = 3.14159265358979323846;
+        constexpr double CUTOFF = 0.9;  // Fraction of Nyquist kept
+        m_kernel.resize(PHASES * KERNEL_TAPS);
+        for (int p = 0; p < PHASES; p++) {
+            double frac = static_cast<double>(p) / PHASES;
+            double sum = 0.0;
+            for (int i = 0; i < KERNEL_TAPS; i++) {
+                double u = i + 1 - frac;  // Position inside the window (0, KERNEL_TAPS]
+                double t = (u - KERNEL_TAPS / 2) * CUTOFF;
+                double sinc = (t == 0.0) ? 1.0 : std::sin(PI * t) / (PI * t);
+                double w = 0.42 - 0.5 * std::cos(2.0 * PI * u / KERNEL_TAPS) +
+                           0.08 * std::cos(4.0 * PI * u / KERNEL_TAPS);
+                m_kernel[p * KERNEL_TAPS + i] = static_cast<float>(sinc * w);
+                sum += sinc * w;
+            }
+            for (int i = 0; i < KERNEL_TAPS; i++) {
+                m_kernel[p * KERNEL_TAPS + i] = static_cast<float>(m_kernel[p * KERNEL_TAPS + i] / sum);
+            }
+        }
+    }
+
+    std::vector<float> m_buffer;
+    std::vector<float> m_kernel;
+    uint64_t m_factor = 0;      // Output samples per clock, 32.32 fixed point
+    uint64_t m_offset = 0;      // Fractional sample position of the frame start
+    size_t m_avail = 0;         // Finished samples at the front of m_buffer
+    float m_integrator = 0.0f;  // Running sum of consumed deltas
+};
+
+} // namespace emu
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "write_watch.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Execute, read and write breakpoints on a core's CPU bus
+//
+// The address space is split into pages, each flagged with the kinds of
+// breakpoint that fall in it. Cores keep the check off their fast paths:
+// a bus with a page table drops flagged pages from it, so only accesses to
+// those pages reach the slow path where check() runs, and the CPU and bus
+// hold a pointer to this only while breakpoints of a kind they test are
+// set. With none, nothing is tested at all; with some, an access to an
+// unflagged page costs a page flag lookup at most.
+//
+// Hits don't stop the core mid-frame: they're recorded with the core's
+// cycle counter and placed within their frame like write watchpoint hits,
+// and the host decides what to do once the frame ends.
+
+namespace emu {
+
+enum BreakpointKind : uint8_t {
+    BREAK_EXECUTE = 0x01,   // An instruction starts in the range
+    BREAK_READ = 0x02,      // The CPU reads the range (and fetches from it, on most cores)
+    BREAK_WRITE = 0x04      // The CPU writes the range
+};
+
+struct Breakpoint {
+    uint32_t address;       // CPU bus address
+    uint32_t length;        // Bytes covered from address
+    uint8_t kinds;          // BreakpointKind bits
+};
+
+// One access that fell in a breakpoint
+struct BreakpointHit {
+    uint32_t address;       // CPU bus address accessed (the PC for BREAK_EXECUTE)
+    uint8_t kind;           // The one BreakpointKind that hit
+    uint8_t value;          // Byte read or written; the opcode's first byte
+    uint64_t frame;         // get_frame_count() once the frame of the hit ended
+    float frame_position;   // How far into that frame it happened, 0 to 1
+};
+
+class Breakpoints {
+public:
+    // Addresses are checked modulo 2^address_bits, in pages of
+    // 2^page_shift bytes; cores with a page table pick its page size
+    Breakpoints(int address_bits, int page_shift)
+        : m_address_mask(address_bits >= 32 ? ~0u : (1u << address_bits) - 1),
+          m_page_shift(page_shift),
+          m_pages((static_cast<size_t>(m_address_mask) >> page_shift) + 1) {}
+
+    // Use these breakpoints instead of the previous ones; pending hits are
+    // dropped
+    void set(const Breakpoint* list, size_t count) {
+        m_list.clear();
+        std::fill(m_pages.begin(), m_pages.end(), 0);
+        m_kinds = 0;
+        for (size_t i = 0; i < count; i++) {
+            Breakpoint breakpoint = list[i];
+            breakpoint.address &= m_address_mask;
+            breakpoint.kinds &= BREAK_EXECUTE | BREAK_READ | BREAK_WRITE;
+            if (breakpoint.length == 0 || breakpoint.kinds == 0) continue;
+
+            uint64_t last = std::min<uint64_t>(uint64_t(breakpoint.address) + breakpoint.length - 1, m_address_mask);
+            for (uint64_t page = breakpoint.address >> m_page_shift; page <= (last >> m_page_shift); page++) {
+                m_pages[static_cast<size_t>(page)] |= breakpoint.kinds;
+            }
+            m_kinds |= breakpoint.kinds;
+            m_list.push_back(breakpoint);
+        }
+        m_log.clear();
+    }
+
+    bool empty() const { return m_list.empty(); }
+
+    // Every kind set, so a core can leave the CPU or the bus unhooked
+    uint8_t kinds() const { return m_kinds; }
+
+    uint8_t page_flags(uint32_t address) const {
+        return m_pages[(address & m_address_mask) >> m_page_shift];
+    }
+
+    // Flags of all the pages from first to last, for page tables coarser
+    // than the breakpoint pages
+    uint8_t range_flags(uint32_t first, uint32_t last) const {
+        uint8_t flags = 0;
+        for (uint64_t page = (first & m_address_mask) >> m_page_shift;
+             page <= ((last & m_address_mask) >> m_page_shift); page++) {
+            flags |= m_pages[static_cast<size_t>(page)];
+        }
+        return flags;
+    }
+
+    // Counter read for each hit, in the core's own cycles
+    void set_clock(const uint64_t* clock) { m_log.set_clock(clock); }
+
+    // From the CPU at each instruction (BREAK_EXECUTE) or the bus at each
+    // access; records a hit if address is in a breakpoint of that kind
+    void check(uint32_t address, uint8_t kind, uint8_t value) {
+        if (page_flags(address) & kind) {
+            record(address & m_address_mask, kind, value);
+        }
+    }
+
+    // Bracket each frame the core runs, with its cycle counter at either end
+    void begin_frame(uint64_t cycle) { m_log.begin_frame(cycle); }
+    void end_frame(uint64_t cycle, uint64_t frame) { m_log.end_frame(cycle, frame); }
+
+    // Move hits of finished frames into out, oldest first; returns how many
+    size_t take(BreakpointHit* out, size_t max) { return m_log.take(out, max); }
+
+private:
+    void record(uint32_t address, uint8_t kind, uint8_t value) {
+        for (const Breakpoint& breakpoint : m_list) {
+            if ((breakpoint.kinds & kind) && address - breakpoint.address < breakpoint.length) {
+                m_log.record({address, kind, value, 0, 0.0f});
+                return;
+            }
+        }
+    }
+
+    uint32_t m_address_mask;
+    int m_page_shift;
+    std::vector<uint8_t> m_pages;
+    std::vector<Breakpoint> m_list;
+    uint8_t m_kinds = 0;
+    FrameHitLog<BreakpointHit> m_log;
+};
+
+} // namespace emu
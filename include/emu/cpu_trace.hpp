@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Binary per-instruction CPU trace
+//
+// The host owns a CpuTrace and hands it to the core with
+// IEmulatorPlugin::set_cpu_trace(); while it's set, the core's main CPU
+// appends one fixed-size record per instruction, before running it. Nothing
+// is formatted or allocated on that path: a record is filled in place in a
+// preallocated ring, so tracing costs a few ns per instruction and whole
+// frames of a real run can be traced. The ring keeps the newest records.
+//
+// save() writes them out; veloce_trace_decode disassembles a saved trace
+// to text.
+
+namespace emu {
+
+// The CPU a record came from, which says how to read its opcode bytes and
+// registers
+enum class CpuTraceArch : uint8_t {
+    MOS6502 = 1,    // NES (2A03)
+    WDC65816 = 2,   // SNES (5A22)
+    SM83 = 3,       // Game Boy
+    ARM7TDMI = 4    // GBA
+};
+
+// One instruction, as the CPU was about to run it
+//
+// regs by arch:
+//   MOS6502   A, X, Y, SP, P
+//   WDC65816  A, X, Y, SP, P, D, DBR
+//   SM83      AF, BC, DE, HL, SP
+//   ARM7TDMI  r0-r7, SP (r13), LR (r14), CPSR
+struct CpuTraceRecord {
+    uint64_t cycle;         // Core's cycle counter (as get_cycle_count())
+    uint32_t pc;            // Instruction address; PBR:PC on the 65816
+    uint8_t opcode[4];      // Instruction bytes from pc on; ARM and Thumb
+                            // hold the instruction word, little-endian
+    uint8_t arch;           // CpuTraceArch
+    uint8_t flags;          // CPU_TRACE_* below
+    uint16_t reserved;
+    uint32_t regs[11];
+};
+static_assert(sizeof(CpuTraceRecord) == 64, "CpuTraceRecord is a fixed 64 bytes");
+
+constexpr uint8_t CPU_TRACE_EMULATION = 0x01;   // 65816: emulation mode (E=1)
+constexpr uint8_t CPU_TRACE_THUMB = 0x01;       // ARM7TDMI: Thumb state
+
+// Saved trace: this header, then `count` records oldest first. Written in
+// host byte order (every platform built for is little-endian).
+struct CpuTraceFileHeader {
+    char magic[8];          // "VCPUTRC\0"
+    uint32_t version;       // CPU_TRACE_VERSION
+    uint32_t record_size;   // sizeof(CpuTraceRecord)
+    uint64_t count;         // Records in the file
+    uint64_t total;         // Instructions traced; total - count fell out of the ring
+};
+
+constexpr char CPU_TRACE_MAGIC[8] = {'V', 'C', 'P', 'U', 'T', 'R', 'C', '\0'};
+constexpr uint32_t CPU_TRACE_VERSION = 1;
+
+class CpuTrace {
+public:
+    // 64 MB: a few frames of the busiest core
+    static constexpr size_t DEFAULT_CAPACITY = size_t(1) << 20;
+
+    // capacity is rounded up to a power of two
+    explicit CpuTrace(size_t capacity = DEFAULT_CAPACITY) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        m_records.resize(size);
+        m_mask = size - 1;
+    }
+
+    CpuTrace(const CpuTrace&) = delete;
+    CpuTrace& operator=(const CpuTrace&) = delete;
+
+    // Counter read for each record, in the core's own cycles; the core sets
+    // this when it's handed the trace
+    void set_clock(const uint64_t* clock) { m_clock = clock; }
+
+    // The next record to fill in, with its cycle already set. Overwrites
+    // the oldest once the ring is full.
+    CpuTraceRecord& append() {
+        CpuTraceRecord& record = m_records[m_total++ & m_mask];
+        record.cycle = m_clock ? *m_clock : 0;
+        return record;
+    }
+
+    size_t capacity() const { return m_records.size(); }
+    size_t size() const { return m_total < m_records.size() ? static_cast<size_t>(m_total) : m_records.size(); }
+    uint64_t total() const { return m_total; }
+    void clear() { m_total = 0; }
+
+    // The i-th record still held, oldest first
+    const CpuTraceRecord& at(size_t i) const {
+        return m_records[(m_total - size() + i) & m_mask];
+    }
+
+    // Write what's held; false if the file can't be written
+    bool save(const std::string& path) const {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) return false;
+
+        CpuTraceFileHeader header{};
+        std::memcpy(header.magic, CPU_TRACE_MAGIC, sizeof(header.magic));
+        header.version = CPU_TRACE_VERSION;
+        header.record_size = sizeof(CpuTraceRecord);
+        header.count = size();
+        header.total = m_total;
+        bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+
+        // The ring in at most two runs
+        size_t first = static_cast<size_t>((m_total - size()) & m_mask);
+        size_t run = std::min(size(), m_records.size() - first);
+        ok = ok && std::fwrite(&m_records[first], sizeof(CpuTraceRecord), run, file) == run;
+        ok = ok && std::fwrite(m_records.data(), sizeof(CpuTraceRecord), size() - run, file) == size() - run;
+        return std::fclose(file) == 0 && ok;
+    }
+
+    // Read a saved trace; false (with a message in error) if it isn't one
+    static bool load(const std::string& path, CpuTraceFileHeader& header,
+                     std::vector<CpuTraceRecord>& records, std::string& error) {
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) {
+            error = "can't open " + path;
+            return false;
+        }
+        bool ok = std::fread(&header, sizeof(header), 1, file) == 1 &&
+                  std::memcmp(header.magic, CPU_TRACE_MAGIC, sizeof(header.magic)) == 0;
+        if (!ok) {
+            error = path + " is not a CPU trace";
+        } else if (header.version != CPU_TRACE_VERSION || header.record_size != sizeof(CpuTraceRecord)) {
+            error = path + " is from an unsupported trace version";
+            ok = false;
+        } else {
+            records.resize(static_cast<size_t>(header.count));
+            if (std::fread(records.data(), sizeof(CpuTraceRecord), records.size(), file) != records.size()) {
+                error = path + " is truncated";
+                ok = false;
+            }
+        }
+        std::fclose(file);
+        return ok;
+    }
+
+private:
+    std::vector<CpuTraceRecord> m_records;
+    size_t m_mask = 0;
+    uint64_t m_total = 0;
+    const uint64_t* m_clock = nullptr;
+};
+
+} // namespace emu
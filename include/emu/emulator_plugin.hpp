@@ -1,10 +1,18 @@
 #pragma once
 
+#include "audio_stream.hpp"
 #include "controller_layout.hpp"
+#include "input_poll.hpp"
+#include "profile.hpp"
+#include "rom_image.hpp"
+#include "write_watch.hpp"
+#include "breakpoints.hpp"
 #include <cstdint>
 #include <cstddef>
+#include <cstring>
 #include <vector>
 #include <functional>
+#include <memory>
 
 // DLL export macro for Windows
 #ifdef _WIN32
@@ -15,6 +23,9 @@
 
 namespace emu {
 
+class Tracer;
+class CpuTrace;
+
 // Information about the emulator plugin
 struct EmulatorInfo {
     const char* name;               // "NES", "SNES", etc.
@@ -36,10 +47,26 @@ struct FrameBuffer {
 };
 
 // Audio buffer for sound output
+//
+// Cores hand over samples at whatever rate they produce them (the SNES DSP's
+// 32 kHz, or the rate a band-limited step buffer synthesizes at) and leave
+// conversion to the device rate to the host, which does it in one pass
+// together with rate control. Cores shouldn't resample their own output.
 struct AudioBuffer {
     float* samples;     // Interleaved stereo samples (-1.0 to 1.0)
     int sample_count;   // Number of sample pairs
-    int sample_rate;    // Typically 44100 or 48000
+    int sample_rate;    // The core's own output rate, not the device's
+};
+
+// Everything the host reads from a core after each frame, gathered in one
+// call (see IEmulatorPlugin::get_frame_result())
+struct FrameResult {
+    FrameBuffer video;      // As get_framebuffer()
+    AudioBuffer audio;      // As get_audio()
+    bool lag_frame;         // As is_lag_frame()
+    bool fast_mode;         // As is_fast_mode_enabled()
+    uint64_t frame_count;
+    uint64_t cycle_count;
 };
 
 // Input state for controllers
@@ -48,6 +75,33 @@ struct InputState {
     uint32_t buttons;   // Bitmask of pressed buttons
 };
 
+// A named memory of a core with its own address space, for debuggers, RAM
+// watch and auto-splitters (see IEmulatorPlugin::get_memory_domains())
+struct MemoryDomain {
+    const char* name;       // "CPU Bus", "WRAM", "VRAM", "OAM", "SRAM", "ROM", ...
+    uint32_t size;          // Addresses run from 0 to size - 1
+    const uint8_t* data;    // All size bytes, when the domain is one array; else nullptr
+};
+
+// Copy length bytes at address out of a domain with data set; false if the
+// range runs past its end. For cores' read_memory_block().
+inline bool copy_memory_domain(const MemoryDomain& domain, uint32_t address, size_t length, uint8_t* out) {
+    if (!domain.data || address > domain.size || length > domain.size - address) return false;
+    std::memcpy(out, domain.data + address, length);
+    return true;
+}
+
+// Options for IEmulatorPlugin::run_frames()
+enum RunFlags : uint32_t {
+    RUN_FLAGS_NONE       = 0,
+    RUN_FLAGS_SKIP_VIDEO = 1u << 0,   // Draw only the last frame
+    RUN_FLAGS_SKIP_AUDIO = 1u << 1,   // Generate audio only for the last frame
+};
+
+inline RunFlags operator|(RunFlags a, RunFlags b) {
+    return static_cast<RunFlags>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
+}
+
 // Main emulator plugin interface
 class IEmulatorPlugin {
 public:
@@ -67,15 +121,93 @@ public:
     virtual bool is_rom_loaded() const = 0;
     virtual uint32_t get_rom_crc32() const = 0;
 
+    // Load a ROM image that other instances may be running at the same time
+    // (netplay clones, the multi-instance job runner), and which may be a
+    // mapping of the ROM file. The image is never written, so a core can
+    // keep a reference for as long as the ROM is loaded instead of copying
+    // it; the default copies it through load_rom().
+    virtual bool load_rom_shared(std::shared_ptr<const RomImage> rom) {
+        return rom && load_rom(rom->data(), rom->size());
+    }
+
     // Emulation control
     virtual void reset() = 0;
     virtual void run_frame(const InputState& input) = 0;
+
+    // Run 'count' frames back to back, frame i reading inputs[i]
+    // Batch callers (TAS seeking, headless runs, fast-forward) use this so a
+    // core can keep its frame loop hot instead of paying per-frame dispatch
+    // and output copies. With RUN_FLAGS_SKIP_VIDEO / RUN_FLAGS_SKIP_AUDIO
+    // every frame but the last runs with that output disabled, and the last
+    // frame runs with it enabled. The default simply loops over run_frame().
+    virtual void run_frames(const InputState* inputs, size_t count, RunFlags flags) {
+        bool skip_video = (flags & RUN_FLAGS_SKIP_VIDEO) != 0 && count > 1;
+        bool skip_audio = (flags & RUN_FLAGS_SKIP_AUDIO) != 0 && count > 1;
+        if (skip_video) set_video_enabled(false);
+        if (skip_audio) set_audio_enabled(false);
+        for (size_t i = 0; i < count; i++) {
+            if (i + 1 == count) {
+                if (skip_video) set_video_enabled(true);
+                if (skip_audio) set_audio_enabled(true);
+            }
+            run_frame(inputs[i]);
+            if (skip_audio && i + 1 < count) clear_audio_buffer();
+        }
+    }
+
+    // run_frame(), then get_frame_result(), so a host can run a frame and
+    // read what it produced with one call across the plugin boundary
+    virtual void run_frame_result(const InputState& input, FrameResult& result) {
+        run_frame(input);
+        get_frame_result(result);
+    }
+
+    // The last frame's output and counters. The default reads them through
+    // the getters from inside the core; the host caches get_info() at ROM
+    // load and uses this between frames instead of the separate calls.
+    virtual void get_frame_result(FrameResult& result) {
+        result.video = get_framebuffer();
+        result.audio = get_audio();
+        result.lag_frame = is_lag_frame();
+        result.fast_mode = is_fast_mode_enabled();
+        result.frame_count = get_frame_count();
+        result.cycle_count = get_cycle_count();
+    }
+
+    // Read the local controller through poll at each latch during the
+    // frames that follow, until an empty poll is set. The host sets one
+    // only around live frames; replays, netplay and rewind keep to their
+    // InputState so they stay deterministic. Cores without latch points
+    // ignore it.
+    virtual void set_input_poll(const InputPoll& poll) { (void)poll; }
+
     virtual uint64_t get_cycle_count() const = 0;
     virtual uint64_t get_frame_count() const = 0;
 
-    // Video output
+    // True if the game never read the controller during the last frame run:
+    // a lag frame, whose input made no difference. Cores that don't track
+    // controller reads always return false.
+    virtual bool is_lag_frame() const { return false; }
+
+    // Video output. The frame's size can change from frame to frame (SNES
+    // hi-res frames are 512 wide, overscan ones 239 lines); get_info() has
+    // the usual size.
     virtual FrameBuffer get_framebuffer() = 0;
 
+    // Draw frames straight into a host buffer (RGBA8888, rows pitch pixels
+    // apart) instead of the core's own, saving the host a copy per frame.
+    // get_framebuffer() then returns the buffer holding the last frame
+    // drawn, which may be one given earlier, so earlier buffers must stay
+    // valid until the next frame is drawn; nullptr goes back to the core's
+    // own buffer. The buffer is get_info()'s size; frames of any other size
+    // are drawn into the core's own. Returns false if the core can't draw
+    // into the buffer (including every core that doesn't override this).
+    virtual bool set_output_framebuffer(uint32_t* pixels, int pitch) {
+        (void)pixels;
+        (void)pitch;
+        return false;
+    }
+
     // Audio output
     virtual AudioBuffer get_audio() = 0;
     virtual void clear_audio_buffer() = 0;
@@ -84,27 +216,101 @@ public:
     // Streaming Audio (low-latency)
     // ============================================================
 
-    // Callback type for streaming audio - called during emulation with small batches
-    // Parameters: samples (interleaved stereo floats), sample_count (number of stereo pairs), sample_rate
-    using AudioStreamCallback = std::function<void(const float* samples, size_t sample_count, int sample_rate)>;
-
-    // Set the audio streaming callback for low-latency audio
-    // When set, the core should push audio samples frequently during run_frame()
-    // instead of batching them until get_audio() is called.
-    // Set to nullptr to disable streaming and use traditional get_audio() mode.
-    virtual void set_audio_callback(AudioStreamCallback callback) { m_audio_callback = callback; }
+    // Set the sink for low-latency audio
+    // When set, the core should write audio into sink blocks frequently during
+    // run_frame() (see AudioStreamWriter), at its own rate as for AudioBuffer,
+    // instead of batching samples until get_audio() is called.
+    // Set an empty sink to disable streaming and use traditional get_audio() mode.
+    virtual void set_audio_sink(const AudioStreamSink& sink) { m_audio_sink = sink; }
 
     // Check if streaming audio is enabled
-    bool has_audio_callback() const { return m_audio_callback != nullptr; }
+    bool has_audio_sink() const { return static_cast<bool>(m_audio_sink); }
 
     // Memory access (for speedrun plugins and RAM watch)
     virtual uint8_t read_memory(uint16_t address) = 0;
     virtual void write_memory(uint16_t address, uint8_t value) = 0;
 
+    // Memory domains, indexed by position. Domain 0 is always the CPU bus
+    // (for cores with a wider bus than read_memory() reaches, all of it);
+    // the others are the core's memories by name. data pointers stay valid
+    // until another ROM is loaded or this one is unloaded. The default is
+    // just the 64KB bus, read through read_memory().
+    virtual std::vector<MemoryDomain> get_memory_domains() {
+        return {{"CPU Bus", 0x10000, nullptr}};
+    }
+
+    // Copy length bytes of a domain, starting at address, into out: one
+    // call for a whole memory viewer page or watch instead of one
+    // read_memory() per byte. False if the domain doesn't exist or the
+    // range runs past its end.
+    virtual bool read_memory_block(size_t domain, uint32_t address, size_t length, uint8_t* out) {
+        if (domain != 0 || address > 0x10000 || length > 0x10000 - address) return false;
+        for (size_t i = 0; i < length; i++) {
+            out[i] = read_memory(static_cast<uint16_t>(address + i));
+        }
+        return true;
+    }
+
+    // Write watchpoints on CPU bus addresses: every CPU write to one is
+    // recorded with where in its frame it happened, so an auto-splitter can
+    // time an event to within an instruction rather than to the frame.
+    // Replaces the previous set; none costs nothing. False if unsupported.
+    virtual bool set_write_watchpoints(const uint32_t* addresses, size_t count) {
+        (void)addresses;
+        return count == 0;
+    }
+
+    // Move the hits of frames already run into out, oldest first, up to
+    // max; returns how many
+    virtual size_t take_write_watch_hits(WriteWatchHit* out, size_t max) {
+        (void)out; (void)max;
+        return 0;
+    }
+
+    // Execute, read and write breakpoints on the main CPU's bus (see
+    // emu/breakpoints.hpp). Hits don't stop the frame; they're recorded
+    // with where in it they happened, like write watchpoint hits. Replaces
+    // the previous set; none costs nothing. False if unsupported.
+    virtual bool set_breakpoints(const Breakpoint* breakpoints, size_t count) {
+        (void)breakpoints;
+        return count == 0;
+    }
+
+    // Move the breakpoint hits of frames already run into out, oldest
+    // first, up to max; returns how many
+    virtual size_t take_breakpoint_hits(BreakpointHit* out, size_t max) {
+        (void)out; (void)max;
+        return 0;
+    }
+
     // Save states
     virtual bool save_state(std::vector<uint8_t>& data) = 0;
     virtual bool load_state(const std::vector<uint8_t>& data) = 0;
 
+    // Fork emulation: copy this instance's state into other, an instance of
+    // the same core with the same ROM loaded (such as a host clone sharing
+    // the ROM image), which then runs on from here on its own. The default
+    // goes through save_state()/load_state(); cores with fast save states
+    // copy straight across. False if other can't take the state.
+    virtual bool clone_into(IEmulatorPlugin* other) {
+        if (!other || other == this || !is_rom_loaded() || !other->is_rom_loaded() ||
+            other->get_rom_crc32() != get_rom_crc32()) {
+            return false;
+        }
+        std::vector<uint8_t> state;
+        return save_state(state) && other->load_state(state);
+    }
+
+    // Load only the chunks with the given tags (STATE_CHUNK_* in
+    // state_chunks.hpp) of a state from save_state(), leaving the rest of
+    // the machine as it is: e.g. just STATE_CHUNK_WORK_RAM to put a game
+    // back to a checkpoint without touching timing or video. Returns false
+    // if the core or the state isn't chunked, or no chunk matched.
+    virtual bool load_state_chunks(const uint8_t* data, size_t size, const uint32_t* tags, size_t tag_count) {
+        (void)data; (void)size; (void)tags; (void)tag_count;
+        return false;
+    }
+
     // Battery-backed save file support (SRAM, EEPROM, etc.)
     // These allow games with battery saves to persist data across sessions.
     // The application handles file I/O; the plugin provides/accepts raw data.
@@ -120,6 +326,12 @@ public:
     // Returns true if data was successfully loaded
     virtual bool set_battery_save_data(const std::vector<uint8_t>& data) { (void)data; return false; }
 
+    // Counter bumped whenever battery-backed memory may have changed (a
+    // write to SRAM, a Flash or EEPROM program, a state load). The host
+    // compares it between frames to write saves in the background while
+    // the game runs; cores that return 0 are only saved at unload.
+    virtual uint64_t get_battery_save_generation() const { return 0; }
+
     // ============================================================
     // Speed / Timing Configuration
     // ============================================================
@@ -129,6 +341,39 @@ public:
     // This is useful for fast-forward or "overclock" modes
     virtual bool is_fast_mode_enabled() const { return false; }
 
+    // Enable or disable audio sample generation
+    // While disabled (fast-forward, TAS seeking) the core may skip mixing and
+    // resampling entirely, but register, length counter and IRQ state must
+    // stay exact so emulation is unaffected. Cores that don't support this
+    // simply keep producing audio.
+    virtual void set_audio_enabled(bool enabled) { (void)enabled; }
+
+    // Enable or disable video output
+    // While disabled (TAS seeking, rollback resimulation, headless runs) the
+    // core may skip pixel composition, but everything the game can observe
+    // (sprite 0 hit, sprite overflow, STAT/LY, HDMA timing) must stay exact.
+    // get_framebuffer() keeps returning the last frame drawn with video on.
+    virtual void set_video_enabled(bool enabled) { (void)enabled; }
+
+    // Allow or forbid inaccurate enhancements that change what the game can
+    // observe, such as overclocking with extra VBlank scanlines. The host
+    // forbids them during netplay and while a TAS movie is open, so peers and
+    // movies stay in sync; cores keep the user's setting and apply it again
+    // once allowed.
+    virtual void set_enhancements_allowed(bool allowed) { (void)allowed; }
+
+    // Marker the core keeps pointed at the subsystem it is running, for
+    // the benchmark's per-subsystem breakdown. nullptr if not marked.
+    virtual const ProfileMarker* get_profile_marker() const { return nullptr; }
+
+    // Trace recorder owned by the host (see trace.hpp), or nullptr to stop
+    // tracing. Cores that mark their frame phases keep the pointer.
+    virtual void set_tracer(Tracer* tracer) { (void)tracer; }
+
+    // Per-instruction trace of the main CPU owned by the host (see
+    // cpu_trace.hpp), or nullptr to stop. False if the core can't trace.
+    virtual bool set_cpu_trace(CpuTrace* trace) { (void)trace; return false; }
+
     // ============================================================
     // Configuration GUI (optional)
     // ============================================================
@@ -175,8 +420,8 @@ public:
     virtual bool load_config(const char* path) { (void)path; return true; }
 
 protected:
-    // Audio streaming callback (set by application for low-latency audio)
-    AudioStreamCallback m_audio_callback;
+    // Audio streaming sink (set by application for low-latency audio)
+    AudioStreamSink m_audio_sink;
 };
 
 } // namespace emu
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "plugin_types.hpp"
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
@@ -61,6 +62,22 @@ struct MemoryWatch {
     const char* format;         // Optional format string
 };
 
+// A memory watch the host evaluates after every frame, calling the plugin
+// only when it fires (see IGameHost::set_watch_subscriptions())
+//
+// Conditions on the value alone (Equals, NotEquals, GreaterThan, LessThan,
+// BitSet, BitClear) fire on the frame they become true; the others
+// (ChangesTo, ChangesFrom, Increases, Decreases, Changes) on the frame the
+// value changes in that way.
+struct WatchSubscription {
+    uint32_t domain;            // Memory domain index (IGameHost::find_memory_domain()); 0 = CPU bus
+    uint32_t address;
+    uint8_t width;              // 1, 2 or 4 bytes, little-endian
+    SplitCondition condition;
+    uint32_t value;             // Target, for the conditions that compare with one
+    uint8_t bit_index;          // For BitSet/BitClear (0-31)
+};
+
 // Split timing information (for display purposes)
 struct SplitTiming {
     uint64_t time_ms;           // Time in milliseconds
@@ -88,6 +105,8 @@ enum class TimerState {
     Finished            // Run completed
 };
 
+class IGamePlugin;
+
 // Host interface provided to game plugins
 // Provides memory access, emulator state, and logging
 class IGameHost {
@@ -100,12 +119,46 @@ public:
     virtual uint32_t read_memory_32(uint16_t address) = 0;
     virtual void write_memory(uint16_t address, uint8_t value) = 0;
 
+    // The running core's memory domains (IEmulatorPlugin::get_memory_domains()),
+    // for memory read_memory() can't reach, like GBA EWRAM or SNES WRAM
+    // above 64KB. find_memory_domain() returns the index for a name
+    // ("WRAM", "EWRAM", ...), or -1 if the core has no such domain.
+    virtual int find_memory_domain(const char* name) { (void)name; return -1; }
+    virtual bool read_memory_block(size_t domain, uint32_t address, size_t length, uint8_t* out) {
+        (void)domain; (void)address; (void)length; (void)out;
+        return false;
+    }
+
+    // Watches for plugin, replacing any it had; an empty list removes
+    // them. Rather than reading memory in on_frame(), a plugin can register
+    // what it watches once: the host reads every plugin's watches in a few
+    // block reads after each frame and calls on_watch_triggered() only for
+    // those that fire. Values are re-read without firing after a ROM loads.
+    // False if the host doesn't support watches or a watch is invalid.
+    virtual bool set_watch_subscriptions(IGamePlugin* plugin, const WatchSubscription* watches, size_t count) {
+        (void)plugin; (void)watches; (void)count;
+        return false;
+    }
+
+    // CPU bus addresses whose writes plugin wants as they happen, replacing
+    // any it had. Unlike a watch, which is read once a frame, each write is
+    // reported through on_watched_write() with how long ago it happened, so
+    // a split can be timed to the instruction. An empty list removes them.
+    // False if the host or the running core can't watch writes.
+    virtual bool set_write_watchpoints(IGamePlugin* plugin, const uint32_t* addresses, size_t count) {
+        (void)plugin; (void)addresses; (void)count;
+        return false;
+    }
+
     // Emulator state
     virtual bool is_emulator_running() const = 0;
     virtual bool is_emulator_paused() const = 0;
     virtual uint64_t get_frame_count() const = 0;
     virtual double get_fps() const = 0;
 
+    // Whether the frame just run was a lag frame (IEmulatorPlugin::is_lag_frame())
+    virtual bool is_lag_frame() const { return false; }
+
     // ROM info
     virtual const char* get_rom_name() const = 0;
     virtual uint32_t get_rom_crc32() const = 0;
@@ -235,6 +288,15 @@ public:
     // Called each frame - plugin can check memory and trigger actions
     virtual void on_frame() = 0;
 
+    // Watch index of IGameHost::set_watch_subscriptions() fired, with the
+    // value it had the frame before and has now. Called before on_frame().
+    virtual void on_watch_triggered(size_t index, uint32_t old_value, uint32_t new_value) {}
+
+    // The game wrote value to an address of IGameHost::set_write_watchpoints(),
+    // seconds_ago of emulated time before now; e.g. split(seconds_ago) on a
+    // TimerCore. Called before on_watch_triggered() and on_frame().
+    virtual void on_watched_write(uint32_t address, uint8_t value, double seconds_ago) {}
+
     // Called when a split is triggered externally (e.g., by auto-splitter)
     virtual void on_split_triggered() { split(); }
 
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+namespace emu {
+
+// Live input for the local controller, read by a core at the moment the
+// game latches its pad (NES $4016 strobe, SNES auto-joypad read) rather
+// than taken from the InputState the frame started with (see
+// IEmulatorPlugin::set_input_poll()). frame_position is how far into the
+// frame the latch falls, 0 to 1; the result is a VirtualButton mask.
+struct InputPoll {
+    void* context = nullptr;
+    uint32_t (*poll)(void* context, float frame_position) = nullptr;
+
+    explicit operator bool() const { return poll != nullptr; }
+};
+
+} // namespace emu
@@ -0,0 +1,35 @@
+#pragma once
+
+namespace emu {
+
+// ===========================================================================
+// ILinkCableCapable - Interface for cores that can link two instances
+// ===========================================================================
+// Emulator plugins inherit from this IN ADDITION to IEmulatorPlugin when two
+// instances of the core in the same process can be joined by a link cable
+// (trades and battles). The host discovers it with dynamic_cast, the same
+// way as INetplayCapable.
+//
+// Linked instances exchange serial data through lock-free queues stamped
+// with emulated cycles, so the result depends only on the two instances'
+// inputs, never on host thread timing. An instance only waits for its
+// partner while a transfer is in flight or while it is listening for one,
+// so each linked instance must run on its own thread: running both from
+// one thread would stall the first instance that has to wait.
+
+class ILinkCableCapable {
+public:
+    virtual ~ILinkCableCapable() = default;
+
+    // Connect this instance to another instance of the same core, replacing
+    // any existing link on either side. Call while neither is running a
+    // frame. Returns false if the partner is not compatible.
+    virtual bool connect_link(ILinkCableCapable* partner) = 0;
+
+    // Unplug the cable; the partner sees a disconnected port from then on
+    virtual void disconnect_link() = 0;
+
+    virtual bool is_link_connected() const = 0;
+};
+
+} // namespace emu
@@ -3,6 +3,7 @@
 #include "plugin_types.hpp"
 #include <cstdint>
 #include <cstddef>
+#include <algorithm>
 #include <array>
 #include <vector>
 #include <string>
@@ -14,7 +15,7 @@
     #define EMU_PLUGIN_EXPORT
 #endif
 
-#define EMU_NETPLAY_PLUGIN_API_VERSION 1
+#define EMU_NETPLAY_PLUGIN_API_VERSION 5
 
 namespace emu {
 
@@ -28,6 +29,37 @@ static constexpr int NETPLAY_MAX_ROLLBACK_FRAMES = 12;
 // Maximum input delay frames
 static constexpr int NETPLAY_MAX_INPUT_DELAY = 8;
 
+// Maximum number of players supported in netplay
+static constexpr int NETPLAY_MAX_PLAYERS = 8;
+
+// Maximum parts in a core's split state hash
+static constexpr int NETPLAY_MAX_HASH_COMPONENTS = 7;
+
+// One part of a core's state hash (see INetplayCapable::get_state_hash_components)
+struct StateHashComponent {
+    const char* name;           // "CPU", "PPU", ...
+    uint64_t hash;
+};
+
+// Byte range of a save_state_fast() state (see
+// INetplayCapable::get_changed_state_spans)
+struct StateSpan {
+    size_t offset;
+    size_t size;
+};
+
+// Every player's buttons for one frame, in a fixed-size caller-owned block
+// so the per-frame input path never allocates
+struct NetplayFrameInputs {
+    std::array<uint32_t, NETPLAY_MAX_PLAYERS> buttons{};
+    int player_count = 0;
+
+    bool operator==(const NetplayFrameInputs& other) const {
+        return player_count == other.player_count && buttons == other.buttons;
+    }
+    bool operator!=(const NetplayFrameInputs& other) const { return !(*this == other); }
+};
+
 // ===========================================================================
 // INetplayCapable - Interface for emulator plugins that support netplay
 // ===========================================================================
@@ -73,17 +105,18 @@ public:
 
     // Run a single frame with N-player input
     // This is the netplay-aware version for variable player counts.
-    // The vector contains inputs for each player (index 0 = P1, etc.)
-    //
-    // player_inputs: Vector of button states for each player
+    // inputs.buttons holds each player's buttons (index 0 = P1, etc.);
+    // entries at or past inputs.player_count are zero.
     //
     // Default implementation delegates to 2-player version for backward compatibility.
-    virtual void run_frame_netplay_n(const std::vector<uint32_t>& player_inputs) {
-        uint32_t p1 = player_inputs.size() > 0 ? player_inputs[0] : 0;
-        uint32_t p2 = player_inputs.size() > 1 ? player_inputs[1] : 0;
-        run_frame_netplay(p1, p2);
+    virtual void run_frame_netplay_n(const NetplayFrameInputs& inputs) {
+        run_frame_netplay(inputs.buttons[0], inputs.buttons[1]);
     }
 
+    // Low bits of a player's button word the core reads. Only these are
+    // sent over the network, packed back to back.
+    virtual int get_input_bits() const { return 32; }
+
     // Get maximum number of players supported by this core
     // Override in emulator implementations to support more than 2 players.
     // Examples:
@@ -126,6 +159,20 @@ public:
     // Returns: true on success, false on failure
     virtual bool load_state_fast(const uint8_t* buffer, size_t size) = 0;
 
+    // Write tracking for incremental captures (optional)
+    // Call mark_state_capture() right before a save_state_fast(), or right
+    // after a load_state_fast(), whose state is kept as a base. get_changed_state_spans() then lists, in
+    // order, the ranges where a state saved now can differ from that base;
+    // every byte outside them is the same, so delta encoders only need to
+    // look inside them. Returns false when the core can't tell (it doesn't
+    // track writes, or the mark is 0), in which case compare everything.
+    virtual uint64_t mark_state_capture() { return 0; }
+    virtual bool get_changed_state_spans(uint64_t mark, std::vector<StateSpan>& spans) const {
+        (void)mark;
+        spans.clear();
+        return false;
+    }
+
     // -----------------------------------------------------------------------
     // Desync Detection
     // -----------------------------------------------------------------------
@@ -137,6 +184,18 @@ public:
     // Returns: 64-bit hash of current state
     virtual uint64_t get_state_hash() const = 0;
 
+    // Get hashes of the separate parts of the machine (CPU, PPU, APU, RAM,
+    // mapper, ...), so a desync can be traced to the part that diverged
+    // first. Each entry names its part with a static string.
+    //
+    // Returns: Number of entries written (at most max), 0 if the core does
+    // not split its state hash
+    virtual int get_state_hash_components(StateHashComponent* out, int max) const {
+        (void)out;
+        (void)max;
+        return 0;
+    }
+
     // -----------------------------------------------------------------------
     // Audio Handling for Rollback
     // -----------------------------------------------------------------------
@@ -154,24 +213,31 @@ public:
 // Utility classes for netplay plugin implementations
 // ===========================================================================
 
-// Maximum number of players supported in netplay
-static constexpr int NETPLAY_MAX_PLAYERS = 8;
-
 // Input history for rollback netcode
-// Stores recent inputs for all players to enable re-simulation
+// Stores recent inputs for all players to enable re-simulation. Frames are
+// stored at frame % capacity and tagged with their frame number, so lookup
+// and confirmation are O(1); a slot holding a different frame is a miss.
 class InputHistory {
 public:
     struct FrameInput {
         uint64_t frame = 0;
         std::array<uint32_t, NETPLAY_MAX_PLAYERS> player_inputs = {};  // Up to 8 players
-        std::array<bool, NETPLAY_MAX_PLAYERS> player_confirmed = {};   // Confirmation status per player
-        int player_count = 2;  // How many players are active in this session
+        uint8_t confirmed_mask = 0;  // Bit N set: player N's input is confirmed
+        uint8_t player_count = 2;    // How many players are active in this session
+
+        static_assert(NETPLAY_MAX_PLAYERS <= 8, "confirmed_mask holds one bit per player");
+
+        bool is_confirmed(int player) const { return (confirmed_mask >> player) & 1; }
+        void set_confirmed(int player, bool confirmed) {
+            uint8_t bit = static_cast<uint8_t>(1u << player);
+            confirmed_mask = confirmed ? (confirmed_mask | bit) : (confirmed_mask & ~bit);
+        }
 
         // Backward compatible accessors for 2-player code
         uint32_t player1() const { return player_inputs[0]; }
         uint32_t player2() const { return player_inputs[1]; }
-        bool player1_confirmed() const { return player_confirmed[0]; }
-        bool player2_confirmed() const { return player_confirmed[1]; }
+        bool player1_confirmed() const { return is_confirmed(0); }
+        bool player2_confirmed() const { return is_confirmed(1); }
 
         // Legacy field accessors (for compatibility)
         uint32_t player1_buttons() const { return player_inputs[0]; }
@@ -181,6 +247,7 @@ public:
     explicit InputHistory(size_t max_frames = NETPLAY_MAX_ROLLBACK_FRAMES * 2, int player_count = 2)
         : m_player_count(player_count) {
         m_history.resize(max_frames);
+        clear();
     }
 
     void set_player_count(int count) {
@@ -190,9 +257,10 @@ public:
     int get_player_count() const { return m_player_count; }
 
     void clear() {
-        m_write_index = 0;
+        for (auto& slot : m_history) slot.frame = NO_FRAME;
         m_count = 0;
         m_oldest_frame = 0;
+        m_newest_frame = 0;
     }
 
     // Legacy 2-player add_input for backward compatibility
@@ -201,88 +269,92 @@ public:
         input.frame = frame;
         input.player_inputs[0] = p1;
         input.player_inputs[1] = p2;
-        input.player_confirmed[0] = p1_confirmed;
-        input.player_confirmed[1] = p2_confirmed;
+        input.set_confirmed(0, p1_confirmed);
+        input.set_confirmed(1, p2_confirmed);
         input.player_count = 2;
 
         add_frame_input(input);
     }
 
     // N-player add_input
-    void add_input_n(uint64_t frame, const std::vector<uint32_t>& inputs,
-                     const std::vector<bool>& confirmed) {
+    // confirmed_mask: bit N set if player N's input is confirmed
+    void add_input_n(uint64_t frame, const NetplayFrameInputs& inputs, uint8_t confirmed_mask) {
         FrameInput input;
         input.frame = frame;
-        input.player_count = m_player_count;
+        input.player_count = static_cast<uint8_t>(m_player_count);
 
-        for (int i = 0; i < m_player_count && i < static_cast<int>(inputs.size()); i++) {
-            input.player_inputs[i] = inputs[i];
-            input.player_confirmed[i] = (i < static_cast<int>(confirmed.size())) ? confirmed[i] : false;
-        }
+        int count = std::min(m_player_count, inputs.player_count);
+        std::copy(inputs.buttons.begin(), inputs.buttons.begin() + count, input.player_inputs.begin());
+        input.confirmed_mask = static_cast<uint8_t>(confirmed_mask & ((1u << count) - 1));
 
         add_frame_input(input);
     }
 
     bool get_input(uint64_t frame, FrameInput& out) const {
-        if (m_count == 0) return false;
-
-        for (size_t i = 0; i < m_count; i++) {
-            size_t idx = (m_write_index + m_history.size() - 1 - i) % m_history.size();
-            if (m_history[idx].frame == frame) {
-                out = m_history[idx];
-                return true;
-            }
-        }
-        return false;
+        const FrameInput* slot = find(frame);
+        if (!slot) return false;
+        out = *slot;
+        return true;
     }
 
     void confirm_input(uint64_t frame, int player, uint32_t buttons) {
         if (player < 0 || player >= NETPLAY_MAX_PLAYERS) return;
 
-        for (size_t i = 0; i < m_count; i++) {
-            size_t idx = (m_write_index + m_history.size() - 1 - i) % m_history.size();
-            if (m_history[idx].frame == frame) {
-                m_history[idx].player_inputs[player] = buttons;
-                m_history[idx].player_confirmed[player] = true;
-                return;
-            }
+        FrameInput* slot = find(frame);
+        if (slot) {
+            slot->player_inputs[player] = buttons;
+            slot->set_confirmed(player, true);
         }
     }
 
     // Check if all players have confirmed input for a frame
     bool is_frame_fully_confirmed(uint64_t frame) const {
-        FrameInput input;
-        if (!get_input(frame, input)) return false;
+        const FrameInput* slot = find(frame);
+        if (!slot) return false;
 
-        for (int i = 0; i < input.player_count; i++) {
-            if (!input.player_confirmed[i]) return false;
-        }
-        return true;
+        uint8_t all = static_cast<uint8_t>((1u << slot->player_count) - 1);
+        return (slot->confirmed_mask & all) == all;
     }
 
     uint64_t get_oldest_frame() const { return m_oldest_frame; }
     size_t get_count() const { return m_count; }
 
 private:
+    static constexpr uint64_t NO_FRAME = UINT64_MAX;
+
+    const FrameInput* find(uint64_t frame) const {
+        const FrameInput& slot = m_history[frame % m_history.size()];
+        return slot.frame == frame ? &slot : nullptr;
+    }
+
+    FrameInput* find(uint64_t frame) {
+        FrameInput& slot = m_history[frame % m_history.size()];
+        return slot.frame == frame ? &slot : nullptr;
+    }
+
+    // Re-adding a frame (resimulation) overwrites it in place
     void add_frame_input(const FrameInput& input) {
-        m_history[m_write_index] = input;
-        m_write_index = (m_write_index + 1) % m_history.size();
-        if (m_count < m_history.size()) {
-            m_count++;
-        } else {
-            m_oldest_frame++;
+        m_history[input.frame % m_history.size()] = input;
+        if (m_count == 0) {
+            m_count = 1;
+            m_newest_frame = input.frame;
+        } else if (input.frame > m_newest_frame) {
+            m_count = std::min<size_t>(m_count + (input.frame - m_newest_frame), m_history.size());
+            m_newest_frame = input.frame;
         }
+        m_oldest_frame = m_newest_frame + 1 - m_count;
     }
 
     std::vector<FrameInput> m_history;
-    size_t m_write_index = 0;
     size_t m_count = 0;
     uint64_t m_oldest_frame = 0;
+    uint64_t m_newest_frame = 0;
     int m_player_count = 2;
 };
 
 // Save state ring buffer for rollback
-// Pre-allocates states to avoid allocations during gameplay
+// Pre-allocates states to avoid allocations during gameplay. A frame's
+// state lives in slot frame % num_states, tagged with the frame number.
 class RollbackStateBuffer {
 public:
     explicit RollbackStateBuffer(size_t max_state_size, size_t num_states = NETPLAY_MAX_ROLLBACK_FRAMES)
@@ -305,6 +377,7 @@ public:
 
     // Get a buffer to write a state for the given frame
     uint8_t* get_write_buffer(uint64_t frame) {
+        m_write_index = frame % m_num_states;
         m_states[m_write_index].frame = frame;
         m_states[m_write_index].valid = true;
         return m_states[m_write_index].data.data();
@@ -313,35 +386,39 @@ public:
     // Commit the write after save_state_fast returns
     void commit_write(size_t actual_size) {
         m_states[m_write_index].size = actual_size;
-        m_write_index = (m_write_index + 1) % m_num_states;
+        if (actual_size == 0) m_states[m_write_index].valid = false;
     }
 
     // Find a state for the given frame
     const uint8_t* find_state(uint64_t frame, size_t& out_size) const {
-        for (const auto& state : m_states) {
-            if (state.valid && state.frame == frame) {
-                out_size = state.size;
-                return state.data.data();
-            }
+        const SavedState& state = m_states[frame % m_num_states];
+        if (state.valid && state.frame == frame) {
+            out_size = state.size;
+            return state.data.data();
         }
         return nullptr;
     }
 
-    // Find the newest valid state at or before the given frame
+    // Invalidate states saved after the given frame. Call after rolling
+    // back to it, before the resimulated frames save their states again.
+    void discard_after(uint64_t frame) {
+        for (auto& state : m_states) {
+            if (state.frame > frame) state.valid = false;
+        }
+    }
+
+    // Find the newest valid state at or before the given frame, looking
+    // back at most one ring's worth of frames
     const uint8_t* find_nearest_state(uint64_t frame, uint64_t& out_frame, size_t& out_size) const {
-        const uint8_t* best = nullptr;
-        uint64_t best_frame = 0;
-
-        for (const auto& state : m_states) {
-            if (state.valid && state.frame <= frame && state.frame > best_frame) {
-                best = state.data.data();
-                best_frame = state.frame;
-                out_size = state.size;
+        for (size_t back = 0; back < m_num_states && back <= frame; back++) {
+            const uint8_t* data = find_state(frame - back, out_size);
+            if (data) {
+                out_frame = frame - back;
+                return data;
             }
         }
-
-        out_frame = best_frame;
-        return best;
+        out_frame = 0;
+        return nullptr;
     }
 
     size_t get_max_state_size() const { return m_max_state_size; }
@@ -428,6 +505,7 @@ struct RollbackEvent {
     uint64_t confirmed_frame;   // Last confirmed frame
     uint64_t rollback_frame;    // Frame we rolled back to
     int frames_resimulated;     // Number of frames re-simulated
+    float resimulation_ms;      // Time spent loading and re-simulating
 };
 
 // Desync information
@@ -449,6 +527,15 @@ struct NetplayStats {
     int rollback_count;         // Total rollbacks this session
     int max_rollback_frames;    // Maximum rollback depth seen
     float frame_advantage;      // Local frame advantage (-/+ frames)
+    float jitter_ms;            // Mean deviation of the round-trip time
+    float packet_loss;          // Fraction of recent round trips lost (0-1)
+    float resim_us_per_frame;   // Recent average time to resimulate one frame
+    float save_state_us;        // Recent average time to save a rollback state
+    float load_state_us;        // Recent average time to load a rollback state
+
+    // Rollbacks by depth: entry N counts those that went back N + 1 frames,
+    // the last entry also the deeper ones
+    int rollback_depth_histogram[NETPLAY_MAX_ROLLBACK_FRAMES];
 };
 
 // Notification types for UI
@@ -484,6 +571,22 @@ public:
     virtual bool save_state_to_buffer(std::vector<uint8_t>& buffer) = 0;
     virtual bool load_state_from_buffer(const std::vector<uint8_t>& buffer) = 0;
 
+    // Rollback resimulation
+    // get_netplay_emulator() exposes the core's fast save states, or returns
+    // nullptr if the core is not netplay capable (the plugin then has to
+    // stay delay-based). resimulate_frame() re-runs one frame with video and
+    // audio output disabled.
+    virtual INetplayCapable* get_netplay_emulator() = 0;
+    virtual void resimulate_frame(const NetplayFrameInputs& inputs) = 0;
+
+    // Speculation cores (optional)
+    // An independent copy of the core with the current ROM loaded and video/
+    // audio output disabled. The plugin may drive it from its own thread
+    // with load_state_fast()/run_frame_netplay_n(). Returns nullptr if the
+    // host cannot make one.
+    virtual INetplayCapable* create_emulator_clone() { return nullptr; }
+    virtual void destroy_emulator_clone(INetplayCapable* clone) { (void)clone; }
+
     // Input injection
     virtual void set_controller_input(int controller, uint32_t buttons) = 0;
     virtual uint32_t get_local_input(int controller) const = 0;
@@ -671,15 +774,14 @@ public:
     }
 
     // Get synchronized inputs for all players at once (efficient batch version)
-    // out_inputs: Output buffer, should be pre-sized to get_active_player_count()
+    // out: Filled with get_active_player_count() players; the rest are zeroed
     // frame: Current frame number
-    virtual void get_synchronized_inputs_fast(std::vector<uint32_t>& out_inputs, uint64_t frame) {
-        int count = get_active_player_count();
-        if (static_cast<int>(out_inputs.size()) != count) {
-            out_inputs.resize(count, 0);
-        }
-        for (int i = 0; i < count; i++) {
-            get_input(i, out_inputs[i], frame);
+    virtual void get_synchronized_inputs_fast(NetplayFrameInputs& out, uint64_t frame) {
+        out.player_count = std::clamp(get_active_player_count(), 0, NETPLAY_MAX_PLAYERS);
+        for (int i = 0; i < NETPLAY_MAX_PLAYERS; i++) {
+            uint32_t buttons = 0;
+            if (i < out.player_count) get_input(i, buttons, frame);
+            out.buttons[i] = buttons;
         }
     }
 
@@ -782,6 +884,11 @@ public:
     // Get frame advantage (positive = ahead of remote)
     virtual float get_frame_advantage() const { return 0.0f; }
 
+    // Multiplier the host applies to its frame time while playing, to keep
+    // peers in step without stalling: above 1 when ahead of the remote
+    // (run slightly slower), below 1 when behind. Stays within a few percent.
+    virtual double get_frame_time_scale() const { return 1.0; }
+
     // =========================================================================
     // GUI Integration
     // =========================================================================
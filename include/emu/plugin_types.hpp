@@ -134,7 +134,8 @@ enum class SplitCondition {
     Increases,      // Trigger when value increases
     Decreases,      // Trigger when value decreases
     BitSet,         // Trigger when specific bit is set
-    BitClear        // Trigger when specific bit is clear
+    BitClear,       // Trigger when specific bit is clear
+    Changes         // Trigger on any change of the value
 };
 
 // Definition of a single split for auto-splitting
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace emu {
+
+// Subsystems a core can attribute its running time to
+enum class ProfileSection : uint8_t {
+    Other = 0,  // Outside any marked subsystem (frame setup, host code)
+    CPU,
+    PPU,
+    APU,
+    DMA,
+    Count
+};
+
+inline const char* profile_section_name(ProfileSection section) {
+    switch (section) {
+        case ProfileSection::CPU: return "cpu";
+        case ProfileSection::PPU: return "ppu";
+        case ProfileSection::APU: return "apu";
+        case ProfileSection::DMA: return "dma";
+        default: return "other";
+    }
+}
+
+// The subsystem a core is running right now
+//
+// Cores store to it as they hand control between subsystems; a sampling
+// profiler on another thread reads it. A store is one relaxed byte write,
+// cheap enough to leave in every build.
+class ProfileMarker {
+public:
+    void set(ProfileSection section) { m_section.store(static_cast<uint8_t>(section), std::memory_order_relaxed); }
+    ProfileSection get() const { return static_cast<ProfileSection>(m_section.load(std::memory_order_relaxed)); }
+
+private:
+    std::atomic<uint8_t> m_section{0};
+};
+
+// Marks a section for the rest of a scope, then restores the previous one
+class ProfileScope {
+public:
+    ProfileScope(ProfileMarker& marker, ProfileSection section)
+        : m_marker(marker), m_previous(marker.get()) {
+        marker.set(section);
+    }
+    ~ProfileScope() { m_marker.set(m_previous); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    ProfileMarker& m_marker;
+    ProfileSection m_previous;
+};
+
+} // namespace emu
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace emu {
+
+// Read-only ROM bytes shared by every instance running the ROM (see
+// IEmulatorPlugin::load_rom_shared()). The bytes stay valid for as long as
+// anyone holds the image, whether they're a buffer or, for ROM files the
+// host maps, the file's pages: then the ROM costs no heap memory at all and
+// only the parts a game touches are ever read from disk. Cores that need
+// to patch or reorder the ROM copy what they change.
+class RomImage {
+public:
+    virtual ~RomImage() = default;
+
+    const uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+protected:
+    RomImage() = default;
+    RomImage(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+// A RomImage that owns its bytes
+class RomBuffer : public RomImage {
+public:
+    explicit RomBuffer(std::vector<uint8_t> bytes) : m_bytes(std::move(bytes)) {
+        m_data = m_bytes.data();
+        m_size = m_bytes.size();
+    }
+
+private:
+    std::vector<uint8_t> m_bytes;
+};
+
+// Copy of data, for callers that only have a pointer
+inline std::shared_ptr<const RomImage> make_rom_image(const uint8_t* data, size_t size) {
+    return std::make_shared<const RomBuffer>(std::vector<uint8_t>(data, data + size));
+}
+
+} // namespace emu
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace emu {
+
+// ===========================================================================
+// Chunked save states
+// ===========================================================================
+// What IEmulatorPlugin::save_state() and INetplayCapable::save_state_fast()
+// produce: STATE_CHUNKS_MAGIC, then one chunk per subsystem, each a
+// StateChunkHeader followed by its payload. A loader finds subsystems by
+// tag instead of by position, so
+//   - a subsystem's layout can change by bumping its chunk version, without
+//     invalidating the other chunks of existing states,
+//   - chunks a build doesn't know (from a newer one) are skipped, and
+//   - a subset can be loaded on its own (IEmulatorPlugin::load_state_chunks),
+//     e.g. just work RAM for a practice "reset to checkpoint".
+// States from before chunking are a bare concatenation; cores still load
+// them, whole.
+//
+// Chunks are written in a fixed order, so states of one ROM line up byte
+// for byte and delta schemes (rewind, greenzone, netplay) work as before.
+
+constexpr uint32_t make_state_chunk_tag(char a, char b, char c, char d) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(a)) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(b)) << 8) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(c)) << 16) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(d)) << 24);
+}
+
+constexpr uint32_t STATE_CHUNKS_MAGIC = make_state_chunk_tag('V', 'S', 'C', 'K');
+
+// Tags shared by the cores; a core uses those that it has
+constexpr uint32_t STATE_CHUNK_TIMING = make_state_chunk_tag('T', 'I', 'M', 'E');   // Frame and cycle counters
+constexpr uint32_t STATE_CHUNK_CPU = make_state_chunk_tag('C', 'P', 'U', ' ');
+constexpr uint32_t STATE_CHUNK_PPU = make_state_chunk_tag('P', 'P', 'U', ' ');
+constexpr uint32_t STATE_CHUNK_APU = make_state_chunk_tag('A', 'P', 'U', ' ');
+constexpr uint32_t STATE_CHUNK_DMA = make_state_chunk_tag('D', 'M', 'A', ' ');
+constexpr uint32_t STATE_CHUNK_WORK_RAM = make_state_chunk_tag('W', 'R', 'A', 'M');
+constexpr uint32_t STATE_CHUNK_BUS = make_state_chunk_tag('B', 'U', 'S', ' ');      // I/O registers
+constexpr uint32_t STATE_CHUNK_CARTRIDGE = make_state_chunk_tag('C', 'A', 'R', 'T'); // Mapper and cartridge RAM
+constexpr uint32_t STATE_CHUNK_COPROCESSOR = make_state_chunk_tag('C', 'O', 'P', 'R');
+
+struct StateChunkHeader {
+    uint32_t tag;
+    uint16_t version;   // Of this chunk's layout, per subsystem
+    uint16_t reserved;
+    uint32_t size;      // Payload bytes after the header
+};
+static_assert(sizeof(StateChunkHeader) == 12, "StateChunkHeader is part of the save state format");
+
+// Write one chunk through a core's StateWriter: the header, whatever
+// write_payload() writes, then the header again with the size filled in.
+// Writer needs write(), size() and overwrite().
+template <typename Writer, typename Fn>
+void write_state_chunk(Writer& out, uint32_t tag, uint16_t version, Fn&& write_payload) {
+    StateChunkHeader header{tag, version, 0, 0};
+    size_t start = out.size();
+    out.write(&header, sizeof(header));
+    write_payload();
+    header.size = static_cast<uint32_t>(out.size() - start - sizeof(header));
+    out.overwrite(start, &header, sizeof(header));
+}
+
+template <typename Writer>
+void write_state_chunks_magic(Writer& out) {
+    uint32_t magic = STATE_CHUNKS_MAGIC;
+    out.write(&magic, sizeof(magic));
+}
+
+struct StateChunk {
+    uint32_t tag = 0;
+    uint16_t version = 0;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+// Walks the chunks of a state without copying it
+class StateChunkReader {
+public:
+    StateChunkReader(const uint8_t* data, size_t size) : m_data(data), m_size(size) {
+        uint32_t magic = 0;
+        if (data && size >= sizeof(magic)) {
+            std::memcpy(&magic, data, sizeof(magic));
+        }
+        m_chunked = magic == STATE_CHUNKS_MAGIC;
+        m_pos = m_chunked ? sizeof(magic) : size;
+    }
+
+    // False for states from before chunking
+    bool is_chunked() const { return m_chunked; }
+
+    // The next chunk; false at the end or on a truncated chunk
+    bool next(StateChunk& chunk) {
+        if (m_size - m_pos < sizeof(StateChunkHeader)) {
+            m_malformed = m_pos != m_size;
+            return false;
+        }
+        StateChunkHeader header;
+        std::memcpy(&header, m_data + m_pos, sizeof(header));
+        m_pos += sizeof(header);
+        if (header.size > m_size - m_pos) {
+            m_malformed = true;
+            m_pos = m_size;
+            return false;
+        }
+        chunk.tag = header.tag;
+        chunk.version = header.version;
+        chunk.data = m_data + m_pos;
+        chunk.size = header.size;
+        m_pos += header.size;
+        return true;
+    }
+
+    // True if next() stopped on a broken chunk rather than the end
+    bool malformed() const { return m_malformed; }
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_pos = 0;
+    bool m_chunked = false;
+    bool m_malformed = false;
+};
+
+// Whether tag is among tags[0..count); a null list means every chunk
+inline bool state_chunk_selected(uint32_t tag, const uint32_t* tags, size_t count) {
+    if (!tags) return true;
+    for (size_t i = 0; i < count; i++) {
+        if (tags[i] == tag) return true;
+    }
+    return false;
+}
+
+} // namespace emu
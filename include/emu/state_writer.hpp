@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <cstring>
+#include <vector>
+
+namespace emu {
+
+// Save state output stream, shared by the cores
+// Every component of a core (CPU, PPU, APU, Bus, Cartridge, mappers)
+// serializes through this so the same code can either append to a growable
+// vector (regular save states) or write in place into a caller-provided
+// buffer (rollback via save_state_fast, where no allocations are allowed).
+class StateWriter {
+public:
+    // Append to a vector (grows as needed)
+    explicit StateWriter(std::vector<uint8_t>& data) : m_vector(&data) {}
+
+    // Write directly into a fixed buffer with a cursor
+    // Writes past the end are dropped and flagged via overflowed()
+    // A null buffer with zero capacity only counts bytes (state sizing)
+    StateWriter(uint8_t* buffer, size_t capacity)
+        : m_buffer(buffer), m_capacity(capacity) {}
+
+    void push_back(uint8_t value) {
+        if (m_vector) {
+            m_vector->push_back(value);
+            return;
+        }
+        if (!m_overflow && m_pos < m_capacity) {
+            m_buffer[m_pos] = value;
+        } else {
+            m_overflow = true;
+        }
+        m_pos++;
+    }
+
+    void write(const void* src, size_t size) {
+        if (size == 0) return;
+        const uint8_t* bytes = static_cast<const uint8_t*>(src);
+        if (m_vector) {
+            m_vector->insert(m_vector->end(), bytes, bytes + size);
+            return;
+        }
+        if (!m_overflow && size <= m_capacity - m_pos) {
+            std::memcpy(m_buffer + m_pos, bytes, size);
+        } else {
+            m_overflow = true;
+        }
+        m_pos += size;
+    }
+
+    // Replace bytes already written at pos (chunk headers, once the
+    // payload's size is known); dropped if they never fit
+    void overwrite(size_t pos, const void* src, size_t size) {
+        if (m_vector) {
+            std::memcpy(m_vector->data() + pos, src, size);
+            return;
+        }
+        if (!m_overflow && pos + size <= m_pos) {
+            std::memcpy(m_buffer + pos, src, size);
+        }
+    }
+
+    // Bytes written so far (for vector mode, the total vector size)
+    size_t size() const { return m_vector ? m_vector->size() : m_pos; }
+
+    // True if a fixed-buffer write ran past the capacity
+    bool overflowed() const { return m_overflow; }
+
+private:
+    std::vector<uint8_t>* m_vector = nullptr;
+    uint8_t* m_buffer = nullptr;
+    size_t m_capacity = 0;
+    size_t m_pos = 0;
+    bool m_overflow = false;
+};
+
+// Field-by-field save and load for a component that lists its fields once,
+// in a visit function template called with either of these. Values are
+// copied as they are in memory, bools as one byte and arrays element by
+// element, so struct padding never reaches the state.
+class StateFieldWriter {
+public:
+    explicit StateFieldWriter(StateWriter& out) : m_out(out) {}
+
+    template <typename T>
+    void operator()(const T& value) { m_out.write(&value, sizeof(value)); }
+    void operator()(bool value) { m_out.push_back(value ? 1 : 0); }
+    template <typename T, size_t N>
+    void operator()(const std::array<T, N>& values) {
+        for (const T& value : values) (*this)(value);
+    }
+
+private:
+    StateWriter& m_out;
+};
+
+// Reads what StateFieldWriter wrote. Fields past the end of the data are
+// left alone, and finish() then wraps remaining past its start so the
+// caller's size check fails.
+class StateFieldReader {
+public:
+    StateFieldReader(const uint8_t*& data, size_t& remaining) : m_data(data), m_remaining(remaining) {}
+
+    template <typename T>
+    void operator()(T& value) {
+        if (!take(sizeof(value))) return;
+        std::memcpy(&value, m_data, sizeof(value));
+        m_data += sizeof(value);
+    }
+    void operator()(bool& value) {
+        if (!take(1)) return;
+        value = *m_data++ != 0;
+    }
+    template <typename T, size_t N>
+    void operator()(std::array<T, N>& values) {
+        for (T& value : values) (*this)(value);
+    }
+
+    void finish() {
+        if (m_short) m_remaining = static_cast<size_t>(-1);
+    }
+
+private:
+    bool take(size_t size) {
+        if (m_short || m_remaining < size) {
+            m_short = true;
+            return false;
+        }
+        m_remaining -= size;
+        return true;
+    }
+
+    const uint8_t*& m_data;
+    size_t& m_remaining;
+    bool m_short = false;
+};
+
+} // namespace emu
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "input_types.hpp"
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 #include <string>
@@ -12,10 +13,12 @@
     #define EMU_PLUGIN_EXPORT
 #endif
 
-#define EMU_TAS_PLUGIN_API_VERSION 1
+#define EMU_TAS_PLUGIN_API_VERSION 10
 
 namespace emu {
 
+class IEmulatorPlugin;
+
 // TAS plugin information
 struct TASPluginInfo {
     const char* name;           // "TAS Editor", etc.
@@ -47,6 +50,74 @@ struct TASFrameData {
     int savestate_slot;             // Which slot, if applicable
 };
 
+// Brute-force input search
+//
+// Tries every controller 1 input sequence over frame_count frames from the
+// state at the start of start_frame and keeps the one that leaves the
+// objective (a little-endian RAM value read after settle_frames more frames
+// with no buttons) highest, or lowest if minimize. Each frame presses any
+// subset of button_mask on top of fixed_buttons.
+constexpr int TAS_SEARCH_MAX_FRAMES = 32;
+
+struct TASSearchParams {
+    uint64_t start_frame = 0;
+    int frame_count = 1;                // 1 to TAS_SEARCH_MAX_FRAMES
+    uint32_t button_mask = 0;           // Buttons tried on and off (VirtualButton bits)
+    uint32_t fixed_buttons = 0;         // Held on every searched frame
+    bool allow_opposites = false;       // Left+Right and Up+Down together
+    uint16_t objective_address = 0;
+    int objective_bytes = 1;            // 1 to 4
+    bool minimize = false;
+    int settle_frames = 0;
+    int max_threads = 0;                // 0 = one per hardware thread
+    uint64_t max_candidates = 1ull << 32;
+};
+
+struct TASSearchStatus {
+    bool running = false;
+    bool has_result = false;
+    uint64_t candidates_total = 0;
+    uint64_t candidates_done = 0;
+    int thread_count = 0;
+    int64_t best_value = 0;
+    int frame_count = 0;
+    uint32_t best_inputs[TAS_SEARCH_MAX_FRAMES] = {};
+};
+
+// Movie verification: the whole movie replayed on a background core with
+// drawing and audio skipped, to check where it ends up
+struct TASVerifyStatus {
+    bool running = false;
+    bool done = false;              // Ran every frame
+    uint64_t frames_total = 0;
+    uint64_t frames_done = 0;
+    uint64_t state_hash = 0;        // Of the end state; 0 if the core has no state hash
+    bool checked = false;           // The greenzone held the end state to check against
+    bool matches = false;           // And the replay ended on it
+};
+
+// A run of bytes in the core's address space
+struct TASMemoryRange {
+    uint16_t address;
+    uint32_t length;            // Up to 0x10000
+};
+
+// Script drawing, in framebuffer pixels. Colors are 0xRRGGBBAA.
+enum class TASDrawType : uint8_t {
+    Text,       // text at (x0, y0)
+    Box,        // outline from (x0, y0) to (x1, y1)
+    FilledBox,
+    Line,
+    Pixel       // at (x0, y0)
+};
+
+struct TASDrawCommand {
+    TASDrawType type;
+    int16_t x0, y0, x1, y1;
+    uint32_t color;
+    char text[64];
+};
+
 // Host interface provided to TAS plugins
 class ITASHost {
 public:
@@ -59,10 +130,36 @@ public:
     virtual void frame_advance() = 0;
     virtual bool is_emulator_paused() const = 0;
 
+    // Let the core skip audio generation and drawing while replaying frames
+    // nobody sees or hears
+    virtual void set_audio_enabled(bool enabled) { (void)enabled; }
+    virtual void set_video_enabled(bool enabled) { (void)enabled; }
+
+    // Run count movie frames back to back for seeking, skipping the host's
+    // per-frame work (presenting, audio output, GUI, plugin hooks). Audio is
+    // off throughout and only the last frame is drawn, if draw_last. Hosts
+    // should drive IEmulatorPlugin::run_frames() with RUN_FLAGS_SKIP_VIDEO |
+    // RUN_FLAGS_SKIP_AUDIO; the default goes through frame_advance().
+    virtual void run_frames_silent(const TASFrameData* frames, size_t count, bool draw_last = true) {
+        set_audio_enabled(false);
+        for (size_t i = 0; i < count; i++) {
+            for (int c = 0; c < 4; c++) set_controller_input(c, frames[i].controller_inputs[c]);
+            set_video_enabled(draw_last && i + 1 == count);
+            frame_advance();
+        }
+        set_video_enabled(true);
+        set_audio_enabled(true);
+    }
+
     // Frame info
     virtual uint64_t get_current_frame() const = 0;
     virtual double get_fps() const = 0;
 
+    // Whether the last frame run, including the last of a
+    // run_frames_silent() batch, was a lag frame
+    // (IEmulatorPlugin::is_lag_frame())
+    virtual bool is_lag_frame() const { return false; }
+
     // Input injection
     virtual void set_controller_input(int controller, uint32_t buttons) = 0;
     virtual uint32_t get_controller_input(int controller) const = 0;
@@ -81,6 +178,26 @@ public:
     // Memory access (for Lua scripting support)
     virtual uint8_t read_memory(uint16_t address) = 0;
     virtual void write_memory(uint16_t address, uint8_t value) = 0;
+
+    // Read several ranges in one call, packed back to back into out (which
+    // holds the sum of their lengths). Scripts snapshot the memory they
+    // watch with this once a frame instead of calling read_memory() per
+    // byte; hosts should copy straight from the core's memory blocks.
+    virtual void read_memory_ranges(const TASMemoryRange* ranges, size_t count, uint8_t* out) {
+        for (size_t i = 0; i < count; i++) {
+            for (uint32_t j = 0; j < ranges[i].length; j++) {
+                *out++ = read_memory(static_cast<uint16_t>(ranges[i].address + j));
+            }
+        }
+    }
+
+    // Background cores (optional)
+    // An independent copy of the core with the current ROM loaded and video/
+    // audio output disabled. The plugin may drive it from its own thread to
+    // refill the greenzone after edits. Returns nullptr if the host cannot
+    // make one.
+    virtual IEmulatorPlugin* create_emulator_clone() { return nullptr; }
+    virtual void destroy_emulator_clone(IEmulatorPlugin* clone) { (void)clone; }
 };
 
 // TAS mode
@@ -130,6 +247,17 @@ public:
 
     // Frame operations for editing
     virtual TASFrameData get_frame(uint64_t frame) const = 0;
+
+    // Copy up to count frames from start into out and return how many there
+    // were, so a view fetches its visible rows in one call
+    virtual uint64_t get_frames(uint64_t start, uint64_t count, TASFrameData* out) const {
+        uint64_t total = get_total_frames();
+        uint64_t copied = 0;
+        for (uint64_t frame = start; frame < total && copied < count; frame++) {
+            out[copied++] = get_frame(frame);
+        }
+        return copied;
+    }
     virtual void set_frame(uint64_t frame, const TASFrameData& data) = 0;
     virtual void insert_frame(uint64_t after_frame) = 0;
     virtual void delete_frame(uint64_t frame) = 0;
@@ -147,6 +275,56 @@ public:
     virtual bool has_greenzone_at(uint64_t frame) const = 0;
     virtual bool seek_to_frame(uint64_t frame) = 0;
 
+    // Memory the greenzone may hold before it drops its least recently
+    // used states (optional)
+    virtual void set_greenzone_budget(size_t bytes) { (void)bytes; }
+    virtual size_t get_greenzone_budget() const { return 0; }
+    virtual size_t get_greenzone_memory_used() const { return 0; }
+
+    // Give memory back now, down to max_bytes, without lowering the budget
+    // (the host's memory budget; optional)
+    virtual void trim_greenzone(size_t max_bytes) { (void)max_bytes; }
+
+    // Which of count frames from start have a state: bit i of bits (LSB
+    // first, (count + 7) / 8 bytes) for frame start + i. The revision
+    // changes whenever states are added or dropped, so a view can keep the
+    // bits until it does; 0 means the plugin doesn't track it.
+    virtual void get_greenzone_presence(uint64_t start, uint64_t count, uint8_t* bits) const {
+        for (uint64_t i = 0; i < (count + 7) / 8; i++) bits[i] = 0;
+        for (uint64_t i = 0; i < count; i++) {
+            if (has_greenzone_at(start + i)) bits[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+        }
+    }
+    virtual uint64_t get_greenzone_revision() const { return 0; }
+
+    // Which of count frames from start were lag frames the last time they
+    // ran, packed like get_greenzone_presence(). Frames that haven't run
+    // since their input last changed read as 0. The revision changes with
+    // the bits; 0 means the plugin doesn't track lag.
+    virtual void get_lag_frames(uint64_t start, uint64_t count, uint8_t* bits) const {
+        (void)start;
+        for (uint64_t i = 0; i < (count + 7) / 8; i++) bits[i] = 0;
+    }
+    virtual uint64_t get_lag_revision() const { return 0; }
+
+    // Brute-force input search on background cores (optional; needs the
+    // host's create_emulator_clone()). start_search() seeks to
+    // params.start_frame and returns false if the search can't run there.
+    // apply_search_result() writes the best sequence into the movie as one
+    // undoable edit.
+    virtual bool start_search(const TASSearchParams& params) { (void)params; return false; }
+    virtual void cancel_search() {}
+    virtual bool get_search_status(TASSearchStatus& status) { (void)status; return false; }
+    virtual bool apply_search_result() { return false; }
+
+    // Movie verification (optional; needs create_emulator_clone()). The
+    // end state is checked against the one normal playback left in the
+    // greenzone when it has it. start_verify() returns false if the
+    // movie can't be replayed on a clone.
+    virtual bool start_verify() { return false; }
+    virtual void cancel_verify() {}
+    virtual bool get_verify_status(TASVerifyStatus& status) { (void)status; return false; }
+
     // Selection (for batch editing in GUI)
     virtual void set_selection(uint64_t start, uint64_t end) = 0;
     virtual void get_selection(uint64_t& start, uint64_t& end) const = 0;
@@ -171,6 +349,12 @@ public:
     virtual bool load_lua_script(const char* filename) { return false; }
     virtual void unload_lua_script() {}
     virtual bool is_lua_running() const { return false; }
+
+    // What the script drew for the last frame it finished, for the GUI
+    // thread to draw over the game; stays until the next frame replaces it.
+    // The error is empty unless the script stopped on one.
+    virtual void get_lua_overlay(std::vector<TASDrawCommand>& commands) { commands.clear(); }
+    virtual const char* get_lua_error() { return ""; }
 };
 
 } // namespace emu
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Trace events for frame phases, viewable in chrome://tracing or Perfetto
+//
+// The host owns a Tracer and hands it to the core with set_tracer(); code
+// marks phases with the macros below. The macros compile to nothing unless
+// the build defines VELOCE_TRACING (the VELOCE_ENABLE_TRACING CMake option),
+// and when compiled in they cost one relaxed load until recording is
+// switched on at runtime.
+//
+//   EMU_TRACE_SCOPE(m_tracer, "gba", "cpu");          // Rest of the scope
+//   EMU_TRACE_COUNTER(m_tracer, "gba", "instructions", count);
+//
+// Scopes are meant for phases (a frame, a scanline batch, an audio push),
+// not per-cycle work: each recorded event takes a lock.
+
+namespace emu {
+
+struct TraceEvent {
+    std::string category;
+    std::string name;
+    char phase = 'X';          // 'X' complete event, 'C' counter
+    uint64_t timestamp_ns = 0;
+    uint64_t duration_ns = 0;  // Complete events only
+    int64_t value = 0;         // Counters only
+    size_t thread = 0;         // Hash of the recording thread's id
+};
+
+class Tracer {
+public:
+    // Recording stops adding events past this, so a forgotten trace can't
+    // eat all memory (a few minutes of typical frame-phase tracing)
+    static constexpr size_t MAX_EVENTS = 4u << 20;
+
+    // True when the macros were compiled in
+    static constexpr bool compiled_in() {
+#ifdef VELOCE_TRACING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool is_enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+    void set_enabled(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+
+    static uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    static size_t current_thread() { return std::hash<std::thread::id>()(std::this_thread::get_id()); }
+
+    void complete(const char* category, const char* name, uint64_t start_ns, uint64_t end_ns) {
+        TraceEvent event;
+        event.category = category;
+        event.name = name;
+        event.phase = 'X';
+        event.timestamp_ns = start_ns;
+        event.duration_ns = end_ns - start_ns;
+        event.thread = current_thread();
+        add(std::move(event));
+    }
+
+    void counter(const char* category, const char* name, int64_t value) {
+        TraceEvent event;
+        event.category = category;
+        event.name = name;
+        event.phase = 'C';
+        event.timestamp_ns = now_ns();
+        event.value = value;
+        event.thread = current_thread();
+        add(std::move(event));
+    }
+
+    // Name the calling thread in the trace viewer
+    void set_thread_name(const char* name) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t thread = current_thread();
+        for (auto& entry : m_thread_names) {
+            if (entry.first == thread) {
+                entry.second = name;
+                return;
+            }
+        }
+        m_thread_names.emplace_back(thread, name);
+    }
+
+    // Hand over everything recorded so far and start afresh
+    std::vector<TraceEvent> take_events() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_dropped = 0;
+        return std::exchange(m_events, {});
+    }
+
+    std::vector<std::pair<size_t, std::string>> get_thread_names() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_thread_names;
+    }
+
+    // Events lost to MAX_EVENTS since the last take_events()
+    size_t get_dropped_count() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_dropped;
+    }
+
+private:
+    void add(TraceEvent&& event) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_events.size() >= MAX_EVENTS) {
+            m_dropped++;
+            return;
+        }
+        m_events.push_back(std::move(event));
+    }
+
+    std::atomic<bool> m_enabled{false};
+    mutable std::mutex m_mutex;
+    std::vector<TraceEvent> m_events;
+    std::vector<std::pair<size_t, std::string>> m_thread_names;
+    size_t m_dropped = 0;
+};
+
+// Records a complete event for the rest of a scope, if recording is on
+class TraceScope {
+public:
+    TraceScope(Tracer* tracer, const char* category, const char* name)
+        : m_tracer(tracer && tracer->is_enabled() ? tracer : nullptr),
+          m_category(category), m_name(name), m_start(m_tracer ? Tracer::now_ns() : 0) {}
+    ~TraceScope() {
+        if (m_tracer) m_tracer->complete(m_category, m_name, m_start, Tracer::now_ns());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    Tracer* m_tracer;
+    const char* m_category;
+    const char* m_name;
+    uint64_t m_start;
+};
+
+} // namespace emu
+
+#ifdef VELOCE_TRACING
+    #define EMU_TRACE_CONCAT_INNER(a, b) a##b
+    #define EMU_TRACE_CONCAT(a, b) EMU_TRACE_CONCAT_INNER(a, b)
+    #define EMU_TRACE_SCOPE(tracer, category, name) \
+        ::emu::TraceScope EMU_TRACE_CONCAT(emu_trace_scope_, __LINE__)((tracer), (category), (name))
+    #define EMU_TRACE_COUNTER(tracer, category, name, value) \
+        do { \
+            ::emu::Tracer* emu_trace_tracer = (tracer); \
+            if (emu_trace_tracer && emu_trace_tracer->is_enabled()) \
+                emu_trace_tracer->counter((category), (name), static_cast<int64_t>(value)); \
+        } while (0)
+#else
+    #define EMU_TRACE_SCOPE(tracer, category, name) ((void)0)
+    #define EMU_TRACE_COUNTER(tracer, category, name, value) ((void)sizeof(value))
+#endif
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace emu {
+
+// A CPU write to a watched address (see IEmulatorPlugin::set_write_watchpoints())
+struct WriteWatchHit {
+    uint32_t address;       // CPU bus address
+    uint8_t value;          // Byte written
+    uint64_t frame;         // get_frame_count() once the frame of the write ended
+    float frame_position;   // How far into that frame it happened, 0 to 1
+};
+
+// Hits stamped with a core's cycle counter and placed within their frame
+// once it ends; Hit needs frame and frame_position members. Shared by
+// WriteWatchpoints and Breakpoints.
+template <typename Hit>
+class FrameHitLog {
+public:
+    // Counter read for each hit, in the core's own cycles
+    void set_clock(const uint64_t* clock) { m_clock = clock; }
+
+    void clear() {
+        m_hits.clear();
+        m_frame_hits = 0;
+    }
+
+    // Bracket each frame the core runs, with its cycle counter at either end
+    void begin_frame(uint64_t cycle) {
+        m_frame_start = cycle;
+        m_frame_hits = m_hits.size();
+    }
+    void end_frame(uint64_t cycle, uint64_t frame) {
+        double length = cycle > m_frame_start ? static_cast<double>(cycle - m_frame_start) : 1.0;
+        for (size_t i = m_frame_hits; i < m_hits.size(); i++) {
+            Pending& hit = m_hits[i];
+            double position = static_cast<double>(hit.cycle - m_frame_start) / length;
+            hit.hit.frame = frame;
+            hit.hit.frame_position = static_cast<float>(std::min(position, 1.0));
+        }
+        m_frame_hits = m_hits.size();
+    }
+
+    void record(const Hit& hit) {
+        if (m_hits.size() >= MAX_HITS) return;
+        uint64_t cycle = m_clock ? *m_clock : m_frame_start;
+        m_hits.push_back({hit, std::max(cycle, m_frame_start)});
+    }
+
+    // Move hits of finished frames into out, oldest first; returns how many
+    size_t take(Hit* out, size_t max) {
+        size_t count = std::min(max, m_frame_hits);
+        for (size_t i = 0; i < count; i++) {
+            out[i] = m_hits[i].hit;
+        }
+        m_hits.erase(m_hits.begin(), m_hits.begin() + count);
+        m_frame_hits -= count;
+        return count;
+    }
+
+private:
+    // Hits beyond this are dropped until the host takes them
+    static constexpr size_t MAX_HITS = 1024;
+
+    struct Pending {
+        Hit hit;
+        uint64_t cycle;
+    };
+
+    std::vector<Pending> m_hits;
+    size_t m_frame_hits = 0;        // Hits of finished frames, at the front of m_hits
+    uint64_t m_frame_start = 0;
+    const uint64_t* m_clock = nullptr;
+};
+
+// Write watchpoints for a core's bus
+//
+// The bus holds a pointer to this only while addresses are watched, so with
+// none the write path pays one null test. With some, each write costs a
+// bit test in a small hashed bitmap, and only writes whose bit is set search
+// the (short, sorted) address list. Hits carry the core's cycle counter and
+// get placed within their frame by end_frame().
+class WriteWatchpoints {
+public:
+    // Watch these addresses instead of the previous ones
+    void set(const uint32_t* addresses, size_t count) {
+        m_addresses.assign(addresses, addresses + count);
+        std::sort(m_addresses.begin(), m_addresses.end());
+        m_addresses.erase(std::unique(m_addresses.begin(), m_addresses.end()), m_addresses.end());
+        m_filter.fill(0);
+        for (uint32_t address : m_addresses) {
+            uint32_t bit = filter_bit(address);
+            m_filter[bit >> 6] |= uint64_t(1) << (bit & 63);
+        }
+        m_log.clear();
+    }
+
+    bool empty() const { return m_addresses.empty(); }
+
+    // Counter read for each hit, in the core's own cycles
+    void set_clock(const uint64_t* clock) { m_log.set_clock(clock); }
+
+    // From the bus's write path
+    void check(uint32_t address, uint8_t value) {
+        uint32_t bit = filter_bit(address);
+        if (m_filter[bit >> 6] & (uint64_t(1) << (bit & 63))) {
+            record(address, value);
+        }
+    }
+
+    // Bracket each frame the core runs, with its cycle counter at either end
+    void begin_frame(uint64_t cycle) { m_log.begin_frame(cycle); }
+    void end_frame(uint64_t cycle, uint64_t frame) { m_log.end_frame(cycle, frame); }
+
+    // Move hits of finished frames into out, oldest first; returns how many
+    size_t take(WriteWatchHit* out, size_t max) { return m_log.take(out, max); }
+
+private:
+    static uint32_t filter_bit(uint32_t address) {
+        return (address * 0x9E3779B1u) >> 20;   // 4096 bits
+    }
+
+    void record(uint32_t address, uint8_t value) {
+        if (!std::binary_search(m_addresses.begin(), m_addresses.end(), address)) return;
+        m_log.record({address, value, 0, 0.0f});
+    }
+
+    std::array<uint64_t, 64> m_filter{};
+    std::vector<uint32_t> m_addresses;
+    FrameHitLog<WriteWatchHit> m_log;
+};
+
+} // namespace emu
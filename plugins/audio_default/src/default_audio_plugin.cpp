@@ -1,9 +1,15 @@
 #include "emu/audio_plugin.hpp"
+#include "effect_chain.hpp"
 #include <cstring>
 #include <algorithm>
 
 namespace {
 
+using audio_default::EffectChain;
+using audio_default::EffectSettings;
+using audio_default::EFFECT_COUNT;
+using audio_default::EFFECT_SPECS;
+
 class DefaultAudioPlugin : public emu::IAudioPlugin {
 public:
     DefaultAudioPlugin() = default;
@@ -14,15 +20,19 @@ public:
             "Default Audio",
             "1.0.0",
             "Veloce Team",
-            "Standard audio passthrough with volume control. Provides basic "
-            "muting and volume adjustment for emulator audio output.",
+            "Volume control plus a low-pass filter, DC blocker, stereo width "
+            "and limiter on the host's output path.",
             false,  // No recording
-            false   // No effects
+            true    // Effects
         };
     }
 
     bool initialize(emu::IAudioHost* host) override {
         m_host = host;
+        if (m_host) {
+            m_chain.set_sample_rate(m_host->get_format().sample_rate);
+        }
+        m_chain.reset();
         return true;
     }
 
@@ -33,34 +43,33 @@ public:
     void process(const float* input, size_t sample_count) override {
         if (!m_host || !input || sample_count == 0) return;
 
-        // Apply volume and mute
-        float effective_volume = m_muted ? 0.0f : m_volume;
-
-        if (effective_volume == 1.0f) {
-            // Direct passthrough
-            m_host->output_samples(input, sample_count);
-        } else {
-            // Apply volume
-            // Use stack buffer for small amounts, heap for large
-            constexpr size_t STACK_BUFFER_SIZE = 4096;
-            float stack_buffer[STACK_BUFFER_SIZE];
-            float* buffer = sample_count <= STACK_BUFFER_SIZE ?
-                            stack_buffer : new float[sample_count];
-
-            for (size_t i = 0; i < sample_count; i++) {
-                buffer[i] = input[i] * effective_volume;
-            }
-
-            m_host->output_samples(buffer, sample_count);
-
-            if (sample_count > STACK_BUFFER_SIZE) {
-                delete[] buffer;
-            }
+        // Same chain as process_in_place(), over a copy
+        constexpr size_t STACK_BUFFER_SIZE = 4096;
+        float buffer[STACK_BUFFER_SIZE];
+        while (sample_count > 0) {
+            size_t count = std::min(sample_count, STACK_BUFFER_SIZE);
+            std::memcpy(buffer, input, count * sizeof(float));
+            process_in_place(buffer, count);
+            m_host->output_samples(buffer, count);
+            input += count;
+            sample_count -= count;
+        }
+    }
+
+    bool process_in_place(float* samples, size_t sample_count) override {
+        // Settings changes from the GUI are picked up at the start of a call
+        if (const EffectSettings* settings = m_exchange.fetch()) {
+            m_chain.configure(*settings);
+        }
+        if (!m_chain.is_bypassed()) {
+            m_chain.process(samples, sample_count / 2);
         }
+        return true;
     }
 
     void set_volume(float volume) override {
         m_volume = std::clamp(volume, 0.0f, 1.0f);
+        publish();
     }
 
     float get_volume() const override {
@@ -69,16 +78,76 @@ public:
 
     void set_muted(bool muted) override {
         m_muted = muted;
+        publish();
     }
 
     bool is_muted() const override {
         return m_muted;
     }
 
+    int get_effect_count() const override {
+        return EFFECT_COUNT;
+    }
+
+    const char* get_effect_name(int index) const override {
+        return valid_effect(index) ? EFFECT_SPECS[index].name : nullptr;
+    }
+
+    bool is_effect_enabled(int index) const override {
+        return valid_effect(index) && m_settings.enabled[index];
+    }
+
+    void set_effect_enabled(int index, bool enabled) override {
+        if (!valid_effect(index)) return;
+        m_settings.enabled[index] = enabled;
+        publish();
+    }
+
+    float get_effect_parameter(int index, int param) const override {
+        return valid_param(index, param) ? m_settings.params[index][param] : 0.0f;
+    }
+
+    void set_effect_parameter(int index, int param, float value) override {
+        if (!valid_param(index, param)) return;
+        const auto& spec = EFFECT_SPECS[index].params[param];
+        m_settings.params[index][param] = std::clamp(value, spec.min, spec.max);
+        publish();
+    }
+
+    int get_effect_parameter_count(int index) const override {
+        return valid_effect(index) ? EFFECT_SPECS[index].param_count : 0;
+    }
+
+    bool get_effect_parameter_info(int index, int param, emu::AudioEffectParameterInfo& info) const override {
+        if (!valid_param(index, param)) return false;
+        const auto& spec = EFFECT_SPECS[index].params[param];
+        info = {spec.name, spec.min, spec.max, spec.default_value};
+        return true;
+    }
+
 private:
+    static bool valid_effect(int index) {
+        return index >= 0 && index < EFFECT_COUNT;
+    }
+
+    static bool valid_param(int index, int param) {
+        return valid_effect(index) && param >= 0 && param < EFFECT_SPECS[index].param_count;
+    }
+
+    // Hand the settings to the audio path. The setters are called from one
+    // thread (the GUI), which owns m_settings.
+    void publish() {
+        m_settings.gain = m_muted ? 0.0f : m_volume;
+        m_exchange.publish(m_settings);
+    }
+
     emu::IAudioHost* m_host = nullptr;
     float m_volume = 1.0f;
     bool m_muted = false;
+
+    EffectSettings m_settings = EffectSettings::defaults();
+    audio_default::SettingsExchange m_exchange;
+    EffectChain m_chain;  // Audio path only
 };
 
 } // anonymous namespace
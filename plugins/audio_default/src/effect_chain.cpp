@@ -0,0 +1,178 @@
+#include "effect_chain.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace audio_default {
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+
+} // namespace
+
+const EffectSpec EFFECT_SPECS[EFFECT_COUNT] = {
+    {"Low-Pass", 1, {{"Cutoff (Hz)", 1000.0f, 20000.0f, 12000.0f}}},
+    {"DC Blocker", 1, {{"Cutoff (Hz)", 5.0f, 100.0f, 20.0f}}},
+    {"Stereo Width", 1, {{"Width", 0.0f, 2.0f, 1.0f}}},
+    {"Limiter", 2, {{"Threshold (dB)", -24.0f, 0.0f, -1.0f}, {"Release (ms)", 10.0f, 1000.0f, 100.0f}}},
+};
+
+EffectSettings EffectSettings::defaults() {
+    EffectSettings settings;
+    for (int effect = 0; effect < EFFECT_COUNT; effect++) {
+        for (int param = 0; param < EFFECT_SPECS[effect].param_count; param++) {
+            settings.params[effect][param] = EFFECT_SPECS[effect].params[param].default_value;
+        }
+    }
+    return settings;
+}
+
+// ============================================================================
+// SettingsExchange
+// ============================================================================
+
+SettingsExchange::SettingsExchange() {
+    for (auto& slot : m_slots) {
+        slot = EffectSettings::defaults();
+    }
+}
+
+void SettingsExchange::publish(const EffectSettings& settings) {
+    m_slots[m_back] = settings;
+    m_back = m_middle.exchange(static_cast<uint8_t>(m_back | NEW_BIT), std::memory_order_acq_rel) & INDEX_MASK;
+}
+
+const EffectSettings* SettingsExchange::fetch() {
+    if (!(m_middle.load(std::memory_order_acquire) & NEW_BIT)) {
+        return nullptr;
+    }
+    m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+    return &m_slots[m_front];
+}
+
+// ============================================================================
+// EffectChain
+// ============================================================================
+
+void EffectChain::set_sample_rate(int sample_rate) {
+    if (sample_rate <= 0 || sample_rate == m_sample_rate) return;
+    m_sample_rate = sample_rate;
+    update_coefficients();
+}
+
+void EffectChain::configure(const EffectSettings& settings) {
+    m_settings = settings;
+    update_coefficients();
+}
+
+void EffectChain::reset() {
+    std::fill(std::begin(m_lp_z1), std::end(m_lp_z1), 0.0f);
+    std::fill(std::begin(m_lp_z2), std::end(m_lp_z2), 0.0f);
+    std::fill(std::begin(m_dc_x1), std::end(m_dc_x1), 0.0f);
+    std::fill(std::begin(m_dc_y1), std::end(m_dc_y1), 0.0f);
+    m_limit_envelope = 0.0f;
+}
+
+void EffectChain::update_coefficients() {
+    double rate = static_cast<double>(m_sample_rate);
+    const auto& params = m_settings.params;
+
+    // Butterworth low-pass (bilinear transform, Q = 1/sqrt(2)), kept below Nyquist
+    double cutoff = std::min(static_cast<double>(params[EFFECT_LOW_PASS][0]), rate * 0.45);
+    double k = std::tan(PI * cutoff / rate);
+    double norm = 1.0 / (1.0 + std::sqrt(2.0) * k + k * k);
+    m_lp_b0 = static_cast<float>(k * k * norm);
+    m_lp_b1 = 2.0f * m_lp_b0;
+    m_lp_b2 = m_lp_b0;
+    m_lp_a1 = static_cast<float>(2.0 * (k * k - 1.0) * norm);
+    m_lp_a2 = static_cast<float>((1.0 - std::sqrt(2.0) * k + k * k) * norm);
+
+    m_dc_r = static_cast<float>(std::exp(-2.0 * PI * params[EFFECT_DC_BLOCKER][0] / rate));
+
+    m_limit_threshold = std::pow(10.0f, params[EFFECT_LIMITER][0] / 20.0f);
+    double release_samples = params[EFFECT_LIMITER][1] * 0.001 * rate;
+    m_limit_release = static_cast<float>(std::exp(-1.0 / std::max(release_samples, 1.0)));
+
+    bool any_enabled = std::any_of(std::begin(m_settings.enabled), std::end(m_settings.enabled),
+                                   [](bool enabled) { return enabled; });
+    m_bypassed = !any_enabled && m_settings.gain == 1.0f;
+}
+
+void EffectChain::process(float* samples, size_t frames) {
+    if (m_bypassed) return;
+    while (frames > 0) {
+        size_t count = std::min(frames, BLOCK_FRAMES);
+        process_block(samples, count);
+        samples += count * 2;
+        frames -= count;
+    }
+}
+
+void EffectChain::process_block(float* samples, size_t frames) {
+    const size_t count = frames * 2;
+
+    // The filters are recursive along time, so they run frame by frame with
+    // the two channels side by side; the element-wise stages below are
+    // plain loops over the whole block that compilers vectorize
+    if (m_settings.enabled[EFFECT_LOW_PASS]) {
+        for (size_t i = 0; i < count; i += 2) {
+            for (size_t ch = 0; ch < 2; ch++) {
+                float x = samples[i + ch];
+                float y = m_lp_b0 * x + m_lp_z1[ch];
+                m_lp_z1[ch] = m_lp_b1 * x - m_lp_a1 * y + m_lp_z2[ch];
+                m_lp_z2[ch] = m_lp_b2 * x - m_lp_a2 * y;
+                samples[i + ch] = y;
+            }
+        }
+    }
+
+    if (m_settings.enabled[EFFECT_DC_BLOCKER]) {
+        for (size_t i = 0; i < count; i += 2) {
+            for (size_t ch = 0; ch < 2; ch++) {
+                float x = samples[i + ch];
+                float y = x - m_dc_x1[ch] + m_dc_r * m_dc_y1[ch];
+                m_dc_x1[ch] = x;
+                m_dc_y1[ch] = y;
+                samples[i + ch] = y;
+            }
+        }
+    }
+
+    if (m_settings.enabled[EFFECT_STEREO_WIDTH]) {
+        // Mid/side: width 0 is mono, 1 unchanged, 2 doubles the side signal
+        const float side_gain = m_settings.params[EFFECT_STEREO_WIDTH][0];
+        for (size_t i = 0; i < count; i += 2) {
+            float mid = 0.5f * (samples[i] + samples[i + 1]);
+            float side = 0.5f * (samples[i] - samples[i + 1]) * side_gain;
+            samples[i] = mid + side;
+            samples[i + 1] = mid - side;
+        }
+    }
+
+    // Volume and limiter gains are worked out per frame, then applied to
+    // the block in one pass
+    float gains[BLOCK_FRAMES];
+    const float volume = m_settings.gain;
+    if (m_settings.enabled[EFFECT_LIMITER]) {
+        float envelope = m_limit_envelope;
+        for (size_t f = 0; f < frames; f++) {
+            float peak = std::max(std::fabs(samples[f * 2]), std::fabs(samples[f * 2 + 1])) * volume;
+            envelope = peak > envelope ? peak : envelope * m_limit_release + peak * (1.0f - m_limit_release);
+            gains[f] = envelope > m_limit_threshold ? volume * m_limit_threshold / envelope : volume;
+        }
+        m_limit_envelope = envelope;
+    } else if (volume != 1.0f) {
+        std::fill(gains, gains + frames, volume);
+    } else {
+        return;
+    }
+
+    for (size_t f = 0; f < frames; f++) {
+        samples[f * 2] *= gains[f];
+        samples[f * 2 + 1] *= gains[f];
+    }
+}
+
+} // namespace audio_default
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace audio_default {
+
+// Effects in chain order
+enum EffectIndex {
+    EFFECT_LOW_PASS,
+    EFFECT_DC_BLOCKER,
+    EFFECT_STEREO_WIDTH,
+    EFFECT_LIMITER,
+    EFFECT_COUNT
+};
+
+constexpr int MAX_EFFECT_PARAMS = 2;
+
+struct EffectParamSpec {
+    const char* name;
+    float min;
+    float max;
+    float default_value;
+};
+
+struct EffectSpec {
+    const char* name;
+    int param_count;
+    EffectParamSpec params[MAX_EFFECT_PARAMS];
+};
+
+extern const EffectSpec EFFECT_SPECS[EFFECT_COUNT];
+
+// Everything the audio thread needs to know about the chain's configuration
+struct EffectSettings {
+    bool enabled[EFFECT_COUNT] = {};
+    float params[EFFECT_COUNT][MAX_EFFECT_PARAMS] = {};
+    float gain = 1.0f;  // Volume, 0 when muted
+
+    // Defaults from EFFECT_SPECS, all effects off
+    static EffectSettings defaults();
+};
+
+// Lock-free hand-off of settings from one writer thread (the GUI) to the
+// audio thread. A triple buffer: the writer fills its own slot and swaps it
+// into the middle, the reader swaps the middle out when it's marked new, so
+// neither side ever waits or sees a half-written set.
+class SettingsExchange {
+public:
+    SettingsExchange();
+
+    void publish(const EffectSettings& settings);
+
+    // Latest settings if any were published since the last fetch
+    const EffectSettings* fetch();
+
+private:
+    static constexpr uint8_t INDEX_MASK = 3;
+    static constexpr uint8_t NEW_BIT = 4;
+
+    EffectSettings m_slots[3];
+    std::atomic<uint8_t> m_middle{1};
+    uint8_t m_back = 0;   // Writer's slot
+    uint8_t m_front = 2;  // Reader's slot
+};
+
+// Low-pass, DC blocker, stereo width and limiter over interleaved stereo
+// float samples, run in blocks of BLOCK_FRAMES
+class EffectChain {
+public:
+    static constexpr size_t BLOCK_FRAMES = 64;
+
+    void set_sample_rate(int sample_rate);
+
+    // Take new settings; recomputes coefficients, keeps filter state
+    void configure(const EffectSettings& settings);
+
+    // True when process() would leave samples unchanged
+    bool is_bypassed() const { return m_bypassed; }
+
+    void process(float* samples, size_t frames);
+
+    // Clear filter and envelope state
+    void reset();
+
+private:
+    void update_coefficients();
+    void process_block(float* samples, size_t frames);
+
+    int m_sample_rate = 48000;
+    EffectSettings m_settings;
+    bool m_bypassed = true;
+
+    // Low-pass: 2nd-order Butterworth biquad, transposed direct form II
+    float m_lp_b0 = 1.0f, m_lp_b1 = 0.0f, m_lp_b2 = 0.0f, m_lp_a1 = 0.0f, m_lp_a2 = 0.0f;
+    float m_lp_z1[2] = {}, m_lp_z2[2] = {};
+
+    // DC blocker: y[n] = x[n] - x[n-1] + r * y[n-1]
+    float m_dc_r = 0.999f;
+    float m_dc_x1[2] = {}, m_dc_y1[2] = {};
+
+    // Limiter: instant attack, exponential release on the peak envelope
+    float m_limit_threshold = 1.0f;
+    float m_limit_release = 0.999f;
+    float m_limit_envelope = 0.0f;
+};
+
+} // namespace audio_default
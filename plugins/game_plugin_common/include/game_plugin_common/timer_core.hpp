@@ -26,8 +26,9 @@ public:
     void pause();
     void resume();
 
-    // Split control
-    void split();
+    // Split control. seconds_ago backdates the split to when its event
+    // happened (IGamePlugin::on_watched_write()), never before the last one.
+    void split(double seconds_ago = 0.0);
     void undo_split();
     void skip_split();
 
@@ -37,6 +38,13 @@ public:
     int get_current_split_index() const { return m_data.current_split; }
     int get_total_splits() const { return static_cast<int>(m_data.splits.size()); }
 
+    // Lag accounting. Call once per emulated frame with whether the core
+    // reported it as a lag frame and how long a frame lasts; lag frames are
+    // only counted while the timer runs.
+    void on_frame(bool lag_frame, double frame_ms);
+    uint64_t get_lag_frames() const { return m_data.lag_frames; }
+    uint64_t get_lag_removed_time_ms() const;
+
     // Split timing
     emu::SplitTiming get_split_timing(int index) const;
     uint64_t get_best_possible_time_ms() const;
@@ -40,6 +40,10 @@ struct TimerData {
     uint64_t accumulated_time_ms = 0;
     int current_split = 0;
 
+    // Lag frames seen while running (TimerCore::on_frame())
+    uint64_t lag_frames = 0;
+    double lag_ms = 0.0;
+
     // Split data
     std::vector<SplitState> splits;
     std::string game_name;
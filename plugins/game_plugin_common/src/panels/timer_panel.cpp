@@ -71,6 +71,13 @@ void TimerPanel::render_timer_section(TimerCore& timer) {
         ImGui::TextDisabled("Attempts: %d/%d", timer.get_completed_count(), attempt_count);
     }
 
+    // Lag frames, and the time with them taken out
+    uint64_t lag_frames = timer.get_lag_frames();
+    if (lag_frames > 0) {
+        ImGui::TextDisabled("Lag: %llu frames (%s without)", (unsigned long long)lag_frames,
+                            format_time(timer.get_lag_removed_time_ms()).c_str());
+    }
+
     // Sum of Best
     uint64_t sob = timer.get_sum_of_best_ms();
     if (sob > 0) {
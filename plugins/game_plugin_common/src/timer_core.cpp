@@ -15,6 +15,8 @@ void TimerCore::start() {
         m_data.start_time = std::chrono::steady_clock::now();
         m_data.accumulated_time_ms = 0;
         m_data.current_split = 0;
+        m_data.lag_frames = 0;
+        m_data.lag_ms = 0.0;
         m_data.attempt_count++;
 
         // Reset all splits
@@ -50,6 +52,8 @@ void TimerCore::reset() {
     m_data.state = emu::TimerState::NotRunning;
     m_data.accumulated_time_ms = 0;
     m_data.current_split = 0;
+    m_data.lag_frames = 0;
+    m_data.lag_ms = 0.0;
 
     for (auto& split : m_data.splits) {
         split.split_time_ms = 0;
@@ -79,7 +83,7 @@ void TimerCore::resume() {
     }
 }
 
-void TimerCore::split() {
+void TimerCore::split(double seconds_ago) {
     if (m_data.current_split >= static_cast<int>(m_data.splits.size())) return;
     if (m_data.state != emu::TimerState::Running) return;
 
@@ -91,6 +95,11 @@ void TimerCore::split() {
         prev_split_time = m_data.splits[m_data.current_split - 1].split_time_ms;
     }
 
+    if (seconds_ago > 0.0) {
+        uint64_t back_ms = static_cast<uint64_t>(seconds_ago * 1000.0 + 0.5);
+        current_time = std::max(current_time > back_ms ? current_time - back_ms : 0, prev_split_time);
+    }
+
     m_data.splits[m_data.current_split].split_time_ms = current_time;
     m_data.splits[m_data.current_split].segment_time_ms = current_time - prev_split_time;
     m_data.splits[m_data.current_split].completed = true;
@@ -112,6 +121,7 @@ void TimerCore::split() {
     // Check if run is complete
     if (m_data.current_split >= static_cast<int>(m_data.splits.size())) {
         stop();
+        m_data.accumulated_time_ms = current_time;   // Final time as split, if backdated
         m_data.completed_count++;
 
         // Record in run history
@@ -166,6 +176,19 @@ uint64_t TimerCore::get_current_time_ms() const {
     return m_data.accumulated_time_ms;
 }
 
+void TimerCore::on_frame(bool lag_frame, double frame_ms) {
+    if (lag_frame && m_data.state == emu::TimerState::Running) {
+        m_data.lag_frames++;
+        m_data.lag_ms += frame_ms;
+    }
+}
+
+uint64_t TimerCore::get_lag_removed_time_ms() const {
+    uint64_t lag = static_cast<uint64_t>(m_data.lag_ms + 0.5);
+    uint64_t current = get_current_time_ms();
+    return current > lag ? current - lag : 0;
+}
+
 emu::SplitTiming TimerCore::get_split_timing(int index) const {
     emu::SplitTiming timing{};
 
@@ -1,9 +1,14 @@
 #include "emu/netplay_plugin.hpp"
 #include "netplay_input_manager.hpp"
+#include "netplay_metrics.hpp"
+#include "speculation.hpp"
+#include "state_hash_log.hpp"
+#include "udp_transport.hpp"
 
 #include <imgui.h>
 #include <nlohmann/json.hpp>
 #include <string>
+#include <array>
 #include <deque>
 #include <vector>
 #include <chrono>
@@ -15,6 +20,9 @@
 #include <filesystem>
 #include <algorithm>
 #include <cctype>
+#include <cmath>
+#include <ctime>
+#include <memory>
 
 namespace {
 
@@ -128,6 +136,45 @@ struct PlayerInfo {
     uint32_t rom_crc32 = 0;
 };
 
+// ============================================================================
+// Per-Player Input by Session Frame
+// ============================================================================
+
+// Recent inputs of one player, indexed by session frame (frames since the
+// game started). A frame not received yet reads as the newest known input.
+struct InputRing {
+    static constexpr int SIZE = 128;
+
+    std::array<uint64_t, SIZE> frames;
+    std::array<uint32_t, SIZE> buttons = {};
+    uint32_t latest = 0;
+
+    InputRing() { clear(); }
+
+    void clear() {
+        frames.fill(UINT64_MAX);
+        latest = 0;
+    }
+
+    void set(uint64_t frame, uint32_t value) {
+        frames[frame % SIZE] = frame;
+        buttons[frame % SIZE] = value;
+        latest = value;
+    }
+
+    bool has(uint64_t frame) const { return frames[frame % SIZE] == frame; }
+
+    // Returns false when the input is a prediction
+    bool get(uint64_t frame, uint32_t& value) const {
+        if (has(frame)) {
+            value = buttons[frame % SIZE];
+            return true;
+        }
+        value = latest;
+        return false;
+    }
+};
+
 // ============================================================================
 // Default Netplay Plugin
 // ============================================================================
@@ -156,7 +203,7 @@ public:
             "Rollback netplay with lobby-first game selection",
             0,  // capabilities
             4,  // max players
-            4   // max spectators
+            emu::UdpTransport::MAX_SPECTATORS  // max spectators
         };
     }
 
@@ -184,6 +231,14 @@ public:
         }
 
         m_player_name = player_name ? player_name : "Player";
+        if (!m_transport.start_host(port, m_player_name.c_str())) {
+            m_host->show_notification(emu::NetplayNotificationType::Error,
+                m_transport.get_error().c_str(), 5.0f);
+            return false;
+        }
+
+        m_transport.set_spectator_limit(m_allow_spectators ? emu::UdpTransport::MAX_SPECTATORS : 0);
+
         m_port = port;
         m_role = emu::NetplayRole::Host;
         m_connection_state = emu::NetplayConnectionState::Connected;
@@ -225,48 +280,68 @@ public:
         }
 
         m_player_name = player_name ? player_name : "Player";
-        m_port = port;
         m_host_address = host_addr ? host_addr : "";
+        if (!m_transport.start_client(m_host_address.c_str(), port, m_player_name.c_str())) {
+            m_host->show_notification(emu::NetplayNotificationType::Error,
+                m_transport.get_error().c_str(), 5.0f);
+            return false;
+        }
+
+        m_port = port;
         m_role = emu::NetplayRole::Client;
         m_connection_state = emu::NetplayConnectionState::Connecting;
+        m_connect_started = std::chrono::steady_clock::now();
 
         // Initialize lobby state - waiting for host's game selection
         m_lobby_state = LobbyState::WaitingForGame;
         m_game_info = {};
-
-        // Simulate connection (in real impl, this would be async)
-        m_connection_state = emu::NetplayConnectionState::Connected;
-        m_local_player_id = 1;
-
-        // Simulate host player info
-        m_player_info[0] = {};
-        m_player_info[0].base = {0, {}, emu::NetplayRole::Host, 30, false, false};
-        std::strncpy(m_player_info[0].base.name, "Host", 63);
-        m_player_info[0].rom_status = RomStatus::NotLoaded;
-
-        // Initialize self (client)
-        m_player_info[1] = {};
-        m_player_info[1].base = {1, {}, emu::NetplayRole::Client, 0, true, false};
-        std::strncpy(m_player_info[1].base.name, m_player_name.c_str(), 63);
-        m_player_info[1].rom_status = RomStatus::NotLoaded;
-        m_player_count = 2;
+        m_player_count = 0;
 
         // Add to recent connections
         add_recent_connection(m_player_name, m_host_address, port);
 
-        add_system_message("Connected to session");
-        add_system_message("Waiting for host to select a game...");
+        add_system_message("Connecting to " + m_host_address + "...");
 
-        if (m_host) {
-            m_host->show_notification(emu::NetplayNotificationType::Info,
-                ("Connected to " + std::string(host_addr)).c_str(), 3.0f);
-            m_host->on_netplay_connected(m_local_player_id);
+        // The rest happens in on_welcomed() once the host answers
+        return true;
+    }
+
+    // Watch a session: no player slot, no input sent, and the game runs
+    // only on inputs the host has confirmed
+    bool join_as_spectator(const char* host_addr, uint16_t port, const char* name) override {
+        if (!m_host) {
+            return false;
         }
 
+        m_player_name = name ? name : "Player";
+        m_host_address = host_addr ? host_addr : "";
+        if (!m_transport.start_spectator(m_host_address.c_str(), port, m_player_name.c_str())) {
+            m_host->show_notification(emu::NetplayNotificationType::Error,
+                m_transport.get_error().c_str(), 5.0f);
+            return false;
+        }
+
+        m_port = port;
+        m_role = emu::NetplayRole::Spectator;
+        m_connection_state = emu::NetplayConnectionState::Connecting;
+        m_connect_started = std::chrono::steady_clock::now();
+        m_local_player_id = -1;
+
+        m_lobby_state = LobbyState::WaitingForGame;
+        m_game_info = {};
+        m_player_count = 0;
+
+        add_recent_connection(m_player_name, m_host_address, port);
+        add_system_message("Connecting to " + m_host_address + " as a spectator...");
         return true;
     }
 
+    int get_spectator_count() const override {
+        return m_role == emu::NetplayRole::Host ? m_transport.get_spectator_count() : 0;
+    }
+
     void disconnect() override {
+        m_transport.stop();
         if (m_connection_state != emu::NetplayConnectionState::Disconnected) {
             add_system_message("Disconnected from session");
             if (m_host) {
@@ -278,11 +353,20 @@ public:
         m_role = emu::NetplayRole::None;
         m_lobby_state = LobbyState::WaitingForPlayers;
         m_game_info = {};
+        m_local_player_id = 0;
         m_player_count = 0;
         m_is_ready = false;
         m_is_rolling_back = false;
         m_rollback_depth = 0;
         m_input_manager.clear_assignments();
+        for (InputRing& ring : m_inputs) ring.clear();
+        m_states.reset();
+        m_speculator.reset();
+        m_used_inputs.clear();
+        m_awaiting_state = false;
+        m_state_requested = false;
+        m_spectator_sync_due = false;
+        m_metrics.close_log();
     }
 
     emu::NetplayConnectionState get_connection_state() const override {
@@ -315,6 +399,7 @@ public:
 
         info.player_count = m_player_count;
         info.max_players = 4;
+        info.spectator_count = get_spectator_count();
         info.input_delay = m_input_delay;
         info.rollback_frames = m_rollback_window;
         return info;
@@ -335,6 +420,8 @@ public:
     }
 
     void set_ready(bool ready) override {
+        if (m_role == emu::NetplayRole::Spectator) return;
+
         // Can only ready up if we have the correct ROM loaded
         if (ready && m_game_info.selected) {
             if (m_player_info[m_local_player_id].rom_status != RomStatus::CrcMatch) {
@@ -353,6 +440,7 @@ public:
 
         // Check if all players are ready
         check_all_ready();
+        publish_lobby();
     }
 
     void send_chat_message(const char* message) override {
@@ -392,12 +480,11 @@ public:
                     ("Game selected: " + m_game_info.name).c_str(), 3.0f);
             }
 
-            // In a real implementation, broadcast game info to all clients here
-            // For now, simulate that clients receive the update
-            simulate_game_broadcast_to_clients();
+            // Clients learn the selection from the next lobby update
+            publish_lobby();
         } else {
             // Client loaded a ROM - check if it matches host's selection
-            if (m_game_info.selected) {
+            if (m_game_info.selected && m_local_player_id >= 0) {
                 uint32_t local_crc = m_host->get_rom_crc32();
                 if (local_crc == m_game_info.crc32) {
                     m_player_info[m_local_player_id].rom_status = RomStatus::CrcMatch;
@@ -427,25 +514,94 @@ public:
     bool begin_frame() override {
         if (!is_connected()) return true;
 
-        // Only run frames if we're in Playing state
-        if (m_lobby_state != LobbyState::Playing) {
+        poll_network();
+
+        // Only run frames if we're in Playing state, and a client only once
+        // it has loaded the host's starting state
+        if (m_lobby_state != LobbyState::Playing || m_awaiting_state) {
             return false;  // Don't advance frame during lobby
         }
+        if (m_role == emu::NetplayRole::Spectator) return begin_spectator_frame();
+
+        // Local input is sampled once per frame and applies input_delay
+        // frames later on every peer
+        uint64_t frame = m_host->get_frame_count();
+        update_time_sync(frame - m_frame_base);
+        send_input(m_local_player_id, m_host->get_local_input(0), frame);
+
+        // A remote input contradicted a prediction: rewind and replay up to
+        // the present before this frame runs
+        uint64_t session_frame = frame - m_frame_base;
+        if (m_rollback_from < session_frame) {
+            roll_back(session_frame);
+        }
+        m_rollback_from = UINT64_MAX;
 
+        // Run ahead of the remote inputs by at most the rollback window
+        // (zero without fast save states, which is plain delay-based sync).
+        // The wait is a skipped host tick, never a socket call.
+        int window = prediction_window();
+        if (session_frame >= static_cast<uint64_t>(window)) {
+            for (int i = 0; i < m_active_player_count; i++) {
+                if (!m_inputs[i].has(session_frame - window)) return false;
+            }
+        }
+
+        if (window > 0 && needs_state(session_frame)) save_state(session_frame);
+        if (m_state_requested) {
+            m_state_requested = false;
+            send_confirmed_state(session_frame);
+        }
+        if (m_role == emu::NetplayRole::Host) {
+            relay_confirmed(session_frame);
+            if (m_spectator_sync_due) send_spectator_state(session_frame);
+        }
+        record_used_inputs(session_frame);
+        if (m_speculator) speculate(session_frame);
+        if (emu::INetplayCapable* emulator = m_host->get_netplay_emulator()) {
+            m_hash_log.record(emulator, session_frame);
+            check_sync(session_frame);
+        }
+        m_metrics.end_frame(m_link, m_frame_advantage);
+        if (m_metrics.is_logging() && session_frame % STATS_LOG_INTERVAL == 0) {
+            m_metrics.log_row(session_frame, get_stats(), m_input_delay, m_rollback_window);
+        }
+        m_frames_run = session_frame + 1;
         return true;
     }
 
     void send_input(int player, uint32_t buttons, uint64_t frame) override {
-        if (player == m_local_player_id) {
-            m_input_manager.set_player_input(player, buttons);
+        if (player != m_local_player_id) return;
+
+        m_input_manager.set_player_input(player, buttons);
+        if (m_lobby_state != LobbyState::Playing) return;
+
+        // Bits the core ignores never reach the wire, so the local copy
+        // drops them too or it would differ from the peer's
+        buttons &= m_input_mask;
+
+        // A delay that just shrank lands on a frame already sent (that
+        // input is dropped); one that grew skips frames, which repeat it
+        uint64_t target = frame - m_frame_base + m_input_delay;
+        if (target < m_next_local_frame) return;
+        for (uint64_t f = m_next_local_frame; f <= target; f++) {
+            m_inputs[player].set(f, buttons);
+            m_transport.send_input(player, f, buttons);
         }
-        (void)frame;
+        m_next_local_frame = target + 1;
+        m_last_sent_buttons = buttons;
     }
 
     bool get_input(int player, uint32_t& buttons, uint64_t frame) override {
-        buttons = m_input_manager.get_player_input(player);
-        (void)frame;
-        return true;
+        if (player < 0 || player >= emu::NETPLAY_MAX_PLAYERS) {
+            buttons = 0;
+            return false;
+        }
+        if (m_lobby_state != LobbyState::Playing) {
+            buttons = m_input_manager.get_player_input(player);
+            return true;
+        }
+        return m_inputs[player].get(frame - m_frame_base, buttons);
     }
 
     void end_frame() override {
@@ -454,20 +610,27 @@ public:
         m_rollback_depth = 0;
     }
 
+    void on_rollback(RollbackCallback callback) override {
+        m_rollback_callback = std::move(callback);
+    }
+
+    void debug_force_rollback(int frames) override {
+        if (frames <= 0 || static_cast<uint64_t>(frames) > m_frames_run) return;
+        m_rollback_from = std::min(m_rollback_from, m_frames_run - frames);
+    }
+
     int get_active_player_count() const override {
         return m_active_player_count;
     }
 
-    void get_synchronized_inputs_fast(std::vector<uint32_t>& out_inputs, uint64_t frame) override {
-        if (static_cast<int>(out_inputs.size()) != m_active_player_count) {
-            out_inputs.resize(m_active_player_count, 0);
-        }
-
-        for (int i = 0; i < m_active_player_count; i++) {
-            uint32_t buttons = 0;
-            get_input(i, buttons, frame);
-            out_inputs[i] = buttons;
+    void get_synchronized_inputs_fast(emu::NetplayFrameInputs& out, uint64_t frame) override {
+        out.player_count = m_active_player_count;
+        out.buttons = {};
+        if (m_lobby_state != LobbyState::Playing) {
+            for (int i = 0; i < m_active_player_count; i++) out.buttons[i] = m_input_manager.get_player_input(i);
+            return;
         }
+        for (int i = 0; i < m_active_player_count; i++) m_inputs[i].get(frame - m_frame_base, out.buttons[i]);
     }
 
     void set_local_input(int player, uint32_t buttons) override {
@@ -482,14 +645,16 @@ public:
     }
 
     void request_state_sync() override {
+        if (!m_transport.is_running()) return;
+        m_transport.request_state();
         if (m_host) {
             m_host->show_notification(emu::NetplayNotificationType::Info, "Requesting state sync...");
         }
     }
 
+    // frame is a session frame; the transport sends a delta when it can
     void send_state(const std::vector<uint8_t>& state, uint64_t frame) override {
-        (void)state;
-        (void)frame;
+        m_transport.send_state(state, frame);
     }
 
     void set_input_delay(int frames) override {
@@ -503,11 +668,21 @@ public:
     }
 
     int get_rollback_window() const override { return m_rollback_window; }
+    float get_frame_advantage() const override { return m_frame_advantage; }
+    double get_frame_time_scale() const override { return m_frame_time_scale; }
     int get_current_rollback_depth() const override { return m_rollback_depth; }
     bool is_rolling_back() const override { return m_is_rolling_back; }
 
     emu::NetplayStats get_stats() const override {
         emu::NetplayStats stats = {};
+        m_transport.fill_stats(stats);
+        stats.rollback_count = m_rollback_count;
+        stats.max_rollback_frames = m_max_rollback_frames;
+        stats.frame_advantage = m_frame_advantage;
+        emu::LinkQuality link = m_transport.get_link_quality();
+        stats.jitter_ms = link.jitter_ms;
+        stats.packet_loss = link.loss;
+        m_metrics.fill_stats(stats);
         for (int i = 0; i < m_player_count; i++) {
             if (!m_player_info[i].base.is_local) {
                 stats.local_ping_ms = m_player_info[i].base.ping_ms;
@@ -576,6 +751,8 @@ public:
     }
 
     void render_gui() override {
+        poll_network();
+
         // Check if ROM was loaded since last frame
         check_rom_status_change();
 
@@ -660,20 +837,6 @@ private:
         }
     }
 
-    void simulate_game_broadcast_to_clients() {
-        // In a real implementation, this would send game info over network
-        // For simulation, just update other players' view of the game info
-
-        // Simulate that clients now see the game selection
-        for (int i = 0; i < m_player_count; i++) {
-            if (!m_player_info[i].base.is_local) {
-                // Simulate client receiving game info and loading ROM
-                // In reality this would happen when they load their copy
-                m_player_info[i].rom_status = RomStatus::NotLoaded;
-            }
-        }
-    }
-
     void check_all_ready() {
         if (!is_connected() || !m_game_info.selected) return;
 
@@ -705,18 +868,923 @@ private:
             return;
         }
 
+        for (InputRing& ring : m_inputs) ring.clear();
+        begin_playing();
+        send_current_state();
+        m_spectator_sync_due = m_transport.get_spectator_count() > 0;
+        publish_lobby();
+
+        add_system_message("Game started!");
+
+        if (m_host) {
+            m_host->show_notification(emu::NetplayNotificationType::Success,
+                "Netplay game started!", 3.0f);
+            m_host->resume_emulator();
+        }
+    }
+
+    // Enter gameplay: session frames count from the current core frame, and
+    // the first input_delay frames have no input on any peer
+    void begin_playing() {
         m_lobby_state = LobbyState::Playing;
         m_connection_state = emu::NetplayConnectionState::Playing;
 
         // Setup input manager for gameplay
         setup_input_manager_for_session();
 
-        add_system_message("Game started!");
+        m_frame_base = m_host ? m_host->get_frame_count() : 0;
+        m_next_local_frame = static_cast<uint64_t>(m_input_delay);
+        m_last_sent_buttons = 0;
+
+        // Inputs go on the wire at the width the core reads
+        emu::INetplayCapable* emulator = m_host ? m_host->get_netplay_emulator() : nullptr;
+        int input_bits = emulator ? std::clamp(emulator->get_input_bits(), 1, 32) : 32;
+        m_input_mask = input_bits >= 32 ? UINT32_MAX : (1u << input_bits) - 1;
+        m_transport.set_input_bits(input_bits);
+
+        // Remote inputs that arrived before we got here are kept
+        for (InputRing& ring : m_inputs) {
+            for (int frame = 0; frame < m_input_delay; frame++) {
+                if (!ring.has(static_cast<uint64_t>(frame))) ring.set(static_cast<uint64_t>(frame), 0);
+            }
+        }
+
+        m_frames_run = 0;
+        m_frame_advantage = 0.0f;
+        m_frame_time_scale = 1.0;
+        m_rollback_from = UINT64_MAX;
+        m_rollback_count = 0;
+        m_max_rollback_frames = 0;
+        m_used_inputs.clear();
+        m_used_inputs.set_player_count(m_active_player_count);
+        m_next_relayed = 0;
+        reset_sync_checks(0);
+        m_metrics.reset();
+        if (m_log_stats && !m_metrics.is_logging()) open_stats_log();
+
+        // One state per frame in the largest window, plus the frame that
+        // is about to run. Spectators never predict, so never roll back.
+        m_states.reset();
+        if (emulator && m_role != emu::NetplayRole::Spectator) {
+            m_states = std::make_unique<emu::RollbackStateBuffer>(
+                emulator->get_max_state_size(), emu::NETPLAY_MAX_ROLLBACK_FRAMES + 1);
+        }
+
+        // Spare cores run the likeliest alternatives to each prediction
+        m_speculator.reset();
+        m_speculated_frames = 0;
+        if (m_states && m_speculation_workers > 0) {
+            auto speculator = std::make_unique<emu::Speculator>();
+            if (speculator->start(m_host, m_speculation_workers, emulator->get_max_state_size(),
+                                  emu::NETPLAY_MAX_ROLLBACK_FRAMES + 1)) {
+                m_speculator = std::move(speculator);
+            }
+        }
+    }
+
+    // =========================================================================
+    // Rollback
+    // =========================================================================
+
+    int prediction_window() const {
+        return m_states ? std::clamp(m_rollback_window, 0, emu::NETPLAY_MAX_ROLLBACK_FRAMES) : 0;
+    }
+
+    // Only a frame run on a predicted input can be rolled back to, so one
+    // every player's input is already in for is never restored. On a LAN
+    // that is nearly every frame, which then runs without a save. Resync
+    // requests for such a frame save it on the spot (send_current_state);
+    // sync check frames are kept while desync dumps are on.
+    bool needs_state(uint64_t session_frame) const {
+        if (m_dump_desync_states && session_frame % SYNC_CHECK_INTERVAL == 0) return true;
+        for (int i = 0; i < m_active_player_count; i++) {
+            if (!m_inputs[i].has(session_frame)) return true;
+        }
+        return false;
+    }
+
+    // Snapshot the core at the start of a session frame
+    void save_state(uint64_t session_frame) {
+        auto started = std::chrono::steady_clock::now();
+        emu::INetplayCapable* emulator = m_host->get_netplay_emulator();
+        uint8_t* buffer = m_states->get_write_buffer(session_frame);
+        m_states->commit_write(emulator->save_state_fast(buffer, m_states->get_max_state_size()));
+        m_metrics.record_save(std::chrono::steady_clock::now() - started);
+    }
+
+    // Remember what each player's input was when a frame ran, so a late
+    // input can be checked against the prediction that was used
+    void record_used_inputs(uint64_t session_frame) {
+        uint8_t confirmed = 0;
+        m_frame_inputs.player_count = m_active_player_count;
+        m_frame_inputs.buttons = {};
+        for (int i = 0; i < m_active_player_count; i++) {
+            if (m_inputs[i].get(session_frame, m_frame_inputs.buttons[i])) confirmed |= static_cast<uint8_t>(1u << i);
+        }
+        m_used_inputs.add_input_n(session_frame, m_frame_inputs, confirmed);
+    }
+
+    // Called as remote inputs arrive
+    void check_prediction(const emu::NetplayInputFrame& input) {
+        if (input.frame >= m_frames_run) return;  // Not run yet
+
+        emu::InputHistory::FrameInput used;
+        if (!m_used_inputs.get_input(input.frame, used)) return;
+        if (used.is_confirmed(input.player_id)) return;
+
+        if (used.player_inputs[input.player_id] != input.buttons) {
+            m_rollback_from = std::min(m_rollback_from, input.frame);
+        }
+        m_used_inputs.confirm_input(input.frame, input.player_id, input.buttons);
+    }
+
+    // Restore the state saved at m_rollback_from and re-run every frame up
+    // to (not including) current_frame with the inputs now known, all
+    // within this host tick. Frames a speculation branch already ran with
+    // those inputs are taken from it instead.
+    void roll_back(uint64_t current_frame) {
+        auto started = std::chrono::steady_clock::now();
+        uint64_t from = m_rollback_from;
+        emu::INetplayCapable* emulator = m_states ? m_host->get_netplay_emulator() : nullptr;
+
+        size_t size = 0;
+        const uint8_t* state = m_states ? m_states->find_state(from, size) : nullptr;
+        if (!emulator || !state) {
+            // Only possible if the window shrank mid-session
+            std::cerr << "NetplayPlugin: No state for frame " << from << ", cannot roll back" << std::endl;
+            return;
+        }
+
+        uint64_t resume = from;
+        if (m_speculator) {
+            resume = adopt_speculation(from, current_frame);
+            state = m_states->find_state(resume, size);
+            m_speculator->invalidate_after(from);
+        }
+        auto load_started = std::chrono::steady_clock::now();
+        if (!emulator->load_state_fast(state, size)) {
+            std::cerr << "NetplayPlugin: Could not load state for frame " << resume << std::endl;
+            return;
+        }
+        auto resim_started = std::chrono::steady_clock::now();
+        m_metrics.record_load(resim_started - load_started);
+        m_states->discard_after(resume);
+
+        int depth = static_cast<int>(current_frame - from);
+        m_is_rolling_back = true;
+        m_rollback_depth = depth;
+        for (uint64_t frame = from; frame < current_frame; frame++) {
+            if (frame > resume && needs_state(frame)) save_state(frame);
+            record_used_inputs(frame);
+            if (frame < resume) continue;
+            m_hash_log.record(emulator, frame);
+            m_host->resimulate_frame(m_frame_inputs);
+        }
+        m_is_rolling_back = false;
+        m_metrics.record_rollback(depth, static_cast<int>(current_frame - resume),
+                                  std::chrono::steady_clock::now() - resim_started);
+
+        m_rollback_count++;
+        m_max_rollback_frames = std::max(m_max_rollback_frames, depth);
+
+        if (m_rollback_callback) {
+            emu::RollbackEvent event = {};
+            event.confirmed_frame = from > 0 ? from - 1 : 0;
+            event.rollback_frame = from;
+            event.frames_resimulated = static_cast<int>(current_frame - resume);
+            event.resimulation_ms = std::chrono::duration<float, std::milli>(
+                std::chrono::steady_clock::now() - started).count();
+            m_rollback_callback(event);
+        }
+    }
+
+    // =========================================================================
+    // Speculation
+    // =========================================================================
+
+    // Give each idle worker the frames from the oldest one still run on a
+    // predicted input, with that player holding one of their most frequent
+    // recent inputs (other than the prediction) instead
+    void speculate(uint64_t session_frame) {
+        int window = prediction_window();
+        uint64_t first = session_frame >= static_cast<uint64_t>(window) ? session_frame - window : 0;
+        uint64_t base = 0;
+        int player = -1;
+        for (uint64_t frame = first; frame <= session_frame && player < 0; frame++) {
+            for (int i = 0; i < m_active_player_count; i++) {
+                if (!m_inputs[i].has(frame)) {
+                    base = frame;
+                    player = i;
+                    break;
+                }
+            }
+        }
+        if (player < 0) return;
+
+        size_t size = 0;
+        const uint8_t* state = m_states->find_state(base, size);
+        if (!state) return;
+
+        // Count distinct confirmed inputs, most frequent first
+        const InputRing& ring = m_inputs[player];
+        m_speculation_candidates.clear();
+        uint64_t oldest = base > SPECULATION_HISTORY ? base - SPECULATION_HISTORY : 0;
+        for (uint64_t frame = oldest; frame < base; frame++) {
+            uint32_t buttons = 0;
+            if (!ring.get(frame, buttons) || buttons == ring.latest) continue;
+            auto it = std::find_if(m_speculation_candidates.begin(), m_speculation_candidates.end(),
+                [buttons](const std::pair<uint32_t, int>& c) { return c.first == buttons; });
+            if (it != m_speculation_candidates.end()) {
+                it->second++;
+            } else {
+                m_speculation_candidates.emplace_back(buttons, 1);
+            }
+        }
+        std::stable_sort(m_speculation_candidates.begin(), m_speculation_candidates.end(),
+            [](const std::pair<uint32_t, int>& a, const std::pair<uint32_t, int>& b) { return a.second > b.second; });
+
+        size_t next = 0;
+        for (int w = 0; w < m_speculator->get_worker_count() && next < m_speculation_candidates.size(); w++) {
+            if (!m_speculator->is_idle(w)) continue;
+
+            uint32_t candidate = m_speculation_candidates[next++].first;
+            m_speculation_inputs.resize(static_cast<size_t>(session_frame - base + 1));
+            for (size_t k = 0; k < m_speculation_inputs.size(); k++) {
+                emu::NetplayFrameInputs& inputs = m_speculation_inputs[k];
+                inputs.player_count = m_active_player_count;
+                inputs.buttons = {};
+                for (int i = 0; i < m_active_player_count; i++) {
+                    if (!m_inputs[i].get(base + k, inputs.buttons[i]) && i == player) inputs.buttons[i] = candidate;
+                }
+            }
+            m_speculator->submit(w, state, size, base, m_speculation_inputs);
+        }
+    }
+
+    // Copy the states of the branch that gets furthest past `from` with the
+    // inputs now known into the rollback buffer. Returns the frame to
+    // resimulate from.
+    uint64_t adopt_speculation(uint64_t from, uint64_t current_frame) {
+        int worker = -1;
+        uint64_t resume = m_speculator->find_branch(from, current_frame,
+            [this](uint64_t frame, const emu::NetplayFrameInputs& inputs) {
+                if (inputs.player_count != m_active_player_count) return false;
+                for (int i = 0; i < m_active_player_count; i++) {
+                    uint32_t buttons = 0;
+                    m_inputs[i].get(frame, buttons);
+                    if (buttons != inputs.buttons[i]) return false;
+                }
+                return true;
+            }, worker);
+
+        for (uint64_t frame = from + 1; frame <= resume; frame++) {
+            size_t size = 0;
+            const uint8_t* state = m_speculator->get_state(worker, frame, size);
+            std::memcpy(m_states->get_write_buffer(frame), state, size);
+            m_states->commit_write(size);
+
+            const emu::StateHashComponent* components = nullptr;
+            int count = 0;
+            uint64_t hash = m_speculator->get_state_hash(worker, frame, components, count);
+            m_hash_log.record(frame, hash, components, count);
+        }
+        m_speculated_frames += resume - from;
+        return resume;
+    }
+
+    // =========================================================================
+    // Desync Detection
+    // =========================================================================
+
+    // Checks restart from a state both peers share
+    void reset_sync_checks(uint64_t frame) {
+        m_hash_log.clear();
+        m_next_sync_check = (frame / SYNC_CHECK_INTERVAL + 1) * SYNC_CHECK_INTERVAL;
+        m_last_synced_frame = frame;
+        m_remote_sync_hashes.clear();
+        m_sync_states.clear();
+        m_desync_searching = false;
+        m_desync_reported = false;
+        m_desync_first = {};
+    }
+
+    // Every SYNC_CHECK_INTERVAL frames, once the state at the start of the
+    // frame is final (every input before it confirmed), send its hash to the
+    // peer, and compare the peer's hashes with ours once both are in
+    void check_sync(uint64_t session_frame) {
+        while (m_next_sync_check <= session_frame &&
+               m_used_inputs.is_frame_fully_confirmed(m_next_sync_check - 1)) {
+            uint64_t frame = m_next_sync_check;
+            m_next_sync_check += SYNC_CHECK_INTERVAL;
+
+            emu::SyncCheck check;
+            if (!m_hash_log.get_hash(frame, check.values[0])) continue;
+            check.type = emu::SyncCheck::Type::Hash;
+            check.frame = frame;
+            m_transport.send_sync_check(check);
+            if (m_dump_desync_states) keep_sync_state(frame, session_frame);
+        }
+
+        while (!m_remote_sync_hashes.empty() && m_remote_sync_hashes.front().first < m_next_sync_check) {
+            auto [frame, remote_hash] = m_remote_sync_hashes.front();
+            m_remote_sync_hashes.pop_front();
+
+            uint64_t local_hash = 0;
+            if (m_desync_searching || m_desync_reported || !m_hash_log.get_hash(frame, local_hash)) continue;
+            if (local_hash == remote_hash) {
+                m_last_synced_frame = frame;
+            } else {
+                m_desync_searching = true;
+                m_desync_check_frame = frame;
+                m_desync_first = {};
+                m_desync_first.frame = frame;
+                m_desync_first.local_hash = local_hash;
+                m_desync_first.remote_hash = remote_hash;
+                request_hash_log(frame + 1);
+            }
+        }
+
+        // Requests and replies are single datagrams; ask again if lost
+        if (m_desync_searching && session_frame > m_desync_request_sent + SYNC_LOG_RETRY_FRAMES) {
+            if (++m_desync_request_attempts > SYNC_LOG_MAX_ATTEMPTS) {
+                report_desync();
+            } else {
+                send_hash_log_request();
+            }
+        }
+    }
+
+    // Ask for the peer's log of the frames before `end`, back to the last
+    // frame known to match
+    void request_hash_log(uint64_t end) {
+        uint64_t first = std::max(m_last_synced_frame + 1,
+                                  end > emu::SyncCheck::MAX_FRAMES ? end - emu::SyncCheck::MAX_FRAMES : 0);
+        m_desync_request_first = first;
+        m_desync_request_count = static_cast<int>(end - first);
+        m_desync_request_attempts = 0;
+        send_hash_log_request();
+    }
+
+    void send_hash_log_request() {
+        emu::SyncCheck check;
+        check.type = emu::SyncCheck::Type::LogRequest;
+        check.frame = m_desync_request_first;
+        check.count = m_desync_request_count;
+        m_transport.send_sync_check(check);
+        m_desync_request_sent = m_frames_run;
+    }
+
+    void on_sync_check(const emu::SyncCheck& check) {
+        switch (check.type) {
+            case emu::SyncCheck::Type::Hash:
+                if (m_remote_sync_hashes.size() < MAX_PENDING_SYNC_HASHES) {
+                    m_remote_sync_hashes.emplace_back(check.frame, check.values[0]);
+                }
+                break;
+
+            case emu::SyncCheck::Type::LogRequest: {
+                emu::SyncCheck reply;
+                m_hash_log.fill_log(check.frame, check.count, reply);
+                m_transport.send_sync_check(reply);
+                break;
+            }
+
+            case emu::SyncCheck::Type::Log:
+                on_hash_log(check);
+                break;
+        }
+    }
+
+    // The peer's log for the window requested. The first frame that
+    // differs is only pinned down once a matching frame precedes it;
+    // otherwise walk back a window, as far as both logs reach.
+    void on_hash_log(const emu::SyncCheck& log) {
+        if (!m_desync_searching || log.frame != m_desync_request_first) return;
+
+        emu::StateHashLog::Divergence found = m_hash_log.compare(log);
+        if (found.found) {
+            m_desync_first = found;
+            bool more = log.frame > m_last_synced_frame + 1 &&
+                        m_frames_run - log.frame + SYNC_CHECK_INTERVAL < emu::StateHashLog::CAPACITY;
+            if (!found.pinned && more) {
+                request_hash_log(log.frame);
+                return;
+            }
+        } else {
+            // Everything both logs hold here matched, so the divergence
+            // found in the later window is the first
+            m_desync_first.pinned = found.pinned;
+        }
+        report_desync();
+    }
+
+    void report_desync() {
+        const emu::StateHashLog::Divergence& first = m_desync_first;
+        m_desync_searching = false;
+        m_desync_reported = true;
+
+        std::string message = "Desync at frame " + std::to_string(first.frame);
+        if (!first.pinned) message = "Desync at or before frame " + std::to_string(first.frame);
+        std::string parts;
+        for (int c = 0; c < m_hash_log.get_component_count(); c++) {
+            if (first.components & (1u << c)) {
+                if (!parts.empty()) parts += ", ";
+                parts += m_hash_log.get_component_name(c);
+            }
+        }
+        if (!parts.empty()) message += " (" + parts + ")";
+        add_system_message(message);
+
+        if (m_dump_desync_states) dump_desync(first);
+
+        int remote_player = m_local_player_id == 0 ? 1 : 0;
+        emu::DesyncInfo info = {};
+        info.frame = first.frame;
+        info.local_checksum = static_cast<uint32_t>(first.local_hash);
+        info.remote_checksum = static_cast<uint32_t>(first.remote_hash);
+        info.player_id = remote_player;
+        m_host->on_netplay_desync(info);
+        m_host->show_notification(emu::NetplayNotificationType::Warning, message.c_str(), 5.0f);
+    }
+
+    // Keep a copy of the state at each checked frame, for dumping if the
+    // check turns out to fail
+    void keep_sync_state(uint64_t frame, uint64_t session_frame) {
+        std::vector<uint8_t> state;
+        if (m_sync_states.size() >= MAX_KEPT_SYNC_STATES) {
+            state.swap(m_sync_states.front().second);
+            m_sync_states.pop_front();
+        }
+
+        size_t size = 0;
+        const uint8_t* saved = m_states ? m_states->find_state(frame, size) : nullptr;
+        if (saved) {
+            state.assign(saved, saved + size);
+        } else if (frame != session_frame || !m_host->save_state_to_buffer(state)) {
+            return;
+        }
+        m_sync_states.emplace_back(frame, std::move(state));
+    }
+
+    // Write our state at the failed check and our hash log around the
+    // divergence. The peer writes its own, so the pairs can be compared.
+    void dump_desync(const emu::StateHashLog::Divergence& first) {
+        std::filesystem::path dir = std::filesystem::path(m_host->get_config_directory()) / "netplay_desync";
+        std::string prefix = "frame" + std::to_string(m_desync_check_frame) + "_player" +
+                             std::to_string(m_local_player_id + 1);
+        try {
+            std::filesystem::create_directories(dir);
+
+            for (const auto& [frame, state] : m_sync_states) {
+                if (frame != m_desync_check_frame) continue;
+                std::ofstream file(dir / (prefix + ".state"), std::ios::binary);
+                file.write(reinterpret_cast<const char*>(state.data()), static_cast<std::streamsize>(state.size()));
+            }
+
+            std::ofstream log(dir / (prefix + ".txt"));
+            log << "First differing frame " << first.frame << (first.pinned ? "" : " (or earlier)") << "\n";
+            log << "frame hash";
+            for (int c = 0; c < m_hash_log.get_component_count(); c++) log << " " << m_hash_log.get_component_name(c);
+            log << "\n" << std::hex;
+            uint64_t from = first.frame > SYNC_CHECK_INTERVAL ? first.frame - SYNC_CHECK_INTERVAL : 0;
+            for (uint64_t frame = from; frame <= m_desync_check_frame; frame++) {
+                uint64_t hash = 0;
+                if (!m_hash_log.get_hash(frame, hash)) continue;
+                log << std::dec << frame << std::hex << " " << hash;
+                for (int c = 0; c < m_hash_log.get_component_count(); c++) {
+                    uint64_t part = 0;
+                    m_hash_log.get_component(frame, c, part);
+                    log << " " << part;
+                }
+                log << "\n";
+            }
+            add_system_message("Desync details written to " + (dir / prefix).string() + ".*");
+        }
+        catch (const std::exception& e) {
+            std::cerr << "NetplayPlugin: Could not write desync dump: " << e.what() << std::endl;
+        }
+    }
+
+    // =========================================================================
+    // Instrumentation
+    // =========================================================================
+
+    // One CSV per session, named for when it started
+    void open_stats_log() {
+        std::filesystem::path dir = std::filesystem::path(m_host->get_config_directory()) / "netplay_stats";
+        std::time_t now = std::time(nullptr);
+        char name[64];
+        std::strftime(name, sizeof(name), "session_%Y%m%d_%H%M%S.csv", std::localtime(&now));
+        try {
+            std::filesystem::create_directories(dir);
+            if (!m_metrics.open_log((dir / name).string())) {
+                std::cerr << "NetplayPlugin: Could not open stats log " << (dir / name).string() << std::endl;
+            }
+        }
+        catch (const std::exception& e) {
+            std::cerr << "NetplayPlugin: Could not open stats log: " << e.what() << std::endl;
+        }
+    }
+
+    // =========================================================================
+    // Spectators
+    // =========================================================================
+
+    // Host: hand frames every player's input is confirmed for to the
+    // transport, oldest first, for relaying to the spectators
+    void relay_confirmed(uint64_t session_frame) {
+        emu::InputHistory::FrameInput used;
+        while (m_next_relayed < session_frame && m_used_inputs.is_frame_fully_confirmed(m_next_relayed) &&
+               m_used_inputs.get_input(m_next_relayed, used)) {
+            if (!m_transport.broadcast_confirmed(m_next_relayed, used.player_inputs.data(), m_active_player_count)) {
+                break;
+            }
+            m_next_relayed++;
+        }
+    }
+
+    // Host: a starting state for the spectators, taken at the first frame
+    // not relayed yet so their inputs pick up exactly where it leaves off
+    void send_spectator_state(uint64_t session_frame) {
+        std::vector<uint8_t> state;
+        if (m_next_relayed == session_frame) {
+            if (!m_host->save_state_to_buffer(state)) return;
+        } else {
+            size_t size = 0;
+            const uint8_t* saved = m_states ? m_states->find_state(m_next_relayed, size) : nullptr;
+            if (!saved) return;  // Tried again next frame
+            state.assign(saved, saved + size);
+        }
+        m_spectator_sync_due = false;
+        m_transport.send_spectator_state(state, m_next_relayed);
+    }
+
+    // Spectator: a frame runs once the host's confirmed inputs for it are
+    // here. Playback runs a little fast or slow to keep about a batch
+    // buffered, so the bursts the host sends in don't show as stutter, and
+    // clearly faster when it has fallen well behind.
+    bool begin_spectator_frame() {
+        uint64_t session_frame = m_host->get_frame_count() - m_frame_base;
+
+        // Every player's inputs come from the host, however many there are
+        m_active_player_count = m_transport.get_relayed_player_count();
+        if (m_active_player_count == 0) return false;
+        m_transport.set_local_frame(session_frame);
+
+        int buffered = 0;
+        while (buffered < SPECTATOR_BUFFER_LIMIT && have_all_inputs(session_frame + buffered)) buffered++;
+
+        if (buffered == SPECTATOR_BUFFER_LIMIT) {
+            m_frame_time_scale = SPECTATOR_CATCH_UP_SCALE;
+        } else if (buffered > 2 * emu::UdpTransport::SPECTATOR_BATCH) {
+            m_frame_time_scale = 1.0 - MAX_FRAME_TIME_ADJUST;
+        } else if (buffered < emu::UdpTransport::SPECTATOR_BATCH) {
+            m_frame_time_scale = 1.0 + MAX_FRAME_TIME_ADJUST;
+        } else {
+            m_frame_time_scale = 1.0;
+        }
+
+        if (buffered == 0) return false;
+        m_frames_run = session_frame + 1;
+        return true;
+    }
+
+    bool have_all_inputs(uint64_t session_frame) const {
+        for (int i = 0; i < m_active_player_count; i++) {
+            if (!m_inputs[i].has(session_frame)) return false;
+        }
+        return true;
+    }
+
+    // =========================================================================
+    // Network
+    // =========================================================================
+
+    void publish_lobby() {
+        emu::LobbySnapshot lobby;
+        lobby.ready = m_is_ready;
+        lobby.started = m_lobby_state == LobbyState::Playing;
+        if (m_local_player_id >= 0 && m_local_player_id < 4) {
+            lobby.rom_crc32 = m_player_info[m_local_player_id].rom_crc32;
+        }
+        if (m_role == emu::NetplayRole::Host && m_game_info.selected) {
+            lobby.game_selected = true;
+            lobby.game_crc32 = m_game_info.crc32;
+            std::strncpy(lobby.game_name, m_game_info.name.c_str(), sizeof(lobby.game_name) - 1);
+            std::strncpy(lobby.platform, m_game_info.platform.c_str(), sizeof(lobby.platform) - 1);
+        }
+        m_transport.set_local_lobby(lobby);
+    }
+
+    // Drain everything the network thread has received. Never blocks.
+    void poll_network() {
+        if (!m_transport.is_running()) return;
+
+        emu::TransportEvent event;
+        while (m_transport.poll_event(event)) {
+            switch (event.type) {
+                case emu::TransportEvent::Type::PeerJoined: on_peer_joined(event); break;
+                case emu::TransportEvent::Type::Welcomed: on_welcomed(event); break;
+                case emu::TransportEvent::Type::PeerLeft: on_peer_left(); break;
+                case emu::TransportEvent::Type::StateRequested: m_state_requested = true; break;
+                case emu::TransportEvent::Type::SpectatorJoined:
+                    add_system_message(std::string(event.name) + " is watching");
+                    m_spectator_sync_due = true;
+                    break;
+                case emu::TransportEvent::Type::SpectatorLeft:
+                    add_system_message(std::string(event.name) + " stopped watching");
+                    break;
+                case emu::TransportEvent::Type::SpectatorStateNeeded: m_spectator_sync_due = true; break;
+            }
+            if (!m_transport.is_running()) return;
+        }
+
+        emu::LobbySnapshot lobby;
+        if (m_transport.poll_remote_lobby(lobby)) {
+            on_remote_lobby(lobby);
+        }
+
+        // A state can beat the lobby update that starts the game; it waits
+        // in the transport until then
+        std::vector<uint8_t> state;
+        uint64_t state_frame = 0;
+        if (m_lobby_state == LobbyState::Playing && m_transport.poll_state(state, state_frame)) {
+            on_state_received(state, state_frame);
+        }
+
+        emu::NetplayInputFrame input;
+        while (m_transport.poll_input(input)) {
+            if (input.player_id != m_local_player_id) {
+                m_inputs[input.player_id].set(input.frame, input.buttons);
+                if (m_lobby_state == LobbyState::Playing) check_prediction(input);
+            }
+        }
+
+        emu::SyncCheck check;
+        while (m_transport.poll_sync_check(check)) {
+            if (m_lobby_state == LobbyState::Playing) on_sync_check(check);
+        }
+
+        if (m_connection_state == emu::NetplayConnectionState::Connecting &&
+            std::chrono::steady_clock::now() - m_connect_started > std::chrono::seconds(10)) {
+            if (m_host) {
+                m_host->show_notification(emu::NetplayNotificationType::Error,
+                    ("No answer from " + m_host_address).c_str(), 5.0f);
+            }
+            disconnect();
+        }
+    }
+
+    // Host: a client said hello
+    void on_peer_joined(const emu::TransportEvent& event) {
+        int id = event.player_id;
+        m_player_info[id] = {};
+        m_player_info[id].base = {id, {}, emu::NetplayRole::Client, 0, false, false};
+        std::strncpy(m_player_info[id].base.name, event.name, 63);
+        m_player_info[id].rom_status = RomStatus::NotLoaded;
+        m_player_count = std::max(m_player_count, id + 1);
+
+        if (m_lobby_state == LobbyState::WaitingForPlayers) {
+            m_lobby_state = m_game_info.selected ? LobbyState::GameSelected : LobbyState::WaitingForGame;
+        }
+
+        add_system_message(std::string(event.name) + " joined");
+        publish_lobby();
+        if (m_host) {
+            m_host->on_netplay_player_joined(m_player_info[id].base);
+        }
+    }
+
+    // Client: the host accepted us
+    void on_welcomed(const emu::TransportEvent& event) {
+        m_connection_state = emu::NetplayConnectionState::Connected;
+        m_local_player_id = event.player_id;
+
+        m_player_info[0] = {};
+        m_player_info[0].base = {0, {}, emu::NetplayRole::Host, 0, false, false};
+        std::strncpy(m_player_info[0].base.name, event.name, 63);
+        m_player_info[0].rom_status = RomStatus::NotLoaded;
+
+        if (m_role == emu::NetplayRole::Spectator) {
+            m_player_count = 1;
+            add_system_message("Watching " + std::string(event.name) + "'s session");
+            add_system_message("Load the host's game to follow along.");
+            if (m_host) {
+                m_host->show_notification(emu::NetplayNotificationType::Info,
+                    ("Spectating " + m_host_address).c_str(), 3.0f);
+                m_host->on_netplay_connected(m_local_player_id);
+            }
+            return;
+        }
+
+        m_player_info[m_local_player_id] = {};
+        m_player_info[m_local_player_id].base =
+            {m_local_player_id, {}, emu::NetplayRole::Client, 0, true, false};
+        std::strncpy(m_player_info[m_local_player_id].base.name, m_player_name.c_str(), 63);
+        m_player_count = m_local_player_id + 1;
+        update_local_rom_status();
+
+        add_system_message("Connected to session");
+        add_system_message("Waiting for host to select a game...");
+        publish_lobby();
 
         if (m_host) {
+            m_host->show_notification(emu::NetplayNotificationType::Info,
+                ("Connected to " + m_host_address).c_str(), 3.0f);
+            m_host->on_netplay_connected(m_local_player_id);
+        }
+    }
+
+    void on_peer_left() {
+        if (m_role != emu::NetplayRole::Host) {
+            add_system_message("Host closed the session");
+            disconnect();
+            return;
+        }
+
+        add_system_message(std::string(m_player_info[1].base.name) + " left");
+        m_player_count = 1;
+        m_player_info[1] = {};
+        m_lobby_state = m_game_info.selected ? LobbyState::GameSelected : LobbyState::WaitingForPlayers;
+        m_connection_state = emu::NetplayConnectionState::Connected;
+        if (m_host) {
+            m_host->on_netplay_player_left(1, "Disconnected");
+        }
+    }
+
+    void on_remote_lobby(const emu::LobbySnapshot& lobby) {
+        if (m_role == emu::NetplayRole::Host) {
+            // Client's ready flag and ROM
+            PlayerInfo& client = m_player_info[1];
+            client.base.is_ready = lobby.ready;
+            client.rom_crc32 = lobby.rom_crc32;
+            if (lobby.rom_crc32 == 0) {
+                client.rom_status = RomStatus::NotLoaded;
+            } else if (!m_game_info.selected) {
+                client.rom_status = RomStatus::Loaded;
+            } else {
+                client.rom_status = lobby.rom_crc32 == m_game_info.crc32 ? RomStatus::CrcMatch
+                                                                       : RomStatus::CrcMismatch;
+            }
+            if (m_lobby_state != LobbyState::Playing) check_all_ready();
+            return;
+        }
+
+        // Host's game selection, ready flag and start
+        m_player_info[0].base.is_ready = lobby.ready;
+        m_player_info[0].rom_crc32 = lobby.rom_crc32;
+        m_player_info[0].rom_status = lobby.rom_crc32 ? RomStatus::CrcMatch : RomStatus::NotLoaded;
+
+        if (lobby.game_selected && (!m_game_info.selected || lobby.game_crc32 != m_game_info.crc32)) {
+            m_game_info.name = lobby.game_name;
+            m_game_info.platform = lobby.platform;
+            m_game_info.crc32 = lobby.game_crc32;
+            m_game_info.selected = true;
+            m_lobby_state = LobbyState::GameSelected;
+
+            add_system_message("Host selected: " + m_game_info.name);
+            add_system_message("CRC32: " + crc32_to_string(m_game_info.crc32));
+            update_local_rom_status();
+            publish_lobby();
+        }
+
+        if (lobby.started && m_lobby_state != LobbyState::Playing) {
+            // Frames start once the host's starting state has loaded
+            begin_playing();
+            m_awaiting_state = true;
+            m_connection_state = emu::NetplayConnectionState::Synchronizing;
+            add_system_message("Game started - receiving state from host...");
+        } else if (m_lobby_state != LobbyState::Playing) {
+            check_all_ready();
+        }
+    }
+
+    // =========================================================================
+    // Time Sync
+    // =========================================================================
+
+    // Called once per host tick while playing. Estimates how many frames we
+    // are ahead of the peer and nudges the host's frame time so the leader
+    // slows down and the follower speeds up, rather than either one stalling.
+    // With auto delay on, also retunes the input delay to the link.
+    void update_time_sync(uint64_t session_frame) {
+        m_transport.set_local_frame(session_frame);
+        emu::LinkQuality link = m_transport.get_link_quality();
+        m_link = link;
+        if (!link.valid) return;
+
+        // The peer's last reported frame, advanced by the time since it
+        // was sent (half a round trip plus the time since it arrived)
+        double fps = m_host->get_fps() > 1.0 ? m_host->get_fps() : 60.0;
+        double frame_ms = 1000.0 / fps;
+        double age_ms = link.rtt_ms / 2.0 + std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - link.remote_frame_time).count();
+        double remote_now = static_cast<double>(link.remote_frame) + age_ms / frame_ms;
+        float advantage = static_cast<float>(static_cast<double>(session_frame) - remote_now);
+        m_frame_advantage += (advantage - m_frame_advantage) * ADVANTAGE_SMOOTHING;
+
+        if (std::abs(m_frame_advantage) < TIME_SYNC_DEADBAND) {
+            m_frame_time_scale = 1.0;
+        } else {
+            m_frame_time_scale = 1.0 + std::clamp(static_cast<double>(m_frame_advantage) * TIME_SYNC_GAIN,
+                                                  -MAX_FRAME_TIME_ADJUST, MAX_FRAME_TIME_ADJUST);
+        }
+
+        for (int i = 0; i < m_player_count; i++) {
+            if (!m_player_info[i].base.is_local) m_player_info[i].base.ping_ms = static_cast<int>(link.rtt_ms);
+        }
+
+        // A remote input is on time if it arrives within input_delay frames
+        // of being sampled: cover the one-way trip plus twice the jitter.
+        // Moves one frame per second at most so a spike doesn't yank it.
+        if (m_auto_input_delay && session_frame >= m_next_delay_update) {
+            m_next_delay_update = session_frame + static_cast<uint64_t>(fps);
+            double needed_ms = link.rtt_ms / 2.0 + 2.0 * link.jitter_ms;
+            int wanted = std::clamp(static_cast<int>(std::ceil(needed_ms / frame_ms)),
+                                    0, emu::NETPLAY_MAX_INPUT_DELAY);
+            if (wanted > m_input_delay) m_input_delay++;
+            else if (wanted < m_input_delay) m_input_delay--;
+        }
+    }
+
+    // Ship the current state, stamped with the session frame about to run
+    void send_current_state() {
+        if (!m_host || m_lobby_state != LobbyState::Playing) return;
+        std::vector<uint8_t> state;
+        if (!m_host->save_state_to_buffer(state)) {
+            m_host->show_notification(emu::NetplayNotificationType::Error, "Could not save state for sync");
+            return;
+        }
+        send_state(state, m_host->get_frame_count() - m_frame_base);
+    }
+
+    // Answer a resync request from begin_frame, once any rollback is done.
+    // Frames run on predicted input may still change, so send the saved
+    // state from before the oldest of them.
+    void send_confirmed_state(uint64_t session_frame) {
+        uint64_t confirmed = session_frame;
+        int window = prediction_window();
+        uint64_t oldest = session_frame > static_cast<uint64_t>(window) ? session_frame - window : 0;
+        for (int i = 0; i < m_active_player_count; i++) {
+            for (uint64_t frame = oldest; frame < confirmed; frame++) {
+                if (!m_inputs[i].has(frame)) {
+                    confirmed = frame;
+                    break;
+                }
+            }
+        }
+
+        size_t size = 0;
+        const uint8_t* saved = m_states ? m_states->find_state(confirmed, size) : nullptr;
+        if (!saved) {
+            send_current_state();
+            return;
+        }
+        send_state(std::vector<uint8_t>(saved, saved + size), confirmed);
+    }
+
+    // Load a state from the peer: the starting state for a client, or a
+    // resync. Session frames restart from the state's frame.
+    void on_state_received(const std::vector<uint8_t>& state, uint64_t frame) {
+        if (!m_host) return;
+        if (!m_host->load_state_from_buffer(state)) {
+            m_host->show_notification(emu::NetplayNotificationType::Error, "Could not load state from peer");
+            return;
+        }
+
+        m_frame_base = m_host->get_frame_count() - frame;
+        m_frames_run = frame;
+        m_rollback_from = UINT64_MAX;
+        m_used_inputs.clear();
+        if (m_states) m_states->clear();
+        if (m_speculator) m_speculator->invalidate_all();
+        reset_sync_checks(frame);
+
+        // Frames the peer ran on a prediction of our input get the input it
+        // predicted (the last one sent), so it has nothing to roll back
+        if (m_local_player_id >= 0) {
+            for (uint64_t f = m_next_local_frame; f < frame + m_input_delay; f++) {
+                m_inputs[m_local_player_id].set(f, m_last_sent_buttons);
+                m_transport.send_input(m_local_player_id, f, m_last_sent_buttons);
+            }
+            m_next_local_frame = std::max(m_next_local_frame, frame + m_input_delay);
+        }
+
+        // The confirmed inputs relayed so far may not lead up to this state
+        if (m_role == emu::NetplayRole::Host) {
+            m_next_relayed = frame;
+            m_spectator_sync_due = m_transport.get_spectator_count() > 0;
+        }
+
+        if (m_awaiting_state) {
+            m_awaiting_state = false;
+            m_connection_state = emu::NetplayConnectionState::Playing;
+            add_system_message("Game started!");
             m_host->show_notification(emu::NetplayNotificationType::Success,
                 "Netplay game started!", 3.0f);
             m_host->resume_emulator();
+        } else {
+            add_system_message("State synchronized at frame " + std::to_string(frame));
         }
     }
 
@@ -904,7 +1972,9 @@ private:
                             "Session code joining requires matchmaking server");
                     }
                 } else {
-                    success = join_session(m_join_ip, static_cast<uint16_t>(m_join_port), m_join_name);
+                    success = m_join_as_spectator
+                        ? join_as_spectator(m_join_ip, static_cast<uint16_t>(m_join_port), m_join_name)
+                        : join_session(m_join_ip, static_cast<uint16_t>(m_join_port), m_join_name);
                 }
 
                 if (success) {
@@ -1092,8 +2162,8 @@ private:
             }
         }
 
-        // Show local ROM status for clients
-        if (m_role == emu::NetplayRole::Client && m_game_info.selected) {
+        // Show local ROM status for clients and spectators
+        if (m_role != emu::NetplayRole::Host && m_game_info.selected) {
             bool rom_loaded = m_host && m_host->is_rom_loaded();
 
             ImGui::Spacing();
@@ -1101,7 +2171,8 @@ private:
                 ImGui::TextColored(ImVec4(0.8f, 0.6f, 0.2f, 1.0f),
                     "Load your copy of this ROM to continue.");
             } else {
-                RomStatus status = m_player_info[m_local_player_id].rom_status;
+                RomStatus status = m_local_player_id >= 0 ? m_player_info[m_local_player_id].rom_status
+                    : m_host->get_rom_crc32() == m_game_info.crc32 ? RomStatus::CrcMatch : RomStatus::CrcMismatch;
                 if (status == RomStatus::CrcMatch) {
                     ImGui::TextColored(ImVec4(0.2f, 0.9f, 0.2f, 1.0f),
                         "Your ROM matches!");
@@ -1187,6 +2258,12 @@ private:
 
             ImGui::EndTable();
         }
+
+        if (m_role == emu::NetplayRole::Spectator) {
+            ImGui::TextDisabled("You are spectating");
+        } else if (get_spectator_count() > 0) {
+            ImGui::TextDisabled("Spectators: %d", get_spectator_count());
+        }
     }
 
     void render_lobby_buttons() {
@@ -1194,8 +2271,8 @@ private:
         float spacing = ImGui::GetStyle().ItemSpacing.x;
 
         // Different buttons based on lobby state
-        if (m_lobby_state == LobbyState::Playing) {
-            // During gameplay, just show disconnect
+        if (m_lobby_state == LobbyState::Playing || m_role == emu::NetplayRole::Spectator) {
+            // During gameplay, and for spectators, just show disconnect
             float offset = (ImGui::GetContentRegionAvail().x - button_width) * 0.5f;
             if (offset > 0) ImGui::SetCursorPosX(ImGui::GetCursorPosX() + offset);
 
@@ -1310,7 +2387,16 @@ private:
     }
 
     void render_settings() {
+        ImGui::Checkbox("Auto Input Delay", &m_auto_input_delay);
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(
+                "Tune input delay during play from the measured\n"
+                "round-trip time and jitter.");
+        }
+
+        ImGui::BeginDisabled(m_auto_input_delay);
         ImGui::SliderInt("Input Delay", &m_input_delay, 0, 10, "%d frames");
+        ImGui::EndDisabled();
         if (ImGui::IsItemHovered()) {
             ImGui::SetTooltip(
                 "Frames of input delay before processing.\n"
@@ -1323,6 +2409,43 @@ private:
                 "Maximum frames to roll back for late inputs.\n"
                 "Higher values handle worse connections but use more CPU.");
         }
+
+        ImGui::SliderInt("Speculation Threads", &m_speculation_workers, 0, MAX_SPECULATION_WORKERS);
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(
+                "Extra copies of the core that try likely remote inputs\n"
+                "on other CPU cores, so rollbacks resimulate fewer frames.\n"
+                "Takes effect when the next game starts. 0 turns it off.");
+        }
+        if (m_speculator) {
+            ImGui::TextDisabled("Frames taken from speculation: %llu",
+                                static_cast<unsigned long long>(m_speculated_frames));
+        }
+
+        ImGui::Checkbox("Dump States on Desync", &m_dump_desync_states);
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(
+                "On a desync, write this side's save state and per-frame\n"
+                "hash log to the netplay_desync folder for comparison\n"
+                "with the other player's.");
+        }
+
+        ImGui::Checkbox("Overlay Graphs", &m_overlay_graphs);
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(
+                "Graph rollback depth, resimulation time, round-trip\n"
+                "time and frame advantage in the in-game overlay.");
+        }
+
+        ImGui::Checkbox("Log Stats to File", &m_log_stats);
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(
+                "Append a row of link and rollback figures every second\n"
+                "to a CSV file per session in the netplay_stats folder.");
+        }
+        if (m_metrics.is_logging()) {
+            ImGui::TextDisabled("Logging to %s", m_metrics.get_log_path().c_str());
+        }
     }
 
     void render_recent_connections() {
@@ -1370,6 +2493,16 @@ private:
         if (ImGui::Begin("NetplayOverlay", nullptr, flags)) {
             ImGui::TextColored(ImVec4(0.2f, 0.8f, 0.2f, 1.0f), "NETPLAY");
 
+            float progress = m_transport.get_state_progress();
+            if (progress >= 0.0f) {
+                ImGui::Text("Syncing state %d%%", static_cast<int>(progress * 100.0f));
+            }
+            if (m_role == emu::NetplayRole::Spectator) {
+                ImGui::TextDisabled("Spectating");
+            } else if (get_spectator_count() > 0) {
+                ImGui::TextDisabled("%d watching", get_spectator_count());
+            }
+
             for (int i = 0; i < m_player_count; i++) {
                 const auto& player = m_player_info[i];
                 if (player.base.is_local) {
@@ -1379,10 +2512,45 @@ private:
                     ImGui::TextColored(ping_color, "P%d: %s %dms", i + 1, player.base.name, player.base.ping_ms);
                 }
             }
+
+            if (m_overlay_graphs && m_role != emu::NetplayRole::Spectator) render_overlay_graphs();
         }
         ImGui::End();
     }
 
+    // The last GRAPH_FRAMES frames of the figures worth watching while
+    // tuning delay and rollback, each scaled to its own peak
+    void render_overlay_graphs() {
+        emu::NetplayStats stats = get_stats();
+        ImVec2 size(180.0f, 32.0f);
+        char label[64];
+
+        ImGui::Separator();
+        const auto& depth = m_metrics.rollback_depth();
+        std::snprintf(label, sizeof(label), "%d rollbacks, max %d frames", stats.rollback_count, stats.max_rollback_frames);
+        ImGui::PlotHistogram("##depth", depth.values.data(), emu::NetplayMetrics::GRAPH_FRAMES, depth.offset,
+                             label, 0.0f, std::max(depth.max(), 1.0f), size);
+
+        const auto& resim = m_metrics.resim_us();
+        std::snprintf(label, sizeof(label), "resim %.0f us/frame", stats.resim_us_per_frame);
+        ImGui::PlotLines("##resim", resim.values.data(), emu::NetplayMetrics::GRAPH_FRAMES, resim.offset,
+                         label, 0.0f, std::max(resim.max(), 1.0f), size);
+
+        const auto& rtt = m_metrics.rtt_ms();
+        std::snprintf(label, sizeof(label), "rtt %.0f +/- %.0f ms, %.0f%% loss",
+                      m_link.rtt_ms, m_link.jitter_ms, m_link.loss * 100.0f);
+        ImGui::PlotLines("##rtt", rtt.values.data(), emu::NetplayMetrics::GRAPH_FRAMES, rtt.offset,
+                         label, 0.0f, std::max(rtt.max(), 1.0f), size);
+
+        const auto& advantage = m_metrics.frame_advantage();
+        std::snprintf(label, sizeof(label), "advantage %+.1f frames", m_frame_advantage);
+        ImGui::PlotLines("##advantage", advantage.values.data(), emu::NetplayMetrics::GRAPH_FRAMES, advantage.offset,
+                         label, -4.0f, 4.0f, size);
+
+        ImGui::TextDisabled("save %.0f us  load %.0f us  delay %d", stats.save_state_us, stats.load_state_us,
+                            m_input_delay);
+    }
+
     // =========================================================================
     // Helpers
     // =========================================================================
@@ -1518,9 +2686,24 @@ private:
             if (json.contains("rollback_frames") && json["rollback_frames"].is_number()) {
                 m_rollback_window = json["rollback_frames"];
             }
+            if (json.contains("dump_desync_states") && json["dump_desync_states"].is_boolean()) {
+                m_dump_desync_states = json["dump_desync_states"];
+            }
+            if (json.contains("speculation_threads") && json["speculation_threads"].is_number()) {
+                m_speculation_workers = std::clamp(json["speculation_threads"].get<int>(), 0, MAX_SPECULATION_WORKERS);
+            }
+            if (json.contains("auto_input_delay") && json["auto_input_delay"].is_boolean()) {
+                m_auto_input_delay = json["auto_input_delay"];
+            }
             if (json.contains("allow_spectators") && json["allow_spectators"].is_boolean()) {
                 m_allow_spectators = json["allow_spectators"];
             }
+            if (json.contains("overlay_graphs") && json["overlay_graphs"].is_boolean()) {
+                m_overlay_graphs = json["overlay_graphs"];
+            }
+            if (json.contains("log_stats") && json["log_stats"].is_boolean()) {
+                m_log_stats = json["log_stats"];
+            }
 
             if (json.contains("recent_connections") && json["recent_connections"].is_array()) {
                 m_recent_connections.clear();
@@ -1556,7 +2739,12 @@ private:
             json["default_port"] = m_host_port;
             json["input_delay"] = m_input_delay;
             json["rollback_frames"] = m_rollback_window;
+            json["speculation_threads"] = m_speculation_workers;
+            json["dump_desync_states"] = m_dump_desync_states;
+            json["auto_input_delay"] = m_auto_input_delay;
             json["allow_spectators"] = m_allow_spectators;
+            json["overlay_graphs"] = m_overlay_graphs;
+            json["log_stats"] = m_log_stats;
 
             nlohmann::json recent = nlohmann::json::array();
             for (const auto& conn : m_recent_connections) {
@@ -1613,6 +2801,78 @@ private:
     // Rollback state
     bool m_is_rolling_back = false;
     int m_rollback_depth = 0;
+    std::unique_ptr<emu::RollbackStateBuffer> m_states;  // Null: delay-based only
+    emu::InputHistory m_used_inputs;
+    emu::NetplayFrameInputs m_frame_inputs;
+    uint64_t m_frames_run = 0;                // Session frames simulated so far
+
+    // Speculation
+    static constexpr int MAX_SPECULATION_WORKERS = 4;
+    static constexpr uint64_t SPECULATION_HISTORY = 64;  // Frames of remote input counted for candidates
+    int m_speculation_workers = 0;            // Setting: 0 is off
+    std::unique_ptr<emu::Speculator> m_speculator;
+    std::vector<std::pair<uint32_t, int>> m_speculation_candidates;  // Buttons, frames held
+    std::vector<emu::NetplayFrameInputs> m_speculation_inputs;
+    uint64_t m_speculated_frames = 0;         // Rollback frames not resimulated
+
+    // Desync detection
+    static constexpr uint64_t SYNC_CHECK_INTERVAL = emu::SyncCheck::MAX_FRAMES;  // One log reply spans two checks
+    static constexpr uint64_t SYNC_LOG_RETRY_FRAMES = 30;
+    static constexpr int SYNC_LOG_MAX_ATTEMPTS = 5;
+    static constexpr size_t MAX_PENDING_SYNC_HASHES = 64;
+    static constexpr size_t MAX_KEPT_SYNC_STATES = 4;
+    emu::StateHashLog m_hash_log;
+    uint64_t m_next_sync_check = 0;           // Next frame whose hash goes to the peer
+    uint64_t m_last_synced_frame = 0;         // Newest frame both hashes matched at
+    std::deque<std::pair<uint64_t, uint64_t>> m_remote_sync_hashes;   // Frame, hash; waiting for ours
+    std::deque<std::pair<uint64_t, std::vector<uint8_t>>> m_sync_states;  // Dumps only
+    bool m_desync_searching = false;          // Narrowing down a failed check
+    bool m_desync_reported = false;           // Until the next resync
+    uint64_t m_desync_check_frame = 0;
+    emu::StateHashLog::Divergence m_desync_first;  // Earliest differing frame found so far
+    uint64_t m_desync_request_first = 0;
+    int m_desync_request_count = 0;
+    int m_desync_request_attempts = 0;
+    uint64_t m_desync_request_sent = 0;       // Session frame
+    bool m_dump_desync_states = false;        // Setting
+
+    // Instrumentation
+    static constexpr uint64_t STATS_LOG_INTERVAL = 60;  // Frames per CSV row
+    emu::NetplayMetrics m_metrics;
+    emu::LinkQuality m_link;                  // As of the last time sync
+    bool m_overlay_graphs = false;            // Setting
+    bool m_log_stats = false;                 // Setting
+
+    // Time sync
+    static constexpr float ADVANTAGE_SMOOTHING = 0.1f;
+    static constexpr float TIME_SYNC_DEADBAND = 0.5f;       // Frames
+    static constexpr double TIME_SYNC_GAIN = 0.01;          // Frame time change per frame of advantage
+    static constexpr double MAX_FRAME_TIME_ADJUST = 0.03;
+    float m_frame_advantage = 0.0f;
+    double m_frame_time_scale = 1.0;
+    bool m_auto_input_delay = true;
+    uint64_t m_next_delay_update = 0;
+    uint64_t m_rollback_from = UINT64_MAX;    // Earliest mispredicted frame
+    int m_rollback_count = 0;
+    int m_max_rollback_frames = 0;
+    RollbackCallback m_rollback_callback;
+
+    // Network
+    emu::UdpTransport m_transport;
+    std::chrono::steady_clock::time_point m_connect_started;
+    std::array<InputRing, emu::NETPLAY_MAX_PLAYERS> m_inputs;
+    uint64_t m_frame_base = 0;        // Core frame at which session frame 0 ran
+    uint64_t m_next_local_frame = 0;  // First session frame without local input
+    uint32_t m_last_sent_buttons = 0;
+    uint32_t m_input_mask = UINT32_MAX;  // Buttons the core reads
+    bool m_awaiting_state = false;    // Client: playing once the host's state loads
+    bool m_state_requested = false;   // Peer asked for a resync
+
+    // Spectators
+    static constexpr int SPECTATOR_BUFFER_LIMIT = 4 * emu::UdpTransport::SPECTATOR_BATCH;  // Frames counted ahead
+    static constexpr double SPECTATOR_CATCH_UP_SCALE = 0.8;
+    uint64_t m_next_relayed = 0;      // Host: first session frame not relayed yet
+    bool m_spectator_sync_due = false;  // Host: a spectator waits for a starting state
 
     // GUI state
     bool m_show_host_dialog = false;
@@ -0,0 +1,104 @@
+#include "netplay_metrics.hpp"
+
+#include <algorithm>
+
+namespace emu {
+
+namespace {
+
+// Recent averages move this fraction of the way to each new sample
+constexpr float AVERAGE_GAIN = 1.0f / 16.0f;
+
+float microseconds(NetplayMetrics::Duration time) {
+    return std::chrono::duration<float, std::micro>(time).count();
+}
+
+void average(float& value, float sample) {
+    value = value == 0.0f ? sample : value + (sample - value) * AVERAGE_GAIN;
+}
+
+} // namespace
+
+float NetplayMetrics::Series::max() const {
+    return *std::max_element(values.begin(), values.end());
+}
+
+void NetplayMetrics::reset() {
+    m_resim_us_per_frame = 0.0f;
+    m_save_us = 0.0f;
+    m_load_us = 0.0f;
+    m_histogram = {};
+    m_frame_depth = 0;
+    m_frame_resim_us = 0.0f;
+    m_depth = {};
+    m_resim = {};
+    m_rtt = {};
+    m_advantage = {};
+}
+
+void NetplayMetrics::record_save(Duration time) {
+    average(m_save_us, microseconds(time));
+}
+
+void NetplayMetrics::record_load(Duration time) {
+    average(m_load_us, microseconds(time));
+}
+
+void NetplayMetrics::record_rollback(int depth, int frames_resimulated, Duration resim_time) {
+    if (depth <= 0) return;
+    m_histogram[std::min(depth, NETPLAY_MAX_ROLLBACK_FRAMES) - 1]++;
+    m_frame_depth = std::max(m_frame_depth, depth);
+
+    float us = microseconds(resim_time);
+    m_frame_resim_us += us;
+    if (frames_resimulated > 0) average(m_resim_us_per_frame, us / static_cast<float>(frames_resimulated));
+}
+
+void NetplayMetrics::end_frame(const LinkQuality& link, float frame_advantage) {
+    m_depth.push(static_cast<float>(m_frame_depth));
+    m_resim.push(m_frame_resim_us);
+    m_rtt.push(link.valid ? link.rtt_ms : 0.0f);
+    m_advantage.push(frame_advantage);
+    m_frame_depth = 0;
+    m_frame_resim_us = 0.0f;
+}
+
+void NetplayMetrics::fill_stats(NetplayStats& stats) const {
+    stats.resim_us_per_frame = m_resim_us_per_frame;
+    stats.save_state_us = m_save_us;
+    stats.load_state_us = m_load_us;
+    std::copy(m_histogram.begin(), m_histogram.end(), stats.rollback_depth_histogram);
+}
+
+bool NetplayMetrics::open_log(const std::string& path) {
+    close_log();
+    m_log.open(path, std::ios::out | std::ios::app);
+    if (!m_log.is_open()) return false;
+    m_log_path = path;
+
+    m_log << "frame,rtt_ms,jitter_ms,loss_pct,frame_advantage,input_delay,rollback_window,"
+             "rollbacks,max_rollback,resim_us_per_frame,save_us,load_us,bytes_sent,bytes_received";
+    for (int depth = 1; depth <= NETPLAY_MAX_ROLLBACK_FRAMES; depth++) m_log << ",depth" << depth;
+    m_log << "\n";
+    return true;
+}
+
+void NetplayMetrics::close_log() {
+    if (m_log.is_open()) m_log.close();
+    m_log_path.clear();
+}
+
+void NetplayMetrics::log_row(uint64_t frame, const NetplayStats& stats, int input_delay, int rollback_window) {
+    if (!m_log.is_open()) return;
+    m_log << frame << ',' << stats.local_ping_ms << ',' << stats.jitter_ms << ','
+          << stats.packet_loss * 100.0f << ',' << stats.frame_advantage << ','
+          << input_delay << ',' << rollback_window << ','
+          << stats.rollback_count << ',' << stats.max_rollback_frames << ','
+          << stats.resim_us_per_frame << ',' << stats.save_state_us << ',' << stats.load_state_us << ','
+          << stats.bytes_sent << ',' << stats.bytes_received;
+    for (int count : stats.rollback_depth_histogram) m_log << ',' << count;
+    m_log << "\n";
+    m_log.flush();
+}
+
+} // namespace emu
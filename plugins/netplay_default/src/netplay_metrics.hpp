@@ -0,0 +1,80 @@
+#pragma once
+
+#include "udp_transport.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace emu {
+
+// Rollback cost and link figures for one session: recent averages for
+// get_stats(), the last few seconds per frame for the overlay graphs, and
+// optionally a CSV log with one row per sample interval
+class NetplayMetrics {
+public:
+    using Duration = std::chrono::steady_clock::duration;
+
+    static constexpr int GRAPH_FRAMES = 240;
+
+    // Ring of per-frame samples, oldest at offset (ImGui::PlotLines order)
+    struct Series {
+        std::array<float, GRAPH_FRAMES> values{};
+        int offset = 0;
+
+        void push(float value) {
+            values[offset] = value;
+            offset = (offset + 1) % GRAPH_FRAMES;
+        }
+        float max() const;
+    };
+
+    void reset();
+
+    void record_save(Duration time);
+    void record_load(Duration time);
+
+    // A rollback `depth` frames deep, frames_resimulated of them run again
+    // (the rest taken from speculation) in resim_time
+    void record_rollback(int depth, int frames_resimulated, Duration resim_time);
+
+    // Close the session frame that just started running, graphing the
+    // rollbacks done for it and the link as of now
+    void end_frame(const LinkQuality& link, float frame_advantage);
+
+    void fill_stats(NetplayStats& stats) const;
+
+    const Series& rollback_depth() const { return m_depth; }
+    const Series& resim_us() const { return m_resim; }
+    const Series& rtt_ms() const { return m_rtt; }
+    const Series& frame_advantage() const { return m_advantage; }
+
+    // CSV log, one row per call to log_row()
+    bool open_log(const std::string& path);
+    void close_log();
+    bool is_logging() const { return m_log.is_open(); }
+    const std::string& get_log_path() const { return m_log_path; }
+    void log_row(uint64_t frame, const NetplayStats& stats, int input_delay, int rollback_window);
+
+private:
+    float m_resim_us_per_frame = 0.0f;
+    float m_save_us = 0.0f;
+    float m_load_us = 0.0f;
+    std::array<int, NETPLAY_MAX_ROLLBACK_FRAMES> m_histogram{};
+
+    // Rollbacks since the last end_frame()
+    int m_frame_depth = 0;
+    float m_frame_resim_us = 0.0f;
+
+    Series m_depth;
+    Series m_resim;
+    Series m_rtt;
+    Series m_advantage;
+
+    std::ofstream m_log;
+    std::string m_log_path;
+};
+
+} // namespace emu
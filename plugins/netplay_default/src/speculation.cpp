@@ -0,0 +1,157 @@
+#include "speculation.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace emu {
+
+Speculator::~Speculator() {
+    stop();
+}
+
+bool Speculator::start(INetplayHost* host, int workers, size_t max_state_size, int max_frames) {
+    stop();
+    if (!host || workers <= 0 || max_state_size == 0 || max_frames <= 0) return false;
+
+    m_host = host;
+    m_max_state_size = max_state_size;
+    m_max_frames = max_frames;
+    m_stopping = false;
+
+    for (int i = 0; i < workers; i++) {
+        INetplayCapable* core = host->create_emulator_clone();
+        if (!core) break;
+
+        auto worker = std::make_unique<Worker>();
+        worker->core = core;
+        worker->base_state.resize(max_state_size);
+        worker->states.resize(max_state_size * static_cast<size_t>(max_frames));
+        worker->sizes.resize(static_cast<size_t>(max_frames));
+        worker->hashes.resize(static_cast<size_t>(max_frames));
+        worker->components.resize(static_cast<size_t>(max_frames));
+        worker->component_counts.resize(static_cast<size_t>(max_frames));
+        m_workers.push_back(std::move(worker));
+    }
+    for (auto& worker : m_workers) {
+        Worker* w = worker.get();
+        w->thread = std::thread([this, w] { run(*w); });
+    }
+    return !m_workers.empty();
+}
+
+void Speculator::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& worker : m_workers) {
+        if (worker->thread.joinable()) worker->thread.join();
+        m_host->destroy_emulator_clone(worker->core);
+    }
+    m_workers.clear();
+}
+
+bool Speculator::is_idle(int worker) const {
+    return !m_workers[worker]->busy.load(std::memory_order_acquire);
+}
+
+void Speculator::submit(int worker, const uint8_t* state, size_t size, uint64_t base_frame,
+                        const std::vector<NetplayFrameInputs>& inputs) {
+    Worker& w = *m_workers[worker];
+    if (w.busy.load(std::memory_order_acquire)) return;
+    if (size > m_max_state_size || inputs.empty() || inputs.size() > static_cast<size_t>(m_max_frames)) return;
+
+    std::memcpy(w.base_state.data(), state, size);
+    w.base_size = size;
+    w.base_frame = base_frame;
+    w.inputs = inputs;
+    w.stale = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        w.busy.store(true, std::memory_order_release);
+    }
+    m_wake.notify_all();
+}
+
+uint64_t Speculator::find_branch(uint64_t from, uint64_t limit, const InputMatcher& matches, int& worker) const {
+    uint64_t best = from;
+    worker = -1;
+
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        const Worker& w = *m_workers[i];
+        if (w.busy.load(std::memory_order_acquire) || w.stale || w.base_frame > from) continue;
+
+        // Every frame from the branch's start has to match, including the
+        // ones before `from` that were predicted correctly
+        uint64_t reached = w.base_frame;
+        for (int k = 0; k < w.frames_done; k++) {
+            uint64_t frame = w.base_frame + static_cast<uint64_t>(k);
+            if (frame >= limit || !matches(frame, w.inputs[static_cast<size_t>(k)])) break;
+            reached = frame + 1;
+        }
+        if (reached > best) {
+            best = reached;
+            worker = static_cast<int>(i);
+        }
+    }
+    return best;
+}
+
+const uint8_t* Speculator::get_state(int worker, uint64_t frame, size_t& size) const {
+    const Worker& w = *m_workers[worker];
+    size_t index = static_cast<size_t>(frame - w.base_frame - 1);
+    size = w.sizes[index];
+    return w.states.data() + index * m_max_state_size;
+}
+
+uint64_t Speculator::get_state_hash(int worker, uint64_t frame, const StateHashComponent*& components,
+                                    int& count) const {
+    const Worker& w = *m_workers[worker];
+    size_t index = static_cast<size_t>(frame - w.base_frame - 1);
+    components = w.components[index].data();
+    count = w.component_counts[index];
+    return w.hashes[index];
+}
+
+void Speculator::invalidate_after(uint64_t frame) {
+    for (auto& worker : m_workers) {
+        if (worker->base_frame > frame) worker->stale = true;
+    }
+}
+
+void Speculator::invalidate_all() {
+    for (auto& worker : m_workers) worker->stale = true;
+}
+
+void Speculator::run(Worker& worker) {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stopping || worker.busy.load(std::memory_order_acquire); });
+            if (m_stopping) return;
+        }
+
+        int done = 0;
+        if (worker.core->load_state_fast(worker.base_state.data(), worker.base_size)) {
+            for (const auto& inputs : worker.inputs) {
+                worker.core->run_frame_netplay_n(inputs);
+                worker.core->discard_audio();
+                uint8_t* out = worker.states.data() + static_cast<size_t>(done) * m_max_state_size;
+                size_t size = worker.core->save_state_fast(out, m_max_state_size);
+                if (size == 0) break;
+                size_t index = static_cast<size_t>(done);
+                worker.sizes[index] = size;
+                worker.hashes[index] = worker.core->get_state_hash();
+                worker.component_counts[index] = worker.core->get_state_hash_components(
+                    worker.components[index].data(), NETPLAY_MAX_HASH_COMPONENTS);
+                done++;
+            }
+        }
+        worker.frames_done = done;
+        worker.busy.store(false, std::memory_order_release);
+    }
+}
+
+} // namespace emu
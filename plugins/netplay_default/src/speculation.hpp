@@ -0,0 +1,104 @@
+#pragma once
+
+#include "emu/netplay_plugin.hpp"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace emu {
+
+// Speculative rollback on spare cores
+//
+// While a remote player's input is still a prediction, each worker re-runs
+// the frames since the oldest predicted one on its own copy of the core
+// with that player holding a different likely input, keeping the state (and
+// its hash) at the start of every frame. If the real input then contradicts
+// the main line's prediction, a branch that guessed it already holds the
+// states a rollback would compute, so only the frames past the branch's end
+// have to be resimulated.
+//
+// Branches are handed out only while their worker is idle. A branch starts
+// from a copy of the main line's state, so a rollback to an earlier frame
+// makes it stale (invalidate_after).
+class Speculator {
+public:
+    // Whether a branch ran a frame with the inputs known for it now
+    using InputMatcher = std::function<bool(uint64_t frame, const NetplayFrameInputs& inputs)>;
+
+    Speculator() = default;
+    ~Speculator();
+
+    Speculator(const Speculator&) = delete;
+    Speculator& operator=(const Speculator&) = delete;
+
+    // Clone up to `workers` cores from the host, each running at most
+    // max_frames frames per branch. False if the host made none.
+    bool start(INetplayHost* host, int workers, size_t max_state_size, int max_frames);
+    void stop();
+
+    int get_worker_count() const { return static_cast<int>(m_workers.size()); }
+    bool is_idle(int worker) const;
+
+    // Run one frame per entry of inputs (every player's buttons) from a
+    // state taken at the start of base_frame. Ignored unless the worker is
+    // idle.
+    void submit(int worker, const uint8_t* state, size_t size, uint64_t base_frame,
+                const std::vector<NetplayFrameInputs>& inputs);
+
+    // The idle branch that started at or before `from` and gets furthest
+    // (up to limit) with every frame's inputs matching. Returns the frame
+    // whose start state it holds, or `from` if no branch gets past it.
+    uint64_t find_branch(uint64_t from, uint64_t limit, const InputMatcher& matches, int& worker) const;
+
+    // State at the start of a frame reached by find_branch()
+    const uint8_t* get_state(int worker, uint64_t frame, size_t& size) const;
+
+    // get_state_hash() and the sub-hashes of that state
+    uint64_t get_state_hash(int worker, uint64_t frame, const StateHashComponent*& components, int& count) const;
+
+    void invalidate_after(uint64_t frame);
+    void invalidate_all();
+
+private:
+    struct Worker {
+        INetplayCapable* core = nullptr;
+        std::thread thread;
+        std::atomic<bool> busy{false};
+
+        // Written by the main thread while idle
+        bool stale = true;
+        uint64_t base_frame = 0;
+        std::vector<uint8_t> base_state;
+        size_t base_size = 0;
+        std::vector<NetplayFrameInputs> inputs;
+
+        // Written by the worker thread while busy. State k is taken at the
+        // start of base_frame + k + 1.
+        std::vector<uint8_t> states;
+        std::vector<size_t> sizes;
+        std::vector<uint64_t> hashes;
+        std::vector<std::array<StateHashComponent, NETPLAY_MAX_HASH_COMPONENTS>> components;
+        std::vector<int> component_counts;
+        int frames_done = 0;
+    };
+
+    void run(Worker& worker);
+
+    INetplayHost* m_host = nullptr;
+    size_t m_max_state_size = 0;
+    int m_max_frames = 0;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stopping = false;
+};
+
+} // namespace emu
@@ -0,0 +1,193 @@
+#include "state_codec.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace emu {
+
+namespace {
+
+// Sequence layout: token (high nibble literal count, low nibble match length
+// minus MIN_MATCH; 15 means more length bytes follow, each adding up to 255),
+// the literals, then a 16-bit little-endian offset back into the output.
+// The final sequence is literals only and has no offset.
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_OFFSET = 65535;
+constexpr int HASH_BITS = 14;
+
+// The last bytes are always emitted as literals so a match never reads past
+// the end of the input
+constexpr size_t END_LITERALS = 5;
+
+uint32_t read_u32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint32_t hash4(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+void put_length(std::vector<uint8_t>& out, size_t length) {
+    while (length >= 255) {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back(static_cast<uint8_t>(length));
+}
+
+void put_sequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literal_count,
+                  size_t match_length, size_t offset) {
+    size_t extra_match = match_length ? match_length - MIN_MATCH : 0;
+    uint8_t token = static_cast<uint8_t>((literal_count < 15 ? literal_count : 15) << 4);
+    token |= static_cast<uint8_t>(extra_match < 15 ? extra_match : 15);
+    out.push_back(token);
+    if (literal_count >= 15) put_length(out, literal_count - 15);
+    out.insert(out.end(), literals, literals + literal_count);
+    if (!match_length) return;
+
+    out.push_back(static_cast<uint8_t>(offset));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    if (extra_match >= 15) put_length(out, extra_match - 15);
+}
+
+bool get_length(const uint8_t*& in, const uint8_t* end, size_t& length) {
+    uint8_t byte;
+    do {
+        if (in >= end) return false;
+        byte = *in++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+} // namespace
+
+void lz_compress(const uint8_t* src, size_t size, std::vector<uint8_t>& out) {
+    std::array<uint32_t, 1u << HASH_BITS> table;
+    table.fill(UINT32_MAX);
+
+    size_t anchor = 0;
+    size_t pos = 0;
+    size_t limit = size > END_LITERALS + MIN_MATCH ? size - END_LITERALS - MIN_MATCH : 0;
+
+    while (pos < limit) {
+        uint32_t sequence = read_u32(src + pos);
+        uint32_t& slot = table[hash4(sequence)];
+        size_t candidate = slot;
+        slot = static_cast<uint32_t>(pos);
+
+        if (candidate == UINT32_MAX || pos - candidate > MAX_OFFSET ||
+            read_u32(src + candidate) != sequence) {
+            pos++;
+            continue;
+        }
+
+        size_t length = MIN_MATCH;
+        size_t max_length = size - END_LITERALS - pos;
+        while (length < max_length && src[candidate + length] == src[pos + length]) length++;
+
+        put_sequence(out, src + anchor, pos - anchor, length, pos - candidate);
+        pos += length;
+        anchor = pos;
+    }
+
+    put_sequence(out, src + anchor, size - anchor, 0, 0);
+}
+
+bool lz_decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t dst_size, size_t& written) {
+    const uint8_t* in = src;
+    const uint8_t* end = src + size;
+    written = 0;
+
+    while (in < end) {
+        uint8_t token = *in++;
+
+        size_t literal_count = token >> 4;
+        if (literal_count == 15 && !get_length(in, end, literal_count)) return false;
+        if (literal_count > static_cast<size_t>(end - in) || literal_count > dst_size - written) return false;
+        std::memcpy(dst + written, in, literal_count);
+        in += literal_count;
+        written += literal_count;
+
+        if (in == end) break;  // Final literal-only sequence
+
+        if (end - in < 2) return false;
+        size_t offset = in[0] | (static_cast<size_t>(in[1]) << 8);
+        in += 2;
+        size_t length = token & 15;
+        if (length == 15 && !get_length(in, end, length)) return false;
+        length += MIN_MATCH;
+        if (offset == 0 || offset > written || length > dst_size - written) return false;
+
+        // Byte by byte: a match may overlap the bytes it produces
+        const uint8_t* from = dst + written - offset;
+        for (size_t i = 0; i < length; i++) dst[written + i] = from[i];
+        written += length;
+    }
+
+    return true;
+}
+
+void encode_keyframe(const std::vector<uint8_t>& state, std::vector<uint8_t>& out) {
+    out.clear();
+    lz_compress(state.data(), state.size(), out);
+}
+
+void encode_delta(const std::vector<uint8_t>& state, const std::vector<uint8_t>& base,
+                  std::vector<uint8_t>& out) {
+    size_t pages = (state.size() + STATE_PAGE_SIZE - 1) / STATE_PAGE_SIZE;
+    std::vector<uint8_t> delta((pages + 7) / 8, 0);
+
+    for (size_t page = 0; page < pages; page++) {
+        size_t begin = page * STATE_PAGE_SIZE;
+        size_t length = std::min(STATE_PAGE_SIZE, state.size() - begin);
+        if (std::memcmp(state.data() + begin, base.data() + begin, length) == 0) continue;
+
+        delta[page / 8] |= static_cast<uint8_t>(1u << (page % 8));
+        for (size_t i = 0; i < length; i++) {
+            delta.push_back(state[begin + i] ^ base[begin + i]);
+        }
+    }
+
+    out.clear();
+    lz_compress(delta.data(), delta.size(), out);
+}
+
+bool decode_state(StateEncoding encoding, const std::vector<uint8_t>& encoded, size_t raw_size,
+                  const std::vector<uint8_t>& base, std::vector<uint8_t>& out) {
+    size_t written = 0;
+    if (encoding == StateEncoding::Keyframe) {
+        out.resize(raw_size);
+        return lz_decompress(encoded.data(), encoded.size(), out.data(), raw_size, written) &&
+               written == raw_size;
+    }
+
+    if (base.size() != raw_size) return false;
+
+    // At most the bitmap plus every page
+    size_t pages = (raw_size + STATE_PAGE_SIZE - 1) / STATE_PAGE_SIZE;
+    size_t bitmap_size = (pages + 7) / 8;
+    std::vector<uint8_t> delta(bitmap_size + raw_size);
+    if (!lz_decompress(encoded.data(), encoded.size(), delta.data(), delta.size(), written) ||
+        written < bitmap_size) {
+        return false;
+    }
+
+    out = base;
+    size_t next = bitmap_size;
+    for (size_t page = 0; page < pages; page++) {
+        if (!((delta[page / 8] >> (page % 8)) & 1)) continue;
+
+        size_t begin = page * STATE_PAGE_SIZE;
+        size_t length = std::min(STATE_PAGE_SIZE, raw_size - begin);
+        if (written - next < length) return false;
+        for (size_t i = 0; i < length; i++) out[begin + i] ^= delta[next + i];
+        next += length;
+    }
+    return next == written;
+}
+
+} // namespace emu
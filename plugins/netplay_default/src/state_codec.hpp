@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace emu {
+
+// Encoding of save states for transfer between peers
+//
+// A keyframe is the whole state run through a small LZ77 block compressor
+// (LZ4-style sequences: a literal run followed by a back-reference).
+// Save states are mostly zero-filled or repetitive memory, so this gets
+// most of the size down at a few hundred MB/s without an extra library.
+//
+// A delta is taken against a base state the receiver already holds. The
+// state is split into STATE_PAGE_SIZE pages. The delta is a bitmap of
+// changed pages followed by those pages XORed with the base, and the whole
+// thing is then compressed the same way.
+constexpr size_t STATE_PAGE_SIZE = 256;
+
+enum class StateEncoding : uint8_t {
+    Keyframe = 0,
+    Delta = 1
+};
+
+// Append the compressed form of [src, src + size) to out
+void lz_compress(const uint8_t* src, size_t size, std::vector<uint8_t>& out);
+
+// Decompress into at most dst_size bytes, setting written to the decoded
+// length. False on malformed input or if dst is too small.
+bool lz_decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t dst_size, size_t& written);
+
+void encode_keyframe(const std::vector<uint8_t>& state, std::vector<uint8_t>& out);
+
+// The base must be the same size as the state
+void encode_delta(const std::vector<uint8_t>& state, const std::vector<uint8_t>& base,
+                  std::vector<uint8_t>& out);
+
+// Rebuild a raw_size-byte state. Deltas need the base they were made from.
+bool decode_state(StateEncoding encoding, const std::vector<uint8_t>& encoded, size_t raw_size,
+                  const std::vector<uint8_t>& base, std::vector<uint8_t>& out);
+
+} // namespace emu
@@ -0,0 +1,99 @@
+#include "state_hash_log.hpp"
+
+#include <algorithm>
+
+namespace emu {
+
+void StateHashLog::clear() {
+    for (Entry& entry : m_entries) entry.frame = UINT64_MAX;
+}
+
+void StateHashLog::record(INetplayCapable* core, uint64_t frame) {
+    StateHashComponent parts[NETPLAY_MAX_HASH_COMPONENTS];
+    int count = core->get_state_hash_components(parts, NETPLAY_MAX_HASH_COMPONENTS);
+    record(frame, core->get_state_hash(), parts, count);
+}
+
+void StateHashLog::record(uint64_t frame, uint64_t hash, const StateHashComponent* components, int count) {
+    Entry& entry = m_entries[frame % CAPACITY];
+    entry.frame = frame;
+    entry.hash = hash;
+
+    count = std::clamp(count, 0, NETPLAY_MAX_HASH_COMPONENTS);
+    if (count != get_component_count()) {
+        m_component_names.clear();
+        for (int i = 0; i < count; i++) {
+            m_component_names.emplace_back(components[i].name ? components[i].name : "?");
+        }
+    }
+    for (int i = 0; i < count; i++) entry.components[i] = components[i].hash;
+}
+
+const StateHashLog::Entry* StateHashLog::find(uint64_t frame) const {
+    const Entry& entry = m_entries[frame % CAPACITY];
+    return entry.frame == frame ? &entry : nullptr;
+}
+
+bool StateHashLog::get_hash(uint64_t frame, uint64_t& hash) const {
+    const Entry* entry = find(frame);
+    if (!entry) return false;
+    hash = entry->hash;
+    return true;
+}
+
+bool StateHashLog::get_component(uint64_t frame, int index, uint64_t& hash) const {
+    const Entry* entry = find(frame);
+    if (!entry || index < 0 || index >= get_component_count()) return false;
+    hash = entry->components[index];
+    return true;
+}
+
+void StateHashLog::fill_log(uint64_t first, int count, SyncCheck& out) const {
+    out.type = SyncCheck::Type::Log;
+    out.frame = first;
+    out.count = std::clamp(count, 0, SyncCheck::MAX_FRAMES);
+    out.components = get_component_count();
+    out.valid = 0;
+
+    int stride = 1 + out.components;
+    for (int i = 0; i < out.count; i++) {
+        const Entry* entry = find(first + static_cast<uint64_t>(i));
+        if (!entry) continue;
+        out.valid |= 1u << i;
+        out.values[i * stride] = entry->hash;
+        for (int c = 0; c < out.components; c++) out.values[i * stride + 1 + c] = entry->components[c];
+    }
+}
+
+StateHashLog::Divergence StateHashLog::compare(const SyncCheck& remote) const {
+    Divergence result;
+    int stride = 1 + remote.components;
+    bool matched = false;
+
+    for (int i = 0; i < remote.count; i++) {
+        const Entry* entry = find(remote.frame + static_cast<uint64_t>(i));
+        if (!entry || !(remote.valid & (1u << i))) continue;
+
+        uint64_t remote_hash = remote.values[i * stride];
+        if (entry->hash == remote_hash) {
+            matched = true;
+            continue;
+        }
+
+        result.found = true;
+        result.frame = entry->frame;
+        result.local_hash = entry->hash;
+        result.remote_hash = remote_hash;
+        result.pinned = matched;
+        if (remote.components == get_component_count()) {
+            for (int c = 0; c < remote.components; c++) {
+                if (entry->components[c] != remote.values[i * stride + 1 + c]) result.components |= 1u << c;
+            }
+        }
+        return result;
+    }
+    result.pinned = matched;
+    return result;
+}
+
+} // namespace emu
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "udp_transport.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace emu {
+
+// Rolling log of the state hash at the start of each session frame, with
+// the core's sub-hashes, for finding where two peers diverged
+//
+// A frame's entry is written when the frame runs and rewritten if a
+// rollback runs it again (or takes it from speculation), so it is final
+// once every input before the frame is confirmed.
+class StateHashLog {
+public:
+    static constexpr int CAPACITY = 1024;
+
+    // Earliest frame at which a peer's log differs from ours
+    struct Divergence {
+        bool found = false;
+        uint64_t frame = 0;
+        uint64_t local_hash = 0;
+        uint64_t remote_hash = 0;
+        uint32_t components = 0;    // Bit i: sub-hash i differs
+        bool pinned = false;        // A matching frame precedes it in the same log
+                                    // (if none differs: any frame matched)
+    };
+
+    void clear();
+
+    // Hash the core's current state as the state at the start of frame
+    void record(INetplayCapable* core, uint64_t frame);
+    void record(uint64_t frame, uint64_t hash, const StateHashComponent* components, int count);
+
+    bool get_hash(uint64_t frame, uint64_t& hash) const;
+
+    // Parts of the core's hash, by index, as named by the core
+    int get_component_count() const { return static_cast<int>(m_component_names.size()); }
+    const std::string& get_component_name(int index) const { return m_component_names[index]; }
+    bool get_component(uint64_t frame, int index, uint64_t& hash) const;
+
+    // Our entries for count frames from first, as a Log reply
+    void fill_log(uint64_t first, int count, SyncCheck& out) const;
+
+    Divergence compare(const SyncCheck& remote) const;
+
+private:
+    struct Entry {
+        uint64_t frame = UINT64_MAX;
+        uint64_t hash = 0;
+        std::array<uint64_t, NETPLAY_MAX_HASH_COMPONENTS> components{};
+    };
+
+    const Entry* find(uint64_t frame) const;
+
+    std::vector<Entry> m_entries = std::vector<Entry>(CAPACITY);
+    std::vector<std::string> m_component_names;
+};
+
+} // namespace emu
@@ -0,0 +1,1382 @@
+#include "udp_transport.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    using socklen_t = int;
+#else
+    #include <arpa/inet.h>
+    #include <fcntl.h>
+    #include <netdb.h>
+    #include <netinet/in.h>
+    #include <sys/select.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+
+namespace emu {
+
+namespace {
+
+// Datagram layout: magic, protocol version, packet type, then the payload.
+// Multi-byte fields are little-endian.
+constexpr uint8_t MAGIC0 = 'V';
+constexpr uint8_t MAGIC1 = 'N';
+constexpr uint8_t PROTOCOL_VERSION = 2;
+constexpr size_t HEADER_SIZE = 4;
+constexpr size_t MAX_DATAGRAM = 1200;
+
+enum PacketType : uint8_t {
+    PACKET_HELLO = 1,     // Client -> host: name[32]
+    PACKET_WELCOME = 2,   // Host -> client: player_id, name[32]
+    PACKET_BYE = 3,       // Either way, no payload
+    PACKET_LOBBY = 4,     // Either way: LobbySnapshot
+    PACKET_INPUT = 5,     // Either way: player, count, bits per input, first frame (u64),
+                          // then the buttons bit-packed
+    PACKET_STATE = 6,     // Either way: STATE_HEADER_SIZE header, then one chunk
+    PACKET_STATE_ACK = 7, // Either way: id, chunks received in order (u16), bitmap of the next 64
+    PACKET_STATE_REQUEST = 8, // Either way: flags (1 = the last delta could not be applied)
+    PACKET_PING = 9,      // Either way: sender time in us (u64), sender session frame (u64)
+    PACKET_PONG = 10,     // Reply: the ping's time echoed (u64), replier session frame (u64)
+    PACKET_SPECTATE = 11, // Spectator -> host: name[32], repeated as a keepalive
+    PACKET_CONFIRMED = 12, // Host -> spectator: player count, frame count, bits per input,
+                           // first frame (u64), then each frame's buttons bit-packed
+    PACKET_CONFIRMED_RESEND = 13, // Spectator -> host: first frame missing (u64)
+    PACKET_SYNC_HASH = 14,        // Either way: frame (u64), hash of the state at its start (u64)
+    PACKET_HASH_LOG_REQUEST = 15, // Either way: first frame (u64), count
+    PACKET_HASH_LOG = 16          // Reply: first frame (u64), count, sub-hashes per frame,
+                                  // valid bitmap (u32), then per frame the hash and its
+                                  // sub-hashes (u64 each)
+};
+
+// Player slot in the welcome a spectator gets
+constexpr uint8_t SPECTATOR_SLOT = 0xFF;
+
+// A spectator not heard from for this long is dropped
+constexpr auto SPECTATOR_TIMEOUT = std::chrono::seconds(5);
+
+// A partial batch of confirmed frames goes out after this long anyway
+constexpr auto CONFIRMED_FLUSH_INTERVAL = std::chrono::milliseconds(50);
+
+// A spectator asks again for a gap no more often than this
+constexpr auto CONFIRMED_RESEND_INTERVAL = std::chrono::milliseconds(100);
+
+// State chunk header: id (u32), frame (u64), encoding (u8), base id (u32),
+// raw size (u32), checksum (u32), encoded size (u32), index (u16), count (u16)
+constexpr size_t STATE_HEADER_SIZE = 4 + 8 + 1 + 4 + 4 + 4 + 4 + 2 + 2;
+
+// Largest decoded state accepted from a peer
+constexpr uint32_t MAX_STATE_SIZE = 64u << 20;
+
+// Unacknowledged state chunks are sent again after this long
+constexpr auto STATE_RESEND_INTERVAL = std::chrono::milliseconds(100);
+
+// Hello (client) and lobby state (both) are resent at this interval
+constexpr auto CONTROL_INTERVAL = std::chrono::milliseconds(250);
+
+// Round trips are measured at this interval
+constexpr auto PING_INTERVAL = std::chrono::milliseconds(100);
+
+// Packet loss is sampled once per this many pings
+constexpr int LOSS_WINDOW = 10;
+
+// Longest the network thread sleeps before checking for outbound input
+constexpr int POLL_INTERVAL_US = 1000;
+
+#ifdef _WIN32
+using NativeSocket = SOCKET;
+const intptr_t INVALID_SOCKET_HANDLE = static_cast<intptr_t>(INVALID_SOCKET);
+#else
+using NativeSocket = int;
+constexpr intptr_t INVALID_SOCKET_HANDLE = -1;
+#endif
+
+NativeSocket native(intptr_t sock) { return static_cast<NativeSocket>(sock); }
+
+// Family, address and port match (sockaddr padding is ignored)
+bool same_address(const sockaddr_storage& a, const uint8_t* b_bytes) {
+    sockaddr_storage b;
+    std::memcpy(&b, b_bytes, sizeof(b));
+    if (a.ss_family != b.ss_family) return false;
+    if (a.ss_family == AF_INET6) {
+        auto& a6 = reinterpret_cast<const sockaddr_in6&>(a);
+        auto& b6 = reinterpret_cast<const sockaddr_in6&>(b);
+        return a6.sin6_port == b6.sin6_port &&
+               std::memcmp(&a6.sin6_addr, &b6.sin6_addr, sizeof(a6.sin6_addr)) == 0;
+    }
+    auto& a4 = reinterpret_cast<const sockaddr_in&>(a);
+    auto& b4 = reinterpret_cast<const sockaddr_in&>(b);
+    return a4.sin_port == b4.sin_port && a4.sin_addr.s_addr == b4.sin_addr.s_addr;
+}
+
+void put_u32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[i] = static_cast<uint8_t>(value >> (i * 8));
+}
+
+void put_u64(uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; i++) out[i] = static_cast<uint8_t>(value >> (i * 8));
+}
+
+uint32_t get_u32(const uint8_t* in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) value |= static_cast<uint32_t>(in[i]) << (i * 8);
+    return value;
+}
+
+void put_u16(uint8_t* out, uint16_t value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+uint16_t get_u16(const uint8_t* in) {
+    return static_cast<uint16_t>(in[0] | (in[1] << 8));
+}
+
+uint64_t get_u64(const uint8_t* in) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) value |= static_cast<uint64_t>(in[i]) << (i * 8);
+    return value;
+}
+
+// Inputs on the wire are packed LSB first, `bits` bits each with no
+// padding between them; the last byte is zero-filled
+constexpr size_t INPUT_HEADER_SIZE = 1 + 1 + 1 + 8;
+
+size_t packed_size(size_t values, int bits) {
+    return (values * static_cast<size_t>(bits) + 7) / 8;
+}
+
+void pack_inputs(uint8_t* out, const uint32_t* values, size_t count, int bits) {
+    uint64_t pending = 0;
+    int pending_bits = 0;
+    uint32_t mask = bits >= 32 ? UINT32_MAX : (1u << bits) - 1;
+    for (size_t i = 0; i < count; i++) {
+        pending |= static_cast<uint64_t>(values[i] & mask) << pending_bits;
+        pending_bits += bits;
+        while (pending_bits >= 8) {
+            *out++ = static_cast<uint8_t>(pending);
+            pending >>= 8;
+            pending_bits -= 8;
+        }
+    }
+    if (pending_bits > 0) *out = static_cast<uint8_t>(pending);
+}
+
+uint32_t unpack_input(const uint8_t* in, size_t index, int bits) {
+    size_t bit = index * static_cast<size_t>(bits);
+    const uint8_t* byte = in + bit / 8;
+    int shift = static_cast<int>(bit % 8);
+    uint64_t window = 0;
+    for (int i = 0; i * 8 < shift + bits; i++) window |= static_cast<uint64_t>(byte[i]) << (i * 8);
+    uint32_t mask = bits >= 32 ? UINT32_MAX : (1u << bits) - 1;
+    return static_cast<uint32_t>(window >> shift) & mask;
+}
+
+void put_string(uint8_t* out, const char* text, size_t size) {
+    std::memset(out, 0, size);
+    std::strncpy(reinterpret_cast<char*>(out), text, size - 1);
+}
+
+void get_string(char* out, const uint8_t* in, size_t size) {
+    std::memcpy(out, in, size);
+    out[size - 1] = '\0';
+}
+
+constexpr size_t LOBBY_SIZE = 1 + 4 + 1 + 4 + 64 + 16;
+
+// FNV-1a over a decoded state, so a delta applied to the wrong base is caught
+uint32_t state_checksum(const std::vector<uint8_t>& state) {
+    uint32_t hash = 2166136261u;
+    for (uint8_t byte : state) hash = (hash ^ byte) * 16777619u;
+    return hash;
+}
+
+} // namespace
+
+UdpTransport::UdpTransport() {
+#ifdef _WIN32
+    WSADATA wsa;
+    WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+}
+
+UdpTransport::~UdpTransport() {
+    stop();
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+bool UdpTransport::open_socket(uint16_t port) {
+    // Dual-stack IPv6 socket so IPv4 peers work too
+    intptr_t sock = static_cast<intptr_t>(::socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP));
+    bool ipv6 = sock != INVALID_SOCKET_HANDLE;
+    if (ipv6) {
+        int off = 0;
+        setsockopt(native(sock), IPPROTO_IPV6, IPV6_V6ONLY,
+                   reinterpret_cast<const char*>(&off), sizeof(off));
+    } else {
+        sock = static_cast<intptr_t>(::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP));
+        if (sock == INVALID_SOCKET_HANDLE) {
+            m_error = "Could not create a UDP socket";
+            return false;
+        }
+    }
+    NativeSocket handle = native(sock);
+
+    sockaddr_storage local = {};
+    socklen_t local_len;
+    if (ipv6) {
+        auto* addr = reinterpret_cast<sockaddr_in6*>(&local);
+        addr->sin6_family = AF_INET6;
+        addr->sin6_addr = in6addr_any;
+        addr->sin6_port = htons(port);
+        local_len = sizeof(sockaddr_in6);
+    } else {
+        auto* addr = reinterpret_cast<sockaddr_in*>(&local);
+        addr->sin_family = AF_INET;
+        addr->sin_addr.s_addr = htonl(INADDR_ANY);
+        addr->sin_port = htons(port);
+        local_len = sizeof(sockaddr_in);
+    }
+    if (bind(handle, reinterpret_cast<sockaddr*>(&local), local_len) != 0) {
+        m_error = "Could not bind UDP port " + std::to_string(port);
+        m_socket = sock;
+        close_socket();
+        return false;
+    }
+
+#ifdef _WIN32
+    u_long non_blocking = 1;
+    ioctlsocket(handle, FIONBIO, &non_blocking);
+#else
+    fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+    m_socket = sock;
+    return true;
+}
+
+void UdpTransport::close_socket() {
+    if (m_socket == INVALID_SOCKET_HANDLE) return;
+#ifdef _WIN32
+    closesocket(static_cast<SOCKET>(m_socket));
+#else
+    ::close(static_cast<int>(m_socket));
+#endif
+    m_socket = INVALID_SOCKET_HANDLE;
+}
+
+bool UdpTransport::start_host(uint16_t port, const char* name) {
+    stop();
+    m_error.clear();
+    m_is_host = true;
+    m_spectating = false;
+    m_name = name ? name : "";
+    m_has_peer = false;
+    m_welcomed = false;
+    if (!open_socket(port)) return false;
+
+    m_stop.store(false);
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread(&UdpTransport::run, this);
+    return true;
+}
+
+bool UdpTransport::start_client(const char* host_addr, uint16_t port, const char* name) {
+    return start_remote(host_addr, port, name, false);
+}
+
+bool UdpTransport::start_spectator(const char* host_addr, uint16_t port, const char* name) {
+    return start_remote(host_addr, port, name, true);
+}
+
+bool UdpTransport::start_remote(const char* host_addr, uint16_t port, const char* name, bool spectating) {
+    stop();
+    m_error.clear();
+    m_is_host = false;
+    m_spectating = spectating;
+    m_name = name ? name : "";
+    m_has_peer = false;
+    m_welcomed = false;
+
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* result = nullptr;
+    std::string service = std::to_string(port);
+    if (getaddrinfo(host_addr, service.c_str(), &hints, &result) != 0 || !result) {
+        m_error = std::string("Could not resolve ") + (host_addr ? host_addr : "");
+        return false;
+    }
+    if (!open_socket(0)) {
+        freeaddrinfo(result);
+        return false;
+    }
+
+    // The socket is dual-stack when possible: map IPv4 hosts into it
+    sockaddr_storage probe = {};
+    socklen_t probe_len = sizeof(probe);
+    getsockname(native(m_socket), reinterpret_cast<sockaddr*>(&probe), &probe_len);
+    if (probe.ss_family == AF_INET6 && result->ai_family == AF_INET) {
+        auto* v4 = reinterpret_cast<const sockaddr_in*>(result->ai_addr);
+        auto* v6 = reinterpret_cast<sockaddr_in6*>(m_peer);
+        std::memset(m_peer, 0, sizeof(m_peer));
+        v6->sin6_family = AF_INET6;
+        v6->sin6_port = v4->sin_port;
+        v6->sin6_addr.s6_addr[10] = 0xFF;
+        v6->sin6_addr.s6_addr[11] = 0xFF;
+        std::memcpy(&v6->sin6_addr.s6_addr[12], &v4->sin_addr, 4);
+        m_peer_len = sizeof(sockaddr_in6);
+    } else {
+        std::memcpy(m_peer, result->ai_addr, std::min<size_t>(result->ai_addrlen, sizeof(m_peer)));
+        m_peer_len = static_cast<int>(result->ai_addrlen);
+    }
+    freeaddrinfo(result);
+    m_has_peer = true;
+
+    m_stop.store(false);
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread(&UdpTransport::run, this);
+    return true;
+}
+
+void UdpTransport::stop() {
+    if (m_thread.joinable()) {
+        m_stop.store(true, std::memory_order_release);
+        m_thread.join();
+    }
+    m_running.store(false, std::memory_order_release);
+    close_socket();
+
+    m_outbound.clear();
+    m_inbound.clear();
+    m_events.clear();
+    m_sync_out.clear();
+    m_sync_in.clear();
+    m_sent = {};
+    m_next_received = {};
+    m_remote_lobby_fresh = false;
+
+    m_pending_fresh = false;
+    m_ready_fresh = false;
+    m_state_request.store(false);
+    m_state_progress.store(-1.0f);
+    m_outgoing = {};
+    m_incoming = {};
+    m_sent_base.clear();
+    m_sent_base_id = 0;
+    m_force_keyframe = false;
+    m_received_base.clear();
+    m_received_base_id = 0;
+
+    m_confirmed_out.clear();
+    m_pending_spectator_fresh = false;
+    m_spectators = {};
+    m_spectator_count.store(0);
+    m_confirmed_next = 0;
+    m_confirmed_stored = 0;
+    m_confirmed_unsent = 0;
+    m_confirmed_synced = false;
+    m_next_confirmed = 0;
+    m_confirmed_seen = 0;
+    m_relayed_players.store(0);
+
+    m_local_frame.store(0);
+    std::lock_guard<std::mutex> lock(m_quality_mutex);
+    m_quality = {};
+}
+
+bool UdpTransport::send_input(int player, uint64_t frame, uint32_t buttons) {
+    if (player < 0 || player >= NETPLAY_MAX_PLAYERS || m_spectating) return false;
+    return m_outbound.push({player, frame, buttons});
+}
+
+void UdpTransport::set_input_bits(int bits) {
+    m_input_bits.store(std::clamp(bits, 1, 32), std::memory_order_relaxed);
+}
+
+void UdpTransport::set_spectator_limit(int count) {
+    m_spectator_limit.store(std::clamp(count, 0, MAX_SPECTATORS), std::memory_order_relaxed);
+}
+
+bool UdpTransport::broadcast_confirmed(uint64_t frame, const uint32_t* buttons, int player_count) {
+    ConfirmedFrame confirmed;
+    confirmed.frame = frame;
+    confirmed.player_count = std::clamp(player_count, 0, NETPLAY_MAX_PLAYERS);
+    std::copy(buttons, buttons + confirmed.player_count, confirmed.buttons.begin());
+    return m_confirmed_out.push(confirmed);
+}
+
+void UdpTransport::send_spectator_state(const std::vector<uint8_t>& state, uint64_t frame) {
+    std::lock_guard<std::mutex> lock(m_state_mutex);
+    m_pending_spectator_state = state;
+    m_pending_spectator_frame = frame;
+    m_pending_spectator_fresh = true;
+}
+
+void UdpTransport::set_local_lobby(const LobbySnapshot& lobby) {
+    std::lock_guard<std::mutex> lock(m_lobby_mutex);
+    m_local_lobby = lobby;
+}
+
+bool UdpTransport::poll_remote_lobby(LobbySnapshot& lobby) {
+    std::lock_guard<std::mutex> lock(m_lobby_mutex);
+    if (!m_remote_lobby_fresh) return false;
+    lobby = m_remote_lobby;
+    m_remote_lobby_fresh = false;
+    return true;
+}
+
+void UdpTransport::send_state(const std::vector<uint8_t>& state, uint64_t frame) {
+    std::lock_guard<std::mutex> lock(m_state_mutex);
+    m_pending_state = state;
+    m_pending_frame = frame;
+    m_pending_fresh = true;
+}
+
+void UdpTransport::request_state() {
+    m_state_request.store(true, std::memory_order_release);
+}
+
+bool UdpTransport::poll_state(std::vector<uint8_t>& state, uint64_t& frame) {
+    std::lock_guard<std::mutex> lock(m_state_mutex);
+    if (!m_ready_fresh) return false;
+    state.swap(m_ready_state);
+    frame = m_ready_frame;
+    m_ready_fresh = false;
+    return true;
+}
+
+LinkQuality UdpTransport::get_link_quality() const {
+    std::lock_guard<std::mutex> lock(m_quality_mutex);
+    return m_quality;
+}
+
+void UdpTransport::fill_stats(NetplayStats& stats) const {
+    stats.send_queue_size = m_outbound.size();
+    stats.recv_queue_size = m_inbound.size();
+    stats.bytes_sent = m_bytes_sent.load(std::memory_order_relaxed);
+    stats.bytes_received = m_bytes_received.load(std::memory_order_relaxed);
+}
+
+// ============================================================================
+// Network thread
+// ============================================================================
+
+void UdpTransport::run() {
+    NativeSocket handle = native(m_socket);
+    m_last_control = std::chrono::steady_clock::now() - CONTROL_INTERVAL;
+    m_epoch = std::chrono::steady_clock::now();
+    m_last_ping = m_epoch;
+    m_pings_sent = 0;
+    m_pongs_received = 0;
+
+    while (!m_stop.load(std::memory_order_acquire)) {
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(handle, &readable);
+        timeval timeout = {0, POLL_INTERVAL_US};
+        if (select(static_cast<int>(m_socket + 1), &readable, nullptr, nullptr, &timeout) > 0) {
+            receive_datagrams();
+        }
+
+        flush_inputs();
+        flush_sync_checks();
+
+        if (m_incoming.ack_due) send_state_ack();
+        if (m_state_request.exchange(false, std::memory_order_acq_rel)) send_state_request(false);
+        start_outgoing_state();
+        if (m_has_peer) service_outgoing_state(m_outgoing, m_peer, m_peer_len);
+
+        if (m_is_host) {
+            flush_confirmed();
+            start_spectator_states();
+            for (Spectator& spectator : m_spectators) {
+                if (spectator.active) service_outgoing_state(spectator.state, spectator.address, spectator.address_len);
+            }
+        }
+        if (m_spectating) request_confirmed_gap();
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - m_last_ping >= PING_INTERVAL && m_has_peer && !m_spectating && (m_is_host || m_welcomed)) {
+            m_last_ping = now;
+            send_ping();
+        }
+
+        if (now - m_last_control >= CONTROL_INTERVAL) {
+            m_last_control = now;
+            if (m_spectating) {
+                // Hello until welcomed, then the same as a keepalive
+                uint8_t payload[32];
+                put_string(payload, m_name.c_str(), sizeof(payload));
+                send_packet(PACKET_SPECTATE, payload, sizeof(payload));
+            } else if (!m_is_host && !m_welcomed) {
+                uint8_t payload[32];
+                put_string(payload, m_name.c_str(), sizeof(payload));
+                send_packet(PACKET_HELLO, payload, sizeof(payload));
+            } else {
+                send_lobby();
+            }
+            if (m_is_host) expire_spectators();
+        }
+    }
+
+    if (m_has_peer) send_packet(PACKET_BYE, nullptr, 0);
+    for (const Spectator& spectator : m_spectators) {
+        if (spectator.active) send_packet_to(spectator.address, spectator.address_len, PACKET_BYE, nullptr, 0);
+    }
+}
+
+void UdpTransport::receive_datagrams() {
+    NativeSocket handle = native(m_socket);
+    uint8_t buffer[MAX_DATAGRAM];
+    for (;;) {
+        sockaddr_storage from = {};
+        socklen_t from_len = sizeof(from);
+        int received = static_cast<int>(recvfrom(handle, reinterpret_cast<char*>(buffer), sizeof(buffer), 0,
+                                                 reinterpret_cast<sockaddr*>(&from), &from_len));
+        if (received <= 0) break;
+        m_bytes_received.fetch_add(static_cast<uint64_t>(received), std::memory_order_relaxed);
+        handle_datagram(buffer, static_cast<size_t>(received), &from, static_cast<int>(from_len));
+    }
+}
+
+void UdpTransport::handle_datagram(const uint8_t* data, size_t size, const void* from, int from_len) {
+    const auto& from_addr = *static_cast<const sockaddr_storage*>(from);
+    if (size < HEADER_SIZE || data[0] != MAGIC0 || data[1] != MAGIC1 || data[2] != PROTOCOL_VERSION) {
+        return;
+    }
+    uint8_t type = data[3];
+    const uint8_t* payload = data + HEADER_SIZE;
+    size_t payload_size = size - HEADER_SIZE;
+
+    bool from_peer = m_has_peer && same_address(from_addr, m_peer);
+
+    if (m_is_host && !from_peer && type != PACKET_HELLO) {
+        handle_spectator_datagram(type, payload, payload_size, from, from_len);
+        return;
+    }
+
+    if (type == PACKET_HELLO) {
+        // Host: the first client to say hello becomes the peer
+        if (!m_is_host || payload_size < 32 || (m_has_peer && !from_peer)) return;
+        if (!m_has_peer) {
+            std::memcpy(m_peer, from, static_cast<size_t>(from_len));
+            m_peer_len = from_len;
+            m_has_peer = true;
+
+            TransportEvent event;
+            event.type = TransportEvent::Type::PeerJoined;
+            event.player_id = 1;
+            get_string(event.name, payload, sizeof(event.name));
+            m_events.push(event);
+        }
+        uint8_t reply[33];
+        reply[0] = 1;  // Player slot given to the client
+        put_string(reply + 1, m_name.c_str(), 32);
+        send_packet(PACKET_WELCOME, reply, sizeof(reply));
+        return;
+    }
+
+    if (!from_peer) return;
+
+    switch (type) {
+        case PACKET_WELCOME: {
+            if (m_is_host || m_welcomed || payload_size < 33) return;
+            m_welcomed = true;
+            TransportEvent event;
+            event.type = TransportEvent::Type::Welcomed;
+            event.player_id = payload[0] == SPECTATOR_SLOT ? -1 : payload[0];
+            get_string(event.name, payload + 1, sizeof(event.name));
+            m_events.push(event);
+            m_last_control = std::chrono::steady_clock::now() - CONTROL_INTERVAL;
+            break;
+        }
+
+        case PACKET_BYE: {
+            TransportEvent event;
+            event.type = TransportEvent::Type::PeerLeft;
+            event.player_id = m_is_host ? 1 : 0;
+            m_events.push(event);
+            m_has_peer = false;
+            break;
+        }
+
+        case PACKET_LOBBY: {
+            if (payload_size < LOBBY_SIZE) return;
+            LobbySnapshot lobby;
+            lobby.ready = payload[0] & 1;
+            lobby.started = (payload[0] >> 1) & 1;
+            lobby.rom_crc32 = get_u32(payload + 1);
+            lobby.game_selected = payload[5] != 0;
+            lobby.game_crc32 = get_u32(payload + 6);
+            get_string(lobby.game_name, payload + 10, sizeof(lobby.game_name));
+            get_string(lobby.platform, payload + 74, sizeof(lobby.platform));
+
+            std::lock_guard<std::mutex> lock(m_lobby_mutex);
+            m_remote_lobby = lobby;
+            m_remote_lobby_fresh = true;
+            break;
+        }
+
+        case PACKET_INPUT: {
+            if (payload_size < INPUT_HEADER_SIZE || m_spectating) return;
+            int player = payload[0];
+            int count = payload[1];
+            int bits = payload[2];
+            uint64_t first = get_u64(payload + 3);
+            if (player >= NETPLAY_MAX_PLAYERS || bits == 0 || bits > 32 ||
+                payload_size < INPUT_HEADER_SIZE + packed_size(static_cast<size_t>(count), bits)) {
+                return;
+            }
+
+            // Redundant copies of frames already delivered are dropped; a gap
+            // longer than the redundancy is skipped over
+            uint64_t& next = m_next_received[player];
+            for (int i = 0; i < count; i++) {
+                uint64_t frame = first + static_cast<uint64_t>(i);
+                if (frame < next) continue;
+                uint32_t buttons = unpack_input(payload + INPUT_HEADER_SIZE, static_cast<size_t>(i), bits);
+                NetplayInputFrame input = {frame, player, buttons, 0};
+                if (!m_inbound.push(input)) break;
+                next = frame + 1;
+            }
+            break;
+        }
+
+        case PACKET_STATE:
+            handle_state_chunk(payload, payload_size);
+            break;
+
+        case PACKET_CONFIRMED:
+            if (m_spectating) handle_confirmed(payload, payload_size);
+            break;
+
+        case PACKET_PING:
+            handle_ping(payload, payload_size);
+            break;
+
+        case PACKET_PONG:
+            handle_pong(payload, payload_size);
+            break;
+
+        case PACKET_STATE_ACK:
+            handle_state_ack(payload, payload_size);
+            break;
+
+        case PACKET_SYNC_HASH:
+        case PACKET_HASH_LOG_REQUEST:
+        case PACKET_HASH_LOG:
+            if (!m_spectating) handle_sync_check(type, payload, payload_size);
+            break;
+
+        case PACKET_STATE_REQUEST: {
+            if (payload_size >= 1 && (payload[0] & 1)) {
+                // The peer could not apply our delta: its base is gone
+                m_force_keyframe = true;
+            }
+            TransportEvent event;
+            event.type = TransportEvent::Type::StateRequested;
+            event.player_id = m_is_host ? 1 : 0;
+            m_events.push(event);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+// ============================================================================
+// Round-trip time
+// ============================================================================
+
+// Every LOSS_WINDOW pings, the share that went unanswered is one loss
+// sample. A pong still in flight at the boundary counts toward the next
+// window, so samples are noisy but the average holds.
+void UdpTransport::send_ping() {
+    if (m_pings_sent == LOSS_WINDOW) {
+        float sample = 1.0f - static_cast<float>(std::min(m_pongs_received, m_pings_sent)) / m_pings_sent;
+        {
+            std::lock_guard<std::mutex> lock(m_quality_mutex);
+            m_quality.loss += (sample - m_quality.loss) / 4.0f;
+        }
+        m_pings_sent = 0;
+        m_pongs_received = 0;
+    }
+    m_pings_sent++;
+
+    auto elapsed = std::chrono::steady_clock::now() - m_epoch;
+    uint8_t payload[16];
+    put_u64(payload, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+    put_u64(payload + 8, m_local_frame.load(std::memory_order_relaxed));
+    send_packet(PACKET_PING, payload, sizeof(payload));
+}
+
+void UdpTransport::handle_ping(const uint8_t* payload, size_t size) {
+    if (size < 16) return;
+    record_remote_frame(get_u64(payload + 8));
+
+    uint8_t reply[16];
+    std::memcpy(reply, payload, 8);
+    put_u64(reply + 8, m_local_frame.load(std::memory_order_relaxed));
+    send_packet(PACKET_PONG, reply, sizeof(reply));
+}
+
+// Smoothed as in TCP's retransmission timer (RFC 6298): the RTT with gain
+// 1/8 and its mean deviation with gain 1/4
+void UdpTransport::handle_pong(const uint8_t* payload, size_t size) {
+    if (size < 16) return;
+    auto elapsed = std::chrono::steady_clock::now() - m_epoch;
+    int64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    int64_t sent_us = static_cast<int64_t>(get_u64(payload));
+    if (sent_us > now_us) return;
+    float sample = static_cast<float>(now_us - sent_us) / 1000.0f;
+    m_pongs_received++;
+
+    {
+        std::lock_guard<std::mutex> lock(m_quality_mutex);
+        LinkQuality& q = m_quality;
+        if (!q.valid) {
+            q.rtt_ms = sample;
+            q.jitter_ms = sample / 2.0f;
+            q.valid = true;
+        } else {
+            float deviation = sample > q.rtt_ms ? sample - q.rtt_ms : q.rtt_ms - sample;
+            q.jitter_ms += (deviation - q.jitter_ms) / 4.0f;
+            q.rtt_ms += (sample - q.rtt_ms) / 8.0f;
+        }
+    }
+    record_remote_frame(get_u64(payload + 8));
+}
+
+void UdpTransport::record_remote_frame(uint64_t frame) {
+    std::lock_guard<std::mutex> lock(m_quality_mutex);
+    m_quality.remote_frame = frame;
+    m_quality.remote_frame_time = std::chrono::steady_clock::now();
+}
+
+// ============================================================================
+// State transfer
+// ============================================================================
+
+void UdpTransport::start_outgoing_state() {
+    {
+        std::lock_guard<std::mutex> lock(m_state_mutex);
+        if (!m_pending_fresh) return;
+        m_outgoing.raw.swap(m_pending_state);
+        m_outgoing.frame = m_pending_frame;
+        m_pending_fresh = false;
+    }
+
+    OutgoingState& out = m_outgoing;
+    out.active = true;
+    out.id = m_next_state_id++;
+    out.raw_size = static_cast<uint32_t>(out.raw.size());
+    out.checksum = state_checksum(out.raw);
+    if (m_sent_base_id != 0 && !m_force_keyframe && m_sent_base.size() == out.raw.size()) {
+        out.encoding = StateEncoding::Delta;
+        out.base_id = m_sent_base_id;
+        encode_delta(out.raw, m_sent_base, out.encoded);
+    } else {
+        out.encoding = StateEncoding::Keyframe;
+        out.base_id = 0;
+        encode_keyframe(out.raw, out.encoded);
+    }
+    m_force_keyframe = false;
+
+    out.chunk_count = static_cast<int>((out.encoded.size() + STATE_CHUNK_SIZE - 1) / STATE_CHUNK_SIZE);
+    if (out.chunk_count == 0) out.chunk_count = 1;
+    out.acked_count = 0;
+    out.acked.assign(static_cast<size_t>(out.chunk_count), 0);
+    out.sent_at.assign(static_cast<size_t>(out.chunk_count), std::chrono::steady_clock::time_point{});
+    m_state_progress.store(0.0f, std::memory_order_relaxed);
+}
+
+// Keep up to STATE_WINDOW chunks in flight, resending any whose ack is late
+void UdpTransport::service_outgoing_state(OutgoingState& out, const uint8_t* address, int address_len) {
+    if (!out.active) return;
+
+    auto now = std::chrono::steady_clock::now();
+    int in_flight = 0;
+    for (int i = 0; i < out.chunk_count; i++) {
+        if (out.acked[i]) continue;
+        if (out.sent_at[i] != std::chrono::steady_clock::time_point{} &&
+            now - out.sent_at[i] < STATE_RESEND_INTERVAL) {
+            in_flight++;
+        }
+    }
+
+    for (int i = 0; i < out.chunk_count && in_flight < STATE_WINDOW; i++) {
+        if (out.acked[i]) continue;
+        if (out.sent_at[i] != std::chrono::steady_clock::time_point{} &&
+            now - out.sent_at[i] < STATE_RESEND_INTERVAL) {
+            continue;
+        }
+        send_state_chunk(out, i, address, address_len);
+        out.sent_at[i] = now;
+        in_flight++;
+    }
+}
+
+void UdpTransport::send_state_chunk(const OutgoingState& out, int index, const uint8_t* address,
+                                    int address_len) {
+    size_t begin = static_cast<size_t>(index) * STATE_CHUNK_SIZE;
+    size_t length = std::min(STATE_CHUNK_SIZE, out.encoded.size() - std::min(begin, out.encoded.size()));
+
+    uint8_t payload[STATE_HEADER_SIZE + STATE_CHUNK_SIZE];
+    put_u32(payload, out.id);
+    put_u64(payload + 4, out.frame);
+    payload[12] = static_cast<uint8_t>(out.encoding);
+    put_u32(payload + 13, out.base_id);
+    put_u32(payload + 17, out.raw_size);
+    put_u32(payload + 21, out.checksum);
+    put_u32(payload + 25, static_cast<uint32_t>(out.encoded.size()));
+    put_u16(payload + 29, static_cast<uint16_t>(index));
+    put_u16(payload + 31, static_cast<uint16_t>(out.chunk_count));
+    if (length) std::memcpy(payload + STATE_HEADER_SIZE, out.encoded.data() + begin, length);
+    send_packet_to(address, address_len, PACKET_STATE, payload, STATE_HEADER_SIZE + length);
+}
+
+void UdpTransport::handle_state_ack(const uint8_t* payload, size_t size) {
+    OutgoingState& out = m_outgoing;
+    if (!apply_state_ack(out, payload, size)) return;
+
+    m_state_progress.store(static_cast<float>(out.acked_count) / out.chunk_count, std::memory_order_relaxed);
+    if (out.acked_count == out.chunk_count) {
+        // The peer now holds this state: later deltas are taken against it
+        m_sent_base.swap(out.raw);
+        m_sent_base_id = out.id;
+        out.active = false;
+        m_state_progress.store(-1.0f, std::memory_order_relaxed);
+    }
+}
+
+// Marks the chunks an ack covers. False if it is not for this transfer.
+bool UdpTransport::apply_state_ack(OutgoingState& out, const uint8_t* payload, size_t size) {
+    if (size < 14 || !out.active || get_u32(payload) != out.id) return false;
+
+    int in_order = std::min<int>(get_u16(payload + 4), out.chunk_count);
+    uint64_t bitmap = get_u64(payload + 6);
+    auto mark = [&](int index) {
+        if (index < out.chunk_count && !out.acked[index]) {
+            out.acked[index] = 1;
+            out.acked_count++;
+        }
+    };
+    for (int i = 0; i < in_order; i++) mark(i);
+    for (int bit = 0; bit < 64; bit++) {
+        if ((bitmap >> bit) & 1) mark(in_order + bit);
+    }
+    return true;
+}
+
+void UdpTransport::handle_state_chunk(const uint8_t* payload, size_t size) {
+    if (size < STATE_HEADER_SIZE) return;
+    IncomingState& in = m_incoming;
+
+    uint32_t id = get_u32(payload);
+    int index = get_u16(payload + 29);
+    int count = get_u16(payload + 31);
+    uint32_t encoded_size = get_u32(payload + 25);
+
+    if (id < in.id || (id == in.id && in.complete)) {
+        // Already have it; our ack was probably lost
+        if (id == in.id) in.ack_due = true;
+        return;
+    }
+
+    if (id != in.id) {
+        // A new transfer replaces whatever was in progress
+        if (count == 0 || encoded_size > static_cast<uint32_t>(count) * STATE_CHUNK_SIZE ||
+            get_u32(payload + 17) > MAX_STATE_SIZE) {
+            return;
+        }
+        in = {};
+        in.id = id;
+        in.frame = get_u64(payload + 4);
+        in.encoding = payload[12] == 1 ? StateEncoding::Delta : StateEncoding::Keyframe;
+        in.base_id = get_u32(payload + 13);
+        in.raw_size = get_u32(payload + 17);
+        in.checksum = get_u32(payload + 21);
+        in.encoded.assign(encoded_size, 0);
+        in.received.assign(static_cast<size_t>(count), 0);
+        in.chunk_count = count;
+    }
+
+    in.ack_due = true;
+    if (index >= in.chunk_count || in.received[index]) return;
+
+    size_t begin = static_cast<size_t>(index) * STATE_CHUNK_SIZE;
+    size_t length = size - STATE_HEADER_SIZE;
+    if (begin + length > in.encoded.size()) return;
+    std::memcpy(in.encoded.data() + begin, payload + STATE_HEADER_SIZE, length);
+    in.received[index] = 1;
+    in.received_count++;
+    m_state_progress.store(static_cast<float>(in.received_count) / in.chunk_count, std::memory_order_relaxed);
+
+    if (in.received_count == in.chunk_count) finish_incoming_state();
+}
+
+void UdpTransport::finish_incoming_state() {
+    IncomingState& in = m_incoming;
+    in.complete = true;
+    m_state_progress.store(-1.0f, std::memory_order_relaxed);
+
+    std::vector<uint8_t> state;
+    bool base_ok = in.encoding == StateEncoding::Keyframe || in.base_id == m_received_base_id;
+    if (!base_ok || !decode_state(in.encoding, in.encoded, in.raw_size, m_received_base, state) ||
+        state_checksum(state) != in.checksum) {
+        send_state_request(true);
+        return;
+    }
+
+    m_received_base = state;
+    m_received_base_id = in.id;
+    in.encoded = {};
+
+    // Confirmed inputs are wanted from the state's frame on
+    if (m_spectating) {
+        m_confirmed_synced = true;
+        m_next_confirmed = in.frame;
+        m_confirmed_seen = in.frame;
+    }
+
+    std::lock_guard<std::mutex> lock(m_state_mutex);
+    m_ready_state.swap(state);
+    m_ready_frame = in.frame;
+    m_ready_fresh = true;
+}
+
+void UdpTransport::send_state_ack() {
+    IncomingState& in = m_incoming;
+    in.ack_due = false;
+
+    int in_order = 0;
+    while (in_order < in.chunk_count && in.received[in_order]) in_order++;
+    uint64_t bitmap = 0;
+    for (int bit = 0; bit < 64 && in_order + bit < in.chunk_count; bit++) {
+        if (in.received[in_order + bit]) bitmap |= uint64_t{1} << bit;
+    }
+
+    uint8_t payload[14];
+    put_u32(payload, in.id);
+    put_u16(payload + 4, static_cast<uint16_t>(in_order));
+    put_u64(payload + 6, bitmap);
+    send_packet(PACKET_STATE_ACK, payload, sizeof(payload));
+}
+
+void UdpTransport::send_state_request(bool keyframe) {
+    if (!m_has_peer) return;
+    uint8_t flags = keyframe ? 1 : 0;
+    send_packet(PACKET_STATE_REQUEST, &flags, 1);
+}
+
+// ============================================================================
+// Spectators
+// ============================================================================
+
+int UdpTransport::find_spectator(const void* from) const {
+    const auto& from_addr = *static_cast<const sockaddr_storage*>(from);
+    for (int i = 0; i < MAX_SPECTATORS; i++) {
+        if (m_spectators[i].active && same_address(from_addr, m_spectators[i].address)) return i;
+    }
+    return -1;
+}
+
+// Host: anything not from the player peer
+void UdpTransport::handle_spectator_datagram(uint8_t type, const uint8_t* payload, size_t size,
+                                             const void* from, int from_len) {
+    int index = find_spectator(from);
+
+    if (type == PACKET_SPECTATE) {
+        if (size < 32) return;
+        if (index < 0) {
+            if (m_spectator_count.load(std::memory_order_relaxed) >= m_spectator_limit.load(std::memory_order_relaxed)) {
+                return;
+            }
+            for (index = 0; index < MAX_SPECTATORS && m_spectators[index].active; index++) {}
+            if (index == MAX_SPECTATORS) return;
+
+            Spectator& joined = m_spectators[index];
+            joined = {};
+            joined.active = true;
+            std::memcpy(joined.address, from, static_cast<size_t>(from_len));
+            joined.address_len = from_len;
+            get_string(joined.name, payload, sizeof(joined.name));
+            joined.needs_state = true;
+            m_spectator_count.fetch_add(1, std::memory_order_relaxed);
+
+            TransportEvent event;
+            event.type = TransportEvent::Type::SpectatorJoined;
+            event.player_id = index;
+            std::memcpy(event.name, joined.name, sizeof(event.name));
+            m_events.push(event);
+        }
+
+        // Answered every time, so a lost welcome is made up for
+        Spectator& spectator = m_spectators[index];
+        spectator.last_heard = std::chrono::steady_clock::now();
+        uint8_t reply[33];
+        reply[0] = SPECTATOR_SLOT;
+        put_string(reply + 1, m_name.c_str(), 32);
+        send_packet_to(spectator.address, spectator.address_len, PACKET_WELCOME, reply, sizeof(reply));
+        return;
+    }
+
+    if (index < 0) return;
+    Spectator& spectator = m_spectators[index];
+    spectator.last_heard = std::chrono::steady_clock::now();
+
+    switch (type) {
+        case PACKET_BYE:
+            drop_spectator(index);
+            break;
+
+        case PACKET_STATE_ACK:
+            if (apply_state_ack(spectator.state, payload, size) &&
+                spectator.state.acked_count == spectator.state.chunk_count) {
+                spectator.state = {};
+            }
+            break;
+
+        case PACKET_CONFIRMED_RESEND: {
+            if (size < 8 || spectator.needs_state || spectator.state.active) break;
+            uint64_t first = get_u64(payload);
+            if (first >= m_confirmed_next - static_cast<uint64_t>(m_confirmed_stored)) {
+                send_confirmed(spectator, first);
+                break;
+            }
+            // Fell behind the history: start over from a new state
+            [[fallthrough]];
+        }
+
+        case PACKET_STATE_REQUEST: {
+            // Its request can beat the ack finishing the transfer it failed on
+            spectator.state = {};
+            if (spectator.needs_state) break;
+            spectator.needs_state = true;
+            TransportEvent event;
+            event.type = TransportEvent::Type::SpectatorStateNeeded;
+            event.player_id = index;
+            m_events.push(event);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void UdpTransport::drop_spectator(int index) {
+    TransportEvent event;
+    event.type = TransportEvent::Type::SpectatorLeft;
+    event.player_id = index;
+    std::memcpy(event.name, m_spectators[index].name, sizeof(event.name));
+    m_events.push(event);
+
+    m_spectators[index] = {};
+    m_spectator_count.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void UdpTransport::expire_spectators() {
+    auto now = std::chrono::steady_clock::now();
+    for (int i = 0; i < MAX_SPECTATORS; i++) {
+        if (m_spectators[i].active && now - m_spectators[i].last_heard > SPECTATOR_TIMEOUT) {
+            drop_spectator(i);
+        }
+    }
+}
+
+// Encode the pending spectator state once and start it towards every
+// spectator waiting for one
+void UdpTransport::start_spectator_states() {
+    OutgoingState out;
+    {
+        std::lock_guard<std::mutex> lock(m_state_mutex);
+        if (!m_pending_spectator_fresh) return;
+        out.raw.swap(m_pending_spectator_state);
+        out.frame = m_pending_spectator_frame;
+        m_pending_spectator_fresh = false;
+    }
+
+    bool waiting = false;
+    for (const Spectator& spectator : m_spectators) waiting |= spectator.active && spectator.needs_state;
+    if (!waiting) return;
+
+    out.active = true;
+    out.encoding = StateEncoding::Keyframe;
+    out.raw_size = static_cast<uint32_t>(out.raw.size());
+    out.checksum = state_checksum(out.raw);
+    encode_keyframe(out.raw, out.encoded);
+    out.raw = {};
+    out.chunk_count = static_cast<int>((out.encoded.size() + STATE_CHUNK_SIZE - 1) / STATE_CHUNK_SIZE);
+    if (out.chunk_count == 0) out.chunk_count = 1;
+    out.acked.assign(static_cast<size_t>(out.chunk_count), 0);
+    out.sent_at.assign(static_cast<size_t>(out.chunk_count), std::chrono::steady_clock::time_point{});
+
+    for (Spectator& spectator : m_spectators) {
+        if (!spectator.active || !spectator.needs_state) continue;
+        spectator.needs_state = false;
+        spectator.state = out;
+        spectator.state.id = m_next_state_id++;
+    }
+}
+
+// Move newly confirmed frames into the history and, once a batch is full
+// (or has waited long enough), send it to every spectator. The datagram
+// repeats the previous batch too, so one lost datagram costs nothing.
+void UdpTransport::flush_confirmed() {
+    ConfirmedFrame confirmed;
+    while (m_confirmed_out.pop(confirmed)) {
+        // Frames are queued in order; a jump restarts the history
+        if (m_confirmed_stored > 0 && confirmed.frame != m_confirmed_next) {
+            m_confirmed_stored = 0;
+            m_confirmed_unsent = 0;
+        }
+        m_confirmed_history[confirmed.frame % CONFIRMED_HISTORY] = confirmed;
+        m_confirmed_next = confirmed.frame + 1;
+        m_confirmed_stored = std::min(m_confirmed_stored + 1, CONFIRMED_HISTORY);
+        m_confirmed_unsent++;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (m_confirmed_unsent < SPECTATOR_BATCH &&
+        (m_confirmed_unsent == 0 || now - m_last_broadcast < CONFIRMED_FLUSH_INTERVAL)) {
+        return;
+    }
+    m_last_broadcast = now;
+
+    int count = std::min({m_confirmed_unsent + SPECTATOR_BATCH, m_confirmed_stored, confirmed_per_datagram()});
+    m_confirmed_unsent = 0;
+    if (m_spectator_count.load(std::memory_order_relaxed) == 0) return;
+
+    uint8_t payload[MAX_DATAGRAM - HEADER_SIZE];
+    size_t size = build_confirmed(payload, m_confirmed_next - static_cast<uint64_t>(count), count);
+    for (const Spectator& spectator : m_spectators) {
+        if (spectator.active) send_packet_to(spectator.address, spectator.address_len, PACKET_CONFIRMED, payload, size);
+    }
+}
+
+// Frames from first on, as many as the history has and a datagram holds
+void UdpTransport::send_confirmed(Spectator& spectator, uint64_t first) {
+    if (first >= m_confirmed_next) return;
+    int count = static_cast<int>(std::min<uint64_t>(m_confirmed_next - first, confirmed_per_datagram()));
+    uint8_t payload[MAX_DATAGRAM - HEADER_SIZE];
+    size_t size = build_confirmed(payload, first, count);
+    send_packet_to(spectator.address, spectator.address_len, PACKET_CONFIRMED, payload, size);
+}
+
+// Frames of confirmed input that fit one datagram
+int UdpTransport::confirmed_per_datagram() const {
+    size_t players = static_cast<size_t>(std::max(m_confirmed_history[(m_confirmed_next - 1) % CONFIRMED_HISTORY].player_count, 1));
+    size_t bits = static_cast<size_t>(m_input_bits.load(std::memory_order_relaxed));
+    return static_cast<int>(std::min<size_t>((MAX_DATAGRAM - HEADER_SIZE - INPUT_HEADER_SIZE) * 8 / (players * bits), 255));
+}
+
+size_t UdpTransport::build_confirmed(uint8_t* payload, uint64_t first, int count) const {
+    int players = m_confirmed_history[first % CONFIRMED_HISTORY].player_count;
+    int bits = m_input_bits.load(std::memory_order_relaxed);
+    payload[0] = static_cast<uint8_t>(players);
+    payload[1] = static_cast<uint8_t>(count);
+    payload[2] = static_cast<uint8_t>(bits);
+    put_u64(payload + 3, first);
+
+    uint32_t buttons[255 * NETPLAY_MAX_PLAYERS];
+    size_t values = 0;
+    for (int i = 0; i < count; i++) {
+        const ConfirmedFrame& frame = m_confirmed_history[(first + static_cast<uint64_t>(i)) % CONFIRMED_HISTORY];
+        for (int p = 0; p < players; p++) buttons[values++] = frame.buttons[p];
+    }
+    pack_inputs(payload + INPUT_HEADER_SIZE, buttons, values, bits);
+    return INPUT_HEADER_SIZE + packed_size(values, bits);
+}
+
+// Spectator: deliver frames in order; a gap is asked for again rather than
+// skipped, since without rollback every frame must be exact
+void UdpTransport::handle_confirmed(const uint8_t* payload, size_t size) {
+    if (size < INPUT_HEADER_SIZE || !m_confirmed_synced) return;
+    int players = payload[0];
+    int count = payload[1];
+    int bits = payload[2];
+    uint64_t first = get_u64(payload + 3);
+    if (players == 0 || players > NETPLAY_MAX_PLAYERS || bits == 0 || bits > 32 ||
+        size < INPUT_HEADER_SIZE + packed_size(static_cast<size_t>(count) * players, bits)) {
+        return;
+    }
+    m_relayed_players.store(players, std::memory_order_release);
+
+    for (int i = 0; i < count; i++) {
+        uint64_t frame = first + static_cast<uint64_t>(i);
+        if (frame < m_next_confirmed) continue;
+        if (frame > m_next_confirmed) break;
+
+        // Held back until playback gets closer; asked for again then
+        if (frame >= m_local_frame.load(std::memory_order_relaxed) + SPECTATOR_LOOKAHEAD ||
+            m_inbound.size() + players > 256) {
+            break;
+        }
+
+        size_t index = static_cast<size_t>(i) * players;
+        for (int p = 0; p < players; p++) {
+            m_inbound.push({frame, p, unpack_input(payload + INPUT_HEADER_SIZE, index + p, bits), 0});
+        }
+        m_next_confirmed++;
+    }
+
+    m_confirmed_seen = std::max(m_confirmed_seen, first + static_cast<uint64_t>(count));
+    request_confirmed_gap();
+}
+
+// Also called from the network loop, so a lost resend is asked for again
+// even once the host has nothing new to send
+void UdpTransport::request_confirmed_gap() {
+    auto now = std::chrono::steady_clock::now();
+    if (m_confirmed_seen <= m_next_confirmed || now - m_last_resend_request < CONFIRMED_RESEND_INTERVAL) return;
+    m_last_resend_request = now;
+    uint8_t request[8];
+    put_u64(request, m_next_confirmed);
+    send_packet(PACKET_CONFIRMED_RESEND, request, sizeof(request));
+}
+
+void UdpTransport::flush_inputs() {
+    OutboundInput input;
+    while (m_outbound.pop(input)) {
+        SentHistory& history = m_sent[input.player];
+
+        // Frames are queued in order; a jump restarts the history
+        if (history.count > 0 && input.frame != history.next_frame) history.count = 0;
+        if (history.count == INPUT_REDUNDANCY) {
+            std::copy(history.buttons.begin() + 1, history.buttons.end(), history.buttons.begin());
+            history.count--;
+        }
+        history.buttons[history.count++] = input.buttons;
+        history.next_frame = input.frame + 1;
+
+        if (!m_has_peer || (!m_is_host && !m_welcomed)) continue;
+
+        int bits = m_input_bits.load(std::memory_order_relaxed);
+        uint8_t payload[INPUT_HEADER_SIZE + INPUT_REDUNDANCY * 4];
+        payload[0] = static_cast<uint8_t>(input.player);
+        payload[1] = static_cast<uint8_t>(history.count);
+        payload[2] = static_cast<uint8_t>(bits);
+        put_u64(payload + 3, history.next_frame - static_cast<uint64_t>(history.count));
+        pack_inputs(payload + INPUT_HEADER_SIZE, history.buttons.data(), static_cast<size_t>(history.count), bits);
+        send_packet(PACKET_INPUT, payload, INPUT_HEADER_SIZE + packed_size(static_cast<size_t>(history.count), bits));
+    }
+}
+
+// To the peer and, from the host, to every spectator
+// ============================================================================
+// Desync checks
+// ============================================================================
+
+void UdpTransport::flush_sync_checks() {
+    SyncCheck check;
+    while (m_sync_out.pop(check)) {
+        if (!m_has_peer) continue;
+
+        uint8_t payload[14 + SyncCheck::MAX_VALUES * 8];
+        put_u64(payload, check.frame);
+        switch (check.type) {
+            case SyncCheck::Type::Hash:
+                put_u64(payload + 8, check.values[0]);
+                send_packet(PACKET_SYNC_HASH, payload, 16);
+                break;
+
+            case SyncCheck::Type::LogRequest:
+                payload[8] = static_cast<uint8_t>(std::clamp(check.count, 0, SyncCheck::MAX_FRAMES));
+                send_packet(PACKET_HASH_LOG_REQUEST, payload, 9);
+                break;
+
+            case SyncCheck::Type::Log: {
+                int count = std::clamp(check.count, 0, SyncCheck::MAX_FRAMES);
+                int components = std::clamp(check.components, 0, NETPLAY_MAX_HASH_COMPONENTS);
+                int values = count * (1 + components);
+                payload[8] = static_cast<uint8_t>(count);
+                payload[9] = static_cast<uint8_t>(components);
+                put_u32(payload + 10, check.valid);
+                for (int i = 0; i < values; i++) put_u64(payload + 14 + i * 8, check.values[i]);
+                send_packet(PACKET_HASH_LOG, payload, 14 + static_cast<size_t>(values) * 8);
+                break;
+            }
+        }
+    }
+}
+
+void UdpTransport::handle_sync_check(uint8_t type, const uint8_t* payload, size_t size) {
+    if (size < 9) return;
+    SyncCheck check;
+    check.frame = get_u64(payload);
+
+    if (type == PACKET_SYNC_HASH) {
+        if (size < 16) return;
+        check.type = SyncCheck::Type::Hash;
+        check.values[0] = get_u64(payload + 8);
+    } else if (type == PACKET_HASH_LOG_REQUEST) {
+        check.type = SyncCheck::Type::LogRequest;
+        check.count = std::min<int>(payload[8], SyncCheck::MAX_FRAMES);
+    } else {
+        if (size < 14) return;
+        check.type = SyncCheck::Type::Log;
+        check.count = payload[8];
+        check.components = payload[9];
+        check.valid = get_u32(payload + 10);
+        int values = check.count * (1 + check.components);
+        if (check.count > SyncCheck::MAX_FRAMES || check.components > NETPLAY_MAX_HASH_COMPONENTS ||
+            size < 14 + static_cast<size_t>(values) * 8) {
+            return;
+        }
+        for (int i = 0; i < values; i++) check.values[i] = get_u64(payload + 14 + i * 8);
+    }
+    m_sync_in.push(check);
+}
+
+void UdpTransport::send_lobby() {
+    if (!m_has_peer && m_spectator_count.load(std::memory_order_relaxed) == 0) return;
+
+    LobbySnapshot lobby;
+    {
+        std::lock_guard<std::mutex> lock(m_lobby_mutex);
+        lobby = m_local_lobby;
+    }
+
+    uint8_t payload[LOBBY_SIZE];
+    payload[0] = static_cast<uint8_t>((lobby.ready ? 1 : 0) | (lobby.started ? 2 : 0));
+    put_u32(payload + 1, lobby.rom_crc32);
+    payload[5] = lobby.game_selected ? 1 : 0;
+    put_u32(payload + 6, lobby.game_crc32);
+    put_string(payload + 10, lobby.game_name, sizeof(lobby.game_name));
+    put_string(payload + 74, lobby.platform, sizeof(lobby.platform));
+    if (m_has_peer) send_packet(PACKET_LOBBY, payload, sizeof(payload));
+    for (const Spectator& spectator : m_spectators) {
+        if (spectator.active) send_packet_to(spectator.address, spectator.address_len, PACKET_LOBBY, payload, sizeof(payload));
+    }
+}
+
+void UdpTransport::send_packet(uint8_t type, const uint8_t* payload, size_t size) {
+    send_packet_to(m_peer, m_peer_len, type, payload, size);
+}
+
+void UdpTransport::send_packet_to(const uint8_t* address, int address_len, uint8_t type,
+                                  const uint8_t* payload, size_t size) {
+    uint8_t datagram[MAX_DATAGRAM];
+    datagram[0] = MAGIC0;
+    datagram[1] = MAGIC1;
+    datagram[2] = PROTOCOL_VERSION;
+    datagram[3] = type;
+    if (size) std::memcpy(datagram + HEADER_SIZE, payload, size);
+
+    int sent = static_cast<int>(sendto(native(m_socket),
+                                       reinterpret_cast<const char*>(datagram),
+                                       static_cast<int>(HEADER_SIZE + size), 0,
+                                       reinterpret_cast<const sockaddr*>(address),
+                                       static_cast<socklen_t>(address_len)));
+    if (sent > 0) m_bytes_sent.fetch_add(static_cast<uint64_t>(sent), std::memory_order_relaxed);
+}
+
+} // namespace emu
@@ -0,0 +1,420 @@
+#pragma once
+
+#include "emu/netplay_plugin.hpp"
+#include "state_codec.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace emu {
+
+// Single-producer/single-consumer ring shared by the emulation thread and
+// the network thread. push() fails when full; nothing ever blocks.
+template <typename T, uint32_t Capacity>
+class SpscRing {
+public:
+    bool push(const T& item) {
+        uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == Capacity) return false;
+        m_items[tail % Capacity] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        uint32_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) return false;
+        item = m_items[head % Capacity];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    int size() const {
+        return static_cast<int>(m_tail.load(std::memory_order_acquire) -
+                                m_head.load(std::memory_order_acquire));
+    }
+
+    // Only while neither side is running
+    void clear() {
+        m_head.store(0, std::memory_order_relaxed);
+        m_tail.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::array<T, Capacity> m_items{};
+    std::atomic<uint32_t> m_head{0};
+    std::atomic<uint32_t> m_tail{0};
+};
+
+// Lobby state each side publishes to the other. It is resent periodically
+// rather than acknowledged, so a lost datagram only delays it.
+struct LobbySnapshot {
+    bool ready = false;
+    bool started = false;          // Host only: the game is running
+    uint32_t rom_crc32 = 0;        // Sender's loaded ROM, 0 if none
+    bool game_selected = false;    // Host only: game the session plays
+    uint32_t game_crc32 = 0;
+    char game_name[64] = {};
+    char platform[16] = {};
+};
+
+// Round-trip time and the peer's progress, measured by the network thread
+struct LinkQuality {
+    bool valid = false;             // At least one round trip measured
+    float rtt_ms = 0.0f;            // Smoothed round-trip time
+    float jitter_ms = 0.0f;         // Smoothed mean deviation of the RTT
+    float loss = 0.0f;              // Smoothed fraction of pings not answered
+    uint64_t remote_frame = 0;      // Peer's session frame when it last reported
+    std::chrono::steady_clock::time_point remote_frame_time;  // When that report arrived
+};
+
+// Desync check traffic with the peer. The emulation thread decides what to
+// send and compares what comes back; the transport only carries it.
+struct SyncCheck {
+    static constexpr int MAX_FRAMES = 16;
+    static constexpr int MAX_VALUES = MAX_FRAMES * (1 + NETPLAY_MAX_HASH_COMPONENTS);
+
+    enum class Type : uint8_t {
+        Hash,           // values[0]: hash of the state at the start of frame
+        LogRequest,     // Asks for the log of count frames from frame
+        Log             // count frames from frame, each the state hash then
+                        // `components` sub-hashes; bit i of valid is set if
+                        // frame + i is in the sender's log
+    };
+    Type type = Type::Hash;
+    uint64_t frame = 0;
+    int count = 0;
+    int components = 0;
+    uint32_t valid = 0;
+    std::array<uint64_t, MAX_VALUES> values{};
+};
+
+// Connection events raised by the network thread
+struct TransportEvent {
+    enum class Type {
+        PeerJoined,     // Host: a client said hello
+        Welcomed,       // Client: the host accepted us
+        PeerLeft,       // The peer said goodbye
+        StateRequested, // The peer asked for a save state (resync)
+        SpectatorJoined,        // Host: a spectator said hello
+        SpectatorLeft,          // Host: a spectator said goodbye or went quiet
+        SpectatorStateNeeded    // Host: a spectator needs a starting state
+    };
+    Type type = Type::PeerJoined;
+    int player_id = 0;              // -1: we are a spectator (Welcomed)
+    char name[32] = {};
+};
+
+// Non-blocking UDP transport between a host and one client, plus the
+// host's spectators
+//
+// All socket work happens on a dedicated network thread. The emulation
+// thread only pushes outbound inputs and pops received ones through
+// lock-free rings, so begin_frame/get_input never wait on the network.
+// Every input datagram repeats the sender's last INPUT_REDUNDANCY frames,
+// so a lost packet is covered by the next one without retransmission.
+//
+// Frames on the wire are session frames, counted from the start of the
+// game, not the core's frame counter.
+//
+// Save states travel over a separate reliable channel: the encoded state
+// is cut into STATE_CHUNK_SIZE chunks, at most STATE_WINDOW of them are
+// unacknowledged at a time, and lost chunks are resent after a timeout.
+// The first state is a compressed keyframe; later ones are deltas against
+// the last state the peer acknowledged. Encoding, decoding and chunking
+// all run on the network thread, so a large state never holds up a frame.
+//
+// The host also relays the game to spectators. They get a keyframe, then
+// only inputs every player has confirmed, SPECTATOR_BATCH frames to a
+// datagram. The host encodes each batch once and sends the same bytes to
+// every spectator; a spectator that misses one asks for the gap again.
+class UdpTransport {
+public:
+    static constexpr int INPUT_REDUNDANCY = 8;
+    static constexpr int MAX_SPECTATORS = 32;
+    static constexpr int SPECTATOR_BATCH = 4;
+    static constexpr int SPECTATOR_LOOKAHEAD = 64;  // Confirmed frames delivered past the local frame
+
+    UdpTransport();
+    ~UdpTransport();
+
+    UdpTransport(const UdpTransport&) = delete;
+    UdpTransport& operator=(const UdpTransport&) = delete;
+
+    // Bind the port and wait for a client's hello
+    bool start_host(uint16_t port, const char* name);
+
+    // Resolve the host and say hello until it answers with a welcome
+    bool start_client(const char* host_addr, uint16_t port, const char* name);
+
+    // As start_client, but watch only: no input is sent, and the inputs
+    // received are the host's confirmed ones for every player
+    bool start_spectator(const char* host_addr, uint16_t port, const char* name);
+
+    // Say goodbye to the peer and join the network thread
+    void stop();
+
+    bool is_running() const { return m_running.load(std::memory_order_acquire); }
+    const std::string& get_error() const { return m_error; }
+
+    // Emulation thread: queue a local player's input for a session frame
+    bool send_input(int player, uint64_t frame, uint32_t buttons);
+
+    // Emulation thread: width of the inputs on the wire. Buttons above it
+    // are dropped, so the core must not read them.
+    void set_input_bits(int bits);
+
+    // Emulation thread: next received input, in frame order per player
+    bool poll_input(NetplayInputFrame& input) { return m_inbound.pop(input); }
+
+    bool poll_event(TransportEvent& event) { return m_events.pop(event); }
+
+    // Lobby state to publish, and the newest one received from the peer
+    void set_local_lobby(const LobbySnapshot& lobby);
+    bool poll_remote_lobby(LobbySnapshot& lobby);
+
+    // Emulation thread: desync checks to and from the peer (players only)
+    bool send_sync_check(const SyncCheck& check) { return !m_spectating && m_sync_out.push(check); }
+    bool poll_sync_check(SyncCheck& check) { return m_sync_in.pop(check); }
+
+    // Fills the queue and byte counters
+    void fill_stats(NetplayStats& stats) const;
+
+    // Emulation thread: the session frame about to run, reported in pings
+    // (and, spectating, bounding how far ahead inputs are delivered)
+    void set_local_frame(uint64_t frame) { m_local_frame.store(frame, std::memory_order_relaxed); }
+
+    LinkQuality get_link_quality() const;
+
+    // Emulation thread: ship a save state taken at a session frame. A newer
+    // state replaces one still in flight.
+    void send_state(const std::vector<uint8_t>& state, uint64_t frame);
+
+    // Emulation thread: ask the peer for its current state
+    void request_state();
+
+    // Emulation thread: the newest state received in full
+    bool poll_state(std::vector<uint8_t>& state, uint64_t& frame);
+
+    // Fraction of the state transfer in progress either way, -1 if none
+    float get_state_progress() const { return m_state_progress.load(std::memory_order_relaxed); }
+
+    // Host: spectators accepted from now on (0 refuses them)
+    void set_spectator_limit(int count);
+    int get_spectator_count() const { return m_spectator_count.load(std::memory_order_relaxed); }
+
+    // Spectator: players in the relayed game, 0 until inputs arrive. Set
+    // before any of their inputs can be polled.
+    int get_relayed_player_count() const { return m_relayed_players.load(std::memory_order_acquire); }
+
+    // Emulation thread, host: a frame every player's input is confirmed
+    // for, queued in frame order for the spectators
+    bool broadcast_confirmed(uint64_t frame, const uint32_t* buttons, int player_count);
+
+    // Emulation thread, host: starting state for the spectators waiting on
+    // one. frame is the first one its confirmed inputs are needed from.
+    void send_spectator_state(const std::vector<uint8_t>& state, uint64_t frame);
+
+private:
+    struct OutboundInput {
+        int player = 0;
+        uint64_t frame = 0;
+        uint32_t buttons = 0;
+    };
+
+    // Local inputs already sent, resent with every later datagram
+    struct SentHistory {
+        std::array<uint32_t, INPUT_REDUNDANCY> buttons{};
+        uint64_t next_frame = 0;   // Frame after the newest entry
+        int count = 0;
+    };
+
+    struct ConfirmedFrame {
+        uint64_t frame = 0;
+        int player_count = 0;
+        std::array<uint32_t, NETPLAY_MAX_PLAYERS> buttons{};
+    };
+
+    bool start_remote(const char* host_addr, uint16_t port, const char* name, bool spectating);
+    bool open_socket(uint16_t port);
+    void close_socket();
+    void run();
+    void receive_datagrams();
+    void handle_datagram(const uint8_t* data, size_t size, const void* from, int from_len);
+    void flush_inputs();
+    void flush_sync_checks();
+    void handle_sync_check(uint8_t type, const uint8_t* payload, size_t size);
+    void send_lobby();
+    void send_packet(uint8_t type, const uint8_t* payload, size_t size);
+    void send_packet_to(const uint8_t* address, int address_len, uint8_t type,
+                        const uint8_t* payload, size_t size);
+
+    static constexpr size_t STATE_CHUNK_SIZE = 1024;
+    static constexpr int STATE_WINDOW = 32;
+
+    struct OutgoingState {
+        bool active = false;
+        uint32_t id = 0;
+        uint64_t frame = 0;
+        StateEncoding encoding = StateEncoding::Keyframe;
+        uint32_t base_id = 0;
+        uint32_t raw_size = 0;
+        uint32_t checksum = 0;
+        std::vector<uint8_t> raw;       // Becomes the delta base once acknowledged
+        std::vector<uint8_t> encoded;
+        std::vector<std::chrono::steady_clock::time_point> sent_at;  // Per chunk
+        std::vector<uint8_t> acked;     // Per chunk
+        int chunk_count = 0;
+        int acked_count = 0;
+    };
+
+    struct IncomingState {
+        uint32_t id = 0;                // 0: none yet
+        uint64_t frame = 0;
+        StateEncoding encoding = StateEncoding::Keyframe;
+        uint32_t base_id = 0;
+        uint32_t raw_size = 0;
+        uint32_t checksum = 0;
+        std::vector<uint8_t> encoded;
+        std::vector<uint8_t> received;  // Per chunk
+        int chunk_count = 0;
+        int received_count = 0;
+        bool complete = false;
+        bool ack_due = false;
+    };
+
+    // A spectator of the host
+    struct Spectator {
+        bool active = false;
+        alignas(8) uint8_t address[128] = {};
+        int address_len = 0;
+        char name[32] = {};
+        std::chrono::steady_clock::time_point last_heard;
+        bool needs_state = false;       // Waiting for a keyframe to start from
+        OutgoingState state;            // Always a keyframe
+    };
+
+    void start_outgoing_state();
+    void service_outgoing_state(OutgoingState& out, const uint8_t* address, int address_len);
+    void send_state_chunk(const OutgoingState& out, int index, const uint8_t* address, int address_len);
+    void handle_state_chunk(const uint8_t* payload, size_t size);
+    void handle_state_ack(const uint8_t* payload, size_t size);
+    bool apply_state_ack(OutgoingState& out, const uint8_t* payload, size_t size);
+    void finish_incoming_state();
+    void send_state_ack();
+    void send_state_request(bool keyframe);
+
+    void send_ping();
+    void handle_ping(const uint8_t* payload, size_t size);
+    void handle_pong(const uint8_t* payload, size_t size);
+    void record_remote_frame(uint64_t frame);
+
+    int find_spectator(const void* from) const;
+    void handle_spectator_datagram(uint8_t type, const uint8_t* payload, size_t size,
+                                   const void* from, int from_len);
+    void drop_spectator(int index);
+    void expire_spectators();
+    void start_spectator_states();
+    void flush_confirmed();
+    void send_confirmed(Spectator& spectator, uint64_t first);
+    int confirmed_per_datagram() const;
+    size_t build_confirmed(uint8_t* payload, uint64_t first, int count) const;
+    void handle_confirmed(const uint8_t* payload, size_t size);
+    void request_confirmed_gap();
+
+    // Socket handle: SOCKET on Windows, a descriptor elsewhere
+    intptr_t m_socket = -1;
+    bool m_is_host = false;
+    bool m_spectating = false;   // Client side of a spectator
+    std::string m_name;
+    std::string m_error;
+
+    // Peer address (a sockaddr_storage), set once known
+    alignas(8) uint8_t m_peer[128] = {};
+    int m_peer_len = 0;
+    bool m_has_peer = false;
+    bool m_welcomed = false;     // Client: welcome received
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_stop{false};
+
+    SpscRing<OutboundInput, 256> m_outbound;
+    SpscRing<NetplayInputFrame, 256> m_inbound;
+    SpscRing<TransportEvent, 16> m_events;
+    SpscRing<SyncCheck, 8> m_sync_out;
+    SpscRing<SyncCheck, 8> m_sync_in;
+
+    std::atomic<int> m_input_bits{32};
+    std::array<SentHistory, NETPLAY_MAX_PLAYERS> m_sent;
+    std::array<uint64_t, NETPLAY_MAX_PLAYERS> m_next_received{};  // Next frame expected per player
+
+    std::mutex m_lobby_mutex;
+    LobbySnapshot m_local_lobby;
+    LobbySnapshot m_remote_lobby;
+    bool m_remote_lobby_fresh = false;
+    std::chrono::steady_clock::time_point m_last_control;
+
+    std::atomic<uint64_t> m_bytes_sent{0};
+    std::atomic<uint64_t> m_bytes_received{0};
+
+    std::atomic<uint64_t> m_local_frame{0};
+    mutable std::mutex m_quality_mutex;
+    LinkQuality m_quality;
+    std::chrono::steady_clock::time_point m_epoch;   // Ping timestamps count from here
+    std::chrono::steady_clock::time_point m_last_ping;
+    int m_pings_sent = 0;        // In the current loss window, network thread only
+    int m_pongs_received = 0;
+
+    // State handoff with the emulation thread. Rare and large, so a mutex
+    // rather than a ring.
+    std::mutex m_state_mutex;
+    std::vector<uint8_t> m_pending_state;
+    uint64_t m_pending_frame = 0;
+    bool m_pending_fresh = false;
+    std::vector<uint8_t> m_ready_state;
+    uint64_t m_ready_frame = 0;
+    bool m_ready_fresh = false;
+    std::atomic<bool> m_state_request{false};
+    std::atomic<float> m_state_progress{-1.0f};
+
+    // Network thread only
+    OutgoingState m_outgoing;
+    IncomingState m_incoming;
+    uint32_t m_next_state_id = 1;
+    std::vector<uint8_t> m_sent_base;        // Last state the peer acknowledged
+    uint32_t m_sent_base_id = 0;
+    bool m_force_keyframe = false;
+    std::vector<uint8_t> m_received_base;    // Last state decoded from the peer
+    uint32_t m_received_base_id = 0;
+
+    // Host: spectators and the confirmed inputs relayed to them
+    static constexpr int CONFIRMED_HISTORY = 512;
+    std::atomic<int> m_spectator_limit{0};
+    std::atomic<int> m_spectator_count{0};
+    SpscRing<ConfirmedFrame, 256> m_confirmed_out;
+    std::vector<uint8_t> m_pending_spectator_state;   // Under m_state_mutex
+    uint64_t m_pending_spectator_frame = 0;
+    bool m_pending_spectator_fresh = false;
+    std::array<Spectator, MAX_SPECTATORS> m_spectators;       // Network thread only
+    std::array<ConfirmedFrame, CONFIRMED_HISTORY> m_confirmed_history;
+    uint64_t m_confirmed_next = 0;      // Frame after the newest in the history
+    int m_confirmed_stored = 0;
+    int m_confirmed_unsent = 0;
+    std::chrono::steady_clock::time_point m_last_broadcast;
+
+    // Spectator: the next confirmed frame expected, once a state has set it
+    bool m_confirmed_synced = false;
+    uint64_t m_next_confirmed = 0;
+    uint64_t m_confirmed_seen = 0;      // Frame after the newest the host has sent
+    std::atomic<int> m_relayed_players{0};
+    std::chrono::steady_clock::time_point m_last_resend_request;
+};
+
+} // namespace emu
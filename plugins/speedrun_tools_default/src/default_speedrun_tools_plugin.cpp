@@ -200,7 +200,12 @@ public:
     // ============================================================
 
     void on_frame() override {
-        // Timer updates are handled by get_current_time_ms() using wall clock
+        // Timer updates are handled by get_current_time_ms() using wall clock;
+        // per frame there's only the lag count
+        if (m_host) {
+            double fps = m_host->get_fps();
+            m_timer.on_frame(m_host->is_lag_frame(), fps > 0.0 ? 1000.0 / fps : 0.0);
+        }
     }
 
     void on_split_triggered() override {
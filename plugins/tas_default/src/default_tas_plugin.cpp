@@ -1,8 +1,16 @@
 #include "emu/tas_plugin.hpp"
+#include "edit_history.hpp"
+#include "greenzone.hpp"
+#include "greenzone_worker.hpp"
+#include "input_search.hpp"
+#ifdef VELOCE_TAS_LUA
+#include "lua_script.hpp"
+#endif
+#include "movie_file.hpp"
+#include "movie_verifier.hpp"
 #include <fstream>
 #include <cstring>
 #include <algorithm>
-#include <deque>
 #include <map>
 
 namespace {
@@ -32,6 +40,9 @@ public:
     }
 
     void shutdown() override {
+#ifdef VELOCE_TAS_LUA
+        m_lua.unload();
+#endif
         close_movie();
         m_host = nullptr;
     }
@@ -53,6 +64,9 @@ public:
         }
 
         m_frames.clear();
+        clear_lag();
+        rekey_greenzone();
+        attach_greenzone_spill();
         m_movie_loaded = true;
         m_mode = emu::TASMode::Recording;
 
@@ -62,36 +76,16 @@ public:
     bool open_movie(const char* filename) override {
         close_movie();
 
-        std::ifstream file(filename, std::ios::binary);
-        if (!file) return false;
+        bool imported = false;
+        if (!emu::load_movie(filename, m_info, m_start_state, m_frames, &imported)) return false;
+        clear_lag();
+        rekey_greenzone();
 
-        // Read header
-        char magic[4];
-        file.read(magic, 4);
-        if (std::strncmp(magic, "TAS1", 4) != 0) {
-            return load_fm2(filename);  // Try FM2 format
-        }
-
-        file.read(reinterpret_cast<char*>(&m_info), sizeof(m_info));
-
-        // Read start state if present
-        if (m_info.starts_from_savestate) {
-            uint32_t state_size;
-            file.read(reinterpret_cast<char*>(&state_size), sizeof(state_size));
-            m_start_state.resize(state_size);
-            file.read(reinterpret_cast<char*>(m_start_state.data()), state_size);
-        }
-
-        // Read frames
-        m_frames.resize(m_info.frame_count);
-        for (uint64_t i = 0; i < m_info.frame_count; i++) {
-            file.read(reinterpret_cast<char*>(&m_frames[i]), sizeof(emu::TASFrameData));
-        }
-
-        m_filename = filename;
+        // An FM2 import is saved with save_movie_as(), never over the .fm2
+        m_filename = imported ? std::string() : std::string(filename);
+        attach_greenzone_spill();
         m_movie_loaded = true;
         m_mode = emu::TASMode::Stopped;
-
         return true;
     }
 
@@ -102,39 +96,26 @@ public:
     bool save_movie_as(const char* filename) override {
         if (!m_movie_loaded) return false;
 
-        std::ofstream file(filename, std::ios::binary);
-        if (!file) return false;
-
-        // Update frame count
         m_info.frame_count = m_frames.size();
+        if (!emu::MovieFile::save(filename, m_info, m_start_state, m_frames)) return false;
 
-        // Write header
-        file.write("TAS1", 4);
-        file.write(reinterpret_cast<const char*>(&m_info), sizeof(m_info));
-
-        // Write start state if present
-        if (m_info.starts_from_savestate) {
-            uint32_t state_size = static_cast<uint32_t>(m_start_state.size());
-            file.write(reinterpret_cast<const char*>(&state_size), sizeof(state_size));
-            file.write(reinterpret_cast<const char*>(m_start_state.data()), state_size);
-        }
-
-        // Write frames
-        for (const auto& frame : m_frames) {
-            file.write(reinterpret_cast<const char*>(&frame), sizeof(emu::TASFrameData));
-        }
-
+        // The states saved with it spare the next session the replay
         m_filename = filename;
+        attach_greenzone_spill();
+        m_greenzone.persist();
         return true;
     }
 
     void close_movie() override {
+        m_search.cancel();
+        m_verifier.cancel();
+        m_worker.stop();
         m_frames.clear();
         m_start_state.clear();
         m_greenzone.clear();
         m_markers.clear();
-        m_undo_stack.clear();
-        m_redo_stack.clear();
+        m_history.clear();
+        clear_lag();
         m_movie_loaded = false;
         m_mode = emu::TASMode::Stopped;
         m_current_frame = 0;
@@ -165,6 +146,8 @@ public:
         m_host->reset_emulator();
         m_current_frame = 0;
         m_frames.clear();
+        clear_lag();
+        rekey_greenzone();
     }
 
     void stop_recording() override {
@@ -177,6 +160,7 @@ public:
 
         m_mode = emu::TASMode::Playing;
         m_current_frame = 0;
+        m_ran_frame = NO_FRAME;
 
         if (m_info.starts_from_savestate && !m_start_state.empty()) {
             m_host->load_state_from_buffer(m_start_state);
@@ -190,8 +174,18 @@ public:
     }
 
     uint32_t on_frame(int controller) override {
+#ifdef VELOCE_TAS_LUA
+        // Scripts see the memory the last frame left, with or without a movie
+        if (controller == 0) m_lua.on_frame(m_host->get_current_frame());
+#endif
         if (!m_movie_loaded) return 0;
 
+        // The core has finished the frame it was given last time
+        if (controller == 0 && m_ran_frame != NO_FRAME) {
+            record_lag(m_ran_frame, m_host->is_lag_frame());
+            m_ran_frame = NO_FRAME;
+        }
+
         uint32_t input = 0;
 
         switch (m_mode) {
@@ -206,15 +200,15 @@ public:
                         frame.controller_inputs[i] = m_host->get_controller_input(i);
                     }
                     m_frames.push_back(frame);
+                    m_greenzone.movie_changed(m_frames, m_frames.size() - 1);
+                    m_ran_frame = m_current_frame;
                     m_current_frame++;
 
-                    // Save greenzone periodically
-                    if (m_current_frame % 60 == 0) {
-                        std::vector<uint8_t> state;
-                        if (m_host->save_state_to_buffer(state)) {
-                            m_greenzone[m_current_frame] = std::move(state);
-                        }
-                    }
+                    // The recording head is the cursor, so this keeps
+                    // every frame until it falls behind into sparser tiers
+                    m_greenzone.set_cursor(m_current_frame);
+                    capture_greenzone(m_current_frame);
+                    m_worker.collect(m_greenzone);
                 }
                 break;
             }
@@ -224,6 +218,7 @@ public:
                 if (m_current_frame < m_frames.size()) {
                     input = m_frames[m_current_frame].controller_inputs[controller];
                     if (controller == 0) {
+                        m_ran_frame = m_current_frame;
                         m_current_frame++;
                     }
                 } else {
@@ -237,6 +232,7 @@ public:
                 if (m_current_frame < m_frames.size()) {
                     input = m_frames[m_current_frame].controller_inputs[controller];
                     if (controller == 0) {
+                        m_ran_frame = m_current_frame;
                         m_current_frame++;
                     }
                 }
@@ -257,108 +253,122 @@ public:
         return {};
     }
 
+    uint64_t get_frames(uint64_t start, uint64_t count, emu::TASFrameData* out) const override {
+        if (start >= m_frames.size()) return 0;
+        count = std::min<uint64_t>(count, m_frames.size() - start);
+        std::copy_n(m_frames.begin() + start, count, out);
+        return count;
+    }
+
     void set_frame(uint64_t frame, const emu::TASFrameData& data) override {
         if (frame < m_frames.size()) {
-            save_undo_state();
-            m_frames[frame] = data;
+            m_history.paint(m_frames, frame, data);
             invalidate_greenzone(frame);
         }
     }
 
     void insert_frame(uint64_t after_frame) override {
-        save_undo_state();
-        emu::TASFrameData new_frame{};
-        new_frame.frame_number = after_frame + 1;
-        if (after_frame < m_frames.size()) {
-            m_frames.insert(m_frames.begin() + after_frame + 1, new_frame);
-        } else {
-            m_frames.push_back(new_frame);
-        }
-        // Renumber frames
-        for (uint64_t i = after_frame + 1; i < m_frames.size(); i++) {
-            m_frames[i].frame_number = i;
-        }
+        uint64_t at = std::min<uint64_t>(after_frame + 1, m_frames.size());
+        m_history.replace(m_frames, at, 0, {emu::TASFrameData{}});
         invalidate_greenzone(after_frame);
     }
 
     void delete_frame(uint64_t frame) override {
         if (frame < m_frames.size()) {
-            save_undo_state();
-            m_frames.erase(m_frames.begin() + frame);
-            // Renumber frames
-            for (uint64_t i = frame; i < m_frames.size(); i++) {
-                m_frames[i].frame_number = i;
-            }
+            m_history.replace(m_frames, frame, 1, {});
             invalidate_greenzone(frame);
         }
     }
 
     void clear_input(uint64_t start_frame, uint64_t end_frame) override {
-        save_undo_state();
-        for (uint64_t i = start_frame; i <= end_frame && i < m_frames.size(); i++) {
+        if (start_frame >= m_frames.size() || end_frame < start_frame) return;
+        uint64_t end = std::min<uint64_t>(end_frame + 1, m_frames.size());
+        std::vector<emu::TASFrameData> cleared(m_frames.begin() + start_frame, m_frames.begin() + end);
+        for (auto& frame : cleared) {
             for (int c = 0; c < 4; c++) {
-                m_frames[i].controller_inputs[c] = 0;
+                frame.controller_inputs[c] = 0;
             }
         }
+        m_history.replace(m_frames, start_frame, end - start_frame, std::move(cleared));
         invalidate_greenzone(start_frame);
     }
 
     void undo() override {
-        if (!m_undo_stack.empty()) {
-            m_redo_stack.push_back(m_frames);
-            m_frames = m_undo_stack.back();
-            m_undo_stack.pop_back();
-        }
+        uint64_t changed_from = 0;
+        if (m_history.undo(m_frames, changed_from)) invalidate_greenzone(changed_from);
     }
 
     void redo() override {
-        if (!m_redo_stack.empty()) {
-            m_undo_stack.push_back(m_frames);
-            m_frames = m_redo_stack.back();
-            m_redo_stack.pop_back();
-        }
+        uint64_t changed_from = 0;
+        if (m_history.redo(m_frames, changed_from)) invalidate_greenzone(changed_from);
     }
 
     bool can_undo() const override {
-        return !m_undo_stack.empty();
+        return m_history.can_undo();
     }
 
     bool can_redo() const override {
-        return !m_redo_stack.empty();
+        return m_history.can_redo();
     }
 
     void increment_rerecord_count() override {
         m_info.rerecord_count++;
     }
 
+    // States after the edit stay stored under the old inputs, for an undo
+    // or another branch with the same prefix to find again
     void invalidate_greenzone(uint64_t from_frame) override {
-        auto it = m_greenzone.lower_bound(from_frame);
-        while (it != m_greenzone.end()) {
-            it = m_greenzone.erase(it);
+        // States the worker already has from before the edit still hold
+        m_worker.cancel(from_frame);
+        m_worker.collect(m_greenzone);
+        m_greenzone.movie_changed(m_frames, from_frame);
+        refill_greenzone(from_frame);
+
+        // Lag past the edit is unknown until those frames run again
+        if (from_frame < m_lag.size()) {
+            m_lag.resize(from_frame);
+            m_lag_revision++;
         }
     }
 
     bool has_greenzone_at(uint64_t frame) const override {
-        return m_greenzone.count(frame) > 0;
+        return m_greenzone.has(frame);
+    }
+
+    void get_greenzone_presence(uint64_t start, uint64_t count, uint8_t* bits) const override {
+        m_greenzone.get_presence(start, count, bits);
+    }
+
+    uint64_t get_greenzone_revision() const override {
+        return m_greenzone.get_revision();
+    }
+
+    void get_lag_frames(uint64_t start, uint64_t count, uint8_t* bits) const override {
+        for (uint64_t i = 0; i < (count + 7) / 8; i++) bits[i] = 0;
+        for (uint64_t i = 0; i < count && start + i < m_lag.size(); i++) {
+            if (m_lag[start + i]) bits[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+        }
+    }
+
+    uint64_t get_lag_revision() const override {
+        return m_lag_revision;
     }
 
     bool seek_to_frame(uint64_t frame) override {
         if (frame >= m_frames.size()) return false;
 
         // Find closest greenzone state before target
-        auto it = m_greenzone.upper_bound(frame);
-        if (it != m_greenzone.begin()) {
-            --it;
-            if (m_host->load_state_from_buffer(it->second)) {
-                m_current_frame = it->first;
+        m_greenzone.set_cursor(frame);
+        m_worker.set_cursor(frame);
+        m_worker.collect(m_greenzone);
+        m_ran_frame = NO_FRAME;
+        uint64_t found = 0;
+        std::vector<uint8_t> state;
+        if (m_greenzone.find_before(frame, found, state)) {
+            if (m_host->load_state_from_buffer(state)) {
+                m_current_frame = found;
                 // Play forward to target frame
-                while (m_current_frame < frame) {
-                    for (int c = 0; c < 4; c++) {
-                        m_host->set_controller_input(c, m_frames[m_current_frame].controller_inputs[c]);
-                    }
-                    m_host->frame_advance();
-                    m_current_frame++;
-                }
+                replay_to_frame(frame);
                 increment_rerecord_count();
                 return true;
             }
@@ -371,13 +381,7 @@ public:
             m_host->reset_emulator();
         }
         m_current_frame = 0;
-        while (m_current_frame < frame) {
-            for (int c = 0; c < 4; c++) {
-                m_host->set_controller_input(c, m_frames[m_current_frame].controller_inputs[c]);
-            }
-            m_host->frame_advance();
-            m_current_frame++;
-        }
+        replay_to_frame(frame);
         increment_rerecord_count();
         return true;
     }
@@ -400,28 +404,102 @@ public:
     }
 
     void cut_selection() override {
+        if (m_selection_start >= m_frames.size() || m_selection_end < m_selection_start) return;
         copy_selection();
-        save_undo_state();
-        m_frames.erase(m_frames.begin() + m_selection_start,
-                       m_frames.begin() + std::min(m_selection_end + 1, (uint64_t)m_frames.size()));
-        // Renumber
-        for (uint64_t i = m_selection_start; i < m_frames.size(); i++) {
-            m_frames[i].frame_number = i;
-        }
+        m_history.replace(m_frames, m_selection_start, m_selection_end + 1 - m_selection_start, {});
         invalidate_greenzone(m_selection_start);
     }
 
     void paste_at(uint64_t frame) override {
         if (m_clipboard.empty()) return;
-        save_undo_state();
-        m_frames.insert(m_frames.begin() + frame, m_clipboard.begin(), m_clipboard.end());
-        // Renumber
-        for (uint64_t i = frame; i < m_frames.size(); i++) {
-            m_frames[i].frame_number = i;
-        }
+        m_history.replace(m_frames, frame, 0, m_clipboard);
         invalidate_greenzone(frame);
     }
 
+    void set_greenzone_budget(size_t bytes) override {
+        m_greenzone.set_budget(bytes);
+    }
+
+    size_t get_greenzone_budget() const override {
+        return m_greenzone.get_budget();
+    }
+
+    size_t get_greenzone_memory_used() const override {
+        return m_greenzone.get_memory_used();
+    }
+
+    void trim_greenzone(size_t max_bytes) override {
+        m_greenzone.trim(max_bytes);
+    }
+
+    bool start_search(const emu::TASSearchParams& params) override {
+        if (!m_movie_loaded || !seek_to_frame(params.start_frame)) return false;
+
+        std::vector<uint8_t> state;
+        if (!m_host->save_state_to_buffer(state)) return false;
+        return m_search.start(m_host, params, state);
+    }
+
+    void cancel_search() override {
+        m_search.cancel();
+    }
+
+    bool get_search_status(emu::TASSearchStatus& status) override {
+        m_search.poll(status);
+        return true;
+    }
+
+    // Controller 1 gets the best sequence; the movie grows if it ends sooner
+    bool apply_search_result() override {
+        emu::TASSearchStatus status;
+        m_search.poll(status);
+        if (status.running || !status.has_result) return false;
+
+        uint64_t start = m_search.get_params().start_frame;
+        if (start > m_frames.size()) return false;
+        uint64_t end = start + static_cast<uint64_t>(status.frame_count);
+        uint64_t replaced = std::min<uint64_t>(end, m_frames.size()) - start;
+
+        std::vector<emu::TASFrameData> frames(m_frames.begin() + start, m_frames.begin() + start + replaced);
+        frames.resize(status.frame_count, emu::TASFrameData{});
+        for (int i = 0; i < status.frame_count; i++) frames[i].controller_inputs[0] = status.best_inputs[i];
+
+        m_history.replace(m_frames, start, replaced, std::move(frames));
+        invalidate_greenzone(start);
+        return true;
+    }
+
+    // Controller 1 only, like the greenzone worker; the greenzone's state
+    // after the last frame is normal playback's end state
+    bool start_verify() override {
+        if (!m_movie_loaded) return false;
+
+        std::vector<uint32_t> inputs;
+        inputs.reserve(m_frames.size());
+        for (const emu::TASFrameData& frame : m_frames) {
+            if (frame.controller_inputs[1] || frame.controller_inputs[2] || frame.controller_inputs[3]) return false;
+            inputs.push_back(frame.controller_inputs[0]);
+        }
+
+        std::vector<uint8_t> start_state;
+        if (m_info.starts_from_savestate) start_state = m_start_state;
+        uint64_t found = 0;
+        std::vector<uint8_t> end_state;
+        if (!m_greenzone.find_before(m_frames.size(), found, end_state) || found != m_frames.size()) {
+            end_state.clear();
+        }
+        return m_verifier.start(m_host, std::move(start_state), std::move(inputs), std::move(end_state));
+    }
+
+    void cancel_verify() override {
+        m_verifier.cancel();
+    }
+
+    bool get_verify_status(emu::TASVerifyStatus& status) override {
+        m_verifier.poll(status);
+        return true;
+    }
+
     uint64_t get_current_frame() const override {
         return m_current_frame;
     }
@@ -460,53 +538,118 @@ public:
         return it->second.c_str();
     }
 
+#ifdef VELOCE_TAS_LUA
+    bool supports_lua() const override { return true; }
+
+    bool load_lua_script(const char* filename) override {
+        return m_lua.load(m_host, filename);
+    }
+
+    void unload_lua_script() override {
+        m_lua.unload();
+    }
+
+    bool is_lua_running() const override {
+        return m_lua.is_running();
+    }
+
+    void get_lua_overlay(std::vector<emu::TASDrawCommand>& commands) override {
+        m_lua.take_overlay(commands);
+    }
+
+    const char* get_lua_error() override {
+        return m_lua.get_error();
+    }
+#endif
+
 private:
-    void save_undo_state() {
-        m_undo_stack.push_back(m_frames);
-        if (m_undo_stack.size() > 100) {
-            m_undo_stack.pop_front();
+    // Play movie input forward from m_current_frame through the host's silent
+    // batch path, stopping only to fill in the dense tier behind the target
+    // for frame stepping. Only the target frame is drawn.
+    void replay_to_frame(uint64_t frame) {
+        uint64_t fill_from = frame >= emu::Greenzone::DENSE_FRAMES ? frame - emu::Greenzone::DENSE_FRAMES + 1 : 0;
+        while (m_current_frame < frame) {
+            uint64_t stop = std::max(m_current_frame + 1, fill_from);
+            while (stop < frame && (!m_greenzone.wants(stop) || m_greenzone.has(stop))) stop++;
+
+            m_host->run_frames_silent(&m_frames[m_current_frame], stop - m_current_frame, stop == frame);
+            record_lag(stop - 1, m_host->is_lag_frame());
+            m_current_frame = stop;
+            capture_greenzone(m_current_frame);
         }
-        m_redo_stack.clear();
     }
 
-    bool load_fm2(const char* filename) {
-        // Simple FM2 parser
-        std::ifstream file(filename);
-        if (!file) return false;
+    // Have the worker run the movie forward from the last state before
+    // from_frame in the background. Its core takes controller 1 only, so
+    // movies using other controllers past that state are left alone.
+    void refill_greenzone(uint64_t from_frame) {
+        // Nothing to do if the greenzone still has these inputs' states
+        while (from_frame < m_frames.size() && (!m_greenzone.wants(from_frame) || m_greenzone.has(from_frame))) {
+            from_frame++;
+        }
+        if (from_frame >= m_frames.size()) return;
+
+        uint64_t base = 0;
+        std::vector<uint8_t> state;
+        if (!m_greenzone.find_before(from_frame, base, state)) {
+            // From the movie's start; an empty state means power-on
+            base = 0;
+            if (m_info.starts_from_savestate) state = m_start_state;
+        }
+
+        std::vector<uint32_t> inputs;
+        inputs.reserve(m_frames.size() - base);
+        for (uint64_t i = base; i < m_frames.size(); i++) {
+            const emu::TASFrameData& frame = m_frames[i];
+            if (frame.controller_inputs[1] || frame.controller_inputs[2] || frame.controller_inputs[3]) return;
+            inputs.push_back(frame.controller_inputs[0]);
+        }
 
-        m_frames.clear();
-        std::string line;
-
-        while (std::getline(file, line)) {
-            if (line.empty() || line[0] == '#') continue;
-
-            // Frame line format: |1|23456789|
-            if (line[0] == '|') {
-                emu::TASFrameData frame{};
-                frame.frame_number = m_frames.size();
-
-                // Parse controller 1
-                if (line.length() >= 10) {
-                    uint32_t buttons = 0;
-                    if (line[3] == 'R') buttons |= 0x80;  // Right
-                    if (line[4] == 'L') buttons |= 0x40;  // Left
-                    if (line[5] == 'D') buttons |= 0x20;  // Down
-                    if (line[6] == 'U') buttons |= 0x10;  // Up
-                    if (line[7] == 'T') buttons |= 0x08;  // Start
-                    if (line[8] == 'S') buttons |= 0x04;  // Select
-                    if (line[9] == 'B') buttons |= 0x02;  // B
-                    if (line[10] == 'A') buttons |= 0x01; // A
-                    frame.controller_inputs[0] = buttons;
-                }
+        if (!m_worker.is_running() && !m_worker.start(m_host)) return;
+        m_worker.submit(base, std::move(state), std::move(inputs));
+    }
 
-                m_frames.push_back(frame);
-            }
+    // Snapshot the core as the state at the start of frame, if the
+    // greenzone wants one there and doesn't have it yet
+    void capture_greenzone(uint64_t frame) {
+        if (!m_greenzone.wants(frame) || m_greenzone.has(frame)) return;
+        std::vector<uint8_t> state;
+        if (m_host->save_state_to_buffer(state)) {
+            m_greenzone.store(frame, std::move(state));
+        }
+    }
+
+    // Lag is only known for frames the core ran in this plugin's sight: the
+    // last frame of each seek batch and every frame played or recorded
+    void record_lag(uint64_t frame, bool lag) {
+        if (frame >= m_frames.size()) return;
+        if (frame >= m_lag.size()) m_lag.resize(frame + 1, 0);
+        if (m_lag[frame] != lag) {
+            m_lag[frame] = lag;
+            m_lag_revision++;
         }
+    }
 
-        m_info.frame_count = m_frames.size();
-        m_movie_loaded = true;
-        m_mode = emu::TASMode::Stopped;
-        return true;
+    void clear_lag() {
+        m_lag.clear();
+        m_ran_frame = NO_FRAME;
+        m_lag_revision++;
+    }
+
+    // Spill greenzone states to a file beside the movie's, where they stay
+    // for the next time it's opened. Without one (an unsaved import, or a
+    // read-only folder) the greenzone just stays in memory.
+    void attach_greenzone_spill() {
+        if (m_filename.empty()) return;
+        std::string path = m_filename + ".greenzone";
+        if (m_greenzone.get_spill_path() == path) return;
+        m_greenzone.attach_spill(path, m_host->get_rom_crc32());
+    }
+
+    // Look states up by this movie's start and inputs
+    void rekey_greenzone() {
+        bool from_state = m_info.starts_from_savestate && !m_start_state.empty();
+        m_greenzone.set_movie(from_state ? m_start_state : std::vector<uint8_t>{}, m_frames);
     }
 
     emu::ITASHost* m_host = nullptr;
@@ -519,11 +662,24 @@ private:
     uint64_t m_current_frame = 0;
 
     // Greenzone (savestate snapshots)
-    std::map<uint64_t, std::vector<uint8_t>> m_greenzone;
+    emu::Greenzone m_greenzone;
+    emu::GreenzoneWorker m_worker;
+
+    // Lag per movie frame (1 = lag), as far as it's known
+    static constexpr uint64_t NO_FRAME = UINT64_MAX;
+    std::vector<uint8_t> m_lag;
+    uint64_t m_lag_revision = 1;
+    uint64_t m_ran_frame = NO_FRAME;    // Movie frame the core was last given
 
     // Undo/redo
-    std::deque<std::vector<emu::TASFrameData>> m_undo_stack;
-    std::deque<std::vector<emu::TASFrameData>> m_redo_stack;
+    emu::EditHistory m_history;
+
+    emu::InputSearch m_search;
+    emu::MovieVerifier m_verifier;
+
+#ifdef VELOCE_TAS_LUA
+    emu::LuaScript m_lua;
+#endif
 
     // Selection
     uint64_t m_selection_start = 0;
@@ -0,0 +1,132 @@
+#include "edit_history.hpp"
+
+#include <algorithm>
+
+namespace emu {
+
+void EditHistory::clear() {
+    m_undo.clear();
+    m_redo.clear();
+    m_bytes = 0;
+}
+
+void EditHistory::replace(std::vector<TASFrameData>& frames, uint64_t start, uint64_t count,
+                          std::vector<TASFrameData> inserted) {
+    start = std::min<uint64_t>(start, frames.size());
+    count = std::min<uint64_t>(count, frames.size() - start);
+    if (count == 0 && inserted.empty()) return;
+
+    Edit edit;
+    edit.start = start;
+    edit.removed.assign(frames.begin() + start, frames.begin() + start + count);
+    edit.inserted = std::move(inserted);
+    apply(frames, edit, false);
+    push(std::move(edit));
+}
+
+void EditHistory::paint(std::vector<TASFrameData>& frames, uint64_t frame, const TASFrameData& data) {
+    if (frame >= frames.size()) return;
+
+    TASFrameData painted = data;
+    painted.frame_number = frame;
+
+    if (!m_undo.empty() && m_undo.back().paint && merge_paint(m_undo.back(), frames, frame, painted)) {
+        frames[frame] = painted;
+        trim();
+        return;
+    }
+
+    Edit edit;
+    edit.start = frame;
+    edit.removed.push_back(frames[frame]);
+    edit.inserted.push_back(painted);
+    edit.paint = true;
+    frames[frame] = painted;
+    push(std::move(edit));
+}
+
+bool EditHistory::merge_paint(Edit& edit, const std::vector<TASFrameData>& frames, uint64_t frame,
+                              const TASFrameData& painted) {
+    uint64_t end = edit.start + edit.inserted.size();
+    size_t before = edit.bytes();
+
+    if (frame >= edit.start && frame < end) {
+        edit.inserted[frame - edit.start] = painted;
+    } else if (frame == end) {
+        edit.removed.push_back(frames[frame]);
+        edit.inserted.push_back(painted);
+    } else if (frame + 1 == edit.start) {
+        edit.removed.insert(edit.removed.begin(), frames[frame]);
+        edit.inserted.insert(edit.inserted.begin(), painted);
+        edit.start = frame;
+    } else {
+        return false;
+    }
+
+    m_bytes += edit.bytes() - before;
+    return true;
+}
+
+bool EditHistory::undo(std::vector<TASFrameData>& frames, uint64_t& changed_from) {
+    if (m_undo.empty()) return false;
+    Edit edit = std::move(m_undo.back());
+    m_undo.pop_back();
+
+    apply(frames, edit, true);
+    edit.paint = false;
+    changed_from = edit.start;
+    m_redo.push_back(std::move(edit));
+    return true;
+}
+
+bool EditHistory::redo(std::vector<TASFrameData>& frames, uint64_t& changed_from) {
+    if (m_redo.empty()) return false;
+    Edit edit = std::move(m_redo.back());
+    m_redo.pop_back();
+
+    apply(frames, edit, false);
+    changed_from = edit.start;
+    m_undo.push_back(std::move(edit));
+    return true;
+}
+
+void EditHistory::apply(std::vector<TASFrameData>& frames, const Edit& edit, bool revert) {
+    const auto& out = revert ? edit.inserted : edit.removed;
+    const auto& in = revert ? edit.removed : edit.inserted;
+
+    auto first = frames.begin() + edit.start;
+    if (out.size() == in.size()) {
+        std::copy(in.begin(), in.end(), first);
+        renumber(frames, edit.start, edit.start + in.size());
+    } else {
+        frames.erase(first, first + out.size());
+        frames.insert(frames.begin() + edit.start, in.begin(), in.end());
+        renumber(frames, edit.start, frames.size());
+    }
+}
+
+void EditHistory::renumber(std::vector<TASFrameData>& frames, uint64_t from, uint64_t to) {
+    for (uint64_t i = from; i < to; i++) frames[i].frame_number = i;
+}
+
+void EditHistory::push(Edit&& edit) {
+    clear_redo();
+    if (!m_undo.empty()) m_undo.back().paint = false;
+    m_bytes += edit.bytes();
+    m_undo.push_back(std::move(edit));
+    trim();
+}
+
+void EditHistory::clear_redo() {
+    for (const Edit& edit : m_redo) m_bytes -= edit.bytes();
+    m_redo.clear();
+}
+
+void EditHistory::trim() {
+    while (m_undo.size() > 1 && (m_undo.size() > MAX_EDITS || m_bytes > MAX_BYTES)) {
+        m_bytes -= m_undo.front().bytes();
+        m_undo.pop_front();
+    }
+}
+
+} // namespace emu
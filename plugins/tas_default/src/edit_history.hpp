@@ -0,0 +1,71 @@
+#pragma once
+
+#include "emu/tas_plugin.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace emu {
+
+// Movie edits with undo/redo
+//
+// Every edit replaces a range of frames with others, so an undo entry is
+// just the start frame and the frames taken out and put in rather than a
+// copy of the whole movie. Painting one frame next to (or inside) the range
+// the previous paint covered extends that entry, so a drag across the piano
+// roll undoes in one step. The oldest entries are dropped past MAX_EDITS or
+// MAX_BYTES.
+class EditHistory {
+public:
+    static constexpr size_t MAX_EDITS = 1000;
+    static constexpr size_t MAX_BYTES = 16u << 20;
+
+    void clear();
+
+    // Replace count frames from start with inserted (clamped to the movie)
+    // and renumber what follows
+    void replace(std::vector<TASFrameData>& frames, uint64_t start, uint64_t count,
+                 std::vector<TASFrameData> inserted);
+
+    // Set one frame, merging with the previous paint where they touch
+    void paint(std::vector<TASFrameData>& frames, uint64_t frame, const TASFrameData& data);
+
+    // Revert or reapply the last edit. Returns false if there is none, else
+    // sets changed_from to the first frame that changed.
+    bool undo(std::vector<TASFrameData>& frames, uint64_t& changed_from);
+    bool redo(std::vector<TASFrameData>& frames, uint64_t& changed_from);
+
+    bool can_undo() const { return !m_undo.empty(); }
+    bool can_redo() const { return !m_redo.empty(); }
+    size_t get_memory_used() const { return m_bytes; }
+
+private:
+    struct Edit {
+        uint64_t start = 0;
+        std::vector<TASFrameData> removed;
+        std::vector<TASFrameData> inserted;
+        bool paint = false;     // Still open to merging with the next paint
+
+        size_t bytes() const { return (removed.size() + inserted.size()) * sizeof(TASFrameData); }
+    };
+
+    // Swap edit.removed for edit.inserted in frames (or back when reverting)
+    static void apply(std::vector<TASFrameData>& frames, const Edit& edit, bool revert);
+    static void renumber(std::vector<TASFrameData>& frames, uint64_t from, uint64_t to);
+
+    // Extend a paint edit by one frame if it touches or overlaps it
+    bool merge_paint(Edit& edit, const std::vector<TASFrameData>& frames, uint64_t frame,
+                     const TASFrameData& painted);
+
+    void push(Edit&& edit);
+    void clear_redo();
+    void trim();
+
+    std::deque<Edit> m_undo;
+    std::deque<Edit> m_redo;
+    size_t m_bytes = 0;
+};
+
+} // namespace emu
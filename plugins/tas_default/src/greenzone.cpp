@@ -0,0 +1,376 @@
+#include "greenzone.hpp"
+#include "state_codec.hpp"
+
+#include <algorithm>
+
+namespace emu {
+
+namespace {
+
+// States are retiered once the cursor has moved this far
+constexpr uint64_t RETIER_FRAMES = 16;
+
+constexpr uint64_t POWER_ON_PREFIX = 0x6A09E667F3BCC908ull;
+
+// splitmix64's finalizer
+uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+// The last entry of map at or before frame kept for the movie with these
+// prefixes, or map.end()
+template <typename Map>
+auto last_current(Map& map, uint64_t frame, const std::vector<uint64_t>& prefixes) {
+    auto it = map.upper_bound({frame, UINT64_MAX});
+    while (it != map.begin()) {
+        --it;
+        if (it->first.prefix == prefixes[it->first.frame]) return it;
+    }
+    return map.end();
+}
+
+} // namespace
+
+void Greenzone::clear() {
+    detach_spill();
+    m_entries.clear();
+    m_prefixes.assign(1, POWER_ON_PREFIX);
+    m_memory = 0;
+    m_cursor = 0;
+    m_tiered_cursor = 0;
+    m_clock = 0;
+    m_keyframe = {NO_KEYFRAME, 0};
+    m_keyframe_state.clear();
+    m_revision++;
+}
+
+void Greenzone::set_budget(size_t bytes) {
+    m_budget = bytes;
+    evict(m_budget);
+}
+
+bool Greenzone::attach_spill(const std::string& path, uint32_t rom_crc32) {
+    detach_spill();
+    std::vector<GreenzoneSpill::Existing> existing;
+    if (!m_spill.open(path, rom_crc32, existing)) return false;
+
+    for (const GreenzoneSpill::Existing& found : existing) {
+        const GreenzoneSpillRecord& record = found.record;
+        m_spilled[{record.frame, record.prefix}] =
+            {found.offset, record.size, record.raw_size, record.keyframe != 0, record.keyframe_prefix};
+    }
+    m_revision++;
+    return true;
+}
+
+void Greenzone::detach_spill() {
+    if (!m_spill.is_open()) return;
+    m_spill.close();
+    m_spilled.clear();
+
+    // Deltas whose keyframe was only on disk can't be decoded any more
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        auto next = std::next(it);
+        const Entry& entry = it->second;
+        if (!entry.keyframe && !m_entries.count({keyframe_for(it->first.frame), entry.keyframe_prefix})) {
+            m_memory -= entry.data.size();
+            m_entries.erase(it);
+        }
+        it = next;
+    }
+    m_revision++;
+}
+
+void Greenzone::persist() {
+    if (!m_spill.is_open()) return;
+    for (const auto& entry : m_entries) {
+        spill(entry.first, entry.second);
+    }
+    m_spill.flush();
+}
+
+bool Greenzone::spill(const Key& key, const Entry& entry) {
+    if (m_spilled.count(key)) return true;
+
+    GreenzoneSpillRecord record{};
+    record.frame = key.frame;
+    record.prefix = key.prefix;
+    record.keyframe_prefix = entry.keyframe_prefix;
+    record.raw_size = static_cast<uint32_t>(entry.raw_size);
+    record.size = static_cast<uint32_t>(entry.data.size());
+    record.keyframe = entry.keyframe ? 1 : 0;
+    uint64_t offset = m_spill.append(record, entry.data.data());
+    if (offset == 0) return false;
+
+    m_spilled[key] = {offset, record.size, record.raw_size, entry.keyframe, entry.keyframe_prefix};
+    return true;
+}
+
+void Greenzone::restore_block(const Key& key) {
+    const Spilled& found = m_spilled.at(key);
+    uint64_t first = keyframe_for(key.frame);
+    uint64_t keyframe_prefix = found.keyframe ? key.prefix : found.keyframe_prefix;
+
+    auto it = m_spilled.lower_bound({first, 0});
+    auto end = m_spilled.lower_bound({first + KEYFRAME_FRAMES, 0});
+    for (; it != end; ++it) {
+        const Spilled& spilled = it->second;
+        bool in_block = it->first == key ||
+                        (spilled.keyframe ? it->first == Key{first, keyframe_prefix}
+                                          : spilled.keyframe_prefix == keyframe_prefix);
+        if (!in_block || m_entries.count(it->first)) continue;
+
+        Entry entry;
+        if (!m_spill.read(spilled.offset, spilled.size, entry.data)) continue;
+        entry.raw_size = spilled.raw_size;
+        entry.keyframe = spilled.keyframe;
+        entry.keyframe_prefix = spilled.keyframe_prefix;
+        entry.last_used = ++m_clock;
+        m_memory += entry.data.size();
+        m_entries.emplace(it->first, std::move(entry));
+    }
+    evict(m_budget);
+}
+
+uint64_t Greenzone::start_prefix(const std::vector<uint8_t>& start_state) {
+    if (start_state.empty()) return POWER_ON_PREFIX;
+
+    // FNV-1a
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (uint8_t byte : start_state) {
+        hash = (hash ^ byte) * 0x100000001B3ull;
+    }
+    return mix(hash ^ start_state.size());
+}
+
+// Everything in a frame that reaches the core; frame_number doesn't
+uint64_t Greenzone::next_prefix(uint64_t prefix, const TASFrameData& frame) {
+    const uint32_t* inputs = frame.controller_inputs;
+    prefix = mix(prefix ^ (uint64_t{inputs[0]} | uint64_t{inputs[1]} << 32));
+    prefix = mix(prefix ^ (uint64_t{inputs[2]} | uint64_t{inputs[3]} << 32));
+    uint64_t events = uint64_t{frame.has_reset} | uint64_t{frame.has_savestate} << 1;
+    if (frame.has_savestate) events |= uint64_t{static_cast<uint32_t>(frame.savestate_slot)} << 32;
+    return mix(prefix ^ events);
+}
+
+void Greenzone::set_movie(const std::vector<uint8_t>& start_state, const std::vector<TASFrameData>& frames) {
+    m_prefixes.assign(1, start_prefix(start_state));
+    movie_changed(frames, 0);
+}
+
+void Greenzone::movie_changed(const std::vector<TASFrameData>& frames, uint64_t frame) {
+    if (m_prefixes.empty()) m_prefixes.push_back(POWER_ON_PREFIX);
+    m_revision++;
+
+    // The state at the start of frame itself still stands
+    frame = std::min<uint64_t>({frame, m_prefixes.size() - 1, frames.size()});
+    m_prefixes.resize(frame + 1);
+    m_prefixes.reserve(frames.size() + 1);
+    for (uint64_t i = frame; i < frames.size(); i++) {
+        m_prefixes.push_back(next_prefix(m_prefixes[i], frames[i]));
+    }
+}
+
+int Greenzone::tier_for(uint64_t distance) {
+    int tier = 0;
+    uint64_t limit = DENSE_FRAMES;
+    while (tier < MAX_TIER && distance >= limit) {
+        limit *= 4;
+        tier++;
+    }
+    return tier;
+}
+
+void Greenzone::set_cursor(uint64_t frame) {
+    m_cursor = frame;
+    uint64_t moved = frame > m_tiered_cursor ? frame - m_tiered_cursor : m_tiered_cursor - frame;
+    if (moved >= RETIER_FRAMES) retier();
+}
+
+bool Greenzone::wanted(uint64_t frame, uint64_t cursor) {
+    uint64_t distance = frame > cursor ? frame - cursor : cursor - frame;
+    uint64_t interval = uint64_t{1} << (2 * tier_for(distance));
+    return frame % interval == 0;
+}
+
+bool Greenzone::has(uint64_t frame) const {
+    if (frame >= m_prefixes.size()) return false;
+    Key key = key_for(frame);
+    return m_entries.count(key) > 0 || m_spilled.count(key) > 0;
+}
+
+void Greenzone::get_presence(uint64_t start, uint64_t count, uint8_t* bits) const {
+    std::fill(bits, bits + (count + 7) / 8, 0);
+    uint64_t end = std::min<uint64_t>(start + count, m_prefixes.size());
+    auto mark = [&](const auto& map) {
+        for (auto it = map.lower_bound({start, 0}); it != map.end() && it->first.frame < end; ++it) {
+            if (it->first.prefix != m_prefixes[it->first.frame]) continue;
+            uint64_t i = it->first.frame - start;
+            bits[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+        }
+    };
+    mark(m_entries);
+    mark(m_spilled);
+}
+
+void Greenzone::store(uint64_t frame, std::vector<uint8_t>&& state) {
+    if (frame >= m_prefixes.size() || !wants(frame) || state.empty()) return;
+
+    // Same start and inputs, so the same state
+    Key key = key_for(frame);
+    auto existing = m_entries.find(key);
+    if (existing != m_entries.end()) {
+        existing->second.last_used = ++m_clock;
+        return;
+    }
+    if (m_spilled.count(key)) return;
+
+    // A delta needs its keyframe; without one (seeked in mid-block, or it
+    // was evicted) the state becomes a keyframe of its own
+    Key base = key_for(keyframe_for(frame));
+    bool delta = base.frame != frame && load_keyframe(base) && m_keyframe_state.size() == state.size();
+
+    Entry& entry = m_entries[key];
+    entry.raw_size = state.size();
+    entry.keyframe = !delta;
+    entry.last_used = ++m_clock;
+    if (delta) {
+        entry.keyframe_prefix = base.prefix;
+        encode_delta(state, m_keyframe_state, entry.data);
+    } else {
+        encode_keyframe(state, entry.data);
+        m_keyframe = key;
+        m_keyframe_state = std::move(state);
+    }
+    m_memory += entry.data.size();
+    m_revision++;
+
+    evict(m_budget);
+}
+
+bool Greenzone::find_before(uint64_t frame, uint64_t& found, std::vector<uint8_t>& state) {
+    if (m_prefixes.empty()) return false;
+    frame = std::min<uint64_t>(frame, m_prefixes.size() - 1);
+
+    // Step back over states kept for other inputs. A closer one on disk
+    // comes back into memory first.
+    auto it = last_current(m_entries, frame, m_prefixes);
+    auto spilled = last_current(m_spilled, frame, m_prefixes);
+    if (spilled != m_spilled.end() && (it == m_entries.end() || it->first.frame < spilled->first.frame)) {
+        Key key = spilled->first;
+        restore_block(key);
+        it = m_entries.find(key);
+        if (it == m_entries.end()) it = last_current(m_entries, frame, m_prefixes);
+    }
+    if (it == m_entries.end()) return false;
+
+    Entry& entry = it->second;
+    bool decoded;
+    if (entry.keyframe) {
+        decoded = load_keyframe(it->first);
+        if (decoded) state = m_keyframe_state;
+    } else {
+        decoded = load_keyframe({keyframe_for(it->first.frame), entry.keyframe_prefix}) &&
+                  decode_state(StateEncoding::Delta, entry.data, entry.raw_size, m_keyframe_state, state);
+    }
+    if (!decoded) {
+        erase(it);
+        return false;
+    }
+
+    entry.last_used = ++m_clock;
+    found = it->first.frame;
+    return true;
+}
+
+bool Greenzone::load_keyframe(const Key& key) {
+    const std::vector<uint8_t>* data;
+    size_t raw_size;
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        if (!it->second.keyframe) return false;
+
+        // Keep it as long as the deltas being read through it
+        it->second.last_used = ++m_clock;
+        if (m_keyframe == key) return true;
+        data = &it->second.data;
+        raw_size = it->second.raw_size;
+    } else {
+        // Spilled while its deltas stayed in memory
+        auto spilled = m_spilled.find(key);
+        if (spilled == m_spilled.end() || !spilled->second.keyframe) return false;
+        if (m_keyframe == key) return true;
+        if (!m_spill.read(spilled->second.offset, spilled->second.size, m_spill_buffer)) return false;
+        data = &m_spill_buffer;
+        raw_size = spilled->second.raw_size;
+    }
+
+    m_keyframe = {NO_KEYFRAME, 0};
+    if (!decode_state(StateEncoding::Keyframe, *data, raw_size, {}, m_keyframe_state)) {
+        return false;
+    }
+    m_keyframe = key;
+    return true;
+}
+
+// Drop the states the cursor's new position no longer wants
+void Greenzone::retier() {
+    m_tiered_cursor = m_cursor;
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        Key key = it->first;
+        if (wants(key.frame)) {
+            ++it;
+        } else {
+            erase(it);  // May take deltas after it along
+            it = m_entries.upper_bound(key);
+        }
+    }
+}
+
+void Greenzone::trim(size_t max_bytes) {
+    evict(max_bytes);
+}
+
+void Greenzone::evict(size_t max_bytes) {
+    while (m_memory > max_bytes && m_entries.size() > 1) {
+        auto oldest = std::min_element(m_entries.begin(), m_entries.end(),
+            [](const auto& a, const auto& b) { return a.second.last_used < b.second.last_used; });
+
+        // Moved to disk, it stays found and its deltas stay decodable
+        if (m_spill.is_open() && spill(oldest->first, oldest->second)) {
+            m_memory -= oldest->second.data.size();
+            m_entries.erase(oldest);
+        } else {
+            erase(oldest);
+        }
+    }
+}
+
+void Greenzone::erase(std::map<Key, Entry>::iterator it) {
+    Key key = it->first;
+    bool keyframe = it->second.keyframe;
+    m_memory -= it->second.data.size();
+    m_entries.erase(it);
+    m_revision++;
+    if (m_keyframe == key) m_keyframe = {NO_KEYFRAME, 0};
+    if (!keyframe || keyframe_for(key.frame) != key.frame || m_spilled.count(key)) return;
+
+    // The deltas against this keyframe can no longer be decoded
+    auto delta = m_entries.lower_bound({key.frame + 1, 0});
+    auto end = m_entries.lower_bound({key.frame + KEYFRAME_FRAMES, 0});
+    while (delta != end) {
+        auto next = std::next(delta);
+        if (!delta->second.keyframe && delta->second.keyframe_prefix == key.prefix) {
+            m_memory -= delta->second.data.size();
+            m_entries.erase(delta);
+        }
+        delta = next;
+    }
+}
+
+} // namespace emu
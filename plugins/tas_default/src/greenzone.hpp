@@ -0,0 +1,180 @@
+#pragma once
+
+#include "emu/tas_plugin.hpp"
+#include "greenzone_spill.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace emu {
+
+// Savestate snapshots for seeking in a TAS movie
+//
+// States are dense near the cursor (the frame being recorded or edited)
+// and exponentially sparser away from it: tier k covers distances below
+// DENSE_FRAMES * 4^k and keeps only frames that are multiples of 4^k. The
+// intervals nest, so a state a coarse tier keeps was also kept by every
+// finer one and moving the cursor away only ever thins states out.
+//
+// Consecutive states differ in a few pages (mostly work RAM), so a state
+// on a multiple of KEYFRAME_FRAMES is stored whole as a keyframe and the
+// rest as page XOR deltas against the keyframe that starts their block,
+// all LZ-compressed. KEYFRAME_FRAMES is tier 3's interval: tiers 1 and 2
+// never drop a keyframe their deltas need, and tier 3 on holds nothing
+// but keyframes. Over the memory budget, the least recently used states
+// are dropped along with any deltas against them.
+//
+// A state is keyed by its frame and a rolling hash of the movie's start
+// state and every input before that frame, since those alone decide it.
+// Editing the movie just rehashes from the edit on: states after it stay
+// stored under the old inputs, ignored while the movie differs, and are
+// found again if an undo (or retyping the same input) brings the prefix
+// back. The budget's LRU order is what finally drops them.
+//
+// With a spill file attached, the budget moves states to disk instead of
+// dropping them. The file sits next to the movie and outlives the session:
+// its states are keyed the same way, so reopening the movie finds them
+// without replaying. A seek that lands on a spilled state reads back its
+// whole keyframe block, since scrubbing near it wants the neighbours next.
+class Greenzone {
+public:
+    static constexpr uint64_t DENSE_FRAMES = 2048;
+    static constexpr uint64_t KEYFRAME_FRAMES = 64;
+    static constexpr int MAX_TIER = 5;             // Interval 1024 frames
+    static constexpr size_t DEFAULT_BUDGET = 512u << 20;
+
+    void clear();
+
+    void set_budget(size_t bytes);
+    size_t get_budget() const { return m_budget; }
+
+    // Drop (or spill) the least recently used states until at most
+    // max_bytes are held; the budget is unchanged
+    void trim(size_t max_bytes);
+    size_t get_memory_used() const { return m_memory; }
+    size_t get_state_count() const { return m_entries.size(); }
+
+    // Spill states over the budget to path rather than dropping them, and
+    // take up the states an earlier session left there. False, with no
+    // disk tier, if it can't be opened.
+    bool attach_spill(const std::string& path, uint32_t rom_crc32);
+    void detach_spill();
+    bool has_spill() const { return m_spill.is_open(); }
+    const std::string& get_spill_path() const { return m_spill.get_path(); }
+    size_t get_spilled_count() const { return m_spilled.size(); }
+    uint64_t get_spill_size() const { return m_spill.get_size(); }
+
+    // Write every state held in memory to the spill file as well, so the
+    // next session finds all of them
+    void persist();
+
+    // The movie the states are looked up for: its start state (empty for
+    // power-on) and inputs. States from other movies stay until evicted.
+    void set_movie(const std::vector<uint8_t>& start_state, const std::vector<TASFrameData>& frames);
+
+    // frames changed from frame on (edited, or appended while recording)
+    void movie_changed(const std::vector<TASFrameData>& frames, uint64_t frame);
+
+    // Distances are measured from here. States are retiered once the
+    // cursor has moved a few frames.
+    void set_cursor(uint64_t frame);
+
+    // Whether a state for this frame would be kept at the current cursor
+    bool wants(uint64_t frame) const { return wanted(frame, m_cursor); }
+    static bool wanted(uint64_t frame, uint64_t cursor);
+
+    // Keep the state at the start of frame of the current movie
+    void store(uint64_t frame, std::vector<uint8_t>&& state);
+
+    bool has(uint64_t frame) const;
+
+    // has() for count frames from start, as bits (LSB first)
+    void get_presence(uint64_t start, uint64_t count, uint8_t* bits) const;
+
+    // Bumped whenever the current movie's states may have changed
+    uint64_t get_revision() const { return m_revision; }
+
+    // The current movie's closest state at or before frame, decoded into
+    // state
+    bool find_before(uint64_t frame, uint64_t& found, std::vector<uint8_t>& state);
+
+private:
+    static constexpr uint64_t NO_KEYFRAME = UINT64_MAX;
+
+    struct Key {
+        uint64_t frame;
+        uint64_t prefix;            // Hash of the start state and inputs before frame
+
+        bool operator<(const Key& other) const {
+            return frame != other.frame ? frame < other.frame : prefix < other.prefix;
+        }
+        bool operator==(const Key& other) const { return frame == other.frame && prefix == other.prefix; }
+    };
+
+    struct Entry {
+        std::vector<uint8_t> data;
+        size_t raw_size = 0;
+        bool keyframe = false;      // Otherwise a delta against the keyframe at
+        uint64_t keyframe_prefix = 0;   // keyframe_for(frame) with this prefix
+        uint64_t last_used = 0;
+    };
+
+    // A state in the spill file
+    struct Spilled {
+        uint64_t offset;
+        uint32_t size;
+        uint32_t raw_size;
+        bool keyframe;
+        uint64_t keyframe_prefix;
+    };
+
+    static int tier_for(uint64_t distance);
+
+    static uint64_t keyframe_for(uint64_t frame) { return frame - frame % KEYFRAME_FRAMES; }
+
+    static uint64_t start_prefix(const std::vector<uint8_t>& start_state);
+    static uint64_t next_prefix(uint64_t prefix, const TASFrameData& frame);
+
+    // The current movie's key for frame, which must be within it
+    Key key_for(uint64_t frame) const { return {frame, m_prefixes[frame]}; }
+
+    // Decode the keyframe at key into m_keyframe_state
+    bool load_keyframe(const Key& key);
+
+    void retier();
+    void evict(size_t max_bytes);
+    void erase(std::map<Key, Entry>::iterator it);
+
+    // Append the entry to the spill file unless it's there already
+    bool spill(const Key& key, const Entry& entry);
+
+    // Read the spilled states of key's keyframe block back into memory
+    void restore_block(const Key& key);
+
+    std::map<Key, Entry> m_entries;
+
+    GreenzoneSpill m_spill;
+    std::map<Key, Spilled> m_spilled;
+    std::vector<uint8_t> m_spill_buffer;
+
+    // The current movie's prefix hash at the start of every frame and
+    // after the last
+    std::vector<uint64_t> m_prefixes;
+
+    size_t m_budget = DEFAULT_BUDGET;
+    size_t m_memory = 0;
+    uint64_t m_cursor = 0;
+    uint64_t m_tiered_cursor = 0;   // Cursor at the last retier()
+    uint64_t m_clock = 0;           // LRU time
+    uint64_t m_revision = 1;
+
+    // The last keyframe stored or decoded, raw, so recording and scrubbing
+    // within a block don't decompress it again for every delta
+    Key m_keyframe{NO_KEYFRAME, 0};
+    std::vector<uint8_t> m_keyframe_state;
+};
+
+} // namespace emu
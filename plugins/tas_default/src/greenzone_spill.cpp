@@ -0,0 +1,128 @@
+#include "greenzone_spill.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+namespace emu {
+
+namespace {
+
+constexpr char MAGIC[4] = {'V', 'G', 'Z', 'S'};
+constexpr uint32_t VERSION = 1;
+constexpr uint64_t HEADER_SIZE = 16;
+
+// Larger than any core's state; a bigger size means a torn record
+constexpr uint32_t MAX_RECORD_SIZE = 64u << 20;
+
+// FNV-1a over every field before check
+uint32_t record_check(const GreenzoneSpillRecord& record) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&record);
+    uint32_t hash = 0x811C9DC5u;
+    for (size_t i = 0; i < offsetof(GreenzoneSpillRecord, check); i++) {
+        hash = (hash ^ bytes[i]) * 0x01000193u;
+    }
+    return hash;
+}
+
+} // namespace
+
+bool GreenzoneSpill::open(const std::string& path, uint32_t rom_crc32, std::vector<Existing>& existing) {
+    close();
+    existing.clear();
+    m_path = path;
+
+    m_file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+    if (!m_file.is_open()) return start_over(rom_crc32);  // Doesn't exist yet
+
+    char header[HEADER_SIZE] = {};
+    m_file.read(header, sizeof(header));
+    uint32_t version = 0;
+    uint32_t crc = 0;
+    std::memcpy(&version, header + 4, 4);
+    std::memcpy(&crc, header + 8, 4);
+    if (!m_file || std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION || crc != rom_crc32) {
+        m_file.clear();
+        return start_over(rom_crc32);
+    }
+
+    m_file.seekg(0, std::ios::end);
+    uint64_t file_size = static_cast<uint64_t>(m_file.tellg());
+    uint64_t position = HEADER_SIZE;
+    while (position + sizeof(GreenzoneSpillRecord) <= file_size) {
+        GreenzoneSpillRecord record;
+        m_file.seekg(static_cast<std::streamoff>(position));
+        m_file.read(reinterpret_cast<char*>(&record), sizeof(record));
+        uint64_t data = position + sizeof(record);
+        if (!m_file || record.check != record_check(record) || record.size > MAX_RECORD_SIZE ||
+            data + record.size > file_size) {
+            break;
+        }
+        existing.push_back({record, data});
+        position = data + record.size;
+    }
+    m_file.clear();
+    m_end = position;
+    return true;
+}
+
+bool GreenzoneSpill::start_over(uint32_t rom_crc32) {
+    if (m_file.is_open()) m_file.close();
+    m_file.clear();
+    m_file.open(m_path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+
+    char header[HEADER_SIZE] = {};
+    std::memcpy(header, MAGIC, sizeof(MAGIC));
+    std::memcpy(header + 4, &VERSION, 4);
+    std::memcpy(header + 8, &rom_crc32, 4);
+    m_file.write(header, sizeof(header));
+    m_file.flush();
+    if (!m_file) {
+        close();
+        return false;
+    }
+    m_end = HEADER_SIZE;
+    return true;
+}
+
+void GreenzoneSpill::close() {
+    if (m_file.is_open()) m_file.close();
+    m_file.clear();
+    m_path.clear();
+    m_end = 0;
+}
+
+uint64_t GreenzoneSpill::append(const GreenzoneSpillRecord& record, const uint8_t* data) {
+    if (!m_file.is_open() || record.size > MAX_RECORD_SIZE) return 0;
+
+    GreenzoneSpillRecord header = record;
+    header.check = record_check(header);
+    m_file.seekp(static_cast<std::streamoff>(m_end));
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_file.write(reinterpret_cast<const char*>(data), record.size);
+    if (!m_file) {
+        m_file.clear();
+        return 0;
+    }
+    uint64_t offset = m_end + sizeof(record);
+    m_end = offset + record.size;
+    return offset;
+}
+
+bool GreenzoneSpill::read(uint64_t offset, uint32_t size, std::vector<uint8_t>& data) {
+    if (!m_file.is_open() || offset + size > m_end) return false;
+
+    data.resize(size);
+    m_file.seekg(static_cast<std::streamoff>(offset));
+    m_file.read(reinterpret_cast<char*>(data.data()), size);
+    if (!m_file) {
+        m_file.clear();
+        return false;
+    }
+    return true;
+}
+
+void GreenzoneSpill::flush() {
+    if (m_file.is_open()) m_file.flush();
+}
+
+} // namespace emu
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace emu {
+
+// Header in front of each state in a greenzone spill file
+struct GreenzoneSpillRecord {
+    uint64_t frame;
+    uint64_t prefix;            // Greenzone key: hash of the start state and inputs
+    uint64_t keyframe_prefix;   // For deltas, the prefix of their keyframe
+    uint32_t raw_size;          // Decoded state size
+    uint32_t size;              // Stored bytes following the header
+    uint32_t keyframe;          // 1 for a keyframe, 0 for a delta
+    uint32_t check;             // Hash of the fields above, set by append()
+};
+
+// Append-only file of greenzone states
+//
+// The file is a 16-byte header (magic, version, ROM CRC) and then records,
+// each a GreenzoneSpillRecord and the state's bytes exactly as the greenzone
+// holds them in memory. Nothing is rewritten or removed, so a crash can
+// only cost the record being written: open() stops at the first header
+// whose check doesn't match, and later appends go over it.
+class GreenzoneSpill {
+public:
+    // A record found by open(), and where its bytes start
+    struct Existing {
+        GreenzoneSpillRecord record;
+        uint64_t offset;
+    };
+
+    // Open path, or create it. A file for another ROM (or not a spill
+    // file) is started over. existing gets the records already there.
+    bool open(const std::string& path, uint32_t rom_crc32, std::vector<Existing>& existing);
+    void close();
+    bool is_open() const { return m_file.is_open(); }
+
+    const std::string& get_path() const { return m_path; }
+    uint64_t get_size() const { return m_end; }
+
+    // Append a record; returns where its bytes start, or 0 on failure
+    uint64_t append(const GreenzoneSpillRecord& record, const uint8_t* data);
+
+    bool read(uint64_t offset, uint32_t size, std::vector<uint8_t>& data);
+
+    void flush();
+
+private:
+    bool start_over(uint32_t rom_crc32);
+
+    std::fstream m_file;
+    std::string m_path;
+    uint64_t m_end = 0;     // Past the last whole record
+};
+
+} // namespace emu
@@ -0,0 +1,143 @@
+#include "greenzone_worker.hpp"
+#include "greenzone.hpp"
+
+#include <algorithm>
+
+namespace emu {
+
+namespace {
+
+// Longest run between checks for cancellation
+constexpr size_t MAX_BATCH_FRAMES = 64;
+
+} // namespace
+
+GreenzoneWorker::~GreenzoneWorker() {
+    stop();
+}
+
+bool GreenzoneWorker::start(ITASHost* host) {
+    stop();
+    if (!host) return false;
+
+    m_core = host->create_emulator_clone();
+    if (!m_core) return false;
+
+    m_host = host;
+    m_thread = std::thread([this] { run(); });
+    return true;
+}
+
+void GreenzoneWorker::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+
+    if (m_core) m_host->destroy_emulator_clone(m_core);
+    m_core = nullptr;
+    m_stopping = false;
+    m_has_job = false;
+    m_ready.clear();
+    m_busy.store(false, std::memory_order_release);
+}
+
+void GreenzoneWorker::submit(uint64_t base_frame, std::vector<uint8_t>&& state, std::vector<uint32_t>&& inputs) {
+    if (!m_core || inputs.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_generation++;
+        m_has_job = true;
+        m_base_frame = base_frame;
+        m_base_state = std::move(state);
+        m_inputs = std::move(inputs);
+        m_busy.store(true, std::memory_order_release);
+    }
+    m_wake.notify_all();
+}
+
+void GreenzoneWorker::cancel(uint64_t frame) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_generation++;
+        m_has_job = false;
+        m_ready.erase(std::remove_if(m_ready.begin(), m_ready.end(),
+                                     [frame](const auto& ready) { return ready.first >= frame; }),
+                      m_ready.end());
+    }
+    m_wake.notify_all();
+}
+
+void GreenzoneWorker::collect(Greenzone& greenzone) {
+    std::vector<std::pair<uint64_t, std::vector<uint8_t>>> ready;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_ready.empty()) return;
+        ready.swap(m_ready);
+    }
+    m_wake.notify_all();
+
+    for (auto& [frame, state] : ready) {
+        if (!greenzone.has(frame)) greenzone.store(frame, std::move(state));
+    }
+}
+
+void GreenzoneWorker::run() {
+    std::vector<uint8_t> state;
+    std::vector<InputState> inputs;
+
+    for (;;) {
+        uint64_t generation = 0;
+        uint64_t base_frame = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stopping || m_has_job; });
+            if (m_stopping) return;
+
+            generation = m_generation;
+            base_frame = m_base_frame;
+            state = std::move(m_base_state);
+            inputs.resize(m_inputs.size());
+            for (size_t i = 0; i < m_inputs.size(); i++) inputs[i].buttons = m_inputs[i];
+            m_has_job = false;
+        }
+
+        // The clone has video and audio output disabled already
+        bool running = true;
+        if (state.empty()) {
+            m_core->reset();
+        } else {
+            running = m_core->load_state(state);
+        }
+        size_t done = 0;
+        while (running && done < inputs.size()) {
+            // Run up to the next frame the greenzone wants
+            uint64_t cursor = m_cursor.load(std::memory_order_relaxed);
+            size_t count = 1;
+            while (done + count < inputs.size() && count < MAX_BATCH_FRAMES &&
+                   !Greenzone::wanted(base_frame + done + count, cursor)) {
+                count++;
+            }
+            m_core->run_frames(&inputs[done], count, RUN_FLAGS_NONE);
+            m_core->clear_audio_buffer();
+            done += count;
+
+            uint64_t frame = base_frame + done;
+            bool keep = Greenzone::wanted(frame, cursor) && m_core->save_state(state);
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] {
+                return m_stopping || m_generation != generation || m_ready.size() < MAX_READY;
+            });
+            running = !m_stopping && m_generation == generation;
+            if (running && keep) m_ready.emplace_back(frame, state);
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_has_job) m_busy.store(false, std::memory_order_release);
+    }
+}
+
+} // namespace emu
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "emu/emulator_plugin.hpp"
+#include "emu/tas_plugin.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace emu {
+
+class Greenzone;
+
+// Refills the greenzone behind an edit
+//
+// An edit drops every state from the edited frame on, so the next seek past
+// it would replay from far back. The worker runs the movie forward from the
+// last surviving state on its own copy of the core, on its own thread, and
+// keeps the states the greenzone wants at the cursor. The main thread takes
+// them with collect(). A new edit cancels the job and starts another one.
+class GreenzoneWorker {
+public:
+    // States waiting for collect() before the worker pauses
+    static constexpr size_t MAX_READY = 64;
+
+    GreenzoneWorker() = default;
+    ~GreenzoneWorker();
+
+    GreenzoneWorker(const GreenzoneWorker&) = delete;
+    GreenzoneWorker& operator=(const GreenzoneWorker&) = delete;
+
+    // Clone a core from the host. False if the host cannot make one.
+    bool start(ITASHost* host);
+    void stop();
+    bool is_running() const { return m_core != nullptr; }
+
+    // Run inputs[k] (controller 1 buttons) as frame base_frame + k from a
+    // state taken at the start of base_frame, or from power-on if state is
+    // empty. Replaces any job in progress.
+    void submit(uint64_t base_frame, std::vector<uint8_t>&& state, std::vector<uint32_t>&& inputs);
+
+    // Stop the job in progress and drop its states from frame on
+    void cancel(uint64_t frame);
+
+    void set_cursor(uint64_t frame) { m_cursor.store(frame, std::memory_order_relaxed); }
+
+    // Hand the finished states to the greenzone (main thread)
+    void collect(Greenzone& greenzone);
+
+    bool is_busy() const { return m_busy.load(std::memory_order_acquire); }
+
+private:
+    void run();
+
+    ITASHost* m_host = nullptr;
+    IEmulatorPlugin* m_core = nullptr;
+    std::thread m_thread;
+    std::atomic<uint64_t> m_cursor{0};
+    std::atomic<bool> m_busy{false};
+
+    // Guarded by m_mutex
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stopping = false;
+    uint64_t m_generation = 0;      // Bumped by submit() and cancel()
+    bool m_has_job = false;
+    uint64_t m_base_frame = 0;
+    std::vector<uint8_t> m_base_state;
+    std::vector<uint32_t> m_inputs;
+    std::vector<std::pair<uint64_t, std::vector<uint8_t>>> m_ready;
+};
+
+} // namespace emu
@@ -0,0 +1,252 @@
+#include "input_search.hpp"
+
+#include <algorithm>
+
+namespace emu {
+
+namespace {
+
+// Enough tasks per thread to even out blocks that finish early
+constexpr uint64_t TASKS_PER_THREAD = 8;
+
+// Leaves counted before publishing progress
+constexpr uint64_t PROGRESS_LEAVES = 256;
+
+constexpr uint32_t button_bit(VirtualButton button) {
+    return 1u << static_cast<uint32_t>(button);
+}
+
+bool has_opposites(uint32_t buttons) {
+    constexpr uint32_t horizontal = button_bit(VirtualButton::Left) | button_bit(VirtualButton::Right);
+    constexpr uint32_t vertical = button_bit(VirtualButton::Up) | button_bit(VirtualButton::Down);
+    return (buttons & horizontal) == horizontal || (buttons & vertical) == vertical;
+}
+
+} // namespace
+
+InputSearch::~InputSearch() {
+    cancel();
+}
+
+bool InputSearch::start(ITASHost* host, const TASSearchParams& params, const std::vector<uint8_t>& base_state) {
+    cancel();
+    if (!host || base_state.empty() || params.frame_count < 1 || params.frame_count > TAS_SEARCH_MAX_FRAMES ||
+        params.objective_bytes < 1 || params.objective_bytes > 4 || params.settle_frames < 0) {
+        return false;
+    }
+
+    // Every subset of the mask, in increasing order
+    m_choices.clear();
+    uint32_t subset = 0;
+    do {
+        uint32_t buttons = params.fixed_buttons | subset;
+        if (params.allow_opposites || !has_opposites(buttons)) m_choices.push_back(buttons);
+        subset = (subset - params.button_mask) & params.button_mask;
+    } while (subset != 0);
+    std::sort(m_choices.begin(), m_choices.end());
+    m_choices.erase(std::unique(m_choices.begin(), m_choices.end()), m_choices.end());
+
+    uint64_t radix = m_choices.size();
+    m_total = 1;
+    for (int i = 0; i < params.frame_count; i++) {
+        if (m_total > params.max_candidates / radix) return false;
+        m_total *= radix;
+    }
+
+    int threads = params.max_threads > 0 ? params.max_threads
+                                         : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    m_split = 0;
+    m_task_count = 1;
+    while (m_split < params.frame_count && m_task_count < static_cast<uint64_t>(threads) * TASKS_PER_THREAD) {
+        m_task_count *= radix;
+        m_split++;
+    }
+    threads = static_cast<int>(std::min<uint64_t>(threads, m_task_count));
+
+    m_host = host;
+    m_params = params;
+    m_base_state = base_state;
+    m_next_task = 0;
+    m_done = 0;
+    m_cancel = false;
+    m_has_result = false;
+
+    for (int i = 0; i < threads; i++) {
+        IEmulatorPlugin* core = host->create_emulator_clone();
+        if (!core) break;
+
+        auto worker = std::make_unique<Worker>();
+        worker->core = core;
+        worker->fast = dynamic_cast<INetplayCapable*>(core);
+        worker->states.resize(params.frame_count + 1);
+        worker->sizes.resize(params.frame_count + 1);
+        if (worker->fast) {
+            for (auto& state : worker->states) state.resize(worker->fast->get_max_state_size());
+        }
+        worker->inputs.resize(params.frame_count);
+        worker->settle.resize(params.settle_frames);
+        m_workers.push_back(std::move(worker));
+    }
+    if (m_workers.empty()) return false;
+
+    m_active = static_cast<int>(m_workers.size());
+    for (auto& worker : m_workers) {
+        Worker* w = worker.get();
+        w->thread = std::thread([this, w] { run(*w); });
+    }
+    return true;
+}
+
+void InputSearch::cancel() {
+    m_cancel = true;
+    release();
+}
+
+void InputSearch::poll(TASSearchStatus& status) {
+    bool running = m_active.load() > 0;
+    int threads = static_cast<int>(m_workers.size());
+    if (!running) release();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    status = {};
+    status.running = running;
+    status.has_result = m_has_result;
+    status.candidates_total = m_total;
+    status.candidates_done = m_done.load(std::memory_order_relaxed);
+    status.thread_count = threads;
+    status.frame_count = m_params.frame_count;
+    if (m_has_result) {
+        status.best_value = m_best_value;
+        decode(m_best_index, status.best_inputs);
+    }
+}
+
+void InputSearch::release() {
+    for (auto& worker : m_workers) {
+        if (worker->thread.joinable()) worker->thread.join();
+        m_host->destroy_emulator_clone(worker->core);
+    }
+    m_workers.clear();
+    m_active = 0;
+}
+
+void InputSearch::run(Worker& worker) {
+    uint64_t leaves_per_task = m_total / m_task_count;
+
+    for (;;) {
+        uint64_t task = m_next_task.fetch_add(1);
+        if (task >= m_task_count || m_cancel.load(std::memory_order_relaxed)) break;
+
+        // Replay the task's fixed frames from the base state in one batch
+        if (!worker.core->load_state(m_base_state)) break;
+        uint64_t rest = task;
+        for (int i = m_split - 1; i >= 0; i--) {
+            worker.inputs[i].buttons = m_choices[rest % m_choices.size()];
+            rest /= m_choices.size();
+        }
+        if (m_split > 0) worker.core->run_frames(worker.inputs.data(), m_split, RUN_FLAGS_NONE);
+
+        if (m_split == m_params.frame_count) {
+            leaf(worker, task);
+        } else if (save(worker, m_split)) {
+            search(worker, m_split, task * leaves_per_task);
+        }
+        merge(worker);
+    }
+
+    merge(worker);
+    m_active.fetch_sub(1);
+}
+
+// Try every input at depth, from the state saved there. index is the first
+// candidate under this node.
+void InputSearch::search(Worker& worker, int depth, uint64_t index) {
+    uint64_t stride = 1;
+    for (int i = depth + 1; i < m_params.frame_count; i++) stride *= m_choices.size();
+
+    for (size_t choice = 0; choice < m_choices.size(); choice++) {
+        if (m_cancel.load(std::memory_order_relaxed)) return;
+        if (choice > 0 && !load(worker, depth)) return;
+
+        worker.inputs[depth].buttons = m_choices[choice];
+        worker.core->run_frame(worker.inputs[depth]);
+        bool lag = worker.core->is_lag_frame();
+
+        uint64_t child = index + choice * stride;
+        if (depth + 1 == m_params.frame_count) {
+            leaf(worker, child);
+        } else if (save(worker, depth + 1)) {
+            search(worker, depth + 1, child);
+        }
+
+        // On a lag frame the game never saw this input, so every other
+        // choice leads to the same states and at best ties, which the
+        // lowest candidate wins
+        if (lag) {
+            worker.leaves += stride * (m_choices.size() - 1 - choice);
+            return;
+        }
+    }
+}
+
+void InputSearch::leaf(Worker& worker, uint64_t index) {
+    if (!worker.settle.empty()) worker.core->run_frames(worker.settle.data(), worker.settle.size(), RUN_FLAGS_NONE);
+    worker.core->clear_audio_buffer();
+
+    int64_t value = 0;
+    for (int i = 0; i < m_params.objective_bytes; i++) {
+        value |= static_cast<int64_t>(worker.core->read_memory(static_cast<uint16_t>(m_params.objective_address + i)))
+                 << (8 * i);
+    }
+    if (!worker.has_best || better(value, index, worker.best_value, worker.best_index)) {
+        worker.has_best = true;
+        worker.best_value = value;
+        worker.best_index = index;
+    }
+
+    if (++worker.leaves >= PROGRESS_LEAVES) {
+        m_done.fetch_add(worker.leaves, std::memory_order_relaxed);
+        worker.leaves = 0;
+    }
+}
+
+bool InputSearch::save(Worker& worker, int depth) {
+    if (worker.fast) {
+        auto& state = worker.states[depth];
+        worker.sizes[depth] = worker.fast->save_state_fast(state.data(), state.size());
+        return worker.sizes[depth] > 0;
+    }
+    return worker.core->save_state(worker.states[depth]);
+}
+
+bool InputSearch::load(Worker& worker, int depth) {
+    if (worker.fast) return worker.fast->load_state_fast(worker.states[depth].data(), worker.sizes[depth]);
+    return worker.core->load_state(worker.states[depth]);
+}
+
+void InputSearch::merge(Worker& worker) {
+    m_done.fetch_add(worker.leaves, std::memory_order_relaxed);
+    worker.leaves = 0;
+    if (!worker.has_best) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_has_result || better(worker.best_value, worker.best_index, m_best_value, m_best_index)) {
+        m_has_result = true;
+        m_best_value = worker.best_value;
+        m_best_index = worker.best_index;
+    }
+}
+
+bool InputSearch::better(int64_t value, uint64_t index, int64_t best_value, uint64_t best_index) const {
+    if (value != best_value) return m_params.minimize ? value < best_value : value > best_value;
+    return index < best_index;
+}
+
+void InputSearch::decode(uint64_t index, uint32_t* inputs) const {
+    for (int i = m_params.frame_count - 1; i >= 0; i--) {
+        inputs[i] = m_choices[index % m_choices.size()];
+        index /= m_choices.size();
+    }
+}
+
+} // namespace emu
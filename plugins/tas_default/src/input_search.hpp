@@ -0,0 +1,99 @@
+#pragma once
+
+#include "emu/emulator_plugin.hpp"
+#include "emu/netplay_plugin.hpp"
+#include "emu/tas_plugin.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace emu {
+
+// Brute-force input search on cloned cores (see TASSearchParams)
+//
+// Candidates are numbered in order with frame 0's input most significant,
+// so a task (one choice for each of the first few frames) covers a
+// contiguous block. Threads take tasks from a shared counter and walk each
+// block depth-first, keeping the state at every depth in their own buffers:
+// a sibling reloads the state its parent left instead of replaying the
+// prefix, so each tree node costs one frame. Cores with INetplayCapable's
+// fast states save and load them without allocating. Ties go to the lowest
+// candidate, so the result doesn't depend on the thread count. A frame the
+// core reports as lag is searched with its first choice only.
+class InputSearch {
+public:
+    InputSearch() = default;
+    ~InputSearch();
+
+    InputSearch(const InputSearch&) = delete;
+    InputSearch& operator=(const InputSearch&) = delete;
+
+    // Start from base_state (taken at the start of params.start_frame),
+    // replacing any search in progress. False if the parameters are out of
+    // range or the host made no cores.
+    bool start(ITASHost* host, const TASSearchParams& params, const std::vector<uint8_t>& base_state);
+    void cancel();
+
+    // Progress and the best sequence so far. Once every thread is done this
+    // joins them and gives the cores back (main thread).
+    void poll(TASSearchStatus& status);
+
+    const TASSearchParams& get_params() const { return m_params; }
+
+private:
+    struct Worker {
+        IEmulatorPlugin* core = nullptr;
+        INetplayCapable* fast = nullptr;        // Same core, if it has fast states
+        std::thread thread;
+
+        // State at the start of each searched frame
+        std::vector<std::vector<uint8_t>> states;
+        std::vector<size_t> sizes;
+
+        std::vector<InputState> inputs;         // The candidate being run
+        std::vector<InputState> settle;
+
+        bool has_best = false;
+        int64_t best_value = 0;
+        uint64_t best_index = 0;
+        uint64_t leaves = 0;                    // Not yet added to m_done
+    };
+
+    void run(Worker& worker);
+    void search(Worker& worker, int depth, uint64_t index);
+    void leaf(Worker& worker, uint64_t index);
+    bool save(Worker& worker, int depth);
+    bool load(Worker& worker, int depth);
+    void merge(Worker& worker);
+    void release();
+
+    bool better(int64_t value, uint64_t index, int64_t best_value, uint64_t best_index) const;
+    void decode(uint64_t index, uint32_t* inputs) const;
+
+    ITASHost* m_host = nullptr;
+    TASSearchParams m_params;
+    std::vector<uint8_t> m_base_state;
+    std::vector<uint32_t> m_choices;    // Inputs tried on each frame
+    uint64_t m_total = 0;
+    uint64_t m_task_count = 0;
+    int m_split = 0;                    // Frames fixed by a task
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<uint64_t> m_next_task{0};
+    std::atomic<uint64_t> m_done{0};
+    std::atomic<int> m_active{0};
+    std::atomic<bool> m_cancel{false};
+
+    // Guarded by m_mutex
+    std::mutex m_mutex;
+    bool m_has_result = false;
+    int64_t m_best_value = 0;
+    uint64_t m_best_index = 0;
+};
+
+} // namespace emu
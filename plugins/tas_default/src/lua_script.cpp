@@ -0,0 +1,377 @@
+#include "lua_script.hpp"
+
+extern "C" {
+#include <lauxlib.h>
+#include <lua.h>
+#include <lualib.h>
+}
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace emu {
+
+namespace {
+
+// Past this a frame's extra draw calls are dropped
+constexpr size_t MAX_DRAW_COMMANDS = 4096;
+
+constexpr lua_Integer WHITE = 0xFFFFFFFF;
+
+} // namespace
+
+LuaScript::~LuaScript() {
+    unload();
+}
+
+bool LuaScript::load(ITASHost* host, const char* filename) {
+    unload();
+    {
+        std::lock_guard<std::mutex> lock(m_error_mutex);
+        m_error.clear();
+    }
+
+    m_host = host;
+    m_lua = luaL_newstate();
+    if (!m_lua) {
+        set_error("out of memory");
+        return false;
+    }
+    luaL_openlibs(m_lua);
+    register_functions(m_lua, this);
+
+    m_callback = LUA_NOREF;
+    m_deferred = false;
+    m_ranges.clear();
+    m_draw.clear();
+    m_failed = false;
+
+    // The main chunk sets up the watches and the callback
+    m_loading = true;
+    int result = luaL_dofile(m_lua, filename);
+    m_loading = false;
+    if (result != LUA_OK) {
+        set_error(lua_tostring(m_lua, -1));
+        unload();
+        return false;
+    }
+
+    build_snapshot_layout();
+    {
+        std::lock_guard<std::mutex> lock(m_overlay_mutex);
+        std::swap(m_overlay, m_draw);
+    }
+
+    if (m_deferred && m_callback != LUA_NOREF) {
+        m_stop = false;
+        m_has_pending = false;
+        m_thread = std::thread(&LuaScript::thread_main, this);
+    }
+    return true;
+}
+
+void LuaScript::unload() {
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+    }
+    if (m_lua) {
+        lua_close(m_lua);
+        m_lua = nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(m_overlay_mutex);
+    m_overlay.clear();
+}
+
+void LuaScript::on_frame(uint64_t frame) {
+    if (!m_lua || m_callback == LUA_NOREF) return;
+    if (m_failed) {
+        unload();
+        return;
+    }
+
+    m_capture.frame = frame;
+    if (!m_ranges.empty()) {
+        m_host->read_memory_ranges(m_ranges.data(), m_ranges.size(), m_capture.memory.data());
+    }
+
+    if (!m_deferred) {
+        std::swap(m_capture, m_current);
+        if (!run_callback()) unload();
+        return;
+    }
+
+    // Replaces the waiting snapshot if the script hasn't taken it yet
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::swap(m_pending, m_capture);
+        m_has_pending = true;
+    }
+    m_wake.notify_one();
+}
+
+void LuaScript::take_overlay(std::vector<TASDrawCommand>& commands) {
+    std::lock_guard<std::mutex> lock(m_overlay_mutex);
+    commands.assign(m_overlay.begin(), m_overlay.end());
+}
+
+const char* LuaScript::get_error() {
+    std::lock_guard<std::mutex> lock(m_error_mutex);
+    m_error_shown = m_error;
+    return m_error_shown.c_str();
+}
+
+void LuaScript::set_error(const char* message) {
+    std::lock_guard<std::mutex> lock(m_error_mutex);
+    m_error = message ? message : "unknown error";
+}
+
+// Merge the watched ranges and map every address to its place in the
+// snapshot
+void LuaScript::build_snapshot_layout() {
+    std::sort(m_ranges.begin(), m_ranges.end(),
+              [](const TASMemoryRange& a, const TASMemoryRange& b) { return a.address < b.address; });
+
+    std::vector<TASMemoryRange> merged;
+    for (const auto& range : m_ranges) {
+        if (!merged.empty() && range.address <= merged.back().address + merged.back().length) {
+            uint32_t end = std::max<uint32_t>(merged.back().address + merged.back().length,
+                                              range.address + range.length);
+            merged.back().length = end - merged.back().address;
+        } else {
+            merged.push_back(range);
+        }
+    }
+    m_ranges = std::move(merged);
+
+    m_offsets.assign(0x10000, -1);
+    m_snapshot_size = 0;
+    for (const auto& range : m_ranges) {
+        for (uint32_t i = 0; i < range.length; i++) {
+            m_offsets[range.address + i] = static_cast<int32_t>(m_snapshot_size + i);
+        }
+        m_snapshot_size += range.length;
+    }
+
+    m_capture.memory.assign(m_snapshot_size, 0);
+    m_current.memory.assign(m_snapshot_size, 0);
+    m_pending.memory.assign(m_snapshot_size, 0);
+}
+
+bool LuaScript::run_callback() {
+    m_draw.clear();
+    lua_rawgeti(m_lua, LUA_REGISTRYINDEX, m_callback);
+    if (lua_pcall(m_lua, 0, 0, 0) != LUA_OK) {
+        set_error(lua_tostring(m_lua, -1));
+        lua_pop(m_lua, 1);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_overlay_mutex);
+    std::swap(m_overlay, m_draw);
+    return true;
+}
+
+void LuaScript::thread_main() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_wake.wait(lock, [this] { return m_has_pending || m_stop; });
+        if (m_stop) return;
+        std::swap(m_pending, m_current);
+        m_has_pending = false;
+        lock.unlock();
+
+        if (!run_callback()) {
+            m_failed = true;
+            return;
+        }
+        lock.lock();
+    }
+}
+
+uint8_t LuaScript::read_byte(lua_State* L, uint32_t address) {
+    address &= 0xFFFF;
+    if (!m_loading) {
+        int32_t offset = m_offsets[address];
+        if (offset >= 0) return m_current.memory[offset];
+        if (m_deferred) {
+            char message[96];
+            std::snprintf(message, sizeof(message), "$%04X is not watched; deferred scripts need memory.watch()",
+                          address);
+            luaL_error(L, "%s", message);
+        }
+    }
+    // On the emulation thread, so the core can be read directly
+    return m_host->read_memory(static_cast<uint16_t>(address));
+}
+
+LuaScript& LuaScript::self(lua_State* L) {
+    return *static_cast<LuaScript*>(lua_touserdata(L, lua_upvalueindex(1)));
+}
+
+void LuaScript::register_functions(lua_State* L, LuaScript* script) {
+    static const luaL_Reg emu_functions[] = {
+        {"framecount", emu_framecount},
+        {"registerafter", emu_registerafter},
+        {"setdeferred", emu_setdeferred},
+        {nullptr, nullptr}
+    };
+    static const luaL_Reg memory_functions[] = {
+        {"watch", memory_watch},
+        {"readbyte", memory_readbyte},
+        {"readbytesigned", memory_readbytesigned},
+        {"readword", memory_readword},
+        {"readbyterange", memory_readbyterange},
+        {nullptr, nullptr}
+    };
+    static const luaL_Reg gui_functions[] = {
+        {"text", gui_text},
+        {"box", gui_box},
+        {"fillbox", gui_fillbox},
+        {"line", gui_line},
+        {"pixel", gui_pixel},
+        {nullptr, nullptr}
+    };
+
+    // Each function gets the script as its upvalue
+    auto add_table = [&](const char* name, const luaL_Reg* functions) {
+        lua_newtable(L);
+        lua_pushlightuserdata(L, script);
+        luaL_setfuncs(L, functions, 1);
+        lua_setglobal(L, name);
+    };
+    add_table("emu", emu_functions);
+    add_table("memory", memory_functions);
+    add_table("gui", gui_functions);
+}
+
+int LuaScript::emu_framecount(lua_State* L) {
+    LuaScript& script = self(L);
+    uint64_t frame = script.m_loading ? script.m_host->get_current_frame() : script.m_current.frame;
+    lua_pushinteger(L, static_cast<lua_Integer>(frame));
+    return 1;
+}
+
+// Setup calls are only taken while the main chunk runs, so the emulation
+// thread never sees them change under it
+int LuaScript::emu_registerafter(lua_State* L) {
+    LuaScript& script = self(L);
+    if (!script.m_loading) return luaL_error(L, "emu.registerafter() is only allowed while the script loads");
+    luaL_checktype(L, 1, LUA_TFUNCTION);
+
+    if (script.m_callback != LUA_NOREF) luaL_unref(L, LUA_REGISTRYINDEX, script.m_callback);
+    lua_pushvalue(L, 1);
+    script.m_callback = luaL_ref(L, LUA_REGISTRYINDEX);
+    return 0;
+}
+
+int LuaScript::emu_setdeferred(lua_State* L) {
+    LuaScript& script = self(L);
+    if (!script.m_loading) return luaL_error(L, "emu.setdeferred() is only allowed while the script loads");
+    script.m_deferred = lua_toboolean(L, 1) != 0;
+    return 0;
+}
+
+int LuaScript::memory_watch(lua_State* L) {
+    LuaScript& script = self(L);
+    if (!script.m_loading) return luaL_error(L, "memory.watch() is only allowed while the script loads");
+    lua_Integer address = luaL_checkinteger(L, 1);
+    lua_Integer length = luaL_optinteger(L, 2, 1);
+    luaL_argcheck(L, address >= 0 && address <= 0xFFFF, 1, "address out of range");
+    luaL_argcheck(L, length >= 1 && address + length <= 0x10000, 2, "length out of range");
+
+    script.m_ranges.push_back({static_cast<uint16_t>(address), static_cast<uint32_t>(length)});
+    return 0;
+}
+
+int LuaScript::memory_readbyte(lua_State* L) {
+    uint32_t address = static_cast<uint32_t>(luaL_checkinteger(L, 1));
+    lua_pushinteger(L, self(L).read_byte(L, address));
+    return 1;
+}
+
+int LuaScript::memory_readbytesigned(lua_State* L) {
+    uint32_t address = static_cast<uint32_t>(luaL_checkinteger(L, 1));
+    lua_pushinteger(L, static_cast<int8_t>(self(L).read_byte(L, address)));
+    return 1;
+}
+
+int LuaScript::memory_readword(lua_State* L) {
+    LuaScript& script = self(L);
+    uint32_t address = static_cast<uint32_t>(luaL_checkinteger(L, 1));
+    uint32_t low = script.read_byte(L, address);
+    uint32_t high = script.read_byte(L, address + 1);
+    lua_pushinteger(L, low | (high << 8));
+    return 1;
+}
+
+int LuaScript::memory_readbyterange(lua_State* L) {
+    LuaScript& script = self(L);
+    uint32_t address = static_cast<uint32_t>(luaL_checkinteger(L, 1));
+    lua_Integer length = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, length >= 0 && length <= 0x10000, 2, "length out of range");
+
+    luaL_Buffer buffer;
+    luaL_buffinit(L, &buffer);
+    for (lua_Integer i = 0; i < length; i++) {
+        luaL_addchar(&buffer, static_cast<char>(script.read_byte(L, address + static_cast<uint32_t>(i))));
+    }
+    luaL_pushresult(&buffer);
+    return 1;
+}
+
+int LuaScript::gui_text(lua_State* L) {
+    TASDrawCommand command{};
+    command.type = TASDrawType::Text;
+    command.x0 = static_cast<int16_t>(luaL_checkinteger(L, 1));
+    command.y0 = static_cast<int16_t>(luaL_checkinteger(L, 2));
+    size_t length = 0;
+    const char* text = luaL_checklstring(L, 3, &length);
+    std::memcpy(command.text, text, std::min(length, sizeof(command.text) - 1));
+    command.color = static_cast<uint32_t>(luaL_optinteger(L, 4, WHITE));
+
+    auto& commands = self(L).m_draw;
+    if (commands.size() < MAX_DRAW_COMMANDS) commands.push_back(command);
+    return 0;
+}
+
+int LuaScript::gui_box(lua_State* L) {
+    return draw(L, TASDrawType::Box, 2);
+}
+
+int LuaScript::gui_fillbox(lua_State* L) {
+    return draw(L, TASDrawType::FilledBox, 2);
+}
+
+int LuaScript::gui_line(lua_State* L) {
+    return draw(L, TASDrawType::Line, 2);
+}
+
+int LuaScript::gui_pixel(lua_State* L) {
+    return draw(L, TASDrawType::Pixel, 1);
+}
+
+// Shapes take their points' x and y, then an optional color
+int LuaScript::draw(lua_State* L, TASDrawType type, int points) {
+    TASDrawCommand command{};
+    command.type = type;
+    command.x0 = static_cast<int16_t>(luaL_checkinteger(L, 1));
+    command.y0 = static_cast<int16_t>(luaL_checkinteger(L, 2));
+    if (points == 2) {
+        command.x1 = static_cast<int16_t>(luaL_checkinteger(L, 3));
+        command.y1 = static_cast<int16_t>(luaL_checkinteger(L, 4));
+    }
+    command.color = static_cast<uint32_t>(luaL_optinteger(L, points * 2 + 1, WHITE));
+
+    auto& commands = self(L).m_draw;
+    if (commands.size() < MAX_DRAW_COMMANDS) commands.push_back(command);
+    return 0;
+}
+
+} // namespace emu
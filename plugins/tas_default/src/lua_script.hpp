@@ -0,0 +1,113 @@
+#pragma once
+
+#include "emu/tas_plugin.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct lua_State;
+
+namespace emu {
+
+// A Lua script with a per-frame callback
+//
+// Scripts name the memory they read with memory.watch() while they load,
+// and the plugin snapshots all of it with one read_memory_ranges() call a
+// frame, so memory.read*() is an array lookup rather than a trip through the
+// host per byte. gui.*() calls queue draw commands; the GUI thread picks up
+// the last finished frame's list with take_overlay().
+//
+// Scripts that call emu.setdeferred(true) while loading run their callback
+// on a thread of their own, one frame behind: the emulation thread only
+// hands over the snapshot. If the script is still busy when the next one
+// arrives the newer snapshot replaces the waiting one, so a slow script
+// skips frames instead of slowing the game. Deferred scripts can only read
+// watched memory.
+class LuaScript {
+public:
+    LuaScript() = default;
+    ~LuaScript();
+
+    LuaScript(const LuaScript&) = delete;
+    LuaScript& operator=(const LuaScript&) = delete;
+
+    // Run the script's main chunk. False if it fails to load or run.
+    bool load(ITASHost* host, const char* filename);
+    void unload();
+    bool is_running() const { return m_lua != nullptr && !m_failed; }
+
+    // Emulation thread, once a frame before the core runs it
+    void on_frame(uint64_t frame);
+
+    void take_overlay(std::vector<TASDrawCommand>& commands);
+    const char* get_error();
+
+private:
+    struct Snapshot {
+        uint64_t frame = 0;
+        std::vector<uint8_t> memory;    // Watched ranges, back to back
+    };
+
+    static LuaScript& self(lua_State* L);
+    static void register_functions(lua_State* L, LuaScript* script);
+
+    static int emu_framecount(lua_State* L);
+    static int emu_registerafter(lua_State* L);
+    static int emu_setdeferred(lua_State* L);
+    static int memory_watch(lua_State* L);
+    static int memory_readbyte(lua_State* L);
+    static int memory_readbytesigned(lua_State* L);
+    static int memory_readword(lua_State* L);
+    static int memory_readbyterange(lua_State* L);
+    static int gui_text(lua_State* L);
+    static int gui_box(lua_State* L);
+    static int gui_fillbox(lua_State* L);
+    static int gui_line(lua_State* L);
+    static int gui_pixel(lua_State* L);
+
+    static int draw(lua_State* L, TASDrawType type, int points);
+    uint8_t read_byte(lua_State* L, uint32_t address);
+
+    void build_snapshot_layout();
+    bool run_callback();
+    void thread_main();
+    void set_error(const char* message);
+
+    ITASHost* m_host = nullptr;
+    lua_State* m_lua = nullptr;
+    int m_callback = 0;                 // Registry reference, LUA_NOREF if none
+    bool m_loading = false;
+    bool m_deferred = false;
+
+    std::vector<TASMemoryRange> m_ranges;
+    std::vector<int32_t> m_offsets;     // Address to snapshot offset, -1 if unwatched
+    size_t m_snapshot_size = 0;
+
+    Snapshot m_capture;                 // Emulation thread
+    Snapshot m_current;                 // Whichever thread runs the callback
+    std::vector<TASDrawCommand> m_draw; // Being built by the callback
+
+    // Deferred mode
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    Snapshot m_pending;                 // Guarded by m_mutex
+    bool m_has_pending = false;         // Guarded by m_mutex
+    bool m_stop = false;                // Guarded by m_mutex
+    std::atomic<bool> m_failed{false};
+
+    std::mutex m_overlay_mutex;
+    std::vector<TASDrawCommand> m_overlay;
+
+    std::mutex m_error_mutex;
+    std::string m_error;
+    std::string m_error_shown;          // What get_error() last returned
+};
+
+} // namespace emu
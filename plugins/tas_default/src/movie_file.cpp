@@ -0,0 +1,332 @@
+#include "movie_file.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace emu {
+
+namespace {
+
+constexpr char MAGIC[4] = {'T', 'A', 'S', '2'};
+
+// Header layout
+constexpr size_t TITLE_OFFSET = 8;
+constexpr size_t AUTHOR_OFFSET = TITLE_OFFSET + sizeof(TASMovieInfo::title);
+constexpr size_t DESCRIPTION_OFFSET = AUTHOR_OFFSET + sizeof(TASMovieInfo::author);
+constexpr size_t PLATFORM_OFFSET = DESCRIPTION_OFFSET + sizeof(TASMovieInfo::description);
+constexpr size_t ROM_NAME_OFFSET = PLATFORM_OFFSET + sizeof(TASMovieInfo::platform);
+constexpr size_t CRC_OFFSET = ROM_NAME_OFFSET + sizeof(TASMovieInfo::rom_name);
+constexpr size_t FLAGS_OFFSET = CRC_OFFSET + 4;
+constexpr size_t FRAME_COUNT_OFFSET = FLAGS_OFFSET + 4;
+constexpr size_t RERECORD_OFFSET = FRAME_COUNT_OFFSET + 8;
+constexpr size_t STATE_OFFSET = RERECORD_OFFSET + 8;          // u64 offset, u64 size
+constexpr size_t COLUMNS_OFFSET = STATE_OFFSET + 16;          // u64 runs offset, u32 run count, u32 unused
+constexpr size_t COLUMN_ENTRY_SIZE = 16;
+constexpr size_t HEADER_SIZE = COLUMNS_OFFSET + MovieFile::COLUMN_COUNT * COLUMN_ENTRY_SIZE;
+
+constexpr uint32_t FLAG_STARTS_FROM_SAVESTATE = 1u << 0;
+
+// Event column bits
+constexpr uint32_t EVENT_RESET = 1u << 0;
+constexpr uint32_t EVENT_SAVESTATE = 1u << 1;
+constexpr int EVENT_SLOT_SHIFT = 16;
+
+constexpr size_t RUN_SIZE = 8;
+constexpr size_t INDEX_ENTRY_SIZE = 8;
+
+uint32_t get_u32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint64_t get_u64(const uint8_t* p) {
+    return get_u32(p) | (static_cast<uint64_t>(get_u32(p + 4)) << 32);
+}
+
+void put_u32(uint8_t* p, uint32_t value) {
+    for (int i = 0; i < 4; i++) p[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+void put_u64(uint8_t* p, uint64_t value) {
+    put_u32(p, static_cast<uint32_t>(value));
+    put_u32(p + 4, static_cast<uint32_t>(value >> 32));
+}
+
+void append_u32(std::vector<uint8_t>& out, uint32_t value) {
+    out.resize(out.size() + 4);
+    put_u32(out.data() + out.size() - 4, value);
+}
+
+// Copy a string field, always leaving it terminated
+void get_text(char* field, size_t size, const uint8_t* p) {
+    std::memcpy(field, p, size);
+    field[size - 1] = '\0';
+}
+
+uint32_t column_value(const TASFrameData& frame, int column) {
+    if (column < 4) return frame.controller_inputs[column];
+    return (frame.has_reset ? EVENT_RESET : 0) | (frame.has_savestate ? EVENT_SAVESTATE : 0) |
+           ((static_cast<uint32_t>(frame.savestate_slot) & 0xFFFF) << EVENT_SLOT_SHIFT);
+}
+
+} // namespace
+
+// ============================================================
+// MovieFile
+// ============================================================
+
+bool MovieFile::open(const char* path) {
+    close();
+    if (!m_file.open(path)) return false;
+
+    const uint8_t* data = m_file.data();
+    size_t size = m_file.size();
+    if (size < HEADER_SIZE || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0 ||
+        get_u32(data + 4) < HEADER_SIZE) {
+        close();
+        return false;
+    }
+
+    get_text(m_info.title, sizeof(m_info.title), data + TITLE_OFFSET);
+    get_text(m_info.author, sizeof(m_info.author), data + AUTHOR_OFFSET);
+    get_text(m_info.description, sizeof(m_info.description), data + DESCRIPTION_OFFSET);
+    get_text(m_info.platform, sizeof(m_info.platform), data + PLATFORM_OFFSET);
+    get_text(m_info.rom_name, sizeof(m_info.rom_name), data + ROM_NAME_OFFSET);
+    m_info.rom_crc32 = get_u32(data + CRC_OFFSET);
+    m_info.starts_from_savestate = (get_u32(data + FLAGS_OFFSET) & FLAG_STARTS_FROM_SAVESTATE) != 0;
+    m_info.frame_count = get_u64(data + FRAME_COUNT_OFFSET);
+    m_info.rerecord_count = get_u64(data + RERECORD_OFFSET);
+
+    uint64_t state_offset = get_u64(data + STATE_OFFSET);
+    uint64_t state_size = get_u64(data + STATE_OFFSET + 8);
+    if (state_offset > size || state_size > size - state_offset) {
+        close();
+        return false;
+    }
+    m_start_state = data + state_offset;
+    m_start_state_size = static_cast<size_t>(state_size);
+
+    // Every column must hold its runs and its index inside the file
+    uint64_t index_entries = (m_info.frame_count + INDEX_FRAMES - 1) / INDEX_FRAMES;
+    for (int c = 0; c < COLUMN_COUNT; c++) {
+        const uint8_t* entry = data + COLUMNS_OFFSET + c * COLUMN_ENTRY_SIZE;
+        uint64_t runs_offset = get_u64(entry);
+        uint32_t run_count = get_u32(entry + 8);
+        uint64_t bytes = run_count * RUN_SIZE + index_entries * INDEX_ENTRY_SIZE;
+        if ((m_info.frame_count > 0 && run_count == 0) || index_entries > size ||
+            runs_offset > size || bytes > size - runs_offset) {
+            close();
+            return false;
+        }
+        m_columns[c].runs = data + runs_offset;
+        m_columns[c].run_count = run_count;
+        m_columns[c].index = data + runs_offset + run_count * RUN_SIZE;
+    }
+    return true;
+}
+
+void MovieFile::close() {
+    m_file.close();
+    m_info = {};
+    m_start_state = nullptr;
+    m_start_state_size = 0;
+    for (Column& column : m_columns) column = {};
+}
+
+void MovieFile::set_column(TASFrameData& frame, int column, uint32_t value) {
+    if (column < 4) {
+        frame.controller_inputs[column] = value;
+        return;
+    }
+    frame.has_reset = (value & EVENT_RESET) != 0;
+    frame.has_savestate = (value & EVENT_SAVESTATE) != 0;
+    frame.savestate_slot = static_cast<int16_t>(value >> EVENT_SLOT_SHIFT);
+}
+
+TASFrameData MovieFile::frame(uint64_t frame) const {
+    TASFrameData data{};
+    data.frame_number = frame;
+    if (frame >= m_info.frame_count) return data;
+
+    for (int c = 0; c < COLUMN_COUNT; c++) {
+        const Column& column = m_columns[c];
+        const uint8_t* entry = column.index + (frame / INDEX_FRAMES) * INDEX_ENTRY_SIZE;
+        uint32_t run = get_u32(entry);
+        uint64_t offset = get_u32(entry + 4) + frame % INDEX_FRAMES;
+        while (run < column.run_count && offset >= get_u32(column.runs + run * RUN_SIZE + 4)) {
+            offset -= get_u32(column.runs + run * RUN_SIZE + 4);
+            run++;
+        }
+        if (run < column.run_count) set_column(data, c, get_u32(column.runs + run * RUN_SIZE));
+    }
+    return data;
+}
+
+void MovieFile::read_frames(std::vector<TASFrameData>& frames) const {
+    frames.assign(m_info.frame_count, TASFrameData{});
+    for (uint64_t i = 0; i < frames.size(); i++) frames[i].frame_number = i;
+
+    for (int c = 0; c < COLUMN_COUNT; c++) {
+        const Column& column = m_columns[c];
+        uint64_t next = 0;
+        for (uint32_t run = 0; run < column.run_count && next < frames.size(); run++) {
+            uint32_t value = get_u32(column.runs + run * RUN_SIZE);
+            uint64_t end = std::min<uint64_t>(next + get_u32(column.runs + run * RUN_SIZE + 4), frames.size());
+            for (; next < end; next++) set_column(frames[next], c, value);
+        }
+    }
+}
+
+bool MovieFile::save(const char* path, const TASMovieInfo& info, const std::vector<uint8_t>& start_state,
+                     const std::vector<TASFrameData>& frames) {
+    std::vector<uint8_t> out(HEADER_SIZE, 0);
+    std::memcpy(out.data(), MAGIC, sizeof(MAGIC));
+    put_u32(out.data() + 4, static_cast<uint32_t>(HEADER_SIZE));
+    std::memcpy(out.data() + TITLE_OFFSET, info.title, sizeof(info.title));
+    std::memcpy(out.data() + AUTHOR_OFFSET, info.author, sizeof(info.author));
+    std::memcpy(out.data() + DESCRIPTION_OFFSET, info.description, sizeof(info.description));
+    std::memcpy(out.data() + PLATFORM_OFFSET, info.platform, sizeof(info.platform));
+    std::memcpy(out.data() + ROM_NAME_OFFSET, info.rom_name, sizeof(info.rom_name));
+    put_u32(out.data() + CRC_OFFSET, info.rom_crc32);
+    put_u32(out.data() + FLAGS_OFFSET, info.starts_from_savestate ? FLAG_STARTS_FROM_SAVESTATE : 0);
+    put_u64(out.data() + FRAME_COUNT_OFFSET, frames.size());
+    put_u64(out.data() + RERECORD_OFFSET, info.rerecord_count);
+
+    const std::vector<uint8_t> no_state;
+    const std::vector<uint8_t>& state = info.starts_from_savestate ? start_state : no_state;
+    put_u64(out.data() + STATE_OFFSET, out.size());
+    put_u64(out.data() + STATE_OFFSET + 8, state.size());
+    out.insert(out.end(), state.begin(), state.end());
+
+    std::vector<uint8_t> runs;
+    std::vector<uint8_t> index;
+    for (int c = 0; c < COLUMN_COUNT; c++) {
+        runs.clear();
+        index.clear();
+        uint32_t run_count = 0;
+        for (uint64_t f = 0; f < frames.size(); f++) {
+            uint32_t value = column_value(frames[f], c);
+            uint8_t* last = run_count > 0 ? runs.data() + runs.size() - RUN_SIZE : nullptr;
+            uint32_t offset = 0;
+            if (last && get_u32(last) == value && get_u32(last + 4) < UINT32_MAX) {
+                offset = get_u32(last + 4);
+                put_u32(last + 4, offset + 1);
+            } else {
+                append_u32(runs, value);
+                append_u32(runs, 1);
+                run_count++;
+            }
+            if (f % INDEX_FRAMES == 0) {
+                append_u32(index, run_count - 1);
+                append_u32(index, offset);
+            }
+        }
+
+        uint8_t* entry = out.data() + COLUMNS_OFFSET + c * COLUMN_ENTRY_SIZE;
+        put_u64(entry, out.size());
+        put_u32(entry + 8, run_count);
+        out.insert(out.end(), runs.begin(), runs.end());
+        out.insert(out.end(), index.begin(), index.end());
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+    return static_cast<bool>(file);
+}
+
+// ============================================================
+// FM2 import
+// ============================================================
+
+bool load_fm2(const char* path, std::vector<TASFrameData>& frames) {
+    MappedFile file;
+    if (!file.open(path) || file.size() == 0) return false;
+
+    frames.clear();
+    const char* p = reinterpret_cast<const char*>(file.data());
+    const char* end = p + file.size();
+
+    while (p < end) {
+        const char* line_end = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (!line_end) line_end = end;
+
+        // Frame line: |commands|port0|port1|port2|
+        if (*p == '|') {
+            TASFrameData frame{};
+            frame.frame_number = frames.size();
+
+            const char* q = p + 1;
+            uint32_t commands = 0;
+            for (; q < line_end && *q >= '0' && *q <= '9'; q++) commands = commands * 10 + (*q - '0');
+            frame.has_reset = (commands & 3) != 0;
+
+            for (int port = 0; port < 4 && q < line_end && *q == '|'; port++) {
+                const char* field = ++q;
+                while (q < line_end && *q != '|') q++;
+                if (q - field < 8) continue;
+
+                uint32_t buttons = 0;
+                for (int i = 0; i < 8; i++) {
+                    if (field[i] != '.' && field[i] != ' ') buttons |= 0x80u >> i;
+                }
+                frame.controller_inputs[port] = buttons;
+            }
+
+            frames.push_back(frame);
+        }
+        p = line_end + 1;
+    }
+    return true;
+}
+
+// ============================================================
+// Any format
+// ============================================================
+
+bool load_movie(const char* path, TASMovieInfo& info, std::vector<uint8_t>& start_state,
+                std::vector<TASFrameData>& frames, bool* imported) {
+    start_state.clear();
+    if (imported) *imported = false;
+
+    MovieFile movie;
+    if (movie.open(path)) {
+        info = movie.info();
+        if (info.starts_from_savestate) {
+            start_state.assign(movie.start_state(), movie.start_state() + movie.start_state_size());
+        }
+        movie.read_frames(frames);
+        return true;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    // Version 1: raw TASMovieInfo and TASFrameData structs
+    char magic[4];
+    file.read(magic, 4);
+    if (std::strncmp(magic, "TAS1", 4) != 0) {
+        if (!load_fm2(path, frames)) return false;
+        info = TASMovieInfo{};
+        info.frame_count = frames.size();
+        if (imported) *imported = true;
+        return true;
+    }
+
+    file.read(reinterpret_cast<char*>(&info), sizeof(info));
+
+    if (info.starts_from_savestate) {
+        uint32_t state_size;
+        file.read(reinterpret_cast<char*>(&state_size), sizeof(state_size));
+        start_state.resize(state_size);
+        file.read(reinterpret_cast<char*>(start_state.data()), state_size);
+    }
+
+    frames.resize(info.frame_count);
+    for (uint64_t i = 0; i < info.frame_count; i++) {
+        file.read(reinterpret_cast<char*>(&frames[i]), sizeof(TASFrameData));
+    }
+    return true;
+}
+
+} // namespace emu
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "core/mapped_file.hpp"
+#include "emu/tas_plugin.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace emu {
+
+// .tas v2 movie files
+//
+// Fixed-size little-endian header (movie info, then where everything else
+// lives), the start state if any, then five columns: one per controller and
+// one of frame events (reset, savestate slot). Each column is a list of
+// (value, length) runs, since held buttons repeat for many frames, followed
+// by an index giving the run at every INDEX_FRAMES-th frame, so any frame is
+// found by walking at most INDEX_FRAMES frames of runs.
+//
+// MovieFile reads a mapped file in place: opening one only parses the
+// header, and decoding touches just the column pages it needs.
+class MovieFile {
+public:
+    static constexpr uint32_t INDEX_FRAMES = 1024;
+    static constexpr int COLUMN_COUNT = 5;
+
+    // False if path is not a readable v2 movie
+    bool open(const char* path);
+    void close();
+
+    const TASMovieInfo& info() const { return m_info; }
+    uint64_t frame_count() const { return m_info.frame_count; }
+    const uint8_t* start_state() const { return m_start_state; }
+    size_t start_state_size() const { return m_start_state_size; }
+
+    // One frame, through the index
+    TASFrameData frame(uint64_t frame) const;
+
+    // Every frame, decoding the runs in order
+    void read_frames(std::vector<TASFrameData>& frames) const;
+
+    static bool save(const char* path, const TASMovieInfo& info, const std::vector<uint8_t>& start_state,
+                     const std::vector<TASFrameData>& frames);
+
+private:
+    struct Column {
+        const uint8_t* runs = nullptr;      // (u32 value, u32 length) each
+        uint32_t run_count = 0;
+        const uint8_t* index = nullptr;     // (u32 run, u32 offset into it) each
+    };
+
+    static void set_column(TASFrameData& frame, int column, uint32_t value);
+
+    MappedFile m_file;
+    TASMovieInfo m_info{};
+    const uint8_t* m_start_state = nullptr;
+    size_t m_start_state_size = 0;
+    Column m_columns[COLUMN_COUNT];
+};
+
+// FCEUX .fm2 input log, parsed in place from the mapped file. Each port's
+// buttons are read as "RLDUTSBA" from bit 7 down; commands 1 and 2 (soft
+// and hard reset) set has_reset.
+bool load_fm2(const char* path, std::vector<TASFrameData>& frames);
+
+// Any movie the TAS plugin opens: .tas v2, the raw-struct .tas v1 it
+// replaced, or .fm2 (which has no movie info beyond its frame count).
+// start_state is left empty unless the movie starts from a savestate;
+// imported, if given, is set for an FM2 import.
+bool load_movie(const char* path, TASMovieInfo& info, std::vector<uint8_t>& start_state,
+                std::vector<TASFrameData>& frames, bool* imported = nullptr);
+
+} // namespace emu
@@ -0,0 +1,101 @@
+#include "movie_verifier.hpp"
+#include "emu/netplay_plugin.hpp"
+
+#include <algorithm>
+
+namespace emu {
+
+namespace {
+
+// Longest run between checks for cancellation
+constexpr size_t BATCH_FRAMES = 600;
+
+} // namespace
+
+MovieVerifier::~MovieVerifier() {
+    cancel();
+}
+
+bool MovieVerifier::start(ITASHost* host, std::vector<uint8_t>&& start_state, std::vector<uint32_t>&& inputs,
+                          std::vector<uint8_t>&& end_state) {
+    cancel();
+    if (!host) return false;
+
+    m_core = host->create_emulator_clone();
+    if (!m_core) return false;
+
+    m_host = host;
+    m_start_state = std::move(start_state);
+    m_end_state = std::move(end_state);
+    m_inputs.resize(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) m_inputs[i].buttons = inputs[i];
+
+    m_result = {};
+    m_result.frames_total = m_inputs.size();
+    m_frames_done.store(0, std::memory_order_relaxed);
+    m_cancel.store(false, std::memory_order_relaxed);
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread([this] { run(); });
+    return true;
+}
+
+void MovieVerifier::cancel() {
+    m_cancel.store(true, std::memory_order_relaxed);
+    release();
+    m_result = {};
+}
+
+void MovieVerifier::poll(TASVerifyStatus& status) {
+    bool running = m_running.load(std::memory_order_acquire);
+    status = {};
+    if (running) {
+        status.frames_total = m_result.frames_total;
+    } else {
+        release();
+        status = m_result;
+    }
+    status.running = running;
+    status.frames_done = m_frames_done.load(std::memory_order_relaxed);
+}
+
+void MovieVerifier::release() {
+    if (m_thread.joinable()) m_thread.join();
+    if (m_core) m_host->destroy_emulator_clone(m_core);
+    m_core = nullptr;
+    m_running.store(false, std::memory_order_release);
+}
+
+void MovieVerifier::run() {
+    // The clone's video and audio output are off; the flags also spare the
+    // core the work it does between frames of a batch
+    const RunFlags flags = RUN_FLAGS_SKIP_VIDEO | RUN_FLAGS_SKIP_AUDIO;
+    auto* netplay = dynamic_cast<INetplayCapable*>(m_core);
+
+    bool ok = true;
+    if (m_start_state.empty()) {
+        m_core->reset();
+    } else {
+        ok = m_core->load_state(m_start_state);
+    }
+
+    size_t done = 0;
+    while (ok && done < m_inputs.size() && !m_cancel.load(std::memory_order_relaxed)) {
+        size_t count = std::min(BATCH_FRAMES, m_inputs.size() - done);
+        m_core->run_frames(&m_inputs[done], count, flags);
+        m_core->clear_audio_buffer();
+        done += count;
+        m_frames_done.store(done, std::memory_order_relaxed);
+    }
+
+    if (ok && done == m_inputs.size()) {
+        m_result.done = true;
+        m_result.state_hash = netplay ? netplay->get_state_hash() : 0;
+        if (netplay && !m_end_state.empty() && m_core->load_state(m_end_state)) {
+            m_result.checked = true;
+            m_result.matches = netplay->get_state_hash() == m_result.state_hash;
+        }
+    }
+    m_running.store(false, std::memory_order_release);
+}
+
+} // namespace emu
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "emu/emulator_plugin.hpp"
+#include "emu/tas_plugin.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace emu {
+
+// Replays a whole movie on a cloned core as fast as the core allows
+//
+// The clone runs controller 1's input from the movie's start in long
+// run_frames() batches with drawing and audio skipped, checking for
+// cancellation between batches, and hashes the state it ends on. Given the
+// state normal playback left after the last frame, it loads that into the
+// clone afterwards and compares the two hashes, so a fast path that drifts
+// from ordinary playback shows up as a mismatch.
+class MovieVerifier {
+public:
+    MovieVerifier() = default;
+    ~MovieVerifier();
+
+    MovieVerifier(const MovieVerifier&) = delete;
+    MovieVerifier& operator=(const MovieVerifier&) = delete;
+
+    // Run inputs (controller 1 buttons) from start_state, or from power-on
+    // if it's empty; end_state is normal playback's, or empty if unknown.
+    // Replaces any run in progress. False if the host made no core.
+    bool start(ITASHost* host, std::vector<uint8_t>&& start_state, std::vector<uint32_t>&& inputs,
+               std::vector<uint8_t>&& end_state);
+    void cancel();
+
+    // Progress and, once done, the result. Joins the thread and gives the
+    // core back when it has finished (main thread).
+    void poll(TASVerifyStatus& status);
+
+private:
+    void run();
+    void release();
+
+    ITASHost* m_host = nullptr;
+    IEmulatorPlugin* m_core = nullptr;
+    std::thread m_thread;
+    std::atomic<bool> m_cancel{false};
+    std::atomic<bool> m_running{false};
+    std::atomic<uint64_t> m_frames_done{0};
+
+    std::vector<uint8_t> m_start_state;
+    std::vector<InputState> m_inputs;
+    std::vector<uint8_t> m_end_state;
+
+    // Written by the thread before m_running clears
+    TASVerifyStatus m_result;
+};
+
+} // namespace emu
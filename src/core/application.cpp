@@ -7,6 +7,9 @@
 #include "savestate_manager.hpp"
 #include "paths_config.hpp"
 #include "screenshot.hpp"
+#include "trace_writer.hpp"
+#include "av_encoder.hpp"
+#include "frame_pacer.hpp"
 #include "gui/gui_manager.hpp"
 #include "gui/notification_manager.hpp"
 #include "emu/controller_layout.hpp"
@@ -15,15 +18,42 @@
 #include <SDL.h>
 #include <iostream>
 #include <fstream>
+#include <cstdlib>
 #include <cstring>
 #include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
 #include <filesystem>
+#include <future>
 
 namespace emu {
 
 // Global application instance
 static Application* g_application = nullptr;
 
+// Set on the emulation thread, so commands posted from it run at once
+static thread_local bool t_on_emulation_thread = false;
+
+// Main loop pacing when vsync is off
+static constexpr double GUI_FRAME_TIME = 1.0 / 60.0;
+
+// While the GUI is idle, frames drawn after each event (for hover states
+// and the like to settle) and the longest wait for the next event
+static constexpr int IDLE_REDRAW_FRAMES = 3;
+static constexpr uint32_t IDLE_WAKEUP_MS = 250;
+
+// Refresh measurement for PresentMode::DisplayLocked: the period is
+// averaged over windows this long, and a gap between swaps longer than
+// the stall limit (a modal drag, a hidden window) starts a new window
+static constexpr uint64_t REFRESH_WINDOW_NS = 500000000;
+static constexpr uint64_t REFRESH_STALL_NS = 100000000;
+
+// Longest the GUI holds off drawing for the next frame with
+// PresentMode::VariableRefresh, so it stays responsive if emulation stalls
+static constexpr double VRR_MAX_WAIT = 1.0 / 20.0;
+
 Application& get_application() {
     return *g_application;
 }
@@ -45,6 +75,59 @@ void Application::print_usage(const char* program_name) {
     std::cout << "  -h, --help       Show this help message and exit\n";
     std::cout << "  -v, --version    Show version information and exit\n";
     std::cout << "  -d, --debug      Enable debug mode (show CPU/PPU state)\n";
+    std::cout << "  --no-preload     Don't load the last used core in the background at\n";
+    std::cout << "                   startup; cores then load on the first ROM\n";
+    std::cout << "  --warm-roms MB   Keep games switched away from loaded, up to MB of\n";
+    std::cout << "                   memory, so switching back is instant (default 0: off)\n";
+    std::cout << "  --memory-budget MB  Total for rewind, instant replay, RAM recording, warm\n";
+    std::cout << "                   ROMs and the TAS greenzone; the least important give\n";
+    std::cout << "                   memory back first (default 0: each keeps its own)\n";
+    std::cout << "  --low-memory     Smaller defaults and a 256 MB total, for laptops\n";
+    std::cout << "  --benchmark      Run ROM_FILE headless as fast as possible and print\n";
+    std::cout << "                   a JSON performance report\n";
+    std::cout << "\n";
+    std::cout << "Benchmark Options:\n";
+    std::cout << "  --frames N       Number of frames to run (default 600)\n";
+    std::cout << "  --movie PATH     Feed controller 1 input from an FM2 movie\n";
+    std::cout << "  --video          Draw every frame (off by default)\n";
+    std::cout << "  --audio          Generate audio every frame (off by default)\n";
+    std::cout << "  --report PATH    Write the report to PATH instead of stdout\n";
+    std::cout << "\n";
+    std::cout << "Job Runner Options:\n";
+    std::cout << "  --jobs PATH      Run the jobs in a JSON job list headless, in parallel on\n";
+    std::cout << "                   independent core instances, and print a JSON report\n";
+    std::cout << "                   (--report PATH writes it to a file instead)\n";
+    std::cout << "  --threads N      Worker threads (default: one per hardware thread)\n";
+    std::cout << "  --no-pin         Don't pin worker threads to CPUs\n";
+    std::cout << "\n";
+    std::cout << "Tracing Options:\n";
+    std::cout << "  --trace PATH     Record frame phases from startup and save them to PATH\n";
+    std::cout << "                   as Chrome trace JSON on exit (needs a build with\n";
+    std::cout << "                   VELOCE_ENABLE_TRACING)\n";
+    std::cout << "  --cpu-trace PATH Record every instruction the CPU runs and save the last\n";
+    std::cout << "                   million to PATH on exit (veloce_trace_decode reads it)\n";
+    std::cout << "\n";
+    std::cout << "Recording Options:\n";
+    std::cout << "  --record PATH    Run ROM_FILE headless and record every frame to PATH.y4m\n";
+    std::cout << "                   and PATH.wav (uncompressed), as fast as they can be\n";
+    std::cout << "                   written\n";
+    std::cout << "\n";
+    std::cout << "Emulation Thread Options:\n";
+    std::cout << "  --priority LEVEL Scheduling class: normal (default), high or realtime\n";
+    std::cout << "                   (MMCSS \"Games\" on Windows, nice/SCHED_FIFO on Linux,\n";
+    std::cout << "                   QoS class on macOS)\n";
+    std::cout << "  --pin-emulation  Keep the emulation thread on one performance core\n";
+    std::cout << "                   (Linux and Windows)\n";
+    std::cout << "  --max-performance  Keep the CPU out of power-saving states while running\n";
+    std::cout << "\n";
+    std::cout << "Audio Options:\n";
+    std::cout << "  --audio-backend NAME  Output through SDL (default) or ALSA, written\n";
+    std::cout << "                   directly (Linux builds with VELOCE_ALSA_AUDIO)\n";
+    std::cout << "\n";
+    std::cout << "Remote Control Options:\n";
+    std::cout << "  --control PORT   Accept batched control commands on 127.0.0.1:PORT (see\n";
+    std::cout << "                   control_server.hpp); emulation pauses while a client\n";
+    std::cout << "                   drives it. With HEADLESS=1 only the client runs frames.\n";
     std::cout << "\n";
     std::cout << "Environment Variables:\n";
     std::cout << "  DEBUG=1          Enable debug output\n";
@@ -62,6 +145,8 @@ void Application::print_usage(const char* program_name) {
     std::cout << "  " << program_name << " --debug game.nes                # Load with debug mode\n";
     std::cout << "  " << program_name << "                                 # Start without loading a ROM\n";
     std::cout << "  HEADLESS=1 FRAMES=600 " << program_name << " test.sfc  # Run test ROM headless\n";
+    std::cout << "  " << program_name << " --benchmark --frames 3600 game.sfc  # Measure core speed\n";
+    std::cout << "  " << program_name << " --jobs jobs.json --threads 8    # Run a batch of jobs\n";
 }
 
 void Application::print_version() {
@@ -88,6 +173,102 @@ bool Application::parse_command_line(int argc, char* argv[], std::string& rom_pa
             m_debug_mode = true;
             std::cout << "Debug mode enabled\n";
         }
+        else if (std::strcmp(arg, "--benchmark") == 0) {
+            m_benchmark_mode = true;
+        }
+        else if (std::strcmp(arg, "--no-preload") == 0) {
+            m_preload_core = false;
+        }
+        else if (std::strcmp(arg, "--low-memory") == 0) {
+            m_low_memory = true;
+        }
+        else if (std::strcmp(arg, "--no-pin") == 0) {
+            m_runner_options.pin_threads = false;
+        }
+        else if (std::strcmp(arg, "--pin-emulation") == 0) {
+            m_pin_emulation = true;
+        }
+        else if (std::strcmp(arg, "--max-performance") == 0) {
+            m_max_performance = true;
+        }
+        else if (std::strcmp(arg, "--video") == 0) {
+            m_benchmark_options.video = true;
+        }
+        else if (std::strcmp(arg, "--audio") == 0) {
+            m_benchmark_options.audio = true;
+        }
+        else if (std::strcmp(arg, "--frames") == 0 || std::strcmp(arg, "--movie") == 0 ||
+                 std::strcmp(arg, "--report") == 0 || std::strcmp(arg, "--trace") == 0 ||
+                 std::strcmp(arg, "--cpu-trace") == 0 || std::strcmp(arg, "--jobs") == 0 || std::strcmp(arg, "--threads") == 0 ||
+                 std::strcmp(arg, "--record") == 0 || std::strcmp(arg, "--control") == 0 ||
+                 std::strcmp(arg, "--audio-backend") == 0 || std::strcmp(arg, "--priority") == 0 ||
+                 std::strcmp(arg, "--warm-roms") == 0 || std::strcmp(arg, "--memory-budget") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << "\n";
+                return false;
+            }
+            const char* value = argv[++i];
+            if (std::strcmp(arg, "--frames") == 0) {
+                m_benchmark_options.frames = std::atoi(value);
+                if (m_benchmark_options.frames <= 0) {
+                    std::cerr << "Invalid frame count: " << value << "\n";
+                    return false;
+                }
+            } else if (std::strcmp(arg, "--movie") == 0) {
+                m_benchmark_options.movie_path = value;
+            } else if (std::strcmp(arg, "--trace") == 0) {
+                m_trace_path = value;
+            } else if (std::strcmp(arg, "--cpu-trace") == 0) {
+                m_cpu_trace_path = value;
+            } else if (std::strcmp(arg, "--jobs") == 0) {
+                m_jobs_path = value;
+            } else if (std::strcmp(arg, "--record") == 0) {
+                m_record_path = value;
+            } else if (std::strcmp(arg, "--control") == 0) {
+                int port = std::atoi(value);
+                if (port <= 0 || port > 65535) {
+                    std::cerr << "Invalid control port: " << value << "\n";
+                    return false;
+                }
+                m_control_port = static_cast<uint16_t>(port);
+            } else if (std::strcmp(arg, "--audio-backend") == 0) {
+                if (!parse_audio_backend_name(value, m_audio_backend)) {
+                    std::cerr << "Unknown audio backend: " << value << "\n";
+                    return false;
+                }
+                if (!is_audio_backend_available(m_audio_backend)) {
+                    std::cerr << "--audio-backend: this build has no " << value << " backend\n";
+                    return false;
+                }
+            } else if (std::strcmp(arg, "--priority") == 0) {
+                if (!parse_thread_priority_name(value, m_emulation_priority)) {
+                    std::cerr << "Unknown priority: " << value << " (normal, high or realtime)\n";
+                    return false;
+                }
+            } else if (std::strcmp(arg, "--warm-roms") == 0) {
+                int mb = std::atoi(value);
+                if (mb < 0 || (mb == 0 && std::strcmp(value, "0") != 0)) {
+                    std::cerr << "Invalid warm ROM budget: " << value << "\n";
+                    return false;
+                }
+                m_warm_rom_mb = static_cast<size_t>(mb);
+            } else if (std::strcmp(arg, "--memory-budget") == 0) {
+                int mb = std::atoi(value);
+                if (mb < 0 || (mb == 0 && std::strcmp(value, "0") != 0)) {
+                    std::cerr << "Invalid memory budget: " << value << "\n";
+                    return false;
+                }
+                m_memory_budget_mb = static_cast<size_t>(mb);
+            } else if (std::strcmp(arg, "--threads") == 0) {
+                m_runner_options.threads = std::atoi(value);
+                if (m_runner_options.threads <= 0) {
+                    std::cerr << "Invalid thread count: " << value << "\n";
+                    return false;
+                }
+            } else {
+                m_benchmark_options.report_path = value;
+            }
+        }
         else if (arg[0] == '-') {
             std::cerr << "Unknown option: " << arg << "\n";
             std::cerr << "Use --help for usage information.\n";
@@ -110,12 +291,29 @@ bool Application::initialize(int argc, char* argv[]) {
         return true;  // Not an error, just exit gracefully
     }
 
+    // Trace from startup when asked to on the command line
+    m_tracer.set_thread_name("main");
+    if (!m_trace_path.empty()) {
+        if (!Tracer::compiled_in()) {
+            std::cerr << "--trace: this build has no tracing (configure with -DVELOCE_ENABLE_TRACING=ON)\n";
+        }
+        start_trace();
+    }
+    if (!m_cpu_trace_path.empty()) {
+        start_cpu_trace();  // Handed to the core when the ROM loads
+    }
+
     // Check for HEADLESS environment variable
     const char* headless_env = std::getenv("HEADLESS");
     if (headless_env && headless_env[0] != '0') {
         m_headless_mode = true;
     }
 
+    // Benchmarks, job runs and recordings are headless
+    if (m_benchmark_mode || !m_jobs_path.empty() || !m_record_path.empty()) {
+        m_headless_mode = true;
+    }
+
     // Check for FRAMES environment variable
     const char* frames_env = std::getenv("FRAMES");
     if (frames_env) {
@@ -150,22 +348,6 @@ bool Application::initialize(int argc, char* argv[]) {
         }
     }
 
-    // In headless mode, skip most GUI/SDL initialization
-    if (!m_headless_mode) {
-        // Initialize SDL
-        if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMECONTROLLER) < 0) {
-            std::cerr << "Failed to initialize SDL: " << SDL_GetError() << std::endl;
-            return false;
-        }
-
-        // Create subsystems
-        m_window_manager = std::make_unique<WindowManager>();
-        m_renderer = std::make_unique<Renderer>();
-        m_input_manager = std::make_unique<InputManager>();
-        m_audio_manager = std::make_unique<AudioManager>();
-        m_gui_manager = std::make_unique<GuiManager>();
-    }
-
     m_plugin_manager = std::make_unique<PluginManager>();
     m_savestate_manager = std::make_unique<SavestateManager>();
     m_paths_config = std::make_unique<PathsConfiguration>();
@@ -176,61 +358,64 @@ bool Application::initialize(int argc, char* argv[]) {
     m_paths_config->load();
     m_paths_config->ensure_directories_exist();
 
-    if (!m_headless_mode) {
-        // Initialize window
-        WindowConfig window_config;
-        window_config.title = "Veloce";
-        window_config.width = 1024;
-        window_config.height = 768;
-
-        if (!m_window_manager->initialize(window_config)) {
-            std::cerr << "Failed to initialize window manager" << std::endl;
-            return false;
+    // Plugin discovery, plugins.json and the ROM itself need neither SDL
+    // nor GL, so a worker reads them while this thread brings up the
+    // window. The ROM is read and starts hashing before the registry is scanned,
+    // and its core's library starts loading as soon as the scan finds it.
+    bool plugins_ok = false;
+    std::thread startup_worker([this, &rom_path, &plugins_ok]() {
+        if (!rom_path.empty()) {
+            m_plugin_manager->prefetch_rom(rom_path);
         }
 
-        // Initialize renderer
-        if (!m_renderer->initialize(*m_window_manager)) {
-            std::cerr << "Failed to initialize renderer" << std::endl;
-            return false;
+        plugins_ok = m_plugin_manager->initialize();
+        if (!plugins_ok) return;
+        if (!rom_path.empty()) {
+            m_plugin_manager->preload_emulator_plugin_for_file(rom_path);
         }
 
-        // Initialize input
-        if (!m_input_manager->initialize()) {
-            std::cerr << "Failed to initialize input manager" << std::endl;
-            return false;
-        }
+        // Set paths configuration for plugin manager (for battery saves)
+        m_plugin_manager->set_paths_config(m_paths_config.get());
 
-        // Initialize audio
-        if (!m_audio_manager->initialize()) {
-            std::cerr << "Failed to initialize audio manager" << std::endl;
-            return false;
-        }
-    }
+        // Load plugin configuration from config directory
+        std::filesystem::path plugin_config_path = m_paths_config->get_config_directory() / "plugins.json";
+        m_plugin_manager->load_config(plugin_config_path.string());
+    });
 
-    // Initialize plugin manager
-    if (!m_plugin_manager->initialize()) {
+    // In headless mode, skip most GUI/SDL initialization
+    bool display_ok = m_headless_mode || initialize_display();
+    startup_worker.join();
+    if (!display_ok) {
+        return false;
+    }
+    if (!plugins_ok) {
         std::cerr << "Failed to initialize plugin manager" << std::endl;
         return false;
     }
 
-    // Set paths configuration for plugin manager (for battery saves)
-    m_plugin_manager->set_paths_config(m_paths_config.get());
-
-    // Load plugin configuration from config directory
-    std::filesystem::path plugin_config_path = m_paths_config->get_config_directory() / "plugins.json";
-    m_plugin_manager->load_config(plugin_config_path.string());
+    m_plugin_manager->set_warm_rom_budget(m_warm_rom_mb << 20);
 
-    if (!m_headless_mode) {
-        // Initialize GUI
-        if (!m_gui_manager->initialize(*m_window_manager)) {
-            std::cerr << "Failed to initialize GUI manager" << std::endl;
-            return false;
-        }
+    size_t memory_budget = m_memory_budget_mb << 20;
+    if (m_low_memory && memory_budget == 0) {
+        memory_budget = MemoryBudget::LOW_MEMORY_TOTAL;
     }
+    m_memory_budget.set_total(memory_budget);
+    register_memory_consumers();
 
     // Initialize savestate manager with paths configuration
     m_savestate_manager->initialize(m_plugin_manager.get(), m_paths_config.get());
 
+    // Saves report success as soon as they're queued; a write that fails
+    // later on the savestate I/O thread is reported here
+    m_savestate_manager->set_write_callback([this](const std::string& path, bool ok) {
+        if (ok) return;
+        run_on_main_thread([this, path]() {
+            if (m_gui_manager) {
+                m_gui_manager->get_notification_manager().error("Failed to write savestate: " + path);
+            }
+        });
+    });
+
     // Set this application as the netplay host for the plugin manager
     m_plugin_manager->set_netplay_host(this);
 
@@ -239,6 +424,15 @@ bool Application::initialize(int argc, char* argv[]) {
         netplay_plugin->initialize(this);
     }
 
+    // The audio manager hosts the audio plugin, which runs its effects on
+    // the output path
+    if (m_audio_manager) {
+        m_plugin_manager->set_audio_host(m_audio_manager.get());
+        if (auto* audio_plugin = m_plugin_manager->get_audio_plugin()) {
+            audio_plugin->initialize(m_audio_manager.get());
+        }
+    }
+
     // Load ROM if provided on command line
     if (!rom_path.empty()) {
         if (!load_rom(rom_path)) {
@@ -249,6 +443,11 @@ bool Application::initialize(int argc, char* argv[]) {
         }
     }
 
+    // With the window up, get the core a ROM will most likely need ready
+    if (!m_headless_mode && m_preload_core) {
+        m_plugin_manager->preload_emulator_plugin();
+    }
+
     m_running = true;
     if (!m_headless_mode) {
         m_last_frame_time = WindowManager::get_ticks();
@@ -257,21 +456,137 @@ bool Application::initialize(int argc, char* argv[]) {
     return true;
 }
 
+bool Application::initialize_display() {
+    // Initialize SDL
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMECONTROLLER) < 0) {
+        std::cerr << "Failed to initialize SDL: " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    // Create subsystems
+    m_window_manager = std::make_unique<WindowManager>();
+    m_renderer = std::make_unique<Renderer>();
+    m_input_manager = std::make_unique<InputManager>();
+    m_audio_manager = std::make_unique<AudioManager>();
+    m_gui_manager = std::make_unique<GuiManager>();
+
+    // Initialize window
+    WindowConfig window_config;
+    window_config.title = "Veloce";
+    window_config.width = 1024;
+    window_config.height = 768;
+
+    if (!m_window_manager->initialize(window_config)) {
+        std::cerr << "Failed to initialize window manager" << std::endl;
+        return false;
+    }
+
+    // Initialize renderer
+    if (!m_renderer->initialize(*m_window_manager)) {
+        std::cerr << "Failed to initialize renderer" << std::endl;
+        return false;
+    }
+
+    // Put something on screen while the plugins are still loading
+    m_renderer->clear();
+    m_window_manager->swap_buffers();
+
+    // Initialize input
+    if (!m_input_manager->initialize()) {
+        std::cerr << "Failed to initialize input manager" << std::endl;
+        return false;
+    }
+
+    // Initialize audio, on SDL if the chosen backend won't open
+    bool audio_ok = m_audio_manager->initialize(DEFAULT_SAMPLE_RATE, DEFAULT_BUFFER_SIZE, m_audio_backend);
+    if (!audio_ok && m_audio_backend != AudioBackendType::SDL) {
+        std::cerr << "Falling back to SDL audio" << std::endl;
+        audio_ok = m_audio_manager->initialize();
+    }
+    if (!audio_ok) {
+        std::cerr << "Failed to initialize audio manager" << std::endl;
+        return false;
+    }
+
+    // Initialize GUI
+    if (!m_gui_manager->initialize(*m_window_manager)) {
+        std::cerr << "Failed to initialize GUI manager" << std::endl;
+        return false;
+    }
+    return true;
+}
+
 void Application::run() {
     // Headless mode - run without GUI for automated testing
     if (m_headless_mode) {
+        if (!m_jobs_path.empty()) {
+            if (!run_jobs()) {
+                m_exit_code = 1;
+            }
+            return;
+        }
+
         auto* active_plugin = m_plugin_manager->get_active_plugin();
         if (!active_plugin || !active_plugin->is_rom_loaded()) {
             std::cerr << "No ROM loaded for headless mode\n";
+            m_exit_code = 1;
+            return;
+        }
+
+        // Under remote control the client runs every frame, on this thread
+        if (m_control_port != 0) {
+            if (!m_control.open(m_control_port)) {
+                std::cerr << m_control.get_error() << "\n";
+                m_exit_code = 1;
+                return;
+            }
+            std::cerr << "Control server listening on 127.0.0.1:" << m_control_port << "\n";
+            m_control.serve([active_plugin](const std::function<void(IEmulatorPlugin*)>& work) {
+                work(active_plugin);
+            });
             return;
         }
 
-        emu::InputState empty_input{};
+        if (m_benchmark_mode) {
+            if (!Benchmark::run(*active_plugin, m_benchmark_options)) {
+                m_exit_code = 1;
+            }
+            return;
+        }
+
+        // Every frame of a recording is drawn and kept; the writer sets the
+        // pace, so this runs as fast as the frames can be written
+        if (!m_record_path.empty() && !start_av_recording(m_record_path, false)) {
+            m_exit_code = 1;
+            return;
+        }
+
+        // Frames run in batches that end on a screenshot frame (or after at
+        // most one second), so only frames that can be captured get drawn
+        constexpr int MAX_HEADLESS_BATCH = 60;
+        std::vector<emu::InputState> batch_inputs(MAX_HEADLESS_BATCH, emu::InputState{});
         int frames_run = 0;
 
         while (m_running && !m_quit_requested && frames_run < m_headless_frames) {
-            active_plugin->run_frame(empty_input);
-            frames_run++;
+            int batch_end = std::min(frames_run + MAX_HEADLESS_BATCH, m_headless_frames);
+            if (m_screenshot_at_frame > frames_run) {
+                batch_end = std::min(batch_end, m_screenshot_at_frame);
+            }
+
+            if (is_av_recording()) {
+                FrameResult result{};
+                for (int i = frames_run; i < batch_end; i++) {
+                    active_plugin->run_frame_result(batch_inputs[0], result);
+                    m_av_recorder.add_audio(result.audio.samples, result.audio.sample_count,
+                                            result.audio.sample_rate);
+                    active_plugin->clear_audio_buffer();
+                    m_av_recorder.add_frame(result.video.pixels, result.video.width, result.video.height);
+                }
+            } else {
+                active_plugin->run_frames(batch_inputs.data(), static_cast<size_t>(batch_end - frames_run),
+                                          emu::RUN_FLAGS_SKIP_VIDEO | emu::RUN_FLAGS_SKIP_AUDIO);
+            }
+            frames_run = batch_end;
 
             // Check for screenshot at specific frame
             if (m_screenshot_at_frame > 0 && frames_run == m_screenshot_at_frame) {
@@ -290,10 +605,216 @@ void Application::run() {
             save_screenshot(path);
         }
 
+        if (is_av_recording() && stop_av_recording().empty()) {
+            m_exit_code = 1;
+        }
+        m_screenshot_writer.flush();
+
         std::cerr << "Headless mode: Ran " << frames_run << " frames\n";
         return;
     }
 
+    // Audio sync mode - DynamicRate is the default for TAS compatibility
+    // It maintains deterministic frame timing while achieving low audio latency
+    // through subtle resampling (max +/-0.5%, completely inaudible). The
+    // emulation thread switches to AudioDriven while audio pacing is on.
+    m_audio_manager->set_sync_mode(AudioSyncMode::DynamicRate);
+
+    // Emulation paces itself on its own thread; this loop only handles
+    // events and draws, so a slow swap or a GUI hitch no longer delays
+    // a frame and fast-forward isn't held to the display rate
+    start_emulation_thread();
+    start_control_server();
+
+    bool idle = false;
+    int redraws_left = IDLE_REDRAW_FRAMES;
+    while (m_running && !m_quit_requested) {
+        // Nothing on screen changes while emulation is paused except in
+        // response to events, so once the frames after the last one are
+        // drawn, sleep until the next instead of redrawing the same GUI
+        if (!idle) {
+            redraws_left = IDLE_REDRAW_FRAMES;
+        } else if (redraws_left == 0) {
+            bool woken = SDL_WaitEventTimeout(nullptr, IDLE_WAKEUP_MS) != 0;
+            redraws_left = woken ? IDLE_REDRAW_FRAMES : 1;
+        }
+
+        // With variable refresh the display follows the core's frame rate:
+        // draw once each frame is published, then sample input for the next
+        PresentMode present_mode = get_present_mode();
+        bool emulating = !m_paused.load(std::memory_order_relaxed);
+        if (present_mode == PresentMode::VariableRefresh && emulating) {
+            wait_for_published_frame(VRR_MAX_WAIT);
+        }
+
+        uint64_t frame_start = WindowManager::get_ticks();
+
+        // Results the emulation thread handed back (savestate notifications)
+        std::function<void()> call;
+        while (m_main_calls.pop(call)) {
+            call();
+        }
+
+        // Process events
+        {
+            auto lock = lock_emulation();
+            process_events();
+            idle = is_gui_idle();
+        }
+
+        // Update input and publish it for the emulation thread
+        m_input_manager->update();
+        m_input_buttons.store(m_input_manager->get_button_state(), std::memory_order_relaxed);
+
+        // Render
+        render();
+        if (redraws_left > 0) {
+            redraws_left--;
+        }
+
+        // The swap just returned at a vsync; release the next frame
+        if (present_mode == PresentMode::DisplayLocked) {
+            measure_refresh(FramePacer::now_ns());
+            signal_vblank();
+        } else if (m_last_swap_ns != 0) {
+            m_last_swap_ns = 0;
+            m_refresh_period_ns.store(0, std::memory_order_relaxed);
+        }
+
+        // Without vsync, swap_buffers returns at once; hold the GUI to
+        // roughly the display rate instead of spinning (published frames
+        // already pace it with variable refresh)
+        bool frame_paced = present_mode == PresentMode::VariableRefresh && emulating;
+        if (!m_window_manager->is_vsync_enabled() && !frame_paced) {
+            double frequency = static_cast<double>(WindowManager::get_performance_frequency());
+            double elapsed = static_cast<double>(WindowManager::get_ticks() - frame_start) / frequency;
+            if (elapsed < GUI_FRAME_TIME) {
+                SDL_Delay(static_cast<uint32_t>((GUI_FRAME_TIME - elapsed) * 1000.0));
+            }
+        }
+    }
+
+    stop_control_server();
+    stop_emulation_thread();
+}
+
+float* Application::reserve_audio_block(void* context, size_t frames, size_t* granted) {
+    auto* app = static_cast<Application*>(context);
+    app->m_audio_block = app->m_audio_manager->reserve_stream_block(frames, *granted);
+    return app->m_audio_block;
+}
+
+void Application::commit_audio_block(void* context, size_t frames, int sample_rate) {
+    auto* app = static_cast<Application*>(context);
+
+    // Skip audio during netplay rollback to avoid artifacts
+    auto* netplay = app->m_plugin_manager->get_netplay_plugin();
+    if (netplay && netplay->is_rolling_back()) {
+        return;
+    }
+
+    app->m_av_recorder.add_audio(app->m_audio_block, frames, sample_rate);
+    if (!app->m_audio_to_device) {
+        return;
+    }
+
+    // Resample the block into the ring (frames are stereo pairs)
+    EMU_TRACE_SCOPE(&app->m_tracer, "host", "audio push");
+    app->m_audio_manager->commit_stream_block(frames, sample_rate);
+}
+
+uint32_t Application::poll_live_input(void* context, float frame_position) {
+    auto* app = static_cast<Application*>(context);
+
+    // Where the latch falls in host time if the frame ran in real time. A
+    // frame run faster than that asks about the future and simply gets the
+    // newest state.
+    uint64_t time = app->m_live_frame_start + static_cast<uint64_t>(app->m_live_frame_ns * frame_position);
+    uint32_t buttons = app->m_input_manager->get_timeline().sample(time);
+    app->m_instant_replay.on_input_poll(buttons);
+    return buttons;
+}
+
+void Application::tune_emulation_thread() {
+    if (m_emulation_priority != ThreadPriority::Normal &&
+        !set_current_thread_priority(m_emulation_priority)) {
+        std::cerr << "Couldn't raise the emulation thread to " << get_thread_priority_name(m_emulation_priority)
+                  << " priority" << std::endl;
+    }
+    if (m_pin_emulation) {
+        int cpu = get_preferred_cpu();
+        if (pin_current_thread(cpu)) {
+            std::cout << "Emulation thread pinned to CPU " << cpu << std::endl;
+        } else {
+            std::cerr << "Couldn't pin the emulation thread" << std::endl;
+        }
+    }
+    if (m_max_performance && !m_power_request.acquire()) {
+        std::cerr << "Couldn't keep the CPU out of power-saving states" << std::endl;
+    }
+}
+
+void Application::start_emulation_thread() {
+    if (m_emulation_thread.joinable()) return;
+    m_emulation_stop.store(false, std::memory_order_release);
+    m_emulation_thread = std::thread(&Application::emulation_loop, this);
+}
+
+void Application::stop_emulation_thread() {
+    if (!m_emulation_thread.joinable()) return;
+    m_emulation_stop.store(true, std::memory_order_release);
+    wake_emulation_thread();
+    m_emulation_thread.join();
+
+    // Commands posted after the thread's last drain
+    EmulationCommand command;
+    while (m_commands.pop(command)) {
+        execute_command(command);
+    }
+}
+
+void Application::start_control_server() {
+    if (m_control_port == 0 || m_control_thread.joinable()) return;
+    if (!m_control.open(m_control_port)) {
+        std::cerr << m_control.get_error() << std::endl;
+        return;
+    }
+    std::cout << "Control server listening on 127.0.0.1:" << m_control_port << std::endl;
+
+    m_control_thread = std::thread([this]() {
+        m_control.serve([this](const std::function<void(IEmulatorPlugin*)>& work) {
+            // Batches run between frames; the client owns frame advance, so
+            // the emulator stays paused while it is in control
+            std::promise<void> ran;
+            std::future<void> done = ran.get_future();
+            run_on_emulation_thread([&]() {
+                if (!m_paused) {
+                    EmulationCommand pause{EmulationCommandType::Pause, {}};
+                    execute_command(pause);
+                }
+                auto* plugin = m_plugin_manager->get_active_plugin();
+                bool loaded = plugin && plugin->is_rom_loaded();
+                work(loaded ? plugin : nullptr);
+                if (loaded) publish_frame(plugin->get_framebuffer());
+                ran.set_value();
+            });
+            done.wait();
+        });
+    });
+}
+
+void Application::stop_control_server() {
+    if (!m_control_thread.joinable()) return;
+    m_control.stop();
+    m_control_thread.join();
+    m_control.close();
+}
+
+void Application::emulation_loop() {
+    t_on_emulation_thread = true;
+    m_tracer.set_thread_name("emulation");
+    tune_emulation_thread();
+
     // Frame timing is determined by the active emulator plugin's native FPS.
     // Examples:
     //   - NES (NTSC): 60.0988 fps (21.477272 MHz / 4 / 262 / 341)
@@ -303,79 +824,323 @@ void Application::run() {
     // Default to 60 FPS when no plugin is active.
     double target_fps = 60.0;
     bool audio_started = false;
+    FramePacer pacer;
+    uint64_t last_present = 0;
+    uint64_t vblank_seen = 0;
+
+    while (!m_emulation_stop.load(std::memory_order_acquire)) {
+        pacer.begin_frame();
+        uint64_t frame_start_ns = m_perf_monitor.is_enabled() ? PerfMonitor::now_ns() : 0;
+        bool ran_frame = false;
+        bool core_fast_mode = false;
+        bool audio_driven = false;
+        bool display_locked = false;
+        double time_scale = 1.0;
+
+        {
+            std::lock_guard<std::mutex> lock(m_emulation_mutex);
+
+            // Apply commands at the frame boundary
+            EmulationCommand command;
+            while (m_commands.pop(command)) {
+                execute_command(command);
+            }
+            poll_instant_replay();
 
-    // Set audio sync mode - DynamicRate is the default for TAS compatibility
-    // It maintains deterministic frame timing while achieving low audio latency
-    // through subtle resampling (max +/-0.5%, completely inaudible)
-    m_audio_manager->set_sync_mode(AudioSyncMode::DynamicRate);
+            // Update target FPS from active plugin (may change when loading different ROMs)
+            auto* active_plugin = m_plugin_manager->get_active_plugin();
+            if (active_plugin && active_plugin->is_rom_loaded()) {
+                target_fps = get_native_fps(active_plugin);
+            }
 
-    while (m_running && !m_quit_requested) {
-        uint64_t frame_start = WindowManager::get_ticks();
-        double frequency = static_cast<double>(WindowManager::get_performance_frequency());
+            // Run emulation if not paused
+            if (!m_paused || m_frame_advance_requested) {
+                // Fast-forward draws only the frames the display rate will
+                // show; netplay and frame advance show every frame
+                float speed = m_speed_multiplier.load(std::memory_order_relaxed);
+                bool fast_forward = speed <= 0.0f || speed > 1.0f || (active_plugin && m_core_fast_mode);
+                bool present = true;
+                uint64_t now = FramePacer::now_ns();
+                if (fast_forward && !m_frame_advance_requested && !m_netplay_active_cached) {
+                    double display_rate = m_fast_forward_display_rate.load(std::memory_order_relaxed);
+                    present = display_rate <= 0.0 || now - last_present >= static_cast<uint64_t>(1e9 / display_rate);
+                }
+                if (present) last_present = now;
 
-        // Process events
-        process_events();
+                run_emulation_frame(present);
+                m_frame_advance_requested = false;
+                ran_frame = true;
 
-        // Update input
-        m_input_manager->update();
+                // Start audio playback once buffer has enough samples
+                // With DynamicRate mode, this threshold is much lower (~24ms vs 139ms)
+                if (!audio_started && m_audio_manager->is_buffer_ready()) {
+                    m_audio_manager->resume();
+                    audio_started = true;
+                }
+            } else {
+                audio_started = false;  // Reset when paused
+            }
 
-        // Update target FPS from active plugin (may change when loading different ROMs)
-        auto* active_plugin = m_plugin_manager->get_active_plugin();
-        if (active_plugin && active_plugin->is_rom_loaded()) {
-            target_fps = active_plugin->get_info().native_fps;
+            // Netplay stretches or shrinks frames slightly to stay in step with
+            // the remote instead of stalling when one side gets ahead
+            if (m_netplay_active_cached) {
+                auto* netplay = m_plugin_manager->get_netplay_plugin();
+                if (netplay) time_scale = netplay->get_frame_time_scale();
+            }
+
+            // Check if the emulator core has fast mode enabled (e.g., "overclock" setting)
+            // When fast mode is enabled, skip frame timing entirely. The
+            // last frame run reported it.
+            core_fast_mode = active_plugin && m_core_fast_mode;
+
+            // The audio device can only drive timing at normal speed and
+            // outside netplay, which needs frames on the host clock
+            float speed = m_speed_multiplier.load(std::memory_order_relaxed);
+            audio_driven = m_audio_paced.load(std::memory_order_relaxed) && speed == 1.0f &&
+                           !core_fast_mode && !m_netplay_active_cached;
+            m_audio_manager->set_sync_mode(audio_driven ? AudioSyncMode::AudioDriven
+                                                        : AudioSyncMode::DynamicRate);
+
+            // Vsync can stand in for the host timer when the display runs
+            // close enough to native_fps for rate control to make up the rest
+            if (get_present_mode() == PresentMode::DisplayLocked && !audio_driven && speed == 1.0f &&
+                !core_fast_mode && !m_netplay_active_cached) {
+                double refresh_ns = static_cast<double>(m_refresh_period_ns.load(std::memory_order_acquire));
+                double native_ns = 1e9 / target_fps;
+                display_locked = refresh_ns > 0.0 &&
+                                 std::abs(refresh_ns - native_ns) <= native_ns * AudioManager::MAX_RATE_ADJUSTMENT;
+            }
+        }
+
+        // Let the main thread in if it is waiting on the lock, so uncapped
+        // emulation can't starve the GUI
+        while (m_main_waiting.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
         }
-        double target_frame_time = 1.0 / target_fps;
 
-        // Run emulation if not paused
-        if (!m_paused || m_frame_advance_requested) {
-            run_emulation_frame();
-            m_frame_advance_requested = false;
+        // Nothing to pace while paused; just wait for commands
+        if (!ran_frame) {
+            std::unique_lock<std::mutex> wake_lock(m_wake_mutex);
+            m_wake.wait_for(wake_lock, std::chrono::milliseconds(100), [this]() {
+                return m_commands_posted.load(std::memory_order_acquire) ||
+                       m_emulation_stop.load(std::memory_order_acquire);
+            });
+            m_commands_posted.store(false, std::memory_order_relaxed);
+            continue;
+        }
 
-            // Start audio playback once buffer has enough samples
-            // With DynamicRate mode, this threshold is much lower (~24ms vs 139ms)
-            if (!audio_started && m_audio_manager->is_buffer_ready()) {
-                m_audio_manager->resume();
-                audio_started = true;
-            }
+        // Skip timing if the speed is unlimited or the core requests fast mode
+        float speed = m_speed_multiplier.load(std::memory_order_relaxed);
+        if (speed <= 0.0f || core_fast_mode) {
+            continue;
+        }
+        double target_frame_time = (1.0 / target_fps) / speed * time_scale;
+        bool measuring = m_perf_monitor.is_enabled();
+        if (measuring) {
+            m_perf_monitor.set_budget_ms(static_cast<float>(target_frame_time * 1000.0));
+        }
+
+        // In AudioDriven mode, sleep until the audio callback asks for the
+        // next frame; dynamic rate control in the audio system otherwise
+        // compensates for drift against the host timer. Until playback
+        // starts there is no callback to wait on, so fill on the host timer.
+        EMU_TRACE_SCOPE(&m_tracer, "host", "pace");
+        if (audio_driven && audio_started) {
+            pacer.wait_for_audio(*m_audio_manager, target_frame_time * 2.0);
+        } else if (display_locked) {
+            wait_for_vblank(vblank_seen, target_frame_time * 2.0);
         } else {
-            audio_started = false;  // Reset when paused
+            pacer.wait_for(target_frame_time);
         }
 
-        // Render
-        render();
+        // How late the next frame starts against the target
+        if (measuring && frame_start_ns != 0) {
+            float interval_ms = PerfMonitor::ms_between(frame_start_ns, PerfMonitor::now_ns());
+            m_perf_monitor.record(PerfMonitor::PACING_ERROR,
+                                  interval_ms - static_cast<float>(target_frame_time * 1000.0));
+        }
+    }
+}
 
-        // Hardware-accurate frame timing with precision spin-wait
-        // Dynamic rate control in the audio system compensates for any minor
-        // timing drift, allowing us to use spin-waiting for precise frame pacing.
-        uint64_t frame_end = WindowManager::get_ticks();
-        double frame_time = static_cast<double>(frame_end - frame_start) / frequency;
-        double adjusted_target = target_frame_time / m_speed_multiplier;
-
-        // Check if the emulator core has fast mode enabled (e.g., "overclock" setting)
-        // When fast mode is enabled, skip frame timing entirely
-        // Note: Re-fetch active_plugin as it may have changed during render() (e.g., ROM load from GUI)
-        auto* current_plugin = m_plugin_manager->get_active_plugin();
-        bool core_fast_mode = current_plugin && current_plugin->is_fast_mode_enabled();
-
-        // Sleep to maintain target frame rate
-        // Skip timing if: speed multiplier != 1.0, or core requests fast mode
-        if (m_speed_multiplier == 1.0f && !core_fast_mode && frame_time < adjusted_target) {
-            double sleep_time = (adjusted_target - frame_time) * 1000.0;
-            // Use a more accurate sleep by sleeping slightly less and spinning
-            if (sleep_time > 2.0) {
-                SDL_Delay(static_cast<uint32_t>(sleep_time - 1.0));
-            }
-            // Spin for remaining time for more accurate timing
-            while (true) {
-                uint64_t now = WindowManager::get_ticks();
-                double elapsed = static_cast<double>(now - frame_start) / frequency;
-                if (elapsed >= adjusted_target) break;
+void Application::measure_refresh(uint64_t now_ns) {
+    if (!m_window_manager->is_vsync_enabled()) {
+        m_refresh_period_ns.store(0, std::memory_order_relaxed);
+        m_last_swap_ns = 0;
+        return;
+    }
+
+    uint64_t interval = now_ns - m_last_swap_ns;
+    bool restart = m_last_swap_ns == 0 || interval > REFRESH_STALL_NS;
+    m_last_swap_ns = now_ns;
+    if (restart) {
+        m_refresh_window_start = now_ns;
+        m_refresh_window_vblanks = 0;
+        return;
+    }
+
+    // A swap that missed a vsync waited for two; counting it as one would
+    // make the display look slower than it is
+    uint64_t period = m_refresh_period_ns.load(std::memory_order_relaxed);
+    uint64_t vblanks = 1;
+    if (period > 0 && interval < period * 4) {
+        vblanks = std::max<uint64_t>(1, (interval + period / 2) / period);
+    }
+    m_refresh_window_vblanks += vblanks;
+
+    uint64_t elapsed = now_ns - m_refresh_window_start;
+    if (elapsed >= REFRESH_WINDOW_NS) {
+        m_refresh_period_ns.store(elapsed / m_refresh_window_vblanks, std::memory_order_release);
+        m_refresh_window_start = now_ns;
+        m_refresh_window_vblanks = 0;
+    }
+}
+
+void Application::signal_vblank() {
+    {
+        std::lock_guard<std::mutex> lock(m_present_mutex);
+        m_vblank_count++;
+    }
+    m_present_cv.notify_all();
+}
+
+bool Application::wait_for_vblank(uint64_t& seen, double max_seconds) {
+    // A vsync that came while the frame was still running releases the
+    // next one at once, so a slow frame doesn't cost a whole refresh
+    std::unique_lock<std::mutex> lock(m_present_mutex);
+    bool signalled = m_present_cv.wait_for(lock, std::chrono::duration<double>(max_seconds), [&]() {
+        return m_vblank_count != seen || m_emulation_stop.load(std::memory_order_acquire);
+    });
+    seen = m_vblank_count;
+    return signalled;
+}
+
+void Application::wait_for_published_frame(double max_seconds) {
+    std::unique_lock<std::mutex> lock(m_present_mutex);
+    m_present_cv.wait_for(lock, std::chrono::duration<double>(max_seconds), [this]() {
+        return m_published_count != m_published_seen;
+    });
+    m_published_seen = m_published_count;
+}
+
+double Application::get_refresh_rate() const {
+    uint64_t period = m_refresh_period_ns.load(std::memory_order_relaxed);
+    return period > 0 ? 1e9 / static_cast<double>(period) : 0.0;
+}
+
+std::unique_lock<std::mutex> Application::lock_emulation() {
+    m_main_waiting.store(true, std::memory_order_release);
+    std::unique_lock<std::mutex> lock(m_emulation_mutex);
+    m_main_waiting.store(false, std::memory_order_release);
+    return lock;
+}
+
+bool Application::on_emulation_thread() const {
+    return t_on_emulation_thread;
+}
+
+void Application::post_command(EmulationCommand&& command) {
+    // Nothing to hand off to before the thread starts or once it's stopped
+    if (on_emulation_thread() || !m_emulation_thread.joinable()) {
+        execute_command(command);
+        return;
+    }
+
+    // The poster may hold the emulation lock, so never wait on a full queue
+    if (!m_commands.push(std::move(command))) {
+        std::cerr << "Emulation command queue full, command dropped" << std::endl;
+        return;
+    }
+    m_commands_posted.store(true, std::memory_order_release);
+    wake_emulation_thread();
+}
+
+void Application::wake_emulation_thread() {
+    // Taking the lock orders this with the waiter's check of its condition
+    { std::lock_guard<std::mutex> lock(m_wake_mutex); }
+    m_wake.notify_one();
+}
+
+bool Application::is_gui_idle() {
+    // Under the emulation lock, like the GUI
+    if (!m_paused.load(std::memory_order_relaxed)) return false;
+    if (m_gui_manager && m_gui_manager->get_notification_manager().count() > 0) return false;
+    auto* netplay = m_plugin_manager->get_netplay_plugin();
+    return !(netplay && netplay->is_connected());
+}
+
+void Application::execute_command(EmulationCommand& command) {
+    switch (command.type) {
+        case EmulationCommandType::Pause:
+            m_paused = true;
+            m_audio_manager->pause();
+            m_plugin_manager->set_paused(true);
+            break;
+
+        case EmulationCommandType::Resume:
+            m_paused = false;
+            m_audio_manager->resume();
+            m_plugin_manager->set_paused(false);
+            break;
+
+        case EmulationCommandType::Reset: {
+            auto* plugin = m_plugin_manager->get_active_plugin();
+            if (plugin && plugin->is_rom_loaded()) {
+                plugin->reset();
+                m_audio_manager->clear_buffer();
             }
+            break;
         }
+
+        case EmulationCommandType::FrameAdvance:
+            if (m_paused) {
+                m_frame_advance_requested = true;
+            }
+            break;
+
+        case EmulationCommandType::Call:
+            if (command.call) {
+                command.call();
+            }
+            break;
+    }
+}
+
+void Application::run_on_emulation_thread(std::function<void()> call) {
+    post_command({EmulationCommandType::Call, std::move(call)});
+}
+
+void Application::run_on_main_thread(std::function<void()> call) {
+    if (!m_main_calls.push(std::move(call))) {
+        std::cerr << "Main thread call queue full, call dropped" << std::endl;
+        return;
     }
+
+    // Wake the main loop if it's waiting for events while idle
+    SDL_Event event{};
+    event.type = SDL_USEREVENT;
+    SDL_PushEvent(&event);
 }
 
 void Application::shutdown() {
+    stop_control_server();
+    stop_emulation_thread();
+    m_instant_replay.cancel_export();
+
+    if (is_tracing()) {
+        stop_trace();
+    }
+    if (is_cpu_tracing()) {
+        stop_cpu_trace();
+    }
+
+    if (is_av_recording()) {
+        stop_av_recording();
+    }
+
+    // Screenshot callbacks post to the main thread; let them run while
+    // everything they touch is still here
+    m_screenshot_writer.flush();
+
     // Save input config before shutdown (not in headless mode)
     if (m_input_manager) {
         m_input_manager->save_platform_config(m_input_manager->get_current_platform());
@@ -449,6 +1214,9 @@ void Application::process_events() {
                 if (event.window.event == SDL_WINDOWEVENT_CLOSE) {
                     m_quit_requested = true;
                 } else if (event.window.event == SDL_WINDOWEVENT_FOCUS_LOST) {
+                    // The rewind key's release goes to another window
+                    set_rewinding(false);
+
                     // Pause when window loses focus (if enabled and ROM loaded)
                     if (m_pause_on_focus_loss && m_plugin_manager->is_rom_loaded()) {
                         m_was_paused_before_focus = m_paused;
@@ -485,6 +1253,9 @@ void Application::process_events() {
                                 frame_advance();
                             }
                             break;
+                        case SDLK_BACKSPACE:
+                            set_rewinding(true);
+                            break;
                         case SDLK_F11:
                             m_window_manager->toggle_fullscreen();
                             break;
@@ -494,9 +1265,8 @@ void Application::process_events() {
                             break;
 
                         case SDLK_PRINTSCREEN:
-                            if (save_screenshot()) {
-                                m_gui_manager->get_notification_manager().success("Screenshot saved");
-                            } else {
+                            // Success is reported once the file is written
+                            if (!save_screenshot()) {
                                 m_gui_manager->get_notification_manager().error("Failed to save screenshot");
                             }
                             break;
@@ -513,38 +1283,43 @@ void Application::process_events() {
                         case SDLK_F9:
                         case SDLK_F10: {
                             int slot = event.key.keysym.sym - SDLK_F1;  // 0-9
-                            auto& notifications = m_gui_manager->get_notification_manager();
-                            std::ostringstream msg;
-
-                            if (event.key.keysym.mod & KMOD_SHIFT) {
-                                // Save state (Shift+F1-F10)
-                                if (m_savestate_manager->save_state(slot)) {
-                                    msg << "State saved to slot " << (slot + 1);
-                                    notifications.success(msg.str());
-                                    std::cout << msg.str() << std::endl;
-                                } else {
-                                    msg << "Failed to save state to slot " << (slot + 1);
-                                    notifications.error(msg.str());
-                                    std::cout << msg.str() << std::endl;
-                                }
-                            } else {
-                                // Load state (F1-F10)
-                                if (m_savestate_manager->load_state(slot)) {
-                                    msg << "State loaded from slot " << (slot + 1);
-                                    notifications.success(msg.str());
-                                    std::cout << msg.str() << std::endl;
+                            bool save = (event.key.keysym.mod & KMOD_SHIFT) != 0;
+
+                            // Shift+F1-F10 saves, F1-F10 loads; done between
+                            // frames, then reported back here
+                            run_on_emulation_thread([this, slot, save]() {
+                                bool ok = save ? m_savestate_manager->save_state(slot)
+                                               : m_savestate_manager->load_state(slot);
+                                std::ostringstream msg;
+                                if (save) {
+                                    msg << (ok ? "State saved to slot " : "Failed to save state to slot ");
                                 } else {
-                                    msg << "Failed to load state from slot " << (slot + 1);
-                                    notifications.error(msg.str());
-                                    std::cout << msg.str() << std::endl;
+                                    msg << (ok ? "State loaded from slot " : "Failed to load state from slot ");
                                 }
-                            }
+                                msg << (slot + 1);
+                                std::cout << msg.str() << std::endl;
+
+                                run_on_main_thread([this, ok, text = msg.str()]() {
+                                    auto& notifications = m_gui_manager->get_notification_manager();
+                                    if (ok) {
+                                        notifications.success(text);
+                                    } else {
+                                        notifications.error(text);
+                                    }
+                                });
+                            });
                             break;
                         }
                     }
                 }
                 break;
 
+            case SDL_KEYUP:
+                if (event.key.keysym.sym == SDLK_BACKSPACE) {
+                    set_rewinding(false);
+                }
+                break;
+
             case SDL_DROPFILE:
                 load_rom(event.drop.file);
                 SDL_free(event.drop.file);
@@ -553,16 +1328,78 @@ void Application::process_events() {
     }
 }
 
-void Application::run_emulation_frame() {
+void Application::run_emulation_frame(bool present) {
     auto* plugin = m_plugin_manager->get_active_plugin();
     if (!plugin || !plugin->is_rom_loaded()) {
         return;
     }
 
+    EMU_TRACE_SCOPE(&m_tracer, "host", "emulate");
+    PerfMonitor::Scope perf_scope(m_perf_monitor, PerfMonitor::EMULATE);
+
+    // Frames skipped while fast-forwarding run with video output off, unless
+    // they're being recorded
+    bool recording = m_av_recorder.is_recording();
+    bool bursting = m_burst_frames_left.load(std::memory_order_relaxed) > 0;
+    bool draw = present || recording || bursting;
+    plugin->set_video_enabled(draw);
+    if (draw && m_direct_output) {
+        plugin->set_output_framebuffer(m_frames.back_buffer(m_output_width, m_output_height), m_output_width);
+    }
+
+    // Uncapped fast mode produces audio far faster than it can be played;
+    // let the core skip generating it, or only record it. The setting is
+    // taken from the last frame's result.
+    bool fast_mode = m_core_fast_mode;
+    bool audio_enabled = !fast_mode || recording;
+    plugin->set_audio_enabled(audio_enabled);
+    m_audio_to_device = !fast_mode;
+
+    // Overclocking would desync netplay peers and TAS movies
+    auto* tas = m_plugin_manager->get_tas_plugin();
+    bool movie_open = tas && tas->is_movie_loaded();
+    plugin->set_enhancements_allowed(!m_netplay_active_cached && !movie_open);
+
+    // Picked up here, under the emulation lock, so a plugin swapped from the
+    // GUI never gets called after it's destroyed
+    if (m_audio_manager) {
+        m_audio_manager->set_effect_plugin(m_plugin_manager->get_audio_plugin());
+    }
+
     // Fast path: check cached netplay active status first
     // This avoids expensive is_connected() call which does plugin lookup + virtual calls
     bool netplay_active = m_netplay_active_cached;
 
+    // Rewinding takes the place of running forward: the previous capture is
+    // loaded and one frame run from it, silently, to show it
+    INetplayCapable* rewind_core = nullptr;
+    if (m_rewind_enabled.load(std::memory_order_relaxed) && !netplay_active) {
+        if (m_rewind_stale) {
+            configure_rewind();
+        }
+        rewind_core = m_rewind.is_configured() ? get_netplay_capable_emulator() : nullptr;
+    }
+    bool rewinding = rewind_core && m_rewinding.load(std::memory_order_relaxed);
+    if (rewinding) {
+        EMU_TRACE_SCOPE(&m_tracer, "host", "rewind");
+        m_rewind.step_back(*rewind_core);
+        audio_enabled = false;
+        plugin->set_audio_enabled(audio_enabled);
+    }
+
+    // With run-ahead the frame shown is one run past this one, which then
+    // needn't be drawn
+    int run_ahead_frames = m_run_ahead_frames.load(std::memory_order_relaxed);
+    INetplayCapable* run_ahead_core = nullptr;
+    if (run_ahead_frames > 0 && present && !recording && !bursting && !fast_mode && !netplay_active &&
+            !rewinding && !movie_open) {
+        run_ahead_core = get_netplay_capable_emulator();
+        if (run_ahead_core) plugin->set_video_enabled(false);
+    }
+
+    // The frame's output and counters, read back with the frame itself
+    FrameResult result{};
+    InputState input{};
     if (netplay_active) {
         auto* netplay = m_plugin_manager->get_netplay_plugin();
         if (netplay) {
@@ -572,7 +1409,7 @@ void Application::run_emulation_frame() {
                 return;
             }
 
-            // Get synchronized inputs for all players using pre-allocated buffer
+            // Get synchronized inputs for all players in one call
             uint64_t frame = plugin->get_frame_count();
             netplay->get_synchronized_inputs_fast(m_netplay_inputs_buffer, frame);
 
@@ -583,35 +1420,79 @@ void Application::run_emulation_frame() {
                 m_netplay_capable_plugin->run_frame_netplay_n(m_netplay_inputs_buffer);
             } else {
                 // Fallback: use local player input only
-                InputState input;
                 int local_id = netplay->get_local_player_id();
-                input.buttons = (local_id >= 0 && local_id < static_cast<int>(m_netplay_inputs_buffer.size()))
-                              ? m_netplay_inputs_buffer[local_id] : 0;
+                input.buttons = (local_id >= 0 && local_id < m_netplay_inputs_buffer.player_count)
+                              ? m_netplay_inputs_buffer.buttons[local_id] : 0;
                 plugin->run_frame(input);
             }
+            plugin->get_frame_result(result);
 
             netplay->end_frame();
+        } else {
+            plugin->get_frame_result(result);
         }
     } else {
         // Normal single-player mode - zero netplay overhead
-        InputState input;
-        input.buttons = m_input_manager->get_button_state();
-        plugin->run_frame(input);
+        input.buttons = get_local_buttons();
+
+        // Cores that latch the pad mid-frame read it then instead, except
+        // while a movie is open, which has to see the inputs it records
+        bool live = m_input_manager && !rewinding && !movie_open;
+        if (live) {
+            float speed = m_speed_multiplier.load(std::memory_order_relaxed);
+            double fps = get_native_fps(plugin);
+            m_live_frame_start = FramePacer::now_ns();
+            m_live_frame_ns = speed > 0.0f && fps > 0.0 ? 1e9 / fps / speed : 0.0;
+            plugin->set_input_poll({this, &Application::poll_live_input});
+        }
+        plugin->run_frame_result(input, result);
+        if (live) {
+            plugin->set_input_poll({});
+        }
+    }
+    m_core_fast_mode = result.fast_mode;
+
+    if (rewind_core && !rewinding) {
+        EMU_TRACE_SCOPE(&m_tracer, "host", "rewind capture");
+        m_rewind.on_frame(*rewind_core);
+    }
+    if (m_ram_recorder.is_active() && !rewinding) {
+        m_ram_recorder.on_frame(*plugin);
+    }
+    if (m_instant_replay_enabled.load(std::memory_order_relaxed) && !netplay_active && !rewinding) {
+        if (m_instant_replay_stale) {
+            configure_instant_replay();
+        }
+        if (auto* core = m_instant_replay.is_configured() ? get_netplay_capable_emulator() : nullptr) {
+            m_instant_replay.on_frame(*plugin, *core, input);
+        }
+    }
+
+    // Consumers that grow as they go are held to the budget about once a
+    // second
+    if (--m_frames_until_memory_check <= 0) {
+        m_frames_until_memory_check = 60;
+        m_memory_budget.balance();
     }
 
     // Update game plugins (for timer updates and auto-split detection)
     m_plugin_manager->update_game_plugins();
+    m_plugin_manager->update_battery_save();
 
     // Audio handling: streaming vs legacy path
-    // Streaming audio (has_audio_callback) pushes samples during emulation for lowest latency
+    // Streaming audio (has_audio_sink) pushes samples during emulation for lowest latency
     // Legacy path batches until frame end (higher latency but compatible with all plugins)
-    if (!plugin->has_audio_callback()) {
+    if (!plugin->has_audio_sink()) {
         // Legacy audio path: get samples at frame end
         auto* netplay = m_plugin_manager->get_netplay_plugin();
         bool skip_audio = netplay_active && netplay && netplay->is_rolling_back();
         if (!skip_audio) {
-            AudioBuffer audio = plugin->get_audio();
-            if (audio.samples && audio.sample_count > 0) {
+            const AudioBuffer& audio = result.audio;
+            if (recording) {
+                m_av_recorder.add_audio(audio.samples, audio.sample_count, audio.sample_rate);
+            }
+            if (audio.samples && audio.sample_count > 0 && m_audio_to_device) {
+                EMU_TRACE_SCOPE(&m_tracer, "host", "audio push");
                 // Resample if source rate differs from output rate
                 m_audio_manager->push_samples_resampled(audio.samples, audio.sample_count * 2,
                                                          audio.sample_rate);
@@ -624,35 +1505,438 @@ void Application::run_emulation_frame() {
     }
     // Streaming path: samples already pushed during run_frame() via callback
 
-    // Update texture with framebuffer
-    FrameBuffer fb = plugin->get_framebuffer();
+    if (recording) {
+        EMU_TRACE_SCOPE(&m_tracer, "host", "record frame");
+        m_av_recorder.add_frame(result.video.pixels, result.video.width, result.video.height);
+    }
+
+    if (bursting) {
+        const FrameBuffer& fb = result.video;
+        char name[32];
+        std::snprintf(name, sizeof(name), "frame_%06llu", static_cast<unsigned long long>(result.frame_count));
+        m_screenshot_writer.queue(m_burst_directory / (name + std::string(Screenshot::extension(m_burst_format))),
+                                  fb.pixels, fb.width, fb.height, m_burst_format);
+        if (m_burst_frames_left.fetch_sub(1, std::memory_order_relaxed) == 1) {
+            uint64_t dropped = m_screenshot_writer.get_dropped() - m_burst_dropped_base;
+            std::string message = "Burst saved to " + m_burst_directory.string();
+            if (dropped > 0) message += " (" + std::to_string(dropped) + " frames dropped)";
+            std::cout << message << std::endl;
+            run_on_main_thread([this, message]() {
+                if (m_gui_manager) m_gui_manager->get_notification_manager().success(message);
+            });
+        }
+    }
+
+    if (run_ahead_core && run_ahead(*plugin, *run_ahead_core, run_ahead_frames, audio_enabled)) {
+        return;
+    }
+
+    // Hand the framebuffer to the render thread
+    if (present) {
+        publish_frame(result.video);
+    }
+}
+
+bool Application::run_ahead(IEmulatorPlugin& plugin, INetplayCapable& core, int frames, bool audio_enabled) {
+    EMU_TRACE_SCOPE(&m_tracer, "host", "run-ahead");
+
+    size_t max_size = core.get_max_state_size();
+    if (m_run_ahead_state.size() < max_size) {
+        m_run_ahead_state.resize(max_size);
+    }
+    size_t size = core.save_state_fast(m_run_ahead_state.data(), m_run_ahead_state.size());
+    if (size == 0) {
+        return false;
+    }
+
+    // Only the picture of these frames is wanted; none of them happened
+    plugin.set_audio_enabled(false);
+    InputState input;
+    input.buttons = get_local_buttons();
+    for (int i = 0; i < frames; i++) {
+        if (i + 1 == frames) {
+            plugin.set_video_enabled(true);
+            if (m_direct_output) {
+                plugin.set_output_framebuffer(m_frames.back_buffer(m_output_width, m_output_height),
+                                              m_output_width);
+            }
+        }
+        plugin.run_frame(input);
+    }
+    publish_frame(plugin.get_framebuffer());
+
+    // Writes they made must not reach auto-splitters next frame
+    WriteWatchHit hits[64];
+    while (plugin.take_write_watch_hits(hits, 64) > 0) {
+    }
+
+    if (!core.load_state_fast(m_run_ahead_state.data(), size)) {
+        // Nothing to go back to; carry on from the frame run ahead to
+        std::cerr << "Run-ahead: state load failed, turning run-ahead off" << std::endl;
+        m_run_ahead_frames.store(0, std::memory_order_relaxed);
+    }
+    plugin.set_audio_enabled(audio_enabled);
+    return true;
+}
+
+double Application::get_native_fps(IEmulatorPlugin* plugin) {
+    if (plugin != m_info_plugin) {
+        m_info_plugin = plugin;
+        m_native_fps = plugin ? plugin->get_info().native_fps : 60.0;
+    }
+    return m_native_fps;
+}
+
+void Application::publish_frame(const FrameBuffer& fb) {
     if (fb.pixels) {
-        m_renderer->update_texture(fb.pixels, fb.width, fb.height);
+        EMU_TRACE_SCOPE(&m_tracer, "host", "frame handoff");
+        if (m_frames.is_back_buffer(fb.pixels)) {
+            m_frames.publish_back(fb.width, fb.height);
+        } else {
+            m_frames.publish(fb.pixels, fb.width, fb.height);
+        }
+
+        if (get_present_mode() == PresentMode::VariableRefresh) {
+            {
+                std::lock_guard<std::mutex> lock(m_present_mutex);
+                m_published_count++;
+            }
+            m_present_cv.notify_all();
+        }
+    }
+}
+
+void Application::configure_rewind() {
+    m_rewind_stale = false;
+
+    auto* plugin = m_plugin_manager->get_active_plugin();
+    auto* core = get_netplay_capable_emulator();
+    if (!plugin || !core) {
+        m_rewind.release();
+        return;
+    }
+
+    // Cores differ a lot in state size, so the budget is per core
+    RewindOptions options;
+    if (m_low_memory) {
+        options.memory_budget = 16 * 1024 * 1024;
+    }
+    const auto& config = m_plugin_manager->get_config();
+    const char* core_name = plugin->get_info().name;
+    std::string memory_mb = config.get_plugin_setting(core_name, "rewind_memory_mb");
+    std::string interval = config.get_plugin_setting(core_name, "rewind_interval");
+    if (!memory_mb.empty()) {
+        options.memory_budget = std::strtoull(memory_mb.c_str(), nullptr, 10) * 1024 * 1024;
+    }
+    if (!interval.empty()) {
+        options.interval = std::atoi(interval.c_str());
+    }
+
+    // Under a few seconds' worth for most cores isn't worth keeping
+    constexpr size_t MIN_MEMORY = 1024 * 1024;
+    options.memory_budget = m_memory_budget.request(m_rewind_memory_id, options.memory_budget);
+    if (options.memory_budget < MIN_MEMORY) {
+        m_rewind.release();
+        std::cout << "Rewind: no room left in the memory budget" << std::endl;
+        return;
     }
+
+    m_rewind.configure(core->get_max_state_size(), options);
+    std::cout << "Rewind: " << (options.memory_budget >> 20) << " MB, a capture every "
+              << m_rewind.get_interval() << " frame(s)" << std::endl;
+}
+
+void Application::configure_instant_replay() {
+    m_instant_replay_stale = false;
+
+    auto* plugin = m_plugin_manager->get_active_plugin();
+    auto* core = get_netplay_capable_emulator();
+    if (!plugin || !core) {
+        m_instant_replay.release();
+        return;
+    }
+
+    InstantReplayOptions options;
+    const auto& config = m_plugin_manager->get_config();
+    const char* core_name = plugin->get_info().name;
+    std::string seconds = config.get_plugin_setting(core_name, "instant_replay_seconds");
+    std::string interval = config.get_plugin_setting(core_name, "instant_replay_keyframe_interval");
+    double fps = get_native_fps(plugin);
+    double window_seconds = seconds.empty() ? (m_low_memory ? 10.0 : 30.0) : std::strtod(seconds.c_str(), nullptr);
+    options.window_frames = static_cast<int>(window_seconds * (fps > 0.0 ? fps : 60.0));
+    if (!interval.empty()) {
+        options.keyframe_interval = std::atoi(interval.c_str());
+    }
+
+    // Short of memory, a shorter window beats none
+    size_t max_state_size = core->get_max_state_size();
+    size_t wanted = InstantReplay::get_memory_needed(max_state_size, options);
+    size_t granted = m_memory_budget.request(m_instant_replay_memory_id, wanted);
+    while (wanted > granted && options.window_frames > options.keyframe_interval) {
+        options.window_frames /= 2;
+        wanted = InstantReplay::get_memory_needed(max_state_size, options);
+    }
+    if (wanted > granted) {
+        m_instant_replay.release();
+        std::cout << "Instant replay: no room left in the memory budget" << std::endl;
+        return;
+    }
+
+    m_instant_replay.configure(max_state_size, options);
+    std::cout << "Instant replay: " << options.window_frames << " frames, a keyframe every "
+              << options.keyframe_interval << " frame(s)" << std::endl;
+}
+
+void Application::register_memory_consumers() {
+    m_memory_budget.add({"Warm ROMs", MemoryPriority::Cache,
+        [this]() { return m_plugin_manager->get_warm_rom_memory(); },
+        [this](size_t bytes) { m_plugin_manager->trim_warm_roms(bytes); }});
+
+    // Rewind and instant replay allocate up front; they move to a smaller
+    // allocation, keeping their newest history
+    m_rewind_memory_id = m_memory_budget.add({"Rewind", MemoryPriority::History,
+        [this]() { return m_rewind.get_budget(); },
+        [this](size_t bytes) { m_rewind.shrink(bytes); }, true});
+    m_instant_replay_memory_id = m_memory_budget.add({"Instant replay", MemoryPriority::History,
+        [this]() { return m_instant_replay.get_allocated_bytes(); },
+        [this](size_t bytes) { m_instant_replay.shrink(bytes); }, true});
+
+    // These drop their oldest data but keep their own budgets, so they grow
+    // back once there's room
+    m_memory_budget.add({"RAM recording", MemoryPriority::History,
+        [this]() { return m_ram_recorder.get_memory_used(); },
+        [this](size_t bytes) { m_ram_recorder.trim(bytes); }});
+
+    // With a spill file attached the greenzone moves states to disk rather
+    // than dropping them
+    m_memory_budget.add({"TAS greenzone", MemoryPriority::Editing,
+        [this]() {
+            ITASPlugin* tas = m_plugin_manager->get_tas_plugin();
+            return tas ? tas->get_greenzone_memory_used() : 0;
+        },
+        [this](size_t bytes) {
+            if (ITASPlugin* tas = m_plugin_manager->get_tas_plugin()) tas->trim_greenzone(bytes);
+        }});
+}
+
+void Application::set_instant_replay_enabled(bool enabled) {
+    m_instant_replay_enabled.store(enabled, std::memory_order_relaxed);
+    run_on_emulation_thread([this, enabled]() {
+        if (enabled) {
+            m_instant_replay_stale = true;  // Allocated on the next frame
+        } else {
+            m_instant_replay.cancel_export();
+            m_instant_replay.release();
+        }
+    });
+}
+
+void Application::save_instant_replay(const std::string& path) {
+    run_on_emulation_thread([this, path]() {
+        auto* plugin = m_plugin_manager->get_active_plugin();
+        if (!plugin || !plugin->is_rom_loaded()) {
+            std::cerr << "[Instant replay] No ROM loaded\n";
+            return;
+        }
+
+        // Sized like a recording started now
+        FrameBuffer fb = plugin->get_framebuffer();
+        AVStreamInfo info;
+        info.width = fb.width > 0 ? fb.width : plugin->get_info().screen_width;
+        info.height = fb.height > 0 ? fb.height : plugin->get_info().screen_height;
+        double fps = get_native_fps(plugin);
+        info.fps = fps > 0.0 ? fps : 60.0;
+
+        std::filesystem::path output_path = path;
+        if (output_path.empty()) {
+            output_path = m_paths_config->get_screenshot_directory() / Screenshot::generate_filename("replay");
+            output_path.replace_extension();
+        }
+
+        std::string error;
+        IEmulatorPlugin* clone = m_plugin_manager->create_emulator_clone();
+        auto release = [this](IEmulatorPlugin* core) { m_plugin_manager->destroy_emulator_clone(core); };
+        if (!m_instant_replay.start_export(clone, release, std::make_unique<RawAVEncoder>(), output_path.string(),
+                                           info, error)) {
+            std::cerr << "[Instant replay] " << error << "\n";
+            return;
+        }
+        std::cout << "Saving instant replay (" << m_instant_replay.get_frame_count() << " frames) to "
+                  << output_path.string() << std::endl;
+    });
+}
+
+void Application::poll_instant_replay() {
+    std::string files;
+    std::string error;
+    if (!m_instant_replay.poll_export(files, error)) return;
+    if (!error.empty()) {
+        std::cerr << "[Instant replay] " << error << "\n";
+    } else {
+        std::cout << "Instant replay saved to " << files << std::endl;
+    }
+}
+
+bool Application::set_frame_sharing(bool enabled) {
+    if (!enabled) {
+        m_frame_share.close();
+        return true;
+    }
+    if (m_frame_share.is_open()) return true;
+    if (!m_frame_share.open()) {
+        std::cerr << m_frame_share.get_error() << std::endl;
+        return false;
+    }
+    std::cout << "Sharing frames as " << FrameShare::NAME << std::endl;
+    return true;
+}
+
+void Application::set_rewind_enabled(bool enabled) {
+    m_rewind_enabled.store(enabled, std::memory_order_relaxed);
+    run_on_emulation_thread([this, enabled]() {
+        if (enabled) {
+            m_rewind_stale = true;  // Allocated on the next frame
+        } else {
+            m_rewind.release();
+        }
+    });
 }
 
 void Application::render() {
+    // Upload the newest frame, if emulation finished one since last time
+    if (const FrameExchange::Frame* frame = m_frames.acquire()) {
+        EMU_TRACE_SCOPE(&m_tracer, "host", "texture upload");
+        PerfMonitor::Scope perf_scope(m_perf_monitor, PerfMonitor::TEXTURE_UPLOAD);
+        m_renderer->update_texture(frame->pixels.data(), frame->width, frame->height);
+        m_frame_share.publish(frame->pixels.data(), frame->width, frame->height);
+    }
+
+    if (m_perf_monitor.is_enabled()) {
+        // Sampled here rather than in the audio callback, once per drawn frame
+        int rate = m_audio_manager->get_sample_rate();
+        if (rate > 0) {
+            double frames = static_cast<double>(m_audio_manager->get_buffered_samples()) / 2.0;
+            m_perf_monitor.record(PerfMonitor::AUDIO_FILL, static_cast<float>(frames * 1000.0 / rate));
+        }
+    }
+
     m_renderer->clear();
     m_gui_manager->begin_frame();
-    m_gui_manager->render(*this, *m_renderer);
-    m_gui_manager->end_frame();
+    uint64_t gui_start_ns = m_perf_monitor.is_enabled() ? PerfMonitor::now_ns() : 0;
+    {
+        // GUI panels and plugin GUIs read the core directly
+        auto lock = lock_emulation();
+        EMU_TRACE_SCOPE(&m_tracer, "host", "gui build");
+        m_gui_manager->render(*this, *m_renderer);
+    }
+    {
+        EMU_TRACE_SCOPE(&m_tracer, "host", "gui render");
+        m_gui_manager->end_frame();
+    }
+    if (gui_start_ns != 0) {
+        m_perf_monitor.record(PerfMonitor::GUI, PerfMonitor::ms_between(gui_start_ns, PerfMonitor::now_ns()));
+    }
+    EMU_TRACE_SCOPE(&m_tracer, "host", "present");
+    PerfMonitor::Scope perf_scope(m_perf_monitor, PerfMonitor::PRESENT);
     m_window_manager->swap_buffers();
 }
 
+bool Application::run_jobs() {
+    std::vector<RunnerJob> jobs;
+    std::string error;
+    if (!InstanceRunner::load_jobs(m_jobs_path, jobs, error)) {
+        std::cerr << "--jobs: " << error << "\n";
+        return false;
+    }
+    if (jobs.empty()) {
+        std::cerr << "--jobs: " << m_jobs_path << " lists no jobs\n";
+        return false;
+    }
+
+    // Every instance comes from the core that runs the first job's ROM
+    if (!m_plugin_manager->set_active_plugin_for_file(jobs.front().rom_path)) {
+        std::cerr << "No plugin found for file: " << jobs.front().rom_path << std::endl;
+        return false;
+    }
+
+    PluginManager* plugins = m_plugin_manager.get();
+    InstanceRunner runner(
+        [plugins]() { return plugins->create_emulator_instance(); },
+        [plugins](IEmulatorPlugin* instance) { plugins->destroy_emulator_instance(instance); });
+    uint64_t start = Benchmark::now_ns();
+    std::vector<RunnerJobResult> results = runner.run(jobs, m_runner_options);
+    uint64_t total_ns = Benchmark::now_ns() - start;
+
+    // Jobs that ran but desynced from their reference, or whose two
+    // configs diverged, fail the run too
+    bool all_ok = std::all_of(results.begin(), results.end(), [](const RunnerJobResult& result) {
+        return result.ok && !result.desynced && !result.diverged;
+    });
+    return InstanceRunner::write_report(results, total_ns, m_benchmark_options.report_path) && all_ok;
+}
+
 bool Application::load_rom(const std::string& path) {
     std::cout << "Loading ROM: " << path << std::endl;
 
-    // Find appropriate plugin for this file type
-    if (!m_plugin_manager->set_active_plugin_for_file(path)) {
-        std::cerr << "No plugin found for file: " << path << std::endl;
-        return false;
+    // The previous core may be switched out; stop it drawing into frame
+    // buffers it no longer owns
+    if (auto* previous = m_plugin_manager->get_active_plugin()) {
+        previous->set_output_framebuffer(nullptr, 0);
+        previous->set_cpu_trace(nullptr);
+    }
+    m_direct_output = false;
+
+    // History of the previous game is no use; sized for the new core later
+    m_rewind.clear();
+    m_rewind_stale = true;
+    m_ram_recorder.stop();
+
+    // A replay's core came from the current core's plugin
+    m_instant_replay.cancel_export();
+    m_instant_replay.clear();
+    m_instant_replay_stale = true;
+
+    // A game still warm from earlier picks up where it was left. Otherwise
+    // the current one is kept warm, if the budget allows, before its core
+    // is replaced.
+    if (!m_plugin_manager->switch_to_warm_rom(path)) {
+        if (m_plugin_manager->get_current_rom_path() != path) {
+            m_plugin_manager->park_active_rom();
+        }
+
+        // Find appropriate plugin for this file type
+        if (!m_plugin_manager->set_active_plugin_for_file(path)) {
+            std::cerr << "No plugin found for file: " << path << std::endl;
+            return false;
+        }
+
+        // Load ROM using the path-based method
+        // This handles file reading, battery saves, and game plugin initialization
+        if (!m_plugin_manager->load_rom(path)) {
+            std::cerr << "Failed to load ROM" << std::endl;
+            return false;
+        }
     }
 
-    // Load ROM using the path-based method
-    // This handles file reading, battery saves, and game plugin initialization
-    if (!m_plugin_manager->load_rom(path)) {
-        std::cerr << "Failed to load ROM" << std::endl;
-        return false;
+    // Cores mark their frame phases while a trace is recording
+    if (auto* plugin = m_plugin_manager->get_active_plugin()) {
+        plugin->set_tracer(&m_tracer);
+        if (m_cpu_tracing && !plugin->set_cpu_trace(m_cpu_trace.get())) {
+            std::cerr << "CPU trace: this core can't be traced" << std::endl;
+        }
+
+        // Static info is read again for the new game; fast mode until its
+        // first frame reports it
+        m_info_plugin = nullptr;
+        m_core_fast_mode = plugin->is_fast_mode_enabled();
+
+        // Cores that can draw straight into the render handoff buffers skip
+        // a copy per frame
+        EmulatorInfo info = plugin->get_info();
+        m_output_width = info.screen_width;
+        m_output_height = info.screen_height;
+        m_direct_output = m_output_width > 0 && m_output_height > 0 &&
+            plugin->set_output_framebuffer(m_frames.back_buffer(m_output_width, m_output_height), m_output_width);
     }
 
     // Get controller layout from emulator plugin and pass to input manager (not in headless mode)
@@ -671,26 +1955,17 @@ bool Application::load_rom(const std::string& path) {
         m_window_manager->set_title("Veloce - " + path);
     }
 
-    // Set up streaming audio callback for lowest latency
-    // The callback pushes small batches of samples (~64 = 1.5ms) during emulation
-    // rather than waiting until frame end (~16.67ms)
+    // Set up streaming audio for lowest latency
+    // The core writes small blocks of samples (~64 = 1.5ms) straight into the
+    // audio manager during emulation rather than waiting until frame end (~16.67ms)
     if (!m_headless_mode) {
         auto* active_plugin = m_plugin_manager->get_active_plugin();
         if (active_plugin) {
-            // Capture audio manager and netplay plugin pointer for the callback
-            AudioManager* audio_mgr = m_audio_manager.get();
-            PluginManager* plugin_mgr = m_plugin_manager.get();
-
-            active_plugin->set_audio_callback(
-                [audio_mgr, plugin_mgr](const float* samples, size_t count, int rate) {
-                    // Skip audio during netplay rollback to avoid artifacts
-                    auto* netplay = plugin_mgr->get_netplay_plugin();
-                    if (netplay && netplay->is_rolling_back()) {
-                        return;
-                    }
-                    // Push samples with resampling (count is stereo pairs)
-                    audio_mgr->push_samples_resampled(samples, count * 2, rate);
-                });
+            AudioStreamSink sink;
+            sink.context = this;
+            sink.reserve = &Application::reserve_audio_block;
+            sink.commit = &Application::commit_audio_block;
+            active_plugin->set_audio_sink(sink);
         }
     }
 
@@ -704,23 +1979,15 @@ bool Application::load_rom(const std::string& path) {
 }
 
 void Application::pause() {
-    m_paused = true;
-    m_audio_manager->pause();
-    m_plugin_manager->set_paused(true);
+    post_command({EmulationCommandType::Pause, nullptr});
 }
 
 void Application::resume() {
-    m_paused = false;
-    m_audio_manager->resume();
-    m_plugin_manager->set_paused(false);
+    post_command({EmulationCommandType::Resume, nullptr});
 }
 
 void Application::reset() {
-    auto* plugin = m_plugin_manager->get_active_plugin();
-    if (plugin && plugin->is_rom_loaded()) {
-        plugin->reset();
-        m_audio_manager->clear_buffer();
-    }
+    post_command({EmulationCommandType::Reset, nullptr});
 }
 
 void Application::toggle_pause() {
@@ -732,9 +1999,7 @@ void Application::toggle_pause() {
 }
 
 void Application::frame_advance() {
-    if (m_paused) {
-        m_frame_advance_requested = true;
-    }
+    post_command({EmulationCommandType::FrameAdvance, nullptr});
 }
 
 void Application::update_netplay_cache() {
@@ -747,15 +2012,8 @@ void Application::update_netplay_cache() {
         // Cache the INetplayCapable pointer
         auto* plugin = m_plugin_manager->get_active_plugin();
         m_netplay_capable_plugin = plugin ? dynamic_cast<INetplayCapable*>(plugin) : nullptr;
-
-        // Pre-allocate input buffer for the player count
-        int player_count = netplay->get_active_player_count();
-        if (static_cast<int>(m_netplay_inputs_buffer.size()) != player_count) {
-            m_netplay_inputs_buffer.resize(player_count, 0);
-        }
     } else {
         m_netplay_capable_plugin = nullptr;
-        // Don't deallocate the buffer - just leave it for potential future use
     }
 }
 
@@ -867,6 +2125,44 @@ bool Application::load_state_from_buffer(const std::vector<uint8_t>& buffer) {
     return emulator->load_state(buffer);
 }
 
+INetplayCapable* Application::get_netplay_emulator() {
+    return get_netplay_capable_emulator();
+}
+
+void Application::resimulate_frame(const NetplayFrameInputs& inputs) {
+    if (!m_plugin_manager) return;
+    auto* emulator = m_plugin_manager->get_emulator_plugin();
+    auto* netplay_capable = get_netplay_capable_emulator();
+    if (!emulator || !netplay_capable) return;
+
+    // Only the final, non-resimulated frame is shown and heard
+    emulator->set_video_enabled(false);
+    emulator->set_audio_enabled(false);
+    netplay_capable->run_frame_netplay_n(inputs);
+    netplay_capable->discard_audio();
+    emulator->clear_audio_buffer();
+    emulator->set_video_enabled(true);
+    emulator->set_audio_enabled(!emulator->is_fast_mode_enabled());
+}
+
+INetplayCapable* Application::create_emulator_clone() {
+    if (!m_plugin_manager) return nullptr;
+    IEmulatorPlugin* clone = m_plugin_manager->create_emulator_clone();
+    if (!clone) return nullptr;
+
+    auto* netplay_capable = dynamic_cast<INetplayCapable*>(clone);
+    if (!netplay_capable) {
+        m_plugin_manager->destroy_emulator_clone(clone);
+        return nullptr;
+    }
+    return netplay_capable;
+}
+
+void Application::destroy_emulator_clone(INetplayCapable* clone) {
+    if (!m_plugin_manager || !clone) return;
+    m_plugin_manager->destroy_emulator_clone(dynamic_cast<IEmulatorPlugin*>(clone));
+}
+
 void Application::set_controller_input(int controller, uint32_t buttons) {
     // This would be used by the netplay plugin to set input for specific controllers
     // For now, we only support single-player input via the input manager
@@ -876,11 +2172,20 @@ void Application::set_controller_input(int controller, uint32_t buttons) {
 
 uint32_t Application::get_local_input(int controller) const {
     if (m_input_manager && controller == 0) {
-        return m_input_manager->get_button_state();
+        return get_local_buttons();
     }
     return 0;
 }
 
+uint32_t Application::get_local_buttons() const {
+    // With the controller polling thread running its state is fresher
+    // than what the main thread published at its last update
+    if (m_input_manager && m_input_manager->is_polling()) {
+        return m_input_manager->get_latest_button_state();
+    }
+    return m_input_buttons.load(std::memory_order_relaxed);
+}
+
 const char* Application::get_config_directory() const {
     if (m_paths_config) {
         m_cached_config_dir = m_paths_config->get_config_directory().string();
@@ -950,6 +2255,148 @@ INetplayCapable* Application::get_netplay_capable_emulator() const {
     return dynamic_cast<INetplayCapable*>(emulator);
 }
 
+void Application::start_trace() {
+    // Drop anything left over from an earlier recording
+    m_tracer.take_events();
+    m_tracer.set_enabled(true);
+}
+
+std::string Application::stop_trace() {
+    m_tracer.set_enabled(false);
+
+    std::filesystem::path path = m_trace_path;
+    if (path.empty()) {
+        path = m_paths_config->get_config_directory() / "traces" / TraceWriter::generate_filename();
+    }
+    m_trace_path.clear();  // Traces started from the GUI get a fresh name
+
+    if (!TraceWriter::write(m_tracer, path)) {
+        return "";
+    }
+    std::cout << "Trace saved to " << path.string() << std::endl;
+    return path.string();
+}
+
+bool Application::start_cpu_trace() {
+    auto* plugin = m_plugin_manager ? m_plugin_manager->get_active_plugin() : nullptr;
+    if (!m_cpu_trace) {
+        m_cpu_trace = std::make_unique<CpuTrace>();
+    }
+    m_cpu_trace->clear();
+    if (plugin && !plugin->set_cpu_trace(m_cpu_trace.get())) {
+        std::cerr << "CPU trace: this core can't be traced" << std::endl;
+        return false;
+    }
+    m_cpu_tracing = true;
+    return true;
+}
+
+std::string Application::stop_cpu_trace() {
+    if (!m_cpu_tracing) return "";
+    m_cpu_tracing = false;
+    if (auto* plugin = m_plugin_manager ? m_plugin_manager->get_active_plugin() : nullptr) {
+        plugin->set_cpu_trace(nullptr);
+    }
+
+    std::filesystem::path path = m_cpu_trace_path;
+    if (path.empty()) {
+        path = m_paths_config->get_config_directory() / "traces" /
+               TraceWriter::generate_filename("cputrace", ".bin");
+    }
+    m_cpu_trace_path.clear();
+
+    std::error_code ec;
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), ec);
+    }
+    if (!m_cpu_trace->save(path.string())) {
+        std::cerr << "CPU trace: failed to write " << path.string() << std::endl;
+        return "";
+    }
+    std::cout << "CPU trace saved to " << path.string() << " (" << m_cpu_trace->size()
+              << " of " << m_cpu_trace->total() << " instructions)" << std::endl;
+    return path.string();
+}
+
+std::string Application::export_ram_recording() {
+    auto* plugin = m_plugin_manager ? m_plugin_manager->get_active_plugin() : nullptr;
+    if (!plugin || m_ram_recorder.get_frame_count() == 0) return "";
+    std::vector<MemoryDomain> domains = plugin->get_memory_domains();
+    size_t domain = m_ram_recorder.get_domain();
+    const char* domain_name = domain < domains.size() ? domains[domain].name : "RAM";
+
+    std::filesystem::path path = m_paths_config->get_config_directory() / "traces" /
+                                 TraceWriter::generate_filename("ram", ".csv");
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    std::string error;
+    if (!m_ram_recorder.export_csv(path.string(), domain_name, error)) {
+        std::cerr << "RAM recording: " << error << std::endl;
+        return "";
+    }
+    return path.string();
+}
+
+bool Application::start_av_recording(const std::string& path, bool drop_frames) {
+    auto* plugin = m_plugin_manager ? m_plugin_manager->get_active_plugin() : nullptr;
+    if (!plugin || !plugin->is_rom_loaded()) {
+        std::cerr << "[Recording] No ROM loaded\n";
+        return false;
+    }
+
+    // The stream takes the size of the frame on screen now
+    FrameBuffer fb = plugin->get_framebuffer();
+    if (!fb.pixels || fb.width <= 0 || fb.height <= 0) {
+        std::cerr << "[Recording] No framebuffer available\n";
+        return false;
+    }
+
+    AVStreamInfo info;
+    info.width = fb.width;
+    info.height = fb.height;
+    double fps = plugin->get_info().native_fps;
+    info.fps = fps > 0.0 ? fps : 60.0;
+
+    std::filesystem::path output_path = path;
+    if (output_path.empty()) {
+        output_path = m_paths_config->get_screenshot_directory() / Screenshot::generate_filename("recording");
+        output_path.replace_extension();
+    }
+
+    AVRecordOptions options;
+    options.policy = drop_frames ? AVRecordPolicy::Drop : AVRecordPolicy::Block;
+
+    std::string error;
+    if (!m_av_recorder.start(std::make_unique<RawAVEncoder>(), output_path.string(), info, options, error)) {
+        std::cerr << "[Recording] " << error << "\n";
+        return false;
+    }
+    std::cout << "Recording to " << output_path.string() << " (" << info.width << "x" << info.height
+              << " @ " << info.fps << " fps)" << std::endl;
+    return true;
+}
+
+std::string Application::stop_av_recording() {
+    if (!m_av_recorder.is_recording()) {
+        return "";
+    }
+    m_av_recorder.stop();
+
+    std::string error = m_av_recorder.get_error();
+    if (!error.empty()) {
+        std::cerr << "[Recording] " << error << "\n";
+        return "";
+    }
+
+    std::string files;
+    for (const auto& file : m_av_recorder.get_output_files()) {
+        files += (files.empty() ? "" : ", ") + file;
+    }
+    std::cout << "Recording saved to " << files << " (" << m_av_recorder.get_frames_written() << " frames, "
+              << m_av_recorder.get_frames_dropped() << " dropped)" << std::endl;
+    return files;
+}
+
 bool Application::save_screenshot(const std::string& path) {
     auto* plugin = m_plugin_manager ? m_plugin_manager->get_active_plugin() : nullptr;
     if (!plugin || !plugin->is_rom_loaded()) {
@@ -973,7 +2420,41 @@ bool Application::save_screenshot(const std::string& path) {
         output_path = path;
     }
 
-    return Screenshot::save_png(output_path, fb.pixels, fb.width, fb.height);
+    // Reported from the writer thread once the file is out
+    bool notify = m_gui_manager != nullptr;
+    return m_screenshot_writer.queue(output_path, fb.pixels, fb.width, fb.height, ScreenshotFormat::Png,
+        [this, notify](const std::string& file, bool ok) {
+            if (ok) {
+                std::cout << "[Screenshot] Saved: " << file << std::endl;
+            }
+            if (!notify) return;
+            run_on_main_thread([this, ok]() {
+                auto& notifications = m_gui_manager->get_notification_manager();
+                if (ok) {
+                    notifications.success("Screenshot saved");
+                } else {
+                    notifications.error("Failed to save screenshot");
+                }
+            });
+        });
+}
+
+void Application::start_screenshot_burst(int frames, ScreenshotFormat format) {
+    if (frames <= 0) return;
+    std::filesystem::path directory =
+        m_paths_config->get_screenshot_directory() / Screenshot::generate_filename("burst", "");
+    run_on_emulation_thread([this, frames, format, directory]() {
+        m_burst_directory = directory;
+        m_burst_format = format;
+        m_burst_dropped_base = m_screenshot_writer.get_dropped();
+        m_burst_frames_left.store(frames, std::memory_order_relaxed);
+    });
+}
+
+void Application::stop_screenshot_burst() {
+    run_on_emulation_thread([this]() {
+        m_burst_frames_left.store(0, std::memory_order_relaxed);
+    });
 }
 
 } // namespace emu
@@ -1,10 +1,32 @@
 #pragma once
 
 #include "emu/netplay_plugin.hpp"
+#include "emu/trace.hpp"
+#include "emu/cpu_trace.hpp"
+#include "benchmark.hpp"
+#include "instance_runner.hpp"
+#include "command_queue.hpp"
+#include "frame_exchange.hpp"
+#include "av_recorder.hpp"
+#include "rewind_buffer.hpp"
+#include "instant_replay.hpp"
+#include "memory_budget.hpp"
+#include "ram_recorder.hpp"
+#include "control_server.hpp"
+#include "frame_share.hpp"
+#include "screenshot_writer.hpp"
+#include "perf_monitor.hpp"
+#include "audio_backend.hpp"
+#include "thread_tuning.hpp"
 #include <string>
 #include <memory>
 #include <vector>
 #include <cstdint>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 namespace emu {
 
@@ -18,8 +40,49 @@ class SavestateManager;
 class PathsConfiguration;
 class INetplayCapable;
 
+// Commands delivered to the emulation thread, applied between frames
+enum class EmulationCommandType {
+    Pause,
+    Resume,
+    Reset,
+    FrameAdvance,
+    Call        // Run an arbitrary function on the emulation thread
+};
+
+struct EmulationCommand {
+    EmulationCommandType type = EmulationCommandType::Call;
+    std::function<void()> call;
+};
+
+// How emulated frames are timed against the display
+enum class PresentMode {
+    // The host timer paces emulation at the core's native_fps and the GUI
+    // draws at the display's rate, showing whichever frame is newest
+    Timer,
+
+    // Each vsync releases the next frame, so every frame is shown exactly
+    // once; audio dynamic rate control absorbs the difference between the
+    // display's refresh and native_fps. Falls back to Timer while vsync is
+    // off or the refresh is further from native_fps than rate control can
+    // cover (a 144 Hz display, a minimized window).
+    DisplayLocked,
+
+    // For G-Sync/FreeSync displays: the host timer paces emulation at
+    // native_fps and the GUI presents each frame as soon as it's published,
+    // so the display refreshes at the core's own rate
+    VariableRefresh
+};
+
 // Main application class - orchestrates all subsystems
 // Also implements INetplayHost to provide callbacks to the netplay plugin
+//
+// Outside headless mode the core runs on its own emulation thread, which
+// owns frame pacing; the main thread handles events, the GUI and the GL
+// upload of whichever frame was last published. Pause, reset, frame
+// advance and savestate hotkeys reach the emulation thread through a
+// lock-free command queue. GUI code that still calls into plugins directly
+// does so while the main thread holds the emulation lock, which it takes
+// only for event handling and building the GUI, never across swap_buffers.
 class Application : public INetplayHost {
 public:
     Application();
@@ -56,8 +119,9 @@ public:
     void resume();
     void reset();
     void toggle_pause();
-    bool is_paused() const { return m_paused; }
+    bool is_paused() const { return m_paused.load(std::memory_order_relaxed); }
     bool is_running() const { return m_running; }
+    int get_exit_code() const { return m_exit_code; }
     void request_quit() { m_quit_requested = true; }
 
     // Focus handling
@@ -66,18 +130,119 @@ public:
 
     // Frame control
     void frame_advance();
-    void set_speed(float speed) { m_speed_multiplier = speed; }
-    float get_speed() const { return m_speed_multiplier; }
+    void set_speed(float speed) { m_speed_multiplier.store(speed, std::memory_order_relaxed); }
+    float get_speed() const { return m_speed_multiplier.load(std::memory_order_relaxed); }
+
+    // While fast-forwarding, only this many frames per second are drawn
+    // and presented; the rest run with the core's video output off
+    void set_fast_forward_display_rate(double fps) { m_fast_forward_display_rate.store(fps, std::memory_order_relaxed); }
+    double get_fast_forward_display_rate() const { return m_fast_forward_display_rate.load(std::memory_order_relaxed); }
+
+    // Let the audio device's clock drive emulation (AudioSyncMode::AudioDriven)
+    // instead of the host timer; applies at normal speed outside netplay
+    void set_audio_paced(bool enabled) { m_audio_paced.store(enabled, std::memory_order_relaxed); }
+    bool is_audio_paced() const { return m_audio_paced.load(std::memory_order_relaxed); }
+
+    void set_present_mode(PresentMode mode) { m_present_mode.store(mode, std::memory_order_relaxed); }
+    PresentMode get_present_mode() const { return m_present_mode.load(std::memory_order_relaxed); }
+
+    // Display refresh rate measured for PresentMode::DisplayLocked; 0 in
+    // other modes, while vsync is off, or before the first measurement
+    double get_refresh_rate() const;
+
+    // Run call on the emulation thread between frames, or right away when
+    // already on it or no emulation thread is running
+    void run_on_emulation_thread(std::function<void()> call);
+
+    // Run call on the main thread at the start of its next frame
+    void run_on_main_thread(std::function<void()> call);
 
     // Debug mode
     bool is_debug_mode() const { return m_debug_mode; }
     void set_debug_mode(bool enabled) { m_debug_mode = enabled; }
     void toggle_debug_mode() { m_debug_mode = !m_debug_mode; }
 
-    // Screenshot
+    // Frame phase tracing, saved as Chrome trace JSON. Records nothing
+    // unless built with VELOCE_ENABLE_TRACING.
+    void start_trace();
+    std::string stop_trace();  // Returns the file written, or "" on failure
+    bool is_tracing() const { return m_tracer.is_enabled(); }
+    Tracer& get_tracer() { return m_tracer; }
+
+    // Per-instruction trace of the active core's CPU into an in-memory ring,
+    // saved in the binary format veloce_trace_decode reads. False if the
+    // loaded core can't be traced.
+    bool start_cpu_trace();
+    std::string stop_cpu_trace();  // Returns the file written, or "" on failure
+    bool is_cpu_tracing() const { return m_cpu_tracing; }
+
+    // Every frame's value of chosen RAM bytes, recorded after each frame the
+    // game runs forward; the GUI drives it under the emulation lock
+    RamRecorder& get_ram_recorder() { return m_ram_recorder; }
+    std::string export_ram_recording();  // CSV in traces/; the file, or "" on failure
+
+    // Frame timings for the performance overlay; measured only while enabled
+    PerfMonitor& get_perf_monitor() { return m_perf_monitor; }
+
+    // Screenshot of the current frame, written in the background as PNG;
+    // false if there's no frame to take. A timestamped name in the
+    // screenshots directory if path is empty.
     bool save_screenshot(const std::string& path = "");
     void request_screenshot() { m_screenshot_requested = true; }
 
+    // Save each of the next frames emulated (drawn even while
+    // fast-forwarding) into a new directory under the screenshots
+    // directory, named by frame count, for comparing TAS runs frame by
+    // frame. Encoding happens in the background; frames are dropped
+    // rather than slowing emulation if it falls behind.
+    void start_screenshot_burst(int frames, ScreenshotFormat format);
+    void stop_screenshot_burst();
+    bool is_screenshot_burst() const { return m_burst_frames_left.load(std::memory_order_relaxed) > 0; }
+
+    // Audio/video recording of every emulated frame (see AVRecorder), to
+    // path.y4m and path.wav; a timestamped name in the screenshots directory
+    // if path is empty. With drop_frames the emulator never waits for the
+    // writer; without, every frame is kept and emulation runs at the
+    // writer's pace. Call between frames, like the GUI does.
+    bool start_av_recording(const std::string& path = "", bool drop_frames = true);
+    std::string stop_av_recording();  // Returns the files written, or "" on failure
+    bool is_av_recording() const { return m_av_recorder.is_recording(); }
+
+    // Publish every presented frame to shared memory for capture tools
+    // (see FrameShare); false if the region can't be created
+    bool set_frame_sharing(bool enabled);
+    bool is_frame_sharing() const { return m_frame_share.is_open(); }
+
+    // Rewind (see RewindBuffer); history is kept while enabled, and holding
+    // the rewind hotkey steps back one capture per frame instead of
+    // running forward. Not available in netplay or for cores without
+    // INetplayCapable. Budget and interval are per core, from the
+    // rewind_memory_mb and rewind_interval settings of the core's name.
+    void set_rewind_enabled(bool enabled);
+    bool is_rewind_enabled() const { return m_rewind_enabled.load(std::memory_order_relaxed); }
+    void set_rewinding(bool rewinding) { m_rewinding.store(rewinding, std::memory_order_relaxed); }
+    bool is_rewinding() const { return m_rewinding.load(std::memory_order_relaxed); }
+
+    // Instant replay (see InstantReplay): while enabled, the last stretch
+    // of play is kept as states and inputs, and save_instant_replay()
+    // re-runs it on a second core in the background and records it like
+    // start_av_recording() does, to path or a timestamped name in the
+    // screenshots directory. Not kept during netplay or for cores without
+    // INetplayCapable. Length and keyframe spacing are per core, from the
+    // instant_replay_seconds and instant_replay_keyframe_interval settings.
+    void set_instant_replay_enabled(bool enabled);
+    bool is_instant_replay_enabled() const { return m_instant_replay_enabled.load(std::memory_order_relaxed); }
+    void save_instant_replay(const std::string& path = "");
+    bool is_saving_instant_replay() const { return m_instant_replay.is_exporting(); }
+
+    // Run-ahead: after each frame, save state, run this many frames further
+    // on the same input, show the last of them and load the state back, so
+    // a game's own lag frames stop adding to input latency. 0 turns it off.
+    // Needs an INetplayCapable core; frames in netplay, rewinding, fast
+    // mode, A/V recording or with a TAS movie open run normally.
+    void set_run_ahead_frames(int frames) { m_run_ahead_frames.store(frames, std::memory_order_relaxed); }
+    int get_run_ahead_frames() const { return m_run_ahead_frames.load(std::memory_order_relaxed); }
+
     // Netplay state cache management
     // Called when netplay connects/disconnects to update cached values
     void update_netplay_cache();
@@ -101,6 +266,10 @@ public:
 
     bool save_state_to_buffer(std::vector<uint8_t>& buffer) override;
     bool load_state_from_buffer(const std::vector<uint8_t>& buffer) override;
+    INetplayCapable* get_netplay_emulator() override;
+    void resimulate_frame(const NetplayFrameInputs& inputs) override;
+    INetplayCapable* create_emulator_clone() override;
+    void destroy_emulator_clone(INetplayCapable* clone) override;
 
     void set_controller_input(int controller, uint32_t buttons) override;
     uint32_t get_local_input(int controller) const override;
@@ -117,13 +286,63 @@ public:
 
 private:
     bool parse_command_line(int argc, char* argv[], std::string& rom_path);
+
+    // SDL, window, GL, input, audio and GUI (everything headless mode skips)
+    bool initialize_display();
     void print_usage(const char* program_name);
     void print_version();
 
+    // Headless --jobs run; false if the job list is unusable or any job failed
+    bool run_jobs();
+
+    // --control: serve the control socket on its own thread, running each
+    // batch on the emulation thread
+    void start_control_server();
+    void stop_control_server();
+
     void process_events();
     void update();
     void render();
-    void run_emulation_frame();
+    void run_emulation_frame(bool present = true);
+    // audio_enabled is the frame's own setting, put back afterwards
+    bool run_ahead(IEmulatorPlugin& plugin, INetplayCapable& core, int frames, bool audio_enabled);
+    void publish_frame(const FrameBuffer& fb);
+    double get_native_fps(IEmulatorPlugin* plugin);
+    void configure_rewind();
+    void configure_instant_replay();
+    void poll_instant_replay();  // Emulation thread; reports a finished save
+    void register_memory_consumers();
+
+    // emu::AudioStreamSink entry points; context is the Application
+    static float* reserve_audio_block(void* context, size_t frames, size_t* granted);
+    static void commit_audio_block(void* context, size_t frames, int sample_rate);
+
+    // emu::InputPoll entry point; context is the Application
+    static uint32_t poll_live_input(void* context, float frame_position);
+
+    // Local player's buttons for a frame (any thread)
+    uint32_t get_local_buttons() const;
+
+    // Emulation thread
+    void tune_emulation_thread();   // Priority, pinning and power request, on the thread itself
+    void start_emulation_thread();
+    void stop_emulation_thread();
+    void emulation_loop();
+    void wake_emulation_thread();
+    bool is_gui_idle();
+    void post_command(EmulationCommand&& command);
+    void execute_command(EmulationCommand& command);
+    bool on_emulation_thread() const;
+
+    // Take the emulation lock from the main thread; the emulation thread
+    // yields it between frames while the main thread is waiting
+    std::unique_lock<std::mutex> lock_emulation();
+
+    // Presentation timing (see PresentMode)
+    void measure_refresh(uint64_t now_ns);
+    void signal_vblank();
+    bool wait_for_vblank(uint64_t& seen, double max_seconds);
+    void wait_for_published_frame(double max_seconds);
 
     // Get INetplayCapable interface from current emulator if available
     INetplayCapable* get_netplay_capable_emulator() const;
@@ -140,18 +359,92 @@ private:
 
     // State
     bool m_running = false;
-    bool m_paused = true;  // Start paused until ROM loaded
+    std::atomic<bool> m_paused{true};  // Start paused until ROM loaded
     bool m_quit_requested = false;
-    bool m_frame_advance_requested = false;
+    bool m_frame_advance_requested = false;  // Owned by the emulation thread
     bool m_debug_mode = false;
     bool m_headless_mode = false;  // Run without GUI for testing
+    bool m_benchmark_mode = false; // Headless, timed, with a JSON report
+    bool m_preload_core = true;    // Load the last used core in the background at startup
+    size_t m_warm_rom_mb = 0;      // From --warm-roms; see PluginManager::set_warm_rom_budget
+    BenchmarkOptions m_benchmark_options;
+    std::string m_jobs_path;       // From --jobs; headless multi-instance run
+    RunnerOptions m_runner_options;
+    int m_exit_code = 0;
     int m_headless_frames = 0;     // Number of frames to run in headless mode (0 = unlimited)
-    float m_speed_multiplier = 1.0f;
+    std::atomic<float> m_speed_multiplier{1.0f};  // 0 = unlimited
+    std::atomic<bool> m_audio_paced{false};
+    std::atomic<double> m_fast_forward_display_rate{60.0};
+    std::atomic<PresentMode> m_present_mode{PresentMode::Timer};
+
+    // Tracing
+    Tracer m_tracer;
+    std::string m_trace_path;  // From --trace; traces/ in the config directory if empty
+    std::unique_ptr<CpuTrace> m_cpu_trace;  // Kept once allocated; it's 64 MB
+    bool m_cpu_tracing = false;
+    std::string m_cpu_trace_path;  // From --cpu-trace; as m_trace_path otherwise
+    RamRecorder m_ram_recorder;
+    PerfMonitor m_perf_monitor;
 
     // Screenshot
     bool m_screenshot_requested = false;
     int m_screenshot_at_frame = -1;  // Frame number to auto-screenshot (-1 = disabled)
     std::string m_screenshot_output_path;  // Custom output path for screenshot
+    ScreenshotWriter m_screenshot_writer;
+
+    // Screenshot burst; the directory and format belong to the emulation
+    // thread
+    std::atomic<int> m_burst_frames_left{0};
+    std::filesystem::path m_burst_directory;
+    ScreenshotFormat m_burst_format = ScreenshotFormat::Qoi;
+    uint64_t m_burst_dropped_base = 0;
+
+    // Recording
+    AVRecorder m_av_recorder;
+    std::string m_record_path;      // From --record; headless run recorded to it
+    float* m_audio_block = nullptr; // Last block from reserve_audio_block()
+    bool m_audio_to_device = true;  // False while fast mode records audio nobody hears
+
+    // Frame sharing; main thread only
+    FrameShare m_frame_share;
+
+    // Rewind; the buffer belongs to the emulation thread
+    RewindBuffer m_rewind;
+    std::atomic<bool> m_rewind_enabled{false};
+    std::atomic<bool> m_rewinding{false};  // Hotkey held
+    bool m_rewind_stale = true;             // Reconfigure for the current core
+
+    // Instant replay; the history belongs to the emulation thread
+    InstantReplay m_instant_replay;
+    std::atomic<bool> m_instant_replay_enabled{false};
+    bool m_instant_replay_stale = true;     // Reconfigure for the current core
+
+    // One budget over the history and caches above, and the warm ROMs and
+    // TAS greenzone; belongs to the emulation thread
+    MemoryBudget m_memory_budget;
+    size_t m_memory_budget_mb = 0;          // From --memory-budget; 0 is unlimited
+    bool m_low_memory = false;              // From --low-memory
+    int m_rewind_memory_id = 0;
+    int m_instant_replay_memory_id = 0;
+    int m_frames_until_memory_check = 0;
+
+    // Emulation thread scheduling (--priority, --pin-emulation, --max-performance)
+    ThreadPriority m_emulation_priority = ThreadPriority::Normal;
+    bool m_pin_emulation = false;
+    bool m_max_performance = false;
+    PowerRequest m_power_request;
+
+    // Audio output chosen with --audio-backend
+    AudioBackendType m_audio_backend = AudioBackendType::SDL;
+
+    // Remote control (see ControlServer); 0 if --control wasn't given
+    uint16_t m_control_port = 0;
+    ControlServer m_control;
+    std::thread m_control_thread;
+
+    // Run-ahead; the state buffer belongs to the emulation thread
+    std::atomic<int> m_run_ahead_frames{0};
+    std::vector<uint8_t> m_run_ahead_state;
 
     // Focus handling
     bool m_pause_on_focus_loss = true;  // Pause emulation when window loses focus
@@ -162,11 +455,49 @@ private:
     uint64_t m_last_frame_time = 0;
     double m_frame_accumulator = 0.0;
 
+    // Emulation thread
+    std::thread m_emulation_thread;
+    std::thread::id m_emulation_thread_id;
+    std::atomic<bool> m_emulation_stop{false};
+    std::mutex m_emulation_mutex;
+    std::atomic<bool> m_main_waiting{false};
+    std::mutex m_wake_mutex;                // Wakes the paused emulation thread
+    std::condition_variable m_wake;
+    std::atomic<bool> m_commands_posted{false};
+    CommandQueue<EmulationCommand, 256> m_commands;
+    CommandQueue<std::function<void()>, 256> m_main_calls;
+    FrameExchange m_frames;
+    bool m_direct_output = false;  // The core draws into m_frames' back buffer
+    int m_output_width = 0;
+    int m_output_height = 0;
+    std::atomic<uint32_t> m_input_buttons{0};  // Local input, published by the main thread
+    uint64_t m_live_frame_start = 0;    // When the live frame being run started (FramePacer::now_ns())
+    double m_live_frame_ns = 0.0;       // Its length at the current speed; 0 when uncapped
+
+    // Per-frame calls into the core are avoided: get_info() is read once
+    // per core and game, and fast mode comes back with each frame
+    IEmulatorPlugin* m_info_plugin = nullptr;  // Core m_native_fps was read from
+    double m_native_fps = 60.0;
+    bool m_core_fast_mode = false;
+
+    // Presentation timing. The main thread counts vsyncs and measures the
+    // refresh period (0 until measured, or while vsync is off); the
+    // emulation thread counts published frames.
+    std::mutex m_present_mutex;
+    std::condition_variable m_present_cv;
+    uint64_t m_vblank_count = 0;
+    uint64_t m_published_count = 0;
+    uint64_t m_published_seen = 0;         // Main thread only
+    std::atomic<uint64_t> m_refresh_period_ns{0};
+    uint64_t m_refresh_window_start = 0;    // Main thread only
+    uint64_t m_refresh_window_vblanks = 0;
+    uint64_t m_last_swap_ns = 0;
+
     // Netplay optimization: cached state to avoid per-frame overhead when netplay is inactive
     // These are updated when netplay connects/disconnects, not every frame
     bool m_netplay_active_cached = false;
     INetplayCapable* m_netplay_capable_plugin = nullptr;
-    std::vector<uint32_t> m_netplay_inputs_buffer;  // Pre-allocated buffer for netplay inputs
+    NetplayFrameInputs m_netplay_inputs_buffer;  // Reused every frame for netplay inputs
 
     // Cached strings for INetplayHost (to avoid dangling pointers)
     mutable std::string m_cached_rom_name;
@@ -0,0 +1,130 @@
+#include "audio_backend.hpp"
+
+#include <SDL.h>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+namespace emu {
+
+#ifdef VELOCE_ALSA_AUDIO
+std::unique_ptr<AudioBackend> create_alsa_audio_backend();  // audio_backend_alsa.cpp
+#endif
+
+namespace {
+
+// SDL's callback device. SDL2 has no call for the device's own latency, so
+// the buffer it was opened with stands in for it.
+class SdlAudioBackend : public AudioBackend {
+public:
+    ~SdlAudioBackend() override { close(); }
+
+    bool open(int& sample_rate, int& buffer_frames, RenderCallback render, void* userdata) override {
+        m_render = render;
+        m_userdata = userdata;
+
+        SDL_AudioSpec desired, obtained;
+        std::memset(&desired, 0, sizeof(desired));
+        desired.freq = sample_rate;
+        desired.format = AUDIO_F32SYS;
+        desired.channels = 2;  // Stereo
+        desired.samples = static_cast<uint16_t>(buffer_frames);
+        desired.callback = audio_callback;
+        desired.userdata = this;
+
+        m_device_id = SDL_OpenAudioDevice(nullptr, 0, &desired, &obtained, 0);
+        if (m_device_id == 0) {
+            std::cerr << "Failed to open audio device: " << SDL_GetError() << std::endl;
+            return false;
+        }
+
+        // Verify we got what we wanted
+        if (obtained.format != AUDIO_F32SYS) {
+            std::cerr << "Warning: Audio format mismatch" << std::endl;
+        }
+
+        sample_rate = obtained.freq;
+        buffer_frames = obtained.samples;
+        m_buffer_frames = obtained.samples;
+        return true;
+    }
+
+    void close() override {
+        if (m_device_id) {
+            SDL_CloseAudioDevice(m_device_id);
+            m_device_id = 0;
+        }
+    }
+
+    void set_paused(bool paused) override {
+        if (m_device_id) {
+            SDL_PauseAudioDevice(m_device_id, paused ? 1 : 0);
+        }
+    }
+
+    size_t get_device_latency_frames() const override { return m_buffer_frames; }
+
+private:
+    static void audio_callback(void* userdata, uint8_t* stream, int len) {
+        SdlAudioBackend* self = static_cast<SdlAudioBackend*>(userdata);
+        self->m_render(self->m_userdata, reinterpret_cast<float*>(stream), len / sizeof(float));
+    }
+
+    uint32_t m_device_id = 0;
+    size_t m_buffer_frames = 0;
+    RenderCallback m_render = nullptr;
+    void* m_userdata = nullptr;
+};
+
+bool equals_ignore_case(const char* a, const char* b) {
+    for (; *a && *b; a++, b++) {
+        if (std::tolower(static_cast<unsigned char>(*a)) != std::tolower(static_cast<unsigned char>(*b))) {
+            return false;
+        }
+    }
+    return *a == *b;
+}
+
+} // namespace
+
+const char* get_audio_backend_name(AudioBackendType type) {
+    switch (type) {
+        case AudioBackendType::SDL: return "SDL";
+        case AudioBackendType::ALSA: return "ALSA";
+        default: return "Unknown";
+    }
+}
+
+bool parse_audio_backend_name(const char* name, AudioBackendType& type) {
+    for (int i = 0; i < static_cast<int>(AudioBackendType::COUNT); i++) {
+        AudioBackendType candidate = static_cast<AudioBackendType>(i);
+        if (equals_ignore_case(name, get_audio_backend_name(candidate))) {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool is_audio_backend_available(AudioBackendType type) {
+    switch (type) {
+        case AudioBackendType::SDL: return true;
+#ifdef VELOCE_ALSA_AUDIO
+        case AudioBackendType::ALSA: return true;
+#endif
+        default: return false;
+    }
+}
+
+std::unique_ptr<AudioBackend> create_audio_backend(AudioBackendType type) {
+    switch (type) {
+        case AudioBackendType::SDL: return std::make_unique<SdlAudioBackend>();
+#ifdef VELOCE_ALSA_AUDIO
+        case AudioBackendType::ALSA: return create_alsa_audio_backend();
+#endif
+        default: return nullptr;
+    }
+}
+
+} // namespace emu
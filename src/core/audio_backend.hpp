@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+namespace emu {
+
+// Audio output paths AudioManager can open. SDL is always built; the
+// native ones only where the build found their libraries.
+enum class AudioBackendType {
+    SDL,    // SDL audio device (any platform)
+    ALSA,   // ALSA PCM written directly (Linux, VELOCE_ALSA_AUDIO); on a
+            // PipeWire or PulseAudio system "default" goes through their
+            // ALSA plugin
+    COUNT
+};
+
+const char* get_audio_backend_name(AudioBackendType type);
+
+// Parse a name as given by get_audio_backend_name, case-insensitively
+bool parse_audio_backend_name(const char* name, AudioBackendType& type);
+
+// True if this build has the backend
+bool is_audio_backend_available(AudioBackendType type);
+
+// A device that pulls interleaved stereo floats from AudioManager.
+//
+// The render callback runs on the device's own thread (SDL's audio thread
+// or the backend's writer) and is handed a whole device period at a time;
+// it only copies out of AudioManager's ring.
+class AudioBackend {
+public:
+    using RenderCallback = void (*)(void* userdata, float* buffer, size_t samples);
+
+    virtual ~AudioBackend() = default;
+
+    // Open the device paused. sample_rate and buffer_frames are what's
+    // wanted, and are updated to what the device gave.
+    virtual bool open(int& sample_rate, int& buffer_frames, RenderCallback render, void* userdata) = 0;
+    virtual void close() = 0;
+
+    virtual void set_paused(bool paused) = 0;
+
+    // Stereo frames written to the device and not yet heard, as the device
+    // last reported them; backends that can't ask report their buffer size
+    virtual size_t get_device_latency_frames() const = 0;
+};
+
+// nullptr if the backend isn't in this build
+std::unique_ptr<AudioBackend> create_audio_backend(AudioBackendType type);
+
+} // namespace emu
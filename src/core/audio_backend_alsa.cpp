@@ -0,0 +1,179 @@
+// Direct ALSA output (built with VELOCE_ALSA_AUDIO)
+//
+// A writer thread renders one period at a time and blocks in
+// snd_pcm_writei, so the device holds two periods at most and nothing sits
+// between the ring and the PCM. After every write it asks the PCM how many
+// frames are still queued, which is the latency reported to AudioManager.
+
+#include "audio_backend.hpp"
+
+#include <alsa/asoundlib.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace emu {
+
+namespace {
+
+class AlsaAudioBackend : public AudioBackend {
+public:
+    ~AlsaAudioBackend() override { close(); }
+
+    bool open(int& sample_rate, int& buffer_frames, RenderCallback render, void* userdata) override {
+        m_render = render;
+        m_userdata = userdata;
+
+        int err = snd_pcm_open(&m_pcm, "default", SND_PCM_STREAM_PLAYBACK, 0);
+        if (err < 0) {
+            std::cerr << "Failed to open ALSA device: " << snd_strerror(err) << std::endl;
+            m_pcm = nullptr;
+            return false;
+        }
+
+        unsigned int rate = static_cast<unsigned int>(sample_rate);
+        snd_pcm_uframes_t period = static_cast<snd_pcm_uframes_t>(buffer_frames);
+        snd_pcm_uframes_t buffer = period * 2;
+
+        snd_pcm_hw_params_t* hw;
+        snd_pcm_hw_params_alloca(&hw);
+        snd_pcm_hw_params_any(m_pcm, hw);
+        if ((err = snd_pcm_hw_params_set_access(m_pcm, hw, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0 ||
+            (err = snd_pcm_hw_params_set_format(m_pcm, hw, SND_PCM_FORMAT_FLOAT)) < 0 ||
+            (err = snd_pcm_hw_params_set_channels(m_pcm, hw, 2)) < 0 ||
+            (err = snd_pcm_hw_params_set_rate_near(m_pcm, hw, &rate, nullptr)) < 0 ||
+            (err = snd_pcm_hw_params_set_period_size_near(m_pcm, hw, &period, nullptr)) < 0 ||
+            (err = snd_pcm_hw_params_set_buffer_size_near(m_pcm, hw, &buffer)) < 0 ||
+            (err = snd_pcm_hw_params(m_pcm, hw)) < 0) {
+            std::cerr << "Failed to configure ALSA device: " << snd_strerror(err) << std::endl;
+            close();
+            return false;
+        }
+        snd_pcm_hw_params_get_period_size(hw, &period, nullptr);
+
+        // Start as soon as the first period is written, and wake the writer
+        // whenever a period's worth of space is free
+        snd_pcm_sw_params_t* sw;
+        snd_pcm_sw_params_alloca(&sw);
+        snd_pcm_sw_params_current(m_pcm, sw);
+        snd_pcm_sw_params_set_start_threshold(m_pcm, sw, period);
+        snd_pcm_sw_params_set_avail_min(m_pcm, sw, period);
+        if ((err = snd_pcm_sw_params(m_pcm, sw)) < 0) {
+            std::cerr << "Failed to configure ALSA device: " << snd_strerror(err) << std::endl;
+            close();
+            return false;
+        }
+
+        sample_rate = static_cast<int>(rate);
+        buffer_frames = static_cast<int>(period);
+        m_period_frames = period;
+        m_delay_frames.store(buffer, std::memory_order_relaxed);
+
+        m_paused = true;
+        m_stopping = false;
+        m_thread = std::thread(&AlsaAudioBackend::writer_loop, this);
+        return true;
+    }
+
+    void close() override {
+        if (m_thread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopping = true;
+            }
+            m_wake.notify_one();
+            m_thread.join();
+        }
+        if (m_pcm) {
+            snd_pcm_close(m_pcm);
+            m_pcm = nullptr;
+        }
+    }
+
+    void set_paused(bool paused) override {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_paused = paused;
+        }
+        m_wake.notify_one();
+    }
+
+    size_t get_device_latency_frames() const override {
+        return m_delay_frames.load(std::memory_order_relaxed);
+    }
+
+private:
+    void writer_loop() {
+        std::vector<float> period(m_period_frames * 2);
+        bool running = false;
+
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                if (m_paused && running) {
+                    // Like a paused SDL device: what's queued is dropped
+                    snd_pcm_drop(m_pcm);
+                    running = false;
+                }
+                m_wake.wait(lock, [this] { return m_stopping || !m_paused; });
+                if (m_stopping) break;
+            }
+            if (!running) {
+                snd_pcm_prepare(m_pcm);
+                running = true;
+            }
+
+            m_render(m_userdata, period.data(), period.size());
+
+            const float* data = period.data();
+            snd_pcm_uframes_t left = m_period_frames;
+            while (left > 0) {
+                snd_pcm_sframes_t written = snd_pcm_writei(m_pcm, data, left);
+                if (written < 0) {
+                    // Underrun or suspend: recover and rewrite the rest
+                    if (snd_pcm_recover(m_pcm, static_cast<int>(written), 1) < 0) {
+                        std::cerr << "ALSA write failed: " << snd_strerror(static_cast<int>(written)) << std::endl;
+                        break;
+                    }
+                    continue;
+                }
+                data += written * 2;
+                left -= static_cast<snd_pcm_uframes_t>(written);
+            }
+
+            snd_pcm_sframes_t delay = 0;
+            if (snd_pcm_delay(m_pcm, &delay) == 0 && delay >= 0) {
+                m_delay_frames.store(static_cast<size_t>(delay), std::memory_order_relaxed);
+            }
+        }
+
+        if (running) {
+            snd_pcm_drop(m_pcm);
+        }
+    }
+
+    snd_pcm_t* m_pcm = nullptr;
+    snd_pcm_uframes_t m_period_frames = 0;
+    RenderCallback m_render = nullptr;
+    void* m_userdata = nullptr;
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_paused = true;
+    bool m_stopping = false;
+
+    std::atomic<size_t> m_delay_frames{0};
+};
+
+} // namespace
+
+std::unique_ptr<AudioBackend> create_alsa_audio_backend() {
+    return std::make_unique<AlsaAudioBackend>();
+}
+
+} // namespace emu
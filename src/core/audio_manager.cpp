@@ -1,9 +1,9 @@
 #include "audio_manager.hpp"
 
-#include <SDL.h>
 #include <iostream>
 #include <cstring>
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 
 namespace emu {
@@ -14,36 +14,22 @@ AudioManager::~AudioManager() {
     shutdown();
 }
 
-bool AudioManager::initialize(int sample_rate, int buffer_size) {
+bool AudioManager::initialize(int sample_rate, int buffer_size, AudioBackendType backend) {
     m_sample_rate = sample_rate;
     m_buffer_size = buffer_size;
+    m_backend_type = backend;
 
-    // Set up audio specification
-    SDL_AudioSpec desired, obtained;
-    std::memset(&desired, 0, sizeof(desired));
-
-    desired.freq = sample_rate;
-    desired.format = AUDIO_F32SYS;
-    desired.channels = 2;  // Stereo
-    desired.samples = buffer_size;
-    desired.callback = audio_callback;
-    desired.userdata = this;
-
-    // Open audio device
-    m_device_id = SDL_OpenAudioDevice(nullptr, 0, &desired, &obtained, 0);
-    if (m_device_id == 0) {
-        std::cerr << "Failed to open audio device: " << SDL_GetError() << std::endl;
+    m_backend = create_audio_backend(backend);
+    if (!m_backend) {
+        std::cerr << "Audio backend " << get_audio_backend_name(backend)
+                  << " is not in this build" << std::endl;
         return false;
     }
-
-    // Verify we got what we wanted
-    if (obtained.format != AUDIO_F32SYS) {
-        std::cerr << "Warning: Audio format mismatch" << std::endl;
+    if (!m_backend->open(m_sample_rate, m_buffer_size, audio_callback, this)) {
+        m_backend.reset();
+        return false;
     }
 
-    m_sample_rate = obtained.freq;
-    m_buffer_size = obtained.samples;
-
     // Clear ring buffer
     std::memset(m_ring_buffer, 0, sizeof(m_ring_buffer));
     m_read_pos = 0;
@@ -51,9 +37,8 @@ bool AudioManager::initialize(int sample_rate, int buffer_size) {
 
     // Reset rate control state
     m_rate_adjustment = 1.0;
-    m_resample_accumulator = 0.0f;
-    m_prev_sample_left = 0.0f;
-    m_prev_sample_right = 0.0f;
+    m_resampler.reset();
+    m_resample_output.reserve(WRAP_CHUNK_FRAMES * 8);
     m_underrun_count = 0;
     m_overrun_count = 0;
 
@@ -63,26 +48,52 @@ bool AudioManager::initialize(int sample_rate, int buffer_size) {
     m_initialized = true;
 
     double latency_ms = (static_cast<double>(m_buffer_size) / m_sample_rate) * 1000.0;
-    std::cout << "Audio manager initialized: " << m_sample_rate << " Hz, "
-              << m_buffer_size << " sample buffer (~" << latency_ms << "ms SDL latency)" << std::endl;
+    std::cout << "Audio manager initialized (" << get_audio_backend_name(backend) << "): "
+              << m_sample_rate << " Hz, " << m_buffer_size << " sample buffer (~"
+              << latency_ms << "ms device latency)" << std::endl;
 
     return true;
 }
 
+bool AudioManager::set_backend(AudioBackendType backend) {
+    if (!m_initialized) {
+        m_backend_type = backend;
+        return true;
+    }
+    if (backend == m_backend_type) return true;
+
+    // The ring starts over empty (a few ms of sound); the producer
+    // resamples to whatever rate the new device opens at from its next push
+    bool paused = m_paused.load(std::memory_order_relaxed);
+    shutdown();
+
+    bool opened = initialize(m_sample_rate, DEFAULT_BUFFER_SIZE, backend);
+    if (!opened && backend != AudioBackendType::SDL) {
+        std::cerr << "Falling back to SDL audio" << std::endl;
+        initialize(m_sample_rate, DEFAULT_BUFFER_SIZE, AudioBackendType::SDL);
+    }
+    if (!m_initialized) return false;
+
+    if (!paused) {
+        resume();
+    }
+    return opened;
+}
+
 void AudioManager::shutdown() {
-    if (m_device_id) {
-        SDL_CloseAudioDevice(m_device_id);
-        m_device_id = 0;
+    if (m_backend) {
+        m_backend->close();
+        m_backend.reset();
     }
     m_initialized = false;
 }
 
 void AudioManager::set_sync_mode(AudioSyncMode mode) {
-    m_sync_mode = mode;
+    if (mode == m_sync_mode.load(std::memory_order_relaxed)) return;
+    m_sync_mode.store(mode, std::memory_order_relaxed);
 
     // Reset rate control when switching modes
     m_rate_adjustment = 1.0;
-    m_resample_accumulator = 0.0f;
 
     const char* mode_name = "Unknown";
     switch (mode) {
@@ -104,97 +115,134 @@ void AudioManager::push_samples(const float* samples, size_t count) {
     size_t write_pos = m_write_pos.load(std::memory_order_relaxed);
     size_t read_pos = m_read_pos.load(std::memory_order_acquire);
 
+    // One slot stays empty to tell full from empty. Drop whole stereo pairs
+    // on overflow so left and right never swap places in the ring.
+    size_t free_space = (read_pos + buffer_capacity - write_pos - 1) % buffer_capacity;
+    if (count > free_space) {
+        m_overrun_count.fetch_add(1, std::memory_order_relaxed);
+        count = free_space & ~static_cast<size_t>(1);
+    }
+
     for (size_t i = 0; i < count; i++) {
-        size_t next_write = (write_pos + 1) % buffer_capacity;
-        // Check for buffer overflow - drop samples if full
-        if (next_write == read_pos) {
-            m_overrun_count.fetch_add(1, std::memory_order_relaxed);
-            break;  // Buffer full, drop remaining samples
-        }
         m_ring_buffer[write_pos] = samples[i] * m_volume;
-        write_pos = next_write;
+        write_pos = (write_pos + 1) % buffer_capacity;
     }
 
-    m_write_pos.store(write_pos, std::memory_order_release);
+    ring_commit(count);
+}
+
+float* AudioManager::reserve_stream_block(size_t frames, size_t& granted) {
+    granted = std::clamp<size_t>(frames, 1, STREAM_BLOCK_FRAMES);
+    return m_stream_block;
+}
+
+void AudioManager::commit_stream_block(size_t frames, int source_rate) {
+    if (frames == 0) return;
+    push_samples_resampled(m_stream_block, std::min(frames, STREAM_BLOCK_FRAMES) * 2, source_rate);
 }
 
 void AudioManager::push_samples_resampled(const float* samples, size_t count, int source_rate) {
     if (!m_initialized || !samples || count == 0) return;
 
-    // If source rate matches output rate, just push directly
-    if (source_rate == m_sample_rate) {
+    bool dynamic = get_sync_mode() == AudioSyncMode::DynamicRate;
+
+    // Without rate control there's nothing to do at matching rates
+    if (source_rate == m_sample_rate && !dynamic) {
         push_samples(samples, count);
         return;
     }
 
-    // Linear interpolation resampling
-    // Ratio = source_rate / target_rate
-    // If source is 32000 and target is 44100, ratio = 0.7256
-    // We need to produce more output samples than input
-    double ratio = static_cast<double>(source_rate) / static_cast<double>(m_sample_rate);
+    if (dynamic) {
+        update_rate_control();
+    }
+
+    // One pass converts the rate and applies the rate control stretch
+    m_resampler.configure(source_rate, m_sample_rate, m_resample_quality);
+    double rate_scale = dynamic ? m_rate_adjustment : 1.0;
+    size_t input_frames = count / 2;  // count is individual samples
+
+    // The resampler writes straight into the ring's free space. Only where
+    // that space wraps around the end of the ring does a small chunk go
+    // through m_resample_output and get copied in.
+    while (input_frames > 0) {
+        size_t span_floats = 0;
+        float* span = ring_write_span(span_floats);
+        size_t chunk = std::min(input_frames, m_resampler.max_input_frames(span_floats / 2, rate_scale));
+
+        if (chunk > 0) {
+            size_t written = m_resampler.process(samples, chunk, rate_scale, span) * 2;
+            float volume = m_volume;
+            for (size_t i = 0; i < written; i++) {
+                span[i] *= volume;
+            }
+            ring_commit(written);
+        } else {
+            chunk = std::min(input_frames, WRAP_CHUNK_FRAMES);
+            size_t max_floats = m_resampler.max_output_frames(chunk, rate_scale) * 2;
+            if (get_buffered_samples() + max_floats >= RING_BUFFER_SIZE * 2) {
+                m_overrun_count.fetch_add(1, std::memory_order_relaxed);
+                return;  // Ring full, drop the rest
+            }
+            m_resample_output.resize(max_floats);
+            size_t written = m_resampler.process(samples, chunk, rate_scale, m_resample_output.data());
+            push_samples(m_resample_output.data(), written * 2);
+        }
 
+        samples += chunk * 2;
+        input_frames -= chunk;
+    }
+}
+
+float* AudioManager::ring_write_span(size_t& floats) {
     const size_t buffer_capacity = RING_BUFFER_SIZE * 2;
     size_t write_pos = m_write_pos.load(std::memory_order_relaxed);
     size_t read_pos = m_read_pos.load(std::memory_order_acquire);
 
-    // count is stereo sample count (pairs), so count*2 is individual samples
-    size_t input_samples = count / 2;  // Number of stereo pairs in input
-    size_t input_idx = 0;
-
-    while (input_idx < input_samples) {
-        // Calculate output samples for this input position
-        while (m_resample_accumulator < 1.0 && input_idx < input_samples) {
-            // Get current and next samples for interpolation
-            size_t curr = input_idx * 2;
-            size_t next = std::min((input_idx + 1) * 2, count - 2);
-
-            float curr_left = samples[curr];
-            float curr_right = samples[curr + 1];
-            float next_left = samples[next];
-            float next_right = samples[next + 1];
-
-            // Linear interpolation
-            float t = static_cast<float>(m_resample_accumulator);
-            float out_left = curr_left + t * (next_left - curr_left);
-            float out_right = curr_right + t * (next_right - curr_right);
-
-            // Push to buffer
-            size_t next_write_l = (write_pos + 1) % buffer_capacity;
-            if (next_write_l == read_pos) {
-                m_overrun_count.fetch_add(1, std::memory_order_relaxed);
-                goto done;  // Buffer full
-            }
-            m_ring_buffer[write_pos] = out_left * m_volume;
-            write_pos = next_write_l;
-
-            size_t next_write_r = (write_pos + 1) % buffer_capacity;
-            if (next_write_r == read_pos) {
-                m_overrun_count.fetch_add(1, std::memory_order_relaxed);
-                goto done;  // Buffer full
-            }
-            m_ring_buffer[write_pos] = out_right * m_volume;
-            write_pos = next_write_r;
+    // One slot stays empty to tell full from empty
+    size_t free_space = (read_pos + buffer_capacity - write_pos - 1) % buffer_capacity;
+    floats = std::min(free_space, buffer_capacity - write_pos) & ~static_cast<size_t>(1);
+    return &m_ring_buffer[write_pos];
+}
 
-            m_resample_accumulator += ratio;
-        }
+void AudioManager::ring_commit(size_t floats) {
+    const size_t buffer_capacity = RING_BUFFER_SIZE * 2;
+    size_t write_pos = m_write_pos.load(std::memory_order_relaxed);
 
-        // Move to next input sample
-        while (m_resample_accumulator >= 1.0 && input_idx < input_samples) {
-            m_resample_accumulator -= 1.0;
-            input_idx++;
+    // Effects run on the written samples before the audio thread can see
+    // them; a write can run past the end of the ring, so up to two pieces
+    if (m_effect_plugin && floats > 0) {
+        size_t first = std::min(floats, buffer_capacity - write_pos);
+        m_effect_plugin->process_in_place(&m_ring_buffer[write_pos], first);
+        if (first < floats) {
+            m_effect_plugin->process_in_place(m_ring_buffer, floats - first);
         }
     }
 
-done:
-    m_write_pos.store(write_pos, std::memory_order_release);
+    m_write_pos.store((write_pos + floats) % buffer_capacity, std::memory_order_release);
+}
+
+// ============================================================================
+// IAudioHost
+// ============================================================================
+
+AudioFormat AudioManager::get_format() const {
+    return {m_sample_rate, 2, 32};
 }
 
-void AudioManager::audio_callback(void* userdata, uint8_t* stream, int len) {
-    AudioManager* self = static_cast<AudioManager*>(userdata);
-    float* buffer = reinterpret_cast<float*>(stream);
-    size_t samples = len / sizeof(float);
+void AudioManager::output_samples(const float* samples, size_t count) {
+    push_samples(samples, count);
+}
+
+void AudioManager::pause_output() {
+    pause();
+}
+
+void AudioManager::resume_output() {
+    resume();
+}
 
-    self->fill_audio_buffer(buffer, samples);
+void AudioManager::audio_callback(void* userdata, float* buffer, size_t samples) {
+    static_cast<AudioManager*>(userdata)->fill_audio_buffer(buffer, samples);
 }
 
 void AudioManager::update_rate_control() {
@@ -208,10 +256,11 @@ void AudioManager::update_rate_control() {
     // The proportional term responds quickly to deviations
     // The integral term (accumulated in m_rate_adjustment) prevents steady-state error
     //
+    // The adjustment scales the resampler's step through the input:
     // When buffer is HIGH (positive error):
-    //   - We need to consume samples FASTER -> rate_adjustment > 1.0
+    //   - We need to produce FEWER samples per input -> rate_adjustment > 1.0
     // When buffer is LOW (negative error):
-    //   - We need to consume samples SLOWER -> rate_adjustment < 1.0
+    //   - We need to produce MORE samples per input -> rate_adjustment < 1.0
 
     // Proportional gain: more aggressive for faster response
     // 0.0001 means 500 samples of error = 5% adjustment contribution
@@ -242,120 +291,86 @@ void AudioManager::fill_audio_buffer(float* buffer, size_t samples) {
         return;
     }
 
-    // For AudioDriven mode, request samples from emulator
-    if (m_sync_mode == AudioSyncMode::AudioDriven && m_sample_callback) {
-        size_t buffered = get_buffered_samples();
-        size_t needed = (samples / 2) + m_buffer_size;  // Request enough for this callback plus one more
-
-        if (buffered < needed) {
-            // Request emulator to produce more samples
-            m_sample_callback(needed - buffered);
-        }
-    }
-
-    // Update dynamic rate control (for DynamicRate mode, but also provides stats for others)
-    if (m_sync_mode == AudioSyncMode::DynamicRate) {
-        update_rate_control();
-    }
-
     const size_t buffer_capacity = RING_BUFFER_SIZE * 2;
     size_t read_pos = m_read_pos.load(std::memory_order_relaxed);
     size_t write_pos = m_write_pos.load(std::memory_order_acquire);
 
-    // For DynamicRate mode, we resample to handle rate adjustment
-    if (m_sync_mode == AudioSyncMode::DynamicRate) {
-        for (size_t i = 0; i < samples; i += 2) {
-            // Accumulate fractional sample position
-            m_resample_accumulator += static_cast<float>(m_rate_adjustment);
-
-            while (m_resample_accumulator >= 1.0f) {
-                m_resample_accumulator -= 1.0f;
-
-                // Calculate available samples
-                size_t available;
-                if (write_pos >= read_pos) {
-                    available = write_pos - read_pos;
-                } else {
-                    available = buffer_capacity - read_pos + write_pos;
-                }
-
-                if (available >= 2) {
-                    m_prev_sample_left = m_last_sample_left;
-                    m_prev_sample_right = m_last_sample_right;
-                    m_last_sample_left = m_ring_buffer[read_pos];
-                    read_pos = (read_pos + 1) % buffer_capacity;
-                    m_last_sample_right = m_ring_buffer[read_pos];
-                    read_pos = (read_pos + 1) % buffer_capacity;
-                } else {
-                    // Underrun - fade samples toward zero to minimize clicking
-                    m_underrun_count.fetch_add(1, std::memory_order_relaxed);
-
-                    // Move prev toward current, and current toward zero
-                    m_prev_sample_left = m_last_sample_left;
-                    m_prev_sample_right = m_last_sample_right;
-                    m_last_sample_left *= 0.95f;
-                    m_last_sample_right *= 0.95f;
-                }
-            }
+    // Rate conversion and rate control already happened on the producer
+    // side; this only copies out of the ring
+    for (size_t i = 0; i < samples; i += 2) {
+        // Calculate available samples (need at least 2 for stereo pair)
+        size_t available;
+        if (write_pos >= read_pos) {
+            available = write_pos - read_pos;
+        } else {
+            available = buffer_capacity - read_pos + write_pos;
+        }
 
-            // Linear interpolation between samples for smooth resampling
-            float t = m_resample_accumulator;
-            buffer[i] = m_prev_sample_left * (1.0f - t) + m_last_sample_left * t;
-            buffer[i + 1] = m_prev_sample_right * (1.0f - t) + m_last_sample_right * t;
+        if (available >= 2) {
+            m_last_sample_left = m_ring_buffer[read_pos];
+            read_pos = (read_pos + 1) % buffer_capacity;
+            m_last_sample_right = m_ring_buffer[read_pos];
+            read_pos = (read_pos + 1) % buffer_capacity;
+        } else {
+            // Underrun - fade toward zero gradually to minimize clicking
+            // Instead of holding the last sample indefinitely (which can cause DC offset),
+            // we fade it toward zero over time
+            m_underrun_count.fetch_add(1, std::memory_order_relaxed);
+
+            // Exponential decay toward zero
+            m_last_sample_left *= 0.95f;
+            m_last_sample_right *= 0.95f;
         }
-    } else {
-        // Simple mode (AudioDriven or LargeBuffer) - no resampling
-        for (size_t i = 0; i < samples; i += 2) {
-            // Calculate available samples (need at least 2 for stereo pair)
-            size_t available;
-            if (write_pos >= read_pos) {
-                available = write_pos - read_pos;
-            } else {
-                available = buffer_capacity - read_pos + write_pos;
-            }
 
-            if (available >= 2) {
-                float new_left = m_ring_buffer[read_pos];
-                read_pos = (read_pos + 1) % buffer_capacity;
-                float new_right = m_ring_buffer[read_pos];
-                read_pos = (read_pos + 1) % buffer_capacity;
-
-                // Apply interpolation to smooth sample transitions
-                // This reduces high-frequency artifacts from sample discontinuities
-                buffer[i] = 0.5f * (new_left + m_last_sample_left);
-                buffer[i + 1] = 0.5f * (new_right + m_last_sample_right);
-
-                m_last_sample_left = new_left;
-                m_last_sample_right = new_right;
-            } else {
-                // Underrun - fade toward zero gradually to minimize clicking
-                // Instead of holding the last sample indefinitely (which can cause DC offset),
-                // we fade it toward zero over time
-                m_underrun_count.fetch_add(1, std::memory_order_relaxed);
-
-                // Exponential decay toward zero
-                m_last_sample_left *= 0.95f;
-                m_last_sample_right *= 0.95f;
-
-                buffer[i] = m_last_sample_left;
-                buffer[i + 1] = m_last_sample_right;
+        buffer[i] = m_last_sample_left;
+        buffer[i + 1] = m_last_sample_right;
+    }
+
+    m_read_pos.store(read_pos, std::memory_order_release);
+
+    // For AudioDriven mode, wake the emulation thread while the ring still
+    // holds enough to cover the time it takes to run a frame
+    if (get_sync_mode() == AudioSyncMode::AudioDriven) {
+        size_t buffered = get_buffered_samples();
+        size_t needed = get_demand_samples();
+        if (buffered < needed) {
+            {
+                std::lock_guard<std::mutex> lock(m_demand_mutex);
+                m_demand = true;
+            }
+            m_demand_cv.notify_one();
+            if (m_sample_callback) {
+                m_sample_callback(needed - buffered);
             }
         }
     }
+}
 
-    m_read_pos.store(read_pos, std::memory_order_release);
+bool AudioManager::wait_for_demand(double max_seconds) {
+    if (!m_initialized || m_paused.load(std::memory_order_relaxed)) return true;
+
+    std::unique_lock<std::mutex> lock(m_demand_mutex);
+    if (get_buffered_samples() < get_demand_samples()) {
+        m_demand = false;
+        return true;
+    }
+
+    auto timeout = std::chrono::duration<double>(std::max(max_seconds, 0.0));
+    bool signaled = m_demand_cv.wait_for(lock, timeout, [this] { return m_demand; });
+    m_demand = false;
+    return signaled;
 }
 
 void AudioManager::pause() {
-    if (m_device_id) {
-        SDL_PauseAudioDevice(m_device_id, 1);
+    if (m_backend) {
+        m_backend->set_paused(true);
         m_paused = true;
     }
 }
 
 void AudioManager::resume() {
-    if (m_device_id) {
-        SDL_PauseAudioDevice(m_device_id, 0);
+    if (m_backend) {
+        m_backend->set_paused(false);
         m_paused = false;
     }
 }
@@ -377,12 +392,13 @@ size_t AudioManager::get_buffered_samples() const {
 }
 
 double AudioManager::get_latency_ms() const {
-    // Total latency = ring buffer samples + SDL buffer
+    // Total latency = ring buffer samples + what the device still holds
     // get_buffered_samples() returns float count (L+R individual samples)
     // Divide by 2 to get stereo pair count (actual audio samples)
     size_t ring_buffer_samples = get_buffered_samples() / 2;
-    // SDL buffer is already in samples (stereo pairs)
-    size_t total_samples = ring_buffer_samples + m_buffer_size;
+    // The device reports stereo pairs; SDL can only give its buffer size
+    size_t device_samples = m_backend ? m_backend->get_device_latency_frames() : m_buffer_size;
+    size_t total_samples = ring_buffer_samples + device_samples;
     return (static_cast<double>(total_samples) / m_sample_rate) * 1000.0;
 }
 
@@ -399,9 +415,7 @@ void AudioManager::clear_buffer() {
     // m_last_sample_left = 0.0f;
     // m_last_sample_right = 0.0f;
 
-    m_prev_sample_left = m_last_sample_left;
-    m_prev_sample_right = m_last_sample_right;
-    m_resample_accumulator = 0.0f;
+    m_resampler.reset();
     m_rate_adjustment = 1.0;
     std::memset(m_ring_buffer, 0, sizeof(m_ring_buffer));
 }
@@ -416,18 +430,18 @@ bool AudioManager::is_buffer_ready() const {
     // get_buffered_samples() returns count of floats (L/R individual samples).
     // At 44100Hz stereo: 256 floats = 128 stereo pairs = ~2.9ms
     size_t min_samples;
-    switch (m_sync_mode) {
+    switch (get_sync_mode()) {
         case AudioSyncMode::AudioDriven:
             // For audio-driven, we can start almost immediately
-            // Just need enough for one SDL callback (m_buffer_size * 2 for stereo floats)
+            // Just need enough for one device callback (m_buffer_size * 2 for stereo floats)
             min_samples = m_buffer_size * 2;
             break;
         case AudioSyncMode::DynamicRate:
             // For dynamic rate, start quickly - rate control will adapt.
-            // We only need enough to fill one SDL callback without underrun.
+            // We only need enough to fill one device callback without underrun.
             // m_buffer_size is 256 samples, so we need 256*2 = 512 floats minimum.
-            // Start with exactly one SDL buffer worth to minimize latency.
-            min_samples = m_buffer_size * 2;  // ~5.8ms - one SDL buffer, rate control compensates
+            // Start with exactly one device buffer worth to minimize latency.
+            min_samples = m_buffer_size * 2;  // ~5.8ms - one device buffer, rate control compensates
             break;
         case AudioSyncMode::LargeBuffer:
         default:
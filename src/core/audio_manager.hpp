@@ -1,15 +1,23 @@
 #pragma once
 
+#include "audio_backend.hpp"
+#include "audio_resampler.hpp"
+#include "emu/audio_plugin.hpp"
+
 #include <cstdint>
 #include <cstddef>
 #include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace emu {
 
 // Default audio settings
 constexpr int DEFAULT_SAMPLE_RATE = 44100;
-// Minimum SDL buffer for lowest latency. With streaming audio and
+// Minimum device buffer for lowest latency. With streaming audio and
 // dynamic rate control, we can use a very small buffer.
 // 128 samples = ~2.9ms at 44100Hz (about 1/6 of a frame)
 // This is the primary source of audio latency - keep it as small as possible.
@@ -18,21 +26,23 @@ constexpr int DEFAULT_BUFFER_SIZE = 128;
 // Audio synchronization modes
 enum class AudioSyncMode {
     // Audio callback drives emulation timing (lowest latency, best for most users)
-    // The emulator runs when audio needs samples
+    // The emulator runs a frame when the audio callback reports the ring
+    // running low and sleeps in wait_for_demand() otherwise
     AudioDriven,
 
-    // Emulator runs at fixed rate, audio uses dynamic resampling to compensate
-    // (deterministic frame timing, good for TAS - slight pitch adjustment inaudible)
+    // Emulator runs at fixed rate, the resampler stretches its output by up to
+    // +/-0.5% to hold the device buffer level (deterministic frame timing, good
+    // for TAS - slight pitch adjustment inaudible)
     DynamicRate,
 
     // Legacy mode: large buffer, fixed rate (high latency but simple)
     LargeBuffer
 };
 
-class AudioManager {
+class AudioManager : public IAudioHost {
 public:
     AudioManager();
-    ~AudioManager();
+    ~AudioManager() override;
 
     // Disable copy
     AudioManager(const AudioManager&) = delete;
@@ -40,26 +50,65 @@ public:
 
     // Initialize audio system
     bool initialize(int sample_rate = DEFAULT_SAMPLE_RATE,
-                   int buffer_size = DEFAULT_BUFFER_SIZE);
+                   int buffer_size = DEFAULT_BUFFER_SIZE,
+                   AudioBackendType backend = AudioBackendType::SDL);
+
+    // Reopen the device on another backend, keeping the pause state; falls
+    // back to SDL if it won't open. Call with the producer stopped (the
+    // emulation lock held).
+    bool set_backend(AudioBackendType backend);
+    AudioBackendType get_backend() const { return m_backend_type; }
 
     // Shutdown
     void shutdown();
 
-    // Set audio sync mode
+    // Set audio sync mode (from the thread that pushes samples)
     void set_sync_mode(AudioSyncMode mode);
-    AudioSyncMode get_sync_mode() const { return m_sync_mode; }
+    AudioSyncMode get_sync_mode() const { return m_sync_mode.load(std::memory_order_relaxed); }
 
     // Push audio samples from emulator (for DynamicRate and LargeBuffer modes)
     void push_samples(const float* samples, size_t count);
 
-    // Push audio samples with resampling from source rate to output rate
+    // Low-latency stream blocks (see emu::AudioStreamSink): reserve a block
+    // for up to frames stereo frames at the source rate and write into it;
+    // commit resamples it straight into the ring. Producer thread only.
+    float* reserve_stream_block(size_t frames, size_t& granted);
+    void commit_stream_block(size_t frames, int source_rate);
+
+    // Push audio samples with resampling from source rate to output rate.
+    // In DynamicRate mode the rate control adjustment is applied here too, so
+    // the audio callback only copies out of the ring buffer.
     void push_samples_resampled(const float* samples, size_t count, int source_rate);
 
-    // For AudioDriven mode: set callback that produces samples on demand
-    // The callback should run enough emulation to produce the requested samples
+    // Audio plugin whose process_in_place() runs on everything written to
+    // the ring, after resampling and volume (nullptr for none). Set from the
+    // producer thread, between pushes.
+    void set_effect_plugin(IAudioPlugin* plugin) { m_effect_plugin = plugin; }
+
+    // IAudioHost: the device format, and output_samples() pushes at it
+    AudioFormat get_format() const override;
+    void output_samples(const float* samples, size_t count) override;
+    void pause_output() override;
+    void resume_output() override;
+
+    // Resampler filter length; takes effect on the next push
+    void set_resample_quality(AudioResampler::Quality quality) { m_resample_quality = quality; }
+    AudioResampler::Quality get_resample_quality() const { return m_resample_quality; }
+
+    // For AudioDriven mode: set callback told how many samples (floats) the
+    // ring is short of after each audio callback that leaves it low. It runs
+    // on the audio thread, so it should only signal, not emulate.
     using SampleCallback = std::function<void(size_t samples_needed)>;
     void set_sample_callback(SampleCallback callback);
 
+    // For AudioDriven mode: block until the audio callback finds the ring
+    // below get_demand_samples(), or max_seconds pass. Returns at once if
+    // it's already low or audio isn't playing. Returns false on timeout.
+    bool wait_for_demand(double max_seconds);
+
+    // Ring level (in floats) below which AudioDriven mode asks for another frame
+    size_t get_demand_samples() const { return static_cast<size_t>(m_buffer_size) * 2 * DEMAND_CALLBACKS; }
+
     // Control
     void pause();
     void resume();
@@ -69,9 +118,14 @@ public:
     // Status
     bool is_initialized() const { return m_initialized; }
     int get_sample_rate() const { return m_sample_rate; }
+    int get_buffer_size() const { return m_buffer_size; }  // Device period, stereo frames
     size_t get_buffered_samples() const;
 
-    // Get current audio latency in milliseconds
+    // Ring level (in floats) that dynamic rate control steers toward
+    size_t get_target_buffered_samples() const { return TARGET_BUFFER_SAMPLES; }
+
+    // Get current audio latency in milliseconds: the ring plus what the
+    // device reports still queued
     double get_latency_ms() const;
 
     // Check if buffer has enough samples to start playback without underruns
@@ -85,14 +139,21 @@ public:
     size_t get_underrun_count() const { return m_underrun_count; }
     size_t get_overrun_count() const { return m_overrun_count; }
 
+    // Furthest dynamic rate control strays from the core's rate
+    static constexpr double MAX_RATE_ADJUSTMENT = 0.005;   // +/- 0.5% max (inaudible)
+
 private:
-    // SDL audio callback
-    static void audio_callback(void* userdata, uint8_t* stream, int len);
+    // AudioBackend render callback
+    static void audio_callback(void* userdata, float* buffer, size_t samples);
     void fill_audio_buffer(float* buffer, size_t samples);
 
-    // Dynamic rate control
+    // Dynamic rate control, run by the producer before each resampled push
     void update_rate_control();
-    float resample_with_rate_adjustment(float sample);
+
+    // Contiguous free space at the ring's write position (floats, always
+    // even), and publishing what was written there
+    float* ring_write_span(size_t& floats);
+    void ring_commit(size_t floats);
 
     // Ring buffer for audio samples (lock-free SPSC)
     static constexpr size_t RING_BUFFER_SIZE = 16384;  // ~370ms at 44kHz - smaller is fine with rate control
@@ -106,16 +167,25 @@ private:
 
     // State
     bool m_initialized = false;
-    uint32_t m_device_id = 0;
+    std::unique_ptr<AudioBackend> m_backend;
+    AudioBackendType m_backend_type = AudioBackendType::SDL;
     int m_sample_rate = DEFAULT_SAMPLE_RATE;
     int m_buffer_size = DEFAULT_BUFFER_SIZE;
     float m_volume = 1.0f;
     std::atomic<bool> m_paused{false};
 
     // Sync mode
-    AudioSyncMode m_sync_mode = AudioSyncMode::DynamicRate;
+    std::atomic<AudioSyncMode> m_sync_mode{AudioSyncMode::DynamicRate};
     SampleCallback m_sample_callback;
 
+    // AudioDriven mode: the audio callback raises m_demand when the ring
+    // falls below DEMAND_CALLBACKS device buffers, which leaves the
+    // emulation thread that long to produce its next frame
+    static constexpr size_t DEMAND_CALLBACKS = 2;
+    std::mutex m_demand_mutex;
+    std::condition_variable m_demand_cv;
+    bool m_demand = false;
+
     // Dynamic rate control state
     // Target: keep buffer at minimal level for low latency while avoiding underruns
     // Lower target = lower latency, but requires faster rate control response
@@ -123,15 +193,23 @@ private:
     // Note: These values are in FLOATS (individual L/R samples), not stereo pairs.
     // At 44100Hz stereo: 128 floats = 64 stereo pairs = ~1.5ms
     double m_rate_adjustment = 1.0;  // 1.0 = no adjustment, 1.001 = 0.1% faster
-    static constexpr double MAX_RATE_ADJUSTMENT = 0.01;    // +/- 1% max (still inaudible)
     static constexpr size_t TARGET_BUFFER_SAMPLES = 128;   // ~1.5ms target buffer level (minimum latency)
     static constexpr size_t MIN_BUFFER_SAMPLES = 32;       // ~0.4ms minimum before rate increase
     static constexpr size_t MAX_BUFFER_SAMPLES = 256;      // ~2.9ms maximum before rate decrease
 
-    // Resampler state for fractional sample interpolation
-    float m_resample_accumulator = 0.0f;
-    float m_prev_sample_left = 0.0f;
-    float m_prev_sample_right = 0.0f;
+    // Producer-side resampler (core rate -> device rate, plus rate control)
+    AudioResampler m_resampler;
+    AudioResampler::Quality m_resample_quality = AudioResampler::Quality::Normal;
+    std::vector<float> m_resample_output;  // Where the ring's free space wraps
+
+    IAudioPlugin* m_effect_plugin = nullptr;
+
+    // Core-rate staging for reserve_stream_block()
+    static constexpr size_t STREAM_BLOCK_FRAMES = 1024;
+    float m_stream_block[STREAM_BLOCK_FRAMES * 2];
+
+    // Input handled per step where the ring's free space wraps
+    static constexpr size_t WRAP_CHUNK_FRAMES = 64;
 
     // Statistics
     std::atomic<size_t> m_underrun_count{0};
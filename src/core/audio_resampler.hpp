@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace emu {
+
+// Polyphase windowed-sinc resampler for interleaved stereo float audio
+//
+// Converts a core's output rate to the device rate, with an extra step
+// scale per call so dynamic rate control rides along in the same pass.
+// Each quality level has a Kaiser-windowed sinc table of PHASES + 1 rows;
+// an output sample blends the two rows around its fractional position.
+// Tables are built only when the rate pair or quality changes.
+class AudioResampler {
+public:
+    enum class Quality {
+        Fast,    // 8 taps
+        Normal,  // 16 taps
+        High     // 32 taps
+    };
+
+    // Set the conversion; rebuilds the table if the cutoff or quality
+    // changed. History is kept so a rate change mid-stream doesn't click.
+    void configure(int input_rate, int output_rate, Quality quality);
+
+    Quality get_quality() const { return m_quality; }
+
+    // Forget buffered input (after a reset or a buffer clear)
+    void reset();
+
+    // Upper bound on the frames process() writes for input_frames of input
+    size_t max_output_frames(size_t input_frames, double rate_scale) const;
+
+    // Most input frames whose output is sure to fit in output_frames
+    size_t max_input_frames(size_t output_frames, double rate_scale) const;
+
+    // Resample input_frames stereo frames into out, which must have room for
+    // max_output_frames(). rate_scale > 1 produces fewer frames (drains the
+    // device buffer), < 1 more. Returns the number of frames written.
+    size_t process(const float* input, size_t input_frames, double rate_scale, float* out);
+
+private:
+    static constexpr size_t MAX_TAPS = 32;
+
+    void build_table();
+    void emit(double position, float* out) const;
+
+    int m_input_rate = 0;
+    int m_output_rate = 0;
+    Quality m_quality = Quality::Normal;
+    double m_ratio = 1.0;  // Input frames per output frame before rate_scale
+
+    size_t m_taps = 16;
+    size_t m_phases = 128;
+    std::vector<float> m_table;  // (m_phases + 1) rows of m_taps coefficients
+
+    // Last m_taps input frames per channel, written twice so the window
+    // starting at m_history_pos is always contiguous
+    float m_history_left[MAX_TAPS * 2] = {};
+    float m_history_right[MAX_TAPS * 2] = {};
+    size_t m_history_pos = 0;
+
+    // Position of the next output frame past the window's center tap,
+    // in input frames
+    double m_time = 0.0;
+};
+
+} // namespace emu
@@ -0,0 +1,147 @@
+#include "av_encoder.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace emu {
+
+namespace {
+
+// WAV header with a WAVE_FORMAT_IEEE_FLOAT fmt chunk and the fact chunk
+// that non-PCM formats carry
+constexpr size_t WAV_HEADER_SIZE = 58;
+
+void put_u16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+void put_u32(uint8_t* p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    p[2] = static_cast<uint8_t>(v >> 16);
+    p[3] = static_cast<uint8_t>(v >> 24);
+}
+
+} // namespace
+
+RawAVEncoder::~RawAVEncoder() {
+    close();
+}
+
+bool RawAVEncoder::open(const std::string& path, const AVStreamInfo& info, std::string& error) {
+    close();
+    if (info.width <= 0 || info.height <= 0 || info.fps <= 0.0) {
+        error = "Invalid video size or frame rate";
+        return false;
+    }
+
+    m_info = info;
+    m_video_path = path + ".y4m";
+    m_audio_path = path + ".wav";
+    m_sample_rate = 0;
+    m_audio_frames = 0;
+
+    m_video = std::fopen(m_video_path.c_str(), "wb");
+    m_audio = std::fopen(m_audio_path.c_str(), "wb");
+    if (!m_video || !m_audio) {
+        error = "Can't create " + (m_video ? m_audio_path : m_video_path);
+        close();
+        return false;
+    }
+
+    // Frame rate as a fraction, e.g. 60.0988 fps -> 60099:1000
+    long fps_num = std::lround(info.fps * 1000.0);
+    std::fprintf(m_video, "YUV4MPEG2 W%d H%d F%ld:1000 Ip A1:1 C444\n", info.width, info.height, fps_num);
+
+    m_planes.resize(static_cast<size_t>(info.width) * info.height * 3);
+    write_wav_header();  // Placeholder, rewritten with the sizes on close
+    return true;
+}
+
+bool RawAVEncoder::write_video(const uint32_t* pixels) {
+    if (!m_video) return false;
+
+    // BT.601 limited range, fixed point
+    const size_t count = static_cast<size_t>(m_info.width) * m_info.height;
+    uint8_t* y_plane = m_planes.data();
+    uint8_t* u_plane = y_plane + count;
+    uint8_t* v_plane = u_plane + count;
+    for (size_t i = 0; i < count; i++) {
+        int r = (pixels[i] >> 16) & 0xFF;
+        int g = (pixels[i] >> 8) & 0xFF;
+        int b = pixels[i] & 0xFF;
+        y_plane[i] = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        u_plane[i] = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        v_plane[i] = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+
+    std::fputs("FRAME\n", m_video);
+    return std::fwrite(m_planes.data(), 1, m_planes.size(), m_video) == m_planes.size();
+}
+
+bool RawAVEncoder::write_audio(const float* samples, size_t frames, int sample_rate) {
+    if (!m_audio) return false;
+    if (frames == 0) return true;
+
+    // The stream's rate is whatever the core produced first; a core doesn't
+    // change rate mid-run
+    if (m_sample_rate == 0) {
+        m_sample_rate = sample_rate;
+    }
+
+    m_audio_frames += frames;
+    return std::fwrite(samples, sizeof(float) * 2, frames, m_audio) == frames;
+}
+
+void RawAVEncoder::close() {
+    if (m_video) {
+        std::fclose(m_video);
+        m_video = nullptr;
+    }
+    if (m_audio) {
+        write_wav_header();
+        std::fclose(m_audio);
+        m_audio = nullptr;
+    }
+}
+
+std::vector<std::string> RawAVEncoder::get_output_files() const {
+    return {m_video_path, m_audio_path};
+}
+
+void RawAVEncoder::write_wav_header() {
+    // RIFF sizes are 32 bits; past 4 GB (about three hours) the header
+    // saturates and readers fall back to the file size
+    uint64_t data_bytes = m_audio_frames * sizeof(float) * 2;
+    uint32_t data_size = static_cast<uint32_t>(std::min<uint64_t>(data_bytes, 0xFFFFFFFFu - WAV_HEADER_SIZE));
+    uint32_t rate = static_cast<uint32_t>(m_sample_rate);
+
+    uint8_t header[WAV_HEADER_SIZE];
+    std::copy_n("RIFF", 4, header);
+    put_u32(header + 4, static_cast<uint32_t>(WAV_HEADER_SIZE - 8) + data_size);
+    std::copy_n("WAVE", 4, header + 8);
+
+    std::copy_n("fmt ", 4, header + 12);
+    put_u32(header + 16, 18);
+    put_u16(header + 20, 3);           // WAVE_FORMAT_IEEE_FLOAT
+    put_u16(header + 22, 2);           // Channels
+    put_u32(header + 24, rate);
+    put_u32(header + 28, rate * 8);    // Bytes per second
+    put_u16(header + 32, 8);           // Block align
+    put_u16(header + 34, 32);          // Bits per sample
+    put_u16(header + 36, 0);           // Extension size
+
+    std::copy_n("fact", 4, header + 38);
+    put_u32(header + 42, 4);
+    put_u32(header + 46, static_cast<uint32_t>(std::min<uint64_t>(m_audio_frames, 0xFFFFFFFFu)));
+
+    std::copy_n("data", 4, header + 50);
+    put_u32(header + 54, data_size);
+
+    std::fseek(m_audio, 0, SEEK_SET);
+    std::fwrite(header, 1, WAV_HEADER_SIZE, m_audio);
+    std::fseek(m_audio, 0, SEEK_END);
+}
+
+} // namespace emu
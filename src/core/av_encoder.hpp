@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace emu {
+
+// Video stream parameters, fixed for the length of a recording
+struct AVStreamInfo {
+    int width = 0;
+    int height = 0;
+    double fps = 60.0;
+};
+
+// Writes a recording's streams to disk. AVRecorder calls an encoder only
+// from its writer thread, so implementations can take as long as they need
+// per frame without stalling emulation (up to the recorder's queue depth).
+class IAVEncoder {
+public:
+    virtual ~IAVEncoder() = default;
+
+    // Create the output files; path has no extension, the encoder adds its
+    // own. Returns false and sets error on failure.
+    virtual bool open(const std::string& path, const AVStreamInfo& info, std::string& error) = 0;
+
+    // One frame of 0xAARRGGBB pixels at the size given to open()
+    virtual bool write_video(const uint32_t* pixels) = 0;
+
+    // Interleaved stereo frames at the core's rate; the first call sets the
+    // audio stream's rate
+    virtual bool write_audio(const float* samples, size_t frames, int sample_rate) = 0;
+
+    // Finish headers and close the files
+    virtual void close() = 0;
+
+    // Files written, for reporting
+    virtual std::vector<std::string> get_output_files() const = 0;
+};
+
+// Uncompressed output that needs no codec library: video as YUV4MPEG2
+// (<path>.y4m, 4:4:4, BT.601) and audio as 32-bit float WAV (<path>.wav).
+// Both play in mpv/VLC and mux losslessly with e.g.
+//   ffmpeg -i rec.y4m -i rec.wav -c:v ffv1 -c:a flac rec.mkv
+class RawAVEncoder : public IAVEncoder {
+public:
+    ~RawAVEncoder() override;
+
+    bool open(const std::string& path, const AVStreamInfo& info, std::string& error) override;
+    bool write_video(const uint32_t* pixels) override;
+    bool write_audio(const float* samples, size_t frames, int sample_rate) override;
+    void close() override;
+    std::vector<std::string> get_output_files() const override;
+
+private:
+    void write_wav_header();
+
+    AVStreamInfo m_info;
+    std::string m_video_path;
+    std::string m_audio_path;
+    std::FILE* m_video = nullptr;
+    std::FILE* m_audio = nullptr;
+    std::vector<uint8_t> m_planes;  // Y, U, V planes of one frame
+    int m_sample_rate = 0;
+    uint64_t m_audio_frames = 0;
+};
+
+} // namespace emu
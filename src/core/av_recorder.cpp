@@ -0,0 +1,228 @@
+#include "av_recorder.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace emu {
+
+namespace {
+
+// Audio capacity reserved per slot up front; a frame's audio is well under
+// this at any core rate, so slots don't grow while recording
+constexpr size_t SLOT_AUDIO_FLOATS = 4096 * 2;
+
+// The producer doesn't take the mutex to wake the writer, so a wakeup can be
+// missed; the writer looks again after this long at the most
+constexpr auto WRITER_POLL = std::chrono::milliseconds(5);
+
+} // namespace
+
+AVRecorder::~AVRecorder() {
+    stop();
+}
+
+bool AVRecorder::start(std::unique_ptr<IAVEncoder> encoder, const std::string& path, const AVStreamInfo& info,
+                       const AVRecordOptions& options, std::string& error) {
+    stop();
+    if (!encoder) {
+        error = "No encoder";
+        return false;
+    }
+    if (!encoder->open(path, info, error)) {
+        return false;
+    }
+
+    m_encoder = std::move(encoder);
+    m_info = info;
+    m_policy = options.policy;
+
+    const size_t pixel_count = static_cast<size_t>(info.width) * info.height;
+    m_slots.assign(std::max<size_t>(options.queue_frames, 2), Packet{});
+    for (auto& slot : m_slots) {
+        slot.pixels.resize(pixel_count);
+        slot.audio.reserve(SLOT_AUDIO_FLOATS);
+    }
+    m_head.store(0, std::memory_order_relaxed);
+    m_tail.store(0, std::memory_order_relaxed);
+
+    m_pending_audio.clear();
+    m_pending_audio.reserve(SLOT_AUDIO_FLOATS);
+    m_pending_rate = 0;
+    m_pending_repeats = 0;
+
+    m_last_frame.assign(pixel_count, 0xFF000000u);
+    m_failed = false;
+    m_frames_written.store(0, std::memory_order_relaxed);
+    m_frames_dropped.store(0, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(m_error_mutex);
+        m_error.clear();
+    }
+    m_output_files.clear();
+
+    m_stopping.store(false, std::memory_order_relaxed);
+    m_writer = std::thread(&AVRecorder::writer_loop, this);
+    m_recording = true;
+    return true;
+}
+
+void AVRecorder::stop() {
+    if (!m_recording) return;
+
+    // Audio after the last frame, and drops not yet stood in for, go out in
+    // a final packet; this one waits for room whatever the policy
+    if (!m_pending_audio.empty() || m_pending_repeats > 0) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        {
+            std::unique_lock<std::mutex> lock(m_wait_mutex);
+            m_wait_cv.wait(lock, [&] {
+                return head - m_tail.load(std::memory_order_acquire) < m_slots.size();
+            });
+        }
+        Packet& slot = m_slots[head % m_slots.size()];
+        slot.audio.swap(m_pending_audio);
+        slot.sample_rate = m_pending_rate;
+        slot.repeats = m_pending_repeats;
+        slot.has_video = false;
+        m_pending_repeats = 0;
+        publish_slot();
+    }
+
+    m_stopping.store(true, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(m_wait_mutex);
+    }
+    m_wait_cv.notify_all();
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+
+    m_encoder->close();
+    m_output_files = m_encoder->get_output_files();
+    m_encoder.reset();
+    m_slots.clear();
+    m_slots.shrink_to_fit();
+    m_recording = false;
+}
+
+void AVRecorder::add_audio(const float* samples, size_t frames, int sample_rate) {
+    if (!m_recording || !samples || frames == 0) return;
+    m_pending_audio.insert(m_pending_audio.end(), samples, samples + frames * 2);
+    m_pending_rate = sample_rate;
+}
+
+void AVRecorder::add_frame(const uint32_t* pixels, int width, int height) {
+    if (!m_recording || !pixels) return;
+
+    Packet* slot = acquire_slot();
+    if (!slot) {
+        // The writer repeats the previous frame in this one's place; the
+        // audio stays pending and goes with the next frame that fits
+        m_pending_repeats++;
+        m_frames_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Cores can change resolution mid-run (SNES hi-res and interlace
+    // modes); the stream's size is fixed, so crop or pad with black
+    uint32_t* out = slot->pixels.data();
+    if (width == m_info.width && height == m_info.height) {
+        std::memcpy(out, pixels, slot->pixels.size() * sizeof(uint32_t));
+    } else {
+        const int copy_width = std::min(width, m_info.width);
+        for (int y = 0; y < m_info.height; y++) {
+            uint32_t* row = out + static_cast<size_t>(y) * m_info.width;
+            int copied = 0;
+            if (y < height) {
+                std::memcpy(row, pixels + static_cast<size_t>(y) * width, copy_width * sizeof(uint32_t));
+                copied = copy_width;
+            }
+            std::fill(row + copied, row + m_info.width, 0xFF000000u);
+        }
+    }
+
+    slot->audio.swap(m_pending_audio);
+    slot->sample_rate = m_pending_rate;
+    slot->repeats = m_pending_repeats;
+    slot->has_video = true;
+    m_pending_repeats = 0;
+    publish_slot();
+}
+
+std::string AVRecorder::get_error() const {
+    std::lock_guard<std::mutex> lock(m_error_mutex);
+    return m_error;
+}
+
+AVRecorder::Packet* AVRecorder::acquire_slot() {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    auto has_room = [&] { return head - m_tail.load(std::memory_order_acquire) < m_slots.size(); };
+
+    if (!has_room()) {
+        if (m_policy == AVRecordPolicy::Drop) {
+            return nullptr;
+        }
+        std::unique_lock<std::mutex> lock(m_wait_mutex);
+        m_wait_cv.wait(lock, has_room);
+    }
+    return &m_slots[head % m_slots.size()];
+}
+
+void AVRecorder::publish_slot() {
+    m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    m_wait_cv.notify_all();
+}
+
+void AVRecorder::writer_loop() {
+    for (;;) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire)) {
+            // Stop only once everything queued before stop() is written
+            if (m_stopping.load(std::memory_order_acquire)) {
+                if (tail == m_head.load(std::memory_order_acquire)) break;
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_wait_mutex);
+            m_wait_cv.wait_for(lock, WRITER_POLL, [&] {
+                return tail != m_head.load(std::memory_order_acquire) ||
+                       m_stopping.load(std::memory_order_acquire);
+            });
+            continue;
+        }
+
+        Packet& packet = m_slots[tail % m_slots.size()];
+        if (!m_failed) {
+            bool ok = true;
+            for (uint32_t i = 0; i < packet.repeats && ok; i++) {
+                ok = m_encoder->write_video(m_last_frame.data());
+                m_frames_written.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (ok && packet.has_video) {
+                ok = m_encoder->write_video(packet.pixels.data());
+                // The slot's buffer is overwritten whole next time, so the
+                // frame can be kept by swapping instead of copying
+                m_last_frame.swap(packet.pixels);
+                m_frames_written.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (ok && !packet.audio.empty()) {
+                ok = m_encoder->write_audio(packet.audio.data(), packet.audio.size() / 2, packet.sample_rate);
+            }
+            if (!ok) {
+                // Keep draining so a blocked producer never waits forever
+                m_failed = true;
+                std::lock_guard<std::mutex> lock(m_error_mutex);
+                m_error = "Failed to write recording (disk full?)";
+            }
+        }
+        packet.audio.clear();
+
+        m_tail.store(tail + 1, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(m_wait_mutex);
+        }
+        m_wait_cv.notify_all();
+    }
+}
+
+} // namespace emu
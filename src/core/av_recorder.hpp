@@ -0,0 +1,130 @@
+#pragma once
+
+#include "av_encoder.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace emu {
+
+// What the producer does when the writer falls behind
+enum class AVRecordPolicy {
+    // Wait for a free slot: every frame is kept, and emulation runs only as
+    // fast as the encoder. For offline encodes (TAS movies, headless runs),
+    // which then go as fast as the disk allows rather than in real time.
+    Block,
+
+    // Never wait: the video frame is dropped and the writer repeats the
+    // previous one in its place, so the streams stay in sync. Audio is
+    // never dropped. For recording live play.
+    Drop
+};
+
+struct AVRecordOptions {
+    AVRecordPolicy policy = AVRecordPolicy::Drop;
+    size_t queue_frames = 32;  // Frames buffered between producer and writer
+};
+
+// Records emulated frames and their audio through an IAVEncoder on a
+// background thread
+//
+// The thread that runs the core hands over each frame's audio with
+// add_audio() and then the frame itself with add_frame(), which copies both
+// into a slot of a bounded single-producer/single-consumer queue. Slots and
+// their buffers are allocated once at start(), so steady-state recording
+// costs the producer one framebuffer copy per frame and no allocation or
+// lock. The writer thread drains the queue into the encoder. Recording is
+// driven by emulated frames, not wall time, so it works the same at any
+// speed, including uncapped batch runs.
+class AVRecorder {
+public:
+    AVRecorder() = default;
+    ~AVRecorder();
+
+    AVRecorder(const AVRecorder&) = delete;
+    AVRecorder& operator=(const AVRecorder&) = delete;
+
+    // Open the encoder at path and start the writer thread. Frames of a
+    // different size than info's are cropped or padded to it.
+    bool start(std::unique_ptr<IAVEncoder> encoder, const std::string& path, const AVStreamInfo& info,
+               const AVRecordOptions& options, std::string& error);
+
+    // Hand over pending audio, write out the queue and close the encoder.
+    // Call from the producer thread, or while it's stopped.
+    void stop();
+
+    bool is_recording() const { return m_recording; }
+
+    // Producer thread: audio for the frame in progress (interleaved stereo)
+    void add_audio(const float* samples, size_t frames, int sample_rate);
+
+    // Producer thread: finish a frame and queue it with its audio
+    void add_frame(const uint32_t* pixels, int width, int height);
+
+    // Statistics; frames_written counts repeats standing in for drops
+    uint64_t get_frames_written() const { return m_frames_written.load(std::memory_order_relaxed); }
+    uint64_t get_frames_dropped() const { return m_frames_dropped.load(std::memory_order_relaxed); }
+
+    // First write error, if the encoder failed; the rest of the recording
+    // is discarded
+    std::string get_error() const;
+
+    // Files written by the last recording
+    std::vector<std::string> get_output_files() const { return m_output_files; }
+
+private:
+    struct Packet {
+        std::vector<uint32_t> pixels;
+        std::vector<float> audio;
+        int sample_rate = 0;
+        uint32_t repeats = 0;  // Times to repeat the previous frame first (drops)
+        bool has_video = false;
+    };
+
+    // Take the next free slot, or nullptr if full under the Drop policy
+    Packet* acquire_slot();
+    void publish_slot();
+    void writer_loop();
+
+    std::unique_ptr<IAVEncoder> m_encoder;
+    AVStreamInfo m_info;
+    AVRecordPolicy m_policy = AVRecordPolicy::Drop;
+    bool m_recording = false;
+
+    // Ring of slots; m_head is written by the producer, m_tail by the writer
+    std::vector<Packet> m_slots;
+    std::atomic<size_t> m_head{0};
+    std::atomic<size_t> m_tail{0};
+
+    // Only used to sleep when the queue is empty (writer) or full (producer
+    // under the Block policy)
+    std::mutex m_wait_mutex;
+    std::condition_variable m_wait_cv;
+
+    std::thread m_writer;
+    std::atomic<bool> m_stopping{false};
+
+    // Producer side: audio gathered since the last queued frame
+    std::vector<float> m_pending_audio;
+    int m_pending_rate = 0;
+    uint32_t m_pending_repeats = 0;
+
+    // Writer side
+    std::vector<uint32_t> m_last_frame;
+    bool m_failed = false;
+
+    std::atomic<uint64_t> m_frames_written{0};
+    std::atomic<uint64_t> m_frames_dropped{0};
+    mutable std::mutex m_error_mutex;
+    std::string m_error;
+    std::vector<std::string> m_output_files;
+};
+
+} // namespace emu
@@ -0,0 +1,98 @@
+#include "battery_save_writer.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace emu {
+
+BatterySaveWriter::~BatterySaveWriter() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+}
+
+void BatterySaveWriter::queue(const fs::path& path, std::vector<uint8_t> data) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_path = path;
+        m_data = std::move(data);
+        m_pending = true;
+        if (!m_writer.joinable()) {
+            m_writer = std::thread(&BatterySaveWriter::writer_loop, this);
+        }
+    }
+    m_wake.notify_one();
+}
+
+bool BatterySaveWriter::flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this] { return !m_pending && !m_busy; });
+    return m_last_ok;
+}
+
+void BatterySaveWriter::writer_loop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_wake.wait(lock, [this] { return m_stopping || m_pending; });
+        if (!m_pending) {
+            return;  // Stopping, with everything written
+        }
+
+        fs::path path = std::move(m_path);
+        std::vector<uint8_t> data = std::move(m_data);
+        m_pending = false;
+        m_busy = true;
+        lock.unlock();
+
+        bool ok = write_file(path, data);
+
+        lock.lock();
+        m_busy = false;
+        m_last_ok = ok;
+        if (!m_pending) {
+            m_idle.notify_all();
+        }
+    }
+}
+
+bool BatterySaveWriter::write_file(const fs::path& path, const std::vector<uint8_t>& data) {
+    std::error_code ec;
+    if (path.has_parent_path()) {
+        fs::create_directories(path.parent_path(), ec);
+    }
+
+    fs::path temp_path = path;
+    temp_path += ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "Failed to create save file: " << temp_path << std::endl;
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+        file.close();
+        if (!file) {
+            std::cerr << "Failed to write save file: " << temp_path << std::endl;
+            fs::remove(temp_path, ec);
+            return false;
+        }
+    }
+
+    fs::rename(temp_path, path, ec);
+    if (ec) {
+        std::cerr << "Failed to replace save file: " << path << std::endl;
+        fs::remove(temp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+} // namespace emu
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace emu {
+
+// Writes battery save files on a background thread
+//
+// queue() takes a copy of the save memory and returns; the writer thread
+// puts it in a temporary file and renames it over the old one, so a crash
+// mid-write leaves the previous save intact. Only the newest copy matters:
+// one queued while an older one is still waiting replaces it.
+class BatterySaveWriter {
+public:
+    BatterySaveWriter() = default;
+    ~BatterySaveWriter();
+
+    BatterySaveWriter(const BatterySaveWriter&) = delete;
+    BatterySaveWriter& operator=(const BatterySaveWriter&) = delete;
+
+    void queue(const std::filesystem::path& path, std::vector<uint8_t> data);
+
+    // Wait until everything queued so far is written; false if the last
+    // write failed
+    bool flush();
+
+private:
+    void writer_loop();
+    static bool write_file(const std::filesystem::path& path, const std::vector<uint8_t>& data);
+
+    std::thread m_writer;               // Started on the first queue()
+    std::mutex m_mutex;
+    std::condition_variable m_wake;     // Save queued, or stopping
+    std::condition_variable m_idle;     // Nothing waiting or being written
+    std::filesystem::path m_path;
+    std::vector<uint8_t> m_data;
+    bool m_pending = false;             // m_path/m_data hold a save to write
+    bool m_busy = false;                // The writer holds a save
+    bool m_last_ok = true;
+    bool m_stopping = false;
+};
+
+} // namespace emu
@@ -0,0 +1,176 @@
+#include "benchmark.hpp"
+#include "emu/emulator_plugin.hpp"
+
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace emu {
+
+namespace {
+
+// How often the sampler reads the core's profile marker
+constexpr auto SAMPLE_INTERVAL = std::chrono::microseconds(20);
+
+uint64_t percentile(const std::vector<uint64_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+} // namespace
+
+uint64_t Benchmark::now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+bool Benchmark::load_fm2_inputs(const std::string& path, std::vector<uint32_t>& inputs) {
+    std::ifstream file(path);
+    if (!file) return false;
+
+    // Frame lines are |commands|port0|port1|...; only port 0 is used, with
+    // the same bit order the TAS plugin plays FM2 movies back in
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] != '|') continue;
+        size_t field = line.find('|', 1);
+        if (field == std::string::npos || line.size() < field + 9) {
+            inputs.push_back(0);
+            continue;
+        }
+        uint32_t buttons = 0;
+        for (int i = 0; i < 8; i++) {
+            char c = line[field + 1 + i];
+            if (c != '.' && c != ' ') buttons |= 0x80u >> i;
+        }
+        inputs.push_back(buttons);
+    }
+    return true;
+}
+
+BenchmarkResult Benchmark::measure(IEmulatorPlugin& plugin, int frames, const std::vector<uint32_t>& inputs,
+                                   bool video, bool audio) {
+    BenchmarkResult result;
+    plugin.set_video_enabled(video);
+    plugin.set_audio_enabled(audio);
+
+    // Sample the subsystem marker from another thread while frames run
+    const ProfileMarker* marker = plugin.get_profile_marker();
+    std::atomic<bool> sampling{marker != nullptr};
+    std::thread sampler;
+    if (marker) {
+        sampler = std::thread([&]() {
+            while (sampling.load(std::memory_order_relaxed)) {
+                size_t section = static_cast<size_t>(marker->get());
+                if (section < static_cast<size_t>(ProfileSection::Count)) result.samples[section]++;
+                std::this_thread::sleep_for(SAMPLE_INTERVAL);
+            }
+        });
+    }
+
+    result.frame_ns.reserve(static_cast<size_t>(std::max(frames, 0)));
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < frames; i++) {
+        InputState input;
+        input.buttons = static_cast<size_t>(i) < inputs.size() ? inputs[static_cast<size_t>(i)] : 0;
+
+        uint64_t frame_start = now_ns();
+        plugin.run_frame(input);
+        if (audio) plugin.clear_audio_buffer();
+        result.frame_ns.push_back(now_ns() - frame_start);
+    }
+    result.total_ns = now_ns() - start;
+
+    sampling.store(false, std::memory_order_relaxed);
+    if (sampler.joinable()) sampler.join();
+
+    plugin.set_video_enabled(true);
+    plugin.set_audio_enabled(true);
+    return result;
+}
+
+bool Benchmark::run(IEmulatorPlugin& plugin, const BenchmarkOptions& options) {
+    std::vector<uint32_t> movie;
+    if (!options.movie_path.empty() && !load_fm2_inputs(options.movie_path, movie)) {
+        std::cerr << "Benchmark: failed to read movie " << options.movie_path << std::endl;
+        return false;
+    }
+
+    int frames = std::max(options.frames, 1);
+    BenchmarkResult result = measure(plugin, frames, movie, options.video, options.audio);
+    uint64_t total_ns = result.total_ns;
+    const std::vector<uint64_t>& frame_ns = result.frame_ns;
+    const uint64_t* samples = result.samples;
+
+    // Report
+    EmulatorInfo info = plugin.get_info();
+    double total_seconds = static_cast<double>(total_ns) / 1e9;
+    double fps = static_cast<double>(frames) / total_seconds;
+
+    uint64_t sum = 0;
+    for (uint64_t ns : frame_ns) sum += ns;
+    std::vector<uint64_t> sorted = frame_ns;
+    std::sort(sorted.begin(), sorted.end());
+
+    char crc[16];
+    std::snprintf(crc, sizeof(crc), "%08x", plugin.get_rom_crc32());
+
+    nlohmann::json report;
+    report["core"] = info.name ? info.name : "";
+    report["core_version"] = info.version ? info.version : "";
+    report["rom_crc32"] = crc;
+    report["frames"] = frames;
+    report["video"] = options.video;
+    report["audio"] = options.audio;
+    report["movie"] = options.movie_path.empty() ? nlohmann::json(nullptr) : nlohmann::json(options.movie_path);
+    report["total_seconds"] = total_seconds;
+    report["fps"] = fps;
+    report["speed"] = info.native_fps > 0.0 ? fps / info.native_fps : 0.0;
+    report["frame_ns"] = {
+        {"mean", sum / static_cast<uint64_t>(frames)},
+        {"min", sorted.front()},
+        {"p50", percentile(sorted, 0.50)},
+        {"p90", percentile(sorted, 0.90)},
+        {"p99", percentile(sorted, 0.99)},
+        {"max", sorted.back()},
+    };
+
+    uint64_t sample_count = 0;
+    for (size_t i = 0; i < static_cast<size_t>(ProfileSection::Count); i++) sample_count += samples[i];
+    if (sample_count > 0) {
+        nlohmann::json subsystems;
+        for (size_t i = 0; i < static_cast<size_t>(ProfileSection::Count); i++) {
+            double fraction = static_cast<double>(samples[i]) / static_cast<double>(sample_count);
+            subsystems[profile_section_name(static_cast<ProfileSection>(i))] = {
+                {"fraction", fraction},
+                {"ns_per_frame", fraction * static_cast<double>(total_ns) / frames},
+            };
+        }
+        report["subsystems"] = subsystems;
+        report["samples"] = sample_count;
+    } else {
+        report["subsystems"] = nullptr;
+    }
+
+    std::string text = report.dump(2);
+    if (options.report_path.empty()) {
+        std::cout << text << std::endl;
+        return true;
+    }
+    std::ofstream out(options.report_path);
+    if (!out) {
+        std::cerr << "Benchmark: failed to write report " << options.report_path << std::endl;
+        return false;
+    }
+    out << text << '\n';
+    return static_cast<bool>(out);
+}
+
+} // namespace emu
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "emu/profile.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace emu {
+
+class IEmulatorPlugin;
+
+struct BenchmarkOptions {
+    int frames = 600;
+    std::string movie_path;   // FM2 input log; no input if empty
+    bool video = false;       // Draw every frame
+    bool audio = false;       // Generate (and discard) audio every frame
+    std::string report_path;  // JSON report destination; stdout if empty
+};
+
+// Timings from one measured run
+struct BenchmarkResult {
+    uint64_t total_ns = 0;
+    std::vector<uint64_t> frame_ns;  // Per-frame wall time, in run order
+
+    // Profile marker samples per ProfileSection; all zero if the core
+    // doesn't keep a marker
+    uint64_t samples[static_cast<size_t>(ProfileSection::Count)] = {};
+};
+
+// Runs a loaded core flat out and reports its performance as JSON:
+// frames per second, per-frame time percentiles, and, for cores that keep
+// a ProfileMarker, the share of time spent in each subsystem
+//
+// The subsystem breakdown is sampled: a second thread reads the core's
+// marker every few tens of microseconds, so marking costs the core one
+// byte store per switch and the emulation itself isn't slowed by timing.
+class Benchmark {
+public:
+    // Returns false if the movie can't be read or the report written
+    static bool run(IEmulatorPlugin& plugin, const BenchmarkOptions& options);
+
+    // Run frames flat out from the core's current state and time them.
+    // Frame i gets inputs[i], or no input past the end.
+    static BenchmarkResult measure(IEmulatorPlugin& plugin, int frames, const std::vector<uint32_t>& inputs,
+                                   bool video, bool audio);
+
+    // Read port 0 of an FM2 movie, one button mask per frame
+    static bool load_fm2_inputs(const std::string& path, std::vector<uint32_t>& inputs);
+
+    // Monotonic clock in nanoseconds
+    static uint64_t now_ns();
+};
+
+} // namespace emu
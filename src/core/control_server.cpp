@@ -0,0 +1,397 @@
+#include "control_server.hpp"
+#include "emu/netplay_plugin.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+#else
+    #include <arpa/inet.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <sys/select.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+
+namespace emu {
+
+namespace {
+
+#ifdef _WIN32
+using NativeSocket = SOCKET;
+const intptr_t INVALID_SOCKET_HANDLE = static_cast<intptr_t>(INVALID_SOCKET);
+#else
+using NativeSocket = int;
+constexpr intptr_t INVALID_SOCKET_HANDLE = -1;
+#endif
+
+NativeSocket native(intptr_t sock) { return static_cast<NativeSocket>(sock); }
+
+void close_handle(intptr_t sock) {
+    if (sock == INVALID_SOCKET_HANDLE) return;
+#ifdef _WIN32
+    closesocket(native(sock));
+#else
+    ::close(native(sock));
+#endif
+}
+
+// How often a blocked socket wait looks at the stop flag
+constexpr int POLL_INTERVAL_MS = 100;
+
+// Largest message accepted; a full GBA state and a long input list fit
+// many times over
+constexpr uint32_t MAX_MESSAGE_SIZE = 64u << 20;
+
+// RUN_FRAMES runs at most this many frames per run_frames() call
+constexpr size_t MAX_FRAME_BATCH = 3600;
+
+// Hits kept for TAKE_BREAK_HITS; later ones are dropped
+constexpr size_t MAX_BREAK_HITS = 4096;
+
+enum Status : uint8_t {
+    STATUS_OK = 0,
+    STATUS_FAILED = 1
+};
+
+// Wait until sock is readable; false on timeout
+bool wait_readable(intptr_t sock) {
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(native(sock), &set);
+    timeval timeout{0, POLL_INTERVAL_MS * 1000};
+    return select(static_cast<int>(native(sock)) + 1, &set, nullptr, nullptr, &timeout) > 0;
+}
+
+// Read exactly size bytes; false if the client went away or stop was set
+bool recv_all(intptr_t sock, uint8_t* data, size_t size, const std::atomic<bool>& stop) {
+    while (size > 0) {
+        if (stop.load(std::memory_order_acquire)) return false;
+        if (!wait_readable(sock)) continue;
+        int chunk = static_cast<int>(std::min<size_t>(size, 1u << 20));
+        int got = static_cast<int>(recv(native(sock), reinterpret_cast<char*>(data), chunk, 0));
+        if (got <= 0) return false;
+        data += got;
+        size -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+bool send_all(intptr_t sock, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        int chunk = static_cast<int>(std::min<size_t>(size, 1u << 20));
+        int sent = static_cast<int>(send(native(sock), reinterpret_cast<const char*>(data), chunk, 0));
+        if (sent <= 0) return false;
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+template <typename T>
+bool take(const uint8_t*& data, const uint8_t* end, T& value) {
+    if (static_cast<size_t>(end - data) < sizeof(T)) return false;
+    std::memcpy(&value, data, sizeof(T));
+    data += sizeof(T);
+    return true;
+}
+
+template <typename T>
+void put(std::vector<uint8_t>& out, T value) {
+    size_t at = out.size();
+    out.resize(at + sizeof(T));
+    std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+void put_bytes(std::vector<uint8_t>& out, const uint8_t* data, size_t size) {
+    out.insert(out.end(), data, data + size);
+}
+
+} // namespace
+
+ControlServer::ControlServer() : m_listen(INVALID_SOCKET_HANDLE) {
+#ifdef _WIN32
+    WSADATA wsa;
+    WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+}
+
+ControlServer::~ControlServer() {
+    close();
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+bool ControlServer::open(uint16_t port) {
+    close();
+    m_error.clear();
+
+    intptr_t sock = static_cast<intptr_t>(::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP));
+    if (sock == INVALID_SOCKET_HANDLE) {
+        m_error = "Could not create a TCP socket";
+        return false;
+    }
+
+    int on = 1;
+    setsockopt(native(sock), SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&on), sizeof(on));
+
+    // Loopback only: anyone who can reach the port can drive the emulator
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    local.sin_port = htons(port);
+    if (bind(native(sock), reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0 ||
+        listen(native(sock), 1) != 0) {
+        m_error = "Could not listen on 127.0.0.1:" + std::to_string(port);
+        close_handle(sock);
+        return false;
+    }
+
+    m_listen = sock;
+    m_stop.store(false, std::memory_order_release);
+    return true;
+}
+
+void ControlServer::close() {
+    close_handle(m_listen);
+    m_listen = INVALID_SOCKET_HANDLE;
+}
+
+bool ControlServer::is_open() const {
+    return m_listen != INVALID_SOCKET_HANDLE;
+}
+
+void ControlServer::serve(const Executor& executor) {
+    std::vector<uint8_t> message;
+    std::vector<uint8_t> reply;
+
+    while (is_open() && !m_stop.load(std::memory_order_acquire)) {
+        if (!wait_readable(m_listen)) continue;
+        intptr_t client = static_cast<intptr_t>(accept(native(m_listen), nullptr, nullptr));
+        if (client == INVALID_SOCKET_HANDLE) continue;
+
+        // Replies are single writes the client is waiting on
+        int on = 1;
+        setsockopt(native(client), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&on), sizeof(on));
+
+        for (;;) {
+            uint32_t size = 0;
+            if (!recv_all(client, reinterpret_cast<uint8_t*>(&size), sizeof(size), m_stop)) break;
+            if (size > MAX_MESSAGE_SIZE) break;
+            message.resize(size);
+            if (!recv_all(client, message.data(), size, m_stop)) break;
+
+            executor([&](IEmulatorPlugin* core) { run_batch(core, message.data(), message.size()); });
+
+            reply.clear();
+            put(reply, static_cast<uint32_t>(m_reply.size()));
+            put_bytes(reply, m_reply.data(), m_reply.size());
+            if (!send_all(client, reply.data(), reply.size())) break;
+        }
+        close_handle(client);
+    }
+}
+
+void ControlServer::run_batch(IEmulatorPlugin* core, const uint8_t* data, size_t size) {
+    m_reply.clear();
+    const uint8_t* end = data + size;
+    while (data < end) {
+        size_t status_at = m_reply.size();
+        put(m_reply, STATUS_OK);
+        if (!core || !run_command(core, data, end)) {
+            m_reply.resize(status_at);
+            put(m_reply, STATUS_FAILED);
+            return;
+        }
+    }
+}
+
+size_t ControlServer::run_frames(IEmulatorPlugin& core, const InputState* inputs, size_t count) {
+    if (count == 0) return 0;
+    const RunFlags flags = RUN_FLAGS_SKIP_VIDEO | RUN_FLAGS_SKIP_AUDIO;
+    size_t ran = count;
+    if (!m_breaking) {
+        core.run_frames(inputs, count, flags);
+    } else {
+        // Hits are only known once a frame ends, so go one frame at a time
+        for (size_t i = 0; i < count; i++) {
+            core.run_frames(inputs + i, 1, flags);
+            if (collect_hits(core)) {
+                ran = i + 1;
+                break;
+            }
+        }
+    }
+    core.clear_audio_buffer();
+    return ran;
+}
+
+// Move the core's pending breakpoint hits into m_hits; true if there were any
+bool ControlServer::collect_hits(IEmulatorPlugin& core) {
+    BreakpointHit hits[64];
+    size_t total = 0;
+    while (size_t count = core.take_breakpoint_hits(hits, 64)) {
+        size_t keep = std::min(count, MAX_BREAK_HITS - std::min(m_hits.size(), MAX_BREAK_HITS));
+        m_hits.insert(m_hits.end(), hits, hits + keep);
+        total += count;
+    }
+    return total > 0;
+}
+
+bool ControlServer::run_command(IEmulatorPlugin* core, const uint8_t*& data, const uint8_t* end) {
+    uint8_t opcode = 0;
+    if (!take(data, end, opcode)) return false;
+    auto* netplay = dynamic_cast<INetplayCapable*>(core);
+
+    switch (opcode) {
+        case RUN_FRAMES: {
+            uint32_t count = 0;
+            if (!take(data, end, count)) return false;
+            m_inputs.assign(std::min<size_t>(count, MAX_FRAME_BATCH), InputState{m_buttons});
+            for (size_t left = count; left > 0;) {
+                size_t batch = std::min(left, m_inputs.size());
+                if (run_frames(*core, m_inputs.data(), batch) < batch) break;
+                left -= batch;
+            }
+            put(m_reply, static_cast<uint64_t>(core->get_frame_count()));
+            return true;
+        }
+
+        case RUN_INPUTS: {
+            uint32_t count = 0;
+            if (!take(data, end, count) || static_cast<size_t>(end - data) / 4 < count) return false;
+            m_inputs.resize(count);
+            for (uint32_t i = 0; i < count; i++) {
+                take(data, end, m_inputs[i].buttons);
+            }
+            run_frames(*core, m_inputs.data(), count);
+            put(m_reply, static_cast<uint64_t>(core->get_frame_count()));
+            return true;
+        }
+
+        case SET_BUTTONS:
+            return take(data, end, m_buttons);
+
+        case RESET:
+            core->reset();
+            return true;
+
+        case SAVE_SLOT: {
+            uint8_t index = 0;
+            if (!take(data, end, index)) return false;
+            Slot& slot = m_slots[index];
+            slot.fast = netplay != nullptr;
+            if (netplay) {
+                slot.state.resize(netplay->get_max_state_size());
+                size_t size = netplay->save_state_fast(slot.state.data(), slot.state.size());
+                slot.state.resize(size);
+                return size > 0;
+            }
+            return core->save_state(slot.state);
+        }
+
+        case LOAD_SLOT: {
+            uint8_t index = 0;
+            if (!take(data, end, index)) return false;
+            const Slot& slot = m_slots[index];
+            if (slot.state.empty()) return false;
+            if (slot.fast) {
+                return netplay && netplay->load_state_fast(slot.state.data(), slot.state.size());
+            }
+            return core->load_state(slot.state);
+        }
+
+        case GET_STATE: {
+            std::vector<uint8_t> state;
+            if (!core->save_state(state)) return false;
+            put(m_reply, static_cast<uint32_t>(state.size()));
+            put_bytes(m_reply, state.data(), state.size());
+            return true;
+        }
+
+        case SET_STATE: {
+            uint32_t size = 0;
+            if (!take(data, end, size) || static_cast<size_t>(end - data) < size) return false;
+            std::vector<uint8_t> state(data, data + size);
+            data += size;
+            return core->load_state(state);
+        }
+
+        case READ_MEMORY: {
+            uint8_t domain = 0;
+            uint32_t address = 0;
+            uint32_t length = 0;
+            if (!take(data, end, domain) || !take(data, end, address) || !take(data, end, length) ||
+                length > MAX_MESSAGE_SIZE) {
+                return false;
+            }
+            size_t at = m_reply.size();
+            m_reply.resize(at + length);
+            return core->read_memory_block(domain, address, length, m_reply.data() + at);
+        }
+
+        case STATE_HASH:
+            if (!netplay) return false;
+            put(m_reply, netplay->get_state_hash());
+            return true;
+
+        case LIST_DOMAINS: {
+            std::vector<MemoryDomain> domains = core->get_memory_domains();
+            put(m_reply, static_cast<uint8_t>(std::min<size_t>(domains.size(), 255)));
+            for (size_t i = 0; i < domains.size() && i < 255; i++) {
+                size_t length = std::min<size_t>(std::strlen(domains[i].name), 255);
+                put(m_reply, domains[i].size);
+                put(m_reply, static_cast<uint8_t>(length));
+                put_bytes(m_reply, reinterpret_cast<const uint8_t*>(domains[i].name), length);
+            }
+            return true;
+        }
+
+        case GET_FRAME: {
+            FrameBuffer fb = core->get_framebuffer();
+            if (!fb.pixels || fb.width <= 0 || fb.height <= 0) return false;
+            put(m_reply, static_cast<uint16_t>(fb.width));
+            put(m_reply, static_cast<uint16_t>(fb.height));
+            put_bytes(m_reply, reinterpret_cast<const uint8_t*>(fb.pixels),
+                      static_cast<size_t>(fb.width) * fb.height * sizeof(uint32_t));
+            return true;
+        }
+
+        case SET_BREAKPOINTS: {
+            uint32_t count = 0;
+            if (!take(data, end, count) || static_cast<size_t>(end - data) / 9 < count) return false;
+            std::vector<Breakpoint> breakpoints(count);
+            for (Breakpoint& breakpoint : breakpoints) {
+                take(data, end, breakpoint.address);
+                take(data, end, breakpoint.length);
+                take(data, end, breakpoint.kinds);
+            }
+            if (!core->set_breakpoints(breakpoints.data(), breakpoints.size())) return false;
+            m_breaking = count > 0;
+            m_hits.clear();
+            return true;
+        }
+
+        case TAKE_BREAK_HITS:
+            collect_hits(*core);
+            put(m_reply, static_cast<uint32_t>(m_hits.size()));
+            for (const BreakpointHit& hit : m_hits) {
+                put(m_reply, hit.address);
+                put(m_reply, hit.kind);
+                put(m_reply, hit.value);
+                put(m_reply, hit.frame);
+                put(m_reply, hit.frame_position);
+            }
+            m_hits.clear();
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+} // namespace emu
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "emu/emulator_plugin.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace emu {
+
+// Remote control of the running core over a localhost TCP socket, for bots
+// and route optimizers
+//
+// A client sends messages, each a u32 payload length followed by a batch of
+// commands, and gets one reply per message: a u32 length, then for each
+// command run a status byte (0 ok, 1 failed) and the command's result.
+// A failed command ends the batch. Everything is little-endian. Batching
+// means a client can run thousands of frames, juggle states and read back
+// the memory it scores on in a single round trip.
+//
+// Commands (opcode, arguments -> result):
+//   RUN_FRAMES     u32 count                 -> u64 frame count
+//                  count frames with the held buttons, drawing the last
+//   RUN_INPUTS     u32 count, u32 buttons[count] -> u64 frame count
+//                  one frame per button mask, drawing the last
+//   SET_BUTTONS    u32 buttons               -> nothing
+//                  buttons held on controller 1 by RUN_FRAMES
+//   RESET          nothing                   -> nothing
+//   SAVE_SLOT      u8 slot                   -> nothing
+//   LOAD_SLOT      u8 slot                   -> nothing
+//                  states kept on the server in 256 in-memory slots
+//   GET_STATE      nothing                   -> u32 size, state
+//   SET_STATE      u32 size, state           -> nothing
+//   READ_MEMORY    u8 domain, u32 address, u32 length -> bytes
+//   STATE_HASH     nothing                   -> u64 hash
+//   LIST_DOMAINS   nothing                   -> u8 count, per domain u32 size,
+//                                               u8 name length, name
+//   GET_FRAME      nothing                   -> u16 width, u16 height,
+//                                               pixels (u32 0xAARRGGBB)
+//   SET_BREAKPOINTS u32 count, per breakpoint u32 address, u32 length,
+//                  u8 kinds (1 execute, 2 read, 4 write) -> nothing
+//                  replaces the core's breakpoints; count 0 clears them
+//   TAKE_BREAK_HITS nothing                  -> u32 count, per hit u32 address,
+//                                               u8 kind, u8 value, u64 frame,
+//                                               f32 position in the frame
+//
+// While breakpoints are set, RUN_FRAMES and RUN_INPUTS stop after the
+// first frame with a hit; the frame count they return shows where.
+//
+// One client is served at a time. The server thread only does the socket
+// work; each batch runs through the executor on whichever thread owns the
+// core, between frames.
+class ControlServer {
+public:
+    enum Opcode : uint8_t {
+        RUN_FRAMES = 1,
+        RUN_INPUTS = 2,
+        SET_BUTTONS = 3,
+        RESET = 4,
+        SAVE_SLOT = 5,
+        LOAD_SLOT = 6,
+        GET_STATE = 7,
+        SET_STATE = 8,
+        READ_MEMORY = 9,
+        STATE_HASH = 10,
+        LIST_DOMAINS = 11,
+        GET_FRAME = 12,
+        SET_BREAKPOINTS = 13,
+        TAKE_BREAK_HITS = 14
+    };
+
+    // Runs work with the active core (nullptr if no ROM is loaded) on the
+    // thread that owns it, and returns once it has run
+    using Executor = std::function<void(const std::function<void(IEmulatorPlugin*)>& work)>;
+
+    ControlServer();
+    ~ControlServer();
+
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    // Listen on 127.0.0.1:port; false and get_error() set on failure
+    bool open(uint16_t port);
+    void close();
+    bool is_open() const;
+    const std::string& get_error() const { return m_error; }
+
+    // Serve clients until stop() (from any thread) or the socket closes
+    void serve(const Executor& executor);
+    void stop() { m_stop.store(true, std::memory_order_release); }
+
+private:
+    // Run one message's commands against core into m_reply
+    void run_batch(IEmulatorPlugin* core, const uint8_t* data, size_t size);
+    bool run_command(IEmulatorPlugin* core, const uint8_t*& data, const uint8_t* end);
+
+    // save_state_fast() states where the core has them
+    struct Slot {
+        std::vector<uint8_t> state;
+        bool fast = false;
+    };
+
+    // Returns how many frames ran, fewer than count if a breakpoint hit
+    size_t run_frames(IEmulatorPlugin& core, const InputState* inputs, size_t count);
+    bool collect_hits(IEmulatorPlugin& core);
+
+    intptr_t m_listen;
+    std::atomic<bool> m_stop{false};
+    std::string m_error;
+
+    // Only touched by the executor's thread while a batch runs
+    uint32_t m_buttons = 0;
+    Slot m_slots[256];
+    std::vector<uint8_t> m_reply;
+    std::vector<InputState> m_inputs;
+    bool m_breaking = false;
+    std::vector<BreakpointHit> m_hits;
+};
+
+} // namespace emu
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace emu {
+
+// Triple-buffered handoff of finished frames from the emulation thread to
+// the render thread
+//
+// The producer always has a back buffer to write into and the consumer
+// always has a front buffer to read from; publishing and acquiring swap
+// them with the middle buffer through one atomic exchange. Neither side
+// waits on the other: a frame the renderer never picked up is overwritten
+// by the next one, and a renderer ahead of emulation keeps the last frame.
+class FrameExchange {
+public:
+    struct Frame {
+        std::vector<uint32_t> pixels;
+        int width = 0;
+        int height = 0;
+    };
+
+    // Producer: copy a finished frame into the back buffer and publish it
+    void publish(const uint32_t* pixels, int width, int height) {
+        Frame& frame = m_frames[m_back];
+        size_t count = static_cast<size_t>(width) * static_cast<size_t>(height);
+        frame.pixels.resize(count);
+        std::memcpy(frame.pixels.data(), pixels, count * sizeof(uint32_t));
+        frame.width = width;
+        frame.height = height;
+
+        m_back = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Producer: the back buffer, sized for width x height, for a core to
+    // draw a frame straight into (IEmulatorPlugin::set_output_framebuffer)
+    uint32_t* back_buffer(int width, int height) {
+        Frame& frame = m_frames[m_back];
+        frame.pixels.resize(static_cast<size_t>(width) * static_cast<size_t>(height));
+        return frame.pixels.data();
+    }
+
+    bool is_back_buffer(const uint32_t* pixels) const {
+        return pixels == m_frames[m_back].pixels.data();
+    }
+
+    // Producer: publish a frame drawn into back_buffer() without copying it
+    void publish_back(int width, int height) {
+        Frame& frame = m_frames[m_back];
+        frame.width = width;
+        frame.height = height;
+
+        m_back = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Consumer: the newest frame if one was published since the last call,
+    // otherwise nullptr. Stays valid until the next call.
+    const Frame* acquire() {
+        if (!(m_middle.load(std::memory_order_relaxed) & FRESH)) return nullptr;
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+        return &m_frames[m_front];
+    }
+
+private:
+    static constexpr int INDEX_MASK = 3;
+    static constexpr int FRESH = 4;
+
+    Frame m_frames[3];
+    int m_back = 0;                 // Owned by the producer
+    int m_front = 1;                // Owned by the consumer
+    std::atomic<int> m_middle{2};   // Index, plus FRESH once published
+};
+
+} // namespace emu
@@ -0,0 +1,145 @@
+#include "frame_pacer.hpp"
+#include "audio_manager.hpp"
+
+#include <algorithm>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <timeapi.h>
+    #ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+        #define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+    #endif
+#elif defined(__APPLE__)
+    #include <mach/mach_time.h>
+#else
+    #include <cerrno>
+    #include <time.h>
+#endif
+
+namespace emu {
+
+namespace {
+
+// Bounds on the spin margin; the upper one caps the cost of a bad timer
+constexpr uint64_t MIN_SPIN_MARGIN_NS = 50'000;
+constexpr uint64_t MAX_SPIN_MARGIN_NS = 4'000'000;
+constexpr uint64_t INITIAL_SPIN_MARGIN_NS = 1'000'000;
+
+#ifdef __APPLE__
+const mach_timebase_info_data_t& timebase() {
+    static mach_timebase_info_data_t info = [] {
+        mach_timebase_info_data_t i;
+        mach_timebase_info(&i);
+        return i;
+    }();
+    return info;
+}
+#endif
+
+} // namespace
+
+FramePacer::FramePacer() : m_spin_margin_ns(INITIAL_SPIN_MARGIN_NS) {
+#ifdef _WIN32
+    // 1 ms scheduler granularity for the fallback path and for waking the
+    // timer thread promptly
+    timeBeginPeriod(1);
+    m_timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!m_timer) {
+        // Before Windows 10 1803
+        m_timer = CreateWaitableTimerW(nullptr, TRUE, nullptr);
+    }
+#endif
+}
+
+FramePacer::~FramePacer() {
+#ifdef _WIN32
+    if (m_timer) {
+        CloseHandle(static_cast<HANDLE>(m_timer));
+    }
+    timeEndPeriod(1);
+#endif
+}
+
+uint64_t FramePacer::now_ns() {
+#ifdef _WIN32
+    static const uint64_t frequency = [] {
+        LARGE_INTEGER f;
+        QueryPerformanceFrequency(&f);
+        return static_cast<uint64_t>(f.QuadPart);
+    }();
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    uint64_t ticks = static_cast<uint64_t>(counter.QuadPart);
+    return (ticks / frequency) * 1'000'000'000ull + (ticks % frequency) * 1'000'000'000ull / frequency;
+#elif defined(__APPLE__)
+    const auto& info = timebase();
+    return static_cast<uint64_t>(static_cast<unsigned __int128>(mach_absolute_time()) * info.numer / info.denom);
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ull + static_cast<uint64_t>(ts.tv_nsec);
+#endif
+}
+
+void FramePacer::sleep_until(uint64_t deadline_ns) {
+#ifdef _WIN32
+    uint64_t now = now_ns();
+    if (deadline_ns <= now) return;
+    if (m_timer) {
+        // Relative due time in 100 ns units
+        LARGE_INTEGER due;
+        due.QuadPart = -static_cast<LONGLONG>((deadline_ns - now) / 100);
+        if (SetWaitableTimer(static_cast<HANDLE>(m_timer), &due, 0, nullptr, nullptr, FALSE)) {
+            WaitForSingleObject(static_cast<HANDLE>(m_timer), INFINITE);
+            return;
+        }
+    }
+    Sleep(static_cast<DWORD>((deadline_ns - now) / 1'000'000));
+#elif defined(__APPLE__)
+    const auto& info = timebase();
+    mach_wait_until(static_cast<uint64_t>(static_cast<unsigned __int128>(deadline_ns) * info.denom / info.numer));
+#else
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(deadline_ns / 1'000'000'000ull);
+    ts.tv_nsec = static_cast<long>(deadline_ns % 1'000'000'000ull);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+#endif
+}
+
+void FramePacer::wait_until(uint64_t deadline_ns) {
+    uint64_t wake = deadline_ns > m_spin_margin_ns ? deadline_ns - m_spin_margin_ns : 0;
+    if (now_ns() < wake) {
+        sleep_until(wake);
+
+        // Track the worst recent lateness, letting it decay slowly so one
+        // hiccup doesn't keep the margin wide forever
+        uint64_t now = now_ns();
+        uint64_t lateness = now > wake ? now - wake : 0;
+        m_lateness_peak_ns = std::max(lateness, m_lateness_peak_ns - m_lateness_peak_ns / 64);
+        m_spin_margin_ns = std::clamp(m_lateness_peak_ns + m_lateness_peak_ns / 4,
+                                      MIN_SPIN_MARGIN_NS, MAX_SPIN_MARGIN_NS);
+    }
+
+    // Spin for the remaining time for more accurate timing
+    while (now_ns() < deadline_ns) {
+    }
+}
+
+void FramePacer::begin_frame() {
+    m_frame_start = now_ns();
+}
+
+void FramePacer::wait_for(double seconds) {
+    if (seconds <= 0.0) return;
+    wait_until(m_frame_start + static_cast<uint64_t>(seconds * 1e9));
+}
+
+void FramePacer::wait_for_audio(AudioManager& audio, double max_seconds) {
+    uint64_t give_up = m_frame_start + static_cast<uint64_t>(std::max(max_seconds, 0.0) * 1e9);
+    uint64_t now = now_ns();
+    if (now >= give_up) return;
+    audio.wait_for_demand(static_cast<double>(give_up - now) / 1e9);
+}
+
+} // namespace emu
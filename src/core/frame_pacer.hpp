@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+namespace emu {
+
+class AudioManager;
+
+// Frame pacing for the emulation thread
+//
+// Sleeps on the platform's high-resolution timer (clock_nanosleep with an
+// absolute deadline on Linux, mach_wait_until on macOS, a high-resolution
+// waitable timer on Windows) until just short of the deadline, then spins
+// the rest. The spin margin calibrates itself from how late the timer
+// actually wakes, so an idle instance spends microseconds, not a whole
+// frame, busy-waiting.
+class FramePacer {
+public:
+    FramePacer();
+    ~FramePacer();
+
+    // Disable copy
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    // Mark the start of a frame; waits are measured from here
+    void begin_frame();
+
+    // Wait until seconds have passed since begin_frame()
+    void wait_for(double seconds);
+
+    // Sleep until the audio callback asks for more samples
+    // (AudioSyncMode::AudioDriven), so the audio device's clock paces
+    // emulation. Gives up once max_seconds have passed since begin_frame(),
+    // in case audio stalls.
+    void wait_for_audio(AudioManager& audio, double max_seconds);
+
+    // Current spin margin in seconds
+    double get_spin_margin() const { return static_cast<double>(m_spin_margin_ns) / 1e9; }
+
+    // Monotonic clock in nanoseconds
+    static uint64_t now_ns();
+
+private:
+    // Sleep on the OS timer until deadline (may wake late, never early)
+    void sleep_until(uint64_t deadline_ns);
+
+    // Sleep until the margin before deadline, then spin to it
+    void wait_until(uint64_t deadline_ns);
+
+    uint64_t m_frame_start = 0;
+
+    // Spin margin, and the worst recent wake-up lateness it's derived from
+    uint64_t m_spin_margin_ns;
+    uint64_t m_lateness_peak_ns = 0;
+
+#ifdef _WIN32
+    void* m_timer = nullptr;
+#endif
+};
+
+} // namespace emu
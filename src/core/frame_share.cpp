@@ -0,0 +1,156 @@
+#include "frame_share.hpp"
+
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace emu {
+
+#ifdef _WIN32
+const char* const FrameShare::NAME = "Local\\VeloceFrames";
+#else
+const char* const FrameShare::NAME = "/veloce-frames";
+#endif
+
+namespace {
+
+// Pixels start on a cache line of their own
+constexpr size_t PIXELS_OFFSET = (sizeof(SharedFrameHeader) + 63) & ~size_t(63);
+
+} // namespace
+
+FrameShare::~FrameShare() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool FrameShare::open() {
+    close();
+    m_error.clear();
+
+    size_t size = PIXELS_OFFSET + SharedFrameHeader::SLOT_COUNT * SharedFrameHeader::SLOT_BYTES;
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                        0, static_cast<DWORD>(size), NAME);
+    if (!mapping) {
+        m_error = std::string("Could not create shared memory ") + NAME;
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (!view) {
+        CloseHandle(mapping);
+        m_error = std::string("Could not map shared memory ") + NAME;
+        return false;
+    }
+
+    m_mapping = mapping;
+    m_header = static_cast<SharedFrameHeader*>(view);
+    m_size = size;
+    m_pixels = static_cast<uint8_t*>(view) + PIXELS_OFFSET;
+    return true;
+}
+
+void FrameShare::close() {
+    if (m_header) {
+        m_header->magic = 0;
+        UnmapViewOfFile(m_header);
+    }
+    if (m_mapping) {
+        CloseHandle(static_cast<HANDLE>(m_mapping));
+    }
+    m_header = nullptr;
+    m_pixels = nullptr;
+    m_mapping = nullptr;
+    m_size = 0;
+    m_published = 0;
+}
+
+#else
+
+bool FrameShare::open() {
+    close();
+    m_error.clear();
+
+    size_t size = PIXELS_OFFSET + SharedFrameHeader::SLOT_COUNT * SharedFrameHeader::SLOT_BYTES;
+    int fd = shm_open(NAME, O_CREAT | O_RDWR, 0600);
+    if (fd < 0) {
+        m_error = std::string("Could not create shared memory ") + NAME;
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        ::close(fd);
+        m_error = std::string("Could not size shared memory ") + NAME;
+        return false;
+    }
+    void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        m_error = std::string("Could not map shared memory ") + NAME;
+        return false;
+    }
+
+    m_header = static_cast<SharedFrameHeader*>(view);
+    m_size = size;
+    m_pixels = static_cast<uint8_t*>(view) + PIXELS_OFFSET;
+    return true;
+}
+
+void FrameShare::close() {
+    if (m_header) {
+        // Readers notice through the magic that nobody writes any more
+        m_header->magic = 0;
+        munmap(m_header, m_size);
+        shm_unlink(NAME);
+    }
+    m_header = nullptr;
+    m_pixels = nullptr;
+    m_size = 0;
+    m_published = 0;
+}
+
+#endif
+
+void FrameShare::publish(const uint32_t* pixels, int width, int height) {
+    if (!m_header || !pixels || width <= 0 || height <= 0) return;
+    if (static_cast<uint32_t>(width) > SharedFrameHeader::MAX_WIDTH ||
+        static_cast<uint32_t>(height) > SharedFrameHeader::MAX_HEIGHT) {
+        return;
+    }
+
+    // The header is (re)written whole on the first frame, so a region left
+    // behind by a crashed run starts over cleanly
+    if (m_published == 0) {
+        new (m_header) SharedFrameHeader{};
+        m_header->version = SharedFrameHeader::VERSION;
+        m_header->slot_count = SharedFrameHeader::SLOT_COUNT;
+        m_header->slot_bytes = static_cast<uint32_t>(SharedFrameHeader::SLOT_BYTES);
+        m_header->pixels_offset = static_cast<uint32_t>(PIXELS_OFFSET);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_header->magic = SharedFrameHeader::MAGIC;
+    }
+
+    uint64_t frame = m_published++;
+    SharedFrameSlot& slot = m_header->slots[frame % SharedFrameHeader::SLOT_COUNT];
+    uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.frame = frame;
+    slot.width = static_cast<uint32_t>(width);
+    slot.height = static_cast<uint32_t>(height);
+    uint8_t* out = m_pixels + (frame % SharedFrameHeader::SLOT_COUNT) * SharedFrameHeader::SLOT_BYTES;
+    std::memcpy(out, pixels, static_cast<size_t>(width) * static_cast<size_t>(height) * sizeof(uint32_t));
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    m_header->latest.store(frame + 1, std::memory_order_release);
+}
+
+} // namespace emu
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace emu {
+
+// Layout of the shared frame region. Capture tools map it read-only by
+// name and copy frames out without going through the compositor.
+//
+// Frames go round the slots in turn: frame n is written to slot
+// n % SLOT_COUNT, after which latest is set to n + 1. A reader loads
+// latest, copies the slot of latest - 1, and keeps the copy only if the
+// slot's sequence was the same even number before and after and its
+// frame matches; the writer makes sequence odd while it fills a slot.
+// Pixels are BGRA bytes (the cores' 0xAARRGGBB words on a little-endian
+// host), rows width * 4 bytes apart.
+struct SharedFrameSlot {
+    std::atomic<uint64_t> sequence;
+    uint64_t frame;
+    uint32_t width;
+    uint32_t height;
+};
+
+struct SharedFrameHeader {
+    static constexpr uint32_t MAGIC = 0x53464C56;     // "VLFS"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t SLOT_COUNT = 3;
+    static constexpr uint32_t MAX_WIDTH = 512;
+    static constexpr uint32_t MAX_HEIGHT = 512;
+    static constexpr size_t SLOT_BYTES = size_t(MAX_WIDTH) * MAX_HEIGHT * 4;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t slot_bytes;
+    uint32_t pixels_offset;             // Slot i's pixels at pixels_offset + i * slot_bytes
+    uint32_t reserved;
+    std::atomic<uint64_t> latest;       // Frames published; 0 before the first
+    SharedFrameSlot slots[SLOT_COUNT];
+};
+
+// Publishes every frame the window presents to the shared frame region
+// ("/veloce-frames" in POSIX shared memory, "Local\VeloceFrames" on
+// Windows) at the core's native resolution. Frames larger than
+// MAX_WIDTH x MAX_HEIGHT are skipped. Main thread only.
+class FrameShare {
+public:
+    static const char* const NAME;
+
+    FrameShare() = default;
+    ~FrameShare();
+
+    FrameShare(const FrameShare&) = delete;
+    FrameShare& operator=(const FrameShare&) = delete;
+
+    // Create the region; false and get_error() set if it can't be
+    bool open();
+    void close();
+    bool is_open() const { return m_header != nullptr; }
+    const std::string& get_error() const { return m_error; }
+
+    void publish(const uint32_t* pixels, int width, int height);
+
+private:
+    SharedFrameHeader* m_header = nullptr;
+    uint8_t* m_pixels = nullptr;
+    size_t m_size = 0;
+    uint64_t m_published = 0;
+    std::string m_error;
+#ifdef _WIN32
+    void* m_mapping = nullptr;  // HANDLE
+#endif
+};
+
+} // namespace emu
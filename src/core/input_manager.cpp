@@ -1,4 +1,5 @@
 #include "input_manager.hpp"
+#include "frame_pacer.hpp"
 
 #include <SDL.h>
 #include <iostream>
@@ -18,6 +19,7 @@ InputManager::~InputManager() {
 bool InputManager::initialize() {
     // Get keyboard state
     m_keyboard_state = SDL_GetKeyboardState(&m_keyboard_state_count);
+    m_keys_down.assign(m_keyboard_state, m_keyboard_state + m_keyboard_state_count);
 
     // Load default bindings
     load_default_bindings();
@@ -39,6 +41,7 @@ bool InputManager::initialize() {
 }
 
 void InputManager::shutdown() {
+    set_polling(false);
     for (auto& controller : m_controllers) {
         if (controller.controller) {
             SDL_GameControllerClose(controller.controller);
@@ -74,92 +77,237 @@ void InputManager::process_event(const SDL_Event& event) {
         case SDL_CONTROLLERDEVICEREMOVED:
             close_controller(event.cdevice.which);
             break;
+
+        case SDL_KEYDOWN:
+        case SDL_KEYUP: {
+            int scancode = event.key.keysym.scancode;
+            if (event.key.repeat || scancode < 0 || scancode >= static_cast<int>(m_keys_down.size())) return;
+            m_keys_down[scancode] = event.type == SDL_KEYDOWN;
+            break;
+        }
+
+        case SDL_CONTROLLERBUTTONDOWN:
+        case SDL_CONTROLLERBUTTONUP:
+            for (auto& controller : m_controllers) {
+                if (controller.instance_id != event.cbutton.which || event.cbutton.button >= 32) continue;
+                uint32_t bit = 1u << event.cbutton.button;
+                if (event.type == SDL_CONTROLLERBUTTONDOWN) controller.buttons_down |= bit;
+                else controller.buttons_down &= ~bit;
+            }
+            break;
+
+        case SDL_CONTROLLERAXISMOTION:
+            for (auto& controller : m_controllers) {
+                if (controller.instance_id != event.caxis.which || event.caxis.axis >= MAX_AXES) continue;
+                controller.axes[event.caxis.axis] = event.caxis.value;
+            }
+            break;
+
+        default:
+            return;
     }
+
+    // SDL stamps events in milliseconds of SDL_GetTicks() when they're
+    // queued; carry that age over to the pacer's clock
+    uint64_t now = FramePacer::now_ns();
+    uint64_t age_ns = static_cast<uint64_t>(SDL_GetTicks() - event.common.timestamp) * 1000000;
+    publish_button_state(age_ns < now ? now - age_ns : now);
 }
 
 void InputManager::update() {
     m_prev_button_state = m_button_state;
-    update_button_state();
+
+    // Binding and capture mode changes move the state without an event
+    publish_button_state(FramePacer::now_ns());
+    m_button_state = get_latest_button_state();
+
+    // Hand binding edits to the polling thread
+    if (is_polling()) {
+        std::lock_guard<std::mutex> lock(m_poll_mutex);
+        bool same = m_poll_bindings.size() == m_bindings.size();
+        for (auto it = m_bindings.begin(); same && it != m_bindings.end(); ++it) {
+            auto found = m_poll_bindings.find(it->first);
+            same = found != m_poll_bindings.end() && found->second == it->second &&
+                   found->second.axis_threshold == it->second.axis_threshold &&
+                   found->second.axis_positive == it->second.axis_positive;
+        }
+        if (!same) {
+            m_poll_bindings = m_bindings;
+        }
+    }
+}
+
+void InputManager::set_input_capture_mode(bool capturing) {
+    m_input_capture_mode = capturing;
+    publish_button_state(FramePacer::now_ns());
 }
 
-void InputManager::update_button_state() {
-    m_button_state = 0;
+void InputManager::publish_button_state(uint64_t time_ns) {
+    uint32_t keyboard = compute_keyboard_state();
+    uint32_t controllers = 0;
+    bool polling = is_polling();
+    if (!polling) {
+        for (const auto& controller : m_controllers) {
+            controllers |= compute_controller_state(m_bindings, controller.instance_id,
+                                                    controller.buttons_down, controller.axes);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_publish_mutex);
+    m_keyboard_buttons = keyboard;
+    if (!polling) {
+        m_controller_buttons = controllers;
+    }
+    push_button_state(time_ns);
+}
 
+void InputManager::push_button_state(uint64_t time_ns) {
     // Don't update game input state during input capture mode
     // This prevents the game from receiving inputs while mapping controls
-    if (m_input_capture_mode) {
-        return;
+    uint32_t buttons = m_input_capture_mode ? 0 : m_keyboard_buttons | m_controller_buttons;
+    m_latest_buttons.store(buttons, std::memory_order_relaxed);
+    if (buttons != m_published_state) {
+        m_published_state = buttons;
+        m_timeline.push(time_ns, buttons);
     }
+}
 
-    // Check keyboard bindings
+uint32_t InputManager::compute_keyboard_state() const {
+    uint32_t state = 0;
     for (const auto& [button, binding] : m_bindings) {
+        if (binding.type == InputSourceType::Keyboard &&
+                binding.code >= 0 && binding.code < static_cast<int>(m_keys_down.size()) &&
+                m_keys_down[binding.code]) {
+            state |= button_to_mask(button);
+        }
+    }
+    return state;
+}
+
+uint32_t InputManager::compute_controller_state(const BindingMap& bindings, int instance_id,
+                                                uint32_t buttons_down, const int16_t* axes) {
+    uint32_t state = 0;
+
+    for (const auto& [button, binding] : bindings) {
+        if (binding.device_id != -1 && binding.device_id != instance_id) continue;
         bool pressed = false;
 
-        if (binding.type == InputSourceType::Keyboard) {
-            if (binding.code >= 0 && binding.code < m_keyboard_state_count) {
-                pressed = m_keyboard_state[binding.code] != 0;
-            }
-        }
-        else if (binding.type == InputSourceType::GamepadButton) {
-            for (const auto& controller : m_controllers) {
-                if (binding.device_id == -1 || binding.device_id == controller.instance_id) {
-                    if (SDL_GameControllerGetButton(controller.controller,
-                            static_cast<SDL_GameControllerButton>(binding.code))) {
-                        pressed = true;
-                        break;
-                    }
-                }
-            }
+        if (binding.type == InputSourceType::GamepadButton) {
+            pressed = binding.code >= 0 && binding.code < 32 && (buttons_down & (1u << binding.code));
         }
         else if (binding.type == InputSourceType::GamepadAxis) {
-            for (const auto& controller : m_controllers) {
-                if (binding.device_id == -1 || binding.device_id == controller.instance_id) {
-                    int16_t value = SDL_GameControllerGetAxis(controller.controller,
-                            static_cast<SDL_GameControllerAxis>(binding.code));
-                    float normalized = value / 32767.0f;
-
-                    if (binding.axis_positive && normalized > binding.axis_threshold) {
-                        pressed = true;
-                    } else if (!binding.axis_positive && normalized < -binding.axis_threshold) {
-                        pressed = true;
-                    }
+            if (binding.code < 0 || binding.code >= MAX_AXES) continue;
+            float normalized = axes[binding.code] / 32767.0f;
 
-                    if (pressed) break;
-                }
+            if (binding.axis_positive && normalized > binding.axis_threshold) {
+                pressed = true;
+            } else if (!binding.axis_positive && normalized < -binding.axis_threshold) {
+                pressed = true;
             }
         }
 
         if (pressed) {
-            m_button_state |= button_to_mask(button);
+            state |= button_to_mask(button);
         }
     }
 
     // Also check gamepad D-pad directly for convenience
+    static constexpr std::pair<int, VirtualButton> pad_defaults[] = {
+        {SDL_CONTROLLER_BUTTON_DPAD_UP, VirtualButton::Up},
+        {SDL_CONTROLLER_BUTTON_DPAD_DOWN, VirtualButton::Down},
+        {SDL_CONTROLLER_BUTTON_DPAD_LEFT, VirtualButton::Left},
+        {SDL_CONTROLLER_BUTTON_DPAD_RIGHT, VirtualButton::Right},
+        {SDL_CONTROLLER_BUTTON_A, VirtualButton::A},
+        {SDL_CONTROLLER_BUTTON_B, VirtualButton::B},
+        {SDL_CONTROLLER_BUTTON_X, VirtualButton::X},
+        {SDL_CONTROLLER_BUTTON_Y, VirtualButton::Y},
+        {SDL_CONTROLLER_BUTTON_START, VirtualButton::Start},
+        {SDL_CONTROLLER_BUTTON_BACK, VirtualButton::Select},
+        {SDL_CONTROLLER_BUTTON_LEFTSHOULDER, VirtualButton::L},
+        {SDL_CONTROLLER_BUTTON_RIGHTSHOULDER, VirtualButton::R},
+    };
+    for (const auto& [pad_button, button] : pad_defaults) {
+        if (buttons_down & (1u << pad_button)) {
+            state |= button_to_mask(button);
+        }
+    }
+
+    return state;
+}
+
+// ============================================================================
+// Controller polling
+// ============================================================================
+
+void InputManager::set_polling(bool enabled) {
+    if (enabled == is_polling()) return;
+
+    if (enabled) {
+        {
+            std::lock_guard<std::mutex> lock(m_poll_mutex);
+            m_poll_bindings = m_bindings;
+        }
+        update_poll_controllers();
+        m_poll_stop = false;
+        m_polling = true;
+        m_poll_thread = std::thread(&InputManager::poll_loop, this);
+    } else {
+        m_poll_stop = true;
+        m_poll_thread.join();
+        m_polling = false;
+
+        // Back to the controller state the events have kept
+        publish_button_state(FramePacer::now_ns());
+    }
+}
+
+void InputManager::update_poll_controllers() {
+    std::lock_guard<std::mutex> lock(m_poll_mutex);
+    m_poll_controllers.clear();
     for (const auto& controller : m_controllers) {
-        if (SDL_GameControllerGetButton(controller.controller, SDL_CONTROLLER_BUTTON_DPAD_UP))
-            m_button_state |= button_to_mask(VirtualButton::Up);
-        if (SDL_GameControllerGetButton(controller.controller, SDL_CONTROLLER_BUTTON_DPAD_DOWN))
-            m_button_state |= button_to_mask(VirtualButton::Down);
-        if (SDL_GameControllerGetButton(controller.controller, SDL_CONTROLLER_BUTTON_DPAD_LEFT))
-            m_button_state |= button_to_mask(VirtualButton::Left);
-        if (SDL_GameControllerGetButton(controller.controller, SDL_CONTROLLER_BUTTON_DPAD_RIGHT))
-            m_button_state |= button_to_mask(VirtualButton::Right);
-        if (SDL_GameControllerGetButton(controller.controller, SDL_CONTROLLER_BUTTON_A))
-            m_button_state |= button_to_mask(VirtualButton::A);
-        if (SDL_GameControllerGetButton(controller.controller, SDL_CONTROLLER_BUTTON_B))
-            m_button_state |= button_to_mask(VirtualButton::B);
-        if (SDL_GameControllerGetButton(controller.controller, SDL_CONTROLLER_BUTTON_X))
-            m_button_state |= button_to_mask(VirtualButton::X);
-        if (SDL_GameControllerGetButton(controller.controller, SDL_CONTROLLER_BUTTON_Y))
-            m_button_state |= button_to_mask(VirtualButton::Y);
-        if (SDL_GameControllerGetButton(controller.controller, SDL_CONTROLLER_BUTTON_START))
-            m_button_state |= button_to_mask(VirtualButton::Start);
-        if (SDL_GameControllerGetButton(controller.controller, SDL_CONTROLLER_BUTTON_BACK))
-            m_button_state |= button_to_mask(VirtualButton::Select);
-        if (SDL_GameControllerGetButton(controller.controller, SDL_CONTROLLER_BUTTON_LEFTSHOULDER))
-            m_button_state |= button_to_mask(VirtualButton::L);
-        if (SDL_GameControllerGetButton(controller.controller, SDL_CONTROLLER_BUTTON_RIGHTSHOULDER))
-            m_button_state |= button_to_mask(VirtualButton::R);
+        m_poll_controllers.push_back({controller.instance_id, controller.controller});
+    }
+}
+
+void InputManager::poll_loop() {
+    FramePacer pacer;
+    const double period = 1.0 / POLL_RATE_HZ;
+
+    while (!m_poll_stop.load(std::memory_order_relaxed)) {
+        pacer.begin_frame();
+
+        // SDL_GameControllerUpdate() reads the devices the way the main
+        // thread's event pump would; SDL's joystick lock keeps the two apart
+        uint32_t controllers = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_poll_mutex);
+            SDL_LockJoysticks();
+            SDL_GameControllerUpdate();
+            for (const auto& [instance_id, controller] : m_poll_controllers) {
+                uint32_t buttons_down = 0;
+                for (int button = 0; button < SDL_CONTROLLER_BUTTON_MAX && button < 32; button++) {
+                    if (SDL_GameControllerGetButton(controller, static_cast<SDL_GameControllerButton>(button))) {
+                        buttons_down |= 1u << button;
+                    }
+                }
+                int16_t axes[MAX_AXES] = {};
+                for (int axis = 0; axis < SDL_CONTROLLER_AXIS_MAX && axis < MAX_AXES; axis++) {
+                    axes[axis] = SDL_GameControllerGetAxis(controller, static_cast<SDL_GameControllerAxis>(axis));
+                }
+                controllers |= compute_controller_state(m_poll_bindings, instance_id, buttons_down, axes);
+            }
+            SDL_UnlockJoysticks();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_publish_mutex);
+            if (controllers != m_controller_buttons) {
+                m_controller_buttons = controllers;
+                push_button_state(FramePacer::now_ns());
+            }
+        }
+
+        pacer.wait_for(period);
     }
 }
 
@@ -215,7 +363,21 @@ void InputManager::open_controller(int device_index) {
         info.instance_id = instance_id;
         info.name = name;
         info.guid = guid_str;
+
+        // Held before it was opened; events keep this current from here
+        for (int button = 0; button < SDL_CONTROLLER_BUTTON_MAX && button < 32; button++) {
+            if (SDL_GameControllerGetButton(controller, static_cast<SDL_GameControllerButton>(button))) {
+                info.buttons_down |= 1u << button;
+            }
+        }
+        for (int axis = 0; axis < SDL_CONTROLLER_AXIS_MAX && axis < MAX_AXES; axis++) {
+            info.axes[axis] = SDL_GameControllerGetAxis(controller, static_cast<SDL_GameControllerAxis>(axis));
+        }
         m_controllers.push_back(info);
+        m_device_generation++;
+        if (is_polling()) {
+            update_poll_controllers();
+        }
 
         std::cout << "Controller connected: " << info.name << " (GUID: " << guid_str << ")" << std::endl;
     }
@@ -225,8 +387,13 @@ void InputManager::close_controller(int instance_id) {
     for (auto it = m_controllers.begin(); it != m_controllers.end(); ++it) {
         if (it->instance_id == instance_id) {
             std::cout << "Controller disconnected: " << it->name << std::endl;
-            SDL_GameControllerClose(it->controller);
+            SDL_GameController* controller = it->controller;
             m_controllers.erase(it);
+            m_device_generation++;
+            if (is_polling()) {
+                update_poll_controllers();  // Before it's closed under the poller
+            }
+            SDL_GameControllerClose(controller);
             break;
         }
     }
@@ -2,11 +2,15 @@
 
 #include "emu/input_types.hpp"
 #include "emu/controller_layout.hpp"
+#include "input_timeline.hpp"
 #include <unordered_map>
 #include <map>
 #include <vector>
 #include <string>
 #include <utility>
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 union SDL_Event;
 struct _SDL_GameController;
@@ -38,6 +42,22 @@ public:
     // Get current input state for emulation
     uint32_t get_button_state() const { return m_button_state; }
 
+    // Every change to the button state, timestamped as the event arrived,
+    // for cores that latch input mid-frame (see InputTimeline)
+    InputTimeline& get_timeline() { return m_timeline; }
+
+    // Controller polling thread. While it runs, gamepads are read
+    // POLL_RATE_HZ times a second off the main thread instead of once per
+    // host frame through its event pump, and each change reaches the
+    // timeline and get_latest_button_state() within a poll. Keyboard input
+    // still comes from the main thread's events.
+    static constexpr int POLL_RATE_HZ = 1000;
+    void set_polling(bool enabled);
+    bool is_polling() const { return m_polling.load(std::memory_order_relaxed); }
+
+    // The newest button state from either thread; safe from any thread
+    uint32_t get_latest_button_state() const { return m_latest_buttons.load(std::memory_order_relaxed); }
+
     // Check if a specific button is pressed
     bool is_button_pressed(VirtualButton button) const;
 
@@ -56,6 +76,10 @@ public:
     std::string get_controller_name(int index) const;
     int get_controller_instance_id(int index) const;
 
+    // Bumped whenever a controller connects or disconnects, for callers
+    // that cache the lists above
+    uint32_t get_device_generation() const { return m_device_generation; }
+
     // Get list of available controllers (id, name pairs)
     // Returns keyboard as (-1, "Keyboard") plus all connected gamepads
     std::vector<std::pair<int, std::string>> get_available_controllers() const;
@@ -96,13 +120,30 @@ public:
 
     // Input capture mode - when true, game input is blocked
     // Used during controller mapping to prevent game from receiving inputs
-    void set_input_capture_mode(bool capturing) { m_input_capture_mode = capturing; }
+    void set_input_capture_mode(bool capturing);
     bool is_input_capture_mode() const { return m_input_capture_mode; }
 
 private:
+    using BindingMap = std::unordered_map<VirtualButton, InputBinding>;
+
     void open_controller(int device_index);
     void close_controller(int instance_id);
-    void update_button_state();
+
+    // The button state is the keyboard's bindings ORed with every
+    // controller's; the two halves are worked out apart so the polling
+    // thread can supply the controllers' without touching the rest
+    uint32_t compute_keyboard_state() const;
+    static uint32_t compute_controller_state(const BindingMap& bindings, int instance_id,
+                                             uint32_t buttons_down, const int16_t* axes);
+
+    // Main thread: recompute and publish. push_button_state() needs
+    // m_publish_mutex held.
+    void publish_button_state(uint64_t time_ns);
+    void push_button_state(uint64_t time_ns);
+
+    // Polling thread, and what the main thread hands it (under m_poll_mutex)
+    void poll_loop();
+    void update_poll_controllers();
     std::string get_config_path(const std::string& platform) const;
 
     // Current button state bitmask
@@ -113,14 +154,23 @@ private:
     const uint8_t* m_keyboard_state = nullptr;
     int m_keyboard_state_count = 0;
 
+    // Bindings are resolved against state kept from the events themselves
+    // rather than SDL's, which already reflects every event of the batch
+    // being processed, so each change gets its own timestamp
+    std::vector<uint8_t> m_keys_down;
+
     // Connected controllers
+    static constexpr int MAX_AXES = 6;  // SDL_CONTROLLER_AXIS_MAX
     struct ControllerInfo {
         SDL_GameController* controller;
         int instance_id;
         std::string name;
         std::string guid;  // For duplicate detection on Windows
+        uint32_t buttons_down = 0;      // Bit per SDL_GameControllerButton
+        int16_t axes[MAX_AXES] = {};
     };
     std::vector<ControllerInfo> m_controllers;
+    uint32_t m_device_generation = 0;
 
     // Active controller (-1 for keyboard, or index into m_controllers)
     int m_active_controller = -1;
@@ -132,13 +182,30 @@ private:
     const ControllerLayoutInfo* m_controller_layout = nullptr;
 
     // Input bindings (current active bindings)
-    std::unordered_map<VirtualButton, InputBinding> m_bindings;
+    BindingMap m_bindings;
 
     // Per-platform bindings cache
-    std::map<std::string, std::unordered_map<VirtualButton, InputBinding>> m_platform_bindings;
+    std::map<std::string, BindingMap> m_platform_bindings;
 
     // Input capture mode - blocks game input during controller mapping
-    bool m_input_capture_mode = false;
+    std::atomic<bool> m_input_capture_mode{false};
+
+    // Both threads publish through m_publish_mutex, which keeps the
+    // timeline's producer side to one thread at a time
+    InputTimeline m_timeline;
+    std::mutex m_publish_mutex;
+    uint32_t m_keyboard_buttons = 0;
+    uint32_t m_controller_buttons = 0;
+    uint32_t m_published_state = 0;     // Last mask pushed to m_timeline
+    std::atomic<uint32_t> m_latest_buttons{0};
+
+    // Controller polling; the thread reads only the copies under m_poll_mutex
+    std::thread m_poll_thread;
+    std::atomic<bool> m_polling{false};
+    std::atomic<bool> m_poll_stop{false};
+    std::mutex m_poll_mutex;
+    BindingMap m_poll_bindings;
+    std::vector<std::pair<int, SDL_GameController*>> m_poll_controllers;  // Instance id, controller
 };
 
 } // namespace emu
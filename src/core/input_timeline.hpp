@@ -0,0 +1,64 @@
+#pragma once
+
+#include "command_queue.hpp"
+
+#include <cstdint>
+
+namespace emu {
+
+// Timestamped button changes, handed from the event thread to emulation
+//
+// The input manager pushes the full button mask each time an event changes
+// it; a core latching its pad asks for the state as of a host time and gets
+// the newest mask at or before it. Presses that were released again before
+// the latch still show up once, so a tap shorter than a frame can't fall
+// between two latches. If emulation stops sampling (pause, netplay) the
+// oldest changes are dropped; each carries the whole mask, so the state
+// stays right and only old taps are lost.
+class InputTimeline {
+public:
+    // Event thread: the mask after a change, at time_ns (FramePacer::now_ns())
+    void push(uint64_t time_ns, uint32_t buttons) {
+        Change change{time_ns, buttons};
+        while (!m_changes.push(Change(change))) {
+            Change oldest;
+            m_changes.pop(oldest);
+        }
+    }
+
+    // Emulation thread: the buttons held at time_ns, plus any pressed and
+    // released since the previous sample
+    uint32_t sample(uint64_t time_ns) {
+        uint32_t tapped = 0;
+        for (;;) {
+            if (!m_has_next && !m_changes.pop(m_next)) break;
+            m_has_next = true;
+            if (m_next.time_ns > time_ns) break;
+
+            if (m_next.time_ns + MAX_TAP_AGE_NS >= time_ns) {
+                tapped |= m_next.buttons & ~m_buttons;
+            }
+            m_buttons = m_next.buttons;
+            m_has_next = false;
+        }
+        return m_buttons | tapped;
+    }
+
+private:
+    // Taps older than this when sampled (e.g. made while paused) are dropped
+    static constexpr uint64_t MAX_TAP_AGE_NS = 50'000'000;
+
+    struct Change {
+        uint64_t time_ns = 0;
+        uint32_t buttons = 0;
+    };
+
+    CommandQueue<Change, 256> m_changes;
+
+    // Emulation thread only
+    Change m_next;
+    bool m_has_next = false;
+    uint32_t m_buttons = 0;
+};
+
+} // namespace emu
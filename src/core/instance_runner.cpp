@@ -0,0 +1,475 @@
+#include "instance_runner.hpp"
+#include "benchmark.hpp"
+#include "plugin_manager.hpp"
+#include "movie_file.hpp"
+#include "emu/emulator_plugin.hpp"
+#include "emu/netplay_plugin.hpp"
+#include "emu/state_chunks.hpp"
+#include "thread_tuning.hpp"
+
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <thread>
+
+namespace emu {
+
+namespace {
+
+// Frames per run_frames() call
+constexpr size_t JOB_BATCH_FRAMES = 60;
+
+constexpr int DEFAULT_JOB_FRAMES = 600;
+
+struct LoadedMovie {
+    bool ok = false;
+    TASMovieInfo info{};
+    std::vector<uint8_t> start_state;
+    std::vector<TASFrameData> frames;
+};
+
+// Hash logs: "<frame> <hash>" per line, '#' comments
+bool read_hash_log(const std::string& path, std::vector<uint64_t>& hashes) {
+    std::ifstream file(path);
+    if (!file) return false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        unsigned long long frame = 0, hash = 0;
+        if (std::sscanf(line.c_str(), "%llu %llx", &frame, &hash) != 2) return false;
+        if (frame >= hashes.size()) hashes.resize(frame + 1, 0);
+        hashes[frame] = hash;
+    }
+    return true;
+}
+
+// hashes[0] is first_frame's; a verify job logs only its last frame
+bool write_hash_log(const std::string& path, const std::vector<uint64_t>& hashes, size_t first_frame) {
+    std::ofstream file(path);
+    if (!file) return false;
+
+    file << "# Veloce state hash log: <frame> <state hash at the end of the frame>\n";
+    char line[48];
+    for (size_t i = 0; i < hashes.size(); i++) {
+        std::snprintf(line, sizeof(line), "%zu %016llx\n", first_frame + i,
+                      static_cast<unsigned long long>(hashes[i]));
+        file << line;
+    }
+    return static_cast<bool>(file);
+}
+
+// "PPU " -> "PPU"
+std::string chunk_tag_name(uint32_t tag) {
+    std::string name;
+    for (int shift = 0; shift < 32; shift += 8) {
+        char c = static_cast<char>((tag >> shift) & 0xFF);
+        if (c != ' ') name += c;
+    }
+    return name;
+}
+
+// Save state chunks (CPU, PPU, WRAM, ...) that differ between a and b,
+// for cores that don't split their state hash
+void compare_state_chunks(IEmulatorPlugin& a, IEmulatorPlugin& b, std::vector<std::string>& out) {
+    std::vector<uint8_t> a_state;
+    std::vector<uint8_t> b_state;
+    if (!a.save_state(a_state) || !b.save_state(b_state)) return;
+
+    std::map<uint32_t, StateChunk> b_chunks;
+    StateChunkReader b_reader(b_state.data(), b_state.size());
+    for (StateChunk chunk; b_reader.next(chunk);) {
+        b_chunks[chunk.tag] = chunk;
+    }
+
+    StateChunkReader a_reader(a_state.data(), a_state.size());
+    for (StateChunk chunk; a_reader.next(chunk);) {
+        auto other = b_chunks.find(chunk.tag);
+        if (other == b_chunks.end() || other->second.size != chunk.size ||
+            std::memcmp(other->second.data, chunk.data, chunk.size) != 0) {
+            out.push_back(chunk_tag_name(chunk.tag));
+        }
+        if (other != b_chunks.end()) b_chunks.erase(other);
+    }
+    for (const auto& [tag, chunk] : b_chunks) {
+        out.push_back(chunk_tag_name(tag));
+    }
+}
+
+// Record the first frame where a differential job's two instances part:
+// their state hashes (when the core has one) or, if compare_frames, their
+// framebuffers differ
+void compare_instances(IEmulatorPlugin& a, IEmulatorPlugin& b, INetplayCapable* a_netplay,
+                       INetplayCapable* b_netplay, uint64_t frame, bool compare_frames, RunnerJobResult& result) {
+    uint64_t a_hash = a_netplay ? a_netplay->get_state_hash() : 0;
+    uint64_t b_hash = b_netplay ? b_netplay->get_state_hash() : 0;
+
+    FrameBuffer a_frame = a.get_framebuffer();
+    FrameBuffer b_frame = b.get_framebuffer();
+    bool frames_differ = compare_frames && (a_frame.width != b_frame.width || a_frame.height != b_frame.height);
+    if (compare_frames && !frames_differ && a_frame.pixels && b_frame.pixels) {
+        size_t bytes = static_cast<size_t>(a_frame.width) * static_cast<size_t>(a_frame.height) * sizeof(uint32_t);
+        frames_differ = std::memcmp(a_frame.pixels, b_frame.pixels, bytes) != 0;
+    }
+    if (a_hash == b_hash && !frames_differ) return;
+
+    result.diverged = true;
+    result.divergence_frame = frame;
+    result.divergence_hash = a_hash;
+    result.compare_hash = b_hash;
+    result.framebuffer_diverged = frames_differ;
+
+    int count = 0;
+    if (a_netplay && b_netplay) {
+        StateHashComponent a_parts[NETPLAY_MAX_HASH_COMPONENTS];
+        StateHashComponent b_parts[NETPLAY_MAX_HASH_COMPONENTS];
+        count = std::min(a_netplay->get_state_hash_components(a_parts, NETPLAY_MAX_HASH_COMPONENTS),
+                         b_netplay->get_state_hash_components(b_parts, NETPLAY_MAX_HASH_COMPONENTS));
+        for (int i = 0; i < count; i++) {
+            if (a_parts[i].hash != b_parts[i].hash) {
+                result.diverged_components.push_back(a_parts[i].name);
+            }
+        }
+    }
+    if (count == 0 && a_hash != b_hash) {
+        compare_state_chunks(a, b, result.diverged_components);
+    }
+}
+
+} // namespace
+
+InstanceRunner::InstanceRunner(CreateFunc create, DestroyFunc destroy)
+    : m_create(std::move(create)), m_destroy(std::move(destroy)) {}
+
+std::vector<RunnerJobResult> InstanceRunner::run(const std::vector<RunnerJob>& jobs, const RunnerOptions& options) {
+    std::vector<RunnerJobResult> results(jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++) {
+        results[i].name = jobs[i].name;
+    }
+
+    // Read every ROM, movie and reference once; jobs using the same file
+    // share it
+    std::map<std::string, std::shared_ptr<const RomImage>> roms;
+    std::map<std::string, LoadedMovie> movies;
+    std::map<std::string, std::vector<uint64_t>> references;
+    for (size_t i = 0; i < jobs.size(); i++) {
+        const RunnerJob& job = jobs[i];
+        std::string& error = results[i].error;
+
+        auto rom = roms.find(job.rom_path);
+        if (rom == roms.end()) {
+            rom = roms.emplace(job.rom_path, PluginManager::read_rom_image(job.rom_path)).first;
+        }
+        if (!rom->second) {
+            error = "failed to read ROM " + job.rom_path;
+        }
+
+        if (!job.movie_path.empty()) {
+            auto movie = movies.find(job.movie_path);
+            if (movie == movies.end()) {
+                movie = movies.emplace(job.movie_path, LoadedMovie{}).first;
+                LoadedMovie& loaded = movie->second;
+                loaded.ok = load_movie(job.movie_path.c_str(), loaded.info, loaded.start_state, loaded.frames);
+            }
+            if (!movie->second.ok && error.empty()) {
+                error = "failed to read movie " + job.movie_path;
+            }
+        }
+
+        if (!job.reference_path.empty() && references.find(job.reference_path) == references.end()) {
+            std::vector<uint64_t> hashes;
+            if (!read_hash_log(job.reference_path, hashes) && error.empty()) {
+                error = "failed to read hash log " + job.reference_path;
+            }
+            references.emplace(job.reference_path, std::move(hashes));
+        }
+    }
+
+    int threads = options.threads;
+    if (threads <= 0) {
+        threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    threads = std::min(threads, static_cast<int>(std::max<size_t>(jobs.size(), 1)));
+    // One worker per physical core before any shares one with an SMT
+    // sibling, performance cores first
+    std::vector<int> cpus;
+    if (options.pin_threads) {
+        cpus = get_spread_cpus();
+    }
+
+    // Workers only read the shared images, movies and references from here on
+    const LoadedMovie no_movie;
+    std::atomic<size_t> next_job{0};
+    auto worker = [&](int index) {
+        if (!cpus.empty()) {
+            pin_current_thread(cpus[static_cast<size_t>(index) % cpus.size()]);
+        }
+
+        // Jobs with configs of their own run on fresh instances, so their
+        // settings never reach the jobs after them
+        IEmulatorPlugin* shared = m_create();
+        std::vector<InputState> batch(JOB_BATCH_FRAMES);
+        std::vector<uint64_t> hashes;
+
+        for (size_t i = next_job.fetch_add(1); i < jobs.size(); i = next_job.fetch_add(1)) {
+            const RunnerJob& job = jobs[i];
+            RunnerJobResult& result = results[i];
+            result.worker = index;
+            if (!result.error.empty()) continue;
+
+            bool comparing = !job.compare_config_path.empty();
+            bool fresh = comparing || !job.config_path.empty();
+            IEmulatorPlugin* instance = fresh ? m_create() : shared;
+            IEmulatorPlugin* other = comparing ? m_create() : nullptr;
+            auto release = [&]() {
+                if (instance && instance->is_rom_loaded()) instance->unload_rom();
+                if (other && other->is_rom_loaded()) other->unload_rom();
+                if (fresh && instance) m_destroy(instance);
+                if (other) m_destroy(other);
+            };
+
+            uint64_t start = Benchmark::now_ns();
+            const LoadedMovie& movie = job.movie_path.empty() ? no_movie : movies.at(job.movie_path);
+            const std::vector<uint64_t>* reference =
+                job.reference_path.empty() ? nullptr : &references.at(job.reference_path);
+            bool hashing = reference || !job.hash_log_path.empty();
+            if (reference) result.reference_frames = reference->size();
+
+            // Config, ROM and the movie's start state; false with the error set
+            auto prepare = [&](IEmulatorPlugin* target, const std::string& config, bool video) {
+                if (!target) {
+                    result.error = "failed to create a core instance";
+                    return false;
+                }
+                if (!config.empty() && !target->load_config(config.c_str())) {
+                    result.error = "core rejected config " + config;
+                    return false;
+                }
+                if (!target->load_rom_shared(roms.at(job.rom_path))) {
+                    result.error = "core rejected ROM " + job.rom_path;
+                    return false;
+                }
+                target->set_video_enabled(video);
+                target->set_audio_enabled(false);
+                auto* target_netplay = dynamic_cast<INetplayCapable*>(target);
+
+                if (movie.info.rom_crc32 != 0 && movie.info.rom_crc32 != target->get_rom_crc32()) {
+                    char crc[16];
+                    std::snprintf(crc, sizeof(crc), "%08x", movie.info.rom_crc32);
+                    result.error = std::string("movie was recorded on ROM ") + crc;
+                } else if ((hashing || (job.verify && comparing)) && !target_netplay) {
+                    result.error = "core has no state hash to verify against";
+                } else if (movie.info.starts_from_savestate && !movie.start_state.empty() &&
+                           !(target_netplay && target_netplay->load_state_fast(movie.start_state.data(),
+                                                                               movie.start_state.size())) &&
+                           !target->load_state(movie.start_state)) {
+                    result.error = "core rejected the movie's start state";
+                }
+                return result.error.empty();
+            };
+            // A verify job's compare instance plays back normally, video and all
+            if (!prepare(instance, job.config_path, comparing && !job.verify) ||
+                (comparing && !prepare(other, job.compare_config_path, true))) {
+                release();
+                continue;
+            }
+            auto* netplay = dynamic_cast<INetplayCapable*>(instance);
+            auto* other_netplay = comparing ? dynamic_cast<INetplayCapable*>(other) : nullptr;
+            result.compared = comparing;
+
+            size_t total = job.frames > 0 ? static_cast<size_t>(job.frames)
+                         : job.movie_path.empty() ? static_cast<size_t>(DEFAULT_JOB_FRAMES)
+                         : movie.frames.size();
+            hashes.clear();
+
+            // Batches end before a movie reset, and are one frame long when
+            // every frame is hashed or compared
+            bool per_frame = (hashing || comparing) && !job.verify;
+            RunFlags flags = job.verify ? RUN_FLAGS_SKIP_VIDEO | RUN_FLAGS_SKIP_AUDIO : RUN_FLAGS_NONE;
+            size_t frame = 0;
+            while (frame < total && !result.diverged) {
+                size_t count = per_frame ? 1 : std::min(JOB_BATCH_FRAMES, total - frame);
+                for (size_t f = 0; f < count; f++) {
+                    const TASFrameData* data = frame + f < movie.frames.size() ? &movie.frames[frame + f] : nullptr;
+                    if (data && data->has_reset && f > 0) {
+                        count = f;
+                        break;
+                    }
+                    batch[f].buttons = data ? data->controller_inputs[0] : 0;
+                }
+                if (frame < movie.frames.size() && movie.frames[frame].has_reset) {
+                    instance->reset();
+                    if (other) other->reset();
+                }
+                instance->run_frames(batch.data(), count, flags);
+                instance->clear_audio_buffer();
+                if (other) {
+                    other->run_frames(batch.data(), count, RUN_FLAGS_NONE);
+                    other->clear_audio_buffer();
+                }
+                frame += count;
+
+                if (hashing && (per_frame || frame == total)) {
+                    uint64_t hash = netplay->get_state_hash();
+                    hashes.push_back(hash);
+                    size_t at = frame - 1;
+                    // Frames missing from a log of only some frames read as 0
+                    if (reference && !result.desynced && at < reference->size() && (*reference)[at] != 0 &&
+                        (*reference)[at] != hash) {
+                        result.desynced = true;
+                        result.desync_frame = at;
+                        result.reference_hash = (*reference)[at];
+                        result.desync_hash = hash;
+                    }
+                }
+                if (comparing) {
+                    compare_instances(*instance, *other, netplay, other_netplay, frame - 1, !job.verify, result);
+                }
+            }
+
+            result.elapsed_ns = Benchmark::now_ns() - start;
+            result.frames = frame;
+            result.rom_crc32 = instance->get_rom_crc32();
+            if (netplay) {
+                result.state_hash = netplay->get_state_hash();
+            }
+            result.ok = true;
+            size_t first_logged = per_frame || hashes.empty() ? 0 : frame - 1;
+            if (!job.hash_log_path.empty() && !write_hash_log(job.hash_log_path, hashes, first_logged)) {
+                result.ok = false;
+                result.error = "failed to write hash log " + job.hash_log_path;
+            }
+            release();
+        }
+
+        if (shared) m_destroy(shared);
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(static_cast<size_t>(threads));
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back(worker, i);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    return results;
+}
+
+bool InstanceRunner::load_jobs(const std::string& path, std::vector<RunnerJob>& jobs, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "can't open " + path;
+        return false;
+    }
+
+    nlohmann::json root = nlohmann::json::parse(file, nullptr, false);
+    if (root.is_discarded() || !root.is_object() || !root.contains("jobs") || !root["jobs"].is_array()) {
+        error = path + " has no \"jobs\" array";
+        return false;
+    }
+
+    std::filesystem::path base = std::filesystem::path(path).parent_path();
+    auto resolve = [&](const std::string& value) {
+        std::filesystem::path p(value);
+        return (p.is_absolute() ? p : base / p).string();
+    };
+
+    for (const auto& entry : root["jobs"]) {
+        RunnerJob job;
+        job.rom_path = entry.value("rom", "");
+        if (job.rom_path.empty()) {
+            error = "job " + std::to_string(jobs.size()) + " has no \"rom\"";
+            return false;
+        }
+        job.rom_path = resolve(job.rom_path);
+        job.name = entry.value("name", std::filesystem::path(job.rom_path).stem().string());
+        std::string movie = entry.value("movie", "");
+        if (!movie.empty()) job.movie_path = resolve(movie);
+        job.frames = entry.value("frames", job.frames);
+        std::string reference = entry.value("reference", "");
+        if (!reference.empty()) job.reference_path = resolve(reference);
+        std::string hash_log = entry.value("hash_log", "");
+        if (!hash_log.empty()) job.hash_log_path = resolve(hash_log);
+        std::string config = entry.value("config", "");
+        if (!config.empty()) job.config_path = resolve(config);
+        std::string compare_config = entry.value("compare_config", "");
+        if (!compare_config.empty()) job.compare_config_path = resolve(compare_config);
+        job.verify = entry.value("verify", false);
+        jobs.push_back(std::move(job));
+    }
+    return true;
+}
+
+bool InstanceRunner::write_report(const std::vector<RunnerJobResult>& results, uint64_t total_ns,
+                                  const std::string& path) {
+    nlohmann::json report = nlohmann::json::array();
+    for (const auto& result : results) {
+        char crc[16];
+        std::snprintf(crc, sizeof(crc), "%08x", result.rom_crc32);
+        char hash[24];
+        std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(result.state_hash));
+
+        nlohmann::json entry;
+        entry["name"] = result.name;
+        entry["ok"] = result.ok;
+        if (!result.ok) entry["error"] = result.error;
+        entry["worker"] = result.worker;
+        entry["rom_crc32"] = crc;
+        entry["frames"] = result.frames;
+        entry["state_hash"] = hash;
+        entry["seconds"] = static_cast<double>(result.elapsed_ns) / 1e9;
+        if (result.reference_frames > 0) {
+            entry["reference_frames"] = result.reference_frames;
+            if (result.desynced) {
+                std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(result.reference_hash));
+                entry["desync"] = {{"frame", result.desync_frame}, {"reference_hash", hash}};
+                std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(result.desync_hash));
+                entry["desync"]["hash"] = hash;
+            } else {
+                entry["desync"] = nullptr;
+            }
+        }
+        if (result.compared) {
+            if (result.diverged) {
+                nlohmann::json divergence;
+                divergence["frame"] = result.divergence_frame;
+                std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(result.divergence_hash));
+                divergence["state_hash"] = hash;
+                std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(result.compare_hash));
+                divergence["compare_state_hash"] = hash;
+                divergence["framebuffer"] = result.framebuffer_diverged;
+                divergence["components"] = result.diverged_components;
+                entry["divergence"] = std::move(divergence);
+            } else {
+                entry["divergence"] = nullptr;
+            }
+        }
+        report.push_back(std::move(entry));
+    }
+
+    nlohmann::json root;
+    root["jobs"] = std::move(report);
+    root["total_seconds"] = static_cast<double>(total_ns) / 1e9;
+    std::string text = root.dump(2);
+    if (path.empty()) {
+        std::cout << text << std::endl;
+        return true;
+    }
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Runner: failed to write report " << path << std::endl;
+        return false;
+    }
+    out << text << '\n';
+    return static_cast<bool>(out);
+}
+
+} // namespace emu
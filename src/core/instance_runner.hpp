@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace emu {
+
+class IEmulatorPlugin;
+
+// One headless job: run a ROM for a number of frames, optionally playing
+// back a movie (.tas or .fm2) on controller 1
+struct RunnerJob {
+    std::string name;
+    std::string rom_path;
+    std::string movie_path;      // No input if empty
+    int frames = 0;              // 0: the movie's length, or 600 without a movie
+    std::string reference_path;  // Hash log to check every frame against
+    std::string hash_log_path;   // Where to write this run's hash log
+    std::string config_path;     // Core config file (load_config) for the run; defaults if empty
+
+    // Differential run: a second instance with this config runs the same
+    // frames in lockstep, and the job stops at the first frame whose state
+    // hash or framebuffer differs between the two
+    std::string compare_config_path;
+
+    // Verify preset: run in long batches with drawing and audio skipped and
+    // hash only the end state, checking it against the reference's last
+    // frame. With a compare config the two instances are checked at the
+    // end of each batch on their state hashes alone.
+    bool verify = false;
+};
+
+struct RunnerJobResult {
+    std::string name;
+    bool ok = false;
+    std::string error;
+    int worker = -1;            // Worker thread (and instance) that ran it
+    uint32_t rom_crc32 = 0;
+    uint64_t frames = 0;        // Frames run, across any movie resets
+    uint64_t state_hash = 0;    // Final INetplayCapable state hash; 0 if the core has none
+    uint64_t elapsed_ns = 0;
+
+    // Against the reference hash log, if the job has one
+    bool desynced = false;
+    uint64_t desync_frame = 0;      // First frame whose end state differs
+    uint64_t reference_hash = 0;    // At desync_frame
+    uint64_t desync_hash = 0;
+    uint64_t reference_frames = 0;  // Frames the reference covers
+
+    // Against the compare_config instance, if the job has one
+    bool compared = false;
+    bool diverged = false;
+    uint64_t divergence_frame = 0;       // First frame whose end differs
+    uint64_t divergence_hash = 0;        // State hashes there (0 without one)
+    uint64_t compare_hash = 0;
+    bool framebuffer_diverged = false;
+    std::vector<std::string> diverged_components;  // State hash parts, or else save state chunks, that differ
+};
+
+struct RunnerOptions {
+    int threads = 0;          // Worker count; 0 picks one per hardware thread
+    bool pin_threads = true;  // Pin workers across physical cores (Linux and Windows)
+};
+
+// Runs many headless jobs in parallel on independent instances of one core
+//
+// Each worker thread creates its own instance from the core's factory and
+// runs jobs off a shared queue on it, reloading the ROM per job. ROM files
+// and movies are read once up front; a ROM used by several jobs is loaded
+// into every instance from the same read-only image through
+// IEmulatorPlugin::load_rom_shared(). Cores keep no mutable statics, so
+// instances don't interfere with each other.
+//
+// Movie verification: a job with a reference or hash log hashes the core's
+// state at the end of every frame. A hash log is a text file of
+// "<frame> <hash>" lines, hashes in hex; run a known-good movie once with
+// hash_log set to make the reference for later runs.
+//
+// Differential runs: a job with a compare config runs on a pair of fresh
+// instances, one per config, a frame at a time with the same input, to
+// show that a fast setting (lazy PPU scheduling, threaded rendering, ...)
+// gives exactly what the accurate one does. The first frame whose state
+// hash or framebuffer differs is reported with the state hash components
+// (CPU, PPU, ...) that differ there.
+//
+// Verify jobs trade the per-frame checks for speed: only the end state is
+// hashed, so a desync shows up as a wrong final hash rather than the frame
+// it started on. The core's own fast paths come from the job's config
+// (the NES's lazy PPU is its fast_mode; idle loop skipping is always on
+// where a core has it). Pairing a verify job with a compare config of the
+// core's accurate settings, or with a reference logged by normal playback,
+// shows the preset ends where ordinary playback does.
+class InstanceRunner {
+public:
+    using CreateFunc = std::function<IEmulatorPlugin*()>;
+    using DestroyFunc = std::function<void(IEmulatorPlugin*)>;
+
+    InstanceRunner(CreateFunc create, DestroyFunc destroy);
+
+    // Results are in job order
+    std::vector<RunnerJobResult> run(const std::vector<RunnerJob>& jobs, const RunnerOptions& options);
+
+    // Read a job list: {"jobs": [{"name", "rom", "movie", "frames",
+    // "reference", "hash_log", "config", "compare_config", "verify"}, ...]},
+    // with relative paths taken from the list's directory. Returns false
+    // and sets error if the file can't be used.
+    static bool load_jobs(const std::string& path, std::vector<RunnerJob>& jobs, std::string& error);
+
+    // Write results and the whole run's wall time as JSON to path, or
+    // stdout if path is empty
+    static bool write_report(const std::vector<RunnerJobResult>& results, uint64_t total_ns,
+                             const std::string& path);
+
+private:
+    CreateFunc m_create;
+    DestroyFunc m_destroy;
+};
+
+} // namespace emu
@@ -0,0 +1,270 @@
+#include "instant_replay.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace emu {
+
+namespace {
+
+// Enough keyframes that the oldest is still at or before the window's start
+// when the next one is due
+size_t keyframe_slots(const InstantReplayOptions& options) {
+    int interval = std::max(options.keyframe_interval, 1);
+    return static_cast<size_t>(std::max(options.window_frames, 1) / interval) + 2;
+}
+
+} // namespace
+
+InstantReplay::~InstantReplay() {
+    cancel_export();
+}
+
+void InstantReplay::configure(size_t max_state_size, const InstantReplayOptions& options) {
+    m_options = options;
+    m_options.window_frames = std::max(options.window_frames, 1);
+    m_options.keyframe_interval = std::max(options.keyframe_interval, 1);
+
+    // The inputs since the oldest keyframe are kept too
+    size_t keyframes = keyframe_slots(m_options);
+    m_keyframes.assign(keyframes, Keyframe{});
+    for (auto& slot : m_keyframes) slot.state.assign(max_state_size, 0);
+    m_inputs.assign(keyframes * m_options.keyframe_interval, FrameInput{});
+    clear();
+}
+
+size_t InstantReplay::get_memory_needed(size_t max_state_size, const InstantReplayOptions& options) {
+    size_t keyframes = keyframe_slots(options);
+    size_t inputs = keyframes * static_cast<size_t>(std::max(options.keyframe_interval, 1));
+    return keyframes * max_state_size + inputs * sizeof(FrameInput);
+}
+
+size_t InstantReplay::get_allocated_bytes() const {
+    size_t max_state_size = m_keyframes.empty() ? 0 : m_keyframes.front().state.size();
+    return m_keyframes.size() * max_state_size + m_inputs.size() * sizeof(FrameInput);
+}
+
+void InstantReplay::release() {
+    m_keyframes = {};
+    m_inputs = {};
+    clear();
+}
+
+void InstantReplay::shrink(size_t max_bytes) {
+    if (!is_configured() || max_bytes >= get_allocated_bytes()) return;
+
+    size_t state_size = m_keyframes.front().state.size();
+    size_t interval = static_cast<size_t>(m_options.keyframe_interval);
+    size_t slots = max_bytes / (state_size + interval * sizeof(FrameInput));
+    if (slots < 3) {
+        release();
+        return;
+    }
+
+    // Keyframe frames are log indices, so the inputs since the oldest one
+    // kept go to the same frames of the smaller log
+    size_t keep = std::min(m_keyframe_count, slots);
+    std::vector<Keyframe> keyframes(slots);
+    for (size_t i = 0; i < slots; i++) {
+        if (i < keep) {
+            keyframes[i] = std::move(keyframe(m_keyframe_count - keep + i));
+        } else {
+            keyframes[i].state.assign(state_size, 0);
+        }
+    }
+    std::vector<FrameInput> inputs(slots * interval);
+    for (uint64_t frame = keep > 0 ? keyframes[0].frame : m_frame; frame < m_frame; frame++) {
+        inputs[frame % inputs.size()] = m_inputs[frame % m_inputs.size()];
+    }
+
+    m_keyframes = std::move(keyframes);
+    m_inputs = std::move(inputs);
+    m_first_keyframe = 0;
+    m_keyframe_count = keep;
+    m_options.window_frames = std::min(m_options.window_frames, static_cast<int>((slots - 2) * interval));
+}
+
+void InstantReplay::clear() {
+    m_first_keyframe = 0;
+    m_keyframe_count = 0;
+    m_frame = 0;
+    m_pending = {};
+    m_core_frame = 0;
+}
+
+void InstantReplay::on_input_poll(uint32_t buttons) {
+    uint32_t index = std::min<uint32_t>(m_pending.poll_count, MAX_POLLS - 1);
+    m_pending.polls[index] = buttons;
+    m_pending.poll_count++;
+}
+
+void InstantReplay::on_frame(IEmulatorPlugin& plugin, INetplayCapable& core, const InputState& input) {
+    FrameInput frame = m_pending;
+    frame.buttons = input.buttons;
+    m_pending = {};
+    if (!is_configured()) return;
+
+    // A jump in the core's frame count breaks the chain of inputs
+    uint64_t core_frame = plugin.get_frame_count();
+    if (m_keyframe_count > 0 && core_frame != m_core_frame + 1) clear();
+    m_core_frame = core_frame;
+
+    // Inputs only count from the first keyframe on; it's taken after this
+    // frame when there's none yet
+    if (m_keyframe_count > 0) {
+        m_inputs[m_frame % m_inputs.size()] = frame;
+        m_frame++;
+    }
+    if (m_keyframe_count == 0 ||
+            m_frame - keyframe(m_keyframe_count - 1).frame >= static_cast<uint64_t>(m_options.keyframe_interval)) {
+        capture(core);
+    }
+}
+
+void InstantReplay::capture(INetplayCapable& core) {
+    if (m_keyframe_count == m_keyframes.size()) {
+        m_first_keyframe = (m_first_keyframe + 1) % m_keyframes.size();
+        m_keyframe_count--;
+    }
+    Keyframe& slot = keyframe(m_keyframe_count);
+    slot.size = core.save_state_fast(slot.state.data(), slot.state.size());
+    slot.frame = m_frame;
+    if (slot.size == 0) {
+        clear();
+        return;
+    }
+    m_keyframe_count++;
+}
+
+size_t InstantReplay::start_keyframe() const {
+    uint64_t window = static_cast<uint64_t>(m_options.window_frames);
+    uint64_t window_start = m_frame > window ? m_frame - window : 0;
+    size_t index = 0;
+    while (index + 1 < m_keyframe_count && keyframe(index + 1).frame <= window_start) index++;
+    return index;
+}
+
+uint64_t InstantReplay::get_frame_count() const {
+    if (m_keyframe_count == 0) return 0;
+    return std::min(m_frame - keyframe(0).frame, static_cast<uint64_t>(m_options.window_frames));
+}
+
+size_t InstantReplay::get_used_bytes() const {
+    size_t bytes = 0;
+    for (size_t i = 0; i < m_keyframe_count; i++) bytes += keyframe(i).size;
+    return bytes + static_cast<size_t>(std::min<uint64_t>(m_frame, m_inputs.size())) * sizeof(FrameInput);
+}
+
+bool InstantReplay::start_export(IEmulatorPlugin* core, std::function<void(IEmulatorPlugin*)> release_core,
+                                 std::unique_ptr<IAVEncoder> encoder, const std::string& path,
+                                 const AVStreamInfo& info, std::string& error) {
+    auto refuse = [&](const char* reason) {
+        if (core && release_core) release_core(core);
+        error = reason;
+        return false;
+    };
+    if (m_export_thread.joinable()) return refuse("A replay is already being saved");
+    if (!core) return refuse("Couldn't create a core to replay on");
+    if (get_frame_count() == 0) return refuse("Nothing recorded yet");
+
+    // Everything the thread needs is copied now, so the live history keeps
+    // moving while it runs
+    const Keyframe& start = keyframe(start_keyframe());
+    m_export_state.assign(start.state.begin(), start.state.begin() + start.size);
+    m_export_inputs.clear();
+    for (uint64_t frame = start.frame; frame < m_frame; frame++) {
+        m_export_inputs.push_back(m_inputs[frame % m_inputs.size()]);
+    }
+    uint64_t window = static_cast<uint64_t>(m_options.window_frames);
+    m_export_skip = m_export_inputs.size() > window ? m_export_inputs.size() - window : 0;
+
+    AVRecordOptions options;
+    options.policy = AVRecordPolicy::Block;
+    if (!m_export_recorder.start(std::move(encoder), path, info, options, error)) {
+        if (release_core) release_core(core);
+        return false;
+    }
+
+    m_export_core = core;
+    m_release_core = std::move(release_core);
+    m_export_error.clear();
+    m_export_cancel.store(false, std::memory_order_relaxed);
+    m_exporting.store(true, std::memory_order_release);
+    m_export_thread = std::thread([this] { run_export(); });
+    return true;
+}
+
+void InstantReplay::cancel_export() {
+    m_export_cancel.store(true, std::memory_order_relaxed);
+    finish_export();
+}
+
+bool InstantReplay::poll_export(std::string& files, std::string& error) {
+    if (!m_export_thread.joinable() || m_exporting.load(std::memory_order_acquire)) return false;
+    finish_export();
+
+    files.clear();
+    for (const auto& file : m_export_recorder.get_output_files()) {
+        files += (files.empty() ? "" : ", ") + file;
+    }
+    error = m_export_error;
+    return true;
+}
+
+void InstantReplay::finish_export() {
+    if (m_export_thread.joinable()) m_export_thread.join();
+    if (m_export_core && m_release_core) m_release_core(m_export_core);
+    m_export_core = nullptr;
+    m_release_core = nullptr;
+    m_export_state = {};
+    m_export_inputs = {};
+    m_exporting.store(false, std::memory_order_release);
+}
+
+uint32_t InstantReplay::poll_export_input(void* context, float frame_position) {
+    (void)frame_position;
+    auto* replay = static_cast<InstantReplay*>(context);
+    const FrameInput& frame = *replay->m_export_frame;
+    if (frame.poll_count == 0) return frame.buttons;
+    uint32_t index = std::min<uint32_t>(replay->m_export_poll++, std::min<uint32_t>(frame.poll_count, MAX_POLLS) - 1);
+    return frame.polls[index];
+}
+
+void InstantReplay::run_export() {
+    IEmulatorPlugin* core = m_export_core;
+    auto* netplay = dynamic_cast<INetplayCapable*>(core);
+    if (!netplay || !netplay->load_state_fast(m_export_state.data(), m_export_state.size())) {
+        m_export_error = "Couldn't load the replay's starting state";
+    } else {
+        // The frames before the window only bring the core up to it
+        core->set_audio_enabled(true);
+        core->set_input_poll({this, &InstantReplay::poll_export_input});
+        for (size_t i = 0; i < m_export_inputs.size(); i++) {
+            if (m_export_cancel.load(std::memory_order_relaxed)) break;
+            bool shown = i >= m_export_skip;
+            core->set_video_enabled(shown);
+
+            m_export_frame = &m_export_inputs[i];
+            m_export_poll = 0;
+            InputState input;
+            input.buttons = m_export_frame->buttons;
+            core->run_frame(input);
+
+            if (shown) {
+                AudioBuffer audio = core->get_audio();
+                m_export_recorder.add_audio(audio.samples, audio.sample_count, audio.sample_rate);
+                FrameBuffer video = core->get_framebuffer();
+                m_export_recorder.add_frame(video.pixels, video.width, video.height);
+            }
+            core->clear_audio_buffer();
+        }
+        core->set_input_poll({});
+    }
+
+    m_export_recorder.stop();
+    if (m_export_error.empty()) m_export_error = m_export_recorder.get_error();
+    m_exporting.store(false, std::memory_order_release);
+}
+
+} // namespace emu
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "av_recorder.hpp"
+
+#include "emu/emulator_plugin.hpp"
+#include "emu/netplay_plugin.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace emu {
+
+struct InstantReplayOptions {
+    int window_frames = 1800;       // Frames a replay covers (30 s at 60 fps)
+    int keyframe_interval = 300;    // Frames between state captures
+};
+
+// The last stretch of play, kept as states and inputs rather than video
+//
+// Every keyframe_interval frames the core's state is captured with
+// save_state_fast() into a ring of slots allocated up front, and each
+// frame's input is logged: the InputState it ran with and the values of
+// any mid-frame pad latches (see InputPoll). A replay loads the newest
+// keyframe at or before the start of the window into a second core and
+// runs the logged inputs from there on a background thread, drawing only
+// the frames inside the window, so the live frame pays for an input copy
+// and now and then a state save. The core's frame count is checked each
+// frame; a jump (state load, reset, rewinding) starts the history over.
+class InstantReplay {
+public:
+    // Latches per frame kept in the log; later ones replay the last value
+    static constexpr int MAX_POLLS = 4;
+
+    InstantReplay() = default;
+    ~InstantReplay();
+
+    InstantReplay(const InstantReplay&) = delete;
+    InstantReplay& operator=(const InstantReplay&) = delete;
+
+    // Allocate for states of up to max_state_size bytes; drops any history
+    void configure(size_t max_state_size, const InstantReplayOptions& options);
+
+    // Free everything; configure() again before use
+    void release();
+
+    // Drop the history but keep the memory
+    void clear();
+
+    // Cut the window down until the allocation fits in max_bytes, keeping
+    // the newest keyframes and their inputs; released if not even one
+    // keyframe interval fits
+    void shrink(size_t max_bytes);
+
+    bool is_configured() const { return !m_keyframes.empty(); }
+
+    // Bytes configure() allocates for options, and has allocated
+    static size_t get_memory_needed(size_t max_state_size, const InstantReplayOptions& options);
+    size_t get_allocated_bytes() const;
+
+    // Emulation thread: a pad latch in the frame being run
+    void on_input_poll(uint32_t buttons);
+
+    // Emulation thread: after each frame, with the input it ran with
+    void on_frame(IEmulatorPlugin& plugin, INetplayCapable& core, const InputState& input);
+
+    // Frames a replay would cover now
+    uint64_t get_frame_count() const;
+    size_t get_used_bytes() const;
+
+    // Replay the window on core (a clone of the live one, which the replay
+    // owns until release_core is called with it) into an encoder at path,
+    // on a background thread. False, with error set, if there's nothing to
+    // replay or an export is running; core is released in that case too.
+    bool start_export(IEmulatorPlugin* core, std::function<void(IEmulatorPlugin*)> release_core,
+                      std::unique_ptr<IAVEncoder> encoder, const std::string& path, const AVStreamInfo& info,
+                      std::string& error);
+
+    // Stop an export early and release its core
+    void cancel_export();
+
+    // Emulation thread: once an export has finished, release its core and
+    // return true with the files written, or error set if it failed
+    bool poll_export(std::string& files, std::string& error);
+
+    bool is_exporting() const { return m_exporting.load(std::memory_order_acquire); }
+
+private:
+    struct FrameInput {
+        uint32_t buttons;
+        uint32_t poll_count;
+        uint32_t polls[MAX_POLLS];
+    };
+
+    struct Keyframe {
+        std::vector<uint8_t> state;
+        size_t size = 0;
+        uint64_t frame = 0;     // Input log index of the frame that follows it
+    };
+
+    Keyframe& keyframe(size_t index) { return m_keyframes[(m_first_keyframe + index) % m_keyframes.size()]; }
+    const Keyframe& keyframe(size_t index) const {
+        return m_keyframes[(m_first_keyframe + index) % m_keyframes.size()];
+    }
+
+    // Index of the keyframe a replay starts from
+    size_t start_keyframe() const;
+
+    void capture(INetplayCapable& core);
+    void run_export();
+    void finish_export();
+    static uint32_t poll_export_input(void* context, float frame_position);
+
+    InstantReplayOptions m_options;
+
+    std::vector<Keyframe> m_keyframes;  // Ring, oldest first
+    size_t m_first_keyframe = 0;
+    size_t m_keyframe_count = 0;
+
+    std::vector<FrameInput> m_inputs;   // Ring indexed by frame
+    uint64_t m_frame = 0;               // Frames logged since the history started
+    FrameInput m_pending{};             // Latches of the frame being run
+    uint64_t m_core_frame = 0;          // Core's frame count after the last frame logged
+
+    // Export; the thread owns these while it runs
+    std::thread m_export_thread;
+    std::atomic<bool> m_exporting{false};
+    std::atomic<bool> m_export_cancel{false};
+    IEmulatorPlugin* m_export_core = nullptr;
+    std::function<void(IEmulatorPlugin*)> m_release_core;
+    std::vector<uint8_t> m_export_state;
+    std::vector<FrameInput> m_export_inputs;
+    size_t m_export_skip = 0;           // Frames run before the window starts
+    const FrameInput* m_export_frame = nullptr;
+    uint32_t m_export_poll = 0;
+    AVRecorder m_export_recorder;
+    std::unique_ptr<IAVEncoder> m_export_encoder;
+    std::string m_export_path;
+    AVStreamInfo m_export_info;
+    std::string m_export_error;         // Written by the thread before m_exporting clears
+};
+
+} // namespace emu
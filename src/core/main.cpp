@@ -12,5 +12,5 @@ int main(int argc, char* argv[]) {
     app.run();
     app.shutdown();
 
-    return 0;
+    return app.get_exit_code();
 }
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace emu {
+
+// Read-only memory mapping of a whole file
+//
+// Lets large files (savestates) be parsed in place instead of read into a
+// buffer first; pages come in from the page cache as they're touched.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    // Disable copy
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map path, closing any previous mapping; false if it can't be opened.
+    // An empty file maps to size() == 0.
+    bool open(const std::string& path);
+    void close();
+
+    const uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool is_open() const { return m_open; }
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_open = false;
+#ifdef _WIN32
+    void* m_file = nullptr;     // HANDLE
+    void* m_mapping = nullptr;  // HANDLE
+#endif
+};
+
+} // namespace emu
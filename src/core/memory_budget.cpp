@@ -0,0 +1,101 @@
+#include "memory_budget.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace emu {
+
+void MemoryBudget::set_total(size_t bytes) {
+    m_total = bytes;
+    balance();
+}
+
+int MemoryBudget::add(MemoryConsumer consumer) {
+    int id = m_next_id++;
+    m_consumers.push_back({id, std::move(consumer)});
+    return id;
+}
+
+void MemoryBudget::remove(int id) {
+    m_consumers.erase(std::remove_if(m_consumers.begin(), m_consumers.end(),
+        [id](const Entry& entry) { return entry.id == id; }), m_consumers.end());
+}
+
+size_t MemoryBudget::request(int id, size_t wanted) {
+    auto it = std::find_if(m_consumers.begin(), m_consumers.end(),
+        [id](const Entry& entry) { return entry.id == id; });
+    if (m_total == 0 || it == m_consumers.end()) return wanted;
+
+    // What the consumer holds now is what it's about to replace
+    auto others_used = [&]() {
+        size_t bytes = 0;
+        for (const Entry& entry : m_consumers) {
+            if (entry.id != id) bytes += entry.consumer.get_used();
+        }
+        return bytes;
+    };
+    size_t others = others_used();
+    if (others + wanted > m_total) {
+        make_room(others + wanted - m_total, static_cast<int>(it->consumer.priority));
+        others = others_used();
+    }
+    return others < m_total ? std::min(wanted, m_total - others) : 0;
+}
+
+size_t MemoryBudget::balance() {
+    if (m_total == 0) return 0;
+    size_t used = get_used_bytes();
+    if (used <= m_total) return 0;
+    return make_room(used - m_total, static_cast<int>(MemoryPriority::Editing) + 1);
+}
+
+size_t MemoryBudget::make_room(size_t needed, int priority) {
+    struct Candidate {
+        Entry* entry;
+        size_t used;
+    };
+    std::vector<Candidate> candidates;
+    for (Entry& entry : m_consumers) {
+        if (static_cast<int>(entry.consumer.priority) < priority) {
+            candidates.push_back({&entry, entry.consumer.get_used()});
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        const MemoryConsumer& x = a.entry->consumer;
+        const MemoryConsumer& y = b.entry->consumer;
+        if (x.priority != y.priority) return x.priority < y.priority;
+        if (x.fixed != y.fixed) return !x.fixed;
+        return a.used > b.used;
+    });
+
+    size_t freed = 0;
+    for (const Candidate& candidate : candidates) {
+        if (freed >= needed) break;
+        if (candidate.used == 0) continue;
+        size_t take = std::min(candidate.used, needed - freed);
+        candidate.entry->consumer.shrink(candidate.used - take);
+
+        // Consumers free in whole entries, so it may be more or less than asked
+        size_t now = candidate.entry->consumer.get_used();
+        if (now < candidate.used) freed += candidate.used - now;
+    }
+    return freed;
+}
+
+size_t MemoryBudget::get_used_bytes() const {
+    size_t bytes = 0;
+    for (const Entry& entry : m_consumers) {
+        bytes += entry.consumer.get_used();
+    }
+    return bytes;
+}
+
+std::vector<MemoryBudget::Usage> MemoryBudget::get_usage() const {
+    std::vector<Usage> usage;
+    for (const Entry& entry : m_consumers) {
+        usage.push_back({entry.consumer.name, entry.consumer.get_used()});
+    }
+    return usage;
+}
+
+} // namespace emu
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace emu {
+
+// Which consumers give memory back first when the total is exceeded; lowest first
+enum class MemoryPriority {
+    Cache = 0,      // Can be rebuilt by loading again (warm ROMs)
+    History = 1,    // Recent play kept for going back (rewind, instant replay, RAM recording)
+    Editing = 2,    // States a user is working from (TAS greenzone)
+};
+
+struct MemoryConsumer {
+    std::string name;
+    MemoryPriority priority = MemoryPriority::History;
+    std::function<size_t()> get_used;       // Bytes held now
+    std::function<void(size_t)> shrink;     // Get down to at most this many bytes
+    bool fixed = false;                     // Allocated up front rather than grown
+};
+
+// One total for the memory the host spends on history and caches
+//
+// Each component that keeps history or a cache registers with a priority
+// and two callbacks: the bytes it holds, and a request to get down to a
+// given size by dropping its oldest or least useful entries. A consumer that
+// allocates up front asks for what it wants with request() first; when that
+// would take the total over, lower priority consumers are shrunk to make
+// room, and it's granted whatever is left then. Consumers that grow as they
+// go are kept in line by balance(), which shrinks the lowest priority
+// consumers until the total fits again. Within a priority the growing ones
+// go before the fixed ones, whose shrinking means moving to a smaller
+// allocation, and the largest go first. A total of 0 is unlimited and
+// leaves every consumer to its own budget.
+//
+// Not thread-safe: used on the emulation thread, or with it stopped, like
+// the components it calls into.
+class MemoryBudget {
+public:
+    // Total in low memory mode (--low-memory)
+    static constexpr size_t LOW_MEMORY_TOTAL = size_t(256) << 20;
+
+    void set_total(size_t bytes);
+    size_t get_total() const { return m_total; }
+
+    // Returns an id for request() and remove()
+    int add(MemoryConsumer consumer);
+    void remove(int id);
+
+    // Bytes consumer id may hold, up to wanted, after making room
+    size_t request(int id, size_t wanted);
+
+    // Shrink consumers until the total fits; returns the bytes freed
+    size_t balance();
+
+    size_t get_used_bytes() const;
+
+    struct Usage {
+        std::string name;
+        size_t bytes;
+    };
+    std::vector<Usage> get_usage() const;
+
+private:
+    struct Entry {
+        int id;
+        MemoryConsumer consumer;
+    };
+
+    // Free up to needed bytes from consumers of a lower priority than
+    // priority, in the order balance() uses; returns the bytes freed
+    size_t make_room(size_t needed, int priority);
+
+    std::vector<Entry> m_consumers;
+    int m_next_id = 1;
+    size_t m_total = 0;
+};
+
+} // namespace emu
@@ -0,0 +1,178 @@
+#include "memory_scanner.hpp"
+
+#include "emu/emulator_plugin.hpp"
+
+#include <bitset>
+#include <cstring>
+#include <type_traits>
+
+namespace emu {
+
+namespace {
+
+constexpr size_t BLOCK = 64;    // Slots per candidate word
+
+// Bit i of the result is set when a[i] compares with b[i]. The compare is
+// a separate pass into bytes so it stays a simple loop the compiler can
+// vectorize; packing the bytes into bits is a second one.
+template <typename T>
+uint64_t compare_block(ScanCompare compare, const T* a, const T* b) {
+    uint8_t match[BLOCK];
+    switch (compare) {
+        case ScanCompare::Equal:
+            for (size_t i = 0; i < BLOCK; i++) match[i] = a[i] == b[i];
+            break;
+        case ScanCompare::NotEqual:
+            for (size_t i = 0; i < BLOCK; i++) match[i] = a[i] != b[i];
+            break;
+        case ScanCompare::Greater:
+            for (size_t i = 0; i < BLOCK; i++) match[i] = a[i] > b[i];
+            break;
+        case ScanCompare::Less:
+            for (size_t i = 0; i < BLOCK; i++) match[i] = a[i] < b[i];
+            break;
+    }
+
+    uint64_t bits = 0;
+    for (size_t i = 0; i < BLOCK; i++) {
+        bits |= static_cast<uint64_t>(match[i]) << i;
+    }
+    return bits;
+}
+
+} // namespace
+
+bool MemoryScanner::start(IEmulatorPlugin& plugin, size_t domain, int width, bool is_signed) {
+    stop();
+    if (width != 1 && width != 2 && width != 4) return false;
+
+    auto domains = plugin.get_memory_domains();
+    if (domain >= domains.size()) return false;
+    uint32_t size = domains[domain].size;
+    if (size < static_cast<uint32_t>(width) || size > MAX_DOMAIN_SIZE) return false;
+
+    m_domain = domain;
+    m_width = width;
+    m_signed = is_signed;
+    m_slots = size / width;
+
+    // Padded to whole blocks so the compare never needs a partial one
+    size_t words = (m_slots + BLOCK - 1) / BLOCK;
+    m_current.assign(words * BLOCK * width, 0);
+    m_previous.assign(m_current.size(), 0);
+    m_candidates.assign(words, 0);
+
+    if (!refresh(plugin)) {
+        stop();
+        return false;
+    }
+    m_previous = m_current;
+    reset_candidates();
+    return true;
+}
+
+void MemoryScanner::stop() {
+    m_width = 0;
+    m_slots = 0;
+    m_candidate_count = 0;
+    m_current.clear();
+    m_previous.clear();
+    m_candidates.clear();
+}
+
+bool MemoryScanner::refresh(IEmulatorPlugin& plugin) {
+    if (!is_active()) return false;
+    return plugin.read_memory_block(m_domain, 0, m_slots * m_width, m_current.data());
+}
+
+void MemoryScanner::reset_candidates() {
+    std::fill(m_candidates.begin(), m_candidates.end(), ~uint64_t(0));
+    if (size_t tail = m_slots % BLOCK) {
+        m_candidates.back() = (uint64_t(1) << tail) - 1;
+    }
+    m_candidate_count = m_slots;
+}
+
+void MemoryScanner::filter(ScanCompare compare, bool against_previous, uint32_t value) {
+    if (!is_active()) return;
+
+    switch (m_width) {
+        case 1:
+            if (m_signed) filter_as<int8_t>(compare, against_previous, static_cast<int8_t>(value));
+            else filter_as<uint8_t>(compare, against_previous, static_cast<uint8_t>(value));
+            break;
+        case 2:
+            if (m_signed) filter_as<int16_t>(compare, against_previous, static_cast<int16_t>(value));
+            else filter_as<uint16_t>(compare, against_previous, static_cast<uint16_t>(value));
+            break;
+        case 4:
+            if (m_signed) filter_as<int32_t>(compare, against_previous, static_cast<int32_t>(value));
+            else filter_as<uint32_t>(compare, against_previous, value);
+            break;
+    }
+
+    m_previous = m_current;
+    count_candidates();
+}
+
+template <typename T>
+void MemoryScanner::filter_as(ScanCompare compare, bool against_previous, T value) {
+    static_assert(std::is_trivially_copyable<T>::value, "scanned values are copied from bytes");
+
+    // Snapshots are little-endian, as is every host this builds for, so a
+    // block of them copies straight into values
+    T current[BLOCK];
+    T other[BLOCK];
+    if (!against_previous) {
+        for (size_t i = 0; i < BLOCK; i++) other[i] = value;
+    }
+
+    for (size_t word = 0; word < m_candidates.size(); word++) {
+        if (m_candidates[word] == 0) continue;
+
+        size_t offset = word * BLOCK * sizeof(T);
+        std::memcpy(current, m_current.data() + offset, sizeof(current));
+        if (against_previous) {
+            std::memcpy(other, m_previous.data() + offset, sizeof(other));
+        }
+        m_candidates[word] &= compare_block(compare, current, other);
+    }
+}
+
+void MemoryScanner::count_candidates() {
+    m_candidate_count = 0;
+    for (uint64_t word : m_candidates) {
+        m_candidate_count += std::bitset<64>(word).count();
+    }
+}
+
+uint32_t MemoryScanner::next_candidate(uint32_t address) const {
+    if (!is_active()) return UINT32_MAX;
+
+    size_t slot = (address + m_width - 1) / m_width;
+    while (slot < m_slots) {
+        uint64_t word = m_candidates[slot / BLOCK] >> (slot % BLOCK);
+        if (word == 0) {
+            slot = (slot / BLOCK + 1) * BLOCK;
+            continue;
+        }
+        while (!(word & 1)) {
+            word >>= 1;
+            slot++;
+        }
+        return static_cast<uint32_t>(slot * m_width);
+    }
+    return UINT32_MAX;
+}
+
+uint32_t MemoryScanner::value_at(const std::vector<uint8_t>& bytes, uint32_t address) const {
+    if (!is_active() || static_cast<size_t>(address) + m_width > m_slots * m_width) return 0;
+
+    uint32_t value = 0;
+    for (int b = m_width - 1; b >= 0; b--) {
+        value = (value << 8) | bytes[address + b];
+    }
+    return value;
+}
+
+} // namespace emu
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace emu {
+
+class IEmulatorPlugin;
+
+enum class ScanCompare {
+    Equal,
+    NotEqual,
+    Greater,
+    Less
+};
+
+// RAM search over one memory domain
+//
+// Values are width bytes wide (1, 2 or 4, little-endian) at addresses that
+// are multiples of the width. refresh() snapshots the domain with one
+// read_memory_block(); filter() keeps the candidates whose current value
+// compares as asked with either a constant or the value at the previous
+// filter. Candidates are a bitset, one bit per value, and the compare runs
+// over 64 values at a time in plain loops over the snapshots, skipping
+// words with no candidates left, so even a first pass over 256KB of GBA
+// EWRAM is a fraction of a millisecond.
+class MemoryScanner {
+public:
+    // Largest domain start() accepts; CPU buses and ROMs are bigger
+    static constexpr uint32_t MAX_DOMAIN_SIZE = 4 * 1024 * 1024;
+
+    // Begin a search with every value a candidate; false if the domain is
+    // too big or can't be read
+    bool start(IEmulatorPlugin& plugin, size_t domain, int width, bool is_signed);
+
+    // Forget the search
+    void stop();
+
+    bool is_active() const { return m_width != 0; }
+    size_t get_domain() const { return m_domain; }
+    int get_width() const { return m_width; }
+    bool is_signed() const { return m_signed; }
+
+    // Read the domain again into the current snapshot, e.g. every frame
+    bool refresh(IEmulatorPlugin& plugin);
+
+    // Keep candidates whose current value compares with value, or with
+    // their value as of the previous filter (start() counts as one). The
+    // current snapshot becomes the previous.
+    void filter(ScanCompare compare, bool against_previous, uint32_t value);
+
+    // Every value a candidate again, without a new snapshot
+    void reset_candidates();
+
+    size_t get_candidate_count() const { return m_candidate_count; }
+
+    // Address of the first candidate at or after address, or UINT32_MAX
+    uint32_t next_candidate(uint32_t address) const;
+
+    uint32_t get_current_value(uint32_t address) const { return value_at(m_current, address); }
+    uint32_t get_previous_value(uint32_t address) const { return value_at(m_previous, address); }
+
+private:
+    uint32_t value_at(const std::vector<uint8_t>& bytes, uint32_t address) const;
+
+    template <typename T>
+    void filter_as(ScanCompare compare, bool against_previous, T value);
+
+    void count_candidates();
+
+    size_t m_domain = 0;
+    int m_width = 0;                // 0 while no search is active
+    bool m_signed = false;
+    size_t m_slots = 0;             // Values in the domain
+
+    std::vector<uint8_t> m_current;
+    std::vector<uint8_t> m_previous;
+    std::vector<uint64_t> m_candidates;  // Bit per slot
+    size_t m_candidate_count = 0;
+};
+
+} // namespace emu
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace emu {
+
+// Rolling per-frame timings for the performance overlay
+//
+// Recorded at the same points as the host trace scopes, but always built
+// in: the emulation thread writes its frame time and pacing error, the
+// main thread its upload, GUI and present times. While the overlay is
+// hidden a Scope costs one relaxed load and measures nothing; while it is
+// shown a sample is a pair of relaxed stores, so neither thread takes a
+// lock for the other.
+class PerfMonitor {
+public:
+    enum Series {
+        EMULATE,            // Core frame, ms
+        PACING_ERROR,       // Frame start interval minus the target, ms
+        AUDIO_FILL,         // Audio ring level, ms of sound
+        TEXTURE_UPLOAD,     // ms
+        GUI,                // Build and render, ms
+        PRESENT,            // Buffer swap, ms
+        SERIES_COUNT
+    };
+
+    static constexpr size_t HISTORY = 240;  // Samples kept per series
+
+    bool is_enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    // Start or stop measuring; starting drops what was kept last time
+    void set_enabled(bool enabled) {
+        if (enabled && !is_enabled()) {
+            for (Ring& ring : m_rings) {
+                ring.count.store(0, std::memory_order_relaxed);
+            }
+        }
+        m_enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    void record(Series series, float value) {
+        Ring& ring = m_rings[series];
+        size_t count = ring.count.load(std::memory_order_relaxed);
+        ring.values[count % HISTORY].store(value, std::memory_order_relaxed);
+        ring.count.store(count + 1, std::memory_order_release);
+    }
+
+    // Copy a series into out (HISTORY floats), oldest first; returns how
+    // many samples there are
+    size_t copy(Series series, float* out) const {
+        const Ring& ring = m_rings[series];
+        size_t count = ring.count.load(std::memory_order_acquire);
+        size_t kept = count < HISTORY ? count : HISTORY;
+        for (size_t i = 0; i < kept; i++) {
+            out[i] = ring.values[(count - kept + i) % HISTORY].load(std::memory_order_relaxed);
+        }
+        return kept;
+    }
+
+    // Frame time the emulation thread is pacing to, ms (0 when unpaced)
+    float get_budget_ms() const { return m_budget_ms.load(std::memory_order_relaxed); }
+    void set_budget_ms(float ms) { m_budget_ms.store(ms, std::memory_order_relaxed); }
+
+    static uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    static float ms_between(uint64_t start_ns, uint64_t end_ns) {
+        return static_cast<float>(static_cast<double>(end_ns - start_ns) / 1e6);
+    }
+
+    // Records the time until it goes out of scope, if measuring when made
+    class Scope {
+    public:
+        Scope(PerfMonitor& monitor, Series series)
+            : m_monitor(monitor.is_enabled() ? &monitor : nullptr), m_series(series),
+              m_start(m_monitor ? now_ns() : 0) {}
+        ~Scope() {
+            if (m_monitor) m_monitor->record(m_series, ms_between(m_start, now_ns()));
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        PerfMonitor* m_monitor;
+        Series m_series;
+        uint64_t m_start;
+    };
+
+private:
+    struct Ring {
+        std::array<std::atomic<float>, HISTORY> values{};
+        std::atomic<size_t> count{0};
+    };
+
+    std::array<Ring, SERIES_COUNT> m_rings;
+    std::atomic<bool> m_enabled{false};
+    std::atomic<float> m_budget_ms{0.0f};
+};
+
+} // namespace emu
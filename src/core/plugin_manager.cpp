@@ -1,6 +1,8 @@
 #include "plugin_manager.hpp"
 #include "paths_config.hpp"
+#include "mapped_file.hpp"
 
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
@@ -23,18 +25,41 @@ uint8_t GamePluginHost::read_memory(uint16_t address) {
 
 uint16_t GamePluginHost::read_memory_16(uint16_t address) {
     // Little-endian read
-    uint16_t lo = read_memory(address);
-    uint16_t hi = read_memory(address + 1);
-    return lo | (hi << 8);
+    uint8_t b[2];
+    read_bus(address, b, sizeof(b));
+    return static_cast<uint16_t>(b[0] | (b[1] << 8));
 }
 
 uint32_t GamePluginHost::read_memory_32(uint16_t address) {
     // Little-endian read
-    uint32_t b0 = read_memory(address);
-    uint32_t b1 = read_memory(address + 1);
-    uint32_t b2 = read_memory(address + 2);
-    uint32_t b3 = read_memory(address + 3);
-    return b0 | (b1 << 8) | (b2 << 16) | (b3 << 24);
+    uint8_t b[4];
+    read_bus(address, b, sizeof(b));
+    return static_cast<uint32_t>(b[0]) | (static_cast<uint32_t>(b[1]) << 8) |
+           (static_cast<uint32_t>(b[2]) << 16) | (static_cast<uint32_t>(b[3]) << 24);
+}
+
+void GamePluginHost::read_bus(uint16_t address, uint8_t* out, size_t length) {
+    // One call to the core; byte by byte only where the read wraps past $FFFF
+    if (read_memory_block(0, address, length, out)) return;
+    for (size_t i = 0; i < length; i++) {
+        out[i] = read_memory(static_cast<uint16_t>(address + i));
+    }
+}
+
+int GamePluginHost::find_memory_domain(const char* name) {
+    if (!m_plugin_manager || !m_plugin_manager->get_emulator_plugin() || !name) return -1;
+    auto domains = m_plugin_manager->get_emulator_plugin()->get_memory_domains();
+    for (size_t i = 0; i < domains.size(); i++) {
+        if (std::strcmp(domains[i].name, name) == 0) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+bool GamePluginHost::read_memory_block(size_t domain, uint32_t address, size_t length, uint8_t* out) {
+    if (m_plugin_manager && m_plugin_manager->get_emulator_plugin()) {
+        return m_plugin_manager->get_emulator_plugin()->read_memory_block(domain, address, length, out);
+    }
+    return false;
 }
 
 void GamePluginHost::write_memory(uint16_t address, uint8_t value) {
@@ -68,6 +93,13 @@ double GamePluginHost::get_fps() const {
     return 60.0;
 }
 
+bool GamePluginHost::is_lag_frame() const {
+    if (m_plugin_manager && m_plugin_manager->get_emulator_plugin()) {
+        return m_plugin_manager->get_emulator_plugin()->is_lag_frame();
+    }
+    return false;
+}
+
 const char* GamePluginHost::get_rom_name() const {
     return m_rom_name.c_str();
 }
@@ -114,6 +146,209 @@ void GamePluginHost::on_run_reset() {
 void GamePluginHost::set_rom_info(const std::string& name, uint32_t crc32) {
     m_rom_name = name;
     m_rom_crc32 = crc32;
+
+    // The new ROM's values are a baseline, not changes
+    for (auto& set : m_watch_sets) {
+        set.primed = false;
+    }
+
+    // The core may be a different one than the watchpoints went to
+    m_write_hits.clear();
+    if (!m_write_watch_sets.empty()) {
+        apply_write_watchpoints();
+    }
+}
+
+bool GamePluginHost::set_watch_subscriptions(IGamePlugin* plugin, const WatchSubscription* watches,
+                                             size_t count) {
+    if (!plugin) return false;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t width = watches[i].width;
+        if ((width != 1 && width != 2 && width != 4) || watches[i].bit_index >= 32) return false;
+    }
+
+    remove_watches(plugin);
+    if (count == 0) return true;
+
+    WatchSet set;
+    set.plugin = plugin;
+    set.watches.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        set.watches[i].watch = watches[i];
+    }
+
+    // Merge watches in address order into ranges, bridging gaps of up to
+    // MAX_GAP bytes: reading a few unused bytes is cheaper than another call
+    constexpr uint32_t MAX_GAP = 32;
+    std::vector<size_t> order(count);
+    for (size_t i = 0; i < count; i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        const auto& wa = watches[a];
+        const auto& wb = watches[b];
+        return wa.domain != wb.domain ? wa.domain < wb.domain : wa.address < wb.address;
+    });
+
+    for (size_t i : order) {
+        const auto& watch = watches[i];
+        uint64_t end = static_cast<uint64_t>(watch.address) + watch.width;
+        WatchRange* range = set.ranges.empty() ? nullptr : &set.ranges.back();
+        if (!range || range->domain != watch.domain ||
+            watch.address > static_cast<uint64_t>(range->address) + range->length + MAX_GAP) {
+            set.ranges.push_back({watch.domain, watch.address, 0, 0});
+            range = &set.ranges.back();
+        }
+        range->length = static_cast<uint32_t>(
+            std::max<uint64_t>(range->length, end - range->address));
+        set.watches[i].range = set.ranges.size() - 1;
+    }
+
+    size_t total = 0;
+    for (auto& range : set.ranges) {
+        range.offset = total;
+        total += range.length;
+    }
+    set.bytes.resize(total);
+    for (auto& state : set.watches) {
+        const WatchRange& range = set.ranges[state.range];
+        state.offset = range.offset + (state.watch.address - range.address);
+    }
+
+    m_watch_sets.push_back(std::move(set));
+    return true;
+}
+
+void GamePluginHost::remove_watches(IGamePlugin* plugin) {
+    m_watch_sets.erase(std::remove_if(m_watch_sets.begin(), m_watch_sets.end(),
+                                      [plugin](const WatchSet& set) { return set.plugin == plugin; }),
+                       m_watch_sets.end());
+    set_write_watchpoints(plugin, nullptr, 0);
+}
+
+bool GamePluginHost::set_write_watchpoints(IGamePlugin* plugin, const uint32_t* addresses,
+                                           size_t count) {
+    if (!plugin) return false;
+
+    auto it = std::find_if(m_write_watch_sets.begin(), m_write_watch_sets.end(),
+                           [plugin](const WriteWatchSet& set) { return set.plugin == plugin; });
+    if (count == 0) {
+        if (it == m_write_watch_sets.end()) return true;
+        m_write_watch_sets.erase(it);
+    } else {
+        if (it == m_write_watch_sets.end()) {
+            m_write_watch_sets.push_back({plugin, {}});
+            it = m_write_watch_sets.end() - 1;
+        }
+        it->addresses.assign(addresses, addresses + count);
+        std::sort(it->addresses.begin(), it->addresses.end());
+    }
+    return apply_write_watchpoints();
+}
+
+bool GamePluginHost::apply_write_watchpoints() {
+    IEmulatorPlugin* emulator = m_plugin_manager ? m_plugin_manager->get_emulator_plugin() : nullptr;
+    if (!emulator) return m_write_watch_sets.empty();
+
+    std::vector<uint32_t> merged;
+    for (const auto& set : m_write_watch_sets) {
+        merged.insert(merged.end(), set.addresses.begin(), set.addresses.end());
+    }
+    return emulator->set_write_watchpoints(merged.data(), merged.size());
+}
+
+void GamePluginHost::collect_write_hits() {
+    m_write_hits.clear();
+    IEmulatorPlugin* emulator = m_plugin_manager ? m_plugin_manager->get_emulator_plugin() : nullptr;
+    if (!emulator || m_write_watch_sets.empty()) return;
+
+    WriteWatchHit hits[64];
+    while (size_t count = emulator->take_write_watch_hits(hits, 64)) {
+        m_write_hits.insert(m_write_hits.end(), hits, hits + count);
+    }
+}
+
+void GamePluginHost::dispatch_write_hits(IGamePlugin* plugin) {
+    if (m_write_hits.empty()) return;
+    uint64_t frame = get_frame_count();
+    double fps = get_fps();
+
+    // Looked up per hit, since the plugin may resubscribe from the callback
+    for (size_t i = 0; i < m_write_hits.size(); i++) {
+        const WriteWatchHit hit = m_write_hits[i];
+        auto it = std::find_if(m_write_watch_sets.begin(), m_write_watch_sets.end(),
+                               [plugin](const WriteWatchSet& set) { return set.plugin == plugin; });
+        if (it == m_write_watch_sets.end()) return;
+        if (!std::binary_search(it->addresses.begin(), it->addresses.end(), hit.address)) continue;
+
+        // The hit's frame ended hit.frame, and the write came position
+        // into it; frames run since then are whole
+        double frames_ago = 1.0 - hit.frame_position;
+        if (frame > hit.frame) frames_ago += static_cast<double>(frame - hit.frame);
+        plugin->on_watched_write(hit.address, hit.value, fps > 0.0 ? frames_ago / fps : 0.0);
+    }
+}
+
+void GamePluginHost::evaluate_watches(IGamePlugin* plugin) {
+    IEmulatorPlugin* emulator = m_plugin_manager ? m_plugin_manager->get_emulator_plugin() : nullptr;
+    if (!emulator || !emulator->is_rom_loaded()) return;
+
+    auto it = std::find_if(m_watch_sets.begin(), m_watch_sets.end(),
+                           [plugin](const WatchSet& set) { return set.plugin == plugin; });
+    if (it == m_watch_sets.end()) return;
+    WatchSet& set = *it;
+
+    for (auto& range : set.ranges) {
+        range.valid = emulator->read_memory_block(range.domain, range.address, range.length,
+                                                  set.bytes.data() + range.offset);
+    }
+
+    bool primed = set.primed;
+    set.primed = true;
+    m_fired_watches.clear();
+
+    for (size_t i = 0; i < set.watches.size(); i++) {
+        WatchState& state = set.watches[i];
+        if (!set.ranges[state.range].valid) continue;
+
+        const WatchSubscription& watch = state.watch;
+        const uint8_t* bytes = set.bytes.data() + state.offset;
+        uint32_t value = 0;
+        for (int b = watch.width - 1; b >= 0; b--) {
+            value = (value << 8) | bytes[b];
+        }
+
+        uint32_t old_value = state.value;
+        bool changed = value != old_value;
+        bool fire = false;
+        bool level = false;
+        bool is_level = true;
+        switch (watch.condition) {
+            case SplitCondition::Equals:      level = value == watch.value; break;
+            case SplitCondition::NotEquals:   level = value != watch.value; break;
+            case SplitCondition::GreaterThan: level = value > watch.value; break;
+            case SplitCondition::LessThan:    level = value < watch.value; break;
+            case SplitCondition::BitSet:      level = (value >> watch.bit_index) & 1; break;
+            case SplitCondition::BitClear:    level = !((value >> watch.bit_index) & 1); break;
+            case SplitCondition::ChangesTo:   is_level = false; fire = changed && value == watch.value; break;
+            case SplitCondition::ChangesFrom: is_level = false; fire = changed && old_value == watch.value; break;
+            case SplitCondition::Increases:   is_level = false; fire = value > old_value; break;
+            case SplitCondition::Decreases:   is_level = false; fire = value < old_value; break;
+            case SplitCondition::Changes:     is_level = false; fire = changed; break;
+        }
+        if (is_level) {
+            fire = level && !state.held;
+            state.held = level;
+        }
+        state.value = value;
+
+        if (primed && fire) {
+            m_fired_watches.push_back({i, old_value, value});
+        }
+    }
+
+    // After the loop, since the plugin may resubscribe from the callback
+    for (const auto& fired : m_fired_watches) {
+        plugin->on_watch_triggered(fired.index, fired.old_value, fired.new_value);
+    }
 }
 
 // ============================================================
@@ -158,6 +393,7 @@ bool PluginManager::initialize(const std::string& plugin_dir) {
     };
 
     bool found_plugins = false;
+    m_registry.set_probe_cache_path(fs::current_path() / "config" / "plugin_cache.json");
 
     // Scan cores directory first (emulator cores)
     for (const auto& path : core_search_paths) {
@@ -179,6 +415,8 @@ bool PluginManager::initialize(const std::string& plugin_dir) {
         }
     }
 
+    m_registry.save_probe_cache();
+
     const auto& plugins = m_registry.get_all_plugins();
     if (plugins.empty()) {
         std::cout << "No plugins found" << std::endl;
@@ -203,17 +441,17 @@ bool PluginManager::initialize(const std::string& plugin_dir) {
     // Build legacy plugin list for backward compatibility
     build_legacy_plugin_list();
 
-    // Load all emulator plugins (for configuration access)
-    load_all_emulator_plugins();
+    // Cores stay unloaded until a ROM needs one (set_active_plugin_for_file());
+    // only one is used per session
+    register_emulator_plugins();
 
-    // Activate default/configured plugins
-    // Only activate emulator plugin by default; others can be activated later
-    auto emulator_plugins = m_registry.get_plugins_of_type(PluginType::Emulator);
-    if (!emulator_plugins.empty()) {
-        std::string selected = m_config.get_selected_plugin(PluginType::Emulator);
-        if (selected.empty() || !activate_emulator_plugin(selected)) {
+    // Auto-activate audio plugin if available (effects on the output path)
+    auto audio_plugins = m_registry.get_plugins_of_type(PluginType::Audio);
+    if (!audio_plugins.empty()) {
+        std::string selected = m_config.get_selected_plugin(PluginType::Audio);
+        if (selected.empty() || !activate_audio_plugin(selected)) {
             // Use first available
-            activate_emulator_plugin(emulator_plugins[0].name);
+            activate_audio_plugin(audio_plugins[0].name);
         }
     }
 
@@ -230,44 +468,36 @@ bool PluginManager::initialize(const std::string& plugin_dir) {
     return true;
 }
 
-void PluginManager::load_all_emulator_plugins() {
+void PluginManager::register_emulator_plugins() {
     auto emulator_plugins = m_registry.get_plugins_of_type(PluginType::Emulator);
 
     for (const auto& metadata : emulator_plugins) {
-        // Load the plugin library
-        PluginHandle* handle = m_registry.load_plugin(metadata);
-        if (!handle || !handle->create_func) {
-            std::cerr << "Failed to load emulator plugin for config: " << metadata.name << std::endl;
-            continue;
-        }
-
-        // Create instance
-        using CreateFunc = IEmulatorPlugin* (*)();
-        auto create = reinterpret_cast<CreateFunc>(handle->create_func);
-        IEmulatorPlugin* instance = create();
-        if (!instance) {
-            std::cerr << "Failed to create emulator plugin instance for config: " << metadata.name << std::endl;
-            continue;
-        }
-
-        // Load configuration for this plugin
-        fs::path config_path = get_core_config_path(metadata.name);
-        if (instance->load_config(config_path.string().c_str())) {
-            if (fs::exists(config_path)) {
-                std::cout << "Loaded config for " << metadata.name << " from " << config_path << std::endl;
-            }
-        }
-
-        // Store in our list
         EmulatorPluginInstance inst;
-        inst.plugin = instance;
-        inst.handle = handle;
         inst.name = metadata.name;
         inst.library_path = metadata.path.string();
         m_emulator_plugins.push_back(std::move(inst));
     }
 }
 
+void PluginManager::preload_emulator_plugin() {
+    if (m_active.emulator) return;
+
+    std::string selected = m_config.get_selected_plugin(PluginType::Emulator);
+    const PluginMetadata* metadata = m_registry.find_plugin(PluginType::Emulator, selected);
+    if (metadata) {
+        m_registry.preload_library(metadata->path);
+    }
+}
+
+void PluginManager::preload_emulator_plugin_for_file(const std::string& filepath) {
+    if (m_active.emulator) return;
+
+    auto plugins = m_registry.find_plugins_for_extension(get_file_extension(filepath));
+    if (!plugins.empty()) {
+        m_registry.preload_library(plugins[0].path);
+    }
+}
+
 fs::path PluginManager::get_core_config_path(const std::string& core_name) const {
     // Put core configs in config/cores/<name>.json
     fs::path config_dir = fs::current_path() / "config" / "cores";
@@ -284,13 +514,38 @@ fs::path PluginManager::get_core_config_path(const std::string& core_name) const
     return config_dir / (filename + ".json");
 }
 
-IEmulatorPlugin* PluginManager::get_emulator_plugin_by_name(const std::string& name) const {
-    for (const auto& inst : m_emulator_plugins) {
-        if (inst.name == name) {
-            return inst.plugin;
+IEmulatorPlugin* PluginManager::get_emulator_plugin_by_name(const std::string& name) {
+    auto it = std::find_if(m_emulator_plugins.begin(), m_emulator_plugins.end(),
+        [&name](const EmulatorPluginInstance& inst) { return inst.name == name; });
+    if (it == m_emulator_plugins.end()) return nullptr;
+    if (it->plugin) return it->plugin;
+
+    const PluginMetadata* metadata = m_registry.find_plugin(PluginType::Emulator, name);
+    PluginHandle* handle = metadata ? m_registry.load_plugin(*metadata) : nullptr;
+    if (!handle || !handle->create_func) {
+        std::cerr << "Failed to load emulator plugin for config: " << name << std::endl;
+        return nullptr;
+    }
+
+    using CreateFunc = IEmulatorPlugin* (*)();
+    auto create = reinterpret_cast<CreateFunc>(handle->create_func);
+    IEmulatorPlugin* instance = create();
+    if (!instance) {
+        std::cerr << "Failed to create emulator plugin instance for config: " << name << std::endl;
+        return nullptr;
+    }
+
+    // Load configuration for this plugin
+    fs::path config_path = get_core_config_path(name);
+    if (instance->load_config(config_path.string().c_str())) {
+        if (fs::exists(config_path)) {
+            std::cout << "Loaded config for " << name << " from " << config_path << std::endl;
         }
     }
-    return nullptr;
+
+    it->plugin = instance;
+    it->handle = handle;
+    return instance;
 }
 
 void PluginManager::shutdown() {
@@ -299,6 +554,7 @@ void PluginManager::shutdown() {
     m_shutdown_called = true;
 
     unload_rom();
+    clear_warm_roms();
 
     // Deactivate all plugins
     deactivate_plugin(PluginType::Netplay);
@@ -487,6 +743,11 @@ bool PluginManager::activate_audio_plugin(const std::string& name) {
     m_active.audio_handle = handle;
     m_config.set_selected_plugin(PluginType::Audio, name);
 
+    // Initialize the plugin with the audio host if available
+    if (m_audio_host) {
+        instance->initialize(m_audio_host);
+    }
+
     notify_plugin_changed(PluginType::Audio, name);
     std::cout << "Activated audio plugin: " << name << std::endl;
     return true;
@@ -610,6 +871,7 @@ bool PluginManager::deactivate_game_plugin_by_name(const std::string& name) {
     }
 
     // Destroy the plugin instance
+    m_game_host->remove_watches(it->plugin);
     if (it->plugin && it->handle) {
         using DestroyFunc = void (*)(IGamePlugin*);
         auto destroy = reinterpret_cast<DestroyFunc>(it->handle->destroy_func);
@@ -661,6 +923,7 @@ void PluginManager::deactivate_all_game_plugins() {
 
     // Destroy all game plugin instances
     for (auto& inst : m_active.game_plugins) {
+        m_game_host->remove_watches(inst.plugin);
         if (inst.plugin && inst.handle) {
             using DestroyFunc = void (*)(IGamePlugin*);
             auto destroy = reinterpret_cast<DestroyFunc>(inst.handle->destroy_func);
@@ -683,9 +946,13 @@ void PluginManager::initialize_game_plugins() {
 }
 
 void PluginManager::update_game_plugins() {
+    m_game_host->collect_write_hits();
+
     // Update all active game plugins (for timer updates and auto-split detection)
     for (auto& inst : m_active.game_plugins) {
         if (inst.plugin && inst.enabled) {
+            m_game_host->dispatch_write_hits(inst.plugin);
+            m_game_host->evaluate_watches(inst.plugin);
             inst.plugin->on_frame();
         }
     }
@@ -781,6 +1048,7 @@ void PluginManager::deactivate_plugin(PluginType type) {
             break;
         case PluginType::Audio:
             if (m_active.audio && m_active.audio_handle) {
+                m_active.audio->shutdown();
                 using DestroyFunc = void (*)(IAudioPlugin*);
                 auto destroy = reinterpret_cast<DestroyFunc>(m_active.audio_handle->destroy_func);
                 if (destroy) destroy(m_active.audio);
@@ -898,11 +1166,40 @@ bool PluginManager::set_active_plugin_for_file(const std::string& filepath) {
     return false;
 }
 
-bool PluginManager::load_rom(const std::string& path) {
+namespace {
+
+// A ROM file's pages, mapped for as long as any instance runs the ROM
+class MappedRomImage : public RomImage {
+public:
+    bool open(const std::string& path) {
+        if (!m_file.open(path) || m_file.size() == 0) return false;
+        m_data = m_file.data();
+        m_size = m_file.size();
+        return true;
+    }
+
+private:
+    MappedFile m_file;
+};
+
+// A battery save is written once the core has stopped writing save memory
+// for BATTERY_SAVE_QUIET, or after BATTERY_SAVE_MAX_DELAY for games that
+// never stop (some write SRAM every frame)
+constexpr std::chrono::milliseconds BATTERY_SAVE_QUIET{1000};
+constexpr std::chrono::milliseconds BATTERY_SAVE_MAX_DELAY{10000};
+
+} // namespace
+
+std::shared_ptr<const RomImage> PluginManager::read_rom_image(const std::string& path) {
+    auto mapped = std::make_shared<MappedRomImage>();
+    if (mapped->open(path)) {
+        return mapped;
+    }
+
     std::ifstream file(path, std::ios::binary | std::ios::ate);
     if (!file) {
         std::cerr << "Failed to open ROM file: " << path << std::endl;
-        return false;
+        return nullptr;
     }
 
     size_t size = file.tellg();
@@ -911,43 +1208,200 @@ bool PluginManager::load_rom(const std::string& path) {
     std::vector<uint8_t> data(size);
     if (!file.read(reinterpret_cast<char*>(data.data()), size)) {
         std::cerr << "Failed to read ROM file" << std::endl;
+        return nullptr;
+    }
+    return std::make_shared<const RomBuffer>(std::move(data));
+}
+
+void PluginManager::prefetch_rom(const std::string& path) {
+    m_prefetched_image = read_rom_image(path);
+    m_prefetched_path = m_prefetched_image ? path : std::string();
+    if (m_prefetched_image) {
+        m_rom_hasher.start(m_prefetched_image, path);
+    }
+}
+
+bool PluginManager::load_rom(const std::string& path) {
+    // A prefetched image is only good for one load; its hash is still
+    // running (or done) unless another ROM was hashed since
+    std::shared_ptr<const RomImage> image;
+    bool prefetched = false;
+    if (m_prefetched_image && m_prefetched_path == path) {
+        image = std::move(m_prefetched_image);
+        prefetched = m_rom_hasher.is_hashing() || !m_rom_hasher.get_sha1().empty();
+    } else {
+        image = read_rom_image(path);
+    }
+    m_prefetched_image.reset();
+    m_prefetched_path.clear();
+    if (!image) {
         return false;
     }
 
     // Store the ROM path for save file support
     m_current_rom_path = path;
 
-    bool result = load_rom(data.data(), data.size());
+    bool result = load_rom_image(std::move(image));
 
     // If ROM loaded successfully and has battery save, try to load it
     if (result) {
         load_battery_save();
+        // Whatever is in save memory now (the file's contents, or fresh RAM
+        // without one) needs no writing back
+        m_battery_written = m_active.emulator->get_battery_save_generation();
+        m_battery_seen = m_battery_written;
+        if (!prefetched) {
+            m_rom_hasher.start(m_rom_image, path);
+        }
+    } else if (prefetched) {
+        m_rom_hasher.cancel();
     }
 
     return result;
 }
 
 bool PluginManager::load_rom(const uint8_t* data, size_t size) {
+    bool result = load_rom_image(make_rom_image(data, size));
+    if (result) {
+        m_rom_hasher.start(m_rom_image, {});
+    }
+    return result;
+}
+
+bool PluginManager::load_rom_image(std::shared_ptr<const RomImage> image) {
     if (!m_active.emulator) {
         std::cerr << "No active emulator plugin" << std::endl;
         return false;
     }
 
-    bool result = m_active.emulator->load_rom(data, size);
+    bool result = m_active.emulator->load_rom_shared(image);
+    m_rom_image = result ? std::move(image) : nullptr;
 
     // If ROM loaded successfully, try to activate a game plugin for it
     if (result) {
-        uint32_t crc32 = m_active.emulator->get_rom_crc32();
-        activate_game_plugin_for_rom(crc32);
+        activate_game_plugins_for_rom();
+    }
+
+    return result;
+}
 
-        // Initialize game plugins with the host interface
-        initialize_game_plugins();
+void PluginManager::activate_game_plugins_for_rom() {
+    uint32_t crc32 = m_active.emulator->get_rom_crc32();
+    activate_game_plugin_for_rom(crc32);
 
-        // Notify game plugins about ROM load
-        notify_game_plugins_rom_loaded();
+    // Initialize game plugins with the host interface
+    initialize_game_plugins();
+
+    // Notify game plugins about ROM load
+    notify_game_plugins_rom_loaded();
+}
+
+void PluginManager::set_warm_rom_budget(size_t bytes) {
+    m_warm_rom_budget = bytes;
+    trim_warm_roms(m_warm_rom_budget);
+}
+
+bool PluginManager::park_active_rom() {
+    if (m_warm_rom_budget == 0 || !is_rom_loaded() || !m_active.emulator_handle) {
+        return false;
     }
 
-    return result;
+    // The core's own memory isn't exposed as such; its savestate is close
+    WarmRom rom;
+    std::vector<uint8_t> state;
+    rom.memory_bytes = m_rom_image ? m_rom_image->size() : 0;
+    if (m_active.emulator->save_state(state)) {
+        rom.memory_bytes += state.size();
+    }
+    if (rom.memory_bytes > m_warm_rom_budget) {
+        return false;
+    }
+
+    // Write the battery save now, so the file is current while the game
+    // sits parked (or if it's dropped from the pool)
+    save_battery_save();
+    notify_game_plugins_rom_unloaded();
+
+    rom.path = m_current_rom_path;
+    rom.core_name = m_config.get_selected_plugin(PluginType::Emulator);
+    rom.emulator = m_active.emulator;
+    rom.handle = m_active.emulator_handle;
+    rom.image = std::move(m_rom_image);
+    m_active.emulator = nullptr;
+    m_active.emulator_handle = nullptr;
+    m_current_rom_path.clear();
+    m_rom_image.reset();
+    m_rom_hasher.cancel();
+
+    std::cout << "Parked ROM: " << rom.path << std::endl;
+    m_warm_roms.push_back(std::move(rom));
+    trim_warm_roms(m_warm_rom_budget);
+    return true;
+}
+
+bool PluginManager::switch_to_warm_rom(const std::string& path) {
+    auto it = std::find_if(m_warm_roms.begin(), m_warm_roms.end(),
+        [&path](const WarmRom& rom) { return rom.path == path; });
+    if (it == m_warm_roms.end()) {
+        return false;
+    }
+    WarmRom rom = std::move(*it);
+    m_warm_roms.erase(it);
+
+    if (!park_active_rom()) {
+        unload_rom();
+        deactivate_plugin(PluginType::Emulator);
+    }
+
+    m_active.emulator = rom.emulator;
+    m_active.emulator_handle = rom.handle;
+    m_config.set_selected_plugin(PluginType::Emulator, rom.core_name);
+    build_legacy_plugin_list();
+    notify_plugin_changed(PluginType::Emulator, rom.core_name);
+
+    m_current_rom_path = path;
+    m_rom_image = std::move(rom.image);
+    m_battery_written = m_active.emulator->get_battery_save_generation();
+    m_battery_seen = m_battery_written;
+    m_rom_hasher.start(m_rom_image, path);  // From <rom>.sha1 after the first load
+    activate_game_plugins_for_rom();
+
+    std::cout << "Switched to warm ROM: " << path << std::endl;
+    return true;
+}
+
+void PluginManager::clear_warm_roms() {
+    for (WarmRom& rom : m_warm_roms) {
+        destroy_warm_rom(rom);
+    }
+    m_warm_roms.clear();
+}
+
+void PluginManager::destroy_warm_rom(WarmRom& rom) {
+    // Its battery save was written when it was parked, and the game can't
+    // have changed it since
+    using DestroyFunc = void (*)(IEmulatorPlugin*);
+    auto destroy = reinterpret_cast<DestroyFunc>(rom.handle->destroy_func);
+    rom.emulator->unload_rom();
+    if (destroy) destroy(rom.emulator);
+    rom.emulator = nullptr;
+}
+
+size_t PluginManager::get_warm_rom_memory() const {
+    size_t total = 0;
+    for (const WarmRom& rom : m_warm_roms) {
+        total += rom.memory_bytes;
+    }
+    return total;
+}
+
+void PluginManager::trim_warm_roms(size_t max_bytes) {
+    size_t total = get_warm_rom_memory();
+    while (!m_warm_roms.empty() && total > max_bytes) {
+        total -= m_warm_roms.front().memory_bytes;
+        destroy_warm_rom(m_warm_roms.front());
+        m_warm_roms.erase(m_warm_roms.begin());
+    }
 }
 
 void PluginManager::unload_rom() {
@@ -967,6 +1421,62 @@ void PluginManager::unload_rom() {
 
     // Clear the ROM path
     m_current_rom_path.clear();
+    // With no ROM loaded the hasher may be on a prefetched one
+    if (m_rom_image) {
+        m_rom_hasher.cancel();
+    }
+    m_rom_image.reset();
+}
+
+IEmulatorPlugin* PluginManager::create_emulator_clone() {
+    if (!m_rom_image) {
+        return nullptr;
+    }
+
+    IEmulatorPlugin* clone = create_emulator_instance();
+    if (!clone) {
+        return nullptr;
+    }
+
+    if (!clone->load_rom_shared(m_rom_image)) {
+        destroy_emulator_instance(clone);
+        return nullptr;
+    }
+    clone->set_video_enabled(false);
+    clone->set_audio_enabled(false);
+    return clone;
+}
+
+void PluginManager::destroy_emulator_clone(IEmulatorPlugin* clone) {
+    destroy_emulator_instance(clone);
+}
+
+IEmulatorPlugin* PluginManager::create_emulator_instance() {
+    PluginHandle* handle = m_active.emulator_handle;
+    if (!m_active.emulator || !handle || !handle->create_func || !handle->destroy_func) {
+        return nullptr;
+    }
+
+    using CreateFunc = IEmulatorPlugin* (*)();
+    auto create = reinterpret_cast<CreateFunc>(handle->create_func);
+    IEmulatorPlugin* instance = create();
+    if (!instance) {
+        return nullptr;
+    }
+    instance->set_video_enabled(false);
+    instance->set_audio_enabled(false);
+    return instance;
+}
+
+void PluginManager::destroy_emulator_instance(IEmulatorPlugin* instance) {
+    if (!instance || !m_active.emulator_handle) return;
+
+    using DestroyFunc = void (*)(IEmulatorPlugin*);
+    auto destroy = reinterpret_cast<DestroyFunc>(m_active.emulator_handle->destroy_func);
+    if (instance->is_rom_loaded()) {
+        instance->unload_rom();
+    }
+    destroy(instance);
 }
 
 bool PluginManager::is_rom_loaded() const {
@@ -1070,11 +1580,6 @@ bool PluginManager::save_battery_save() {
         return false;
     }
 
-    // Ensure directory exists
-    if (save_path.has_parent_path()) {
-        fs::create_directories(save_path.parent_path());
-    }
-
     // Get save data from emulator
     std::vector<uint8_t> data = m_active.emulator->get_battery_save_data();
     if (data.empty()) {
@@ -1082,20 +1587,49 @@ bool PluginManager::save_battery_save() {
         return false;
     }
 
-    // Write save file
-    std::ofstream file(save_path, std::ios::binary);
-    if (!file) {
-        std::cerr << "Failed to create save file: " << save_path << std::endl;
+    // Through the writer, so this lands after any background write still
+    // in flight rather than being overwritten by it
+    size_t size = data.size();
+    m_battery_written = m_active.emulator->get_battery_save_generation();
+    m_battery_seen = m_battery_written;
+    m_battery_writer.queue(save_path, std::move(data));
+    if (!m_battery_writer.flush()) {
         return false;
     }
 
-    if (!file.write(reinterpret_cast<const char*>(data.data()), data.size())) {
-        std::cerr << "Failed to write save file" << std::endl;
-        return false;
+    std::cout << "Saved battery data: " << save_path << " (" << size << " bytes)" << std::endl;
+    return true;
+}
+
+void PluginManager::update_battery_save() {
+    IEmulatorPlugin* emulator = m_active.emulator;
+    if (!emulator || !emulator->is_rom_loaded() || !emulator->has_battery_save()) {
+        return;
     }
 
-    std::cout << "Saved battery data: " << save_path << " (" << data.size() << " bytes)" << std::endl;
-    return true;
+    uint64_t generation = emulator->get_battery_save_generation();
+    if (generation == m_battery_written) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (generation != m_battery_seen) {
+        if (m_battery_seen == m_battery_written) {
+            m_battery_dirty_since = now;
+        }
+        m_battery_seen = generation;
+        m_battery_changed_at = now;
+    }
+    if (now - m_battery_changed_at < BATTERY_SAVE_QUIET && now - m_battery_dirty_since < BATTERY_SAVE_MAX_DELAY) {
+        return;
+    }
+
+    fs::path save_path = get_save_file_path();
+    m_battery_written = generation;
+    std::vector<uint8_t> data = emulator->get_battery_save_data();
+    if (!save_path.empty() && !data.empty()) {
+        m_battery_writer.queue(save_path, std::move(data));
+    }
 }
 
 } // namespace emu
@@ -10,6 +10,8 @@
 #include "emu/netplay_plugin.hpp"
 #include "plugin_registry.hpp"
 #include "plugin_config.hpp"
+#include "battery_save_writer.hpp"
+#include "rom_hasher.hpp"
 
 #include <string>
 #include <vector>
@@ -18,6 +20,7 @@
 #include <functional>
 #include <filesystem>
 #include <iostream>
+#include <chrono>
 
 namespace emu {
 
@@ -48,9 +51,9 @@ struct GamePluginInstance {
     bool visible = true;  // GUI panel visibility
 };
 
-// Emulator plugin instance with its handle (kept loaded for configuration)
+// Emulator plugin instance with its handle, for configuration
 struct EmulatorPluginInstance {
-    IEmulatorPlugin* plugin = nullptr;
+    IEmulatorPlugin* plugin = nullptr;  // Null until the core is first configured
     PluginHandle* handle = nullptr;
     std::string name;           // Name from registry (stable identifier)
     std::string library_path;   // Path to the .so file
@@ -94,12 +97,31 @@ public:
     uint16_t read_memory_16(uint16_t address) override;
     uint32_t read_memory_32(uint16_t address) override;
     void write_memory(uint16_t address, uint8_t value) override;
+    int find_memory_domain(const char* name) override;
+    bool read_memory_block(size_t domain, uint32_t address, size_t length, uint8_t* out) override;
+
+    // Watch subscriptions
+    bool set_watch_subscriptions(IGamePlugin* plugin, const WatchSubscription* watches, size_t count) override;
+
+    // Check plugin's watches against the frame just run, calling its
+    // on_watch_triggered() for those that fire
+    void evaluate_watches(IGamePlugin* plugin);
+
+    // Drop plugin's watches, before it's destroyed
+    void remove_watches(IGamePlugin* plugin);
+
+    // Write watchpoints. Hits are collected from the core once per update,
+    // then handed to each plugin watching their address.
+    bool set_write_watchpoints(IGamePlugin* plugin, const uint32_t* addresses, size_t count) override;
+    void collect_write_hits();
+    void dispatch_write_hits(IGamePlugin* plugin);
 
     // Emulator state
     bool is_emulator_running() const override;
     bool is_emulator_paused() const override;
     uint64_t get_frame_count() const override;
     double get_fps() const override;
+    bool is_lag_frame() const override;
 
     // ROM info
     const char* get_rom_name() const override;
@@ -125,6 +147,51 @@ public:
     void set_paused(bool paused) { m_paused = paused; }
 
 private:
+    // length bytes of the CPU bus from address, wrapping at 64KB
+    void read_bus(uint16_t address, uint8_t* out, size_t length);
+
+    // One plugin's watches. Watches near each other in a domain share a
+    // read, so a frame costs one read_memory_block() per range.
+    struct WatchRange {
+        uint32_t domain;
+        uint32_t address;
+        uint32_t length;
+        size_t offset;          // Into bytes
+        bool valid = false;     // Read succeeded this frame
+    };
+    struct WatchState {
+        WatchSubscription watch;
+        size_t range;           // Index into ranges
+        size_t offset;          // Of the value's bytes in bytes
+        uint32_t value = 0;     // As of the last frame
+        bool held = false;      // Level condition was true last frame
+    };
+    struct WatchSet {
+        IGamePlugin* plugin = nullptr;
+        std::vector<WatchState> watches;
+        std::vector<WatchRange> ranges;
+        std::vector<uint8_t> bytes;
+        bool primed = false;    // Values read at least once since the ROM loaded
+    };
+    std::vector<WatchSet> m_watch_sets;
+
+    struct FiredWatch {
+        size_t index;
+        uint32_t old_value;
+        uint32_t new_value;
+    };
+    std::vector<FiredWatch> m_fired_watches;  // Reused across frames
+
+    // Every plugin's write watchpoints, merged into the core's by
+    // apply_write_watchpoints()
+    struct WriteWatchSet {
+        IGamePlugin* plugin;
+        std::vector<uint32_t> addresses;    // Sorted
+    };
+    bool apply_write_watchpoints();
+    std::vector<WriteWatchSet> m_write_watch_sets;
+    std::vector<WriteWatchHit> m_write_hits;  // Since the last update
+
     PluginManager* m_plugin_manager;
     std::string m_rom_name;
     uint32_t m_rom_crc32 = 0;
@@ -215,11 +282,21 @@ public:
     // Get the name of the currently selected plugin for a type
     std::string get_selected_plugin_name(PluginType type) const;
 
-    // Get all loaded emulator plugins (for configuration UI)
+    // Get all emulator plugins (for configuration UI); their instances are
+    // created by get_emulator_plugin_by_name()
     const std::vector<EmulatorPluginInstance>& get_all_emulator_plugins() const { return m_emulator_plugins; }
 
-    // Get an emulator plugin by registry name (for configuration)
-    IEmulatorPlugin* get_emulator_plugin_by_name(const std::string& name) const;
+    // Get an emulator plugin by registry name (for configuration), loading
+    // the core the first time
+    IEmulatorPlugin* get_emulator_plugin_by_name(const std::string& name);
+
+    // Start loading the most recently used core's library in the background,
+    // so the first ROM load doesn't wait for it. No-op once a core is active.
+    void preload_emulator_plugin();
+
+    // Start loading the library of the core that would run this file. Needs
+    // the registry scanned (initialize()).
+    void preload_emulator_plugin_for_file(const std::string& filepath);
 
     // Callback registration
     void on_plugin_changed(PluginChangedCallback callback);
@@ -237,7 +314,64 @@ public:
     bool load_rom(const uint8_t* data, size_t size);
     void unload_rom();
     bool is_rom_loaded() const;
+    const std::string& get_current_rom_path() const { return m_current_rom_path; }
     uint32_t get_rom_crc32() const;
+    // The ROM's SHA-1 (lowercase hex), computed in the background after
+    // load; empty until it's ready
+    std::string get_rom_sha1() const { return m_rom_hasher.get_sha1(); }
+
+    // Second instance of the active emulator with the current ROM loaded and
+    // video/audio output disabled, for running frames off the main thread
+    // (netplay speculation). The clone shares the loaded ROM image. Returns
+    // nullptr if no ROM is loaded. Release with destroy_emulator_clone().
+    IEmulatorPlugin* create_emulator_clone();
+    void destroy_emulator_clone(IEmulatorPlugin* clone);
+
+    // Fresh instance of the active emulator from the already loaded library,
+    // with no ROM and video/audio output disabled. Instances are independent
+    // and may each run on their own thread. Release with
+    // destroy_emulator_instance().
+    IEmulatorPlugin* create_emulator_instance();
+    void destroy_emulator_instance(IEmulatorPlugin* instance);
+
+    // Warm ROM switching, for runs that go back and forth between games.
+    // With a budget set, park_active_rom() keeps the loaded ROM running in
+    // its core instance, paused, instead of it being unloaded, and
+    // switch_to_warm_rom() later makes it active again as it was left,
+    // without reading, hashing or booting it. The least recently parked
+    // ROMs are dropped once the parked cores' estimated memory (ROM plus
+    // savestate size) is over the budget. 0 (the default) keeps none.
+    void set_warm_rom_budget(size_t bytes);
+    size_t get_warm_rom_budget() const { return m_warm_rom_budget; }
+    size_t get_warm_rom_count() const { return m_warm_roms.size(); }
+
+    // Estimated memory of the parked ROMs, as counted against the budget
+    size_t get_warm_rom_memory() const;
+
+    // Drop the least recently parked ROMs until the rest fit max_bytes; the
+    // budget itself is unchanged
+    void trim_warm_roms(size_t max_bytes);
+
+    // Park the loaded ROM; afterwards no emulator is active. False (and the
+    // ROM left loaded) with no budget, no ROM, or a ROM too big for it.
+    bool park_active_rom();
+
+    // Make path's parked ROM active, parking or unloading the current one.
+    // False if path isn't parked.
+    bool switch_to_warm_rom(const std::string& path);
+
+    // Unload every parked ROM
+    void clear_warm_roms();
+
+    // Map a ROM file read-only as an image that can be shared by several
+    // instances (see IEmulatorPlugin::load_rom_shared), or read it if it
+    // can't be mapped. Returns nullptr on failure.
+    static std::shared_ptr<const RomImage> read_rom_image(const std::string& path);
+
+    // Read a ROM and start hashing it before a core is chosen, so that the
+    // next load_rom() of the same path picks both up. Safe to call before
+    // initialize().
+    void prefetch_rom(const std::string& path);
 
     // Set paths configuration (for battery save directory)
     void set_paths_config(PathsConfiguration* paths_config) { m_paths_config = paths_config; }
@@ -245,15 +379,25 @@ public:
     // Set netplay host (for initializing netplay plugins when they're activated)
     void set_netplay_host(INetplayHost* host) { m_netplay_host = host; }
 
+    // Set audio host (for initializing audio plugins when they're activated)
+    void set_audio_host(IAudioHost* host) { m_audio_host = host; }
+
     // Battery-backed save file support
     // These are called automatically by load_rom/unload_rom when appropriate
     bool load_battery_save();
     bool save_battery_save();
     std::filesystem::path get_save_file_path() const;
 
+    // Write the battery save in the background once the core's save memory
+    // has been left alone for a moment (or has kept changing for too long).
+    // Emulation thread, once per frame; does nothing for cores that don't
+    // report a save generation.
+    void update_battery_save();
+
 private:
-    // Load all emulator plugins (for configuration access)
-    void load_all_emulator_plugins();
+    // List the emulator plugins; cores are only loaded when a ROM or the
+    // configuration needs one
+    void register_emulator_plugins();
 
     // Activate a specific plugin
     bool activate_emulator_plugin(const std::string& name);
@@ -267,6 +411,11 @@ private:
     // Deactivate and cleanup a plugin
     void deactivate_plugin(PluginType type);
 
+    // Load a ROM image into the active emulator
+    bool load_rom_image(std::shared_ptr<const RomImage> image);
+    // Game plugin activation and notification for the ROM just made active
+    void activate_game_plugins_for_rom();
+
     // Build legacy plugin list for compatibility
     void build_legacy_plugin_list();
 
@@ -283,7 +432,7 @@ private:
     PluginConfiguration m_config;
     ActivePlugins m_active;
 
-    // All emulator plugins (kept loaded for configuration access)
+    // All emulator plugins, for configuration access
     std::vector<EmulatorPluginInstance> m_emulator_plugins;
 
     // Legacy support
@@ -295,6 +444,31 @@ private:
 
     // Current ROM path for save file support
     std::string m_current_rom_path;
+    std::shared_ptr<const RomImage> m_rom_image;  // The loaded ROM, shared with clones
+    RomHasher m_rom_hasher;
+    std::shared_ptr<const RomImage> m_prefetched_image;  // See prefetch_rom
+    std::string m_prefetched_path;
+
+    // A ROM kept loaded in its own core instance by park_active_rom()
+    struct WarmRom {
+        std::string path;
+        std::string core_name;
+        IEmulatorPlugin* emulator = nullptr;
+        PluginHandle* handle = nullptr;
+        std::shared_ptr<const RomImage> image;
+        size_t memory_bytes = 0;
+    };
+    void destroy_warm_rom(WarmRom& rom);
+
+    std::vector<WarmRom> m_warm_roms;  // Least recently parked first
+    size_t m_warm_rom_budget = 0;
+
+    // Battery save write-behind (see update_battery_save)
+    BatterySaveWriter m_battery_writer;
+    uint64_t m_battery_written = 0;     // Save generation last loaded or written
+    uint64_t m_battery_seen = 0;        // Save generation at the last check
+    std::chrono::steady_clock::time_point m_battery_dirty_since;
+    std::chrono::steady_clock::time_point m_battery_changed_at;
 
     // Paths configuration for save directories
     PathsConfiguration* m_paths_config = nullptr;
@@ -302,6 +476,9 @@ private:
     // Netplay host (for initializing netplay plugins)
     INetplayHost* m_netplay_host = nullptr;
 
+    // Audio host (for initializing audio plugins)
+    IAudioHost* m_audio_host = nullptr;
+
     // Guard against double-shutdown
     bool m_shutdown_called = false;
 
@@ -7,8 +7,13 @@
 #include "emu/game_plugin.hpp"
 #include "emu/netplay_plugin.hpp"
 
+#include <nlohmann/json.hpp>
+
 #include <iostream>
+#include <fstream>
 #include <algorithm>
+#include <atomic>
+#include <thread>
 
 #ifdef _WIN32
     #include <windows.h>
@@ -377,10 +382,24 @@ bool PluginRegistry::scan_directory(const std::filesystem::path& directory) {
         m_plugin_directories.push_back(directory);
     }
 
+    if (!m_probe_cache_loaded) {
+        load_probe_cache();
+    }
+
     const char* lib_ext = get_library_extension();
     int found_count = 0;
 
-    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
+    // Libraries not yet registered, with their cached probe if it's current
+    struct Candidate {
+        std::filesystem::path path;
+        ProbeCacheEntry probe;
+        bool cached = false;
+    };
+    std::vector<Candidate> candidates;
+    std::vector<size_t> to_probe;
+
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, ec)) {
         if (!entry.is_regular_file()) continue;
 
         const auto& path = entry.path();
@@ -396,20 +415,150 @@ bool PluginRegistry::scan_directory(const std::filesystem::path& directory) {
         }
         if (already_registered) continue;
 
-        // Probe the plugin
-        PluginMetadata metadata;
-        if (probe_plugin(path, metadata)) {
-            m_plugins.push_back(std::move(metadata));
-            ++found_count;
-            std::cout << "Found " << plugin_type_to_string(m_plugins.back().type)
-                      << " plugin: " << m_plugins.back().name
-                      << " (" << path.filename() << ")" << std::endl;
+        Candidate candidate;
+        candidate.path = path;
+        candidate.probe.mtime = static_cast<int64_t>(entry.last_write_time(ec).time_since_epoch().count());
+        candidate.probe.size = static_cast<uint64_t>(entry.file_size(ec));
+
+        auto cached = m_probe_cache.find(path.string());
+        if (cached != m_probe_cache.end() && cached->second.mtime == candidate.probe.mtime &&
+            cached->second.size == candidate.probe.size) {
+            candidate.probe = cached->second;
+            candidate.probe.metadata.path = path;
+            candidate.cached = true;
+        } else {
+            to_probe.push_back(candidates.size());
+        }
+        candidates.push_back(std::move(candidate));
+    }
+
+    // Probe the rest in parallel; loading a library is mostly the loader
+    // mapping and relocating it, which runs fine on several threads
+    if (!to_probe.empty()) {
+        size_t thread_count = std::min<size_t>(to_probe.size(),
+                                               std::max(1u, std::thread::hardware_concurrency()));
+        std::atomic<size_t> next{0};
+        auto worker = [&]() {
+            for (size_t i = next++; i < to_probe.size(); i = next++) {
+                Candidate& candidate = candidates[to_probe[i]];
+                candidate.probe.valid = probe_plugin(candidate.path, candidate.probe.metadata);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < thread_count; i++) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        for (size_t index : to_probe) {
+            if (candidates[index].probe.valid) {
+                m_probe_cache[candidates[index].path.string()] = candidates[index].probe;
+                m_probe_cache_dirty = true;
+            }
         }
     }
 
+    // Register in directory order, whichever way each was probed
+    for (auto& candidate : candidates) {
+        if (!candidate.probe.valid) continue;
+
+        m_plugins.push_back(std::move(candidate.probe.metadata));
+        ++found_count;
+        std::cout << "Found " << plugin_type_to_string(m_plugins.back().type)
+                  << " plugin: " << m_plugins.back().name
+                  << " (" << candidate.path.filename() << ")"
+                  << (candidate.cached ? " [cached]" : "") << std::endl;
+    }
+
     return found_count > 0;
 }
 
+void PluginRegistry::set_probe_cache_path(const std::filesystem::path& path) {
+    m_probe_cache_path = path;
+    m_probe_cache.clear();
+    m_probe_cache_loaded = false;
+    m_probe_cache_dirty = false;
+}
+
+void PluginRegistry::load_probe_cache() {
+    m_probe_cache_loaded = true;
+    if (m_probe_cache_path.empty() || !std::filesystem::exists(m_probe_cache_path)) return;
+
+    // A damaged or outdated cache only costs a full probe
+    try {
+        std::ifstream file(m_probe_cache_path);
+        nlohmann::json json;
+        file >> json;
+        if (json.value("version", 0) != 1 || !json.contains("plugins")) return;
+
+        for (const auto& item : json["plugins"]) {
+            ProbeCacheEntry entry;
+            entry.mtime = item.at("mtime").get<int64_t>();
+            entry.size = item.at("size").get<uint64_t>();
+            entry.valid = true;
+            PluginMetadata& metadata = entry.metadata;
+            metadata.type = static_cast<PluginType>(item.at("type").get<int>());
+            metadata.name = item.at("name").get<std::string>();
+            metadata.version = item.value("version", "");
+            metadata.author = item.value("author", "");
+            metadata.description = item.value("description", "");
+            metadata.api_version = item.value("api_version", 0u);
+            metadata.capabilities = item.value("capabilities", 0u);
+            metadata.file_extensions = item.value("file_extensions", std::vector<std::string>{});
+            metadata.supported_roms = item.value("supported_roms", std::vector<uint32_t>{});
+            m_probe_cache[item.at("path").get<std::string>()] = std::move(entry);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Ignoring plugin cache " << m_probe_cache_path << ": " << e.what() << std::endl;
+        m_probe_cache.clear();
+    }
+}
+
+void PluginRegistry::save_probe_cache() {
+    if (m_probe_cache_path.empty() || !m_probe_cache_dirty) return;
+
+    nlohmann::json plugins = nlohmann::json::array();
+    for (const auto& [path, entry] : m_probe_cache) {
+        // Libraries since deleted would only pile up
+        std::error_code ec;
+        if (!std::filesystem::exists(path, ec)) continue;
+
+        nlohmann::json item;
+        item["path"] = path;
+        item["mtime"] = entry.mtime;
+        item["size"] = entry.size;
+        const PluginMetadata& metadata = entry.metadata;
+        item["type"] = static_cast<int>(metadata.type);
+        item["name"] = metadata.name;
+        item["version"] = metadata.version;
+        item["author"] = metadata.author;
+        item["description"] = metadata.description;
+        item["api_version"] = metadata.api_version;
+        item["capabilities"] = metadata.capabilities;
+        item["file_extensions"] = metadata.file_extensions;
+        item["supported_roms"] = metadata.supported_roms;
+        plugins.push_back(std::move(item));
+    }
+
+    nlohmann::json json;
+    json["version"] = 1;
+    json["plugins"] = std::move(plugins);
+
+    std::error_code ec;
+    std::filesystem::create_directories(m_probe_cache_path.parent_path(), ec);
+    std::ofstream file(m_probe_cache_path);
+    if (!file) {
+        std::cerr << "Failed to write plugin cache " << m_probe_cache_path << std::endl;
+        return;
+    }
+    file << json.dump(2);
+    m_probe_cache_dirty = false;
+}
+
 std::vector<PluginMetadata> PluginRegistry::get_plugins_of_type(PluginType type) const {
     std::vector<PluginMetadata> result;
     for (const auto& plugin : m_plugins) {
@@ -475,6 +624,11 @@ std::vector<PluginMetadata> PluginRegistry::find_game_plugins_for_rom(uint32_t c
 }
 
 PluginHandle* PluginRegistry::load_plugin(const PluginMetadata& metadata) {
+    // Other libraries can load alongside a preload
+    if (m_preload_thread.joinable() && metadata.path == m_preload_path) {
+        join_preload();
+    }
+
     // Check if already loaded
     for (auto& handle_ptr : m_loaded_plugins) {
         if (handle_ptr->path == metadata.path) {
@@ -555,6 +709,26 @@ void PluginRegistry::unload_all() {
         unload_library(handle_ptr->library_handle);
     }
     m_loaded_plugins.clear();
+
+    join_preload();
+    unload_library(m_preload_handle);
+    m_preload_handle = nullptr;
+    m_preload_path.clear();
+}
+
+void PluginRegistry::preload_library(const std::filesystem::path& path) {
+    if (m_preload_thread.joinable() || m_preload_handle || find_loaded_plugin(path)) return;
+
+    m_preload_path = path;
+    m_preload_thread = std::thread([this, path]() {
+        m_preload_handle = load_library(path);
+    });
+}
+
+void PluginRegistry::join_preload() {
+    if (m_preload_thread.joinable()) {
+        m_preload_thread.join();
+    }
 }
 
 PluginHandle* PluginRegistry::find_loaded_plugin(const std::filesystem::path& path) {
@@ -574,6 +748,7 @@ void PluginRegistry::refresh() {
     for (const auto& dir : m_plugin_directories) {
         scan_directory(dir);
     }
+    save_probe_cache();
 }
 
 void PluginRegistry::add_plugin_directory(const std::filesystem::path& directory) {
@@ -7,6 +7,7 @@
 #include <unordered_map>
 #include <filesystem>
 #include <functional>
+#include <thread>
 
 namespace emu {
 
@@ -37,6 +38,13 @@ public:
     // Can be called multiple times for different directories
     bool scan_directory(const std::filesystem::path& directory);
 
+    // Probe results are cached in this file, keyed by each library's path,
+    // modification time and size, so unchanged libraries aren't loaded
+    // again just to be probed. Read on the next scan; save_probe_cache()
+    // writes it back if a scan probed anything.
+    void set_probe_cache_path(const std::filesystem::path& path);
+    void save_probe_cache();
+
     // Get all discovered plugins
     const std::vector<PluginMetadata>& get_all_plugins() const { return m_plugins; }
 
@@ -61,6 +69,10 @@ public:
     // Unload all plugins
     void unload_all();
 
+    // Load a library on a background thread and keep it until unload_all(),
+    // so a later load_plugin() of it only has to look up its symbols
+    void preload_library(const std::filesystem::path& path);
+
     // Get loaded plugin handles
     std::vector<PluginHandle*> get_loaded_plugins() const {
         std::vector<PluginHandle*> result;
@@ -84,9 +96,23 @@ public:
     void add_plugin_directory(const std::filesystem::path& directory);
 
 private:
-    // Probe a library file to check if it's a valid plugin
+    // Probe a library file to check if it's a valid plugin. Touches no
+    // registry state, so libraries can be probed on several threads.
     bool probe_plugin(const std::filesystem::path& path, PluginMetadata& metadata);
 
+    // Probe result for one library. Only plugins are cached: a library that
+    // failed may just be missing a dependency that gets installed later.
+    struct ProbeCacheEntry {
+        int64_t mtime = 0;
+        uint64_t size = 0;
+        bool valid = false;
+        PluginMetadata metadata{};
+    };
+    void load_probe_cache();
+
+    // Wait for preload_library() to finish
+    void join_preload();
+
     // Load library and get function pointer
     void* load_library(const std::filesystem::path& path);
     void unload_library(void* handle);
@@ -98,6 +124,15 @@ private:
     std::vector<PluginMetadata> m_plugins;
     std::vector<std::unique_ptr<PluginHandle>> m_loaded_plugins;  // Use unique_ptr for stable pointers
     std::vector<std::filesystem::path> m_plugin_directories;
+
+    std::filesystem::path m_probe_cache_path;
+    std::unordered_map<std::string, ProbeCacheEntry> m_probe_cache;  // By path
+    bool m_probe_cache_loaded = false;
+    bool m_probe_cache_dirty = false;
+
+    std::thread m_preload_thread;
+    std::filesystem::path m_preload_path;
+    void* m_preload_handle = nullptr;   // Set by m_preload_thread
 };
 
 } // namespace emu
@@ -0,0 +1,297 @@
+#include "ram_recorder.hpp"
+#include "emu/emulator_plugin.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace emu {
+
+namespace {
+
+// Run count marking a column stored as raw deltas
+constexpr uint8_t RAW_COLUMN = 0xFF;
+
+// Bytes a coded column takes, from its two header bytes
+size_t column_size(const uint8_t* column, size_t frames) {
+    uint8_t runs = column[1];
+    if (runs == RAW_COLUMN) return 2 + (frames - 1);
+    return 2 + 2 * static_cast<size_t>(runs);
+}
+
+} // namespace
+
+bool RamRecorder::start(IEmulatorPlugin& plugin, size_t domain, const std::vector<uint32_t>& addresses,
+                        size_t memory_budget) {
+    stop();
+    m_blocks.clear();
+    m_stored_bytes = 0;
+    m_frame_count = 0;
+
+    std::vector<MemoryDomain> domains = plugin.get_memory_domains();
+    if (domain >= domains.size()) return false;
+    uint32_t domain_size = domains[domain].size;
+
+    m_addresses = addresses;
+    if (m_addresses.empty()) {
+        if (domain_size > MAX_COLUMNS) return false;
+        for (uint32_t address = 0; address < domain_size; address++) {
+            m_addresses.push_back(address);
+        }
+    }
+    std::sort(m_addresses.begin(), m_addresses.end());
+    m_addresses.erase(std::unique(m_addresses.begin(), m_addresses.end()), m_addresses.end());
+    if (m_addresses.empty() || m_addresses.size() > MAX_COLUMNS || m_addresses.back() >= domain_size) {
+        m_addresses.clear();
+        return false;
+    }
+
+    // One read per frame covers every column
+    m_read_first = m_addresses.front();
+    m_read_length = m_addresses.back() - m_read_first + 1;
+    m_read.resize(m_read_length);
+    if (!plugin.read_memory_block(domain, m_read_first, m_read_length, m_read.data())) {
+        m_addresses.clear();
+        return false;
+    }
+
+    m_domain = domain;
+    m_budget = memory_budget;
+    m_pending.clear();
+    m_pending.reserve(BLOCK_FRAMES * m_addresses.size());
+    m_pending_frames = 0;
+    m_active = true;
+    return true;
+}
+
+void RamRecorder::stop() {
+    if (m_active && m_pending_frames > 0) {
+        store_pending();
+    }
+    m_active = false;
+}
+
+void RamRecorder::on_frame(IEmulatorPlugin& plugin) {
+    if (!m_active) return;
+
+    uint64_t frame = plugin.get_frame_count();
+    if (m_pending_frames > 0 && frame != m_pending_first + m_pending_frames) {
+        store_pending();
+    }
+
+    if (!plugin.read_memory_block(m_domain, m_read_first, m_read_length, m_read.data())) {
+        stop();
+        return;
+    }
+    if (m_pending_frames == 0) {
+        m_pending_first = frame;
+    }
+    for (uint32_t address : m_addresses) {
+        m_pending.push_back(m_read[address - m_read_first]);
+    }
+    m_pending_frames++;
+    m_frame_count++;
+
+    if (m_pending_frames == BLOCK_FRAMES) {
+        store_pending();
+    }
+}
+
+void RamRecorder::store_pending() {
+    const size_t columns = m_addresses.size();
+    const size_t frames = m_pending_frames;
+    m_coded.clear();
+
+    for (size_t column = 0; column < columns; column++) {
+        const uint8_t* value = m_pending.data() + column;
+        size_t header = m_coded.size();
+        m_coded.push_back(value[0]);
+        m_coded.push_back(0);
+
+        // Runs of equal deltas, given up for raw deltas once they'd be as big
+        size_t runs = 0;
+        bool all_zero = true;
+        size_t limit = (frames - 1) / 2;
+        size_t frame = 1;
+        while (frame < frames && runs <= limit) {
+            uint8_t delta = static_cast<uint8_t>(value[frame * columns] - value[(frame - 1) * columns]);
+            size_t length = 1;
+            while (frame + length < frames &&
+                   static_cast<uint8_t>(value[(frame + length) * columns] -
+                                        value[(frame + length - 1) * columns]) == delta) {
+                length++;
+            }
+            all_zero = all_zero && delta == 0;
+            m_coded.push_back(static_cast<uint8_t>(length - 1));
+            m_coded.push_back(delta);
+            runs++;
+            frame += length;
+        }
+
+        if (all_zero && frame >= frames) {
+            m_coded.resize(header + 2);  // runs 0: the value never changes
+        } else if (runs <= limit) {
+            m_coded[header + 1] = static_cast<uint8_t>(runs);
+        } else {
+            m_coded.resize(header + 2);
+            m_coded[header + 1] = RAW_COLUMN;
+            for (size_t i = 1; i < frames; i++) {
+                m_coded.push_back(static_cast<uint8_t>(value[i * columns] - value[(i - 1) * columns]));
+            }
+        }
+    }
+
+    Block block;
+    block.first_frame = m_pending_first;
+    block.frames = frames;
+    block.data.assign(m_coded.begin(), m_coded.end());
+    m_stored_bytes += block.data.size();
+    m_blocks.push_back(std::move(block));
+
+    m_pending.clear();
+    m_pending_frames = 0;
+    drop_oldest_blocks(m_budget);
+}
+
+void RamRecorder::trim(size_t max_bytes) {
+    drop_oldest_blocks(max_bytes);
+}
+
+void RamRecorder::drop_oldest_blocks(size_t max_bytes) {
+    while (m_stored_bytes > max_bytes && m_blocks.size() > 1) {
+        m_stored_bytes -= m_blocks.front().data.size();
+        m_frame_count -= m_blocks.front().frames;
+        m_blocks.pop_front();
+    }
+}
+
+void RamRecorder::decode_column(const Block& block, size_t column, uint8_t* out) const {
+    const uint8_t* coded = block.data.data();
+    for (size_t i = 0; i < column; i++) {
+        coded += column_size(coded, block.frames);
+    }
+
+    uint8_t value = coded[0];
+    uint8_t runs = coded[1];
+    const uint8_t* payload = coded + 2;
+    out[0] = value;
+    if (runs == RAW_COLUMN) {
+        for (size_t frame = 1; frame < block.frames; frame++) {
+            value = static_cast<uint8_t>(value + payload[frame - 1]);
+            out[frame] = value;
+        }
+    } else if (runs == 0) {
+        std::fill(out + 1, out + block.frames, value);
+    } else {
+        size_t frame = 1;
+        for (uint8_t run = 0; run < runs; run++) {
+            size_t length = payload[run * 2] + 1u;
+            uint8_t delta = payload[run * 2 + 1];
+            for (size_t i = 0; i < length && frame < block.frames; i++) {
+                value = static_cast<uint8_t>(value + delta);
+                out[frame++] = value;
+            }
+        }
+    }
+}
+
+void RamRecorder::decode_block(const Block& block, std::vector<uint8_t>& rows) const {
+    const size_t columns = m_addresses.size();
+    std::vector<uint8_t> values(block.frames);
+    rows.resize(block.frames * columns);
+    for (size_t column = 0; column < columns; column++) {
+        decode_column(block, column, values.data());
+        for (size_t frame = 0; frame < block.frames; frame++) {
+            rows[frame * columns + column] = values[frame];
+        }
+    }
+}
+
+size_t RamRecorder::find_column(uint32_t address) const {
+    auto it = std::lower_bound(m_addresses.begin(), m_addresses.end(), address);
+    if (it == m_addresses.end() || *it != address) return SIZE_MAX;
+    return static_cast<size_t>(it - m_addresses.begin());
+}
+
+uint64_t RamRecorder::get_first_frame() const {
+    if (!m_blocks.empty()) return m_blocks.front().first_frame;
+    return m_pending_first;
+}
+
+uint64_t RamRecorder::get_last_frame() const {
+    if (m_pending_frames > 0) return m_pending_first + m_pending_frames - 1;
+    if (!m_blocks.empty()) return m_blocks.back().first_frame + m_blocks.back().frames - 1;
+    return 0;
+}
+
+size_t RamRecorder::read_column(size_t column, uint64_t first, size_t count, uint8_t* out) const {
+    if (column >= m_addresses.size()) return 0;
+
+    // Later blocks win where frame numbers repeat, as after a state load
+    size_t found = 0;
+    std::vector<uint8_t> values;
+    auto copy_range = [&](uint64_t block_first, size_t frames, const uint8_t* source, size_t stride) {
+        uint64_t from = std::max(block_first, first);
+        uint64_t to = std::min(block_first + frames, first + count);
+        for (uint64_t frame = from; frame < to; frame++) {
+            out[frame - first] = source[(frame - block_first) * stride];
+            found++;
+        }
+    };
+
+    for (const Block& block : m_blocks) {
+        if (block.first_frame >= first + count || block.first_frame + block.frames <= first) continue;
+        values.resize(block.frames);
+        decode_column(block, column, values.data());
+        copy_range(block.first_frame, block.frames, values.data(), 1);
+    }
+    if (m_pending_frames > 0) {
+        copy_range(m_pending_first, m_pending_frames, m_pending.data() + column, m_addresses.size());
+    }
+    return found;
+}
+
+bool RamRecorder::export_csv(const std::string& path, const char* domain_name, std::string& error) const {
+    std::ofstream out(path);
+    if (!out) {
+        error = "can't write " + path;
+        return false;
+    }
+
+    char text[32];
+    out << "frame";
+    for (uint32_t address : m_addresses) {
+        std::snprintf(text, sizeof(text), ",%s:%X", domain_name, address);
+        out << text;
+    }
+    out << '\n';
+
+    const size_t columns = m_addresses.size();
+    auto write_rows = [&](uint64_t first_frame, size_t frames, const uint8_t* rows) {
+        std::string line;
+        for (size_t frame = 0; frame < frames; frame++) {
+            line = std::to_string(first_frame + frame);
+            for (size_t column = 0; column < columns; column++) {
+                line += ',';
+                line += std::to_string(rows[frame * columns + column]);
+            }
+            line += '\n';
+            out << line;
+        }
+    };
+
+    std::vector<uint8_t> rows;
+    for (const Block& block : m_blocks) {
+        decode_block(block, rows);
+        write_rows(block.first_frame, block.frames, rows.data());
+    }
+    write_rows(m_pending_first, m_pending_frames, m_pending.data());
+
+    if (!out) {
+        error = "failed writing " + path;
+        return false;
+    }
+    return true;
+}
+
+} // namespace emu
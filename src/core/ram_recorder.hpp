@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace emu {
+
+class IEmulatorPlugin;
+
+// Every frame's value of chosen RAM bytes, for graphs and route analysis
+//
+// A recording covers one memory domain: either all of it (small domains
+// such as NES work RAM) or a list of addresses in it. Each column is one
+// byte. Frames are gathered row by row into a block of up to BLOCK_FRAMES,
+// then the block is stored column by column: a column keeps its first
+// value and the deltas to each following frame, run-length coded, or the
+// raw deltas when runs wouldn't be smaller. Bytes that never change cost
+// two bytes per block and counters barely more, so hours of play fit in a
+// few megabytes. The oldest blocks are dropped once the memory budget is
+// used up.
+//
+// A block covers consecutive frame numbers; when the core's frame count
+// jumps (a state load, a reset, rewinding) the block is closed early and
+// the next one starts at the new frame.
+class RamRecorder {
+public:
+    static constexpr size_t BLOCK_FRAMES = 256;
+
+    // Most columns a recording can have
+    static constexpr size_t MAX_COLUMNS = 16384;
+
+    // Record addresses of domain, or every byte of it when addresses is
+    // empty; false if the domain is too big or can't be read
+    bool start(IEmulatorPlugin& plugin, size_t domain, const std::vector<uint32_t>& addresses,
+               size_t memory_budget = 64 * 1024 * 1024);
+
+    // Stop recording; what was recorded stays readable until start()
+    void stop();
+
+    bool is_active() const { return m_active; }
+
+    // After each emulated frame; reads the columns from the core
+    void on_frame(IEmulatorPlugin& plugin);
+
+    size_t get_domain() const { return m_domain; }
+    size_t get_column_count() const { return m_addresses.size(); }
+    uint32_t get_column_address(size_t column) const { return m_addresses[column]; }
+
+    // Column recording address, or SIZE_MAX
+    size_t find_column(uint32_t address) const;
+
+    // Frame numbers held, oldest to newest; gaps are frames never recorded
+    uint64_t get_first_frame() const;
+    uint64_t get_last_frame() const;
+    size_t get_frame_count() const { return m_frame_count; }
+
+    // Values of column for frames first to first + count - 1 into out; frames
+    // not recorded are left as they are. Returns how many were found.
+    size_t read_column(size_t column, uint64_t first, size_t count, uint8_t* out) const;
+
+    // Bytes held by the stored blocks and the frames not yet stored
+    size_t get_memory_used() const { return m_stored_bytes + m_pending.size(); }
+
+    // Drop the oldest blocks until at most max_bytes are stored; the
+    // budget is unchanged
+    void trim(size_t max_bytes);
+
+    // Every recorded frame as "frame,<address>,..." rows; false and error set
+    // on failure
+    bool export_csv(const std::string& path, const char* domain_name, std::string& error) const;
+
+private:
+    struct Block {
+        uint64_t first_frame;
+        size_t frames;
+        std::vector<uint8_t> data;   // Coded columns, in column order
+    };
+
+    // Code the pending rows into a new block
+    void store_pending();
+
+    // Drop the oldest blocks until the stored ones fit in max_bytes
+    void drop_oldest_blocks(size_t max_bytes);
+
+    // Decode every column of block into rows (frames * columns bytes)
+    void decode_block(const Block& block, std::vector<uint8_t>& rows) const;
+
+    // Decode column of block into out[0..block.frames)
+    void decode_column(const Block& block, size_t column, uint8_t* out) const;
+
+    bool m_active = false;
+    size_t m_domain = 0;
+    std::vector<uint32_t> m_addresses;
+    uint32_t m_read_first = 0;       // Span read from the domain each frame
+    uint32_t m_read_length = 0;
+    std::vector<uint8_t> m_read;
+    size_t m_budget = 0;
+
+    std::deque<Block> m_blocks;
+    size_t m_stored_bytes = 0;
+    size_t m_frame_count = 0;
+
+    std::vector<uint8_t> m_pending;  // Rows not yet stored, a frame each
+    size_t m_pending_frames = 0;
+    uint64_t m_pending_first = 0;
+    std::vector<uint8_t> m_coded;    // Scratch for store_pending()
+};
+
+} // namespace emu
@@ -8,6 +8,46 @@
 
 namespace emu {
 
+// Buffer object and sync entry points, which SDL_opengl.h only declares for
+// GL 1.x; loaded through SDL once the context exists
+struct PixelBufferFunctions {
+    PFNGLGENBUFFERSPROC GenBuffers = nullptr;
+    PFNGLDELETEBUFFERSPROC DeleteBuffers = nullptr;
+    PFNGLBINDBUFFERPROC BindBuffer = nullptr;
+    PFNGLBUFFERDATAPROC BufferData = nullptr;
+    PFNGLMAPBUFFERRANGEPROC MapBufferRange = nullptr;
+    PFNGLUNMAPBUFFERPROC UnmapBuffer = nullptr;
+    PFNGLFENCESYNCPROC FenceSync = nullptr;
+    PFNGLCLIENTWAITSYNCPROC ClientWaitSync = nullptr;
+    PFNGLDELETESYNCPROC DeleteSync = nullptr;
+    PFNGLBUFFERSTORAGEPROC BufferStorage = nullptr;  // ARB_buffer_storage only
+};
+
+namespace {
+
+template <typename T>
+void load_gl_function(T& function, const char* name) {
+    function = reinterpret_cast<T>(SDL_GL_GetProcAddress(name));
+}
+
+// Cheap 64-bit hash of a frame, to spot repeats
+uint64_t hash_pixels(const uint32_t* pixels, size_t count) {
+    uint64_t hash = 0x9E3779B97F4A7C15ull ^ count;
+    size_t i = 0;
+    for (; i + 1 < count; i += 2) {
+        uint64_t word;
+        std::memcpy(&word, pixels + i, sizeof(word));
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 32;
+    }
+    if (i < count) {
+        hash = (hash ^ pixels[i]) * 0xFF51AFD7ED558CCDull;
+    }
+    return hash ^ (hash >> 29);
+}
+
+} // namespace
+
 Renderer::Renderer() = default;
 
 Renderer::~Renderer() {
@@ -22,19 +62,23 @@ bool Renderer::initialize(WindowManager& window_manager) {
         return false;
     }
 
+    init_pixel_buffers();
+
+    // Without shaders the frame is still shown as uploaded
+    m_shaders.initialize();
+
     std::cout << "Renderer initialized" << std::endl;
     return true;
 }
 
 void Renderer::shutdown() {
+    destroy_pixel_buffers();
+    m_shaders.shutdown();
+    m_shader_output = 0;
     if (m_texture_id) {
         glDeleteTextures(1, &m_texture_id);
         m_texture_id = 0;
     }
-    // VAO, VBO, and shaders are not used - ImGui handles all rendering
-    m_vao = 0;
-    m_vbo = 0;
-    m_shader_program = 0;
 }
 
 bool Renderer::create_texture(int width, int height) {
@@ -59,12 +103,93 @@ bool Renderer::create_texture(int width, int height) {
 
     m_texture_width = width;
     m_texture_height = height;
+    m_texture_valid = false;
 
     glBindTexture(GL_TEXTURE_2D, 0);
 
     return true;
 }
 
+void Renderer::init_pixel_buffers() {
+    m_gl = std::make_unique<PixelBufferFunctions>();
+    PixelBufferFunctions& gl = *m_gl;
+    load_gl_function(gl.GenBuffers, "glGenBuffers");
+    load_gl_function(gl.DeleteBuffers, "glDeleteBuffers");
+    load_gl_function(gl.BindBuffer, "glBindBuffer");
+    load_gl_function(gl.BufferData, "glBufferData");
+    load_gl_function(gl.MapBufferRange, "glMapBufferRange");
+    load_gl_function(gl.UnmapBuffer, "glUnmapBuffer");
+    load_gl_function(gl.FenceSync, "glFenceSync");
+    load_gl_function(gl.ClientWaitSync, "glClientWaitSync");
+    load_gl_function(gl.DeleteSync, "glDeleteSync");
+    if (SDL_GL_ExtensionSupported("GL_ARB_buffer_storage")) {
+        load_gl_function(gl.BufferStorage, "glBufferStorage");
+    }
+
+    bool buffers = gl.GenBuffers && gl.DeleteBuffers && gl.BindBuffer && gl.MapBufferRange && gl.UnmapBuffer;
+    bool sync = gl.FenceSync && gl.ClientWaitSync && gl.DeleteSync;
+    if (buffers && sync && gl.BufferStorage) {
+        m_upload_path = UploadPath::Persistent;
+    } else if (buffers && gl.BufferData) {
+        m_upload_path = UploadPath::Streaming;
+    } else {
+        m_upload_path = UploadPath::Direct;
+    }
+}
+
+bool Renderer::create_pixel_buffers(size_t frame_bytes) {
+    destroy_pixel_buffers();
+    PixelBufferFunctions& gl = *m_gl;
+
+    gl.GenBuffers(1, &m_pbo);
+    gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo);
+    if (m_upload_path == UploadPath::Persistent) {
+        // Write-only, coherent: the CPU writes land without explicit flushes,
+        // and fences keep it off a region the GPU may still be reading
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLsizeiptr size = static_cast<GLsizeiptr>(frame_bytes * PBO_RING_SIZE);
+        gl.BufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+        m_pbo_mapped = static_cast<uint8_t*>(gl.MapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags));
+        if (!m_pbo_mapped) {
+            // Mapping failed; stream through the same kind of buffer instead
+            gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            gl.DeleteBuffers(1, &m_pbo);
+            m_pbo = 0;
+            std::cerr << "Renderer: persistent pixel buffer mapping failed, streaming uploads instead" << std::endl;
+            m_upload_path = gl.BufferData ? UploadPath::Streaming : UploadPath::Direct;
+            return m_upload_path == UploadPath::Streaming && create_pixel_buffers(frame_bytes);
+        }
+    } else {
+        gl.BufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(frame_bytes), nullptr, GL_STREAM_DRAW);
+    }
+    gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    m_pbo_frame_bytes = frame_bytes;
+    m_pbo_index = 0;
+    return true;
+}
+
+void Renderer::destroy_pixel_buffers() {
+    if (!m_gl) return;
+    PixelBufferFunctions& gl = *m_gl;
+
+    for (void*& fence : m_pbo_fences) {
+        if (fence) gl.DeleteSync(static_cast<GLsync>(fence));
+        fence = nullptr;
+    }
+    if (m_pbo) {
+        if (m_pbo_mapped) {
+            gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo);
+            gl.UnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            m_pbo_mapped = nullptr;
+        }
+        gl.DeleteBuffers(1, &m_pbo);
+        m_pbo = 0;
+    }
+    m_pbo_frame_bytes = 0;
+}
+
 void Renderer::update_texture(const uint32_t* pixels, int width, int height) {
     if (!pixels) return;
 
@@ -73,11 +198,90 @@ void Renderer::update_texture(const uint32_t* pixels, int width, int height) {
         create_texture(width, height);
     }
 
-    // Upload pixel data
+    size_t count = static_cast<size_t>(width) * static_cast<size_t>(height);
+    uint64_t hash = hash_pixels(pixels, count);
+    if (m_texture_valid && hash == m_last_frame_hash) {
+        // A repeated frame still moves shaders that blend in earlier ones
+        if (m_shaders.has_feedback()) {
+            apply_shader(true);
+        }
+        return;
+    }
+
+    size_t bytes = count * sizeof(uint32_t);
+    if (m_upload_path != UploadPath::Direct && m_pbo_frame_bytes != bytes && !create_pixel_buffers(bytes)) {
+        m_upload_path = UploadPath::Direct;
+    }
+
     glBindTexture(GL_TEXTURE_2D, m_texture_id);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height,
-                    GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    if (m_upload_path == UploadPath::Direct) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height,
+                        GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    } else {
+        PixelBufferFunctions& gl = *m_gl;
+        size_t offset = 0;
+        gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo);
+
+        if (m_upload_path == UploadPath::Persistent) {
+            // The region was last read PBO_RING_SIZE uploads ago, so its
+            // fence has almost always signalled already
+            void*& fence = m_pbo_fences[m_pbo_index];
+            if (fence) {
+                gl.ClientWaitSync(static_cast<GLsync>(fence), GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+                gl.DeleteSync(static_cast<GLsync>(fence));
+                fence = nullptr;
+            }
+            offset = static_cast<size_t>(m_pbo_index) * m_pbo_frame_bytes;
+            std::memcpy(m_pbo_mapped + offset, pixels, bytes);
+        } else {
+            // Orphan the old storage so mapping never waits on the last upload
+            gl.BufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_STREAM_DRAW);
+            void* dest = gl.MapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes),
+                                           GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            if (dest) {
+                std::memcpy(dest, pixels, bytes);
+                gl.UnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            } else {
+                // Mapping failed; upload this frame and later ones directly
+                gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                m_upload_path = UploadPath::Direct;
+            }
+        }
+
+        // With a buffer bound, the data argument is an offset into it
+        const void* source = m_upload_path == UploadPath::Direct ? static_cast<const void*>(pixels)
+                                                                 : reinterpret_cast<const void*>(offset);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, source);
+        gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        if (m_upload_path == UploadPath::Persistent) {
+            m_pbo_fences[m_pbo_index] = gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            m_pbo_index = (m_pbo_index + 1) % PBO_RING_SIZE;
+        }
+    }
     glBindTexture(GL_TEXTURE_2D, 0);
+
+    m_last_frame_hash = hash;
+    m_texture_valid = true;
+    apply_shader(true);
+}
+
+void Renderer::set_active_shader(int index) {
+    m_shaders.set_active_shader(index);
+    apply_shader(false);
+}
+
+void Renderer::set_shader_parameter(int shader_index, int param_index, float value) {
+    m_shaders.set_shader_parameter(shader_index, param_index, value);
+    if (shader_index == m_shaders.get_active_shader()) {
+        apply_shader(false);
+    }
+}
+
+void Renderer::apply_shader(bool new_frame) {
+    m_shader_output = m_texture_valid
+        ? m_shaders.apply(m_texture_id, m_texture_width, m_texture_height, new_frame)
+        : 0;
 }
 
 void Renderer::render_game_texture(int x, int y, int width, int height) {
@@ -1,10 +1,15 @@
 #pragma once
 
+#include "shader_chain.hpp"
+
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 
 namespace emu {
 
 class WindowManager;
+struct PixelBufferFunctions;
 
 // Handles OpenGL rendering of the game framebuffer
 class Renderer {
@@ -23,6 +28,9 @@ public:
     void shutdown();
 
     // Upload framebuffer data to GPU texture
+    // Goes through pixel buffer objects where the driver has them, so the
+    // call returns without waiting for the GPU to finish with the texture,
+    // and is skipped when the frame is identical to the last one uploaded
     void update_texture(const uint32_t* pixels, int width, int height);
 
     // Render the game texture (called by GUI)
@@ -31,22 +39,69 @@ public:
     // Clear the screen
     void clear(float r = 0.1f, float g = 0.1f, float b = 0.1f);
 
-    // Get texture ID for ImGui rendering
-    uint32_t get_texture_id() const { return m_texture_id; }
+    // Get texture ID for ImGui rendering: the active shader's output, or
+    // the frame as uploaded. The size is always the frame's.
+    uint32_t get_texture_id() const { return m_shader_output ? m_shader_output : m_texture_id; }
     int get_texture_width() const { return m_texture_width; }
     int get_texture_height() const { return m_texture_height; }
 
+    // The frame's size on screen: hi-res (over 320 wide) and interlaced
+    // (over 300 lines) frames cover the same area as the usual ones, so
+    // they're halved here and the GPU scales them down with the rest
+    int get_display_width() const { return m_texture_width > 320 ? m_texture_width / 2 : m_texture_width; }
+    int get_display_height() const { return m_texture_height > 300 ? m_texture_height / 2 : m_texture_height; }
+
+    // Built-in shaders (see ShaderChain), run once per new frame and again
+    // whenever the choice or a parameter changes
+    int get_shader_count() const { return m_shaders.get_shader_count(); }
+    ShaderInfo get_shader_info(int index) const { return m_shaders.get_shader_info(index); }
+    int get_active_shader() const { return m_shaders.get_active_shader(); }
+    void set_active_shader(int index);
+
+    int get_shader_parameter_count(int shader_index) const {
+        return m_shaders.get_shader_parameter_count(shader_index);
+    }
+    ShaderParameter get_shader_parameter(int shader_index, int param_index) const {
+        return m_shaders.get_shader_parameter(shader_index, param_index);
+    }
+    void set_shader_parameter(int shader_index, int param_index, float value);
+
 private:
+    // How frames reach the texture
+    enum class UploadPath {
+        Direct,         // glTexSubImage2D from client memory
+        Streaming,      // One PBO, orphaned and mapped per frame (GL 3.0)
+        Persistent      // Ring of regions in one persistently mapped PBO (ARB_buffer_storage)
+    };
+
     bool create_texture(int width, int height);
-    bool compile_shaders();
+    void apply_shader(bool new_frame);
+
+    void init_pixel_buffers();
+    bool create_pixel_buffers(size_t frame_bytes);
+    void destroy_pixel_buffers();
 
     WindowManager* m_window_manager = nullptr;
     uint32_t m_texture_id = 0;
     int m_texture_width = 0;
     int m_texture_height = 0;
-    uint32_t m_shader_program = 0;
-    uint32_t m_vao = 0;
-    uint32_t m_vbo = 0;
+
+    ShaderChain m_shaders;
+    uint32_t m_shader_output = 0;               // 0 with no shader active
+
+    // Pixel buffer upload
+    static constexpr int PBO_RING_SIZE = 3;
+    std::unique_ptr<PixelBufferFunctions> m_gl;  // Loaded buffer/sync entry points
+    UploadPath m_upload_path = UploadPath::Direct;
+    uint32_t m_pbo = 0;
+    size_t m_pbo_frame_bytes = 0;                // Size of one frame (one ring region)
+    uint8_t* m_pbo_mapped = nullptr;             // Persistent mapping of the whole ring
+    void* m_pbo_fences[PBO_RING_SIZE] = {};      // GLsync per region, set when its upload is queued
+    int m_pbo_index = 0;
+
+    // Skip uploading frames that didn't change (paused, static screens)
+    uint64_t m_last_frame_hash = 0;
+    bool m_texture_valid = false;
 };
 
 } // namespace emu
@@ -0,0 +1,316 @@
+#include "rewind_buffer.hpp"
+
+#include "emu/netplay_plugin.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace emu {
+
+namespace {
+
+// Captures kept at most, whatever the budget; at one capture per frame
+// this is about 18 minutes of history
+constexpr size_t MAX_ENTRIES = 65536;
+
+// Changed spans reserved for; more than any core reports
+constexpr size_t MAX_SPANS = 4096;
+
+// Delta layout: the target size (u32), then runs of (u16 unchanged bytes,
+// u16 changed bytes, the changed bytes XORed with the source). A run of
+// unchanged bytes shorter than a run header isn't worth ending a literal
+// for. Bytes past the end of the source count as zero.
+constexpr size_t DELTA_HEADER = sizeof(uint32_t);
+constexpr size_t RUN_HEADER = 2 * sizeof(uint16_t);
+constexpr size_t MAX_RUN = 0xFFFF;
+constexpr size_t MIN_SKIP = RUN_HEADER;
+
+void put_run(uint8_t*& out, size_t skip, size_t literal) {
+    uint16_t header[2] = {static_cast<uint16_t>(skip), static_cast<uint16_t>(literal)};
+    std::memcpy(out, header, RUN_HEADER);
+    out += RUN_HEADER;
+}
+
+} // namespace
+
+void RewindBuffer::configure(size_t max_state_size, const RewindOptions& options) {
+    m_options = options;
+    m_options.interval = std::max(options.interval, 1);
+    m_max_state_size = max_state_size;
+
+    m_arena.assign(options.memory_budget, 0);
+    m_entries.assign(MAX_ENTRIES, Entry{0, 0});
+    m_current.assign(max_state_size, 0);
+    m_scratch.assign(max_state_size, 0);
+    m_delta.assign(max_delta_size(max_state_size), 0);
+    m_spans.reserve(MAX_SPANS);
+    clear();
+}
+
+void RewindBuffer::release() {
+    m_arena = {};
+    m_entries = {};
+    m_current = {};
+    m_scratch = {};
+    m_delta = {};
+    m_spans = {};
+    m_max_state_size = 0;
+    clear();
+}
+
+void RewindBuffer::clear() {
+    m_first = 0;
+    m_count = 0;
+    m_used_bytes = 0;
+    m_current_size = 0;
+    m_frames_until_capture = 0;
+    m_mark = 0;
+}
+
+void RewindBuffer::shrink(size_t memory_budget) {
+    if (!is_configured() || memory_budget >= m_arena.size()) return;
+    if (memory_budget == 0) {
+        release();
+        return;
+    }
+
+    size_t keep = 0;
+    size_t bytes = 0;
+    while (keep < m_count && bytes + entry(m_count - 1 - keep).size <= memory_budget) {
+        bytes += entry(m_count - 1 - keep).size;
+        keep++;
+    }
+
+    // Oldest first from the start of the new arena, so the next capture
+    // goes right after the newest
+    std::vector<uint8_t> arena(memory_budget, 0);
+    size_t offset = 0;
+    for (size_t i = m_count - keep; i < m_count; i++) {
+        Entry& kept = entry(i);
+        std::memcpy(arena.data() + offset, m_arena.data() + kept.offset, kept.size);
+        kept.offset = offset;
+        offset += kept.size;
+    }
+    m_first = (m_first + m_count - keep) % m_entries.size();
+    m_count = keep;
+    m_used_bytes = bytes;
+    m_arena = std::move(arena);
+    m_options.memory_budget = memory_budget;
+}
+
+void RewindBuffer::on_frame(INetplayCapable& core) {
+    if (!is_configured()) return;
+    if (m_frames_until_capture > 0) {
+        m_frames_until_capture--;
+        return;
+    }
+    m_frames_until_capture = m_options.interval - 1;
+
+    uint64_t mark = core.mark_state_capture();
+    size_t size = core.save_state_fast(m_scratch.data(), m_scratch.size());
+    if (size == 0) {
+        m_mark = 0;
+        return;
+    }
+
+    if (m_current_size > 0) {
+        // Cores that track writes say where the two captures can differ
+        bool partial = m_mark && size == m_current_size && core.get_changed_state_spans(m_mark, m_spans);
+        size_t delta_size = encode_delta(m_scratch.data(), size, m_current.data(), m_current_size,
+                                         partial ? &m_spans : nullptr, m_delta.data());
+        if (delta_size <= m_arena.size()) {
+            size_t offset = allocate(delta_size);
+            std::memcpy(m_arena.data() + offset, m_delta.data(), delta_size);
+            entry(m_count) = Entry{offset, delta_size};
+            m_count++;
+            m_used_bytes += delta_size;
+        } else {
+            // A budget smaller than one delta; nothing to chain to
+            m_first = 0;
+            m_count = 0;
+            m_used_bytes = 0;
+        }
+    }
+
+    std::swap(m_current, m_scratch);
+    m_current_size = size;
+    m_mark = mark;
+}
+
+bool RewindBuffer::step_back(INetplayCapable& core) {
+    if (m_current_size == 0) return false;
+
+    if (m_count == 0) {
+        m_mark = core.load_state_fast(m_current.data(), m_current_size) ? core.mark_state_capture() : 0;
+        return false;
+    }
+
+    const Entry& newest = entry(m_count - 1);
+    size_t size = apply_delta(m_current.data(), m_current_size, m_arena.data() + newest.offset, newest.size,
+                              m_scratch.data(), m_scratch.size());
+    m_used_bytes -= newest.size;
+    m_count--;
+    if (size == 0) {
+        clear();
+        return false;
+    }
+
+    std::swap(m_current, m_scratch);
+    m_current_size = size;
+    m_frames_until_capture = m_options.interval - 1;
+
+    // The core now holds m_current, so it is the base for the next delta
+    bool loaded = core.load_state_fast(m_current.data(), m_current_size);
+    m_mark = loaded ? core.mark_state_capture() : 0;
+    return loaded;
+}
+
+size_t RewindBuffer::get_used_bytes() const {
+    return m_used_bytes + m_current_size;
+}
+
+size_t RewindBuffer::encode_delta(const uint8_t* source, size_t source_size,
+                                  const uint8_t* target, size_t target_size,
+                                  const std::vector<StateSpan>* spans, uint8_t* out) {
+    const uint8_t* start = out;
+    uint32_t header = static_cast<uint32_t>(target_size);
+    std::memcpy(out, &header, DELTA_HEADER);
+    out += DELTA_HEADER;
+
+    const size_t common = std::min(source_size, target_size);
+    auto unchanged = [&](size_t i) { return target[i] == (i < common ? source[i] : 0); };
+
+    // Without spans the whole target is looked at
+    const StateSpan whole{0, target_size};
+    const StateSpan* span = spans ? spans->data() : &whole;
+    const StateSpan* spans_end = spans ? span + spans->size() : &whole + 1;
+
+    size_t skip_start = 0;  // Unchanged bytes from here on aren't written out yet
+    for (; span != spans_end; ++span) {
+        // Spans closer than a run header are taken together, which keeps
+        // the delta within max_delta_size()
+        size_t pos = std::min(span->offset, target_size);
+        size_t span_end = span->offset + span->size;
+        while (span + 1 != spans_end && span[1].offset < span_end + MIN_SKIP) {
+            ++span;
+            span_end = std::max(span_end, span->offset + span->size);
+        }
+        const size_t end = std::min(span_end, target_size);
+        const size_t compare_end = std::min(common, end);
+        while (pos < end) {
+            // Unchanged bytes, eight at a time where both states have them
+            while (pos + 8 <= compare_end) {
+                uint64_t a, b;
+                std::memcpy(&a, source + pos, 8);
+                std::memcpy(&b, target + pos, 8);
+                if (a != b) break;
+                pos += 8;
+            }
+            while (pos < end && unchanged(pos)) pos++;
+            if (pos == end) break;
+            size_t skip = pos - skip_start;
+
+            // Changed bytes, up to the next run of unchanged ones long
+            // enough to be worth a header, or the end of the span
+            size_t literal_start = pos;
+            while (pos < end) {
+                if (!unchanged(pos)) {
+                    pos++;
+                    continue;
+                }
+                size_t run = 1;
+                while (run < MIN_SKIP && pos + run < end && unchanged(pos + run)) run++;
+                if (run >= MIN_SKIP || pos + run == end) break;
+                pos += run;
+            }
+
+            while (skip > MAX_RUN) {
+                put_run(out, MAX_RUN, 0);
+                skip -= MAX_RUN;
+            }
+            for (size_t i = literal_start; i < pos;) {
+                size_t literal = std::min(pos - i, MAX_RUN);
+                put_run(out, skip, literal);
+                for (size_t j = 0; j < literal; j++, i++) {
+                    *out++ = target[i] ^ (i < common ? source[i] : 0);
+                }
+                skip = 0;
+            }
+            skip_start = pos;
+        }
+    }
+    // The rest is the source's
+    return static_cast<size_t>(out - start);
+}
+
+size_t RewindBuffer::apply_delta(const uint8_t* source, size_t source_size,
+                                 const uint8_t* delta, size_t delta_size,
+                                 uint8_t* out, size_t out_size) {
+    if (delta_size < DELTA_HEADER) return 0;
+    uint32_t target_size;
+    std::memcpy(&target_size, delta, DELTA_HEADER);
+    if (target_size == 0 || target_size > out_size) return 0;
+
+    // Start from the source, zero-extended, and flip the changed bytes
+    size_t copied = std::min<size_t>(source_size, target_size);
+    std::memcpy(out, source, copied);
+    std::memset(out + copied, 0, target_size - copied);
+
+    size_t in = DELTA_HEADER;
+    size_t pos = 0;
+    while (in < delta_size) {
+        if (delta_size - in < RUN_HEADER) return 0;
+        uint16_t header[2];
+        std::memcpy(header, delta + in, RUN_HEADER);
+        in += RUN_HEADER;
+
+        pos += header[0];
+        size_t literal = header[1];
+        if (pos + literal > target_size || delta_size - in < literal) return 0;
+        for (size_t i = 0; i < literal; i++) {
+            out[pos + i] ^= delta[in + i];
+        }
+        pos += literal;
+        in += literal;
+    }
+    return target_size;
+}
+
+size_t RewindBuffer::max_delta_size(size_t state_size) {
+    // Every run but the first skips at least MIN_SKIP bytes, which pays for
+    // its header; what's left are runs split at MAX_RUN
+    return DELTA_HEADER + state_size + RUN_HEADER * 2 * (state_size / MAX_RUN + 2);
+}
+
+size_t RewindBuffer::allocate(size_t size) {
+    auto drop_oldest = [this] {
+        m_used_bytes -= entry(0).size;
+        m_first = (m_first + 1) % m_entries.size();
+        m_count--;
+    };
+
+    size_t offset = 0;
+    if (m_count > 0) {
+        const Entry& newest = entry(m_count - 1);
+        offset = newest.offset + newest.size;
+    }
+
+    // No room before the end of the arena: drop what's stored past the
+    // newest entry (the oldest ones) and continue from the start
+    if (offset + size > m_arena.size()) {
+        while (m_count > 0 && entry(0).offset >= offset) drop_oldest();
+        offset = 0;
+    }
+
+    // The oldest entries are the ones just ahead of the write position
+    while (m_count > 0) {
+        const Entry& oldest = entry(0);
+        bool overlaps = oldest.offset < offset + size && offset < oldest.offset + oldest.size;
+        if (!overlaps && m_count < m_entries.size()) break;
+        drop_oldest();
+    }
+    return offset;
+}
+
+} // namespace emu
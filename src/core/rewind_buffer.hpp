@@ -0,0 +1,103 @@
+#pragma once
+
+#include "emu/netplay_plugin.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace emu {
+
+struct RewindOptions {
+    size_t memory_budget = 64 * 1024 * 1024;  // Bytes of history, per core
+    int interval = 1;                         // Frames between captures
+};
+
+// History of recent states for rewinding
+//
+// Every interval frames the core's state is captured with save_state_fast()
+// and the newest capture is kept whole. What's stored per capture is a
+// backward delta that turns it into the one before: the two states XORed,
+// then run-length coded, so the bytes a frame didn't change cost almost
+// nothing. Cores that track their writes (get_changed_state_spans()) narrow
+// the comparison down to the pages written since the previous capture.
+// Deltas go into one arena allocated up front, and the oldest are dropped
+// once the budget is used up; after configure() nothing allocates.
+// Stepping back applies the newest delta to the current capture and loads
+// the result with load_state_fast().
+class RewindBuffer {
+public:
+    // Allocate for states of up to max_state_size bytes; drops any history
+    void configure(size_t max_state_size, const RewindOptions& options);
+
+    // Free everything; configure() again before use
+    void release();
+
+    // Drop the history but keep the memory
+    void clear();
+
+    // Move to a smaller arena of memory_budget bytes, keeping the newest
+    // captures that fit; no-op if it isn't smaller
+    void shrink(size_t memory_budget);
+
+    bool is_configured() const { return !m_arena.empty(); }
+
+    // After each emulated frame; captures every interval frames
+    void on_frame(INetplayCapable& core);
+
+    // Load the previous capture into the core; false when the history is
+    // used up (the oldest capture is loaded again in that case)
+    bool step_back(INetplayCapable& core);
+
+    size_t get_capture_count() const { return m_count + (m_current_size > 0 ? 1 : 0); }
+    size_t get_used_bytes() const;
+    size_t get_budget() const { return m_arena.size(); }
+    int get_interval() const { return m_options.interval; }
+
+private:
+    struct Entry {
+        size_t offset;
+        size_t size;
+    };
+
+    // Delta that rebuilds target from source, written to out (which must
+    // hold max_delta_size(target_size) bytes); returns its size. With
+    // spans, the bytes outside them are known to be the same.
+    static size_t encode_delta(const uint8_t* source, size_t source_size,
+                               const uint8_t* target, size_t target_size,
+                               const std::vector<StateSpan>* spans, uint8_t* out);
+
+    // Rebuild the target into out (at least max_state_size bytes); returns
+    // its size, or 0 if the delta is malformed
+    static size_t apply_delta(const uint8_t* source, size_t source_size,
+                              const uint8_t* delta, size_t delta_size,
+                              uint8_t* out, size_t out_size);
+
+    static size_t max_delta_size(size_t state_size);
+
+    // Make room for size bytes after the newest entry, dropping the oldest
+    // entries in the way; returns the offset
+    size_t allocate(size_t size);
+
+    Entry& entry(size_t index) { return m_entries[(m_first + index) % m_entries.size()]; }
+
+    RewindOptions m_options;
+    size_t m_max_state_size = 0;
+
+    std::vector<uint8_t> m_arena;
+    std::vector<Entry> m_entries;   // Ring, oldest first
+    size_t m_first = 0;
+    size_t m_count = 0;
+    size_t m_used_bytes = 0;        // Sum of the entries' sizes
+
+    std::vector<uint8_t> m_current; // Newest capture, whole
+    size_t m_current_size = 0;
+    std::vector<uint8_t> m_scratch; // Next capture, or the state being rebuilt
+    std::vector<uint8_t> m_delta;   // Delta being encoded
+    uint64_t m_mark = 0;            // Core's capture mark for m_current, 0 = none
+    std::vector<StateSpan> m_spans;
+
+    int m_frames_until_capture = 0;
+};
+
+} // namespace emu
@@ -0,0 +1,208 @@
+#include "rom_hasher.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+namespace emu {
+
+namespace {
+
+// How much is hashed between looks at the cancel flag
+constexpr size_t CANCEL_CHECK_BYTES = 1u << 20;
+
+uint32_t rotl(uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+class Sha1 {
+public:
+    void update(const uint8_t* data, size_t size) {
+        m_length += size;
+        if (m_buffered > 0) {
+            size_t take = std::min(size, sizeof(m_buffer) - m_buffered);
+            std::memcpy(m_buffer + m_buffered, data, take);
+            m_buffered += take;
+            data += take;
+            size -= take;
+            if (m_buffered < sizeof(m_buffer)) return;
+            block(m_buffer);
+            m_buffered = 0;
+        }
+        for (; size >= 64; data += 64, size -= 64) {
+            block(data);
+        }
+        std::memcpy(m_buffer, data, size);
+        m_buffered = size;
+    }
+
+    std::string finish() {
+        uint64_t bits = m_length * 8;
+        uint8_t pad[72] = {0x80};
+        size_t pad_size = (m_buffered < 56 ? 56 : 120) - m_buffered;
+        for (int i = 0; i < 8; i++) {
+            pad[pad_size + i] = static_cast<uint8_t>(bits >> (56 - i * 8));
+        }
+        update(pad, pad_size + 8);
+
+        static const char HEX[] = "0123456789abcdef";
+        std::string out;
+        for (uint32_t word : m_state) {
+            for (int shift = 28; shift >= 0; shift -= 4) {
+                out += HEX[(word >> shift) & 0xF];
+            }
+        }
+        return out;
+    }
+
+private:
+    void block(const uint8_t* data) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (uint32_t(data[i * 4]) << 24) | (uint32_t(data[i * 4 + 1]) << 16) |
+                   (uint32_t(data[i * 4 + 2]) << 8) | uint32_t(data[i * 4 + 3]);
+        }
+        for (int i = 16; i < 80; i++) {
+            w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3], e = m_state[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t t = rotl(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotl(b, 30);
+            b = a;
+            a = t;
+        }
+        m_state[0] += a;
+        m_state[1] += b;
+        m_state[2] += c;
+        m_state[3] += d;
+        m_state[4] += e;
+    }
+
+    uint32_t m_state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    uint8_t m_buffer[64];
+    size_t m_buffered = 0;
+    uint64_t m_length = 0;
+};
+
+// What the cache entry is keyed on; changes whenever the ROM file does
+struct FileKey {
+    uintmax_t size = 0;
+    long long mtime = 0;
+};
+
+bool get_file_key(const std::filesystem::path& path, FileKey& key) {
+    std::error_code ec;
+    key.size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) return false;
+    key.mtime = static_cast<long long>(mtime.time_since_epoch().count());
+    return true;
+}
+
+std::filesystem::path cache_path(const std::filesystem::path& rom_path) {
+    std::filesystem::path path = rom_path;
+    path += ".sha1";
+    return path;
+}
+
+// The cache holds one line: "<size> <mtime> <sha1>"
+bool read_cache(const std::filesystem::path& rom_path, const FileKey& key, std::string& sha1) {
+    std::ifstream file(cache_path(rom_path));
+    uintmax_t size = 0;
+    long long mtime = 0;
+    std::string hex;
+    if (!(file >> size >> mtime >> hex)) return false;
+    if (size != key.size || mtime != key.mtime || hex.size() != 40) return false;
+    sha1 = hex;
+    return true;
+}
+
+void write_cache(const std::filesystem::path& rom_path, const FileKey& key, const std::string& sha1) {
+    // Best effort: a read-only ROM folder just means hashing again next time
+    std::ofstream file(cache_path(rom_path), std::ios::trunc);
+    if (file) {
+        file << key.size << ' ' << key.mtime << ' ' << sha1 << '\n';
+    }
+}
+
+} // namespace
+
+RomHasher::~RomHasher() {
+    cancel();
+}
+
+void RomHasher::start(std::shared_ptr<const RomImage> image, const std::filesystem::path& path) {
+    cancel();
+    if (!image) return;
+
+    m_cancel.store(false, std::memory_order_release);
+    m_hashing.store(true, std::memory_order_release);
+    m_worker = std::thread(&RomHasher::hash_rom, this, std::move(image), path);
+}
+
+void RomHasher::cancel() {
+    m_cancel.store(true, std::memory_order_release);
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+    m_hashing.store(false, std::memory_order_release);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_sha1.clear();
+}
+
+std::string RomHasher::get_sha1() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_sha1;
+}
+
+void RomHasher::hash_rom(std::shared_ptr<const RomImage> image, std::filesystem::path path) {
+    FileKey key;
+    bool cacheable = !path.empty() && get_file_key(path, key) && key.size == image->size();
+
+    std::string sha1;
+    if (!cacheable || !read_cache(path, key, sha1)) {
+        Sha1 hash;
+        const uint8_t* data = image->data();
+        for (size_t left = image->size(); left > 0;) {
+            if (m_cancel.load(std::memory_order_acquire)) return;
+            size_t chunk = std::min(left, CANCEL_CHECK_BYTES);
+            hash.update(data, chunk);
+            data += chunk;
+            left -= chunk;
+        }
+        sha1 = hash.finish();
+        if (cacheable) {
+            write_cache(path, key, sha1);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_sha1 = sha1;
+    }
+    m_hashing.store(false, std::memory_order_release);
+}
+
+} // namespace emu
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "emu/rom_image.hpp"
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace emu {
+
+// Computes the loaded ROM's SHA-1 on a background thread
+//
+// The CRC32 the cores compute at load is enough to pick game plugins and
+// check savestates, but movies and ROM verification want a real hash, and
+// over a 32 MB GBA ROM that takes long enough to notice. start() returns
+// at once; get_sha1() is empty until the hash is ready. The result is
+// cached next to the ROM in "<rom>.sha1", keyed by the file's size and
+// modification time, so loading the same ROM again costs nothing.
+class RomHasher {
+public:
+    RomHasher() = default;
+    ~RomHasher();
+
+    RomHasher(const RomHasher&) = delete;
+    RomHasher& operator=(const RomHasher&) = delete;
+
+    // Hash image, which was read from path (empty for a ROM loaded from
+    // memory, which is hashed but not cached). Cancels any hash running.
+    void start(std::shared_ptr<const RomImage> image, const std::filesystem::path& path);
+
+    // Forget the current ROM, stopping its hash if it's still running
+    void cancel();
+
+    // Lowercase hex SHA-1, or empty while hashing or with no ROM
+    std::string get_sha1() const;
+    bool is_hashing() const { return m_hashing.load(std::memory_order_acquire); }
+
+private:
+    void hash_rom(std::shared_ptr<const RomImage> image, std::filesystem::path path);
+
+    std::thread m_worker;
+    std::atomic<bool> m_cancel{false};
+    std::atomic<bool> m_hashing{false};
+    mutable std::mutex m_mutex;
+    std::string m_sha1;     // Guarded by m_mutex
+};
+
+} // namespace emu
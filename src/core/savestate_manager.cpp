@@ -2,6 +2,9 @@
 #include "plugin_manager.hpp"
 #include "paths_config.hpp"
 #include "emu/emulator_plugin.hpp"
+#include "emu/netplay_plugin.hpp"
+#include "mapped_file.hpp"
+#include "state_codec.hpp"
 
 #include <fstream>
 #include <filesystem>
@@ -15,18 +18,51 @@ namespace emu {
 // Version history:
 // 1 - Initial format
 // 2 - Added complete PPU NMI state, sprite state, CPU m_nmi_delayed flag
+// 3 - SavestateStorage follows the header; the state may be LZ-compressed
+// 4 - SavestateThumbnailHeader and the thumbnail follow the state
 struct SavestateHeader {
     char magic[4] = {'V', 'E', 'L', 'O'};  // "VELO" - Veloce Savestate
-    uint32_t version = 2;
+    uint32_t version = 4;
     uint32_t rom_crc32 = 0;
     uint64_t frame_count = 0;
     int64_t timestamp = 0;
-    uint32_t data_size = 0;
+    uint32_t data_size = 0;                // Uncompressed state size
     char rom_name[256] = {0};
 };
 
-SavestateManager::SavestateManager() = default;
-SavestateManager::~SavestateManager() = default;
+// How the state is stored (version 3 on)
+struct SavestateStorage {
+    uint32_t compression = 0;              // SavestateCompression
+    uint32_t stored_size = 0;              // Bytes of state data in the file
+};
+
+// The thumbnail (version 4 on); 0x0 when the save had no frame
+struct SavestateThumbnailHeader {
+    uint16_t width = 0;
+    uint16_t height = 0;
+    uint32_t compression = 0;              // SavestateCompression
+    uint32_t stored_size = 0;              // Bytes of pixels in the file
+};
+
+enum SavestateCompression : uint32_t {
+    SAVESTATE_RAW = 0,
+    SAVESTATE_LZ = 1                       // lz_compress() from the netplay codec
+};
+
+SavestateManager::SavestateManager() {
+    m_io_thread = std::thread(&SavestateManager::io_loop, this);
+}
+
+SavestateManager::~SavestateManager() {
+    {
+        std::lock_guard<std::mutex> lock(m_io_mutex);
+        m_io_stopping = true;
+    }
+    m_io_wake.notify_all();
+    if (m_io_thread.joinable()) {
+        m_io_thread.join();
+    }
+}
 
 void SavestateManager::initialize(PluginManager* plugin_manager, PathsConfiguration* paths_config) {
     m_plugin_manager = plugin_manager;
@@ -55,33 +91,73 @@ bool SavestateManager::save_state(int slot) {
         return false;
     }
 
-    // Serialize emulator state
-    std::vector<uint8_t> data;
-    if (!plugin->save_state(data)) {
-        std::cerr << "Failed to serialize emulator state" << std::endl;
+    // Serialize into the slot's buffer, so loading it back needs no disk
+    SlotBuffer* buffer = get_slot_buffer(slot, plugin->get_rom_crc32());
+    if (!capture_state(buffer->data, buffer->info)) {
+        buffer->loaded = false;
         return false;
     }
+    buffer->loaded = true;
+    const SavestateInfo& info = buffer->info;
+    size_t size = buffer->data.size();
+
+    // The slot shows the new state right away; the file follows
+    IoJob job;
+    job.kind = IoJob::Kind::Write;
+    job.path = get_savestate_path(slot);
+    job.info = info;
+    job.slot = slot;
+    job.rom_crc32 = info.rom_crc32;
+    job.data = buffer->data;
+    capture_frame(job);
+    {
+        std::lock_guard<std::mutex> lock(m_io_mutex);
+        if (m_slot_cache_loaded && m_slot_cache_crc == info.rom_crc32) {
+            m_slot_cache[slot] = info;
+            m_slot_generation[slot]++;
+        }
+    }
+    queue_job(std::move(job));
 
-    // Build savestate info
-    SavestateInfo info;
-    info.rom_name = m_current_rom_name;
-    info.rom_crc32 = plugin->get_rom_crc32();
-    info.frame_count = plugin->get_frame_count();
-    info.timestamp = std::chrono::system_clock::now().time_since_epoch().count();
-    info.valid = true;
+    std::cout << "Saving state to slot " << slot << " (" << size << " bytes)" << std::endl;
+    return true;
+}
+
+bool SavestateManager::load_state(int slot) {
+    if (slot < 0 || slot >= NUM_SLOTS) {
+        std::cerr << "Invalid savestate slot: " << slot << std::endl;
+        return false;
+    }
 
-    // Write to file
-    std::string path = get_savestate_path(slot);
-    if (!write_savestate_file(path, data, info)) {
-        std::cerr << "Failed to write savestate file" << std::endl;
+    if (!m_plugin_manager) {
+        std::cerr << "SavestateManager not initialized" << std::endl;
         return false;
     }
 
-    std::cout << "Saved state to slot " << slot << " (" << data.size() << " bytes)" << std::endl;
+    auto* plugin = m_plugin_manager->get_active_plugin();
+    if (!plugin || !plugin->is_rom_loaded()) {
+        std::cerr << "No ROM loaded, cannot load state" << std::endl;
+        return false;
+    }
+
+    SlotBuffer* buffer = fetch_slot(slot, plugin);
+    if (!buffer) {
+        return false;
+    }
+
+    // Load the state
+    auto* fast = dynamic_cast<INetplayCapable*>(plugin);
+    bool loaded = fast && fast->load_state_fast(buffer->data.data(), buffer->data.size());
+    if (!loaded && !plugin->load_state(buffer->data)) {
+        std::cerr << "Failed to deserialize emulator state" << std::endl;
+        return false;
+    }
+
+    std::cout << "Loaded state from slot " << slot << " (frame " << buffer->info.frame_count << ")" << std::endl;
     return true;
 }
 
-bool SavestateManager::load_state(int slot) {
+bool SavestateManager::load_state_chunks(int slot, const uint32_t* tags, size_t tag_count) {
     if (slot < 0 || slot >= NUM_SLOTS) {
         std::cerr << "Invalid savestate slot: " << slot << std::endl;
         return false;
@@ -98,31 +174,48 @@ bool SavestateManager::load_state(int slot) {
         return false;
     }
 
-    // Read savestate file
-    std::string path = get_savestate_path(slot);
+    SlotBuffer* buffer = fetch_slot(slot, plugin);
+    if (!buffer) {
+        return false;
+    }
+
+    if (!plugin->load_state_chunks(buffer->data.data(), buffer->data.size(), tags, tag_count)) {
+        std::cerr << "Core can't load part of this state" << std::endl;
+        return false;
+    }
+
+    std::cout << "Loaded part of the state in slot " << slot << std::endl;
+    return true;
+}
+
+SavestateManager::SlotBuffer* SavestateManager::fetch_slot(int slot, IEmulatorPlugin* plugin) {
+    // First load of a slot not saved this session: read it from its file,
+    // once any save to it has landed
+    SlotBuffer* buffer = get_slot_buffer(slot, plugin->get_rom_crc32());
+    if (buffer->loaded) {
+        return buffer;
+    }
+
+    flush();
     SavestateInfo info;
-    auto data = read_savestate_file(path, info);
+    auto data = read_savestate_file(get_savestate_path(slot), info);
 
     if (!data.has_value()) {
         std::cerr << "Failed to read savestate file" << std::endl;
-        return false;
+        return nullptr;
     }
 
     // Verify ROM CRC matches
     if (info.rom_crc32 != plugin->get_rom_crc32()) {
         std::cerr << "Savestate ROM CRC mismatch! Expected: " << std::hex
                   << plugin->get_rom_crc32() << ", got: " << info.rom_crc32 << std::dec << std::endl;
-        return false;
+        return nullptr;
     }
 
-    // Load the state
-    if (!plugin->load_state(data.value())) {
-        std::cerr << "Failed to deserialize emulator state" << std::endl;
-        return false;
-    }
-
-    std::cout << "Loaded state from slot " << slot << " (frame " << info.frame_count << ")" << std::endl;
-    return true;
+    buffer->data = std::move(data.value());
+    buffer->info = info;
+    buffer->loaded = true;
+    return buffer;
 }
 
 bool SavestateManager::quick_save() {
@@ -137,28 +230,54 @@ SavestateInfo SavestateManager::get_slot_info(int slot) const {
     SavestateInfo info = {};
     info.valid = false;
 
-    if (slot < 0 || slot >= NUM_SLOTS) {
+    if (slot < 0 || slot >= NUM_SLOTS || !m_plugin_manager) {
         return info;
     }
 
-    std::string path = get_savestate_path(slot);
-    std::ifstream file(path, std::ios::binary);
-    if (!file) {
+    auto* plugin = m_plugin_manager->get_active_plugin();
+    if (!plugin || !plugin->is_rom_loaded()) {
         return info;
     }
+    uint32_t crc = plugin->get_rom_crc32();
 
-    SavestateHeader header;
-    file.read(reinterpret_cast<char*>(&header), sizeof(header));
-
-    if (file && std::memcmp(header.magic, "VELO", 4) == 0) {
-        info.rom_name = header.rom_name;
-        info.rom_crc32 = header.rom_crc32;
-        info.frame_count = header.frame_count;
-        info.timestamp = header.timestamp;
-        info.valid = true;
+    std::lock_guard<std::mutex> lock(m_io_mutex);
+    if (!m_slot_cache_loaded || m_slot_cache_crc != crc) {
+        // First look at this ROM's slots: empty until the I/O thread has
+        // read their headers, which takes a frame or two
+        m_slot_cache.fill(SavestateInfo{});
+        m_slot_cache_crc = crc;
+        m_slot_cache_loaded = true;
+        for (int i = 0; i < NUM_SLOTS; i++) {
+            m_slot_thumbnails[i] = SavestateThumbnail{};
+            m_thumbnail_generation[i] = ++m_last_thumbnail_generation;
+        }
+
+        IoJob job;
+        job.kind = IoJob::Kind::RefreshSlots;
+        job.rom_crc32 = crc;
+        for (int i = 0; i < NUM_SLOTS; i++) {
+            job.slot_paths[i] = get_savestate_path(i);
+            job.slot_generations[i] = m_slot_generation[i];
+        }
+        m_io_queue.push_back(std::move(job));
+        m_io_wake.notify_one();
+        return info;
     }
+    return m_slot_cache[slot];
+}
 
-    return info;
+bool SavestateManager::get_slot_thumbnail(int slot, uint64_t& generation, SavestateThumbnail& thumbnail) const {
+    if (slot < 0 || slot >= NUM_SLOTS) return false;
+    std::lock_guard<std::mutex> lock(m_io_mutex);
+    if (m_thumbnail_generation[slot] == generation) return false;
+    generation = m_thumbnail_generation[slot];
+    thumbnail = m_slot_thumbnails[slot];
+    return true;
+}
+
+void SavestateManager::set_cached_thumbnail(int slot, SavestateThumbnail&& thumbnail) {
+    m_slot_thumbnails[slot] = std::move(thumbnail);
+    m_thumbnail_generation[slot] = ++m_last_thumbnail_generation;
 }
 
 bool SavestateManager::is_slot_valid(int slot) const {
@@ -191,34 +310,23 @@ bool SavestateManager::save_state_to_file(const std::string& path) {
         return false;
     }
 
-    auto* plugin = m_plugin_manager->get_active_plugin();
-    if (!plugin || !plugin->is_rom_loaded()) {
-        std::cerr << "No ROM loaded, cannot save state" << std::endl;
-        return false;
-    }
-
-    // Serialize emulator state
     std::vector<uint8_t> data;
-    if (!plugin->save_state(data)) {
-        std::cerr << "Failed to serialize emulator state" << std::endl;
-        return false;
-    }
-
-    // Build savestate info
     SavestateInfo info;
-    info.rom_name = m_current_rom_name;
-    info.rom_crc32 = plugin->get_rom_crc32();
-    info.frame_count = plugin->get_frame_count();
-    info.timestamp = std::chrono::system_clock::now().time_since_epoch().count();
-    info.valid = true;
-
-    // Write to file
-    if (!write_savestate_file(path, data, info)) {
-        std::cerr << "Failed to write savestate file: " << path << std::endl;
+    if (!capture_state(data, info)) {
         return false;
     }
-
-    std::cout << "Saved state to file: " << path << " (" << data.size() << " bytes)" << std::endl;
+    size_t size = data.size();
+
+    IoJob job;
+    job.kind = IoJob::Kind::Write;
+    job.path = path;
+    job.info = info;
+    job.rom_crc32 = info.rom_crc32;
+    job.data = std::move(data);
+    capture_frame(job);
+    queue_job(std::move(job));
+
+    std::cout << "Saving state to file: " << path << " (" << size << " bytes)" << std::endl;
     return true;
 }
 
@@ -234,7 +342,8 @@ bool SavestateManager::load_state_from_file(const std::string& path) {
         return false;
     }
 
-    // Read savestate file
+    // Read savestate file, once any save to it has landed
+    flush();
     SavestateInfo info;
     auto data = read_savestate_file(path, info);
 
@@ -260,13 +369,190 @@ bool SavestateManager::load_state_from_file(const std::string& path) {
     return true;
 }
 
+void SavestateManager::set_write_callback(WriteCallback callback) {
+    std::lock_guard<std::mutex> lock(m_io_mutex);
+    m_write_callback = std::move(callback);
+}
+
+void SavestateManager::flush() {
+    std::unique_lock<std::mutex> lock(m_io_mutex);
+    m_io_idle.wait(lock, [this] { return m_io_queue.empty() && !m_io_busy; });
+}
+
+bool SavestateManager::capture_state(std::vector<uint8_t>& data, SavestateInfo& info) {
+    auto* plugin = m_plugin_manager->get_active_plugin();
+    if (!plugin || !plugin->is_rom_loaded()) {
+        std::cerr << "No ROM loaded, cannot save state" << std::endl;
+        return false;
+    }
+
+    // Serialize emulator state; the one part of a save that has to happen
+    // between frames. The fast path writes in place, so a buffer that has
+    // held a state before isn't reallocated.
+    bool saved = false;
+    if (auto* fast = dynamic_cast<INetplayCapable*>(plugin)) {
+        data.resize(fast->get_max_state_size());
+        size_t size = fast->save_state_fast(data.data(), data.size());
+        data.resize(size);
+        saved = size > 0;
+    }
+    if (!saved && !plugin->save_state(data)) {
+        std::cerr << "Failed to serialize emulator state" << std::endl;
+        return false;
+    }
+
+    info.rom_name = m_current_rom_name;
+    info.rom_crc32 = plugin->get_rom_crc32();
+    info.frame_count = plugin->get_frame_count();
+    info.timestamp = std::chrono::system_clock::now().time_since_epoch().count();
+    info.valid = true;
+    return true;
+}
+
+// The one copy a save makes of the frame; shrinking it is the I/O
+// thread's job
+void SavestateManager::capture_frame(IoJob& job) {
+    auto* plugin = m_plugin_manager->get_active_plugin();
+    FrameBuffer fb = plugin->get_framebuffer();
+    if (!fb.pixels || fb.width <= 0 || fb.height <= 0) return;
+    job.frame.assign(fb.pixels, fb.pixels + static_cast<size_t>(fb.width) * fb.height);
+    job.frame_width = fb.width;
+    job.frame_height = fb.height;
+}
+
+SavestateManager::SlotBuffer* SavestateManager::get_slot_buffer(int slot, uint32_t rom_crc32) {
+    // Another ROM's slots; the buffers keep their capacity for this one's
+    if (m_slot_buffers_crc != rom_crc32) {
+        for (auto& buffer : m_slot_buffers) {
+            buffer.data.clear();
+            buffer.loaded = false;
+        }
+        m_slot_buffers_crc = rom_crc32;
+    }
+    return &m_slot_buffers[slot];
+}
+
+void SavestateManager::queue_job(IoJob&& job) const {
+    {
+        std::lock_guard<std::mutex> lock(m_io_mutex);
+        m_io_queue.push_back(std::move(job));
+    }
+    m_io_wake.notify_one();
+}
+
+void SavestateManager::io_loop() {
+    std::unique_lock<std::mutex> lock(m_io_mutex);
+    for (;;) {
+        m_io_wake.wait(lock, [this] { return !m_io_queue.empty() || m_io_stopping; });
+        if (m_io_queue.empty()) {
+            break;  // Stopping, and every queued write is done
+        }
+
+        IoJob job = std::move(m_io_queue.front());
+        m_io_queue.pop_front();
+        m_io_busy = true;
+
+        lock.unlock();
+        run_job(job);
+        lock.lock();
+
+        m_io_busy = false;
+        if (m_io_queue.empty()) {
+            m_io_idle.notify_all();
+        }
+    }
+}
+
+void SavestateManager::run_job(IoJob& job) {
+    if (job.kind == IoJob::Kind::RefreshSlots) {
+        std::array<SavestateInfo, NUM_SLOTS> infos;
+        std::array<SavestateThumbnail, NUM_SLOTS> thumbnails;
+        for (int i = 0; i < NUM_SLOTS; i++) {
+            infos[i] = read_savestate_info(job.slot_paths[i], &thumbnails[i]);
+        }
+
+        // Skip slots saved since the refresh was asked for, and the whole
+        // thing if another ROM was loaded meanwhile
+        std::lock_guard<std::mutex> lock(m_io_mutex);
+        if (m_slot_cache_crc != job.rom_crc32) return;
+        for (int i = 0; i < NUM_SLOTS; i++) {
+            if (m_slot_generation[i] == job.slot_generations[i]) {
+                m_slot_cache[i] = infos[i];
+                set_cached_thumbnail(i, std::move(thumbnails[i]));
+            }
+        }
+        return;
+    }
+
+    SavestateThumbnail thumbnail = make_thumbnail(job.frame, job.frame_width, job.frame_height);
+    bool ok = write_savestate_file(job.path, job.data, job.info, thumbnail);
+    if (!ok) {
+        std::cerr << "Failed to write savestate file: " << job.path << std::endl;
+    }
+
+    WriteCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(m_io_mutex);
+        if (job.slot >= 0 && m_slot_cache_crc == job.rom_crc32) {
+            if (ok) {
+                set_cached_thumbnail(job.slot, std::move(thumbnail));
+            } else {
+                // The cache showed the state as saved; put back what's on disk
+                SavestateThumbnail on_disk;
+                m_slot_cache[job.slot] = read_savestate_info(job.path, &on_disk);
+                set_cached_thumbnail(job.slot, std::move(on_disk));
+            }
+        }
+        callback = m_write_callback;
+    }
+    if (callback) {
+        callback(job.path, ok);
+    }
+}
+
+// Box-filter the frame down by the smallest whole factor that fits
+// THUMBNAIL_MAX_WIDTH
+SavestateThumbnail SavestateManager::make_thumbnail(const std::vector<uint32_t>& frame, int width, int height) {
+    SavestateThumbnail thumbnail;
+    if (frame.empty() || width <= 0 || height <= 0) return thumbnail;
+
+    int factor = (width + THUMBNAIL_MAX_WIDTH - 1) / THUMBNAIL_MAX_WIDTH;
+    thumbnail.width = width / factor;
+    thumbnail.height = height / factor;
+    thumbnail.pixels.resize(static_cast<size_t>(thumbnail.width) * thumbnail.height);
+    const uint32_t area = static_cast<uint32_t>(factor * factor);
+
+    for (int y = 0; y < thumbnail.height; y++) {
+        for (int x = 0; x < thumbnail.width; x++) {
+            uint32_t sum[4] = {};
+            for (int dy = 0; dy < factor; dy++) {
+                const uint32_t* row = frame.data() + static_cast<size_t>(y * factor + dy) * width + x * factor;
+                for (int dx = 0; dx < factor; dx++) {
+                    for (int c = 0; c < 4; c++) sum[c] += (row[dx] >> (c * 8)) & 0xFF;
+                }
+            }
+            uint32_t pixel = 0;
+            for (int c = 0; c < 4; c++) pixel |= (sum[c] / area) << (c * 8);
+            thumbnail.pixels[static_cast<size_t>(y) * thumbnail.width + x] = pixel;
+        }
+    }
+    return thumbnail;
+}
+
 bool SavestateManager::write_savestate_file(const std::string& path,
                                              const std::vector<uint8_t>& data,
-                                             const SavestateInfo& info) {
-    std::filesystem::create_directories(std::filesystem::path(path).parent_path());
-
-    std::ofstream file(path, std::ios::binary);
-    if (!file) return false;
+                                             const SavestateInfo& info,
+                                             const SavestateThumbnail& thumbnail) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+
+    // Compress; states are mostly zero-filled or repetitive memory. Kept
+    // raw in the rare case that doesn't pay.
+    std::vector<uint8_t> compressed;
+    lz_compress(data.data(), data.size(), compressed);
+    bool use_lz = compressed.size() < data.size();
+    const std::vector<uint8_t>& stored = use_lz ? compressed : data;
 
     // Write header
     SavestateHeader header;
@@ -276,28 +562,70 @@ bool SavestateManager::write_savestate_file(const std::string& path,
     header.data_size = static_cast<uint32_t>(data.size());
     std::strncpy(header.rom_name, info.rom_name.c_str(), sizeof(header.rom_name) - 1);
 
-    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
-
-    // Write state data
-    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    SavestateStorage storage;
+    storage.compression = use_lz ? SAVESTATE_LZ : SAVESTATE_RAW;
+    storage.stored_size = static_cast<uint32_t>(stored.size());
+
+    // Emulated screens are flat colour, so the thumbnail shrinks too
+    const uint8_t* thumbnail_bytes = reinterpret_cast<const uint8_t*>(thumbnail.pixels.data());
+    size_t thumbnail_size = thumbnail.pixels.size() * sizeof(uint32_t);
+    std::vector<uint8_t> thumbnail_compressed;
+    lz_compress(thumbnail_bytes, thumbnail_size, thumbnail_compressed);
+    bool thumbnail_lz = thumbnail_compressed.size() < thumbnail_size;
+    SavestateThumbnailHeader thumbnail_header;
+    thumbnail_header.width = static_cast<uint16_t>(thumbnail.width);
+    thumbnail_header.height = static_cast<uint16_t>(thumbnail.height);
+    thumbnail_header.compression = thumbnail_lz ? SAVESTATE_LZ : SAVESTATE_RAW;
+    thumbnail_header.stored_size = static_cast<uint32_t>(thumbnail_lz ? thumbnail_compressed.size() : thumbnail_size);
+    if (thumbnail_lz) thumbnail_bytes = thumbnail_compressed.data();
+
+    // Into a temporary file first, then renamed over the old state, so the
+    // slot holds either the old state or the new one whatever happens
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(&storage), sizeof(storage));
+        file.write(reinterpret_cast<const char*>(stored.data()), stored.size());
+        file.write(reinterpret_cast<const char*>(&thumbnail_header), sizeof(thumbnail_header));
+        file.write(reinterpret_cast<const char*>(thumbnail_bytes), thumbnail_header.stored_size);
+        file.close();
+        if (!file) {
+            fs::remove(temp_path, ec);
+            return false;
+        }
+    }
 
-    return file.good();
+    fs::rename(temp_path, path, ec);
+    if (ec) {
+        fs::remove(temp_path, ec);
+        return false;
+    }
+    return true;
 }
 
 std::optional<std::vector<uint8_t>> SavestateManager::read_savestate_file(const std::string& path,
                                                                            SavestateInfo& info) {
-    std::ifstream file(path, std::ios::binary);
-    if (!file) return std::nullopt;
+    // Mapped rather than read, so the state is decompressed (or copied)
+    // straight out of the page cache without a buffer for the whole file
+    MappedFile file;
+    if (!file.open(path)) return std::nullopt;
+    const uint8_t* bytes = file.data();
+    size_t remaining = file.size();
 
     // Read header
     SavestateHeader header;
-    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (remaining < sizeof(header)) return std::nullopt;
+    std::memcpy(&header, bytes, sizeof(header));
+    bytes += sizeof(header);
+    remaining -= sizeof(header);
 
-    if (!file || std::memcmp(header.magic, "VELO", 4) != 0) {
+    if (std::memcmp(header.magic, "VELO", 4) != 0) {
         return std::nullopt;
     }
 
-    if (header.version < 1 || header.version > 2) {
+    if (header.version < 1 || header.version > 4) {
         std::cerr << "Unsupported savestate version: " << header.version << std::endl;
         return std::nullopt;
     }
@@ -311,13 +639,89 @@ std::optional<std::vector<uint8_t>> SavestateManager::read_savestate_file(const
     info.timestamp = header.timestamp;
     info.valid = true;
 
-    // Read state data
-    std::vector<uint8_t> data(header.data_size);
-    file.read(reinterpret_cast<char*>(data.data()), header.data_size);
+    // Versions before 3 hold the raw state right after the header
+    SavestateStorage storage;
+    storage.stored_size = header.data_size;
+    if (header.version >= 3) {
+        if (remaining < sizeof(storage)) return std::nullopt;
+        std::memcpy(&storage, bytes, sizeof(storage));
+        bytes += sizeof(storage);
+        remaining -= sizeof(storage);
+    }
 
-    if (!file) return std::nullopt;
+    if (storage.stored_size > remaining) return std::nullopt;
 
+    if (storage.compression == SAVESTATE_RAW) {
+        if (storage.stored_size != header.data_size) return std::nullopt;
+        return std::vector<uint8_t>(bytes, bytes + storage.stored_size);
+    }
+    if (storage.compression != SAVESTATE_LZ) {
+        std::cerr << "Unknown savestate compression: " << storage.compression << std::endl;
+        return std::nullopt;
+    }
+
+    std::vector<uint8_t> data(header.data_size);
+    size_t written = 0;
+    if (!lz_decompress(bytes, storage.stored_size, data.data(), data.size(), written) ||
+        written != data.size()) {
+        std::cerr << "Corrupt savestate data" << std::endl;
+        return std::nullopt;
+    }
     return data;
 }
 
+SavestateInfo SavestateManager::read_savestate_info(const std::string& path, SavestateThumbnail* thumbnail) {
+    SavestateInfo info = {};
+    info.valid = false;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return info;
+    }
+
+    SavestateHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (file && std::memcmp(header.magic, "VELO", 4) == 0) {
+        info.rom_name = header.rom_name;
+        info.rom_crc32 = header.rom_crc32;
+        info.frame_count = header.frame_count;
+        info.timestamp = header.timestamp;
+        info.valid = true;
+    }
+
+    // The thumbnail sits past the state, which is skipped over
+    if (!thumbnail || !info.valid || header.version < 4) {
+        return info;
+    }
+    SavestateStorage storage;
+    SavestateThumbnailHeader thumbnail_header;
+    file.read(reinterpret_cast<char*>(&storage), sizeof(storage));
+    file.seekg(storage.stored_size, std::ios::cur);
+    file.read(reinterpret_cast<char*>(&thumbnail_header), sizeof(thumbnail_header));
+    size_t size = static_cast<size_t>(thumbnail_header.width) * thumbnail_header.height * sizeof(uint32_t);
+    if (!file || size == 0) {
+        return info;
+    }
+
+    std::vector<uint8_t> stored(thumbnail_header.stored_size);
+    file.read(reinterpret_cast<char*>(stored.data()), stored.size());
+    std::vector<uint32_t> pixels(size / sizeof(uint32_t));
+    size_t written = 0;
+    bool ok = file && (thumbnail_header.compression == SAVESTATE_LZ
+        ? lz_decompress(stored.data(), stored.size(), reinterpret_cast<uint8_t*>(pixels.data()), size, written) &&
+          written == size
+        : stored.size() == size);
+    if (!ok) {
+        return info;
+    }
+    if (thumbnail_header.compression != SAVESTATE_LZ) {
+        std::memcpy(pixels.data(), stored.data(), size);
+    }
+    thumbnail->width = thumbnail_header.width;
+    thumbnail->height = thumbnail_header.height;
+    thumbnail->pixels = std::move(pixels);
+    return info;
+}
+
 } // namespace emu
@@ -1,13 +1,20 @@
 #pragma once
 
+#include <array>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 #include <optional>
 
 namespace emu {
 
 class PluginManager;
+class IEmulatorPlugin;
 class PathsConfiguration;
 
 // Metadata stored with each savestate
@@ -19,51 +26,154 @@ struct SavestateInfo {
     bool valid;                     // Whether this slot has a valid savestate
 };
 
+// Downscaled frame shown when the state was saved
+struct SavestateThumbnail {
+    int width = 0;
+    int height = 0;
+    std::vector<uint32_t> pixels;   // RGBA8888, like FrameBuffer
+};
+
+// Savestate slots and files
+//
+// Saving only serializes the core on the calling thread. The state is then
+// compressed and written on a background I/O thread, to a temporary file
+// that's renamed over the old one when complete, so a save never stalls a
+// frame and a crash mid-write never leaves a torn file. Slot metadata for
+// the menus comes from a cache that the I/O thread fills, so listing slots
+// doesn't touch the disk either. Thumbnails work the same way: a save
+// copies the framebuffer, and the I/O thread shrinks it, stores it after
+// the state and puts it in the cache.
+//
+// The slots themselves are also kept in memory, filled on save and on the
+// first load of each slot, with the files as write-behind copies. Loading a
+// slot is then one load_state_fast() from its buffer, with no file I/O or
+// allocation, for practice sessions that reload a slot hundreds of times.
+// Slot saves and loads must come from one thread (the emulation thread).
 class SavestateManager {
 public:
     static constexpr int NUM_SLOTS = 10;  // Slots 0-9 (F1-F10 hotkeys)
 
+    // Widest a thumbnail gets; frames shrink by a whole factor to fit
+    static constexpr int THUMBNAIL_MAX_WIDTH = 128;
+
     SavestateManager();
-    ~SavestateManager();
+    ~SavestateManager();  // Finishes queued writes
 
     // Initialize with plugin manager and paths configuration
     void initialize(PluginManager* plugin_manager, PathsConfiguration* paths_config);
 
-    // Save current state to slot (0-9)
+    // Save current state to slot (0-9); true once the write is queued
     bool save_state(int slot);
 
-    // Load state from slot (0-9)
+    // Load state from slot (0-9); from memory after the first time
     bool load_state(int slot);
 
+    // Load only the chunks of a slot's state with the given tags (see
+    // IEmulatorPlugin::load_state_chunks), e.g. STATE_CHUNK_WORK_RAM
+    bool load_state_chunks(int slot, const uint32_t* tags, size_t tag_count);
+
     // Quick save/load (uses slot 0)
     bool quick_save();
     bool quick_load();
 
-    // Get info about a slot
+    // Get info about a slot (cached; a slot saved this session shows at once)
     SavestateInfo get_slot_info(int slot) const;
 
+    // Copy the slot's thumbnail into thumbnail if it changed since
+    // generation (0 at first), and update generation; an empty thumbnail
+    // means the slot has none. Cached like get_slot_info().
+    bool get_slot_thumbnail(int slot, uint64_t& generation, SavestateThumbnail& thumbnail) const;
+
     // Check if slot has a valid savestate
     bool is_slot_valid(int slot) const;
 
     // Get current ROM's savestate path for a slot
     std::string get_savestate_path(int slot) const;
 
-    // Save/load to arbitrary file path
+    // Save/load to arbitrary file path; saving is queued like save_state()
     bool save_state_to_file(const std::string& path);
     bool load_state_from_file(const std::string& path);
 
     // Set the current ROM name (used for organizing saves)
     void set_current_rom_name(const std::string& name) { m_current_rom_name = name; }
 
+    // Called on the I/O thread after each queued write, with its outcome
+    using WriteCallback = std::function<void(const std::string& path, bool ok)>;
+    void set_write_callback(WriteCallback callback);
+
+    // Block until every queued write has finished
+    void flush();
+
 private:
-    bool write_savestate_file(const std::string& path, const std::vector<uint8_t>& data,
-                              const SavestateInfo& info);
-    std::optional<std::vector<uint8_t>> read_savestate_file(const std::string& path,
-                                                             SavestateInfo& info);
+    struct IoJob {
+        enum class Kind { Write, RefreshSlots } kind = Kind::Write;
+        std::string path;               // Write
+        std::vector<uint8_t> data;      // Write: uncompressed state
+        SavestateInfo info{};           // Write
+        std::vector<uint32_t> frame;    // Write: framebuffer when saved, shrunk on the I/O thread
+        int frame_width = 0;
+        int frame_height = 0;
+        int slot = -1;                  // Write: slot the file belongs to, or -1
+        uint32_t rom_crc32 = 0;         // ROM the slot paths belong to
+        std::array<std::string, NUM_SLOTS> slot_paths;     // RefreshSlots
+        std::array<uint64_t, NUM_SLOTS> slot_generations{}; // RefreshSlots
+    };
+
+    // A slot's state in memory; data keeps its capacity across saves
+    struct SlotBuffer {
+        std::vector<uint8_t> data;
+        SavestateInfo info{};
+        bool loaded = false;
+    };
+
+    bool capture_state(std::vector<uint8_t>& data, SavestateInfo& info);
+    void capture_frame(IoJob& job);
+    SlotBuffer* get_slot_buffer(int slot, uint32_t rom_crc32);
+    SlotBuffer* fetch_slot(int slot, IEmulatorPlugin* plugin);  // Read from disk if needed
+    void queue_job(IoJob&& job) const;
+    void io_loop();
+    void run_job(IoJob& job);
+
+    void set_cached_thumbnail(int slot, SavestateThumbnail&& thumbnail);
+
+    static SavestateThumbnail make_thumbnail(const std::vector<uint32_t>& frame, int width, int height);
+    static bool write_savestate_file(const std::string& path, const std::vector<uint8_t>& data,
+                                     const SavestateInfo& info, const SavestateThumbnail& thumbnail);
+    static std::optional<std::vector<uint8_t>> read_savestate_file(const std::string& path,
+                                                                    SavestateInfo& info);
+    static SavestateInfo read_savestate_info(const std::string& path, SavestateThumbnail* thumbnail = nullptr);
 
     PluginManager* m_plugin_manager = nullptr;
     PathsConfiguration* m_paths_config = nullptr;
     std::string m_current_rom_name;
+
+    // I/O thread; everything below is guarded by m_io_mutex
+    std::thread m_io_thread;
+    mutable std::mutex m_io_mutex;
+    mutable std::condition_variable m_io_wake;  // Job queued, or stopping
+    std::condition_variable m_io_idle;          // Queue drained
+    mutable std::deque<IoJob> m_io_queue;
+    bool m_io_busy = false;
+    bool m_io_stopping = false;
+    WriteCallback m_write_callback;
+
+    // In-memory slots for the ROM with CRC m_slot_buffers_crc; only touched
+    // by the thread that saves and loads slots
+    std::array<SlotBuffer, NUM_SLOTS> m_slot_buffers;
+    uint32_t m_slot_buffers_crc = 0;
+
+    // Slot metadata for the ROM with CRC m_slot_cache_crc. A save bumps its
+    // slot's generation, so a refresh queued before the save doesn't
+    // overwrite the newer entry with what was on disk.
+    mutable std::array<SavestateInfo, NUM_SLOTS> m_slot_cache{};
+    mutable std::array<uint64_t, NUM_SLOTS> m_slot_generation{};
+    mutable uint32_t m_slot_cache_crc = 0;
+    mutable bool m_slot_cache_loaded = false;
+
+    // Thumbnails for the same ROM; each change takes a new generation
+    mutable std::array<SavestateThumbnail, NUM_SLOTS> m_slot_thumbnails;
+    mutable std::array<uint64_t, NUM_SLOTS> m_thumbnail_generation{};
+    mutable uint64_t m_last_thumbnail_generation = 0;
 };
 
 } // namespace emu
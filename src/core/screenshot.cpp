@@ -3,6 +3,7 @@
 
 #include "screenshot.hpp"
 #include <chrono>
+#include <cstdio>
 #include <sstream>
 #include <iomanip>
 #include <vector>
@@ -10,9 +11,36 @@
 
 namespace emu {
 
+bool Screenshot::save(const std::filesystem::path& path, const uint32_t* pixels,
+                      int width, int height, ScreenshotFormat format) {
+    switch (format) {
+        case ScreenshotFormat::Png:
+            return save_png(path, pixels, width, height);
+        case ScreenshotFormat::PngFast:
+            return save_png(path, pixels, width, height, 1);
+        case ScreenshotFormat::Qoi:
+            return save_qoi(path, pixels, width, height);
+        case ScreenshotFormat::Bmp:
+            return save_bmp(path, pixels, width, height);
+    }
+    return false;
+}
+
+const char* Screenshot::extension(ScreenshotFormat format) {
+    switch (format) {
+        case ScreenshotFormat::Qoi:
+            return ".qoi";
+        case ScreenshotFormat::Bmp:
+            return ".bmp";
+        default:
+            return ".png";
+    }
+}
+
 bool Screenshot::save_png(const std::filesystem::path& path,
                           const uint32_t* pixels,
-                          int width, int height) {
+                          int width, int height,
+                          int compression_level) {
     if (!pixels || width <= 0 || height <= 0) {
         return false;
     }
@@ -35,15 +63,14 @@ bool Screenshot::save_png(const std::filesystem::path& path,
         rgba_data[i * 4 + 3] = (pixel >> 24) & 0xFF; // A
     }
 
+    stbi_write_png_compression_level = compression_level;
     int result = stbi_write_png(path.string().c_str(),
                                 width, height,
                                 4, // RGBA
                                 rgba_data.data(),
                                 width * 4); // stride
 
-    if (result) {
-        std::cout << "[Screenshot] Saved: " << path << std::endl;
-    } else {
+    if (!result) {
         std::cerr << "[Screenshot] Failed to save: " << path << std::endl;
     }
 
@@ -81,7 +108,93 @@ bool Screenshot::save_bmp(const std::filesystem::path& path,
     return result != 0;
 }
 
-std::string Screenshot::generate_filename(const std::string& prefix) {
+bool Screenshot::save_qoi(const std::filesystem::path& path,
+                          const uint32_t* pixels,
+                          int width, int height) {
+    if (!pixels || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path());
+    }
+
+    // Worst case is 5 bytes a pixel (QOI_OP_RGBA), plus header and end marker
+    size_t count = static_cast<size_t>(width) * static_cast<size_t>(height);
+    std::vector<uint8_t> out;
+    out.reserve(14 + count * 5 + 8);
+    auto put32 = [&](uint32_t value) {
+        out.push_back(static_cast<uint8_t>(value >> 24));
+        out.push_back(static_cast<uint8_t>(value >> 16));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+        out.push_back(static_cast<uint8_t>(value));
+    };
+    out.insert(out.end(), {'q', 'o', 'i', 'f'});
+    put32(static_cast<uint32_t>(width));
+    put32(static_cast<uint32_t>(height));
+    out.push_back(4);   // RGBA
+    out.push_back(0);   // sRGB
+
+    // Pixels as 0xAARRGGBB, like the framebuffer
+    uint32_t index[64] = {};
+    uint32_t previous = 0xFF000000u;
+    int run = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t pixel = pixels[i];
+        if (pixel == previous) {
+            if (++run == 62 || i + 1 == count) {
+                out.push_back(static_cast<uint8_t>(0xC0 | (run - 1)));
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            out.push_back(static_cast<uint8_t>(0xC0 | (run - 1)));
+            run = 0;
+        }
+
+        uint32_t r = (pixel >> 16) & 0xFF;
+        uint32_t g = (pixel >> 8) & 0xFF;
+        uint32_t b = pixel & 0xFF;
+        uint32_t a = pixel >> 24;
+        uint32_t slot = (r * 3 + g * 5 + b * 7 + a * 11) % 64;
+        if (index[slot] == pixel) {
+            out.push_back(static_cast<uint8_t>(slot));
+        } else if (a != (previous >> 24)) {
+            index[slot] = pixel;
+            out.insert(out.end(), {0xFF, static_cast<uint8_t>(r), static_cast<uint8_t>(g),
+                                   static_cast<uint8_t>(b), static_cast<uint8_t>(a)});
+        } else {
+            index[slot] = pixel;
+            int dr = static_cast<int8_t>(r - ((previous >> 16) & 0xFF));
+            int dg = static_cast<int8_t>(g - ((previous >> 8) & 0xFF));
+            int db = static_cast<int8_t>(b - (previous & 0xFF));
+            int dr_dg = dr - dg;
+            int db_dg = db - dg;
+            if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                out.push_back(static_cast<uint8_t>(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+            } else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+                out.push_back(static_cast<uint8_t>(0x80 | (dg + 32)));
+                out.push_back(static_cast<uint8_t>((dr_dg + 8) << 4 | (db_dg + 8)));
+            } else {
+                out.insert(out.end(), {0xFE, static_cast<uint8_t>(r), static_cast<uint8_t>(g),
+                                       static_cast<uint8_t>(b)});
+            }
+        }
+        previous = pixel;
+    }
+    out.insert(out.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+
+    FILE* file = std::fopen(path.string().c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+    ok = std::fclose(file) == 0 && ok;
+    return ok;
+}
+
+std::string Screenshot::generate_filename(const std::string& prefix, const char* extension) {
     auto now = std::chrono::system_clock::now();
     auto time_t = std::chrono::system_clock::to_time_t(now);
     auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -91,7 +204,7 @@ std::string Screenshot::generate_filename(const std::string& prefix) {
     oss << prefix << "_"
         << std::put_time(std::localtime(&time_t), "%Y%m%d_%H%M%S")
         << "_" << std::setfill('0') << std::setw(3) << ms.count()
-        << ".png";
+        << extension;
 
     return oss.str();
 }
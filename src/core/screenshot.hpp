@@ -6,12 +6,35 @@
 
 namespace emu {
 
+// Image formats screenshots can be written in
+enum class ScreenshotFormat {
+    Png,        // Smallest files; deflate at stb's default level
+    PngFast,    // Deflate level 1: a few times faster, somewhat larger
+    Qoi,        // Lossless and much faster again; for frame bursts
+    Bmp         // Uncompressed
+};
+
 // Screenshot utility for saving framebuffer to PNG files
 class Screenshot {
 public:
+    // Save in format; the path's extension is left as given
+    static bool save(const std::filesystem::path& path, const uint32_t* pixels,
+                     int width, int height, ScreenshotFormat format);
+
+    // ".png", ".qoi" or ".bmp"
+    static const char* extension(ScreenshotFormat format);
+
     // Save RGBA framebuffer to PNG file
-    // Returns true on success
+    // Returns true on success. compression_level is zlib's 1-9; stb keeps
+    // it in a global, so PNGs must only be written from one thread at a
+    // time (the ScreenshotWriter's).
     static bool save_png(const std::filesystem::path& path,
+                         const uint32_t* pixels,
+                         int width, int height,
+                         int compression_level = 8);
+
+    // Save to a QOI file (qoiformat.org): lossless, encoded in one pass
+    static bool save_qoi(const std::filesystem::path& path,
                          const uint32_t* pixels,
                          int width, int height);
 
@@ -21,7 +44,8 @@ public:
                          int width, int height);
 
     // Generate a timestamped filename for screenshots
-    static std::string generate_filename(const std::string& prefix = "screenshot");
+    static std::string generate_filename(const std::string& prefix = "screenshot",
+                                         const char* extension = ".png");
 };
 
 } // namespace emu
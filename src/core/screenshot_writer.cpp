@@ -0,0 +1,92 @@
+#include "screenshot_writer.hpp"
+
+#include <cstring>
+
+namespace emu {
+
+ScreenshotWriter::ScreenshotWriter(size_t max_pending) : m_max_pending(max_pending) {}
+
+ScreenshotWriter::~ScreenshotWriter() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+}
+
+bool ScreenshotWriter::queue(const std::filesystem::path& path, const uint32_t* pixels, int width, int height,
+                             ScreenshotFormat format, DoneCallback done) {
+    if (!pixels || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    Job job;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_jobs.size() >= m_max_pending) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (!m_pool.empty()) {
+            job.pixels = std::move(m_pool.back());
+            m_pool.pop_back();
+        }
+        if (!m_writer.joinable()) {
+            m_writer = std::thread(&ScreenshotWriter::writer_loop, this);
+        }
+    }
+
+    // Copied outside the lock so the writer isn't held up by it
+    size_t count = static_cast<size_t>(width) * static_cast<size_t>(height);
+    job.pixels.resize(count);
+    std::memcpy(job.pixels.data(), pixels, count * sizeof(uint32_t));
+    job.path = path;
+    job.width = width;
+    job.height = height;
+    job.format = format;
+    job.done = std::move(done);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(std::move(job));
+    }
+    m_wake.notify_one();
+    return true;
+}
+
+void ScreenshotWriter::flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this] { return m_jobs.empty() && !m_busy; });
+}
+
+void ScreenshotWriter::writer_loop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_wake.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+        if (m_jobs.empty()) {
+            return;  // Stopping, with everything written
+        }
+
+        Job job = std::move(m_jobs.front());
+        m_jobs.pop_front();
+        m_busy = true;
+        lock.unlock();
+
+        bool ok = Screenshot::save(job.path, job.pixels.data(), job.width, job.height, job.format);
+        if (job.done) {
+            job.done(job.path.string(), ok);
+        }
+
+        lock.lock();
+        m_pool.push_back(std::move(job.pixels));
+        m_busy = false;
+        if (m_jobs.empty()) {
+            m_idle.notify_all();
+        }
+    }
+}
+
+} // namespace emu
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "screenshot.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace emu {
+
+// Encodes and writes screenshots on a background thread
+//
+// queue() copies the frame into a pooled buffer and returns; the writer
+// thread does the encoding and file I/O, so taking a screenshot costs the
+// caller one framebuffer copy whether it's a single PNG or every frame of
+// a burst. Buffers go back to the pool once written, so a burst settles
+// into reusing the same few. With max_pending frames waiting, further
+// frames are dropped rather than making the caller wait.
+class ScreenshotWriter {
+public:
+    // Called on the writer thread after each file, with whether it was saved
+    using DoneCallback = std::function<void(const std::string& path, bool ok)>;
+
+    explicit ScreenshotWriter(size_t max_pending = 256);
+    ~ScreenshotWriter();
+
+    ScreenshotWriter(const ScreenshotWriter&) = delete;
+    ScreenshotWriter& operator=(const ScreenshotWriter&) = delete;
+
+    // Any thread. False if the frame is empty or was dropped; otherwise
+    // done, if given, is called once the file is written.
+    bool queue(const std::filesystem::path& path, const uint32_t* pixels, int width, int height,
+               ScreenshotFormat format, DoneCallback done = {});
+
+    // Wait until everything queued so far is written
+    void flush();
+
+    uint64_t get_dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Job {
+        std::filesystem::path path;
+        std::vector<uint32_t> pixels;
+        int width = 0;
+        int height = 0;
+        ScreenshotFormat format = ScreenshotFormat::Png;
+        DoneCallback done;
+    };
+
+    void writer_loop();
+
+    size_t m_max_pending;
+    std::thread m_writer;               // Started on the first queue()
+    std::mutex m_mutex;
+    std::condition_variable m_wake;     // Work queued, or stopping
+    std::condition_variable m_idle;     // Queue drained
+    std::deque<Job> m_jobs;
+    std::vector<std::vector<uint32_t>> m_pool;
+    bool m_busy = false;                // The writer holds a job
+    bool m_stopping = false;
+    std::atomic<uint64_t> m_dropped{0};
+};
+
+} // namespace emu
@@ -0,0 +1,480 @@
+#include "shader_chain.hpp"
+
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include <algorithm>
+#include <iostream>
+
+namespace emu {
+
+// Shader, vertex array and framebuffer entry points, which SDL_opengl.h
+// only declares for GL 1.x; loaded through SDL once the context exists
+struct ShaderFunctions {
+    PFNGLCREATESHADERPROC CreateShader = nullptr;
+    PFNGLSHADERSOURCEPROC ShaderSource = nullptr;
+    PFNGLCOMPILESHADERPROC CompileShader = nullptr;
+    PFNGLGETSHADERIVPROC GetShaderiv = nullptr;
+    PFNGLGETSHADERINFOLOGPROC GetShaderInfoLog = nullptr;
+    PFNGLDELETESHADERPROC DeleteShader = nullptr;
+    PFNGLCREATEPROGRAMPROC CreateProgram = nullptr;
+    PFNGLATTACHSHADERPROC AttachShader = nullptr;
+    PFNGLLINKPROGRAMPROC LinkProgram = nullptr;
+    PFNGLGETPROGRAMIVPROC GetProgramiv = nullptr;
+    PFNGLGETPROGRAMINFOLOGPROC GetProgramInfoLog = nullptr;
+    PFNGLDELETEPROGRAMPROC DeleteProgram = nullptr;
+    PFNGLUSEPROGRAMPROC UseProgram = nullptr;
+    PFNGLGETUNIFORMLOCATIONPROC GetUniformLocation = nullptr;
+    PFNGLUNIFORM1IPROC Uniform1i = nullptr;
+    PFNGLUNIFORM2FPROC Uniform2f = nullptr;
+    PFNGLUNIFORM1FVPROC Uniform1fv = nullptr;
+    PFNGLACTIVETEXTUREPROC ActiveTexture = nullptr;
+    PFNGLGENVERTEXARRAYSPROC GenVertexArrays = nullptr;
+    PFNGLBINDVERTEXARRAYPROC BindVertexArray = nullptr;
+    PFNGLDELETEVERTEXARRAYSPROC DeleteVertexArrays = nullptr;
+    PFNGLGENFRAMEBUFFERSPROC GenFramebuffers = nullptr;
+    PFNGLBINDFRAMEBUFFERPROC BindFramebuffer = nullptr;
+    PFNGLFRAMEBUFFERTEXTURE2DPROC FramebufferTexture2D = nullptr;
+    PFNGLCHECKFRAMEBUFFERSTATUSPROC CheckFramebufferStatus = nullptr;
+    PFNGLDELETEFRAMEBUFFERSPROC DeleteFramebuffers = nullptr;
+};
+
+namespace {
+
+template <typename T>
+bool load_gl_function(T& function, const char* name) {
+    function = reinterpret_cast<T>(SDL_GL_GetProcAddress(name));
+    return function != nullptr;
+}
+
+constexpr int MAX_PARAMETERS = 4;
+
+// One triangle covering the target; v_uv runs 0-1 across it
+const char* const VERTEX_SHADER = R"(#version 330 core
+out vec2 v_uv;
+void main() {
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    v_uv = pos;
+    gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+// Put in front of every pass. u_source_size is the size of the pass's
+// input, so v_uv * u_source_size is the input texel under this fragment.
+const char* const FRAGMENT_PRELUDE = R"(#version 330 core
+in vec2 v_uv;
+out vec4 frag_color;
+uniform sampler2D u_source;
+uniform sampler2D u_previous;
+uniform vec2 u_source_size;
+uniform int u_frame;
+uniform float u_param[4];
+)";
+
+// Dark gaps between the lines, as on a CRT
+// u_param: intensity, brightness
+const char* const SCANLINES = R"(
+void main() {
+    vec2 pos = v_uv * u_source_size;
+    vec3 color = texelFetch(u_source, ivec2(pos), 0).rgb;
+    float distance = abs(fract(pos.y) - 0.5) * 2.0;
+    float beam = 1.0 - u_param[0] * smoothstep(0.3, 1.0, distance);
+    frag_color = vec4(color * beam * u_param[1], 1.0);
+}
+)";
+
+// Slow pixel response: blend the frame into the last one's result
+// u_param: ghosting, grid
+const char* const LCD_GHOSTING = R"(
+void main() {
+    ivec2 pos = ivec2(v_uv * u_source_size);
+    vec3 color = texelFetch(u_source, pos, 0).rgb;
+    vec3 previous = texelFetch(u_previous, pos, 0).rgb;
+    frag_color = vec4(mix(color, previous, u_param[0]), 1.0);
+}
+)";
+
+// Gaps between the LCD's pixels
+const char* const LCD_GRID = R"(
+void main() {
+    vec2 pos = v_uv * u_source_size;
+    vec3 color = texelFetch(u_source, ivec2(pos), 0).rgb;
+    vec2 cell = abs(fract(pos) - 0.5) * 2.0;
+    float edge = max(smoothstep(0.6, 1.0, cell.x), smoothstep(0.6, 1.0, cell.y));
+    frag_color = vec4(color * (1.0 - u_param[1] * edge), 1.0);
+}
+)";
+
+// Composite video, with the NES's timing: four samples per pixel, six per
+// color subcarrier cycle, the phase moving two samples every line and
+// shifting on odd frames. This pass modulates each pixel's YIQ into the
+// signal; the next one filters it back apart, and the leftovers are the
+// color fringes and dot crawl of the real thing.
+const char* const NTSC_ENCODE = R"(
+void main() {
+    ivec2 pos = ivec2(v_uv * u_source_size * vec2(4.0, 1.0));
+    vec3 rgb = texelFetch(u_source, ivec2(pos.x / 4, pos.y), 0).rgb;
+    float y = dot(rgb, vec3(0.299, 0.587, 0.114));
+    float i = dot(rgb, vec3(0.596, -0.274, -0.322));
+    float q = dot(rgb, vec3(0.211, -0.523, 0.312));
+    float phase = float((pos.x + pos.y * 2 + (u_frame & 1) * 4) % 6) * (3.14159265 / 3.0);
+    frag_color = vec4(y + i * cos(phase) + q * sin(phase), 0.0, 0.0, 1.0);
+}
+)";
+
+// Luma is the signal averaged over whole subcarrier cycles (one for sharp,
+// two for soft), chroma the signal demodulated over two cycles
+// u_param: sharpness, saturation
+const char* const NTSC_DECODE = R"(
+void main() {
+    vec2 pos = v_uv * u_source_size;
+    int x = int(pos.x);
+    int row = int(pos.y);
+    int last = int(u_source_size.x) - 1;
+    int offset = 6 + row * 2 + (u_frame & 1) * 4;
+
+    float wide = 0.0;
+    float narrow = 0.0;
+    float i = 0.0;
+    float q = 0.0;
+    for (int n = -6; n < 6; n++) {
+        float s = texelFetch(u_source, ivec2(clamp(x + n, 0, last), row), 0).r;
+        float phase = float((x + n + offset) % 6) * (3.14159265 / 3.0);
+        wide += s;
+        if (n >= -3 && n < 3) narrow += s;
+        i += s * cos(phase);
+        q += s * sin(phase);
+    }
+    float y = mix(wide / 12.0, narrow / 6.0, u_param[0]);
+    i *= u_param[1] / 6.0;
+    q *= u_param[1] / 6.0;
+
+    vec3 rgb = vec3(y + 0.956 * i + 0.621 * q,
+                    y - 0.272 * i - 0.647 * q,
+                    y - 1.106 * i + 1.703 * q);
+    frag_color = vec4(clamp(rgb, 0.0, 1.0), 1.0);
+}
+)";
+
+ShaderParameter make_parameter(const char* name, const char* description,
+                               float min_value, float max_value, float default_value) {
+    return {name, description, min_value, max_value, default_value, default_value};
+}
+
+} // namespace
+
+ShaderChain::ShaderChain() = default;
+
+ShaderChain::~ShaderChain() {
+    shutdown();
+}
+
+bool ShaderChain::initialize() {
+    shutdown();
+
+    m_gl = std::make_unique<ShaderFunctions>();
+    ShaderFunctions& gl = *m_gl;
+    bool loaded = load_gl_function(gl.CreateShader, "glCreateShader");
+    loaded &= load_gl_function(gl.ShaderSource, "glShaderSource");
+    loaded &= load_gl_function(gl.CompileShader, "glCompileShader");
+    loaded &= load_gl_function(gl.GetShaderiv, "glGetShaderiv");
+    loaded &= load_gl_function(gl.GetShaderInfoLog, "glGetShaderInfoLog");
+    loaded &= load_gl_function(gl.DeleteShader, "glDeleteShader");
+    loaded &= load_gl_function(gl.CreateProgram, "glCreateProgram");
+    loaded &= load_gl_function(gl.AttachShader, "glAttachShader");
+    loaded &= load_gl_function(gl.LinkProgram, "glLinkProgram");
+    loaded &= load_gl_function(gl.GetProgramiv, "glGetProgramiv");
+    loaded &= load_gl_function(gl.GetProgramInfoLog, "glGetProgramInfoLog");
+    loaded &= load_gl_function(gl.DeleteProgram, "glDeleteProgram");
+    loaded &= load_gl_function(gl.UseProgram, "glUseProgram");
+    loaded &= load_gl_function(gl.GetUniformLocation, "glGetUniformLocation");
+    loaded &= load_gl_function(gl.Uniform1i, "glUniform1i");
+    loaded &= load_gl_function(gl.Uniform2f, "glUniform2f");
+    loaded &= load_gl_function(gl.Uniform1fv, "glUniform1fv");
+    loaded &= load_gl_function(gl.ActiveTexture, "glActiveTexture");
+    loaded &= load_gl_function(gl.GenVertexArrays, "glGenVertexArrays");
+    loaded &= load_gl_function(gl.BindVertexArray, "glBindVertexArray");
+    loaded &= load_gl_function(gl.DeleteVertexArrays, "glDeleteVertexArrays");
+    loaded &= load_gl_function(gl.GenFramebuffers, "glGenFramebuffers");
+    loaded &= load_gl_function(gl.BindFramebuffer, "glBindFramebuffer");
+    loaded &= load_gl_function(gl.FramebufferTexture2D, "glFramebufferTexture2D");
+    loaded &= load_gl_function(gl.CheckFramebufferStatus, "glCheckFramebufferStatus");
+    loaded &= load_gl_function(gl.DeleteFramebuffers, "glDeleteFramebuffers");
+    if (!loaded) {
+        std::cerr << "Shaders: GL 3.3 entry points missing, shaders disabled" << std::endl;
+        m_gl.reset();
+        return false;
+    }
+
+    auto add_pass = [&](Shader& shader, const char* source, int scale_x, int scale_y,
+                        bool feedback, bool linear) {
+        Pass pass;
+        pass.program = compile_program(source);
+        pass.scale_x = scale_x;
+        pass.scale_y = scale_y;
+        pass.feedback = feedback;
+        pass.linear = linear;
+        shader.passes.push_back(pass);
+        return pass.program != 0;
+    };
+
+    bool compiled = true;
+    {
+        Shader shader{"NTSC Composite", "Composite video artifacts with NES timing", {}, {}};
+        shader.parameters.push_back(make_parameter("Sharpness", "Luma filter width", 0.0f, 1.0f, 0.5f));
+        shader.parameters.push_back(make_parameter("Saturation", "Color strength", 0.0f, 2.0f, 1.0f));
+        compiled &= add_pass(shader, NTSC_ENCODE, 4, 1, false, false);
+        compiled &= add_pass(shader, NTSC_DECODE, 1, 4, false, true);
+        m_shaders.push_back(std::move(shader));
+    }
+    {
+        Shader shader{"LCD Ghosting", "Slow LCD response and pixel grid, for handhelds", {}, {}};
+        shader.parameters.push_back(make_parameter("Ghosting", "How much of the last frame remains", 0.0f, 0.9f, 0.5f));
+        shader.parameters.push_back(make_parameter("Grid", "Darkness of the gaps between pixels", 0.0f, 1.0f, 0.3f));
+        compiled &= add_pass(shader, LCD_GHOSTING, 1, 1, true, false);
+        compiled &= add_pass(shader, LCD_GRID, 4, 4, false, true);
+        m_shaders.push_back(std::move(shader));
+    }
+    {
+        Shader shader{"Scanlines", "Dark gaps between lines, as on a CRT", {}, {}};
+        shader.parameters.push_back(make_parameter("Intensity", "Darkness of the gaps", 0.0f, 1.0f, 0.5f));
+        shader.parameters.push_back(make_parameter("Brightness", "Makes up for the darker picture", 0.5f, 1.5f, 1.1f));
+        compiled &= add_pass(shader, SCANLINES, 4, 4, false, true);
+        m_shaders.push_back(std::move(shader));
+    }
+
+    gl.GenVertexArrays(1, &m_vao);
+
+    if (!compiled) {
+        std::cerr << "Shaders: compilation failed, shaders disabled" << std::endl;
+        shutdown();
+        return false;
+    }
+    return true;
+}
+
+void ShaderChain::shutdown() {
+    if (!m_gl) return;
+    ShaderFunctions& gl = *m_gl;
+
+    for (Shader& shader : m_shaders) {
+        for (Pass& pass : shader.passes) {
+            if (pass.program) gl.DeleteProgram(pass.program);
+            destroy_target(pass.targets[0]);
+            destroy_target(pass.targets[1]);
+        }
+    }
+    m_shaders.clear();
+    m_active = -1;
+
+    if (m_vao) {
+        gl.DeleteVertexArrays(1, &m_vao);
+        m_vao = 0;
+    }
+    m_gl.reset();
+}
+
+int ShaderChain::get_shader_count() const {
+    return static_cast<int>(m_shaders.size());
+}
+
+ShaderInfo ShaderChain::get_shader_info(int index) const {
+    if (index < 0 || index >= get_shader_count()) return {};
+    const Shader& shader = m_shaders[index];
+    return {shader.name, shader.description, static_cast<int>(shader.parameters.size())};
+}
+
+void ShaderChain::set_active_shader(int index) {
+    m_active = (index >= 0 && index < get_shader_count()) ? index : -1;
+}
+
+int ShaderChain::get_shader_parameter_count(int shader_index) const {
+    if (shader_index < 0 || shader_index >= get_shader_count()) return 0;
+    return static_cast<int>(m_shaders[shader_index].parameters.size());
+}
+
+ShaderParameter ShaderChain::get_shader_parameter(int shader_index, int param_index) const {
+    if (param_index < 0 || param_index >= get_shader_parameter_count(shader_index)) return {};
+    return m_shaders[shader_index].parameters[param_index];
+}
+
+void ShaderChain::set_shader_parameter(int shader_index, int param_index, float value) {
+    if (param_index < 0 || param_index >= get_shader_parameter_count(shader_index)) return;
+    ShaderParameter& parameter = m_shaders[shader_index].parameters[param_index];
+    parameter.current_value = std::clamp(value, parameter.min_value, parameter.max_value);
+}
+
+bool ShaderChain::has_feedback() const {
+    if (m_active < 0) return false;
+    const std::vector<Pass>& passes = m_shaders[m_active].passes;
+    return std::any_of(passes.begin(), passes.end(), [](const Pass& pass) { return pass.feedback; });
+}
+
+uint32_t ShaderChain::apply(uint32_t source, int width, int height, bool new_frame) {
+    if (m_active < 0 || width <= 0 || height <= 0) return 0;
+    ShaderFunctions& gl = *m_gl;
+    Shader& shader = m_shaders[m_active];
+    if (new_frame) m_frame++;
+
+    float params[MAX_PARAMETERS] = {};
+    for (size_t i = 0; i < shader.parameters.size() && i < MAX_PARAMETERS; i++) {
+        params[i] = shader.parameters[i].current_value;
+    }
+
+    // Left as ImGui's backend expects to find them
+    GLint viewport[4];
+    GLint framebuffer = 0;
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+    glDisable(GL_BLEND);
+    glDisable(GL_SCISSOR_TEST);
+    gl.BindVertexArray(m_vao);
+
+    uint32_t input = source;
+    int input_width = width;
+    int input_height = height;
+    uint32_t output = 0;
+    for (Pass& pass : shader.passes) {
+        int output_width = input_width * pass.scale_x;
+        int output_height = input_height * pass.scale_y;
+
+        if (pass.feedback && new_frame) pass.current ^= 1;
+        Target& target = pass.targets[pass.current];
+        Target& previous = pass.targets[pass.current ^ 1];
+        bool ready = resize_target(target, output_width, output_height, pass.linear);
+        if (ready && pass.feedback) {
+            ready = resize_target(previous, output_width, output_height, pass.linear);
+        }
+        if (!ready) {
+            output = 0;
+            break;
+        }
+
+        gl.BindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+        glViewport(0, 0, output_width, output_height);
+        gl.UseProgram(pass.program);
+
+        gl.ActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, input);
+        gl.ActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, pass.feedback ? previous.texture : input);
+
+        gl.Uniform1i(gl.GetUniformLocation(pass.program, "u_source"), 0);
+        gl.Uniform1i(gl.GetUniformLocation(pass.program, "u_previous"), 1);
+        gl.Uniform2f(gl.GetUniformLocation(pass.program, "u_source_size"),
+                     static_cast<float>(input_width), static_cast<float>(input_height));
+        gl.Uniform1i(gl.GetUniformLocation(pass.program, "u_frame"), static_cast<GLint>(m_frame & 0x7FFFFFFF));
+        gl.Uniform1fv(gl.GetUniformLocation(pass.program, "u_param"), MAX_PARAMETERS, params);
+
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        input = target.texture;
+        input_width = output_width;
+        input_height = output_height;
+        output = target.texture;
+    }
+
+    gl.ActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    gl.ActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    gl.UseProgram(0);
+    gl.BindVertexArray(0);
+    gl.BindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(framebuffer));
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    if (blend) glEnable(GL_BLEND);
+    if (scissor) glEnable(GL_SCISSOR_TEST);
+    return output;
+}
+
+uint32_t ShaderChain::compile_program(const char* fragment_source) {
+    ShaderFunctions& gl = *m_gl;
+
+    auto compile = [&](GLenum type, const char* const* sources, GLsizei count) -> GLuint {
+        GLuint shader = gl.CreateShader(type);
+        gl.ShaderSource(shader, count, sources, nullptr);
+        gl.CompileShader(shader);
+        GLint status = GL_FALSE;
+        gl.GetShaderiv(shader, GL_COMPILE_STATUS, &status);
+        if (status != GL_TRUE) {
+            char log[1024] = {};
+            gl.GetShaderInfoLog(shader, sizeof(log), nullptr, log);
+            std::cerr << "Shaders: compile error: " << log << std::endl;
+            gl.DeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    };
+
+    const char* vertex_sources[] = {VERTEX_SHADER};
+    const char* fragment_sources[] = {FRAGMENT_PRELUDE, fragment_source};
+    GLuint vertex = compile(GL_VERTEX_SHADER, vertex_sources, 1);
+    GLuint fragment = compile(GL_FRAGMENT_SHADER, fragment_sources, 2);
+    GLuint program = 0;
+    if (vertex && fragment) {
+        program = gl.CreateProgram();
+        gl.AttachShader(program, vertex);
+        gl.AttachShader(program, fragment);
+        gl.LinkProgram(program);
+        GLint status = GL_FALSE;
+        gl.GetProgramiv(program, GL_LINK_STATUS, &status);
+        if (status != GL_TRUE) {
+            char log[1024] = {};
+            gl.GetProgramInfoLog(program, sizeof(log), nullptr, log);
+            std::cerr << "Shaders: link error: " << log << std::endl;
+            gl.DeleteProgram(program);
+            program = 0;
+        }
+    }
+    if (vertex) gl.DeleteShader(vertex);
+    if (fragment) gl.DeleteShader(fragment);
+    return program;
+}
+
+bool ShaderChain::resize_target(Target& target, int width, int height, bool linear) {
+    if (target.texture && target.width == width && target.height == height) return true;
+    ShaderFunctions& gl = *m_gl;
+
+    if (!target.texture) {
+        glGenTextures(1, &target.texture);
+        gl.GenFramebuffers(1, &target.framebuffer);
+    }
+
+    // Half floats: the composite signal between the NTSC passes goes negative
+    GLint filter = linear ? GL_LINEAR : GL_NEAREST;
+    glBindTexture(GL_TEXTURE_2D, target.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Feedback passes read this as the previous frame before it's drawn
+    gl.BindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    gl.FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+    bool complete = gl.CheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (complete) {
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (!complete) {
+        std::cerr << "Shaders: can't render to a " << width << "x" << height << " texture" << std::endl;
+        destroy_target(target);
+        return false;
+    }
+    target.width = width;
+    target.height = height;
+    return true;
+}
+
+void ShaderChain::destroy_target(Target& target) {
+    if (target.framebuffer) m_gl->DeleteFramebuffers(1, &target.framebuffer);
+    if (target.texture) glDeleteTextures(1, &target.texture);
+    target = Target{};
+}
+
+} // namespace emu
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "emu/video_plugin.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace emu {
+
+struct ShaderFunctions;
+
+// Built-in multi-pass GL shaders run over the game texture
+//
+// Each shader is a list of fragment passes. A pass draws the previous
+// pass's output (the game texture for the first) into a texture scaled by
+// the pass's factors, and may also read its own output from the previous
+// frame, which is how the LCD shader ghosts. All of it runs on the GPU
+// thread at display time; the cores keep handing over plain RGBA frames.
+class ShaderChain {
+public:
+    ShaderChain();
+    ~ShaderChain();
+
+    ShaderChain(const ShaderChain&) = delete;
+    ShaderChain& operator=(const ShaderChain&) = delete;
+
+    // Load the GL entry points and compile every shader; false (and no
+    // shaders offered) if the context can't run them
+    bool initialize();
+    void shutdown();
+
+    int get_shader_count() const;
+    ShaderInfo get_shader_info(int index) const;
+
+    // -1 for none
+    int get_active_shader() const { return m_active; }
+    void set_active_shader(int index);
+
+    int get_shader_parameter_count(int shader_index) const;
+    ShaderParameter get_shader_parameter(int shader_index, int param_index) const;
+    void set_shader_parameter(int shader_index, int param_index, float value);
+
+    // Run the active shader over source (width x height); new_frame
+    // advances the frame counter and the feedback passes. Returns the
+    // output texture, or 0 with no shader active.
+    uint32_t apply(uint32_t source, int width, int height, bool new_frame);
+
+    // Whether the active shader looks at earlier frames, so it has to run
+    // even when a frame repeats
+    bool has_feedback() const;
+
+private:
+    struct Target {
+        uint32_t texture = 0;
+        uint32_t framebuffer = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    struct Pass {
+        uint32_t program = 0;
+        int scale_x = 1;
+        int scale_y = 1;
+        bool feedback = false;      // Reads its own output from the previous frame
+        bool linear = false;        // Output sampled with bilinear filtering
+        Target targets[2];          // Output, and last frame's for feedback passes
+        int current = 0;
+    };
+
+    struct Shader {
+        const char* name;
+        const char* description;
+        std::vector<ShaderParameter> parameters;
+        std::vector<Pass> passes;
+    };
+
+    uint32_t compile_program(const char* fragment_source);
+    bool resize_target(Target& target, int width, int height, bool linear);
+    void destroy_target(Target& target);
+
+    std::unique_ptr<ShaderFunctions> m_gl;
+    std::vector<Shader> m_shaders;
+    int m_active = -1;
+    uint32_t m_vao = 0;
+    uint32_t m_frame = 0;
+};
+
+} // namespace emu
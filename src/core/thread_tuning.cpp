@@ -0,0 +1,322 @@
+#include "thread_tuning.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <string>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    #include <avrt.h>
+#elif defined(__APPLE__)
+    #include <pthread.h>
+    #include <pthread/qos.h>
+#else
+    #include <fcntl.h>
+    #include <pthread.h>
+    #include <sched.h>
+    #include <sys/resource.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+namespace emu {
+
+namespace {
+
+// A physical core: its logical CPUs, first one first, and how fast its
+// type is relative to the others (higher is faster)
+struct CoreInfo {
+    std::vector<int> cpus;
+    int performance = 0;
+};
+
+#ifdef _WIN32
+
+// MMCSS registration of this thread, if any
+thread_local HANDLE t_mmcss_task = nullptr;
+
+std::vector<CoreInfo> read_cores() {
+    std::vector<CoreInfo> cores;
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationProcessorCore, nullptr, &length);
+    if (GetLastError() != ERROR_INSUFFICIENT_BUFFER) return cores;
+
+    std::vector<uint8_t> buffer(length);
+    auto* info = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data());
+    if (!GetLogicalProcessorInformationEx(RelationProcessorCore, info, &length)) return cores;
+
+    // Group 0 only, like pin_current_thread()
+    for (DWORD offset = 0; offset < length;) {
+        auto* entry = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + offset);
+        const PROCESSOR_RELATIONSHIP& core = entry->Processor;
+        if (core.GroupCount > 0 && core.GroupMask[0].Group == 0) {
+            CoreInfo info_core;
+            info_core.performance = core.EfficiencyClass;
+            for (int cpu = 0; cpu < 64; cpu++) {
+                if (core.GroupMask[0].Mask & (KAFFINITY(1) << cpu)) {
+                    info_core.cpus.push_back(cpu);
+                }
+            }
+            if (!info_core.cpus.empty()) {
+                cores.push_back(std::move(info_core));
+            }
+        }
+        offset += entry->Size;
+    }
+    return cores;
+}
+
+#elif defined(__APPLE__)
+
+std::vector<CoreInfo> read_cores() {
+    return {};  // Nothing could be pinned to them
+}
+
+#else
+
+bool read_file(const std::string& path, std::string& text) {
+    std::ifstream file(path);
+    if (!file) return false;
+    std::getline(file, text);
+    return true;
+}
+
+// "0-3,8,10-11" as in sysfs
+std::vector<int> parse_cpu_list(const std::string& text) {
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        int first = 0;
+        int last = 0;
+        int consumed = 0;
+        if (std::sscanf(text.c_str() + pos, "%d-%d%n", &first, &last, &consumed) == 2) {
+            // Range
+        } else if (std::sscanf(text.c_str() + pos, "%d%n", &first, &consumed) == 1) {
+            last = first;
+        } else {
+            break;
+        }
+        for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+            cpus.push_back(cpu);
+        }
+        pos += static_cast<size_t>(consumed);
+        while (pos < text.size() && (text[pos] == ',' || std::isspace(static_cast<unsigned char>(text[pos])))) {
+            pos++;
+        }
+    }
+    return cpus;
+}
+
+std::vector<CoreInfo> read_cores() {
+    std::vector<CoreInfo> cores;
+    std::string text;
+    if (!read_file("/sys/devices/system/cpu/online", text)) return cores;
+    std::vector<int> online = parse_cpu_list(text);
+
+    // Intel hybrid parts list their P-cores here; ARM big.LITTLE gives
+    // each CPU a relative capacity instead
+    std::set<int> performance_cpus;
+    if (read_file("/sys/devices/cpu_core/cpus", text)) {
+        for (int cpu : parse_cpu_list(text)) performance_cpus.insert(cpu);
+    }
+
+    std::set<int> seen;
+    for (int cpu : online) {
+        if (seen.count(cpu)) continue;
+        std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+
+        CoreInfo core;
+        if (read_file(dir + "/topology/thread_siblings_list", text)) {
+            for (int sibling : parse_cpu_list(text)) {
+                if (std::find(online.begin(), online.end(), sibling) != online.end()) {
+                    core.cpus.push_back(sibling);
+                }
+            }
+        }
+        if (core.cpus.empty()) {
+            core.cpus.push_back(cpu);
+        }
+        for (int sibling : core.cpus) seen.insert(sibling);
+
+        if (!performance_cpus.empty()) {
+            core.performance = performance_cpus.count(cpu) ? 1 : 0;
+        } else if (read_file(dir + "/cpu_capacity", text)) {
+            core.performance = std::atoi(text.c_str());
+        }
+        cores.push_back(std::move(core));
+    }
+    return cores;
+}
+
+#endif
+
+} // namespace
+
+const char* get_thread_priority_name(ThreadPriority priority) {
+    switch (priority) {
+        case ThreadPriority::Normal: return "normal";
+        case ThreadPriority::High: return "high";
+        case ThreadPriority::Realtime: return "realtime";
+    }
+    return "normal";
+}
+
+bool parse_thread_priority_name(const char* name, ThreadPriority& priority) {
+    for (ThreadPriority candidate : {ThreadPriority::Normal, ThreadPriority::High, ThreadPriority::Realtime}) {
+        if (std::string(name) == get_thread_priority_name(candidate)) {
+            priority = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool set_current_thread_priority(ThreadPriority priority) {
+#ifdef _WIN32
+    if (priority == ThreadPriority::Normal) {
+        if (t_mmcss_task) {
+            AvRevertMmThreadCharacteristics(t_mmcss_task);
+            t_mmcss_task = nullptr;
+        }
+        return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_NORMAL) != 0;
+    }
+
+    // MMCSS boosts the thread while it runs and keeps background work off
+    // it; the thread priority is the fallback where the service is off
+    if (!t_mmcss_task) {
+        DWORD task_index = 0;
+        t_mmcss_task = AvSetMmThreadCharacteristicsW(L"Games", &task_index);
+    }
+    bool realtime = priority == ThreadPriority::Realtime;
+    if (t_mmcss_task) {
+        AvSetMmThreadPriority(t_mmcss_task, realtime ? AVRT_PRIORITY_HIGH : AVRT_PRIORITY_NORMAL);
+    }
+    int level = realtime ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST;
+    return SetThreadPriority(GetCurrentThread(), level) != 0 || t_mmcss_task != nullptr;
+#elif defined(__APPLE__)
+    qos_class_t qos = priority == ThreadPriority::Normal ? QOS_CLASS_DEFAULT : QOS_CLASS_USER_INTERACTIVE;
+    return pthread_set_qos_class_self_np(qos, 0) == 0;
+#else
+    // Low in the FIFO range, so audio servers (PipeWire, JACK) still
+    // preempt it
+    constexpr int REALTIME_PRIORITY = 10;
+    constexpr int HIGH_NICE = -10;
+
+    sched_param param{};
+    if (priority == ThreadPriority::Realtime) {
+        param.sched_priority = REALTIME_PRIORITY;
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0) {
+            return true;
+        }
+        priority = ThreadPriority::High;
+    } else {
+        param.sched_priority = 0;
+        pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+    }
+
+    // Linux applies a nice value per thread when given its thread id
+    int nice_value = priority == ThreadPriority::High ? HIGH_NICE : 0;
+    return setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), nice_value) == 0;
+#endif
+}
+
+bool pin_current_thread(int cpu) {
+    if (cpu < 0) return false;
+#ifdef _WIN32
+    if (cpu >= 64) return false;
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__APPLE__)
+    return false;
+#else
+    if (cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#endif
+}
+
+std::vector<int> get_spread_cpus() {
+    std::vector<CoreInfo> cores = read_cores();
+    std::stable_sort(cores.begin(), cores.end(), [](const CoreInfo& a, const CoreInfo& b) {
+        return a.performance > b.performance;
+    });
+
+    std::vector<int> cpus;
+    size_t max_threads = 0;
+    for (const CoreInfo& core : cores) {
+        max_threads = std::max(max_threads, core.cpus.size());
+    }
+    for (size_t thread = 0; thread < max_threads; thread++) {
+        for (const CoreInfo& core : cores) {
+            if (thread < core.cpus.size()) {
+                cpus.push_back(core.cpus[thread]);
+            }
+        }
+    }
+    return cpus;
+}
+
+int get_preferred_cpu() {
+    std::vector<CoreInfo> cores = read_cores();
+    int best = -1;
+    int best_performance = 0;
+    for (const CoreInfo& core : cores) {
+        int cpu = core.cpus.front();
+        bool better = best < 0 || core.performance > best_performance ||
+                      (core.performance == best_performance && best == 0);
+        if (better) {
+            best = cpu;
+            best_performance = core.performance;
+        }
+    }
+    return best;
+}
+
+bool PowerRequest::acquire() {
+    if (m_held) return true;
+#ifdef _WIN32
+    PROCESS_POWER_THROTTLING_STATE state{};
+    state.Version = PROCESS_POWER_THROTTLING_CURRENT_VERSION;
+    state.ControlMask = PROCESS_POWER_THROTTLING_EXECUTION_SPEED;
+    state.StateMask = 0;  // Throttling off
+    m_held = SetProcessInformation(GetCurrentProcess(), ProcessPowerThrottling, &state, sizeof(state)) != 0;
+#elif defined(__APPLE__)
+    m_held = false;
+#else
+    // The request lasts while the file stays open
+    m_latency_fd = open("/dev/cpu_dma_latency", O_WRONLY | O_CLOEXEC);
+    if (m_latency_fd >= 0) {
+        int32_t latency_us = 0;
+        if (write(m_latency_fd, &latency_us, sizeof(latency_us)) == static_cast<ssize_t>(sizeof(latency_us))) {
+            m_held = true;
+        } else {
+            close(m_latency_fd);
+            m_latency_fd = -1;
+        }
+    }
+#endif
+    return m_held;
+}
+
+void PowerRequest::release() {
+    if (!m_held) return;
+#ifdef _WIN32
+    PROCESS_POWER_THROTTLING_STATE state{};
+    state.Version = PROCESS_POWER_THROTTLING_CURRENT_VERSION;
+    state.ControlMask = 0;  // Back to the system's choice
+    state.StateMask = 0;
+    SetProcessInformation(GetCurrentProcess(), ProcessPowerThrottling, &state, sizeof(state));
+#elif !defined(__APPLE__)
+    close(m_latency_fd);
+    m_latency_fd = -1;
+#endif
+    m_held = false;
+}
+
+} // namespace emu
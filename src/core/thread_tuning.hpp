@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+
+namespace emu {
+
+// Scheduling class for a latency-sensitive thread
+enum class ThreadPriority {
+    Normal,     // The OS default
+    High,       // Windows: highest priority in the MMCSS "Games" task;
+                // Linux: nice -10; macOS: user-interactive QoS
+    Realtime    // Windows: time-critical in MMCSS "Games" at high priority;
+                // Linux: SCHED_FIFO (falls back to High without
+                // CAP_SYS_NICE or an RLIMIT_RTPRIO); macOS: as High
+};
+
+const char* get_thread_priority_name(ThreadPriority priority);
+bool parse_thread_priority_name(const char* name, ThreadPriority& priority);
+
+// Set the calling thread's scheduling class; false if the OS refused it
+// (the thread keeps whatever it had)
+bool set_current_thread_priority(ThreadPriority priority);
+
+// Restrict the calling thread to one logical CPU; false where unsupported
+// (macOS has no affinity API) or the CPU doesn't exist
+bool pin_current_thread(int cpu);
+
+// Logical CPUs ordered for spreading threads over: one per physical core,
+// the fastest core type first (P-cores on hybrid Intel and ARM parts),
+// then the remaining SMT siblings in the same order. Empty where the
+// topology can't be read or threads can't be pinned.
+std::vector<int> get_spread_cpus();
+
+// Logical CPU for a single latency-sensitive thread: a performance core
+// other than CPU 0 where there is one, since CPU 0 tends to take more
+// interrupts. -1 where threads can't be pinned.
+int get_preferred_cpu();
+
+// Asks the OS to keep the CPU out of its power-saving states while held:
+// no power throttling on Windows (EcoQoS), a zero /dev/cpu_dma_latency
+// request on Linux (needs write access), which keeps cores out of deep
+// idle states between frames. Nothing on macOS, where the QoS class set by
+// set_current_thread_priority() is what steers this.
+class PowerRequest {
+public:
+    PowerRequest() = default;
+    ~PowerRequest() { release(); }
+
+    PowerRequest(const PowerRequest&) = delete;
+    PowerRequest& operator=(const PowerRequest&) = delete;
+
+    // False if the OS wouldn't take the request
+    bool acquire();
+    void release();
+    bool is_held() const { return m_held; }
+
+private:
+    bool m_held = false;
+#if !defined(_WIN32) && !defined(__APPLE__)
+    int m_latency_fd = -1;
+#endif
+};
+
+} // namespace emu
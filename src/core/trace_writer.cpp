@@ -0,0 +1,98 @@
+#include "trace_writer.hpp"
+#include "emu/trace.hpp"
+
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+namespace emu {
+
+bool TraceWriter::write(Tracer& tracer, const std::filesystem::path& path) {
+    std::vector<TraceEvent> events = tracer.take_events();
+    size_t dropped = tracer.get_dropped_count();
+    auto thread_names = tracer.get_thread_names();
+
+    // Viewers want small thread ids; number threads in order of appearance
+    std::unordered_map<size_t, int> thread_ids;
+    auto thread_id = [&](size_t thread) {
+        auto it = thread_ids.find(thread);
+        if (it != thread_ids.end()) return it->second;
+        int id = static_cast<int>(thread_ids.size()) + 1;
+        thread_ids.emplace(thread, id);
+        return id;
+    };
+
+    // Timestamps are microseconds from the first event
+    uint64_t origin = events.empty() ? 0 : events.front().timestamp_ns;
+    for (const auto& event : events) {
+        origin = std::min(origin, event.timestamp_ns);
+    }
+
+    nlohmann::json trace_events = nlohmann::json::array();
+    for (const auto& event : events) {
+        nlohmann::json entry = {
+            {"name", event.name},
+            {"cat", event.category},
+            {"ph", std::string(1, event.phase)},
+            {"ts", static_cast<double>(event.timestamp_ns - origin) / 1000.0},
+            {"pid", 1},
+            {"tid", thread_id(event.thread)},
+        };
+        if (event.phase == 'X') {
+            entry["dur"] = static_cast<double>(event.duration_ns) / 1000.0;
+        } else if (event.phase == 'C') {
+            entry["args"] = {{event.name, event.value}};
+        }
+        trace_events.push_back(std::move(entry));
+    }
+
+    for (const auto& [thread, name] : thread_names) {
+        trace_events.push_back({
+            {"name", "thread_name"},
+            {"ph", "M"},
+            {"pid", 1},
+            {"tid", thread_id(thread)},
+            {"args", {{"name", name}}},
+        });
+    }
+
+    nlohmann::json root;
+    root["traceEvents"] = std::move(trace_events);
+    root["displayTimeUnit"] = "ns";
+    if (dropped > 0) {
+        root["otherData"] = {{"dropped_events", dropped}};
+    }
+
+    std::error_code ec;
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), ec);
+    }
+
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Failed to write trace " << path.string() << std::endl;
+        return false;
+    }
+    out << root.dump() << '\n';
+    if (dropped > 0) {
+        std::cerr << "Trace hit its event limit; " << dropped << " events were dropped" << std::endl;
+    }
+    return static_cast<bool>(out);
+}
+
+std::string TraceWriter::generate_filename(const std::string& prefix, const char* extension) {
+    auto now = std::chrono::system_clock::now();
+    auto time_t = std::chrono::system_clock::to_time_t(now);
+
+    std::ostringstream oss;
+    oss << prefix << "_" << std::put_time(std::localtime(&time_t), "%Y%m%d_%H%M%S") << extension;
+    return oss.str();
+}
+
+} // namespace emu
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+namespace emu {
+
+class Tracer;
+
+// Saves what a Tracer recorded as Chrome trace event JSON, which loads in
+// Perfetto (ui.perfetto.dev) and chrome://tracing
+class TraceWriter {
+public:
+    // Write and clear the recorded events; returns false if the file
+    // can't be written
+    static bool write(Tracer& tracer, const std::filesystem::path& path);
+
+    // Generate a timestamped filename for traces
+    static std::string generate_filename(const std::string& prefix = "trace",
+                                         const char* extension = ".json");
+};
+
+} // namespace emu
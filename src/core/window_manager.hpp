@@ -44,6 +44,7 @@ public:
     int get_width() const { return m_width; }
     int get_height() const { return m_height; }
     bool is_fullscreen() const { return m_fullscreen; }
+    bool is_vsync_enabled() const { return m_vsync; }
 
     // Frame management
     void swap_buffers();
@@ -4,10 +4,54 @@
 #include "emu/emulator_plugin.hpp"
 
 #include <imgui.h>
+#include <algorithm>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 namespace emu {
 
+namespace {
+
+// "7E0 75-7F, 3D" into addresses; false on anything else
+bool parse_addresses(const char* text, std::vector<uint32_t>& addresses) {
+    addresses.clear();
+    while (*text) {
+        if (*text == ' ' || *text == ',') {
+            text++;
+            continue;
+        }
+        char* end = nullptr;
+        unsigned long first = std::strtoul(text, &end, 16);
+        if (end == text) return false;
+        unsigned long last = first;
+        text = end;
+        if (*text == '-') {
+            last = std::strtoul(text + 1, &end, 16);
+            if (end == text + 1 || last < first || last - first >= RamRecorder::MAX_COLUMNS) return false;
+            text = end;
+        }
+        for (unsigned long address = first; address <= last; address++) {
+            addresses.push_back(static_cast<uint32_t>(address));
+        }
+    }
+    return true;
+}
+
+// Where a RAM search starts: WRAM, else the first domain that is one array
+// small enough to search. Buses are last, as they're read a byte at a time.
+size_t default_search_domain(const std::vector<MemoryDomain>& domains) {
+    for (size_t i = 0; i < domains.size(); i++) {
+        if (std::strcmp(domains[i].name, "WRAM") == 0) return i;
+    }
+    for (size_t i = 0; i < domains.size(); i++) {
+        if (domains[i].data && domains[i].size <= MemoryScanner::MAX_DOMAIN_SIZE) return i;
+    }
+    return 0;
+}
+
+} // namespace
+
 DebugPanel::DebugPanel() {
     // Add some default watches for NES
     m_watches.push_back({0x0000, "Zero Page 0", true});
@@ -37,7 +81,7 @@ void DebugPanel::render(Application& app, bool& visible) {
         // Tabs for different debug views
         if (ImGui::BeginTabBar("DebugTabs")) {
             if (ImGui::BeginTabItem("Timing")) {
-                render_timing_info(plugin);
+                render_timing_info(plugin, app.get_plugin_manager().get_rom_sha1());
                 ImGui::EndTabItem();
             }
 
@@ -46,6 +90,16 @@ void DebugPanel::render(Application& app, bool& visible) {
                 ImGui::EndTabItem();
             }
 
+            if (ImGui::BeginTabItem("Search")) {
+                render_ram_search(plugin);
+                ImGui::EndTabItem();
+            }
+
+            if (ImGui::BeginTabItem("Recorder")) {
+                render_ram_recorder(app, plugin);
+                ImGui::EndTabItem();
+            }
+
             if (ImGui::BeginTabItem("CPU")) {
                 render_cpu_state(plugin);
                 ImGui::EndTabItem();
@@ -56,13 +110,18 @@ void DebugPanel::render(Application& app, bool& visible) {
                 ImGui::EndTabItem();
             }
 
+            if (ImGui::BeginTabItem("Video")) {
+                m_vram_viewer.render(plugin);
+                ImGui::EndTabItem();
+            }
+
             ImGui::EndTabBar();
         }
     }
     ImGui::End();
 }
 
-void DebugPanel::render_timing_info(IEmulatorPlugin* plugin) {
+void DebugPanel::render_timing_info(IEmulatorPlugin* plugin, const std::string& rom_sha1) {
     if (!plugin || !plugin->is_rom_loaded()) {
         ImGui::Text("No ROM loaded");
         return;
@@ -73,6 +132,8 @@ void DebugPanel::render_timing_info(IEmulatorPlugin* plugin) {
     ImGui::Text("System: %s", info.name);
     ImGui::Text("Native FPS: %.4f", info.native_fps);
     ImGui::Text("CPU Clock: %lu Hz", static_cast<unsigned long>(info.cycles_per_second));
+    ImGui::Text("ROM CRC32: %08X", plugin->get_rom_crc32());
+    ImGui::Text("ROM SHA-1: %s", rom_sha1.empty() ? "(hashing...)" : rom_sha1.c_str());
     ImGui::Separator();
 
     ImGui::Text("Frame Count: %lu", static_cast<unsigned long>(plugin->get_frame_count()));
@@ -94,27 +155,72 @@ void DebugPanel::render_memory_viewer(IEmulatorPlugin* plugin) {
         return;
     }
 
+    auto domains = plugin->get_memory_domains();
+    if (m_memory_domain >= domains.size()) {
+        m_memory_domain = 0;
+        m_memory_start_address = 0;
+    }
+
+    // Domain selection
+    ImGui::SetNextItemWidth(120);
+    if (ImGui::BeginCombo("Domain", domains[m_memory_domain].name)) {
+        for (size_t i = 0; i < domains.size(); i++) {
+            if (ImGui::Selectable(domains[i].name, i == m_memory_domain)) {
+                m_memory_domain = i;
+                m_memory_start_address = 0;
+            }
+        }
+        ImGui::EndCombo();
+    }
+    const MemoryDomain& domain = domains[m_memory_domain];
+    ImGui::SameLine();
+
     // Address input
     ImGui::SetNextItemWidth(100);
-    ImGui::InputScalar("Start Address", ImGuiDataType_U16, &m_memory_start_address, nullptr, nullptr, "%04X", ImGuiInputTextFlags_CharsHexadecimal);
-    ImGui::SameLine();
+    ImGui::InputScalar("Start Address", ImGuiDataType_U32, &m_memory_start_address, nullptr, nullptr, "%X", ImGuiInputTextFlags_CharsHexadecimal);
 
-    // Quick navigation
-    if (ImGui::Button("Zero Page")) m_memory_start_address = 0x0000;
-    ImGui::SameLine();
-    if (ImGui::Button("Stack")) m_memory_start_address = 0x0100;
-    ImGui::SameLine();
-    if (ImGui::Button("RAM")) m_memory_start_address = 0x0200;
-    ImGui::SameLine();
-    if (ImGui::Button("PPU")) m_memory_start_address = 0x2000;
+    // Quick navigation (NES CPU bus)
+    if (m_memory_domain == 0) {
+        ImGui::SameLine();
+        if (ImGui::Button("Zero Page")) m_memory_start_address = 0x0000;
+        ImGui::SameLine();
+        if (ImGui::Button("Stack")) m_memory_start_address = 0x0100;
+        ImGui::SameLine();
+        if (ImGui::Button("RAM")) m_memory_start_address = 0x0200;
+        ImGui::SameLine();
+        if (ImGui::Button("PPU")) m_memory_start_address = 0x2000;
+    }
 
     ImGui::Separator();
 
-    // Memory display
+    // Memory display: the visible page is fetched with one call, or read
+    // straight from the domain when the core exposes it as an array
     const int rows = 16;
+    const uint32_t page_size = static_cast<uint32_t>(rows * m_memory_columns);
+    uint32_t length = std::min(domain.size, page_size);
+    if (m_memory_start_address > domain.size - length) {
+        m_memory_start_address = domain.size - length;
+    }
+
+    const uint8_t* bytes = nullptr;
+    if (domain.data) {
+        bytes = domain.data + m_memory_start_address;
+    } else {
+        m_memory_page.resize(page_size);
+        if (plugin->read_memory_block(m_memory_domain, m_memory_start_address, length, m_memory_page.data())) {
+            bytes = m_memory_page.data();
+        }
+    }
+    if (length == 0 || !bytes) {
+        ImGui::Text("%s is empty", domain.name);
+        length = 0;
+    }
+
+    // Wide enough for the domain's last address
+    int digits = domain.size > 0x1000000 ? 8 : domain.size > 0x10000 ? 6 : 4;
 
     // Header
-    ImGui::Text("       ");
+    ImGui::Text("%*s", digits + 3, "");
     for (int i = 0; i < m_memory_columns; i++) {
         ImGui::SameLine();
         ImGui::Text("%02X", i);
@@ -125,15 +231,14 @@ void DebugPanel::render_memory_viewer(IEmulatorPlugin* plugin) {
     }
 
     // Memory rows
-    for (int row = 0; row < rows; row++) {
-        uint16_t addr = m_memory_start_address + row * m_memory_columns;
-        ImGui::Text("%04X: ", addr);
+    for (uint32_t offset = 0; offset < length; offset += m_memory_columns) {
+        uint32_t addr = m_memory_start_address + offset;
+        ImGui::Text("%0*X: ", digits, addr);
 
         char ascii[17] = {0};
 
-        for (int col = 0; col < m_memory_columns; col++) {
-            uint16_t current_addr = addr + col;
-            uint8_t value = plugin->read_memory(current_addr);
+        for (int col = 0; col < m_memory_columns && offset + col < length; col++) {
+            uint8_t value = bytes[offset + col];
 
             ImGui::SameLine();
             ImGui::Text("%02X", value);
@@ -156,7 +261,10 @@ void DebugPanel::render_memory_viewer(IEmulatorPlugin* plugin) {
 
     for (size_t i = 0; i < m_watches.size(); i++) {
         auto& watch = m_watches[i];
-        uint8_t value = plugin->read_memory(watch.address);
+        uint8_t value = 0;
+        if (!plugin->read_memory_block(watch.domain, watch.address, 1, &value)) {
+            continue;
+        }
 
         if (watch.show_hex) {
             ImGui::Text("$%04X %-16s = $%02X (%3d)",
@@ -168,6 +276,216 @@ void DebugPanel::render_memory_viewer(IEmulatorPlugin* plugin) {
     }
 }
 
+void DebugPanel::render_ram_search(IEmulatorPlugin* plugin) {
+    if (!plugin || !plugin->is_rom_loaded()) {
+        m_scanner.stop();
+        ImGui::Text("No ROM loaded");
+        return;
+    }
+
+    auto domains = plugin->get_memory_domains();
+    if (domains.empty()) {
+        m_scanner.stop();
+        ImGui::Text("No memory domains");
+        return;
+    }
+    if (m_search_domain >= domains.size()) {
+        m_search_domain = default_search_domain(domains);
+        m_scanner.stop();
+    }
+
+    // Snapshot every frame the tab is shown, so the list tracks the game.
+    // Domains that aren't one array are read a byte at a time, so those are
+    // only read again when filtering.
+    bool live = m_scanner.is_active() && domains[m_scanner.get_domain()].data;
+    if (live && !m_scanner.refresh(*plugin)) {
+        m_scanner.stop();
+    }
+
+    if (!m_scanner.is_active()) {
+        ImGui::SetNextItemWidth(120);
+        if (ImGui::BeginCombo("Domain", domains[m_search_domain].name)) {
+            for (size_t i = 0; i < domains.size(); i++) {
+                if (domains[i].size > MemoryScanner::MAX_DOMAIN_SIZE) continue;
+                if (ImGui::Selectable(domains[i].name, i == m_search_domain)) {
+                    m_search_domain = i;
+                }
+            }
+            ImGui::EndCombo();
+        }
+        ImGui::SameLine();
+        ImGui::RadioButton("1 byte", &m_search_width, 1);
+        ImGui::SameLine();
+        ImGui::RadioButton("2 bytes", &m_search_width, 2);
+        ImGui::SameLine();
+        ImGui::RadioButton("4 bytes", &m_search_width, 4);
+        ImGui::SameLine();
+        ImGui::Checkbox("Signed", &m_search_signed);
+
+        if (ImGui::Button("New Search")) {
+            m_scanner.start(*plugin, m_search_domain, m_search_width, m_search_signed);
+        }
+        if (domains[m_search_domain].size > MemoryScanner::MAX_DOMAIN_SIZE) {
+            ImGui::Text("%s is too large to search", domains[m_search_domain].name);
+        }
+        return;
+    }
+
+    ImGui::Text("%s, %d-byte %s values: %zu candidates", domains[m_scanner.get_domain()].name,
+                m_scanner.get_width(), m_scanner.is_signed() ? "signed" : "unsigned",
+                m_scanner.get_candidate_count());
+
+    static const char* compare_names[] = {"Equal to", "Not equal to", "Greater than", "Less than"};
+    ImGui::SetNextItemWidth(120);
+    ImGui::Combo("##compare", &m_search_compare, compare_names, IM_ARRAYSIZE(compare_names));
+    ImGui::SameLine();
+    if (ImGui::RadioButton("Previous", m_search_vs_previous)) m_search_vs_previous = true;
+    ImGui::SameLine();
+    if (ImGui::RadioButton("Value", !m_search_vs_previous)) m_search_vs_previous = false;
+    if (!m_search_vs_previous) {
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(100);
+        ImGui::InputInt("##value", &m_search_value);
+    }
+
+    if (ImGui::Button("Filter")) {
+        if (!live && !m_scanner.refresh(*plugin)) {
+            m_scanner.stop();
+            return;
+        }
+        m_scanner.filter(static_cast<ScanCompare>(m_search_compare), m_search_vs_previous,
+                         static_cast<uint32_t>(m_search_value));
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Reset")) m_scanner.reset_candidates();
+    ImGui::SameLine();
+    if (ImGui::Button("Stop")) {
+        m_scanner.stop();
+        return;
+    }
+
+    ImGui::Separator();
+
+    // Only the first candidates are listed; filter further to see the rest
+    constexpr int MAX_LISTED = 256;
+    int digits = domains[m_scanner.get_domain()].size > 0x10000 ? 6 : 4;
+    bool is_signed = m_scanner.is_signed();
+    int shift = 32 - 8 * m_scanner.get_width();
+
+    ImGui::BeginChild("##candidates");
+    uint32_t address = m_scanner.next_candidate(0);
+    for (int listed = 0; listed < MAX_LISTED && address != UINT32_MAX; listed++) {
+        uint32_t current = m_scanner.get_current_value(address);
+        uint32_t previous = m_scanner.get_previous_value(address);
+        if (is_signed) {
+            ImGui::Text("%0*X: %11d (was %d)", digits, address,
+                        static_cast<int32_t>(current << shift) >> shift,
+                        static_cast<int32_t>(previous << shift) >> shift);
+        } else {
+            ImGui::Text("%0*X: %11u (was %u)", digits, address, current, previous);
+        }
+        ImGui::SameLine();
+        ImGui::PushID(static_cast<int>(address));
+        if (ImGui::SmallButton("Watch")) {
+            char label[32];
+            std::snprintf(label, sizeof(label), "%s %X", domains[m_scanner.get_domain()].name, address);
+            m_watches.push_back({address, label, true, m_scanner.get_domain()});
+        }
+        ImGui::PopID();
+        address = m_scanner.next_candidate(address + 1);
+    }
+    ImGui::EndChild();
+}
+
+void DebugPanel::render_ram_recorder(Application& app, IEmulatorPlugin* plugin) {
+    RamRecorder& recorder = app.get_ram_recorder();
+    if (!plugin || !plugin->is_rom_loaded()) {
+        ImGui::Text("No ROM loaded");
+        return;
+    }
+
+    auto domains = plugin->get_memory_domains();
+    if (m_record_domain >= domains.size()) {
+        m_record_domain = 0;
+    }
+
+    if (!recorder.is_active()) {
+        ImGui::SetNextItemWidth(120);
+        if (ImGui::BeginCombo("Domain", domains[m_record_domain].name)) {
+            for (size_t i = 0; i < domains.size(); i++) {
+                if (ImGui::Selectable(domains[i].name, i == m_record_domain)) {
+                    m_record_domain = i;
+                }
+            }
+            ImGui::EndCombo();
+        }
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(200);
+        ImGui::InputTextWithHint("##addresses", "all, or e.g. 75 3D-3F", m_record_addresses,
+                                 sizeof(m_record_addresses));
+        ImGui::SameLine();
+        if (ImGui::Button("Record")) {
+            std::vector<uint32_t> addresses;
+            if (!parse_addresses(m_record_addresses, addresses)) {
+                m_record_status = "Addresses are hex, separated by spaces or commas";
+            } else if (!recorder.start(*plugin, m_record_domain, addresses)) {
+                m_record_status = "Can't record that; whole domains are limited to 16 KB";
+            } else {
+                m_record_status.clear();
+                m_graph_address = recorder.get_column_address(0);
+            }
+        }
+    } else if (ImGui::Button("Stop")) {
+        recorder.stop();
+    }
+
+    if (recorder.get_frame_count() > 0) {
+        if (!recorder.is_active()) ImGui::SameLine();
+        if (ImGui::Button("Export CSV")) {
+            std::string path = app.export_ram_recording();
+            m_record_status = path.empty() ? "Failed to export the recording" : "Saved to " + path;
+        }
+    }
+    if (!m_record_status.empty()) {
+        ImGui::TextUnformatted(m_record_status.c_str());
+    }
+    if (recorder.get_column_count() == 0) return;
+
+    ImGui::Text("%zu frames (%llu-%llu) of %zu bytes in %.1f KB%s", recorder.get_frame_count(),
+                static_cast<unsigned long long>(recorder.get_first_frame()),
+                static_cast<unsigned long long>(recorder.get_last_frame()),
+                recorder.get_column_count(), recorder.get_memory_used() / 1024.0,
+                recorder.is_active() ? "" : ", stopped");
+    ImGui::Separator();
+
+    ImGui::SetNextItemWidth(100);
+    ImGui::InputScalar("Address", ImGuiDataType_U32, &m_graph_address, nullptr, nullptr, "%X",
+                       ImGuiInputTextFlags_CharsHexadecimal);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(160);
+    ImGui::SliderInt("Frames", &m_graph_frames, 60, 36000, "%d", ImGuiSliderFlags_Logarithmic);
+
+    size_t column = recorder.find_column(m_graph_address);
+    if (column == SIZE_MAX) {
+        ImGui::Text("%X isn't recorded", m_graph_address);
+        return;
+    }
+
+    // The newest frames, with frames never recorded drawn as 0
+    size_t count = static_cast<size_t>(m_graph_frames);
+    uint64_t last = recorder.get_last_frame();
+    uint64_t first = last + 1 >= count ? last + 1 - count : 0;
+    m_graph_bytes.assign(count, 0);
+    recorder.read_column(column, first, count, m_graph_bytes.data());
+    m_graph_values.assign(m_graph_bytes.begin(), m_graph_bytes.end());
+
+    char overlay[48];
+    std::snprintf(overlay, sizeof(overlay), "%X = %u at frame %llu", m_graph_address, m_graph_bytes.back(),
+                  static_cast<unsigned long long>(last));
+    ImGui::PlotLines("##graph", m_graph_values.data(), static_cast<int>(m_graph_values.size()), 0, overlay,
+                     0.0f, 255.0f, ImVec2(ImGui::GetContentRegionAvail().x, 160));
+}
+
 void DebugPanel::render_cpu_state(IEmulatorPlugin* plugin) {
     if (!plugin || !plugin->is_rom_loaded()) {
         ImGui::Text("No ROM loaded");
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "../core/memory_scanner.hpp"
+#include "vram_viewer.hpp"
+
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -21,21 +24,46 @@ public:
 private:
     void render_cpu_state(IEmulatorPlugin* plugin);
     void render_memory_viewer(IEmulatorPlugin* plugin);
+    void render_ram_search(IEmulatorPlugin* plugin);
+    void render_ram_recorder(Application& app, IEmulatorPlugin* plugin);
     void render_ppu_state(IEmulatorPlugin* plugin);
-    void render_timing_info(IEmulatorPlugin* plugin);
+    void render_timing_info(IEmulatorPlugin* plugin, const std::string& rom_sha1);
 
     // Memory viewer state
-    uint16_t m_memory_start_address = 0x0000;
+    size_t m_memory_domain = 0;         // Index into get_memory_domains()
+    uint32_t m_memory_start_address = 0x0000;
     int m_memory_columns = 16;
     bool m_show_ascii = true;
+    std::vector<uint8_t> m_memory_page; // Visible bytes of a domain without a data pointer
 
     // Watch list for specific addresses
     struct WatchEntry {
-        uint16_t address;
+        uint32_t address;
         std::string label;
         bool show_hex;
+        size_t domain = 0;              // Memory domain, the CPU bus by default
     };
     std::vector<WatchEntry> m_watches;
+
+    // RAM search state
+    MemoryScanner m_scanner;
+    size_t m_search_domain = SIZE_MAX;  // SIZE_MAX until a ROM's domains pick one
+    int m_search_width = 1;             // Bytes
+    bool m_search_signed = false;
+    int m_search_compare = 0;           // ScanCompare
+    bool m_search_vs_previous = true;   // Else against m_search_value
+    int m_search_value = 0;
+
+    // RAM recorder state
+    size_t m_record_domain = 0;
+    char m_record_addresses[256] = "";  // Hex addresses and ranges; empty records the domain
+    uint32_t m_graph_address = 0;
+    int m_graph_frames = 600;           // Frames shown, ending at the newest
+    std::vector<float> m_graph_values;
+    std::vector<uint8_t> m_graph_bytes;
+    std::string m_record_status;
+
+    VramViewer m_vram_viewer;
 };
 
 } // namespace emu
@@ -1,5 +1,6 @@
 #include "gui_manager.hpp"
 #include "debug_panel.hpp"
+#include "tas_editor_panel.hpp"
 #include "input_config_panel.hpp"
 #include "plugin_config_panel.hpp"
 #include "paths_config_panel.hpp"
@@ -13,14 +14,18 @@
 #include "core/savestate_manager.hpp"
 #include "core/paths_config.hpp"
 #include "emu/game_plugin.hpp"
+#include "emu/state_chunks.hpp"
 
 #include <chrono>
+#include <cmath>
 #include <cstring>
+#include <cstdio>
 #include <ctime>
 #include <iomanip>
 #include <sstream>
 
 #include <SDL.h>
+#include <SDL_opengl.h>
 #include <imgui.h>
 #include <imgui_impl_sdl2.h>
 #include <imgui_impl_opengl3.h>
@@ -65,6 +70,7 @@ bool GuiManager::initialize(WindowManager& window_manager) {
     // Create GUI panels
     // Note: SpeedrunPanel has been moved into game plugins - they render their own GUI
     m_debug_panel = std::make_unique<DebugPanel>();
+    m_tas_editor_panel = std::make_unique<TASEditorPanel>();
     m_input_config_panel = std::make_unique<InputConfigPanel>();
     m_plugin_config_panel = std::make_unique<PluginConfigPanel>();
     m_paths_config_panel = std::make_unique<PathsConfigPanel>();
@@ -78,6 +84,13 @@ bool GuiManager::initialize(WindowManager& window_manager) {
 
 void GuiManager::shutdown() {
     if (m_initialized) {
+        for (SlotThumbnail& thumbnail : m_slot_thumbnails) {
+            if (thumbnail.texture) {
+                GLuint texture = thumbnail.texture;
+                glDeleteTextures(1, &texture);
+            }
+        }
+        m_slot_thumbnails.clear();
         ImGui_ImplOpenGL3_Shutdown();
         ImGui_ImplSDL2_Shutdown();
         ImGui::DestroyContext();
@@ -143,6 +156,11 @@ void GuiManager::render(Application& app, Renderer& renderer) {
         }
     }
 
+    // Render TAS editor (piano roll for the active TAS plugin)
+    if (m_show_tas_editor && m_tas_editor_panel) {
+        m_tas_editor_panel->render(app, m_show_tas_editor);
+    }
+
     // Render plugin configuration panel
     if (m_show_plugin_config && m_plugin_config_panel) {
         m_plugin_config_panel->render(app, m_show_plugin_config);
@@ -153,6 +171,12 @@ void GuiManager::render(Application& app, Renderer& renderer) {
         render_core_config(app);
     }
 
+    // Frame timings are only measured while the overlay is up
+    app.get_perf_monitor().set_enabled(m_show_perf_overlay);
+    if (m_show_perf_overlay) {
+        render_perf_overlay(app);
+    }
+
     // Render netplay GUI - handled by the netplay plugin
     {
         auto* netplay_plugin = app.get_plugin_manager().get_netplay_plugin();
@@ -236,6 +260,39 @@ void GuiManager::render_main_menu(Application& app) {
                 if (ImGui::MenuItem("Unlimited", nullptr, app.get_speed() == 0.0f)) {
                     app.set_speed(0.0f);
                 }
+                ImGui::Separator();
+                if (ImGui::BeginMenu("Fast-Forward Display")) {
+                    for (double rate : {30.0, 60.0, 120.0}) {
+                        char label[16];
+                        std::snprintf(label, sizeof(label), "%.0f fps", rate);
+                        if (ImGui::MenuItem(label, nullptr, app.get_fast_forward_display_rate() == rate)) {
+                            app.set_fast_forward_display_rate(rate);
+                        }
+                    }
+                    ImGui::EndMenu();
+                }
+                ImGui::EndMenu();
+            }
+            if (ImGui::MenuItem("Pace to Audio Clock", nullptr, app.is_audio_paced())) {
+                app.set_audio_paced(!app.is_audio_paced());
+            }
+            if (ImGui::MenuItem("Rewind", "Hold Backspace", app.is_rewind_enabled())) {
+                app.set_rewind_enabled(!app.is_rewind_enabled());
+            }
+            if (ImGui::MenuItem("Instant Replay", nullptr, app.is_instant_replay_enabled())) {
+                app.set_instant_replay_enabled(!app.is_instant_replay_enabled());
+            }
+            if (ImGui::BeginMenu("Run-Ahead")) {
+                if (ImGui::MenuItem("Off", nullptr, app.get_run_ahead_frames() == 0)) {
+                    app.set_run_ahead_frames(0);
+                }
+                for (int frames = 1; frames <= 4; frames++) {
+                    char label[16];
+                    std::snprintf(label, sizeof(label), "%d frame%s", frames, frames == 1 ? "" : "s");
+                    if (ImGui::MenuItem(label, nullptr, app.get_run_ahead_frames() == frames)) {
+                        app.set_run_ahead_frames(frames);
+                    }
+                }
                 ImGui::EndMenu();
             }
 
@@ -327,6 +384,18 @@ void GuiManager::render_main_menu(Application& app) {
                 m_show_debug_panel = !m_show_debug_panel;
             }
 
+            // Performance overlay
+            if (ImGui::MenuItem("Performance Overlay", nullptr, m_show_perf_overlay)) {
+                m_show_perf_overlay = !m_show_perf_overlay;
+            }
+
+            // TAS Editor (only with a TAS plugin active)
+            if (app.get_plugin_manager().get_tas_plugin()) {
+                if (ImGui::MenuItem("TAS Editor", nullptr, m_show_tas_editor)) {
+                    m_show_tas_editor = !m_show_tas_editor;
+                }
+            }
+
             // RAM Watch
             if (ImGui::MenuItem("RAM Watch", nullptr, m_show_ram_watch)) {
                 m_show_ram_watch = !m_show_ram_watch;
@@ -347,6 +416,95 @@ void GuiManager::render_main_menu(Application& app) {
         }
 
         if (ImGui::BeginMenu("Tools")) {
+            if (ImGui::MenuItem("Record Trace", nullptr, app.is_tracing(), Tracer::compiled_in())) {
+                if (app.is_tracing()) {
+                    std::string path = app.stop_trace();
+                    if (path.empty()) {
+                        m_notification_manager->error("Failed to save trace");
+                    } else {
+                        m_notification_manager->success("Trace saved to " + path);
+                    }
+                } else {
+                    app.start_trace();
+                }
+            }
+            if (!Tracer::compiled_in() && ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) {
+                ImGui::SetTooltip("Rebuild with -DVELOCE_ENABLE_TRACING=ON to record traces");
+            }
+            bool can_cpu_trace = app.is_cpu_tracing() || app.get_plugin_manager().is_rom_loaded();
+            if (ImGui::MenuItem("Record CPU Trace", nullptr, app.is_cpu_tracing(), can_cpu_trace)) {
+                if (app.is_cpu_tracing()) {
+                    std::string path = app.stop_cpu_trace();
+                    if (path.empty()) {
+                        m_notification_manager->error("Failed to save CPU trace");
+                    } else {
+                        m_notification_manager->success("CPU trace saved to " + path);
+                    }
+                } else if (!app.start_cpu_trace()) {
+                    m_notification_manager->error("This core can't record a CPU trace");
+                }
+            }
+            ImGui::Separator();
+            bool can_record = app.is_av_recording() || app.get_plugin_manager().is_rom_loaded();
+            if (ImGui::MenuItem("Record Video", nullptr, app.is_av_recording(), can_record)) {
+                if (app.is_av_recording()) {
+                    std::string files = app.stop_av_recording();
+                    if (files.empty()) {
+                        m_notification_manager->error("Failed to save recording");
+                    } else {
+                        m_notification_manager->success("Recording saved to " + files);
+                    }
+                } else if (!app.start_av_recording("", !m_record_every_frame)) {
+                    m_notification_manager->error("Failed to start recording");
+                }
+            }
+            if (ImGui::MenuItem("Keep Every Recorded Frame", nullptr, m_record_every_frame, !app.is_av_recording())) {
+                m_record_every_frame = !m_record_every_frame;
+            }
+            if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) {
+                ImGui::SetTooltip("Emulation waits for the writer instead of dropping frames.\n"
+                                  "Use for fast-forwarded or TAS encodes.");
+            }
+            bool can_save_replay = app.is_instant_replay_enabled() && !app.is_saving_instant_replay() &&
+                                   app.get_plugin_manager().is_rom_loaded();
+            if (ImGui::MenuItem("Save Instant Replay", nullptr, false, can_save_replay)) {
+                app.save_instant_replay();
+                m_notification_manager->info("Saving instant replay...");
+            }
+            if (ImGui::BeginMenu("Screenshot Burst", app.get_plugin_manager().is_rom_loaded())) {
+                const int burst_lengths[] = {60, 600, 3600};
+                for (int frames : burst_lengths) {
+                    std::string label = "Next " + std::to_string(frames) + " Frames";
+                    if (ImGui::MenuItem(label.c_str(), nullptr, false, !app.is_screenshot_burst())) {
+                        app.start_screenshot_burst(frames, m_burst_format);
+                    }
+                }
+                if (ImGui::MenuItem("Stop", nullptr, false, app.is_screenshot_burst())) {
+                    app.stop_screenshot_burst();
+                }
+                ImGui::Separator();
+                if (ImGui::MenuItem("QOI", nullptr, m_burst_format == ScreenshotFormat::Qoi)) {
+                    m_burst_format = ScreenshotFormat::Qoi;
+                }
+                if (ImGui::MenuItem("PNG (fast)", nullptr, m_burst_format == ScreenshotFormat::PngFast)) {
+                    m_burst_format = ScreenshotFormat::PngFast;
+                }
+                if (ImGui::MenuItem("BMP", nullptr, m_burst_format == ScreenshotFormat::Bmp)) {
+                    m_burst_format = ScreenshotFormat::Bmp;
+                }
+                ImGui::EndMenu();
+            }
+            ImGui::Separator();
+            if (ImGui::MenuItem("Share Frames", nullptr, app.is_frame_sharing())) {
+                if (!app.set_frame_sharing(!app.is_frame_sharing())) {
+                    m_notification_manager->error("Failed to create the shared frame buffer");
+                }
+            }
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Publish every frame at native resolution to shared memory,\n"
+                                  "for capture tools that read it directly.");
+            }
+            ImGui::Separator();
             if (ImGui::MenuItem("ImGui Demo", nullptr, m_show_demo_window)) {
                 m_show_demo_window = !m_show_demo_window;
             }
@@ -400,8 +558,8 @@ void GuiManager::render_game_view(Application& app, Renderer& renderer) {
     ImVec2 window_size = ImGui::GetContentRegionAvail();
 
     // Calculate scaled size maintaining aspect ratio
-    int tex_width = renderer.get_texture_width();
-    int tex_height = renderer.get_texture_height();
+    int tex_width = renderer.get_display_width();
+    int tex_height = renderer.get_display_height();
 
     if (tex_width > 0 && tex_height > 0) {
         float aspect = static_cast<float>(tex_width) / tex_height;
@@ -525,6 +683,70 @@ void GuiManager::render_rom_browser(Application& app) {
     ImGui::End();
 }
 
+void GuiManager::render_perf_overlay(Application& app) {
+    PerfMonitor& perf = app.get_perf_monitor();
+    AudioManager& audio = app.get_audio_manager();
+    float budget = perf.get_budget_ms();
+
+    float padding = 10.0f;
+    ImVec2 viewport_pos = ImGui::GetMainViewport()->Pos;
+    ImGui::SetNextWindowPos(ImVec2(viewport_pos.x + padding, viewport_pos.y + ImGui::GetFrameHeight() + padding));
+    ImGui::SetNextWindowBgAlpha(0.7f);
+
+    ImGuiWindowFlags flags =
+        ImGuiWindowFlags_NoDecoration |
+        ImGuiWindowFlags_AlwaysAutoResize |
+        ImGuiWindowFlags_NoSavedSettings |
+        ImGuiWindowFlags_NoFocusOnAppearing |
+        ImGuiWindowFlags_NoNav |
+        ImGuiWindowFlags_NoMove;
+
+    if (ImGui::Begin("PerfOverlay", nullptr, flags)) {
+        if (budget > 0.0f) {
+            ImGui::Text("Frame budget %.2f ms", budget);
+        } else {
+            ImGui::TextUnformatted("Frame budget: unpaced");
+        }
+
+        // One graph per series, with its average and worst in the label.
+        // Frame phases share a 0..budget scale so they read against it.
+        float values[PerfMonitor::HISTORY];
+        auto plot = [&](const char* name, PerfMonitor::Series series, float scale_min, float scale_max) {
+            size_t count = perf.copy(series, values);
+            float sum = 0.0f;
+            float worst = 0.0f;
+            for (size_t i = 0; i < count; i++) {
+                sum += values[i];
+                if (std::abs(values[i]) > std::abs(worst)) worst = values[i];
+            }
+            char label[64];
+            std::snprintf(label, sizeof(label), "avg %.2f  max %.2f", count ? sum / count : 0.0f, worst);
+            ImGui::TextUnformatted(name);
+            ImGui::PushID(series);
+            ImGui::PlotLines("##plot", values, static_cast<int>(count), 0, label, scale_min, scale_max,
+                             ImVec2(260, 40));
+            ImGui::PopID();
+        };
+
+        float phase_max = budget > 0.0f ? budget : 16.7f;
+        plot("Emulation (ms)", PerfMonitor::EMULATE, 0.0f, phase_max);
+        plot("Pacing error (ms)", PerfMonitor::PACING_ERROR, -phase_max / 2.0f, phase_max / 2.0f);
+
+        double target_ms = 0.0;
+        if (audio.get_sample_rate() > 0) {
+            target_ms = static_cast<double>(audio.get_target_buffered_samples()) / 2.0 * 1000.0 /
+                        audio.get_sample_rate();
+        }
+        plot("Audio buffer (ms)", PerfMonitor::AUDIO_FILL, 0.0f, static_cast<float>(target_ms * 2.0));
+        ImGui::Text("Underruns %zu  Overruns %zu", audio.get_underrun_count(), audio.get_overrun_count());
+
+        plot("Texture upload (ms)", PerfMonitor::TEXTURE_UPLOAD, 0.0f, phase_max);
+        plot("GUI (ms)", PerfMonitor::GUI, 0.0f, phase_max);
+        plot("Present (ms)", PerfMonitor::PRESENT, 0.0f, phase_max);
+    }
+    ImGui::End();
+}
+
 void GuiManager::render_core_config(Application& app) {
     ImGui::SetNextWindowSize(ImVec2(450, 400), ImGuiCond_FirstUseEver);
 
@@ -611,10 +833,10 @@ void GuiManager::render_core_config(Application& app) {
                 plugin = plugin_manager.get_active_plugin();
                 plugin_name = plugin ? plugin->get_info().name : "";
             } else {
-                // No game loaded - use the registry instance for preview
-                const auto& selected_inst = emu_plugins[m_selected_core_index];
-                plugin = selected_inst.plugin;
-                plugin_name = selected_inst.name;
+                // No game loaded - use the registry instance for preview,
+                // which loads the core the first time it's shown
+                plugin_name = emu_plugins[m_selected_core_index].name;
+                plugin = plugin_manager.get_emulator_plugin_by_name(plugin_name);
             }
 
             if (plugin && plugin->has_config_gui()) {
@@ -654,6 +876,18 @@ void GuiManager::render_settings(Application& app) {
                     ImGui::SetTooltip("Automatically pause emulation when you click outside the window");
                 }
 
+                // Warm ROM switching
+                PluginManager& plugins = app.get_plugin_manager();
+                int warm_mb = static_cast<int>(plugins.get_warm_rom_budget() >> 20);
+                if (ImGui::SliderInt("Warm game memory (MB)", &warm_mb, 0, 1024)) {
+                    plugins.set_warm_rom_budget(static_cast<size_t>(warm_mb) << 20);
+                }
+                if (ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("Keep games you switch away from loaded, so switching back\n"
+                                      "resumes them at once (0 turns this off)");
+                }
+                ImGui::Text("Warm games: %zu", plugins.get_warm_rom_count());
+
                 ImGui::EndTabItem();
             }
 
@@ -672,6 +906,62 @@ void GuiManager::render_settings(Application& app) {
                     app.get_window_manager().set_vsync(vsync);
                 }
 
+                static const char* const present_modes[] = {"Timer", "Display Locked", "Variable Refresh"};
+                int present_mode = static_cast<int>(app.get_present_mode());
+                if (ImGui::Combo("Presentation", &present_mode, present_modes, IM_ARRAYSIZE(present_modes))) {
+                    app.set_present_mode(static_cast<PresentMode>(present_mode));
+                }
+                if (ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("Timer: emulation keeps the core's own frame rate; frames may repeat or skip on the display\n"
+                                      "Display Locked: every vsync shows one frame; audio absorbs the small speed difference\n"
+                                      "Variable Refresh: each frame is shown as soon as it's ready (G-Sync/FreeSync)");
+                }
+                if (app.get_present_mode() == PresentMode::DisplayLocked) {
+                    double refresh = app.get_refresh_rate();
+                    if (refresh > 0.0) {
+                        ImGui::Text("Display: %.3f Hz", refresh);
+                    } else {
+                        ImGui::TextDisabled("Display: not measured (needs VSync)");
+                    }
+                }
+
+                // Built-in shaders, run by the renderer on the GPU
+                Renderer& renderer = app.get_renderer();
+                if (renderer.get_shader_count() > 0) {
+                    ImGui::Separator();
+                    int active = renderer.get_active_shader();
+                    const char* preview = active >= 0 ? renderer.get_shader_info(active).name : "None";
+                    if (ImGui::BeginCombo("Shader", preview)) {
+                        if (ImGui::Selectable("None", active < 0)) {
+                            renderer.set_active_shader(-1);
+                        }
+                        for (int i = 0; i < renderer.get_shader_count(); i++) {
+                            ShaderInfo info = renderer.get_shader_info(i);
+                            if (ImGui::Selectable(info.name, active == i)) {
+                                renderer.set_active_shader(i);
+                            }
+                            if (ImGui::IsItemHovered()) {
+                                ImGui::SetTooltip("%s", info.description);
+                            }
+                        }
+                        ImGui::EndCombo();
+                    }
+
+                    active = renderer.get_active_shader();
+                    for (int p = 0; p < renderer.get_shader_parameter_count(active); p++) {
+                        ShaderParameter param = renderer.get_shader_parameter(active, p);
+                        float value = param.current_value;
+                        ImGui::PushID(p);
+                        if (ImGui::SliderFloat(param.name, &value, param.min_value, param.max_value)) {
+                            renderer.set_shader_parameter(active, p, value);
+                        }
+                        if (ImGui::IsItemHovered()) {
+                            ImGui::SetTooltip("%s", param.description);
+                        }
+                        ImGui::PopID();
+                    }
+                }
+
                 ImGui::EndTabItem();
             }
 
@@ -682,10 +972,74 @@ void GuiManager::render_settings(Application& app) {
                     app.get_audio_manager().set_volume(volume);
                 }
 
+                // Output path; switching reopens the device (the emulation
+                // lock is held here, so the core isn't pushing meanwhile)
+                AudioManager& audio = app.get_audio_manager();
+                AudioBackendType backend = audio.get_backend();
+                if (ImGui::BeginCombo("Backend", get_audio_backend_name(backend))) {
+                    for (int i = 0; i < static_cast<int>(AudioBackendType::COUNT); i++) {
+                        AudioBackendType type = static_cast<AudioBackendType>(i);
+                        if (!is_audio_backend_available(type)) continue;
+                        if (ImGui::Selectable(get_audio_backend_name(type), type == backend) && type != backend) {
+                            if (!audio.set_backend(type)) {
+                                m_notification_manager->error(std::string("Couldn't open ") +
+                                                              get_audio_backend_name(type) + " audio");
+                            }
+                        }
+                    }
+                    ImGui::EndCombo();
+                }
+                if (audio.is_initialized()) {
+                    ImGui::Text("Latency: %.1f ms (%d Hz, %d frame periods)", audio.get_latency_ms(),
+                                audio.get_sample_rate(), audio.get_buffer_size());
+                }
+
+                // Effects of the active audio plugin; it hands the changes to
+                // the audio path itself, so no locking here
+                IAudioPlugin* audio_plugin = app.get_plugin_manager().get_audio_plugin();
+                if (audio_plugin && audio_plugin->get_effect_count() > 0) {
+                    ImGui::Separator();
+                    ImGui::Text("Effects");
+                    for (int i = 0; i < audio_plugin->get_effect_count(); i++) {
+                        const char* name = audio_plugin->get_effect_name(i);
+                        ImGui::PushID(i);
+                        bool enabled = audio_plugin->is_effect_enabled(i);
+                        if (ImGui::Checkbox(name ? name : "Effect", &enabled)) {
+                            audio_plugin->set_effect_enabled(i, enabled);
+                        }
+                        if (enabled) {
+                            ImGui::Indent();
+                            for (int p = 0; p < audio_plugin->get_effect_parameter_count(i); p++) {
+                                AudioEffectParameterInfo info{};
+                                if (!audio_plugin->get_effect_parameter_info(i, p, info)) continue;
+                                float value = audio_plugin->get_effect_parameter(i, p);
+                                ImGui::PushID(p);
+                                if (ImGui::SliderFloat(info.name, &value, info.min_value, info.max_value)) {
+                                    audio_plugin->set_effect_parameter(i, p, value);
+                                }
+                                ImGui::PopID();
+                            }
+                            ImGui::Unindent();
+                        }
+                        ImGui::PopID();
+                    }
+                }
+
                 ImGui::EndTabItem();
             }
 
             if (ImGui::BeginTabItem("Input")) {
+                InputManager& input = app.get_input_manager();
+                bool polling = input.is_polling();
+                if (ImGui::Checkbox("Poll Controllers at 1 kHz", &polling)) {
+                    input.set_polling(polling);
+                }
+                if (ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("Read gamepads on their own thread every millisecond instead of once per\n"
+                                      "displayed frame, so a press reaches the core's next input latch sooner");
+                }
+                ImGui::Separator();
+
                 // Render the input configuration panel
                 if (m_input_config_panel) {
                     if (m_input_config_panel->render(app)) {
@@ -735,6 +1089,41 @@ std::string GuiManager::format_savestate_slot_label(int slot, bool has_save, int
     return label.str();
 }
 
+void GuiManager::show_slot_thumbnail(SavestateManager& savestates, int slot) {
+    m_slot_thumbnails.resize(SavestateManager::NUM_SLOTS);
+    SlotThumbnail& entry = m_slot_thumbnails[slot];
+
+    SavestateThumbnail thumbnail;
+    if (savestates.get_slot_thumbnail(slot, entry.generation, thumbnail)) {
+        entry.width = thumbnail.width;
+        entry.height = thumbnail.height;
+        if (entry.width > 0) {
+            GLuint texture = entry.texture;
+            if (!texture) {
+                glGenTextures(1, &texture);
+                entry.texture = texture;
+                glBindTexture(GL_TEXTURE_2D, texture);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            } else {
+                glBindTexture(GL_TEXTURE_2D, texture);
+            }
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, entry.width, entry.height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                         thumbnail.pixels.data());
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+    }
+
+    if (entry.width > 0 && ImGui::IsItemHovered()) {
+        ImGui::BeginTooltip();
+        ImGui::Image(reinterpret_cast<ImTextureID>(static_cast<intptr_t>(entry.texture)),
+                     ImVec2(entry.width * 2.0f, entry.height * 2.0f));
+        ImGui::EndTooltip();
+    }
+}
+
 void GuiManager::render_save_state_menu(Application& app) {
     bool rom_loaded = app.get_plugin_manager().is_rom_loaded();
 
@@ -751,7 +1140,9 @@ void GuiManager::render_save_state_menu(Application& app) {
             // Hotkey text: Shift+F1 through Shift+F10
             std::string hotkey = "Shift+F" + std::to_string(slot + 1);
 
-            if (ImGui::MenuItem(label.c_str(), hotkey.c_str())) {
+            bool clicked = ImGui::MenuItem(label.c_str(), hotkey.c_str());
+            show_slot_thumbnail(savestate_mgr, slot);
+            if (clicked) {
                 std::ostringstream msg;
                 if (savestate_mgr.save_state(slot)) {
                     msg << "State saved to slot " << (slot + 1);
@@ -795,7 +1186,9 @@ void GuiManager::render_load_state_menu(Application& app) {
             std::string hotkey = "F" + std::to_string(slot + 1);
 
             // Disable menu item if slot is empty
-            if (ImGui::MenuItem(label.c_str(), hotkey.c_str(), false, info.valid)) {
+            bool clicked = ImGui::MenuItem(label.c_str(), hotkey.c_str(), false, info.valid);
+            show_slot_thumbnail(savestate_mgr, slot);
+            if (clicked) {
                 std::ostringstream msg;
                 if (savestate_mgr.load_state(slot)) {
                     msg << "State loaded from slot " << (slot + 1);
@@ -807,6 +1200,27 @@ void GuiManager::render_load_state_menu(Application& app) {
             }
         }
 
+        // Restore just a slot's work RAM, keeping CPU, video and timing as they are
+        if (ImGui::BeginMenu("Load Work RAM Only")) {
+            const uint32_t tags[] = {emu::STATE_CHUNK_WORK_RAM};
+            for (int slot = 0; slot < SavestateManager::NUM_SLOTS; ++slot) {
+                SavestateInfo info = savestate_mgr.get_slot_info(slot);
+                std::string label = format_savestate_slot_label(slot, info.valid, info.timestamp);
+
+                if (ImGui::MenuItem(label.c_str(), nullptr, false, info.valid)) {
+                    std::ostringstream msg;
+                    if (savestate_mgr.load_state_chunks(slot, tags, 1)) {
+                        msg << "Work RAM loaded from slot " << (slot + 1);
+                        notifications.success(msg.str());
+                    } else {
+                        msg << "Failed to load work RAM from slot " << (slot + 1);
+                        notifications.error(msg.str());
+                    }
+                }
+            }
+            ImGui::EndMenu();
+        }
+
         ImGui::Separator();
 
         // Load from file option
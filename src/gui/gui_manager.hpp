@@ -1,7 +1,11 @@
 #pragma once
 
+#include "core/screenshot.hpp"
+
+#include <cstdint>
 #include <string>
 #include <memory>
+#include <vector>
 
 struct SDL_Window;
 typedef void* SDL_GLContext;
@@ -13,10 +17,12 @@ class Application;
 class WindowManager;
 class Renderer;
 class DebugPanel;
+class TASEditorPanel;
 class InputConfigPanel;
 class PluginConfigPanel;
 class PathsConfigPanel;
 class NotificationManager;
+class SavestateManager;
 
 class GuiManager {
 public:
@@ -67,11 +73,22 @@ private:
     void render_settings(Application& app);
     void render_savestate_file_browser(Application& app);
     void render_core_config(Application& app);
+    void render_perf_overlay(Application& app);
 
     // Savestate menu helpers
     void render_save_state_menu(Application& app);
     void render_load_state_menu(Application& app);
     std::string format_savestate_slot_label(int slot, bool has_save, int64_t timestamp) const;
+    void show_slot_thumbnail(SavestateManager& savestates, int slot);  // Tooltip of the last item
+
+    // Slot thumbnails as textures, uploaded when a menu shows a new one
+    struct SlotThumbnail {
+        unsigned int texture = 0;
+        int width = 0;
+        int height = 0;
+        uint64_t generation = 0;
+    };
+    std::vector<SlotThumbnail> m_slot_thumbnails;
 
     bool m_initialized = false;
 
@@ -81,9 +98,13 @@ private:
     bool m_show_ram_watch = false;
     bool m_show_speedrun_panel = true;  // Show by default
     bool m_show_debug_panel = false;
+    bool m_show_tas_editor = false;
     bool m_show_plugin_config = false;
     bool m_show_core_config = false;
     bool m_show_demo_window = false;
+    bool m_show_perf_overlay = false;
+    bool m_record_every_frame = false;  // Recordings wait for the writer instead of dropping frames
+    ScreenshotFormat m_burst_format = ScreenshotFormat::Qoi;
     bool m_show_savestate_browser = false;
     bool m_savestate_browser_is_save = false;  // true = save mode, false = load mode
 
@@ -99,6 +120,7 @@ private:
     // Panels
     // Note: SpeedrunPanel has been removed - game plugins now render their own GUI via render_gui()
     std::unique_ptr<DebugPanel> m_debug_panel;
+    std::unique_ptr<TASEditorPanel> m_tas_editor_panel;
     std::unique_ptr<InputConfigPanel> m_input_config_panel;
     std::unique_ptr<PluginConfigPanel> m_plugin_config_panel;
     std::unique_ptr<PathsConfigPanel> m_paths_config_panel;
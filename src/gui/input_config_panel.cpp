@@ -11,6 +11,17 @@
 
 namespace emu {
 
+// Number of emulator plugins loaded; cores load on demand, so this grows
+static size_t count_loaded_plugins(const PluginManager& plugins) {
+    size_t count = 0;
+    for (const auto& plugin : plugins.get_plugins()) {
+        if (plugin.instance) {
+            count++;
+        }
+    }
+    return count;
+}
+
 // Helper to get available platforms from loaded plugins
 static std::vector<std::string> get_available_platforms(const PluginManager& plugins) {
     std::vector<std::string> platforms;
@@ -141,7 +152,11 @@ bool InputConfigPanel::render(Application& app) {
 
 void InputConfigPanel::render_controller_selector(Application& app) {
     auto& input = app.get_input_manager();
-    auto controllers = input.get_available_controllers();
+    if (m_controllers_generation != input.get_device_generation()) {
+        m_controllers = input.get_available_controllers();
+        m_controllers_generation = input.get_device_generation();
+    }
+    const auto& controllers = m_controllers;
 
     // Find current selection index
     int current_index = 0;
@@ -189,7 +204,12 @@ void InputConfigPanel::render_platform_selector(Application& app) {
     auto& plugins = app.get_plugin_manager();
 
     // Get available platforms from loaded plugins
-    auto available_platforms = get_available_platforms(plugins);
+    size_t loaded = count_loaded_plugins(plugins);
+    if (m_platforms_loaded != loaded) {
+        m_platforms = get_available_platforms(plugins);
+        m_platforms_loaded = loaded;
+    }
+    const auto& available_platforms = m_platforms;
 
     // If no plugins loaded, show message
     if (available_platforms.empty()) {
@@ -438,7 +458,11 @@ void InputConfigPanel::draw_button(Application& app, ImVec2 origin, ImVec2 size,
 }
 
 void InputConfigPanel::render_binding_table(Application& app) {
-    auto buttons = InputManager::get_platform_buttons(m_current_platform);
+    if (m_platform_buttons_for != m_current_platform) {
+        m_platform_buttons = InputManager::get_platform_buttons(m_current_platform);
+        m_platform_buttons_for = m_current_platform;
+    }
+    const auto& buttons = m_platform_buttons;
 
     ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
                             ImGuiTableFlags_SizingStretchProp;
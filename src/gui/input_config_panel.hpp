@@ -3,6 +3,8 @@
 #include "emu/input_types.hpp"
 #include "emu/controller_layout.hpp"
 #include <string>
+#include <utility>
+#include <vector>
 
 struct ImVec2;
 
@@ -45,6 +47,15 @@ private:
 
     // Visual mode toggle
     bool m_show_visual = true;
+
+    // Lists derived from the input and plugin managers, rebuilt only when
+    // what they come from changes
+    std::vector<std::pair<int, std::string>> m_controllers;
+    uint32_t m_controllers_generation = UINT32_MAX;
+    std::vector<std::string> m_platforms;
+    size_t m_platforms_loaded = SIZE_MAX;   // Loaded cores m_platforms was built from
+    std::vector<VirtualButton> m_platform_buttons;
+    std::string m_platform_buttons_for;
 };
 
 } // namespace emu
@@ -158,15 +158,10 @@ void PluginConfigPanel::render_plugin_selector(const char* label, PluginType typ
         ImGui::BeginDisabled();
     }
 
-    // Build combo items
-    std::vector<const char*> items;
-    items.push_back("(None)");
-
-    if (m_available_plugins.count(type)) {
-        for (const auto& plugin : m_available_plugins[type]) {
-            items.push_back(plugin.name.c_str());
-        }
-    }
+    // Combo items, built with the lists
+    static const std::vector<const char*> no_plugins = {"(None)"};
+    auto items_it = m_combo_items.find(type);
+    const std::vector<const char*>& items = items_it != m_combo_items.end() ? items_it->second : no_plugins;
 
     // Ensure we have a valid selection index
     if (!m_selected_indices.count(type)) {
@@ -458,6 +453,17 @@ void PluginConfigPanel::build_plugin_lists(PluginManager& pm) {
                   return a.name < b.name;
               });
 
+    // The lists don't change until the next build, so neither do the
+    // combos' items
+    m_combo_items.clear();
+    for (const auto& [type, plugins] : m_available_plugins) {
+        auto& items = m_combo_items[type];
+        items.push_back("(None)");
+        for (const auto& plugin : plugins) {
+            items.push_back(plugin.name.c_str());
+        }
+    }
+
     // Initialize selection indices based on currently active plugins
     auto init_selection = [&](PluginType type, const std::string& active_name) {
         m_selected_indices[type] = 0;  // Default to "(None)"
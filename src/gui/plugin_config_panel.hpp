@@ -54,6 +54,9 @@ private:
     // Plugin lists per type
     std::unordered_map<PluginType, std::vector<PluginSelection>> m_available_plugins;
 
+    // Each type's combo items: "(None)", then the names in m_available_plugins
+    std::unordered_map<PluginType, std::vector<const char*>> m_combo_items;
+
     // Current selection indices per type
     std::unordered_map<PluginType, int> m_selected_indices;
 
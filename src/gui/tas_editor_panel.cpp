@@ -0,0 +1,187 @@
+#include "tas_editor_panel.hpp"
+#include "../core/application.hpp"
+#include "../core/plugin_manager.hpp"
+#include "emu/input_types.hpp"
+
+#include <imgui.h>
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+
+namespace emu {
+
+namespace {
+
+// Controller 1's buttons, one column each
+struct ButtonColumn {
+    VirtualButton button;
+    const char* label;
+};
+
+constexpr ButtonColumn BUTTON_COLUMNS[] = {
+    {VirtualButton::Up, "^"},
+    {VirtualButton::Down, "v"},
+    {VirtualButton::Left, "<"},
+    {VirtualButton::Right, ">"},
+    {VirtualButton::Select, "Sl"},
+    {VirtualButton::Start, "St"},
+    {VirtualButton::Y, "Y"},
+    {VirtualButton::X, "X"},
+    {VirtualButton::B, "B"},
+    {VirtualButton::A, "A"},
+    {VirtualButton::L, "L"},
+    {VirtualButton::R, "R"},
+};
+
+constexpr int BUTTON_COLUMN_COUNT = sizeof(BUTTON_COLUMNS) / sizeof(BUTTON_COLUMNS[0]);
+
+// Greenzone presence and lag are fetched for this many frames either side
+// of a row outside the cached window, so scrolling rarely refetches
+constexpr uint64_t PRESENCE_MARGIN = 512;
+
+} // namespace
+
+void TASEditorPanel::render(Application& app, bool& visible) {
+    if (!visible) return;
+
+    ImGui::SetNextWindowSize(ImVec2(420, 600), ImGuiCond_FirstUseEver);
+
+    if (ImGui::Begin("TAS Editor", &visible)) {
+        auto* tas = app.get_plugin_manager().get_tas_plugin();
+        if (!tas || !tas->is_movie_loaded()) {
+            ImGui::Text("No movie loaded");
+        } else {
+            render_movie(tas);
+        }
+    }
+    ImGui::End();
+}
+
+void TASEditorPanel::render_movie(ITASPlugin* tas) {
+    // Cached bits hold until the greenzone or the known lag changes
+    uint64_t revision = tas->get_greenzone_revision();
+    uint64_t lag_revision = tas->get_lag_revision();
+    if (revision == 0 || revision != m_presence_revision || lag_revision != m_lag_revision) {
+        m_presence_count = 0;
+        m_presence_revision = revision;
+        m_lag_revision = lag_revision;
+    }
+
+    ImGui::Text("Frame %llu / %llu", static_cast<unsigned long long>(tas->get_current_frame()),
+                static_cast<unsigned long long>(tas->get_total_frames()));
+    ImGui::SameLine();
+    ImGui::Text("Rerecords: %llu", static_cast<unsigned long long>(tas->get_rerecord_count()));
+    ImGui::Text("Greenzone: %.1f MB", tas->get_greenzone_memory_used() / (1024.0 * 1024.0));
+
+    ImGui::BeginDisabled(!tas->can_undo());
+    if (ImGui::Button("Undo")) tas->undo();
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    ImGui::BeginDisabled(!tas->can_redo());
+    if (ImGui::Button("Redo")) tas->redo();
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    ImGui::Checkbox("Follow cursor", &m_follow_cursor);
+
+    ImGui::Separator();
+    render_piano_roll(tas);
+}
+
+void TASEditorPanel::render_piano_roll(ITASPlugin* tas) {
+    uint64_t total = std::min<uint64_t>(tas->get_total_frames(), INT_MAX);
+    uint64_t current = tas->get_current_frame();
+    bool scroll_to_current = m_follow_cursor && current != m_followed_frame && current < total;
+    m_followed_frame = current;
+
+    ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV |
+                            ImGuiTableFlags_SizingFixedFit;
+    if (!ImGui::BeginTable("PianoRoll", 1 + BUTTON_COLUMN_COUNT, flags)) return;
+
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Frame", ImGuiTableColumnFlags_WidthFixed, 70.0f);
+    for (const auto& column : BUTTON_COLUMNS) {
+        ImGui::TableSetupColumn(column.label, ImGuiTableColumnFlags_WidthFixed, 18.0f);
+    }
+    ImGui::TableHeadersRow();
+
+    // Only the visible rows (and the cursor's, when following it) are built
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(total));
+    if (scroll_to_current) clipper.IncludeItemByIndex(static_cast<int>(current));
+    while (clipper.Step()) {
+        uint64_t first = static_cast<uint64_t>(clipper.DisplayStart);
+        m_rows.resize(static_cast<size_t>(clipper.DisplayEnd - clipper.DisplayStart));
+        uint64_t count = tas->get_frames(first, m_rows.size(), m_rows.data());
+
+        for (uint64_t i = 0; i < count; i++) {
+            if (scroll_to_current && first + i == current) ImGui::SetScrollHereY(0.5f);
+            render_row(tas, first + i, m_rows[i], current);
+        }
+    }
+
+    ImGui::EndTable();
+}
+
+void TASEditorPanel::render_row(ITASPlugin* tas, uint64_t frame, const TASFrameData& data, uint64_t current) {
+    ImGui::TableNextRow();
+    if (frame == current) {
+        ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg1, IM_COL32(60, 90, 160, 255));
+    } else if (has_greenzone(tas, frame)) {
+        ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg1, IM_COL32(40, 90, 50, 255));
+    }
+
+    ImGui::PushID(static_cast<int>(frame));
+
+    // Double-click a frame number to seek there; lag frames are marked red
+    ImGui::TableNextColumn();
+    if (is_lag(tas, frame)) {
+        ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg, IM_COL32(140, 40, 40, 255));
+    }
+    char label[24];
+    std::snprintf(label, sizeof(label), "%llu", static_cast<unsigned long long>(frame));
+    ImGui::Selectable(label, false, ImGuiSelectableFlags_AllowDoubleClick);
+    if (ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
+        tas->seek_to_frame(frame);
+    }
+
+    // Click a cell to toggle the button
+    for (int i = 0; i < BUTTON_COLUMN_COUNT; i++) {
+        ImGui::TableNextColumn();
+        uint32_t bit = 1u << static_cast<uint32_t>(BUTTON_COLUMNS[i].button);
+        bool pressed = (data.controller_inputs[0] & bit) != 0;
+
+        char cell[16];
+        std::snprintf(cell, sizeof(cell), "%s###%d", pressed ? BUTTON_COLUMNS[i].label : "", i);
+        if (ImGui::Selectable(cell, pressed)) {
+            TASFrameData edited = data;
+            edited.controller_inputs[0] ^= bit;
+            tas->set_frame(frame, edited);
+        }
+    }
+
+    ImGui::PopID();
+}
+
+bool TASEditorPanel::has_greenzone(ITASPlugin* tas, uint64_t frame) {
+    fetch_bits(tas, frame);
+    uint64_t i = frame - m_presence_start;
+    return (m_presence[i / 8] >> (i % 8)) & 1;
+}
+
+bool TASEditorPanel::is_lag(ITASPlugin* tas, uint64_t frame) {
+    fetch_bits(tas, frame);
+    uint64_t i = frame - m_presence_start;
+    return (m_lag[i / 8] >> (i % 8)) & 1;
+}
+
+void TASEditorPanel::fetch_bits(ITASPlugin* tas, uint64_t frame) {
+    if (frame >= m_presence_start && frame < m_presence_start + m_presence_count) return;
+    m_presence_start = frame > PRESENCE_MARGIN ? frame - PRESENCE_MARGIN : 0;
+    m_presence_count = frame - m_presence_start + PRESENCE_MARGIN;
+    m_presence.resize((m_presence_count + 7) / 8);
+    m_lag.resize(m_presence.size());
+    tas->get_greenzone_presence(m_presence_start, m_presence_count, m_presence.data());
+    tas->get_lag_frames(m_presence_start, m_presence_count, m_lag.data());
+}
+
+} // namespace emu
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "emu/tas_plugin.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace emu {
+
+class Application;
+
+// Piano roll for the active TAS plugin's movie
+//
+// Only the rows on screen are built: the list clipper picks them, their
+// frames come from one get_frames() call, and greenzone presence and lag
+// come as bitmaps kept for a window around them until the plugin's
+// revisions change. Scrolling a long movie costs the same as a short one.
+class TASEditorPanel {
+public:
+    // Render the panel
+    void render(Application& app, bool& visible);
+
+private:
+    void render_movie(ITASPlugin* tas);
+    void render_piano_roll(ITASPlugin* tas);
+    void render_row(ITASPlugin* tas, uint64_t frame, const TASFrameData& data, uint64_t current);
+    bool has_greenzone(ITASPlugin* tas, uint64_t frame);
+    bool is_lag(ITASPlugin* tas, uint64_t frame);
+    void fetch_bits(ITASPlugin* tas, uint64_t frame);
+
+    // Rows being drawn, refetched every frame
+    std::vector<TASFrameData> m_rows;
+
+    // Greenzone presence and lag bits for m_presence_count frames from
+    // m_presence_start, as of m_presence_revision and m_lag_revision
+    std::vector<uint8_t> m_presence;
+    std::vector<uint8_t> m_lag;
+    uint64_t m_presence_start = 0;
+    uint64_t m_presence_count = 0;
+    uint64_t m_presence_revision = 0;
+    uint64_t m_lag_revision = 0;
+
+    bool m_follow_cursor = true;
+    uint64_t m_followed_frame = UINT64_MAX;
+};
+
+} // namespace emu
@@ -0,0 +1,643 @@
+#include "vram_viewer.hpp"
+#include "emu/emulator_plugin.hpp"
+
+#include <SDL_opengl.h>
+#include <imgui.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace emu {
+
+namespace {
+
+constexpr int SHEET_COLUMNS = 16;   // Tiles across the tile sheet
+
+// Tile encodings: NES (two 8-byte planes), SNES/GB planar (plane pairs
+// interleaved by row, 16 bytes per pair) and GBA linear (packed pixels)
+enum class TileFormat { NES, Planar, Linear };
+
+int tile_bytes(int bits) {
+    return bits * 8;
+}
+
+// Colour indices of an 8x8 tile's pixels, row by row
+void decode_tile(const uint8_t* tile, TileFormat format, int bits, uint8_t* out) {
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            int shift = 7 - x;
+            uint8_t index = 0;
+            switch (format) {
+                case TileFormat::NES:
+                    index = ((tile[y] >> shift) & 1) | (((tile[y + 8] >> shift) & 1) << 1);
+                    break;
+                case TileFormat::Planar:
+                    for (int plane = 0; plane < bits; plane++) {
+                        uint8_t row = tile[(plane >> 1) * 16 + y * 2 + (plane & 1)];
+                        index |= ((row >> shift) & 1) << plane;
+                    }
+                    break;
+                case TileFormat::Linear:
+                    if (bits == 8) {
+                        index = tile[y * 8 + x];
+                    } else {
+                        uint8_t pair = tile[y * 4 + x / 2];
+                        index = (x & 1) ? pair >> 4 : pair & 0x0F;
+                    }
+                    break;
+            }
+            out[y * 8 + x] = index;
+        }
+    }
+}
+
+// Copy a tile out of memory that wraps at size (an address past the end
+// of VRAM reads from its start, as the cores' own fetches do)
+void fetch_tile(const uint8_t* data, uint32_t size, uint32_t offset, int bytes, uint8_t* out) {
+    for (int i = 0; i < bytes; i++) {
+        out[i] = data[(offset + static_cast<uint32_t>(i)) % size];
+    }
+}
+
+// Draw tile indices at (x0, y0), colour index + base from colors
+void draw_tile(std::vector<uint32_t>& pixels, int width, int x0, int y0, const uint8_t* indices,
+               bool hflip, bool vflip, const std::array<uint32_t, 256>& colors, int base) {
+    for (int y = 0; y < 8; y++) {
+        uint32_t* row = &pixels[static_cast<size_t>(y0 + y) * width + x0];
+        int src_y = vflip ? 7 - y : y;
+        for (int x = 0; x < 8; x++) {
+            int src_x = hflip ? 7 - x : x;
+            row[x] = colors[(base + indices[src_y * 8 + src_x]) & 0xFF];
+        }
+    }
+}
+
+// BGR555 as stored by the SNES, GBA and GBC, to the renderer's RGBA
+uint32_t bgr555_to_rgba(const uint8_t* color) {
+    uint16_t value = color[0] | (color[1] << 8);
+    uint32_t r = value & 0x1F, g = (value >> 5) & 0x1F, b = (value >> 10) & 0x1F;
+    r = (r << 3) | (r >> 2);
+    g = (g << 3) | (g >> 2);
+    b = (b << 3) | (b >> 2);
+    return 0xFF000000 | (b << 16) | (g << 8) | r;
+}
+
+ImVec4 rgba_to_vec4(uint32_t color) {
+    return ImVec4((color & 0xFF) / 255.0f, ((color >> 8) & 0xFF) / 255.0f, ((color >> 16) & 0xFF) / 255.0f, 1.0f);
+}
+
+} // namespace
+
+VramViewer::~VramViewer() {
+    for (View* view : {&m_tile_view, &m_map_view}) {
+        if (view->texture) {
+            GLuint texture = view->texture;
+            glDeleteTextures(1, &texture);
+        }
+    }
+}
+
+void VramViewer::render(IEmulatorPlugin* plugin) {
+    if (!plugin || !plugin->is_rom_loaded()) {
+        ImGui::Text("No ROM loaded");
+        return;
+    }
+
+    find_sources(*plugin);
+    if (m_system == System::Unknown) {
+        ImGui::Text("No viewers for %s", plugin->get_info().name);
+        return;
+    }
+
+    if (ImGui::BeginTabBar("VideoTabs")) {
+        if (ImGui::BeginTabItem("Tiles")) {
+            render_tiles();
+            ImGui::EndTabItem();
+        }
+        if (ImGui::BeginTabItem("Map")) {
+            render_map();
+            ImGui::EndTabItem();
+        }
+        if (ImGui::BeginTabItem("Palette")) {
+            render_palette();
+            ImGui::EndTabItem();
+        }
+        if (ImGui::BeginTabItem("Sprites")) {
+            render_sprites();
+            ImGui::EndTabItem();
+        }
+        ImGui::EndTabBar();
+    }
+}
+
+void VramViewer::find_sources(IEmulatorPlugin& plugin) {
+    std::string name = plugin.get_info().name;
+    if (name == "NES") m_system = System::NES;
+    else if (name == "GB") m_system = System::GB;
+    else if (name == "GBC") m_system = System::GBC;
+    else if (name == "SNES") m_system = System::SNES;
+    else if (name == "GBA") m_system = System::GBA;
+    else m_system = System::Unknown;
+
+    m_sources = {};
+    auto domains = plugin.get_memory_domains();
+    Sources& s = m_sources;
+    switch (m_system) {
+        case System::NES:
+            s.vram = domain_bytes(plugin, domains, "CHR", s.vram_size, &m_vram_scratch);
+            s.map = domain_bytes(plugin, domains, "Nametables", s.map_size, nullptr);
+            s.palette = domain_bytes(plugin, domains, "Palette", s.palette_size, nullptr);
+            break;
+        case System::GB:
+        case System::GBC:
+            s.vram = domain_bytes(plugin, domains, "VRAM", s.vram_size, &m_vram_scratch);
+            if (m_system == System::GBC) {
+                s.palette = domain_bytes(plugin, domains, "BG Palette", s.palette_size, nullptr);
+                s.obj_palette = domain_bytes(plugin, domains, "OBJ Palette", s.obj_palette_size, nullptr);
+            }
+            break;
+        case System::SNES:
+            s.vram = domain_bytes(plugin, domains, "VRAM", s.vram_size, &m_vram_scratch);
+            s.palette = domain_bytes(plugin, domains, "CGRAM", s.palette_size, nullptr);
+            break;
+        case System::GBA:
+            s.vram = domain_bytes(plugin, domains, "VRAM", s.vram_size, &m_vram_scratch);
+            s.palette = domain_bytes(plugin, domains, "Palette", s.palette_size, nullptr);
+            break;
+        case System::Unknown:
+            return;
+    }
+    s.oam = domain_bytes(plugin, domains, "OAM", s.oam_size, &m_oam_scratch);
+}
+
+const uint8_t* VramViewer::domain_bytes(IEmulatorPlugin& plugin, const std::vector<MemoryDomain>& domains,
+                                        const char* name, uint32_t& size, std::vector<uint8_t>* scratch) {
+    size = 0;
+    for (size_t i = 0; i < domains.size(); i++) {
+        const MemoryDomain& domain = domains[i];
+        if (std::strcmp(domain.name, name) != 0 || domain.size == 0) continue;
+        if (domain.data) {
+            size = domain.size;
+            return domain.data;
+        }
+        if (!scratch) return nullptr;
+        scratch->resize(domain.size);
+        if (!plugin.read_memory_block(i, 0, domain.size, scratch->data())) return nullptr;
+        size = domain.size;
+        return scratch->data();
+    }
+    return nullptr;
+}
+
+void VramViewer::load_colors(int bits, int index, bool obj) {
+    int count = 1 << bits;
+    int base = index * count;
+    const uint8_t* palette = obj && m_system == System::GBC ? m_sources.obj_palette : m_sources.palette;
+    uint32_t palette_size = obj && m_system == System::GBC ? m_sources.obj_palette_size : m_sources.palette_size;
+    uint32_t bank = obj && m_system == System::GBA ? 0x200 : 0;
+
+    bool rgb = palette && (m_system == System::SNES || m_system == System::GBA || m_system == System::GBC);
+    for (int i = 0; i < 256; i++) {
+        uint32_t offset = bank + static_cast<uint32_t>((base + i) * 2);
+        if (rgb && offset + 1 < palette_size) {
+            m_colors[i] = bgr555_to_rgba(palette + offset);
+        } else {
+            // A DMG's shade 0 is its lightest; elsewhere colour 0 is the
+            // darkest grey
+            int level = (i % count) * 255 / (count - 1);
+            if (m_system == System::GB) level = 255 - level;
+            m_colors[i] = 0xFF000000 | (level << 16) | (level << 8) | level;
+        }
+    }
+}
+
+void VramViewer::begin_key(std::initializer_list<int> settings) {
+    m_key.clear();
+    for (int setting : settings) {
+        add_key_bytes(reinterpret_cast<const uint8_t*>(&setting), sizeof(setting));
+    }
+}
+
+void VramViewer::add_key_bytes(const uint8_t* data, size_t size) {
+    m_key.insert(m_key.end(), data, data + size);
+}
+
+bool VramViewer::needs_update(View& view, int width, int height) {
+    if (view.texture && view.width == width && view.height == height && view.key == m_key) {
+        return false;
+    }
+    view.key.swap(m_key);
+    view.width = width;
+    view.height = height;
+    view.pixels.assign(static_cast<size_t>(width) * height, 0xFF000000);
+    return true;
+}
+
+void VramViewer::upload(View& view) {
+    GLuint texture = view.texture;
+    if (!texture) {
+        glGenTextures(1, &texture);
+        view.texture = texture;
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    } else {
+        glBindTexture(GL_TEXTURE_2D, texture);
+    }
+    // Views change size with their settings; reallocating then is rare
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, view.width, view.height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 view.pixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void VramViewer::show(const View& view, float scale) {
+    if (!view.texture) return;
+    ImGui::BeginChild("##view", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar);
+    ImGui::Image(reinterpret_cast<ImTextureID>(static_cast<intptr_t>(view.texture)),
+                 ImVec2(view.width * scale, view.height * scale));
+    ImGui::EndChild();
+}
+
+void VramViewer::render_tiles() {
+    const Sources& s = m_sources;
+    if (!s.vram) {
+        ImGui::Text("No tile data");
+        return;
+    }
+
+    // Format, tiles per page and page stride of each system's tile memory
+    TileFormat format = TileFormat::Planar;
+    int bits = 2;
+    int page_tiles = 1024;
+    uint32_t page_stride = 0;
+    int palettes = 0;           // Palettes to choose from for these tiles
+    switch (m_system) {
+        case System::NES:
+            format = TileFormat::NES;
+            page_tiles = 512;   // Both pattern tables; CHR is shown unbanked
+            break;
+        case System::GB:
+        case System::GBC:
+            page_tiles = 384;   // $8000-$97FF of one bank
+            page_stride = 0x2000;
+            palettes = m_system == System::GBC ? 16 : 0;
+            break;
+        case System::SNES:
+            ImGui::RadioButton("2bpp", &m_tile_bits, 2);
+            ImGui::SameLine();
+            ImGui::RadioButton("4bpp", &m_tile_bits, 4);
+            ImGui::SameLine();
+            ImGui::RadioButton("8bpp", &m_tile_bits, 8);
+            bits = m_tile_bits;
+            palettes = bits == 8 ? 0 : 256 >> bits;
+            break;
+        case System::GBA:
+            if (m_tile_bits == 2) m_tile_bits = 4;
+            format = TileFormat::Linear;
+            ImGui::RadioButton("4bpp", &m_tile_bits, 4);
+            ImGui::SameLine();
+            ImGui::RadioButton("8bpp", &m_tile_bits, 8);
+            bits = m_tile_bits;
+            palettes = bits == 8 ? 2 : 32;
+            break;
+        case System::Unknown:
+            return;
+    }
+    int bytes = tile_bytes(bits);
+    if (page_stride == 0) page_stride = static_cast<uint32_t>(page_tiles * bytes);
+
+    int pages = static_cast<int>((s.vram_size + page_stride - 1) / page_stride);
+    m_tile_page = std::clamp(m_tile_page, 0, std::max(pages - 1, 0));
+    if (pages > 1) {
+        ImGui::SetNextItemWidth(150);
+        ImGui::SliderInt(m_system == System::GBC ? "Bank" : "Page", &m_tile_page, 0, pages - 1);
+        ImGui::SameLine();
+    }
+    m_tile_palette = std::clamp(m_tile_palette, 0, std::max(palettes - 1, 0));
+    if (palettes > 1) {
+        // On the GBA and GBC the second half are the sprite palettes
+        ImGui::SetNextItemWidth(150);
+        ImGui::SliderInt("Palette", &m_tile_palette, 0, palettes - 1);
+        ImGui::SameLine();
+    }
+    ImGui::SetNextItemWidth(100);
+    ImGui::SliderFloat("Zoom", &m_tile_scale, 1.0f, 4.0f, "%.0fx");
+
+    uint32_t start = static_cast<uint32_t>(m_tile_page) * page_stride;
+    int tiles = std::min<int>(page_tiles, static_cast<int>((s.vram_size - start) / bytes));
+    if (tiles <= 0) return;
+
+    bool obj = (m_system == System::GBC || m_system == System::GBA) && m_tile_palette >= palettes / 2;
+    int palette = obj ? m_tile_palette - palettes / 2 : m_tile_palette;
+    load_colors(bits, m_system == System::GBA && bits == 8 ? 0 : palette, obj);
+
+    begin_key({static_cast<int>(m_system), m_tile_page, bits, m_tile_palette});
+    add_key_bytes(s.vram + start, static_cast<size_t>(tiles) * bytes);
+    add_key_bytes(reinterpret_cast<const uint8_t*>(m_colors.data()), sizeof(m_colors));
+
+    int width = SHEET_COLUMNS * 8;
+    int height = (tiles + SHEET_COLUMNS - 1) / SHEET_COLUMNS * 8;
+    if (needs_update(m_tile_view, width, height)) {
+        uint8_t indices[64];
+        for (int tile = 0; tile < tiles; tile++) {
+            decode_tile(s.vram + start + static_cast<uint32_t>(tile * bytes), format, bits, indices);
+            draw_tile(m_tile_view.pixels, width, (tile % SHEET_COLUMNS) * 8, (tile / SHEET_COLUMNS) * 8,
+                      indices, false, false, m_colors, 0);
+        }
+        upload(m_tile_view);
+    }
+    show(m_tile_view, m_tile_scale);
+}
+
+void VramViewer::render_map() {
+    const Sources& s = m_sources;
+    if (!s.vram) {
+        ImGui::Text("No tile data");
+        return;
+    }
+
+    // The cores' scroll and map registers aren't memory domains, so which
+    // map and tiles to show is picked here
+    int width = 256;
+    int height = 256;
+    switch (m_system) {
+        case System::NES:
+            if (!s.map || s.vram_size < 0x2000) {
+                ImGui::Text("No nametables");
+                return;
+            }
+            m_map_select &= 1;
+            ImGui::Text("Pattern table:");
+            ImGui::SameLine();
+            ImGui::RadioButton("$0000", &m_map_select, 0);
+            ImGui::SameLine();
+            ImGui::RadioButton("$1000", &m_map_select, 1);
+            width = 512;
+            height = 240;
+            break;
+        case System::GB:
+        case System::GBC:
+            m_map_select &= 1;
+            m_map_tiles &= 1;
+            ImGui::Text("Map:");
+            ImGui::SameLine();
+            ImGui::RadioButton("$9800", &m_map_select, 0);
+            ImGui::SameLine();
+            ImGui::RadioButton("$9C00", &m_map_select, 1);
+            ImGui::SameLine();
+            ImGui::Text("Tiles:");
+            ImGui::SameLine();
+            ImGui::RadioButton("$8800", &m_map_tiles, 0);
+            ImGui::SameLine();
+            ImGui::RadioButton("$8000", &m_map_tiles, 1);
+            break;
+        case System::SNES:
+        case System::GBA: {
+            bool snes = m_system == System::SNES;
+            if (!snes && m_map_bits == 2) m_map_bits = 4;
+            if (snes) {
+                ImGui::RadioButton("2bpp", &m_map_bits, 2);
+                ImGui::SameLine();
+            }
+            ImGui::RadioButton("4bpp", &m_map_bits, 4);
+            ImGui::SameLine();
+            ImGui::RadioButton("8bpp", &m_map_bits, 8);
+            // SNES: BGnSC base in 2KB units and BGnNBA in 8KB units; GBA:
+            // BGnCNT screen base block (2KB) and character base block (16KB)
+            ImGui::SetNextItemWidth(120);
+            ImGui::SliderInt("Map base", &m_map_select, 0, 31);
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(120);
+            ImGui::SliderInt("Tile base", &m_map_tiles, 0, snes ? 7 : 3);
+            m_map_select = std::clamp(m_map_select, 0, 31);
+            m_map_tiles = std::clamp(m_map_tiles, 0, snes ? 7 : 3);
+            break;
+        }
+        case System::Unknown:
+            return;
+    }
+    ImGui::SetNextItemWidth(100);
+    ImGui::SliderFloat("Zoom", &m_map_scale, 1.0f, 4.0f, "%.0fx");
+
+    // Maps use every palette, so load them all
+    switch (m_system) {
+        case System::SNES:
+        case System::GBA: load_colors(8, 0, false); break;
+        case System::GBC: load_colors(5, 0, false); break;
+        default: load_colors(2, 0, false); break;
+    }
+
+    begin_key({static_cast<int>(m_system), m_map_select, m_map_tiles, m_map_bits});
+    if (m_system == System::NES) {
+        add_key_bytes(s.map, s.map_size);
+        add_key_bytes(s.vram + m_map_select * 0x1000, 0x1000);
+    } else {
+        add_key_bytes(s.vram, s.vram_size);
+    }
+    add_key_bytes(reinterpret_cast<const uint8_t*>(m_colors.data()), sizeof(m_colors));
+    if (!needs_update(m_map_view, width, height)) {
+        show(m_map_view, m_map_scale);
+        return;
+    }
+
+    std::vector<uint32_t>& pixels = m_map_view.pixels;
+    uint8_t tile[64];
+    uint8_t indices[64];
+    switch (m_system) {
+        case System::NES:
+            // Both physical nametables side by side; how they mirror is the
+            // cartridge's business
+            for (int table = 0; table < 2 && (table + 1) * 0x400u <= s.map_size; table++) {
+                const uint8_t* names = s.map + table * 0x400;
+                const uint8_t* patterns = s.vram + m_map_select * 0x1000;
+                for (int row = 0; row < 30; row++) {
+                    for (int col = 0; col < 32; col++) {
+                        decode_tile(patterns + names[row * 32 + col] * 16, TileFormat::NES, 2, indices);
+                        draw_tile(pixels, width, table * 256 + col * 8, row * 8, indices, false, false, m_colors, 0);
+                    }
+                }
+            }
+            break;
+
+        case System::GB:
+        case System::GBC: {
+            uint32_t map = m_map_select ? 0x1C00 : 0x1800;
+            bool cgb = m_system == System::GBC && s.vram_size >= 0x4000;
+            for (int row = 0; row < 32; row++) {
+                for (int col = 0; col < 32; col++) {
+                    uint32_t entry = map + row * 32 + col;
+                    uint8_t name = s.vram[entry];
+                    uint8_t attributes = cgb ? s.vram[0x2000 + entry] : 0;
+                    uint32_t address = m_map_tiles ? name * 16u
+                                                   : static_cast<uint32_t>(0x1000 + static_cast<int8_t>(name) * 16);
+                    if (attributes & 0x08) address += 0x2000;
+                    decode_tile(s.vram + address, TileFormat::Planar, 2, indices);
+                    draw_tile(pixels, width, col * 8, row * 8, indices, attributes & 0x20, attributes & 0x40,
+                              m_colors, (attributes & 0x07) * 4);
+                }
+            }
+            break;
+        }
+
+        case System::SNES:
+        case System::GBA: {
+            bool snes = m_system == System::SNES;
+            int bits = m_map_bits;
+            int bytes = tile_bytes(bits);
+            uint32_t map = static_cast<uint32_t>(m_map_select) * 0x800;
+            uint32_t tiles = static_cast<uint32_t>(m_map_tiles) * (snes ? 0x2000 : 0x4000);
+            for (int row = 0; row < 32; row++) {
+                for (int col = 0; col < 32; col++) {
+                    uint32_t entry_offset = (map + (row * 32 + col) * 2) % s.vram_size;
+                    uint16_t entry = s.vram[entry_offset] | (s.vram[(entry_offset + 1) % s.vram_size] << 8);
+                    // SNES: vhopppcc cccccccc; GBA: ppppvhnn nnnnnnnn
+                    uint32_t name = entry & 0x3FF;
+                    int palette = snes ? (entry >> 10) & 7 : entry >> 12;
+                    bool hflip = entry & (snes ? 0x4000 : 0x0400);
+                    bool vflip = entry & (snes ? 0x8000 : 0x0800);
+                    fetch_tile(s.vram, s.vram_size, tiles + name * bytes, bytes, tile);
+                    decode_tile(tile, snes ? TileFormat::Planar : TileFormat::Linear, bits, indices);
+                    int base = bits == 8 ? 0 : palette << bits;
+                    draw_tile(pixels, width, col * 8, row * 8, indices, hflip, vflip, m_colors, base);
+                }
+            }
+            break;
+        }
+
+        case System::Unknown:
+            break;
+    }
+    upload(m_map_view);
+    show(m_map_view, m_map_scale);
+}
+
+void VramViewer::render_palette() {
+    const Sources& s = m_sources;
+
+    // Colours as swatches, per_row across, hovering one shows its value
+    auto swatches = [](const uint8_t* palette, int count, int per_row) {
+        for (int i = 0; i < count; i++) {
+            uint16_t value = palette[i * 2] | (palette[i * 2 + 1] << 8);
+            char label[32];
+            std::snprintf(label, sizeof(label), "%d: $%04X##color%d", i, value, i);
+            if (i % per_row != 0) ImGui::SameLine(0, 2);
+            ImGui::ColorButton(label, rgba_to_vec4(bgr555_to_rgba(palette + i * 2)),
+                               ImGuiColorEditFlags_NoAlpha, ImVec2(14, 14));
+        }
+    };
+
+    switch (m_system) {
+        case System::NES:
+            // Indices into the PPU's colours, which aren't a memory domain
+            if (!s.palette || s.palette_size < 32) break;
+            for (int group = 0; group < 2; group++) {
+                ImGui::Text(group == 0 ? "Background:" : "Sprites:   ");
+                for (int i = 0; i < 16; i++) {
+                    ImGui::SameLine(0, i % 4 == 0 ? 16 : -1);
+                    ImGui::Text("$%02X", s.palette[group * 16 + i]);
+                }
+            }
+            return;
+        case System::GB:
+            ImGui::Text("DMG palettes are the BGP, OBP0 and OBP1 registers ($FF47-$FF49)");
+            return;
+        case System::GBC:
+            if (s.palette && s.palette_size >= 64) {
+                ImGui::Text("Background");
+                swatches(s.palette, 32, 4);
+            }
+            if (s.obj_palette && s.obj_palette_size >= 64) {
+                ImGui::Text("Sprites");
+                ImGui::PushID("obj");
+                swatches(s.obj_palette, 32, 4);
+                ImGui::PopID();
+            }
+            return;
+        case System::SNES:
+            if (s.palette && s.palette_size >= 512) swatches(s.palette, 256, 16);
+            return;
+        case System::GBA:
+            if (s.palette && s.palette_size >= 0x400) {
+                ImGui::Text("Background");
+                swatches(s.palette, 256, 16);
+                ImGui::Text("Sprites");
+                ImGui::PushID("obj");
+                swatches(s.palette + 0x200, 256, 16);
+                ImGui::PopID();
+            }
+            return;
+        case System::Unknown:
+            return;
+    }
+    ImGui::Text("No palette");
+}
+
+void VramViewer::render_sprites() {
+    const Sources& s = m_sources;
+    if (!s.oam) {
+        ImGui::Text("No OAM");
+        return;
+    }
+    const uint8_t* oam = s.oam;
+
+    ImGui::BeginChild("##sprites");
+    switch (m_system) {
+        case System::NES:
+            ImGui::Text(" #    X    Y  Tile  Attr");
+            for (uint32_t i = 0; i < 64 && i * 4 + 3 < s.oam_size; i++) {
+                const uint8_t* e = oam + i * 4;
+                ImGui::Text("%2u  %3u  %3u   $%02X   $%02X", i, e[3], e[0], e[1], e[2]);
+            }
+            break;
+
+        case System::GB:
+        case System::GBC:
+            ImGui::Text(" #    X    Y  Tile  Flags");
+            for (uint32_t i = 0; i < 40 && i * 4 + 3 < s.oam_size; i++) {
+                const uint8_t* e = oam + i * 4;
+                ImGui::Text("%2u  %3d  %3d   $%02X    $%02X", i, e[1] - 8, e[0] - 16, e[2], e[3]);
+            }
+            break;
+
+        case System::SNES:
+            // 128 four-byte entries, then two bits each: X bit 8 and size
+            if (s.oam_size < 544) break;
+            ImGui::Text("  #    X    Y  Tile  Attr  Size");
+            for (uint32_t i = 0; i < 128; i++) {
+                const uint8_t* e = oam + i * 4;
+                int high = (oam[512 + i / 4] >> ((i % 4) * 2)) & 3;
+                int x = e[0] | ((high & 1) << 8);
+                if (x >= 256) x -= 512;
+                ImGui::Text("%3u  %4d  %3u  $%03X   $%02X  %s", i, x, e[1], e[2] | ((e[3] & 1) << 8), e[3],
+                            (high & 2) ? "large" : "small");
+            }
+            break;
+
+        case System::GBA:
+            // Eight bytes per entry: attributes 0-2, then an affine parameter
+            if (s.oam_size < 0x400) break;
+            ImGui::Text("  #    X    Y  Tile  Pal  Shape/Size  Mode");
+            for (uint32_t i = 0; i < 128; i++) {
+                const uint8_t* e = oam + i * 8;
+                uint16_t attr0 = e[0] | (e[1] << 8);
+                uint16_t attr1 = e[2] | (e[3] << 8);
+                uint16_t attr2 = e[4] | (e[5] << 8);
+                if ((attr0 & 0x0300) == 0x0200) continue;  // Disabled
+                int x = attr1 & 0x1FF;
+                if (x >= 256) x -= 512;
+                ImGui::Text("%3u  %4d  %3u  $%03X  %3d      %d/%d      %s%s", i, x, attr0 & 0xFF, attr2 & 0x3FF,
+                            attr2 >> 12, attr0 >> 14, attr1 >> 14, (attr0 & 0x0100) ? "affine" : "normal",
+                            (attr0 & 0x2000) ? " 8bpp" : "");
+            }
+            break;
+
+        case System::Unknown:
+            break;
+    }
+    ImGui::EndChild();
+}
+
+} // namespace emu
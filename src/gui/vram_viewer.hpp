@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+namespace emu {
+
+class IEmulatorPlugin;
+struct MemoryDomain;
+
+// Tile, map, palette and sprite viewers for the debug panel (NES, GB/GBC,
+// SNES and GBA)
+//
+// Video memory comes from the core's memory domains, read once per GUI
+// frame and only while a viewer is on screen. A view is decoded and
+// uploaded to its texture only when the bytes it is built from, or its
+// settings, differ from last time, so an open viewer over a screen that
+// isn't changing costs one compare per frame and nothing in the core.
+class VramViewer {
+public:
+    VramViewer() = default;
+    ~VramViewer();
+
+    VramViewer(const VramViewer&) = delete;
+    VramViewer& operator=(const VramViewer&) = delete;
+
+    void render(IEmulatorPlugin* plugin);
+
+private:
+    enum class System { Unknown, NES, GB, GBC, SNES, GBA };
+
+    // A texture and the key it was last built from
+    struct View {
+        unsigned int texture = 0;       // GL texture name, 0 until first built
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> key;       // Settings and source bytes shown
+        std::vector<uint32_t> pixels;
+    };
+
+    // The domains the viewers read, found once per frame
+    struct Sources {
+        const uint8_t* vram = nullptr;  // CHR on the NES
+        uint32_t vram_size = 0;
+        const uint8_t* map = nullptr;   // NES nametables; elsewhere maps are in VRAM
+        uint32_t map_size = 0;
+        const uint8_t* palette = nullptr;
+        uint32_t palette_size = 0;
+        const uint8_t* obj_palette = nullptr;  // GBC only
+        uint32_t obj_palette_size = 0;
+        const uint8_t* oam = nullptr;
+        uint32_t oam_size = 0;
+    };
+
+    void find_sources(IEmulatorPlugin& plugin);
+
+    // The bytes of the domain called name, or nullptr. One without a data
+    // pointer is read into scratch if given, else skipped.
+    const uint8_t* domain_bytes(IEmulatorPlugin& plugin, const std::vector<MemoryDomain>& domains,
+                                const char* name, uint32_t& size, std::vector<uint8_t>* scratch);
+
+    void render_tiles();
+    void render_map();
+    void render_palette();
+    void render_sprites();
+
+    // Fill colors with the palette tiles are drawn in: index entries of
+    // 2^bits colours from the core's palette, or a grey ramp without one
+    void load_colors(int bits, int index, bool obj);
+
+    // Start a new key in m_key from the settings given
+    void begin_key(std::initializer_list<int> settings);
+    void add_key_bytes(const uint8_t* data, size_t size);
+
+    // True if the view must be rebuilt at width x height for m_key, which
+    // it then takes; its pixels are sized and cleared to be drawn into
+    bool needs_update(View& view, int width, int height);
+    void upload(View& view);
+    void show(const View& view, float scale);
+
+    System m_system = System::Unknown;
+    Sources m_sources;
+    std::vector<uint8_t> m_vram_scratch;    // Copies of domains without a data pointer
+    std::vector<uint8_t> m_oam_scratch;
+    std::array<uint32_t, 256> m_colors{};
+    std::vector<uint8_t> m_key;
+
+    View m_tile_view;
+    View m_map_view;
+
+    // Tile sheet settings
+    int m_tile_page = 0;
+    int m_tile_bits = 4;        // SNES and GBA: bits per pixel
+    int m_tile_palette = 0;
+    float m_tile_scale = 2.0f;
+
+    // Map settings (as the core's registers would give them)
+    int m_map_select = 0;       // NES pattern table, GB map, SNES/GBA map base
+    int m_map_tiles = 0;        // GB tile data area, SNES/GBA character base
+    int m_map_bits = 4;         // SNES and GBA: bits per pixel
+    float m_map_scale = 1.0f;
+};
+
+} // namespace emu
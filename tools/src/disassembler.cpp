@@ -0,0 +1,569 @@
+#include "disassembler.hpp"
+
+#include <cstdarg>
+#include <cstdio>
+
+namespace disasm {
+
+namespace {
+
+std::string format(const char* fmt, ...) {
+    char buffer[128];
+    va_list args;
+    va_start(args, fmt);
+    std::vsnprintf(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+    return buffer;
+}
+
+// ============================================================================
+// 6502 / 65816
+// ============================================================================
+
+enum Mode : uint8_t {
+    IMP,    // (none)
+    ACC,    // A
+    IMM,    // #$nn
+    IMM_M,  // #$nn or #$nnnn by the M flag (65816)
+    IMM_X,  // #$nn or #$nnnn by the X flag (65816)
+    IMM16,  // $nnnn, PEA (65816)
+    ZP,     // $nn
+    ZPX,    // $nn,X
+    ZPY,    // $nn,Y
+    ABS,    // $nnnn
+    ABX,    // $nnnn,X
+    ABY,    // $nnnn,Y
+    IND,    // ($nnnn)
+    IZX,    // ($nn,X)
+    IZY,    // ($nn),Y
+    REL,    // 8-bit branch
+    // 65816 only
+    ZPI,    // ($nn)
+    ZPIL,   // [$nn]
+    ZPILY,  // [$nn],Y
+    LONG,   // $nnnnnn
+    LONGX,  // $nnnnnn,X
+    INDL,   // [$nnnn]
+    AIX,    // ($nnnn,X)
+    SR,     // $nn,S
+    SRIY,   // ($nn,S),Y
+    RELL,   // 16-bit branch
+    BLK     // src,dst banks (MVN/MVP)
+};
+
+struct Op {
+    const char* name;
+    Mode mode;
+};
+
+// clang-format off
+const Op s_6502[256] = {
+    {"BRK",IMP},{"ORA",IZX},{"JAM",IMP},{"SLO",IZX},{"NOP",ZP}, {"ORA",ZP}, {"ASL",ZP}, {"SLO",ZP}, {"PHP",IMP},{"ORA",IMM},{"ASL",ACC},{"ANC",IMM},{"NOP",ABS},{"ORA",ABS},{"ASL",ABS},{"SLO",ABS},
+    {"BPL",REL},{"ORA",IZY},{"JAM",IMP},{"SLO",IZY},{"NOP",ZPX},{"ORA",ZPX},{"ASL",ZPX},{"SLO",ZPX},{"CLC",IMP},{"ORA",ABY},{"NOP",IMP},{"SLO",ABY},{"NOP",ABX},{"ORA",ABX},{"ASL",ABX},{"SLO",ABX},
+    {"JSR",ABS},{"AND",IZX},{"JAM",IMP},{"RLA",IZX},{"BIT",ZP}, {"AND",ZP}, {"ROL",ZP}, {"RLA",ZP}, {"PLP",IMP},{"AND",IMM},{"ROL",ACC},{"ANC",IMM},{"BIT",ABS},{"AND",ABS},{"ROL",ABS},{"RLA",ABS},
+    {"BMI",REL},{"AND",IZY},{"JAM",IMP},{"RLA",IZY},{"NOP",ZPX},{"AND",ZPX},{"ROL",ZPX},{"RLA",ZPX},{"SEC",IMP},{"AND",ABY},{"NOP",IMP},{"RLA",ABY},{"NOP",ABX},{"AND",ABX},{"ROL",ABX},{"RLA",ABX},
+    {"RTI",IMP},{"EOR",IZX},{"JAM",IMP},{"SRE",IZX},{"NOP",ZP}, {"EOR",ZP}, {"LSR",ZP}, {"SRE",ZP}, {"PHA",IMP},{"EOR",IMM},{"LSR",ACC},{"ALR",IMM},{"JMP",ABS},{"EOR",ABS},{"LSR",ABS},{"SRE",ABS},
+    {"BVC",REL},{"EOR",IZY},{"JAM",IMP},{"SRE",IZY},{"NOP",ZPX},{"EOR",ZPX},{"LSR",ZPX},{"SRE",ZPX},{"CLI",IMP},{"EOR",ABY},{"NOP",IMP},{"SRE",ABY},{"NOP",ABX},{"EOR",ABX},{"LSR",ABX},{"SRE",ABX},
+    {"RTS",IMP},{"ADC",IZX},{"JAM",IMP},{"RRA",IZX},{"NOP",ZP}, {"ADC",ZP}, {"ROR",ZP}, {"RRA",ZP}, {"PLA",IMP},{"ADC",IMM},{"ROR",ACC},{"ARR",IMM},{"JMP",IND},{"ADC",ABS},{"ROR",ABS},{"RRA",ABS},
+    {"BVS",REL},{"ADC",IZY},{"JAM",IMP},{"RRA",IZY},{"NOP",ZPX},{"ADC",ZPX},{"ROR",ZPX},{"RRA",ZPX},{"SEI",IMP},{"ADC",ABY},{"NOP",IMP},{"RRA",ABY},{"NOP",ABX},{"ADC",ABX},{"ROR",ABX},{"RRA",ABX},
+    {"NOP",IMM},{"STA",IZX},{"NOP",IMM},{"SAX",IZX},{"STY",ZP}, {"STA",ZP}, {"STX",ZP}, {"SAX",ZP}, {"DEY",IMP},{"NOP",IMM},{"TXA",IMP},{"XAA",IMM},{"STY",ABS},{"STA",ABS},{"STX",ABS},{"SAX",ABS},
+    {"BCC",REL},{"STA",IZY},{"JAM",IMP},{"SHA",IZY},{"STY",ZPX},{"STA",ZPX},{"STX",ZPY},{"SAX",ZPY},{"TYA",IMP},{"STA",ABY},{"TXS",IMP},{"TAS",ABY},{"SHY",ABX},{"STA",ABX},{"SHX",ABY},{"SHA",ABY},
+    {"LDY",IMM},{"LDA",IZX},{"LDX",IMM},{"LAX",IZX},{"LDY",ZP}, {"LDA",ZP}, {"LDX",ZP}, {"LAX",ZP}, {"TAY",IMP},{"LDA",IMM},{"TAX",IMP},{"LXA",IMM},{"LDY",ABS},{"LDA",ABS},{"LDX",ABS},{"LAX",ABS},
+    {"BCS",REL},{"LDA",IZY},{"JAM",IMP},{"LAX",IZY},{"LDY",ZPX},{"LDA",ZPX},{"LDX",ZPY},{"LAX",ZPY},{"CLV",IMP},{"LDA",ABY},{"TSX",IMP},{"LAS",ABY},{"LDY",ABX},{"LDA",ABX},{"LDX",ABY},{"LAX",ABY},
+    {"CPY",IMM},{"CMP",IZX},{"NOP",IMM},{"DCP",IZX},{"CPY",ZP}, {"CMP",ZP}, {"DEC",ZP}, {"DCP",ZP}, {"INY",IMP},{"CMP",IMM},{"DEX",IMP},{"SBX",IMM},{"CPY",ABS},{"CMP",ABS},{"DEC",ABS},{"DCP",ABS},
+    {"BNE",REL},{"CMP",IZY},{"JAM",IMP},{"DCP",IZY},{"NOP",ZPX},{"CMP",ZPX},{"DEC",ZPX},{"DCP",ZPX},{"CLD",IMP},{"CMP",ABY},{"NOP",IMP},{"DCP",ABY},{"NOP",ABX},{"CMP",ABX},{"DEC",ABX},{"DCP",ABX},
+    {"CPX",IMM},{"SBC",IZX},{"NOP",IMM},{"ISC",IZX},{"CPX",ZP}, {"SBC",ZP}, {"INC",ZP}, {"ISC",ZP}, {"INX",IMP},{"SBC",IMM},{"NOP",IMP},{"SBC",IMM},{"CPX",ABS},{"SBC",ABS},{"INC",ABS},{"ISC",ABS},
+    {"BEQ",REL},{"SBC",IZY},{"JAM",IMP},{"ISC",IZY},{"NOP",ZPX},{"SBC",ZPX},{"INC",ZPX},{"ISC",ZPX},{"SED",IMP},{"SBC",ABY},{"NOP",IMP},{"ISC",ABY},{"NOP",ABX},{"SBC",ABX},{"INC",ABX},{"ISC",ABX},
+};
+
+const Op s_65816[256] = {
+    {"BRK",IMM},{"ORA",IZX},{"COP",IMM},{"ORA",SR}, {"TSB",ZP}, {"ORA",ZP}, {"ASL",ZP}, {"ORA",ZPIL},{"PHP",IMP},{"ORA",IMM_M},{"ASL",ACC},{"PHD",IMP},{"TSB",ABS},{"ORA",ABS},{"ASL",ABS},{"ORA",LONG},
+    {"BPL",REL},{"ORA",IZY},{"ORA",ZPI},{"ORA",SRIY},{"TRB",ZP},{"ORA",ZPX},{"ASL",ZPX},{"ORA",ZPILY},{"CLC",IMP},{"ORA",ABY},{"INC",ACC},{"TCS",IMP},{"TRB",ABS},{"ORA",ABX},{"ASL",ABX},{"ORA",LONGX},
+    {"JSR",ABS},{"AND",IZX},{"JSL",LONG},{"AND",SR},{"BIT",ZP}, {"AND",ZP}, {"ROL",ZP}, {"AND",ZPIL},{"PLP",IMP},{"AND",IMM_M},{"ROL",ACC},{"PLD",IMP},{"BIT",ABS},{"AND",ABS},{"ROL",ABS},{"AND",LONG},
+    {"BMI",REL},{"AND",IZY},{"AND",ZPI},{"AND",SRIY},{"BIT",ZPX},{"AND",ZPX},{"ROL",ZPX},{"AND",ZPILY},{"SEC",IMP},{"AND",ABY},{"DEC",ACC},{"TSC",IMP},{"BIT",ABX},{"AND",ABX},{"ROL",ABX},{"AND",LONGX},
+    {"RTI",IMP},{"EOR",IZX},{"WDM",IMM},{"EOR",SR}, {"MVP",BLK},{"EOR",ZP}, {"LSR",ZP}, {"EOR",ZPIL},{"PHA",IMP},{"EOR",IMM_M},{"LSR",ACC},{"PHK",IMP},{"JMP",ABS},{"EOR",ABS},{"LSR",ABS},{"EOR",LONG},
+    {"BVC",REL},{"EOR",IZY},{"EOR",ZPI},{"EOR",SRIY},{"MVN",BLK},{"EOR",ZPX},{"LSR",ZPX},{"EOR",ZPILY},{"CLI",IMP},{"EOR",ABY},{"PHY",IMP},{"TCD",IMP},{"JML",LONG},{"EOR",ABX},{"LSR",ABX},{"EOR",LONGX},
+    {"RTS",IMP},{"ADC",IZX},{"PER",RELL},{"ADC",SR},{"STZ",ZP}, {"ADC",ZP}, {"ROR",ZP}, {"ADC",ZPIL},{"PLA",IMP},{"ADC",IMM_M},{"ROR",ACC},{"RTL",IMP},{"JMP",IND},{"ADC",ABS},{"ROR",ABS},{"ADC",LONG},
+    {"BVS",REL},{"ADC",IZY},{"ADC",ZPI},{"ADC",SRIY},{"STZ",ZPX},{"ADC",ZPX},{"ROR",ZPX},{"ADC",ZPILY},{"SEI",IMP},{"ADC",ABY},{"PLY",IMP},{"TDC",IMP},{"JMP",AIX},{"ADC",ABX},{"ROR",ABX},{"ADC",LONGX},
+    {"BRA",REL},{"STA",IZX},{"BRL",RELL},{"STA",SR},{"STY",ZP}, {"STA",ZP}, {"STX",ZP}, {"STA",ZPIL},{"DEY",IMP},{"BIT",IMM_M},{"TXA",IMP},{"PHB",IMP},{"STY",ABS},{"STA",ABS},{"STX",ABS},{"STA",LONG},
+    {"BCC",REL},{"STA",IZY},{"STA",ZPI},{"STA",SRIY},{"STY",ZPX},{"STA",ZPX},{"STX",ZPY},{"STA",ZPILY},{"TYA",IMP},{"STA",ABY},{"TXS",IMP},{"TXY",IMP},{"STZ",ABS},{"STA",ABX},{"STZ",ABX},{"STA",LONGX},
+    {"LDY",IMM_X},{"LDA",IZX},{"LDX",IMM_X},{"LDA",SR},{"LDY",ZP},{"LDA",ZP}, {"LDX",ZP}, {"LDA",ZPIL},{"TAY",IMP},{"LDA",IMM_M},{"TAX",IMP},{"PLB",IMP},{"LDY",ABS},{"LDA",ABS},{"LDX",ABS},{"LDA",LONG},
+    {"BCS",REL},{"LDA",IZY},{"LDA",ZPI},{"LDA",SRIY},{"LDY",ZPX},{"LDA",ZPX},{"LDX",ZPY},{"LDA",ZPILY},{"CLV",IMP},{"LDA",ABY},{"TSX",IMP},{"TYX",IMP},{"LDY",ABX},{"LDA",ABX},{"LDX",ABY},{"LDA",LONGX},
+    {"CPY",IMM_X},{"CMP",IZX},{"REP",IMM},{"CMP",SR},{"CPY",ZP}, {"CMP",ZP}, {"DEC",ZP}, {"CMP",ZPIL},{"INY",IMP},{"CMP",IMM_M},{"DEX",IMP},{"WAI",IMP},{"CPY",ABS},{"CMP",ABS},{"DEC",ABS},{"CMP",LONG},
+    {"BNE",REL},{"CMP",IZY},{"CMP",ZPI},{"CMP",SRIY},{"PEI",ZPI},{"CMP",ZPX},{"DEC",ZPX},{"CMP",ZPILY},{"CLD",IMP},{"CMP",ABY},{"PHX",IMP},{"STP",IMP},{"JML",INDL},{"CMP",ABX},{"DEC",ABX},{"CMP",LONGX},
+    {"CPX",IMM_X},{"SBC",IZX},{"SEP",IMM},{"SBC",SR},{"CPX",ZP}, {"SBC",ZP}, {"INC",ZP}, {"SBC",ZPIL},{"INX",IMP},{"SBC",IMM_M},{"NOP",IMP},{"XBA",IMP},{"CPX",ABS},{"SBC",ABS},{"INC",ABS},{"SBC",LONG},
+    {"BEQ",REL},{"SBC",IZY},{"SBC",ZPI},{"SBC",SRIY},{"PEA",IMM16},{"SBC",ZPX},{"INC",ZPX},{"SBC",ZPILY},{"SED",IMP},{"SBC",ABY},{"PLX",IMP},{"XCE",IMP},{"JSR",AIX},{"SBC",ABX},{"INC",ABX},{"SBC",LONGX},
+};
+// clang-format on
+
+// Operand bytes after the opcode for a mode
+int operand_size(Mode mode, bool m8, bool x8) {
+    switch (mode) {
+        case IMP: case ACC: return 0;
+        case IMM_M: return m8 ? 1 : 2;
+        case IMM_X: return x8 ? 1 : 2;
+        case IMM16: case ABS: case ABX: case ABY: case IND: case INDL: case AIX: case RELL: case BLK: return 2;
+        case LONG: case LONGX: return 3;
+        default: return 1;
+    }
+}
+
+// pc_bank is the 65816's program bank (0 on the 6502); branches wrap
+// within it
+std::string format_65xx(const Op& op, const uint8_t* bytes, uint32_t pc, uint32_t pc_bank,
+                        bool m8, bool x8, int& length) {
+    int size = operand_size(op.mode, m8, x8);
+    length = 1 + size;
+    uint32_t value = 0;
+    for (int i = 0; i < size; i++) {
+        value |= static_cast<uint32_t>(bytes[1 + i]) << (i * 8);
+    }
+    const char* name = op.name;
+
+    switch (op.mode) {
+        case IMP: return name;
+        case ACC: return format("%s A", name);
+        case IMM: case IMM_M: case IMM_X:
+            return size == 1 ? format("%s #$%02X", name, value) : format("%s #$%04X", name, value);
+        case IMM16: return format("%s $%04X", name, value);
+        case ZP: return format("%s $%02X", name, value);
+        case ZPX: return format("%s $%02X,X", name, value);
+        case ZPY: return format("%s $%02X,Y", name, value);
+        case ABS: return format("%s $%04X", name, value);
+        case ABX: return format("%s $%04X,X", name, value);
+        case ABY: return format("%s $%04X,Y", name, value);
+        case IND: return format("%s ($%04X)", name, value);
+        case IZX: return format("%s ($%02X,X)", name, value);
+        case IZY: return format("%s ($%02X),Y", name, value);
+        case ZPI: return format("%s ($%02X)", name, value);
+        case ZPIL: return format("%s [$%02X]", name, value);
+        case ZPILY: return format("%s [$%02X],Y", name, value);
+        case LONG: return format("%s $%06X", name, value);
+        case LONGX: return format("%s $%06X,X", name, value);
+        case INDL: return format("%s [$%04X]", name, value);
+        case AIX: return format("%s ($%04X,X)", name, value);
+        case SR: return format("%s $%02X,S", name, value);
+        case SRIY: return format("%s ($%02X,S),Y", name, value);
+        case BLK: return format("%s $%02X,$%02X", name, value >> 8, value & 0xFF);
+        case REL: case RELL: {
+            int32_t offset = size == 1 ? static_cast<int8_t>(value) : static_cast<int16_t>(value);
+            uint32_t target = (pc + length + offset) & 0xFFFF;
+            return pc_bank ? format("%s $%06X", name, pc_bank | target) : format("%s $%04X", name, target);
+        }
+    }
+    return name;
+}
+
+// ============================================================================
+// SM83
+// ============================================================================
+
+// Operand tokens: d8/d16 immediate, a8 high-page address, a16 address,
+// r8 relative branch, s8 signed offset
+// clang-format off
+const char* const s_sm83[256] = {
+    "NOP","LD BC,d16","LD (BC),A","INC BC","INC B","DEC B","LD B,d8","RLCA","LD (a16),SP","ADD HL,BC","LD A,(BC)","DEC BC","INC C","DEC C","LD C,d8","RRCA",
+    "STOP","LD DE,d16","LD (DE),A","INC DE","INC D","DEC D","LD D,d8","RLA","JR r8","ADD HL,DE","LD A,(DE)","DEC DE","INC E","DEC E","LD E,d8","RRA",
+    "JR NZ,r8","LD HL,d16","LD (HL+),A","INC HL","INC H","DEC H","LD H,d8","DAA","JR Z,r8","ADD HL,HL","LD A,(HL+)","DEC HL","INC L","DEC L","LD L,d8","CPL",
+    "JR NC,r8","LD SP,d16","LD (HL-),A","INC SP","INC (HL)","DEC (HL)","LD (HL),d8","SCF","JR C,r8","ADD HL,SP","LD A,(HL-)","DEC SP","INC A","DEC A","LD A,d8","CCF",
+    // 0x40-0xBF are generated
+    nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,
+    nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,
+    nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,
+    nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,
+    nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,
+    nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,
+    nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,
+    nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,
+    "RET NZ","POP BC","JP NZ,a16","JP a16","CALL NZ,a16","PUSH BC","ADD A,d8","RST 00H","RET Z","RET","JP Z,a16",nullptr,"CALL Z,a16","CALL a16","ADC A,d8","RST 08H",
+    "RET NC","POP DE","JP NC,a16",nullptr,"CALL NC,a16","PUSH DE","SUB d8","RST 10H","RET C","RETI","JP C,a16",nullptr,"CALL C,a16",nullptr,"SBC A,d8","RST 18H",
+    "LDH (a8),A","POP HL","LD (C),A",nullptr,nullptr,"PUSH HL","AND d8","RST 20H","ADD SP,s8","JP HL","LD (a16),A",nullptr,nullptr,nullptr,"XOR d8","RST 28H",
+    "LDH A,(a8)","POP AF","LD A,(C)","DI",nullptr,"PUSH AF","OR d8","RST 30H","LD HL,SPs8","LD SP,HL","LD A,(a16)","EI",nullptr,nullptr,"CP d8","RST 38H",
+};
+// clang-format on
+
+const char* const s_sm83_regs[8] = {"B", "C", "D", "E", "H", "L", "(HL)", "A"};
+
+} // namespace
+
+std::string mos6502(const uint8_t* bytes, uint16_t pc, int& length) {
+    return format_65xx(s_6502[bytes[0]], bytes, pc, 0, true, true, length);
+}
+
+std::string wdc65816(const uint8_t* bytes, uint32_t pc, bool m8, bool x8, int& length) {
+    return format_65xx(s_65816[bytes[0]], bytes, pc & 0xFFFF, pc & 0xFF0000, m8, x8, length);
+}
+
+std::string sm83(const uint8_t* bytes, uint16_t pc, int& length) {
+    uint8_t opcode = bytes[0];
+    length = 1;
+
+    if (opcode == 0xCB) {
+        static const char* const shifts[8] = {"RLC", "RRC", "RL", "RR", "SLA", "SRA", "SWAP", "SRL"};
+        static const char* const bit_ops[3] = {"BIT", "RES", "SET"};
+        uint8_t op = bytes[1];
+        length = 2;
+        const char* reg = s_sm83_regs[op & 7];
+        if (op < 0x40) return format("%s %s", shifts[op >> 3], reg);
+        return format("%s %d,%s", bit_ops[(op >> 6) - 1], (op >> 3) & 7, reg);
+    }
+    if (opcode == 0x76) return "HALT";
+    if (opcode >= 0x40 && opcode < 0x80) {
+        return format("LD %s,%s", s_sm83_regs[(opcode >> 3) & 7], s_sm83_regs[opcode & 7]);
+    }
+    if (opcode >= 0x80 && opcode < 0xC0) {
+        static const char* const alu[8] = {"ADD A,", "ADC A,", "SUB ", "SBC A,", "AND ", "XOR ", "OR ", "CP "};
+        return format("%s%s", alu[(opcode >> 3) & 7], s_sm83_regs[opcode & 7]);
+    }
+
+    const char* text = s_sm83[opcode];
+    if (!text) return format("DB $%02X", opcode);
+
+    // Substitute the one lowercase operand token, if any
+    std::string result(text);
+    size_t pos = result.find_first_of("adrs");
+    if (pos == std::string::npos) return result;
+    size_t end = result.find_first_not_of("0123456789", pos + 1);
+    std::string token = result.substr(pos, end - pos);
+
+    std::string operand;
+    uint8_t byte = bytes[1];
+    uint16_t word = static_cast<uint16_t>(bytes[1] | (bytes[2] << 8));
+    if (token == "d16" || token == "a16") {
+        operand = format("$%04X", word);
+        length = 3;
+    } else if (token == "a8") {
+        operand = format("$FF%02X", byte);
+        length = 2;
+    } else if (token == "r8") {
+        operand = format("$%04X", static_cast<uint16_t>(pc + 2 + static_cast<int8_t>(byte)));
+        length = 2;
+    } else if (token == "s8") {
+        int offset = static_cast<int8_t>(byte);
+        operand = offset < 0 ? format("-$%02X", -offset) : format("+$%02X", offset);
+        length = 2;
+    } else {
+        operand = format("$%02X", byte);
+        length = 2;
+    }
+    return result.replace(pos, token.size(), operand);
+}
+
+// ============================================================================
+// ARM7TDMI
+// ============================================================================
+
+namespace {
+
+const char* const s_conditions[16] = {
+    "EQ", "NE", "CS", "CC", "MI", "PL", "VS", "VC",
+    "HI", "LS", "GE", "LT", "GT", "LE", "", "NV"
+};
+
+const char* const s_arm_regs[16] = {
+    "r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7",
+    "r8", "r9", "r10", "r11", "r12", "sp", "lr", "pc"
+};
+
+const char* const s_shifts[4] = {"LSL", "LSR", "ASR", "ROR"};
+
+uint32_t bits(uint32_t value, int high, int low) {
+    return (value >> low) & ((1u << (high - low + 1)) - 1);
+}
+
+std::string register_list(uint32_t list) {
+    std::string result = "{";
+    for (int reg = 0; reg < 16; reg++) {
+        if (!(list & (1u << reg))) continue;
+        // Runs of three or more as a range
+        int last = reg;
+        while (last < 15 && (list & (1u << (last + 1)))) last++;
+        if (result.size() > 1) result += ", ";
+        if (last - reg >= 2) {
+            result += std::string(s_arm_regs[reg]) + "-" + s_arm_regs[last];
+            reg = last;
+        } else {
+            result += s_arm_regs[reg];
+        }
+    }
+    return result + "}";
+}
+
+// Shifted register operand (data processing operand 2, register offsets)
+std::string shifted_register(uint32_t ins, bool allow_register_shift) {
+    std::string result = s_arm_regs[bits(ins, 3, 0)];
+    uint32_t type = bits(ins, 6, 5);
+    if (allow_register_shift && (ins & 0x10)) {
+        return result + ", " + s_shifts[type] + " " + s_arm_regs[bits(ins, 11, 8)];
+    }
+    uint32_t amount = bits(ins, 11, 7);
+    if (amount == 0) {
+        if (type == 0) return result;
+        if (type == 3) return result + ", RRX";
+        amount = 32;
+    }
+    return result + format(", %s #%u", s_shifts[type], amount);
+}
+
+std::string arm_data_processing(uint32_t ins, const char* cond) {
+    static const char* const ops[16] = {
+        "AND", "EOR", "SUB", "RSB", "ADD", "ADC", "SBC", "RSC",
+        "TST", "TEQ", "CMP", "CMN", "ORR", "MOV", "BIC", "MVN"
+    };
+    uint32_t opcode = bits(ins, 24, 21);
+    bool set_flags = (ins >> 20) & 1;
+    const char* rd = s_arm_regs[bits(ins, 15, 12)];
+    const char* rn = s_arm_regs[bits(ins, 19, 16)];
+
+    std::string operand;
+    if (ins & (1u << 25)) {
+        uint32_t rotate = bits(ins, 11, 8) * 2;
+        uint32_t imm = bits(ins, 7, 0);
+        imm = rotate ? (imm >> rotate) | (imm << (32 - rotate)) : imm;
+        operand = format("#0x%X", imm);
+    } else {
+        operand = shifted_register(ins, true);
+    }
+
+    std::string name = std::string(ops[opcode]) + cond;
+    if (opcode >= 8 && opcode <= 11) {
+        // Compares always set flags; S isn't written
+        return name + " " + rn + ", " + operand;
+    }
+    if (set_flags) name += "S";
+    if (opcode == 13 || opcode == 15) {
+        return name + " " + rd + ", " + operand;
+    }
+    return name + " " + rd + ", " + rn + ", " + operand;
+}
+
+std::string arm_single_transfer(uint32_t ins, const char* cond) {
+    bool load = (ins >> 20) & 1;
+    bool write_back = (ins >> 21) & 1;
+    bool byte = (ins >> 22) & 1;
+    bool up = (ins >> 23) & 1;
+    bool pre = (ins >> 24) & 1;
+    bool register_offset = (ins >> 25) & 1;
+
+    std::string name = std::string(load ? "LDR" : "STR") + cond + (byte ? "B" : "");
+    if (!pre && write_back) name += "T";
+    std::string address = std::string("[") + s_arm_regs[bits(ins, 19, 16)];
+    std::string offset;
+    if (register_offset) {
+        offset = std::string(up ? "" : "-") + shifted_register(ins, false);
+    } else if (bits(ins, 11, 0) != 0) {
+        offset = format("#%s0x%X", up ? "" : "-", bits(ins, 11, 0));
+    }
+
+    if (pre) {
+        if (!offset.empty()) address += ", " + offset;
+        address += write_back ? "]!" : "]";
+    } else {
+        address += "]";
+        if (!offset.empty()) address += ", " + offset;
+    }
+    return name + " " + s_arm_regs[bits(ins, 15, 12)] + ", " + address;
+}
+
+std::string arm_halfword_transfer(uint32_t ins, const char* cond) {
+    static const char* const kinds[4] = {"", "H", "SB", "SH"};
+    bool load = (ins >> 20) & 1;
+    bool write_back = (ins >> 21) & 1;
+    bool immediate = (ins >> 22) & 1;
+    bool up = (ins >> 23) & 1;
+    bool pre = (ins >> 24) & 1;
+
+    std::string name = std::string(load ? "LDR" : "STR") + cond + kinds[bits(ins, 6, 5)];
+    std::string address = std::string("[") + s_arm_regs[bits(ins, 19, 16)];
+    std::string offset;
+    if (immediate) {
+        uint32_t value = (bits(ins, 11, 8) << 4) | bits(ins, 3, 0);
+        if (value) offset = format("#%s0x%X", up ? "" : "-", value);
+    } else {
+        offset = std::string(up ? "" : "-") + s_arm_regs[bits(ins, 3, 0)];
+    }
+
+    if (pre) {
+        if (!offset.empty()) address += ", " + offset;
+        address += write_back ? "]!" : "]";
+    } else {
+        address += "]";
+        if (!offset.empty()) address += ", " + offset;
+    }
+    return name + " " + s_arm_regs[bits(ins, 15, 12)] + ", " + address;
+}
+
+std::string arm_block_transfer(uint32_t ins, const char* cond) {
+    static const char* const modes[4] = {"DA", "IA", "DB", "IB"};
+    bool load = (ins >> 20) & 1;
+    bool write_back = (ins >> 21) & 1;
+    bool user = (ins >> 22) & 1;
+    uint32_t mode = bits(ins, 24, 23);
+
+    return std::string(load ? "LDM" : "STM") + cond + modes[mode] + " " +
+           s_arm_regs[bits(ins, 19, 16)] + (write_back ? "!" : "") + ", " +
+           register_list(bits(ins, 15, 0)) + (user ? "^" : "");
+}
+
+} // namespace
+
+std::string arm(uint32_t ins, uint32_t pc) {
+    const char* cond = s_conditions[ins >> 28];
+
+    if ((ins & 0x0FFFFFF0) == 0x012FFF10) {
+        return std::string("BX") + cond + " " + s_arm_regs[bits(ins, 3, 0)];
+    }
+    if (bits(ins, 27, 25) == 5) {
+        int32_t offset = static_cast<int32_t>(ins << 8) >> 6;
+        return format("%s%s 0x%08X", (ins & (1u << 24)) ? "BL" : "B", cond, pc + 8 + offset);
+    }
+    if (bits(ins, 27, 24) == 0xF) {
+        return format("SWI%s #0x%X", cond, bits(ins, 23, 0));
+    }
+    if ((ins & 0x0FC000F0) == 0x00000090) {
+        const char* rd = s_arm_regs[bits(ins, 19, 16)];
+        const char* rm = s_arm_regs[bits(ins, 3, 0)];
+        const char* rs = s_arm_regs[bits(ins, 11, 8)];
+        const char* s = (ins & (1u << 20)) ? "S" : "";
+        if (ins & (1u << 21)) {
+            return format("MLA%s%s %s, %s, %s, %s", cond, s, rd, rm, rs, s_arm_regs[bits(ins, 15, 12)]);
+        }
+        return format("MUL%s%s %s, %s, %s", cond, s, rd, rm, rs);
+    }
+    if ((ins & 0x0F8000F0) == 0x00800090) {
+        static const char* const ops[4] = {"UMULL", "UMLAL", "SMULL", "SMLAL"};
+        return format("%s%s%s %s, %s, %s, %s", ops[bits(ins, 22, 21)], cond, (ins & (1u << 20)) ? "S" : "",
+                      s_arm_regs[bits(ins, 15, 12)], s_arm_regs[bits(ins, 19, 16)],
+                      s_arm_regs[bits(ins, 3, 0)], s_arm_regs[bits(ins, 11, 8)]);
+    }
+    if ((ins & 0x0FB00FF0) == 0x01000090) {
+        return format("SWP%s%s %s, %s, [%s]", cond, (ins & (1u << 22)) ? "B" : "",
+                      s_arm_regs[bits(ins, 15, 12)], s_arm_regs[bits(ins, 3, 0)], s_arm_regs[bits(ins, 19, 16)]);
+    }
+    if ((ins & 0x0E000090) == 0x00000090 && bits(ins, 6, 5) != 0) {
+        return arm_halfword_transfer(ins, cond);
+    }
+    if ((ins & 0x0FBF0FFF) == 0x010F0000) {
+        return format("MRS%s %s, %s", cond, s_arm_regs[bits(ins, 15, 12)], (ins & (1u << 22)) ? "SPSR" : "CPSR");
+    }
+    if ((ins & 0x0DB0F000) == 0x0120F000) {
+        std::string psr = (ins & (1u << 22)) ? "SPSR_" : "CPSR_";
+        if (ins & (1u << 19)) psr += "f";
+        if (ins & (1u << 16)) psr += "c";
+        std::string operand;
+        if (ins & (1u << 25)) {
+            uint32_t rotate = bits(ins, 11, 8) * 2;
+            uint32_t imm = bits(ins, 7, 0);
+            operand = format("#0x%X", rotate ? (imm >> rotate) | (imm << (32 - rotate)) : imm);
+        } else {
+            operand = s_arm_regs[bits(ins, 3, 0)];
+        }
+        return std::string("MSR") + cond + " " + psr + ", " + operand;
+    }
+    switch (bits(ins, 27, 26)) {
+        case 0: return arm_data_processing(ins, cond);
+        case 1:
+            if ((ins & (1u << 25)) && (ins & 0x10)) break;  // Undefined
+            return arm_single_transfer(ins, cond);
+        case 2:
+            if (!(ins & (1u << 25))) return arm_block_transfer(ins, cond);
+            break;
+        case 3:
+            return format("CP%s 0x%08X", cond, ins);  // No coprocessors on the GBA
+    }
+    return format("UND%s 0x%08X", cond, ins);
+}
+
+std::string thumb(uint16_t ins, uint32_t pc) {
+    auto reg = [ins](int low) { return s_arm_regs[(ins >> low) & 7]; };
+
+    if ((ins >> 13) == 0 && ((ins >> 11) & 3) != 3) {
+        static const char* const shifts[3] = {"LSL", "LSR", "ASR"};
+        return format("%s %s, %s, #%u", shifts[(ins >> 11) & 3], reg(0), reg(3), bits(ins, 10, 6));
+    }
+    if ((ins >> 11) == 0x03) {
+        const char* op = (ins & (1u << 9)) ? "SUB" : "ADD";
+        if (ins & (1u << 10)) return format("%s %s, %s, #%u", op, reg(0), reg(3), bits(ins, 8, 6));
+        return format("%s %s, %s, %s", op, reg(0), reg(3), reg(6));
+    }
+    if ((ins >> 13) == 1) {
+        static const char* const ops[4] = {"MOV", "CMP", "ADD", "SUB"};
+        return format("%s %s, #0x%X", ops[bits(ins, 12, 11)], reg(8), bits(ins, 7, 0));
+    }
+    if ((ins >> 10) == 0x10) {
+        static const char* const ops[16] = {
+            "AND", "EOR", "LSL", "LSR", "ASR", "ADC", "SBC", "ROR",
+            "TST", "NEG", "CMP", "CMN", "ORR", "MUL", "BIC", "MVN"
+        };
+        return format("%s %s, %s", ops[bits(ins, 9, 6)], reg(0), reg(3));
+    }
+    if ((ins >> 10) == 0x11) {
+        static const char* const ops[4] = {"ADD", "CMP", "MOV", "BX"};
+        uint32_t rd = bits(ins, 2, 0) | (bits(ins, 7, 7) << 3);
+        uint32_t rs = bits(ins, 6, 3);
+        uint32_t op = bits(ins, 9, 8);
+        if (op == 3) return format("BX %s", s_arm_regs[rs]);
+        return format("%s %s, %s", ops[op], s_arm_regs[rd], s_arm_regs[rs]);
+    }
+    if ((ins >> 11) == 0x09) {
+        uint32_t address = ((pc + 4) & ~3u) + bits(ins, 7, 0) * 4;
+        return format("LDR %s, [pc, #0x%X] ; =0x%08X", reg(8), bits(ins, 7, 0) * 4, address);
+    }
+    if ((ins >> 12) == 0x5) {
+        static const char* const word_ops[4] = {"STR", "STRB", "LDR", "LDRB"};
+        static const char* const half_ops[4] = {"STRH", "LDSB", "LDRH", "LDSH"};
+        const char* op = (ins & (1u << 9)) ? half_ops[bits(ins, 11, 10)] : word_ops[bits(ins, 11, 10)];
+        return format("%s %s, [%s, %s]", op, reg(0), reg(3), reg(6));
+    }
+    if ((ins >> 13) == 3) {
+        bool byte = (ins >> 12) & 1;
+        bool load = (ins >> 11) & 1;
+        uint32_t offset = bits(ins, 10, 6) * (byte ? 1 : 4);
+        return format("%s%s %s, [%s, #0x%X]", load ? "LDR" : "STR", byte ? "B" : "", reg(0), reg(3), offset);
+    }
+    if ((ins >> 12) == 0x8) {
+        return format("%s %s, [%s, #0x%X]", (ins & (1u << 11)) ? "LDRH" : "STRH", reg(0), reg(3), bits(ins, 10, 6) * 2);
+    }
+    if ((ins >> 12) == 0x9) {
+        return format("%s %s, [sp, #0x%X]", (ins & (1u << 11)) ? "LDR" : "STR", reg(8), bits(ins, 7, 0) * 4);
+    }
+    if ((ins >> 12) == 0xA) {
+        return format("ADD %s, %s, #0x%X", reg(8), (ins & (1u << 11)) ? "sp" : "pc", bits(ins, 7, 0) * 4);
+    }
+    if ((ins >> 8) == 0xB0) {
+        return format("ADD sp, #%s0x%X", (ins & 0x80) ? "-" : "", bits(ins, 6, 0) * 4);
+    }
+    if ((ins & 0xF600) == 0xB400) {
+        bool pop = (ins >> 11) & 1;
+        uint32_t list = bits(ins, 7, 0);
+        if (ins & (1u << 8)) list |= pop ? (1u << 15) : (1u << 14);
+        return std::string(pop ? "POP " : "PUSH ") + register_list(list);
+    }
+    if ((ins >> 12) == 0xC) {
+        return format("%s %s!, %s", (ins & (1u << 11)) ? "LDMIA" : "STMIA", reg(8),
+                      register_list(bits(ins, 7, 0)).c_str());
+    }
+    if ((ins >> 8) == 0xDF) {
+        return format("SWI #0x%X", bits(ins, 7, 0));
+    }
+    if ((ins >> 12) == 0xD && bits(ins, 11, 8) < 0xE) {
+        int32_t offset = static_cast<int8_t>(ins & 0xFF) * 2;
+        return format("B%s 0x%08X", s_conditions[bits(ins, 11, 8)], pc + 4 + offset);
+    }
+    if ((ins >> 11) == 0x1C) {
+        int32_t offset = (static_cast<int32_t>(ins << 21) >> 21) * 2;
+        return format("B 0x%08X", pc + 4 + offset);
+    }
+    // BL is two instructions; the first puts the high half of the offset
+    // in LR, the second adds the low half and branches
+    if ((ins >> 11) == 0x1E) {
+        int32_t offset = (static_cast<int32_t>(ins << 21) >> 21) << 12;
+        return format("BL (hi) lr = 0x%08X", pc + 4 + offset);
+    }
+    if ((ins >> 11) == 0x1F) {
+        return format("BL (lo) lr + 0x%X", bits(ins, 10, 0) * 2);
+    }
+    return format("UND 0x%04X", ins);
+}
+
+} // namespace disasm
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Disassemblers for the CPUs the cores trace (see emu/cpu_trace.hpp)
+//
+// Each turns the bytes of one instruction into assembler text in the usual
+// syntax for that CPU. Branch targets are resolved against pc. Those taking
+// bytes set length to the instruction's size, which may be less than the
+// bytes given.
+
+namespace disasm {
+
+// NES 2A03, unofficial opcodes included
+std::string mos6502(const uint8_t* bytes, uint16_t pc, int& length);
+
+// SNES 5A22; m8 and x8 are the M and X flags (both set in emulation mode),
+// which size the immediate operands
+std::string wdc65816(const uint8_t* bytes, uint32_t pc, bool m8, bool x8, int& length);
+
+// Game Boy, CB-prefixed opcodes included
+std::string sm83(const uint8_t* bytes, uint16_t pc, int& length);
+
+// GBA ARM7TDMI, ARM and Thumb states
+std::string arm(uint32_t instruction, uint32_t pc);
+std::string thumb(uint16_t instruction, uint32_t pc);
+
+} // namespace disasm
@@ -0,0 +1,177 @@
+// veloce_trace_decode - turns a binary CPU trace into a disassembly listing
+//
+// Reads a trace saved by the frontend (--cpu-trace, or Tools > Record CPU
+// Trace) and prints one line per instruction: the core's cycle count, the
+// address, the instruction bytes, the disassembly and the registers as they
+// were before it ran. The trace format is emu/cpu_trace.hpp; each record
+// names its CPU, so one decoder covers every core.
+
+#include "disassembler.hpp"
+
+#include <emu/cpu_trace.hpp>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+void print_usage(const char* program) {
+    std::printf("Usage: %s [options] <trace.bin>\n\n", program);
+    std::printf("Options:\n");
+    std::printf("  -o <file>     Write the listing to a file instead of stdout\n");
+    std::printf("  --last <n>    Only the last n instructions\n");
+    std::printf("  --no-regs     Leave out the register columns\n");
+    std::printf("  -h, --help    Show this help\n");
+}
+
+std::string format_bytes(const uint8_t* bytes, int length) {
+    char buffer[16] = {};
+    int pos = 0;
+    for (int i = 0; i < length; i++) {
+        pos += std::snprintf(buffer + pos, sizeof(buffer) - pos, i ? " %02X" : "%02X", bytes[i]);
+    }
+    return buffer;
+}
+
+void print_record(std::FILE* out, const emu::CpuTraceRecord& record, bool show_regs) {
+    const uint32_t* r = record.regs;
+    std::string text;
+    std::string bytes;
+    char line[160] = {};
+    char regs[160] = {};
+    int length = 0;
+
+    switch (static_cast<emu::CpuTraceArch>(record.arch)) {
+        case emu::CpuTraceArch::MOS6502:
+            text = disasm::mos6502(record.opcode, static_cast<uint16_t>(record.pc), length);
+            bytes = format_bytes(record.opcode, length);
+            std::snprintf(line, sizeof(line), "%12" PRIu64 "  %04X  %-9s  %-16s", record.cycle, record.pc, bytes.c_str(), text.c_str());
+            std::snprintf(regs, sizeof(regs), "A:%02X X:%02X Y:%02X SP:%02X P:%02X",
+                          r[0], r[1], r[2], r[3], r[4]);
+            break;
+
+        case emu::CpuTraceArch::WDC65816: {
+            bool emulation = record.flags & emu::CPU_TRACE_EMULATION;
+            bool m8 = emulation || (r[4] & 0x20);
+            bool x8 = emulation || (r[4] & 0x10);
+            text = disasm::wdc65816(record.opcode, record.pc, m8, x8, length);
+            bytes = format_bytes(record.opcode, length);
+            std::snprintf(line, sizeof(line), "%12" PRIu64 "  %06X  %-11s  %-18s", record.cycle, record.pc, bytes.c_str(), text.c_str());
+            std::snprintf(regs, sizeof(regs), "A:%04X X:%04X Y:%04X S:%04X P:%02X%s D:%04X DB:%02X",
+                          r[0], r[1], r[2], r[3], r[4], emulation ? "E" : " ", r[5], r[6]);
+            break;
+        }
+
+        case emu::CpuTraceArch::SM83:
+            text = disasm::sm83(record.opcode, static_cast<uint16_t>(record.pc), length);
+            bytes = format_bytes(record.opcode, length);
+            std::snprintf(line, sizeof(line), "%12" PRIu64 "  %04X  %-8s  %-16s", record.cycle, record.pc, bytes.c_str(), text.c_str());
+            std::snprintf(regs, sizeof(regs), "AF:%04X BC:%04X DE:%04X HL:%04X SP:%04X",
+                          r[0], r[1], r[2], r[3], r[4]);
+            break;
+
+        case emu::CpuTraceArch::ARM7TDMI: {
+            uint32_t word = record.opcode[0] | (record.opcode[1] << 8) |
+                            (record.opcode[2] << 16) | (static_cast<uint32_t>(record.opcode[3]) << 24);
+            char encoding[16];
+            if (record.flags & emu::CPU_TRACE_THUMB) {
+                text = disasm::thumb(static_cast<uint16_t>(word), record.pc);
+                std::snprintf(encoding, sizeof(encoding), "    %04X", word & 0xFFFF);
+            } else {
+                text = disasm::arm(word, record.pc);
+                std::snprintf(encoding, sizeof(encoding), "%08X", word);
+            }
+            std::snprintf(line, sizeof(line), "%12" PRIu64 "  %08X  %s  %-32s", record.cycle, record.pc, encoding, text.c_str());
+            int pos = 0;
+            for (int i = 0; i < 8; i++) {
+                pos += std::snprintf(regs + pos, sizeof(regs) - pos, "r%d:%08X ", i, r[i]);
+            }
+            std::snprintf(regs + pos, sizeof(regs) - pos, "sp:%08X lr:%08X cpsr:%08X", r[8], r[9], r[10]);
+            break;
+        }
+
+        default:
+            std::snprintf(line, sizeof(line), "%12" PRIu64 "  %08X  (unknown CPU %u)", record.cycle, record.pc, record.arch);
+            break;
+    }
+
+    if (show_regs && regs[0]) {
+        std::fprintf(out, "%s  %s\n", line, regs);
+    } else {
+        // Without registers the padding would only trail
+        std::string text_only(line);
+        text_only.erase(text_only.find_last_not_of(' ') + 1);
+        std::fprintf(out, "%s\n", text_only.c_str());
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string input_path;
+    std::string output_path;
+    uint64_t last = 0;
+    bool show_regs = true;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--last") == 0 && i + 1 < argc) {
+            last = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--no-regs") == 0) {
+            show_regs = false;
+        } else if (std::strcmp(argv[i], "-h") == 0 || std::strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (argv[i][0] != '-' && input_path.empty()) {
+            input_path = argv[i];
+        } else {
+            std::fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (input_path.empty()) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    emu::CpuTraceFileHeader header{};
+    std::vector<emu::CpuTraceRecord> records;
+    std::string error;
+    if (!emu::CpuTrace::load(input_path, header, records, error)) {
+        std::fprintf(stderr, "Error: %s\n", error.c_str());
+        return 1;
+    }
+
+    std::FILE* out = stdout;
+    if (!output_path.empty()) {
+        out = std::fopen(output_path.c_str(), "w");
+        if (!out) {
+            std::fprintf(stderr, "Error: can't write %s\n", output_path.c_str());
+            return 1;
+        }
+    }
+
+    if (header.total > header.count) {
+        std::fprintf(out, "; %" PRIu64 " instructions traced, the first %" PRIu64 " fell out of the ring\n",
+                     header.total, header.total - header.count);
+    }
+
+    size_t first = 0;
+    if (last && last < records.size()) {
+        first = records.size() - static_cast<size_t>(last);
+    }
+    for (size_t i = first; i < records.size(); i++) {
+        print_record(out, records[i], show_regs);
+    }
+
+    if (out != stdout) {
+        std::fclose(out);
+    }
+    return 0;
+}